@@ -167,6 +167,11 @@ struct ar_cache
 
 #define is_bsd44_extended_name(NAME) \
   (NAME[0] == '#'  && NAME[1] == '1' && NAME[2] == '/' && ISDIGIT (NAME[3]))
+
+/* The size of the pieces in which member contents are copied when
+   writing an archive.  */
+
+#define ARCHIVE_COPY_BUFFERSIZE (1024 * 1024)
 
 void
 _bfd_ar_spacepad (char *p, size_t n, const char *fmt, long val)
@@ -2114,6 +2119,7 @@ _bfd_write_archive_contents (bfd *arch)
   bfd_size_type wrote;
   int tries;
   char *armag;
+  char *buffer = NULL;
 
   /* Verify the viability of all entries; if any of them live in the
      filesystem (as opposed to living in an archive open for input)
@@ -2192,16 +2198,21 @@ _bfd_write_archive_contents (bfd *arch)
 	}
     }
 
+  /* Copy the members in large pieces; for a big archive most of the
+     time goes in moving their contents.  */
+  buffer = (char *) bfd_malloc (ARCHIVE_COPY_BUFFERSIZE);
+  if (buffer == NULL)
+    return FALSE;
+
   for (current = arch->archive_head;
        current != NULL;
        current = current->archive_next)
     {
-      char buffer[DEFAULT_BUFFERSIZE];
       bfd_size_type remaining = arelt_size (current);
 
       /* Write ar header.  */
       if (!_bfd_write_ar_hdr (arch, current))
-	return FALSE;
+	goto output_err;
       if (bfd_is_thin_archive (arch))
 	continue;
       if (bfd_seek (current, (file_ptr) 0, SEEK_SET) != 0)
@@ -2209,7 +2220,7 @@ _bfd_write_archive_contents (bfd *arch)
 
       while (remaining)
 	{
-	  unsigned int amt = DEFAULT_BUFFERSIZE;
+	  unsigned int amt = ARCHIVE_COPY_BUFFERSIZE;
 
 	  if (amt > remaining)
 	    amt = remaining;
@@ -2221,17 +2232,19 @@ _bfd_write_archive_contents (bfd *arch)
 	      goto input_err;
 	    }
 	  if (bfd_bwrite (buffer, amt, arch) != amt)
-	    return FALSE;
+	    goto output_err;
 	  remaining -= amt;
 	}
 
       if ((arelt_size (current) % 2) == 1)
 	{
 	  if (bfd_bwrite (&ARFMAG[1], 1, arch) != 1)
-	    return FALSE;
+	    goto output_err;
 	}
     }
 
+  free (buffer);
+
   if (makemap && hasobjects)
     {
       /* Verify the timestamp in the archive file.  If it would not be
@@ -2255,9 +2268,142 @@ _bfd_write_archive_contents (bfd *arch)
 
  input_err:
   bfd_set_error (bfd_error_on_input, current, bfd_get_error ());
+ output_err:
+  if (buffer != NULL)
+    free (buffer);
   return FALSE;
 }
 
+/* Add NAME, a symbol defined by member ABFD, to the armap entries
+   being collected for ARCH in *MAP.  */
+
+static bfd_boolean
+add_armap_entry (bfd *arch, struct orl **map, unsigned int *orl_max,
+		 unsigned int *orl_count, int *stridx, const char *name,
+		 bfd *abfd)
+{
+  bfd_size_type namelen;
+  bfd_size_type amt;
+  struct orl *ent;
+
+  if (*orl_count == *orl_max)
+    {
+      struct orl *new_map;
+
+      *orl_max *= 2;
+      amt = *orl_max * sizeof (struct orl);
+      new_map = (struct orl *) bfd_realloc (*map, amt);
+      if (new_map == NULL)
+	return FALSE;
+
+      *map = new_map;
+    }
+
+  ent = *map + *orl_count;
+  namelen = strlen (name);
+  amt = sizeof (char *);
+  ent->name = (char **) bfd_alloc (arch, amt);
+  if (ent->name == NULL)
+    return FALSE;
+  *(ent->name) = (char *) bfd_alloc (arch, namelen + 1);
+  if (*(ent->name) == NULL)
+    return FALSE;
+  strcpy (*(ent->name), name);
+  ent->u.abfd = abfd;
+  ent->namidx = *stridx;
+
+  *stridx += namelen + 1;
+  ++*orl_count;
+  return TRUE;
+}
+
+/* The armap of an archive that members of the archive being written
+   were read from, sorted by member.  */
+
+struct armap_reuse
+{
+  bfd *archive;
+  carsym **syms;
+  symindex count;
+};
+
+/* Compare two pointers into an armap's symdefs by the member they
+   refer to, keeping the symbols of one member in armap order.  */
+
+static int
+carsym_ptr_compare (const void *a, const void *b)
+{
+  const carsym *sa = *(const carsym * const *) a;
+  const carsym *sb = *(const carsym * const *) b;
+
+  if (sa->file_offset != sb->file_offset)
+    return sa->file_offset < sb->file_offset ? -1 : 1;
+  return sa < sb ? -1 : sa > sb;
+}
+
+/* Member CURRENT of ARCH is being copied unchanged from the archive
+   it was read from.  If that archive's own armap can be trusted to
+   list the symbols of CURRENT, return TRUE and set *FIRST and *LAST
+   to the range of REUSE->syms that does so; this saves opening every
+   unchanged member to read its symbol table when only a few members
+   of a large archive have been replaced.  Callers who want the armap
+   rebuilt from scratch, such as ranlib, clear bfd_has_map on the
+   input archive.  */
+
+static bfd_boolean
+armap_reuse_lookup (struct armap_reuse *reuse, bfd *arch, bfd *current,
+		    symindex *first, symindex *last)
+{
+  bfd *src = current->my_archive;
+  file_ptr key;
+  symindex lo, hi;
+
+  if (src == NULL
+      || src->xvec != arch->xvec
+      || bfd_is_thin_archive (src)
+      || !bfd_has_map (src)
+      || bfd_ardata (src) == NULL
+      || bfd_ardata (src)->symdef_count == 0
+      || current->arelt_data == NULL)
+    return FALSE;
+
+  if (reuse->archive != src)
+    {
+      symindex i;
+
+      if (reuse->syms != NULL)
+	free (reuse->syms);
+      reuse->archive = NULL;
+      reuse->count = bfd_ardata (src)->symdef_count;
+      reuse->syms = (carsym **) bfd_malloc (reuse->count * sizeof (carsym *));
+      if (reuse->syms == NULL)
+	return FALSE;
+      for (i = 0; i < reuse->count; i++)
+	reuse->syms[i] = bfd_ardata (src)->symdefs + i;
+      qsort (reuse->syms, reuse->count, sizeof (carsym *),
+	     carsym_ptr_compare);
+      reuse->archive = src;
+    }
+
+  key = arch_eltdata (current)->key;
+  lo = 0;
+  hi = reuse->count;
+  while (lo < hi)
+    {
+      symindex mid = lo + (hi - lo) / 2;
+
+      if (reuse->syms[mid]->file_offset < key)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  *first = lo;
+  while (lo < reuse->count && reuse->syms[lo]->file_offset == key)
+    lo++;
+  *last = lo;
+  return TRUE;
+}
+
 /* Note that the namidx for the first symbol is 0.  */
 
 bfd_boolean
@@ -2274,6 +2420,7 @@ _bfd_compute_and_write_armap (bfd *arch, unsigned int elength)
   long syms_max = 0;
   bfd_boolean ret;
   bfd_size_type amt;
+  struct armap_reuse reuse = { NULL, NULL, 0 };
 
   /* Dunno if this is the best place for this info...  */
   if (elength != 0)
@@ -2301,6 +2448,17 @@ _bfd_compute_and_write_armap (bfd *arch, unsigned int elength)
        current != NULL;
        current = current->archive_next, elt_no++)
     {
+      symindex first, last;
+
+      if (armap_reuse_lookup (&reuse, arch, current, &first, &last))
+	{
+	  for (; first < last; first++)
+	    if (!add_armap_entry (arch, &map, &orl_max, &orl_count, &stridx,
+				  reuse.syms[first]->name, current))
+	      goto error_return;
+	  continue;
+	}
+
       if (bfd_check_format (current, bfd_object)
 	  && (bfd_get_file_flags (current) & HAS_SYMS) != 0)
 	{
@@ -2341,36 +2499,11 @@ _bfd_compute_and_write_armap (bfd *arch, unsigned int elength)
 		       || bfd_is_com_section (sec))
 		      && ! bfd_is_und_section (sec))
 		    {
-		      bfd_size_type namelen;
-		      struct orl *new_map;
-
 		      /* This symbol will go into the archive header.  */
-		      if (orl_count == orl_max)
-			{
-			  orl_max *= 2;
-			  amt = orl_max * sizeof (struct orl);
-			  new_map = (struct orl *) bfd_realloc (map, amt);
-			  if (new_map == NULL)
-			    goto error_return;
-
-			  map = new_map;
-			}
-
-		      namelen = strlen (syms[src_count]->name);
-		      amt = sizeof (char *);
-		      map[orl_count].name = (char **) bfd_alloc (arch, amt);
-		      if (map[orl_count].name == NULL)
-			goto error_return;
-		      *(map[orl_count].name) = (char *) bfd_alloc (arch,
-								   namelen + 1);
-		      if (*(map[orl_count].name) == NULL)
+		      if (!add_armap_entry (arch, &map, &orl_max, &orl_count,
+					    &stridx, syms[src_count]->name,
+					    current))
 			goto error_return;
-		      strcpy (*(map[orl_count].name), syms[src_count]->name);
-		      map[orl_count].u.abfd = current;
-		      map[orl_count].namidx = stridx;
-
-		      stridx += namelen + 1;
-		      ++orl_count;
 		    }
 		}
 	    }
@@ -2388,6 +2521,8 @@ _bfd_compute_and_write_armap (bfd *arch, unsigned int elength)
 
   if (syms_max > 0)
     free (syms);
+  if (reuse.syms != NULL)
+    free (reuse.syms);
   if (map != NULL)
     free (map);
   if (first_name != NULL)
@@ -2398,6 +2533,8 @@ _bfd_compute_and_write_armap (bfd *arch, unsigned int elength)
  error_return:
   if (syms_max > 0)
     free (syms);
+  if (reuse.syms != NULL)
+    free (reuse.syms);
   if (map != NULL)
     free (map);
   if (first_name != NULL)
@@ -338,7 +338,7 @@ extern const char *bfd_get_stab_name (int);
 
 struct bfd_hash_entry
 {
-  /* Next entry for this hash code.  */
+  /* Next entry for the same string.  */
   struct bfd_hash_entry *next;
   /* String being hashed.  */
   const char *string;
@@ -351,8 +351,11 @@ struct bfd_hash_entry
 
 struct bfd_hash_table
 {
-  /* The hash array.  */
+  /* The hash array.  Each used slot holds the entries for one
+     string, chained through their NEXT fields.  */
   struct bfd_hash_entry **table;
+  /* The low bits of the hash code of the entry in each used slot.  */
+  unsigned int *hashes;
   /* A function used to create new elements in the hash table.  The
      first entry is itself a pointer to an element.  When this
      function is first invoked, this pointer will be NULL.  However,
@@ -369,6 +372,8 @@ struct bfd_hash_table
   unsigned int size;
   /* The number of entries in the hash table.  */
   unsigned int count;
+  /* The number of used slots in the hash table.  */
+  unsigned int used;
   /* The size of elements.  */
   unsigned int entsize;
   /* If non-zero, don't grow the hash table.  */
@@ -345,7 +345,7 @@ extern const char *bfd_get_stab_name (int);
 
 struct bfd_hash_entry
 {
-  /* Next entry for this hash code.  */
+  /* Next entry for the same string.  */
   struct bfd_hash_entry *next;
   /* String being hashed.  */
   const char *string;
@@ -358,8 +358,11 @@ struct bfd_hash_entry
 
 struct bfd_hash_table
 {
-  /* The hash array.  */
+  /* The hash array.  Each used slot holds the entries for one
+     string, chained through their NEXT fields.  */
   struct bfd_hash_entry **table;
+  /* The low bits of the hash code of the entry in each used slot.  */
+  unsigned int *hashes;
   /* A function used to create new elements in the hash table.  The
      first entry is itself a pointer to an element.  When this
      function is first invoked, this pointer will be NULL.  However,
@@ -376,6 +379,8 @@ struct bfd_hash_table
   unsigned int size;
   /* The number of entries in the hash table.  */
   unsigned int count;
+  /* The number of used slots in the hash table.  */
+  unsigned int used;
   /* The size of elements.  */
   unsigned int entsize;
   /* If non-zero, don't grow the hash table.  */
@@ -5988,6 +5993,14 @@ struct bfd
      least-recently-used list of BFDs.  */
   struct bfd *lru_prev, *lru_next;
 
+  /* For a file opened for reading, the caching routines may map
+     the whole file and read from the mapping.  MAP_BASE is the
+     mapping, or NULL if there is none, MAP_SIZE is its size and
+     MAP_POS is the current read position in it.  */
+  void *map_base;
+  ufile_ptr map_size;
+  ufile_ptr map_pos;
+
   /* When a file is closed by the caching routines, BFD retains
      state information on the file here...  */
   ufile_ptr where;
@@ -6201,6 +6214,10 @@ struct bfd
      of objalloc.h.  */
   void *memory;
 
+  /* The state of the partial decompression of compressed sections,
+     kept by bfd_get_decompressed_section_range.  */
+  void *decompress_states;
+
   /* Is the file descriptor being cached?  That is, can it be closed as
      needed, and re-opened when accessed later?  */
   unsigned int cacheable : 1;
@@ -6953,6 +6970,10 @@ bfd_boolean bfd_compress_section_contents
 bfd_boolean bfd_get_full_section_contents
    (bfd *abfd, asection *section, bfd_byte **ptr);
 
+bfd_boolean bfd_get_decompressed_section_range
+   (bfd *abfd, asection *section, void *location,
+    file_ptr offset, bfd_size_type count);
+
 void bfd_cache_section_contents
    (asection *sec, void *contents);
 
@@ -64,6 +64,14 @@ CODE_FRAGMENT
 .     least-recently-used list of BFDs.  *}
 .  struct bfd *lru_prev, *lru_next;
 .
+.  {* For a file opened for reading, the caching routines may map
+.     the whole file and read from the mapping.  MAP_BASE is the
+.     mapping, or NULL if there is none, MAP_SIZE is its size and
+.     MAP_POS is the current read position in it.  *}
+.  void *map_base;
+.  ufile_ptr map_size;
+.  ufile_ptr map_pos;
+.
 .  {* When a file is closed by the caching routines, BFD retains
 .     state information on the file here...  *}
 .  ufile_ptr where;
@@ -277,6 +285,10 @@ CODE_FRAGMENT
 .     of objalloc.h.  *}
 .  void *memory;
 .
+.  {* The state of the partial decompression of compressed sections,
+.     kept by bfd_get_decompressed_section_range.  *}
+.  void *decompress_states;
+.
 .  {* Is the file descriptor being cached?  That is, can it be closed as
 .     needed, and re-opened when accessed later?  *}
 .  unsigned int cacheable : 1;
@@ -101,6 +101,21 @@ bfd_cache_max_open (void)
 
 static int open_files;
 
+/* The most files, and the most bytes of files, which the cache will
+   keep mapped at one time.  A file opened for reading is mapped
+   whole, and reads are copied from the mapping rather than going
+   through its stream.  Since reads from a mapped file do not need its
+   file descriptor, the descriptors of mapped files are the first to
+   be closed when too many files are open.  */
+
+#define MAX_MAPPED_FILES 4096
+#define MAX_MAPPED_BYTES ((ufile_ptr) 1 << (sizeof (void *) * 8 - 3))
+
+/* The number of BFD files we have mapped, and their total size.  */
+
+static int mapped_files;
+static ufile_ptr mapped_bytes;
+
 /* Zero, or a pointer to the topmost BFD on the chain.  This is
    used by the <<bfd_cache_lookup>> macro in @file{libbfd.h} to
    determine when it can avoid a function call.  */
@@ -165,29 +180,41 @@ bfd_cache_delete (bfd *abfd)
   return ret;
 }
 
+/* Return the least recently used cacheable BFD, or NULL if there is
+   none.  If MAPPED_ONLY, only consider BFDs whose file is mapped.  */
+
+static bfd *
+lru_cacheable (bfd_boolean mapped_only)
+{
+  bfd *abfd;
+
+  if (bfd_last_cache == NULL)
+    return NULL;
+
+  for (abfd = bfd_last_cache->lru_prev;
+       ! abfd->cacheable || (mapped_only && abfd->map_base == NULL);
+       abfd = abfd->lru_prev)
+    {
+      if (abfd == bfd_last_cache)
+	return NULL;
+    }
+
+  return abfd;
+}
+
 /* We need to open a new file, and the cache is full.  Find the least
-   recently used cacheable BFD and close it.  */
+   recently used cacheable BFD and close it.  A BFD whose file is
+   mapped is closed first, since it does not need its stream to be
+   read.  */
 
 static bfd_boolean
 close_one (void)
 {
   register bfd *to_kill;
 
-  if (bfd_last_cache == NULL)
-    to_kill = NULL;
-  else
-    {
-      for (to_kill = bfd_last_cache->lru_prev;
-	   ! to_kill->cacheable;
-	   to_kill = to_kill->lru_prev)
-	{
-	  if (to_kill == bfd_last_cache)
-	    {
-	      to_kill = NULL;
-	      break;
-	    }
-	}
-    }
+  to_kill = lru_cacheable (TRUE);
+  if (to_kill == NULL)
+    to_kill = lru_cacheable (FALSE);
 
   if (to_kill == NULL)
     {
@@ -195,7 +222,10 @@ close_one (void)
       return TRUE;
     }
 
-  to_kill->where = real_ftell ((FILE *) to_kill->iostream);
+  /* The stream of a mapped file is not used for reading, so its
+     position is meaningless.  */
+  if (to_kill->map_base == NULL)
+    to_kill->where = real_ftell ((FILE *) to_kill->iostream);
 
   return bfd_cache_delete (to_kill);
 }
@@ -255,21 +285,133 @@ bfd_cache_lookup_worker (bfd *abfd, enum cache_flag flag)
   return NULL;
 }
 
+/* Map the whole of the file of ABFD, which has just been opened, if
+   it is opened for reading and the mapping limits allow it.  If the
+   file is not mapped, it is read through its stream.  */
+
+static void
+cache_map_file (bfd *abfd)
+{
+#ifdef HAVE_MMAP
+  FILE *f = (FILE *) abfd->iostream;
+  struct stat st;
+  void *base;
+
+  if (abfd->map_base != NULL
+      || abfd->direction != read_direction
+      || abfd->my_archive != NULL
+      || mapped_files >= MAX_MAPPED_FILES)
+    return;
+
+  if (fstat (fileno (f), &st) != 0
+      || ! S_ISREG (st.st_mode)
+      || st.st_size <= 0
+      || (ufile_ptr) st.st_size > MAX_MAPPED_BYTES - mapped_bytes)
+    return;
+
+  base = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno (f), 0);
+  if (base == (void *) -1)
+    return;
+
+  abfd->map_base = base;
+  abfd->map_size = st.st_size;
+  abfd->map_pos = abfd->where;
+  ++mapped_files;
+  mapped_bytes += abfd->map_size;
+#else
+  (void) abfd;
+#endif
+}
+
+/* Remove the mapping of the file of ABFD, if there is one.  */
+
+static void
+cache_unmap_file (bfd *abfd)
+{
+#ifdef HAVE_MMAP
+  if (abfd->map_base == NULL)
+    return;
+
+  munmap (abfd->map_base, abfd->map_size);
+  --mapped_files;
+  mapped_bytes -= abfd->map_size;
+
+  /* Remember the position for when the file is reopened, as
+     close_one does.  */
+  abfd->where = abfd->map_pos;
+  abfd->map_base = NULL;
+  abfd->map_size = 0;
+  abfd->map_pos = 0;
+#else
+  (void) abfd;
+#endif
+}
+
+/* Return the BFD whose mapped file ABFD is read from, or NULL if the
+   file of ABFD is not mapped.  Archive elements are read from the
+   mapping of their archive.  */
+
+static bfd *
+cache_mapped_bfd (bfd *abfd)
+{
+  while (abfd->my_archive)
+    abfd = abfd->my_archive;
+
+  return abfd->map_base != NULL ? abfd : NULL;
+}
+
 static file_ptr
 cache_btell (struct bfd *abfd)
 {
-  FILE *f = bfd_cache_lookup (abfd, CACHE_NO_OPEN);
+  bfd *mapped = cache_mapped_bfd (abfd);
+  FILE *f;
+
+  if (mapped != NULL)
+    return mapped->map_pos;
+
+  f = bfd_cache_lookup (abfd, CACHE_NO_OPEN);
   if (f == NULL)
     return abfd->where;
   return real_ftell (f);
 }
 
+/* Seek to OFFSET, relative to WHENCE, in the mapped file of ABFD.  */
+
+static int
+cache_bseek_mapped (struct bfd *abfd, file_ptr offset, int whence)
+{
+  if (whence == SEEK_CUR)
+    offset += abfd->map_pos;
+  else if (whence == SEEK_END)
+    offset += abfd->map_size;
+  if (offset < 0)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  abfd->map_pos = offset;
+  return 0;
+}
+
 static int
 cache_bseek (struct bfd *abfd, file_ptr offset, int whence)
 {
-  FILE *f = bfd_cache_lookup (abfd, whence != SEEK_CUR ? CACHE_NO_SEEK : CACHE_NORMAL);
+  bfd *mapped = cache_mapped_bfd (abfd);
+  FILE *f;
+
+  if (mapped != NULL)
+    return cache_bseek_mapped (mapped, offset, whence);
+
+  f = bfd_cache_lookup (abfd, whence != SEEK_CUR ? CACHE_NO_SEEK : CACHE_NORMAL);
   if (f == NULL)
     return -1;
+
+  /* Reopening the file may have mapped it, in which case the
+     mapping rather than the stream must be positioned.  */
+  mapped = cache_mapped_bfd (abfd);
+  if (mapped != NULL)
+    return cache_bseek_mapped (mapped, offset, whence);
+
   return real_fseek (f, offset, whence);
 }
 
@@ -331,11 +473,46 @@ cache_bread_1 (struct bfd *abfd, void *buf, file_ptr nbytes)
   return nread;
 }
 
+/* Read NBYTES into BUF from the mapped file of ABFD.  */
+
+static file_ptr
+cache_bread_mapped (struct bfd *abfd, void *buf, file_ptr nbytes)
+{
+  file_ptr nread = 0;
+
+  if (abfd->map_pos < abfd->map_size)
+    {
+      ufile_ptr left = abfd->map_size - abfd->map_pos;
+
+      nread = (ufile_ptr) nbytes < left ? nbytes : (file_ptr) left;
+      memcpy (buf, (char *) abfd->map_base + abfd->map_pos, nread);
+      abfd->map_pos += nread;
+    }
+  if (nread < nbytes)
+    /* This may or may not be an error, but in case the calling code
+       bails out because of it, set the right error code.  */
+    bfd_set_error (bfd_error_file_truncated);
+  return nread;
+}
+
 static file_ptr
 cache_bread (struct bfd *abfd, void *buf, file_ptr nbytes)
 {
+  bfd *mapped = cache_mapped_bfd (abfd);
   file_ptr nread = 0;
 
+  if (mapped != NULL)
+    return cache_bread_mapped (mapped, buf, nbytes);
+
+  /* Reopening the file may map it; read from the mapping if so.  */
+  if (nbytes == 0)
+    return 0;
+  if (bfd_cache_lookup (abfd, CACHE_NORMAL) == NULL)
+    return 0;
+  mapped = cache_mapped_bfd (abfd);
+  if (mapped != NULL)
+    return cache_bread_mapped (mapped, buf, nbytes);
+
   /* Some filesystems are unable to handle reads that are too large
      (for instance, NetApp shares with oplocks turned off).  To avoid
      hitting this limitation, we read the buffer in chunks of 8MB max.  */
@@ -485,7 +662,8 @@ SYNOPSIS
 	bfd_boolean bfd_cache_init (bfd *abfd);
 
 DESCRIPTION
-	Add a newly opened BFD to the cache.
+	Add a newly opened BFD to the cache.  If it is opened for
+	reading, map the file too.
 */
 
 bfd_boolean
@@ -500,6 +678,7 @@ bfd_cache_init (bfd *abfd)
   abfd->iovec = &cache_iovec;
   insert (abfd);
   ++open_files;
+  cache_map_file (abfd);
   return TRUE;
 }
 
@@ -512,7 +691,7 @@ SYNOPSIS
 
 DESCRIPTION
 	Remove the BFD @var{abfd} from the cache. If the attached file is open,
-	then close it too.
+	then close it too.  If it is mapped, then unmap it.
 
 RETURNS
 	<<FALSE>> is returned if closing the file fails, <<TRUE>> is
@@ -525,6 +704,8 @@ bfd_cache_close (bfd *abfd)
   if (abfd->iovec != &cache_iovec)
     return TRUE;
 
+  cache_unmap_file (abfd);
+
   if (abfd->iostream == NULL)
     /* Previously closed.  */
     return TRUE;
@@ -61,6 +61,247 @@ decompress_contents (bfd_byte *compressed_buffer,
   rc |= inflateEnd (&strm);
   return rc == Z_OK && strm.avail_out == 0;
 }
+
+/* Read the compressed contents of SEC, including the 12 byte header,
+   into BUF, which is COMPRESSED_SIZE bytes long.  */
+
+static bfd_boolean
+read_compressed_contents (bfd *abfd, sec_ptr sec, bfd_byte *buf)
+{
+  bfd_boolean ret;
+  bfd_size_type save_size;
+  bfd_size_type save_rawsize;
+  unsigned int save_status;
+
+  save_rawsize = sec->rawsize;
+  save_size = sec->size;
+  save_status = sec->compress_status;
+  /* Clear rawsize, set size to compressed size and set compress_status
+     to COMPRESS_SECTION_NONE.  If the compressed size is bigger than
+     the uncompressed size, bfd_get_section_contents will fail.  */
+  sec->rawsize = 0;
+  sec->size = sec->compressed_size;
+  sec->compress_status = COMPRESS_SECTION_NONE;
+  ret = bfd_get_section_contents (abfd, sec, buf, 0, sec->compressed_size);
+  /* Restore rawsize and size.  */
+  sec->rawsize = save_rawsize;
+  sec->size = save_size;
+  sec->compress_status = save_status;
+  return ret;
+}
+
+/* Parts of a compressed section are inflated in chunks of this many
+   bytes.  Reading part of a section only inflates the chunks it
+   touches, and the ones before them the first time.  */
+#define DECOMPRESS_CHUNK_SIZE (1024 * 1024)
+
+/* The number of inflated chunks kept for each section.  */
+#define DECOMPRESS_CACHE_CHUNKS 4
+
+/* A chunk of inflated section contents.  */
+
+struct decompress_chunk
+{
+  /* The number of the chunk, or -1 if the slot is unused.  */
+  bfd_size_type index;
+  /* The value of the use counter of the section when the chunk was
+     last read.  */
+  unsigned long last_use;
+  bfd_byte *data;
+};
+
+/* The state of the partial decompression of a section.  These are
+   kept on the decompress_states list of the BFD.  */
+
+struct decompress_state
+{
+  struct decompress_state *next;
+  asection *sec;
+  /* The compressed contents, including the 12 byte header.  */
+  bfd_byte *compressed;
+  /* The number of chunks of uncompressed contents.  */
+  bfd_size_type chunk_count;
+  /* The inflate state at the start of each of the first
+     CHECKPOINT_COUNT chunks, so that a chunk can be inflated again
+     without starting from the beginning of the section.  */
+  z_stream *checkpoints;
+  bfd_size_type checkpoint_count;
+  struct decompress_chunk cache[DECOMPRESS_CACHE_CHUNKS];
+  unsigned long use_count;
+};
+
+/* Free STATE.  */
+
+static void
+free_decompress_state (struct decompress_state *state)
+{
+  bfd_size_type i;
+
+  for (i = 0; i < state->checkpoint_count; i++)
+    inflateEnd (&state->checkpoints[i]);
+  for (i = 0; i < DECOMPRESS_CACHE_CHUNKS; i++)
+    free (state->cache[i].data);
+  free (state->checkpoints);
+  free (state->compressed);
+  free (state);
+}
+
+/* Return the partial decompression state of SEC in ABFD, creating it
+   if needed.  */
+
+static struct decompress_state *
+get_decompress_state (bfd *abfd, sec_ptr sec)
+{
+  struct decompress_state *state;
+  unsigned int i;
+
+  for (state = (struct decompress_state *) abfd->decompress_states;
+       state != NULL;
+       state = state->next)
+    if (state->sec == sec)
+      return state;
+
+  if (sec->compressed_size <= 12)
+    {
+      bfd_set_error (bfd_error_bad_value);
+      return NULL;
+    }
+
+  state = (struct decompress_state *) bfd_zmalloc (sizeof (*state));
+  if (state == NULL)
+    return NULL;
+  state->sec = sec;
+  for (i = 0; i < DECOMPRESS_CACHE_CHUNKS; i++)
+    state->cache[i].index = (bfd_size_type) -1;
+  state->chunk_count = ((sec->size + DECOMPRESS_CHUNK_SIZE - 1)
+			/ DECOMPRESS_CHUNK_SIZE);
+  state->compressed = (bfd_byte *) bfd_malloc (sec->compressed_size);
+  state->checkpoints = (z_stream *) bfd_malloc (state->chunk_count
+						* sizeof (z_stream));
+  if (state->compressed == NULL
+      || state->checkpoints == NULL
+      || !read_compressed_contents (abfd, sec, state->compressed))
+    {
+      free_decompress_state (state);
+      return NULL;
+    }
+
+  memset (&state->checkpoints[0], 0, sizeof (z_stream));
+  state->checkpoints[0].next_in = (Bytef *) state->compressed + 12;
+  state->checkpoints[0].avail_in = sec->compressed_size - 12;
+  if (inflateInit (&state->checkpoints[0]) != Z_OK)
+    {
+      free_decompress_state (state);
+      bfd_set_error (bfd_error_no_memory);
+      return NULL;
+    }
+  state->checkpoint_count = 1;
+
+  state->next = (struct decompress_state *) abfd->decompress_states;
+  abfd->decompress_states = state;
+  return state;
+}
+
+/* Inflate chunk INDEX of the section of STATE from STRM, which is
+   positioned at its start, into DEST.  */
+
+static bfd_boolean
+inflate_chunk (struct decompress_state *state, z_stream *strm,
+	       bfd_size_type index, bfd_byte *dest)
+{
+  bfd_size_type size = state->sec->size - index * DECOMPRESS_CHUNK_SIZE;
+
+  if (size > DECOMPRESS_CHUNK_SIZE)
+    size = DECOMPRESS_CHUNK_SIZE;
+  strm->next_out = (Bytef *) dest;
+  strm->avail_out = size;
+
+  /* The section may consist of several compressed streams
+     concatenated together.  */
+  while (strm->avail_out > 0)
+    {
+      int rc;
+
+      if (strm->avail_in == 0)
+	return FALSE;
+      rc = inflate (strm, Z_NO_FLUSH);
+      if (rc == Z_STREAM_END)
+	rc = inflateReset (strm);
+      if (rc != Z_OK)
+	return FALSE;
+    }
+  return TRUE;
+}
+
+/* Return the inflated chunk INDEX of the section of STATE.  */
+
+static bfd_byte *
+get_decompressed_chunk (struct decompress_state *state, bfd_size_type index)
+{
+  struct decompress_chunk *slot = NULL;
+  bfd_size_type i;
+  unsigned int j;
+  z_stream strm;
+
+  for (j = 0; j < DECOMPRESS_CACHE_CHUNKS; j++)
+    if (state->cache[j].index == index)
+      {
+	state->cache[j].last_use = ++state->use_count;
+	return state->cache[j].data;
+      }
+
+  /* Inflate from the last saved state at or before the chunk,
+     keeping the chunks and saving the states passed on the way.  */
+  i = index;
+  if (i >= state->checkpoint_count)
+    i = state->checkpoint_count - 1;
+  if (inflateCopy (&strm, &state->checkpoints[i]) != Z_OK)
+    {
+      bfd_set_error (bfd_error_no_memory);
+      return NULL;
+    }
+
+  for (;; i++)
+    {
+      slot = &state->cache[0];
+      for (j = 1; j < DECOMPRESS_CACHE_CHUNKS; j++)
+	if (state->cache[j].last_use < slot->last_use)
+	  slot = &state->cache[j];
+      slot->index = (bfd_size_type) -1;
+      if (slot->data == NULL)
+	{
+	  slot->data = (bfd_byte *) bfd_malloc (DECOMPRESS_CHUNK_SIZE);
+	  if (slot->data == NULL)
+	    break;
+	}
+      if (!inflate_chunk (state, &strm, i, slot->data))
+	{
+	  bfd_set_error (bfd_error_bad_value);
+	  break;
+	}
+      slot->index = i;
+      slot->last_use = ++state->use_count;
+
+      if (i + 1 == state->checkpoint_count && i + 1 < state->chunk_count)
+	{
+	  if (inflateCopy (&state->checkpoints[i + 1], &strm) != Z_OK)
+	    {
+	      bfd_set_error (bfd_error_no_memory);
+	      break;
+	    }
+	  state->checkpoint_count++;
+	}
+
+      if (i == index)
+	{
+	  inflateEnd (&strm);
+	  return slot->data;
+	}
+    }
+
+  inflateEnd (&strm);
+  return NULL;
+}
 #endif
 
 /*
@@ -161,9 +402,6 @@ bfd_get_full_section_contents (bfd *abfd, sec_ptr sec, bfd_byte **ptr)
   bfd_size_type sz;
   bfd_byte *p = *ptr;
 #ifdef HAVE_ZLIB_H
-  bfd_boolean ret;
-  bfd_size_type save_size;
-  bfd_size_type save_rawsize;
   bfd_byte *compressed_buffer;
 #endif
 
@@ -201,21 +439,7 @@ bfd_get_full_section_contents (bfd *abfd, sec_ptr sec, bfd_byte **ptr)
       compressed_buffer = (bfd_byte *) bfd_malloc (sec->compressed_size);
       if (compressed_buffer == NULL)
 	return FALSE;
-      save_rawsize = sec->rawsize;
-      save_size = sec->size;
-      /* Clear rawsize, set size to compressed size and set compress_status
-	 to COMPRESS_SECTION_NONE.  If the compressed size is bigger than
-	 the uncompressed size, bfd_get_section_contents will fail.  */
-      sec->rawsize = 0;
-      sec->size = sec->compressed_size;
-      sec->compress_status = COMPRESS_SECTION_NONE;
-      ret = bfd_get_section_contents (abfd, sec, compressed_buffer,
-				      0, sec->compressed_size);
-      /* Restore rawsize and size.  */
-      sec->rawsize = save_rawsize;
-      sec->size = save_size;
-      sec->compress_status = DECOMPRESS_SECTION_SIZED;
-      if (!ret)
+      if (!read_compressed_contents (abfd, sec, compressed_buffer))
 	goto fail_compressed;
 
       if (p == NULL)
@@ -254,6 +478,105 @@ bfd_get_full_section_contents (bfd *abfd, sec_ptr sec, bfd_byte **ptr)
     }
 }
 
+/*
+FUNCTION
+	bfd_get_decompressed_section_range
+
+SYNOPSIS
+	bfd_boolean bfd_get_decompressed_section_range
+	  (bfd *abfd, asection *section, void *location,
+	   file_ptr offset, bfd_size_type count);
+
+DESCRIPTION
+	Read @var{count} bytes at @var{offset} in the decompressed
+	contents of @var{section} in BFD @var{abfd} into @var{location}.
+	@var{section} must have been sized for decompression by
+	bfd_init_section_decompress_status.  The section is inflated
+	in chunks and only as far as the end of the range read; the
+	state of the decompression at the start of each chunk and the
+	most recently read chunks are kept until @var{abfd} is closed,
+	so that later reads of nearby or earlier ranges are cheap.
+	bfd_get_section_contents calls this for such sections.
+
+	Return @code{TRUE} if the range is retrieved successfully.
+*/
+
+bfd_boolean
+bfd_get_decompressed_section_range (bfd *abfd ATTRIBUTE_UNUSED,
+				    sec_ptr sec ATTRIBUTE_UNUSED,
+				    void *location ATTRIBUTE_UNUSED,
+				    file_ptr offset ATTRIBUTE_UNUSED,
+				    bfd_size_type count ATTRIBUTE_UNUSED)
+{
+#ifndef HAVE_ZLIB_H
+  bfd_set_error (bfd_error_invalid_operation);
+  return FALSE;
+#else
+  struct decompress_state *state;
+  bfd_byte *dest = (bfd_byte *) location;
+
+  if (sec->compress_status != DECOMPRESS_SECTION_SIZED)
+    {
+      bfd_set_error (bfd_error_invalid_operation);
+      return FALSE;
+    }
+
+  if ((bfd_size_type) offset > sec->size
+      || count > sec->size - offset)
+    {
+      bfd_set_error (bfd_error_bad_value);
+      return FALSE;
+    }
+
+  if (count == 0)
+    return TRUE;
+
+  state = get_decompress_state (abfd, sec);
+  if (state == NULL)
+    return FALSE;
+
+  while (count > 0)
+    {
+      bfd_size_type index = offset / DECOMPRESS_CHUNK_SIZE;
+      bfd_size_type start = offset % DECOMPRESS_CHUNK_SIZE;
+      bfd_size_type len = DECOMPRESS_CHUNK_SIZE - start;
+      bfd_byte *chunk;
+
+      chunk = get_decompressed_chunk (state, index);
+      if (chunk == NULL)
+	return FALSE;
+      if (len > count)
+	len = count;
+      memcpy (dest, chunk + start, len);
+      dest += len;
+      offset += len;
+      count -= len;
+    }
+
+  return TRUE;
+#endif
+}
+
+/* Free the state kept by bfd_get_decompressed_section_range for the
+   sections of ABFD.  */
+
+void
+_bfd_free_decompress_states (bfd *abfd)
+{
+#ifdef HAVE_ZLIB_H
+  struct decompress_state *state, *next;
+
+  for (state = (struct decompress_state *) abfd->decompress_states;
+       state != NULL;
+       state = next)
+    {
+      next = state->next;
+      free_decompress_state (state);
+    }
+#endif
+  abfd->decompress_states = NULL;
+}
+
 /*
 FUNCTION
 	bfd_cache_section_contents
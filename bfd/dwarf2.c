@@ -35,6 +35,7 @@
 #include "libbfd.h"
 #include "elf-bfd.h"
 #include "dwarf2.h"
+#include "hashtab.h"
 
 /* The data in the .debug_line statement prologue looks like this.  */
 
@@ -144,6 +145,15 @@ struct dwarf2_debug
   /* Length of the loaded .debug_str section.  */
   bfd_size_type dwarf_str_size;
 
+  /* If the .debug_str section is compressed, strings are read from it
+     one at a time instead of inflating all of it into
+     dwarf_str_buffer.  DWARF_STR_SECTION is then the section and
+     DWARF_STR_HTAB holds the strings read, indexed by offset.
+     DWARF_STR_CHECKED is set once the section has been looked at.  */
+  asection *dwarf_str_section;
+  htab_t dwarf_str_htab;
+  bfd_boolean dwarf_str_checked;
+
   /* Pointer to the .debug_ranges section loaded into memory. */
   bfd_byte *dwarf_ranges_buffer;
 
@@ -185,6 +195,51 @@ struct dwarf2_debug
 
   /* True if we opened bfd_ptr.  */
   bfd_boolean close_on_cleanup;
+
+  /* The number of comp units read so far.  */
+  unsigned int comp_unit_count;
+
+  /* The address ranges of the comp units, sorted by start address,
+     for finding the comp units which contain an address.  */
+  struct unit_range *unit_ranges;
+  unsigned int unit_range_count;
+
+  /* The comp units in the table above with no address range, which
+     may contain any address.  */
+  struct comp_unit **unit_ranges_any;
+  unsigned int unit_ranges_any_count;
+
+  /* The number of comp units which were read when the table was
+     built.  */
+  unsigned int unit_ranges_units;
+
+  /* The comp units whose address ranges changed after the table was
+     built, which must be checked one by one like the comp units read
+     after the table was built.  */
+  struct comp_unit **unit_ranges_changed;
+  unsigned int unit_ranges_changed_count;
+  unsigned int unit_ranges_changed_alloc;
+
+  /* A buffer for the comp units which may contain an address.  */
+  struct comp_unit **unit_candidates;
+  unsigned int unit_candidates_alloc;
+
+  /* A buffer for the functions which may contain an address.  */
+  struct lookup_funcinfo **func_candidates;
+  unsigned int func_candidates_alloc;
+};
+
+/* An entry in the table of comp unit address ranges.  MAX_HIGH is the
+   highest HIGH of this entry and all entries before it, so that the
+   table may be binary searched for the entries containing an
+   address.  */
+
+struct unit_range
+{
+  bfd_vma low;
+  bfd_vma high;
+  bfd_vma max_high;
+  struct comp_unit *unit;
 };
 
 struct arange
@@ -271,6 +326,23 @@ struct comp_unit
 
   /* TRUE if symbols are cached in hash table for faster lookup by name.  */
   bfd_boolean cached;
+
+  /* The number of comp units read before this one.  */
+  unsigned int index;
+
+  /* TRUE if the current address ranges of this comp unit are in the
+     stash's table of comp unit address ranges.  */
+  bfd_boolean in_unit_ranges;
+
+  /* The functions in function_table, sorted by address, for finding
+     the functions which contain an address.  NULL if not yet
+     built.  */
+  struct lookup_funcinfo *lookup_funcinfo_table;
+  unsigned int number_of_functions;
+
+  /* A hash table mapping the DIEs referred to by abstract origins and
+     specifications to their names.  NULL if not yet created.  */
+  htab_t abstract_names;
 };
 
 /* This data structure holds the information of an abbrev.  */
@@ -614,6 +686,144 @@ read_string (bfd *abfd ATTRIBUTE_UNUSED,
 
 /* END VERBATIM */
 
+/* An entry in the hash table of the strings read from a compressed
+   .debug_str section.  */
+
+struct indirect_string
+{
+  bfd_uint64_t offset;
+  char *str;
+};
+
+static hashval_t
+hash_indirect_string (const void *p)
+{
+  const struct indirect_string *entry = (const struct indirect_string *) p;
+  return (hashval_t) (entry->offset ^ (entry->offset >> 31 >> 1));
+}
+
+static int
+eq_indirect_string (const void *p1, const void *p2)
+{
+  const struct indirect_string *entry1 = (const struct indirect_string *) p1;
+  const struct indirect_string *entry2 = (const struct indirect_string *) p2;
+  return entry1->offset == entry2->offset;
+}
+
+/* Return TRUE if the strings of the .debug_str section of UNIT should
+   be read one at a time by read_compressed_string.  That is the case
+   if the section is compressed and needs no relocation, since
+   bfd_get_section_contents then only inflates the part of it read.  */
+
+static bfd_boolean
+use_compressed_string_section (struct comp_unit *unit)
+{
+  struct dwarf2_debug *stash = unit->stash;
+  const struct dwarf_debug_section *sec = &stash->debug_sections[debug_str];
+  asection *msec;
+
+  if (stash->dwarf_str_checked)
+    return stash->dwarf_str_htab != NULL;
+  stash->dwarf_str_checked = TRUE;
+
+  msec = bfd_get_section_by_name (unit->abfd, sec->uncompressed_name);
+  if (msec == NULL && sec->compressed_name != NULL)
+    msec = bfd_get_section_by_name (unit->abfd, sec->compressed_name);
+  if (msec == NULL
+      || msec->compress_status != DECOMPRESS_SECTION_SIZED
+      || (stash->syms != NULL && (msec->flags & SEC_RELOC) != 0))
+    return FALSE;
+
+  stash->dwarf_str_htab = htab_try_create (256, hash_indirect_string,
+					   eq_indirect_string, NULL);
+  if (stash->dwarf_str_htab == NULL)
+    return FALSE;
+  stash->dwarf_str_section = msec;
+  return TRUE;
+}
+
+/* Read the string at OFFSET in the compressed .debug_str section of
+   UNIT, inflating only the part of the section which holds it.  */
+
+static char *
+read_compressed_string (struct comp_unit *unit, bfd_uint64_t offset)
+{
+  struct dwarf2_debug *stash = unit->stash;
+  asection *msec = stash->dwarf_str_section;
+  bfd_size_type size = msec->size;
+  struct indirect_string key;
+  struct indirect_string *entry;
+  bfd_byte *buf = NULL;
+  bfd_size_type len = 0;
+  void **slot;
+
+  if (offset >= size)
+    {
+      (*_bfd_error_handler) (_("Dwarf Error: Offset (%lu)"
+			       " greater than or equal to %s size (%lu)."),
+			     (long) offset, bfd_get_section_name (unit->abfd,
+								  msec),
+			     size);
+      bfd_set_error (bfd_error_bad_value);
+      return NULL;
+    }
+
+  key.offset = offset;
+  entry = (struct indirect_string *) htab_find (stash->dwarf_str_htab, &key);
+  if (entry != NULL)
+    return entry->str;
+
+  /* Read the string in pieces until its terminating NUL, or the end
+     of the section.  */
+  while (offset + len < size)
+    {
+      bfd_size_type piece = 256;
+      bfd_byte *newbuf;
+      bfd_byte *end;
+
+      if (piece > size - (offset + len))
+	piece = size - (offset + len);
+      newbuf = (bfd_byte *) bfd_realloc (buf, len + piece + 1);
+      if (newbuf == NULL)
+	{
+	  free (buf);
+	  return NULL;
+	}
+      buf = newbuf;
+      if (! bfd_get_section_contents (unit->abfd, msec, buf + len,
+				      offset + len, piece))
+	{
+	  free (buf);
+	  return NULL;
+	}
+      end = (bfd_byte *) memchr (buf + len, 0, piece);
+      if (end != NULL)
+	{
+	  len = end - buf;
+	  break;
+	}
+      len += piece;
+    }
+
+  entry = (struct indirect_string *) bfd_alloc (unit->abfd,
+						sizeof (*entry) + len + 1);
+  if (entry == NULL)
+    {
+      free (buf);
+      return NULL;
+    }
+  entry->offset = offset;
+  entry->str = (char *) (entry + 1);
+  memcpy (entry->str, buf, len);
+  entry->str[len] = '\0';
+  free (buf);
+
+  slot = htab_find_slot (stash->dwarf_str_htab, entry, INSERT);
+  if (slot != NULL)
+    *slot = entry;
+  return entry->str;
+}
+
 static char *
 read_indirect_string (struct comp_unit * unit,
 		      bfd_byte *         buf,
@@ -630,12 +840,22 @@ read_indirect_string (struct comp_unit * unit,
 
   *bytes_read_ptr = unit->offset_size;
 
-  if (! read_section (unit->abfd, &stash->debug_sections[debug_str],
-                      stash->syms, offset,
-		      &stash->dwarf_str_buffer, &stash->dwarf_str_size))
-    return NULL;
+  if (use_compressed_string_section (unit))
+    {
+      str = read_compressed_string (unit, offset);
+      if (str == NULL)
+	return NULL;
+    }
+  else
+    {
+      if (! read_section (unit->abfd, &stash->debug_sections[debug_str],
+			  stash->syms, offset,
+			  &stash->dwarf_str_buffer, &stash->dwarf_str_size))
+	return NULL;
+
+      str = (char *) stash->dwarf_str_buffer + offset;
+    }
 
-  str = (char *) stash->dwarf_str_buffer + offset;
   if (*str == '\0')
     return NULL;
   return str;
@@ -1119,6 +1339,8 @@ struct line_sequence
   bfd_vma               low_pc;
   struct line_sequence* prev_sequence;
   struct line_info*     last_line;  /* Largest VMA.  */
+  struct line_info**    line_info_lookup;  /* Sorted by VMA, or NULL.  */
+  unsigned int          num_lines;
 };
 
 struct line_info_table
@@ -1160,6 +1382,21 @@ struct funcinfo
   asection *sec;
 };
 
+/* An entry in the table of functions of a comp unit sorted by
+   address.  LOW_ADDR and HIGH_ADDR span all the address ranges of the
+   function, except that HIGH_ADDR is raised to the highest HIGH_ADDR
+   of the entries before it, so that the table may be binary searched.
+   INDEX is the position of the function in the function_table
+   list.  */
+
+struct lookup_funcinfo
+{
+  struct funcinfo *funcinfo;
+  bfd_vma low_addr;
+  bfd_vma high_addr;
+  unsigned int index;
+};
+
 struct varinfo
 {
   /* Pointer to previous variable in list of all variables */
@@ -1268,6 +1505,8 @@ add_line_info (struct line_info_table *table,
       seq->low_pc = address;
       seq->prev_sequence = table->sequences;
       seq->last_line = info;
+      seq->line_info_lookup = NULL;
+      seq->num_lines = 0;
       table->lcl_head = info;
       table->sequences = seq;
       table->num_sequences++;
@@ -1487,6 +1726,8 @@ sort_line_sequences (struct line_info_table* table)
       sequences[n].low_pc = seq->low_pc;
       sequences[n].prev_sequence = NULL;
       sequences[n].last_line = seq->last_line;
+      sequences[n].line_info_lookup = NULL;
+      sequences[n].num_lines = 0;
       seq = seq->prev_sequence;
       free (last_seq);
     }
@@ -1524,6 +1765,92 @@ sort_line_sequences (struct line_info_table* table)
   return TRUE;
 }
 
+/* Build the array of the lines of SEQ sorted by VMA, so that the
+   line containing an address may be found by a binary search.  */
+
+static bfd_boolean
+build_line_info_table (struct line_info_table *table,
+		       struct line_sequence *seq)
+{
+  bfd_size_type amt;
+  struct line_info **line_info_lookup;
+  struct line_info *each_line;
+  unsigned int num_lines;
+  unsigned int line_index;
+
+  if (seq->line_info_lookup != NULL)
+    return TRUE;
+
+  num_lines = 0;
+  for (each_line = seq->last_line; each_line; each_line = each_line->prev_line)
+    num_lines++;
+
+  amt = sizeof (struct line_info *) * num_lines;
+  line_info_lookup = (struct line_info **) bfd_alloc (table->abfd, amt);
+  if (line_info_lookup == NULL)
+    return FALSE;
+
+  /* The lines are chained in descending order.  */
+  line_index = num_lines;
+  for (each_line = seq->last_line; each_line; each_line = each_line->prev_line)
+    line_info_lookup[--line_index] = each_line;
+
+  BFD_ASSERT (line_index == 0);
+
+  seq->line_info_lookup = line_info_lookup;
+  seq->num_lines = num_lines;
+  return TRUE;
+}
+
+/* Return TRUE if the addresses from LOW_PC up to HIGH_PC are already
+   in the address ranges of UNIT.  */
+
+static bfd_boolean
+unit_range_covered (struct comp_unit *unit, bfd_vma low_pc, bfd_vma high_pc)
+{
+  struct arange *arange;
+
+  if (low_pc == high_pc)
+    return TRUE;
+
+  if (unit->arange.high == 0)
+    return FALSE;
+
+  for (arange = &unit->arange; arange; arange = arange->next)
+    if (low_pc >= arange->low && high_pc <= arange->high)
+      return TRUE;
+
+  return FALSE;
+}
+
+/* Note that the address ranges of UNIT are about to change, so that
+   they are no longer those in the table of comp unit address
+   ranges.  */
+
+static bfd_boolean
+note_unit_ranges_changed (struct dwarf2_debug *stash, struct comp_unit *unit)
+{
+  if (! unit->in_unit_ranges)
+    return TRUE;
+
+  if (stash->unit_ranges_changed_count >= stash->unit_ranges_changed_alloc)
+    {
+      unsigned int alloc = stash->unit_ranges_changed_alloc * 2 + 16;
+      struct comp_unit **changed;
+
+      changed = (struct comp_unit **)
+	bfd_realloc (stash->unit_ranges_changed, alloc * sizeof (*changed));
+      if (changed == NULL)
+	return FALSE;
+      stash->unit_ranges_changed = changed;
+      stash->unit_ranges_changed_alloc = alloc;
+    }
+
+  stash->unit_ranges_changed[stash->unit_ranges_changed_count++] = unit;
+  unit->in_unit_ranges = FALSE;
+  return TRUE;
+}
+
 /* Decode the line number information for UNIT.  */
 
 static struct line_info_table*
@@ -1760,6 +2087,9 @@ decode_line_info (struct comp_unit *unit, struct dwarf2_debug *stash)
 		    low_pc = address;
 		  if (address > high_pc)
 		    high_pc = address;
+		  if (!unit_range_covered (unit, low_pc, high_pc)
+		      && !note_unit_ranges_changed (stash, unit))
+		    goto line_fail;
 		  if (!arange_add (unit, &unit->arange, low_pc, high_pc))
 		    goto line_fail;
 		  break;
@@ -1925,6 +2255,7 @@ lookup_address_in_line_info_table (struct line_info_table *table,
   struct line_sequence *seq = NULL;
   struct line_info *each_line;
   int low, high, mid;
+  unsigned int line_low, line_high, line_mid;
 
   /* Binary search the array of sequences.  */
   low = 0;
@@ -1943,12 +2274,25 @@ lookup_address_in_line_info_table (struct line_info_table *table,
 
   if (seq && addr >= seq->low_pc && addr < seq->last_line->address)
     {
-      /* Note: seq->last_line should be a descendingly sorted list.  */
-      for (each_line = seq->last_line;
-           each_line;
-           each_line = each_line->prev_line)
-        if (addr >= each_line->address)
-          break;
+      if (! build_line_info_table (table, seq))
+	{
+	  *filename_ptr = NULL;
+	  return 0;
+	}
+
+      /* Binary search for the last line at or before ADDR.  This is
+	 the first line at or before ADDR in the descending list.  */
+      line_low = 0;
+      line_high = seq->num_lines;
+      while (line_low < line_high)
+	{
+	  line_mid = (line_low + line_high) / 2;
+	  if (seq->line_info_lookup[line_mid]->address <= addr)
+	    line_low = line_mid + 1;
+	  else
+	    line_high = line_mid;
+	}
+      each_line = line_low > 0 ? seq->line_info_lookup[line_low - 1] : NULL;
 
       if (each_line
           && !(each_line->end_sequence || each_line == seq->last_line))
@@ -1978,6 +2322,109 @@ read_debug_ranges (struct comp_unit *unit)
 
 /* Function table functions.  */
 
+/* Compare function for the sorted function table.  */
+
+static int
+compare_lookup_funcinfos (const void *a, const void *b)
+{
+  const struct lookup_funcinfo *lookup1 = (const struct lookup_funcinfo *) a;
+  const struct lookup_funcinfo *lookup2 = (const struct lookup_funcinfo *) b;
+
+  if (lookup1->low_addr < lookup2->low_addr)
+    return -1;
+  if (lookup1->low_addr > lookup2->low_addr)
+    return 1;
+  if (lookup1->high_addr < lookup2->high_addr)
+    return -1;
+  if (lookup1->high_addr > lookup2->high_addr)
+    return 1;
+
+  return lookup1->index < lookup2->index ? -1 : 1;
+}
+
+/* Build the table of the functions of UNIT sorted by address.  */
+
+static bfd_boolean
+build_lookup_funcinfo_table (struct comp_unit *unit)
+{
+  struct lookup_funcinfo *lookup_funcinfo_table;
+  unsigned int number_of_functions = 0;
+  struct funcinfo *each_func;
+  struct arange *arange;
+  unsigned int func_index;
+  bfd_vma high_addr;
+
+  for (each_func = unit->function_table;
+       each_func;
+       each_func = each_func->prev_func)
+    number_of_functions++;
+
+  if (number_of_functions == 0)
+    return TRUE;
+
+  lookup_funcinfo_table = (struct lookup_funcinfo *)
+    bfd_alloc (unit->abfd, number_of_functions * sizeof (*lookup_funcinfo_table));
+  if (lookup_funcinfo_table == NULL)
+    return FALSE;
+
+  for (each_func = unit->function_table, func_index = 0;
+       each_func;
+       each_func = each_func->prev_func, func_index++)
+    {
+      struct lookup_funcinfo *entry = &lookup_funcinfo_table[func_index];
+
+      entry->funcinfo = each_func;
+      entry->index = func_index;
+      entry->low_addr = each_func->arange.low;
+      entry->high_addr = each_func->arange.high;
+      for (arange = each_func->arange.next; arange; arange = arange->next)
+	{
+	  if (arange->low < entry->low_addr)
+	    entry->low_addr = arange->low;
+	  if (arange->high > entry->high_addr)
+	    entry->high_addr = arange->high;
+	}
+    }
+
+  qsort (lookup_funcinfo_table, number_of_functions,
+	 sizeof (*lookup_funcinfo_table), compare_lookup_funcinfos);
+
+  /* Raise each HIGH_ADDR to the highest one before it, so that the
+     entries are sorted by HIGH_ADDR too.  */
+  high_addr = lookup_funcinfo_table[0].high_addr;
+  for (func_index = 1; func_index < number_of_functions; func_index++)
+    {
+      struct lookup_funcinfo *entry = &lookup_funcinfo_table[func_index];
+
+      if (entry->high_addr > high_addr)
+	high_addr = entry->high_addr;
+      else
+	entry->high_addr = high_addr;
+    }
+
+  unit->lookup_funcinfo_table = lookup_funcinfo_table;
+  unit->number_of_functions = number_of_functions;
+  return TRUE;
+}
+
+/* Compare function to sort functions in the order of the
+   function_table list.  */
+
+static int
+compare_func_candidates (const void *a, const void *b)
+{
+  const struct lookup_funcinfo *lookup1
+    = *(const struct lookup_funcinfo * const *) a;
+  const struct lookup_funcinfo *lookup2
+    = *(const struct lookup_funcinfo * const *) b;
+
+  if (lookup1->index < lookup2->index)
+    return -1;
+  if (lookup1->index > lookup2->index)
+    return 1;
+  return 0;
+}
+
 /* If ADDR is within UNIT's function tables, set FUNCTIONNAME_PTR, and return
    TRUE.  Note that we need to find the function that has the smallest range
    that contains ADDR, to handle inlined functions without depending upon
@@ -1989,14 +2436,63 @@ lookup_address_in_function_table (struct comp_unit *unit,
 				  struct funcinfo **function_ptr,
 				  const char **functionname_ptr)
 {
+  struct dwarf2_debug *stash = unit->stash;
   struct funcinfo* each_func;
   struct funcinfo* best_fit = NULL;
   struct arange *arange;
+  unsigned int low, high, mid;
+  unsigned int count = 0;
+  unsigned int i;
 
-  for (each_func = unit->function_table;
-       each_func;
-       each_func = each_func->prev_func)
+  if (unit->lookup_funcinfo_table == NULL
+      && ! build_lookup_funcinfo_table (unit))
+    return FALSE;
+
+  /* Find the first function which may contain ADDR.  */
+  low = 0;
+  high = unit->number_of_functions;
+  while (low < high)
     {
+      mid = (low + high) / 2;
+      if (addr < unit->lookup_funcinfo_table[mid].high_addr)
+	high = mid;
+      else
+	low = mid + 1;
+    }
+
+  /* Collect the functions which may contain ADDR.  */
+  for (; low < unit->number_of_functions; low++)
+    {
+      struct lookup_funcinfo *lookup_funcinfo;
+
+      lookup_funcinfo = &unit->lookup_funcinfo_table[low];
+      if (addr < lookup_funcinfo->low_addr)
+	break;
+
+      if (count >= stash->func_candidates_alloc)
+	{
+	  unsigned int alloc = stash->func_candidates_alloc * 2 + 16;
+	  struct lookup_funcinfo **candidates;
+
+	  candidates = (struct lookup_funcinfo **)
+	    bfd_realloc (stash->func_candidates, alloc * sizeof (*candidates));
+	  if (candidates == NULL)
+	    return FALSE;
+	  stash->func_candidates = candidates;
+	  stash->func_candidates_alloc = alloc;
+	}
+      stash->func_candidates[count++] = lookup_funcinfo;
+    }
+
+  /* Look at them in list order, so that the result is the same as
+     that of searching the whole list.  */
+  if (count > 1)
+    qsort (stash->func_candidates, count, sizeof (*stash->func_candidates),
+	   compare_func_candidates);
+
+  for (i = 0; i < count; i++)
+    {
+      each_func = stash->func_candidates[i]->funcinfo;
       for (arange = &each_func->arange;
 	   arange;
 	   arange = arange->next)
@@ -2106,16 +2602,43 @@ lookup_symbol_in_variable_table (struct comp_unit *unit,
     return FALSE;
 }
 
+/* An entry in the hash table of the names of abstract instances.  */
+
+struct abstract_name
+{
+  bfd_byte *info_ptr;
+  char *name;
+};
+
+static hashval_t
+hash_abstract_name (const void *p)
+{
+  const struct abstract_name *entry = (const struct abstract_name *) p;
+  return htab_hash_pointer (entry->info_ptr);
+}
+
+static int
+eq_abstract_name (const void *p1, const void *p2)
+{
+  const struct abstract_name *entry1 = (const struct abstract_name *) p1;
+  const struct abstract_name *entry2 = (const struct abstract_name *) p2;
+  return entry1->info_ptr == entry2->info_ptr;
+}
+
 static char *
 find_abstract_instance_name (struct comp_unit *unit,
 			     struct attribute *attr_ptr)
 {
   bfd *abfd = unit->abfd;
   bfd_byte *info_ptr;
+  bfd_byte *die_ptr;
   unsigned int abbrev_number, bytes_read, i;
   struct abbrev_info *abbrev;
   bfd_uint64_t die_ref = attr_ptr->u.val;
   struct attribute attr;
+  struct abstract_name key;
+  struct abstract_name *entry;
+  void **slot;
   char *name = NULL;
 
   /* DW_FORM_ref_addr can reference an entry in a different CU. It
@@ -2143,6 +2666,25 @@ find_abstract_instance_name (struct comp_unit *unit,
   else
     info_ptr = unit->info_ptr_unit + die_ref;
 
+  /* Many inlined instances and declarations may refer to the same
+     DIE, so remember the names we have found.  */
+  if (unit->abstract_names == NULL)
+    {
+      unit->abstract_names = htab_try_create (16, hash_abstract_name,
+					      eq_abstract_name, NULL);
+      if (unit->abstract_names == NULL)
+	{
+	  bfd_set_error (bfd_error_no_memory);
+	  return name;
+	}
+    }
+
+  key.info_ptr = info_ptr;
+  entry = (struct abstract_name *) htab_find (unit->abstract_names, &key);
+  if (entry != NULL)
+    return entry->name;
+
+  die_ptr = info_ptr;
   abbrev_number = read_unsigned_leb128 (abfd, info_ptr, &bytes_read);
   info_ptr += bytes_read;
 
@@ -2184,6 +2726,18 @@ find_abstract_instance_name (struct comp_unit *unit,
 	    }
 	}
     }
+
+  /* The table may have grown while finding a specification, so look
+     for the slot only now.  */
+  entry = (struct abstract_name *) bfd_alloc (abfd, sizeof (*entry));
+  if (entry != NULL)
+    {
+      entry->info_ptr = die_ptr;
+      entry->name = name;
+      slot = htab_find_slot (unit->abstract_names, entry, INSERT);
+      if (slot != NULL)
+	*slot = entry;
+    }
   return name;
 }
 
@@ -2684,6 +3238,238 @@ comp_unit_contains_address (struct comp_unit *unit, bfd_vma addr)
   return FALSE;
 }
 
+/* Compare function for the table of comp unit address ranges.  */
+
+static int
+compare_unit_ranges (const void *a, const void *b)
+{
+  const struct unit_range *range1 = (const struct unit_range *) a;
+  const struct unit_range *range2 = (const struct unit_range *) b;
+
+  if (range1->low < range2->low)
+    return -1;
+  if (range1->low > range2->low)
+    return 1;
+  if (range1->unit->index < range2->unit->index)
+    return -1;
+  if (range1->unit->index > range2->unit->index)
+    return 1;
+  return 0;
+}
+
+/* Build the table of the address ranges of all the comp units read so
+   far.  */
+
+static bfd_boolean
+build_unit_ranges (struct dwarf2_debug *stash)
+{
+  struct comp_unit *each;
+  struct arange *arange;
+  unsigned int range_count = 0;
+  unsigned int any_count = 0;
+  struct unit_range *ranges;
+  struct comp_unit **any;
+  unsigned int i;
+  bfd_vma max_high;
+
+  for (each = stash->all_comp_units; each; each = each->next_unit)
+    {
+      if (each->arange.high == 0)
+	any_count++;
+      else
+	for (arange = &each->arange; arange; arange = arange->next)
+	  range_count++;
+    }
+
+  ranges = (struct unit_range *) bfd_malloc (range_count * sizeof (*ranges)
+					      + 1);
+  any = (struct comp_unit **) bfd_malloc (any_count * sizeof (*any) + 1);
+  if (ranges == NULL || any == NULL)
+    {
+      free (ranges);
+      free (any);
+      return FALSE;
+    }
+
+  range_count = 0;
+  any_count = 0;
+  for (each = stash->all_comp_units; each; each = each->next_unit)
+    {
+      if (each->arange.high == 0)
+	any[any_count++] = each;
+      else
+	for (arange = &each->arange; arange; arange = arange->next)
+	  {
+	    ranges[range_count].low = arange->low;
+	    ranges[range_count].high = arange->high;
+	    ranges[range_count].unit = each;
+	    range_count++;
+	  }
+      each->in_unit_ranges = TRUE;
+    }
+
+  qsort (ranges, range_count, sizeof (*ranges), compare_unit_ranges);
+
+  max_high = 0;
+  for (i = 0; i < range_count; i++)
+    {
+      if (ranges[i].high > max_high)
+	max_high = ranges[i].high;
+      ranges[i].max_high = max_high;
+    }
+
+  free (stash->unit_ranges);
+  free (stash->unit_ranges_any);
+  stash->unit_ranges = ranges;
+  stash->unit_range_count = range_count;
+  stash->unit_ranges_any = any;
+  stash->unit_ranges_any_count = any_count;
+  stash->unit_ranges_units = stash->comp_unit_count;
+  stash->unit_ranges_changed_count = 0;
+  return TRUE;
+}
+
+/* Add UNIT to the comp units which may contain an address, the first
+   COUNT of which are already in STASH->unit_candidates.  */
+
+static bfd_boolean
+add_unit_candidate (struct dwarf2_debug *stash, struct comp_unit *unit,
+		    unsigned int count)
+{
+  if (count >= stash->unit_candidates_alloc)
+    {
+      unsigned int alloc = stash->unit_candidates_alloc * 2 + 16;
+      struct comp_unit **candidates;
+
+      candidates = (struct comp_unit **)
+	bfd_realloc (stash->unit_candidates, alloc * sizeof (*candidates));
+      if (candidates == NULL)
+	return FALSE;
+      stash->unit_candidates = candidates;
+      stash->unit_candidates_alloc = alloc;
+    }
+
+  stash->unit_candidates[count] = unit;
+  return TRUE;
+}
+
+/* Compare function to sort comp units in the order of the
+   all_comp_units list, the most recently read first.  */
+
+static int
+compare_unit_candidates (const void *a, const void *b)
+{
+  const struct comp_unit *unit1 = *(const struct comp_unit * const *) a;
+  const struct comp_unit *unit2 = *(const struct comp_unit * const *) b;
+
+  if (unit1->index > unit2->index)
+    return -1;
+  if (unit1->index < unit2->index)
+    return 1;
+  return 0;
+}
+
+/* Set STASH->unit_candidates to the comp units which may contain ADDR,
+   in the order of the all_comp_units list, and *COUNT to their number.
+   These are the comp units with no address range and those which
+   contain ADDR according to comp_unit_contains_address.  The table of
+   comp unit address ranges is rebuilt when enough comp units are
+   missing from it.  */
+
+static bfd_boolean
+find_unit_candidates (struct dwarf2_debug *stash, bfd_vma addr,
+		      unsigned int *count)
+{
+  struct comp_unit *each;
+  unsigned int unindexed;
+  unsigned int n = 0;
+  unsigned int low, high, mid, i;
+
+  unindexed = (stash->comp_unit_count - stash->unit_ranges_units
+	       + stash->unit_ranges_changed_count);
+  if (unindexed > stash->unit_ranges_units / 4
+      && ! build_unit_ranges (stash))
+    return FALSE;
+
+  /* The comp units read since the table was built, and those whose
+     address ranges have changed, are checked one by one.  */
+  for (each = stash->all_comp_units;
+       each && each->index >= stash->unit_ranges_units;
+       each = each->next_unit)
+    if (each->arange.high == 0 || comp_unit_contains_address (each, addr))
+      {
+	if (! add_unit_candidate (stash, each, n))
+	  return FALSE;
+	n++;
+      }
+
+  for (i = 0; i < stash->unit_ranges_changed_count; i++)
+    {
+      each = stash->unit_ranges_changed[i];
+      if (each->arange.high == 0 || comp_unit_contains_address (each, addr))
+	{
+	  if (! add_unit_candidate (stash, each, n))
+	    return FALSE;
+	  n++;
+	}
+    }
+
+  for (i = 0; i < stash->unit_ranges_any_count; i++)
+    {
+      each = stash->unit_ranges_any[i];
+      if (each->in_unit_ranges)
+	{
+	  if (! add_unit_candidate (stash, each, n))
+	    return FALSE;
+	  n++;
+	}
+    }
+
+  /* Find the first range which may contain ADDR.  */
+  low = 0;
+  high = stash->unit_range_count;
+  while (low < high)
+    {
+      mid = (low + high) / 2;
+      if (addr < stash->unit_ranges[mid].max_high)
+	high = mid;
+      else
+	low = mid + 1;
+    }
+
+  for (; low < stash->unit_range_count; low++)
+    {
+      struct unit_range *range = &stash->unit_ranges[low];
+
+      if (addr < range->low)
+	break;
+      each = range->unit;
+      if (addr < range->high && each->in_unit_ranges && ! each->error)
+	{
+	  if (! add_unit_candidate (stash, each, n))
+	    return FALSE;
+	  n++;
+	}
+    }
+
+  /* Sort the comp units into list order and drop any duplicates, as a
+     comp unit may have several ranges containing ADDR.  */
+  if (n > 1)
+    {
+      unsigned int j;
+
+      qsort (stash->unit_candidates, n, sizeof (*stash->unit_candidates),
+	     compare_unit_candidates);
+      for (i = 1, j = 1; i < n; i++)
+	if (stash->unit_candidates[i] != stash->unit_candidates[j - 1])
+	  stash->unit_candidates[j++] = stash->unit_candidates[i];
+      n = j;
+    }
+
+  *count = n;
+  return TRUE;
+}
+
 /* If UNIT contains ADDR, set the output parameters to the values for
    the line containing ADDR.  The output parameters, FILENAME_PTR,
    FUNCTIONNAME_PTR, and LINENUMBER_PTR, are pointers to the objects
@@ -3566,19 +4352,24 @@ find_line (bfd *abfd,
       const char * local_functionname = NULL;
       unsigned int local_linenumber = 0;
       unsigned int local_discriminator = 0;
+      unsigned int candidate_count;
+      unsigned int i;
 
-      for (each = stash->all_comp_units; each; each = each->next_unit)
+      /* Only look at the comp units which may contain ADDR.  */
+      if (! find_unit_candidates (stash, addr, &candidate_count))
+	return FALSE;
+
+      for (i = 0; i < candidate_count; i++)
 	{
 	  bfd_vma range = (bfd_vma) -1;
 
-	  found = ((each->arange.high == 0
-		    || comp_unit_contains_address (each, addr))
-		   && (range = comp_unit_find_nearest_line (each, addr,
-							    & local_filename,
-							    & local_functionname,
-							    & local_linenumber,
-							    & local_discriminator,
-							    stash)) != 0);
+	  each = stash->unit_candidates[i];
+	  found = ((range = comp_unit_find_nearest_line (each, addr,
+							 & local_filename,
+							 & local_functionname,
+							 & local_linenumber,
+							 & local_discriminator,
+							 stash)) != 0);
 	  if (found)
 	    {
 	      /* PRs 15935 15994: Bogus debug information may have provided us
@@ -3672,6 +4463,7 @@ find_line (bfd *abfd,
 	       more.  */
 	    break;
 	  stash->info_ptr += length;
+	  each->index = stash->comp_unit_count++;
 
 	  if (stash->all_comp_units)
 	    stash->all_comp_units->prev_unit = each;
@@ -3806,6 +4598,9 @@ _bfd_dwarf2_cleanup_debug_info (bfd *abfd, void **pinfo)
       struct varinfo *variable_table = each->variable_table;
       size_t i;
 
+      if (each->abstract_names)
+	htab_delete (each->abstract_names);
+
       for (i = 0; i < ABBREV_HASH_SIZE; i++)
 	{
 	  struct abbrev_info *abbrev = abbrevs[i];
@@ -3857,6 +4652,8 @@ _bfd_dwarf2_cleanup_debug_info (bfd *abfd, void **pinfo)
     free (stash->dwarf_line_buffer);
   if (stash->dwarf_str_buffer)
     free (stash->dwarf_str_buffer);
+  if (stash->dwarf_str_htab)
+    htab_delete (stash->dwarf_str_htab);
   if (stash->dwarf_ranges_buffer)
     free (stash->dwarf_ranges_buffer);
   if (stash->info_ptr_memory)
@@ -3869,4 +4666,9 @@ _bfd_dwarf2_cleanup_debug_info (bfd *abfd, void **pinfo)
     free (stash->alt_dwarf_info_buffer);
   if (stash->alt_bfd_ptr)
     bfd_close (stash->alt_bfd_ptr);
+  free (stash->unit_ranges);
+  free (stash->unit_ranges_any);
+  free (stash->unit_ranges_changed);
+  free (stash->unit_candidates);
+  free (stash->func_candidates);
 }
@@ -3347,8 +3347,10 @@ elf_link_add_object_symbols (bfd *abfd, struct bfd_link_info *info)
   bfd_size_type amt;
   void *alloc_mark = NULL;
   struct bfd_hash_entry **old_table = NULL;
+  unsigned int *old_hashes = NULL;
   unsigned int old_size = 0;
   unsigned int old_count = 0;
+  unsigned int old_used = 0;
   void *old_tab = NULL;
   void *old_ent;
   struct bfd_link_hash_entry *old_undefs = NULL;
@@ -3356,6 +3358,7 @@ elf_link_add_object_symbols (bfd *abfd, struct bfd_link_info *info)
   long old_dynsymcount = 0;
   bfd_size_type old_dynstr_size = 0;
   size_t tabsize = 0;
+  size_t hashsize = 0;
   asection *s;
 
   htab = elf_hash_table (info);
@@ -3766,7 +3769,8 @@ error_free_dyn:
 	}
 
       tabsize = htab->root.table.size * sizeof (struct bfd_hash_entry *);
-      old_tab = bfd_malloc (tabsize + entsize);
+      hashsize = htab->root.table.size * sizeof (unsigned int);
+      old_tab = bfd_malloc (tabsize + hashsize + entsize);
       if (old_tab == NULL)
 	goto error_free_vers;
 
@@ -3783,13 +3787,16 @@ error_free_dyn:
 
       /* Clone the symbol table.  Remember some pointers into the
 	 symbol table, and dynamic symbol count.  */
-      old_ent = (char *) old_tab + tabsize;
+      old_ent = (char *) old_tab + tabsize + hashsize;
       memcpy (old_tab, htab->root.table.table, tabsize);
+      memcpy ((char *) old_tab + tabsize, htab->root.table.hashes, hashsize);
       old_undefs = htab->root.undefs;
       old_undefs_tail = htab->root.undefs_tail;
       old_table = htab->root.table.table;
+      old_hashes = htab->root.table.hashes;
       old_size = htab->root.table.size;
       old_count = htab->root.table.count;
+      old_used = htab->root.table.used;
       old_dynsymcount = htab->dynsymcount;
       old_dynstr_size = _bfd_elf_strtab_size (htab->dynstr);
 
@@ -4472,13 +4479,16 @@ error_free_dyn:
       unsigned int i;
 
       /* Restore the symbol table.  */
-      old_ent = (char *) old_tab + tabsize;
+      old_ent = (char *) old_tab + tabsize + hashsize;
       memset (elf_sym_hashes (abfd), 0,
 	      extsymcount * sizeof (struct elf_link_hash_entry *));
       htab->root.table.table = old_table;
+      htab->root.table.hashes = old_hashes;
       htab->root.table.size = old_size;
       htab->root.table.count = old_count;
+      htab->root.table.used = old_used;
       memcpy (htab->root.table.table, old_tab, tabsize);
+      memcpy (htab->root.table.hashes, (char *) old_tab + tabsize, hashsize);
       htab->root.undefs = old_undefs;
       htab->root.undefs_tail = old_undefs_tail;
       _bfd_elf_strtab_restore_size (htab->dynstr, old_dynstr_size);
@@ -4926,6 +4936,214 @@ _bfd_elf_archive_symbol_lookup (bfd *abfd,
   return h;
 }
 
+/* An entry in the index from symbol names to the archive map entries
+   which might satisfy them, used by elf_link_add_archive_symbols.  The
+   names are stripped of any version and of a leading dot, so that an
+   entry covers all the names an archive symbol lookup might match.  */
+
+struct elf_archive_index_entry
+{
+  struct bfd_hash_entry root;
+  /* The first archive map entry with this name.  Later ones are
+     chained through the NEXT array of the search.  */
+  symindex first;
+};
+
+static struct bfd_hash_entry *
+elf_archive_index_newfunc (struct bfd_hash_entry *entry,
+			   struct bfd_hash_table *table,
+			   const char *string)
+{
+  if (entry == NULL)
+    {
+      entry = (struct bfd_hash_entry *)
+	bfd_hash_allocate (table, sizeof (struct elf_archive_index_entry));
+      if (entry == NULL)
+	return entry;
+    }
+
+  entry = bfd_hash_newfunc (entry, table, string);
+  if (entry != NULL)
+    ((struct elf_archive_index_entry *) entry)->first = BFD_NO_MORE_SYMBOLS;
+  return entry;
+}
+
+/* Look up the index entry for NAME in TABLE, creating it if CREATE.  */
+
+static struct elf_archive_index_entry *
+elf_archive_index_lookup (struct bfd_hash_table *table, const char *name,
+			  bfd_boolean create)
+{
+  struct bfd_hash_entry *ent;
+  const char *p;
+  char *copy;
+
+  if (name[0] == '.')
+    name++;
+  p = strchr (name, ELF_VER_CHR);
+  if (p == NULL)
+    return ((struct elf_archive_index_entry *)
+	    bfd_hash_lookup (table, name, create, FALSE));
+
+  copy = (char *) bfd_malloc (p - name + 1);
+  if (copy == NULL)
+    return NULL;
+  memcpy (copy, name, p - name);
+  copy[p - name] = '\0';
+  ent = bfd_hash_lookup (table, copy, create, create);
+  free (copy);
+  return (struct elf_archive_index_entry *) ent;
+}
+
+/* The state of a search of an archive map by
+   elf_link_add_archive_symbols.  */
+
+struct elf_archive_search
+{
+  /* The number of entries in the archive map.  */
+  symindex count;
+  /* The index from names to archive map entries, and the chains of
+     entries with the same name.  */
+  struct bfd_hash_table index;
+  symindex *next;
+  /* A heap of the archive map entries still to be checked in this
+     pass, and whether each entry is in it.  */
+  symindex *heap;
+  symindex heap_count;
+  bfd_boolean *queued;
+  /* The entries found to be weakly undefined in the last pass.  A weak
+     undefined symbol which later becomes strongly undefined is not
+     always put on the undefs list again.  */
+  symindex *weak;
+  symindex weak_count;
+};
+
+/* Build the name index of SEARCH for the archive map SYMDEFS.  */
+
+static bfd_boolean
+elf_archive_search_init (struct elf_archive_search *search, carsym *symdefs)
+{
+  bfd_size_type amt;
+  symindex i;
+
+  if (!bfd_hash_table_init (&search->index, elf_archive_index_newfunc,
+			    sizeof (struct elf_archive_index_entry)))
+    return FALSE;
+
+  amt = search->count;
+  amt *= sizeof (symindex);
+  search->next = (symindex *) bfd_malloc (amt);
+  search->heap = (symindex *) bfd_malloc (amt);
+  amt = search->count;
+  amt *= sizeof (bfd_boolean);
+  search->queued = (bfd_boolean *) bfd_zmalloc (amt);
+  if (search->next == NULL || search->heap == NULL
+      || search->queued == NULL)
+    return FALSE;
+
+  for (i = search->count; i-- > 0; )
+    {
+      struct elf_archive_index_entry *ent;
+
+      ent = elf_archive_index_lookup (&search->index, symdefs[i].name, TRUE);
+      if (ent == NULL)
+	return FALSE;
+      search->next[i] = ent->first;
+      ent->first = i;
+    }
+  return TRUE;
+}
+
+/* Add archive map entry I to the heap of SEARCH.  */
+
+static void
+elf_archive_search_push (struct elf_archive_search *search, symindex i)
+{
+  symindex *heap = search->heap;
+  symindex n = search->heap_count++;
+
+  search->queued[i] = TRUE;
+  while (n > 0 && heap[(n - 1) / 2] > i)
+    {
+      heap[n] = heap[(n - 1) / 2];
+      n = (n - 1) / 2;
+    }
+  heap[n] = i;
+}
+
+/* Remove and return the first archive map entry in the heap of
+   SEARCH.  */
+
+static symindex
+elf_archive_search_pop (struct elf_archive_search *search)
+{
+  symindex *heap = search->heap;
+  symindex first = heap[0];
+  symindex last = heap[--search->heap_count];
+  symindex n = 0;
+
+  for (;;)
+    {
+      symindex child = 2 * n + 1;
+
+      if (child >= search->heap_count)
+	break;
+      if (child + 1 < search->heap_count && heap[child + 1] < heap[child])
+	child++;
+      if (heap[child] >= last)
+	break;
+      heap[n] = heap[child];
+      n = child;
+    }
+  heap[n] = last;
+  search->queued[first] = FALSE;
+  return first;
+}
+
+/* Queue the archive map entries from FIRST on which might satisfy a
+   reference to H, unless they have already been dealt with.  */
+
+static void
+elf_archive_search_queue (struct elf_archive_search *search,
+			  struct bfd_link_hash_entry *h,
+			  symindex first,
+			  const bfd_boolean *defined,
+			  const bfd_boolean *included)
+{
+  struct elf_archive_index_entry *ent;
+  symindex i;
+
+  if (h->type != bfd_link_hash_undefined
+      && h->type != bfd_link_hash_undefweak
+      && h->type != bfd_link_hash_common)
+    return;
+
+  ent = elf_archive_index_lookup (&search->index, h->root.string, FALSE);
+  if (ent == NULL)
+    return;
+  for (i = ent->first; i != BFD_NO_MORE_SYMBOLS; i = search->next[i])
+    if (i >= first
+	&& !defined[i] && !included[i] && !search->queued[i])
+      elf_archive_search_push (search, i);
+}
+
+/* Free the memory used by SEARCH.  */
+
+static void
+elf_archive_search_free (struct elf_archive_search *search)
+{
+  if (search->index.memory != NULL)
+    bfd_hash_table_free (&search->index);
+  if (search->next != NULL)
+    free (search->next);
+  if (search->heap != NULL)
+    free (search->heap);
+  if (search->weak != NULL)
+    free (search->weak);
+  if (search->queued != NULL)
+    free (search->queued);
+}
+
 /* Add symbols from an ELF archive file to the linker hash table.  We
    don't use _bfd_generic_link_add_archive_symbols because of a
    problem which arises on UnixWare.  The UnixWare libc.so is an
@@ -4949,7 +5167,12 @@ _bfd_elf_archive_symbol_lookup (bfd *abfd,
    object file.
 
    Unfortunately, we do have to make multiple passes over the symbol
-   table until nothing further is resolved.  */
+   table until nothing further is resolved.  Only the first pass looks
+   at the whole archive map.  The later ones look only at the entries
+   named by the undefined symbols, found through an index of the
+   archive map, in the same order as a full pass would.  When they
+   stop finding anything, one more full pass makes sure that nothing
+   was missed.  */
 
 static bfd_boolean
 elf_link_add_archive_symbols (bfd *abfd, struct bfd_link_info *info)
@@ -4959,10 +5182,12 @@ elf_link_add_archive_symbols (bfd *abfd, struct bfd_link_info *info)
   bfd_boolean *included = NULL;
   carsym *symdefs;
   bfd_boolean loop;
+  bfd_boolean full;
   bfd_size_type amt;
   const struct elf_backend_data *bed;
   struct elf_link_hash_entry * (*archive_symbol_lookup)
     (bfd *, struct bfd_link_info *, const char *);
+  struct elf_archive_search search;
 
   if (! bfd_has_map (abfd))
     {
@@ -4979,43 +5204,74 @@ elf_link_add_archive_symbols (bfd *abfd, struct bfd_link_info *info)
   c = bfd_ardata (abfd)->symdef_count;
   if (c == 0)
     return TRUE;
+  memset (&search, 0, sizeof (search));
+  search.count = c;
   amt = c;
   amt *= sizeof (bfd_boolean);
   defined = (bfd_boolean *) bfd_zmalloc (amt);
   included = (bfd_boolean *) bfd_zmalloc (amt);
-  if (defined == NULL || included == NULL)
+  amt = c;
+  amt *= sizeof (symindex);
+  search.weak = (symindex *) bfd_malloc (amt);
+  if (defined == NULL || included == NULL || search.weak == NULL)
     goto error_return;
 
   symdefs = bfd_ardata (abfd)->symdefs;
   bed = get_elf_backend_data (abfd);
   archive_symbol_lookup = bed->elf_backend_archive_symbol_lookup;
 
+  full = TRUE;
   do
     {
-      file_ptr last;
       symindex i;
-      carsym *symdef;
-      carsym *symdefend;
+      symindex next_full;
 
       loop = FALSE;
-      last = -1;
+      next_full = 0;
+
+      if (!full)
+	{
+	  struct bfd_link_hash_entry *u;
+	  symindex w;
+
+	  /* Queue the entries which might satisfy an undefined symbol,
+	     or a weak undefined symbol found in the last pass.  */
+	  if (search.next == NULL
+	      && !elf_archive_search_init (&search, symdefs))
+	    goto error_return;
+	  for (u = info->hash->undefs; u != NULL; u = u->u.undef.next)
+	    elf_archive_search_queue (&search, u, 0, defined, included);
+	  for (w = 0; w < search.weak_count; w++)
+	    if (!defined[search.weak[w]] && !included[search.weak[w]]
+		&& !search.queued[search.weak[w]])
+	      elf_archive_search_push (&search, search.weak[w]);
+	}
+      search.weak_count = 0;
 
-      symdef = symdefs;
-      symdefend = symdef + c;
-      for (i = 0; symdef < symdefend; symdef++, i++)
+      for (;;)
 	{
 	  struct elf_link_hash_entry *h;
 	  bfd *element;
 	  struct bfd_link_hash_entry *undefs_tail;
+	  carsym *symdef;
 	  symindex mark;
 
-	  if (defined[i] || included[i])
-	    continue;
-	  if (symdef->file_offset == last)
+	  if (full)
 	    {
-	      included[i] = TRUE;
-	      continue;
+	      if (next_full >= c)
+		break;
+	      i = next_full++;
 	    }
+	  else
+	    {
+	      if (search.heap_count == 0)
+		break;
+	      i = elf_archive_search_pop (&search);
+	    }
+	  symdef = symdefs + i;
+
+	  if (defined[i] || included[i])
+	    continue;
 
 	  h = archive_symbol_lookup (abfd, info, symdef->name);
 	  if (h == (struct elf_link_hash_entry *) 0 - 1)
@@ -5045,6 +5301,8 @@ elf_link_add_archive_symbols (bfd *abfd, struct bfd_link_info *info)
 	    {
 	      if (h->root.type != bfd_link_hash_undefweak)
 		defined[i] = TRUE;
+	      else
+		search.weak[search.weak_count++] = i;
 	      continue;
 	    }
 
@@ -5082,10 +5340,37 @@ elf_link_add_archive_symbols (bfd *abfd, struct bfd_link_info *info)
 	     does not require another pass.  This isn't a bug, but it
 	     does make the code less efficient than it could be.  */
 	  if (undefs_tail != info->hash->undefs_tail)
-	    loop = TRUE;
+	    {
+	      loop = TRUE;
+
+	      /* A full pass would go on to see the later entries
+		 naming the new undefined symbols, so queue them.  If
+		 the old tail of the undefs list has been taken off it,
+		 the new symbols cannot be found, so look at everything
+		 after this entry instead.  */
+	      if (!full)
+		{
+		  struct bfd_link_hash_entry *u;
+
+		  if (undefs_tail == NULL)
+		    u = info->hash->undefs;
+		  else
+		    u = undefs_tail->u.undef.next;
+		  if (u == NULL)
+		    {
+		      full = TRUE;
+		      next_full = i + 1;
+		      while (search.heap_count != 0)
+			elf_archive_search_pop (&search);
+		    }
+		  for (; u != NULL; u = u->u.undef.next)
+		    elf_archive_search_queue (&search, u, i + 1, defined,
+					      included);
+		}
+	    }
 
-	  /* Look backward to mark all symbols from this object file
-	     which we have already seen in this pass.  */
+	  /* Mark all symbols from this object file which are next to
+	     this one in the archive map.  */
 	  mark = i;
 	  do
 	    {
@@ -5095,20 +5380,32 @@ elf_link_add_archive_symbols (bfd *abfd, struct bfd_link_info *info)
 	      --mark;
 	    }
 	  while (symdefs[mark].file_offset == symdef->file_offset);
+	  for (mark = i + 1;
+	       mark < c && symdefs[mark].file_offset == symdef->file_offset;
+	       mark++)
+	    included[mark] = TRUE;
+	}
 
-	  /* We mark subsequent symbols from this object file as we go
-	     on through the loop.  */
-	  last = symdef->file_offset;
+      /* When a pass over the undefined symbols finds nothing more,
+	 check with a full pass.  */
+      if (!full && !loop)
+	{
+	  loop = TRUE;
+	  full = TRUE;
 	}
+      else
+	full = !loop;
     }
   while (loop);
 
+  elf_archive_search_free (&search);
   free (defined);
   free (included);
 
   return TRUE;
 
  error_return:
+  elf_archive_search_free (&search);
   if (defined != NULL)
     free (defined);
   if (included != NULL)
@@ -10906,7 +11203,15 @@ bfd_elf_final_link (bfd *abfd, struct bfd_link_info *info)
      it.  Fortunately, it only happens when performing a relocatable
      link, which is not the common case.  FIXME: If keep_memory is set
      we could write the relocs out and then read them again; I don't
-     know how bad the memory loss will be.  */
+     know how bad the memory loss will be.
+
+     The input files are handled one at a time, in link order.  They
+     cannot simply be relocated in parallel: elf_link_input_bfd shares
+     the buffers in FLINFO between inputs, the BFD file cache and error
+     state are global, local symbols must be output in order through
+     elf_link_output_sym, and the backend relocate_section routines
+     update the global symbol hash entries and append to shared
+     sections such as the dynamic relocation sections.  */
 
   for (sub = info->input_bfds; sub != NULL; sub = sub->link_next)
     sub->output_has_begun = FALSE;
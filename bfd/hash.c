@@ -301,67 +301,61 @@ SUBSUBSECTION
 /* The default number of entries to use when creating a hash table.  */
 #define DEFAULT_SIZE 4051
 
-/* The following function returns a nearest prime number which is
-   greater than N, and near a power of two.  Copied from libiberty.
-   Returns zero for ridiculously large N to signify an error.  */
+/* The hash table is open addressed, with linear probing.  Each used
+   slot of TABLE holds the most recently inserted entry for one
+   string, and older entries for the same string hang off it through
+   their NEXT fields, as do the entries which callers such as the
+   section hash table chain after an entry themselves.  HASHES holds
+   the low bits of the hash code of the entry in each slot, so that
+   probing a slot only touches the entry when the codes match.  The
+   number of slots is a power of two, and the table is doubled when
+   more than two thirds of them are used.  */
+
+/* The largest number of slots a table may have.  */
+#define MAX_SIZE ((unsigned int) 1 << 30)
 
-static unsigned long
-higher_prime_number (unsigned long n)
-{
-  /* These are primes that are near, but slightly smaller than, a
-     power of two.  */
-  static const unsigned long primes[] =
-    {
-      (unsigned long) 31,
-      (unsigned long) 61,
-      (unsigned long) 127,
-      (unsigned long) 251,
-      (unsigned long) 509,
-      (unsigned long) 1021,
-      (unsigned long) 2039,
-      (unsigned long) 4093,
-      (unsigned long) 8191,
-      (unsigned long) 16381,
-      (unsigned long) 32749,
-      (unsigned long) 65521,
-      (unsigned long) 131071,
-      (unsigned long) 262139,
-      (unsigned long) 524287,
-      (unsigned long) 1048573,
-      (unsigned long) 2097143,
-      (unsigned long) 4194301,
-      (unsigned long) 8388593,
-      (unsigned long) 16777213,
-      (unsigned long) 33554393,
-      (unsigned long) 67108859,
-      (unsigned long) 134217689,
-      (unsigned long) 268435399,
-      (unsigned long) 536870909,
-      (unsigned long) 1073741789,
-      (unsigned long) 2147483647,
-					/* 4294967291L */
-      ((unsigned long) 2147483647) + ((unsigned long) 2147483644),
-  };
-
-  const unsigned long *low = &primes[0];
-  const unsigned long *high = &primes[sizeof (primes) / sizeof (primes[0])];
-
-  while (low != high)
-    {
-      const unsigned long *mid = low + (high - low) / 2;
-      if (n >= *mid)
-	low = mid + 1;
-      else
-	high = mid;
-    }
+static unsigned long bfd_default_hash_table_size = DEFAULT_SIZE;
 
-  if (n >= *low)
-    return 0;
+/* Return the slot where entries with hash code HASH start probing in
+   a table of SIZE slots.  The hash codes are not well spread in their
+   low bits, so mix them first.  */
 
-  return *low;
+static inline unsigned int
+bfd_hash_slot (unsigned long hash, unsigned int size)
+{
+  unsigned int h = (unsigned int) (hash ^ (hash >> 31 >> 1));
+
+  h ^= h >> 16;
+  h *= 0x45d9f3b;
+  h ^= h >> 16;
+  return h & (size - 1);
 }
 
-static unsigned long bfd_default_hash_table_size = DEFAULT_SIZE;
+/* Allocate the arrays of TABLE for SIZE slots.  */
+
+static bfd_boolean
+bfd_hash_alloc_slots (struct bfd_hash_table *table, unsigned int size)
+{
+  struct bfd_hash_entry **newtable;
+  unsigned int *newhashes;
+
+  newtable = ((struct bfd_hash_entry **)
+	      objalloc_alloc ((struct objalloc *) table->memory,
+			      (unsigned long) size * sizeof (*newtable)));
+  newhashes = ((unsigned int *)
+	       objalloc_alloc ((struct objalloc *) table->memory,
+			       (unsigned long) size * sizeof (*newhashes)));
+  if (newtable == NULL || newhashes == NULL)
+    {
+      bfd_set_error (bfd_error_no_memory);
+      return FALSE;
+    }
+  memset (newtable, 0, (unsigned long) size * sizeof (*newtable));
+  table->table = newtable;
+  table->hashes = newhashes;
+  table->size = size;
+  return TRUE;
+}
 
 /* Create a new hash table, given a number of entries.  */
 
@@ -373,15 +367,10 @@ bfd_hash_table_init_n (struct bfd_hash_table *table,
 		       unsigned int entsize,
 		       unsigned int size)
 {
-  unsigned long alloc;
+  unsigned int slots;
 
-  alloc = size;
-  alloc *= sizeof (struct bfd_hash_entry *);
-  if (alloc / sizeof (struct bfd_hash_entry *) != size)
-    {
-      bfd_set_error (bfd_error_no_memory);
-      return FALSE;
-    }
+  for (slots = 16; slots < size && slots < MAX_SIZE; slots <<= 1)
+    ;
 
   table->memory = (void *) objalloc_create ();
   if (table->memory == NULL)
@@ -389,17 +378,11 @@ bfd_hash_table_init_n (struct bfd_hash_table *table,
       bfd_set_error (bfd_error_no_memory);
       return FALSE;
     }
-  table->table = (struct bfd_hash_entry **)
-      objalloc_alloc ((struct objalloc *) table->memory, alloc);
-  if (table->table == NULL)
-    {
-      bfd_set_error (bfd_error_no_memory);
-      return FALSE;
-    }
-  memset ((void *) table->table, 0, alloc);
-  table->size = size;
+  if (!bfd_hash_alloc_slots (table, slots))
+    return FALSE;
   table->entsize = entsize;
   table->count = 0;
+  table->used = 0;
   table->frozen = 0;
   table->newfunc = newfunc;
   return TRUE;
@@ -451,6 +434,142 @@ bfd_hash_hash (const char *string, unsigned int *lenp)
   return hash;
 }
 
+/* Return the index of the slot of TABLE holding the entries for
+   STRING, whose hash code is HASH, or of the empty slot where they
+   would go.  */
+
+static inline unsigned int
+bfd_hash_find_slot (const struct bfd_hash_table *table,
+		    const char *string, unsigned long hash)
+{
+  unsigned int mask = table->size - 1;
+  unsigned int _index = bfd_hash_slot (hash, table->size);
+  struct bfd_hash_entry *hashp;
+
+  while ((hashp = table->table[_index]) != NULL)
+    {
+      if (table->hashes[_index] == (unsigned int) hash
+	  && hashp->hash == hash
+	  && strcmp (hashp->string, string) == 0)
+	break;
+      _index = (_index + 1) & mask;
+    }
+  return _index;
+}
+
+/* Return the index of the slot of TABLE from which ENT can be reached,
+   and set *PPH to the pointer to ENT in that slot or in the NEXT field
+   of the entry before it.  Abort if ENT is not in TABLE.  */
+
+static unsigned int
+bfd_hash_find_entry (const struct bfd_hash_table *table,
+		     struct bfd_hash_entry *ent,
+		     struct bfd_hash_entry ***pph)
+{
+  unsigned int mask = table->size - 1;
+  unsigned int _index;
+
+  for (_index = bfd_hash_slot (ent->hash, table->size);
+       table->table[_index] != NULL;
+       _index = (_index + 1) & mask)
+    if (table->hashes[_index] == (unsigned int) ent->hash)
+      for (*pph = &table->table[_index]; **pph != NULL; *pph = &(**pph)->next)
+	if (**pph == ent)
+	  return _index;
+
+  abort ();
+}
+
+/* Empty slot _INDEX of TABLE, moving later entries of its cluster
+   back so that none of them is cut off from its starting slot.  */
+
+static void
+bfd_hash_empty_slot (struct bfd_hash_table *table, unsigned int _index)
+{
+  unsigned int mask = table->size - 1;
+  unsigned int next = _index;
+
+  table->table[_index] = NULL;
+  table->used--;
+  for (;;)
+    {
+      unsigned int home;
+
+      next = (next + 1) & mask;
+      if (table->table[next] == NULL)
+	return;
+      home = bfd_hash_slot (table->table[next]->hash, table->size);
+      /* Move the entry at NEXT unless it starts cyclically in
+	 (_INDEX, NEXT].  */
+      if (_index <= next
+	  ? (home <= _index || home > next)
+	  : (home <= _index && home > next))
+	{
+	  table->table[_index] = table->table[next];
+	  table->hashes[_index] = table->hashes[next];
+	  table->table[next] = NULL;
+	  _index = next;
+	}
+    }
+}
+
+/* Double the number of slots in TABLE.  */
+
+static bfd_boolean
+bfd_hash_grow (struct bfd_hash_table *table)
+{
+  struct bfd_hash_entry **oldtable = table->table;
+  unsigned int *oldhashes = table->hashes;
+  unsigned int oldsize = table->size;
+  unsigned int mask, i;
+
+  if (oldsize >= MAX_SIZE
+      || !bfd_hash_alloc_slots (table, oldsize * 2))
+    return FALSE;
+
+  mask = table->size - 1;
+  for (i = 0; i < oldsize; i++)
+    if (oldtable[i] != NULL)
+      {
+	unsigned int _index = bfd_hash_slot (oldtable[i]->hash, table->size);
+
+	while (table->table[_index] != NULL)
+	  _index = (_index + 1) & mask;
+	table->table[_index] = oldtable[i];
+	table->hashes[_index] = oldhashes[i];
+      }
+  return TRUE;
+}
+
+/* Put ENT in slot _INDEX of TABLE, ahead of any entries already there
+   for the same string.  */
+
+static bfd_boolean
+bfd_hash_put (struct bfd_hash_table *table, unsigned int _index,
+	      struct bfd_hash_entry *ent)
+{
+  ent->next = table->table[_index];
+  table->table[_index] = ent;
+  table->hashes[_index] = (unsigned int) ent->hash;
+  if (ent->next != NULL)
+    return TRUE;
+
+  table->used++;
+  if (table->used > table->size / 3 * 2)
+    {
+      /* A table being traversed cannot be grown, but there must
+	 always be an empty slot to end a probe.  */
+      if (!table->frozen && bfd_hash_grow (table))
+	return TRUE;
+      if (table->used + 1 >= table->size)
+	{
+	  bfd_set_error (bfd_error_no_memory);
+	  return FALSE;
+	}
+    }
+  return TRUE;
+}
+
 /* Look up a string in a hash table.  */
 
 struct bfd_hash_entry *
@@ -462,18 +581,11 @@ bfd_hash_lookup (struct bfd_hash_table *table,
   unsigned long hash;
   struct bfd_hash_entry *hashp;
   unsigned int len;
-  unsigned int _index;
 
   hash = bfd_hash_hash (string, &len);
-  _index = hash % table->size;
-  for (hashp = table->table[_index];
-       hashp != NULL;
-       hashp = hashp->next)
-    {
-      if (hashp->hash == hash
-	  && strcmp (hashp->string, string) == 0)
-	return hashp;
-    }
+  hashp = table->table[bfd_hash_find_slot (table, string, hash)];
+  if (hashp != NULL)
+    return hashp;
 
   if (! create)
     return NULL;
@@ -504,60 +616,16 @@ bfd_hash_insert (struct bfd_hash_table *table,
 		 unsigned long hash)
 {
   struct bfd_hash_entry *hashp;
-  unsigned int _index;
 
   hashp = (*table->newfunc) (NULL, table, string);
   if (hashp == NULL)
     return NULL;
   hashp->string = string;
   hashp->hash = hash;
-  _index = hash % table->size;
-  hashp->next = table->table[_index];
-  table->table[_index] = hashp;
+  if (!bfd_hash_put (table, bfd_hash_find_slot (table, string, hash), hashp))
+    return NULL;
   table->count++;
 
-  if (!table->frozen && table->count > table->size * 3 / 4)
-    {
-      unsigned long newsize = higher_prime_number (table->size);
-      struct bfd_hash_entry **newtable;
-      unsigned int hi;
-      unsigned long alloc = newsize * sizeof (struct bfd_hash_entry *);
-
-      /* If we can't find a higher prime, or we can't possibly alloc
-	 that much memory, don't try to grow the table.  */
-      if (newsize == 0 || alloc / sizeof (struct bfd_hash_entry *) != newsize)
-	{
-	  table->frozen = 1;
-	  return hashp;
-	}
-
-      newtable = ((struct bfd_hash_entry **)
-		  objalloc_alloc ((struct objalloc *) table->memory, alloc));
-      if (newtable == NULL)
-	{
-	  table->frozen = 1;
-	  return hashp;
-	}
-      memset (newtable, 0, alloc);
-
-      for (hi = 0; hi < table->size; hi ++)
-	while (table->table[hi])
-	  {
-	    struct bfd_hash_entry *chain = table->table[hi];
-	    struct bfd_hash_entry *chain_end = chain;
-
-	    while (chain_end->next && chain_end->next->hash == chain->hash)
-	      chain_end = chain_end->next;
-
-	    table->table[hi] = chain_end->next;
-	    _index = chain->hash % newsize;
-	    chain_end->next = newtable[_index];
-	    newtable[_index] = chain;
-	  }
-      table->table = newtable;
-      table->size = newsize;
-    }
-
   return hashp;
 }
 
@@ -571,19 +639,17 @@ bfd_hash_rename (struct bfd_hash_table *table,
   unsigned int _index;
   struct bfd_hash_entry **pph;
 
-  _index = ent->hash % table->size;
-  for (pph = &table->table[_index]; *pph != NULL; pph = &(*pph)->next)
-    if (*pph == ent)
-      break;
-  if (*pph == NULL)
-    abort ();
+  _index = bfd_hash_find_entry (table, ent, &pph);
+  if (pph == &table->table[_index] && ent->next == NULL)
+    bfd_hash_empty_slot (table, _index);
+  else
+    *pph = ent->next;
 
-  *pph = ent->next;
   ent->string = string;
   ent->hash = bfd_hash_hash (string, NULL);
-  _index = ent->hash % table->size;
-  ent->next = table->table[_index];
-  table->table[_index] = ent;
+  _index = bfd_hash_find_slot (table, string, ent->hash);
+  if (!bfd_hash_put (table, _index, ent))
+    abort ();
 }
 
 /* Replace an entry in a hash table.  */
@@ -593,22 +659,10 @@ bfd_hash_replace (struct bfd_hash_table *table,
 		  struct bfd_hash_entry *old,
 		  struct bfd_hash_entry *nw)
 {
-  unsigned int _index;
   struct bfd_hash_entry **pph;
 
-  _index = old->hash % table->size;
-  for (pph = &table->table[_index];
-       (*pph) != NULL;
-       pph = &(*pph)->next)
-    {
-      if (*pph == old)
-	{
-	  *pph = nw;
-	  return;
-	}
-    }
-
-  abort ();
+  bfd_hash_find_entry (table, old, &pph);
+  *pph = nw;
 }
 
 /* Allocate space in a hash table.  */
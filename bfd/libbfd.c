@@ -857,6 +857,10 @@ _bfd_generic_get_section_contents (bfd *abfd,
   if (count == 0)
     return TRUE;
 
+  if (section->compress_status == DECOMPRESS_SECTION_SIZED)
+    return bfd_get_decompressed_section_range (abfd, section, location,
+					       offset, count);
+
   if (section->compress_status != COMPRESS_SECTION_NONE)
     {
       (*_bfd_error_handler)
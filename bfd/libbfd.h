@@ -169,6 +169,8 @@ bfd * _bfd_new_bfd
   (void);
 bfd_boolean _bfd_free_cached_info
   (bfd *);
+void _bfd_free_decompress_states
+  (bfd *);
 
 bfd_boolean bfd_false
   (bfd *ignore);
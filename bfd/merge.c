@@ -29,6 +29,7 @@
 #include "libbfd.h"
 #include "hashtab.h"
 #include "libiberty.h"
+#include "objalloc.h"
 
 struct sec_merge_sec_info;
 
@@ -36,7 +37,9 @@ struct sec_merge_sec_info;
 
 struct sec_merge_hash_entry
 {
-  struct bfd_hash_entry root;
+  /* The entity, and its hash value.  */
+  const char *string;
+  unsigned long hash;
   /* Length of this entry.  This includes the zero terminator.  */
   unsigned int len;
   /* Start of this string needs to be aligned to
@@ -55,11 +58,18 @@ struct sec_merge_hash_entry
   struct sec_merge_hash_entry *next;
 };
 
-/* The section merge hash table.  */
+/* The section merge hash table.  This is open addressed, with linear
+   probing, since entries are never removed.  */
 
 struct sec_merge_hash
 {
-  struct bfd_hash_table table;
+  /* Where the entries are allocated.  */
+  struct objalloc *memory;
+  /* The slots of the table, a power of two of them.  */
+  struct sec_merge_hash_entry **table;
+  unsigned int slots;
+  /* The number of used slots.  */
+  unsigned int count;
   /* Next available index.  */
   bfd_size_type size;
   /* First entity in the SEC_MERGE sections of this type.  */
@@ -99,35 +109,44 @@ struct sec_merge_sec_info
 };
 
 
-/* Routine to create an entry in a section merge hashtab.  */
+/* The initial number of slots in a section merge hash table.  */
+#define SEC_MERGE_HASH_INITIAL_SLOTS 4096
 
-static struct bfd_hash_entry *
-sec_merge_hash_newfunc (struct bfd_hash_entry *entry,
-			struct bfd_hash_table *table, const char *string)
-{
-  /* Allocate the structure if it has not already been allocated by a
-     subclass.  */
-  if (entry == NULL)
-    entry = (struct bfd_hash_entry *)
-        bfd_hash_allocate (table, sizeof (struct sec_merge_hash_entry));
-  if (entry == NULL)
-    return NULL;
+/* Double the number of slots in TABLE.  */
 
-  /* Call the allocation method of the superclass.  */
-  entry = bfd_hash_newfunc (entry, table, string);
+static bfd_boolean
+sec_merge_hash_grow (struct sec_merge_hash *table)
+{
+  struct sec_merge_hash_entry **newtable;
+  unsigned int newslots = table->slots * 2;
+  unsigned int mask = newslots - 1;
+  unsigned int i;
 
-  if (entry != NULL)
+  if (newslots == 0)
     {
-      /* Initialize the local fields.  */
-      struct sec_merge_hash_entry *ret = (struct sec_merge_hash_entry *) entry;
-
-      ret->u.suffix = NULL;
-      ret->alignment = 0;
-      ret->secinfo = NULL;
-      ret->next = NULL;
+      bfd_set_error (bfd_error_no_memory);
+      return FALSE;
     }
 
-  return entry;
+  newtable = (struct sec_merge_hash_entry **)
+      bfd_zmalloc ((bfd_size_type) newslots * sizeof (*newtable));
+  if (newtable == NULL)
+    return FALSE;
+
+  for (i = 0; i < table->slots; i++)
+    if (table->table[i] != NULL)
+      {
+	unsigned int j = table->table[i]->hash & mask;
+
+	while (newtable[j] != NULL)
+	  j = (j + 1) & mask;
+	newtable[j] = table->table[i];
+      }
+
+  free (table->table);
+  table->table = newtable;
+  table->slots = newslots;
+  return TRUE;
 }
 
 /* Look up an entry in a section merge hash table.  */
@@ -139,9 +158,9 @@ sec_merge_hash_lookup (struct sec_merge_hash *table, const char *string,
   const unsigned char *s;
   unsigned long hash;
   unsigned int c;
-  struct sec_merge_hash_entry *hashp;
+  struct sec_merge_hash_entry *hashp, *newp;
   unsigned int len, i;
-  unsigned int _index;
+  unsigned int _index, mask;
 
   hash = 0;
   len = 0;
@@ -192,14 +211,14 @@ sec_merge_hash_lookup (struct sec_merge_hash *table, const char *string,
       len = table->entsize;
     }
 
-  _index = hash % table->table.size;
-  for (hashp = (struct sec_merge_hash_entry *) table->table.table[_index];
-       hashp != NULL;
-       hashp = (struct sec_merge_hash_entry *) hashp->root.next)
+  mask = table->slots - 1;
+  for (_index = hash & mask;
+       (hashp = table->table[_index]) != NULL;
+       _index = (_index + 1) & mask)
     {
-      if (hashp->root.hash == hash
+      if (hashp->hash == hash
 	  && len == hashp->len
-	  && memcmp (hashp->root.string, string, len) == 0)
+	  && memcmp (hashp->string, string, len) == 0)
 	{
 	  /* If the string we found does not have at least the required
 	     alignment, we need to insert another copy.  */
@@ -207,7 +226,9 @@ sec_merge_hash_lookup (struct sec_merge_hash *table, const char *string,
 	    {
 	      if (create)
 		{
-		  /*  Mark the less aligned copy as deleted.  */
+		  /*  Mark the less aligned copy as deleted.  It stays on
+		      the list of entries but the new copy replaces it in
+		      the table.  */
 		  hashp->len = 0;
 		  hashp->alignment = 0;
 		}
@@ -220,13 +241,33 @@ sec_merge_hash_lookup (struct sec_merge_hash *table, const char *string,
   if (! create)
     return NULL;
 
-  hashp = ((struct sec_merge_hash_entry *)
-	   bfd_hash_insert (&table->table, string, hash));
-  if (hashp == NULL)
-    return NULL;
-  hashp->len = len;
-  hashp->alignment = alignment;
-  return hashp;
+  newp = ((struct sec_merge_hash_entry *)
+	  objalloc_alloc (table->memory, sizeof (*newp)));
+  if (newp == NULL)
+    {
+      bfd_set_error (bfd_error_no_memory);
+      return NULL;
+    }
+  newp->string = string;
+  newp->hash = hash;
+  newp->len = len;
+  newp->alignment = alignment;
+  newp->u.suffix = NULL;
+  newp->secinfo = NULL;
+  newp->next = NULL;
+
+  if (hashp != NULL)
+    table->table[_index] = newp;
+  else
+    {
+      table->table[_index] = newp;
+      table->count++;
+      /* Keep the table at most three quarters full.  */
+      if (table->count > table->slots / 4 * 3
+	  && ! sec_merge_hash_grow (table))
+	return NULL;
+    }
+  return newp;
 }
 
 /* Create a new hash table.  */
@@ -240,10 +281,18 @@ sec_merge_init (unsigned int entsize, bfd_boolean strings)
   if (table == NULL)
     return NULL;
 
-  if (! bfd_hash_table_init_n (&table->table, sec_merge_hash_newfunc,
-			       sizeof (struct sec_merge_hash_entry), 16699))
+  table->memory = objalloc_create ();
+  table->slots = SEC_MERGE_HASH_INITIAL_SLOTS;
+  table->count = 0;
+  table->table = (struct sec_merge_hash_entry **)
+      bfd_zmalloc (table->slots * sizeof (*table->table));
+  if (table->memory == NULL || table->table == NULL)
     {
+      if (table->memory != NULL)
+	objalloc_free (table->memory);
+      free (table->table);
       free (table);
+      bfd_set_error (bfd_error_no_memory);
       return NULL;
     }
 
@@ -312,7 +361,7 @@ sec_merge_emit (bfd *abfd, struct sec_merge_hash_entry *entry)
 	  off += len;
 	}
 
-      str = entry->root.string;
+      str = entry->string;
       len = entry->len;
 
       if (bfd_bwrite (str, len, abfd) != len)
@@ -528,55 +577,117 @@ error_return:
   return FALSE;
 }
 
+/* Return the key of entry E at DEPTH for sorting strings by their
+   reversed contents: the byte DEPTH bytes from the end of E, not
+   counting the terminator, or -1 if E is shorter than that.  At
+   DEPTH -1 the key is the length of E modulo ALIGN, which sorts
+   strings whose tails are aligned alike next to each other.  */
+
+static inline int
+strrev_key (const struct sec_merge_hash_entry *e, int depth,
+	    unsigned int align)
+{
+  if (depth < 0)
+    return e->len & (align - 1);
+  if ((unsigned int) depth >= e->len)
+    return -1;
+  return ((const unsigned char *) e->string)[e->len - 1 - depth];
+}
+
+/* Compare entries A and B, which have equal keys below DEPTH, by
+   their reversed contents.  */
+
 static int
-strrevcmp (const void *a, const void *b)
+strrevcmp (const struct sec_merge_hash_entry *A,
+	   const struct sec_merge_hash_entry *B,
+	   int depth, unsigned int align)
 {
-  struct sec_merge_hash_entry *A = *(struct sec_merge_hash_entry **) a;
-  struct sec_merge_hash_entry *B = *(struct sec_merge_hash_entry **) b;
-  unsigned int lenA = A->len;
-  unsigned int lenB = B->len;
-  const unsigned char *s = (const unsigned char *) A->root.string + lenA - 1;
-  const unsigned char *t = (const unsigned char *) B->root.string + lenB - 1;
-  int l = lenA < lenB ? lenA : lenB;
-
-  while (l)
+  for (;; depth++)
     {
-      if (*s != *t)
-	return (int) *s - (int) *t;
-      s--;
-      t--;
-      l--;
+      int keyA = strrev_key (A, depth, align);
+      int keyB = strrev_key (B, depth, align);
+
+      if (keyA != keyB)
+	return keyA - keyB;
+      if (keyA == -1 && depth >= 0)
+	return 0;
     }
-  return lenA - lenB;
 }
 
-/* Like strrevcmp, but for the case where all strings have the same
-   alignment > entsize.  */
+/* Sort the N entries at ARRAY, which have equal keys below DEPTH, by
+   their reversed contents.  This is a multikey quicksort: the entries
+   are partitioned on their key at DEPTH, and those with an equal key
+   are then sorted on the next one, so that each byte is looked at
+   about log N times rather than once per comparison as qsort would.
+   Start at DEPTH -1 to sort first by the length modulo ALIGN.  */
 
-static int
-strrevcmp_align (const void *a, const void *b)
+static void
+sort_strings (struct sec_merge_hash_entry **array, size_t n, int depth,
+	      unsigned int align)
 {
-  struct sec_merge_hash_entry *A = *(struct sec_merge_hash_entry **) a;
-  struct sec_merge_hash_entry *B = *(struct sec_merge_hash_entry **) b;
-  unsigned int lenA = A->len;
-  unsigned int lenB = B->len;
-  const unsigned char *s = (const unsigned char *) A->root.string + lenA - 1;
-  const unsigned char *t = (const unsigned char *) B->root.string + lenB - 1;
-  int l = lenA < lenB ? lenA : lenB;
-  int tail_align = (lenA & (A->alignment - 1)) - (lenB & (A->alignment - 1));
-
-  if (tail_align != 0)
-    return tail_align;
-
-  while (l)
+  while (n > 1)
     {
-      if (*s != *t)
-	return (int) *s - (int) *t;
-      s--;
-      t--;
-      l--;
+      struct sec_merge_hash_entry *tmp;
+      size_t lt, gt, i, j;
+      int pivot, k0, k1, k2;
+
+      if (n < 8)
+	{
+	  for (i = 1; i < n; i++)
+	    for (j = i;
+		 j > 0 && strrevcmp (array[j - 1], array[j], depth, align) > 0;
+		 j--)
+	      {
+		tmp = array[j];
+		array[j] = array[j - 1];
+		array[j - 1] = tmp;
+	      }
+	  return;
+	}
+
+      /* Use the median of three keys as the pivot.  */
+      k0 = strrev_key (array[0], depth, align);
+      k1 = strrev_key (array[n / 2], depth, align);
+      k2 = strrev_key (array[n - 1], depth, align);
+      if (k0 > k1)
+	pivot = k0, k0 = k1, k1 = pivot;
+      pivot = k2 < k0 ? k0 : k2 > k1 ? k1 : k2;
+
+      /* Partition into keys below the pivot at [0,LT), equal to it at
+	 [LT,GT) and above it at [GT,N).  */
+      lt = 0;
+      gt = n;
+      i = 0;
+      while (i < gt)
+	{
+	  int key = strrev_key (array[i], depth, align);
+
+	  if (key < pivot)
+	    {
+	      tmp = array[i];
+	      array[i++] = array[lt];
+	      array[lt++] = tmp;
+	    }
+	  else if (key > pivot)
+	    {
+	      tmp = array[i];
+	      array[i] = array[--gt];
+	      array[gt] = tmp;
+	    }
+	  else
+	    i++;
+	}
+
+      sort_strings (array, lt, depth, align);
+      sort_strings (array + gt, n - gt, depth, align);
+
+      /* Entries which all ended at this depth are equal.  */
+      if (pivot == -1 && depth >= 0)
+	return;
+      array += lt;
+      n = gt - lt;
+      depth++;
     }
-  return lenA - lenB;
 }
 
 static inline int
@@ -588,8 +699,8 @@ is_suffix (const struct sec_merge_hash_entry *A,
        not to be equal by the hash table.  */
     return 0;
 
-  return memcmp (A->root.string + (A->len - B->len),
-		 B->root.string, B->len) == 0;
+  return memcmp (A->string + (A->len - B->len),
+		 B->string, B->len) == 0;
 }
 
 /* This is a helper function for _bfd_merge_sections.  It attempts to
@@ -626,10 +737,10 @@ merge_strings (struct sec_merge_info *sinfo)
   sinfo->htab->size = a - array;
   if (sinfo->htab->size != 0)
     {
-      qsort (array, (size_t) sinfo->htab->size,
-	     sizeof (struct sec_merge_hash_entry *),
-	     (alignment != (unsigned) -1 && alignment > sinfo->htab->entsize
-	      ? strrevcmp_align : strrevcmp));
+      if (alignment != (unsigned) -1 && alignment > sinfo->htab->entsize)
+	sort_strings (array, (size_t) sinfo->htab->size, -1, alignment);
+      else
+	sort_strings (array, (size_t) sinfo->htab->size, 0, 1);
 
       /* Loop over the sorted array and merge suffixes */
       e = *--a;
@@ -895,7 +1006,8 @@ _bfd_merge_sections_free (void *xsinfo)
 
   for (sinfo = (struct sec_merge_info *) xsinfo; sinfo; sinfo = sinfo->next)
     {
-      bfd_hash_table_free (&sinfo->htab->table);
+      objalloc_free (sinfo->htab->memory);
+      free (sinfo->htab->table);
       free (sinfo->htab);
     }
 }
@@ -117,6 +117,8 @@ _bfd_new_bfd_contained_in (bfd *obfd)
 static void
 _bfd_delete_bfd (bfd *abfd)
 {
+  _bfd_free_decompress_states (abfd);
+
   if (abfd->memory)
     {
       bfd_hash_table_free (&abfd->section_htab);
@@ -132,6 +134,8 @@ _bfd_delete_bfd (bfd *abfd)
 bfd_boolean
 _bfd_free_cached_info (bfd *abfd)
 {
+  _bfd_free_decompress_states (abfd);
+
   if (abfd->memory)
     {
       bfd_hash_table_free (&abfd->section_htab);
@@ -27,15 +27,19 @@
    addr2line [options] addr addr ...
    or
    addr2line [options]
+   or
+   addr2line --server [options]
 
-   both forms write results to stdout, the second form reads addresses
-   to be converted from stdin.  */
+   all forms write results to stdout, the second form reads addresses
+   to be converted from stdin, and the third reads requests naming
+   executables and addresses from stdin.  */
 
 #include "sysdep.h"
 #include "bfd.h"
 #include "getopt.h"
 #include "libiberty.h"
 #include "demangle.h"
+#include "safe-ctype.h"
 #include "bucomm.h"
 #include "elf-bfd.h"
 
@@ -45,12 +49,52 @@ static bfd_boolean with_functions;	/* -f, show function names.  */
 static bfd_boolean do_demangle;		/* -C, demangle names.  */
 static bfd_boolean pretty_print;	/* -p, print on one line.  */
 static bfd_boolean base_names;		/* -s, strip directory names.  */
+static bfd_boolean server_mode;		/* --server, answer requests.  */
 
 static int naddr;		/* Number of addresses to process.  */
 static char **addr;		/* Hex addresses to process.  */
 
 static asymbol **syms;		/* Symbol table.  */
 
+/* An allocated section of an executable, for finding the sections
+   containing an address.  MAX_END is the highest END of this section
+   and of all the sections sorted before it.  */
+
+struct section_range
+{
+  bfd_vma vma;
+  bfd_vma end;
+  bfd_vma max_end;
+  asection *section;
+  unsigned int index;
+};
+
+/* An executable whose addresses are translated.  */
+
+struct exe_info
+{
+  /* Next executable kept open by --server.  */
+  struct exe_info *next;
+  /* The name used to open it.  */
+  char *name;
+  bfd *abfd;
+  /* The symbol table.  */
+  asymbol **syms;
+  /* The section named by -j, or NULL to translate addresses.  */
+  asection *section;
+  /* The allocated sections, sorted by address.  */
+  struct section_range *ranges;
+  unsigned int range_count;
+  /* A buffer for the sections containing an address.  */
+  struct section_range **matches;
+};
+
+/* The executables kept open by --server.  */
+
+static struct exe_info *server_exes;
+
+#define OPTION_SERVER 200
+
 static struct option long_options[] =
 {
   {"addresses", no_argument, NULL, 'a'},
@@ -61,6 +105,7 @@ static struct option long_options[] =
   {"inlines", no_argument, NULL, 'i'},
   {"pretty-print", no_argument, NULL, 'p'},
   {"section", required_argument, NULL, 'j'},
+  {"server", no_argument, NULL, OPTION_SERVER},
   {"target", required_argument, NULL, 'b'},
   {"help", no_argument, NULL, 'H'},
   {"version", no_argument, NULL, 'V'},
@@ -69,9 +114,10 @@ static struct option long_options[] =
 
 static void usage (FILE *, int);
 static void slurp_symtab (bfd *);
-static void find_address_in_section (bfd *, asection *, void *);
+static void find_address_in_sections (struct exe_info *);
 static void find_offset_in_section (bfd *, asection *);
-static void translate_addresses (bfd *, asection *);
+static void translate_address (struct exe_info *);
+static void translate_addresses (struct exe_info *);
 
 /* Print a usage message to STREAM and exit with STATUS.  */
 
@@ -89,6 +135,7 @@ usage (FILE *stream, int status)
   -i --inlines           Unwind inlined functions\n\
   -j --section=<name>    Read section-relative offsets instead of addresses\n\
   -p --pretty-print      Make the output easier to read for humans\n\
+     --server            Answer requests for several executables from stdin\n\
   -s --basenames         Strip directory names\n\
   -f --functions         Show function names\n\
   -C --demangle[=style]  Demangle function names\n\
@@ -144,7 +191,7 @@ slurp_symtab (bfd *abfd)
 }
 
 /* These global variables are used to pass information between
-   translate_addresses and find_address_in_section.  */
+   translate_address and find_address_in_sections.  */
 
 static bfd_vma pc;
 static const char *filename;
@@ -153,33 +200,48 @@ static unsigned int line;
 static unsigned int discriminator;
 static bfd_boolean found;
 
-/* Look for an address in a section.  This is called via
-   bfd_map_over_sections.  */
+/* Look for an address in the sections of EXE which contain it, in
+   the order of the section list.  */
 
 static void
-find_address_in_section (bfd *abfd, asection *section,
-			 void *data ATTRIBUTE_UNUSED)
+find_address_in_sections (struct exe_info *exe)
 {
-  bfd_vma vma;
-  bfd_size_type size;
-
-  if (found)
-    return;
-
-  if ((bfd_get_section_flags (abfd, section) & SEC_ALLOC) == 0)
-    return;
-
-  vma = bfd_get_section_vma (abfd, section);
-  if (pc < vma)
-    return;
-
-  size = bfd_get_section_size (section);
-  if (pc >= vma + size)
-    return;
+  unsigned int low, high, mid;
+  unsigned int count = 0;
+  unsigned int i, j;
+
+  /* Find the first section which may contain the address.  */
+  low = 0;
+  high = exe->range_count;
+  while (low < high)
+    {
+      mid = (low + high) / 2;
+      if (pc < exe->ranges[mid].max_end)
+	high = mid;
+      else
+	low = mid + 1;
+    }
 
-  found = bfd_find_nearest_line_discriminator (abfd, section, syms, pc - vma,
-                                               &filename, &functionname,
-                                               &line, &discriminator);
+  for (; low < exe->range_count && exe->ranges[low].vma <= pc; low++)
+    if (pc < exe->ranges[low].end)
+      {
+	/* Keep the sections in list order; there are few of them.  */
+	for (i = count; i > 0; i--)
+	  if (exe->matches[i - 1]->index < exe->ranges[low].index)
+	    break;
+	for (j = count; j > i; j--)
+	  exe->matches[j] = exe->matches[j - 1];
+	exe->matches[i] = &exe->ranges[low];
+	count++;
+      }
+
+  for (i = 0; i < count && !found; i++)
+    found = bfd_find_nearest_line_discriminator (exe->abfd,
+						 exe->matches[i]->section,
+						 syms,
+						 pc - exe->matches[i]->vma,
+						 &filename, &functionname,
+						 &line, &discriminator);
 }
 
 /* Look for an offset in a section.  This is directly called.  */
@@ -204,14 +266,140 @@ find_offset_in_section (bfd *abfd, asection *section)
                                                &line, &discriminator);
 }
 
-/* Read hexadecimal addresses from stdin, translate into
-   file_name:line_number and optionally function name.  */
+/* Translate the address PC in EXE into file_name:line_number and
+   optionally function name.  EXE is NULL if the executable could not
+   be opened.  */
+
+static void
+translate_address (struct exe_info *exe)
+{
+  bfd *abfd = exe != NULL ? exe->abfd : NULL;
+
+  if (abfd != NULL && bfd_get_flavour (abfd) == bfd_target_elf_flavour)
+    {
+      const struct elf_backend_data *bed = get_elf_backend_data (abfd);
+      bfd_vma sign = (bfd_vma) 1 << (bed->s->arch_size - 1);
+
+      pc &= (sign << 1) - 1;
+      if (bed->sign_extend_vma)
+	pc = (pc ^ sign) - sign;
+    }
+
+  if (with_addresses)
+    {
+      printf ("0x");
+      if (abfd != NULL)
+	bfd_printf_vma (abfd, pc);
+      else
+	printf ("%" BFD_VMA_FMT "x", pc);
+
+      if (pretty_print)
+	printf (": ");
+      else
+	printf ("\n");
+    }
+
+  found = FALSE;
+  if (exe == NULL)
+    ;
+  else if (exe->section)
+    find_offset_in_section (abfd, exe->section);
+  else
+    find_address_in_sections (exe);
+
+  if (! found)
+    {
+      if (with_functions)
+	{
+	  if (pretty_print)
+	    printf ("?? ");
+	  else
+	    printf ("??\n");
+	}
+      printf ("??:0\n");
+    }
+  else
+    {
+      while (1)
+	{
+	  if (with_functions)
+	    {
+	      const char *name;
+	      char *alloc = NULL;
+
+	      name = functionname;
+	      if (name == NULL || *name == '\0')
+		name = "??";
+	      else if (do_demangle)
+		{
+		  alloc = bfd_demangle (abfd, name, DMGL_ANSI | DMGL_PARAMS);
+		  if (alloc != NULL)
+		    name = alloc;
+		}
+
+	      printf ("%s", name);
+	      if (pretty_print)
+		/* Note for translators:  This printf is used to join the
+		   function name just printed above to the line number/
+		   file name pair that is about to be printed below.  Eg:
+
+		     foo at 123:bar.c  */
+		printf (_(" at "));
+	      else
+		printf ("\n");
+
+	      if (alloc != NULL)
+		free (alloc);
+	    }
+
+	  if (base_names && filename != NULL)
+	    {
+	      char *h;
+
+	      h = strrchr (filename, '/');
+	      if (h != NULL)
+		filename = h + 1;
+	    }
+
+	  printf ("%s:", filename ? filename : "??");
+	  if (line != 0)
+	    {
+	      if (discriminator != 0)
+		printf ("%u (discriminator %u)\n", line, discriminator);
+	      else
+		printf ("%u\n", line);
+	    }
+	  else
+	    printf ("?\n");
+	  if (!unwind_inlines)
+	    found = FALSE;
+	  else
+	    found = bfd_find_inliner_info (abfd, &filename, &functionname,
+					   &line);
+	  if (! found)
+	    break;
+	  if (pretty_print)
+	    /* Note for translators: This printf is used to join the
+	       line number/file name pair that has just been printed with
+	       the line number/file name pair that is going to be printed
+	       by the next iteration of the while loop.  Eg:
+
+		 123:bar.c (inlined by) 456:main.c  */
+	    printf (_(" (inlined by) "));
+	}
+    }
+}
+
+/* Read hexadecimal addresses from stdin or the command line, and
+   translate them in EXE.  */
 
 static void
-translate_addresses (bfd *abfd, asection *section)
+translate_addresses (struct exe_info *exe)
 {
   int read_stdin = (naddr == 0);
 
+  syms = exe->syms;
+
   for (;;)
     {
       if (read_stdin)
@@ -230,114 +418,7 @@ translate_addresses (bfd *abfd, asection *section)
 	  pc = bfd_scan_vma (*addr++, NULL, 16);
 	}
 
-      if (bfd_get_flavour (abfd) == bfd_target_elf_flavour)
-	{
-	  const struct elf_backend_data *bed = get_elf_backend_data (abfd);
-	  bfd_vma sign = (bfd_vma) 1 << (bed->s->arch_size - 1);
-
-	  pc &= (sign << 1) - 1;
-	  if (bed->sign_extend_vma)
-	    pc = (pc ^ sign) - sign;
-	}
-
-      if (with_addresses)
-        {
-          printf ("0x");
-          bfd_printf_vma (abfd, pc);
-
-          if (pretty_print)
-            printf (": ");
-          else
-            printf ("\n");
-        }
-
-      found = FALSE;
-      if (section)
-	find_offset_in_section (abfd, section);
-      else
-	bfd_map_over_sections (abfd, find_address_in_section, NULL);
-
-      if (! found)
-	{
-	  if (with_functions)
-	    {
-	      if (pretty_print)
-		printf ("?? ");
-	      else
-		printf ("??\n");
-	    }
-	  printf ("??:0\n");
-	}
-      else
-	{
-	  while (1)
-            {
-              if (with_functions)
-                {
-                  const char *name;
-                  char *alloc = NULL;
-
-                  name = functionname;
-                  if (name == NULL || *name == '\0')
-                    name = "??";
-                  else if (do_demangle)
-                    {
-                      alloc = bfd_demangle (abfd, name, DMGL_ANSI | DMGL_PARAMS);
-                      if (alloc != NULL)
-                        name = alloc;
-                    }
-
-                  printf ("%s", name);
-                  if (pretty_print)
-		    /* Note for translators:  This printf is used to join the
-		       function name just printed above to the line number/
-		       file name pair that is about to be printed below.  Eg:
-
-		         foo at 123:bar.c  */
-                    printf (_(" at "));
-                  else
-                    printf ("\n");
-
-                  if (alloc != NULL)
-                    free (alloc);
-                }
-
-              if (base_names && filename != NULL)
-                {
-                  char *h;
-
-                  h = strrchr (filename, '/');
-                  if (h != NULL)
-                    filename = h + 1;
-                }
-
-              printf ("%s:", filename ? filename : "??");
-	      if (line != 0)
-                {
-                  if (discriminator != 0)
-                    printf ("%u (discriminator %u)\n", line, discriminator);
-                  else
-                    printf ("%u\n", line);
-                }
-	      else
-		printf ("?\n");
-              if (!unwind_inlines)
-                found = FALSE;
-              else
-                found = bfd_find_inliner_info (abfd, &filename, &functionname,
-					       &line);
-              if (! found)
-                break;
-              if (pretty_print)
-		/* Note for translators: This printf is used to join the
-		   line number/file name pair that has just been printed with
-		   the line number/file name pair that is going to be printed
-		   by the next iteration of the while loop.  Eg:
-
-		     123:bar.c (inlined by) 456:main.c  */
-                printf (_(" (inlined by) "));
-            }
-	}
+      translate_address (exe);
 
       /* fflush() is essential for using this command as a server
          child process that reads addresses from a pipe and responds
@@ -347,28 +428,100 @@ translate_addresses (bfd *abfd, asection *section)
     }
 }
 
-/* Process a file.  Returns an exit value for main().  */
+/* Compare function for sorting the sections of an executable.  */
 
 static int
-process_file (const char *file_name, const char *section_name,
-	      const char *target)
+compare_section_ranges (const void *a, const void *b)
 {
+  const struct section_range *range1 = (const struct section_range *) a;
+  const struct section_range *range2 = (const struct section_range *) b;
+
+  if (range1->vma != range2->vma)
+    return range1->vma < range2->vma ? -1 : 1;
+  return range1->index < range2->index ? -1 : 1;
+}
+
+/* Build the table of the allocated sections of EXE sorted by
+   address.  */
+
+static void
+sort_sections (struct exe_info *exe)
+{
+  asection *section;
+  unsigned int index;
+  unsigned int count;
+  bfd_vma max_end;
+
+  exe->ranges = (struct section_range *)
+    xmalloc (bfd_count_sections (exe->abfd) * sizeof (*exe->ranges) + 1);
+
+  count = 0;
+  for (section = exe->abfd->sections, index = 0;
+       section != NULL;
+       section = section->next, index++)
+    {
+      struct section_range *range = &exe->ranges[count];
+
+      if ((bfd_get_section_flags (exe->abfd, section) & SEC_ALLOC) == 0)
+	continue;
+
+      range->vma = bfd_get_section_vma (exe->abfd, section);
+      range->end = range->vma + bfd_get_section_size (section);
+      if (range->end <= range->vma)
+	continue;
+      range->section = section;
+      range->index = index;
+      count++;
+    }
+
+  qsort (exe->ranges, count, sizeof (*exe->ranges), compare_section_ranges);
+
+  max_end = 0;
+  for (index = 0; index < count; index++)
+    {
+      if (exe->ranges[index].end > max_end)
+	max_end = exe->ranges[index].end;
+      exe->ranges[index].max_end = max_end;
+    }
+
+  exe->range_count = count;
+  exe->matches = (struct section_range **)
+    xmalloc (count * sizeof (*exe->matches) + 1);
+}
+
+/* Open FILE_NAME with TARGET, read its symbols and sort its sections.
+   If SECTION_NAME is not NULL, offsets in that section are translated
+   instead of addresses.  Return NULL after reporting an error if the
+   file cannot be used.  */
+
+static struct exe_info *
+open_exe (const char *file_name, const char *section_name,
+	  const char *target)
+{
+  struct exe_info *exe;
   bfd *abfd;
   asection *section;
   char **matching;
 
   if (get_file_size (file_name) < 1)
-    return 1;
+    return NULL;
 
   abfd = bfd_openr (file_name, target);
   if (abfd == NULL)
-    bfd_fatal (file_name);
+    {
+      bfd_nonfatal (file_name);
+      return NULL;
+    }
 
   /* Decompress sections.  */
   abfd->flags |= BFD_DECOMPRESS;
 
   if (bfd_check_format (abfd, bfd_archive))
-    fatal (_("%s: cannot get addresses from archive"), file_name);
+    {
+      non_fatal (_("%s: cannot get addresses from archive"), file_name);
+      bfd_close (abfd);
+      return NULL;
+    }
 
   if (! bfd_check_format_matches (abfd, bfd_object, &matching))
     {
@@ -378,33 +531,197 @@ process_file (const char *file_name, const char *section_name,
 	  list_matching_formats (matching);
 	  free (matching);
 	}
-      xexit (1);
+      bfd_close (abfd);
+      return NULL;
     }
 
   if (section_name != NULL)
     {
       section = bfd_get_section_by_name (abfd, section_name);
       if (section == NULL)
-	fatal (_("%s: cannot find section %s"), file_name, section_name);
+	{
+	  non_fatal (_("%s: cannot find section %s"), file_name, section_name);
+	  bfd_close (abfd);
+	  return NULL;
+	}
     }
   else
     section = NULL;
 
+  syms = NULL;
   slurp_symtab (abfd);
 
-  translate_addresses (abfd, section);
+  exe = (struct exe_info *) xmalloc (sizeof (*exe));
+  exe->next = NULL;
+  exe->name = xstrdup (file_name);
+  exe->abfd = abfd;
+  exe->syms = syms;
+  exe->section = section;
+  sort_sections (exe);
+
+  return exe;
+}
+
+/* Close EXE.  */
+
+static void
+close_exe (struct exe_info *exe)
+{
+  if (exe->syms != NULL)
+    free (exe->syms);
+  free (exe->ranges);
+  free (exe->matches);
+  free (exe->name);
+  bfd_close (exe->abfd);
+  free (exe);
+}
+
+/* Read a line from stdin into *BUF, whose size is *SIZE, growing it as
+   needed.  Return FALSE at the end of the input.  */
+
+static bfd_boolean
+read_request (char **buf, size_t *size)
+{
+  size_t len = 0;
+  int c;
 
-  if (syms != NULL)
+  while ((c = getchar ()) != EOF && c != '\n')
     {
-      free (syms);
-      syms = NULL;
+      if (len + 1 >= *size)
+	{
+	  *size = *size * 2 + 128;
+	  *buf = (char *) xrealloc (*buf, *size);
+	}
+      (*buf)[len++] = c;
     }
 
-  bfd_close (abfd);
+  if (c == EOF && len == 0)
+    return FALSE;
+
+  if (*buf == NULL)
+    *buf = (char *) xmalloc (*size = 128);
+  (*buf)[len] = '\0';
+  return TRUE;
+}
+
+/* Answer requests from stdin until the end of the input.  A request
+   is a line, which is either "exe FILENAME", to translate the
+   following addresses in FILENAME, or a list of hexadecimal addresses
+   separated by white space.  The executables are opened once and
+   kept open.  The answer to an address is printed as in the other
+   modes, and the answer to each request ends with an empty line.  If
+   FILENAME cannot be opened, the answer is a line starting with
+   "error:", and addresses are not found until another executable is
+   named.  FILE_NAME, if not NULL, is the executable to start with.  */
+
+static int
+serve_requests (const char *file_name, const char *section_name,
+		const char *target)
+{
+  struct exe_info *exe = NULL;
+  char *buf = NULL;
+  size_t size = 0;
+
+  if (file_name != NULL)
+    {
+      exe = open_exe (file_name, section_name, target);
+      if (exe == NULL)
+	return 1;
+      server_exes = exe;
+    }
+
+  while (read_request (&buf, &size))
+    {
+      char *p = buf;
+
+      while (ISSPACE (*p))
+	p++;
+
+      if (CONST_STRNEQ (p, "exe") && ISSPACE (p[3]))
+	{
+	  char *name = p + 4;
+	  char *end;
+
+	  while (ISSPACE (*name))
+	    name++;
+	  end = name + strlen (name);
+	  while (end > name && ISSPACE (end[-1]))
+	    *--end = '\0';
+
+	  for (exe = server_exes; exe != NULL; exe = exe->next)
+	    if (strcmp (exe->name, name) == 0)
+	      break;
+
+	  if (exe == NULL)
+	    {
+	      exe = open_exe (name, section_name, target);
+	      if (exe != NULL)
+		{
+		  exe->next = server_exes;
+		  server_exes = exe;
+		}
+	      else
+		printf (_("error: cannot use %s\n"), name);
+	    }
+	}
+      else
+	{
+	  syms = exe != NULL ? exe->syms : NULL;
+	  while (*p != '\0')
+	    {
+	      char *next;
+
+	      pc = bfd_scan_vma (p, (const char **) &next, 16);
+	      if (next == p)
+		{
+		  /* Skip a word which is not an address.  */
+		  while (*p != '\0' && !ISSPACE (*p))
+		    p++;
+		}
+	      else
+		{
+		  translate_address (exe);
+		  p = next;
+		}
+	      while (ISSPACE (*p))
+		p++;
+	    }
+	}
+
+      printf ("\n");
+      fflush (stdout);
+    }
+
+  free (buf);
+  while (server_exes != NULL)
+    {
+      exe = server_exes;
+      server_exes = exe->next;
+      close_exe (exe);
+    }
 
   return 0;
 }
-
+
+/* Process a file.  Returns an exit value for main().  */
+
+static int
+process_file (const char *file_name, const char *section_name,
+	      const char *target)
+{
+  struct exe_info *exe;
+
+  exe = open_exe (file_name, section_name, target);
+  if (exe == NULL)
+    return 1;
+
+  translate_addresses (exe);
+
+  close_exe (exe);
+
+  return 0;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -486,12 +803,22 @@ main (int argc, char **argv)
 	case 'j':
 	  section_name = optarg;
 	  break;
+	case OPTION_SERVER:
+	  server_mode = TRUE;
+	  break;
 	default:
 	  usage (stderr, 1);
 	  break;
 	}
     }
 
+  if (server_mode)
+    {
+      if (optind < argc)
+	usage (stderr, 1);
+      return serve_requests (file_name, section_name, target);
+    }
+
   if (file_name == NULL)
     file_name = "a.out";
 
@@ -1142,6 +1142,12 @@ write_archive (bfd *iarch)
      been explicitly requested not to.  */
   obfd->has_armap = write_armap >= 0;
 
+  /* BFD takes the symbols of members copied unchanged from IARCH out
+     of IARCH's existing map.  Don't trust that map when we have been
+     asked to rebuild the symbol table, as ranlib and `s' do.  */
+  if (write_armap > 0)
+    bfd_has_map (iarch) = FALSE;
+
   if (ar_truncate)
     {
       /* This should really use bfd_set_file_flags, but that rejects
@@ -658,6 +658,14 @@ abbrev_entry;
 static abbrev_entry *first_abbrev = NULL;
 static abbrev_entry *last_abbrev = NULL;
 
+/* Abbreviation numbers are normally allocated densely from 1, so the
+   entries of the current set are also indexed by number here to save
+   walking the list for every DIE.  Numbers beyond MAX_ABBREV_INDEX are
+   only found through the list.  */
+#define MAX_ABBREV_INDEX 0x10000
+static abbrev_entry **abbrev_index = NULL;
+static unsigned long abbrev_index_size = 0;
+
 static void
 free_abbrevs (void)
 {
@@ -668,6 +676,9 @@ free_abbrevs (void)
       abbrev_entry *next_abbrev = abbrv->next;
       abbrev_attr *attr;
 
+      if (abbrv->entry < abbrev_index_size)
+	abbrev_index[abbrv->entry] = NULL;
+
       for (attr = abbrv->first_attr; attr;)
 	{
 	  abbrev_attr *next_attr = attr->next;
@@ -683,6 +694,25 @@ free_abbrevs (void)
   last_abbrev = first_abbrev = NULL;
 }
 
+/* Return the abbreviation numbered NUMBER in the current set, or NULL
+   if there is none.  */
+
+static abbrev_entry *
+find_abbrev (unsigned long number)
+{
+  abbrev_entry *entry;
+
+  if (number < abbrev_index_size)
+    return abbrev_index[number];
+  if (number < MAX_ABBREV_INDEX)
+    return NULL;
+
+  for (entry = first_abbrev; entry != NULL; entry = entry->next)
+    if (entry->entry == number)
+      break;
+  return entry;
+}
+
 static void
 add_abbrev (unsigned long number, unsigned long tag, int children)
 {
@@ -706,6 +736,25 @@ add_abbrev (unsigned long number, unsigned long tag, int children)
     last_abbrev->next = entry;
 
   last_abbrev = entry;
+
+  if (number < MAX_ABBREV_INDEX)
+    {
+      if (number >= abbrev_index_size)
+	{
+	  unsigned long size = abbrev_index_size ? abbrev_index_size : 64;
+
+	  while (size <= number)
+	    size *= 2;
+	  abbrev_index = (abbrev_entry **)
+	    xcrealloc (abbrev_index, size, sizeof (*abbrev_index));
+	  memset (abbrev_index + abbrev_index_size, 0,
+		  (size - abbrev_index_size) * sizeof (*abbrev_index));
+	  abbrev_index_size = size;
+	}
+      /* Keep the first definition, as the list walk would.  */
+      if (abbrev_index[number] == NULL)
+	abbrev_index[number] = entry;
+    }
 }
 
 static void
@@ -1748,11 +1797,11 @@ read_and_display_attr_value (unsigned long attribute,
 
 	      if (lmax == 0 || num >= lmax)
 		{
-		  lmax += 1024;
+		  lmax = lmax ? lmax * 2 : 16;
 		  debug_info_p->loc_offsets = (dwarf_vma *)
                       xcrealloc (debug_info_p->loc_offsets,
 				 lmax, sizeof (*debug_info_p->loc_offsets));
-		  debug_info_p->have_frame_base = (int *)
+		  debug_info_p->have_frame_base = (unsigned char *)
                       xcrealloc (debug_info_p->have_frame_base,
 				 lmax, sizeof (*debug_info_p->have_frame_base));
 		  debug_info_p->max_loc_offsets = lmax;
@@ -1789,7 +1838,7 @@ read_and_display_attr_value (unsigned long attribute,
 
 	      if (lmax == 0 || num >= lmax)
 		{
-		  lmax += 1024;
+		  lmax = lmax ? lmax * 2 : 16;
 		  debug_info_p->range_lists = (dwarf_vma *)
                       xcrealloc (debug_info_p->range_lists,
 				 lmax, sizeof (*debug_info_p->range_lists));
@@ -2056,9 +2105,7 @@ read_and_display_attr_value (unsigned long attribute,
 	       yet.  */
 	    if (form != DW_FORM_ref_addr)
 	      {
-		for (entry = first_abbrev; entry != NULL; entry = entry->next)
-		  if (entry->entry == abbrev_number)
-		    break;
+		entry = find_abbrev (abbrev_number);
 		if (entry != NULL)
 		  printf (" (%s)", get_TAG_name (entry->tag));
 	      }
@@ -2125,6 +2172,36 @@ read_and_display_attr (unsigned long attribute,
   return data;
 }
 
+/* Shrink the location and range list arrays of DEBUG_INFO_P to the
+   number of entries actually recorded.  */
+
+static void
+trim_debug_info_lists (debug_info *debug_info_p)
+{
+  unsigned int num;
+
+  num = debug_info_p->num_loc_offsets;
+  if (num < debug_info_p->max_loc_offsets)
+    {
+      debug_info_p->loc_offsets = (dwarf_vma *)
+	xcrealloc (debug_info_p->loc_offsets, num,
+		   sizeof (*debug_info_p->loc_offsets));
+      debug_info_p->have_frame_base = (unsigned char *)
+	xcrealloc (debug_info_p->have_frame_base, num,
+		   sizeof (*debug_info_p->have_frame_base));
+      debug_info_p->max_loc_offsets = num;
+    }
+
+  num = debug_info_p->num_range_lists;
+  if (num < debug_info_p->max_range_lists)
+    {
+      debug_info_p->range_lists = (dwarf_vma *)
+	xcrealloc (debug_info_p->range_lists, num,
+		   sizeof (*debug_info_p->range_lists));
+      debug_info_p->max_range_lists = num;
+    }
+}
+
 /* Process the contents of a .debug_info section.  If do_loc is non-zero
    then we are scanning for location lists and we do not want to display
    anything to the user.  If do_types is non-zero, we are processing
@@ -2458,12 +2535,7 @@ process_debug_info (struct dwarf_section *section,
 		}
 	    }
 
-	  /* Scan through the abbreviation list until we reach the
-	     correct entry.  */
-	  for (entry = first_abbrev;
-	       entry && entry->entry != abbrev_number;
-	       entry = entry->next)
-	    continue;
+	  entry = find_abbrev (abbrev_number);
 
 	  if (entry == NULL)
 	    {
@@ -2527,6 +2599,14 @@ process_debug_info (struct dwarf_section *section,
  	  if (entry->children)
  	    ++level;
  	}
+
+      /* Only the location and range list offsets of each unit are kept
+	 once it has been read, so give back the slack in those lists.  */
+      if (debug_information != NULL
+	  && (do_loc || do_debug_loc || do_debug_ranges)
+	  && num_debug_info_entries == 0
+	  && ! do_types)
+	trim_debug_info_lists (debug_information + unit);
     }
 
   /* Set num_debug_info_entries here so that it can be used to check if
@@ -6589,6 +6669,9 @@ free_debug_memory (void)
   unsigned int i;
 
   free_abbrevs ();
+  free (abbrev_index);
+  abbrev_index = NULL;
+  abbrev_index_size = 0;
 
   for (i = 0; i < max; i++)
     free_debug_section ((enum dwarf_section_display_enum) i);
@@ -6599,13 +6682,9 @@ free_debug_memory (void)
 	{
 	  for (i = 0; i < num_debug_info_entries; i++)
 	    {
-	      if (!debug_information [i].max_loc_offsets)
-		{
-		  free (debug_information [i].loc_offsets);
-		  free (debug_information [i].have_frame_base);
-		}
-	      if (!debug_information [i].max_range_lists)
-		free (debug_information [i].range_lists);
+	      free (debug_information [i].loc_offsets);
+	      free (debug_information [i].have_frame_base);
+	      free (debug_information [i].range_lists);
 	    }
 	}
 
@@ -42,6 +42,18 @@ struct size_sym
   bfd_vma size;
 };
 
+/* The keys of a symbol being sorted by name or value.  These are
+   extracted once up front so that the comparisons do not have to go
+   through bfd_minisymbol_to_symbol for every symbol they look at.  */
+
+struct sort_key
+{
+  const char *name;
+  bfd_vma value;
+  bfd_boolean undefined;
+  const bfd_byte *minisym;
+};
+
 /* When fetching relocs, we use this structure to pass information to
    get_relocs.  */
 
@@ -481,6 +493,9 @@ filter_symbols (bfd *abfd, bfd_boolean is_dynamic, void *minisyms,
 /* These globals are used to pass information into the sorting
    routines.  */
 static bfd *sort_bfd;
+/* TRUE if the collation locale is C or POSIX, in which strcoll orders
+   names exactly as the much cheaper strcmp does.  */
+static bfd_boolean collate_bytewise = TRUE;
 static bfd_boolean sort_dynamic;
 static asymbol *sort_x;
 static asymbol *sort_y;
@@ -493,19 +508,8 @@ static asymbol *sort_y;
    specially -- i.e., their sizes are used as their "values".  */
 
 static int
-non_numeric_forward (const void *P_x, const void *P_y)
+compare_symbol_names (const char *xn, const char *yn)
 {
-  asymbol *x, *y;
-  const char *xn, *yn;
-
-  x = bfd_minisymbol_to_symbol (sort_bfd, sort_dynamic, P_x, sort_x);
-  y = bfd_minisymbol_to_symbol (sort_bfd, sort_dynamic, P_y, sort_y);
-  if (x == NULL || y == NULL)
-    bfd_fatal (bfd_get_filename (sort_bfd));
-
-  xn = bfd_asymbol_name (x);
-  yn = bfd_asymbol_name (y);
-
   if (yn == NULL)
     return xn != NULL;
   if (xn == NULL)
@@ -519,12 +523,27 @@ non_numeric_forward (const void *P_x, const void *P_y)
   if (*xn == '\0')
     return -1;
 
+  if (collate_bytewise)
+    return strcmp (xn, yn);
   return strcoll (xn, yn);
 #else
   return strcmp (xn, yn);
 #endif
 }
 
+static int
+non_numeric_forward (const void *P_x, const void *P_y)
+{
+  asymbol *x, *y;
+
+  x = bfd_minisymbol_to_symbol (sort_bfd, sort_dynamic, P_x, sort_x);
+  y = bfd_minisymbol_to_symbol (sort_bfd, sort_dynamic, P_y, sort_y);
+  if (x == NULL || y == NULL)
+    bfd_fatal (bfd_get_filename (sort_bfd));
+
+  return compare_symbol_names (bfd_asymbol_name (x), bfd_asymbol_name (y));
+}
+
 static int
 non_numeric_reverse (const void *x, const void *y)
 {
@@ -570,6 +589,250 @@ static int (*(sorters[2][2])) (const void *, const void *) =
   { numeric_forward, numeric_reverse }
 };
 
+static int
+sort_key_name_forward (const void *P_x, const void *P_y)
+{
+  const struct sort_key *x = (const struct sort_key *) P_x;
+  const struct sort_key *y = (const struct sort_key *) P_y;
+  int cmp;
+
+  /* Keep symbols with the same name in their original order.  */
+  cmp = compare_symbol_names (x->name, y->name);
+  if (cmp == 0 && x->minisym != y->minisym)
+    cmp = x->minisym < y->minisym ? -1 : 1;
+  return cmp;
+}
+
+#define NAME_BYTE(key, depth) ((unsigned char) (key)->name[depth])
+
+/* Sort the COUNT keys in KEYS by name, bytewise, keeping symbols with
+   the same name in their original order.  The names must all be
+   non-NULL and agree in their first DEPTH bytes.  This is a multikey
+   quicksort, which looks at each byte of a name about once rather than
+   comparing the long common prefixes of mangled names over and over.  */
+
+static void
+name_sort_keys (struct sort_key *keys, long count, size_t depth)
+{
+  struct sort_key t;
+  long lt, gt, i, j;
+  int pivot, c;
+
+  while (count > 8)
+    {
+      /* Partition on the byte at DEPTH into less than, equal to and
+	 greater than the pivot.  */
+      pivot = NAME_BYTE (&keys[count / 2], depth);
+      lt = 0;
+      gt = count - 1;
+      i = 0;
+      while (i <= gt)
+	{
+	  c = NAME_BYTE (&keys[i], depth);
+	  if (c < pivot)
+	    {
+	      t = keys[lt];
+	      keys[lt++] = keys[i];
+	      keys[i++] = t;
+	    }
+	  else if (c > pivot)
+	    {
+	      t = keys[gt];
+	      keys[gt--] = keys[i];
+	      keys[i] = t;
+	    }
+	  else
+	    i++;
+	}
+
+      name_sort_keys (keys, lt, depth);
+      name_sort_keys (keys + gt + 1, count - gt - 1, depth);
+
+      keys += lt;
+      count = gt - lt + 1;
+      if (pivot == 0)
+	{
+	  /* These names are all identical.  */
+	  qsort (keys, count, sizeof (*keys), sort_key_name_forward);
+	  return;
+	}
+      depth++;
+    }
+
+  for (i = 1; i < count; i++)
+    {
+      t = keys[i];
+      for (j = i; j > 0; j--)
+	{
+	  int cmp = strcmp (keys[j - 1].name + depth, t.name + depth);
+
+	  if (cmp < 0 || (cmp == 0 && keys[j - 1].minisym < t.minisym))
+	    break;
+	  keys[j] = keys[j - 1];
+	}
+      keys[j] = t;
+    }
+}
+
+/* Return true if the symbols with keys X and Y compare equal under the
+   current sort order.  */
+
+static bfd_boolean
+sort_keys_equal (const struct sort_key *x, const struct sort_key *y)
+{
+  if (sort_numerically
+      && (x->undefined != y->undefined || x->value != y->value))
+    return FALSE;
+  return compare_symbol_names (x->name, y->name) == 0;
+}
+
+/* Stably sort the COUNT keys in KEYS into ascending order of value,
+   with undefined symbols first, using TMP as scratch space.  This is
+   an LSD radix sort, a byte at a time, skipping bytes which are the
+   same in every key (usually most of the high ones).  */
+
+static void
+radix_sort_keys (struct sort_key *keys, struct sort_key *tmp, long count)
+{
+  struct sort_key *from = keys;
+  struct sort_key *to = tmp;
+  struct sort_key *swap;
+  unsigned int shift;
+  long buckets[256];
+  long i, pos, n;
+
+  for (shift = 0; shift <= 8 * sizeof (bfd_vma); shift += 8)
+    {
+      unsigned int nbuckets;
+
+      memset (buckets, 0, sizeof (buckets));
+      /* The final pass moves the undefined symbols to the front.  */
+      if (shift == 8 * sizeof (bfd_vma))
+	{
+	  nbuckets = 2;
+	  for (i = 0; i < count; i++)
+	    buckets[! from[i].undefined]++;
+	  if (buckets[! from[0].undefined] == count)
+	    continue;
+	}
+      else
+	{
+	  nbuckets = 256;
+	  for (i = 0; i < count; i++)
+	    buckets[(from[i].value >> shift) & 0xff]++;
+	  if (buckets[(from[0].value >> shift) & 0xff] == count)
+	    continue;
+	}
+
+      for (i = 0, pos = 0; i < (long) nbuckets; i++)
+	{
+	  n = buckets[i];
+	  buckets[i] = pos;
+	  pos += n;
+	}
+
+      if (nbuckets == 2)
+	for (i = 0; i < count; i++)
+	  to[buckets[! from[i].undefined]++] = from[i];
+      else
+	for (i = 0; i < count; i++)
+	  to[buckets[(from[i].value >> shift) & 0xff]++] = from[i];
+
+      swap = from;
+      from = to;
+      to = swap;
+    }
+
+  if (from != keys)
+    memcpy (keys, from, count * sizeof (*keys));
+}
+
+/* Sort the SYMCOUNT minisymbols of SIZE bytes each in MINISYMS by name,
+   or by value if SORT_NUMERICALLY, in the order the sorters above
+   define.  Symbols which compare equal keep their original order.  */
+
+static void
+sort_minisyms (bfd *abfd, bfd_boolean is_dynamic, void *minisyms,
+	       long symcount, unsigned int size)
+{
+  struct sort_key *keys, *tmp;
+  bfd_byte *from, *sorted;
+  asymbol *store;
+  long i, k, end;
+  bfd_boolean bytewise = collate_bytewise;
+
+  if (symcount < 2)
+    return;
+
+  store = bfd_make_empty_symbol (abfd);
+  if (store == NULL)
+    bfd_fatal (bfd_get_filename (abfd));
+
+  keys = (struct sort_key *) xmalloc (symcount * sizeof (*keys));
+  from = (bfd_byte *) minisyms;
+  for (i = 0; i < symcount; i++, from += size)
+    {
+      asymbol *sym;
+
+      sym = bfd_minisymbol_to_symbol (abfd, is_dynamic, from, store);
+      if (sym == NULL)
+	bfd_fatal (bfd_get_filename (abfd));
+
+      keys[i].name = bfd_asymbol_name (sym);
+      if (keys[i].name == NULL)
+	bytewise = FALSE;
+      keys[i].undefined = bfd_is_und_section (bfd_get_section (sym));
+      keys[i].value = keys[i].undefined ? 0 : valueof (sym);
+      keys[i].minisym = from;
+    }
+
+  if (sort_numerically)
+    {
+      tmp = (struct sort_key *) xmalloc (symcount * sizeof (*keys));
+      radix_sort_keys (keys, tmp, symcount);
+      free (tmp);
+
+      /* Symbols with the same value are ordered by name.  */
+      for (i = 0; i < symcount; i = end)
+	{
+	  end = i + 1;
+	  while (end < symcount
+		 && keys[end].undefined == keys[i].undefined
+		 && keys[end].value == keys[i].value)
+	    end++;
+	  if (end - i == 1)
+	    continue;
+	  if (bytewise)
+	    name_sort_keys (keys + i, end - i, 0);
+	  else
+	    qsort (keys + i, end - i, sizeof (*keys), sort_key_name_forward);
+	}
+    }
+  else if (bytewise)
+    name_sort_keys (keys, symcount, 0);
+  else
+    qsort (keys, symcount, sizeof (*keys), sort_key_name_forward);
+
+  /* A reverse sort keeps symbols which compare equal in their original
+     order, so reverse the runs of equal keys rather than the symbols.  */
+  sorted = (bfd_byte *) xmalloc (symcount * size);
+  for (i = 0; i < symcount; i = end)
+    {
+      end = i + 1;
+      if (reverse_sort)
+	while (end < symcount && sort_keys_equal (&keys[end], &keys[i]))
+	  end++;
+
+      for (k = i; k < end; k++)
+	memcpy (sorted + (reverse_sort ? symcount - end + k - i : k) * size,
+		keys[k].minisym, size);
+    }
+  memcpy (minisyms, sorted, symcount * size);
+
+  free (sorted);
+  free (keys);
+}
+
 /* This sort routine is used by sort_symbols_by_size.  It is similar
    to numeric_forward, but when symbols have the same value it sorts
    by section VMA.  This simplifies the sort_symbols_by_size code
@@ -1092,8 +1355,7 @@ display_rel_file (bfd *abfd, bfd *archive_bfd)
 	bfd_fatal (bfd_get_filename (abfd));
 
       if (! sort_by_size)
-	qsort (minisyms, symcount, size,
-	       sorters[sort_numerically][reverse_sort]);
+	sort_minisyms (abfd, dynamic, minisyms, symcount, size);
       else
 	symcount = sort_symbols_by_size (abfd, dynamic, minisyms, symcount,
 					 size, &symsizes);
@@ -1528,7 +1790,13 @@ main (int argc, char **argv)
 #endif
 #if defined (HAVE_SETLOCALE)
   setlocale (LC_CTYPE, "");
-  setlocale (LC_COLLATE, "");
+  {
+    const char *collate = setlocale (LC_COLLATE, "");
+
+    collate_bytewise = (collate == NULL
+			|| strcmp (collate, "C") == 0
+			|| strcmp (collate, "POSIX") == 0);
+  }
 #endif
   bindtextdomain (PACKAGE, LOCALEDIR);
   textdomain (PACKAGE);
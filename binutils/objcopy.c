@@ -2864,6 +2864,46 @@ copy_relocations_in_section (bfd *ibfd, sec_ptr isection, void *obfdarg)
     }
 }
 
+/* Sections which are copied unchanged are passed through a buffer of
+   this size, rather than being read into memory in one piece.  */
+#define COPY_CHUNK_SIZE (1024 * 1024)
+
+/* Copy the SIZE bytes of ISECTION of IBFD unchanged to OSECTION of
+   OBFD, a chunk at a time.  */
+
+static bfd_boolean
+copy_section_contents_by_chunk (bfd *ibfd, sec_ptr isection,
+				bfd *obfd, sec_ptr osection,
+				bfd_size_type size)
+{
+  bfd_byte *chunk = (bfd_byte *) xmalloc (COPY_CHUNK_SIZE);
+  file_ptr offset;
+  bfd_size_type count;
+
+  for (offset = 0; (bfd_size_type) offset < size; offset += count)
+    {
+      count = size - offset;
+      if (count > COPY_CHUNK_SIZE)
+	count = COPY_CHUNK_SIZE;
+
+      if (!bfd_get_section_contents (ibfd, isection, chunk, offset, count))
+	{
+	  bfd_nonfatal_message (NULL, ibfd, isection, NULL);
+	  free (chunk);
+	  return FALSE;
+	}
+      if (!bfd_set_section_contents (obfd, osection, chunk, offset, count))
+	{
+	  bfd_nonfatal_message (NULL, obfd, osection, NULL);
+	  free (chunk);
+	  return FALSE;
+	}
+    }
+
+  free (chunk);
+  return TRUE;
+}
+
 /* Copy the data of input section ISECTION of IBFD
    to an output section with the same name in OBFD.  */
 
@@ -2886,6 +2926,24 @@ copy_section (bfd *ibfd, sec_ptr isection, void *obfdarg)
     {
       bfd_byte *memhunk = NULL;
 
+      /* Large sections which need no rewriting are streamed across,
+	 so that copying or stripping a big file does not need memory
+	 for its biggest section.  Compressed sections still have to be
+	 read in whole.  This is limited to ELF output, which writes
+	 each piece straight to its place in the file; record based
+	 formats such as ihex would lay their records out differently.  */
+      if (size > COPY_CHUNK_SIZE
+	  && bfd_get_flavour (obfd) == bfd_target_elf_flavour
+	  && !reverse_bytes
+	  && copy_byte < 0
+	  && isection->compress_status == COMPRESS_SECTION_NONE)
+	{
+	  if (!copy_section_contents_by_chunk (ibfd, isection,
+					       obfd, osection, size))
+	    status = 1;
+	  return;
+	}
+
       if (!bfd_get_full_section_contents (ibfd, isection, &memhunk))
 	{
 	  status = 1;
@@ -1453,6 +1453,32 @@ objdump_sprintf (SFILE *f, const char *format, ...)
 {
   size_t n;
   va_list args;
+  const char *text = NULL;
+
+  /* Disassemblers mostly print either a bare "%s" or a literal
+     string with no conversions at all; copy those directly rather
+     than paying for a vsnprintf call per operand.  */
+  if (format[0] == '%' && format[1] == 's' && format[2] == '\0')
+    {
+      va_start (args, format);
+      text = va_arg (args, const char *);
+      va_end (args);
+    }
+  else if (strchr (format, '%') == NULL)
+    text = format;
+
+  if (text != NULL)
+    {
+      n = strlen (text);
+      if (f->alloc - f->pos <= n)
+	{
+	  f->alloc = (f->alloc + n) * 2;
+	  f->buffer = (char *) xrealloc (f->buffer, f->alloc);
+	}
+      memcpy (f->buffer + f->pos, text, n + 1);
+      f->pos += n;
+      return n;
+    }
 
   while (1)
     {
@@ -1473,6 +1499,18 @@ objdump_sprintf (SFILE *f, const char *format, ...)
   return n;
 }
 
+/* Print the octet BYTE as two hex digits.  Raw instruction bytes are
+   printed one at a time, so avoid going through printf for each.  */
+
+static void
+print_hex_octet (bfd_byte byte)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  putchar (hex[byte >> 4]);
+  putchar (hex[byte & 0xf]);
+}
+
 /* The number of zeroes we want to see before we start skipping them.
    The number is arbitrarily chosen.  */
 
@@ -1726,13 +1764,13 @@ disassemble_bytes (struct disassemble_info * inf,
 		  if (bpc > 1 && inf->display_endian == BFD_ENDIAN_LITTLE)
 		    {
 		      for (k = bpc - 1; k >= 0; k--)
-			printf ("%02x", (unsigned) data[j + k]);
+			print_hex_octet (data[j + k]);
 		      putchar (' ');
 		    }
 		  else
 		    {
 		      for (k = 0; k < bpc; k++)
-			printf ("%02x", (unsigned) data[j + k]);
+			print_hex_octet (data[j + k]);
 		      putchar (' ');
 		    }
 		}
@@ -1756,7 +1794,7 @@ disassemble_bytes (struct disassemble_info * inf,
 	  if (! insns)
 	    printf ("%s", buf);
 	  else if (sfile.pos)
-	    printf ("%s", sfile.buffer);
+	    fputs (sfile.buffer, stdout);
 
 	  if (prefix_addresses
 	      ? show_raw_insn > 0
@@ -1787,13 +1825,13 @@ disassemble_bytes (struct disassemble_info * inf,
 		      if (bpc > 1 && inf->display_endian == BFD_ENDIAN_LITTLE)
 			{
 			  for (k = bpc - 1; k >= 0; k--)
-			    printf ("%02x", (unsigned) data[j + k]);
+			    print_hex_octet (data[j + k]);
 			  putchar (' ');
 			}
 		      else
 			{
 			  for (k = 0; k < bpc; k++)
-			    printf ("%02x", (unsigned) data[j + k]);
+			    print_hex_octet (data[j + k]);
 			  putchar (' ');
 			}
 		    }
@@ -49,6 +49,10 @@
 #ifdef HAVE_WCHAR_H
 #include <wchar.h>
 #endif
+#if defined (HAVE_MMAP) && defined (HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#define USE_MMAP 1
+#endif
 
 #if __GNUC__ >= 2
 /* Define BFD64 here, even if our default architecture is 32 bit ELF
@@ -349,6 +353,58 @@ get_data (void * var, FILE * file, long offset, size_t size, size_t nmemb,
   return mvar;
 }
 
+/* The input file mapped into memory, if mmap is available and mapping
+   it succeeded.  FILE_MAP_STREAM is the stream it was mapped from.  */
+static unsigned char * file_map = NULL;
+static size_t file_map_size = 0;
+static FILE * file_map_stream = NULL;
+
+/* Like get_data with a NULL VAR, but if the data lies within the
+   mapped input file return a pointer straight into the mapping rather
+   than reading a copy.  The mapping is private and writable, so callers
+   may still modify the data in place.  The result must be released with
+   release_data rather than free.  */
+
+static void *
+get_mapped_data (FILE * file, long offset, size_t size, size_t nmemb,
+		 const char * reason)
+{
+#ifdef USE_MMAP
+  if (file == file_map_stream
+      && size != 0
+      && nmemb != 0
+      && nmemb < (~(size_t) 0 - 1) / size
+      && offset >= 0
+      && (size_t) offset < file_map_size - archive_file_offset)
+    {
+      size_t start = archive_file_offset + offset;
+      size_t len = size * nmemb;
+
+      /* get_data always leaves a NUL after the data it reads, which
+	 the string table readers rely upon.  Only hand out the mapping
+	 when the data is terminated in the same way.  */
+      if (len < file_map_size - start
+	  && (file_map[start + len - 1] == '\0'
+	      || file_map[start + len] == '\0'))
+	return file_map + start;
+    }
+#endif
+
+  return get_data (NULL, file, offset, size, nmemb, reason);
+}
+
+/* Release DATA obtained from get_mapped_data.  */
+
+static void
+release_data (void * data)
+{
+  unsigned char * p = (unsigned char *) data;
+
+  if (p >= file_map && p < file_map + file_map_size)
+    return;
+  free (data);
+}
+
 /* Print a VMA value.  */
 
 static int
@@ -693,8 +749,8 @@ slurp_rela_relocs (FILE * file,
     {
       Elf32_External_Rela * erelas;
 
-      erelas = (Elf32_External_Rela *) get_data (NULL, file, rel_offset, 1,
-                                                 rel_size, _("32-bit relocation data"));
+      erelas = (Elf32_External_Rela *) get_mapped_data (file, rel_offset, 1,
+                                                        rel_size, _("32-bit relocation data"));
       if (!erelas)
 	return 0;
 
@@ -705,7 +761,7 @@ slurp_rela_relocs (FILE * file,
 
       if (relas == NULL)
 	{
-	  free (erelas);
+	  release_data (erelas);
 	  error (_("out of memory parsing relocs\n"));
 	  return 0;
 	}
@@ -717,14 +773,14 @@ slurp_rela_relocs (FILE * file,
 	  relas[i].r_addend = BYTE_GET_SIGNED (erelas[i].r_addend);
 	}
 
-      free (erelas);
+      release_data (erelas);
     }
   else
     {
       Elf64_External_Rela * erelas;
 
-      erelas = (Elf64_External_Rela *) get_data (NULL, file, rel_offset, 1,
-                                                 rel_size, _("64-bit relocation data"));
+      erelas = (Elf64_External_Rela *) get_mapped_data (file, rel_offset, 1,
+                                                        rel_size, _("64-bit relocation data"));
       if (!erelas)
 	return 0;
 
@@ -735,7 +791,7 @@ slurp_rela_relocs (FILE * file,
 
       if (relas == NULL)
 	{
-	  free (erelas);
+	  release_data (erelas);
 	  error (_("out of memory parsing relocs\n"));
 	  return 0;
 	}
@@ -769,7 +825,7 @@ slurp_rela_relocs (FILE * file,
 #endif /* BFD64 */
 	}
 
-      free (erelas);
+      release_data (erelas);
     }
   *relasp = relas;
   *nrelasp = nrelas;
@@ -791,8 +847,8 @@ slurp_rel_relocs (FILE * file,
     {
       Elf32_External_Rel * erels;
 
-      erels = (Elf32_External_Rel *) get_data (NULL, file, rel_offset, 1,
-                                               rel_size, _("32-bit relocation data"));
+      erels = (Elf32_External_Rel *) get_mapped_data (file, rel_offset, 1,
+                                                      rel_size, _("32-bit relocation data"));
       if (!erels)
 	return 0;
 
@@ -802,7 +858,7 @@ slurp_rel_relocs (FILE * file,
 
       if (rels == NULL)
 	{
-	  free (erels);
+	  release_data (erels);
 	  error (_("out of memory parsing relocs\n"));
 	  return 0;
 	}
@@ -814,14 +870,14 @@ slurp_rel_relocs (FILE * file,
 	  rels[i].r_addend = 0;
 	}
 
-      free (erels);
+      release_data (erels);
     }
   else
     {
       Elf64_External_Rel * erels;
 
-      erels = (Elf64_External_Rel *) get_data (NULL, file, rel_offset, 1,
-                                               rel_size, _("64-bit relocation data"));
+      erels = (Elf64_External_Rel *) get_mapped_data (file, rel_offset, 1,
+                                                      rel_size, _("64-bit relocation data"));
       if (!erels)
 	return 0;
 
@@ -831,7 +887,7 @@ slurp_rel_relocs (FILE * file,
 
       if (rels == NULL)
 	{
-	  free (erels);
+	  release_data (erels);
 	  error (_("out of memory parsing relocs\n"));
 	  return 0;
 	}
@@ -865,7 +921,7 @@ slurp_rel_relocs (FILE * file,
 #endif /* BFD64 */
 	}
 
-      free (erels);
+      release_data (erels);
     }
   *relsp = rels;
   *nrelsp = nrels;
@@ -4365,8 +4421,9 @@ get_32bit_elf_symbols (FILE * file,
       goto exit_point;
     }
 
-  esyms = (Elf32_External_Sym *) get_data (NULL, file, section->sh_offset, 1,
-                                           section->sh_size, _("symbols"));
+  esyms = (Elf32_External_Sym *) get_mapped_data (file, section->sh_offset, 1,
+                                                  section->sh_size,
+                                                  _("symbols"));
   if (esyms == NULL)
     goto exit_point;
 
@@ -4375,10 +4432,10 @@ get_32bit_elf_symbols (FILE * file,
       && (symtab_shndx_hdr->sh_link
 	  == (unsigned long) (section - section_headers)))
     {
-      shndx = (Elf_External_Sym_Shndx *) get_data (NULL, file,
-                                                   symtab_shndx_hdr->sh_offset,
-                                                   1, symtab_shndx_hdr->sh_size,
-                                                   _("symbol table section indicies"));
+      shndx = (Elf_External_Sym_Shndx *)
+	get_mapped_data (file, symtab_shndx_hdr->sh_offset, 1,
+			 symtab_shndx_hdr->sh_size,
+			 _("symbol table section indicies"));
       if (shndx == NULL)
 	goto exit_point;
     }
@@ -4408,9 +4465,9 @@ get_32bit_elf_symbols (FILE * file,
 
  exit_point:
   if (shndx != NULL)
-    free (shndx);
+    release_data (shndx);
   if (esyms != NULL)
-    free (esyms);
+    release_data (esyms);
 
   if (num_syms_return != NULL)
     * num_syms_return = isyms == NULL ? 0 : number;
@@ -4445,8 +4502,9 @@ get_64bit_elf_symbols (FILE * file,
       goto exit_point;
     }
 
-  esyms = (Elf64_External_Sym *) get_data (NULL, file, section->sh_offset, 1,
-                                           section->sh_size, _("symbols"));
+  esyms = (Elf64_External_Sym *) get_mapped_data (file, section->sh_offset, 1,
+                                                  section->sh_size,
+                                                  _("symbols"));
   if (!esyms)
     goto exit_point;
 
@@ -4454,10 +4512,10 @@ get_64bit_elf_symbols (FILE * file,
       && (symtab_shndx_hdr->sh_link
 	  == (unsigned long) (section - section_headers)))
     {
-      shndx = (Elf_External_Sym_Shndx *) get_data (NULL, file,
-                                                   symtab_shndx_hdr->sh_offset,
-                                                   1, symtab_shndx_hdr->sh_size,
-                                                   _("symbol table section indicies"));
+      shndx = (Elf_External_Sym_Shndx *)
+	get_mapped_data (file, symtab_shndx_hdr->sh_offset, 1,
+			 symtab_shndx_hdr->sh_size,
+			 _("symbol table section indicies"));
       if (shndx == NULL)
 	goto exit_point;
     }
@@ -4489,9 +4547,9 @@ get_64bit_elf_symbols (FILE * file,
 
  exit_point:
   if (shndx != NULL)
-    free (shndx);
+    release_data (shndx);
   if (esyms != NULL)
-    free (esyms);
+    release_data (esyms);
 
   if (num_syms_return != NULL)
     * num_syms_return = isyms == NULL ? 0 : number;
@@ -11008,7 +11066,7 @@ uncompress_section_contents (unsigned char **buffer ATTRIBUTE_UNUSED,
       || strm.avail_out != 0)
     goto fail;
 
-  free (compressed_buffer);
+  release_data (compressed_buffer);
   *buffer = uncompressed_buffer;
   *size = uncompressed_size;
   return 1;
@@ -11034,9 +11092,9 @@ load_specific_debug_section (enum dwarf_section_display_enum debug,
 
   snprintf (buf, sizeof (buf), _("%s section data"), section->name);
   section->address = sec->sh_addr;
-  section->start = (unsigned char *) get_data (NULL, (FILE *) file,
-                                               sec->sh_offset, 1,
-                                               sec->sh_size, buf);
+  section->start = (unsigned char *) get_mapped_data ((FILE *) file,
+						      sec->sh_offset, 1,
+						      sec->sh_size, buf);
   if (section->start == NULL)
     section->size = 0;
   else
@@ -11095,7 +11153,7 @@ free_debug_section (enum dwarf_section_display_enum debug)
   if (section->start == NULL)
     return;
 
-  free ((char *) section->start);
+  release_data (section->start);
   section->start = NULL;
   section->address = 0;
   section->size = 0;
@@ -14346,6 +14404,25 @@ process_file (char * file_name)
       return 1;
     }
 
+#ifdef USE_MMAP
+  /* Map the whole file so that large tables and debug sections can be
+     used in place rather than copied.  If this fails we simply fall
+     back to reading everything with fread.  */
+  if (statbuf.st_size > 0
+      && (off_t) (size_t) statbuf.st_size == statbuf.st_size)
+    {
+      void * map = mmap (NULL, statbuf.st_size, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE, fileno (file), 0);
+
+      if (map != MAP_FAILED)
+	{
+	  file_map = (unsigned char *) map;
+	  file_map_size = statbuf.st_size;
+	  file_map_stream = file;
+	}
+    }
+#endif
+
   if (fread (armag, SARMAG, 1, file) != 1)
     {
       error (_("%s: Failed to read file's magic number\n"), file_name);
@@ -14368,6 +14445,14 @@ process_file (char * file_name)
       ret = process_object (file_name, file);
     }
 
+#ifdef USE_MMAP
+  if (file_map != NULL)
+    munmap (file_map, file_map_size);
+#endif
+  file_map = NULL;
+  file_map_size = 0;
+  file_map_stream = NULL;
+
   fclose (file);
 
   return ret;
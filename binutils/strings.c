@@ -104,6 +104,13 @@ static char *target;
 static char encoding;
 static int encoding_bytes;
 
+/* Nonzero for each byte value that STRING_ISGRAPHIC accepts in the
+   selected encoding.  */
+static unsigned char graphic_table[256];
+
+/* The size of the blocks that print_strings reads from a stream.  */
+#define STRINGS_BLOCK_SIZE (64 * 1024)
+
 static struct option long_options[] =
 {
   {"all", no_argument, NULL, 'a'},
@@ -131,7 +138,8 @@ static bfd_boolean strings_object_file (const char *);
 static bfd_boolean strings_file (char *file);
 static void print_strings (const char *, FILE *, file_ptr, int, int, char *);
 static void usage (FILE *, int);
-static long get_char (FILE *, file_ptr *, int *, char **);
+static long decode_char (const unsigned char *);
+static void print_string_start (const char *, file_ptr, const char *, int);
 
 int main (int, char **);
 
@@ -143,6 +151,7 @@ main (int argc, char **argv)
   bfd_boolean files_given = FALSE;
   char *s;
   int numeric_opt = 0;
+  int i;
 
 #if defined (HAVE_SETLOCALE)
   setlocale (LC_ALL, "");
@@ -264,6 +273,9 @@ main (int argc, char **argv)
       usage (stderr, 1);
     }
 
+  for (i = 0; i < 256; i++)
+    graphic_table[i] = STRING_ISGRAPHIC (i);
+
   bfd_init ();
   set_default_bfd_target ();
 
@@ -441,192 +453,235 @@ strings_file (char *file)
   return TRUE;
 }
 
-/* Read the next character, return EOF if none available.
-   Assume that STREAM is positioned so that the next byte read
-   is at address ADDRESS in the file.
-
-   If STREAM is NULL, do not read from it.
-   The caller can supply a buffer of characters
-   to be processed before the data in STREAM.
-   MAGIC is the address of the buffer and
-   MAGICCOUNT is how many characters are in it.  */
+/* Return the character encoded by the ENCODING_BYTES bytes at P.  */
 
 static long
-get_char (FILE *stream, file_ptr *address, int *magiccount, char **magic)
+decode_char (const unsigned char *p)
 {
-  int c, i;
-  long r = 0;
-
-  for (i = 0; i < encoding_bytes; i++)
-    {
-      if (*magiccount)
-	{
-	  (*magiccount)--;
-	  c = *(*magic)++;
-	}
-      else
-	{
-	  if (stream == NULL)
-	    return EOF;
-
-	  /* Only use getc_unlocked if we found a declaration for it.
-	     Otherwise, libc is not thread safe by default, and we
-	     should not use it.  */
-
-#if defined(HAVE_GETC_UNLOCKED) && HAVE_DECL_GETC_UNLOCKED
-	  c = getc_unlocked (stream);
-#else
-	  c = getc (stream);
-#endif
-	  if (c == EOF)
-	    return EOF;
-	}
-
-      (*address)++;
-      r = (r << 8) | (c & 0xff);
-    }
-
   switch (encoding)
     {
     default:
-      break;
+      return p[0];
+    case 'b':
+      return (p[0] << 8) | p[1];
     case 'l':
-      r = ((r & 0xff) << 8) | ((r & 0xff00) >> 8);
-      break;
+      return (p[1] << 8) | p[0];
+    case 'B':
+      return (((long) p[0] << 24) | ((long) p[1] << 16)
+	      | ((long) p[2] << 8) | (long) p[3]);
     case 'L':
-      r = (((r & 0xff) << 24) | ((r & 0xff00) << 8)
-	   | ((r & 0xff0000) >> 8) | ((r & 0xff000000) >> 24));
-      break;
+      return (((long) p[3] << 24) | ((long) p[2] << 16)
+	      | ((long) p[1] << 8) | (long) p[0]);
     }
-
-  return r;
 }
-
-/* Find the strings in file FILENAME, read from STREAM.
-   Assume that STREAM is positioned so that the next byte read
-   is at address ADDRESS in the file.
-   Stop reading at address STOP_POINT in the file, if nonzero.
 
-   If STREAM is NULL, do not read from it.
-   The caller can supply a buffer of characters
-   to be processed before the data in STREAM.
-   MAGIC is the address of the buffer and
-   MAGICCOUNT is how many characters are in it.
-   Those characters come at address ADDRESS and the data in STREAM follow.  */
+/* Print the start of a string found at address START in FILENAME,
+   before its first COUNT characters, which are in BUF.  */
 
 static void
-print_strings (const char *filename, FILE *stream, file_ptr address,
-	       int stop_point, int magiccount, char *magic)
+print_string_start (const char *filename, file_ptr start,
+		    const char *buf, int count)
 {
-  char *buf = (char *) xmalloc (sizeof (char) * (string_min + 1));
-
-  while (1)
-    {
-      file_ptr start;
-      int i;
-      long c;
-
-      /* See if the next `string_min' chars are all graphic chars.  */
-    tryline:
-      if (stop_point && address >= stop_point)
-	break;
-      start = address;
-      for (i = 0; i < string_min; i++)
-	{
-	  c = get_char (stream, &address, &magiccount, &magic);
-	  if (c == EOF)
-	    {
-	      free (buf);
-	      return;
-	    }
-	  if (! STRING_ISGRAPHIC (c))
-	    /* Found a non-graphic.  Try again starting with next char.  */
-	    goto tryline;
-	  buf[i] = c;
-	}
-
-      /* We found a run of `string_min' graphic characters.  Print up
-	 to the next non-graphic character.  */
-
-      if (print_filenames)
-	printf ("%s: ", filename);
-      if (print_addresses)
-	switch (address_radix)
-	  {
-	  case 8:
+  if (print_filenames)
+    printf ("%s: ", filename);
+  if (print_addresses)
+    switch (address_radix)
+      {
+      case 8:
 #if __STDC_VERSION__ >= 199901L || (defined(__GNUC__) && __GNUC__ >= 2)
-	    if (sizeof (start) > sizeof (long))
-	      {
+	if (sizeof (start) > sizeof (long))
+	  {
 #ifndef __MSVCRT__
-	        printf ("%7llo ", (unsigned long long) start);
+	    printf ("%7llo ", (unsigned long long) start);
 #else
-	        printf ("%7I64o ", (unsigned long long) start);
+	    printf ("%7I64o ", (unsigned long long) start);
 #endif
-	      }
-	    else
+	  }
+	else
 #elif !BFD_HOST_64BIT_LONG
-	    if (start != (unsigned long) start)
-	      printf ("++%7lo ", (unsigned long) start);
-	    else
+	if (start != (unsigned long) start)
+	  printf ("++%7lo ", (unsigned long) start);
+	else
 #endif
-	      printf ("%7lo ", (unsigned long) start);
-	    break;
+	  printf ("%7lo ", (unsigned long) start);
+	break;
 
-	  case 10:
+      case 10:
 #if __STDC_VERSION__ >= 199901L || (defined(__GNUC__) && __GNUC__ >= 2)
-	    if (sizeof (start) > sizeof (long))
-	      {
+	if (sizeof (start) > sizeof (long))
+	  {
 #ifndef __MSVCRT__
-	        printf ("%7lld ", (unsigned long long) start);
+	    printf ("%7lld ", (unsigned long long) start);
 #else
-	        printf ("%7I64d ", (unsigned long long) start);
+	    printf ("%7I64d ", (unsigned long long) start);
 #endif
-	      }
-	    else
+	  }
+	else
 #elif !BFD_HOST_64BIT_LONG
-	    if (start != (unsigned long) start)
-	      printf ("++%7ld ", (unsigned long) start);
-	    else
+	if (start != (unsigned long) start)
+	  printf ("++%7ld ", (unsigned long) start);
+	else
 #endif
-	      printf ("%7ld ", (long) start);
-	    break;
+	  printf ("%7ld ", (long) start);
+	break;
 
-	  case 16:
+      case 16:
 #if __STDC_VERSION__ >= 199901L || (defined(__GNUC__) && __GNUC__ >= 2)
-	    if (sizeof (start) > sizeof (long))
-	      {
+	if (sizeof (start) > sizeof (long))
+	  {
 #ifndef __MSVCRT__
-	        printf ("%7llx ", (unsigned long long) start);
+	    printf ("%7llx ", (unsigned long long) start);
 #else
-	        printf ("%7I64x ", (unsigned long long) start);
+	    printf ("%7I64x ", (unsigned long long) start);
 #endif
-	      }
-	    else
+	  }
+	else
 #elif !BFD_HOST_64BIT_LONG
-	    if (start != (unsigned long) start)
-	      printf ("%lx%8.8lx ", (unsigned long) (start >> 32),
-		      (unsigned long) (start & 0xffffffff));
-	    else
+	if (start != (unsigned long) start)
+	  printf ("%lx%8.8lx ", (unsigned long) (start >> 32),
+		  (unsigned long) (start & 0xffffffff));
+	else
 #endif
-	      printf ("%7lx ", (unsigned long) start);
-	    break;
-	  }
+	  printf ("%7lx ", (unsigned long) start);
+	break;
+      }
+
+  fwrite (buf, 1, count, stdout);
+}
+
+/* Find the strings in file FILENAME, read from STREAM.
+   Assume that STREAM is positioned so that the next byte read
+   is at address ADDRESS in the file.
+   Stop reading at address STOP_POINT in the file, if nonzero.
+
+   If STREAM is NULL, do not read from it.
+   The caller can supply a buffer of characters
+   to be processed before the data in STREAM.
+   MAGIC is the address of the buffer and
+   MAGICCOUNT is how many characters are in it.
+   Those characters come at address ADDRESS and the data in STREAM follow.
+
+   The data is scanned a block at a time rather than a character at
+   a time.  For the single byte encodings each byte is classified
+   with graphic_table, and the tail of a string is written out as
+   one run rather than character by character.  */
 
-      buf[i] = '\0';
-      fputs (buf, stdout);
+static void
+print_strings (const char *filename, FILE *stream, file_ptr address,
+	       int stop_point, int magiccount, char *magic)
+{
+  char *buf = (char *) xmalloc (sizeof (char) * (string_min + 1));
+  unsigned char *block = NULL;
+  const unsigned char *p = (const unsigned char *) magic;
+  const unsigned char *end = p + magiccount;
+  file_ptr start = address;
+  /* The number of graphic characters seen in the current run.  */
+  int run = 0;
+  /* TRUE once the current run has been found to be long enough and
+     has started to be printed.  */
+  bfd_boolean printing = FALSE;
+
+  if (stream != NULL)
+    block = (unsigned char *) xmalloc (STRINGS_BLOCK_SIZE);
 
-      while (1)
+  while (1)
+    {
+      if (end - p < encoding_bytes)
 	{
-	  c = get_char (stream, &address, &magiccount, &magic);
-	  if (c == EOF)
+	  /* Refill the block, carrying over the bytes of any character
+	     split across the end of the previous one.  */
+	  size_t left = end - p;
+	  size_t got;
+
+	  if (stream == NULL)
 	    break;
-	  if (! STRING_ISGRAPHIC (c))
+	  memmove (block, p, left);
+	  got = fread (block + left, 1, STRINGS_BLOCK_SIZE - left, stream);
+	  if (got == 0)
 	    break;
-	  putchar (c);
+	  p = block;
+	  end = block + left + got;
+	  continue;
+	}
+
+      if (!printing)
+	{
+	  /* See if the next `string_min' chars are all graphic chars.  */
+	  while (run < string_min && end - p >= encoding_bytes)
+	    {
+	      long c;
+
+	      if (run == 0)
+		{
+		  if (stop_point && address >= stop_point)
+		    goto done;
+		  start = address;
+		}
+	      if (encoding_bytes == 1)
+		c = *p;
+	      else
+		c = decode_char (p);
+	      p += encoding_bytes;
+	      address += encoding_bytes;
+	      if (c >= 0 && c <= 255 && graphic_table[c])
+		buf[run++] = c;
+	      else
+		/* Found a non-graphic.  Try again starting with next char.  */
+		run = 0;
+	    }
+	  if (run < string_min)
+	    continue;
+
+	  /* We found a run of `string_min' graphic characters.  Print up
+	     to the next non-graphic character.  */
+	  print_string_start (filename, start, buf, run);
+	  printing = TRUE;
+	}
+
+      if (encoding_bytes == 1)
+	{
+	  const unsigned char *q = p;
+
+	  while (q < end && graphic_table[*q])
+	    q++;
+	  fwrite (p, 1, q - p, stdout);
+	  address += q - p;
+	  p = q;
+	  if (p == end)
+	    continue;
+	  p++;
+	  address++;
+	}
+      else
+	{
+	  bfd_boolean ended = FALSE;
+
+	  while (end - p >= encoding_bytes)
+	    {
+	      long c = decode_char (p);
+
+	      p += encoding_bytes;
+	      address += encoding_bytes;
+	      if (c < 0 || c > 255 || !graphic_table[c])
+		{
+		  ended = TRUE;
+		  break;
+		}
+	      putchar (c);
+	    }
+	  if (!ended)
+	    continue;
 	}
 
       putchar ('\n');
+      printing = FALSE;
+      run = 0;
     }
+
+ done:
+  if (printing)
+    putchar ('\n');
+  free (block);
   free (buf);
 }
 
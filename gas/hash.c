@@ -27,22 +27,23 @@
    are stored in the hash table.  Instead, it always stores a pointer.
    The assembler uses the hash table mostly to store symbols, and we
    don't need to confuse the symbol structure with a hash table
-   structure.  */
+   structure.
+
+   The table uses open addressing with linear probing, and doubles in
+   size when it becomes three quarters full, so a table created small
+   can still hold millions of symbols without long probe sequences.
+   The hash codes of the entries are kept in an array of their own,
+   parallel to the entries, so that a probe only looks at the string
+   of an entry whose full hash code matches.  */
 
 #include "as.h"
 #include "safe-ctype.h"
-#include "obstack.h"
 
 /* An entry in a hash table.  */
 
 struct hash_entry {
-  /* Next entry for this hash code.  */
-  struct hash_entry *next;
   /* String being hashed.  */
   const char *string;
-  /* Hash code.  This is the full hash code, not the index into the
-     table.  */
-  unsigned long hash;
   /* Pointer being stored in the hash table.  */
   void *data;
 };
@@ -50,14 +51,17 @@ struct hash_entry {
 /* A hash table.  */
 
 struct hash_control {
-  /* The hash array.  */
-  struct hash_entry **table;
-  /* The number of slots in the hash table.  */
+  /* The hash codes of the entries, or HASH_EMPTY or HASH_DELETED.  */
+  unsigned int *hashes;
+  /* The entries.  */
+  struct hash_entry *table;
+  /* The number of slots in the hash table, always a power of two.  */
   unsigned int size;
-  /* An obstack for this hash table.  */
-  struct obstack memory;
+  /* The number of live entries.  */
+  unsigned int count;
+  /* The number of slots holding deleted entries.  */
+  unsigned int deleted;
 
-#ifdef HASH_STATISTICS
   /* Statistics.  */
   unsigned long lookups;
   unsigned long hash_compares;
@@ -65,13 +69,20 @@ struct hash_control {
   unsigned long insertions;
   unsigned long replacements;
   unsigned long deletions;
-#endif /* HASH_STATISTICS */
+  unsigned long expansions;
 };
 
+/* The hash codes marking a slot that has never been used, and one
+   whose entry has been deleted.  */
+
+#define HASH_EMPTY 0
+#define HASH_DELETED 0xffffffff
+
 /* The default number of entries to use when creating a hash table.
    Note this value can be reduced to 4051 by using the command line
    switch --reduce-memory-overheads, or set to other values by using
-   the --hash-size=<NUMBER> switch.  */
+   the --hash-size=<NUMBER> switch.  The table starts with the largest
+   power of two no bigger than this, and grows as needed.  */
 
 static unsigned long gas_hash_table_size = 65537;
 
@@ -81,29 +92,41 @@ set_gas_hash_table_size (unsigned long size)
   gas_hash_table_size = bfd_hash_set_default_size (size);
 }
 
+/* Allocate SIZE empty slots for TABLE.  */
+
+static void
+hash_alloc_slots (struct hash_control *table, unsigned int size)
+{
+  table->hashes = (unsigned int *) xcalloc (size, sizeof (unsigned int));
+  table->table = (struct hash_entry *) xmalloc (size
+						* sizeof (struct hash_entry));
+  table->size = size;
+  table->count = 0;
+  table->deleted = 0;
+}
+
 /* Create a hash table.  This return a control block.  */
 
 struct hash_control *
 hash_new_sized (unsigned long size)
 {
-  unsigned long alloc;
+  unsigned int alloc;
   struct hash_control *ret;
 
+  alloc = 16;
+  while (alloc <= size / 2)
+    alloc *= 2;
+
   ret = (struct hash_control *) xmalloc (sizeof *ret);
-  obstack_begin (&ret->memory, chunksize);
-  alloc = size * sizeof (struct hash_entry *);
-  ret->table = (struct hash_entry **) obstack_alloc (&ret->memory, alloc);
-  memset (ret->table, 0, alloc);
-  ret->size = size;
+  hash_alloc_slots (ret, alloc);
 
-#ifdef HASH_STATISTICS
   ret->lookups = 0;
   ret->hash_compares = 0;
   ret->string_compares = 0;
   ret->insertions = 0;
   ret->replacements = 0;
   ret->deletions = 0;
-#endif
+  ret->expansions = 0;
 
   return ret;
 }
@@ -119,34 +142,20 @@ hash_new (void)
 void
 hash_die (struct hash_control *table)
 {
-  obstack_free (&table->memory, 0);
+  free (table->hashes);
+  free (table->table);
   free (table);
 }
 
-/* Look up a string in a hash table.  This returns a pointer to the
-   hash_entry, or NULL if the string is not in the table.  If PLIST is
-   not NULL, this sets *PLIST to point to the start of the list which
-   would hold this hash entry.  If PHASH is not NULL, this sets *PHASH
-   to the hash code for KEY.
-
-   Each time we look up a string, we move it to the start of the list
-   for its hash code, to take advantage of referential locality.  */
+/* Compute the hash code of KEY, which is LEN characters long.  The
+   code is never HASH_EMPTY or HASH_DELETED.  */
 
-static struct hash_entry *
-hash_lookup (struct hash_control *table, const char *key, size_t len,
-	     struct hash_entry ***plist, unsigned long *phash)
+static unsigned int
+hash_string (const char *key, size_t len)
 {
   unsigned long hash;
   size_t n;
   unsigned int c;
-  unsigned int hindex;
-  struct hash_entry **list;
-  struct hash_entry *p;
-  struct hash_entry *prev;
-
-#ifdef HASH_STATISTICS
-  ++table->lookups;
-#endif
 
   hash = 0;
   for (n = 0; n < len; n++)
@@ -158,45 +167,143 @@ hash_lookup (struct hash_control *table, const char *key, size_t len,
   hash += len + (len << 17);
   hash ^= hash >> 2;
 
+  /* Mix the high bits into the low ones, which pick the slot.  */
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3b;
+  hash ^= hash >> 16;
+
+  if ((unsigned int) hash == HASH_EMPTY
+      || (unsigned int) hash == HASH_DELETED)
+    return 1;
+  return hash;
+}
+
+/* Look up a string in a hash table.  This returns the index of the
+   slot holding KEY, or -1 if the string is not in the table.  If
+   PFREE is not NULL, this sets *PFREE to the slot in which KEY should
+   be inserted if it is not found.  If PHASH is not NULL, this sets
+   *PHASH to the hash code for KEY.  */
+
+static long
+hash_lookup (struct hash_control *table, const char *key, size_t len,
+	     unsigned int *pfree, unsigned int *phash)
+{
+  unsigned int hash;
+  unsigned int mask = table->size - 1;
+  unsigned int i;
+  long first_free = -1;
+
+  ++table->lookups;
+
+  hash = hash_string (key, len);
   if (phash != NULL)
     *phash = hash;
 
-  hindex = hash % table->size;
-  list = table->table + hindex;
+  for (i = hash & mask; ; i = (i + 1) & mask)
+    {
+      unsigned int h = table->hashes[i];
+      const char *s;
 
-  if (plist != NULL)
-    *plist = list;
+      if (h == HASH_EMPTY)
+	break;
 
-  prev = NULL;
-  for (p = *list; p != NULL; p = p->next)
-    {
-#ifdef HASH_STATISTICS
       ++table->hash_compares;
-#endif
 
-      if (p->hash == hash)
+      if (h != hash)
 	{
-#ifdef HASH_STATISTICS
-	  ++table->string_compares;
-#endif
-
-	  if (strncmp (p->string, key, len) == 0 && p->string[len] == '\0')
-	    {
-	      if (prev != NULL)
-		{
-		  prev->next = p->next;
-		  p->next = *list;
-		  *list = p;
-		}
-
-	      return p;
-	    }
+	  if (h == HASH_DELETED && first_free < 0)
+	    first_free = i;
+	  continue;
 	}
 
-      prev = p;
+      s = table->table[i].string;
+      ++table->string_compares;
+
+      if (strncmp (s, key, len) == 0 && s[len] == '\0')
+	return i;
     }
 
-  return NULL;
+  if (pfree != NULL)
+    *pfree = first_free >= 0 ? (unsigned int) first_free : i;
+
+  return -1;
+}
+
+/* Make room in TABLE for one more entry, rehashing it into a bigger
+   array if it is getting full.  Return TRUE if it was rehashed.  */
+
+static bfd_boolean
+hash_make_room (struct hash_control *table)
+{
+  unsigned int *old_hashes;
+  struct hash_entry *old_table;
+  unsigned int old_size;
+  unsigned int size;
+  unsigned int i;
+
+  if ((table->count + table->deleted + 1) * 4 <= table->size * 3)
+    return FALSE;
+
+  old_hashes = table->hashes;
+  old_table = table->table;
+  old_size = table->size;
+
+  /* If most of the used slots just hold deleted entries, rehashing at
+     the same size is enough to clear them out.  */
+  size = old_size;
+  if ((table->count + 1) * 2 > old_size)
+    size *= 2;
+
+  hash_alloc_slots (table, size);
+  if (size != old_size)
+    ++table->expansions;
+
+  for (i = 0; i < old_size; i++)
+    if (old_hashes[i] != HASH_EMPTY && old_hashes[i] != HASH_DELETED)
+      {
+	unsigned int mask = size - 1;
+	unsigned int j;
+
+	for (j = old_hashes[i] & mask;
+	     table->hashes[j] != HASH_EMPTY;
+	     j = (j + 1) & mask)
+	  ;
+	table->hashes[j] = old_hashes[i];
+	table->table[j] = old_table[i];
+	++table->count;
+      }
+
+  free (old_hashes);
+  free (old_table);
+  return TRUE;
+}
+
+/* Add KEY with value VAL to TABLE, in slot SLOT found for it by
+   hash_lookup with hash code HASH.  */
+
+static void
+hash_add (struct hash_control *table, unsigned int slot, unsigned int hash,
+	  const char *key, void *val)
+{
+  if (hash_make_room (table))
+    {
+      unsigned int mask = table->size - 1;
+
+      for (slot = hash & mask;
+	   table->hashes[slot] != HASH_EMPTY;
+	   slot = (slot + 1) & mask)
+	;
+    }
+  else if (table->hashes[slot] == HASH_DELETED)
+    /* Reusing the slot of a deleted entry.  */
+    --table->deleted;
+
+  ++table->insertions;
+
+  table->hashes[slot] = hash;
+  table->table[slot].string = key;
+  table->table[slot].data = val;
+  ++table->count;
 }
 
 /* Insert an entry into a hash table.  This returns NULL on success.
@@ -207,25 +314,13 @@ hash_lookup (struct hash_control *table, const char *key, size_t len,
 const char *
 hash_insert (struct hash_control *table, const char *key, void *val)
 {
-  struct hash_entry *p;
-  struct hash_entry **list;
-  unsigned long hash;
+  unsigned int slot;
+  unsigned int hash;
 
-  p = hash_lookup (table, key, strlen (key), &list, &hash);
-  if (p != NULL)
+  if (hash_lookup (table, key, strlen (key), &slot, &hash) >= 0)
     return "exists";
 
-#ifdef HASH_STATISTICS
-  ++table->insertions;
-#endif
-
-  p = (struct hash_entry *) obstack_alloc (&table->memory, sizeof (*p));
-  p->string = key;
-  p->hash = hash;
-  p->data = val;
-
-  p->next = *list;
-  *list = p;
+  hash_add (table, slot, hash, key, val);
 
   return NULL;
 }
@@ -237,33 +332,19 @@ hash_insert (struct hash_control *table, const char *key, void *val)
 const char *
 hash_jam (struct hash_control *table, const char *key, void *val)
 {
-  struct hash_entry *p;
-  struct hash_entry **list;
-  unsigned long hash;
+  long i;
+  unsigned int slot;
+  unsigned int hash;
 
-  p = hash_lookup (table, key, strlen (key), &list, &hash);
-  if (p != NULL)
+  i = hash_lookup (table, key, strlen (key), &slot, &hash);
+  if (i >= 0)
     {
-#ifdef HASH_STATISTICS
       ++table->replacements;
-#endif
 
-      p->data = val;
+      table->table[i].data = val;
     }
   else
-    {
-#ifdef HASH_STATISTICS
-      ++table->insertions;
-#endif
-
-      p = (struct hash_entry *) obstack_alloc (&table->memory, sizeof (*p));
-      p->string = key;
-      p->hash = hash;
-      p->data = val;
-
-      p->next = *list;
-      *list = p;
-    }
+    hash_add (table, slot, hash, key, val);
 
   return NULL;
 }
@@ -275,20 +356,18 @@ hash_jam (struct hash_control *table, const char *key, void *val)
 void *
 hash_replace (struct hash_control *table, const char *key, void *value)
 {
-  struct hash_entry *p;
+  long i;
   void *ret;
 
-  p = hash_lookup (table, key, strlen (key), NULL, NULL);
-  if (p == NULL)
+  i = hash_lookup (table, key, strlen (key), NULL, NULL);
+  if (i < 0)
     return NULL;
 
-#ifdef HASH_STATISTICS
   ++table->replacements;
-#endif
 
-  ret = p->data;
+  ret = table->table[i].data;
 
-  p->data = value;
+  table->table[i].data = value;
 
   return ret;
 }
@@ -299,13 +378,13 @@ hash_replace (struct hash_control *table, const char *key, void *value)
 void *
 hash_find (struct hash_control *table, const char *key)
 {
-  struct hash_entry *p;
+  long i;
 
-  p = hash_lookup (table, key, strlen (key), NULL, NULL);
-  if (p == NULL)
+  i = hash_lookup (table, key, strlen (key), NULL, NULL);
+  if (i < 0)
     return NULL;
 
-  return p->data;
+  return table->table[i].data;
 }
 
 /* As hash_find, but KEY is of length LEN and is not guaranteed to be
@@ -314,45 +393,43 @@ hash_find (struct hash_control *table, const char *key)
 void *
 hash_find_n (struct hash_control *table, const char *key, size_t len)
 {
-  struct hash_entry *p;
+  long i;
 
-  p = hash_lookup (table, key, len, NULL, NULL);
-  if (p == NULL)
+  i = hash_lookup (table, key, len, NULL, NULL);
+  if (i < 0)
     return NULL;
 
-  return p->data;
+  return table->table[i].data;
 }
 
 /* Delete an entry from a hash table.  This returns the value stored
-   for that entry, or NULL if there is no such entry.  */
+   for that entry, or NULL if there is no such entry.  Entries are
+   not allocated one by one any more, so FREEME is ignored.  */
 
 void *
-hash_delete (struct hash_control *table, const char *key, int freeme)
+hash_delete (struct hash_control *table, const char *key,
+	     int freeme ATTRIBUTE_UNUSED)
 {
-  struct hash_entry *p;
-  struct hash_entry **list;
+  long i;
 
-  p = hash_lookup (table, key, strlen (key), &list, NULL);
-  if (p == NULL)
+  i = hash_lookup (table, key, strlen (key), NULL, NULL);
+  if (i < 0)
     return NULL;
 
-  if (p != *list)
-    abort ();
-
-#ifdef HASH_STATISTICS
   ++table->deletions;
-#endif
-
-  *list = p->next;
 
-  if (freeme)
-    obstack_free (&table->memory, p);
+  /* Don't mark the slot empty, so that probes for other keys carry
+     on past it.  */
+  table->hashes[i] = HASH_DELETED;
+  --table->count;
+  ++table->deleted;
 
-  return p->data;
+  return table->table[i].data;
 }
 
 /* Traverse a hash table.  Call the function on every entry in the
-   hash table.  */
+   hash table.  The function may delete entries, but must not add
+   any.  */
 
 void
 hash_traverse (struct hash_control *table,
@@ -361,27 +438,16 @@ hash_traverse (struct hash_control *table,
   unsigned int i;
 
   for (i = 0; i < table->size; ++i)
-    {
-      struct hash_entry *p;
-
-      for (p = table->table[i]; p != NULL; p = p->next)
-	(*pfn) (p->string, p->data);
-    }
+    if (table->hashes[i] != HASH_EMPTY && table->hashes[i] != HASH_DELETED)
+      (*pfn) (table->table[i].string, table->table[i].data);
 }
 
 /* Print hash table statistics on the specified file.  NAME is the
    name of the hash table, used for printing a header.  */
 
 void
-hash_print_statistics (FILE *f ATTRIBUTE_UNUSED,
-		       const char *name ATTRIBUTE_UNUSED,
-		       struct hash_control *table ATTRIBUTE_UNUSED)
+hash_print_statistics (FILE *f, const char *name, struct hash_control *table)
 {
-#ifdef HASH_STATISTICS
-  unsigned int i;
-  unsigned long total;
-  unsigned long empty;
-
   fprintf (f, "%s hash statistics:\n", name);
   fprintf (f, "\t%lu lookups\n", table->lookups);
   fprintf (f, "\t%lu hash comparisons\n", table->hash_compares);
@@ -389,27 +455,14 @@ hash_print_statistics (FILE *f ATTRIBUTE_UNUSED,
   fprintf (f, "\t%lu insertions\n", table->insertions);
   fprintf (f, "\t%lu replacements\n", table->replacements);
   fprintf (f, "\t%lu deletions\n", table->deletions);
-
-  total = 0;
-  empty = 0;
-  for (i = 0; i < table->size; ++i)
-    {
-      struct hash_entry *p;
-
-      if (table->table[i] == NULL)
-	++empty;
-      else
-	{
-	  for (p = table->table[i]; p != NULL; p = p->next)
-	    ++total;
-	}
-    }
-
-  fprintf (f, "\t%g average chain length\n", (double) total / table->size);
-  fprintf (f, "\t%lu empty slots\n", empty);
-#endif
+  fprintf (f, "\t%u entries in %u slots, %u deleted\n",
+	   table->count, table->size, table->deleted);
+  fprintf (f, "\t%lu expansions\n", table->expansions);
+  if (table->lookups != 0)
+    fprintf (f, "\t%g average probes per lookup\n",
+	     (double) table->hash_compares / table->lookups);
 }
-
+
 #ifdef TEST
 
 /* This test program is left over from the old hash table code.  */
@@ -1393,6 +1393,48 @@ compress_frag (struct z_stream_s *strm, const char *contents, int in_size,
   return total_out_size;
 }
 
+/* The size of the buffer in which compress_debug gathers the contents
+   of a section's frags, so that the compression engine is called once
+   per block rather than once per frag or per repetition of a fill.  */
+#define COMPRESS_BLOCK_SIZE (64 * 1024)
+
+/* Add IN_SIZE bytes at CONTENTS to the *USED bytes already gathered in
+   BLOCK, first passing the block through the compression engine if
+   there is no room left in it.  Contents too big for the block bypass
+   it.  Return the amount of compressed output produced, or -1 on
+   error.  */
+
+static int
+compress_buffered (struct z_stream_s *strm, const char *contents,
+		   int in_size, char *block, int *used,
+		   fragS **last_newf, struct obstack *ob)
+{
+  int out_size = 0;
+
+  if (*used + in_size > COMPRESS_BLOCK_SIZE)
+    {
+      if (*used > 0)
+	{
+	  out_size = compress_frag (strm, block, *used, last_newf, ob);
+	  if (out_size < 0)
+	    return -1;
+	  *used = 0;
+	}
+      if (in_size > COMPRESS_BLOCK_SIZE)
+	{
+	  int big_size = compress_frag (strm, contents, in_size,
+					last_newf, ob);
+	  if (big_size < 0)
+	    return -1;
+	  return out_size + big_size;
+	}
+    }
+
+  memcpy (block + *used, contents, in_size);
+  *used += in_size;
+  return out_size;
+}
+
 static void
 compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
 {
@@ -1409,6 +1451,8 @@ compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
   struct z_stream_s *strm;
   int x;
   flagword flags = bfd_get_section_flags (abfd, sec);
+  char *block;
+  int used;
 
   if (seginfo == NULL
       || sec->size < 32
@@ -1447,6 +1491,8 @@ compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
 
   /* Stream the frags through the compression engine, adding new frags
      as necessary to accomodate the compressed output.  */
+  block = (char *) xmalloc (COMPRESS_BLOCK_SIZE);
+  used = 0;
   for (f = seginfo->frchainP->frch_root;
        f;
        f = f->fr_next)
@@ -1459,10 +1505,13 @@ compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
       gas_assert (f->fr_type == rs_fill);
       if (f->fr_fix)
 	{
-	  out_size = compress_frag (strm, f->fr_literal, f->fr_fix,
-				    &last_newf, ob);
+	  out_size = compress_buffered (strm, f->fr_literal, f->fr_fix,
+					block, &used, &last_newf, ob);
 	  if (out_size < 0)
-	    return;
+	    {
+	      free (block);
+	      return;
+	    }
 	  compressed_size += out_size;
 	}
       fill_literal = f->fr_literal + f->fr_fix;
@@ -1473,15 +1522,32 @@ compress_debug (bfd *abfd, asection *sec, void *xxx ATTRIBUTE_UNUSED)
 	{
 	  while (count--)
 	    {
-	      out_size = compress_frag (strm, fill_literal, (int) fill_size,
-				        &last_newf, ob);
+	      out_size = compress_buffered (strm, fill_literal,
+					    (int) fill_size, block, &used,
+					    &last_newf, ob);
 	      if (out_size < 0)
-		return;
+		{
+		  free (block);
+		  return;
+		}
 	      compressed_size += out_size;
 	    }
 	}
     }
 
+  if (used > 0)
+    {
+      int out_size = compress_frag (strm, block, used, &last_newf, ob);
+
+      if (out_size < 0)
+	{
+	  free (block);
+	  return;
+	}
+      compressed_size += out_size;
+    }
+  free (block);
+
   /* Flush the compression state.  */
   for (;;)
     {
@@ -2197,6 +2263,15 @@ relax_frag (segT segment, fragS *fragP, long stretch)
   start_type = this_type = table + this_state;
   symbolP = fragP->fr_symbol;
 
+#ifndef md_prepare_relax_scan
+  /* A frag that has reached a state with nowhere further to go cannot
+     grow, whatever its target.  Once a big function's branches have
+     mostly relaxed to their long forms, this saves looking up every
+     one of their targets again on each remaining pass.  */
+  if (this_type->rlx_more == 0)
+    return 0;
+#endif
+
   if (symbolP)
     {
       fragS *sym_frag;
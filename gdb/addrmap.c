@@ -105,15 +105,23 @@ struct addrmap_fixed
 {
   struct addrmap addrmap;
 
-  /* The number of transitions in TRANSITIONS.  */
+  /* The number of transitions in the map.  */
   size_t num_transitions;
 
-  /* An array of transitions, sorted by address.  For every point in
-     the map where either ADDR == 0 or ADDR is mapped to one value and
-     ADDR - 1 is mapped to something different, we have an entry here
+  /* The transitions' addresses and values.  For every point in the
+     map where either ADDR == 0 or ADDR is mapped to one value and
+     ADDR - 1 is mapped to something different, we have an entry
      containing ADDR and VALUE.  (Note that this means we always have
-     an entry for address 0).  */
-  struct addrmap_transition transitions[1];
+     an entry for address 0).
+
+     Rather than being sorted by address, the entries are laid out as
+     an implicit binary search tree in breadth-first (Eytzinger)
+     order, indexed from 1: the children of entry K are entries 2K and
+     2K + 1.  This way the first steps of every search touch the same
+     few cache lines, and keeping the addresses apart from the values
+     packs twice as many of them into each line.  */
+  CORE_ADDR *addrs;
+  void **values;
 };
 
 
@@ -132,32 +140,27 @@ static void *
 addrmap_fixed_find (struct addrmap *this, CORE_ADDR addr)
 {
   struct addrmap_fixed *map = (struct addrmap_fixed *) this;
-  struct addrmap_transition *bottom = &map->transitions[0];
-  struct addrmap_transition *top = &map->transitions[map->num_transitions - 1];
+  size_t k = 1;
 
-  while (bottom < top)
-    {
-      /* This needs to round towards top, or else when top = bottom +
-         1 (i.e., two entries are under consideration), then mid ==
-         bottom, and then we may not narrow the range when (mid->addr
-         < addr).  */
-      struct addrmap_transition *mid = top - (top - bottom) / 2;
-
-      if (mid->addr == addr)
-        {
-          bottom = mid;
-          break;
-        }
-      else if (mid->addr < addr)
-        /* We don't eliminate mid itself here, since each transition
-           covers all subsequent addresses until the next.  This is why
-           we must round up in computing the midpoint.  */
-        bottom = mid;
-      else
-        top = mid - 1;
-    }
+  /* Descend to a leaf, going right whenever the entry is at or below
+     ADDR.  */
+  while (k <= map->num_transitions)
+    k = 2 * k + (map->addrs[k] <= addr);
+
+  /* The entry we want is the last one where we went right: undo the
+     left turns after it, and then it.  */
+  while ((k & 1) == 0)
+    k >>= 1;
+  k >>= 1;
+
+  /* There is none if ADDR is below every entry, which can happen once
+     the map has been relocated away from address 0.  Use the lowest
+     entry then, the leftmost one in the tree.  */
+  if (k == 0)
+    for (k = 1; 2 * k <= map->num_transitions; k *= 2)
+      ;
 
-  return bottom->value;
+  return map->values[k];
 }
 
 
@@ -176,8 +179,33 @@ addrmap_fixed_relocate (struct addrmap *this, CORE_ADDR offset)
   struct addrmap_fixed *map = (struct addrmap_fixed *) this;
   size_t i;
 
-  for (i = 0; i < map->num_transitions; i++)
-    map->transitions[i].addr += offset;
+  for (i = 1; i <= map->num_transitions; i++)
+    map->addrs[i] += offset;
+}
+
+
+/* Call FN with DATA on the entries of the subtree of MAP rooted at
+   entry K, in order of increasing address.  Stop and return FN's
+   result as soon as it is non-zero.  */
+
+static int
+addrmap_fixed_foreach_1 (struct addrmap_fixed *map, size_t k,
+			 addrmap_foreach_fn fn, void *data)
+{
+  int res;
+
+  if (k > map->num_transitions)
+    return 0;
+
+  res = addrmap_fixed_foreach_1 (map, 2 * k, fn, data);
+  if (res != 0)
+    return res;
+
+  res = fn (data, map->addrs[k], map->values[k]);
+  if (res != 0)
+    return res;
+
+  return addrmap_fixed_foreach_1 (map, 2 * k + 1, fn, data);
 }
 
 
@@ -186,17 +214,8 @@ addrmap_fixed_foreach (struct addrmap *this, addrmap_foreach_fn fn,
 		       void *data)
 {
   struct addrmap_fixed *map = (struct addrmap_fixed *) this;
-  size_t i;
 
-  for (i = 0; i < map->num_transitions; i++)
-    {
-      int res = fn (data, map->transitions[i].addr, map->transitions[i].value);
-
-      if (res != 0)
-	return res;
-    }
-
-  return 0;
+  return addrmap_fixed_foreach_1 (map, 1, fn, data);
 }
 
 
@@ -410,28 +429,55 @@ splay_foreach_count (splay_tree_node n, void *closure)
 }
 
 
-/* A function to pass to splay_tree_foreach to copy entries into a
-   fixed address map.  */
+/* The state of splay_foreach_copy.  */
+struct addrmap_copy_data
+{
+  /* The transitions copied so far, sorted by address.  */
+  struct addrmap_transition *transitions;
+  size_t num_transitions;
+};
+
+/* A function to pass to splay_tree_foreach to copy entries into an
+   array of transitions.  */
 static int
 splay_foreach_copy (splay_tree_node n, void *closure)
 {
-  struct addrmap_fixed *fixed = (struct addrmap_fixed *) closure;
-  struct addrmap_transition *t = &fixed->transitions[fixed->num_transitions];
+  struct addrmap_copy_data *data = (struct addrmap_copy_data *) closure;
+  struct addrmap_transition *t = &data->transitions[data->num_transitions];
 
   t->addr = addrmap_node_key (n);
   t->value = addrmap_node_value (n);
-  fixed->num_transitions++;
+  data->num_transitions++;
 
   return 0;
 }
 
 
+/* Store the sorted transitions starting at *NEXT into the subtree of
+   FIXED rooted at entry K, advancing *NEXT past them.  */
+static void
+addrmap_fixed_fill (struct addrmap_fixed *fixed, size_t k,
+		    const struct addrmap_transition *sorted, size_t *next)
+{
+  if (k > fixed->num_transitions)
+    return;
+
+  addrmap_fixed_fill (fixed, 2 * k, sorted, next);
+  fixed->addrs[k] = sorted[*next].addr;
+  fixed->values[k] = sorted[*next].value;
+  ++*next;
+  addrmap_fixed_fill (fixed, 2 * k + 1, sorted, next);
+}
+
+
 static struct addrmap *
 addrmap_mutable_create_fixed (struct addrmap *this, struct obstack *obstack)
 {
   struct addrmap_mutable *mutable = (struct addrmap_mutable *) this;
   struct addrmap_fixed *fixed;
+  struct addrmap_copy_data data;
   size_t num_transitions;
+  size_t next = 0;
 
   /* Count the number of transitions in the tree.  */
   num_transitions = 0;
@@ -441,21 +487,29 @@ addrmap_mutable_create_fixed (struct addrmap *this, struct obstack *obstack)
      maps have, but mutable maps do not.)  */
   num_transitions++;
 
-  fixed = obstack_alloc (obstack,
-                         (sizeof (*fixed)
-                          + (num_transitions
-                             * sizeof (fixed->transitions[0]))));
-  fixed->addrmap.funcs = &addrmap_fixed_funcs;
-  fixed->num_transitions = 1;
-  fixed->transitions[0].addr = 0;
-  fixed->transitions[0].value = NULL;
+  data.transitions = XNEWVEC (struct addrmap_transition, num_transitions);
+  data.num_transitions = 1;
+  data.transitions[0].addr = 0;
+  data.transitions[0].value = NULL;
 
   /* Copy all entries from the splay tree to the array, in order 
      of increasing address.  */
-  splay_tree_foreach (mutable->tree, splay_foreach_copy, fixed);
+  splay_tree_foreach (mutable->tree, splay_foreach_copy, &data);
 
   /* We should have filled the array.  */
-  gdb_assert (fixed->num_transitions == num_transitions);
+  gdb_assert (data.num_transitions == num_transitions);
+
+  fixed = obstack_alloc (obstack, sizeof (*fixed));
+  fixed->addrmap.funcs = &addrmap_fixed_funcs;
+  fixed->num_transitions = num_transitions;
+  fixed->addrs = obstack_alloc (obstack, ((num_transitions + 1)
+					  * sizeof (fixed->addrs[0])));
+  fixed->values = obstack_alloc (obstack, ((num_transitions + 1)
+					   * sizeof (fixed->values[0])));
+  addrmap_fixed_fill (fixed, 1, data.transitions, &next);
+  gdb_assert (next == num_transitions);
+
+  xfree (data.transitions);
 
   return (struct addrmap *) fixed;
 }
@@ -30,6 +30,7 @@
 
 #include "gdb_assert.h"
 #include "gdb_string.h"
+#include "gdb_wait.h"
 #include "elf/common.h"
 #include <sys/uio.h>
 #include <sys/ptrace.h>
@@ -72,6 +73,16 @@ struct arch_lwp_info
 {
   /* Non-zero if our copy differs from what's recorded in the thread.  */
   int debug_registers_changed;
+
+  /* Non-zero if DR_WRITTEN and DR_CONTROL_WRITTEN below hold what the
+     thread's debug registers were last set to.  Only the registers
+     whose value differs need writing then.  */
+  int dr_written_p;
+
+  /* The debug address registers, and DR_CONTROL, as last written to
+     the thread.  */
+  CORE_ADDR dr_written[DR_NADDR];
+  unsigned long dr_control_written;
 };
 
 /* Does the current host support PTRACE_GETREGSET?  */
@@ -154,7 +165,14 @@ fill_fpregset (const struct regcache *regcache,
 
 /* Fetch register REGNUM from the child process.  If REGNUM is -1, do
    this for all registers (including the floating point and SSE
-   registers).  */
+   registers).
+
+   A general-purpose register only costs a PTRACE_GETREGS; the much
+   larger extended state is fetched only once some frame needs a
+   floating point or vector register.  Unwinding, as in "thread apply
+   all bt", thus takes one system call per thread.  There is no ptrace
+   request that reads the registers of several threads at once, so
+   fetching them ahead of time would not save anything.  */
 
 static void
 amd64_linux_fetch_inferior_registers (struct target_ops *ops,
@@ -400,6 +418,7 @@ amd64_linux_prepare_to_resume (struct lwp_info *lwp)
 
   if (lwp->arch_private->debug_registers_changed)
     {
+      struct arch_lwp_info *info = lwp->arch_private;
       struct i386_debug_reg_state *state
 	= i386_debug_reg_state (ptid_get_pid (lwp->ptid));
       int i;
@@ -412,9 +431,12 @@ amd64_linux_prepare_to_resume (struct lwp_info *lwp)
 	 Ensure DR_CONTROL gets written as the very last register here.  */
 
       for (i = DR_FIRSTADDR; i <= DR_LASTADDR; i++)
-	if (state->dr_ref_count[i] > 0)
+	if (state->dr_ref_count[i] > 0
+	    && (!info->dr_written_p
+		|| info->dr_written[i] != state->dr_mirror[i]))
 	  {
 	    amd64_linux_dr_set (lwp->ptid, i, state->dr_mirror[i]);
+	    info->dr_written[i] = state->dr_mirror[i];
 
 	    /* If we're setting a watchpoint, any change the inferior
 	       had done itself to the debug registers needs to be
@@ -423,9 +445,18 @@ amd64_linux_prepare_to_resume (struct lwp_info *lwp)
 	    clear_status = 1;
 	  }
 
-      amd64_linux_dr_set (lwp->ptid, DR_CONTROL, state->dr_control_mirror);
+      /* Watchpoints are removed and inserted again around every
+	 stop, usually ending up in the registers they were in, so
+	 often nothing needs writing at all.  */
+      if (!info->dr_written_p
+	  || info->dr_control_written != state->dr_control_mirror)
+	{
+	  amd64_linux_dr_set (lwp->ptid, DR_CONTROL, state->dr_control_mirror);
+	  info->dr_control_written = state->dr_control_mirror;
+	}
 
-      lwp->arch_private->debug_registers_changed = 0;
+      info->dr_written_p = 1;
+      info->debug_registers_changed = 0;
     }
 
   if (clear_status || lwp->stopped_by_watchpoint)
@@ -1163,6 +1194,71 @@ amd64_linux_teardown_btrace (struct btrace_target_info *tinfo)
   linux_disable_btrace (tinfo);
 }
 
+/* Make the stopped LWP LP call mprotect (ADDR, LEN, PROT), by
+   single-stepping a system call instruction written over the one at
+   its pc, and put everything back afterwards.  Return 0 if the call
+   succeeded.  */
+
+static int
+amd64_linux_inferior_mprotect (struct lwp_info *lp, CORE_ADDR addr,
+			       ULONGEST len, int prot)
+{
+  struct user_regs_struct regs, saved_regs;
+  int tid = ptid_get_lwp (lp->ptid);
+  long insn, saved_insn;
+  int status, ret = -1;
+
+  if (ptrace (PTRACE_GETREGS, tid, 0, (long) &saved_regs) < 0)
+    return -1;
+
+  errno = 0;
+  saved_insn = ptrace (PTRACE_PEEKTEXT, tid, saved_regs.rip, 0);
+  if (errno != 0)
+    return -1;
+
+  regs = saved_regs;
+
+  /* Make sure the kernel does not restart a system call the LWP was
+     stopped in instead of running ours.  */
+  regs.orig_rax = -1;
+
+  if (gdbarch_bfd_arch_info (target_gdbarch ())->bits_per_word == 32)
+    {
+      /* int $0x80, with the i386 system call number.  */
+      insn = (saved_insn & ~0xffffL) | 0x80cd;
+      regs.rax = 125;
+      regs.rbx = addr;
+      regs.rcx = len;
+      regs.rdx = prot;
+    }
+  else
+    {
+      /* syscall.  */
+      insn = (saved_insn & ~0xffffL) | 0x050f;
+      regs.rax = SYS_mprotect;
+      regs.rdi = addr;
+      regs.rsi = len;
+      regs.rdx = prot;
+    }
+
+  if (ptrace (PTRACE_POKETEXT, tid, saved_regs.rip, insn) == 0)
+    {
+      if (ptrace (PTRACE_SETREGS, tid, 0, (long) &regs) == 0)
+	{
+	  status = linux_nat_step_lwp (lp);
+	  if (WIFSTOPPED (status)
+	      && ptrace (PTRACE_GETREGS, tid, 0, (long) &regs) == 0
+	      && regs.rax == 0)
+	    ret = 0;
+	}
+
+      ptrace (PTRACE_POKETEXT, tid, saved_regs.rip, saved_insn);
+      ptrace (PTRACE_SETREGS, tid, 0, (long) &saved_regs);
+    }
+
+  return ret;
+}
+
 /* Provide a prototype to silence -Wmissing-prototypes.  */
 void _initialize_amd64_linux_nat (void);
 
@@ -1215,4 +1311,5 @@ _initialize_amd64_linux_nat (void)
   linux_nat_set_forget_process (t, i386_forget_process);
   linux_nat_set_siginfo_fixup (t, amd64_linux_siginfo_fixup);
   linux_nat_set_prepare_to_resume (t, amd64_linux_prepare_to_resume);
+  linux_nat_set_inferior_mprotect (t, amd64_linux_inferior_mprotect);
 }
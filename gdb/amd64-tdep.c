@@ -32,6 +32,7 @@
 #include "gdbcmd.h"
 #include "gdbcore.h"
 #include "objfiles.h"
+#include "prologue-cache.h"
 #include "regcache.h"
 #include "regset.h"
 #include "symfile.h"
@@ -2140,6 +2141,65 @@ amd64_analyze_prologue (struct gdbarch *gdbarch,
   return pc;
 }
 
+/* The parts of a `struct amd64_frame_cache' that a complete run of
+   amd64_analyze_prologue fills in, as recorded in the prologue
+   cache.  */
+
+struct amd64_prologue_info
+{
+  /* Offset of the end of the analyzed prologue from the function's
+     start address.  */
+  CORE_ADDR length;
+
+  CORE_ADDR sp_offset;
+  CORE_ADDR saved_rbp;
+  int saved_sp_reg;
+  int frameless_p;
+};
+
+/* Like amd64_analyze_prologue, but reuse an earlier analysis of the
+   function at PC if CURRENT_PC is past the end of its prologue.  CACHE
+   must have just been initialized by amd64_init_frame_cache.
+
+   Only analyses that were not cut short by CURRENT_PC are recorded;
+   those are exactly the ones that returned an address below
+   CURRENT_PC, and they give the same result for any CURRENT_PC past
+   that address.  */
+
+static CORE_ADDR
+amd64_analyze_prologue_cached (struct gdbarch *gdbarch,
+			       CORE_ADDR pc, CORE_ADDR current_pc,
+			       struct amd64_frame_cache *cache)
+{
+  const struct amd64_prologue_info *info;
+  struct amd64_prologue_info new_info;
+  CORE_ADDR end;
+
+  info = prologue_cache_lookup (gdbarch, pc, sizeof (*info));
+  if (info != NULL && current_pc > pc + info->length)
+    {
+      cache->sp_offset = info->sp_offset;
+      cache->saved_regs[AMD64_RBP_REGNUM] = info->saved_rbp;
+      cache->saved_sp_reg = info->saved_sp_reg;
+      cache->frameless_p = info->frameless_p;
+      return pc + info->length;
+    }
+
+  end = amd64_analyze_prologue (gdbarch, pc, current_pc, cache);
+
+  if (info == NULL && end < current_pc)
+    {
+      new_info.length = end - pc;
+      new_info.sp_offset = cache->sp_offset;
+      new_info.saved_rbp = cache->saved_regs[AMD64_RBP_REGNUM];
+      new_info.saved_sp_reg = cache->saved_sp_reg;
+      new_info.frameless_p = cache->frameless_p;
+      prologue_cache_store (gdbarch, pc, &new_info, sizeof (new_info));
+    }
+
+  return end;
+}
+
 /* Work around false termination of prologue - GCC PR debug/48827.
 
    START_PC is the first instruction of a function, PC is its minimal already
@@ -2245,8 +2305,8 @@ amd64_skip_prologue (struct gdbarch *gdbarch, CORE_ADDR start_pc)
     }
 
   amd64_init_frame_cache (&cache);
-  pc = amd64_analyze_prologue (gdbarch, start_pc, 0xffffffffffffffffLL,
-			       &cache);
+  pc = amd64_analyze_prologue_cached (gdbarch, start_pc,
+				      0xffffffffffffffffLL, &cache);
   if (cache.frameless_p)
     return start_pc;
 
@@ -2267,8 +2327,8 @@ amd64_frame_cache_1 (struct frame_info *this_frame,
 
   cache->pc = get_frame_func (this_frame);
   if (cache->pc != 0)
-    amd64_analyze_prologue (gdbarch, cache->pc, get_frame_pc (this_frame),
-			    cache);
+    amd64_analyze_prologue_cached (gdbarch, cache->pc,
+				   get_frame_pc (this_frame), cache);
 
   if (cache->frameless_p)
     {
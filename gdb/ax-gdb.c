@@ -2578,6 +2578,316 @@ gen_printf (CORE_ADDR scope, struct gdbarch *gdbarch,
   return ax;
 }
 
+/* Evaluating agent expressions.  */
+
+/* The maximum depth of the stack eval_agent_expr supports.  */
+#define AX_EVAL_STACK_MAX 100
+
+/* Read the N-byte big-endian operand at offset O of AX's bytecode.  */
+
+static ULONGEST
+ax_eval_operand (struct agent_expr *ax, int o, int n)
+{
+  ULONGEST accum = 0;
+  int i;
+
+  for (i = 0; i < n; i++)
+    accum = (accum << 8) | ax->buf[o + i];
+
+  return accum;
+}
+
+/* Evaluate AX, as described for eval_agent_expr.  If TRACE_MEMORY is
+   not NULL, also handle the tracing operations, by calling it with
+   DATA for every range of memory to collect, and allow the stack to
+   be empty at the end, in which case *VALUE is not set.  */
+
+static int
+eval_agent_expr_1 (struct agent_expr *ax, struct regcache *regcache,
+		   ax_trace_memory_ftype *trace_memory, void *data,
+		   ULONGEST *value)
+{
+  struct gdbarch *gdbarch = get_regcache_arch (regcache);
+  enum bfd_endian byte_order = gdbarch_byte_order (gdbarch);
+  int num_regs = (gdbarch_num_regs (gdbarch)
+		  + gdbarch_num_pseudo_regs (gdbarch));
+  ULONGEST stack[AX_EVAL_STACK_MAX];
+  int sp = 0;
+  int pc = 0;
+
+  while (pc < ax->len)
+    {
+      int op = ax->buf[pc];
+      const struct aop_map *map;
+      ULONGEST a, b, arg;
+
+      if (op >= aop_last || aop_map[op].name == NULL)
+	return 1;
+      map = &aop_map[op];
+
+      /* Check that the operand is there and that the stack neither
+	 underflows nor overflows.  */
+      if (pc + 1 + map->op_size > ax->len
+	  || sp < map->consumed
+	  || sp - map->consumed + map->produced > AX_EVAL_STACK_MAX)
+	return 1;
+      arg = ax_eval_operand (ax, pc + 1, map->op_size);
+      pc += 1 + map->op_size;
+
+      switch (op)
+	{
+	case aop_add:
+	case aop_sub:
+	case aop_mul:
+	case aop_div_signed:
+	case aop_div_unsigned:
+	case aop_rem_signed:
+	case aop_rem_unsigned:
+	case aop_lsh:
+	case aop_rsh_signed:
+	case aop_rsh_unsigned:
+	case aop_bit_and:
+	case aop_bit_or:
+	case aop_bit_xor:
+	case aop_equal:
+	case aop_less_signed:
+	case aop_less_unsigned:
+	  a = stack[sp - 2];
+	  b = stack[sp - 1];
+	  sp--;
+
+	  switch (op)
+	    {
+	    case aop_add:
+	      a += b;
+	      break;
+	    case aop_sub:
+	      a -= b;
+	      break;
+	    case aop_mul:
+	      a *= b;
+	      break;
+	    case aop_div_signed:
+	    case aop_rem_signed:
+	      if (b == 0 || ((LONGEST) b == -1 && a == (ULONGEST) 1 << 63))
+		return 1;
+	      if (op == aop_div_signed)
+		a = (LONGEST) a / (LONGEST) b;
+	      else
+		a = (LONGEST) a % (LONGEST) b;
+	      break;
+	    case aop_div_unsigned:
+	    case aop_rem_unsigned:
+	      if (b == 0)
+		return 1;
+	      if (op == aop_div_unsigned)
+		a = a / b;
+	      else
+		a = a % b;
+	      break;
+	    case aop_lsh:
+	      a = b < 8 * sizeof (a) ? a << b : 0;
+	      break;
+	    case aop_rsh_signed:
+	      if (b >= 8 * sizeof (a))
+		b = 8 * sizeof (a) - 1;
+	      a = (LONGEST) a >> b;
+	      break;
+	    case aop_rsh_unsigned:
+	      a = b < 8 * sizeof (a) ? a >> b : 0;
+	      break;
+	    case aop_bit_and:
+	      a &= b;
+	      break;
+	    case aop_bit_or:
+	      a |= b;
+	      break;
+	    case aop_bit_xor:
+	      a ^= b;
+	      break;
+	    case aop_equal:
+	      a = (a == b);
+	      break;
+	    case aop_less_signed:
+	      a = ((LONGEST) a < (LONGEST) b);
+	      break;
+	    case aop_less_unsigned:
+	      a = (a < b);
+	      break;
+	    }
+	  stack[sp - 1] = a;
+	  break;
+
+	case aop_log_not:
+	  stack[sp - 1] = !stack[sp - 1];
+	  break;
+
+	case aop_bit_not:
+	  stack[sp - 1] = ~stack[sp - 1];
+	  break;
+
+	case aop_ext:
+	  if (arg > 0 && arg < 8 * sizeof (ULONGEST))
+	    {
+	      ULONGEST sign = (ULONGEST) 1 << (arg - 1);
+
+	      a = stack[sp - 1] & ((sign << 1) - 1);
+	      stack[sp - 1] = (a ^ sign) - sign;
+	    }
+	  break;
+
+	case aop_zero_ext:
+	  if (arg < 8 * sizeof (ULONGEST))
+	    stack[sp - 1] &= ((ULONGEST) 1 << arg) - 1;
+	  break;
+
+	case aop_ref8:
+	case aop_ref16:
+	case aop_ref32:
+	case aop_ref64:
+	  {
+	    gdb_byte buf[8];
+	    int size = map->data_size / 8;
+
+	    if (target_read_memory (stack[sp - 1], buf, size) != 0)
+	      return 1;
+	    stack[sp - 1] = extract_unsigned_integer (buf, size, byte_order);
+	  }
+	  break;
+
+	case aop_if_goto:
+	  if (stack[--sp] != 0)
+	    pc = arg;
+	  break;
+
+	case aop_goto:
+	  pc = arg;
+	  break;
+
+	case aop_const8:
+	case aop_const16:
+	case aop_const32:
+	case aop_const64:
+	  stack[sp++] = arg;
+	  break;
+
+	case aop_reg:
+	  if (arg >= num_regs
+	      || register_size (gdbarch, arg) > sizeof (ULONGEST)
+	      || regcache_cooked_read_unsigned (regcache, arg,
+						&stack[sp]) != REG_VALID)
+	    return 1;
+	  sp++;
+	  break;
+
+	case aop_end:
+	  if (sp > 0 && value != NULL)
+	    *value = stack[sp - 1];
+	  else if (trace_memory == NULL)
+	    return 1;
+	  return 0;
+
+	case aop_dup:
+	  stack[sp] = stack[sp - 1];
+	  sp++;
+	  break;
+
+	case aop_pop:
+	  sp--;
+	  break;
+
+	case aop_pick:
+	  if (arg >= sp)
+	    return 1;
+	  stack[sp] = stack[sp - 1 - arg];
+	  sp++;
+	  break;
+
+	case aop_rot:
+	  /* A B C => C A B.  */
+	  a = stack[sp - 1];
+	  stack[sp - 1] = stack[sp - 2];
+	  stack[sp - 2] = stack[sp - 3];
+	  stack[sp - 3] = a;
+	  break;
+
+	case aop_swap:
+	  a = stack[sp - 1];
+	  stack[sp - 1] = stack[sp - 2];
+	  stack[sp - 2] = a;
+	  break;
+
+	case aop_trace:
+	  if (trace_memory == NULL
+	      || trace_memory (data, stack[sp - 2], stack[sp - 1]) != 0)
+	    return 1;
+	  sp -= 2;
+	  break;
+
+	case aop_trace_quick:
+	case aop_trace16:
+	  if (trace_memory == NULL
+	      || trace_memory (data, stack[sp - 1], arg) != 0)
+	    return 1;
+	  break;
+
+	case aop_tracenz:
+	  {
+	    CORE_ADDR addr = stack[sp - 2];
+	    ULONGEST len, limit = stack[sp - 1];
+
+	    if (trace_memory == NULL)
+	      return 1;
+
+	    /* Collect the string up to and including its terminating
+	       null, or LIMIT bytes of it.  */
+	    for (len = 0; len < limit; len++)
+	      {
+		gdb_byte c;
+
+		if (target_read_memory (addr + len, &c, 1) != 0)
+		  break;
+		if (c == 0)
+		  {
+		    len++;
+		    break;
+		  }
+	      }
+	    if (trace_memory (data, addr, len) != 0)
+	      return 1;
+	    sp -= 2;
+	  }
+	  break;
+
+	default:
+	  /* Floating point, trace state variables and printf are not
+	     supported.  */
+	  return 1;
+	}
+    }
+
+  /* Ran off the end of the expression.  */
+  return 1;
+}
+
+/* See ax-gdb.h.  */
+
+int
+eval_agent_expr (struct agent_expr *ax, struct regcache *regcache,
+		 ULONGEST *value)
+{
+  return eval_agent_expr_1 (ax, regcache, NULL, NULL, value);
+}
+
+/* See ax-gdb.h.  */
+
+int
+eval_trace_agent_expr (struct agent_expr *ax, struct regcache *regcache,
+		       ax_trace_memory_ftype *trace_memory, void *data)
+{
+  return eval_agent_expr_1 (ax, regcache, trace_memory, data, NULL);
+}
+
 static void
 agent_eval_command_one (const char *exp, int eval, CORE_ADDR pc)
 {
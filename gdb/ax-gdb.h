@@ -113,6 +113,34 @@ extern struct agent_expr *gen_trace_for_return_address (CORE_ADDR,
 
 extern struct agent_expr *gen_eval_for_expr (CORE_ADDR, struct expression *);
 
+struct regcache;
+
+/* Evaluate the agent expression AX, produced by gen_eval_for_expr,
+   taking register values from REGCACHE and memory from the current
+   target.  On success, store the value left on top of the stack in
+   *VALUE and return zero.  Return nonzero if AX can't be evaluated,
+   because it uses an operation that is not supported here (such as
+   floating point or tracing), accesses unavailable registers or
+   memory, or is malformed.  */
+extern int eval_agent_expr (struct agent_expr *ax, struct regcache *regcache,
+			    ULONGEST *value);
+
+/* The type of function eval_trace_agent_expr calls to collect LEN
+   bytes of memory at ADDR.  DATA is the pointer passed to
+   eval_trace_agent_expr.  Return nonzero to stop the evaluation
+   with an error.  */
+typedef int (ax_trace_memory_ftype) (void *data, CORE_ADDR addr,
+				     ULONGEST len);
+
+/* Evaluate the agent expression AX, produced by gen_trace_for_expr or
+   gen_eval_for_expr for a tracepoint action, like eval_agent_expr.
+   Call TRACE_MEMORY with DATA for every range of memory AX collects.
+   Return zero on success, or nonzero if AX can't be evaluated.  */
+extern int eval_trace_agent_expr (struct agent_expr *ax,
+				  struct regcache *regcache,
+				  ax_trace_memory_ftype *trace_memory,
+				  void *data);
+
 extern void gen_expr (struct expression *exp, union exp_element **pc,
 		      struct agent_expr *ax, struct axs_value *value);
 
@@ -73,6 +73,19 @@ free_agent_expr (struct agent_expr *x)
   xfree (x);
 }
 
+/* Return a new agent expression with the same bytecode as X.  */
+struct agent_expr *
+copy_agent_expr (struct agent_expr *x)
+{
+  struct agent_expr *copy = new_agent_expr (x->gdbarch, x->scope);
+
+  grow_expr (copy, x->len);
+  memcpy (copy->buf, x->buf, x->len);
+  copy->len = x->len;
+
+  return copy;
+}
+
 static void
 do_free_agent_expr_cleanup (void *x)
 {
@@ -188,6 +188,9 @@ extern struct agent_expr *new_agent_expr (struct gdbarch *, CORE_ADDR);
 
 /* Free a agent expression.  */
 extern void free_agent_expr (struct agent_expr *);
+
+/* Return a copy of an agent expression's bytecode.  */
+extern struct agent_expr *copy_agent_expr (struct agent_expr *);
 extern struct cleanup *make_cleanup_free_agent_expr (struct agent_expr *);
 
 /* Append a simple operator OP to EXPR.  */
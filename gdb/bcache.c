@@ -55,39 +55,58 @@ struct bstring
 };
 
 
-/* The structure for a bcache itself.  The bcache is initialized, in
-   bcache_xmalloc(), by filling it with zeros and then setting the
-   corresponding obstack's malloc() and free() methods.  */
+/* The number of bits of the hash value used to select a shard, and
+   the resulting number of shards.  Each shard is an independent hash
+   table, so no lookup or insertion touches more than one of them, and
+   growing one shard does not rehash the entries of the others.  */
 
-struct bcache
-{
-  /* All the bstrings are allocated here.  */
-  struct obstack cache;
+#define BCACHE_SHARD_BITS (3)
+#define BCACHE_SHARDS (1 << BCACHE_SHARD_BITS)
 
+/* One shard of a bcache.  */
+
+struct bcache_shard
+{
   /* How many hash buckets we're using.  */
   unsigned int num_buckets;
-  
+
   /* Hash buckets.  This table is allocated using malloc, so when we
      grow the table we can return the old table to the system.  */
   struct bstring **bucket;
 
   /* Statistics.  */
   unsigned long unique_count;	/* number of unique strings */
-  long total_count;	/* total number of strings cached, including dups */
-  long unique_size;	/* size of unique strings, in bytes */
-  long total_size;      /* total number of bytes cached, including dups */
-  long structure_size;	/* total size of bcache, including infrastructure */
+  unsigned long total_count;	/* number of strings cached, including dups */
   /* Number of times that the hash table is expanded and hence
      re-built, and the corresponding number of times that a string is
-     [re]hashed as part of entering it into the expanded table.  The
-     total number of hashes can be computed by adding TOTAL_COUNT to
-     expand_hash_count.  */
+     [re]hashed as part of entering it into the expanded table.  */
   unsigned long expand_count;
   unsigned long expand_hash_count;
   /* Number of times that the half-hash compare hit (compare the upper
      16 bits of hash values) hit, but the corresponding combined
      length/data compare missed.  */
   unsigned long half_hash_miss_count;
+};
+
+/* The structure for a bcache itself.  The bcache is initialized, in
+   bcache_xmalloc(), by filling it with zeros and then setting the
+   corresponding obstack's malloc() and free() methods.  */
+
+struct bcache
+{
+  /* All the bstrings are allocated here.  */
+  struct obstack cache;
+
+  /* The hash tables.  A string lives in the shard selected by the low
+     BCACHE_SHARD_BITS bits of its hash.  */
+  struct bcache_shard shards[BCACHE_SHARDS];
+
+  /* Statistics.  */
+  unsigned long unique_count;	/* number of unique strings */
+  long total_count;	/* total number of strings cached, including dups */
+  long unique_size;	/* size of unique strings, in bytes */
+  long total_size;      /* total number of bytes cached, including dups */
+  long structure_size;	/* total size of bcache, including infrastructure */
 
   /* Hash function to be used for this bcache object.  */
   unsigned long (*hash_function)(const void *addr, int length);
@@ -128,15 +147,26 @@ hash_continue (const void *addr, int length, unsigned long h)
    resize our hash table.  */
 #define CHAIN_LENGTH_THRESHOLD (5)
 
+/* Return the index of the shard holding strings whose hash is
+   FULL_HASH, and the bucket within a shard of NUM_BUCKETS buckets.  */
+
+#define BCACHE_SHARD_INDEX(full_hash) \
+  ((full_hash) & (BCACHE_SHARDS - 1))
+#define BCACHE_BUCKET_INDEX(full_hash, num_buckets) \
+  (((full_hash) >> BCACHE_SHARD_BITS) % (num_buckets))
+
 static void
-expand_hash_table (struct bcache *bcache)
+expand_hash_table (struct bcache *bcache, struct bcache_shard *shard)
 {
   /* A table of good hash table sizes.  Whenever we grow, we pick the
-     next larger size from this table.  sizes[i] is close to 1 << (i+10),
+     next larger size from this table.  sizes[i] is close to 1 << (i+7),
      so we roughly double the table size each time.  After we fall off 
      the end of this table, we just double.  Don't laugh --- there have
-     been executables sighted with a gigabyte of debug info.  */
+     been executables sighted with a gigabyte of debug info.  The
+     first sizes are small because each bcache has BCACHE_SHARDS
+     tables.  */
   static unsigned long sizes[] = { 
+    127, 251, 509,
     1021, 2053, 4099, 8191, 16381, 32771,
     65537, 131071, 262144, 524287, 1048573, 2097143,
     4194301, 8388617, 16777213, 33554467, 67108859, 134217757,
@@ -148,13 +178,13 @@ expand_hash_table (struct bcache *bcache)
 
   /* Count the stats.  Every unique item needs to be re-hashed and
      re-entered.  */
-  bcache->expand_count++;
-  bcache->expand_hash_count += bcache->unique_count;
+  shard->expand_count++;
+  shard->expand_hash_count += shard->unique_count;
 
   /* Find the next size.  */
-  new_num_buckets = bcache->num_buckets * 2;
+  new_num_buckets = shard->num_buckets * 2;
   for (i = 0; i < (sizeof (sizes) / sizeof (sizes[0])); i++)
-    if (sizes[i] > bcache->num_buckets)
+    if (sizes[i] > shard->num_buckets)
       {
 	new_num_buckets = sizes[i];
 	break;
@@ -167,37 +197,39 @@ expand_hash_table (struct bcache *bcache)
     new_buckets = (struct bstring **) xmalloc (new_size);
     memset (new_buckets, 0, new_size);
 
-    bcache->structure_size -= (bcache->num_buckets
-			       * sizeof (bcache->bucket[0]));
+    bcache->structure_size -= (shard->num_buckets
+			       * sizeof (shard->bucket[0]));
     bcache->structure_size += new_size;
   }
 
   /* Rehash all existing strings.  */
-  for (i = 0; i < bcache->num_buckets; i++)
+  for (i = 0; i < shard->num_buckets; i++)
     {
       struct bstring *s, *next;
 
-      for (s = bcache->bucket[i]; s; s = next)
+      for (s = shard->bucket[i]; s; s = next)
 	{
 	  struct bstring **new_bucket;
+	  unsigned long full_hash;
+
 	  next = s->next;
 
-	  new_bucket = &new_buckets[(bcache->hash_function (&s->d.data,
-							    s->length)
-				     % new_num_buckets)];
+	  full_hash = bcache->hash_function (&s->d.data, s->length);
+	  new_bucket = &new_buckets[BCACHE_BUCKET_INDEX (full_hash,
+							 new_num_buckets)];
 	  s->next = *new_bucket;
 	  *new_bucket = s;
 	}
     }
 
   /* Plug in the new table.  */
-  if (bcache->bucket)
-    xfree (bcache->bucket);
-  bcache->bucket = new_buckets;
-  bcache->num_buckets = new_num_buckets;
+  if (shard->bucket)
+    xfree (shard->bucket);
+  shard->bucket = new_buckets;
+  shard->num_buckets = new_num_buckets;
 }
 
-
+
 /* Looking up things in the bcache.  */
 
 /* The number of bytes needed to allocate a struct bstring whose data
@@ -225,6 +257,7 @@ bcache_full (const void *addr, int length, struct bcache *bcache, int *added)
   unsigned long full_hash;
   unsigned short half_hash;
   int hash_index;
+  struct bcache_shard *shard;
   struct bstring *s;
 
   if (added)
@@ -240,22 +273,24 @@ bcache_full (const void *addr, int length, struct bcache *bcache, int *added)
       obstack_init (&bcache->cache);
     }
 
+  full_hash = bcache->hash_function (addr, length);
+  shard = &bcache->shards[BCACHE_SHARD_INDEX (full_hash)];
+
   /* If our average chain length is too high, expand the hash table.  */
-  if (bcache->unique_count >= bcache->num_buckets * CHAIN_LENGTH_THRESHOLD)
-    expand_hash_table (bcache);
+  if (shard->unique_count >= shard->num_buckets * CHAIN_LENGTH_THRESHOLD)
+    expand_hash_table (bcache, shard);
 
   bcache->total_count++;
   bcache->total_size += length;
-
-  full_hash = bcache->hash_function (addr, length);
+  shard->total_count++;
 
   half_hash = (full_hash >> 16);
-  hash_index = full_hash % bcache->num_buckets;
+  hash_index = BCACHE_BUCKET_INDEX (full_hash, shard->num_buckets);
 
   /* Search the hash bucket for a string identical to the caller's.
      As a short-circuit first compare the upper part of each hash
      values.  */
-  for (s = bcache->bucket[hash_index]; s; s = s->next)
+  for (s = shard->bucket[hash_index]; s; s = s->next)
     {
       if (s->half_hash == half_hash)
 	{
@@ -263,7 +298,7 @@ bcache_full (const void *addr, int length, struct bcache *bcache, int *added)
 	      && bcache->compare_function (&s->d.data, addr, length))
 	    return &s->d.data;
 	  else
-	    bcache->half_hash_miss_count++;
+	    shard->half_hash_miss_count++;
 	}
     }
 
@@ -274,10 +309,11 @@ bcache_full (const void *addr, int length, struct bcache *bcache, int *added)
 
     memcpy (&new->d.data, addr, length);
     new->length = length;
-    new->next = bcache->bucket[hash_index];
+    new->next = shard->bucket[hash_index];
     new->half_hash = half_hash;
-    bcache->bucket[hash_index] = new;
+    shard->bucket[hash_index] = new;
 
+    shard->unique_count++;
     bcache->unique_count++;
     bcache->unique_size += length;
     bcache->structure_size += BSTRING_SIZE (length);
@@ -331,12 +367,15 @@ bcache_xmalloc (unsigned long (*hash_function)(const void *, int length),
 void
 bcache_xfree (struct bcache *bcache)
 {
+  int i;
+
   if (bcache == NULL)
     return;
   /* Only free the obstack if we actually initialized it.  */
   if (bcache->total_count > 0)
     obstack_free (&bcache->cache, 0);
-  xfree (bcache->bucket);
+  for (i = 0; i < BCACHE_SHARDS; i++)
+    xfree (bcache->shards[i].bucket);
   xfree (bcache);
 }
 
@@ -367,49 +406,68 @@ print_bcache_statistics (struct bcache *c, char *type)
   int median_chain_length;
   int max_entry_size;
   int median_entry_size;
+  unsigned int num_buckets;
+  unsigned long expand_count;
+  unsigned long expand_hash_count;
+  unsigned long half_hash_miss_count;
+  int i;
+
+  /* Total the per-shard counts.  */
+  num_buckets = 0;
+  expand_count = 0;
+  expand_hash_count = 0;
+  half_hash_miss_count = 0;
+  for (i = 0; i < BCACHE_SHARDS; i++)
+    {
+      num_buckets += c->shards[i].num_buckets;
+      expand_count += c->shards[i].expand_count;
+      expand_hash_count += c->shards[i].expand_hash_count;
+      half_hash_miss_count += c->shards[i].half_hash_miss_count;
+    }
 
   /* Count the number of occupied buckets, tally the various string
      lengths, and measure chain lengths.  */
   {
-    unsigned int b;
-    int *chain_length = XCALLOC (c->num_buckets + 1, int);
+    unsigned int b, bucketi = 0;
+    int *chain_length = XCALLOC (num_buckets + 1, int);
     int *entry_size = XCALLOC (c->unique_count + 1, int);
     int stringi = 0;
 
     occupied_buckets = 0;
 
-    for (b = 0; b < c->num_buckets; b++)
-      {
-	struct bstring *s = c->bucket[b];
-
-	chain_length[b] = 0;
-
-	if (s)
-	  {
-	    occupied_buckets++;
-	    
-	    while (s)
-	      {
-		gdb_assert (b < c->num_buckets);
-		chain_length[b]++;
-		gdb_assert (stringi < c->unique_count);
-		entry_size[stringi++] = s->length;
-		s = s->next;
-	      }
-	  }
-      }
+    for (i = 0; i < BCACHE_SHARDS; i++)
+      for (b = 0; b < c->shards[i].num_buckets; b++, bucketi++)
+	{
+	  struct bstring *s = c->shards[i].bucket[b];
+
+	  chain_length[bucketi] = 0;
+
+	  if (s)
+	    {
+	      occupied_buckets++;
+
+	      while (s)
+		{
+		  gdb_assert (bucketi < num_buckets);
+		  chain_length[bucketi]++;
+		  gdb_assert (stringi < c->unique_count);
+		  entry_size[stringi++] = s->length;
+		  s = s->next;
+		}
+	    }
+	}
 
     /* To compute the median, we need the set of chain lengths
        sorted.  */
-    qsort (chain_length, c->num_buckets, sizeof (chain_length[0]),
+    qsort (chain_length, num_buckets, sizeof (chain_length[0]),
 	   compare_positive_ints);
     qsort (entry_size, c->unique_count, sizeof (entry_size[0]),
 	   compare_positive_ints);
 
-    if (c->num_buckets > 0)
+    if (num_buckets > 0)
       {
-	max_chain_length = chain_length[c->num_buckets - 1];
-	median_chain_length = chain_length[c->num_buckets / 2];
+	max_chain_length = chain_length[num_buckets - 1];
+	median_chain_length = chain_length[num_buckets / 2];
       }
     else
       {
@@ -464,26 +522,39 @@ Total memory used by bcache, including overhead: %ld\n"),
   printf_filtered ("\n");
 
   printf_filtered (_("    Hash table size:           %3d\n"), 
-		   c->num_buckets);
+		   num_buckets);
   printf_filtered (_("    Hash table expands:        %lu\n"),
-		   c->expand_count);
+		   expand_count);
   printf_filtered (_("    Hash table hashes:         %lu\n"),
-		   c->total_count + c->expand_hash_count);
+		   c->total_count + expand_hash_count);
   printf_filtered (_("    Half hash misses:          %lu\n"),
-		   c->half_hash_miss_count);
+		   half_hash_miss_count);
   printf_filtered (_("    Hash table population:     "));
-  print_percentage (occupied_buckets, c->num_buckets);
+  print_percentage (occupied_buckets, num_buckets);
   printf_filtered (_("    Median hash chain length:  %3d\n"),
 		   median_chain_length);
   printf_filtered (_("    Average hash chain length: "));
-  if (c->num_buckets > 0)
-    printf_filtered ("%3lu\n", c->unique_count / c->num_buckets);
+  if (num_buckets > 0)
+    printf_filtered ("%3lu\n", c->unique_count / num_buckets);
   else
     /* i18n: "Average hash chain length: (not applicable)".  */
     printf_filtered (_("(not applicable)\n"));
   printf_filtered (_("    Maximum hash chain length: %3d\n"), 
 		   max_chain_length);
   printf_filtered ("\n");
+
+  for (i = 0; i < BCACHE_SHARDS; i++)
+    {
+      struct bcache_shard *shard = &c->shards[i];
+
+      printf_filtered (_("    Shard %d: %lu objects, %lu unique, "
+			 "%u buckets, %lu expands, duplicates: "),
+		       i, shard->total_count, shard->unique_count,
+		       shard->num_buckets, shard->expand_count);
+      print_percentage (shard->total_count - shard->unique_count,
+			shard->total_count);
+    }
+  printf_filtered ("\n");
 }
 
 int
@@ -247,6 +247,8 @@ static void update_global_location_list (int);
 
 static void update_global_location_list_nothrow (int);
 
+static void mark_breakpoint_locations_changed (struct breakpoint *b);
+
 static int is_hardware_watchpoint (const struct breakpoint *bpt);
 
 static void insert_breakpoint_locations (void);
@@ -564,6 +566,11 @@ int target_exact_watchpoints = 0;
 
 struct breakpoint *breakpoint_chain;
 
+/* Last element of BREAKPOINT_CHAIN, so that new breakpoints can be
+   appended without walking the whole chain.  */
+
+static struct breakpoint *breakpoint_chain_last;
+
 /* Array is sorted by bp_location_compare - primarily by the ADDRESS.  */
 
 static struct bp_location **bp_location;
@@ -593,6 +600,25 @@ static CORE_ADDR bp_location_shadow_len_after_address_max;
    by a target.  */
 VEC(bp_location_p) *moribund_locations = NULL;
 
+/* Breakpoints whose LOC list may have changed since the BP_LOCATION
+   array was last updated; see mark_breakpoint_locations_changed.
+   update_global_location_list only needs to merge the locations of
+   these breakpoints into the array, the rest of it is still valid.  */
+
+static VEC(breakpoint_p) *location_changed_breakpoints;
+
+/* While non-zero, calls to update_global_location_list only record
+   that an update is needed.  A single update is done at the end, when
+   the locations of many breakpoints are re-set together.  */
+
+static int location_list_update_deferred;
+
+/* Whether update_global_location_list was called while deferred, and
+   whether any of those calls wanted breakpoints to be inserted.  */
+
+static int location_list_update_pending;
+static int location_list_update_should_insert;
+
 /* Number of last breakpoint made.  */
 
 static int breakpoint_count;
@@ -1754,6 +1780,7 @@ update_watchpoint (struct watchpoint *b, int reparse)
      and update_global_location_list will eventually delete them and
      remove breakpoints if needed.  */
   b->base.loc = NULL;
+  mark_breakpoint_locations_changed (&b->base);
 
   if (within_current_scope && reparse)
     {
@@ -2705,6 +2732,7 @@ breakpoint_program_space_exit (struct program_space *pspace)
       if (loc->pspace == pspace)
 	{
 	  /* ALL_BP_LOCATIONS bp_location has LOC->OWNER always non-NULL.  */
+	  mark_breakpoint_locations_changed (loc->owner);
 	  if (loc->owner->loc == loc)
 	    loc->owner->loc = loc->next;
 	  else
@@ -5262,6 +5290,9 @@ bpstat_stop_status (struct address_space *aspace,
   int ix;
   int need_remove_insert;
   int removed_any;
+  struct infrun_phase_timer timer;
+
+  infrun_phase_begin (&timer, INFRUN_PHASE_BPSTAT);
 
   /* First, build the bpstat chain with locations that explain a
      target stop, while being careful to not set the target running,
@@ -5356,7 +5387,11 @@ bpstat_stop_status (struct address_space *aspace,
       b->ops->check_status (bs);
       if (bs->stop)
 	{
+	  struct infrun_phase_timer condition_timer;
+
+	  infrun_phase_begin (&condition_timer, INFRUN_PHASE_CONDITION);
 	  bpstat_check_breakpoint_conditions (bs, ptid);
+	  infrun_phase_end (&condition_timer);
 
 	  if (bs->stop)
 	    {
@@ -5413,6 +5448,7 @@ bpstat_stop_status (struct address_space *aspace,
   else if (removed_any)
     update_global_location_list (0);
 
+  infrun_phase_end (&timer);
   return bs_head;
 }
 
@@ -6990,20 +7026,16 @@ decref_bp_location (struct bp_location **blp)
 static void
 add_to_breakpoint_chain (struct breakpoint *b)
 {
-  struct breakpoint *b1;
-
   /* Add this breakpoint to the end of the chain so that a list of
      breakpoints will come out in order of increasing numbers.  */
 
-  b1 = breakpoint_chain;
-  if (b1 == 0)
+  if (breakpoint_chain == NULL)
     breakpoint_chain = b;
   else
-    {
-      while (b1->next)
-	b1 = b1->next;
-      b1->next = b;
-    }
+    breakpoint_chain_last->next = b;
+  breakpoint_chain_last = b;
+
+  mark_breakpoint_locations_changed (b);
 }
 
 /* Initializes breakpoint B with type BPTYPE and no locations yet.  */
@@ -9083,6 +9115,7 @@ update_dprintf_command_list (struct breakpoint *b)
     printf_cmd_line->control_type = simple_control;
     printf_cmd_line->body_count = 0;
     printf_cmd_line->body_list = NULL;
+    printf_cmd_line->condition = NULL;
     printf_cmd_line->next = NULL;
     printf_cmd_line->line = printf_line;
 
@@ -12269,11 +12302,12 @@ force_breakpoint_reinsertion (struct bp_location *bl)
    breakpoints had already been removed from the inferior.  */
 
 static void
-update_global_location_list (int should_insert)
+update_global_location_list_1 (int should_insert)
 {
   struct breakpoint *b;
   struct bp_location **locp, *loc;
   struct cleanup *cleanups;
+  int ix;
   /* Last breakpoint location address that was marked for update.  */
   CORE_ADDR last_addr = 0;
   /* Last breakpoint location program space that was marked for update.  */
@@ -12292,26 +12326,88 @@ update_global_location_list (int should_insert)
 
   /* Saved former bp_location array which we compare against the newly
      built bp_location from the current state of ALL_BREAKPOINTS.  */
-  struct bp_location **old_location, **old_locp;
+  struct bp_location **old_location, **old_locp, **old_end;
   unsigned old_location_count;
 
+  /* Current locations of the breakpoints in
+     LOCATION_CHANGED_BREAKPOINTS, which are merged into the
+     locations of the other breakpoints kept from OLD_LOCATION.  */
+  struct bp_location **changed_locs, **changed_locp, **changed_end;
+  unsigned changed_count, kept_count;
+  struct bp_location *last_kept = NULL;
+  int kept_sorted = 1;
+
   old_location = bp_location;
   old_location_count = bp_location_count;
+  old_end = old_location + old_location_count;
   bp_location = NULL;
   bp_location_count = 0;
   cleanups = make_cleanup (xfree, old_location);
 
-  ALL_BREAKPOINTS (b)
+  changed_count = 0;
+  for (ix = 0;
+       VEC_iterate (breakpoint_p, location_changed_breakpoints, ix, b);
+       ix++)
+    for (loc = b->loc; loc; loc = loc->next)
+      changed_count++;
+
+  changed_locs = xmalloc (sizeof (*changed_locs) * changed_count);
+  make_cleanup (xfree, changed_locs);
+  changed_locp = changed_locs;
+  for (ix = 0;
+       VEC_iterate (breakpoint_p, location_changed_breakpoints, ix, b);
+       ix++)
     for (loc = b->loc; loc; loc = loc->next)
-      bp_location_count++;
+      *changed_locp++ = loc;
+  changed_end = changed_locp;
+  qsort (changed_locs, changed_count, sizeof (*changed_locs),
+	 bp_location_compare);
+
+  kept_count = 0;
+  for (old_locp = old_location; old_locp < old_end; old_locp++)
+    if (!(*old_locp)->owner->locations_changed)
+      kept_count++;
 
+  bp_location_count = kept_count + changed_count;
   bp_location = xmalloc (sizeof (*bp_location) * bp_location_count);
+
+  /* Merge the two sorted lists.  The kept locations are only out of
+     order if one of their sort keys was changed in place, in which
+     case sort the whole array again.  */
   locp = bp_location;
-  ALL_BREAKPOINTS (b)
-    for (loc = b->loc; loc; loc = loc->next)
-      *locp++ = loc;
-  qsort (bp_location, bp_location_count, sizeof (*bp_location),
-	 bp_location_compare);
+  old_locp = old_location;
+  changed_locp = changed_locs;
+  while (1)
+    {
+      while (old_locp < old_end && (*old_locp)->owner->locations_changed)
+	old_locp++;
+
+      if (old_locp < old_end
+	  && (changed_locp == changed_end
+	      || bp_location_compare (old_locp, changed_locp) <= 0))
+	{
+	  if (last_kept != NULL
+	      && bp_location_compare (&last_kept, old_locp) > 0)
+	    kept_sorted = 0;
+	  last_kept = *old_locp;
+	  *locp++ = *old_locp++;
+	}
+      else if (changed_locp < changed_end)
+	*locp++ = *changed_locp++;
+      else
+	break;
+    }
+  gdb_assert (locp == bp_location + bp_location_count);
+
+  if (!kept_sorted)
+    qsort (bp_location, bp_location_count, sizeof (*bp_location),
+	   bp_location_compare);
+
+  for (ix = 0;
+       VEC_iterate (breakpoint_p, location_changed_breakpoints, ix, b);
+       ix++)
+    b->locations_changed = 0;
+  VEC_truncate (breakpoint_p, location_changed_breakpoints, 0);
 
   bp_location_target_extensions_update ();
 
@@ -12626,6 +12722,83 @@ update_global_location_list (int should_insert)
   do_cleanups (cleanups);
 }
 
+/* Update the global location list, the BP_LOCATION array, from the
+   current locations of all breakpoints; see
+   update_global_location_list_1 for SHOULD_INSERT.  While updates
+   are deferred, just remember that one is needed.  */
+
+static void
+update_global_location_list (int should_insert)
+{
+  if (location_list_update_deferred)
+    {
+      location_list_update_pending = 1;
+      if (should_insert)
+	location_list_update_should_insert = 1;
+      return;
+    }
+
+  update_global_location_list_1 (should_insert);
+}
+
+/* Record that the locations of breakpoint B may have changed, so that
+   the next update of the global location list takes its current
+   locations into account.  Anything that adds locations to or
+   removes locations from B->LOC must call this.  */
+
+static void
+mark_breakpoint_locations_changed (struct breakpoint *b)
+{
+  if (!b->locations_changed)
+    {
+      b->locations_changed = 1;
+      VEC_safe_push (breakpoint_p, location_changed_breakpoints, b);
+    }
+}
+
+/* Cleanup function for defer_global_location_list_update.  */
+
+static void
+undefer_global_location_list_update (void *ignore)
+{
+  gdb_assert (location_list_update_deferred > 0);
+  location_list_update_deferred--;
+}
+
+/* Defer updates of the global location list until the returned
+   cleanup is run and update_deferred_global_location_list is
+   called.  */
+
+static struct cleanup *
+defer_global_location_list_update (void)
+{
+  location_list_update_deferred++;
+  return make_cleanup (undefer_global_location_list_update, NULL);
+}
+
+/* Do the update of the global location list that was requested while
+   updates were deferred, if any.  Errors are reported, but not
+   propagated, as the breakpoints themselves were already changed.  */
+
+static void
+update_deferred_global_location_list (void)
+{
+  volatile struct gdb_exception e;
+  int should_insert;
+
+  if (location_list_update_deferred || !location_list_update_pending)
+    return;
+
+  should_insert = location_list_update_should_insert;
+  location_list_update_pending = 0;
+  location_list_update_should_insert = 0;
+
+  TRY_CATCH (e, RETURN_MASK_ERROR)
+    update_global_location_list (should_insert);
+  if (e.reason < 0)
+    exception_print (gdb_stderr, e);
+}
+
 void
 breakpoint_retire_moribund (void)
 {
@@ -13707,14 +13880,25 @@ delete_breakpoint (struct breakpoint *bpt)
     observer_notify_breakpoint_deleted (bpt);
 
   if (breakpoint_chain == bpt)
-    breakpoint_chain = bpt->next;
-
-  ALL_BREAKPOINTS (b)
-    if (b->next == bpt)
     {
-      b->next = bpt->next;
-      break;
+      breakpoint_chain = bpt->next;
+      if (breakpoint_chain_last == bpt)
+	breakpoint_chain_last = NULL;
     }
+  else
+    ALL_BREAKPOINTS (b)
+      if (b->next == bpt)
+	{
+	  b->next = bpt->next;
+	  if (breakpoint_chain_last == bpt)
+	    breakpoint_chain_last = b;
+	  break;
+	}
+
+  /* The locations of BPT are only in the global location list now,
+     and the update below removes them from there.  */
+  bpt->loc = NULL;
+  mark_breakpoint_locations_changed (bpt);
 
   /* Be sure no bpstat's are pointing at the breakpoint after it's
      been freed.  */
@@ -13733,8 +13917,10 @@ delete_breakpoint (struct breakpoint *bpt)
      belong to this breakpoint.  Do this before freeing the breakpoint
      itself, since remove_breakpoint looks at location's owner.  It
      might be better design to have location completely
-     self-contained, but it's not the case now.  */
-  update_global_location_list (0);
+     self-contained, but it's not the case now.  This is done even
+     while updates are deferred, as nothing must refer to BPT once it
+     is freed.  */
+  update_global_location_list_1 (0);
 
   bpt->ops->dtor (bpt);
   /* On the chance that someone will soon try again to delete this
@@ -14080,6 +14266,7 @@ update_breakpoint_locations (struct breakpoint *b,
     return;
 
   b->loc = NULL;
+  mark_breakpoint_locations_changed (b);
 
   for (i = 0; i < sals.nelts; ++i)
     {
@@ -14390,7 +14577,11 @@ breakpoint_re_set (void)
   struct breakpoint *b, *b_tmp;
   enum language save_language;
   int save_input_radix;
-  struct cleanup *old_chain;
+  struct cleanup *old_chain, *defer_chain;
+
+  /* Update the global location list once for all breakpoints, instead
+     of once for every breakpoint re-set.  */
+  defer_chain = defer_global_location_list_update ();
 
   save_language = current_language->la_language;
   save_input_radix = input_radix;
@@ -14416,6 +14607,9 @@ breakpoint_re_set (void)
   create_longjmp_master_breakpoint ();
   create_std_terminate_master_breakpoint ();
   create_exception_master_breakpoint ();
+
+  do_cleanups (defer_chain);
+  update_deferred_global_location_list ();
 }
 
 /* Reset the thread number of this breakpoint:
@@ -675,6 +675,10 @@ struct breakpoint
     /* Location(s) associated with this high-level breakpoint.  */
     struct bp_location *loc;
 
+    /* Non-zero if LOC may have gained or lost locations since the
+       global location list was last updated.  */
+    unsigned char locations_changed;
+
     /* Non-zero means a silent breakpoint (don't print frame info
        if we stop here).  */
     unsigned char silent;
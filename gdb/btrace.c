@@ -45,6 +45,9 @@
 
 #define DEBUG_FTRACE(msg, args...) DEBUG ("[ftrace] " msg, ##args)
 
+/* The largest block of code that compute_itrace reads at once.  */
+#define BTRACE_BLOCK_READ_MAX 4096
+
 /* Initialize the instruction iterator.  */
 
 static void
@@ -67,29 +70,42 @@ btrace_init_func_iterator (struct btrace_thread_info *btinfo)
   btinfo->func_iterator.end = 0;
 }
 
-/* Compute the instruction trace from the block trace.  */
+/* Append the instructions of the block trace BTRACE to the instruction
+   trace ITRACE, and return the updated instruction trace.
+
+   The code of each block is read at once, and decoded from that copy,
+   rather than reading the target for each instruction.  */
 
 static VEC (btrace_inst_s) *
-compute_itrace (VEC (btrace_block_s) *btrace)
+compute_itrace (VEC (btrace_inst_s) *itrace, VEC (btrace_block_s) *btrace)
 {
-  VEC (btrace_inst_s) *itrace;
   struct gdbarch *gdbarch;
+  struct cleanup *cleanup;
+  gdb_byte *code;
   unsigned int b;
 
   DEBUG ("compute itrace");
 
-  itrace = NULL;
   gdbarch = target_gdbarch ();
+  code = xmalloc (BTRACE_BLOCK_READ_MAX);
+  cleanup = make_cleanup (xfree, code);
   b = VEC_length (btrace_block_s, btrace);
 
   while (b-- != 0)
     {
       btrace_block_s *block;
       CORE_ADDR pc;
+      int have_code;
 
       block = VEC_index (btrace_block_s, btrace, b);
       pc = block->begin;
 
+      /* The instruction at the end of the block is not decoded.  */
+      have_code = (block->begin <= block->end
+		   && block->end - block->begin <= BTRACE_BLOCK_READ_MAX
+		   && target_read_memory (block->begin, code,
+					  block->end - block->begin) == 0);
+
       /* Add instructions for this block.  */
       for (;;)
 	{
@@ -110,7 +126,15 @@ compute_itrace (VEC (btrace_block_s) *btrace)
 	  if (block->end == pc)
 	    break;
 
-	  size = gdb_insn_length (gdbarch, pc);
+	  size = 0;
+	  if (have_code)
+	    size = gdb_buffered_insn_length (gdbarch, code + (pc - block->begin),
+					     block->end - pc, pc);
+
+	  /* The instruction may extend past the end of the block if the
+	     trace is corrupted.  Let the disassembler read the target.  */
+	  if (size <= 0)
+	    size = gdb_insn_length (gdbarch, pc);
 
 	  /* Make sure we terminate if we fail to compute the size.  */
 	  if (size <= 0)
@@ -123,6 +147,7 @@ compute_itrace (VEC (btrace_block_s) *btrace)
 	}
     }
 
+  do_cleanups (cleanup);
   return itrace;
 }
 
@@ -254,22 +279,25 @@ ftrace_skip_file (struct btrace_func *bfun, const char *filename)
   return (filename_cmp (bfile, filename) != 0);
 }
 
-/* Compute the function trace from the instruction trace.  */
+/* Extend the function trace FTRACE with the instructions of the
+   instruction trace ITRACE starting at index START, and return the
+   updated function trace.  */
 
 static VEC (btrace_func_s) *
-compute_ftrace (VEC (btrace_inst_s) *itrace)
+compute_ftrace (VEC (btrace_func_s) *ftrace, VEC (btrace_inst_s) *itrace,
+		unsigned int start)
 {
-  VEC (btrace_func_s) *ftrace;
   struct btrace_inst *binst;
   struct btrace_func *bfun;
   unsigned int idx;
 
-  DEBUG ("compute ftrace");
+  DEBUG ("compute ftrace from %u", start);
 
-  ftrace = NULL;
   bfun = NULL;
+  if (!VEC_empty (btrace_func_s, ftrace))
+    bfun = VEC_last (btrace_func_s, ftrace);
 
-  for (idx = 0; VEC_iterate (btrace_inst_s, itrace, idx, binst); ++idx)
+  for (idx = start; VEC_iterate (btrace_inst_s, itrace, idx, binst); ++idx)
     {
       struct symtab_and_line sal;
       struct bound_minimal_symbol mfun;
@@ -394,6 +422,8 @@ btrace_fetch (struct thread_info *tp)
 {
   struct btrace_thread_info *btinfo;
   VEC (btrace_block_s) *btrace;
+  struct btrace_block *oldest;
+  enum btrace_read_type type;
 
   DEBUG ("fetch thread %d (%s)", tp->num, target_pid_to_str (tp->ptid));
 
@@ -401,15 +431,53 @@ btrace_fetch (struct thread_info *tp)
   if (btinfo->target == NULL)
     return;
 
-  btrace = target_read_btrace (btinfo->target, btrace_read_new);
+  /* Once we have some trace, we only read what was added since.  */
+  if (VEC_empty (btrace_inst_s, btinfo->itrace))
+    type = btrace_read_new;
+  else
+    type = btrace_read_delta;
+
+  btrace = target_read_btrace (btinfo->target, type);
   if (VEC_empty (btrace_block_s, btrace))
     return;
 
-  btrace_clear (tp);
+  /* A zero begin address of the oldest block means that it continues the
+     newest block of the trace we read last.  That block ended at the
+     (then) current instruction, which also starts the new block.  */
+  oldest = VEC_last (btrace_block_s, btrace);
+  if (oldest->begin == 0 && !VEC_empty (btrace_inst_s, btinfo->itrace))
+    {
+      DEBUG ("extend trace");
 
-  btinfo->btrace = btrace;
-  btinfo->itrace = compute_itrace (btinfo->btrace);
-  btinfo->ftrace = compute_ftrace (btinfo->itrace);
+      oldest->begin = VEC_last (btrace_inst_s, btinfo->itrace)->pc;
+      VEC_pop (btrace_inst_s, btinfo->itrace);
+
+      /* The function trace is extended from the instruction we just
+	 removed, the next time it is needed.  */
+      btinfo->ftrace_end = min (btinfo->ftrace_end,
+				VEC_length (btrace_inst_s, btinfo->itrace));
+
+      VEC_free (btrace_block_s, btinfo->btrace);
+      btinfo->btrace = btrace;
+    }
+  else
+    {
+      /* There is nothing to continue; ignore the partial block.  */
+      if (oldest->begin == 0)
+	{
+	  VEC_pop (btrace_block_s, btrace);
+	  if (VEC_empty (btrace_block_s, btrace))
+	    {
+	      VEC_free (btrace_block_s, btrace);
+	      return;
+	    }
+	}
+
+      btrace_clear (tp);
+      btinfo->btrace = btrace;
+    }
+
+  btinfo->itrace = compute_itrace (btinfo->itrace, btinfo->btrace);
 
   /* Initialize branch trace iterators.  */
   btrace_init_insn_iterator (btinfo);
@@ -434,6 +502,23 @@ btrace_clear (struct thread_info *tp)
   btinfo->btrace = NULL;
   btinfo->itrace = NULL;
   btinfo->ftrace = NULL;
+  btinfo->ftrace_end = 0;
+}
+
+/* See btrace.h.  */
+
+void
+btrace_update_ftrace (struct btrace_thread_info *btinfo)
+{
+  unsigned int end;
+
+  end = VEC_length (btrace_inst_s, btinfo->itrace);
+  if (btinfo->ftrace_end == end)
+    return;
+
+  btinfo->ftrace = compute_ftrace (btinfo->ftrace, btinfo->itrace,
+				   btinfo->ftrace_end);
+  btinfo->ftrace_end = end;
 }
 
 /* See btrace.h.  */
@@ -103,11 +103,19 @@ struct btrace_thread_info
      the underlying architecture.  */
   struct btrace_target_info *target;
 
-  /* The current branch trace for this thread.  */
+  /* The branch trace blocks read last for this thread, and the
+     instruction and function trace computed from all blocks read so far.
+     Reads after the first one only return the blocks added since, so the
+     latter two grow at their end.  */
   VEC (btrace_block_s) *btrace;
   VEC (btrace_inst_s) *itrace;
   VEC (btrace_func_s) *ftrace;
 
+  /* The number of instructions of ITRACE that FTRACE covers.  The
+     function trace needs symbol lookups for every instruction, so it is
+     only extended when it is used; see btrace_update_ftrace.  */
+  unsigned int ftrace_end;
+
   /* The instruction history iterator.  */
   struct btrace_insn_iterator insn_iterator;
 
@@ -130,6 +138,10 @@ extern void btrace_teardown (struct thread_info *);
 /* Fetch the branch trace for a single thread.  */
 extern void btrace_fetch (struct thread_info *);
 
+/* Extend the function trace of BTINFO to cover all of its instruction
+   trace.  */
+extern void btrace_update_ftrace (struct btrace_thread_info *btinfo);
+
 /* Clear the branch trace for a single thread.  */
 extern void btrace_clear (struct thread_info *);
 
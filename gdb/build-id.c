@@ -28,9 +28,9 @@
 #include "objfiles.h"
 #include "filenames.h"
 
-/* Locate NT_GNU_BUILD_ID from ABFD and return its content.  */
+/* See build-id.h.  */
 
-static const struct elf_build_id *
+const struct elf_build_id *
 build_id_bfd_get (bfd *abfd)
 {
   if (!bfd_check_format (abfd, bfd_object)
@@ -111,8 +111,10 @@ build_id_to_debug_bfd (size_t build_id_len, const bfd_byte *build_id)
 	s += sprintf (s, "%02x", (unsigned) *data++);
       strcpy (s, ".debug");
 
-      /* lrealpath() is expensive even for the usually non-existent files.  */
-      if (access (link, F_OK) == 0)
+      /* lrealpath() is expensive even for the usually non-existent files,
+	 and most of them are already known missing from the cached
+	 listing of their .build-id subdirectory.  */
+      if (debug_file_may_exist (link) && access (link, F_OK) == 0)
 	filename = lrealpath (link);
 
       if (filename == NULL)
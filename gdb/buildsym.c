@@ -262,6 +262,9 @@ finish_block_internal (struct symbol *symbol, struct pending **listhead,
   block = (is_global
 	   ? allocate_global_block (&objfile->objfile_obstack)
 	   : allocate_block (&objfile->objfile_obstack));
+  OBJSTAT (objfile, sz_blocks += (is_global
+				  ? sizeof (struct global_block)
+				  : sizeof (struct block)));
 
   if (symbol)
     {
@@ -517,6 +520,8 @@ make_blockvector (struct objfile *objfile)
     obstack_alloc (&objfile->objfile_obstack,
 		   (sizeof (struct blockvector)
 		    + (i - 1) * sizeof (struct block *)));
+  OBJSTAT (objfile, sz_blocks += (sizeof (struct blockvector)
+				  + (i - 1) * sizeof (struct block *)));
 
   /* Copy the blocks into the blockvector.  This is done in reverse
      order, which happens to put the blocks into the proper order
@@ -836,6 +841,22 @@ compare_line_numbers (const void *ln1p, const void *ln2p)
   return ln1->line - ln2->line;
 }
 
+/* Return non-zero if the entries of LINETABLE are already in the order
+   compare_line_numbers would put them in.  */
+
+static int
+line_table_sorted_p (const struct linetable *linetable)
+{
+  int i;
+
+  for (i = 1; i < linetable->nitems; ++i)
+    if (compare_line_numbers (&linetable->item[i - 1],
+			      &linetable->item[i]) > 0)
+      return 0;
+
+  return 1;
+}
+
 /* Return the macro table.
    Initialize it if this is the first use.  */
 
@@ -1173,8 +1194,11 @@ end_symtab_from_static_block (struct block *static_block,
 
 	      /* Like the pending blocks, the line table may be
 	         scrambled in reordered executables.  Sort it if
-	         OBJF_REORDERED is true.  */
-	      if (objfile->flags & OBJF_REORDERED)
+	         OBJF_REORDERED is true.  Most line tables are in order
+	         already though, and they can be huge, so check that
+	         first.  */
+	      if ((objfile->flags & OBJF_REORDERED)
+		  && !line_table_sorted_p (subfile->line_vector))
 		qsort (subfile->line_vector->item,
 		       subfile->line_vector->nitems,
 		     sizeof (struct linetable_entry), compare_line_numbers);
@@ -1195,6 +1219,7 @@ end_symtab_from_static_block (struct block *static_block,
 	      symtab->linetable = (struct linetable *)
 		obstack_alloc (&objfile->objfile_obstack, linetablesize);
 	      memcpy (symtab->linetable, subfile->line_vector, linetablesize);
+	      OBJSTAT (objfile, sz_linetables += linetablesize);
 	    }
 	  else
 	    {
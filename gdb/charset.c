@@ -456,38 +456,193 @@ host_hex_value (char c)
 
 /* Public character management functions.  */
 
-/* A cleanup function which is run to close an iconv descriptor.  */
+/* Opening an iconv descriptor can take much longer than a short
+   conversion, and printing an array of strings or characters converts
+   many short strings between the same character sets.  So the
+   descriptors no longer in use are kept here, and reused by the next
+   conversion between the same character sets.  */
+
+struct cached_iconv
+{
+  /* The character sets DESC converts to and from, or NULL if this
+     entry is empty.  */
+  char *to, *from;
+
+  /* The descriptor.  */
+  iconv_t desc;
+};
+
+/* The maximum number of descriptors kept.  */
+#define MAX_CACHED_ICONVS 8
+
+static struct cached_iconv cached_iconvs[MAX_CACHED_ICONVS];
+
+/* The entry of CACHED_ICONVS that release_iconv replaces when the
+   cache is full.  */
+static int next_cached_iconv;
+
+/* Return an iconv descriptor converting from FROM to TO, like
+   iconv_open.  Release it with release_iconv rather than
+   iconv_close.  */
+
+static iconv_t
+open_iconv (const char *to, const char *from)
+{
+  int i;
+
+  for (i = 0; i < MAX_CACHED_ICONVS; ++i)
+    {
+      struct cached_iconv *entry = &cached_iconvs[i];
+
+      if (entry->to != NULL
+	  && strcmp (entry->to, to) == 0
+	  && strcmp (entry->from, from) == 0)
+	{
+	  iconv_t desc = entry->desc;
+
+	  xfree (entry->to);
+	  xfree (entry->from);
+	  entry->to = NULL;
+	  entry->from = NULL;
+
+#ifndef PHONY_ICONV
+	  /* Return the descriptor to its initial state.  */
+	  iconv (desc, NULL, NULL, NULL, NULL);
+#endif
+	  return desc;
+	}
+    }
+
+  return iconv_open (to, from);
+}
+
+/* Release DESC, a descriptor returned by open_iconv (TO, FROM).  */
 
 static void
-cleanup_iconv (void *p)
+release_iconv (iconv_t desc, const char *to, const char *from)
 {
-  iconv_t *descp = p;
-  iconv_close (*descp);
+  struct cached_iconv *entry = NULL;
+  int i;
+
+  for (i = 0; i < MAX_CACHED_ICONVS; ++i)
+    if (cached_iconvs[i].to == NULL)
+      {
+	entry = &cached_iconvs[i];
+	break;
+      }
+
+  if (entry == NULL)
+    {
+      entry = &cached_iconvs[next_cached_iconv];
+      next_cached_iconv = (next_cached_iconv + 1) % MAX_CACHED_ICONVS;
+
+      iconv_close (entry->desc);
+      xfree (entry->to);
+      xfree (entry->from);
+    }
+
+  entry->to = xstrdup (to);
+  entry->from = xstrdup (from);
+  entry->desc = desc;
 }
 
-void
-convert_between_encodings (const char *from, const char *to,
-			   const gdb_byte *bytes, unsigned int num_bytes,
-			   int width, struct obstack *output,
-			   enum transliterations translit)
+/* An iconv descriptor in use by convert_between_encodings.  */
+
+struct iconv_in_use
 {
   iconv_t desc;
-  struct cleanup *cleanups;
-  size_t inleft;
-  ICONV_CONST char *inp;
-  unsigned int space_request;
+  const char *to, *from;
+};
 
-  /* Often, the host and target charsets will be the same.  */
-  if (!strcmp (from, to))
+/* A cleanup function which is run to release an iconv descriptor.  */
+
+static void
+cleanup_iconv (void *p)
+{
+  struct iconv_in_use *use = p;
+
+  release_iconv (use->desc, use->to, use->from);
+}
+
+/* Return non-zero if CHARSET is a stateless character set that
+   encodes each ASCII character as a single code unit whose value is
+   its ASCII code, and other characters as code units from 0x80 up.
+   If so, set *WIDTH to the size of a code unit, and *BYTE_ORDER to
+   the byte order of the code units wider than a byte.  The characters
+   of such a character set that are also ASCII characters can be
+   converted without iconv.  */
+
+static int
+ascii_code_units (const char *charset, int *width,
+		  enum bfd_endian *byte_order)
+{
+  static const char *const byte_charsets[] =
+    { "ASCII", "ANSI_X3.4-1968", "US-ASCII", "UTF-8", NULL };
+  static const struct
+  {
+    const char *name;
+    int width;
+  } wide_charsets[] =
     {
-      obstack_grow (output, bytes, num_bytes);
-      return;
+      { "UTF-16", 2 },
+      { "UCS-2", 2 },
+      { "UTF-32", 4 },
+      { "UCS-4", 4 },
+      { NULL, 0 }
+    };
+  int i;
+
+  for (i = 0; byte_charsets[i] != NULL; ++i)
+    if (strcasecmp (charset, byte_charsets[i]) == 0)
+      {
+	*width = 1;
+	*byte_order = BFD_ENDIAN_UNKNOWN;
+	return 1;
+      }
+
+  if (strncasecmp (charset, "ISO-8859-", 9) == 0)
+    {
+      *width = 1;
+      *byte_order = BFD_ENDIAN_UNKNOWN;
+      return 1;
     }
 
-  desc = iconv_open (to, from);
-  if (desc == (iconv_t) -1)
-    perror_with_name (_("Converting character sets"));
-  cleanups = make_cleanup (cleanup_iconv, &desc);
+  for (i = 0; wide_charsets[i].name != NULL; ++i)
+    {
+      size_t len = strlen (wide_charsets[i].name);
+
+      /* The character sets without an explicit byte order may start
+	 with a byte order mark.  */
+      if (strncasecmp (charset, wide_charsets[i].name, len) == 0)
+	{
+	  if (strcasecmp (charset + len, "BE") == 0)
+	    *byte_order = BFD_ENDIAN_BIG;
+	  else if (strcasecmp (charset + len, "LE") == 0)
+	    *byte_order = BFD_ENDIAN_LITTLE;
+	  else
+	    return 0;
+
+	  *width = wide_charsets[i].width;
+	  return 1;
+	}
+    }
+
+  return 0;
+}
+
+/* Convert the NUM_BYTES bytes at BYTES with DESC, an iconv descriptor
+   converting to TO, appending the result to OUTPUT.  WIDTH and
+   TRANSLIT are as for convert_between_encodings.  */
+
+static void
+convert_with_iconv (iconv_t desc, const char *to,
+		    const gdb_byte *bytes, size_t num_bytes,
+		    int width, struct obstack *output,
+		    enum transliterations translit)
+{
+  size_t inleft;
+  ICONV_CONST char *inp;
+  unsigned int space_request;
 
   inleft = num_bytes;
   inp = (ICONV_CONST char *) bytes;
@@ -558,17 +713,92 @@ convert_between_encodings (const char *from, const char *to,
 	    }
 	}
     }
+}
+
+void
+convert_between_encodings (const char *from, const char *to,
+			   const gdb_byte *bytes, unsigned int num_bytes,
+			   int width, struct obstack *output,
+			   enum transliterations translit)
+{
+  struct iconv_in_use use;
+  struct cleanup *cleanups;
+  int from_width, to_width;
+  enum bfd_endian from_order, to_order;
+
+  /* Often, the host and target charsets will be the same.  */
+  if (!strcmp (from, to))
+    {
+      obstack_grow (output, bytes, num_bytes);
+      return;
+    }
+
+  use.desc = open_iconv (to, from);
+  if (use.desc == (iconv_t) -1)
+    perror_with_name (_("Converting character sets"));
+  use.to = to;
+  use.from = from;
+  cleanups = make_cleanup (cleanup_iconv, &use);
+
+  if (ascii_code_units (from, &from_width, &from_order)
+      && ascii_code_units (to, &to_width, &to_order))
+    {
+      /* Strings are mostly made of ASCII characters, so convert the
+	 runs of them directly and only hand the rest to iconv.  */
+      size_t i = 0;
+
+      while (i < num_bytes)
+	{
+	  size_t start;
+
+	  for (; i + from_width <= num_bytes; i += from_width)
+	    {
+	      ULONGEST c = extract_unsigned_integer (bytes + i, from_width,
+						     from_order);
+	      gdb_byte unit[4];
+
+	      if (c >= 0x80)
+		break;
+	      store_unsigned_integer (unit, to_width, to_order, c);
+	      obstack_grow (output, unit, to_width);
+	    }
+
+	  start = i;
+	  for (; i < num_bytes; i += from_width)
+	    if (i + from_width <= num_bytes
+		&& extract_unsigned_integer (bytes + i, from_width,
+					     from_order) < 0x80)
+	      break;
+	  if (i > num_bytes)
+	    i = num_bytes;
+
+	  if (i > start)
+	    convert_with_iconv (use.desc, to, bytes + start, i - start,
+				width, output, translit);
+	}
+    }
+  else
+    convert_with_iconv (use.desc, to, bytes, num_bytes, width, output,
+			translit);
 
   do_cleanups (cleanups);
 }
 
-
+
 
 /* An iterator that returns host wchar_t's from a target string.  */
 struct wchar_iterator
 {
-  /* The underlying iconv descriptor.  */
+  /* The underlying iconv descriptor, and the character set it
+     converts from.  */
   iconv_t desc;
+  char *charset;
+
+  /* If non-zero, the size of the code units of CHARSET, and their
+     byte order, for converting ASCII characters without DESC; see
+     ascii_code_units.  */
+  int ascii_width;
+  enum bfd_endian ascii_byte_order;
 
   /* The input string.  This is updated as convert characters.  */
   const gdb_byte *input;
@@ -590,13 +820,26 @@ make_wchar_iterator (const gdb_byte *input, size_t bytes,
 {
   struct wchar_iterator *result;
   iconv_t desc;
+  int intermediate_width;
+  enum bfd_endian intermediate_order;
 
-  desc = iconv_open (INTERMEDIATE_ENCODING, charset);
+  desc = open_iconv (INTERMEDIATE_ENCODING, charset);
   if (desc == (iconv_t) -1)
     perror_with_name (_("Converting character sets"));
 
   result = XNEW (struct wchar_iterator);
   result->desc = desc;
+  result->charset = xstrdup (charset);
+
+  /* The ASCII characters can be converted directly if they are also
+     the values of the corresponding wide characters.  */
+  if (!ascii_code_units (charset, &result->ascii_width,
+			 &result->ascii_byte_order)
+      || result->ascii_width != width
+      || !ascii_code_units (INTERMEDIATE_ENCODING, &intermediate_width,
+			    &intermediate_order)
+      || intermediate_width != sizeof (gdb_wchar_t))
+    result->ascii_width = 0;
   result->input = input;
   result->bytes = bytes;
   result->width = width;
@@ -612,7 +855,8 @@ do_cleanup_iterator (void *p)
 {
   struct wchar_iterator *iter = p;
 
-  iconv_close (iter->desc);
+  release_iconv (iter->desc, INTERMEDIATE_ENCODING, iter->charset);
+  xfree (iter->charset);
   xfree (iter->out);
   xfree (iter);
 }
@@ -630,25 +874,55 @@ wchar_iterate (struct wchar_iterator *iter,
 	       const gdb_byte **ptr,
 	       size_t *len)
 {
-  size_t out_request;
+  size_t out_request, in_request;
+  const gdb_byte *orig_inptr = iter->input;
+  size_t orig_in = iter->bytes;
+
+  /* Convert an ASCII character directly.  */
+  if (iter->ascii_width != 0 && iter->bytes >= iter->ascii_width)
+    {
+      ULONGEST c = extract_unsigned_integer (iter->input, iter->ascii_width,
+					     iter->ascii_byte_order);
+
+      if (c < 0x80)
+	{
+	  iter->out[0] = c;
+	  iter->input += iter->ascii_width;
+	  iter->bytes -= iter->ascii_width;
+
+	  *out_result = wchar_iterate_ok;
+	  *out_chars = iter->out;
+	  *ptr = orig_inptr;
+	  *len = iter->ascii_width;
+	  return 1;
+	}
+    }
 
   /* Try to convert some characters.  At first we try to convert just
      a single character.  The reason for this is that iconv does not
      necessarily update its outgoing arguments when it encounters an
      invalid input sequence -- but we want to reliably report this to
-     our caller so it can emit an escape sequence.  */
+     our caller so it can emit an escape sequence.
+
+     Likewise, we only hand iconv a few characters' worth of input at
+     a time.  Some iconv implementations take time proportional to the
+     length of the input even when there is only room for a single
+     character of output, which makes iterating over a long string
+     quadratic.  */
   out_request = 1;
+  in_request = 16 * iter->width;
   while (iter->bytes > 0)
     {
       ICONV_CONST char *inptr = (ICONV_CONST char *) iter->input;
       char *outptr = (char *) &iter->out[0];
-      const gdb_byte *orig_inptr = iter->input;
-      size_t orig_in = iter->bytes;
       size_t out_avail = out_request * sizeof (gdb_wchar_t);
+      size_t in_avail = min (iter->bytes, in_request);
+      size_t in_left = in_avail;
       size_t num;
-      size_t r = iconv (iter->desc, &inptr, &iter->bytes, &outptr, &out_avail);
+      size_t r = iconv (iter->desc, &inptr, &in_left, &outptr, &out_avail);
 
       iter->input = (gdb_byte *) inptr;
+      iter->bytes -= in_avail - in_left;
 
       if (r == (size_t) -1)
 	{
@@ -686,8 +960,18 @@ wchar_iterate (struct wchar_iterator *iter,
 	      continue;
 
 	    case EINVAL:
-	      /* Incomplete input sequence.  Let the caller know, and
-		 arrange for future calls to see EOF.  */
+	      /* Incomplete input sequence.  If we held back part of the
+		 input, offer more of it and try again.  */
+	      if (out_avail < out_request * sizeof (gdb_wchar_t))
+		break;
+	      if (in_left < iter->bytes)
+		{
+		  in_request *= 2;
+		  continue;
+		}
+
+	      /* Otherwise let the caller know, and arrange for future
+		 calls to see EOF.  */
 	      *out_result = wchar_iterate_incomplete;
 	      *ptr = iter->input;
 	      *len = iter->bytes;
@@ -25,6 +25,7 @@
 #include "cli/cli-cmds.h"
 #include "cli/cli-decode.h"
 #include "gdb_assert.h"
+#include "hashtab.h"
 
 /* Prototypes for local functions.  */
 
@@ -45,6 +46,8 @@ static struct cmd_list_element *find_cmd (const char *command,
 
 static void help_all (struct ui_file *stream);
 
+static void forget_cmd_list_indexes (void);
+
 /* Look up a command whose 'prefixlist' is KEY.  Return the command if found,
    otherwise return NULL.  */
 
@@ -196,6 +199,7 @@ add_cmd (const char *name, enum command_class class, void (*fun) (char *, int),
 			   &c->hook_post, &c->hookee_post);
   for (iter = c->aliases; iter; iter = iter->alias_chain)
     iter->cmd_pointer = c;
+  forget_cmd_list_indexes ();
   if (c->hook_pre)
     c->hook_pre->hookee_pre = c;
   if (c->hookee_pre)
@@ -807,6 +811,7 @@ delete_cmd (const char *name, struct cmd_list_element **list,
 
 	  /* Update the link.  */
 	  *previous_chain_ptr = iter->next;
+	  forget_cmd_list_indexes ();
 
 	  aliases = iter->aliases;
 
@@ -1199,6 +1204,114 @@ help_cmd_list (struct cmd_list_element *list, enum command_class class,
 }
 
 
+/* An index of a command list: its elements in an array, so that
+   find_cmd can find the commands whose name starts with a word by a
+   binary search, rather than by comparing the word with every name
+   in the list.  add_cmd keeps the lists sorted by name.  */
+
+struct cmd_list_index
+{
+  /* The first element of the list.  */
+  struct cmd_list_element *head;
+
+  int count;
+  struct cmd_list_element **elements;
+};
+
+/* The indexes of the command lists looked up so far, keyed by their
+   first element.  Adding or deleting a command forgets them all:
+   commands are rarely added once GDB has started.  */
+
+static htab_t cmd_list_indexes;
+
+/* Lists this short are searched without an index.  */
+
+#define MIN_CMD_LIST_INDEX 16
+
+static hashval_t
+hash_cmd_list_index (const void *p)
+{
+  const struct cmd_list_index *index = p;
+
+  return htab_hash_pointer (index->head);
+}
+
+static int
+eq_cmd_list_index (const void *a, const void *b)
+{
+  const struct cmd_list_index *lhs = a;
+  const struct cmd_list_index *rhs = b;
+
+  return lhs->head == rhs->head;
+}
+
+static void
+free_cmd_list_index (void *p)
+{
+  struct cmd_list_index *index = p;
+
+  xfree (index->elements);
+  xfree (index);
+}
+
+/* Forget the indexes of all the command lists, because one of them
+   has changed.  */
+
+static void
+forget_cmd_list_indexes (void)
+{
+  if (cmd_list_indexes != NULL)
+    htab_empty (cmd_list_indexes);
+}
+
+/* Return the index of the command list CLIST, or NULL if CLIST is
+   better searched without one.  */
+
+static struct cmd_list_index *
+get_cmd_list_index (struct cmd_list_element *clist)
+{
+  struct cmd_list_index key, *index;
+  struct cmd_list_element *c;
+  void **slot;
+  int count;
+
+  if (clist == NULL)
+    return NULL;
+
+  if (cmd_list_indexes == NULL)
+    cmd_list_indexes = htab_create_alloc (31, hash_cmd_list_index,
+					  eq_cmd_list_index,
+					  free_cmd_list_index,
+					  xcalloc, xfree);
+
+  key.head = clist;
+  slot = htab_find_slot (cmd_list_indexes, &key, INSERT);
+  if (*slot != NULL)
+    {
+      index = *slot;
+      return index->elements != NULL ? index : NULL;
+    }
+
+  index = XCNEW (struct cmd_list_index);
+  index->head = clist;
+  *slot = index;
+
+  /* A list that is short, or not sorted, is recorded with no
+     elements, and searched the slow way.  */
+  for (count = 0, c = clist; c != NULL; c = c->next, count++)
+    if (c->next != NULL && strcmp (c->name, c->next->name) > 0)
+      return NULL;
+  if (count < MIN_CMD_LIST_INDEX)
+    return NULL;
+
+  index->count = count;
+  index->elements = XNEWVEC (struct cmd_list_element *, count);
+  for (count = 0, c = clist; c != NULL; c = c->next)
+    index->elements[count++] = c;
+
+  return index;
+}
+
 /* Search the input clist for 'command'.  Return the command if
    found (or NULL if not), and return the number of commands
    found in nfound.  */
@@ -1208,9 +1321,31 @@ find_cmd (const char *command, int len, struct cmd_list_element *clist,
 	  int ignore_help_classes, int *nfound)
 {
   struct cmd_list_element *found, *c;
+  struct cmd_list_index *index;
 
   found = (struct cmd_list_element *) NULL;
   *nfound = 0;
+
+  index = get_cmd_list_index (clist);
+  if (index != NULL)
+    {
+      int lo = 0, hi = index->count;
+
+      /* Find the first command whose name does not sort before
+	 COMMAND.  The commands starting with COMMAND follow it, and
+	 are the only ones that can match.  */
+      while (lo < hi)
+	{
+	  int mid = lo + (hi - lo) / 2;
+
+	  if (strncmp (index->elements[mid]->name, command, len) < 0)
+	    lo = mid + 1;
+	  else
+	    hi = mid;
+	}
+      clist = lo < index->count ? index->elements[lo] : NULL;
+    }
+
   for (c = clist; c; c = c->next)
     if (!strncmp (command, c->name, len)
 	&& (!ignore_help_classes || c->func))
@@ -1223,6 +1358,8 @@ find_cmd (const char *command, int len, struct cmd_list_element *clist,
 	    break;
 	  }
       }
+    else if (index != NULL && strncmp (command, c->name, len) != 0)
+      break;
   return found;
 }
 
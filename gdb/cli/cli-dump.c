@@ -170,6 +170,25 @@ append_command (char *cmd, int from_tty)
   help_list (dump_cmdlist, "append ", -1, gdb_stdout);
 }
 
+/* The amount of memory dump and restore transfer at a time.  This is
+   large enough for the target to pipeline its side of the transfer,
+   while dumping or restoring a huge region still only needs this much
+   memory in GDB.  */
+#define DUMP_CHUNK_SIZE (1024 * 1024)
+
+/* When dumping memory to a new binary file, blocks of this many zero
+   bytes are skipped rather than written, leaving holes in the file on
+   file systems that support them.  */
+#define DUMP_HOLE_SIZE 4096
+
+/* Return non-zero if the LEN bytes at BUF are all zero.  */
+
+static int
+zero_block_p (const gdb_byte *buf, size_t len)
+{
+  return len > 0 && buf[0] == 0 && memcmp (buf, buf + 1, len - 1) == 0;
+}
+
 static void
 dump_binary_file (const char *filename, const char *mode, 
 		  const bfd_byte *buf, ULONGEST len)
@@ -183,15 +202,14 @@ dump_binary_file (const char *filename, const char *mode,
     perror_with_name (filename);
 }
 
-static void
-dump_bfd_file (const char *filename, const char *mode, 
-	       const char *target, CORE_ADDR vaddr, 
-	       const bfd_byte *buf, ULONGEST len)
+/* Create the single section of a dump file OBFD, for LEN bytes at
+   VADDR.  */
+
+static asection *
+make_dump_section (bfd *obfd, CORE_ADDR vaddr, ULONGEST len)
 {
-  bfd *obfd;
   asection *osection;
 
-  obfd = bfd_openw_with_cleanup (filename, target, mode);
   osection = bfd_make_section_anyway (obfd, ".newsec");
   bfd_set_section_size (obfd, osection, len);
   bfd_set_section_vma (obfd, osection, vaddr);
@@ -200,11 +218,121 @@ dump_bfd_file (const char *filename, const char *mode,
 					  | SEC_ALLOC
 					  | SEC_LOAD));
   osection->entsize = 0;
+  return osection;
+}
+
+static void
+dump_bfd_file (const char *filename, const char *mode, 
+	       const char *target, CORE_ADDR vaddr, 
+	       const bfd_byte *buf, ULONGEST len)
+{
+  bfd *obfd;
+  asection *osection;
+
+  obfd = bfd_openw_with_cleanup (filename, target, mode);
+  osection = make_dump_section (obfd, vaddr, len);
   if (!bfd_set_section_contents (obfd, osection, buf, 0, len))
     warning (_("writing dump file '%s' (%s)"), filename, 
 	     bfd_errmsg (bfd_get_error ()));
 }
 
+/* Dump the COUNT bytes of target memory at LO to the binary file
+   FILENAME, opened with MODE, DUMP_CHUNK_SIZE bytes at a time.  */
+
+static void
+dump_binary_memory_file (const char *filename, const char *mode,
+			 CORE_ADDR lo, ULONGEST count)
+{
+  struct cleanup *cleanup;
+  FILE *file;
+  gdb_byte *buf;
+  ULONGEST done;
+  /* Holes only make sense when writing a file from the start; in
+     append mode every write goes to the end anyway.  */
+  int sparse = (mode[0] == 'w');
+  int trailing_hole = 0;
+
+  file = fopen_with_cleanup (filename, mode);
+  buf = xmalloc (min (count, DUMP_CHUNK_SIZE));
+  cleanup = make_cleanup (xfree, buf);
+
+  for (done = 0; done < count; )
+    {
+      size_t len = min (count - done, DUMP_CHUNK_SIZE);
+      size_t pos, block;
+
+      QUIT;
+      read_memory (lo + done, buf, len);
+
+      for (pos = 0; pos < len; pos += block)
+	{
+	  block = min (len - pos, DUMP_HOLE_SIZE);
+	  if (sparse && block == DUMP_HOLE_SIZE
+	      && zero_block_p (buf + pos, block))
+	    {
+	      if (fseek (file, block, SEEK_CUR) != 0)
+		perror_with_name (filename);
+	      trailing_hole = 1;
+	    }
+	  else
+	    {
+	      if (fwrite (buf + pos, block, 1, file) != 1)
+		perror_with_name (filename);
+	      trailing_hole = 0;
+	    }
+	}
+
+      done += len;
+    }
+
+  /* Seeking past the end does not extend the file; write its last
+     byte so that a trailing hole is part of it.  */
+  if (trailing_hole)
+    {
+      if (fseek (file, -1, SEEK_CUR) != 0
+	  || fputc (0, file) == EOF)
+	perror_with_name (filename);
+    }
+
+  do_cleanups (cleanup);
+}
+
+/* Dump the COUNT bytes of target memory at LO to FILENAME, a file of
+   BFD target TARGET opened with MODE, DUMP_CHUNK_SIZE bytes at a
+   time.  */
+
+static void
+dump_bfd_memory_file (const char *filename, const char *mode,
+		      const char *target, CORE_ADDR lo, ULONGEST count)
+{
+  struct cleanup *cleanup;
+  bfd *obfd;
+  asection *osection;
+  gdb_byte *buf;
+  ULONGEST done;
+
+  obfd = bfd_openw_with_cleanup (filename, target, mode);
+  osection = make_dump_section (obfd, lo, count);
+  buf = xmalloc (min (count, DUMP_CHUNK_SIZE));
+  cleanup = make_cleanup (xfree, buf);
+
+  for (done = 0; done < count; done += DUMP_CHUNK_SIZE)
+    {
+      size_t len = min (count - done, DUMP_CHUNK_SIZE);
+
+      QUIT;
+      read_memory (lo + done, buf, len);
+      if (!bfd_set_section_contents (obfd, osection, buf, done, len))
+	{
+	  warning (_("writing dump file '%s' (%s)"), filename,
+		   bfd_errmsg (bfd_get_error ()));
+	  break;
+	}
+    }
+
+  do_cleanups (cleanup);
+}
+
 static void
 dump_memory_to_file (char *cmd, char *mode, char *file_format)
 {
@@ -213,7 +341,6 @@ dump_memory_to_file (char *cmd, char *mode, char *file_format)
   CORE_ADDR hi;
   ULONGEST count;
   char *filename;
-  void *buf;
   char *lo_exp;
   char *hi_exp;
 
@@ -236,20 +363,14 @@ dump_memory_to_file (char *cmd, char *mode, char *file_format)
     error (_("Invalid memory address range (start >= end)."));
   count = hi - lo;
 
-  /* FIXME: Should use read_memory_partial() and a magic blocking
-     value.  */
-  buf = xmalloc (count);
-  make_cleanup (xfree, buf);
-  read_memory (lo, buf, count);
-  
-  /* Have everything.  Open/write the data.  */
+  /* Open the file and stream the memory into it.  */
   if (file_format == NULL || strcmp (file_format, "binary") == 0)
     {
-      dump_binary_file (filename, mode, buf, count);
+      dump_binary_memory_file (filename, mode, lo, count);
     }
   else
     {
-      dump_bfd_file (filename, mode, file_format, lo, buf, count);
+      dump_bfd_memory_file (filename, mode, file_format, lo, count);
     }
 
   do_cleanups (old_cleanups);
@@ -442,6 +563,7 @@ restore_section_callback (bfd *ibfd, asection *isec, void *args)
   bfd_vma sec_end    = sec_start + size;
   bfd_size_type sec_offset = 0;
   bfd_size_type sec_load_count = size;
+  bfd_size_type done;
   struct cleanup *old_chain;
   gdb_byte *buf;
   int ret;
@@ -470,13 +592,6 @@ restore_section_callback (bfd *ibfd, asection *isec, void *args)
   if (data->load_end > 0 && sec_end > data->load_end)
     sec_load_count -= sec_end - data->load_end;
 
-  /* Get the data.  */
-  buf = xmalloc (size);
-  old_chain = make_cleanup (xfree, buf);
-  if (!bfd_get_section_contents (ibfd, isec, buf, 0, size))
-    error (_("Failed to read bfd file %s: '%s'."), bfd_get_filename (ibfd), 
-	   bfd_errmsg (bfd_get_error ()));
-
   printf_filtered ("Restoring section %s (0x%lx to 0x%lx)",
 		   bfd_section_name (ibfd, isec), 
 		   (unsigned long) sec_start, 
@@ -493,11 +608,27 @@ restore_section_callback (bfd *ibfd, asection *isec, void *args)
   else
     puts_filtered ("\n");
 
-  /* Write the data.  */
-  ret = target_write_memory (sec_start + sec_offset + data->load_offset, 
-			     buf + sec_offset, sec_load_count);
-  if (ret != 0)
-    warning (_("restore: memory write failed (%s)."), safe_strerror (ret));
+  /* Copy the data, DUMP_CHUNK_SIZE bytes at a time.  */
+  buf = xmalloc (min (sec_load_count, DUMP_CHUNK_SIZE));
+  old_chain = make_cleanup (xfree, buf);
+  for (done = 0; done < sec_load_count; done += DUMP_CHUNK_SIZE)
+    {
+      bfd_size_type len = min (sec_load_count - done, DUMP_CHUNK_SIZE);
+
+      QUIT;
+      if (!bfd_get_section_contents (ibfd, isec, buf, sec_offset + done, len))
+	error (_("Failed to read bfd file %s: '%s'."),
+	       bfd_get_filename (ibfd), bfd_errmsg (bfd_get_error ()));
+
+      ret = target_write_memory (sec_start + sec_offset + done
+				 + data->load_offset, buf, len);
+      if (ret != 0)
+	{
+	  warning (_("restore: memory write failed (%s)."),
+		   safe_strerror (ret));
+	  break;
+	}
+    }
   do_cleanups (old_chain);
   return;
 }
@@ -508,7 +639,8 @@ restore_binary_file (char *filename, struct callback_data *data)
   struct cleanup *cleanup = make_cleanup (null_cleanup, NULL);
   FILE *file = fopen_with_cleanup (filename, FOPEN_RB);
   gdb_byte *buf;
-  long len;
+  long len, done;
+  int ret;
 
   /* Get the file size for reading.  */
   if (fseek (file, 0, SEEK_END) == 0)
@@ -541,16 +673,27 @@ restore_binary_file (char *filename, struct callback_data *data)
   if (fseek (file, data->load_start, SEEK_SET) != 0)
     perror_with_name (filename);
 
-  /* Now allocate a buffer and read the file contents.  */
-  buf = xmalloc (len);
+  /* Now copy the file contents into target memory, DUMP_CHUNK_SIZE
+     bytes at a time.  */
+  buf = xmalloc (min (len, DUMP_CHUNK_SIZE));
   make_cleanup (xfree, buf);
-  if (fread (buf, 1, len, file) != len)
-    perror_with_name (filename);
+  for (done = 0; done < len; done += DUMP_CHUNK_SIZE)
+    {
+      long count = min (len - done, DUMP_CHUNK_SIZE);
 
-  /* Now write the buffer into target memory.  */
-  len = target_write_memory (data->load_start + data->load_offset, buf, len);
-  if (len != 0)
-    warning (_("restore: memory write failed (%s)."), safe_strerror (len));
+      QUIT;
+      if (fread (buf, 1, count, file) != count)
+	perror_with_name (filename);
+
+      ret = target_write_memory (data->load_start + data->load_offset + done,
+				 buf, count);
+      if (ret != 0)
+	{
+	  warning (_("restore: memory write failed (%s)."),
+		   safe_strerror (ret));
+	  break;
+	}
+    }
   do_cleanups (cleanup);
 }
 
@@ -31,6 +31,10 @@
 #include "cli/cli-decode.h"
 #include "cli/cli-script.h"
 #include "gdb_assert.h"
+#include "block.h"
+#include "source.h"
+#include "symtab.h"
+#include "observer.h"
 
 #include "python/python.h"
 #include "interps.h"
@@ -93,6 +97,7 @@ build_command_line (enum command_control_type type, char *args)
   cmd = (struct command_line *) xmalloc (sizeof (struct command_line));
   cmd->next = NULL;
   cmd->control_type = type;
+  cmd->condition = NULL;
 
   cmd->body_count = 1;
   cmd->body_list
@@ -395,10 +400,148 @@ print_command_trace (const char *cmd)
   printf_filtered ("%s\n", cmd);
 }
 
+/* A parsed "if" or "while" condition.  It is kept with its command
+   line, so that a conditional in the body of a loop, or in a script
+   or user-defined command that is run many times, is not parsed again
+   each time it is run.  */
+
+struct control_condition
+{
+  /* The command line the condition belongs to.  */
+  struct command_line *cmd;
+
+  /* The text of the condition, after insert_args.  */
+  char *text;
+
+  /* The context the condition was parsed in.  */
+  const struct block *block;
+  CORE_ADDR pc;
+  const struct language_defn *language;
+  unsigned int generation;
+
+  struct expression *expr;
+};
+
+/* Incremented whenever the symbols or the settings that a condition
+   was parsed with may have changed, so that no condition parsed
+   before is used again.  */
+
+static unsigned int control_condition_generation;
+
+static void
+free_control_condition (struct control_condition *cond)
+{
+  xfree (cond->text);
+  xfree (cond->expr);
+  xfree (cond);
+}
+
+static void
+free_control_condition_cleanup (void *arg)
+{
+  free_control_condition (arg);
+}
+
+/* Find the block and the pc that parse_expression would parse an
+   expression in.  */
+
+static const struct block *
+control_condition_block (CORE_ADDR *pc)
+{
+  const struct block *block = get_selected_block (pc);
+
+  if (block == NULL)
+    {
+      struct symtab_and_line cursal = get_current_source_symtab_and_line ();
+
+      *pc = 0;
+      if (cursal.symtab != NULL)
+	block = BLOCKVECTOR_BLOCK (BLOCKVECTOR (cursal.symtab), STATIC_BLOCK);
+    }
+
+  return block;
+}
+
+/* Return the parsed condition TEXT of the "if" or "while" command
+   CMD.  The condition is parsed anew unless CMD has one that was
+   parsed from the same text in the same context.  The caller gets
+   the condition for itself; keep_control_condition gives it back to
+   CMD.  */
+
+static struct control_condition *
+get_control_condition (struct command_line *cmd, char *text)
+{
+  struct control_condition *cond = cmd->condition;
+  struct cleanup *old_chain;
+  const struct block *block;
+  CORE_ADDR pc;
+
+  block = control_condition_block (&pc);
+  if (cond != NULL
+      && cond->block == block
+      && cond->pc == pc
+      && cond->language == current_language
+      && cond->generation == control_condition_generation
+      && strcmp (cond->text, text) == 0)
+    {
+      /* While it is in use, a recursive run of the same command line
+	 must not free it.  */
+      cmd->condition = NULL;
+      return cond;
+    }
+
+  cond = XCNEW (struct control_condition);
+  old_chain = make_cleanup (free_control_condition_cleanup, cond);
+  cond->cmd = cmd;
+  cond->text = xstrdup (text);
+  cond->expr = parse_expression (text);
+  cond->block = block;
+  cond->pc = pc;
+  cond->language = current_language;
+  cond->generation = control_condition_generation;
+  discard_cleanups (old_chain);
+
+  return cond;
+}
+
+/* Give COND, returned by get_control_condition, back to its command
+   line.  */
+
+static void
+keep_control_condition (void *arg)
+{
+  struct control_condition *cond = arg;
+
+  if (cond->cmd->condition != NULL)
+    free_control_condition (cond->cmd->condition);
+  cond->cmd->condition = cond;
+}
+
+/* Forget the parsed conditions when what they were parsed with may
+   have changed.  */
+
+static void
+control_condition_new_objfile (struct objfile *objfile)
+{
+  control_condition_generation++;
+}
+
+static void
+control_condition_free_objfile (struct objfile *objfile)
+{
+  control_condition_generation++;
+}
+
+static void
+control_condition_param_changed (const char *param, const char *value)
+{
+  control_condition_generation++;
+}
+
 enum command_control_type
 execute_control_command (struct command_line *cmd)
 {
-  struct expression *expr;
+  struct control_condition *cond;
   struct command_line *current;
   struct cleanup *old_chain = make_cleanup (null_cleanup, 0);
   struct value *val;
@@ -452,8 +595,8 @@ execute_control_command (struct command_line *cmd)
 	if (!new_line)
 	  break;
 	make_cleanup (free_current_contents, &new_line);
-	expr = parse_expression (new_line);
-	make_cleanup (free_current_contents, &expr);
+	cond = get_control_condition (cmd, new_line);
+	make_cleanup (keep_control_condition, cond);
 
 	ret = simple_control;
 	loop = 1;
@@ -467,7 +610,7 @@ execute_control_command (struct command_line *cmd)
 
 	    /* Evaluate the expression.  */
 	    val_mark = value_mark ();
-	    val = evaluate_expression (expr);
+	    val = evaluate_expression (cond->expr);
 	    cond_result = value_true (val);
 	    value_free_to_mark (val_mark);
 
@@ -521,15 +664,15 @@ execute_control_command (struct command_line *cmd)
 	  break;
 	make_cleanup (free_current_contents, &new_line);
 	/* Parse the conditional for the if statement.  */
-	expr = parse_expression (new_line);
-	make_cleanup (free_current_contents, &expr);
+	cond = get_control_condition (cmd, new_line);
+	make_cleanup (keep_control_condition, cond);
 
 	current = NULL;
 	ret = simple_control;
 
 	/* Evaluate the conditional.  */
 	val_mark = value_mark ();
-	val = evaluate_expression (expr);
+	val = evaluate_expression (cond->expr);
 
 	/* Choose which arm to take commands from based on the value
 	   of the conditional expression.  */
@@ -1016,6 +1159,7 @@ process_next_line (char *p, struct command_line **command, int parse_commands,
 	  (*command)->control_type = break_control;
 	  (*command)->body_count = 0;
 	  (*command)->body_list = NULL;
+	  (*command)->condition = NULL;
 	}
       else if (p_end - p == 13 && !strncmp (p, "loop_continue", 13))
 	{
@@ -1026,6 +1170,7 @@ process_next_line (char *p, struct command_line **command, int parse_commands,
 	  (*command)->control_type = continue_control;
 	  (*command)->body_count = 0;
 	  (*command)->body_list = NULL;
+	  (*command)->condition = NULL;
 	}
       else
 	not_handled = 1;
@@ -1041,6 +1186,7 @@ process_next_line (char *p, struct command_line **command, int parse_commands,
       (*command)->control_type = simple_control;
       (*command)->body_count = 0;
       (*command)->body_list = NULL;
+      (*command)->condition = NULL;
     }
 
   if (validator)
@@ -1331,6 +1477,8 @@ free_command_lines (struct command_line **lptr)
 	    free_command_lines (blist);
 	}
       next = l->next;
+      if (l->condition != NULL)
+	free_control_condition (l->condition);
       xfree (l->line);
       xfree (l);
       l = next;
@@ -1363,6 +1511,7 @@ copy_command_lines (struct command_line *cmds)
       result->line = xstrdup (cmds->line);
       result->control_type = cmds->control_type;
       result->body_count = cmds->body_count;
+      result->condition = NULL;
       if (cmds->body_count > 0)
         {
           int i;
@@ -1698,6 +1847,10 @@ initialize_file_ftype _initialize_cli_script;
 void
 _initialize_cli_script (void)
 {
+  observer_attach_new_objfile (control_condition_new_objfile);
+  observer_attach_free_objfile (control_condition_free_objfile);
+  observer_attach_command_param_changed (control_condition_param_changed);
+
   add_com ("document", class_support, document_command, _("\
 Document a user-defined command.\n\
 Give command name as argument.  Give documentation on following lines.\n\
@@ -87,6 +87,14 @@ int
 agent_look_up_symbols (void *arg)
 {
   int i;
+#ifdef GDBSERVER
+  const char *names[sizeof (symbol_list) / sizeof (symbol_list[0])];
+
+  /* Ask GDB for all of them at once, if it can.  */
+  for (i = 0; i < sizeof (symbol_list) / sizeof (symbol_list[0]); i++)
+    names[i] = symbol_list[i].name;
+  look_up_symbols (names, i);
+#endif
 
   all_agent_symbols_looked_up = 0;
 
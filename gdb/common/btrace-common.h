@@ -67,7 +67,13 @@ enum btrace_read_type
   btrace_read_all,
 
   /* Send all available trace, if it changed.  */
-  btrace_read_new
+  btrace_read_new,
+
+  /* Send the trace added since the last read, if it changed.  The oldest
+     block then has a zero begin address, since it continues the newest
+     block of the last read.  If some of that trace was lost, send all
+     available trace instead, as for btrace_read_all.  */
+  btrace_read_delta
 };
 
 #endif /* BTRACE_COMMON_H */
@@ -168,20 +168,27 @@ perf_event_sample_ok (const struct perf_event_sample *sample)
    s1.to and b.end = s2.from.
 
    In case the buffer overflows during sampling, one sample may have its lower
-   part at the end and its upper part at the beginning of the buffer.  */
+   part at the end and its upper part at the beginning of the buffer.
+
+   We read at most SIZE bytes of samples.  If DELTA is non-zero, these are
+   the samples added since the last read, and we also push the block that
+   leads from the last read to the oldest of them, with a zero begin
+   address.  */
 
 static VEC (btrace_block_s) *
 perf_event_read_bts (struct btrace_target_info* tinfo, const uint8_t *begin,
-		     const uint8_t *end, const uint8_t *start)
+		     const uint8_t *end, const uint8_t *start, size_t size,
+		     int delta)
 {
   VEC (btrace_block_s) *btrace = NULL;
   struct perf_event_sample sample;
-  size_t read = 0, size = (end - begin);
+  size_t read = 0;
   struct btrace_block block = { 0, 0 };
   struct regcache *regcache;
 
   gdb_assert (begin <= start);
   gdb_assert (start <= end);
+  gdb_assert (size <= (size_t) (end - begin));
 
   /* The first block ends at the current pc.  */
 #ifdef GDBSERVER
@@ -237,6 +244,7 @@ perf_event_read_bts (struct btrace_target_info* tinfo, const uint8_t *begin,
       if (!perf_event_sample_ok (psample))
 	{
 	  warning (_("Branch trace may be incomplete."));
+	  delta = 0;
 	  break;
 	}
 
@@ -252,6 +260,12 @@ perf_event_read_bts (struct btrace_target_info* tinfo, const uint8_t *begin,
       block.end = psample->bts.from;
     }
 
+  if (delta)
+    {
+      block.begin = 0;
+      VEC_safe_push (btrace_block_s, btrace, &block);
+    }
+
   return btrace;
 }
 
@@ -507,9 +521,10 @@ linux_read_btrace (struct btrace_target_info *tinfo,
   volatile struct perf_event_mmap_page *header;
   const uint8_t *begin, *end, *start;
   unsigned long data_head, retries = 5;
-  size_t buffer_size;
+  size_t buffer_size, size;
+  int delta;
 
-  if (type == btrace_read_new && !linux_btrace_has_changed (tinfo))
+  if (type != btrace_read_all && !linux_btrace_has_changed (tinfo))
     return NULL;
 
   header = perf_event_header (tinfo);
@@ -532,7 +547,17 @@ linux_read_btrace (struct btrace_target_info *tinfo,
 	  else
 	    end = perf_event_buffer_end (tinfo);
 
-	  btrace = perf_event_read_bts (tinfo, begin, end, start);
+	  /* Only read the samples added since the last read, if we were
+	     asked to and if none of them were overwritten.  */
+	  size = end - begin;
+	  delta = (type == btrace_read_delta
+		   && data_head - tinfo->data_head <= size);
+	  if (delta)
+	    size = data_head - tinfo->data_head;
+
+	  VEC_free (btrace_block_s, btrace);
+	  btrace = perf_event_read_bts (tinfo, begin, end, start, size,
+					delta);
 	}
 
       /* The stopping thread notifies its ptracer before it is scheduled out.
@@ -25,6 +25,8 @@
 
 #include "linux-procfs.h"
 #include "filestuff.h"
+#include "gdb_dirent.h"
+#include <ctype.h>
 
 /* Return the TGID of LWPID from /proc/pid/status.  Returns -1 if not
    found.  */
@@ -119,3 +121,30 @@ linux_proc_pid_is_zombie (pid_t pid)
 {
   return linux_proc_pid_has_state (pid, "Z (zombie)");
 }
+
+/* See linux-procfs.h declaration.  */
+
+int
+linux_proc_iterate_tasks (pid_t pid, linux_proc_task_func func, void *data)
+{
+  char path[64];
+  DIR *dir;
+  struct dirent *dp;
+
+  snprintf (path, sizeof (path), "/proc/%d/task", (int) pid);
+  dir = opendir (path);
+  if (dir == NULL)
+    return -1;
+
+  while ((dp = readdir (dir)) != NULL)
+    {
+      if (!isdigit (dp->d_name[0]))
+	continue;
+
+      if (func (atoi (dp->d_name), data))
+	break;
+    }
+
+  closedir (dir);
+  return 0;
+}
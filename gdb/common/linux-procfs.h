@@ -40,4 +40,16 @@ extern int linux_proc_pid_is_stopped (pid_t pid);
 
 extern int linux_proc_pid_is_zombie (pid_t pid);
 
+/* Callback for linux_proc_iterate_tasks.  LWPID is the LWP id of one
+   of the tasks.  Return non-zero to stop the iteration.  */
+
+typedef int (*linux_proc_task_func) (pid_t lwpid, void *data);
+
+/* Call FUNC with DATA for each task listed in /proc/PID/task, until
+   FUNC returns non-zero.  Returns -1 if the list could not be read,
+   0 otherwise.  */
+
+extern int linux_proc_iterate_tasks (pid_t pid, linux_proc_task_func func,
+				     void *data);
+
 #endif /* COMMON_LINUX_PROCFS_H */
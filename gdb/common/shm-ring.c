@@ -0,0 +1,512 @@
+/* Shared memory transport between GDB and gdbserver.
+   Copyright (C) 2013 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef GDBSERVER
+#include "server.h"
+#else
+#include "defs.h"
+#include "gdb_string.h"
+#endif
+
+#ifndef USE_WIN32API
+
+#include "shm-ring.h"
+#include "filestuff.h"
+#include "gdb_stat.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+
+/* How long gdbserver waits for GDB to finish connecting, once GDB
+   opened its doorbell, in milliseconds.  */
+
+#define SHM_CONNECT_TIMEOUT 10000
+
+/* Order the accesses to the shared file before this call with those
+   after it, as seen by the peer.  */
+
+static void
+shm_barrier (void)
+{
+  __sync_synchronize ();
+}
+
+/* Return the name of the doorbell of the side receiving the bytes of
+   the ring NAME, for the shared file PATH.  The result is
+   xmalloc'd.  */
+
+static char *
+shm_doorbell_name (const char *path, const char *name)
+{
+  return xstrprintf ("%s.%s", path, name);
+}
+
+/* Ring the peer's doorbell if it may be asleep, or unconditionally
+   if FORCE.  Return 0, or -1 with errno set if the peer went away.  */
+
+static int
+shm_ring_doorbell (struct shm_channel *ch, int force)
+{
+  shm_barrier ();
+  if (force || ch->out->waiting)
+    {
+      while (write (ch->out_fd, "", 1) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  /* A full doorbell already has a byte for the peer.  */
+	  if (errno == EAGAIN || errno == EWOULDBLOCK)
+	    break;
+	  return -1;
+	}
+    }
+
+  return 0;
+}
+
+/* See shm-ring.h.  */
+
+int
+shm_channel_listen (const char *path, struct shm_channel *ch)
+{
+  char *in_name, *out_name;
+  void *map;
+  int fd, i;
+
+  memset (ch, 0, sizeof (*ch));
+  ch->in_fd = -1;
+  ch->out_fd = -1;
+
+  fd = gdb_open_cloexec (path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0)
+    return -1;
+  if (ftruncate (fd, sizeof (struct shm_segment)) < 0)
+    {
+      int saved_errno = errno;
+
+      close (fd);
+      unlink (path);
+      errno = saved_errno;
+      return -1;
+    }
+  map = mmap (NULL, sizeof (struct shm_segment), PROT_READ | PROT_WRITE,
+	      MAP_SHARED, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    {
+      int saved_errno = errno;
+
+      unlink (path);
+      errno = saved_errno;
+      return -1;
+    }
+
+  ch->segment = map;
+  ch->path = xstrdup (path);
+  ch->in = &ch->segment->to_server;
+  ch->out = &ch->segment->to_client;
+
+  /* gdbserver always waits for GDB in its event loop.  */
+  ch->stay_armed = 1;
+  ch->in->waiting = 1;
+
+  in_name = shm_doorbell_name (path, "to-server");
+  out_name = shm_doorbell_name (path, "to-client");
+  unlink (in_name);
+  unlink (out_name);
+  if (mkfifo (in_name, 0600) < 0 || mkfifo (out_name, 0600) < 0)
+    goto fail;
+
+  ch->in_fd = gdb_open_cloexec (in_name, O_RDONLY | O_NONBLOCK, 0);
+  if (ch->in_fd < 0)
+    goto fail;
+
+  shm_barrier ();
+  ch->segment->magic = SHM_SEGMENT_MAGIC;
+
+  /* This waits for GDB to open its doorbell.  */
+  do
+    ch->out_fd = gdb_open_cloexec (out_name, O_WRONLY, 0);
+  while (ch->out_fd < 0 && errno == EINTR);
+  if (ch->out_fd < 0)
+    goto fail;
+  fcntl (ch->out_fd, F_SETFL, O_NONBLOCK);
+
+  for (i = 0; !ch->segment->connected; i++)
+    {
+      if (i == SHM_CONNECT_TIMEOUT)
+	{
+	  errno = ETIMEDOUT;
+	  goto fail;
+	}
+      usleep (1000);
+    }
+  shm_barrier ();
+
+  xfree (in_name);
+  xfree (out_name);
+  return 0;
+
+ fail:
+  {
+    int saved_errno = errno;
+
+    xfree (in_name);
+    xfree (out_name);
+    shm_channel_close (ch);
+    errno = saved_errno;
+    return -1;
+  }
+}
+
+/* See shm-ring.h.  */
+
+int
+shm_channel_connect (const char *path, struct shm_channel *ch)
+{
+  char *in_name = NULL, *out_name = NULL;
+  struct stat st;
+  void *map;
+  int fd;
+
+  memset (ch, 0, sizeof (*ch));
+  ch->in_fd = -1;
+  ch->out_fd = -1;
+
+  fd = gdb_open_cloexec (path, O_RDWR, 0);
+  if (fd < 0)
+    return -1;
+  if (fstat (fd, &st) < 0
+      || st.st_size < sizeof (struct shm_segment))
+    {
+      close (fd);
+      errno = ECONNREFUSED;
+      return -1;
+    }
+  map = mmap (NULL, sizeof (struct shm_segment), PROT_READ | PROT_WRITE,
+	      MAP_SHARED, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    return -1;
+
+  ch->segment = map;
+  ch->in = &ch->segment->to_client;
+  ch->out = &ch->segment->to_server;
+  if (ch->segment->magic != SHM_SEGMENT_MAGIC)
+    {
+      errno = ECONNREFUSED;
+      goto fail;
+    }
+  shm_barrier ();
+
+  in_name = shm_doorbell_name (path, "to-client");
+  out_name = shm_doorbell_name (path, "to-server");
+  ch->in_fd = gdb_open_cloexec (in_name, O_RDONLY | O_NONBLOCK, 0);
+  if (ch->in_fd < 0)
+    goto fail;
+
+  /* This fails with ENXIO if no gdbserver is listening; the file was
+     left behind by an earlier session.  */
+  ch->out_fd = gdb_open_cloexec (out_name, O_WRONLY | O_NONBLOCK, 0);
+  if (ch->out_fd < 0)
+    {
+      if (errno == ENXIO)
+	errno = ECONNREFUSED;
+      goto fail;
+    }
+
+  shm_barrier ();
+  ch->segment->connected = 1;
+
+  xfree (in_name);
+  xfree (out_name);
+  return 0;
+
+ fail:
+  {
+    int saved_errno = errno;
+
+    xfree (in_name);
+    xfree (out_name);
+    shm_channel_close (ch);
+    errno = saved_errno;
+    return -1;
+  }
+}
+
+/* See shm-ring.h.  */
+
+void
+shm_channel_close (struct shm_channel *ch)
+{
+  if (ch->in_fd >= 0)
+    close (ch->in_fd);
+  if (ch->out_fd >= 0)
+    close (ch->out_fd);
+  if (ch->segment != NULL)
+    munmap (ch->segment, sizeof (struct shm_segment));
+
+  if (ch->path != NULL)
+    {
+      char *name;
+
+      name = shm_doorbell_name (ch->path, "to-server");
+      unlink (name);
+      xfree (name);
+      name = shm_doorbell_name (ch->path, "to-client");
+      unlink (name);
+      xfree (name);
+      unlink (ch->path);
+      xfree (ch->path);
+    }
+
+  memset (ch, 0, sizeof (*ch));
+  ch->in_fd = -1;
+  ch->out_fd = -1;
+}
+
+/* See shm-ring.h.  */
+
+int
+shm_channel_pending_p (struct shm_channel *ch)
+{
+  return ch->in->head != ch->in->tail;
+}
+
+/* See shm-ring.h.  */
+
+int
+shm_channel_read (struct shm_channel *ch, void *buf, int count)
+{
+  struct shm_ring *ring = ch->in;
+  unsigned int head = ring->head;
+  unsigned int tail = ring->tail;
+  int done = 0;
+
+  /* Read the data only after seeing HEAD move past it.  */
+  shm_barrier ();
+
+  if (count > head - tail)
+    count = head - tail;
+  while (done < count)
+    {
+      unsigned int offset = (tail + done) & (SHM_RING_SIZE - 1);
+      int chunk = SHM_RING_SIZE - offset;
+
+      if (chunk > count - done)
+	chunk = count - done;
+      memcpy ((gdb_byte *) buf + done, ring->data + offset, chunk);
+      done += chunk;
+    }
+
+  /* Only give the room back once the data was copied.  */
+  shm_barrier ();
+  ring->tail = tail + count;
+  return count;
+}
+
+/* See shm-ring.h.  */
+
+int
+shm_channel_write (struct shm_channel *ch, const void *buf, int count)
+{
+  struct shm_ring *ring = ch->out;
+  const gdb_byte *p = buf;
+  int left = count;
+
+  while (left > 0)
+    {
+      unsigned int head = ring->head;
+      unsigned int room = SHM_RING_SIZE - (head - ring->tail);
+      unsigned int offset = head & (SHM_RING_SIZE - 1);
+      int chunk;
+
+      if (room == 0)
+	{
+	  /* The peer has not caught up yet.  Ringing its doorbell
+	     also tells whether it is still there.  */
+	  if (shm_ring_doorbell (ch, 1) < 0)
+	    return -1;
+	  usleep (10);
+	  continue;
+	}
+
+      chunk = SHM_RING_SIZE - offset;
+      if (chunk > room)
+	chunk = room;
+      if (chunk > left)
+	chunk = left;
+      memcpy (ring->data + offset, p, chunk);
+
+      /* Publish the data before the new HEAD.  */
+      shm_barrier ();
+      ring->head = head + chunk;
+      p += chunk;
+      left -= chunk;
+
+      if (shm_ring_doorbell (ch, 0) < 0)
+	return -1;
+    }
+
+  return count;
+}
+
+/* See shm-ring.h.  */
+
+int
+shm_channel_drain (struct shm_channel *ch)
+{
+  char buf[64];
+
+  while (1)
+    {
+      int n = read (ch->in_fd, buf, sizeof (buf));
+
+      if (n > 0)
+	continue;
+      if (n == 0)
+	{
+	  /* No writer is left: the peer went away.  */
+	  errno = EPIPE;
+	  return -1;
+	}
+      if (errno == EINTR)
+	continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+	return 0;
+      return -1;
+    }
+}
+
+/* See shm-ring.h.  */
+
+int
+shm_channel_spin (struct shm_channel *ch)
+{
+  static long ncpus;
+  struct timeval start, now;
+
+  /* On a single processor, spinning only delays the peer.  */
+  if (ncpus == 0)
+    {
+#ifdef _SC_NPROCESSORS_ONLN
+      ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+      if (ncpus <= 0)
+	ncpus = 1;
+    }
+  if (ncpus == 1)
+    return shm_channel_pending_p (ch);
+
+  gettimeofday (&start, NULL);
+  do
+    {
+      int i;
+
+      for (i = 0; i < 64; i++)
+	if (shm_channel_pending_p (ch))
+	  return 1;
+      gettimeofday (&now, NULL);
+    }
+  while ((now.tv_sec - start.tv_sec) * 1000000
+	 + (now.tv_usec - start.tv_usec) < SHM_SPIN_USECS);
+
+  return 0;
+}
+
+/* See shm-ring.h.  */
+
+int
+shm_channel_wait (struct shm_channel *ch, int timeout)
+{
+  int res;
+
+  if (shm_channel_pending_p (ch))
+    return 1;
+  if (timeout == 0)
+    return 0;
+
+  /* Replies to most requests come quickly; watching the ring for a
+     little while avoids the cost of sleeping and being woken up.  */
+  if (shm_channel_spin (ch))
+    return 1;
+
+  while (1)
+    {
+      struct timeval tv;
+      fd_set readfds;
+      int drained;
+
+      /* Tell the peer to ring the doorbell, then check the ring again,
+	 in case data came in before it could see the request.  */
+      ch->in->waiting = 1;
+      shm_barrier ();
+      if (shm_channel_pending_p (ch))
+	{
+	  res = 1;
+	  break;
+	}
+
+      FD_ZERO (&readfds);
+      FD_SET (ch->in_fd, &readfds);
+      tv.tv_sec = timeout;
+      tv.tv_usec = 0;
+      res = select (ch->in_fd + 1, &readfds, NULL, NULL,
+		    timeout < 0 ? NULL : &tv);
+      if (res < 0 && errno == EINTR)
+	continue;
+      if (res <= 0)
+	break;
+
+      /* Bytes can still be in the ring after the peer went away.  */
+      drained = shm_channel_drain (ch);
+      if (shm_channel_pending_p (ch))
+	{
+	  res = 1;
+	  break;
+	}
+      if (drained < 0)
+	{
+	  res = -1;
+	  break;
+	}
+
+      /* The doorbell was for bytes we already read.  */
+    }
+
+  if (!ch->stay_armed)
+    ch->in->waiting = 0;
+  return res;
+}
+
+/* See shm-ring.h.  */
+
+void
+shm_channel_stay_armed (struct shm_channel *ch, int stay_armed)
+{
+  ch->stay_armed = stay_armed;
+  ch->in->waiting = stay_armed;
+  shm_barrier ();
+}
+
+#endif /* USE_WIN32API */
@@ -0,0 +1,165 @@
+/* Shared memory transport between GDB and gdbserver.
+   Copyright (C) 2013 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef COMMON_SHM_RING_H
+#define COMMON_SHM_RING_H
+
+/* A connection "shm:PATH" between GDB and a gdbserver on the same
+   host uses a file PATH, mapped by both sides, holding one ring
+   buffer per direction.  Moving bytes through the rings needs no
+   system call.
+
+   Each side also owns a "doorbell", a FIFO named PATH.to-server or
+   PATH.to-client, that the peer writes a byte to after filling the
+   ring, but only if the owner said it is going to sleep waiting for
+   the doorbell.  A reader first spins on the ring for a short while,
+   so that a reply that comes quickly is seen without sleeping.  The
+   doorbells also let each side notice the other going away, and give
+   the event loops a descriptor to wait on.  */
+
+/* The prefix of the connection names that use this transport.  */
+
+#define SHM_CONNECTION_PREFIX "shm:"
+
+/* Size of each ring buffer.  Must be a power of 2.  */
+
+#define SHM_RING_SIZE 65536
+
+/* How long a reader spins on the ring before going to sleep on its
+   doorbell, in microseconds.  There is no spinning on a single
+   processor host.  */
+
+#define SHM_SPIN_USECS 100
+
+/* One direction of the connection.  HEAD and TAIL are free-running
+   counts of the bytes written and read; their difference is the
+   number of bytes in DATA.  */
+
+struct shm_ring
+{
+  /* Only changed by the writer.  */
+  volatile unsigned int head;
+
+  /* Only changed by the reader.  */
+  volatile unsigned int tail;
+
+  /* Nonzero if the reader may be asleep on its doorbell, so the
+     writer must ring it.  Only changed by the reader.  */
+  volatile unsigned int waiting;
+
+  unsigned char data[SHM_RING_SIZE];
+};
+
+/* The contents of the shared file.  */
+
+struct shm_segment
+{
+  /* SHM_SEGMENT_MAGIC, once gdbserver initialized the rest.  */
+  volatile unsigned int magic;
+
+  /* Nonzero once GDB opened both doorbells.  */
+  volatile unsigned int connected;
+
+  /* The bytes GDB sends to gdbserver.  */
+  struct shm_ring to_server;
+
+  /* The bytes gdbserver sends to GDB.  */
+  struct shm_ring to_client;
+};
+
+#define SHM_SEGMENT_MAGIC 0x67646231
+
+/* One side's view of the connection.  */
+
+struct shm_channel
+{
+  struct shm_segment *segment;
+
+  /* The ring we read from and the ring we write to.  */
+  struct shm_ring *in;
+  struct shm_ring *out;
+
+  /* The read end of our doorbell, and the write end of the peer's.  */
+  int in_fd;
+  int out_fd;
+
+  /* Nonzero if IN->waiting is kept set even while we are not asleep,
+     because an event loop waits on IN_FD.  */
+  int stay_armed;
+
+  /* The name of the shared file, if we created it, to remove it and
+     the doorbells when closing.  */
+  char *path;
+};
+
+/* Create the shared file PATH and its doorbells, and wait for GDB to
+   connect.  Return 0 on success, or -1 with errno set.  */
+
+extern int shm_channel_listen (const char *path, struct shm_channel *ch);
+
+/* Connect to a gdbserver waiting on the shared file PATH.  Return 0
+   on success, or -1 with errno set.  */
+
+extern int shm_channel_connect (const char *path, struct shm_channel *ch);
+
+/* Close CH, removing the files it created.  */
+
+extern void shm_channel_close (struct shm_channel *ch);
+
+/* Copy up to COUNT bytes from the incoming ring of CH to BUF, without
+   waiting.  Return the number of bytes copied, which is zero if the
+   ring is empty.  */
+
+extern int shm_channel_read (struct shm_channel *ch, void *buf, int count);
+
+/* Copy the COUNT bytes in BUF to the outgoing ring of CH, waiting for
+   room as needed, and ring the peer's doorbell if it sleeps.  Return
+   COUNT, or -1 with errno set if the peer went away.  */
+
+extern int shm_channel_write (struct shm_channel *ch, const void *buf,
+			      int count);
+
+/* Watch the incoming ring of CH for SHM_SPIN_USECS microseconds, if
+   the host has more than one processor.  Return nonzero as soon as it
+   holds data, or zero if it stays empty.  */
+
+extern int shm_channel_spin (struct shm_channel *ch);
+
+/* Wait for data in the incoming ring of CH, for at most TIMEOUT
+   seconds, or forever if TIMEOUT is negative.  Return 1 if there is
+   data, 0 on timeout, or -1 with errno set on error.  If the peer
+   went away, errno is EPIPE.  */
+
+extern int shm_channel_wait (struct shm_channel *ch, int timeout);
+
+/* Consume the bytes written to the doorbell of CH, after an event loop
+   saw it readable.  Return 0, or -1 with errno set to EPIPE if the
+   peer went away.  */
+
+extern int shm_channel_drain (struct shm_channel *ch);
+
+/* Return nonzero if the incoming ring of CH holds data.  */
+
+extern int shm_channel_pending_p (struct shm_channel *ch);
+
+/* Set whether the doorbell of CH is rung for every write, for use
+   with an event loop waiting on CH->in_fd.  */
+
+extern void shm_channel_stay_armed (struct shm_channel *ch, int stay_armed);
+
+#endif /* COMMON_SHM_RING_H */
@@ -48,6 +48,12 @@
 #include "gdb_bfd.h"
 #include "completer.h"
 #include "filestuff.h"
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void *) -1)
+#endif
+#endif
 
 #ifndef O_LARGEFILE
 #define O_LARGEFILE 0
@@ -77,6 +83,31 @@ static struct gdbarch *core_gdbarch = NULL;
    unix child targets.  */
 static struct target_section_table *core_data;
 
+/* The sections of CORE_DATA, for finding those holding a given
+   address quickly, along with mappings of their contents.  */
+
+struct core_section_map
+{
+  /* The section.  */
+  struct target_section *section;
+
+  /* The address of its contents in memory once mapped, or NULL.  */
+  const gdb_byte *data;
+
+  /* Nonzero if the contents can't be mapped.  */
+  int unmappable;
+
+  /* What to pass to munmap.  */
+  void *map_addr;
+  bfd_size_type map_len;
+};
+
+/* The sections of CORE_DATA, sorted by address, or NULL if the index
+   is not used; NUM_CORE_SECTION_MAPS is their number.  */
+
+static struct core_section_map *core_section_maps;
+static int num_core_section_maps;
+
 static void core_files_info (struct target_ops *);
 
 static struct core_fns *sniff_core_bfd (bfd *);
@@ -93,6 +124,10 @@ static void core_close_cleanup (void *ignore);
 
 static void add_to_thread_list (bfd *, asection *, void *);
 
+static void build_core_section_maps (void);
+
+static void free_core_section_maps (void);
+
 static void init_core_ops (void);
 
 void _initialize_corelow (void);
@@ -208,6 +243,8 @@ core_close (void)
          comments in clear_solib in solib.c.  */
       clear_solib ();
 
+      free_core_section_maps ();
+
       if (core_data)
 	{
 	  xfree (core_data->sections);
@@ -359,6 +396,8 @@ core_open (char *filename, int from_tty)
     error (_("\"%s\": Can't find sections: %s"),
 	   bfd_get_filename (core_bfd), bfd_errmsg (bfd_get_error ()));
 
+  build_core_section_maps ();
+
   /* If we have no exec file, try to set the architecture from the
      core file.  We don't do this unconditionally since an exec file
      typically contains more information that helps us determine the
@@ -674,15 +713,233 @@ get_core_siginfo (bfd *abfd, gdb_byte *readbuf, ULONGEST offset, LONGEST len)
   return len;
 }
 
+/* qsort comparison function for struct core_section_map, ordering
+   them by address.  */
+
+static int
+compare_core_section_maps (const void *ap, const void *bp)
+{
+  const struct core_section_map *a = ap;
+  const struct core_section_map *b = bp;
+
+  if (a->section->addr < b->section->addr)
+    return -1;
+  if (a->section->addr > b->section->addr)
+    return 1;
+  return 0;
+}
+
+/* Build CORE_SECTION_MAPS from CORE_DATA.  The index is only used if
+   no two sections overlap, since section_table_xfer_memory_partial
+   would otherwise serve an address from whichever comes first.  */
+
+static void
+build_core_section_maps (void)
+{
+  int count = core_data->sections_end - core_data->sections;
+  int i;
+
+  if (count == 0)
+    return;
+
+  core_section_maps = XCNEWVEC (struct core_section_map, count);
+  num_core_section_maps = count;
+  for (i = 0; i < count; i++)
+    core_section_maps[i].section = &core_data->sections[i];
+  qsort (core_section_maps, count, sizeof (*core_section_maps),
+	 compare_core_section_maps);
+
+  for (i = 1; i < count; i++)
+    if (core_section_maps[i].section->addr
+	< core_section_maps[i - 1].section->endaddr)
+      {
+	free_core_section_maps ();
+	return;
+      }
+}
+
+/* Unmap the sections mapped by core_xfer_mapped_memory and free
+   CORE_SECTION_MAPS.  */
+
+static void
+free_core_section_maps (void)
+{
+#ifdef HAVE_MMAP
+  int i;
+
+  for (i = 0; i < num_core_section_maps; i++)
+    if (core_section_maps[i].data != NULL)
+      munmap (core_section_maps[i].map_addr, core_section_maps[i].map_len);
+#endif
+
+  xfree (core_section_maps);
+  core_section_maps = NULL;
+  num_core_section_maps = 0;
+}
+
+/* Return the entry of CORE_SECTION_MAPS whose section holds ADDR, or
+   NULL if there is none.  */
+
+static struct core_section_map *
+find_core_section_map (CORE_ADDR addr)
+{
+  int lo = 0, hi = num_core_section_maps;
+
+  /* Find the first section starting above ADDR; the one before it is
+     the only one which may hold it.  */
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (core_section_maps[mid].section->addr <= addr)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  if (lo == 0 || addr >= core_section_maps[lo - 1].section->endaddr)
+    return NULL;
+  return &core_section_maps[lo - 1];
+}
+
+/* Read up to LEN bytes of memory at MEMADDR into READBUF from a
+   mapping of the core file section holding it, mapping the section
+   the first time.  This saves the system call and the copy through
+   BFD's buffers that bfd_get_section_contents costs for every read,
+   which adds up when walking large data structures in big cores.
+   Return the number of bytes read, which may stop short at the end
+   of the section, or 0 if this can't be done; the caller should then
+   resort to section_table_xfer_memory_partial.  */
+
+static LONGEST
+core_xfer_mapped_memory (gdb_byte *readbuf, ULONGEST memaddr, LONGEST len)
+{
+#ifdef HAVE_MMAP
+  struct core_section_map *map;
+  struct bfd_section *asect;
+
+  /* If the core file is open for writing too, writes through BFD
+     could make the mapping stale.  */
+  if (core_bfd->direction != read_direction)
+    return 0;
+
+  map = find_core_section_map (memaddr);
+  if (map == NULL || map->unmappable)
+    return 0;
+
+  if (map->data == NULL)
+    {
+      void *data;
+
+      asect = map->section->the_bfd_section;
+      if ((bfd_get_section_flags (core_bfd, asect) & SEC_HAS_CONTENTS) == 0
+	  || bfd_get_section_size (asect) == 0
+	  || bfd_get_section_size (asect) != (map->section->endaddr
+					      - map->section->addr))
+	{
+	  map->unmappable = 1;
+	  return 0;
+	}
+
+      data = bfd_mmap (core_bfd, 0, bfd_get_section_size (asect),
+		       PROT_READ, MAP_PRIVATE, asect->filepos,
+		       &map->map_addr, &map->map_len);
+      if (data == MAP_FAILED)
+	{
+	  map->unmappable = 1;
+	  return 0;
+	}
+      map->data = data;
+    }
+
+  len = min (len, map->section->endaddr - memaddr);
+  memcpy (readbuf, map->data + (memaddr - map->section->addr), len);
+  return len;
+#else
+  return 0;
+#endif
+}
+
+/* See gdbcore.h.  */
+
+const gdb_byte *
+core_file_map_memory (CORE_ADDR memaddr, ULONGEST len,
+		      void **map_addr, bfd_size_type *map_len)
+{
+#ifdef HAVE_MMAP
+  struct target_ops *t;
+  struct core_section_map *map;
+  struct bfd_section *asect;
+  void *data;
+
+  if (core_bfd == NULL || core_bfd->direction != read_direction
+      || core_section_maps == NULL || len == 0)
+    return NULL;
+
+  /* Memory reads must reach the core target unchanged; thread layers
+     pass them straight down, but a record or arch target may not.  */
+  for (t = current_target.beneath; t != NULL; t = t->beneath)
+    if (t->to_stratum != thread_stratum)
+      break;
+  if (t != &core_ops)
+    return NULL;
+
+  map = find_core_section_map (memaddr);
+  if (map == NULL || map->unmappable
+      || memaddr + len > map->section->endaddr)
+    return NULL;
+
+  asect = map->section->the_bfd_section;
+  if ((bfd_get_section_flags (core_bfd, asect) & SEC_HAS_CONTENTS) == 0
+      || bfd_get_section_size (asect) != (map->section->endaddr
+					  - map->section->addr))
+    return NULL;
+
+  data = bfd_mmap (core_bfd, 0, len, PROT_READ, MAP_PRIVATE,
+		   asect->filepos + (memaddr - map->section->addr),
+		   map_addr, map_len);
+  if (data == MAP_FAILED)
+    return NULL;
+  return data;
+#else
+  return NULL;
+#endif
+}
+
+/* See gdbcore.h.  */
+
+void
+core_file_unmap_memory (void *map_addr, bfd_size_type map_len)
+{
+#ifdef HAVE_MMAP
+  munmap (map_addr, map_len);
+#endif
+}
+
 static LONGEST
 core_xfer_partial (struct target_ops *ops, enum target_object object,
 		   const char *annex, gdb_byte *readbuf,
 		   const gdb_byte *writebuf, ULONGEST offset,
 		   LONGEST len)
 {
+  LONGEST res;
+
   switch (object)
     {
     case TARGET_OBJECT_MEMORY:
+      if (readbuf != NULL)
+	{
+	  res = core_xfer_mapped_memory (readbuf, offset, len);
+	  if (res > 0)
+	    return res;
+	}
+
+      /* The index, when there is one, covers every section, so an
+	 address it doesn't find is not in the core file at all; code,
+	 for instance, is usually read from the executable instead.
+	 There is no point in looking through the table then.  */
+      if (core_section_maps != NULL && find_core_section_map (offset) == NULL)
+	return 0;
       return section_table_xfer_memory_partial (readbuf, writebuf,
 						offset, len,
 						core_data->sections,
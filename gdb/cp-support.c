@@ -35,6 +35,7 @@
 #include "expression.h"
 #include "value.h"
 #include "cp-abi.h"
+#include "hashtab.h"
 
 #include "safe-ctype.h"
 
@@ -563,6 +564,89 @@ cp_canonicalize_string_no_typedefs (const char *string)
   return cp_canonicalize_string_full (string, NULL, NULL);
 }
 
+/* The results of cp_canonicalize_string.  The same names are
+   canonicalized over and over, by linespecs, symbol lookups and the
+   DWARF reader's computation of physnames, and parsing them is
+   expensive.  */
+
+struct canonical_name
+{
+  /* The name that was canonicalized.  It is allocated along with the
+     entry.  */
+  char *name;
+
+  /* Its canonical form, allocated along with the entry, or NULL if
+     the name could not be parsed or was already canonical.  */
+  char *canonical;
+};
+
+/* The table of struct canonical_name entries.  */
+
+static htab_t canonical_names;
+
+/* The maximum number of entries in CANONICAL_NAMES.  When it is full
+   the table is emptied, rather than keeping track of which entries
+   were used last.  */
+
+#define MAX_CANONICAL_NAMES 4096
+
+/* Hash function for struct canonical_name.  */
+
+static hashval_t
+hash_canonical_name (const void *p)
+{
+  const struct canonical_name *e = p;
+
+  return htab_hash_string (e->name);
+}
+
+/* Equality function for struct canonical_name.  */
+
+static int
+eq_canonical_name (const void *a, const void *b)
+{
+  const struct canonical_name *ea = a;
+  const struct canonical_name *eb = b;
+
+  return strcmp (ea->name, eb->name) == 0;
+}
+
+/* Remember that the canonical form of STRING is CANONICAL, which may
+   be NULL.  */
+
+static void
+record_canonical_name (const char *string, const char *canonical)
+{
+  struct canonical_name e, *entry;
+  size_t len = strlen (string) + 1;
+  size_t canonical_len = canonical != NULL ? strlen (canonical) + 1 : 0;
+  void **slot;
+
+  if (canonical_names == NULL)
+    canonical_names = htab_create_alloc (127, hash_canonical_name,
+					 eq_canonical_name, xfree,
+					 xcalloc, xfree);
+  else if (htab_elements (canonical_names) >= MAX_CANONICAL_NAMES)
+    htab_empty (canonical_names);
+
+  e.name = (char *) string;
+  slot = htab_find_slot (canonical_names, &e, INSERT);
+  if (*slot != NULL)
+    return;
+
+  entry = xmalloc (sizeof (*entry) + len + canonical_len);
+  entry->name = (char *) (entry + 1);
+  memcpy (entry->name, string, len);
+  if (canonical != NULL)
+    {
+      entry->canonical = entry->name + len;
+      memcpy (entry->canonical, canonical, canonical_len);
+    }
+  else
+    entry->canonical = NULL;
+  *slot = entry;
+}
+
 /* Parse STRING and convert it to canonical form.  If parsing fails,
    or if STRING is already canonical, return NULL.  Otherwise return
    the canonical form.  The return value is allocated via xmalloc.  */
@@ -577,9 +661,22 @@ cp_canonicalize_string (const char *string)
   if (cp_already_canonical (string))
     return NULL;
 
+  if (canonical_names != NULL)
+    {
+      struct canonical_name e, *entry;
+
+      e.name = (char *) string;
+      entry = htab_find (canonical_names, &e);
+      if (entry != NULL)
+	return entry->canonical != NULL ? xstrdup (entry->canonical) : NULL;
+    }
+
   info = cp_demangled_name_to_comp (string, NULL);
   if (info == NULL)
-    return NULL;
+    {
+      record_canonical_name (string, NULL);
+      return NULL;
+    }
 
   estimated_len = strlen (string) * 2;
   ret = cp_comp_to_string (info->tree, estimated_len);
@@ -595,9 +692,11 @@ cp_canonicalize_string (const char *string)
   if (strcmp (string, ret) == 0)
     {
       xfree (ret);
+      record_canonical_name (string, NULL);
       return NULL;
     }
 
+  record_canonical_name (string, ret);
   return ret;
 }
 
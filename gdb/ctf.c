@@ -90,6 +90,16 @@ struct trace_write_handler
 
   /* This is the start offset of current packet.  */
   long packet_start;
+
+  /* The current packet is built up in PACKET, which has room for
+     PACKET_ALLOC bytes, and written out by ctf_save_next_packet in
+     a single write.  PACKET_POS is the offset in the packet where
+     the next write goes, and PACKET_LEN is the offset of the end of
+     the data written so far.  */
+  gdb_byte *packet;
+  size_t packet_alloc;
+  size_t packet_pos;
+  size_t packet_len;
 };
 
 /* Write metadata in FORMAT.  */
@@ -107,6 +117,30 @@ ctf_save_write_metadata (struct trace_write_handler *handler,
   va_end (args);
 }
 
+/* Extend the current packet of HANDLER to at least END bytes.  The
+   bytes added are zero, as the bytes skipped over by a seek past the
+   end of a file would read back.  */
+
+static void
+ctf_save_extend_packet (struct trace_write_handler *handler, size_t end)
+{
+  if (end <= handler->packet_len)
+    return;
+
+  if (end > handler->packet_alloc)
+    {
+      if (handler->packet_alloc == 0)
+	handler->packet_alloc = 4096;
+      while (end > handler->packet_alloc)
+	handler->packet_alloc *= 2;
+      handler->packet = xrealloc (handler->packet, handler->packet_alloc);
+    }
+
+  memset (handler->packet + handler->packet_len, 0,
+	  end - handler->packet_len);
+  handler->packet_len = end;
+}
+
 /* Write BUF of length SIZE to datastream file represented by
    HANDLER.  */
 
@@ -114,15 +148,35 @@ static int
 ctf_save_write (struct trace_write_handler *handler,
 		const gdb_byte *buf, size_t size)
 {
-  if (fwrite (buf, size, 1, handler->datastream_fd) != 1)
-    error (_("Unable to write file for saving trace data (%s)"),
-	   safe_strerror (errno));
+  size_t end = handler->packet_pos + size;
+
+  ctf_save_extend_packet (handler, end);
+  memcpy (handler->packet + handler->packet_pos, buf, size);
+  handler->packet_pos = end;
 
   handler->content_size += size;
 
   return 0;
 }
 
+/* Write the first SIZE bytes of the current packet to the datastream
+   file represented by HANDLER, padding it with zero bytes if less
+   than that was written, and start a new empty packet.  */
+
+static void
+ctf_save_flush (struct trace_write_handler *handler, size_t size)
+{
+  ctf_save_extend_packet (handler, size);
+
+  if (size > 0
+      && fwrite (handler->packet, size, 1, handler->datastream_fd) != 1)
+    error (_("Unable to write file for saving trace data (%s)"),
+	   safe_strerror (errno));
+
+  handler->packet_pos = 0;
+  handler->packet_len = 0;
+}
+
 /* Write a unsigned 32-bit integer to datastream file represented by
    HANDLER.  */
 
@@ -136,7 +190,8 @@ ctf_save_write (struct trace_write_handler *handler,
   ctf_save_write ((HANDLER), (gdb_byte *) &(INT32), 4)
 
 /* Set datastream file position.  Update HANDLER->content_size
-   if WHENCE is SEEK_CUR.  */
+   if WHENCE is SEEK_CUR.  The position must be within the current
+   packet.  */
 
 static int
 ctf_save_fseek (struct trace_write_handler *handler, long offset,
@@ -144,14 +199,17 @@ ctf_save_fseek (struct trace_write_handler *handler, long offset,
 {
   gdb_assert (whence != SEEK_END);
   gdb_assert (whence != SEEK_SET
-	      || offset <= handler->content_size + handler->packet_start);
+	      || (offset >= handler->packet_start
+		  && (offset
+		      <= handler->content_size + handler->packet_start)));
 
-  if (fseek (handler->datastream_fd, offset, whence))
-    error (_("Unable to seek file for saving trace data (%s)"),
-	   safe_strerror (errno));
-
-  if (whence == SEEK_CUR)
-    handler->content_size += offset;
+  if (whence == SEEK_SET)
+    handler->packet_pos = offset - handler->packet_start;
+  else
+    {
+      handler->packet_pos += offset;
+      handler->content_size += offset;
+    }
 
   return 0;
 }
@@ -177,13 +235,17 @@ ctf_save_align_write (struct trace_write_handler *handler,
   return 0;
 }
 
-/* Write events to next new packet.  */
+/* Write out the current packet, and write events to next new
+   packet.  The packet is HANDLER->content_size bytes of content
+   followed by 4 bytes of padding.  */
 
 static void
 ctf_save_next_packet (struct trace_write_handler *handler)
 {
-  handler->packet_start += (handler->content_size + 4);
-  ctf_save_fseek (handler, handler->packet_start, SEEK_SET);
+  size_t packet_size = handler->content_size + 4;
+
+  ctf_save_flush (handler, packet_size);
+  handler->packet_start += packet_size;
   handler->content_size = 0;
 }
 
@@ -283,6 +345,7 @@ ctf_dtor (struct trace_file_writer *self)
   if (writer->tcs.datastream_fd != NULL)
     fclose (writer->tcs.datastream_fd);
 
+  xfree (writer->tcs.packet);
 }
 
 /* This is the implementation of trace_file_write_ops method
@@ -686,6 +749,8 @@ ctf_end (struct trace_file_writer *self)
 			  SEEK_SET);
 	  ctf_save_write (&writer->tcs, &b, 1);
 	}
+
+      ctf_save_flush (&writer->tcs, writer->tcs.packet_len);
     }
 }
 
@@ -881,19 +946,57 @@ ctf_trace_file_writer_new (void)
 /* The struct pointer for current CTF directory.  */
 static struct bt_context *ctx = NULL;
 static struct bt_ctf_iter *ctf_iter = NULL;
-/* The position of the first packet containing trace frame.  */
-static struct bt_iter_pos *start_pos;
 
 /* The name of CTF directory.  */
 static char *trace_dirname;
 
 static struct target_ops ctf_ops;
 
+/* The location of a trace frame in the CTF data.  */
+
+struct ctf_traceframe
+{
+  /* The position of the frame's "frame" event.  */
+  struct bt_iter_pos *pos;
+
+  /* The number of the tracepoint that collected it, on the target.  */
+  int tpnum;
+};
+
+typedef struct ctf_traceframe ctf_traceframe_s;
+DEF_VEC_O (ctf_traceframe_s);
+
+/* The trace frames in the CTF data, by number.  */
+static VEC (ctf_traceframe_s) *ctf_traceframes;
+
+/* Return the tracepoint number in "frame" event.  */
+
+static int
+ctf_get_tpnum_from_frame_event (struct bt_ctf_event *event)
+{
+  /* The packet context of events has a field "tpnum".  */
+  const struct bt_definition *scope
+    = bt_ctf_get_top_level_scope (event, BT_STREAM_PACKET_CONTEXT);
+  uint64_t tpnum
+    = bt_ctf_get_uint64 (bt_ctf_get_field (event, scope, "tpnum"));
+
+  return (int) tpnum;
+}
+
 /* Destroy ctf iterator and context.  */
 
 static void
 ctf_destroy (void)
 {
+  struct ctf_traceframe *frame;
+  int ix;
+
+  for (ix = 0;
+       VEC_iterate (ctf_traceframe_s, ctf_traceframes, ix, frame);
+       ix++)
+    bt_iter_free_pos (frame->pos);
+  VEC_free (ctf_traceframe_s, ctf_traceframes);
+
   if (ctf_iter != NULL)
     {
       bt_ctf_iter_destroy (ctf_iter);
@@ -914,6 +1017,7 @@ ctf_open_dir (char *dirname)
   int ret;
   struct bt_iter_pos begin_pos;
   struct bt_iter_pos *pos;
+  int first_packet = 1;
 
   ctx = bt_context_create ();
   if (ctx == NULL)
@@ -935,7 +1039,9 @@ ctf_open_dir (char *dirname)
     }
 
   /* Iterate over events, and look for an event for register block
-     to set trace_regblock_size.  */
+     to set trace_regblock_size.  Record where each trace frame is on
+     the way, so that ctf_trace_find doesn't have to iterate over the
+     events again.  */
 
   /* Save the current position.  */
   pos = bt_iter_get_pos (bt_ctf_get_iter (ctf_iter));
@@ -952,6 +1058,21 @@ ctf_open_dir (char *dirname)
 
       if (name == NULL)
 	break;
+      else if (strcmp (name, "frame") == 0)
+	{
+	  /* The first packet holds the trace status and definitions,
+	     not a trace frame.  */
+	  if (first_packet)
+	    first_packet = 0;
+	  else
+	    {
+	      struct ctf_traceframe *frame
+		= VEC_safe_push (ctf_traceframe_s, ctf_traceframes, NULL);
+
+	      frame->pos = bt_iter_get_pos (bt_ctf_get_iter (ctf_iter));
+	      frame->tpnum = ctf_get_tpnum_from_frame_event (event);
+	    }
+	}
       else if (strcmp (name, "register") == 0)
 	{
 	  const struct bt_definition *scope
@@ -1193,9 +1314,6 @@ ctf_open (char *dirname, int from_tty)
 	error (_("Wrong event id of the first event of the second packet"));
     }
 
-  start_pos = bt_iter_get_pos (bt_ctf_get_iter (ctf_iter));
-  gdb_assert (start_pos->type == BT_SEEK_RESTORE);
-
   trace_dirname = xstrdup (dirname);
   push_target (&ctf_ops);
 
@@ -1548,82 +1666,33 @@ ctf_get_trace_state_variable_value (int tsvnum, LONGEST *val)
   return found;
 }
 
-/* Return the tracepoint number in "frame" event.  */
-
-static int
-ctf_get_tpnum_from_frame_event (struct bt_ctf_event *event)
-{
-  /* The packet context of events has a field "tpnum".  */
-  const struct bt_definition *scope
-    = bt_ctf_get_top_level_scope (event, BT_STREAM_PACKET_CONTEXT);
-  uint64_t tpnum
-    = bt_ctf_get_uint64 (bt_ctf_get_field (event, scope, "tpnum"));
-
-  return (int) tpnum;
-}
-
-/* Return the address at which the current frame was collected.  */
+/* Return the address at which traceframe FRAME was collected.  */
 
 static CORE_ADDR
-ctf_get_traceframe_address (void)
+ctf_get_traceframe_address (struct ctf_traceframe *frame)
 {
-  struct bt_ctf_event *event = NULL;
-  struct bt_iter_pos *pos;
   CORE_ADDR addr = 0;
+  struct tracepoint *tp
+    = get_tracepoint_by_number_on_target (frame->tpnum);
 
-  gdb_assert (ctf_iter != NULL);
-  pos  = bt_iter_get_pos (bt_ctf_get_iter (ctf_iter));
-  gdb_assert (pos->type == BT_SEEK_RESTORE);
-
-  while (1)
-    {
-      const char *name;
-      struct bt_ctf_event *event1;
-
-      event1 = bt_ctf_iter_read_event (ctf_iter);
-
-      name = bt_ctf_event_name (event1);
-
-      if (name == NULL)
-	break;
-      else if (strcmp (name, "frame") == 0)
-	{
-	  event = event1;
-	  break;
-	}
-
-      if (bt_iter_next (bt_ctf_get_iter (ctf_iter)) < 0)
-	break;
-    }
-
-  if (event != NULL)
-    {
-      int tpnum = ctf_get_tpnum_from_frame_event (event);
-      struct tracepoint *tp
-	= get_tracepoint_by_number_on_target (tpnum);
-
-      if (tp && tp->base.loc)
-	addr = tp->base.loc->address;
-    }
-
-  /* Restore the position.  */
-  bt_iter_set_pos (bt_ctf_get_iter (ctf_iter), pos);
+  if (tp && tp->base.loc)
+    addr = tp->base.loc->address;
 
   return addr;
 }
 
 /* This is the implementation of target_ops method to_trace_find.
-   Iterate the events whose name is "frame", extract the tracepoint
-   number in it.  Return traceframe number when matched.  */
+   Look up the trace frames recorded by ctf_open_dir, and move the
+   iterator to the events of the one matched.  Return its traceframe
+   number.  */
 
 static int
 ctf_trace_find (enum trace_find_type type, int num,
 		CORE_ADDR addr1, CORE_ADDR addr2, int *tpp)
 {
-  int ret = -1;
-  int tfnum = 0;
+  struct ctf_traceframe *frame = NULL;
+  int tfnum;
   int found = 0;
-  struct bt_iter_pos pos;
 
   if (num == -1)
     {
@@ -1633,84 +1702,70 @@ ctf_trace_find (enum trace_find_type type, int num,
     }
 
   gdb_assert (ctf_iter != NULL);
-  /* Set iterator back to the start.  */
-  bt_iter_set_pos (bt_ctf_get_iter (ctf_iter), start_pos);
 
-  while (1)
+  if (type == tfind_number)
     {
-      int id;
-      struct bt_ctf_event *event;
-      const char *name;
-
-      event = bt_ctf_iter_read_event (ctf_iter);
-
-      name = bt_ctf_event_name (event);
-
-      if (event == NULL || name == NULL)
-	break;
-
-      if (strcmp (name, "frame") == 0)
+      /* Looking for a specific trace frame.  */
+      tfnum = num;
+      if (tfnum >= 0
+	  && tfnum < VEC_length (ctf_traceframe_s, ctf_traceframes))
+	{
+	  frame = VEC_index (ctf_traceframe_s, ctf_traceframes, tfnum);
+	  found = 1;
+	}
+    }
+  else
+    {
+      /* Start from the _next_ trace frame.  */
+      for (tfnum = get_traceframe_number () + 1;
+	   VEC_iterate (ctf_traceframe_s, ctf_traceframes, tfnum, frame);
+	   tfnum++)
 	{
 	  CORE_ADDR tfaddr;
 
-	  if (type == tfind_number)
+	  switch (type)
 	    {
-	      /* Looking for a specific trace frame.  */
-	      if (tfnum == num)
+	    case tfind_tp:
+	      {
+		struct tracepoint *tp = get_tracepoint (num);
+
+		if (tp != NULL && tp->number_on_target == frame->tpnum)
+		  found = 1;
+		break;
+	      }
+	    case tfind_pc:
+	      tfaddr = ctf_get_traceframe_address (frame);
+	      if (tfaddr == addr1)
 		found = 1;
-	    }
-	  else
-	    {
-	      /* Start from the _next_ trace frame.  */
-	      if (tfnum > get_traceframe_number ())
-		{
-		  switch (type)
-		    {
-		    case tfind_tp:
-		      {
-			struct tracepoint *tp = get_tracepoint (num);
-
-			if (tp != NULL
-			    && (tp->number_on_target
-				== ctf_get_tpnum_from_frame_event (event)))
-			  found = 1;
-			break;
-		      }
-		    case tfind_pc:
-		      tfaddr = ctf_get_traceframe_address ();
-		      if (tfaddr == addr1)
-			found = 1;
-		      break;
-		    case tfind_range:
-		      tfaddr = ctf_get_traceframe_address ();
-		      if (addr1 <= tfaddr && tfaddr <= addr2)
-			found = 1;
-		      break;
-		    case tfind_outside:
-		      tfaddr = ctf_get_traceframe_address ();
-		      if (!(addr1 <= tfaddr && tfaddr <= addr2))
-			found = 1;
-		      break;
-		    default:
-		      internal_error (__FILE__, __LINE__, _("unknown tfind type"));
-		    }
-		}
+	      break;
+	    case tfind_range:
+	      tfaddr = ctf_get_traceframe_address (frame);
+	      if (addr1 <= tfaddr && tfaddr <= addr2)
+		found = 1;
+	      break;
+	    case tfind_outside:
+	      tfaddr = ctf_get_traceframe_address (frame);
+	      if (!(addr1 <= tfaddr && tfaddr <= addr2))
+		found = 1;
+	      break;
+	    default:
+	      internal_error (__FILE__, __LINE__, _("unknown tfind type"));
 	    }
 	  if (found)
-	    {
-	      if (tpp != NULL)
-		*tpp = ctf_get_tpnum_from_frame_event (event);
+	    break;
+	}
+    }
 
-	      /* Skip the event "frame".  */
-	      bt_iter_next (bt_ctf_get_iter (ctf_iter));
+  if (found)
+    {
+      if (tpp != NULL)
+	*tpp = frame->tpnum;
 
-	      return tfnum;
-	    }
-	  tfnum++;
-	}
+      /* Skip the event "frame".  */
+      bt_iter_set_pos (bt_ctf_get_iter (ctf_iter), frame->pos);
+      bt_iter_next (bt_ctf_get_iter (ctf_iter));
 
-      if (bt_iter_next (bt_ctf_get_iter (ctf_iter)) < 0)
-	break;
+      return tfnum;
     }
 
   return -1;
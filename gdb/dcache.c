@@ -51,6 +51,11 @@ static struct cmd_list_element *dcache_show_list = NULL;
    Lines are only allocated as needed, so DCACHE_SIZE really specifies the
    *maximum* number of lines in the cache.
 
+   Misses which walk through memory in one direction, like the stack
+   reads of a backtrace, make the cache read ahead of them, so that
+   the following accesses find their lines already present; see
+   dcache_fill_lines.
+
    At present, the cache is write-through rather than writeback: as soon
    as data is written to the cache, it is also immediately written to
    the target.  Therefore, cache lines are never "dirty".  Whether a given
@@ -83,6 +88,15 @@ static unsigned dcache_size = DCACHE_DEFAULT_SIZE;
 #define DCACHE_DEFAULT_LINE_SIZE 64
 static unsigned dcache_line_size = DCACHE_DEFAULT_LINE_SIZE;
 
+/* The greatest number of lines read ahead of a miss.  When misses
+   follow each other in one direction, as they do while unwinding the
+   stack or dumping a block of memory, the cache starts reading the
+   lines after (or before) the missing ones along with them, first one
+   line, then doubling the number with each further miss up to this
+   limit.  Zero disables read-ahead.  */
+#define DCACHE_DEFAULT_READ_AHEAD 16
+static unsigned dcache_read_ahead = DCACHE_DEFAULT_READ_AHEAD;
+
 /* Each cache block holds LINE_SIZE bytes of data
    starting at a multiple-of-LINE_SIZE address.  */
 
@@ -116,6 +130,23 @@ struct dcache_struct
 
   /* The ptid of last inferior to use cache or null_ptid.  */
   ptid_t ptid;
+
+  /* The lines filled by the last miss, from LAST_FILL_LO up to but
+     not including LAST_FILL_HI, or an empty range if there was none
+     since the cache was last invalidated.  */
+  CORE_ADDR last_fill_lo;
+  CORE_ADDR last_fill_hi;
+
+  /* The direction of the current run of misses, 1 for increasing and
+     -1 for decreasing addresses, or 0 if there is none, and the
+     number of lines to read ahead in that direction.  */
+  int read_ahead_dir;
+  unsigned read_ahead_lines;
+
+  /* Statistics for "info dcache".  These survive invalidation.  */
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long lines_read_ahead;
 };
 
 typedef void (block_func) (struct dcache_block *block, void *param);
@@ -258,6 +289,9 @@ dcache_invalidate (DCACHE *dcache)
   dcache->oldest = NULL;
   dcache->size = 0;
   dcache->ptid = null_ptid;
+  dcache->last_fill_lo = dcache->last_fill_hi = 0;
+  dcache->read_ahead_dir = 0;
+  dcache->read_ahead_lines = 0;
 
   if (dcache->line_size != dcache_line_size)
     {
@@ -395,6 +429,186 @@ dcache_alloc (DCACHE *dcache, CORE_ADDR addr)
   return db;
 }
 
+/* Return nonzero if the line of DCACHE at ADDR is not in the cache,
+   and lies wholly within REGION, which must be readable.  */
+
+static int
+dcache_fillable_line_p (DCACHE *dcache, CORE_ADDR addr,
+			struct mem_region *region)
+{
+  if (splay_tree_lookup (dcache->tree, (splay_tree_key) addr) != NULL)
+    return 0;
+
+  return (lookup_mem_region (addr) == region
+	  && (region->hi == 0 || addr + dcache->line_size <= region->hi));
+}
+
+/* Record a miss of DCACHE filling the lines from LO up to HI, and
+   return how many lines to read ahead of them, in the direction of
+   DCACHE->read_ahead_dir.  A miss close after (or before) the lines
+   filled by the previous one continues a run in that direction, and
+   doubles the read-ahead; any other miss ends it.  */
+
+static unsigned
+dcache_update_read_ahead (DCACHE *dcache, CORE_ADDR lo, CORE_ADDR hi)
+{
+  CORE_ADDR reach = (CORE_ADDR) dcache_read_ahead * dcache->line_size;
+  int dir = 0;
+  unsigned lines;
+
+  if (dcache->last_fill_lo < dcache->last_fill_hi)
+    {
+      if (lo >= dcache->last_fill_hi && lo - dcache->last_fill_hi <= reach)
+	dir = 1;
+      else if (hi <= dcache->last_fill_lo
+	       && dcache->last_fill_lo - hi <= reach)
+	dir = -1;
+    }
+
+  if (dir == 0 || dcache_read_ahead == 0)
+    lines = 0;
+  else if (dir == dcache->read_ahead_dir && dcache->read_ahead_lines > 0)
+    lines = min (2 * dcache->read_ahead_lines, dcache_read_ahead);
+  else
+    lines = 1;
+
+  dcache->read_ahead_dir = dir;
+  dcache->read_ahead_lines = lines;
+  dcache->last_fill_lo = lo;
+  dcache->last_fill_hi = hi;
+  return lines;
+}
+
+/* Fill the lines of DCACHE covering the LEN bytes at MEMADDR which
+   are not in the cache yet, along with the lines read ahead of them,
+   reading them with a single call to target_read_multi.  Lines which
+   span more than one memory region, or a write-only one, are left for
+   dcache_read_line.  Lines that couldn't be read are dropped again, so
+   that the caller finds them missing and reports the error as
+   usual.  */
+
+static void
+dcache_fill_lines (DCACHE *dcache, CORE_ADDR memaddr, int len)
+{
+  CORE_ADDR start = MASK (dcache, memaddr);
+  CORE_ADDR end = memaddr + len;
+  CORE_ADDR line_size = dcache->line_size;
+  CORE_ADDR addr, lo = 0, hi = 0, ahead_lo = 0;
+  struct memory_read_range *ranges;
+  struct mem_region *region = NULL;
+  struct cleanup *cleanups;
+  gdb_byte *ahead_buf = NULL;
+  unsigned ahead, n;
+  int count = 0;
+  int i;
+
+  ranges = xmalloc ((dcache_size + 1) * sizeof (*ranges));
+  cleanups = make_cleanup (xfree, ranges);
+
+  for (addr = start;
+       addr < end && addr >= start && count < dcache_size;
+       addr += line_size)
+    {
+      if (splay_tree_lookup (dcache->tree, (splay_tree_key) addr) != NULL)
+	{
+	  dcache->hits++;
+	  continue;
+	}
+
+      dcache->misses++;
+      region = lookup_mem_region (addr);
+      if (region->attrib.mode == MEM_WO
+	  || !dcache_fillable_line_p (dcache, addr, region))
+	continue;
+
+      if (count == 0)
+	lo = addr;
+      hi = addr + line_size;
+      ranges[count].offset = addr;
+      ranges[count].len = line_size;
+      count++;
+    }
+
+  if (count == 0)
+    {
+      do_cleanups (cleanups);
+      return;
+    }
+
+  /* Don't let the lines read ahead evict the ones being filled.  Stay
+     within the region of the missing lines, since the memory next to
+     them may not be cacheable, or even readable.  */
+  ahead = dcache_update_read_ahead (dcache, lo, hi);
+  ahead = min (ahead, dcache_size - count);
+  if (dcache->read_ahead_dir > 0)
+    {
+      region = lookup_mem_region (hi - 1);
+      for (n = 0; n < ahead; n++)
+	{
+	  addr = hi + n * line_size;
+	  if (addr < hi || !dcache_fillable_line_p (dcache, addr, region))
+	    break;
+	}
+      ahead_lo = hi;
+      ahead = n;
+    }
+  else if (dcache->read_ahead_dir < 0)
+    {
+      region = lookup_mem_region (lo);
+      for (n = 0; n < ahead; n++)
+	{
+	  addr = lo - (n + 1) * line_size;
+	  if (addr >= lo || !dcache_fillable_line_p (dcache, addr, region))
+	    break;
+	}
+      ahead_lo = lo - n * line_size;
+      ahead = n;
+    }
+
+  /* The lines read ahead are read as one range into a separate
+     buffer, and only entered into the cache if all of them could be
+     read; that way reading past the end of mapped memory costs just
+     the one failing read.  */
+  if (ahead > 0)
+    {
+      ahead_buf = xmalloc (ahead * line_size);
+      make_cleanup (xfree, ahead_buf);
+      ranges[count].offset = ahead_lo;
+      ranges[count].len = ahead * line_size;
+      ranges[count].buf = ahead_buf;
+    }
+
+  for (i = 0; i < count; i++)
+    ranges[i].buf = dcache_alloc (dcache, ranges[i].offset)->data;
+
+  target_read_multi (&current_target, TARGET_OBJECT_RAW_MEMORY,
+		     ranges, count + (ahead > 0));
+  for (i = 0; i < count; i++)
+    if (!ranges[i].ok)
+      dcache_invalidate_line (dcache, ranges[i].offset);
+
+  if (ahead > 0 && ranges[count].ok)
+    {
+      for (n = 0; n < ahead; n++)
+	{
+	  struct dcache_block *db;
+
+	  db = dcache_alloc (dcache, ahead_lo + n * line_size);
+	  memcpy (db->data, ahead_buf + n * line_size, line_size);
+	}
+      dcache->lines_read_ahead += ahead;
+      dcache->last_fill_lo = min (lo, ahead_lo);
+      dcache->last_fill_hi = max (hi, ahead_lo + ahead * line_size);
+    }
+  else if (ahead > 0)
+    {
+      dcache->read_ahead_dir = 0;
+      dcache->read_ahead_lines = 0;
+    }
+
+  do_cleanups (cleanups);
+}
+
 /* Using the data cache DCACHE, store in *PTR the contents of the byte at
    address ADDR in the remote machine.  
 
@@ -468,6 +682,12 @@ dcache_init (void)
   dcache->size = 0;
   dcache->line_size = dcache_line_size;
   dcache->ptid = null_ptid;
+  dcache->last_fill_lo = dcache->last_fill_hi = 0;
+  dcache->read_ahead_dir = 0;
+  dcache->read_ahead_lines = 0;
+  dcache->hits = 0;
+  dcache->misses = 0;
+  dcache->lines_read_ahead = 0;
   last_cache = dcache;
 
   return dcache;
@@ -516,6 +736,8 @@ dcache_xfer_memory (struct target_ops *ops, DCACHE *dcache,
       /* Update LEN to what was actually written.  */
       len = res;
     }
+  else
+    dcache_fill_lines (dcache, memaddr, len);
       
   for (i = 0; i < len; i++)
     {
@@ -535,6 +757,53 @@ dcache_xfer_memory (struct target_ops *ops, DCACHE *dcache,
   return len;
 }
 
+/* Store in DCACHE the LEN bytes at MEMADDR in MYADDR, which the
+   target sent along with a stop of PTID.  Only the lines the data
+   covers entirely are filled; lines already in the cache are
+   overwritten.  */
+
+void
+dcache_fill (DCACHE *dcache, ptid_t ptid, CORE_ADDR memaddr,
+	     const gdb_byte *myaddr, int len)
+{
+  CORE_ADDR line_size = dcache->line_size;
+  CORE_ADDR addr = MASK (dcache, memaddr + line_size - 1);
+  CORE_ADDR end = memaddr + len;
+
+  if (! ptid_equal (ptid, dcache->ptid))
+    {
+      dcache_invalidate (dcache);
+      dcache->ptid = ptid;
+    }
+
+  for (; addr >= memaddr && addr + line_size <= end; addr += line_size)
+    {
+      struct mem_region *region = lookup_mem_region (addr);
+      struct dcache_block *db;
+      splay_tree_node node;
+
+      if (region->attrib.mode == MEM_WO
+	  || (region->hi != 0 && addr + line_size > region->hi))
+	continue;
+
+      node = splay_tree_lookup (dcache->tree, (splay_tree_key) addr);
+      if (node != NULL)
+	db = (struct dcache_block *) node->value;
+      else
+	db = dcache_alloc (dcache, addr);
+
+      memcpy (db->data, myaddr + (addr - memaddr), line_size);
+    }
+}
+
+/* Return the line size the next invalidated cache will use.  */
+
+unsigned
+dcache_get_line_size (void)
+{
+  return dcache_line_size;
+}
+
 /* FIXME: There would be some benefit to making the cache write-back and
    moving the writeback operation to a higher layer, as it could occur
    after a sequence of smaller writes have been completed (as when a stack
@@ -654,6 +923,10 @@ dcache_info (char *exp, int tty)
     }
 
   printf_filtered (_("Cache state: %d active lines, %d hits\n"), i, refcount);
+  printf_filtered (_("Line lookups: %lu hits, %lu misses, "
+		     "%lu lines read ahead\n"),
+		   last_cache->hits, last_cache->misses,
+		   last_cache->lines_read_ahead);
 }
 
 static void
@@ -743,4 +1016,15 @@ Show number of dcache lines."),
 			     set_dcache_size,
 			     NULL,
 			     &dcache_set_list, &dcache_show_list);
+  add_setshow_zuinteger_cmd ("read-ahead", class_obscure,
+			     &dcache_read_ahead, _("\
+Set the maximum number of dcache lines read ahead of a miss."), _("\
+Show the maximum number of dcache lines read ahead of a miss."), _("\
+When cache misses follow each other through memory in one direction,\n\
+as they do during a backtrace, the cache reads increasingly many lines\n\
+past the missing ones along with them, up to this many.\n\
+Zero disables read-ahead."),
+			     NULL,
+			     NULL,
+			     &dcache_set_list, &dcache_show_list);
 }
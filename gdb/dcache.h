@@ -40,4 +40,10 @@ int dcache_xfer_memory (struct target_ops *ops, DCACHE *cache, CORE_ADDR mem,
 void dcache_update (DCACHE *dcache, CORE_ADDR memaddr, gdb_byte *myaddr,
 		    int len);
 
+void dcache_fill (DCACHE *dcache, ptid_t ptid, CORE_ADDR memaddr,
+		  const gdb_byte *myaddr, int len);
+
+/* Return the line size the next invalidated cache will use.  */
+unsigned dcache_get_line_size (void);
+
 #endif /* DCACHE_H */
@@ -435,6 +435,9 @@ struct command_line
        example, for "if" command this will contain the then branch and
        the else branch, if that is available.  */
     struct command_line **body_list;
+    /* For "if" and "while", the condition as last parsed by
+       execute_control_command, or NULL.  */
+    struct control_condition *condition;
   };
 
 extern struct command_line *read_command_lines (char *, int, int,
@@ -93,6 +93,9 @@ enum dict_type
     DICT_HASHED,
     /* Symbols are stored in an expandable hash table.  */
     DICT_HASHED_EXPANDABLE,
+    /* Symbols are stored in a fixed-size hash table using open
+       addressing.  */
+    DICT_HASHED_OPEN,
     /* Symbols are stored in a fixed-size array.  */
     DICT_LINEAR,
     /* Symbols are stored in an expandable array.  */
@@ -147,6 +150,24 @@ struct dictionary_hashed_expandable
   int nsyms;
 };
 
+/* A slot of a DICT_HASHED_OPEN dictionary.  */
+
+struct dict_slot
+{
+  /* The dict_hash of SYM's search name; names are only compared when
+     it matches.  */
+  unsigned int hash;
+  /* The symbol, or NULL if the slot is empty.  */
+  struct symbol *sym;
+};
+
+struct dictionary_hashed_open
+{
+  /* The number of slots; a power of two.  */
+  int nslots;
+  struct dict_slot *slots;
+};
+
 struct dictionary_linear
 {
   int nsyms;
@@ -171,6 +192,7 @@ struct dictionary
   {
     struct dictionary_hashed hashed;
     struct dictionary_hashed_expandable hashed_expandable;
+    struct dictionary_hashed_open hashed_open;
     struct dictionary_linear linear;
     struct dictionary_linear_expandable linear_expandable;
   }
@@ -189,6 +211,10 @@ struct dictionary
 
 #define DICT_HASHED_EXPANDABLE_NSYMS(d)	(d)->data.hashed_expandable.nsyms
 
+#define DICT_HASHED_OPEN_NSLOTS(d)	(d)->data.hashed_open.nslots
+#define DICT_HASHED_OPEN_SLOTS(d)	(d)->data.hashed_open.slots
+#define DICT_HASHED_OPEN_SLOT(d,i)	DICT_HASHED_OPEN_SLOTS (d) [i]
+
 /* These can be used for DICT_LINEAR_EXPANDABLEs, too.  */
 
 #define DICT_LINEAR_NSYMS(d)		(d)->data.linear.nsyms
@@ -207,6 +233,13 @@ struct dictionary
 
 #define DICT_HASHTABLE_SIZE(n)	((n)/5 + 1)
 
+/* dict_create_hashed uses a DICT_HASHED_OPEN dictionary for blocks
+   with at least this many symbols.  Walking a bucket chain costs one
+   cache miss per symbol, which starts to matter for the global blocks
+   of large compilation units.  */
+
+#define DICT_HASHED_OPEN_MIN_SYMS 256
+
 /* Accessor macros for dict_iterators; they're here rather than
    dictionary.h because code elsewhere should treat dict_iterators as
    opaque.  */
@@ -246,8 +279,6 @@ static struct symbol *iter_match_next_hashed (const char *name,
 					      symbol_compare_ftype *compare,
 					      struct dict_iterator *iterator);
 
-static unsigned int dict_hash (const char *string);
-
 /* Functions only for DICT_HASHED.  */
 
 static int size_hashed (const struct dictionary *dict);
@@ -261,6 +292,24 @@ static void add_symbol_hashed_expandable (struct dictionary *dict,
 
 static int size_hashed_expandable (const struct dictionary *dict);
 
+/* Functions only for DICT_HASHED_OPEN.  */
+
+static struct symbol *iterator_first_hashed_open
+  (const struct dictionary *dict, struct dict_iterator *iterator);
+
+static struct symbol *iterator_next_hashed_open
+  (struct dict_iterator *iterator);
+
+static struct symbol *iter_match_first_hashed_open
+  (const struct dictionary *dict, const char *name,
+   symbol_compare_ftype *compare, struct dict_iterator *iterator);
+
+static struct symbol *iter_match_next_hashed_open
+  (const char *name, symbol_compare_ftype *compare,
+   struct dict_iterator *iterator);
+
+static int size_hashed_open (const struct dictionary *dict);
+
 /* Functions for DICT_LINEAR and DICT_LINEAR_EXPANDABLE
    dictionaries.  */
 
@@ -313,6 +362,18 @@ static const struct dict_vector dict_hashed_expandable_vector =
     size_hashed_expandable,		/* size */
   };
 
+static const struct dict_vector dict_hashed_open_vector =
+  {
+    DICT_HASHED_OPEN,			/* type */
+    free_obstack,			/* free */
+    add_symbol_nonexpandable,		/* add_symbol */
+    iterator_first_hashed_open,		/* iterator_first */
+    iterator_next_hashed_open,		/* iterator_next */
+    iter_match_first_hashed_open,	/* iter_name_first */
+    iter_match_next_hashed_open,	/* iter_name_next */
+    size_hashed_open,			/* size */
+  };
+
 static const struct dict_vector dict_linear_vector =
   {
     DICT_LINEAR,			/* type */
@@ -347,11 +408,19 @@ static void insert_symbol_hashed (struct dictionary *dict,
 
 static void expand_hashtable (struct dictionary *dict);
 
+static struct dictionary *dict_create_hashed_open
+  (struct obstack *obstack, const struct pending *symbol_list, int nsyms);
+
+static struct symbol *iter_match_hashed_open (const char *name,
+					      unsigned int hash,
+					      symbol_compare_ftype *compare,
+					      struct dict_iterator *iterator);
+
 /* The creation functions.  */
 
 /* Create a dictionary implemented via a fixed-size hashtable.  All
    memory it uses is allocated on OBSTACK; the environment is
-   initialized from SYMBOL_LIST.  */
+   initialized from SYMBOL_LIST.  Large tables use open addressing.  */
 
 struct dictionary *
 dict_create_hashed (struct obstack *obstack,
@@ -362,9 +431,6 @@ dict_create_hashed (struct obstack *obstack,
   struct symbol **buckets;
   const struct pending *list_counter;
 
-  retval = obstack_alloc (obstack, sizeof (struct dictionary));
-  DICT_VECTOR (retval) = &dict_hashed_vector;
-
   /* Calculate the number of symbols, and allocate space for them.  */
   for (list_counter = symbol_list;
        list_counter != NULL;
@@ -372,6 +438,13 @@ dict_create_hashed (struct obstack *obstack,
     {
       nsyms += list_counter->nsyms;
     }
+
+  if (nsyms >= DICT_HASHED_OPEN_MIN_SYMS)
+    return dict_create_hashed_open (obstack, symbol_list, nsyms);
+
+  retval = obstack_alloc (obstack, sizeof (struct dictionary));
+  DICT_VECTOR (retval) = &dict_hashed_vector;
+
   nbuckets = DICT_HASHTABLE_SIZE (nsyms);
   DICT_HASHED_NBUCKETS (retval) = nbuckets;
   buckets = obstack_alloc (obstack, nbuckets * sizeof (struct symbol *));
@@ -392,6 +465,60 @@ dict_create_hashed (struct obstack *obstack,
   return retval;
 }
 
+/* Create a DICT_HASHED_OPEN dictionary on OBSTACK holding the NSYMS
+   symbols of SYMBOL_LIST.  Symbols with the same name are found in
+   the same order as in a DICT_HASHED dictionary.  */
+
+static struct dictionary *
+dict_create_hashed_open (struct obstack *obstack,
+			 const struct pending *symbol_list, int nsyms)
+{
+  struct dictionary *retval;
+  struct dict_slot *slots;
+  struct symbol **syms;
+  const struct pending *list_counter;
+  int nslots, i, j;
+
+  retval = obstack_alloc (obstack, sizeof (struct dictionary));
+  DICT_VECTOR (retval) = &dict_hashed_open_vector;
+
+  /* Keep the table at most half full.  */
+  for (nslots = 1; nslots < 2 * nsyms; nslots *= 2)
+    ;
+  DICT_HASHED_OPEN_NSLOTS (retval) = nslots;
+  slots = obstack_alloc (obstack, nslots * sizeof (struct dict_slot));
+  memset (slots, 0, nslots * sizeof (struct dict_slot));
+  DICT_HASHED_OPEN_SLOTS (retval) = slots;
+
+  /* dict_create_hashed pushes each symbol on the front of its chain,
+     so a lookup sees the last symbol it inserts first.  Linear probing
+     sees the first symbol inserted first, so insert in the opposite
+     order.  */
+  syms = xmalloc (nsyms * sizeof (struct symbol *));
+  for (list_counter = symbol_list, j = 0;
+       list_counter != NULL;
+       list_counter = list_counter->next)
+    {
+      for (i = list_counter->nsyms - 1; i >= 0; --i)
+	syms[j++] = list_counter->symbol[i];
+    }
+
+  for (j = nsyms - 1; j >= 0; --j)
+    {
+      unsigned int hash = dict_hash (SYMBOL_SEARCH_NAME (syms[j]));
+
+      for (i = hash & (nslots - 1);
+	   slots[i].sym != NULL;
+	   i = (i + 1) & (nslots - 1))
+	;
+      slots[i].hash = hash;
+      slots[i].sym = syms[j];
+    }
+
+  xfree (syms);
+  return retval;
+}
+
 /* Create a dictionary implemented via a hashtable that grows as
    necessary.  The dictionary is initially empty; to add symbols to
    it, call dict_add_symbol().  Call dict_free() when you're done with
@@ -790,7 +917,7 @@ expand_hashtable (struct dictionary *dict)
    That is, two identifiers equivalent according to any of those three
    comparison operators hash to the same value.  */
 
-static unsigned int
+unsigned int
 dict_hash (const char *string0)
 {
   /* The Ada-encoded version of a name P1.P2...Pn has either the form
@@ -860,6 +987,102 @@ dict_hash (const char *string0)
   return hash;
 }
 
+/* Functions for DICT_HASHED_OPEN.  */
+
+static struct symbol *
+iterator_first_hashed_open (const struct dictionary *dict,
+			    struct dict_iterator *iterator)
+{
+  DICT_ITERATOR_DICT (iterator) = dict;
+  DICT_ITERATOR_INDEX (iterator) = -1;
+  return iterator_next_hashed_open (iterator);
+}
+
+static struct symbol *
+iterator_next_hashed_open (struct dict_iterator *iterator)
+{
+  const struct dictionary *dict = DICT_ITERATOR_DICT (iterator);
+  int nslots = DICT_HASHED_OPEN_NSLOTS (dict);
+  int i;
+
+  for (i = DICT_ITERATOR_INDEX (iterator) + 1; i < nslots; ++i)
+    {
+      struct symbol *sym = DICT_HASHED_OPEN_SLOT (dict, i).sym;
+
+      if (sym != NULL)
+	{
+	  DICT_ITERATOR_INDEX (iterator) = i;
+	  return sym;
+	}
+    }
+
+  DICT_ITERATOR_INDEX (iterator) = nslots;
+  return NULL;
+}
+
+/* Probe the slots after the one ITERATOR points to for a symbol whose
+   search name has hash HASH and matches NAME according to COMPARE.  */
+
+static struct symbol *
+iter_match_hashed_open (const char *name, unsigned int hash,
+			symbol_compare_ftype *compare,
+			struct dict_iterator *iterator)
+{
+  const struct dictionary *dict = DICT_ITERATOR_DICT (iterator);
+  unsigned int mask = DICT_HASHED_OPEN_NSLOTS (dict) - 1;
+  const struct dict_slot *slot;
+  unsigned int i;
+
+  for (i = (DICT_ITERATOR_INDEX (iterator) + 1) & mask;
+       (slot = &DICT_HASHED_OPEN_SLOT (dict, i))->sym != NULL;
+       i = (i + 1) & mask)
+    {
+      /* Warning: the order of arguments to compare matters!  */
+      if (slot->hash == hash
+	  && compare (SYMBOL_SEARCH_NAME (slot->sym), name) == 0)
+	{
+	  DICT_ITERATOR_INDEX (iterator) = i;
+	  return slot->sym;
+	}
+    }
+
+  return NULL;
+}
+
+static struct symbol *
+iter_match_first_hashed_open (const struct dictionary *dict,
+			      const char *name,
+			      symbol_compare_ftype *compare,
+			      struct dict_iterator *iterator)
+{
+  unsigned int hash = dict_hash (name);
+
+  DICT_ITERATOR_DICT (iterator) = dict;
+  /* Start probing at the home slot of HASH.  */
+  DICT_ITERATOR_INDEX (iterator)
+    = (int) ((hash - 1) & (DICT_HASHED_OPEN_NSLOTS (dict) - 1));
+  return iter_match_hashed_open (name, hash, compare, iterator);
+}
+
+static struct symbol *
+iter_match_next_hashed_open (const char *name, symbol_compare_ftype *compare,
+			     struct dict_iterator *iterator)
+{
+  const struct dictionary *dict = DICT_ITERATOR_DICT (iterator);
+
+  /* The last symbol returned has the same hash as NAME.  */
+  return iter_match_hashed_open (name,
+				 DICT_HASHED_OPEN_SLOT
+				   (dict, DICT_ITERATOR_INDEX (iterator)).hash,
+				 compare, iterator);
+}
+
+static int
+size_hashed_open (const struct dictionary *dict)
+{
+  return DICT_HASHED_OPEN_NSLOTS (dict);
+}
+
 /* Functions for DICT_LINEAR and DICT_LINEAR_EXPANDABLE.  */
 
 static struct symbol *
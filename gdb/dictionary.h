@@ -169,6 +169,13 @@ extern struct symbol *dict_iter_match_next (const char *name,
 
 extern int dict_size (const struct dictionary *dict);
 
+/* Return the hash value the hashed dictionaries use for the symbol
+   name STRING.  Names that are equivalent according to strcmp_iw,
+   strcmp, or, at least on Ada symbols, wild_match, have the same hash
+   value.  */
+
+extern unsigned int dict_hash (const char *string);
+
 /* Macro to loop through all symbols in a dictionary DICT, in no
    particular order.  ITER is a struct dict_iterator (NOTE: __not__ a
    struct dict_iterator *), and SYM points to the current symbol.
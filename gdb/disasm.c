@@ -42,12 +42,12 @@ struct dis_line_entry
   CORE_ADDR end_pc;
 };
 
-/* Like target_read_memory, but slightly different parameters.  */
+/* Like target_read_code, but slightly different parameters.  */
 static int
 dis_asm_read_memory (bfd_vma memaddr, gdb_byte *myaddr, unsigned int len,
 		     struct disassemble_info *info)
 {
-  return target_read_memory (memaddr, myaddr, len);
+  return target_read_code (memaddr, myaddr, len);
 }
 
 /* Like memory_error with slightly different parameters.  */
@@ -474,6 +474,7 @@ int
 gdb_insn_length (struct gdbarch *gdbarch, CORE_ADDR addr)
 {
   static struct ui_file *null_stream = NULL;
+  struct disassemble_info di;
 
   /* Dummy file descriptor for the disassembler.  */
   if (!null_stream)
@@ -482,7 +483,9 @@ gdb_insn_length (struct gdbarch *gdbarch, CORE_ADDR addr)
       make_final_cleanup (do_ui_file_delete, null_stream);
     }
 
-  return gdb_print_insn (gdbarch, addr, null_stream, NULL);
+  di = gdb_disassemble_info (gdbarch, null_stream);
+  di.flags |= DISASSEMBLE_LENGTH_ONLY;
+  return gdbarch_print_insn (gdbarch, addr, &di);
 }
 
 /* fprintf-function for gdb_buffered_insn_length.  This function is a
@@ -516,6 +519,7 @@ gdb_buffered_insn_length_init_dis (struct gdbarch *gdbarch,
   di->mach = gdbarch_bfd_arch_info (gdbarch)->mach;
   di->endian = gdbarch_byte_order (gdbarch);
   di->endian_code = gdbarch_byte_order_for_code (gdbarch);
+  di->flags |= DISASSEMBLE_LENGTH_ONLY;
 
   disassemble_init_for_target (di);
 }
@@ -41,6 +41,7 @@
 #include "dwarf2loc.h"
 #include "exceptions.h"
 #include "dwarf2-frame-tailcall.h"
+#include "gdb_bfd.h"
 
 struct comp_unit;
 
@@ -124,10 +125,41 @@ struct dwarf2_fde
   unsigned char eh_frame_p;
 };
 
+struct dwarf2_eh_frame_hdr;
+
 struct dwarf2_fde_table
 {
   int num_entries;
   struct dwarf2_fde **entries;
+
+  /* If non-NULL, ENTRIES is empty and FDEs are instead looked up through
+     the binary search table of the .eh_frame_hdr section.  */
+  struct dwarf2_eh_frame_hdr *eh_frame_hdr;
+};
+
+/* The binary search table of an .eh_frame_hdr section, as emitted by
+   the GNU linker.  It lets us find the FDE covering a PC without
+   decoding all of .eh_frame first.  */
+
+struct dwarf2_eh_frame_hdr
+{
+  /* The .eh_frame section the table refers to.  */
+  struct comp_unit *unit;
+
+  /* The CIEs decoded so far, sorted by offset.  */
+  struct dwarf2_cie_table cie_table;
+
+  /* The VMA of the .eh_frame_hdr section; the table entries are
+     relative to it.  */
+  CORE_ADDR hdr_vma;
+
+  /* The table: FDE_COUNT pairs of signed 4-byte initial locations and
+     FDE addresses, sorted by initial location.  */
+  const gdb_byte *table;
+  unsigned int fde_count;
+
+  /* The FDEs decoded so far, indexed like TABLE.  */
+  struct dwarf2_fde **fdes;
 };
 
 /* A minimal decoding of DWARF2 compilation units.  We only decode
@@ -159,6 +191,9 @@ struct comp_unit
 static struct dwarf2_fde *dwarf2_frame_find_fde (CORE_ADDR *pc,
 						 CORE_ADDR *out_offset);
 
+static struct dwarf2_fde *eh_frame_hdr_find_fde
+  (struct dwarf2_eh_frame_hdr *hdr, CORE_ADDR seek_pc);
+
 static int dwarf2_frame_adjust_regnum (struct gdbarch *gdbarch, int regnum,
 				       int eh_frame_p);
 
@@ -992,6 +1027,127 @@ struct dwarf2_frame_cache
   void *tailcall_cache;
 };
 
+/* A cache of decoded CFI rows.  Executing the CIE and FDE programs is
+   the main cost of unwinding a frame, and the same PCs are unwound
+   over and over again when stepping or printing backtraces.  Each
+   entry records the register rules in effect at PC, which is relative
+   to the text offset of the objfile FDE belongs to so that entries
+   survive relocation.  The cache is direct-mapped and thus bounded;
+   it is flushed whenever an objfile's frame data is released, since
+   FDE pointers would dangle afterwards.  */
+
+#define DWARF2_FRAME_ROW_CACHE_SIZE 1024
+
+struct dwarf2_frame_row
+{
+  /* The key.  FDE is NULL for an unused entry.  */
+  struct gdbarch *gdbarch;
+  struct dwarf2_fde *fde;
+  CORE_ADDR pc;
+
+  /* The register set after executing the CFA program up to PC.  The
+     PREV chain is always empty.  */
+  struct dwarf2_frame_state_reg_info regs;
+
+  /* The start of the row containing PC, relative to the text
+     offset.  */
+  CORE_ADDR row_pc;
+
+  ULONGEST retaddr_column;
+  int armcc_cfa_offsets_reversed;
+
+  /* The SP-relative CFA offset at the function's entry PC, if
+     known.  */
+  LONGEST entry_cfa_sp_offset;
+  int entry_cfa_sp_offset_p;
+};
+
+static struct dwarf2_frame_row dwarf2_frame_rows[DWARF2_FRAME_ROW_CACHE_SIZE];
+
+/* Return the cache slot for FDE and PC.  */
+
+static struct dwarf2_frame_row *
+dwarf2_frame_row_slot (struct dwarf2_fde *fde, CORE_ADDR pc)
+{
+  uintptr_t hash = ((uintptr_t) fde >> 3) ^ (uintptr_t) pc;
+
+  return &dwarf2_frame_rows[hash % DWARF2_FRAME_ROW_CACHE_SIZE];
+}
+
+/* Look up the cached row for PC in FDE.  Return NULL if there is
+   none.  */
+
+static struct dwarf2_frame_row *
+dwarf2_frame_row_find (struct gdbarch *gdbarch, struct dwarf2_fde *fde,
+		       CORE_ADDR pc)
+{
+  struct dwarf2_frame_row *row = dwarf2_frame_row_slot (fde, pc);
+
+  if (row->fde == fde && row->pc == pc && row->gdbarch == gdbarch)
+    return row;
+  return NULL;
+}
+
+/* Discard the contents of ROW.  */
+
+static void
+dwarf2_frame_row_clear (struct dwarf2_frame_row *row)
+{
+  xfree (row->regs.reg);
+  memset (row, 0, sizeof (*row));
+}
+
+/* Record the state FS reached for PC in FDE.  */
+
+static void
+dwarf2_frame_row_save (struct gdbarch *gdbarch, struct dwarf2_fde *fde,
+		       CORE_ADDR pc, CORE_ADDR text_offset,
+		       struct dwarf2_frame_state *fs,
+		       LONGEST entry_cfa_sp_offset, int entry_cfa_sp_offset_p)
+{
+  struct dwarf2_frame_row *row = dwarf2_frame_row_slot (fde, pc);
+
+  dwarf2_frame_row_clear (row);
+
+  row->gdbarch = gdbarch;
+  row->fde = fde;
+  row->pc = pc;
+  row->regs = fs->regs;
+  row->regs.reg = dwarf2_frame_state_copy_regs (&fs->regs);
+  row->regs.prev = NULL;
+  row->row_pc = fs->pc - text_offset;
+  row->retaddr_column = fs->retaddr_column;
+  row->armcc_cfa_offsets_reversed = fs->armcc_cfa_offsets_reversed;
+  row->entry_cfa_sp_offset = entry_cfa_sp_offset;
+  row->entry_cfa_sp_offset_p = entry_cfa_sp_offset_p;
+}
+
+/* Fill in FS from the cached ROW.  */
+
+static void
+dwarf2_frame_row_restore (struct dwarf2_frame_row *row,
+			  CORE_ADDR text_offset,
+			  struct dwarf2_frame_state *fs)
+{
+  fs->regs = row->regs;
+  fs->regs.reg = dwarf2_frame_state_copy_regs (&row->regs);
+  fs->pc = row->row_pc + text_offset;
+  fs->retaddr_column = row->retaddr_column;
+  fs->armcc_cfa_offsets_reversed = row->armcc_cfa_offsets_reversed;
+}
+
+/* Empty the row cache.  */
+
+static void
+dwarf2_frame_row_flush (void)
+{
+  int i;
+
+  for (i = 0; i < DWARF2_FRAME_ROW_CACHE_SIZE; i++)
+    if (dwarf2_frame_rows[i].fde != NULL)
+      dwarf2_frame_row_clear (&dwarf2_frame_rows[i]);
+}
+
 /* A cleanup that sets a pointer to NULL.  */
 
 static void
@@ -1012,8 +1168,9 @@ dwarf2_frame_cache (struct frame_info *this_frame, void **this_cache)
   struct dwarf2_frame_cache *cache;
   struct dwarf2_frame_state *fs;
   struct dwarf2_fde *fde;
+  struct dwarf2_frame_row *row;
   volatile struct gdb_exception ex;
-  CORE_ADDR entry_pc;
+  CORE_ADDR pc, entry_pc;
   LONGEST entry_cfa_sp_offset;
   int entry_cfa_sp_offset_p = 0;
   const gdb_byte *instr;
@@ -1046,50 +1203,64 @@ dwarf2_frame_cache (struct frame_info *this_frame, void **this_cache)
      get_frame_address_in_block does just this.  It's not clear how
      reliable the method is though; there is the potential for the
      register state pre-call being different to that on return.  */
-  fs->pc = get_frame_address_in_block (this_frame);
+  pc = get_frame_address_in_block (this_frame);
+  fs->pc = pc;
 
   /* Find the correct FDE.  */
   fde = dwarf2_frame_find_fde (&fs->pc, &cache->text_offset);
   gdb_assert (fde != NULL);
 
-  /* Extract any interesting information from the CIE.  */
-  fs->data_align = fde->cie->data_alignment_factor;
-  fs->code_align = fde->cie->code_alignment_factor;
-  fs->retaddr_column = fde->cie->return_address_register;
   cache->addr_size = fde->cie->addr_size;
 
-  /* Check for "quirks" - known bugs in producers.  */
-  dwarf2_frame_find_quirks (fs, fde);
+  row = dwarf2_frame_row_find (gdbarch, fde, pc - cache->text_offset);
+  if (row != NULL)
+    {
+      dwarf2_frame_row_restore (row, cache->text_offset, fs);
+      entry_cfa_sp_offset = row->entry_cfa_sp_offset;
+      entry_cfa_sp_offset_p = row->entry_cfa_sp_offset_p;
+    }
+  else
+    {
+      /* Extract any interesting information from the CIE.  */
+      fs->data_align = fde->cie->data_alignment_factor;
+      fs->code_align = fde->cie->code_alignment_factor;
+      fs->retaddr_column = fde->cie->return_address_register;
 
-  /* First decode all the insns in the CIE.  */
-  execute_cfa_program (fde, fde->cie->initial_instructions,
-		       fde->cie->end, gdbarch,
-		       get_frame_address_in_block (this_frame), fs);
+      /* Check for "quirks" - known bugs in producers.  */
+      dwarf2_frame_find_quirks (fs, fde);
 
-  /* Save the initialized register set.  */
-  fs->initial = fs->regs;
-  fs->initial.reg = dwarf2_frame_state_copy_regs (&fs->regs);
+      /* First decode all the insns in the CIE.  */
+      execute_cfa_program (fde, fde->cie->initial_instructions,
+			   fde->cie->end, gdbarch, pc, fs);
 
-  if (get_frame_func_if_available (this_frame, &entry_pc))
-    {
-      /* Decode the insns in the FDE up to the entry PC.  */
-      instr = execute_cfa_program (fde, fde->instructions, fde->end, gdbarch,
-				   entry_pc, fs);
+      /* Save the initialized register set.  */
+      fs->initial = fs->regs;
+      fs->initial.reg = dwarf2_frame_state_copy_regs (&fs->regs);
 
-      if (fs->regs.cfa_how == CFA_REG_OFFSET
-	  && (gdbarch_dwarf2_reg_to_regnum (gdbarch, fs->regs.cfa_reg)
-	      == gdbarch_sp_regnum (gdbarch)))
+      if (get_frame_func_if_available (this_frame, &entry_pc))
 	{
-	  entry_cfa_sp_offset = fs->regs.cfa_offset;
-	  entry_cfa_sp_offset_p = 1;
+	  /* Decode the insns in the FDE up to the entry PC.  */
+	  instr = execute_cfa_program (fde, fde->instructions, fde->end,
+				       gdbarch, entry_pc, fs);
+
+	  if (fs->regs.cfa_how == CFA_REG_OFFSET
+	      && (gdbarch_dwarf2_reg_to_regnum (gdbarch, fs->regs.cfa_reg)
+		  == gdbarch_sp_regnum (gdbarch)))
+	    {
+	      entry_cfa_sp_offset = fs->regs.cfa_offset;
+	      entry_cfa_sp_offset_p = 1;
+	    }
 	}
-    }
-  else
-    instr = fde->instructions;
+      else
+	instr = fde->instructions;
 
-  /* Then decode the insns in the FDE up to our target PC.  */
-  execute_cfa_program (fde, instr, fde->end, gdbarch,
-		       get_frame_address_in_block (this_frame), fs);
+      /* Then decode the insns in the FDE up to our target PC.  */
+      execute_cfa_program (fde, instr, fde->end, gdbarch, pc, fs);
+
+      dwarf2_frame_row_save (gdbarch, fde, pc - cache->text_offset,
+			     cache->text_offset, fs,
+			     entry_cfa_sp_offset, entry_cfa_sp_offset_p);
+    }
 
   TRY_CATCH (ex, RETURN_MASK_ERROR)
     {
@@ -1713,18 +1884,24 @@ find_cie (struct dwarf2_cie_table *cie_table, ULONGEST cie_pointer)
   return NULL;
 }
 
-/* Add a pointer to new CIE to the CIE_TABLE, allocating space for it.  */
+/* Add a pointer to new CIE to the CIE_TABLE, allocating space for it.
+   The table is kept sorted by offset.  CIEs are usually added in order;
+   only those decoded on demand through .eh_frame_hdr may not be.  */
 static void
 add_cie (struct dwarf2_cie_table *cie_table, struct dwarf2_cie *cie)
 {
   const int n = cie_table->num_entries;
-
-  gdb_assert (n < 1
-              || cie_table->entries[n - 1]->cie_pointer < cie->cie_pointer);
+  int i = n;
 
   cie_table->entries =
       xrealloc (cie_table->entries, (n + 1) * sizeof (cie_table->entries[0]));
-  cie_table->entries[n] = cie;
+  while (i > 0 && cie_table->entries[i - 1]->cie_pointer > cie->cie_pointer)
+    i--;
+  gdb_assert (i == 0
+	      || cie_table->entries[i - 1]->cie_pointer < cie->cie_pointer);
+  memmove (&cie_table->entries[i + 1], &cie_table->entries[i],
+	   (n - i) * sizeof (cie_table->entries[0]));
+  cie_table->entries[i] = cie;
   cie_table->num_entries = n + 1;
 }
 
@@ -1764,6 +1941,23 @@ dwarf2_frame_find_fde (CORE_ADDR *pc, CORE_ADDR *out_offset)
 	}
       gdb_assert (fde_table != NULL);
 
+      if (fde_table->eh_frame_hdr != NULL)
+	{
+	  struct dwarf2_fde *fde;
+
+	  gdb_assert (objfile->section_offsets);
+	  offset = ANOFFSET (objfile->section_offsets, SECT_OFF_TEXT (objfile));
+	  fde = eh_frame_hdr_find_fde (fde_table->eh_frame_hdr, *pc - offset);
+	  if (fde != NULL)
+	    {
+	      *pc = fde->initial_location + offset;
+	      if (out_offset)
+		*out_offset = offset;
+	      return fde;
+	    }
+	  continue;
+	}
+
       if (fde_table->num_entries == 0)
 	continue;
 
@@ -2244,6 +2438,141 @@ qsort_fde_cmp (const void *a, const void *b)
   return (aa->initial_location < bb->initial_location) ? -1 : 1;
 }
 
+/* Return the FDE with index IDX in the binary search table of HDR,
+   decoding it if needed.  Return NULL if it can't be decoded.  */
+
+static struct dwarf2_fde *
+eh_frame_hdr_fde (struct dwarf2_eh_frame_hdr *hdr, unsigned int idx)
+{
+  struct comp_unit *unit = hdr->unit;
+  struct dwarf2_fde_table fde_table;
+  CORE_ADDR fde_addr;
+  ULONGEST fde_offset;
+  volatile struct gdb_exception e;
+
+  if (hdr->fdes[idx] != NULL)
+    return hdr->fdes[idx];
+
+  fde_addr = (hdr->hdr_vma
+	      + bfd_get_signed_32 (unit->abfd, hdr->table + idx * 8 + 4));
+  fde_offset = (fde_addr
+		- bfd_get_section_vma (unit->abfd, unit->dwarf_frame_section));
+  if (fde_offset >= unit->dwarf_frame_size)
+    return NULL;
+
+  fde_table.num_entries = 0;
+  fde_table.entries = NULL;
+  fde_table.eh_frame_hdr = NULL;
+
+  TRY_CATCH (e, RETURN_MASK_ERROR)
+    {
+      decode_frame_entry (unit, unit->dwarf_frame_buffer + fde_offset, 1,
+			  &hdr->cie_table, &fde_table, EH_FDE_TYPE_ID);
+    }
+  if (e.reason < 0)
+    complaint (&symfile_complaints,
+	       _("skipping FDE at offset %s in .eh_frame of %s: %s"),
+	       pulongest (fde_offset), objfile_name (unit->objfile),
+	       e.message);
+  else if (fde_table.num_entries == 1)
+    hdr->fdes[idx] = fde_table.entries[0];
+
+  xfree (fde_table.entries);
+  return hdr->fdes[idx];
+}
+
+/* Find the FDE for SEEK_PC, an unrelocated address, using the binary
+   search table of HDR.  */
+
+static struct dwarf2_fde *
+eh_frame_hdr_find_fde (struct dwarf2_eh_frame_hdr *hdr, CORE_ADDR seek_pc)
+{
+  bfd *abfd = hdr->unit->abfd;
+  unsigned int lo = 0, hi = hdr->fde_count;
+  struct dwarf2_fde *fde;
+
+  /* Find the last entry whose initial location is not above SEEK_PC.  */
+  while (lo < hi)
+    {
+      unsigned int mid = lo + (hi - lo) / 2;
+      CORE_ADDR loc = (hdr->hdr_vma
+		       + bfd_get_signed_32 (abfd, hdr->table + mid * 8));
+
+      if (seek_pc < loc)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+  if (lo == 0)
+    return NULL;
+
+  fde = eh_frame_hdr_fde (hdr, lo - 1);
+  if (fde != NULL && bsearch_fde_cmp (&seek_pc, &fde) == 0)
+    return fde;
+  return NULL;
+}
+
+/* Read the binary search table of the .eh_frame_hdr section of
+   UNIT's objfile, for UNIT's .eh_frame section.  Return NULL if there
+   is no such section, or its table is missing or in a form we don't
+   handle.  Only the form the GNU linker emits, with 4-byte
+   section-relative entries, is supported.  */
+
+static struct dwarf2_eh_frame_hdr *
+read_eh_frame_hdr (struct comp_unit *unit)
+{
+  struct objfile *objfile = unit->objfile;
+  asection *sect;
+  const gdb_byte *buf, *end;
+  bfd_size_type size;
+  unsigned int fde_count;
+  struct dwarf2_eh_frame_hdr *hdr;
+
+  sect = bfd_get_section_by_name (unit->abfd, ".eh_frame_hdr");
+  if (sect == NULL || (bfd_get_section_flags (unit->abfd, sect)
+		       & SEC_HAS_CONTENTS) == 0)
+    return NULL;
+  buf = gdb_bfd_map_section (sect, &size);
+  if (buf == NULL || size < 12)
+    return NULL;
+  end = buf + size;
+
+  /* Version, eh_frame_ptr encoding, fde_count encoding, table
+     encoding.  */
+  if (buf[0] != 1
+      || (buf[1] & 0x0f) != DW_EH_PE_sdata4
+      || buf[2] != DW_EH_PE_udata4
+      || buf[3] != (DW_EH_PE_datarel | DW_EH_PE_sdata4))
+    return NULL;
+
+  fde_count = bfd_get_32 (unit->abfd, buf + 8);
+  if (fde_count == 0 || fde_count > (size - 12) / 8)
+    return NULL;
+
+  hdr = OBSTACK_ZALLOC (&objfile->objfile_obstack, struct dwarf2_eh_frame_hdr);
+  hdr->unit = unit;
+  hdr->hdr_vma = bfd_get_section_vma (unit->abfd, sect);
+  hdr->table = buf + 12;
+  hdr->fde_count = fde_count;
+  hdr->fdes = OBSTACK_CALLOC (&objfile->objfile_obstack, fde_count,
+			      struct dwarf2_fde *);
+  return hdr;
+}
+
+/* Return non-zero if OBJFILE has a .debug_frame section.  */
+
+static int
+has_debug_frame_p (struct objfile *objfile)
+{
+  asection *sect;
+  const gdb_byte *buffer;
+  bfd_size_type size;
+
+  dwarf2_get_section_info (objfile, DWARF2_DEBUG_FRAME, &sect, &buffer,
+			   &size);
+  return size != 0;
+}
+
 void
 dwarf2_build_frame_info (struct objfile *objfile)
 {
@@ -2259,6 +2588,7 @@ dwarf2_build_frame_info (struct objfile *objfile)
 
   fde_table.num_entries = 0;
   fde_table.entries = NULL;
+  fde_table.eh_frame_hdr = NULL;
 
   /* Build a minimal decoding of the DWARF2 compilation unit.  */
   unit = (struct comp_unit *) obstack_alloc (&objfile->objfile_obstack,
@@ -2294,6 +2624,24 @@ dwarf2_build_frame_info (struct objfile *objfile)
           if (txt)
             unit->tbase = txt->vma;
 
+	  /* If the linker left a binary search table for .eh_frame and
+	     there is no .debug_frame to merge with it, don't decode all of
+	     .eh_frame now: FDEs are decoded as they are looked up.  */
+	  if (!has_debug_frame_p (objfile))
+	    {
+	      struct dwarf2_eh_frame_hdr *hdr = read_eh_frame_hdr (unit);
+
+	      if (hdr != NULL)
+		{
+		  fde_table2 = OBSTACK_ZALLOC (&objfile->objfile_obstack,
+					       struct dwarf2_fde_table);
+		  fde_table2->eh_frame_hdr = hdr;
+		  set_objfile_data (objfile, dwarf2_frame_objfile_data,
+				    fde_table2);
+		  return;
+		}
+	    }
+
 	  TRY_CATCH (e, RETURN_MASK_ERROR)
 	    {
 	      frame_ptr = unit->dwarf_frame_buffer;
@@ -2377,8 +2725,8 @@ dwarf2_build_frame_info (struct objfile *objfile)
     }
 
   /* Copy fde_table to obstack: it is needed at runtime.  */
-  fde_table2 = (struct dwarf2_fde_table *)
-    obstack_alloc (&objfile->objfile_obstack, sizeof (*fde_table2));
+  fde_table2 = OBSTACK_ZALLOC (&objfile->objfile_obstack,
+			       struct dwarf2_fde_table);
 
   if (fde_table.num_entries == 0)
     {
@@ -2450,6 +2798,21 @@ dwarf2_build_frame_info (struct objfile *objfile)
   set_objfile_data (objfile, dwarf2_frame_objfile_data, fde_table2);
 }
 
+/* Free the CIE table of the .eh_frame_hdr lookup of an objfile, if
+   any.  The rest of the FDE table is on the objfile obstack.  */
+
+static void
+dwarf2_frame_objfile_data_free (struct objfile *objfile, void *data)
+{
+  struct dwarf2_fde_table *fde_table = data;
+
+  /* The row cache may refer to this objfile's FDEs.  */
+  dwarf2_frame_row_flush ();
+
+  if (fde_table->eh_frame_hdr != NULL)
+    xfree (fde_table->eh_frame_hdr->cie_table.entries);
+}
+
 /* Provide a prototype to silence -Wmissing-prototypes.  */
 void _initialize_dwarf2_frame (void);
 
@@ -2457,5 +2820,6 @@ void
 _initialize_dwarf2_frame (void)
 {
   dwarf2_frame_data = gdbarch_data_register_pre_init (dwarf2_frame_init);
-  dwarf2_frame_objfile_data = register_objfile_data ();
+  dwarf2_frame_objfile_data
+    = register_objfile_data_with_cleanup (NULL, dwarf2_frame_objfile_data_free);
 }
@@ -3309,6 +3309,192 @@ dwarf2_compile_expr_to_ax (struct agent_expr *expr, struct axs_value *loc,
 }
 
 
+/* Set DLBATON's form, register and offset from its expression.  Only
+   expressions consisting of a single operation of one of the kinds in
+   enum dwarf2_locexpr_form are recognized.  */
+
+static void
+locexpr_decode (struct dwarf2_locexpr_baton *dlbaton)
+{
+  const gdb_byte *data = dlbaton->data;
+  const gdb_byte *end = data + dlbaton->size;
+  uint64_t reg;
+  int64_t offset;
+
+  dlbaton->form = LOCEXPR_FORM_GENERIC;
+
+  if (dlbaton->size == 0)
+    return;
+
+  if (data[0] == DW_OP_addr)
+    {
+      struct objfile *objfile = dwarf2_per_cu_objfile (dlbaton->per_cu);
+      enum bfd_endian byte_order
+	= gdbarch_byte_order (get_objfile_arch (objfile));
+      int addr_size = dwarf2_per_cu_addr_size (dlbaton->per_cu);
+
+      /* A trailing DW_OP_GNU_push_tls_address, amongst others, makes
+	 this something else.  */
+      if (dlbaton->size != 1 + addr_size)
+	return;
+      dlbaton->offset = extract_unsigned_integer (data + 1, addr_size,
+						  byte_order);
+      dlbaton->form = LOCEXPR_FORM_ADDR;
+    }
+  else if (data[0] >= DW_OP_reg0 && data[0] <= DW_OP_reg31)
+    {
+      if (dlbaton->size != 1)
+	return;
+      dlbaton->regnum = data[0] - DW_OP_reg0;
+      dlbaton->form = LOCEXPR_FORM_REG;
+    }
+  else if (data[0] == DW_OP_regx)
+    {
+      if (gdb_read_uleb128 (data + 1, end, &reg) != end)
+	return;
+      dlbaton->regnum = reg;
+      dlbaton->form = LOCEXPR_FORM_REG;
+    }
+  else if (data[0] >= DW_OP_breg0 && data[0] <= DW_OP_breg31)
+    {
+      if (gdb_read_sleb128 (data + 1, end, &offset) != end)
+	return;
+      dlbaton->regnum = data[0] - DW_OP_breg0;
+      dlbaton->offset = offset;
+      dlbaton->form = LOCEXPR_FORM_BREG;
+    }
+  else if (data[0] == DW_OP_bregx)
+    {
+      const gdb_byte *p = gdb_read_uleb128 (data + 1, end, &reg);
+
+      if (p == NULL || gdb_read_sleb128 (p, end, &offset) != end)
+	return;
+      dlbaton->regnum = reg;
+      dlbaton->offset = offset;
+      dlbaton->form = LOCEXPR_FORM_BREG;
+    }
+  else if (data[0] == DW_OP_fbreg)
+    {
+      if (gdb_read_sleb128 (data + 1, end, &offset) != end)
+	return;
+      dlbaton->offset = offset;
+      dlbaton->form = LOCEXPR_FORM_FBREG;
+    }
+}
+
+/* Compute the frame base of FRAME into *BASE, if the function's
+   DW_AT_frame_base is DW_OP_call_frame_cfa or a single DW_OP_breg<n>.
+   Return zero if it is anything else.  */
+
+static int
+locexpr_simple_frame_base (struct frame_info *frame, CORE_ADDR *base)
+{
+  struct block *bl = get_frame_block (frame, NULL);
+  struct symbol *framefunc;
+  const gdb_byte *start, *end;
+  size_t length;
+  int64_t offset;
+
+  if (bl == NULL)
+    return 0;
+  framefunc = block_linkage_function (bl);
+  if (framefunc == NULL)
+    return 0;
+
+  dwarf_expr_frame_base_1 (framefunc, get_frame_address_in_block (frame),
+			   &start, &length);
+  end = start + length;
+
+  if (length == 1 && start[0] == DW_OP_call_frame_cfa)
+    {
+      *base = dwarf2_frame_cfa (frame);
+      return 1;
+    }
+  if (start[0] >= DW_OP_breg0 && start[0] <= DW_OP_breg31
+      && gdb_read_sleb128 (start + 1, end, &offset) == end)
+    {
+      struct gdbarch *gdbarch = get_frame_arch (frame);
+      int regnum = gdbarch_dwarf2_reg_to_regnum (gdbarch,
+						 start[0] - DW_OP_breg0);
+
+      if (regnum == -1)
+	return 0;
+      *base = (address_from_register (builtin_type (gdbarch)->builtin_data_ptr,
+				      regnum, frame)
+	       + offset);
+      return 1;
+    }
+
+  return 0;
+}
+
+/* Subroutine of locexpr_read_variable.  Compute the value of SYMBOL,
+   located by DLBATON, in FRAME directly from DLBATON's decoded form.
+   Return NULL if the form doesn't allow that; the caller then uses the
+   DWARF expression evaluator, which also handles any error here in
+   its usual way.  */
+
+static struct value *
+locexpr_read_variable_decoded (struct symbol *symbol,
+			       struct dwarf2_locexpr_baton *dlbaton,
+			       struct frame_info *frame)
+{
+  struct type *type = SYMBOL_TYPE (symbol);
+  struct value *retval = NULL;
+  volatile struct gdb_exception ex;
+
+  if (dlbaton->form == LOCEXPR_FORM_ADDR)
+    return value_at_lazy (type, (dlbaton->offset
+				 + dwarf2_per_cu_text_offset (dlbaton->per_cu)));
+
+  if (frame == NULL)
+    return NULL;
+
+  TRY_CATCH (ex, RETURN_MASK_ERROR)
+    {
+      struct gdbarch *gdbarch = get_frame_arch (frame);
+      int regnum;
+      CORE_ADDR base;
+
+      switch (dlbaton->form)
+	{
+	case LOCEXPR_FORM_REG:
+	  regnum = gdbarch_dwarf2_reg_to_regnum (gdbarch, dlbaton->regnum);
+	  if (regnum == -1)
+	    break;
+	  retval = value_from_register (type, regnum, frame);
+	  /* As in dwarf2_evaluate_loc_desc_full, show an unsaved register
+	     as <optimized out>.  */
+	  if (value_optimized_out (retval))
+	    retval = allocate_optimized_out_value (type);
+	  break;
+
+	case LOCEXPR_FORM_BREG:
+	  regnum = gdbarch_dwarf2_reg_to_regnum (gdbarch, dlbaton->regnum);
+	  if (regnum == -1)
+	    break;
+	  base = address_from_register (builtin_type (gdbarch)->builtin_data_ptr,
+					regnum, frame);
+	  retval = value_at_lazy (type, base + dlbaton->offset);
+	  break;
+
+	case LOCEXPR_FORM_FBREG:
+	  if (!locexpr_simple_frame_base (frame, &base))
+	    break;
+	  retval = value_at_lazy (type, base + dlbaton->offset);
+	  set_value_stack (retval, 1);
+	  break;
+
+	default:
+	  break;
+	}
+    }
+  if (ex.reason < 0)
+    return NULL;
+
+  return retval;
+}
+
 /* Return the value of SYMBOL in FRAME using the DWARF-2 expression
    evaluator to calculate the location.  */
 static struct value *
@@ -3317,6 +3503,15 @@ locexpr_read_variable (struct symbol *symbol, struct frame_info *frame)
   struct dwarf2_locexpr_baton *dlbaton = SYMBOL_LOCATION_BATON (symbol);
   struct value *val;
 
+  if (dlbaton->form == LOCEXPR_FORM_UNKNOWN)
+    locexpr_decode (dlbaton);
+  if (dlbaton->form != LOCEXPR_FORM_GENERIC)
+    {
+      val = locexpr_read_variable_decoded (symbol, dlbaton, frame);
+      if (val != NULL)
+	return val;
+    }
+
   val = dwarf2_evaluate_loc_desc (SYMBOL_TYPE (symbol), frame, dlbaton->data,
 				  dlbaton->size, dlbaton->per_cu);
 
@@ -3342,6 +3537,13 @@ locexpr_read_needs_frame (struct symbol *symbol)
 {
   struct dwarf2_locexpr_baton *dlbaton = SYMBOL_LOCATION_BATON (symbol);
 
+  if (dlbaton->form == LOCEXPR_FORM_UNKNOWN)
+    locexpr_decode (dlbaton);
+  if (dlbaton->form == LOCEXPR_FORM_ADDR)
+    return 0;
+  if (dlbaton->form != LOCEXPR_FORM_GENERIC)
+    return 1;
+
   return dwarf2_loc_desc_needs_frame (dlbaton->data, dlbaton->size,
 				      dlbaton->per_cu);
 }
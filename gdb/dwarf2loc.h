@@ -99,6 +99,31 @@ CORE_ADDR dwarf2_read_addr_index (struct dwarf2_per_cu_data *per_cu,
    expression; "struct dwarf2_loclist_baton" is for a symbol with a
    location list.  */
 
+/* The shapes of location expression that locexpr_read_variable handles
+   without running the DWARF expression evaluator.  */
+
+enum dwarf2_locexpr_form
+{
+  /* The expression has not been examined yet.  */
+  LOCEXPR_FORM_UNKNOWN = 0,
+
+  /* Any other expression; it is evaluated by dwarf2_evaluate_loc_desc.  */
+  LOCEXPR_FORM_GENERIC,
+
+  /* DW_OP_addr: the object is at a fixed, unrelocated address.  */
+  LOCEXPR_FORM_ADDR,
+
+  /* DW_OP_reg<n> or DW_OP_regx: the object is in a register.  */
+  LOCEXPR_FORM_REG,
+
+  /* DW_OP_breg<n> or DW_OP_bregx: the object is at an offset from the
+     address held in a register.  */
+  LOCEXPR_FORM_BREG,
+
+  /* DW_OP_fbreg: the object is at an offset from the frame base.  */
+  LOCEXPR_FORM_FBREG
+};
+
 struct dwarf2_locexpr_baton
 {
   /* Pointer to the start of the location expression.  Valid only if SIZE is
@@ -112,6 +137,19 @@ struct dwarf2_locexpr_baton
   /* The compilation unit containing the symbol whose location
      we're computing.  */
   struct dwarf2_per_cu_data *per_cu;
+
+  /* The shape of the expression, as decoded by the first
+     locexpr_read_variable of a symbol using this baton.  Symbol batons
+     are allocated zeroed, so this starts as LOCEXPR_FORM_UNKNOWN.  */
+  ENUM_BITFIELD (dwarf2_locexpr_form) form : 8;
+
+  /* The DWARF register number, for LOCEXPR_FORM_REG and
+     LOCEXPR_FORM_BREG.  */
+  int regnum;
+
+  /* The register or frame base offset for LOCEXPR_FORM_BREG and
+     LOCEXPR_FORM_FBREG, or the address for LOCEXPR_FORM_ADDR.  */
+  LONGEST offset;
 };
 
 struct dwarf2_loclist_baton
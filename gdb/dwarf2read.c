@@ -66,6 +66,7 @@
 #include "gdb/gdb-index.h"
 #include <ctype.h>
 #include "gdb_bfd.h"
+#include "maint.h"
 #include "f-lang.h"
 #include "source.h"
 #include "filestuff.h"
@@ -75,6 +76,12 @@
 #include "gdb_string.h"
 #include "gdb_assert.h"
 #include <sys/types.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void *) -1)
+#endif
+#endif
 
 typedef struct symbol *symbolp;
 DEF_VEC_P (symbolp);
@@ -92,6 +99,13 @@ static int check_physname = 0;
 /* When non-zero, do not reject deprecated .gdb_index sections.  */
 static int use_deprecated_index_sections = 0;
 
+/* When non-zero, look up indices in, and save them to, the index
+   cache.  */
+static int index_cache_enabled = 0;
+
+/* The directory holding the index cache.  */
+static char *index_cache_directory;
+
 static const struct objfile_data *dwarf2_objfile_data_key;
 
 /* The "aclass" indices for various kinds of computed DWARF symbols.  */
@@ -201,6 +215,10 @@ struct mapped_index
 typedef struct dwarf2_per_cu_data *dwarf2_per_cu_ptr;
 DEF_VEC_P (dwarf2_per_cu_ptr);
 
+/* The maximum number of abbrev tables that are kept in the per-objfile
+   abbrev table cache while nothing is using them.  */
+#define ABBREV_CACHE_UNUSED_MAX 16
+
 /* Collection of data recorded per objfile.
    This hangs off of dwarf2_objfile_data_key.  */
 
@@ -261,12 +279,18 @@ struct dwarf2_per_objfile
     int nr_symtabs;
     int nr_symtab_sharers;
     int nr_stmt_less_type_units;
+    int nr_shared_type_units;
   } tu_stats;
 
   /* A chain of compilation units that are currently read in, so that
      they can be freed later.  */
   struct dwarf2_per_cu_data *read_in_chain;
 
+  /* The number of times a needed compilation unit was, or was not,
+     found in READ_IN_CHAIN.  See "maint info dwarf2-cache".  */
+  unsigned int cu_cache_hits;
+  unsigned int cu_cache_misses;
+
   /* A table mapping DW_AT_dwo_name values to struct dwo_file objects.
      This is NULL if the table hasn't been allocated yet.  */
   htab_t dwo_files;
@@ -310,8 +334,30 @@ struct dwarf2_per_objfile
      The mapping is done via (CU/TU + DIE offset) -> type.  */
   htab_t die_type_hash;
 
+  /* Table of the base, subroutine and array types read so far, keyed
+     by their structure; see lookup_consed_type.
+     This is NULL if not allocated yet.  */
+  htab_t consed_types;
+
   /* The CUs we recently read.  */
   VEC (dwarf2_per_cu_ptr) *just_read_cus;
+
+  /* Table of struct abbrev_table objects read so far, keyed by
+     section and offset.  See abbrev_table_get.
+     This is NULL if not allocated yet.  */
+  htab_t abbrev_tables;
+
+  /* The abbrev tables in ABBREV_TABLES whose reference count is zero,
+     least recently released first.  */
+  struct abbrev_table *unused_abbrev_tables[ABBREV_CACHE_UNUSED_MAX];
+  int n_unused_abbrev_tables;
+
+  /* If the index was found in the index cache, the contents of the
+     cached file and their size.  INDEX_CACHE_MAPPED is non-zero if
+     the contents were mmapped rather than read into malloc'd memory.  */
+  gdb_byte *index_cache_buffer;
+  size_t index_cache_size;
+  int index_cache_mapped;
 };
 
 static struct dwarf2_per_objfile *dwarf2_per_objfile;
@@ -831,6 +877,11 @@ struct dwo_file
   /* Table of TUs in the file.
      Each element is a struct dwo_unit.  */
   htab_t tus;
+
+  /* Non-zero if the file could not be found.  Such entries are kept in
+     the DWO file table so that later references to the same file do
+     not repeat the search, which can be slow on network filesystems.  */
+  int not_found;
 };
 
 /* These sections are what may appear in a DWP file.  */
@@ -1159,6 +1210,23 @@ struct abbrev_info
     unsigned short num_attrs;	/* number of attributes */
     struct attr_abbrev *attrs;	/* an array of attribute descriptions */
     struct abbrev_info *next;	/* next in chain */
+
+    /* Non-zero if the attributes of a DIE using this abbrev can be
+       skipped without looking at them: all the forms have a fixed size
+       and there is no DW_AT_sibling.  In this case the size of the
+       attributes is computed from the fields below; see
+       abbrev_fixed_attrs_size.  */
+    unsigned int size_fixed_p : 1;
+
+    /* The number of bytes taken by attributes whose size does not
+       depend on the unit header.  */
+    unsigned short fixed_size;
+
+    /* The number of address sized, offset sized and DW_FORM_ref_addr
+       attributes.  */
+    unsigned short n_addr_sized;
+    unsigned short n_offset_sized;
+    unsigned short n_ref_addr;
   };
 
 struct attr_abbrev
@@ -1175,9 +1243,17 @@ struct attr_abbrev
 struct abbrev_table
 {
   /* Where the abbrev table came from.
-     This is used as a sanity check when the table is used.  */
+     This is used as a sanity check when the table is used, and with
+     SECTION as the key of the abbrev table cache.  */
   sect_offset offset;
 
+  /* The section the abbrev table was read from.  */
+  struct dwarf2_section_info *section;
+
+  /* The number of users of this table.  Tables in the abbrev table
+     cache with a reference count of zero can be evicted.  */
+  int refcount;
+
   /* Storage for the abbrev table.  */
   struct obstack abbrev_obstack;
 
@@ -1224,6 +1300,10 @@ struct die_info
        type derived from this DIE.  */
     unsigned char building_fullname : 1;
 
+    /* True if we're presently reading the parameter types of the
+       subroutine type derived from this DIE.  */
+    unsigned char reading_param_types : 1;
+
     /* Abbrev number */
     unsigned int abbrev;
 
@@ -1361,7 +1441,40 @@ show_dwarf2_max_cache_age (struct ui_file *file, int from_tty,
 			    "dwarf2 compilation units is %s.\n"),
 		    value);
 }
+
+/* The upper bound on the memory used by the compilation units kept in
+   the cache, or -1 if unlimited.  Units exceeding the budget are
+   evicted least recently used first, even if they are younger than
+   dwarf2_max_cache_age.  */
+static int dwarf2_max_cache_bytes = -1;
+static void
+show_dwarf2_max_cache_bytes (struct ui_file *file, int from_tty,
+			     struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("The upper bound on the memory used by cached "
+			    "dwarf2 compilation units is %s.\n"),
+		    value);
+}
 
+/* When non-zero, don't build partial symbols for a type unit that
+   another objfile in the same program space already has partial
+   symbols for.  See "maint set dwarf2 dedup-type-units".  */
+static int dwarf2_dedup_type_units = 0;
+
+/* An entry in type_unit_owners: the objfile whose partial symbols
+   describe the type unit with signature SIGNATURE and length LENGTH.  */
+
+struct type_unit_owner
+{
+  ULONGEST signature;
+  unsigned int length;
+  struct objfile *objfile;
+};
+
+/* Hash table of struct type_unit_owner, shared by all objfiles.
+   Only used if dwarf2_dedup_type_units is set.  */
+static htab_t type_unit_owners;
+
 /* local function prototypes */
 
 static const char *get_section_name (const struct dwarf2_section_info *);
@@ -1378,6 +1491,8 @@ static struct partial_symtab *create_partial_symtab
 
 static void dwarf2_build_psymtabs_hard (struct objfile *);
 
+static void index_cache_store (struct objfile *);
+
 static void scan_partial_symbols (struct partial_die_info *,
 				  CORE_ADDR *, CORE_ADDR *,
 				  int, struct dwarf2_cu *);
@@ -1413,7 +1528,12 @@ static struct abbrev_table *abbrev_table_read_table
 
 static void abbrev_table_free (struct abbrev_table *);
 
-static void abbrev_table_free_cleanup (void *);
+static struct abbrev_table *abbrev_table_get
+  (struct dwarf2_section_info *, sect_offset);
+
+static void abbrev_table_release (struct abbrev_table *);
+
+static void abbrev_table_release_cleanup (void *);
 
 static void dwarf2_read_abbrevs (struct dwarf2_cu *,
 				 struct dwarf2_section_info *);
@@ -2587,7 +2707,8 @@ dw2_do_instantiate_symtab (struct dwarf2_per_cu_data *per_cu)
   if (IS_TYPE_UNIT_GROUP (per_cu))
     return;
 
-  back_to = make_cleanup (dwarf2_release_queue, NULL);
+  back_to = make_profile_phase_cleanup ("expand symtab", NULL);
+  make_cleanup (dwarf2_release_queue, NULL);
 
   if (dwarf2_per_objfile->using_index
       ? per_cu->v.quick->symtab == NULL
@@ -2955,44 +3076,32 @@ find_slot_in_mapped_hash (struct mapped_index *index, const char *name,
     }
 }
 
-/* A helper function that reads the .gdb_index from SECTION and fills
-   in MAP.  FILENAME is the name of the file containing the section;
-   it is used for error reporting.  DEPRECATED_OK is nonzero if it is
-   ok to use deprecated sections.
+/* A helper function that reads the index contents at ADDR, which
+   is SIZE bytes long, and fills in MAP.  FILENAME is the name of the
+   file containing the index; it is used for error reporting.
+   DEPRECATED_OK is nonzero if it is ok to use deprecated indices.
 
    CU_LIST, CU_LIST_ELEMENTS, TYPES_LIST, and TYPES_LIST_ELEMENTS are
    out parameters that are filled in with information about the CU and
-   TU lists in the section.
+   TU lists in the index.
 
    Returns 1 if all went well, 0 otherwise.  */
 
 static int
-read_index_from_section (struct objfile *objfile,
-			 const char *filename,
-			 int deprecated_ok,
-			 struct dwarf2_section_info *section,
-			 struct mapped_index *map,
-			 const gdb_byte **cu_list,
-			 offset_type *cu_list_elements,
-			 const gdb_byte **types_list,
-			 offset_type *types_list_elements)
+read_index_from_buffer (const char *filename,
+			int deprecated_ok,
+			const gdb_byte *addr,
+			offset_type size,
+			struct mapped_index *map,
+			const gdb_byte **cu_list,
+			offset_type *cu_list_elements,
+			const gdb_byte **types_list,
+			offset_type *types_list_elements)
 {
-  const gdb_byte *addr;
   offset_type version;
   offset_type *metadata;
   int i;
 
-  if (dwarf2_section_empty_p (section))
-    return 0;
-
-  /* Older elfutils strip versions could keep the section in the main
-     executable while splitting it for the separate debug info file.  */
-  if ((get_section_flags (section) & SEC_HAS_CONTENTS) == 0)
-    return 0;
-
-  dwarf2_read_section (objfile, section);
-
-  addr = section->buffer;
   /* Version check.  */
   version = MAYBE_SWAP (*(offset_type *) addr);
   /* Versions earlier than 3 emitted every copy of a psymbol.  This
@@ -3043,7 +3152,7 @@ to use the section anyway."),
     return 0;
 
   map->version = version;
-  map->total_size = section->size;
+  map->total_size = size;
 
   metadata = (offset_type *) (addr + sizeof (offset_type));
 
@@ -3075,6 +3184,188 @@ to use the section anyway."),
   return 1;
 }
 
+/* A helper function that reads the .gdb_index from SECTION and fills
+   in MAP.  The remaining arguments are as for read_index_from_buffer.
+
+   Returns 1 if all went well, 0 otherwise.  */
+
+static int
+read_index_from_section (struct objfile *objfile,
+			 const char *filename,
+			 int deprecated_ok,
+			 struct dwarf2_section_info *section,
+			 struct mapped_index *map,
+			 const gdb_byte **cu_list,
+			 offset_type *cu_list_elements,
+			 const gdb_byte **types_list,
+			 offset_type *types_list_elements)
+{
+  if (dwarf2_section_empty_p (section))
+    return 0;
+
+  /* Older elfutils strip versions could keep the section in the main
+     executable while splitting it for the separate debug info file.  */
+  if ((get_section_flags (section) & SEC_HAS_CONTENTS) == 0)
+    return 0;
+
+  dwarf2_read_section (objfile, section);
+
+  return read_index_from_buffer (filename, deprecated_ok,
+				 section->buffer, section->size, map,
+				 cu_list, cu_list_elements,
+				 types_list, types_list_elements);
+}
+
+/* Return the name of the index cache file for OBJFILE, or NULL if
+   OBJFILE cannot be cached.  The result is malloc'd.  */
+
+static char *
+index_cache_file_name (struct objfile *objfile)
+{
+  const struct elf_build_id *build_id;
+  char *name, *p;
+  size_t i;
+
+  if (index_cache_directory == NULL || *index_cache_directory == '\0')
+    return NULL;
+
+  build_id = build_id_bfd_get (objfile->obfd);
+  if (build_id == NULL || build_id->size == 0)
+    return NULL;
+
+  name = xmalloc (strlen (index_cache_directory) + strlen (SLASH_STRING)
+		  + 2 * build_id->size + strlen (INDEX_SUFFIX) + 1);
+  p = name;
+  strcpy (p, index_cache_directory);
+  p += strlen (p);
+  strcpy (p, SLASH_STRING);
+  p += strlen (p);
+  for (i = 0; i < build_id->size; ++i)
+    {
+      sprintf (p, "%02x", (unsigned) build_id->data[i]);
+      p += 2;
+    }
+  strcpy (p, INDEX_SUFFIX);
+
+  return name;
+}
+
+/* Look for OBJFILE in the index cache.  If a plausible index file is
+   found, record its contents in dwarf2_per_objfile and return 1.
+   Otherwise, return 0.  */
+
+static int
+index_cache_lookup (struct objfile *objfile)
+{
+  char *filename;
+  struct cleanup *cleanup;
+  struct stat st;
+  gdb_byte *buffer = NULL;
+  const offset_type *metadata;
+  offset_type prev;
+  size_t size;
+  int mapped = 0;
+  int fd, i;
+
+  if (!index_cache_enabled)
+    return 0;
+
+  /* The index of a 'dwz -m' program refers to the .gdb_index section
+     of the dwz file, which the cache does not provide.  */
+  if (dwarf2_get_dwz_file () != NULL)
+    return 0;
+
+  filename = index_cache_file_name (objfile);
+  if (filename == NULL)
+    return 0;
+  cleanup = make_cleanup (xfree, filename);
+
+  fd = gdb_open_cloexec (filename, O_RDONLY | O_BINARY, 0);
+  if (fd < 0)
+    {
+      do_cleanups (cleanup);
+      return 0;
+    }
+
+  if (fstat (fd, &st) < 0 || st.st_size < 6 * sizeof (offset_type))
+    {
+      close (fd);
+      do_cleanups (cleanup);
+      return 0;
+    }
+  size = st.st_size;
+
+#ifdef HAVE_MMAP
+  buffer = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (buffer == MAP_FAILED)
+    buffer = NULL;
+  else
+    mapped = 1;
+#endif
+
+  if (buffer == NULL)
+    {
+      size_t done = 0;
+
+      buffer = xmalloc (size);
+      while (done < size)
+	{
+	  ssize_t n = read (fd, buffer + done, size - done);
+
+	  if (n <= 0)
+	    break;
+	  done += n;
+	}
+      if (done < size)
+	{
+	  xfree (buffer);
+	  close (fd);
+	  do_cleanups (cleanup);
+	  return 0;
+	}
+    }
+  close (fd);
+
+  /* Unlike a section in the objfile, a cache file could have been
+     truncated or otherwise damaged, so make sure the offsets in the
+     header at least stay within the file.  */
+  metadata = (const offset_type *) buffer;
+  prev = 6 * sizeof (offset_type);
+  for (i = 1; i < 6; ++i)
+    {
+      offset_type val = MAYBE_SWAP (metadata[i]);
+
+      if (val < prev || val > size)
+	break;
+      prev = val;
+    }
+  if (i < 6)
+    {
+      if (dwarf2_read_debug)
+	fprintf_unfiltered (gdb_stdlog, "Ignoring damaged index cache file %s\n",
+			    filename);
+#ifdef HAVE_MMAP
+      if (mapped)
+	munmap (buffer, size);
+      else
+#endif
+	xfree (buffer);
+      do_cleanups (cleanup);
+      return 0;
+    }
+
+  if (dwarf2_read_debug)
+    fprintf_unfiltered (gdb_stdlog, "Using index cache file %s for %s\n",
+			filename, objfile_name (objfile));
+
+  dwarf2_per_objfile->index_cache_buffer = buffer;
+  dwarf2_per_objfile->index_cache_size = size;
+  dwarf2_per_objfile->index_cache_mapped = mapped;
+
+  do_cleanups (cleanup);
+  return 1;
+}
+
 
 /* Read the index file.  If everything went ok, initialize the "quick"
    elements of all the CUs and return 1.  Otherwise, return 0.  */
@@ -3092,7 +3383,19 @@ dwarf2_read_index (struct objfile *objfile)
 				&dwarf2_per_objfile->gdb_index, &local_map,
 				&cu_list, &cu_list_elements,
 				&types_list, &types_list_elements))
-    return 0;
+    {
+      /* Fall back to an index saved in the index cache by an earlier
+	 session.  */
+      if (!index_cache_lookup (objfile)
+	  || !read_index_from_buffer (objfile_name (objfile),
+				      use_deprecated_index_sections,
+				      dwarf2_per_objfile->index_cache_buffer,
+				      dwarf2_per_objfile->index_cache_size,
+				      &local_map,
+				      &cu_list, &cu_list_elements,
+				      &types_list, &types_list_elements))
+	return 0;
+    }
 
   /* Don't use the index if it's empty.  */
   if (local_map.symbol_table_slots == 0)
@@ -4069,6 +4372,9 @@ const struct quick_symbol_functions dwarf2_gdb_index_functions =
 int
 dwarf2_initialize_objfile (struct objfile *objfile)
 {
+  struct cleanup *cleanup;
+  int found;
+
   /* If we're about to read full symbols, don't bother with the
      indices.  In this case we also don't care if some other debug
      format is making psymtabs, because they are all about to be
@@ -4098,24 +4404,58 @@ dwarf2_initialize_objfile (struct objfile *objfile)
       return 1;
     }
 
-  if (dwarf2_read_index (objfile))
-    return 1;
+  cleanup = make_profile_phase_cleanup ("read index", objfile_name (objfile));
+  found = dwarf2_read_index (objfile);
+  do_cleanups (cleanup);
 
-  return 0;
+  return found;
 }
 
 
 
+/* Return an estimate of the number of partial symbols that reading
+   the .debug_info section of the current objfile will produce.
+   This is used to size the psymbol lists up front: large programs
+   would otherwise spend a noticeable part of psymtab construction
+   repeatedly growing and copying them.  The estimate deliberately
+   errs on the low side since the lists are never shrunk.  */
+
+static int
+dwarf2_estimate_psymbol_count (void)
+{
+  bfd_size_type info_size = dwarf2_per_objfile->info.size;
+  struct dwz_file *dwz = dwarf2_per_objfile->dwz_file;
+  bfd_size_type estimate;
+
+  if (dwz != NULL)
+    info_size += dwz->info.size;
+
+  /* Empirically, there are somewhat fewer than one interesting
+     global or static name per 64 bytes of .debug_info.  Note that
+     init_psymbol_list divides the total between both lists.  */
+  estimate = info_size / 64;
+
+  if (estimate < 1024)
+    return 1024;
+  if (estimate > INT_MAX / 2)
+    return INT_MAX / 2;
+  return estimate;
+}
+
 /* Build a partial symbol table.  */
 
 void
 dwarf2_build_psymtabs (struct objfile *objfile)
 {
   volatile struct gdb_exception except;
+  struct cleanup *phase;
+
+  phase = make_profile_phase_cleanup ("build psymtabs",
+				      objfile_name (objfile));
 
   if (objfile->global_psymbols.size == 0 && objfile->static_psymbols.size == 0)
     {
-      init_psymbol_list (objfile, 1024);
+      init_psymbol_list (objfile, dwarf2_estimate_psymbol_count ());
     }
 
   TRY_CATCH (except, RETURN_MASK_ERROR)
@@ -4130,6 +4470,10 @@ dwarf2_build_psymtabs (struct objfile *objfile)
     }
   if (except.reason < 0)
     exception_print (gdb_stderr, except);
+  else
+    index_cache_store (objfile);
+
+  do_cleanups (phase);
 }
 
 /* Return the total length of the CU described by HEADER.  */
@@ -5767,9 +6111,9 @@ build_type_unit_groups (die_reader_func_ftype *func, void *data)
 
   /* TUs typically share abbrev tables, and there can be way more TUs than
      abbrev tables.  Sort by abbrev table to reduce the number of times we
-     read each abbrev table in.
-     Alternatives are to punt or to maintain a cache of abbrev tables.
-     This is simpler and efficient enough for now.
+     read each abbrev table in.  The abbrev table cache would catch
+     most of this anyway, but sorting keeps the number of tables in
+     use at any one time down to one.
 
      Later we group TUs by their DW_AT_stmt_list value (as this defines the
      symtab to use).  Typically TUs with the same abbrev offset have the same
@@ -5809,7 +6153,7 @@ build_type_unit_groups (die_reader_func_ftype *func, void *data)
 
   abbrev_offset.sect_off = ~(unsigned) 0;
   abbrev_table = NULL;
-  make_cleanup (abbrev_table_free_cleanup, &abbrev_table);
+  make_cleanup (abbrev_table_release_cleanup, &abbrev_table);
 
   for (i = 0; i < dwarf2_per_objfile->n_type_units; ++i)
     {
@@ -5821,15 +6165,14 @@ build_type_unit_groups (die_reader_func_ftype *func, void *data)
 	{
 	  if (abbrev_table != NULL)
 	    {
-	      abbrev_table_free (abbrev_table);
-	      /* Reset to NULL in case abbrev_table_read_table throws
-		 an error: abbrev_table_free_cleanup will get called.  */
+	      abbrev_table_release (abbrev_table);
+	      /* Reset to NULL in case abbrev_table_get throws
+		 an error: abbrev_table_release_cleanup will get called.  */
 	      abbrev_table = NULL;
 	    }
 	  abbrev_offset = tu->abbrev_offset;
 	  abbrev_table =
-	    abbrev_table_read_table (&dwarf2_per_objfile->abbrev,
-				     abbrev_offset);
+	    abbrev_table_get (&dwarf2_per_objfile->abbrev, abbrev_offset);
 	  ++tu_stats->nr_uniq_abbrev_tables;
 	}
 
@@ -5876,6 +6219,9 @@ build_type_unit_groups (die_reader_func_ftype *func, void *data)
 			  tu_stats->nr_symtab_sharers);
       fprintf_unfiltered (gdb_stdlog, "  %d type units without a stmt_list\n",
 			  tu_stats->nr_stmt_less_type_units);
+      fprintf_unfiltered (gdb_stdlog, "  %d type units shared with another"
+			  " objfile\n",
+			  tu_stats->nr_shared_type_units);
     }
 }
 
@@ -6086,6 +6432,85 @@ process_psymtab_comp_unit (struct dwarf2_per_cu_data *this_cu,
   age_cached_comp_units ();
 }
 
+static hashval_t
+hash_type_unit_owner (const void *item)
+{
+  const struct type_unit_owner *owner = item;
+
+  /* This drops the top 32 bits of the signature, but is ok for a hash.  */
+  return owner->signature;
+}
+
+static int
+eq_type_unit_owner (const void *item_lhs, const void *item_rhs)
+{
+  const struct type_unit_owner *lhs = item_lhs;
+  const struct type_unit_owner *rhs = item_rhs;
+
+  return lhs->signature == rhs->signature;
+}
+
+/* Return non-zero if the partial symbols of SIG_TYPE would duplicate
+   those of a type unit already read by another objfile of the same
+   program space.  Otherwise record the current objfile as the owner of
+   SIG_TYPE's signature and return zero.
+
+   The signature is a hash of the type's contents, so two units with the
+   same signature describe the same type.  The unit length is compared
+   too, as a cheap guard against broken producers.  */
+
+static int
+type_unit_shared_p (struct signatured_type *sig_type)
+{
+  struct objfile *objfile = dwarf2_per_objfile->objfile;
+  struct type_unit_owner find_entry, *owner;
+  void **slot;
+
+  if (type_unit_owners == NULL)
+    type_unit_owners = htab_create_alloc (1021, hash_type_unit_owner,
+					  eq_type_unit_owner, xfree,
+					  xcalloc, xfree);
+
+  find_entry.signature = sig_type->signature;
+  slot = htab_find_slot (type_unit_owners, &find_entry, INSERT);
+  owner = *slot;
+  if (owner != NULL)
+    return (owner->objfile != objfile
+	    && owner->objfile->pspace == objfile->pspace
+	    && owner->length == sig_type->per_cu.length);
+
+  owner = XNEW (struct type_unit_owner);
+  owner->signature = sig_type->signature;
+  owner->length = sig_type->per_cu.length;
+  owner->objfile = objfile;
+  *slot = owner;
+  return 0;
+}
+
+/* Traversal function for forget_type_unit_owners.  */
+
+static int
+forget_type_unit_owner (void **slot, void *info)
+{
+  struct type_unit_owner *owner = *slot;
+
+  if (owner->objfile == info)
+    htab_clear_slot (type_unit_owners, slot);
+  return 1;
+}
+
+/* Remove OBJFILE's entries from type_unit_owners.  Objfiles that skipped
+   those units keep their type units, which are still found by
+   signature, but not the partial symbols naming them.  */
+
+static void
+forget_type_unit_owners (struct objfile *objfile)
+{
+  if (type_unit_owners != NULL)
+    htab_traverse_noresize (type_unit_owners, forget_type_unit_owner,
+			    objfile);
+}
+
 /* Reader function for build_type_psymtabs.  */
 
 static void
@@ -6112,6 +6537,12 @@ build_type_psymtabs_reader (const struct die_reader_specs *reader,
   if (! has_children)
     return;
 
+  if (dwarf2_dedup_type_units && type_unit_shared_p (sig_type))
+    {
+      ++dwarf2_per_objfile->tu_stats.nr_shared_type_units;
+      return;
+    }
+
   attr = dwarf2_attr_no_follow (type_unit_die, DW_AT_stmt_list);
   tu_group = get_type_unit_group (cu, attr);
 
@@ -6987,6 +7418,25 @@ skip_children (const struct die_reader_specs *reader, const gdb_byte *info_ptr)
     }
 }
 
+/* Return the size of the attributes of a DIE in CU using ABBREV,
+   which must have size_fixed_p set.  */
+
+static inline unsigned int
+abbrev_fixed_attrs_size (const struct abbrev_info *abbrev,
+			 const struct dwarf2_cu *cu)
+{
+  unsigned int addr_size = cu->header.addr_size;
+  unsigned int offset_size = cu->header.offset_size;
+
+  /* In DWARF 2, DW_FORM_ref_addr is address sized; in DWARF 3
+     and later it is offset sized.  */
+  return (abbrev->fixed_size
+	  + abbrev->n_addr_sized * addr_size
+	  + abbrev->n_offset_sized * offset_size
+	  + abbrev->n_ref_addr * (cu->header.version == 2
+				  ? addr_size : offset_size));
+}
+
 /* Scan the debug information for CU starting at INFO_PTR in buffer BUFFER.
    INFO_PTR should point just after the initial uleb128 of a DIE, and the
    abbrev corresponding to that skipped uleb128 should be passed in
@@ -7006,6 +7456,15 @@ skip_one_die (const struct die_reader_specs *reader, const gdb_byte *info_ptr,
   const gdb_byte *start_info_ptr = info_ptr;
   unsigned int form, i;
 
+  /* Fast path: nothing in the attributes needs decoding.  */
+  if (abbrev->size_fixed_p)
+    {
+      info_ptr += abbrev_fixed_attrs_size (abbrev, cu);
+      if (abbrev->has_children)
+	return skip_children (reader, info_ptr);
+      return info_ptr;
+    }
+
   for (i = 0; i < abbrev->num_attrs; i++)
     {
       /* The only abbrev we care about is DW_AT_sibling.  */
@@ -7243,11 +7702,13 @@ maybe_queue_comp_unit (struct dwarf2_cu *dependent_cu,
      used.  */
   if (per_cu->cu != NULL)
     {
+      ++dwarf2_per_objfile->cu_cache_hits;
       per_cu->cu->last_used = 0;
       return 0;
     }
 
   /* Add it to the queue.  */
+  ++dwarf2_per_objfile->cu_cache_misses;
   queue_comp_unit (per_cu, pretend_language);
 
   return 1;
@@ -10470,6 +10931,7 @@ lookup_dwo_cutu (struct dwarf2_per_cu_data *this_unit,
   void **dwo_file_slot;
   struct dwo_file *dwo_file;
   struct dwp_file *dwp_file;
+  struct cleanup *phase;
 
   /* First see if there's a DWP file.
      If we have a DWP file but didn't find the DWO inside it, don't
@@ -10509,12 +10971,31 @@ lookup_dwo_cutu (struct dwarf2_per_cu_data *this_unit,
       if (*dwo_file_slot == NULL)
 	{
 	  /* Read in the file and build a table of the CUs/TUs it contains.  */
-	  *dwo_file_slot = open_and_init_dwo_file (this_unit, dwo_name, comp_dir);
+	  phase = make_profile_phase_cleanup ("open DWO", dwo_name);
+	  dwo_file = open_and_init_dwo_file (this_unit, dwo_name, comp_dir);
+	  do_cleanups (phase);
+	  if (dwo_file == NULL)
+	    {
+	      /* Remember that the file is missing.  */
+	      dwo_file = OBSTACK_ZALLOC (&objfile->objfile_obstack,
+					 struct dwo_file);
+	      dwo_file->dwo_name = dwo_name;
+	      dwo_file->comp_dir = comp_dir;
+	      dwo_file->not_found = 1;
+	    }
+	  *dwo_file_slot = dwo_file;
 	}
-      /* NOTE: This will be NULL if unable to open the file.  */
-      dwo_file = *dwo_file_slot;
+      else
+	{
+	  dwo_file = *dwo_file_slot;
 
-      if (dwo_file != NULL)
+	  /* We've already warned about the missing file, don't do it
+	     again for every unit that refers to it.  */
+	  if (dwo_file->not_found)
+	    return NULL;
+	}
+
+      if (!dwo_file->not_found)
 	{
 	  struct dwo_unit *dwo_cutu = NULL;
 
@@ -13084,35 +13565,225 @@ process_enumeration_scope (struct die_info *die, struct dwarf2_cu *cu)
   new_symbol (die, this_type, cu);
 }
 
-/* Extract all information from a DW_TAG_array_type DIE and put it in
-   the DIE's type field.  For now, this only handles one dimensional
-   arrays.  */
+/* Hash-consing of types.
 
-static struct type *
-read_array_type (struct die_info *die, struct dwarf2_cu *cu)
-{
-  struct objfile *objfile = cu->objfile;
-  struct die_info *child_die;
-  struct type *type;
-  struct type *element_type, *range_type, *index_type;
-  struct type **range_types = NULL;
-  struct attribute *attr;
-  int ndim = 0;
-  struct cleanup *back_to;
-  const char *name;
+   Every CU of an objfile has its own "int", and the same function
+   signatures and array types are read again in each CU that includes
+   the header declaring them.  The base, subroutine and array types
+   that nothing changes once they are read are recorded in
+   DWARF2_PER_OBJFILE->CONSED_TYPES, keyed by their structure, and a DIE
+   with the structure of a recorded type gets that type instead of a
+   new copy.  Types are compared by their immediate structure only:
+   two types match if their component types are the same objects.  */
 
-  element_type = die_type (die, cu);
+/* Hash function for the table of consed types.  */
 
-  /* The die_type call above may have already set the type for this DIE.  */
-  type = get_die_type (die, cu);
-  if (type)
-    return type;
+static hashval_t
+hash_consed_type (const void *item)
+{
+  const struct type *type = item;
+  hashval_t hash;
+  int i;
 
-  /* Irix 6.2 native cc creates array types without children for
-     arrays with unspecified length.  */
-  if (die->child == NULL)
+  hash = TYPE_CODE (type);
+  if (TYPE_NAME (type) != NULL)
+    hash += htab_hash_string (TYPE_NAME (type));
+  hash = hash * 67 + htab_hash_pointer (TYPE_TARGET_TYPE (type));
+
+  switch (TYPE_CODE (type))
     {
-      index_type = objfile_type (objfile)->builtin_int;
+    case TYPE_CODE_FUNC:
+      hash = hash * 67 + TYPE_NFIELDS (type);
+      for (i = 0; i < TYPE_NFIELDS (type); i++)
+	hash = hash * 67 + htab_hash_pointer (TYPE_FIELD_TYPE (type, i));
+      break;
+
+    case TYPE_CODE_ARRAY:
+      /* The length of an array of a stub type changes once the stub
+	 is resolved, so only the bounds are used.  */
+      hash = hash * 67 + TYPE_LOW_BOUND (TYPE_INDEX_TYPE (type));
+      hash = hash * 67 + TYPE_HIGH_BOUND (TYPE_INDEX_TYPE (type));
+      break;
+
+    default:
+      hash = hash * 67 + TYPE_LENGTH (type);
+      break;
+    }
+
+  return hash;
+}
+
+/* Equality function for the table of consed types.  */
+
+static int
+eq_consed_type (const void *item_lhs, const void *item_rhs)
+{
+  const struct type *lhs = item_lhs;
+  const struct type *rhs = item_rhs;
+  int i;
+
+  if (TYPE_CODE (lhs) != TYPE_CODE (rhs)
+      || TYPE_TARGET_TYPE (lhs) != TYPE_TARGET_TYPE (rhs)
+      || TYPE_NFIELDS (lhs) != TYPE_NFIELDS (rhs)
+      || TYPE_UNSIGNED (lhs) != TYPE_UNSIGNED (rhs)
+      || TYPE_NOSIGN (lhs) != TYPE_NOSIGN (rhs))
+    return 0;
+
+  if (TYPE_NAME (lhs) == NULL || TYPE_NAME (rhs) == NULL)
+    {
+      if (TYPE_NAME (lhs) != TYPE_NAME (rhs))
+	return 0;
+    }
+  else if (strcmp (TYPE_NAME (lhs), TYPE_NAME (rhs)) != 0)
+    return 0;
+
+  switch (TYPE_CODE (lhs))
+    {
+    case TYPE_CODE_FUNC:
+      if (TYPE_PROTOTYPED (lhs) != TYPE_PROTOTYPED (rhs)
+	  || TYPE_VARARGS (lhs) != TYPE_VARARGS (rhs)
+	  || (TYPE_CALLING_CONVENTION (lhs)
+	      != TYPE_CALLING_CONVENTION (rhs)))
+	return 0;
+      for (i = 0; i < TYPE_NFIELDS (lhs); i++)
+	if (TYPE_FIELD_TYPE (lhs, i) != TYPE_FIELD_TYPE (rhs, i)
+	    || (TYPE_FIELD_ARTIFICIAL (lhs, i)
+		!= TYPE_FIELD_ARTIFICIAL (rhs, i)))
+	  return 0;
+      return 1;
+
+    case TYPE_CODE_ARRAY:
+      {
+	/* Only arrays indexed by unnamed ranges are recorded; see
+	   dwarf2_create_array_type.  */
+	struct type *lrange = TYPE_INDEX_TYPE (lhs);
+	struct type *rrange = TYPE_INDEX_TYPE (rhs);
+
+	return (TYPE_TARGET_TYPE (lrange) == TYPE_TARGET_TYPE (rrange)
+		&& TYPE_LENGTH (lrange) == TYPE_LENGTH (rrange)
+		&& TYPE_UNSIGNED (lrange) == TYPE_UNSIGNED (rrange)
+		&& TYPE_LOW_BOUND (lrange) == TYPE_LOW_BOUND (rrange)
+		&& TYPE_HIGH_BOUND (lrange) == TYPE_HIGH_BOUND (rrange)
+		&& (TYPE_LOW_BOUND_UNDEFINED (lrange)
+		    == TYPE_LOW_BOUND_UNDEFINED (rrange))
+		&& (TYPE_HIGH_BOUND_UNDEFINED (lrange)
+		    == TYPE_HIGH_BOUND_UNDEFINED (rrange)));
+      }
+
+    default:
+      return TYPE_LENGTH (lhs) == TYPE_LENGTH (rhs);
+    }
+}
+
+/* Return the type already read into the current objfile that has the
+   structure of TMPL, or NULL if there is none.  TMPL need only
+   have the parts of a type that eq_consed_type looks at.  */
+
+static struct type *
+lookup_consed_type (struct type *tmpl)
+{
+  if (dwarf2_per_objfile->consed_types == NULL)
+    return NULL;
+
+  return htab_find (dwarf2_per_objfile->consed_types, tmpl);
+}
+
+/* Record TYPE, just read in CU, for lookup_consed_type.  TYPE must not
+   be changed afterwards.  */
+
+static void
+record_consed_type (struct type *type, struct dwarf2_cu *cu)
+{
+  struct objfile *objfile = cu->objfile;
+  void **slot;
+
+  if (TYPE_OBJFILE (type) != objfile)
+    return;
+
+  if (dwarf2_per_objfile->consed_types == NULL)
+    dwarf2_per_objfile->consed_types
+      = htab_create_alloc_ex (127, hash_consed_type, eq_consed_type,
+			      NULL, &objfile->objfile_obstack,
+			      hashtab_obstack_allocate,
+			      dummy_obstack_deallocate);
+
+  slot = htab_find_slot (dwarf2_per_objfile->consed_types, type, INSERT);
+  if (*slot == NULL)
+    *slot = type;
+}
+
+/* Return an array of ELEMENT_TYPE indexed by RANGE_TYPE, for an array
+   DIE of CU.  If SHARE is non-zero, the caller will not change the
+   type, and an identical array type read before may be returned.  */
+
+static struct type *
+dwarf2_create_array_type (struct type *element_type,
+			  struct type *range_type, int share,
+			  struct dwarf2_cu *cu)
+{
+  struct type *type;
+
+  share = (share
+	   && TYPE_CODE (range_type) == TYPE_CODE_RANGE
+	   && TYPE_NAME (range_type) == NULL);
+
+  if (share)
+    {
+      struct main_type main_tmpl;
+      struct type tmpl;
+      struct field field;
+
+      memset (&main_tmpl, 0, sizeof (main_tmpl));
+      memset (&tmpl, 0, sizeof (tmpl));
+      memset (&field, 0, sizeof (field));
+      TYPE_MAIN_TYPE (&tmpl) = &main_tmpl;
+      TYPE_CODE (&tmpl) = TYPE_CODE_ARRAY;
+      TYPE_TARGET_TYPE (&tmpl) = element_type;
+      TYPE_NFIELDS (&tmpl) = 1;
+      TYPE_FIELDS (&tmpl) = &field;
+      TYPE_INDEX_TYPE (&tmpl) = range_type;
+
+      type = lookup_consed_type (&tmpl);
+      if (type != NULL)
+	return type;
+    }
+
+  type = create_array_type (NULL, element_type, range_type);
+  if (share)
+    record_consed_type (type, cu);
+  return type;
+}
+
+/* Extract all information from a DW_TAG_array_type DIE and put it in
+   the DIE's type field.  For now, this only handles one dimensional
+   arrays.  */
+
+static struct type *
+read_array_type (struct die_info *die, struct dwarf2_cu *cu)
+{
+  struct objfile *objfile = cu->objfile;
+  struct die_info *child_die;
+  struct type *type;
+  struct type *element_type, *range_type, *index_type;
+  struct type **range_types = NULL;
+  struct attribute *attr;
+  int ndim = 0;
+  struct cleanup *back_to;
+  const char *name;
+  int share;
+
+  element_type = die_type (die, cu);
+
+  /* The die_type call above may have already set the type for this DIE.  */
+  type = get_die_type (die, cu);
+  if (type)
+    return type;
+
+  /* Irix 6.2 native cc creates array types without children for
+     arrays with unspecified length.  */
+  if (die->child == NULL)
+    {
+      index_type = objfile_type (objfile)->builtin_int;
       range_type = create_range_type (NULL, index_type, 0, -1);
       type = create_array_type (NULL, element_type, range_type);
       return set_die_type (die, type, cu);
@@ -13144,6 +13815,14 @@ read_array_type (struct die_info *die, struct dwarf2_cu *cu)
       child_die = sibling_die (child_die);
     }
 
+  /* The array types can be shared with other DIEs unless the code
+     below changes the outermost one.  */
+  name = dwarf2_name (die, cu);
+  share = (name == NULL
+	   && !need_gnat_info (cu)
+	   && dwarf2_attr (die, DW_AT_GNU_vector, cu) == NULL
+	   && dwarf2_attr (die, DW_AT_byte_size, cu) == NULL);
+
   /* Dwarf2 dimensions are output from left to right, create the
      necessary array types in backwards order.  */
 
@@ -13154,12 +13833,12 @@ read_array_type (struct die_info *die, struct dwarf2_cu *cu)
       int i = 0;
 
       while (i < ndim)
-	type = create_array_type (NULL, type, range_types[i++]);
+	type = dwarf2_create_array_type (type, range_types[i++], share, cu);
     }
   else
     {
       while (ndim-- > 0)
-	type = create_array_type (NULL, type, range_types[ndim]);
+	type = dwarf2_create_array_type (type, range_types[ndim], share, cu);
     }
 
   /* Understand Dwarf2 support for vector types (like they occur on
@@ -13186,7 +13865,6 @@ read_array_type (struct die_info *die, struct dwarf2_cu *cu)
 		     "than the total size of elements"));
     }
 
-  name = dwarf2_name (die, cu);
   if (name)
     TYPE_NAME (type) = name;
 
@@ -13286,8 +13964,8 @@ mark_common_block_symbol_computed (struct symbol *sym,
   gdb_assert (attr_form_is_block (member_loc)
 	      || attr_form_is_constant (member_loc));
 
-  baton = obstack_alloc (&objfile->objfile_obstack,
-			 sizeof (struct dwarf2_locexpr_baton));
+  baton = OBSTACK_ZALLOC (&objfile->objfile_obstack,
+			  struct dwarf2_locexpr_baton);
   baton->per_cu = cu->per_cu;
   gdb_assert (baton->per_cu);
 
@@ -13869,10 +14547,14 @@ prototyped_function_p (struct die_info *die, struct dwarf2_cu *cu)
 static struct type *
 read_subroutine_type (struct die_info *die, struct dwarf2_cu *cu)
 {
-  struct objfile *objfile = cu->objfile;
   struct type *type;		/* Type that this function returns.  */
   struct type *ftype;		/* Function that returns above type.  */
   struct attribute *attr;
+  struct field *fields = NULL;
+  int nparams = 0, varargs = 0, prototyped, consed = 0;
+  unsigned calling_convention;
+  unsigned char reading_param_types;
+  struct cleanup *back_to;
 
   type = die_type (die, cu);
 
@@ -13881,56 +14563,60 @@ read_subroutine_type (struct die_info *die, struct dwarf2_cu *cu)
   if (ftype)
     return ftype;
 
-  ftype = lookup_function_type (type);
-
-  if (prototyped_function_p (die, cu))
-    TYPE_PROTOTYPED (ftype) = 1;
+  prototyped = prototyped_function_p (die, cu);
 
   /* Store the calling convention in the type if it's available in
      the subroutine die.  Otherwise set the calling convention to
      the default value DW_CC_normal.  */
   attr = dwarf2_attr (die, DW_AT_calling_convention, cu);
   if (attr)
-    TYPE_CALLING_CONVENTION (ftype) = DW_UNSND (attr);
+    calling_convention = DW_UNSND (attr);
   else if (cu->producer && strstr (cu->producer, "IBM XL C for OpenCL"))
-    TYPE_CALLING_CONVENTION (ftype) = DW_CC_GDB_IBM_OpenCL;
+    calling_convention = DW_CC_GDB_IBM_OpenCL;
   else
-    TYPE_CALLING_CONVENTION (ftype) = DW_CC_normal;
+    calling_convention = DW_CC_normal;
+
+  /* The parameter types are read before the subroutine type is made,
+     so that a DW_TAG_subroutine_type identical to one read before can
+     share its type; see lookup_consed_type.  If reading a parameter
+     type leads back to this DIE, the nested call below makes the
+     subroutine type and adds it to the die immediately, so that we
+     don't infinitely recurse when dealing with parameters declared as
+     the same subroutine type.  Subprogram types are never shared:
+     read_call_site_scope adds the tail calls of the subprogram to its
+     type.  */
+  if (die->reading_param_types || die->tag != DW_TAG_subroutine_type)
+    {
+      ftype = lookup_function_type (type);
+      TYPE_PROTOTYPED (ftype) = prototyped;
+      TYPE_CALLING_CONVENTION (ftype) = calling_convention;
+      set_die_type (die, ftype, cu);
+    }
 
-  /* We need to add the subroutine type to the die immediately so
-     we don't infinitely recurse when dealing with parameters
-     declared as the same subroutine type.  */
-  set_die_type (die, ftype, cu);
+  back_to = make_cleanup (null_cleanup, NULL);
+  reading_param_types = die->reading_param_types;
+  die->reading_param_types = 1;
 
   if (die->child != NULL)
     {
-      struct type *void_type = objfile_type (objfile)->builtin_void;
       struct die_info *child_die;
-      int nparams, iparams;
+      int iparams;
 
       /* Count the number of parameters.
          FIXME: GDB currently ignores vararg functions, but knows about
          vararg member functions.  */
-      nparams = 0;
       child_die = die->child;
       while (child_die && child_die->tag)
 	{
 	  if (child_die->tag == DW_TAG_formal_parameter)
 	    nparams++;
 	  else if (child_die->tag == DW_TAG_unspecified_parameters)
-	    TYPE_VARARGS (ftype) = 1;
+	    varargs = 1;
 	  child_die = sibling_die (child_die);
 	}
 
-      /* Allocate storage for parameters and fill them in.  */
-      TYPE_NFIELDS (ftype) = nparams;
-      TYPE_FIELDS (ftype) = (struct field *)
-	TYPE_ZALLOC (ftype, nparams * sizeof (struct field));
-
-      /* TYPE_FIELD_TYPE must never be NULL.  Pre-fill the array to ensure it
-	 even if we error out during the parameters reading below.  */
-      for (iparams = 0; iparams < nparams; iparams++)
-	TYPE_FIELD_TYPE (ftype, iparams) = void_type;
+      fields = xcalloc (nparams, sizeof (struct field));
+      make_cleanup (xfree, fields);
 
       iparams = 0;
       child_die = die->child;
@@ -13951,10 +14637,10 @@ read_subroutine_type (struct die_info *die, struct dwarf2_cu *cu)
 		 4.5 does not yet generate.  */
 	      attr = dwarf2_attr (child_die, DW_AT_artificial, cu);
 	      if (attr)
-		TYPE_FIELD_ARTIFICIAL (ftype, iparams) = DW_UNSND (attr);
+		FIELD_ARTIFICIAL (fields[iparams]) = DW_UNSND (attr);
 	      else
 		{
-		  TYPE_FIELD_ARTIFICIAL (ftype, iparams) = 0;
+		  FIELD_ARTIFICIAL (fields[iparams]) = 0;
 
 		  /* GCC/43521: In java, the formal parameter
 		     "this" is sometimes not marked with DW_AT_artificial.  */
@@ -13963,7 +14649,7 @@ read_subroutine_type (struct die_info *die, struct dwarf2_cu *cu)
 		      const char *name = dwarf2_name (child_die, cu);
 
 		      if (name && !strcmp (name, "this"))
-			TYPE_FIELD_ARTIFICIAL (ftype, iparams) = 1;
+			FIELD_ARTIFICIAL (fields[iparams]) = 1;
 		    }
 		}
 	      arg_type = die_type (child_die, cu);
@@ -13972,7 +14658,7 @@ read_subroutine_type (struct die_info *die, struct dwarf2_cu *cu)
 		 expects.  GCC marks THIS as const in method definitions,
 		 but not in the class specifications (GCC PR 43053).  */
 	      if (cu->language == language_cplus && !TYPE_CONST (arg_type)
-		  && TYPE_FIELD_ARTIFICIAL (ftype, iparams))
+		  && FIELD_ARTIFICIAL (fields[iparams]))
 		{
 		  int is_this = 0;
 		  struct dwarf2_cu *arg_cu = cu;
@@ -13999,13 +14685,72 @@ read_subroutine_type (struct die_info *die, struct dwarf2_cu *cu)
 					     arg_type, 0);
 		}
 
-	      TYPE_FIELD_TYPE (ftype, iparams) = arg_type;
+	      FIELD_TYPE (fields[iparams]) = arg_type;
 	      iparams++;
 	    }
 	  child_die = sibling_die (child_die);
 	}
     }
 
+  die->reading_param_types = reading_param_types;
+
+  if (ftype == NULL)
+    {
+      struct main_type main_tmpl;
+      struct type tmpl;
+      struct func_type func_tmpl;
+
+      /* A nested call may have made the type already.  */
+      ftype = get_die_type (die, cu);
+      if (ftype != NULL)
+	{
+	  do_cleanups (back_to);
+	  return ftype;
+	}
+
+      memset (&main_tmpl, 0, sizeof (main_tmpl));
+      memset (&tmpl, 0, sizeof (tmpl));
+      memset (&func_tmpl, 0, sizeof (func_tmpl));
+      TYPE_MAIN_TYPE (&tmpl) = &main_tmpl;
+      TYPE_CODE (&tmpl) = TYPE_CODE_FUNC;
+      TYPE_TARGET_TYPE (&tmpl) = type;
+      TYPE_PROTOTYPED (&tmpl) = prototyped;
+      TYPE_VARARGS (&tmpl) = varargs;
+      TYPE_SPECIFIC_FIELD (&tmpl) = TYPE_SPECIFIC_FUNC;
+      TYPE_MAIN_TYPE (&tmpl)->type_specific.func_stuff = &func_tmpl;
+      TYPE_CALLING_CONVENTION (&tmpl) = calling_convention;
+      TYPE_NFIELDS (&tmpl) = nparams;
+      TYPE_FIELDS (&tmpl) = fields;
+
+      ftype = lookup_consed_type (&tmpl);
+      if (ftype != NULL)
+	{
+	  do_cleanups (back_to);
+	  return set_die_type (die, ftype, cu);
+	}
+
+      ftype = lookup_function_type (type);
+      TYPE_PROTOTYPED (ftype) = prototyped;
+      TYPE_CALLING_CONVENTION (ftype) = calling_convention;
+      consed = 1;
+    }
+
+  TYPE_VARARGS (ftype) = varargs;
+  TYPE_NFIELDS (ftype) = nparams;
+  if (die->child != NULL)
+    {
+      TYPE_FIELDS (ftype) = (struct field *)
+	TYPE_ALLOC (ftype, nparams * sizeof (struct field));
+      memcpy (TYPE_FIELDS (ftype), fields, nparams * sizeof (struct field));
+    }
+
+  if (consed)
+    {
+      record_consed_type (ftype, cu);
+      set_die_type (die, ftype, cu);
+    }
+
+  do_cleanups (back_to);
   return ftype;
 }
 
@@ -14124,6 +14869,28 @@ read_base_type (struct die_info *die, struct dwarf2_cu *cu)
 	break;
     }
 
+  if (target_type == NULL)
+    {
+      struct main_type main_tmpl;
+      struct type tmpl;
+
+      /* The type is shared with any identical base type read before;
+	 see lookup_consed_type.  */
+      memset (&main_tmpl, 0, sizeof (main_tmpl));
+      memset (&tmpl, 0, sizeof (tmpl));
+      TYPE_MAIN_TYPE (&tmpl) = &main_tmpl;
+      TYPE_CODE (&tmpl) = code;
+      TYPE_LENGTH (&tmpl) = size;
+      TYPE_UNSIGNED (&tmpl) = (type_flags & TYPE_FLAG_UNSIGNED) != 0;
+      TYPE_NAME (&tmpl) = name;
+      if (name && strcmp (name, "char") == 0)
+	TYPE_NOSIGN (&tmpl) = 1;
+
+      type = lookup_consed_type (&tmpl);
+      if (type != NULL)
+	return set_die_type (die, type, cu);
+    }
+
   type = init_type (code, size, type_flags, NULL, objfile);
   TYPE_NAME (type) = name;
   TYPE_TARGET_TYPE (type) = target_type;
@@ -14131,6 +14898,9 @@ read_base_type (struct die_info *die, struct dwarf2_cu *cu)
   if (name && strcmp (name, "char") == 0)
     TYPE_NOSIGN (type) = 1;
 
+  if (target_type == NULL)
+    record_consed_type (type, cu);
+
   return set_die_type (die, type, cu);
 }
 
@@ -14561,6 +15331,78 @@ abbrev_table_lookup_abbrev (const struct abbrev_table *abbrev_table,
   return NULL;
 }
 
+/* Fill in the size_fixed_p and related fields of ABBREV from its
+   attribute list.  This lets skip_one_die step over the many DIEs the
+   partial symbol reader is not interested in without decoding each of
+   their attributes.  */
+
+static void
+abbrev_compute_fixed_size (struct abbrev_info *abbrev)
+{
+  unsigned int fixed_size = 0;
+  unsigned int i;
+
+  abbrev->size_fixed_p = 0;
+  abbrev->fixed_size = 0;
+  abbrev->n_addr_sized = 0;
+  abbrev->n_offset_sized = 0;
+  abbrev->n_ref_addr = 0;
+
+  for (i = 0; i < abbrev->num_attrs; ++i)
+    {
+      /* skip_one_die uses DW_AT_sibling to skip any children, so it
+	 has to look at the attributes.  */
+      if (abbrev->attrs[i].name == DW_AT_sibling)
+	return;
+
+      switch (abbrev->attrs[i].form)
+	{
+	case DW_FORM_flag_present:
+	  break;
+	case DW_FORM_data1:
+	case DW_FORM_ref1:
+	case DW_FORM_flag:
+	  fixed_size += 1;
+	  break;
+	case DW_FORM_data2:
+	case DW_FORM_ref2:
+	  fixed_size += 2;
+	  break;
+	case DW_FORM_data4:
+	case DW_FORM_ref4:
+	  fixed_size += 4;
+	  break;
+	case DW_FORM_data8:
+	case DW_FORM_ref8:
+	case DW_FORM_ref_sig8:
+	  fixed_size += 8;
+	  break;
+	case DW_FORM_addr:
+	  ++abbrev->n_addr_sized;
+	  break;
+	case DW_FORM_sec_offset:
+	case DW_FORM_strp:
+	case DW_FORM_GNU_strp_alt:
+	case DW_FORM_GNU_ref_alt:
+	  ++abbrev->n_offset_sized;
+	  break;
+	case DW_FORM_ref_addr:
+	  ++abbrev->n_ref_addr;
+	  break;
+	default:
+	  /* Strings, blocks, LEB128 values and indirect forms.  */
+	  return;
+	}
+    }
+
+  /* The counts cannot overflow, there are at most 65535 attributes.  */
+  if (fixed_size > (unsigned short) -1)
+    return;
+
+  abbrev->fixed_size = fixed_size;
+  abbrev->size_fixed_p = 1;
+}
+
 /* Read in an abbrev table.  */
 
 static struct abbrev_table *
@@ -14579,6 +15421,8 @@ abbrev_table_read_table (struct dwarf2_section_info *section,
 
   abbrev_table = XMALLOC (struct abbrev_table);
   abbrev_table->offset = offset;
+  abbrev_table->section = section;
+  abbrev_table->refcount = 0;
   obstack_init (&abbrev_table->abbrev_obstack);
   abbrev_table->abbrevs = obstack_alloc (&abbrev_table->abbrev_obstack,
 					 (ABBREV_HASH_SIZE
@@ -14634,6 +15478,7 @@ abbrev_table_read_table (struct dwarf2_section_info *section,
 					  * sizeof (struct attr_abbrev)));
       memcpy (cur_abbrev->attrs, cur_attrs,
 	      cur_abbrev->num_attrs * sizeof (struct attr_abbrev));
+      abbrev_compute_fixed_size (cur_abbrev);
 
       abbrev_table_add_abbrev (abbrev_table, abbrev_number, cur_abbrev);
 
@@ -14665,18 +15510,136 @@ abbrev_table_free (struct abbrev_table *abbrev_table)
   xfree (abbrev_table);
 }
 
-/* Same as abbrev_table_free but as a cleanup.
+/* Abbrev table cache.
+
+   Many units can share one abbrev table: all the CUs of an LTO
+   partition, the TUs of a .debug_types section, or everything
+   compressed by dwz.  Rather than reading the table again for each
+   unit, tables are kept in a per-objfile hash table keyed by section
+   and offset and reference counted by their users.  A small number
+   of unused tables is retained as well, so that reading one unit
+   after another with the same table does not reread it.  */
+
+/* Hash function for struct abbrev_table.  */
+
+static hashval_t
+hash_abbrev_table (const void *item)
+{
+  const struct abbrev_table *table = item;
+
+  return htab_hash_pointer (table->section) ^ table->offset.sect_off;
+}
+
+/* Equality function for struct abbrev_table.  */
+
+static int
+eq_abbrev_table (const void *item_lhs, const void *item_rhs)
+{
+  const struct abbrev_table *lhs = item_lhs;
+  const struct abbrev_table *rhs = item_rhs;
+
+  return (lhs->section == rhs->section
+	  && lhs->offset.sect_off == rhs->offset.sect_off);
+}
+
+/* Deletion function for the abbrev table cache.  */
+
+static void
+abbrev_table_htab_free (void *item)
+{
+  abbrev_table_free (item);
+}
+
+/* Remove TABLE from the list of unused abbrev tables.  */
+
+static void
+abbrev_table_remove_unused (struct abbrev_table *table)
+{
+  struct abbrev_table **unused = dwarf2_per_objfile->unused_abbrev_tables;
+  int n_unused = dwarf2_per_objfile->n_unused_abbrev_tables;
+  int i;
+
+  for (i = 0; i < n_unused; ++i)
+    if (unused[i] == table)
+      break;
+  gdb_assert (i < n_unused);
+
+  memmove (&unused[i], &unused[i + 1],
+	   (n_unused - i - 1) * sizeof (struct abbrev_table *));
+  --dwarf2_per_objfile->n_unused_abbrev_tables;
+}
+
+/* Return the abbrev table at OFFSET in SECTION, reading it in if it
+   is not in the abbrev table cache yet.  The caller must release the
+   table with abbrev_table_release when done.  */
+
+static struct abbrev_table *
+abbrev_table_get (struct dwarf2_section_info *section, sect_offset offset)
+{
+  struct abbrev_table find, *table;
+  void **slot;
+
+  if (dwarf2_per_objfile->abbrev_tables == NULL)
+    dwarf2_per_objfile->abbrev_tables
+      = htab_create_alloc (17, hash_abbrev_table, eq_abbrev_table,
+			   abbrev_table_htab_free, xcalloc, xfree);
+
+  find.section = section;
+  find.offset = offset;
+  table = htab_find (dwarf2_per_objfile->abbrev_tables, &find);
+  if (table != NULL)
+    {
+      if (table->refcount == 0)
+	abbrev_table_remove_unused (table);
+      ++table->refcount;
+      return table;
+    }
+
+  /* Only insert the table once it has been read successfully.  */
+  table = abbrev_table_read_table (section, offset);
+  slot = htab_find_slot (dwarf2_per_objfile->abbrev_tables, table, INSERT);
+  gdb_assert (*slot == NULL);
+  *slot = table;
+  table->refcount = 1;
+
+  return table;
+}
+
+/* Release a reference to TABLE, which was returned by
+   abbrev_table_get.  Once the table is no longer used it may be
+   evicted from the abbrev table cache.  */
+
+static void
+abbrev_table_release (struct abbrev_table *table)
+{
+  gdb_assert (table->refcount > 0);
+  if (--table->refcount > 0)
+    return;
+
+  if (dwarf2_per_objfile->n_unused_abbrev_tables == ABBREV_CACHE_UNUSED_MAX)
+    {
+      struct abbrev_table *oldest = dwarf2_per_objfile->unused_abbrev_tables[0];
+
+      abbrev_table_remove_unused (oldest);
+      htab_remove_elt (dwarf2_per_objfile->abbrev_tables, oldest);
+    }
+
+  dwarf2_per_objfile->unused_abbrev_tables
+    [dwarf2_per_objfile->n_unused_abbrev_tables++] = table;
+}
+
+/* Same as abbrev_table_release but as a cleanup.
    We pass in a pointer to the pointer to the table so that we can
    set the pointer to NULL when we're done.  It also simplifies
    build_type_unit_groups.  */
 
 static void
-abbrev_table_free_cleanup (void *table_ptr)
+abbrev_table_release_cleanup (void *table_ptr)
 {
   struct abbrev_table **abbrev_table_ptr = table_ptr;
 
   if (*abbrev_table_ptr != NULL)
-    abbrev_table_free (*abbrev_table_ptr);
+    abbrev_table_release (*abbrev_table_ptr);
   *abbrev_table_ptr = NULL;
 }
 
@@ -14687,10 +15650,10 @@ dwarf2_read_abbrevs (struct dwarf2_cu *cu,
 		     struct dwarf2_section_info *abbrev_section)
 {
   cu->abbrev_table =
-    abbrev_table_read_table (abbrev_section, cu->header.abbrev_offset);
+    abbrev_table_get (abbrev_section, cu->header.abbrev_offset);
 }
 
-/* Release the memory used by the abbrev table for a compilation unit.  */
+/* Release the abbrev table for a compilation unit.  */
 
 static void
 dwarf2_free_abbrev_table (void *ptr_to_cu)
@@ -14698,7 +15661,7 @@ dwarf2_free_abbrev_table (void *ptr_to_cu)
   struct dwarf2_cu *cu = ptr_to_cu;
 
   if (cu->abbrev_table != NULL)
-    abbrev_table_free (cu->abbrev_table);
+    abbrev_table_release (cu->abbrev_table);
   /* Set this to NULL so that we SEGV if we try to read it later,
      and also because free_comp_unit verifies this is NULL.  */
   cu->abbrev_table = NULL;
@@ -15277,7 +16240,12 @@ find_partial_die (sect_offset offset, int offset_in_dwz, struct dwarf2_cu *cu)
 						 objfile);
 
       if (per_cu->cu == NULL || per_cu->cu->partial_dies == NULL)
-	load_partial_comp_unit (per_cu);
+	{
+	  ++dwarf2_per_objfile->cu_cache_misses;
+	  load_partial_comp_unit (per_cu);
+	}
+      else
+	++dwarf2_per_objfile->cu_cache_hits;
 
       per_cu->cu->last_used = 0;
       pd = find_partial_die_in_comp_unit (offset, per_cu->cu);
@@ -15987,6 +16955,15 @@ read_unsigned_leb128 (bfd *abfd, const gdb_byte *buf,
   int i, shift;
   unsigned char byte;
 
+  /* Most values, including nearly all abbrev codes and attribute
+     forms, fit in a single byte.  */
+  byte = bfd_get_8 (abfd, buf);
+  if ((byte & 128) == 0)
+    {
+      *bytes_read_ptr = 1;
+      return byte;
+    }
+
   result = 0;
   shift = 0;
   num_read = 0;
@@ -16015,6 +16992,16 @@ read_signed_leb128 (bfd *abfd, const gdb_byte *buf,
   int i, shift, num_read;
   unsigned char byte;
 
+  /* See read_unsigned_leb128.  */
+  byte = bfd_get_8 (abfd, buf);
+  if ((byte & 128) == 0)
+    {
+      *bytes_read_ptr = 1;
+      if (byte & 0x40)
+	return (LONGEST) byte - 128;
+      return byte;
+    }
+
   result = 0;
   shift = 0;
   num_read = 0;
@@ -16721,9 +17708,16 @@ dwarf_decode_lines_1 (struct line_header *lh, const char *comp_dir,
   struct subfile *last_subfile = NULL;
   void (*p_record_line) (struct subfile *subfile, int line, CORE_ADDR pc)
     = record_line;
+  /* The number of entries of LH->file_names not referenced so far.  */
+  unsigned int n_unincluded = 0;
+  unsigned int i;
 
   baseaddr = ANOFFSET (objfile->section_offsets, SECT_OFF_TEXT (objfile));
 
+  for (i = 0; i < lh->num_file_names; ++i)
+    if (!lh->file_names[i].included_p)
+      ++n_unincluded;
+
   line_ptr = lh->statement_program_start;
   line_end = lh->statement_program_end;
 
@@ -16783,7 +17777,11 @@ dwarf_decode_lines_1 (struct line_header *lh, const char *comp_dir,
 		 instruction boundary.  */
 	      else if (op_index == 0)
 		{
-		  lh->file_names[file - 1].included_p = 1;
+		  if (!lh->file_names[file - 1].included_p)
+		    {
+		      lh->file_names[file - 1].included_p = 1;
+		      --n_unincluded;
+		    }
 		  if (!decode_for_pst_p && is_stmt)
 		    {
 		      if (last_subfile != current_subfile)
@@ -16855,6 +17853,7 @@ dwarf_decode_lines_1 (struct line_header *lh, const char *comp_dir,
                       read_unsigned_leb128 (abfd, line_ptr, &bytes_read);
                     line_ptr += bytes_read;
                     add_file_name (lh, cur_file, dir_index, mod_time, length);
+		    ++n_unincluded;
                   }
 		  break;
 		case DW_LNE_set_discriminator:
@@ -16882,7 +17881,11 @@ dwarf_decode_lines_1 (struct line_header *lh, const char *comp_dir,
 		dwarf2_debug_line_missing_file_complaint ();
 	      else
 		{
-		  lh->file_names[file - 1].included_p = 1;
+		  if (!lh->file_names[file - 1].included_p)
+		    {
+		      lh->file_names[file - 1].included_p = 1;
+		      --n_unincluded;
+		    }
 		  if (!decode_for_pst_p && is_stmt)
 		    {
 		      if (last_subfile != current_subfile)
@@ -16988,13 +17991,24 @@ dwarf_decode_lines_1 (struct line_header *lh, const char *comp_dir,
         dwarf2_debug_line_missing_file_complaint ();
       else
         {
-          lh->file_names[file - 1].included_p = 1;
+	  if (!lh->file_names[file - 1].included_p)
+	    {
+	      lh->file_names[file - 1].included_p = 1;
+	      --n_unincluded;
+	    }
           if (!decode_for_pst_p)
 	    {
 	      addr = gdbarch_addr_bits_remove (gdbarch, address);
 	      (*p_record_line) (current_subfile, 0, addr);
 	    }
         }
+
+      /* When building psymtabs, all we want to know is which files
+	 are referenced.  Once that is all of them, the rest of the
+	 program cannot tell us anything new (barring DW_LNE_define_file,
+	 which no current producer emits), so stop decoding.  */
+      if (decode_for_pst_p && n_unincluded == 0)
+	break;
     }
 }
 
@@ -17674,7 +18688,7 @@ dwarf2_const_value_attr (const struct attribute *attr, struct type *type,
 	/* Symbols of this form are reasonably rare, so we just
 	   piggyback on the existing location code rather than writing
 	   a new implementation of symbol_computed_ops.  */
-	*baton = obstack_alloc (obstack, sizeof (struct dwarf2_locexpr_baton));
+	*baton = OBSTACK_ZALLOC (obstack, struct dwarf2_locexpr_baton);
 	(*baton)->per_cu = cu->per_cu;
 	gdb_assert ((*baton)->per_cu);
 
@@ -19764,18 +20778,13 @@ file_full_name (int file, struct line_header *lh, const char *comp_dir)
 static struct macro_source_file *
 macro_start_file (int file, int line,
                   struct macro_source_file *current_file,
-                  const char *comp_dir,
-                  struct line_header *lh, struct objfile *objfile)
+                  struct line_header *lh, struct macro_table *macro_table)
 {
   /* File name relative to the compilation directory of this source file.  */
   char *file_name = file_file_name (file, lh);
 
   if (! current_file)
     {
-      /* Note: We don't create a macro table for this compilation unit
-	 at all until we actually get a filename.  */
-      struct macro_table *macro_table = get_macro_table (objfile, comp_dir);
-
       /* If we have no current file, then this must be the start_file
 	 directive for the compilation unit's main source file.  */
       current_file = macro_set_main (macro_table, file_name);
@@ -20152,7 +21161,8 @@ static void
 dwarf_decode_macro_bytes (bfd *abfd,
 			  const gdb_byte *mac_ptr, const gdb_byte *mac_end,
 			  struct macro_source_file *current_file,
-			  struct line_header *lh, const char *comp_dir,
+			  struct line_header *lh,
+			  struct macro_table *macro_table,
 			  struct dwarf2_section_info *section,
 			  int section_is_gnu, int section_is_dwz,
 			  unsigned int offset_size,
@@ -20300,8 +21310,8 @@ dwarf_decode_macro_bytes (bfd *abfd,
 	      }
 	    else
 	      current_file = macro_start_file (file, line,
-					       current_file, comp_dir,
-					       lh, objfile);
+					       current_file, lh,
+					       macro_table);
           }
           break;
 
@@ -20387,7 +21397,7 @@ dwarf_decode_macro_bytes (bfd *abfd,
 
 		dwarf_decode_macro_bytes (include_bfd, new_mac_ptr,
 					  include_mac_end, current_file,
-					  lh, comp_dir,
+					  lh, macro_table,
 					  section, section_is_gnu, is_dwz,
 					  offset_size, objfile, include_hash);
 
@@ -20423,58 +21433,53 @@ dwarf_decode_macro_bytes (bfd *abfd,
     } while (macinfo_type != 0);
 }
 
-static void
-dwarf_decode_macros (struct dwarf2_cu *cu, unsigned int offset,
-                     const char *comp_dir, int section_is_gnu)
+/* The macro information of a CU, as recorded by dwarf_decode_macros
+   so that dwarf2_read_macros can read it once the CU has been
+   discarded.  */
+
+struct dwarf2_macro_info
 {
-  struct objfile *objfile = dwarf2_per_objfile->objfile;
-  struct line_header *lh = cu->line_header;
-  bfd *abfd;
+  /* The objfile the CU belongs to.  */
+  struct objfile *objfile;
+
+  /* The section holding the macro information, its name, and whether
+     it is .debug_macro rather than .debug_macinfo.  */
+  struct dwarf2_section_info *section;
+  const char *section_name;
+  int section_is_gnu;
+
+  /* The offset of the macro information of the CU in SECTION, and
+     the offset size of the CU.  */
+  unsigned int offset;
+  unsigned int offset_size;
+
+  /* The line header of the CU, which the file numbers of the macro
+     information refer to.  */
+  struct line_header *lh;
+};
+
+/* Read the macro information described by INFO into MACRO_TABLE.  If
+   MACRO_TABLE is NULL, only look for the DW_MACRO_GNU_start_file entry
+   of the main source file, and return non-zero if there is one.  */
+
+static int
+dwarf_decode_macros_1 (const struct dwarf2_macro_info *info,
+		       struct macro_table *macro_table)
+{
+  struct objfile *objfile = info->objfile;
+  struct line_header *lh = info->lh;
+  struct dwarf2_section_info *section = info->section;
+  int section_is_gnu = info->section_is_gnu;
+  unsigned int offset = info->offset;
+  bfd *abfd = get_section_bfd_owner (section);
   const gdb_byte *mac_ptr, *mac_end;
   struct macro_source_file *current_file = 0;
   enum dwarf_macro_record_type macinfo_type;
-  unsigned int offset_size = cu->header.offset_size;
+  unsigned int offset_size = info->offset_size;
   const gdb_byte *opcode_definitions[256];
   struct cleanup *cleanup;
   htab_t include_hash;
   void **slot;
-  struct dwarf2_section_info *section;
-  const char *section_name;
-
-  if (cu->dwo_unit != NULL)
-    {
-      if (section_is_gnu)
-	{
-	  section = &cu->dwo_unit->dwo_file->sections.macro;
-	  section_name = ".debug_macro.dwo";
-	}
-      else
-	{
-	  section = &cu->dwo_unit->dwo_file->sections.macinfo;
-	  section_name = ".debug_macinfo.dwo";
-	}
-    }
-  else
-    {
-      if (section_is_gnu)
-	{
-	  section = &dwarf2_per_objfile->macro;
-	  section_name = ".debug_macro";
-	}
-      else
-	{
-	  section = &dwarf2_per_objfile->macinfo;
-	  section_name = ".debug_macinfo";
-	}
-    }
-
-  dwarf2_read_section (objfile, section);
-  if (section->buffer == NULL)
-    {
-      complaint (&symfile_complaints, _("missing %s section"), section_name);
-      return;
-    }
-  abfd = get_section_bfd_owner (section);
 
   /* First pass: Find the name of the base filename.
      This filename is needed in order to process all macros whose definition
@@ -20495,7 +21500,7 @@ dwarf_decode_macros (struct dwarf2_cu *cu, unsigned int offset,
   if (mac_ptr == NULL)
     {
       /* We already issued a complaint.  */
-      return;
+      return 0;
     }
 
   do
@@ -20544,8 +21549,11 @@ dwarf_decode_macros (struct dwarf2_cu *cu, unsigned int offset,
 	    file = read_unsigned_leb128 (abfd, mac_ptr, &bytes_read);
 	    mac_ptr += bytes_read;
 
+	    if (macro_table == NULL)
+	      return 1;
+
 	    current_file = macro_start_file (file, line, current_file,
-					     comp_dir, lh, objfile);
+					     lh, macro_table);
 	  }
 	  break;
 
@@ -20592,11 +21600,14 @@ dwarf_decode_macros (struct dwarf2_cu *cu, unsigned int offset,
 					 mac_ptr, mac_end, abfd, offset_size,
 					 section);
 	  if (mac_ptr == NULL)
-	    return;
+	    return 0;
 	  break;
 	}
     } while (macinfo_type != 0 && current_file == NULL);
 
+  if (macro_table == NULL)
+    return 0;
+
   /* Second pass: Process all entries.
 
      Use the AT_COMMAND_LINE flag to determine whether we are still processing
@@ -20610,10 +21621,123 @@ dwarf_decode_macros (struct dwarf2_cu *cu, unsigned int offset,
   slot = htab_find_slot (include_hash, mac_ptr, INSERT);
   *slot = (void *) mac_ptr;
   dwarf_decode_macro_bytes (abfd, mac_ptr, mac_end,
-			    current_file, lh, comp_dir, section,
+			    current_file, lh, macro_table, section,
 			    section_is_gnu, 0,
 			    offset_size, objfile, include_hash);
   do_cleanups (cleanup);
+  return 1;
+}
+
+/* Read the macro information described by BATON, a struct
+   dwarf2_macro_info, into MACRO_TABLE.  This is the reader that
+   dwarf_decode_macros installs in the macro table of a CU.  */
+
+static void
+dwarf2_read_macros (struct macro_table *macro_table, void *baton)
+{
+  const struct dwarf2_macro_info *info = baton;
+
+  dw2_setup (info->objfile);
+  dwarf_decode_macros_1 (info, macro_table);
+}
+
+/* Return a copy of LH allocated on OBSTACK, with what the macro
+   information needs of it: the include directories and file names.
+   The strings are shared with LH; they point into the .debug_line
+   section, which lives as long as the objfile.  */
+
+static struct line_header *
+copy_line_header_for_macros (const struct line_header *lh,
+			     struct obstack *obstack)
+{
+  struct line_header *copy = OBSTACK_ZALLOC (obstack, struct line_header);
+
+  copy->num_include_dirs = lh->num_include_dirs;
+  copy->include_dirs_size = lh->num_include_dirs;
+  copy->include_dirs
+    = obstack_copy (obstack, lh->include_dirs,
+		    lh->num_include_dirs * sizeof (*lh->include_dirs));
+  copy->num_file_names = lh->num_file_names;
+  copy->file_names_size = lh->num_file_names;
+  copy->file_names
+    = obstack_copy (obstack, lh->file_names,
+		    lh->num_file_names * sizeof (*lh->file_names));
+
+  return copy;
+}
+
+/* Record the macro information of CU, at OFFSET in .debug_macro if
+   SECTION_IS_GNU is non-zero or in .debug_macinfo otherwise.
+   COMP_DIR is the compilation directory of CU.
+
+   The macro information of a CU can be much larger than the rest of
+   its debug information, and is seldom looked at, so only a macro
+   table that will read it on first use is made here.  */
+
+static void
+dwarf_decode_macros (struct dwarf2_cu *cu, unsigned int offset,
+                     const char *comp_dir, int section_is_gnu)
+{
+  struct objfile *objfile = dwarf2_per_objfile->objfile;
+  struct dwarf2_macro_info info, *saved;
+  struct macro_table *macro_table;
+  struct dwarf2_section_info *section;
+  const char *section_name;
+
+  if (cu->dwo_unit != NULL)
+    {
+      if (section_is_gnu)
+	{
+	  section = &cu->dwo_unit->dwo_file->sections.macro;
+	  section_name = ".debug_macro.dwo";
+	}
+      else
+	{
+	  section = &cu->dwo_unit->dwo_file->sections.macinfo;
+	  section_name = ".debug_macinfo.dwo";
+	}
+    }
+  else
+    {
+      if (section_is_gnu)
+	{
+	  section = &dwarf2_per_objfile->macro;
+	  section_name = ".debug_macro";
+	}
+      else
+	{
+	  section = &dwarf2_per_objfile->macinfo;
+	  section_name = ".debug_macinfo";
+	}
+    }
+
+  dwarf2_read_section (objfile, section);
+  if (section->buffer == NULL)
+    {
+      complaint (&symfile_complaints, _("missing %s section"), section_name);
+      return;
+    }
+
+  info.objfile = objfile;
+  info.section = section;
+  info.section_name = section_name;
+  info.section_is_gnu = section_is_gnu;
+  info.offset = offset;
+  info.offset_size = cu->header.offset_size;
+  info.lh = cu->line_header;
+
+  /* We don't create a macro table for this compilation unit at all
+     unless its macro information names its main source file.  */
+  if (!dwarf_decode_macros_1 (&info, NULL))
+    return;
+
+  saved = XOBNEW (&objfile->objfile_obstack, struct dwarf2_macro_info);
+  *saved = info;
+  saved->lh = copy_line_header_for_macros (cu->line_header,
+					   &objfile->objfile_obstack);
+
+  macro_table = get_macro_table (objfile, comp_dir);
+  macro_set_reader (macro_table, dwarf2_read_macros, saved);
 }
 
 /* Check if the attribute's form is a DW_FORM_block*
@@ -20765,8 +21889,8 @@ dwarf2_symbol_mark_computed (const struct attribute *attr, struct symbol *sym,
     {
       struct dwarf2_locexpr_baton *baton;
 
-      baton = obstack_alloc (&objfile->objfile_obstack,
-			     sizeof (struct dwarf2_locexpr_baton));
+      baton = OBSTACK_ZALLOC (&objfile->objfile_obstack,
+			      struct dwarf2_locexpr_baton);
       baton->per_cu = cu->per_cu;
       gdb_assert (baton->per_cu);
 
@@ -21034,8 +22158,29 @@ free_cached_comp_units (void *data)
     }
 }
 
+/* Return the number of bytes of memory used by CU.  The DIEs, partial
+   DIEs and their hash tables all live on the CU's obstack.  */
+
+static size_t
+dwarf2_cu_memory_used (struct dwarf2_cu *cu)
+{
+  return sizeof (*cu) + obstack_memory_used (&cu->comp_unit_obstack);
+}
+
+/* qsort helper for age_cached_comp_units: sort most recently used
+   compilation units first.  */
+
+static int
+compare_cu_last_used (const void *ap, const void *bp)
+{
+  const struct dwarf2_per_cu_data *a = *(struct dwarf2_per_cu_data **) ap;
+  const struct dwarf2_per_cu_data *b = *(struct dwarf2_per_cu_data **) bp;
+
+  return a->cu->last_used - b->cu->last_used;
+}
+
 /* Increase the age counter on each cached compilation unit, and free
-   any that are too old.  */
+   any that are too old, or that do not fit in dwarf2_max_cache_bytes.  */
 
 static void
 age_cached_comp_units (void)
@@ -21043,13 +22188,59 @@ age_cached_comp_units (void)
   struct dwarf2_per_cu_data *per_cu, **last_chain;
 
   dwarf2_clear_marks (dwarf2_per_objfile->read_in_chain);
-  per_cu = dwarf2_per_objfile->read_in_chain;
-  while (per_cu != NULL)
+
+  if (dwarf2_max_cache_bytes < 0)
     {
-      per_cu->cu->last_used ++;
-      if (per_cu->cu->last_used <= dwarf2_max_cache_age)
-	dwarf2_mark (per_cu->cu);
-      per_cu = per_cu->cu->read_in_chain;
+      per_cu = dwarf2_per_objfile->read_in_chain;
+      while (per_cu != NULL)
+	{
+	  per_cu->cu->last_used ++;
+	  if (per_cu->cu->last_used <= dwarf2_max_cache_age)
+	    dwarf2_mark (per_cu->cu);
+	  per_cu = per_cu->cu->read_in_chain;
+	}
+    }
+  else
+    {
+      VEC (dwarf2_per_cu_ptr) *candidates = NULL;
+      struct cleanup *cleanup;
+      size_t used = 0;
+      int ix;
+
+      cleanup = make_cleanup (VEC_cleanup (dwarf2_per_cu_ptr), &candidates);
+
+      per_cu = dwarf2_per_objfile->read_in_chain;
+      while (per_cu != NULL)
+	{
+	  per_cu->cu->last_used ++;
+	  if (per_cu->cu->last_used <= dwarf2_max_cache_age)
+	    VEC_safe_push (dwarf2_per_cu_ptr, candidates, per_cu);
+	  per_cu = per_cu->cu->read_in_chain;
+	}
+
+      if (!VEC_empty (dwarf2_per_cu_ptr, candidates))
+	qsort (VEC_address (dwarf2_per_cu_ptr, candidates),
+	       VEC_length (dwarf2_per_cu_ptr, candidates),
+	       sizeof (dwarf2_per_cu_ptr), compare_cu_last_used);
+
+      /* Keep the most recently used units that fit in the budget.  Units
+	 they depend on are kept too, so this is approximate.  */
+      for (ix = 0;
+	   VEC_iterate (dwarf2_per_cu_ptr, candidates, ix, per_cu);
+	   ++ix)
+	{
+	  size_t size;
+
+	  if (per_cu->cu->mark)
+	    continue;
+	  size = dwarf2_cu_memory_used (per_cu->cu);
+	  if (used + size > dwarf2_max_cache_bytes)
+	    break;
+	  used += size;
+	  dwarf2_mark (per_cu->cu);
+	}
+
+      do_cleanups (cleanup);
     }
 
   per_cu = dwarf2_per_objfile->read_in_chain;
@@ -21101,6 +22292,62 @@ free_one_cached_comp_unit (struct dwarf2_per_cu_data *target_per_cu)
     }
 }
 
+/* Implement the "maint info dwarf2-cache" command.  */
+
+static void
+maintenance_info_dwarf2_cache (char *args, int from_tty)
+{
+  struct objfile *objfile;
+
+  ALL_OBJFILES (objfile)
+    {
+      struct dwarf2_per_objfile *data
+	= objfile_data (objfile, dwarf2_objfile_data_key);
+      struct dwarf2_per_cu_data *per_cu;
+      size_t bytes = 0;
+      int count = 0;
+
+      if (data == NULL)
+	continue;
+
+      for (per_cu = data->read_in_chain;
+	   per_cu != NULL;
+	   per_cu = per_cu->cu->read_in_chain)
+	{
+	  ++count;
+	  bytes += dwarf2_cu_memory_used (per_cu->cu);
+	}
+
+      printf_filtered (_("Objfile %s:\n"), objfile_name (objfile));
+      printf_filtered (_("  Cached compilation units: %d\n"), count);
+      printf_filtered (_("  Resident bytes: %s\n"), pulongest (bytes));
+      printf_filtered (_("  Cache hits: %u\n"), data->cu_cache_hits);
+      printf_filtered (_("  Cache misses: %u\n"), data->cu_cache_misses);
+    }
+}
+
+/* Return the number of bytes used by the compilation units of OBJFILE
+   currently held in the DWARF CU cache.  */
+
+size_t
+dwarf2_cu_cache_memory_used (struct objfile *objfile)
+{
+  struct dwarf2_per_objfile *data
+    = objfile_data (objfile, dwarf2_objfile_data_key);
+  struct dwarf2_per_cu_data *per_cu;
+  size_t bytes = 0;
+
+  if (data == NULL)
+    return 0;
+
+  for (per_cu = data->read_in_chain;
+       per_cu != NULL;
+       per_cu = per_cu->cu->read_in_chain)
+    bytes += dwarf2_cu_memory_used (per_cu->cu);
+
+  return bytes;
+}
+
 /* Release all extra memory associated with OBJFILE.  */
 
 void
@@ -21376,6 +22623,8 @@ dwarf2_per_objfile_free (struct objfile *objfile, void *d)
      cleaning up.  */
   dwarf2_per_objfile = NULL;
 
+  forget_type_unit_owners (objfile);
+
   for (ix = 0; ix < data->n_comp_units; ++ix)
    VEC_free (dwarf2_per_cu_ptr, data->all_comp_units[ix]->imported_symtabs);
 
@@ -21393,6 +22642,19 @@ dwarf2_per_objfile_free (struct objfile *objfile, void *d)
 
   if (data->dwz_file && data->dwz_file->dwz_bfd)
     gdb_bfd_unref (data->dwz_file->dwz_bfd);
+
+  if (data->abbrev_tables)
+    htab_delete (data->abbrev_tables);
+
+  if (data->index_cache_buffer != NULL)
+    {
+#ifdef HAVE_MMAP
+      if (data->index_cache_mapped)
+	munmap (data->index_cache_buffer, data->index_cache_size);
+      else
+#endif
+	xfree (data->index_cache_buffer);
+    }
 }
 
 
@@ -22071,13 +23333,17 @@ recursively_write_psymbols (struct objfile *objfile,
 		  1);
 }
 
-/* Create an index file for OBJFILE in the directory DIR.  */
+/* Create an index file for OBJFILE in the directory DIR.  The file
+   is named BASE_NAME with INDEX_SUFFIX appended.  The contents are
+   written to a temporary file first, so that a reader never sees a
+   partially written index.  */
 
 static void
-write_psymtabs_to_index (struct objfile *objfile, const char *dir)
+write_psymtabs_to_index (struct objfile *objfile, const char *dir,
+			 const char *base_name)
 {
   struct cleanup *cleanup;
-  char *filename, *cleanup_filename;
+  char *filename, *tmp_filename, *cleanup_filename;
   struct obstack contents, addr_obstack, constant_pool, symtab_obstack;
   struct obstack cu_list, types_cu_list;
   int i;
@@ -22101,15 +23367,16 @@ write_psymtabs_to_index (struct objfile *objfile, const char *dir)
   if (stat (objfile_name (objfile), &st) < 0)
     perror_with_name (objfile_name (objfile));
 
-  filename = concat (dir, SLASH_STRING, lbasename (objfile_name (objfile)),
-		     INDEX_SUFFIX, (char *) NULL);
+  filename = concat (dir, SLASH_STRING, base_name, INDEX_SUFFIX, (char *) NULL);
   cleanup = make_cleanup (xfree, filename);
+  tmp_filename = xstrprintf ("%s.%ld.tmp", filename, (long) getpid ());
+  make_cleanup (xfree, tmp_filename);
 
-  out_file = gdb_fopen_cloexec (filename, "wb");
+  out_file = gdb_fopen_cloexec (tmp_filename, "wb");
   if (!out_file)
-    error (_("Can't open `%s' for writing"), filename);
+    error (_("Can't open `%s' for writing"), tmp_filename);
 
-  cleanup_filename = filename;
+  cleanup_filename = tmp_filename;
   make_cleanup (unlink_if_set, &cleanup_filename);
 
   symtab = create_mapped_symtab ();
@@ -22248,7 +23515,11 @@ write_psymtabs_to_index (struct objfile *objfile, const char *dir)
   write_obstack (out_file, &symtab_obstack);
   write_obstack (out_file, &constant_pool);
 
-  fclose (out_file);
+  if (fclose (out_file) != 0)
+    error (_("couldn't write index file `%s'"), tmp_filename);
+
+  if (rename (tmp_filename, filename) != 0)
+    perror_with_name (filename);
 
   /* We want to keep the file, so we set cleanup_filename to NULL
      here.  See unlink_if_set.  */
@@ -22257,6 +23528,93 @@ write_psymtabs_to_index (struct objfile *objfile, const char *dir)
   do_cleanups (cleanup);
 }
 
+/* Create directory DIR and any missing parent directories.  Return
+   0 on success, or -1 with errno set on failure.  */
+
+static int
+index_cache_mkdir (const char *dir)
+{
+  char *copy = xstrdup (dir);
+  char *p = copy;
+  int result = 0;
+
+  while (result == 0)
+    {
+      char save;
+
+      while (IS_DIR_SEPARATOR (*p))
+	++p;
+      while (*p != '\0' && !IS_DIR_SEPARATOR (*p))
+	++p;
+
+      save = *p;
+      *p = '\0';
+      if (mkdir (copy, 0700) != 0 && errno != EEXIST)
+	result = -1;
+      *p = save;
+
+      if (save == '\0')
+	break;
+    }
+
+  xfree (copy);
+  return result;
+}
+
+/* Save the index for OBJFILE in the index cache, if the cache is
+   enabled and OBJFILE does not already have an index.  This is
+   called once the partial symtabs of OBJFILE have been built, so
+   that later sessions can skip the full DWARF scan.  */
+
+static void
+index_cache_store (struct objfile *objfile)
+{
+  volatile struct gdb_exception except;
+  struct cleanup *cleanup;
+  char *filename;
+  char *base_name;
+
+  if (!index_cache_enabled)
+    return;
+
+  /* The conditions under which write_psymtabs_to_index would refuse
+     to write the index; there is no point in complaining about them
+     every time a file is read.  */
+  if (dwarf2_per_objfile->using_index
+      || VEC_length (dwarf2_section_info_def, dwarf2_per_objfile->types) > 1
+      || dwarf2_per_objfile->dwz_file != NULL
+      || !objfile->psymtabs || !objfile->psymtabs_addrmap)
+    return;
+
+  filename = index_cache_file_name (objfile);
+  if (filename == NULL)
+    return;
+  cleanup = make_cleanup (xfree, filename);
+
+  TRY_CATCH (except, RETURN_MASK_ERROR)
+    {
+      if (index_cache_mkdir (index_cache_directory) != 0)
+	perror_with_name (index_cache_directory);
+
+      /* INDEX_CACHE_FILE_NAME includes INDEX_SUFFIX already.  */
+      base_name = xstrdup (lbasename (filename));
+      base_name[strlen (base_name) - strlen (INDEX_SUFFIX)] = '\0';
+      make_cleanup (xfree, base_name);
+
+      write_psymtabs_to_index (objfile, index_cache_directory, base_name);
+
+      if (dwarf2_read_debug)
+	fprintf_unfiltered (gdb_stdlog, "Saved index of %s in %s\n",
+			    objfile_name (objfile), filename);
+    }
+  if (except.reason < 0)
+    exception_fprintf (gdb_stderr, except,
+		       _("Error while writing index cache for `%s': "),
+		       objfile_name (objfile));
+
+  do_cleanups (cleanup);
+}
+
 /* Implementation of the `save gdb-index' command.
    
    Note that the file format used by this command is documented in the
@@ -22285,7 +23643,8 @@ save_gdb_index_command (char *arg, int from_tty)
 
 	TRY_CATCH (except, RETURN_MASK_ERROR)
 	  {
-	    write_psymtabs_to_index (objfile, arg);
+	    write_psymtabs_to_index (objfile, arg,
+				     lbasename (objfile_name (objfile)));
 	  }
 	if (except.reason < 0)
 	  exception_fprintf (gdb_stderr, except,
@@ -22309,6 +23668,22 @@ show_dwarf2_always_disassemble (struct ui_file *file, int from_tty,
 		    value);
 }
 
+static void
+show_index_cache_enabled (struct ui_file *file, int from_tty,
+			  struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("Whether to use the index cache is %s.\n"),
+		    value);
+}
+
+static void
+show_index_cache_directory (struct ui_file *file, int from_tty,
+			    struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("The directory of the index cache is \"%s\".\n"),
+		    value);
+}
+
 static void
 show_check_physname (struct ui_file *file, int from_tty,
 		     struct cmd_list_element *c, const char *value)
@@ -22352,6 +23727,40 @@ caching, which can slow down startup."),
 			    &set_dwarf2_cmdlist,
 			    &show_dwarf2_cmdlist);
 
+  add_setshow_zuinteger_unlimited_cmd ("max-cache-bytes", class_obscure,
+				       &dwarf2_max_cache_bytes, _("\
+Set the upper bound on the memory used by cached dwarf2 compilation units."),
+				       _("\
+Show the upper bound on the memory used by cached dwarf2 compilation units."),
+				       _("\
+When the compilation units kept in the cache use more memory than this,\n\
+the least recently used ones are freed even if they are younger than\n\
+max-cache-age.  \"unlimited\" means the cache is only limited by age."),
+				       NULL,
+				       show_dwarf2_max_cache_bytes,
+				       &set_dwarf2_cmdlist,
+				       &show_dwarf2_cmdlist);
+
+  add_setshow_boolean_cmd ("dedup-type-units", class_obscure,
+			   &dwarf2_dedup_type_units, _("\
+Set whether partial symbols of type units are shared between objfiles."), _("\
+Show whether partial symbols of type units are shared between objfiles."), _("\
+When enabled, GDB does not build partial symbols for a type unit whose\n\
+signature was already seen in another objfile of the same program space,\n\
+saving time and memory when many shared libraries carry the same\n\
+type units.  The types are still read from each objfile when they are\n\
+referenced.  If the objfile owning the partial symbols is unloaded,\n\
+name lookups of those types no longer find them in the other objfiles."),
+			   NULL,
+			   NULL,
+			   &set_dwarf2_cmdlist,
+			   &show_dwarf2_cmdlist);
+
+  add_cmd ("dwarf2-cache", class_maintenance, maintenance_info_dwarf2_cache,
+	   _("\
+Print statistics about the dwarf2 compilation unit cache."),
+	   &maintenanceinfolist);
+
   add_setshow_boolean_cmd ("always-disassemble", class_obscure,
 			   &dwarf2_always_disassemble, _("\
 Set whether `info address' always disassembles DWARF expressions."), _("\
@@ -22402,6 +23811,43 @@ Warning: This option must be enabled before gdb reads the file."),
 			   NULL,
 			   &setlist, &showlist);
 
+  add_setshow_boolean_cmd ("index-cache", class_files,
+			   &index_cache_enabled, _("\
+Set whether to use the index cache."), _("\
+Show whether to use the index cache."), _("\
+When enabled, GDB saves the index of each symbol file it reads\n\
+in the index cache directory, keyed by the file's build-id, and\n\
+uses a saved index instead of scanning the DWARF debug information\n\
+when the file is read again."),
+			   NULL,
+			   show_index_cache_enabled,
+			   &setlist, &showlist);
+
+  {
+    const char *cache_home = getenv ("XDG_CACHE_HOME");
+    const char *home = getenv ("HOME");
+
+    if (cache_home != NULL && IS_ABSOLUTE_PATH (cache_home))
+      index_cache_directory = concat (cache_home, SLASH_STRING, "gdb",
+				      SLASH_STRING, "index", (char *) NULL);
+    else if (home != NULL)
+      index_cache_directory = concat (home, SLASH_STRING, ".cache",
+				      SLASH_STRING, "gdb", SLASH_STRING,
+				      "index", (char *) NULL);
+    else
+      index_cache_directory = xstrdup ("");
+  }
+
+  add_setshow_optional_filename_cmd ("index-cache-directory", class_files,
+				     &index_cache_directory, _("\
+Set the directory of the index cache."), _("\
+Show the directory of the index cache."), _("\
+Index files saved by \"set index-cache on\" are stored in this\n\
+directory.  It is created if it does not exist."),
+				     NULL,
+				     show_index_cache_directory,
+				     &setlist, &showlist);
+
   c = add_cmd ("gdb-index", class_files, save_gdb_index_command,
 	       _("\
 Save a gdb-index file.\n\
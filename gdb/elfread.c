@@ -45,6 +45,7 @@
 #include "regcache.h"
 #include "bcache.h"
 #include "gdb_bfd.h"
+#include "maint.h"
 #include "build-id.h"
 
 extern void _initialize_elfread (void);
@@ -226,10 +227,55 @@ record_minimal_symbol (const char *name, int name_len, int copy_name,
 #define ST_DYNAMIC 1
 #define ST_SYNTHETIC 2
 
+/* The state elf_symtab_read_1 carries from one part of a symbol table
+   to the next.  */
+
+struct elf_symtab_state
+{
+  /* If sectinfo is nonNULL, it contains section info that should end up
+     filed in the objfile.  */
+  struct stab_section_info *sectinfo;
+
+  /* If filesym is nonNULL, it is the name of a file symbol, but we
+     haven't seen any section info for it yet.  */
+  const char *filesym;
+
+  /* Name of filesym.  This is either a constant string or is saved on
+     the objfile's filename cache.  */
+  const char *filesymname;
+};
+
 static void
-elf_symtab_read (struct objfile *objfile, int type,
-		 long number_of_symbols, asymbol **symbol_table,
-		 int copy_names)
+elf_symtab_state_init (struct elf_symtab_state *state)
+{
+  state->sectinfo = NULL;
+  state->filesym = NULL;
+  state->filesymname = "";
+}
+
+/* Return the number of symbols in the regular symbol table of ABFD,
+   whether or not BFD has read them.  */
+
+static long
+elf_regular_symcount (bfd *abfd)
+{
+  const struct elf_backend_data *ebd = get_elf_backend_data (abfd);
+  Elf_Internal_Shdr *hdr = &elf_tdata (abfd)->symtab_hdr;
+
+  if (elf_onesymtab (abfd) == 0 || hdr->sh_size < ebd->s->sizeof_sym)
+    return 0;
+
+  /* Do not count the null symbol.  */
+  return hdr->sh_size / ebd->s->sizeof_sym - 1;
+}
+
+/* Enter NUMBER_OF_SYMBOLS symbols from SYMBOL_TABLE, which may be
+   just a part of a whole symbol table, as described by STATE.  */
+
+static void
+elf_symtab_read_1 (struct objfile *objfile, int type,
+		   long number_of_symbols, asymbol **symbol_table,
+		   int copy_names, struct elf_symtab_state *state)
 {
   struct gdbarch *gdbarch = get_objfile_arch (objfile);
   asymbol *sym;
@@ -237,17 +283,12 @@ elf_symtab_read (struct objfile *objfile, int type,
   CORE_ADDR symaddr;
   CORE_ADDR offset;
   enum minimal_symbol_type ms_type;
-  /* If sectinfo is nonNULL, it contains section info that should end up
-     filed in the objfile.  */
-  struct stab_section_info *sectinfo = NULL;
-  /* If filesym is nonzero, it points to a file symbol, but we haven't
-     seen any section info for it yet.  */
-  asymbol *filesym = 0;
-  /* Name of filesym.  This is either a constant string or is saved on
-     the objfile's filename cache.  */
-  const char *filesymname = "";
+  struct stab_section_info *sectinfo = state->sectinfo;
+  const char *filesym = state->filesym;
+  const char *filesymname = state->filesymname;
   struct dbx_symfile_info *dbx = DBX_SYMFILE_INFO (objfile);
-  int stripped = (bfd_get_symcount (objfile->obfd) == 0);
+  int stripped = (elf_regular_symcount (objfile->obfd) == 0
+		  || (objfile->flags & OBJF_DEFERRED) != 0);
 
   for (i = 0; i < number_of_symbols; i++)
     {
@@ -351,9 +392,9 @@ elf_symtab_read (struct objfile *objfile, int type,
 	      dbx->stab_section_info = sectinfo;
 	      sectinfo = NULL;
 	    }
-	  filesym = sym;
-	  filesymname = bcache (filesym->name, strlen (filesym->name) + 1,
+	  filesymname = bcache (sym->name, strlen (sym->name) + 1,
 				objfile->per_bfd->filename_cache);
+	  filesym = filesymname;
 	}
       else if (sym->flags & BSF_SECTION_SYM)
 	continue;
@@ -506,8 +547,7 @@ elf_symtab_read (struct objfile *objfile, int type,
 			    }
 			  else
 			    {
-			      sectinfo->filename =
-				(char *) filesym->name;
+			      sectinfo->filename = (char *) filesym;
 			    }
 			}
 		      if (sectinfo->sections[special_local_sect] != 0)
@@ -612,6 +652,192 @@ elf_symtab_read (struct objfile *objfile, int type,
 	    }
 	}
     }
+
+  state->sectinfo = sectinfo;
+  state->filesym = filesym;
+  state->filesymname = filesymname;
+}
+
+/* Enter the symbols of the whole symbol table SYMBOL_TABLE.  */
+
+static void
+elf_symtab_read (struct objfile *objfile, int type,
+		 long number_of_symbols, asymbol **symbol_table,
+		 int copy_names)
+{
+  struct elf_symtab_state state;
+
+  elf_symtab_state_init (&state);
+  elf_symtab_read_1 (objfile, type, number_of_symbols, symbol_table,
+		     copy_names, &state);
+}
+
+/* The number of regular symbols elf_read_symtab_direct converts at a
+   time.  */
+
+#define ELF_SYMTAB_CHUNK 4096
+
+/* Return non-zero if the regular symbol table of ABFD can be read by
+   elf_read_symtab_direct.  That is not possible when the backend
+   post-processes the canonical symbol table as a whole, or when
+   SYNTH_ABFD needs the canonical symbol table for its synthetic
+   symbols, as ppc64 does for its function descriptors.  */
+
+static int
+elf_can_read_symtab_direct (bfd *abfd, bfd *synth_abfd)
+{
+  const struct elf_backend_data *ebd;
+
+  if (bfd_get_flavour (abfd) != bfd_target_elf_flavour
+      || bfd_get_flavour (synth_abfd) != bfd_target_elf_flavour)
+    return 0;
+
+  ebd = get_elf_backend_data (abfd);
+  if (ebd->elf_backend_symbol_table_processing != NULL
+      || (abfd->flags & BFD_PLUGIN) != 0)
+    return 0;
+
+  return (synth_abfd->xvec->_bfd_get_synthetic_symtab
+	  == _bfd_elf_get_synthetic_symtab);
+}
+
+/* Fill in SYM, the way BFD would when canonicalizing the regular
+   symbol table HDR of ABFD, from ISYM.  */
+
+static void
+elf_canonicalize_symbol (bfd *abfd, Elf_Internal_Shdr *hdr,
+			 Elf_Internal_Sym *isym, elf_symbol_type *sym)
+{
+  const struct elf_backend_data *ebd = get_elf_backend_data (abfd);
+
+  memset (sym, 0, sizeof (*sym));
+  sym->internal_elf_sym = *isym;
+  sym->symbol.the_bfd = abfd;
+  sym->symbol.name = bfd_elf_sym_name (abfd, hdr, isym, NULL);
+  sym->symbol.value = isym->st_value;
+
+  if (isym->st_shndx == SHN_UNDEF)
+    sym->symbol.section = bfd_und_section_ptr;
+  else if (isym->st_shndx == SHN_ABS)
+    sym->symbol.section = bfd_abs_section_ptr;
+  else if (isym->st_shndx == SHN_COMMON)
+    {
+      sym->symbol.section = bfd_com_section_ptr;
+      sym->symbol.value = isym->st_size;
+    }
+  else
+    {
+      sym->symbol.section = bfd_section_from_elf_index (abfd, isym->st_shndx);
+      if (sym->symbol.section == NULL)
+	sym->symbol.section = bfd_abs_section_ptr;
+    }
+
+  if ((abfd->flags & (EXEC_P | DYNAMIC)) != 0)
+    sym->symbol.value -= sym->symbol.section->vma;
+
+  switch (ELF_ST_BIND (isym->st_info))
+    {
+    case STB_LOCAL:
+      sym->symbol.flags |= BSF_LOCAL;
+      break;
+    case STB_GLOBAL:
+      if (isym->st_shndx != SHN_UNDEF && isym->st_shndx != SHN_COMMON)
+	sym->symbol.flags |= BSF_GLOBAL;
+      break;
+    case STB_WEAK:
+      sym->symbol.flags |= BSF_WEAK;
+      break;
+    case STB_GNU_UNIQUE:
+      sym->symbol.flags |= BSF_GNU_UNIQUE;
+      break;
+    }
+
+  switch (ELF_ST_TYPE (isym->st_info))
+    {
+    case STT_SECTION:
+      sym->symbol.flags |= BSF_SECTION_SYM | BSF_DEBUGGING;
+      break;
+    case STT_FILE:
+      sym->symbol.flags |= BSF_FILE | BSF_DEBUGGING;
+      break;
+    case STT_FUNC:
+      sym->symbol.flags |= BSF_FUNCTION;
+      break;
+    case STT_COMMON:
+    case STT_OBJECT:
+      sym->symbol.flags |= BSF_OBJECT;
+      break;
+    case STT_TLS:
+      sym->symbol.flags |= BSF_THREAD_LOCAL;
+      break;
+    case STT_GNU_IFUNC:
+      sym->symbol.flags |= BSF_GNU_INDIRECT_FUNCTION;
+      break;
+    }
+
+  if (ebd->elf_backend_symbol_processing)
+    (*ebd->elf_backend_symbol_processing) (abfd, &sym->symbol);
+}
+
+/* Read the regular symbol table of OBJFILE into minimal symbols,
+   ELF_SYMTAB_CHUNK symbols at a time, instead of having BFD build
+   the canonical symbol table.  That table costs an elf_symbol_type
+   per symbol for as long as the BFD is open, on top of the transient
+   array of internal symbols it is built from.  Here only one chunk of
+   each is alive at a time, and the minimal symbol names still point
+   into the string table BFD keeps.  Return the number of symbols.  */
+
+static long
+elf_read_symtab_direct (struct objfile *objfile)
+{
+  bfd *abfd = objfile->obfd;
+  const struct elf_backend_data *ebd = get_elf_backend_data (abfd);
+  Elf_Internal_Shdr *hdr = &elf_tdata (abfd)->symtab_hdr;
+  long symcount = elf_regular_symcount (abfd);
+  struct elf_symtab_state state;
+  Elf_Internal_Sym *isymbuf;
+  elf_symbol_type *symbase;
+  asymbol **symptrs;
+  gdb_byte *extsymbuf;
+  struct cleanup *back_to;
+  long done, i;
+
+  if (symcount == 0)
+    return 0;
+
+  isymbuf = XNEWVEC (Elf_Internal_Sym, ELF_SYMTAB_CHUNK);
+  back_to = make_cleanup (xfree, isymbuf);
+  symbase = XNEWVEC (elf_symbol_type, ELF_SYMTAB_CHUNK);
+  make_cleanup (xfree, symbase);
+  symptrs = XNEWVEC (asymbol *, ELF_SYMTAB_CHUNK);
+  make_cleanup (xfree, symptrs);
+  extsymbuf = xmalloc (ELF_SYMTAB_CHUNK * ebd->s->sizeof_sym);
+  make_cleanup (xfree, extsymbuf);
+
+  elf_symtab_state_init (&state);
+
+  /* Skip the null symbol, as BFD does.  */
+  for (done = 0; done < symcount; done += ELF_SYMTAB_CHUNK)
+    {
+      long count = min (symcount - done, ELF_SYMTAB_CHUNK);
+
+      if (bfd_elf_get_elf_syms (abfd, hdr, count, done + 1, isymbuf,
+				extsymbuf, NULL) == NULL)
+	error (_("Can't read symbols from %s: %s"),
+	       bfd_get_filename (abfd),
+	       bfd_errmsg (bfd_get_error ()));
+
+      for (i = 0; i < count; i++)
+	{
+	  elf_canonicalize_symbol (abfd, hdr, &isymbuf[i], &symbase[i]);
+	  symptrs[i] = &symbase[i].symbol;
+	}
+
+      elf_symtab_read_1 (objfile, ST_REGULAR, count, symptrs, 0, &state);
+    }
+
+  do_cleanups (back_to);
+  return symcount;
 }
 
 /* Build minimal symbols named `function@got.plt' (see SYMBOL_GOT_PLT_SUFFIX)
@@ -1083,6 +1309,43 @@ elf_gnu_ifunc_resolver_return_stop (struct breakpoint *b)
   update_breakpoint_locations (b, sals, sals_end);
 }
 
+/* Read just the dynamic symbols of OBJFILE as its minimal symbols,
+   for SYMFILE_DEFER_READ.  The caller has set OBJF_DEFERRED, so
+   elf_symtab_read enters them even if OBJFILE has a full symbol
+   table; elf_symfile_read reads that one when the deferred symbols
+   are read.  */
+
+static void
+elf_read_deferred_minimal_symbols (struct objfile *objfile)
+{
+  struct cleanup *back_to;
+  long storage_needed, dynsymcount;
+  asymbol **dyn_symbol_table;
+
+  back_to = make_profile_phase_cleanup ("minimal symbols", NULL);
+  init_minimal_symbol_collection ();
+  make_cleanup_discard_minimal_symbols ();
+
+  storage_needed = bfd_get_dynamic_symtab_upper_bound (objfile->obfd);
+  if (storage_needed > 0)
+    {
+      dyn_symbol_table = (asymbol **) xmalloc (storage_needed);
+      make_cleanup (xfree, dyn_symbol_table);
+      dynsymcount = bfd_canonicalize_dynamic_symtab (objfile->obfd,
+						     dyn_symbol_table);
+
+      if (dynsymcount < 0)
+	error (_("Can't read symbols from %s: %s"),
+	       bfd_get_filename (objfile->obfd),
+	       bfd_errmsg (bfd_get_error ()));
+
+      elf_symtab_read (objfile, ST_DYNAMIC, dynsymcount, dyn_symbol_table, 0);
+    }
+
+  install_minimal_symbols (objfile);
+  do_cleanups (back_to);
+}
+
 /* Scan and build partial symbols for a symbol file.
    We have been initialized by a call to elf_symfile_init, which
    currently does nothing.
@@ -1129,8 +1392,18 @@ elf_symfile_read (struct objfile *objfile, int symfile_flags)
 			  objfile_name (objfile));
     }
 
+  /* Leave the full symbol table and the debug information for
+     read_deferred_symbols.  */
+  if ((symfile_flags & SYMFILE_DEFER_READ) != 0)
+    {
+      objfile->flags |= OBJF_DEFERRED;
+      elf_read_deferred_minimal_symbols (objfile);
+      return;
+    }
+
+  back_to = make_profile_phase_cleanup ("minimal symbols", NULL);
   init_minimal_symbol_collection ();
-  back_to = make_cleanup_discard_minimal_symbols ();
+  make_cleanup_discard_minimal_symbols ();
 
   memset ((char *) &ei, 0, sizeof (ei));
 
@@ -1139,11 +1412,24 @@ elf_symfile_read (struct objfile *objfile, int symfile_flags)
   set_objfile_data (objfile, dbx_objfile_data_key, dbx);
   make_cleanup (free_elfinfo, (void *) objfile);
 
+  if (objfile->separate_debug_objfile_backlink)
+    synth_abfd = objfile->separate_debug_objfile_backlink->obfd;
+  else
+    synth_abfd = abfd;
+
   /* Process the normal ELF symbol table first.  This may write some
      chain of info into the dbx_symfile_info of the objfile, which can
      later be used by elfstab_offset_sections.  */
 
-  storage_needed = bfd_get_symtab_upper_bound (objfile->obfd);
+  if (elf_can_read_symtab_direct (abfd, synth_abfd))
+    {
+      /* The synthetic symbols do not need the regular ones, so there
+	 is no need to canonicalize them.  */
+      elf_read_symtab_direct (objfile);
+      storage_needed = 0;
+    }
+  else
+    storage_needed = bfd_get_symtab_upper_bound (objfile->obfd);
   if (storage_needed < 0)
     error (_("Can't read symbols from %s: %s"),
 	   bfd_get_filename (objfile->obfd),
@@ -1199,13 +1485,8 @@ elf_symfile_read (struct objfile *objfile, int symfile_flags)
      read the code address from .opd while it reads the .symtab section from
      a separate debug info file as the .opd section is SHT_NOBITS there.
 
-     With SYNTH_ABFD the .opd section will be read from the original
-     backlinked binary where it is valid.  */
-
-  if (objfile->separate_debug_objfile_backlink)
-    synth_abfd = objfile->separate_debug_objfile_backlink->obfd;
-  else
-    synth_abfd = abfd;
+     With SYNTH_ABFD, set above, the .opd section will be read from the
+     original backlinked binary where it is valid.  */
 
   /* Add synthetic symbols - for instance, names for any PLT entries.  */
 
@@ -30,6 +30,10 @@
 #endif
 #endif
 
+#ifdef HAVE_EPOLL_CREATE1
+#include <sys/epoll.h>
+#endif
+
 #include <sys/types.h>
 #include "gdb_string.h"
 #include <errno.h>
@@ -162,6 +166,18 @@ static QUEUE(gdb_event_p) *event_queue = NULL;
 
 static unsigned char use_poll = USE_POLL;
 
+#ifdef HAVE_EPOLL_CREATE1
+/* Do we wait for the poll_fds with epoll instead of poll?  epoll
+   returns only the descriptors that are ready, so the cost of a wakeup
+   does not grow with the number of descriptors registered.  It cannot
+   watch regular files though, so if one of those is registered, we go
+   back to poll for good.  */
+static unsigned char use_epoll = 1;
+
+/* The epoll instance, or -1 if it has not been created yet.  */
+static int epoll_fd = -1;
+#endif
+
 #ifdef USE_WIN32API
 #include <windows.h>
 #include <io.h>
@@ -180,6 +196,17 @@ static struct
     int poll_timeout;
 #endif
 
+#ifdef HAVE_EPOLL_CREATE1
+    /* Buffer for the results of epoll_wait, and its size.  */
+    struct epoll_event *epoll_events;
+    int num_epoll_events;
+#endif
+
+    /* The file handlers, indexed by file descriptor, so that a ready
+       descriptor's handler is found without walking the list.  */
+    file_handler **fd_table;
+    int fd_table_size;
+
     /* Masks to be used in the next call to select.
        Bits are set in response to calls to create_file_handler.  */
     fd_set check_masks[3];
@@ -284,6 +311,71 @@ create_file_event (int fd)
   return create_event (handle_file_event, data);
 }
 
+/* Return the file handler registered for FD, or NULL if there is
+   none.  */
+
+static file_handler *
+find_file_handler (int fd)
+{
+  if (fd >= 0 && fd < gdb_notifier.fd_table_size)
+    return gdb_notifier.fd_table[fd];
+  return NULL;
+}
+
+/* Record that FILE_PTR saw the events in MASK, and queue an event for
+   it unless one is already pending.  */
+
+static void
+mark_file_ready (file_handler *file_ptr, int mask)
+{
+  if (file_ptr->ready_mask == 0)
+    {
+      gdb_event *file_event_ptr = create_file_event (file_ptr->fd);
+
+      QUEUE_enque (gdb_event_p, event_queue, file_event_ptr);
+    }
+  file_ptr->ready_mask = mask;
+}
+
+#ifdef HAVE_EPOLL_CREATE1
+/* Watch FD for the poll events in MASK with epoll.  If epoll is not
+   usable, or will not watch FD, stop using it; the poll_fds array is
+   kept either way, so gdb_wait_for_event simply calls poll instead.  */
+
+static void
+epoll_watch_fd (int fd, int mask)
+{
+  struct epoll_event event;
+
+  if (!use_epoll)
+    return;
+
+  if (epoll_fd == -1)
+    {
+      epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+      if (epoll_fd == -1)
+	{
+	  use_epoll = 0;
+	  return;
+	}
+    }
+
+  memset (&event, 0, sizeof (event));
+  event.events = mask;
+  event.data.fd = fd;
+  if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0
+      || (errno == EEXIST
+	  && epoll_ctl (epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0))
+    return;
+
+  /* Typically FD is a regular file or /dev/null, which epoll
+     refuses with EPERM.  */
+  close (epoll_fd);
+  epoll_fd = -1;
+  use_epoll = 0;
+}
+#endif
+
 
 /* Free EVENT.  */
 
@@ -529,12 +621,7 @@ create_file_handler (int fd, int mask, handler_func * proc,
 
   /* Do we already have a file handler for this file?  (We may be
      changing its associated procedure).  */
-  for (file_ptr = gdb_notifier.first_file_handler; file_ptr != NULL;
-       file_ptr = file_ptr->next_file)
-    {
-      if (file_ptr->fd == fd)
-	break;
-    }
+  file_ptr = find_file_handler (fd);
 
   /* It is a new file descriptor.  Add it to the list.  Otherwise, just
      change the data associated with it.  */
@@ -546,6 +633,20 @@ create_file_handler (int fd, int mask, handler_func * proc,
       file_ptr->next_file = gdb_notifier.first_file_handler;
       gdb_notifier.first_file_handler = file_ptr;
 
+      if (fd >= gdb_notifier.fd_table_size)
+	{
+	  int new_size = max (fd + 1, 2 * gdb_notifier.fd_table_size);
+
+	  gdb_notifier.fd_table
+	    = xrealloc (gdb_notifier.fd_table,
+			new_size * sizeof (file_handler *));
+	  memset (gdb_notifier.fd_table + gdb_notifier.fd_table_size, 0,
+		  ((new_size - gdb_notifier.fd_table_size)
+		   * sizeof (file_handler *)));
+	  gdb_notifier.fd_table_size = new_size;
+	}
+      gdb_notifier.fd_table[fd] = file_ptr;
+
       if (use_poll)
 	{
 #ifdef HAVE_POLL
@@ -591,6 +692,14 @@ create_file_handler (int fd, int mask, handler_func * proc,
   file_ptr->proc = proc;
   file_ptr->client_data = client_data;
   file_ptr->mask = mask;
+
+#ifdef HAVE_EPOLL_CREATE1
+  /* Register FD with epoll even if we had a handler for it already;
+     it may have been closed and opened again, which drops it from the
+     epoll set.  */
+  if (use_poll)
+    epoll_watch_fd (fd, mask);
+#endif
 }
 
 /* Remove the file descriptor FD from the list of monitored fd's: 
@@ -607,19 +716,27 @@ delete_file_handler (int fd)
 
   /* Find the entry for the given file.  */
 
-  for (file_ptr = gdb_notifier.first_file_handler; file_ptr != NULL;
-       file_ptr = file_ptr->next_file)
-    {
-      if (file_ptr->fd == fd)
-	break;
-    }
-
+  file_ptr = find_file_handler (fd);
   if (file_ptr == NULL)
     return;
 
+  gdb_notifier.fd_table[fd] = NULL;
+
   if (use_poll)
     {
 #ifdef HAVE_POLL
+#ifdef HAVE_EPOLL_CREATE1
+      /* FD may already have been closed, which removes it from the
+	 epoll set by itself, so ignore errors.  */
+      if (use_epoll && epoll_fd != -1)
+	{
+	  struct epoll_event event;
+
+	  memset (&event, 0, sizeof (event));
+	  epoll_ctl (epoll_fd, EPOLL_CTL_DEL, fd, &event);
+	}
+#endif
+
       /* Create a new poll_fds array by copying every fd's information
          but the one we want to get rid of.  */
 
@@ -703,72 +820,68 @@ handle_file_event (event_data data)
 #endif
   int event_file_desc = data.integer;
 
-  /* Search the file handler list to find one that matches the fd in
-     the event.  */
-  for (file_ptr = gdb_notifier.first_file_handler; file_ptr != NULL;
-       file_ptr = file_ptr->next_file)
-    {
-      if (file_ptr->fd == event_file_desc)
-	{
-	  /* With poll, the ready_mask could have any of three events
-	     set to 1: POLLHUP, POLLERR, POLLNVAL.  These events
-	     cannot be used in the requested event mask (events), but
-	     they can be returned in the return mask (revents).  We
-	     need to check for those event too, and add them to the
-	     mask which will be passed to the handler.  */
+  /* Find the file handler that matches the fd in the event.  It may
+     have been deleted since the event was queued.  */
+  file_ptr = find_file_handler (event_file_desc);
+  if (file_ptr == NULL)
+    return;
 
-	  /* See if the desired events (mask) match the received
-	     events (ready_mask).  */
+  /* With poll, the ready_mask could have any of three events
+     set to 1: POLLHUP, POLLERR, POLLNVAL.  These events
+     cannot be used in the requested event mask (events), but
+     they can be returned in the return mask (revents).  We
+     need to check for those event too, and add them to the
+     mask which will be passed to the handler.  */
 
-	  if (use_poll)
-	    {
+  /* See if the desired events (mask) match the received
+     events (ready_mask).  */
+
+  if (use_poll)
+    {
 #ifdef HAVE_POLL
-	      /* POLLHUP means EOF, but can be combined with POLLIN to
-		 signal more data to read.  */
-	      error_mask = POLLHUP | POLLERR | POLLNVAL;
-	      mask = file_ptr->ready_mask & (file_ptr->mask | error_mask);
-
-	      if ((mask & (POLLERR | POLLNVAL)) != 0)
-		{
-		  /* Work in progress.  We may need to tell somebody
-		     what kind of error we had.  */
-		  if (mask & POLLERR)
-		    printf_unfiltered (_("Error detected on fd %d\n"),
-				       file_ptr->fd);
-		  if (mask & POLLNVAL)
-		    printf_unfiltered (_("Invalid or non-`poll'able fd %d\n"),
-				       file_ptr->fd);
-		  file_ptr->error = 1;
-		}
-	      else
-		file_ptr->error = 0;
+      /* POLLHUP means EOF, but can be combined with POLLIN to
+	 signal more data to read.  */
+      error_mask = POLLHUP | POLLERR | POLLNVAL;
+      mask = file_ptr->ready_mask & (file_ptr->mask | error_mask);
+
+      if ((mask & (POLLERR | POLLNVAL)) != 0)
+	{
+	  /* Work in progress.  We may need to tell somebody
+	     what kind of error we had.  */
+	  if (mask & POLLERR)
+	    printf_unfiltered (_("Error detected on fd %d\n"),
+			       file_ptr->fd);
+	  if (mask & POLLNVAL)
+	    printf_unfiltered (_("Invalid or non-`poll'able fd %d\n"),
+			       file_ptr->fd);
+	  file_ptr->error = 1;
+	}
+      else
+	file_ptr->error = 0;
 #else
-	      internal_error (__FILE__, __LINE__,
-			      _("use_poll without HAVE_POLL"));
+      internal_error (__FILE__, __LINE__,
+		      _("use_poll without HAVE_POLL"));
 #endif /* HAVE_POLL */
-	    }
-	  else
-	    {
-	      if (file_ptr->ready_mask & GDB_EXCEPTION)
-		{
-		  printf_unfiltered (_("Exception condition detected "
-				       "on fd %d\n"), file_ptr->fd);
-		  file_ptr->error = 1;
-		}
-	      else
-		file_ptr->error = 0;
-	      mask = file_ptr->ready_mask & file_ptr->mask;
-	    }
-
-	  /* Clear the received events for next time around.  */
-	  file_ptr->ready_mask = 0;
-
-	  /* If there was a match, then call the handler.  */
-	  if (mask != 0)
-	    (*file_ptr->proc) (file_ptr->error, file_ptr->client_data);
-	  break;
+    }
+  else
+    {
+      if (file_ptr->ready_mask & GDB_EXCEPTION)
+	{
+	  printf_unfiltered (_("Exception condition detected "
+			       "on fd %d\n"), file_ptr->fd);
+	  file_ptr->error = 1;
 	}
+      else
+	file_ptr->error = 0;
+      mask = file_ptr->ready_mask & file_ptr->mask;
     }
+
+  /* Clear the received events for next time around.  */
+  file_ptr->ready_mask = 0;
+
+  /* If there was a match, then call the handler.  */
+  if (mask != 0)
+    (*file_ptr->proc) (file_ptr->error, file_ptr->client_data);
 }
 
 /* Called by gdb_do_one_event to wait for new events on the monitored
@@ -780,7 +893,6 @@ static int
 gdb_wait_for_event (int block)
 {
   file_handler *file_ptr;
-  gdb_event *file_event_ptr;
   int num_found = 0;
   int i;
 
@@ -801,13 +913,35 @@ gdb_wait_for_event (int block)
       else
 	timeout = 0;
 
-      num_found = poll (gdb_notifier.poll_fds,
-			(unsigned long) gdb_notifier.num_fds, timeout);
+#ifdef HAVE_EPOLL_CREATE1
+      if (use_epoll)
+	{
+	  if (gdb_notifier.num_epoll_events < gdb_notifier.num_fds)
+	    {
+	      gdb_notifier.num_epoll_events = gdb_notifier.num_fds;
+	      gdb_notifier.epoll_events
+		= xrealloc (gdb_notifier.epoll_events,
+			    (gdb_notifier.num_epoll_events
+			     * sizeof (struct epoll_event)));
+	    }
+
+	  num_found = epoll_wait (epoll_fd, gdb_notifier.epoll_events,
+				  gdb_notifier.num_epoll_events, timeout);
+
+	  if (num_found == -1 && errno != EINTR)
+	    perror_with_name (("epoll_wait"));
+	}
+      else
+#endif
+	{
+	  num_found = poll (gdb_notifier.poll_fds,
+			    (unsigned long) gdb_notifier.num_fds, timeout);
 
-      /* Don't print anything if we get out of poll because of a
-	 signal.  */
-      if (num_found == -1 && errno != EINTR)
-	perror_with_name (("poll"));
+	  /* Don't print anything if we get out of poll because of a
+	     signal.  */
+	  if (num_found == -1 && errno != EINTR)
+	    perror_with_name (("poll"));
+	}
 #else
       internal_error (__FILE__, __LINE__,
 		      _("use_poll without HAVE_POLL"));
@@ -855,6 +989,21 @@ gdb_wait_for_event (int block)
   if (use_poll)
     {
 #ifdef HAVE_POLL
+#ifdef HAVE_EPOLL_CREATE1
+      if (use_epoll)
+	{
+	  for (i = 0; i < num_found; i++)
+	    {
+	      struct epoll_event *event = &gdb_notifier.epoll_events[i];
+
+	      file_ptr = find_file_handler (event->data.fd);
+	      if (file_ptr != NULL)
+		mark_file_ready (file_ptr, event->events);
+	    }
+	  return 0;
+	}
+#endif
+
       for (i = 0; (i < gdb_notifier.num_fds) && (num_found > 0); i++)
 	{
 	  if ((gdb_notifier.poll_fds + i)->revents)
@@ -862,25 +1011,9 @@ gdb_wait_for_event (int block)
 	  else
 	    continue;
 
-	  for (file_ptr = gdb_notifier.first_file_handler;
-	       file_ptr != NULL;
-	       file_ptr = file_ptr->next_file)
-	    {
-	      if (file_ptr->fd == (gdb_notifier.poll_fds + i)->fd)
-		break;
-	    }
-
+	  file_ptr = find_file_handler ((gdb_notifier.poll_fds + i)->fd);
 	  if (file_ptr)
-	    {
-	      /* Enqueue an event only if this is still a new event for
-	         this fd.  */
-	      if (file_ptr->ready_mask == 0)
-		{
-		  file_event_ptr = create_file_event (file_ptr->fd);
-		  QUEUE_enque (gdb_event_p, event_queue, file_event_ptr);
-		}
-	      file_ptr->ready_mask = (gdb_notifier.poll_fds + i)->revents;
-	    }
+	    mark_file_ready (file_ptr, (gdb_notifier.poll_fds + i)->revents);
 	}
 #else
       internal_error (__FILE__, __LINE__,
@@ -907,15 +1040,7 @@ gdb_wait_for_event (int block)
 	  else
 	    num_found--;
 
-	  /* Enqueue an event only if this is still a new event for
-	     this fd.  */
-
-	  if (file_ptr->ready_mask == 0)
-	    {
-	      file_event_ptr = create_file_event (file_ptr->fd);
-	      QUEUE_enque (gdb_event_p, event_queue, file_event_ptr);
-	    }
-	  file_ptr->ready_mask = mask;
+	  mark_file_ready (file_ptr, mask);
 	}
     }
   return 0;
@@ -352,6 +352,7 @@ add_to_section_table (bfd *abfd, struct bfd_section *asect,
 
   (*table_pp)->owner = NULL;
   (*table_pp)->the_bfd_section = asect;
+  (*table_pp)->verified = 0;
   (*table_pp)->addr = bfd_section_vma (abfd, asect);
   (*table_pp)->endaddr = (*table_pp)->addr + bfd_section_size (abfd, asect);
   (*table_pp)++;
@@ -477,6 +478,7 @@ add_target_sections_of_objfile (struct objfile *objfile)
       ts->addr = obj_section_addr (osect);
       ts->endaddr = obj_section_endaddr (osect);
       ts->the_bfd_section = osect->the_bfd_section;
+      ts->verified = 0;
       ts->owner = (void *) objfile;
 
       ts++;
@@ -27,6 +27,9 @@
 #include "exceptions.h"
 #include "gdb_assert.h"
 #include "gdb_obstack.h"
+#include "hashtab.h"
+#include "observer.h"
+#include "progspace.h"
 
 static struct gdbarch_data *frame_unwind_data;
 
@@ -88,6 +91,87 @@ frame_unwind_append_unwinder (struct gdbarch *gdbarch,
   (*ip)->unwinder = unwinder;
 }
 
+/* The sniffers of normal and signal trampoline frame unwinders decide
+   whether to claim a frame from its PC, whether it is the innermost
+   frame, and the kind of frame it was called from.  Other frames with
+   the same PC are thus claimed by the same unwinder; remember which,
+   so that the sniffers that rejected the first frame don't have to
+   look at the others again.  The dummy, inline and tail call
+   sniffers depend on more than that, and are always run.  */
+
+struct unwinder_cache_entry
+{
+  /* What identifies the frames.  NEXT_TYPE is the type of the frame
+     called from the frames, or -1 for innermost frames.  */
+  struct program_space *pspace;
+  struct gdbarch *gdbarch;
+  CORE_ADDR pc;
+  int next_type;
+
+  /* The entry of the unwinder table that claimed the frames.  */
+  struct frame_unwind_table_entry *entry;
+};
+
+/* The unwinders that claimed frames, indexed by the unwinder_cache_entry
+   fields above ENTRY.  Emptied whenever an objfile comes or goes.  */
+
+static htab_t unwinder_cache;
+
+static hashval_t
+hash_unwinder_cache_entry (const void *p)
+{
+  const struct unwinder_cache_entry *e = p;
+
+  return (htab_hash_pointer (e->pspace) ^ htab_hash_pointer (e->gdbarch)
+	  ^ (hashval_t) e->pc ^ e->next_type);
+}
+
+static int
+eq_unwinder_cache_entry (const void *a, const void *b)
+{
+  const struct unwinder_cache_entry *ea = a;
+  const struct unwinder_cache_entry *eb = b;
+
+  return (ea->pspace == eb->pspace && ea->gdbarch == eb->gdbarch
+	  && ea->pc == eb->pc && ea->next_type == eb->next_type);
+}
+
+/* Return non-zero if the sniffer of UNWINDER decides from the frame's
+   PC and surroundings only, as described above.  */
+
+static int
+unwinder_cacheable_p (const struct frame_unwind *unwinder)
+{
+  return unwinder->type == NORMAL_FRAME || unwinder->type == SIGTRAMP_FRAME;
+}
+
+/* Fill in the key of KEY for THIS_FRAME.  Return zero if THIS_FRAME's
+   PC isn't available.  */
+
+static int
+unwinder_cache_key (struct frame_info *this_frame,
+		    struct unwinder_cache_entry *key)
+{
+  struct frame_info *next_frame;
+
+  if (!get_frame_pc_if_available (this_frame, &key->pc))
+    return 0;
+
+  next_frame = get_next_frame (this_frame);
+  key->pspace = get_frame_program_space (this_frame);
+  key->gdbarch = get_frame_arch (this_frame);
+  key->next_type = next_frame != NULL ? get_frame_type (next_frame) : -1;
+  key->entry = NULL;
+  return 1;
+}
+
+static void
+unwinder_cache_clear (struct objfile *objfile)
+{
+  if (unwinder_cache != NULL)
+    htab_empty (unwinder_cache);
+}
+
 /* Iterate through sniffers for THIS_FRAME frame until one returns with an
    unwinder implementation.  THIS_FRAME->UNWIND must be NULL, it will get set
    by this function.  Possibly initialize THIS_CACHE.  */
@@ -98,13 +182,26 @@ frame_unwind_find_by_frame (struct frame_info *this_frame, void **this_cache)
   struct gdbarch *gdbarch = get_frame_arch (this_frame);
   struct frame_unwind_table *table = gdbarch_data (gdbarch, frame_unwind_data);
   struct frame_unwind_table_entry *entry;
+  struct unwinder_cache_entry key, *cached;
+  int have_key;
+
+  have_key = unwinder_cache_key (this_frame, &key);
+  cached = NULL;
+  if (have_key && unwinder_cache != NULL)
+    cached = htab_find (unwinder_cache, &key);
 
+ retry:
   for (entry = table->list; entry != NULL; entry = entry->next)
     {
       struct cleanup *old_cleanup;
       volatile struct gdb_exception ex;
       int res = 0;
 
+      /* Skip the sniffers that rejected frames like this one.  */
+      if (cached != NULL && entry != cached->entry
+	  && unwinder_cacheable_p (entry->unwinder))
+	continue;
+
       old_cleanup = frame_prepare_for_sniffer (this_frame, entry->unwinder);
 
       TRY_CATCH (ex, RETURN_MASK_ERROR)
@@ -118,16 +215,45 @@ frame_unwind_find_by_frame (struct frame_info *this_frame, void **this_cache)
 	     thus most unwinders aren't able to determine if they're
 	     the best fit.  Keep trying.  Fallback prologue unwinders
 	     should always accept the frame.  */
+	  have_key = 0;
 	}
       else if (ex.reason < 0)
 	throw_exception (ex);
       else if (res)
         {
           discard_cleanups (old_cleanup);
+
+	  if (have_key && cached == NULL
+	      && unwinder_cacheable_p (entry->unwinder))
+	    {
+	      void **slot;
+
+	      if (unwinder_cache == NULL)
+		unwinder_cache
+		  = htab_create_alloc (13, hash_unwinder_cache_entry,
+				       eq_unwinder_cache_entry, xfree,
+				       xcalloc, xfree);
+
+	      slot = htab_find_slot (unwinder_cache, &key, INSERT);
+	      if (*slot == NULL)
+		*slot = XNEW (struct unwinder_cache_entry);
+	      **(struct unwinder_cache_entry **) slot = key;
+	      (*(struct unwinder_cache_entry **) slot)->entry = entry;
+	    }
           return;
         }
 
       do_cleanups (old_cleanup);
+
+      if (cached != NULL && entry == cached->entry)
+	{
+	  /* The unwinder that claimed frames like this one rejected
+	     this one after all.  Forget about it, and try all
+	     sniffers.  */
+	  htab_remove_elt (unwinder_cache, &key);
+	  cached = NULL;
+	  goto retry;
+	}
     }
   internal_error (__FILE__, __LINE__, _("frame_unwind_find_by_frame failed"));
 }
@@ -242,4 +368,7 @@ void
 _initialize_frame_unwind (void)
 {
   frame_unwind_data = gdbarch_data_register_pre_init (frame_unwind_init);
+
+  observer_attach_new_objfile (unwinder_cache_clear);
+  observer_attach_free_objfile (unwinder_cache_clear);
 }
@@ -41,6 +41,12 @@
    generate-core-file for programs with large resident data.  */
 #define MAX_COPY_BYTES (1024 * 1024)
 
+/* Blocks of this many bytes of memory that are all zero are not
+   written to the core file, leaving holes in it where the file system
+   supports them.  Large processes usually have many such pages, that
+   were never touched or have been freed.  */
+#define SPARSE_BLOCK_BYTES 4096
+
 static const char *default_gcore_target (void);
 static enum bfd_architecture default_gcore_arch (void);
 static unsigned long default_gcore_mach (void);
@@ -407,10 +413,12 @@ gcore_create_callback (CORE_ADDR vaddr, unsigned long size, int read,
       return 0;
     }
 
-  if (write == 0 && modified == 0 && !solib_keep_data_in_core (vaddr, size))
+  if (modified == 0 && !solib_keep_data_in_core (vaddr, size))
     {
       /* See if this region of memory lies inside a known file on disk.
-	 If so, we can avoid copying its contents by clearing SEC_LOAD.  */
+	 If so, we can avoid copying its contents by clearing SEC_LOAD.
+	 This holds for writable regions too, as long as they haven't
+	 been written to.  */
       struct objfile *objfile;
       struct obj_section *objsec;
 
@@ -527,6 +535,68 @@ objfile_find_memory_regions (find_memory_region_ftype func, void *obfd)
   return 0;
 }
 
+/* Return nonzero if the LEN bytes at BUF are all zero.  */
+
+static int
+zero_block_p (const gdb_byte *buf, bfd_size_type len)
+{
+  bfd_size_type i;
+
+  for (i = 0; i < len; i++)
+    if (buf[i] != 0)
+      return 0;
+
+  return 1;
+}
+
+/* Write the SIZE bytes at BUF to OSEC of OBFD at OFFSET, skipping
+   blocks of SPARSE_BLOCK_BYTES which are all zero.  If LAST, this is
+   the end of the section, whose final byte is always written so that
+   the file extends over the whole section.  Return nonzero on
+   success.  */
+
+static int
+gcore_write_sparse (bfd *obfd, asection *osec, const gdb_byte *buf,
+		    file_ptr offset, bfd_size_type size, int last)
+{
+  bfd_size_type start = 0;
+
+  while (start < size)
+    {
+      bfd_size_type end = start;
+
+      /* Skip zero blocks.  */
+      while (end < size)
+	{
+	  bfd_size_type len = min (SPARSE_BLOCK_BYTES, size - end);
+
+	  if (!zero_block_p (buf + end, len) || (last && end + len == size))
+	    break;
+	  end += len;
+	}
+      start = end;
+
+      /* Find the end of the run of blocks to write.  */
+      while (end < size)
+	{
+	  bfd_size_type len = min (SPARSE_BLOCK_BYTES, size - end);
+
+	  if (end > start && zero_block_p (buf + end, len)
+	      && !(last && end + len == size))
+	    break;
+	  end += len;
+	}
+
+      if (end > start
+	  && !bfd_set_section_contents (obfd, osec, buf + start,
+					offset + start, end - start))
+	return 0;
+      start = end;
+    }
+
+  return 1;
+}
+
 static void
 gcore_copy_callback (bfd *obfd, asection *osec, void *ignored)
 {
@@ -561,7 +631,8 @@ gcore_copy_callback (bfd *obfd, asection *osec, void *ignored)
 		   paddress (target_gdbarch (), bfd_section_vma (obfd, osec)));
 	  break;
 	}
-      if (!bfd_set_section_contents (obfd, osec, memhunk, offset, size))
+      if (!gcore_write_sparse (obfd, osec, memhunk, offset, size,
+			       size == total_size))
 	{
 	  warning (_("Failed to write corefile contents (%s)."),
 		   bfd_errmsg (bfd_get_error ()));
@@ -353,6 +353,82 @@ get_section_descriptor (asection *section)
   return result;
 }
 
+#if defined (HAVE_MMAP) && defined (HAVE_ZLIB_H)
+
+/* Read the compressed section SECTP into DESCRIPTOR.  Rather than
+   reading the compressed contents into a temporary buffer, as
+   bfd_get_full_section_contents does, map them from the file and
+   inflate straight from the mapping into the final buffer.  This
+   saves a copy of the compressed data and keeps it off the heap.
+   Return 1 on success, or 0 if the caller should let BFD read the
+   section instead.  */
+
+static int
+map_compressed_section (asection *sectp,
+			struct gdb_bfd_section_data *descriptor)
+{
+  bfd *abfd = sectp->owner;
+  bfd_size_type size;
+  bfd_byte *compressed, *data;
+  void *map_addr;
+  bfd_size_type map_len;
+  z_stream strm;
+  int rc, res;
+
+  /* The first 12 bytes are the "ZLIB" header and the uncompressed
+     size, which BFD has already read.  */
+  if (sectp->compress_status != DECOMPRESS_SECTION_SIZED
+      || sectp->compressed_size <= 12)
+    return 0;
+
+  compressed = bfd_mmap (abfd, 0, sectp->compressed_size, PROT_READ,
+			 MAP_PRIVATE, sectp->filepos, &map_addr, &map_len);
+  if ((caddr_t) compressed == MAP_FAILED)
+    return 0;
+
+#if HAVE_POSIX_MADVISE
+  posix_madvise (map_addr, map_len, POSIX_MADV_SEQUENTIAL);
+#endif
+
+  size = bfd_get_section_size (sectp);
+  data = xmalloc (size);
+
+  /* The section may consist of several compressed streams
+     concatenated together, so inflate in a loop.  */
+  memset (&strm, 0, sizeof (strm));
+  strm.next_in = (Bytef *) compressed + 12;
+  strm.avail_in = sectp->compressed_size - 12;
+  strm.avail_out = size;
+
+  rc = inflateInit (&strm);
+  while (strm.avail_in > 0 && strm.avail_out > 0)
+    {
+      if (rc != Z_OK)
+	break;
+      strm.next_out = (Bytef *) data + (size - strm.avail_out);
+      rc = inflate (&strm, Z_FINISH);
+      if (rc != Z_STREAM_END)
+	break;
+      rc = inflateReset (&strm);
+    }
+  rc |= inflateEnd (&strm);
+
+  res = munmap (map_addr, map_len);
+  gdb_assert (res == 0);
+
+  if (rc != Z_OK || strm.avail_out != 0)
+    {
+      xfree (data);
+      return 0;
+    }
+
+  descriptor->size = size;
+  descriptor->data = data;
+  return 1;
+}
+
+#endif /* HAVE_MMAP && HAVE_ZLIB_H */
+
 /* See gdb_bfd.h.  */
 
 const gdb_byte *
@@ -406,6 +482,10 @@ gdb_bfd_map_section (asection *sectp, bfd_size_type *size)
 	  memset (descriptor, 0, sizeof (*descriptor));
 	}
     }
+#ifdef HAVE_ZLIB_H
+  else if (map_compressed_section (sectp, descriptor))
+    goto done;
+#endif
 #endif /* HAVE_MMAP */
 
   /* Handle compressed sections, or ordinary uncompressed sections in
@@ -125,6 +125,22 @@ extern bfd *core_bfd;
 
 extern struct target_ops *core_target;
 
+/* If reading LEN bytes of memory at MEMADDR would get them straight
+   from the contents of a single section of the core file, map those
+   bytes read-only and return their address.  *MAP_ADDR and *MAP_LEN
+   are set to what core_file_unmap_memory needs to release the mapping,
+   which stays valid after the core file is closed.  Otherwise, or if
+   the mapping fails, return NULL; the memory should then be read with
+   target_read_memory.  */
+
+extern const gdb_byte *core_file_map_memory (CORE_ADDR memaddr,
+					     ULONGEST len, void **map_addr,
+					     bfd_size_type *map_len);
+
+/* Release a mapping made by core_file_map_memory.  */
+
+extern void core_file_unmap_memory (void *map_addr, bfd_size_type map_len);
+
 /* Whether to open exec and core files read-only or read-write.  */
 
 extern int write_files;
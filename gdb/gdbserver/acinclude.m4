@@ -12,6 +12,9 @@ sinclude(../../config/override.m4)
 dnl For ACX_PKGVERSION and ACX_BUGURL.
 sinclude(../../config/acx.m4)
 
+dnl For AM_ZLIB.
+sinclude(../../config/zlib.m4)
+
 m4_include(../../config/depstand.m4)
 m4_include(../../config/lead-dot.m4)
 
@@ -20,6 +20,11 @@
 #include "ax.h"
 #include "format.h"
 #include "tracepoint.h"
+#include <stdint.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 static void ax_vdebug (const char *, ...) ATTRIBUTE_PRINTF (1, 2);
 
@@ -383,6 +388,31 @@ is_goto_target (struct agent_expr *aexpr, int pc)
   return 0;
 }
 
+/* Return nonzero if the agent expression AEXPR reads or writes trace
+   state variables.  */
+
+int
+agent_expr_uses_tsvs (struct agent_expr *aexpr)
+{
+  int i;
+  unsigned char op;
+
+  for (i = 0; i < aexpr->length; i += 1 + gdb_agent_op_sizes[op])
+    {
+      op = aexpr->bytes[i];
+
+      if (op >= gdb_agent_op_last)
+	return 0;
+
+      if (op == gdb_agent_op_getv
+	  || op == gdb_agent_op_setv
+	  || op == gdb_agent_op_tracev)
+	return 1;
+    }
+
+  return 0;
+}
+
 /* Given an agent expression, turn it into native code.  */
 
 enum eval_result_type
@@ -409,7 +439,13 @@ compile_bytecodes (struct agent_expr *aexpr)
       return expr_eval_empty_expression;
     }
 
-  bytecode_address_table = NULL;
+  /* Free the table of the last compilation.  */
+  while (bytecode_address_table != NULL)
+    {
+      aentry = bytecode_address_table;
+      bytecode_address_table = aentry->next;
+      free (aentry);
+    }
 
   while (!done)
     {
@@ -789,6 +825,173 @@ compile_bytecodes (struct agent_expr *aexpr)
   return expr_eval_no_error;
 }
 
+/* Compilation of agent expressions for gdbserver itself, used for
+   breakpoint conditions evaluated on the target.  */
+
+struct compiled_agent_expr
+{
+  /* The mapping holding the code, and its size.  */
+  unsigned char *code;
+  size_t size;
+};
+
+typedef enum eval_result_type (*compiled_agent_expr_fn) (struct regcache *,
+							  ULONGEST *);
+
+int emit_for_gdbserver;
+
+/* The end of the mapping compile_agent_expr is filling.  */
+static CORE_ADDR emit_code_limit;
+
+void
+write_insns (CORE_ADDR to, const unsigned char *buf, size_t len)
+{
+  if (!emit_for_gdbserver)
+    write_inferior_memory (to, buf, len);
+  else if (to + len > emit_code_limit)
+    emit_error = 1;
+  else
+    memcpy ((unsigned char *) (uintptr_t) to, buf, len);
+}
+
+/* Return the SIZE byte integer in target order at BYTES.  */
+
+static ULONGEST
+agent_value_from_bytes (const unsigned char *bytes, int size)
+{
+  union
+  {
+    unsigned char bytes[8];
+    unsigned char u8;
+    unsigned short u16;
+    unsigned int u32;
+    ULONGEST u64;
+  } cnv;
+
+  memcpy (cnv.bytes, bytes, size);
+  switch (size)
+    {
+    case 1:
+      return cnv.u8;
+    case 2:
+      return cnv.u16;
+    case 4:
+      return cnv.u32;
+    case 8:
+      return cnv.u64;
+    default:
+      internal_error (__FILE__, __LINE__, "unhandled value size");
+    }
+}
+
+ULONGEST
+gdbserver_agent_get_reg (struct regcache *regcache, int regnum)
+{
+  unsigned char buf[8];
+  int size = register_size (regcache->tdesc, regnum);
+
+  if (size > sizeof (buf))
+    internal_error (__FILE__, __LINE__, "unhandled register size");
+
+  collect_register (regcache, regnum, buf);
+  return agent_value_from_bytes (buf, size);
+}
+
+ULONGEST
+gdbserver_agent_read_memory (CORE_ADDR addr, int size)
+{
+  unsigned char buf[8];
+
+  /* Like the interpreter, ignore errors.  Unreadable memory reads as
+     zero.  */
+  memset (buf, 0, sizeof (buf));
+  read_inferior_memory (addr, buf, size);
+  return agent_value_from_bytes (buf, size);
+}
+
+/* No operation compiles to more than this many bytes of code.  */
+#define MAX_COMPILED_OP_SIZE 64
+
+struct compiled_agent_expr *
+compile_agent_expr (struct agent_expr *aexpr)
+{
+#ifdef HAVE_SYS_MMAN_H
+  struct compiled_agent_expr *cexpr;
+  enum eval_result_type err;
+  unsigned char *code;
+  size_t size;
+
+  emit_for_gdbserver = 1;
+  if (target_emit_ops () == NULL)
+    {
+      emit_for_gdbserver = 0;
+      return NULL;
+    }
+
+  /* Each operation takes at least one byte of bytecode, and the
+     prologue and epilogue make one more.  */
+  size = (aexpr->length + 1) * MAX_COMPILED_OP_SIZE;
+  code = mmap (NULL, size, PROT_READ | PROT_WRITE,
+	       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED)
+    {
+      emit_for_gdbserver = 0;
+      return NULL;
+    }
+
+  current_insn_ptr = (CORE_ADDR) (uintptr_t) code;
+  emit_code_limit = current_insn_ptr + size;
+
+  emit_error = 0;
+  emit_prologue ();
+  err = compile_bytecodes (aexpr);
+  if (err == expr_eval_no_error)
+    {
+      emit_epilogue ();
+      if (emit_error)
+	err = expr_eval_unhandled_opcode;
+    }
+
+  emit_for_gdbserver = 0;
+
+  /* Only make the code executable once it is complete.  */
+  if (err != expr_eval_no_error
+      || mprotect (code, size, PROT_READ | PROT_EXEC) != 0)
+    {
+      ax_debug ("Cannot compile agent expression for gdbserver, "
+		"error code %d", err);
+      munmap (code, size);
+      return NULL;
+    }
+
+  cexpr = xmalloc (sizeof (*cexpr));
+  cexpr->code = code;
+  cexpr->size = size;
+  return cexpr;
+#else
+  return NULL;
+#endif
+}
+
+enum eval_result_type
+run_compiled_agent_expr (struct compiled_agent_expr *cexpr,
+			 struct regcache *regcache, ULONGEST *rslt)
+{
+  compiled_agent_expr_fn fn;
+
+  fn = (compiled_agent_expr_fn) (uintptr_t) cexpr->code;
+  return fn (regcache, rslt);
+}
+
+void
+free_compiled_agent_expr (struct compiled_agent_expr *cexpr)
+{
+#ifdef HAVE_SYS_MMAN_H
+  munmap (cexpr->code, cexpr->size);
+#endif
+  free (cexpr);
+}
+
 #endif
 
 /* Make printf-type calls using arguments supplied from the host.  We
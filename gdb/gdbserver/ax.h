@@ -65,6 +65,42 @@ char *gdb_unparse_agent_expr (struct agent_expr *aexpr);
 void emit_prologue (void);
 void emit_epilogue (void);
 enum eval_result_type compile_bytecodes (struct agent_expr *aexpr);
+
+/* Return nonzero if AEXPR reads or writes trace state variables.  */
+int agent_expr_uses_tsvs (struct agent_expr *aexpr);
+
+/* Nonzero while compile_bytecodes builds code for gdbserver itself to
+   run, rather than for the in-process agent.  That code is stored in
+   gdbserver's own memory, and reads the inferior's registers and
+   memory through gdbserver_agent_get_reg and
+   gdbserver_agent_read_memory.  */
+extern int emit_for_gdbserver;
+
+/* Store the LEN bytes of code at BUF at TO, in the inferior, or in
+   gdbserver's memory if emit_for_gdbserver.  */
+void write_insns (CORE_ADDR to, const unsigned char *buf, size_t len);
+
+/* Return the value of register REGNUM in REGCACHE, and of the SIZE
+   bytes of inferior memory at ADDR.  Called by the code compiled for
+   gdbserver.  */
+ULONGEST gdbserver_agent_get_reg (struct regcache *regcache, int regnum);
+ULONGEST gdbserver_agent_read_memory (CORE_ADDR addr, int size);
+
+/* An agent expression compiled to native code run by gdbserver.  */
+struct compiled_agent_expr;
+
+/* Compile AEXPR to native code for gdbserver to run.  Return NULL if
+   the target cannot compile code for gdbserver, or AEXPR uses
+   operations the compiler does not handle.  */
+struct compiled_agent_expr *compile_agent_expr (struct agent_expr *aexpr);
+
+/* Run the code CEXPR with the registers in REGCACHE, and store the
+   value of the expression in *RSLT.  */
+enum eval_result_type
+  run_compiled_agent_expr (struct compiled_agent_expr *cexpr,
+			   struct regcache *regcache, ULONGEST *rslt);
+
+void free_compiled_agent_expr (struct compiled_agent_expr *cexpr);
 #endif
 
 /* The context when evaluating agent expression.  */
@@ -36,6 +36,10 @@
 
 #include <unistd.h>
 
+#ifdef HAVE_EPOLL_CREATE1
+#include <sys/epoll.h>
+#endif
+
 typedef struct gdb_event gdb_event;
 typedef int (event_handler_func) (gdb_fildes_t);
 
@@ -121,6 +125,63 @@ static struct
   }
 gdb_notifier;
 
+#ifdef HAVE_EPOLL_CREATE1
+/* Do we wait with epoll instead of select?  epoll returns only the
+   descriptors that are ready, so a wakeup does not cost a walk over
+   every registered one.  If epoll cannot watch some descriptor, we go
+   back to select for good; the select masks are kept up to date
+   either way.  */
+static int use_epoll = 1;
+
+/* The epoll instance, or -1 if it has not been created yet.  */
+static int epoll_fd = -1;
+
+/* Buffer for the results of epoll_wait, and its size.  */
+static struct epoll_event *epoll_events;
+static int num_epoll_events;
+
+/* Watch FILE_PTR's descriptor with epoll, for the events in its
+   mask.  */
+
+static void
+epoll_watch_file (file_handler *file_ptr)
+{
+  struct epoll_event event;
+
+  if (!use_epoll)
+    return;
+
+  if (epoll_fd == -1)
+    {
+      epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+      if (epoll_fd == -1)
+	{
+	  use_epoll = 0;
+	  return;
+	}
+    }
+
+  memset (&event, 0, sizeof (event));
+  if (file_ptr->mask & GDB_READABLE)
+    event.events |= EPOLLIN;
+  if (file_ptr->mask & GDB_WRITABLE)
+    event.events |= EPOLLOUT;
+  if (file_ptr->mask & GDB_EXCEPTION)
+    event.events |= EPOLLPRI;
+  event.data.ptr = file_ptr;
+  if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, file_ptr->fd, &event) == 0
+      || (errno == EEXIST
+	  && epoll_ctl (epoll_fd, EPOLL_CTL_MOD, file_ptr->fd, &event) == 0))
+    return;
+
+  /* Typically the descriptor is a regular file or /dev/null, which
+     epoll refuses with EPERM.  */
+  close (epoll_fd);
+  epoll_fd = -1;
+  use_epoll = 0;
+}
+#endif
+
 /* Callbacks are just routines that are executed before waiting for the
    next event.  In GDB this is struct gdb_timer.  We don't need timers
    so rather than copy all that complexity in gdbserver, we provide what
@@ -322,6 +383,10 @@ create_file_handler (gdb_fildes_t fd, int mask, handler_func *proc,
   file_ptr->proc = proc;
   file_ptr->client_data = client_data;
   file_ptr->mask = mask;
+
+#ifdef HAVE_EPOLL_CREATE1
+  epoll_watch_file (file_ptr);
+#endif
 }
 
 /* Wrapper function for create_file_handler.  */
@@ -353,6 +418,18 @@ delete_file_handler (gdb_fildes_t fd)
   if (file_ptr == NULL)
     return;
 
+#ifdef HAVE_EPOLL_CREATE1
+  /* FD may already have been closed, which removes it from the epoll
+     set by itself, so ignore errors.  */
+  if (use_epoll && epoll_fd != -1)
+    {
+      struct epoll_event event;
+
+      memset (&event, 0, sizeof (event));
+      epoll_ctl (epoll_fd, EPOLL_CTL_DEL, fd, &event);
+    }
+#endif
+
   if (file_ptr->mask & GDB_READABLE)
     FD_CLR (fd, &gdb_notifier.check_masks[0]);
   if (file_ptr->mask & GDB_WRITABLE)
@@ -458,6 +535,21 @@ create_file_event (gdb_fildes_t fd)
   return file_event_ptr;
 }
 
+/* Record that FILE_PTR saw the events in MASK, and queue an event for
+   it unless one is already pending.  */
+
+static void
+mark_file_ready (file_handler *file_ptr, int mask)
+{
+  if (file_ptr->ready_mask == 0)
+    {
+      gdb_event *file_event_ptr = create_file_event (file_ptr->fd);
+
+      QUEUE_enque (gdb_event_p, event_queue, file_event_ptr);
+    }
+  file_ptr->ready_mask = mask;
+}
+
 /* Called by do_one_event to wait for new events on the monitored file
    descriptors.  Queue file events as they are detected by the poll.
    If there are no events, this function will block in the call to
@@ -477,6 +569,48 @@ wait_for_event (void)
   if (gdb_notifier.num_fds == 0)
     return -1;
 
+#ifdef HAVE_EPOLL_CREATE1
+  if (use_epoll)
+    {
+      int i;
+
+      if (num_epoll_events < gdb_notifier.num_fds)
+	{
+	  num_epoll_events = gdb_notifier.num_fds;
+	  epoll_events = xrealloc (epoll_events,
+				   (num_epoll_events
+				    * sizeof (struct epoll_event)));
+	}
+
+      num_found = epoll_wait (epoll_fd, epoll_events, num_epoll_events, -1);
+
+      /* Dont print anything if we got a signal, let gdb handle it.  */
+      if (num_found == -1 && errno != EINTR)
+	perror_with_name ("epoll_wait");
+
+      /* A hangup or error makes the descriptor readable, as it would
+	 with select.  */
+      for (i = 0; i < num_found; i++)
+	{
+	  int mask = 0;
+
+	  file_ptr = epoll_events[i].data.ptr;
+	  if (epoll_events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+	    mask |= GDB_READABLE;
+	  if (epoll_events[i].events & EPOLLOUT)
+	    mask |= GDB_WRITABLE;
+	  if (epoll_events[i].events & EPOLLPRI)
+	    mask |= GDB_EXCEPTION;
+
+	  mask &= file_ptr->mask;
+	  if (mask != 0)
+	    mark_file_ready (file_ptr, mask);
+	}
+
+      return 0;
+    }
+#endif
+
   gdb_notifier.ready_masks[0] = gdb_notifier.check_masks[0];
   gdb_notifier.ready_masks[1] = gdb_notifier.check_masks[1];
   gdb_notifier.ready_masks[2] = gdb_notifier.check_masks[2];
@@ -520,16 +654,7 @@ wait_for_event (void)
       else
 	num_found--;
 
-      /* Enqueue an event only if this is still a new event for this
-	 fd.  */
-
-      if (file_ptr->ready_mask == 0)
-	{
-	  gdb_event *file_event_ptr = create_file_event (file_ptr->fd);
-
-	  QUEUE_enque (gdb_event_p, event_queue, file_event_ptr);
-	}
-      file_ptr->ready_mask = mask;
+      mark_file_ready (file_ptr, mask);
     }
 
   return 0;
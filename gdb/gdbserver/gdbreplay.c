@@ -412,6 +412,28 @@ play (FILE *fp)
     }
 }
 
+/* Number of milliseconds to wait before replaying each reply, to
+   simulate the latency of a slow link.  */
+
+static int reply_delay;
+
+/* Wait REPLY_DELAY milliseconds.  */
+
+static void
+delay_reply (void)
+{
+  if (reply_delay <= 0)
+    return;
+
+#ifdef USE_WIN32API
+  Sleep (reply_delay);
+#else
+  if (reply_delay >= 1000)
+    sleep (reply_delay / 1000);
+  usleep ((reply_delay % 1000) * 1000);
+#endif
+}
+
 static void
 gdbreplay_version (void)
 {
@@ -426,7 +448,8 @@ gdbreplay_version (void)
 static void
 gdbreplay_usage (FILE *stream)
 {
-  fprintf (stream, "Usage:\tgdbreplay <logfile> <host:port>\n");
+  fprintf (stream,
+	   "Usage:\tgdbreplay [--delay MSECS] <logfile> <host:port>\n");
   if (REPORT_BUGS_TO[0] && stream == stdout)
     fprintf (stream, "Report bugs to \"%s\".\n", REPORT_BUGS_TO);
 }
@@ -436,6 +459,7 @@ main (int argc, char *argv[])
 {
   FILE *fp;
   int ch;
+  int last_ch = 0;
 
   if (argc >= 2 && strcmp (argv[1], "--version") == 0)
     {
@@ -448,6 +472,20 @@ main (int argc, char *argv[])
       exit (0);
     }
 
+  if (argc >= 3 && strcmp (argv[1], "--delay") == 0)
+    {
+      char *end;
+
+      reply_delay = strtol (argv[2], &end, 10);
+      if (*argv[2] == '\0' || *end != '\0' || reply_delay < 0)
+	{
+	  fprintf (stderr, "Invalid delay `%s'\n", argv[2]);
+	  exit (1);
+	}
+      argc -= 2;
+      argv += 2;
+    }
+
   if (argc < 3)
     {
       gdbreplay_usage (stderr);
@@ -468,14 +506,20 @@ main (int argc, char *argv[])
 	  expect (fp);
 	  break;
 	case 'r':
-	  /* data sent from gdbreplay to gdb, play it */
+	  /* data sent from gdbreplay to gdb, play it.  The first reply
+	     following a request from gdb is delayed to model the round
+	     trip of a slow link.  */
+	  if (last_ch == 'w')
+	    delay_reply ();
 	  play (fp);
 	  break;
 	case 'c':
 	  /* Command executed by gdb */
 	  while ((ch = logchar (fp)) != EOL);
+	  ch = 'c';
 	  break;
 	}
+      last_ch = ch;
     }
   remote_close ();
   exit (0);
@@ -63,9 +63,18 @@ struct thread_info
 
   /* Branch trace target information for this thread.  */
   struct btrace_target_info *btrace;
+
+  /* The thread list generation this thread was added in.  */
+  unsigned long generation;
 };
 
 extern struct inferior_list all_threads;
+extern unsigned long threads_generation;
+
+int threads_delta_known_p (unsigned long since);
+void for_each_exited_thread_since (unsigned long since,
+				   void (*func) (ptid_t, void *),
+				   void *data);
 
 void remove_thread (struct thread_info *thread);
 void add_thread (ptid_t ptid, void *target_data);
@@ -21,6 +21,7 @@
 #include "server.h"
 #include "gdb/fileio.h"
 #include "hostio.h"
+#include "gdb_stat.h"
 
 #include <fcntl.h>
 #include <limits.h>
@@ -510,6 +511,90 @@ handle_readlink (char *own_buf, int *new_packet_len)
 #endif
 }
 
+/* Store NUM in the LEN bytes at FNUM, as struct fio_stat wants.  */
+
+static void
+host_to_fileio_number (ULONGEST num, char *fnum, int len)
+{
+  int i;
+
+  for (i = len - 1; i >= 0; i--)
+    {
+      fnum[i] = num & 0xff;
+      num >>= 8;
+    }
+}
+
+/* Convert the host stat buffer ST to *FST.  */
+
+static void
+host_to_fileio_stat (struct stat *st, struct fio_stat *fst)
+{
+  ULONGEST mode = st->st_mode & 0777;
+
+#define FIO_FIELD(field, value) \
+  host_to_fileio_number ((value), fst->field, sizeof (fst->field))
+
+  if (S_ISREG (st->st_mode))
+    mode |= FILEIO_S_IFREG;
+  else if (S_ISDIR (st->st_mode))
+    mode |= FILEIO_S_IFDIR;
+  else if (S_ISCHR (st->st_mode))
+    mode |= FILEIO_S_IFCHR;
+
+  FIO_FIELD (fst_dev, st->st_dev);
+  FIO_FIELD (fst_ino, st->st_ino);
+  FIO_FIELD (fst_mode, mode);
+  FIO_FIELD (fst_nlink, st->st_nlink);
+  FIO_FIELD (fst_uid, st->st_uid);
+  FIO_FIELD (fst_gid, st->st_gid);
+  FIO_FIELD (fst_rdev, st->st_rdev);
+  FIO_FIELD (fst_size, st->st_size);
+  /* Not all hosts have these; GDB does not use them.  */
+  FIO_FIELD (fst_blksize, 512);
+  FIO_FIELD (fst_blocks, (st->st_size + 511) / 512);
+  FIO_FIELD (fst_atime, st->st_atime);
+  FIO_FIELD (fst_mtime, st->st_mtime);
+  FIO_FIELD (fst_ctime, st->st_ctime);
+
+#undef FIO_FIELD
+}
+
+static void
+handle_fstat (char *own_buf, int *new_packet_len)
+{
+  struct stat st;
+  struct fio_stat fst;
+  char *p;
+  int fd, bytes_sent;
+
+  p = own_buf + strlen ("vFile:fstat:");
+
+  if (require_int (&p, &fd)
+      || require_valid_fd (fd)
+      || require_end (p))
+    {
+      hostio_packet_error (own_buf);
+      return;
+    }
+
+  if (fstat (fd, &st) == -1)
+    {
+      hostio_error (own_buf);
+      return;
+    }
+
+  host_to_fileio_stat (&st, &fst);
+
+  bytes_sent = hostio_reply_with_data (own_buf, (char *) &fst, sizeof (fst),
+				       new_packet_len);
+
+  /* If the response does not fit into a single packet, do not attempt
+     to return a partial response, but simply fail.  */
+  if (bytes_sent < sizeof (fst))
+    write_enn (own_buf);
+}
+
 /* Handle all the 'F' file transfer packets.  */
 
 int
@@ -527,6 +612,8 @@ handle_vFile (char *own_buf, int packet_len, int *new_packet_len)
     handle_unlink (own_buf);
   else if (strncmp (own_buf, "vFile:readlink:", 15) == 0)
     handle_readlink (own_buf, new_packet_len);
+  else if (strncmp (own_buf, "vFile:fstat:", 12) == 0)
+    handle_fstat (own_buf, new_packet_len);
   else
     return 0;
 
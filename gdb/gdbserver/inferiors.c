@@ -29,18 +29,109 @@ struct inferior_list all_threads;
 
 struct thread_info *current_inferior;
 
+/* The generation of the thread list, bumped whenever a thread is
+   added or removed.  GDB can ask for the threads added and removed
+   since a generation it saw, instead of the whole list.  */
+unsigned long threads_generation;
+
+/* The most recently removed threads, in a ring of
+   EXITED_THREADS_SIZE entries, with the generation of their
+   removal.  */
+
+#define EXITED_THREADS_SIZE 1024
+
+struct exited_thread
+{
+  ptid_t id;
+  unsigned long generation;
+};
+
+static struct exited_thread exited_threads[EXITED_THREADS_SIZE];
+
+/* The number of threads ever recorded in EXITED_THREADS.  */
+static unsigned long exited_threads_count;
+
+/* The changes up to this generation are no longer all known, as
+   removed threads were dropped from EXITED_THREADS or the whole list
+   was cleared.  */
+static unsigned long threads_delta_horizon;
+
 #define get_thread(inf) ((struct thread_info *)(inf))
 
+/* The initial number of buckets of a list's hash table.  Must be a
+   power of 2.  */
+#define INFERIOR_HASH_INITIAL_SIZE 64
+
+/* Return the hash table key of ID.  */
+
+static unsigned long
+inferior_hash_key (ptid_t id)
+{
+  long lwp = ptid_get_lwp (id);
+
+  return lwp != 0 ? lwp : ptid_get_pid (id);
+}
+
+/* Return the bucket of LIST holding the entries whose ids have hash
+   key KEY.  */
+
+static struct inferior_list_entry **
+inferior_hash_bucket (struct inferior_list *list, unsigned long key)
+{
+  return &list->buckets[key & (list->num_buckets - 1)];
+}
+
+/* Add ENTRY to the hash table of LIST.  */
+
+static void
+inferior_hash_insert (struct inferior_list *list,
+		      struct inferior_list_entry *entry)
+{
+  struct inferior_list_entry **bucket;
+
+  bucket = inferior_hash_bucket (list, inferior_hash_key (entry->id));
+  entry->hash_next = *bucket;
+  *bucket = entry;
+}
+
+/* Make the hash table of LIST big enough for one more entry, keeping
+   at most two entries per bucket on average.  */
+
+static void
+inferior_hash_grow (struct inferior_list *list)
+{
+  struct inferior_list_entry *entry;
+
+  if (list->count < 2 * list->num_buckets)
+    return;
+
+  free (list->buckets);
+  if (list->num_buckets == 0)
+    list->num_buckets = INFERIOR_HASH_INITIAL_SIZE;
+  else
+    list->num_buckets *= 2;
+  list->buckets = xcalloc (list->num_buckets, sizeof (list->buckets[0]));
+
+  for (entry = list->head; entry != NULL; entry = entry->next)
+    inferior_hash_insert (list, entry);
+}
+
 void
 add_inferior_to_list (struct inferior_list *list,
 		      struct inferior_list_entry *new_inferior)
 {
+  inferior_hash_grow (list);
+
   new_inferior->next = NULL;
+  new_inferior->prev = list->tail;
   if (list->tail != NULL)
     list->tail->next = new_inferior;
   else
     list->head = new_inferior;
   list->tail = new_inferior;
+
+  inferior_hash_insert (list, new_inferior);
+  list->count++;
 }
 
 /* Invoke ACTION for each inferior in LIST.  */
@@ -65,25 +156,40 @@ remove_inferior (struct inferior_list *list,
 {
   struct inferior_list_entry **cur;
 
-  if (list->head == entry)
-    {
-      list->head = entry->next;
-      if (list->tail == entry)
-	list->tail = list->head;
-      return;
-    }
+  if (list->num_buckets == 0)
+    return;
 
-  cur = &list->head;
-  while (*cur && (*cur)->next != entry)
-    cur = &(*cur)->next;
+  /* Find ENTRY in its bucket, which also tells whether it is in
+     LIST.  */
+  cur = inferior_hash_bucket (list, inferior_hash_key (entry->id));
+  while (*cur != NULL && *cur != entry)
+    cur = &(*cur)->hash_next;
 
   if (*cur == NULL)
     return;
 
-  (*cur)->next = entry->next;
+  *cur = entry->hash_next;
+
+  if (entry->prev != NULL)
+    entry->prev->next = entry->next;
+  else
+    list->head = entry->next;
+
+  if (entry->next != NULL)
+    entry->next->prev = entry->prev;
+  else
+    list->tail = entry->prev;
+
+  list->count--;
+}
+
+/* Empty LIST, without freeing its entries.  */
 
-  if (list->tail == entry)
-    list->tail = *cur;
+void
+clear_inferior_list (struct inferior_list *list)
+{
+  free (list->buckets);
+  memset (list, 0, sizeof (*list));
 }
 
 void
@@ -94,6 +200,7 @@ add_thread (ptid_t thread_id, void *target_data)
   memset (new_thread, 0, sizeof (*new_thread));
 
   new_thread->entry.id = thread_id;
+  new_thread->generation = ++threads_generation;
   new_thread->last_resume_kind = resume_continue;
   new_thread->last_status.kind = TARGET_WAITKIND_IGNORE;
 
@@ -108,14 +215,8 @@ add_thread (ptid_t thread_id, void *target_data)
 ptid_t
 thread_id_to_gdb_id (ptid_t thread_id)
 {
-  struct inferior_list_entry *inf = all_threads.head;
-
-  while (inf != NULL)
-    {
-      if (ptid_equal (inf->id, thread_id))
-	return thread_id;
-      inf = inf->next;
-    }
+  if (find_inferior_id (&all_threads, thread_id) != NULL)
+    return thread_id;
 
   return null_ptid;
 }
@@ -129,17 +230,7 @@ thread_to_gdb_id (struct thread_info *thread)
 struct thread_info *
 find_thread_ptid (ptid_t ptid)
 {
-  struct inferior_list_entry *inf = all_threads.head;
-
-  while (inf != NULL)
-    {
-      struct thread_info *thread = get_thread (inf);
-      if (ptid_equal (thread->entry.id, ptid))
-	return thread;
-      inf = inf->next;
-    }
-
-  return NULL;
+  return get_thread (find_inferior_id (&all_threads, ptid));
 }
 
 ptid_t
@@ -161,13 +252,51 @@ free_one_thread (struct inferior_list_entry *inf)
 void
 remove_thread (struct thread_info *thread)
 {
+  struct exited_thread *exited;
+
   if (thread->btrace != NULL)
     target_disable_btrace (thread->btrace);
 
+  exited = &exited_threads[exited_threads_count % EXITED_THREADS_SIZE];
+  if (exited_threads_count >= EXITED_THREADS_SIZE)
+    threads_delta_horizon = exited->generation;
+  exited->id = thread_to_gdb_id (thread);
+  exited->generation = ++threads_generation;
+  exited_threads_count++;
+
   remove_inferior (&all_threads, (struct inferior_list_entry *) thread);
   free_one_thread (&thread->entry);
 }
 
+/* Return nonzero if the threads added and removed since generation
+   SINCE are all known.  */
+
+int
+threads_delta_known_p (unsigned long since)
+{
+  return since >= threads_delta_horizon && since <= threads_generation;
+}
+
+/* Call FUNC with the GDB id of each thread removed after generation
+   SINCE, and DATA.  */
+
+void
+for_each_exited_thread_since (unsigned long since,
+			      void (*func) (ptid_t, void *), void *data)
+{
+  unsigned long i;
+
+  i = (exited_threads_count > EXITED_THREADS_SIZE
+       ? exited_threads_count - EXITED_THREADS_SIZE : 0);
+  for (; i < exited_threads_count; i++)
+    {
+      struct exited_thread *exited = &exited_threads[i % EXITED_THREADS_SIZE];
+
+      if (exited->generation > since)
+	(*func) (exited->id, data);
+    }
+}
+
 /* Find the first inferior_list_entry E in LIST for which FUNC (E, ARG)
    returns non-zero.  If no entry is found then return NULL.  */
 
@@ -193,13 +322,39 @@ find_inferior (struct inferior_list *list,
 struct inferior_list_entry *
 find_inferior_id (struct inferior_list *list, ptid_t id)
 {
-  struct inferior_list_entry *inf = list->head;
+  struct inferior_list_entry *inf;
+
+  if (list->num_buckets == 0)
+    return NULL;
 
+  inf = *inferior_hash_bucket (list, inferior_hash_key (id));
   while (inf != NULL)
     {
       if (ptid_equal (inf->id, id))
 	return inf;
-      inf = inf->next;
+      inf = inf->hash_next;
+    }
+
+  return NULL;
+}
+
+/* Find the entry of LIST whose id has lwp LWP.  If no entry is found
+   then return NULL.  */
+
+struct inferior_list_entry *
+find_inferior_lwp (struct inferior_list *list, long lwp)
+{
+  struct inferior_list_entry *inf;
+
+  if (list->num_buckets == 0)
+    return NULL;
+
+  inf = *inferior_hash_bucket (list, lwp);
+  while (inf != NULL)
+    {
+      if (ptid_get_lwp (inf->id) == lwp)
+	return inf;
+      inf = inf->hash_next;
     }
 
   return NULL;
@@ -229,14 +384,12 @@ set_inferior_regcache_data (struct thread_info *inferior, void *data)
   inferior->regcache_data = data;
 }
 
-#define clear_list(LIST) \
-  do { (LIST)->head = (LIST)->tail = NULL; } while (0)
-
 void
 clear_inferiors (void)
 {
   for_each_inferior (&all_threads, free_one_thread);
-  clear_list (&all_threads);
+  clear_inferior_list (&all_threads);
+  threads_delta_horizon = ++threads_generation;
 
   clear_dlls ();
 
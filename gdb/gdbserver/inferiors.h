@@ -25,11 +25,27 @@ struct inferior_list
 {
   struct inferior_list_entry *head;
   struct inferior_list_entry *tail;
+
+  /* A hash table of the entries, so that finding an entry by id does
+     not walk the whole list.  Entries are hashed by the lwp of their
+     id, or by the pid if the lwp is zero.  NUM_BUCKETS is zero until
+     the first entry is added.  */
+  struct inferior_list_entry **buckets;
+  unsigned int num_buckets;
+
+  /* The number of entries.  */
+  unsigned int count;
 };
 struct inferior_list_entry
 {
   ptid_t id;
   struct inferior_list_entry *next;
+
+  /* The previous entry in the list.  */
+  struct inferior_list_entry *prev;
+
+  /* The next entry in the same bucket of the list's hash table.  */
+  struct inferior_list_entry *hash_next;
 };
 
 struct thread_info;
@@ -87,6 +103,7 @@ void for_each_inferior (struct inferior_list *list,
 extern struct thread_info *current_inferior;
 void remove_inferior (struct inferior_list *list,
 		      struct inferior_list_entry *entry);
+void clear_inferior_list (struct inferior_list *list);
 
 struct process_info *add_process (int pid, int attached);
 void remove_process (struct process_info *process);
@@ -106,6 +123,8 @@ struct inferior_list_entry *find_inferior
       void *arg);
 struct inferior_list_entry *find_inferior_id (struct inferior_list *list,
 					      ptid_t id);
+struct inferior_list_entry *find_inferior_lwp (struct inferior_list *list,
+					       long lwp);
 void *inferior_target_data (struct thread_info *);
 void set_inferior_target_data (struct thread_info *, void *);
 void *inferior_regcache_data (struct thread_info *);
@@ -19,6 +19,7 @@
    along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
 
 #include "server.h"
+#include <stdint.h>
 #include "tracepoint.h"
 
 /* Defined in auto-generated file amd64-linux.c.  */
@@ -166,6 +167,18 @@ supply_static_tracepoint_registers (struct regcache *regcache,
 
 #endif /* HAVE_UST */
 
+/* The thread area is the address of the thread control block, which
+   the pointer at the start of the %fs segment points to.  */
+
+CORE_ADDR
+current_thread_area (void)
+{
+  uintptr_t area;
+
+  asm ("mov %%fs:0,%0" : "=r" (area));
+  return area;
+}
+
 void
 initialize_low_tracepoint (void)
 {
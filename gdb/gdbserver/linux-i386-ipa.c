@@ -248,6 +248,18 @@ initialize_fast_tracepoint_trampoline_buffer (void)
     }
 }
 
+/* The thread area is the address of the thread control block, which
+   the pointer at the start of the %gs segment points to.  */
+
+CORE_ADDR
+current_thread_area (void)
+{
+  uintptr_t area;
+
+  asm ("mov %%gs:0,%0" : "=r" (area));
+  return area;
+}
+
 void
 initialize_low_tracepoint (void)
 {
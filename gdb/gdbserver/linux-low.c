@@ -20,6 +20,7 @@
 #include "linux-low.h"
 #include "linux-osdata.h"
 #include "agent.h"
+#include "tdesc.h"
 
 #include "nat/linux-nat.h"
 #include "nat/linux-waitpid.h"
@@ -149,6 +150,30 @@ typedef struct
 
 struct inferior_list all_lwps;
 
+/* The number of lwps in ``all_lwps'' with a status pending, so that
+   waiting for an event need not look at every lwp when none has one.
+   Only set_status_pending_p changes lwp_info.status_pending_p, to
+   keep this and the count of each process up to date.  */
+
+static int num_lwps_status_pending;
+
+/* Set whether LWP has a status pending.  */
+
+static void
+set_status_pending_p (struct lwp_info *lwp, int pending)
+{
+  pending = (pending != 0);
+  if (lwp->status_pending_p != pending)
+    {
+      struct process_info *proc = find_process_pid (pid_of (lwp));
+
+      num_lwps_status_pending += pending ? 1 : -1;
+      if (proc != NULL)
+	proc->private->num_lwps_status_pending += pending ? 1 : -1;
+    }
+  lwp->status_pending_p = pending;
+}
+
 /* A list of all unknown processes which receive stop signals.  Some
    other process will presumably claim each of these as forked
    children momentarily.  */
@@ -346,6 +371,7 @@ linux_pid_exe_is_elf_64_file (int pid, unsigned int *machine)
 static void
 delete_lwp (struct lwp_info *lwp)
 {
+  set_status_pending_p (lwp, 0);
   remove_thread (get_lwp_thread (lwp));
   remove_inferior (&all_lwps, &lwp->head);
   free (lwp->arch_private);
@@ -366,6 +392,8 @@ linux_add_process (int pid, int attached)
   /* Set the arch when the first LWP stops.  */
   proc->private->new_inferior = 1;
 
+  proc->private->mem_fd = -1;
+
   if (the_low_target.new_process != NULL)
     proc->private->arch_private = the_low_target.new_process ();
 
@@ -439,7 +467,7 @@ handle_extended_wait (struct lwp_info *event_child, int wstat)
 	  if (stopping_threads != NOT_STOPPING_THREADS)
 	    {
 	      new_lwp->stop_pc = get_stop_pc (new_lwp);
-	      new_lwp->status_pending_p = 1;
+	      set_status_pending_p (new_lwp, 1);
 	      new_lwp->status_pending = status;
 	    }
 	  else
@@ -1186,6 +1214,9 @@ linux_mourn (struct process_info *process)
 
   /* Freeing all private data.  */
   priv = process->private;
+  if (priv->mem_fd != -1)
+    close (priv->mem_fd);
+  free (priv->regset_map);
   free (priv->arch_private);
   free (priv);
   process->private = NULL;
@@ -1245,27 +1276,15 @@ status_pending_p_callback (struct inferior_list_entry *entry, void *arg)
   return lwp->status_pending_p;
 }
 
-static int
-same_lwp (struct inferior_list_entry *entry, void *data)
+struct lwp_info *
+find_lwp_pid (ptid_t ptid)
 {
-  ptid_t ptid = *(ptid_t *) data;
-  int lwp;
+  long lwp = ptid_get_lwp (ptid);
 
-  if (ptid_get_lwp (ptid) != 0)
-    lwp = ptid_get_lwp (ptid);
-  else
+  if (lwp == 0)
     lwp = ptid_get_pid (ptid);
 
-  if (ptid_get_lwp (entry->id) == lwp)
-    return 1;
-
-  return 0;
-}
-
-struct lwp_info *
-find_lwp_pid (ptid_t ptid)
-{
-  return (struct lwp_info*) find_inferior (&all_lwps, same_lwp, &ptid);
+  return (struct lwp_info *) find_inferior_lwp (&all_lwps, lwp);
 }
 
 static struct lwp_info *
@@ -1551,6 +1570,7 @@ Checking whether LWP %ld needs to move out of the jump pad...it does\n",
 	    {
 	      siginfo_t info;
 	      struct regcache *regcache;
+	      CORE_ADDR thread_area;
 
 	      /* The si_addr on a few signals references the address
 		 of the faulting instruction.  Adjust that as
@@ -1574,9 +1594,11 @@ Checking whether LWP %ld needs to move out of the jump pad...it does\n",
 	      (*the_low_target.set_pc) (regcache, status.tpoint_addr);
 	      lwp->stop_pc = status.tpoint_addr;
 
-	      /* Cancel any fast tracepoint lock this thread was
-		 holding.  */
-	      force_unlock_trace_buffer ();
+	      /* Cancel the fast tracepoint collection this thread was
+		 doing.  */
+	      if ((*the_low_target.get_thread_area) (lwpid_of (lwp),
+						     &thread_area) == 0)
+		force_unlock_trace_buffer (thread_area);
 	    }
 
 	  if (lwp->exit_jump_pad_bkpt != NULL)
@@ -1766,6 +1788,77 @@ cancel_breakpoint (struct lwp_info *lwp)
    being stepped.  */
 ptid_t step_over_bkpt;
 
+/* Collect all the events the kernel has for our children, without
+   blocking, and leave each one pending in its lwp, to be reported
+   later.  Events that are never reported, such as the exit of a
+   thread that isn't the last of its process, extended waits and
+   expected SIGSTOPs, are handled right away, as linux_wait_for_event
+   does.  With many processes, this takes every event that is ready
+   in one pass, instead of one per call.  */
+
+static void
+linux_collect_pending_events (void)
+{
+  struct lwp_info *event_child;
+  int wstat;
+
+  while ((event_child = linux_wait_for_lwp (minus_one_ptid, &wstat,
+					    WNOHANG)) != NULL)
+    {
+      struct thread_info *thread = get_lwp_thread (event_child);
+
+      if (! WIFSTOPPED (wstat))
+	{
+	  if (last_thread_of_process_p (thread))
+	    {
+	      /* Report the exit of the process later.  */
+	      mark_lwp_dead (event_child, wstat);
+	      continue;
+	    }
+
+	  if (debug_threads)
+	    fprintf (stderr, "LWP %ld exiting\n", lwpid_of (event_child));
+
+	  delete_lwp (event_child);
+	  if (current_inferior == thread)
+	    current_inferior = (non_stop
+				? NULL
+				: (struct thread_info *) all_threads.head);
+	  continue;
+	}
+
+      if (event_child->must_set_ptrace_flags)
+	{
+	  linux_enable_event_reporting (lwpid_of (event_child));
+	  event_child->must_set_ptrace_flags = 0;
+	}
+
+      if (WSTOPSIG (wstat) == SIGTRAP && wstat >> 16 != 0)
+	{
+	  handle_extended_wait (event_child, wstat);
+	  continue;
+	}
+
+      if (WSTOPSIG (wstat) == SIGSTOP && event_child->stop_expected)
+	{
+	  if (debug_threads)
+	    fprintf (stderr, "Expected stop.\n");
+	  event_child->stop_expected = 0;
+
+	  if (thread->last_resume_kind != resume_stop
+	      && stopping_threads == NOT_STOPPING_THREADS)
+	    {
+	      linux_resume_one_lwp (event_child,
+				    event_child->stepping, 0, NULL);
+	      continue;
+	    }
+	}
+
+      set_status_pending_p (event_child, 1);
+      event_child->status_pending = wstat;
+    }
+}
+
 /* Wait for an event from child PID.  If PID is -1, wait for any
    child.  Store the stop status through the status pointer WSTAT.
    OPTIONS is passed to the waitpid call.  Return 0 if no child stop
@@ -1785,8 +1878,18 @@ linux_wait_for_event (ptid_t ptid, int *wstat, int options)
 
   if (ptid_equal (ptid, minus_one_ptid) || ptid_is_pid (ptid))
     {
-      event_child = (struct lwp_info *)
-	find_inferior (&all_lwps, status_pending_p_callback, &ptid);
+      struct process_info *proc = NULL;
+
+      linux_collect_pending_events ();
+
+      if (ptid_is_pid (ptid))
+	proc = find_process_pid (ptid_get_pid (ptid));
+
+      if (proc != NULL
+	  ? proc->private->num_lwps_status_pending > 0
+	  : num_lwps_status_pending > 0)
+	event_child = (struct lwp_info *)
+	  find_inferior (&all_lwps, status_pending_p_callback, &ptid);
       if (debug_threads && event_child)
 	fprintf (stderr, "Got a pending child %ld\n", lwpid_of (event_child));
     }
@@ -1800,7 +1903,7 @@ linux_wait_for_event (ptid_t ptid, int *wstat, int options)
 	{
 	  enqueue_one_deferred_signal (requested_child,
 				       &requested_child->status_pending);
-	  requested_child->status_pending_p = 0;
+	  set_status_pending_p (requested_child, 0);
 	  requested_child->status_pending = 0;
 	  linux_resume_one_lwp (requested_child, 0, 0, NULL);
 	}
@@ -1819,7 +1922,7 @@ linux_wait_for_event (ptid_t ptid, int *wstat, int options)
 	fprintf (stderr, "Got an event from pending child %ld (%04x)\n",
 		 lwpid_of (event_child), event_child->status_pending);
       *wstat = event_child->status_pending;
-      event_child->status_pending_p = 0;
+      set_status_pending_p (event_child, 0);
       event_child->status_pending = 0;
       current_inferior = get_lwp_thread (event_child);
       return lwpid_of (event_child);
@@ -1861,7 +1964,7 @@ linux_wait_for_event (ptid_t ptid, int *wstat, int options)
 	    mark_lwp_dead (event_child, *wstat);
 	  else
 	    {
-	      event_child->status_pending_p = 1;
+	      set_status_pending_p (event_child, 1);
 	      event_child->status_pending = *wstat;
 	    }
 	  continue;
@@ -2055,7 +2158,7 @@ cancel_breakpoints_callback (struct inferior_list_entry *entry, void *data)
       && !lp->stopped_by_watchpoint
       && cancel_breakpoint (lp))
     /* Throw away the SIGTRAP.  */
-    lp->status_pending_p = 0;
+    set_status_pending_p (lp, 0);
 
   return 0;
 }
@@ -2668,12 +2771,12 @@ Check if we're already there.\n",
 	 starvation.  */
       if (ptid_equal (ptid, minus_one_ptid))
 	{
-	  event_child->status_pending_p = 1;
+	  set_status_pending_p (event_child, 1);
 	  event_child->status_pending = w;
 
 	  select_event_lwp (&event_child);
 
-	  event_child->status_pending_p = 0;
+	  set_status_pending_p (event_child, 0);
 	  w = event_child->status_pending;
 	}
 
@@ -2889,7 +2992,7 @@ mark_lwp_dead (struct lwp_info *lwp, int wstat)
   lwp->dead = 1;
 
   /* Store the exit status for later.  */
-  lwp->status_pending_p = 1;
+  set_status_pending_p (lwp, 1);
   lwp->status_pending = wstat;
 
   /* Prevent trying to stop it.  */
@@ -2945,7 +3048,7 @@ wait_for_sigstop (struct inferior_list_entry *entry)
 	    fprintf (stderr, "LWP %ld stopped with non-sigstop status %06x\n",
 		     lwpid_of (lwp), wstat);
 
-	  lwp->status_pending_p = 1;
+	  set_status_pending_p (lwp, 1);
 	  lwp->status_pending = wstat;
 	}
     }
@@ -3038,7 +3141,7 @@ move_out_of_jump_pad_callback (struct inferior_list_entry *entry)
 
       if (wstat)
 	{
-	  lwp->status_pending_p = 0;
+	  set_status_pending_p (lwp, 0);
 	  enqueue_one_deferred_signal (lwp, wstat);
 
 	  if (debug_threads)
@@ -3354,7 +3457,7 @@ linux_set_resume_request (struct inferior_list_entry *entry, void *arg)
 	      && !lwp->status_pending_p
 	      && dequeue_one_deferred_signal (lwp, &lwp->status_pending))
 	    {
-	      lwp->status_pending_p = 1;
+	      set_status_pending_p (lwp, 1);
 
 	      if (debug_threads)
 		fprintf (stderr,
@@ -3770,7 +3873,7 @@ linux_resume (struct thread_resume *resume_info, size_t n)
      logic to each thread individually.  We consume all pending events
      before considering to start a step-over (in all-stop).  */
   any_pending = 0;
-  if (!non_stop)
+  if (!non_stop && num_lwps_status_pending > 0)
     find_inferior (&all_lwps, resume_status_pending_p, &any_pending);
 
   /* If there is a thread which would otherwise be resumed, which is
@@ -3994,70 +4097,131 @@ disable_regset (struct regsets_info *info, struct regset_info *regset)
   info->disabled_regsets[dr_offset] = 1;
 }
 
-static int
-regsets_fetch_inferior_registers (struct regsets_info *regsets_info,
-				  struct regcache *regcache)
+/* Return the regset of REGSETS_INFO that transfers register REGNO of
+   REGCACHE, or NULL if there is none that can be used.  */
+
+static struct regset_info *
+regset_of_register (struct regsets_info *regsets_info,
+		    struct regcache *regcache, int regno)
 {
+  struct process_info_private *priv = current_process ()->private;
+  const struct target_desc *tdesc = regcache->tdesc;
   struct regset_info *regset;
-  int saw_general_regs = 0;
-  int pid;
-  struct iovec iov;
-
-  regset = regsets_info->regsets;
 
-  pid = lwpid_of (get_thread_lwp (current_inferior));
-  while (regset->size >= 0)
+  if (priv->regset_map == NULL || priv->regset_map_tdesc != tdesc)
     {
-      void *buf, *data;
-      int nt_type, res;
+      struct regcache *scratch = new_register_cache (tdesc);
+      int i;
 
-      if (regset->size == 0 || regset_disabled (regsets_info, regset))
+      /* Find out which registers each regset supplies.  The regsets
+	 later in the array win, as they do when fetching them all.  */
+      free (priv->regset_map);
+      priv->regset_map = xmalloc (tdesc->num_registers
+				  * sizeof (priv->regset_map[0]));
+      for (i = 0; i < tdesc->num_registers; i++)
+	priv->regset_map[i] = -1;
+
+      for (regset = regsets_info->regsets; regset->size >= 0; regset++)
 	{
-	  regset ++;
-	  continue;
-	}
+	  void *buf;
 
-      buf = xmalloc (regset->size);
+	  if (regset->size == 0 || regset_disabled (regsets_info, regset))
+	    continue;
 
-      nt_type = regset->nt_type;
-      if (nt_type)
-	{
-	  iov.iov_base = buf;
-	  iov.iov_len = regset->size;
-	  data = (void *) &iov;
+	  memset (scratch->register_status, REG_VALID + 1,
+		  tdesc->num_registers);
+	  buf = xcalloc (1, regset->size);
+	  regset->store_function (scratch, buf);
+	  free (buf);
+
+	  for (i = 0; i < tdesc->num_registers; i++)
+	    if (scratch->register_status[i] != REG_VALID + 1)
+	      priv->regset_map[i] = regset - regsets_info->regsets;
 	}
-      else
-	data = buf;
+
+      free_register_cache (scratch);
+      priv->regset_map_tdesc = tdesc;
+    }
+
+  if (priv->regset_map[regno] < 0)
+    return NULL;
+
+  regset = &regsets_info->regsets[priv->regset_map[regno]];
+  if (regset->size <= 0 || regset_disabled (regsets_info, regset))
+    return NULL;
+  return regset;
+}
+
+/* Fetch REGSET of the current thread into REGCACHE.  Return 0 on
+   success, -1 on failure.  */
+
+static int
+fetch_regset (struct regsets_info *regsets_info, struct regset_info *regset,
+	      struct regcache *regcache)
+{
+  void *buf, *data;
+  int nt_type, res;
+  int pid;
+  struct iovec iov;
+
+  pid = lwpid_of (get_thread_lwp (current_inferior));
+  buf = xmalloc (regset->size);
+
+  nt_type = regset->nt_type;
+  if (nt_type)
+    {
+      iov.iov_base = buf;
+      iov.iov_len = regset->size;
+      data = (void *) &iov;
+    }
+  else
+    data = buf;
 
 #ifndef __sparc__
-      res = ptrace (regset->get_request, pid,
-		    (PTRACE_TYPE_ARG3) (long) nt_type, data);
+  res = ptrace (regset->get_request, pid,
+		(PTRACE_TYPE_ARG3) (long) nt_type, data);
 #else
-      res = ptrace (regset->get_request, pid, data, nt_type);
+  res = ptrace (regset->get_request, pid, data, nt_type);
 #endif
-      if (res < 0)
+  if (res < 0)
+    {
+      if (errno == EIO)
 	{
-	  if (errno == EIO)
-	    {
-	      /* If we get EIO on a regset, do not try it again for
-		 this process mode.  */
-	      disable_regset (regsets_info, regset);
-	      free (buf);
-	      continue;
-	    }
-	  else
-	    {
-	      char s[256];
-	      sprintf (s, "ptrace(regsets_fetch_inferior_registers) PID=%d",
-		       pid);
-	      perror (s);
-	    }
+	  /* If we get EIO on a regset, do not try it again for
+	     this process mode.  */
+	  disable_regset (regsets_info, regset);
+	  free (buf);
+	  return -1;
 	}
-      else if (regset->type == GENERAL_REGS)
+      else
+	{
+	  char s[256];
+	  sprintf (s, "ptrace(regsets_fetch_inferior_registers) PID=%d",
+		   pid);
+	  perror (s);
+	}
+    }
+  regset->store_function (regcache, buf);
+  free (buf);
+  return res < 0 ? -1 : 0;
+}
+
+static int
+regsets_fetch_inferior_registers (struct regsets_info *regsets_info,
+				  struct regcache *regcache)
+{
+  struct regset_info *regset;
+  int saw_general_regs = 0;
+
+  regset = regsets_info->regsets;
+
+  while (regset->size >= 0)
+    {
+      if (regset->size != 0 && !regset_disabled (regsets_info, regset)
+	  && fetch_regset (regsets_info, regset, regcache) == 0
+	  && regset->type == GENERAL_REGS)
 	saw_general_regs = 1;
-      regset->store_function (regcache, buf);
       regset ++;
-      free (buf);
     }
   if (saw_general_regs)
     return 0;
@@ -4065,6 +4229,22 @@ regsets_fetch_inferior_registers (struct regsets_info *regsets_info,
     return 1;
 }
 
+/* Fetch only the regset that transfers register REGNO into REGCACHE.
+   Return 0 on success, or 1 if all the registers must be fetched
+   instead.  */
+
+static int
+regsets_fetch_inferior_register (struct regsets_info *regsets_info,
+				 struct regcache *regcache, int regno)
+{
+  struct regset_info *regset;
+
+  regset = regset_of_register (regsets_info, regcache, regno);
+  if (regset != NULL && fetch_regset (regsets_info, regset, regcache) == 0)
+    return 0;
+  return 1;
+}
+
 static int
 regsets_store_inferior_registers (struct regsets_info *regsets_info,
 				  struct regcache *regcache)
@@ -4073,6 +4253,29 @@ regsets_store_inferior_registers (struct regsets_info *regsets_info,
   int saw_general_regs = 0;
   int pid;
   struct iovec iov;
+  char *dirty_regsets = NULL;
+
+  /* Only store the regsets with dirty registers.  */
+  if (regcache->register_dirty != NULL)
+    {
+      const struct target_desc *tdesc = regcache->tdesc;
+      int i;
+
+      dirty_regsets = alloca (regsets_info->num_regsets);
+      memset (dirty_regsets, 0, regsets_info->num_regsets);
+      for (i = 0; i < tdesc->num_registers; i++)
+	if (regcache->register_dirty[i])
+	  {
+	    regset = regset_of_register (regsets_info, regcache, i);
+	    if (regset == NULL)
+	      {
+		/* Play safe and store them all.  */
+		dirty_regsets = NULL;
+		break;
+	      }
+	    dirty_regsets[regset - regsets_info->regsets] = 1;
+	  }
+    }
 
   regset = regsets_info->regsets;
 
@@ -4088,6 +4291,15 @@ regsets_store_inferior_registers (struct regsets_info *regsets_info,
 	  continue;
 	}
 
+      if (dirty_regsets != NULL
+	  && !dirty_regsets[regset - regsets_info->regsets])
+	{
+	  if (regset->type == GENERAL_REGS)
+	    saw_general_regs = 1;
+	  regset ++;
+	  continue;
+	}
+
       buf = xmalloc (regset->size);
 
       /* First fill the buffer with the current register set contents,
@@ -4113,6 +4325,12 @@ regsets_store_inferior_registers (struct regsets_info *regsets_info,
 
       if (res == 0)
 	{
+	  /* The registers of this regset that were not fetched yet
+	     take their values from the buffer, so that only the dirty
+	     ones change.  */
+	  if (regcache->thread != NULL && !regcache->registers_valid)
+	    regset->store_function (regcache, buf);
+
 	  /* Then overlay our cached registers on that.  */
 	  regset->fill_function (regcache, buf);
 
@@ -4164,6 +4382,7 @@ regsets_store_inferior_registers (struct regsets_info *regsets_info,
 
 #define use_linux_regsets 0
 #define regsets_fetch_inferior_registers(regsets_info, regcache) 1
+#define regsets_fetch_inferior_register(regsets_info, regcache, regno) 1
 #define regsets_store_inferior_registers(regsets_info, regcache) 1
 
 #endif
@@ -4331,7 +4550,8 @@ usr_store_inferior_registers (const struct regs_info *regs_info,
   if (regno == -1)
     {
       for (regno = 0; regno < usr->num_regs; regno++)
-	if (all || !linux_register_in_regsets (regs_info, regno))
+	if ((all || !linux_register_in_regsets (regs_info, regno))
+	    && regcache_register_dirty_p (regcache, regno))
 	  store_register (usr, regcache, regno);
     }
   else
@@ -4372,8 +4592,13 @@ linux_fetch_registers (struct regcache *regcache, int regno)
 
       use_regsets = linux_register_in_regsets (regs_info, regno);
       if (use_regsets)
-	all = regsets_fetch_inferior_registers (regs_info->regsets_info,
-						regcache);
+	{
+	  if (regsets_fetch_inferior_register (regs_info->regsets_info,
+					       regcache, regno) == 0)
+	    return;
+	  all = regsets_fetch_inferior_registers (regs_info->regsets_info,
+						  regcache);
+	}
       if ((!use_regsets || all) && regs_info->usrregs != NULL)
 	usr_fetch_inferior_registers (regs_info, regcache, regno, 1);
     }
@@ -4405,59 +4630,135 @@ linux_store_registers (struct regcache *regcache, int regno)
 }
 
 
-/* Copy LEN bytes from inferior's memory starting at MEMADDR
-   to debugger memory starting at MYADDR.  */
+/* Read LEN bytes at MEMADDR into READBUF, or write LEN bytes from
+   WRITEBUF at MEMADDR, through the /proc/PID/mem file of the current
+   process.  The file is opened the first time it is needed and kept
+   open until the process is mourned.  Return the number of bytes
+   transferred, or -1 if the file cannot be used.  */
 
 static int
-linux_read_memory (CORE_ADDR memaddr, unsigned char *myaddr, int len)
+linux_proc_mem_xfer (CORE_ADDR memaddr, unsigned char *readbuf,
+		     const unsigned char *writebuf, int len)
 {
-  int pid = lwpid_of (get_thread_lwp (current_inferior));
-  register PTRACE_XFER_TYPE *buffer;
-  register CORE_ADDR addr;
-  register int count;
-  char filename[64];
-  register int i;
-  int ret;
-  int fd;
+  struct process_info_private *priv = current_process ()->private;
+  int attempt;
+  int bytes = -1;
 
-  /* Try using /proc.  Don't bother for one word.  */
-  if (len >= 3 * sizeof (long))
+  for (attempt = 0; attempt < 2; attempt++)
     {
-      int bytes;
-
-      /* We could keep this file open and cache it - possibly one per
-	 thread.  That requires some juggling, but is even faster.  */
-      sprintf (filename, "/proc/%d/mem", pid);
-      fd = open (filename, O_RDONLY | O_LARGEFILE);
-      if (fd == -1)
-	goto no_proc;
+      if (priv->mem_fd == -1)
+	{
+	  int pid = lwpid_of (get_thread_lwp (current_inferior));
+	  char filename[64];
+
+	  sprintf (filename, "/proc/%d/mem", pid);
+	  /* Writing to the file needs Linux 2.6.39 or later.  Reads
+	     work with older kernels too.  */
+	  priv->mem_fd = open (filename, O_RDWR | O_LARGEFILE);
+	  if (priv->mem_fd == -1)
+	    priv->mem_fd = open (filename, O_RDONLY | O_LARGEFILE);
+	  if (priv->mem_fd == -1)
+	    return -1;
+	}
 
       /* If pread64 is available, use it.  It's faster if the kernel
 	 supports it (only one syscall), and it's 64-bit safe even on
 	 32-bit platforms (for instance, SPARC debugging a SPARC64
-	 application).  */
+	 application).  Likewise for pwrite64.  */
+      if (readbuf != NULL)
+	{
 #ifdef HAVE_PREAD64
-      bytes = pread64 (fd, myaddr, len, memaddr);
+	  bytes = pread64 (priv->mem_fd, readbuf, len, memaddr);
 #else
-      bytes = -1;
-      if (lseek (fd, memaddr, SEEK_SET) != -1)
-	bytes = read (fd, myaddr, len);
+	  bytes = -1;
+	  if (lseek (priv->mem_fd, memaddr, SEEK_SET) != -1)
+	    bytes = read (priv->mem_fd, readbuf, len);
 #endif
+	}
+      else
+	{
+#ifdef HAVE_PWRITE64
+	  bytes = pwrite64 (priv->mem_fd, writebuf, len, memaddr);
+#else
+	  bytes = -1;
+	  if (lseek (priv->mem_fd, memaddr, SEEK_SET) != -1)
+	    bytes = write (priv->mem_fd, writebuf, len);
+#endif
+	}
 
-      close (fd);
+      if (bytes != 0)
+	break;
+
+      /* End of file means the address space the file was opened for
+	 is gone, e.g. the process called exec.  Open the file again.  */
+      close (priv->mem_fd);
+      priv->mem_fd = -1;
+    }
+
+  return bytes;
+}
+
+#ifdef HAVE_PROCESS_VM_READV
+/* Nonzero if the kernel does not implement process_vm_readv.  */
+static int process_vm_readv_unsupported;
+#endif
+
+/* Copy LEN bytes from inferior's memory starting at MEMADDR
+   to debugger memory starting at MYADDR.  */
+
+static int
+linux_read_memory (CORE_ADDR memaddr, unsigned char *myaddr, int len)
+{
+  int pid = lwpid_of (get_thread_lwp (current_inferior));
+  register PTRACE_XFER_TYPE *buffer;
+  register CORE_ADDR addr;
+  register int count;
+  register int i;
+  int ret;
+  int bytes;
+
+#ifdef HAVE_PROCESS_VM_READV
+  /* Try process_vm_readv first.  It reads straight from the address
+     space of the inferior, with a single system call, and needs no
+     file descriptor.  It fails for pages without read permission,
+     that /proc and ptrace can still read.  */
+  if (!process_vm_readv_unsupported
+      && (CORE_ADDR) (uintptr_t) memaddr == memaddr)
+    {
+      struct iovec local_iov, remote_iov;
+
+      local_iov.iov_base = myaddr;
+      local_iov.iov_len = len;
+      remote_iov.iov_base = (void *) (uintptr_t) memaddr;
+      remote_iov.iov_len = len;
+      bytes = process_vm_readv (pid, &local_iov, 1, &remote_iov, 1, 0);
       if (bytes == len)
 	return 0;
 
-      /* Some data was read, we'll try to get the rest with ptrace.  */
-      if (bytes > 0)
+      if (bytes < 0 && errno == ENOSYS)
+	process_vm_readv_unsupported = 1;
+      else if (bytes > 0)
 	{
 	  memaddr += bytes;
 	  myaddr += bytes;
 	  len -= bytes;
 	}
     }
+#endif
+
+  /* Try using /proc.  */
+  bytes = linux_proc_mem_xfer (memaddr, myaddr, NULL, len);
+  if (bytes == len)
+    return 0;
+
+  /* Some data was read, we'll try to get the rest with ptrace.  */
+  if (bytes > 0)
+    {
+      memaddr += bytes;
+      myaddr += bytes;
+      len -= bytes;
+    }
 
- no_proc:
   /* Round starting address down to longword boundary.  */
   addr = memaddr & -(CORE_ADDR) sizeof (PTRACE_XFER_TYPE);
   /* Round ending address up; get number of longwords that makes.  */
@@ -4501,18 +4802,11 @@ static int
 linux_write_memory (CORE_ADDR memaddr, const unsigned char *myaddr, int len)
 {
   register int i;
-  /* Round starting address down to longword boundary.  */
-  register CORE_ADDR addr = memaddr & -(CORE_ADDR) sizeof (PTRACE_XFER_TYPE);
-  /* Round ending address up; get number of longwords that makes.  */
-  register int count
-    = (((memaddr + len) - addr) + sizeof (PTRACE_XFER_TYPE) - 1)
-    / sizeof (PTRACE_XFER_TYPE);
-
-  /* Allocate buffer of that many longwords.  */
-  register PTRACE_XFER_TYPE *buffer = (PTRACE_XFER_TYPE *)
-    alloca (count * sizeof (PTRACE_XFER_TYPE));
-
+  register CORE_ADDR addr;
+  register int count;
+  register PTRACE_XFER_TYPE *buffer;
   int pid = lwpid_of (get_thread_lwp (current_inferior));
+  int bytes;
 
   if (len == 0)
     {
@@ -4534,6 +4828,29 @@ linux_write_memory (CORE_ADDR memaddr, const unsigned char *myaddr, int len)
 	       val, (long)memaddr);
     }
 
+  /* Try using /proc, which writes the whole block with one system
+     call.  Like ptrace, and unlike process_vm_writev, it can write to
+     read-only pages, such as those holding breakpoints.  */
+  bytes = linux_proc_mem_xfer (memaddr, NULL, myaddr, len);
+  if (bytes == len)
+    return 0;
+
+  /* Some data was written, we'll write the rest with ptrace.  */
+  if (bytes > 0)
+    {
+      memaddr += bytes;
+      myaddr += bytes;
+      len -= bytes;
+    }
+
+  /* Round starting address down to longword boundary.  */
+  addr = memaddr & -(CORE_ADDR) sizeof (PTRACE_XFER_TYPE);
+  /* Round ending address up; get number of longwords that makes.  */
+  count = ((((memaddr + len) - addr) + sizeof (PTRACE_XFER_TYPE) - 1)
+	   / sizeof (PTRACE_XFER_TYPE));
+  /* Allocate buffer of that many longwords.  */
+  buffer = (PTRACE_XFER_TYPE *) alloca (count * sizeof (PTRACE_XFER_TYPE));
+
   /* Fill start and end extra bytes of buffer with existing memory data.  */
 
   errno = 0;
@@ -4929,6 +5246,59 @@ linux_supports_range_stepping (void)
   return (*the_low_target.supports_range_stepping) ();
 }
 
+static int
+linux_supports_lazy_regcache (void)
+{
+  return 1;
+}
+
+/* Implementation of the target_ops method "find_memory_regions",
+   reading the mappings of the current process from /proc/PID/maps.  */
+
+static int
+linux_find_memory_regions (find_memory_region_callback func, void *data)
+{
+  char filename[100];
+  char line[PATH_MAX + 100];
+  FILE *f;
+  int pid;
+
+  if (current_inferior == NULL)
+    return -1;
+
+  pid = lwpid_of (get_thread_lwp (current_inferior));
+  xsnprintf (filename, sizeof filename, "/proc/%d/maps", pid);
+  f = fopen (filename, "r");
+  if (f == NULL)
+    return -1;
+
+  while (fgets (line, sizeof line, f) != NULL)
+    {
+      unsigned long long lo, hi;
+      char perms[5];
+
+      /* Skip the rest of an overlong line.  */
+      if (strchr (line, '\n') == NULL)
+	{
+	  int c;
+
+	  do
+	    c = fgetc (f);
+	  while (c != EOF && c != '\n');
+	}
+
+      if (sscanf (line, "%llx-%llx %4s", &lo, &hi, perms) != 3)
+	continue;
+
+      if (func ((CORE_ADDR) lo, (CORE_ADDR) (hi - lo), perms[0] == 'r',
+		data) != 0)
+	break;
+    }
+
+  fclose (f);
+  return 0;
+}
+
 /* Enumerate spufs IDs for process PID.  */
 static int
 spu_enumerate_spu_ids (long pid, unsigned char *buf, CORE_ADDR offset, int len)
@@ -5178,7 +5548,7 @@ linux_done_accessing_memory (void)
 static int
 linux_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 					CORE_ADDR collector,
-					CORE_ADDR lockaddr,
+					int collecting_offset,
 					ULONGEST orig_size,
 					CORE_ADDR *jump_entry,
 					CORE_ADDR *trampoline,
@@ -5190,7 +5560,7 @@ linux_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 					char *err)
 {
   return (*the_low_target.install_fast_tracepoint_jump_pad)
-    (tpoint, tpaddr, collector, lockaddr, orig_size,
+    (tpoint, tpaddr, collector, collecting_offset, orig_size,
      jump_entry, trampoline, trampoline_size,
      jjump_pad_insn, jjump_pad_insn_size,
      adjusted_insn_addr, adjusted_insn_addr_end,
@@ -5825,6 +6195,8 @@ static struct target_ops linux_target_ops = {
   NULL,
 #endif
   linux_supports_range_stepping,
+  linux_supports_lazy_regcache,
+  linux_find_memory_regions,
 };
 
 static void
@@ -118,6 +118,18 @@ struct process_info_private
      LWP of this process but it has not stopped yet.  As soon as it
      does, we need to call the low target's arch_setup callback.  */
   int new_inferior;
+
+  /* A descriptor of the /proc/PID/mem file of this process, opened
+     when first needed, or -1.  */
+  int mem_fd;
+
+  /* The number of lwps of this process with a status pending.  */
+  int num_lwps_status_pending;
+
+  /* For each register of REGSET_MAP_TDESC, the index of the regset
+     that transfers it, or -1.  Computed when first needed.  */
+  int *regset_map;
+  const struct target_desc *regset_map_tdesc;
 };
 
 struct lwp_info;
@@ -198,7 +210,7 @@ struct linux_target_ops
      comments.  */
   int (*install_fast_tracepoint_jump_pad) (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 					   CORE_ADDR collector,
-					   CORE_ADDR lockaddr,
+					   int collecting_offset,
 					   ULONGEST orig_size,
 					   CORE_ADDR *jump_entry,
 					   CORE_ADDR *trampoline,
@@ -266,7 +278,7 @@ struct lwp_info
   CORE_ADDR stop_pc;
 
   /* If this flag is set, STATUS_PENDING is a waitstatus that has not yet
-     been reported.  */
+     been reported.  Only set with set_status_pending_p.  */
   int status_pending_p;
   int status_pending;
 
@@ -1483,7 +1483,7 @@ x86_supports_tracepoints (void)
 static void
 append_insns (CORE_ADDR *to, size_t len, const unsigned char *buf)
 {
-  write_inferior_memory (*to, buf, len);
+  write_insns (*to, buf, len);
   *to += len;
 }
 
@@ -1517,7 +1517,7 @@ push_opcode (unsigned char *buf, char *op)
 static int
 amd64_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 					CORE_ADDR collector,
-					CORE_ADDR lockaddr,
+					int collecting_offset,
 					ULONGEST orig_size,
 					CORE_ADDR *jump_entry,
 					CORE_ADDR *trampoline,
@@ -1575,16 +1575,12 @@ amd64_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
   i += push_opcode (&buf[i], "48 89 44 24 08"); /* mov %rax,0x8(%rsp) */
   append_insns (&buildaddr, i, buf);
 
-  /* spin-lock.  */
+  /* Point the thread's collecting slot at the object.  */
   i = 0;
-  i += push_opcode (&buf[i], "48 be");		/* movl <lockaddr>,%rsi */
-  memcpy (&buf[i], (void *) &lockaddr, 8);
-  i += 8;
   i += push_opcode (&buf[i], "48 89 e1");       /* mov %rsp,%rcx */
-  i += push_opcode (&buf[i], "31 c0");		/* xor %eax,%eax */
-  i += push_opcode (&buf[i], "f0 48 0f b1 0e"); /* lock cmpxchg %rcx,(%rsi) */
-  i += push_opcode (&buf[i], "48 85 c0");	/* test %rax,%rax */
-  i += push_opcode (&buf[i], "75 f4");		/* jne <again> */
+  i += push_opcode (&buf[i], "64 48 89 0c 25"); /* mov %rcx,%fs:<offset> */
+  memcpy (&buf[i], &collecting_offset, 4);
+  i += 4;
   append_insns (&buildaddr, i, buf);
 
   /* Set up the gdb_collect call.  */
@@ -1610,12 +1606,12 @@ amd64_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
   i += push_opcode (&buf[i], "ff d0");          /* callq *%rax */
   append_insns (&buildaddr, i, buf);
 
-  /* Clear the spin-lock.  */
+  /* Clear the collecting slot.  */
   i = 0;
   i += push_opcode (&buf[i], "31 c0");		/* xor %eax,%eax */
-  i += push_opcode (&buf[i], "48 a3");		/* mov %rax, lockaddr */
-  memcpy (buf + i, &lockaddr, 8);
-  i += 8;
+  i += push_opcode (&buf[i], "64 48 89 04 25"); /* mov %rax,%fs:<offset> */
+  memcpy (buf + i, &collecting_offset, 4);
+  i += 4;
   append_insns (&buildaddr, i, buf);
 
   /* Remove stack that had been used for the collect_t object.  */
@@ -1706,7 +1702,7 @@ amd64_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 static int
 i386_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 				       CORE_ADDR collector,
-				       CORE_ADDR lockaddr,
+				       int collecting_offset,
 				       ULONGEST orig_size,
 				       CORE_ADDR *jump_entry,
 				       CORE_ADDR *trampoline,
@@ -1754,17 +1750,11 @@ i386_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
   i += push_opcode (&buf[i], "89 44 24 04");	   /* mov %eax,0x4(%esp) */
   append_insns (&buildaddr, i, buf);
 
-  /* spin-lock.  Note this is using cmpxchg, which leaves i386 behind.
-     If we cared for it, this could be using xchg alternatively.  */
-
+  /* Point the thread's collecting slot at the object.  */
   i = 0;
-  i += push_opcode (&buf[i], "31 c0");		/* xor %eax,%eax */
-  i += push_opcode (&buf[i], "f0 0f b1 25");    /* lock cmpxchg
-						   %esp,<lockaddr> */
-  memcpy (&buf[i], (void *) &lockaddr, 4);
+  i += push_opcode (&buf[i], "65 89 25");	/* mov %esp,%gs:<offset> */
+  memcpy (&buf[i], &collecting_offset, 4);
   i += 4;
-  i += push_opcode (&buf[i], "85 c0");		/* test %eax,%eax */
-  i += push_opcode (&buf[i], "75 f2");		/* jne <again> */
   append_insns (&buildaddr, i, buf);
 
 
@@ -1796,12 +1786,11 @@ i386_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
   append_insns (&buildaddr, 3, buf);
 
 
-  /* Clear the spin-lock.  This would need the LOCK prefix on older
-     broken archs.  */
+  /* Clear the collecting slot.  */
   i = 0;
   i += push_opcode (&buf[i], "31 c0");		/* xor %eax,%eax */
-  i += push_opcode (&buf[i], "a3");		/* mov %eax, lockaddr */
-  memcpy (buf + i, &lockaddr, 4);
+  i += push_opcode (&buf[i], "65 a3");		/* mov %eax,%gs:<offset> */
+  memcpy (buf + i, &collecting_offset, 4);
   i += 4;
   append_insns (&buildaddr, i, buf);
 
@@ -1889,7 +1878,7 @@ i386_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 static int
 x86_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 				      CORE_ADDR collector,
-				      CORE_ADDR lockaddr,
+				      int collecting_offset,
 				      ULONGEST orig_size,
 				      CORE_ADDR *jump_entry,
 				      CORE_ADDR *trampoline,
@@ -1903,7 +1892,8 @@ x86_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 #ifdef __x86_64__
   if (is_64bit_tdesc ())
     return amd64_install_fast_tracepoint_jump_pad (tpoint, tpaddr,
-						   collector, lockaddr,
+						   collector,
+						   collecting_offset,
 						   orig_size, jump_entry,
 						   trampoline, trampoline_size,
 						   jjump_pad_insn,
@@ -1914,7 +1904,7 @@ x86_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 #endif
 
   return i386_install_fast_tracepoint_jump_pad (tpoint, tpaddr,
-						collector, lockaddr,
+						collector, collecting_offset,
 						orig_size, jump_entry,
 						trampoline, trampoline_size,
 						jjump_pad_insn,
@@ -2194,9 +2184,33 @@ amd64_emit_less_unsigned (void)
 	    "lea 0x8(%rsp),%rsp");
 }
 
+static void amd64_emit_call (CORE_ADDR fn);
+
 static void
 amd64_emit_ref (int size)
 {
+  if (emit_for_gdbserver)
+    {
+      unsigned char buf[16];
+      int i;
+      CORE_ADDR buildaddr;
+
+      /* The memory is the inferior's, not ours; have gdbserver read
+	 it.  */
+      buildaddr = current_insn_ptr;
+      i = 0;
+      buf[i++] = 0x48; /* mov %rax,%rdi */
+      buf[i++] = 0x89;
+      buf[i++] = 0xc7;
+      buf[i++] = 0xbe; /* mov $<n>,%esi */
+      memcpy (&buf[i], &size, sizeof (size));
+      i += 4;
+      append_insns (&buildaddr, i, buf);
+      current_insn_ptr = buildaddr;
+      amd64_emit_call ((CORE_ADDR) (uintptr_t) gdbserver_agent_read_memory);
+      return;
+    }
+
   switch (size)
     {
     case 1:
@@ -2256,7 +2270,7 @@ amd64_write_goto_address (CORE_ADDR from, CORE_ADDR to, int size)
     }
 
   memcpy (buf, &diff, sizeof (int));
-  write_inferior_memory (from, buf, sizeof (int));
+  write_insns (from, buf, sizeof (int));
 }
 
 static void
@@ -2277,16 +2291,32 @@ amd64_emit_const (LONGEST num)
 static void
 amd64_emit_call (CORE_ADDR fn)
 {
-  unsigned char buf[16];
+  unsigned char buf[32];
   int i;
   CORE_ADDR buildaddr;
   LONGEST offset64;
 
+  buildaddr = current_insn_ptr;
+  i = 0;
+
+  /* The value stack lives on the machine stack, so %rsp may be
+     anywhere.  Align it as the ABI requires for the call, saving the
+     old value in the frame set up by the prologue.  This is emitted
+     as raw bytes rather than with EMIT_ASM, since this function may
+     be inlined in several places.  */
+  buf[i++] = 0x48; /* mov %rsp,-24(%rbp) */
+  buf[i++] = 0x89;
+  buf[i++] = 0x65;
+  buf[i++] = 0xe8;
+  buf[i++] = 0x48; /* and $-16,%rsp */
+  buf[i++] = 0x83;
+  buf[i++] = 0xe4;
+  buf[i++] = 0xf0;
+  append_insns (&buildaddr, i, buf);
+
   /* The destination function being in the shared library, may be
      >31-bits away off the compiled code pad.  */
 
-  buildaddr = current_insn_ptr;
-
   offset64 = fn - (buildaddr + 1 /* call op */ + 4 /* 32-bit offset */);
 
   i = 0;
@@ -2294,22 +2324,29 @@ amd64_emit_call (CORE_ADDR fn)
   if (offset64 > INT_MAX || offset64 < INT_MIN)
     {
       /* Offset is too large for a call.  Use callq, but that requires
-	 a register, so avoid it if possible.  Use r10, since it is
+	 a register, so avoid it if possible.  Use rdx, since it is
 	 call-clobbered, we don't have to push/pop it.  */
-      buf[i++] = 0x48; /* mov $fn,%r10 */
+      buf[i++] = 0x48; /* mov $fn,%rdx */
       buf[i++] = 0xba;
       memcpy (buf + i, &fn, 8);
       i += 8;
-      buf[i++] = 0xff; /* callq *%r10 */
+      buf[i++] = 0xff; /* callq *%rdx */
       buf[i++] = 0xd2;
     }
   else
     {
       int offset32 = offset64; /* we know we can't overflow here.  */
+
+      buf[i++] = 0xe8; /* call <reladdr> */
       memcpy (buf + i, &offset32, 4);
       i += 4;
     }
 
+  buf[i++] = 0x48; /* mov -24(%rbp),%rsp */
+  buf[i++] = 0x8b;
+  buf[i++] = 0x65;
+  buf[i++] = 0xe8;
+
   append_insns (&buildaddr, i, buf);
   current_insn_ptr = buildaddr;
 }
@@ -2321,9 +2358,14 @@ amd64_emit_reg (int reg)
   int i;
   CORE_ADDR buildaddr;
 
-  /* Assume raw_regs is still in %rdi.  */
+  /* Reload raw_regs, which the prologue saved, as an earlier call may
+     have clobbered %rdi.  */
   buildaddr = current_insn_ptr;
   i = 0;
+  buf[i++] = 0x48; /* mov -8(%rbp),%rdi */
+  buf[i++] = 0x8b;
+  buf[i++] = 0x7d;
+  buf[i++] = 0xf8;
   buf[i++] = 0xbe; /* mov $<n>,%esi */
   memcpy (&buf[i], &reg, sizeof (reg));
   i += 4;
@@ -2872,7 +2914,7 @@ i386_write_goto_address (CORE_ADDR from, CORE_ADDR to, int size)
     }
 
   memcpy (buf, &diff, sizeof (int));
-  write_inferior_memory (from, buf, sizeof (int));
+  write_insns (from, buf, sizeof (int));
 }
 
 static void
@@ -3278,11 +3320,15 @@ static struct emit_ops *
 x86_emit_ops (void)
 {
 #ifdef __x86_64__
-  if (is_64bit_tdesc ())
+  /* Code for gdbserver itself runs on a 64-bit host, whatever the
+     inferior is.  */
+  if (emit_for_gdbserver || is_64bit_tdesc ())
     return &amd64_emit_ops;
-  else
 #endif
-    return &i386_emit_ops;
+  /* The i386 code can only run in the in-process agent.  */
+  if (emit_for_gdbserver)
+    return NULL;
+  return &i386_emit_ops;
 }
 
 static int
@@ -93,6 +93,13 @@ struct point_cond_list
      conditional.  */
   struct agent_expr *cond;
 
+  /* COND compiled to native code, or NULL if it was not compiled
+     yet, or cannot be compiled.  */
+  struct compiled_agent_expr *compiled_cond;
+
+  /* Nonzero once compiling COND was tried.  */
+  int compile_tried;
+
   /* Pointer to the next condition.  */
   struct point_cond_list *next;
 };
@@ -772,6 +779,8 @@ clear_gdb_breakpoint_conditions (CORE_ADDR addr)
       struct point_cond_list *cond_next;
 
       cond_next = cond->next;
+      if (cond->compiled_cond != NULL)
+	free_compiled_agent_expr (cond->compiled_cond);
       free (cond->cond->bytes);
       free (cond->cond);
       free (cond);
@@ -862,8 +871,21 @@ gdb_condition_true_at_breakpoint (CORE_ADDR where)
   for (cl = bp->cond_list;
        cl && !value && !err; cl = cl->next)
     {
+      /* Compile the condition the first time the breakpoint is hit,
+	 and run the compiled code from then on, if the target can
+	 compile it.  */
+      if (!cl->compile_tried)
+	{
+	  cl->compiled_cond = compile_agent_expr (cl->cond);
+	  cl->compile_tried = 1;
+	}
+
       /* Evaluate the condition.  */
-      err = gdb_eval_agent_expr (&ctx, cl->cond, &value);
+      if (cl->compiled_cond != NULL)
+	err = run_compiled_agent_expr (cl->compiled_cond, ctx.regcache,
+				       &value);
+      else
+	err = gdb_eval_agent_expr (&ctx, cl->cond, &value);
     }
 
   if (err)
@@ -26,6 +26,58 @@
 
 #ifndef IN_PROCESS_AGENT
 
+/* Fetch register N of the thread REGCACHE caches.  */
+
+static void
+regcache_fetch_register (struct regcache *regcache, int n)
+{
+  struct thread_info *saved_inferior = current_inferior;
+
+  current_inferior = regcache->thread;
+  regcache->transferring = 1;
+  fetch_inferior_registers (regcache, n);
+  regcache->transferring = 0;
+  current_inferior = saved_inferior;
+
+  /* Don't ask again for a register the target could not supply.  */
+  regcache->register_fetched[n] = 1;
+}
+
+/* Fetch all the registers of the thread REGCACHE caches that were not
+   fetched yet.  */
+
+static void
+regcache_fetch_all (struct regcache *regcache)
+{
+  const struct target_desc *tdesc = regcache->tdesc;
+  int i;
+
+  if (regcache->thread == NULL || regcache->registers_valid)
+    return;
+
+  if (target_supports_lazy_regcache ())
+    {
+      /* The target fetches the whole register set a register belongs
+	 to, so this takes one request per register set.  */
+      for (i = 0; i < tdesc->num_registers; i++)
+	if (!regcache->register_fetched[i])
+	  regcache_fetch_register (regcache, i);
+    }
+  else
+    {
+      struct thread_info *saved_inferior = current_inferior;
+
+      current_inferior = regcache->thread;
+      regcache->transferring = 1;
+      fetch_inferior_registers (regcache, -1);
+      regcache->transferring = 0;
+      current_inferior = saved_inferior;
+    }
+
+  memset (regcache->register_fetched, 1, tdesc->num_registers);
+  regcache->registers_valid = 1;
+}
+
 struct regcache *
 get_thread_regcache (struct thread_info *thread, int fetch)
 {
@@ -48,18 +100,14 @@ get_thread_regcache (struct thread_info *thread, int fetch)
 	fatal ("no target description");
 
       regcache = new_register_cache (proc->tdesc);
+      regcache->thread = thread;
       set_inferior_regcache_data (thread, regcache);
     }
 
-  if (fetch && regcache->registers_valid == 0)
-    {
-      struct thread_info *saved_inferior = current_inferior;
-
-      current_inferior = thread;
-      fetch_inferior_registers (regcache, -1);
-      current_inferior = saved_inferior;
-      regcache->registers_valid = 1;
-    }
+  /* Targets that transfer the registers one register set at a time
+     fetch each register when it is first read instead.  */
+  if (fetch && !target_supports_lazy_regcache ())
+    regcache_fetch_all (regcache);
 
   return regcache;
 }
@@ -74,15 +122,32 @@ regcache_invalidate_thread (struct thread_info *thread)
   if (regcache == NULL)
     return;
 
-  if (regcache->registers_valid)
+  /* An error while the target transferred the registers may have
+     left this set.  */
+  regcache->transferring = 0;
+
+  /* Nothing needs to be written back after a stop where the registers
+     were only read.  */
+  if (regcache->num_dirty > 0)
     {
       struct thread_info *saved_inferior = current_inferior;
 
+      /* Targets that don't store the dirty registers only write all
+	 the registers from the cache, so it must have them all.  */
+      if (!target_supports_lazy_regcache ())
+	regcache_fetch_all (regcache);
+
       current_inferior = thread;
+      regcache->transferring = 1;
       store_inferior_registers (regcache, -1);
+      regcache->transferring = 0;
       current_inferior = saved_inferior;
+
+      memset (regcache->register_dirty, 0, regcache->tdesc->num_registers);
+      regcache->num_dirty = 0;
     }
 
+  memset (regcache->register_fetched, 0, regcache->tdesc->num_registers);
   regcache->registers_valid = 0;
 }
 
@@ -128,6 +193,8 @@ init_register_cache (struct regcache *regcache,
       regcache->registers_owned = 1;
       regcache->register_status = xcalloc (1, tdesc->num_registers);
       gdb_assert (REG_UNAVAILABLE == 0);
+      regcache->register_fetched = xcalloc (1, tdesc->num_registers);
+      regcache->register_dirty = xcalloc (1, tdesc->num_registers);
     }
   else
 #else
@@ -141,10 +208,17 @@ init_register_cache (struct regcache *regcache,
       regcache->registers_owned = 0;
 #ifndef IN_PROCESS_AGENT
       regcache->register_status = NULL;
+      regcache->register_fetched = NULL;
+      regcache->register_dirty = NULL;
 #endif
     }
 
   regcache->registers_valid = 0;
+#ifndef IN_PROCESS_AGENT
+  regcache->thread = NULL;
+  regcache->num_dirty = 0;
+  regcache->transferring = 0;
+#endif
 
   return regcache;
 }
@@ -170,6 +244,8 @@ free_register_cache (struct regcache *regcache)
       if (regcache->registers_owned)
 	free (regcache->registers);
       free (regcache->register_status);
+      free (regcache->register_fetched);
+      free (regcache->register_dirty);
       free (regcache);
     }
 }
@@ -183,6 +259,9 @@ regcache_cpy (struct regcache *dst, struct regcache *src)
   gdb_assert (src->tdesc == dst->tdesc);
   gdb_assert (src != dst);
 
+#ifndef IN_PROCESS_AGENT
+  regcache_fetch_all (src);
+#endif
   memcpy (dst->registers, src->registers, src->tdesc->registers_size);
 #ifndef IN_PROCESS_AGENT
   if (dst->register_status != NULL && src->register_status != NULL)
@@ -202,6 +281,8 @@ registers_to_string (struct regcache *regcache, char *buf)
   const struct target_desc *tdesc = regcache->tdesc;
   int i;
 
+  regcache_fetch_all (regcache);
+
   for (i = 0; i < tdesc->num_registers; i++)
     {
       if (regcache->register_status[i] == REG_VALID)
@@ -234,6 +315,29 @@ registers_from_string (struct regcache *regcache, char *buf)
       if (len > tdesc->registers_size * 2)
 	len = tdesc->registers_size * 2;
     }
+
+  if (regcache->thread != NULL)
+    {
+      unsigned char *newregs = xmalloc (tdesc->registers_size);
+      int i;
+
+      /* Supply the registers one by one, so that only those changed
+	 are stored back.  */
+      regcache_fetch_all (regcache);
+      memcpy (newregs, registers, tdesc->registers_size);
+      convert_ascii_to_int (buf, newregs, len / 2);
+      for (i = 0; i < tdesc->num_registers; i++)
+	{
+	  int offset = tdesc->reg_defs[i].offset / 8;
+
+	  if (memcmp (newregs + offset, registers + offset,
+		      register_size (tdesc, i)) != 0)
+	    supply_register (regcache, i, newregs + offset);
+	}
+      free (newregs);
+      return;
+    }
+
   convert_ascii_to_int (buf, registers, len / 2);
 }
 
@@ -315,9 +419,74 @@ register_size (const struct target_desc *tdesc, int n)
 static unsigned char *
 register_data (struct regcache *regcache, int n, int fetch)
 {
+#ifndef IN_PROCESS_AGENT
+  if (fetch && regcache->thread != NULL && !regcache->registers_valid
+      && !regcache->register_fetched[n])
+    regcache_fetch_register (regcache, n);
+#endif
+
   return regcache->registers + regcache->tdesc->reg_defs[n].offset / 8;
 }
 
+#ifndef IN_PROCESS_AGENT
+
+/* Prepare for supplying register N of REGCACHE with the contents of
+   BUF, or with zeroes if BUF is NULL and ZEROED is nonzero, or as
+   unavailable otherwise.  Return zero if the value must be dropped,
+   because the register has a newer one that the thread does not have
+   yet.  */
+
+static int
+regcache_prepare_supply (struct regcache *regcache, int n,
+			 const void *buf, int zeroed)
+{
+  int changed;
+
+  if (regcache->thread == NULL)
+    return 1;
+
+  if (regcache->transferring)
+    {
+      if (regcache->register_dirty[n])
+	return 0;
+      regcache->register_fetched[n] = 1;
+      return 1;
+    }
+
+  /* The thread's value is needed to tell whether this changes it; and
+     a target fetching the register's set later must not overwrite
+     the new value.  */
+  register_data (regcache, n, 1);
+
+  if (regcache->register_dirty[n])
+    return 1;
+
+  if (buf != NULL)
+    changed = (regcache->register_status[n] != REG_VALID
+	       || memcmp (register_data (regcache, n, 0), buf,
+			  register_size (regcache->tdesc, n)) != 0);
+  else if (zeroed)
+    changed = 1;
+  else
+    changed = regcache->register_status[n] != REG_UNAVAILABLE;
+
+  if (changed)
+    {
+      regcache->register_dirty[n] = 1;
+      regcache->num_dirty++;
+    }
+  return 1;
+}
+
+int
+regcache_register_dirty_p (struct regcache *regcache, int n)
+{
+  return (regcache->register_dirty == NULL
+	  || regcache->register_dirty[n]);
+}
+
+#endif
+
 /* Supply register N, whose contents are stored in BUF, to REGCACHE.
    If BUF is NULL, the register's value is recorded as
    unavailable.  */
@@ -325,6 +494,11 @@ register_data (struct regcache *regcache, int n, int fetch)
 void
 supply_register (struct regcache *regcache, int n, const void *buf)
 {
+#ifndef IN_PROCESS_AGENT
+  if (!regcache_prepare_supply (regcache, n, buf, 0))
+    return;
+#endif
+
   if (buf)
     {
       memcpy (register_data (regcache, n, 0), buf,
@@ -350,6 +524,11 @@ supply_register (struct regcache *regcache, int n, const void *buf)
 void
 supply_register_zeroed (struct regcache *regcache, int n)
 {
+#ifndef IN_PROCESS_AGENT
+  if (!regcache_prepare_supply (regcache, n, NULL, 1))
+    return;
+#endif
+
   memset (register_data (regcache, n, 0), 0,
 	  register_size (regcache->tdesc, n));
 #ifndef IN_PROCESS_AGENT
@@ -365,6 +544,23 @@ supply_register_zeroed (struct regcache *regcache, int n)
 void
 supply_regblock (struct regcache *regcache, const void *buf)
 {
+#ifndef IN_PROCESS_AGENT
+  if (regcache->thread != NULL)
+    {
+      const struct target_desc *tdesc = regcache->tdesc;
+      int i;
+
+      /* Keep track of what changes.  */
+      for (i = 0; i < tdesc->num_registers; i++)
+	supply_register (regcache, i,
+			 buf != NULL
+			 ? (const unsigned char *) buf
+			   + tdesc->reg_defs[i].offset / 8
+			 : NULL);
+      return;
+    }
+#endif
+
   if (buf)
     {
       const struct target_desc *tdesc = regcache->tdesc;
@@ -40,16 +40,39 @@ struct regcache
   const struct target_desc *tdesc;
 
   /* Whether the REGISTERS buffer's contents are valid.  If false, we
-     haven't fetched the registers from the target yet.  Not that this
-     register cache is _not_ pass-through, unlike GDB's.  Note that
-     "valid" here is unrelated to whether the registers are available
-     in a traceframe.  For that, check REGISTER_STATUS below.  */
+     haven't fetched all the registers from the target yet.  Not that
+     this register cache is _not_ pass-through, unlike GDB's.  Note
+     that "valid" here is unrelated to whether the registers are
+     available in a traceframe.  For that, check REGISTER_STATUS
+     below.  */
   int registers_valid;
   int registers_owned;
   unsigned char *registers;
 #ifndef IN_PROCESS_AGENT
   /* One of REG_UNAVAILBLE or REG_VALID.  */
   unsigned char *register_status;
+
+  /* The thread whose registers this is the cache of, or NULL.  The
+     registers of a thread are fetched as they are first read, and
+     only the ones changed since are stored back when the cache is
+     invalidated.  */
+  struct thread_info *thread;
+
+  /* For a thread's cache, one boolean byte per register, set once the
+     register was fetched from the thread.  */
+  unsigned char *register_fetched;
+
+  /* For a thread's cache, one boolean byte per register, set if the
+     register was changed and not yet stored back, and the number of
+     those bytes set.  */
+  unsigned char *register_dirty;
+  int num_dirty;
+
+  /* Nonzero while the target fetches or stores the registers of the
+     thread.  The values the target supplies then come from the
+     thread, so they don't make registers dirty, and don't replace the
+     values of dirty registers.  */
+  int transferring;
 #endif
 };
 
@@ -115,6 +138,11 @@ void supply_register_by_name (struct regcache *regcache,
 
 void supply_regblock (struct regcache *regcache, const void *buf);
 
+/* Return true if register N of REGCACHE may hold a value that the
+   thread does not have yet.  */
+
+int regcache_register_dirty_p (struct regcache *regcache, int n);
+
 void collect_register (struct regcache *regcache, int n, void *buf);
 
 void collect_register_as_string (struct regcache *regcache, int n, char *buf);
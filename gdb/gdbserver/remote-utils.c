@@ -22,6 +22,7 @@
 #include "gdbthread.h"
 #include "tdesc.h"
 #include "dll.h"
+#include "shm-ring.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -61,6 +62,9 @@
 #if HAVE_ERRNO_H
 #include <errno.h>
 #endif
+#if HAVE_ZLIB_H
+#include <zlib.h>
+#endif
 
 #if USE_WIN32API
 #include <winsock2.h>
@@ -96,11 +100,16 @@ static int readchar (void);
 static void reset_readchar (void);
 static void reschedule (void);
 
-/* A cache entry for a successfully looked-up symbol.  */
+/* A cache entry for a looked-up symbol.  */
 struct sym_cache
 {
   char *name;
   CORE_ADDR addr;
+
+  /* Zero if GDB did not know the symbol; ADDR is then meaningless.
+     Such entries are dropped by forget_missing_symbols.  */
+  int found;
+
   struct sym_cache *next;
 };
 
@@ -112,6 +121,13 @@ static int remote_is_stdio = 0;
 static gdb_fildes_t remote_desc = INVALID_DESCRIPTOR;
 static gdb_fildes_t listen_desc = INVALID_DESCRIPTOR;
 
+#ifndef USE_WIN32API
+/* If true, the connection is a shared memory one, and REMOTE_DESC is
+   the read end of its doorbell.  */
+static int remote_is_shm = 0;
+static struct shm_channel remote_shm;
+#endif
+
 /* FIXME headerize? */
 extern int using_threads;
 extern int debug_threads;
@@ -120,6 +136,15 @@ extern int debug_threads;
 int noack_mode = 0;
 /* If true, then we tell GDB to use noack mode by default.  */
 int transport_is_reliable = 0;
+/* If true, then GDB can decompress packets, and we compress the
+   larger ones we send.  */
+int compress_packets = 0;
+
+/* Nonzero if GDB can answer qSymbols requests.  */
+int batch_symbol_lookups = 0;
+
+/* Packets shorter than this are never compressed.  */
+#define COMPRESS_THRESHOLD 256
 
 #ifdef USE_WIN32API
 # define read(fd, buf, len) recv (fd, (char *) buf, len, 0)
@@ -217,6 +242,37 @@ handle_accept_event (int err, gdb_client_data client_data)
   return 0;
 }
 
+#ifndef USE_WIN32API
+
+/* Event loop handler for the doorbell of a shared memory connection.
+   Bytes read from the ring while handling earlier events leave their
+   doorbell rings behind, so ignore the rings that find the ring
+   empty.
+
+   GDB usually sends its next request right after reading a reply, so
+   watch the ring for a while after each request, and handle the next
+   one directly, without sleeping in the event loop.  The doorbell
+   stays armed, so that a Ctrl-C from GDB still raises SIGIO while the
+   inferior runs.  */
+
+static int
+handle_shm_event (int err, gdb_client_data client_data)
+{
+  int res;
+
+  if (shm_channel_drain (&remote_shm) == 0
+      && !shm_channel_pending_p (&remote_shm))
+    return 0;
+
+  do
+    res = handle_serial_event (err, client_data);
+  while (res == 0 && remote_is_shm && shm_channel_spin (&remote_shm));
+
+  return res;
+}
+
+#endif
+
 /* Prepare for a later connection to a remote debugger.
    NAME is the filename used for communication.  */
 
@@ -243,6 +299,13 @@ remote_prepare (char *name)
       return;
     }
 
+  if (strncmp (name, SHM_CONNECTION_PREFIX,
+	       strlen (SHM_CONNECTION_PREFIX)) == 0)
+    {
+      transport_is_reliable = 1;
+      return;
+    }
+
   port_str = strchr (name, ':');
   if (port_str == NULL)
     {
@@ -312,6 +375,28 @@ remote_open (char *name)
       add_file_handler (remote_desc, handle_serial_event, NULL);
     }
 #ifndef USE_WIN32API
+  else if (strncmp (name, SHM_CONNECTION_PREFIX,
+		    strlen (SHM_CONNECTION_PREFIX)) == 0)
+    {
+      fprintf (stderr, "Listening on %s\n", name);
+      fflush (stderr);
+
+      if (shm_channel_listen (name + strlen (SHM_CONNECTION_PREFIX),
+			      &remote_shm) < 0)
+	perror_with_name ("Could not open shared memory connection");
+      remote_is_shm = 1;
+      remote_desc = remote_shm.in_fd;
+
+      signal (SIGPIPE, SIG_IGN);	/* If we don't do this, then gdbserver
+					   simply exits when GDB dies.  */
+
+      fprintf (stderr, "Remote debugging using %s\n", name);
+
+      enable_async_notification (remote_desc);
+
+      /* Register the event loop handler.  */
+      add_file_handler (remote_desc, handle_shm_event, NULL);
+    }
   else if (port_str == NULL)
     {
       struct stat statbuf;
@@ -409,7 +494,13 @@ remote_close (void)
 #ifdef USE_WIN32API
   closesocket (remote_desc);
 #else
-  if (! remote_connection_is_stdio ())
+  if (remote_is_shm)
+    {
+      /* This also closes REMOTE_DESC.  */
+      shm_channel_close (&remote_shm);
+      remote_is_shm = 0;
+    }
+  else if (! remote_connection_is_stdio ())
     close (remote_desc);
 #endif
   remote_desc = INVALID_DESCRIPTOR;
@@ -776,6 +867,10 @@ read_ptid (char *buf, char **obuf)
 static int
 write_prim (const void *buf, int count)
 {
+#ifndef USE_WIN32API
+  if (remote_is_shm)
+    return shm_channel_write (&remote_shm, buf, count);
+#endif
   if (remote_connection_is_stdio ())
     return write (fileno (stdout), buf, count);
   else
@@ -789,12 +884,74 @@ write_prim (const void *buf, int count)
 static int
 read_prim (void *buf, int count)
 {
+#ifndef USE_WIN32API
+  if (remote_is_shm)
+    {
+      if (shm_channel_wait (&remote_shm, -1) < 0)
+	return errno == EPIPE ? 0 : -1;
+      return shm_channel_read (&remote_shm, buf, count);
+    }
+#endif
   if (remote_connection_is_stdio ())
     return read (fileno (stdin), buf, count);
   else
     return read (remote_desc, buf, count);
 }
 
+#if HAVE_ZLIB_H
+
+/* Build a compressed frame for the CNT bytes of packet data in BUF:
+   "&", the length of the data in hex, ":", the zlib-compressed data
+   in escaped binary, "#" and the checksum.  Store the end of the
+   frame in *END.  Return the xmalloc'd frame, or NULL if compressing
+   the data would not make the frame smaller.  */
+
+static char *
+make_compressed_frame (char *buf, int cnt, char **end)
+{
+  uLongf zlen = compressBound (cnt);
+  unsigned char *zbuf = xmalloc (zlen);
+  unsigned char csum = 0;
+  char *frame, *p, *q;
+  int out_len;
+
+  if (compress2 (zbuf, &zlen, (unsigned char *) buf, cnt,
+		 Z_BEST_SPEED) != Z_OK
+      || zlen >= cnt)
+    {
+      free (zbuf);
+      return NULL;
+    }
+
+  frame = xmalloc (strlen ("&") + 8 + strlen (":") + 2 * zlen
+		   + strlen ("#nn") + 1);
+  p = frame;
+  *p++ = '&';
+  p += sprintf (p, "%x:", cnt);
+  p += remote_escape_output (zbuf, zlen, (unsigned char *) p, &out_len,
+			     2 * zlen);
+  free (zbuf);
+
+  /* Escapes may have eaten the gain.  */
+  if (p - frame + 3 >= cnt)
+    {
+      free (frame);
+      return NULL;
+    }
+
+  for (q = frame + 1; q < p; q++)
+    csum += *q;
+  *p++ = '#';
+  *p++ = tohex ((csum >> 4) & 0xf);
+  *p++ = tohex (csum & 0xf);
+  *p = '\0';
+
+  *end = p;
+  return frame;
+}
+
+#endif
+
 /* Send a packet to the remote machine, with error checking.
    The data of the packet is in BUF, and the length of the
    packet is in CNT.  Returns >= 0 on success, -1 otherwise.  */
@@ -808,25 +965,34 @@ putpkt_binary_1 (char *buf, int cnt, int is_notif)
   char *p;
   int cc;
 
-  buf2 = xmalloc (strlen ("$") + cnt + strlen ("#nn") + 1);
+  buf2 = NULL;
+#if HAVE_ZLIB_H
+  if (compress_packets && !is_notif && cnt >= COMPRESS_THRESHOLD)
+    buf2 = make_compressed_frame (buf, cnt, &p);
+#endif
 
-  /* Copy the packet into buffer BUF2, encapsulating it
-     and giving it a checksum.  */
+  if (buf2 == NULL)
+    {
+      buf2 = xmalloc (strlen ("$") + cnt + strlen ("#nn") + 1);
 
-  p = buf2;
-  if (is_notif)
-    *p++ = '%';
-  else
-    *p++ = '$';
+      /* Copy the packet into buffer BUF2, encapsulating it
+	 and giving it a checksum.  */
 
-  for (i = 0; i < cnt;)
-    i += try_rle (buf + i, cnt - i, &csum, &p);
+      p = buf2;
+      if (is_notif)
+	*p++ = '%';
+      else
+	*p++ = '$';
 
-  *p++ = '#';
-  *p++ = tohex ((csum >> 4) & 0xf);
-  *p++ = tohex (csum & 0xf);
+      for (i = 0; i < cnt;)
+	i += try_rle (buf + i, cnt - i, &csum, &p);
 
-  *p = '\0';
+      *p++ = '#';
+      *p++ = tohex ((csum >> 4) & 0xf);
+      *p++ = tohex (csum & 0xf);
+
+      *p = '\0';
+    }
 
   /* Send it over and over until we get a positive ack.  */
 
@@ -916,13 +1082,27 @@ input_interrupt (int unused)
 {
   fd_set readset;
   struct timeval immediate = { 0, 0 };
+  int ready;
 
-  /* Protect against spurious interrupts.  This has been observed to
-     be a problem under NetBSD 1.4 and 1.5.  */
+#ifndef USE_WIN32API
+  if (remote_is_shm)
+    {
+      /* The doorbell rings for every write, so only the ring tells
+	 whether there is something to read.  */
+      shm_channel_drain (&remote_shm);
+      ready = shm_channel_pending_p (&remote_shm);
+    }
+  else
+#endif
+    {
+      /* Protect against spurious interrupts.  This has been observed
+	 to be a problem under NetBSD 1.4 and 1.5.  */
+      FD_ZERO (&readset);
+      FD_SET (remote_desc, &readset);
+      ready = select (remote_desc + 1, &readset, 0, 0, &immediate) > 0;
+    }
 
-  FD_ZERO (&readset);
-  FD_SET (remote_desc, &readset);
-  if (select (remote_desc + 1, &readset, 0, 0, &immediate) > 0)
+  if (ready)
     {
       int cc;
       char c = 0;
@@ -1310,6 +1490,59 @@ dead_thread_notify (int id)
   enable_async_io ();
 }
 
+/* Append to BUF a "stack:ADDR,XX...;" stop reply field with the
+   stack memory GDB asked for with QExpediteStack, as seen by the
+   thread of REGCACHE.  Return the new end of BUF.  Nothing is added
+   if the memory cannot be read.  */
+
+static char *
+outstack (struct regcache *regcache, char *buf)
+{
+  int regno = expedite_stack_regno;
+  unsigned char mem[MAX_EXPEDITE_STACK_LENGTH + 512];
+  CORE_ADDR sp, addr;
+  int size, len;
+
+  if (expedite_stack_length == 0
+      || regno < 0 || regno >= regcache->tdesc->num_registers)
+    return buf;
+
+  size = register_size (regcache->tdesc, regno);
+  if (size == 4)
+    {
+      uint32_t val;
+
+      collect_register (regcache, regno, &val);
+      sp = val;
+    }
+  else if (size == 8)
+    {
+      uint64_t val;
+
+      collect_register (regcache, regno, &val);
+      sp = val;
+    }
+  else
+    return buf;
+
+  addr = sp;
+  if (expedite_stack_align > 1 && expedite_stack_align <= 512)
+    addr &= ~(CORE_ADDR) (expedite_stack_align - 1);
+  len = expedite_stack_length + (sp - addr);
+
+  if (read_inferior_memory (addr, mem, len) != 0)
+    return buf;
+
+  sprintf (buf, "stack:%s,", paddress (addr));
+  buf += strlen (buf);
+  convert_int_to_ascii (mem, buf, len);
+  buf += 2 * len;
+  *buf++ = ';';
+  *buf = '\0';
+
+  return buf;
+}
+
 void
 prepare_resume_reply (char *buf, ptid_t ptid,
 		      struct target_waitstatus *status)
@@ -1364,6 +1597,8 @@ prepare_resume_reply (char *buf, ptid_t ptid,
 	  }
 	*buf = '\0';
 
+	buf = outstack (regcache, buf);
+
 	/* Formerly, if the debugger had not used any thread features
 	   we would not burden it with a thread status response.  This
 	   was for the benefit of GDB 4.13 and older.  However, in
@@ -1580,6 +1815,35 @@ clear_symbol_cache (struct sym_cache **symcache_p)
   *symcache_p = NULL;
 }
 
+/* Return the entry for NAME in the symbol cache of PROC, or NULL.  */
+
+static struct sym_cache *
+find_sym_cache (struct process_info *proc, const char *name)
+{
+  struct sym_cache *sym;
+
+  for (sym = proc->symbol_cache; sym; sym = sym->next)
+    if (strcmp (name, sym->name) == 0)
+      return sym;
+
+  return NULL;
+}
+
+/* Add NAME to the symbol cache of PROC.  */
+
+static void
+add_sym_cache (struct process_info *proc, const char *name,
+	       CORE_ADDR addr, int found)
+{
+  struct sym_cache *sym = xmalloc (sizeof (*sym));
+
+  sym->name = xstrdup (name);
+  sym->addr = addr;
+  sym->found = found;
+  sym->next = proc->symbol_cache;
+  proc->symbol_cache = sym;
+}
+
 /* Get the address of NAME, and return it in ADDRP if found.  if
    MAY_ASK_GDB is false, assume symbol cache misses are failures.
    Returns 1 if the symbol is found, 0 if it is not, -1 on error.  */
@@ -1595,12 +1859,14 @@ look_up_one_symbol (const char *name, CORE_ADDR *addrp, int may_ask_gdb)
   proc = current_process ();
 
   /* Check the cache first.  */
-  for (sym = proc->symbol_cache; sym; sym = sym->next)
-    if (strcmp (name, sym->name) == 0)
-      {
-	*addrp = sym->addr;
-	return 1;
-      }
+  sym = find_sym_cache (proc, name);
+  if (sym != NULL)
+    {
+      if (!sym->found)
+	return 0;
+      *addrp = sym->addr;
+      return 1;
+    }
 
   /* It might not be an appropriate time to look up a symbol,
      e.g. while we're trying to fetch registers.  */
@@ -1661,15 +1927,171 @@ look_up_one_symbol (const char *name, CORE_ADDR *addrp, int may_ask_gdb)
   decode_address (addrp, p, q - p);
 
   /* Save the symbol in our cache.  */
-  sym = xmalloc (sizeof (*sym));
-  sym->name = xstrdup (name);
-  sym->addr = *addrp;
-  sym->next = proc->symbol_cache;
-  proc->symbol_cache = sym;
+  add_sym_cache (proc, name, *addrp, 1);
 
   return 1;
 }
 
+/* Send the qSymbols request in OWN_BUF, and store the symbols GDB
+   reports in the cache of PROC.  OWN_BUF must have room for PBUFSIZ
+   bytes.  Return 0 on success, -1 on error.  */
+
+static int
+send_qsymbols (struct process_info *proc, char *own_buf)
+{
+  char *p;
+
+  if (putpkt (own_buf) < 0 || getpkt (own_buf) < 0)
+    return -1;
+
+  /* Let GDB read memory while it looks up the symbols, as in
+     look_up_one_symbol.  */
+  while (own_buf[0] == 'm')
+    {
+      CORE_ADDR mem_addr;
+      unsigned char *mem_buf;
+      unsigned int mem_len;
+
+      decode_m_packet (&own_buf[1], &mem_addr, &mem_len);
+      mem_buf = xmalloc (mem_len);
+      if (read_inferior_memory (mem_addr, mem_buf, mem_len) == 0)
+	convert_int_to_ascii (mem_buf, own_buf, mem_len);
+      else
+	write_enn (own_buf);
+      free (mem_buf);
+      if (putpkt (own_buf) < 0 || getpkt (own_buf) < 0)
+	return -1;
+    }
+
+  if (strncmp (own_buf, "qSymbols:", strlen ("qSymbols:")) != 0)
+    {
+      warning ("Malformed response to qSymbols, ignoring: %s\n", own_buf);
+      return -1;
+    }
+
+  /* Each entry is "VALUE:HEXNAME", VALUE being empty for the symbols
+     GDB does not know.  */
+  p = own_buf + strlen ("qSymbols:");
+  while (*p != '\0')
+    {
+      char *colon = strchr (p, ':');
+      char *end, *name;
+      CORE_ADDR addr = 0;
+      int len;
+
+      if (colon == NULL)
+	{
+	  warning ("Malformed response to qSymbols, ignoring: %s\n", p);
+	  return -1;
+	}
+
+      end = strchr (colon, ';');
+      if (end == NULL)
+	end = colon + strlen (colon);
+
+      len = (end - colon - 1) / 2;
+      name = xmalloc (len + 1);
+      unhexify (name, colon + 1, len);
+      name[len] = '\0';
+
+      if (colon != p)
+	decode_address (&addr, p, colon - p);
+      if (find_sym_cache (proc, name) == NULL)
+	add_sym_cache (proc, name, addr, colon != p);
+      free (name);
+
+      p = *end == ';' ? end + 1 : end;
+    }
+
+  return 0;
+}
+
+/* Ask GDB for the COUNT symbols in NAMES that are not in the cache
+   yet, with as few qSymbols requests as possible.  The results, found
+   or not, go to the cache, where look_up_one_symbol then finds them.
+   Does nothing if GDB cannot answer qSymbols.  Return 0 on success,
+   -1 on error.  */
+
+int
+look_up_symbols (const char **names, int count)
+{
+  struct process_info *proc = current_process ();
+  char *own_buf;
+  int i, len, entries, ret = 0;
+  /* Room needed in GDB's reply for the value of an entry.  */
+  int value_len = 2 * sizeof (CORE_ADDR) + 1;
+
+  if (!batch_symbol_lookups)
+    return 0;
+
+  own_buf = xmalloc (PBUFSIZ);
+  strcpy (own_buf, "qSymbols:");
+  len = strlen (own_buf);
+  entries = 0;
+
+  for (i = 0; i < count; i++)
+    {
+      int name_len = 2 * strlen (names[i]);
+
+      if (find_sym_cache (proc, names[i]) != NULL)
+	continue;
+
+      /* Both the request and GDB's reply, which is longer, must fit in
+	 a packet.  */
+      if (entries > 0
+	  && len + 1 + name_len + (entries + 1) * value_len >= PBUFSIZ - 1)
+	{
+	  if (send_qsymbols (proc, own_buf) < 0)
+	    {
+	      ret = -1;
+	      break;
+	    }
+	  strcpy (own_buf, "qSymbols:");
+	  len = strlen (own_buf);
+	  entries = 0;
+	}
+
+      if (len + 1 + name_len + (entries + 1) * value_len >= PBUFSIZ - 1)
+	continue;
+
+      if (entries > 0)
+	own_buf[len++] = ';';
+      hexify (own_buf + len, names[i], strlen (names[i]));
+      len += name_len;
+      own_buf[len] = '\0';
+      entries++;
+    }
+
+  if (ret == 0 && entries > 0)
+    ret = send_qsymbols (proc, own_buf);
+
+  free (own_buf);
+  return ret;
+}
+
+/* Drop from the cache the symbols GDB did not know, as it may know
+   them now that it loaded new symbols.  */
+
+void
+forget_missing_symbols (void)
+{
+  struct process_info *proc = current_process ();
+  struct sym_cache **symp = &proc->symbol_cache;
+
+  while (*symp != NULL)
+    {
+      struct sym_cache *sym = *symp;
+
+      if (sym->found)
+	symp = &sym->next;
+      else
+	{
+	  *symp = sym->next;
+	  free_sym_cache (sym);
+	}
+    }
+}
+
 /* Relocate an instruction to execute at a different address.  OLDLOC
    is the address in the inferior memory where the instruction to
    relocate is currently at.  On input, TO points to the destination
@@ -22,6 +22,8 @@
 extern int remote_debug;
 extern int noack_mode;
 extern int transport_is_reliable;
+extern int compress_packets;
+extern int batch_symbol_lookups;
 
 int gdb_connected (void);
 
@@ -77,6 +79,8 @@ char *unpack_varlen_hex (char *buff,  ULONGEST *result);
 
 void clear_symbol_cache (struct sym_cache **symcache_p);
 int look_up_one_symbol (const char *name, CORE_ADDR *addrp, int may_ask_gdb);
+int look_up_symbols (const char **names, int count);
+void forget_missing_symbols (void);
 
 int relocate_instruction (CORE_ADDR *to, CORE_ADDR oldloc);
 
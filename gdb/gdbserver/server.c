@@ -110,6 +110,14 @@ int disable_packet_Tthread;
 int disable_packet_qC;
 int disable_packet_qfThreadInfo;
 
+/* The stack memory GDB asked to have in stop replies with
+   QExpediteStack: EXPEDITE_STACK_LENGTH bytes from the value of
+   register EXPEDITE_STACK_REGNO, rounded down to a multiple of
+   EXPEDITE_STACK_ALIGN.  A zero length means none.  */
+int expedite_stack_regno;
+unsigned int expedite_stack_length;
+unsigned int expedite_stack_align;
+
 /* Last status reported to GDB.  */
 static struct target_waitstatus last_status;
 static ptid_t last_ptid;
@@ -538,6 +546,29 @@ handle_general_set (char *own_buf)
       return;
     }
 
+  if (strncmp ("QExpediteStack:", own_buf, strlen ("QExpediteStack:")) == 0)
+    {
+      const char *p = own_buf + strlen ("QExpediteStack:");
+      ULONGEST regno, length, align;
+
+      p = unpack_varlen_hex ((char *) p, &regno);
+      if (*p++ == ','
+	  && *(p = unpack_varlen_hex ((char *) p, &length)) == ','
+	  && *unpack_varlen_hex ((char *) p + 1, &align) == '\0'
+	  && (align & (align - 1)) == 0)
+	{
+	  expedite_stack_regno = regno;
+	  if (length > MAX_EXPEDITE_STACK_LENGTH)
+	    length = MAX_EXPEDITE_STACK_LENGTH;
+	  expedite_stack_length = length;
+	  expedite_stack_align = align;
+	  write_ok (own_buf);
+	}
+      else
+	write_enn (own_buf);
+      return;
+    }
+
   if (strcmp (own_buf, "QStartNoAckMode") == 0)
     {
       if (remote_debug)
@@ -764,23 +795,31 @@ gdb_write_memory (CORE_ADDR memaddr, const unsigned char *myaddr, int len)
     }
 }
 
-/* Subroutine of handle_search_memory to simplify it.  */
+/* Subroutine of handle_search_memory to simplify it.  Search
+   SEARCH_SPACE_LEN bytes at START_ADDR for PATTERN.  Return 1 and set
+   *FOUND_ADDRP if found, 0 if not, or -1 if a read failed, setting
+   *READ_ADDRP and *READ_LENP to the failed read and *RESUME_ADDRP to
+   the address from which the search did not complete.  */
 
 static int
 handle_search_memory_1 (CORE_ADDR start_addr, CORE_ADDR search_space_len,
 			gdb_byte *pattern, unsigned pattern_len,
 			gdb_byte *search_buf,
 			unsigned chunk_size, unsigned search_buf_size,
-			CORE_ADDR *found_addrp)
+			CORE_ADDR *found_addrp, CORE_ADDR *resume_addrp,
+			CORE_ADDR *read_addrp, unsigned *read_lenp)
 {
+  if (search_space_len < search_buf_size)
+    search_buf_size = search_space_len;
+
   /* Prime the search buffer.  */
 
   if (gdb_read_memory (start_addr, search_buf, search_buf_size)
       != search_buf_size)
     {
-      warning ("Unable to access %ld bytes of target "
-	       "memory at 0x%lx, halting search.",
-	       (long) search_buf_size, (long) start_addr);
+      *resume_addrp = start_addr;
+      *read_addrp = start_addr;
+      *read_lenp = search_buf_size;
       return -1;
     }
 
@@ -829,11 +868,11 @@ handle_search_memory_1 (CORE_ADDR start_addr, CORE_ADDR search_space_len,
 			: chunk_size);
 
 	  if (gdb_read_memory (read_addr, search_buf + keep_len,
-			       nr_to_read) != search_buf_size)
+			       nr_to_read) != nr_to_read)
 	    {
-	      warning ("Unable to access %ld bytes of target memory "
-		       "at 0x%lx, halting search.",
-		       (long) nr_to_read, (long) read_addr);
+	      *resume_addrp = start_addr + chunk_size;
+	      *read_addrp = read_addr;
+	      *read_lenp = nr_to_read;
 	      return -1;
 	    }
 
@@ -846,6 +885,86 @@ handle_search_memory_1 (CORE_ADDR start_addr, CORE_ADDR search_space_len,
   return 0;
 }
 
+/* The state of handle_search_memory while searching the readable
+   regions of memory, for search_memory_region.  */
+
+struct search_memory_state
+{
+  /* The part of the search space left to search, [START, END).  */
+  CORE_ADDR start;
+  CORE_ADDR end;
+
+  /* The end of the last readable region seen, so that a region
+     contiguous with it is searched together with it, since a pattern
+     may straddle them.  */
+  CORE_ADDR region_end;
+
+  gdb_byte *pattern;
+  unsigned pattern_len;
+  gdb_byte *search_buf;
+  unsigned chunk_size;
+  unsigned search_buf_size;
+
+  /* The result so far, and the details that go with it.  */
+  int found;
+  CORE_ADDR found_addr;
+  CORE_ADDR read_addr;
+  unsigned read_len;
+};
+
+/* Search what's left of STATE->START .. STATE->END below the end of
+   the readable memory seen so far.  Return nonzero once the search is
+   over.  */
+
+static int
+search_memory_flush (struct search_memory_state *state)
+{
+  CORE_ADDR hi = (state->region_end < state->end
+		  ? state->region_end : state->end);
+  CORE_ADDR resume_addr;
+
+  if (hi > state->start && hi - state->start >= state->pattern_len)
+    state->found = handle_search_memory_1 (state->start, hi - state->start,
+					   state->pattern, state->pattern_len,
+					   state->search_buf,
+					   state->chunk_size,
+					   state->search_buf_size,
+					   &state->found_addr, &resume_addr,
+					   &state->read_addr,
+					   &state->read_len);
+  if (hi > state->start)
+    state->start = hi;
+
+  return state->found != 0 || state->start >= state->end;
+}
+
+/* A find_memory_region_callback searching the readable regions in
+   turn, skipping the unmapped gaps between them.  DATA is a struct
+   search_memory_state.  */
+
+static int
+search_memory_region (CORE_ADDR addr, CORE_ADDR size, int readable,
+		      void *data)
+{
+  struct search_memory_state *state = data;
+
+  if (!readable || size == 0)
+    return 0;
+
+  /* Search what was readable before this region, unless it continues
+     right here.  */
+  if (addr != state->region_end)
+    {
+      if (search_memory_flush (state))
+	return 1;
+
+      if (addr > state->start)
+	state->start = addr;
+    }
+  state->region_end = addr + size;
+  return 0;
+}
+
 /* Handle qSearch:memory packets.  */
 
 static void
@@ -856,13 +975,14 @@ handle_search_memory (char *own_buf, int packet_len)
   gdb_byte *pattern;
   unsigned int pattern_len;
   /* NOTE: also defined in find.c testcase.  */
-#define SEARCH_CHUNK_SIZE 16000
+#define SEARCH_CHUNK_SIZE (1024 * 1024)
   const unsigned chunk_size = SEARCH_CHUNK_SIZE;
   /* Buffer to hold memory contents for searching.  */
   gdb_byte *search_buf;
   unsigned search_buf_size;
   int found;
-  CORE_ADDR found_addr;
+  CORE_ADDR found_addr, resume_addr, read_addr;
+  unsigned read_len;
   int cmd_name_len = sizeof ("qSearch:memory:") - 1;
 
   pattern = malloc (packet_len);
@@ -901,14 +1021,49 @@ handle_search_memory (char *own_buf, int packet_len)
   found = handle_search_memory_1 (start_addr, search_space_len,
 				  pattern, pattern_len,
 				  search_buf, chunk_size, search_buf_size,
-				  &found_addr);
+				  &found_addr, &resume_addr,
+				  &read_addr, &read_len);
+
+  /* If some memory of the live process can't be read, search the rest
+     of its readable regions only.  */
+  if (found < 0 && current_traceframe < 0)
+    {
+      struct search_memory_state state;
+
+      memset (&state, 0, sizeof (state));
+      state.start = resume_addr;
+      state.end = start_addr + search_space_len;
+      if (state.end < start_addr)
+	state.end = (CORE_ADDR) -1;
+      state.pattern = pattern;
+      state.pattern_len = pattern_len;
+      state.search_buf = search_buf;
+      state.chunk_size = chunk_size;
+      state.search_buf_size = search_buf_size;
+
+      if (target_find_memory_regions (search_memory_region, &state) == 0)
+	{
+	  if (state.found == 0 && state.start < state.end)
+	    search_memory_flush (&state);
+
+	  found = state.found;
+	  found_addr = state.found_addr;
+	  read_addr = state.read_addr;
+	  read_len = state.read_len;
+	}
+    }
 
   if (found > 0)
     sprintf (own_buf, "1,%lx", (long) found_addr);
   else if (found == 0)
     strcpy (own_buf, "0");
   else
-    strcpy (own_buf, "E00");
+    {
+      warning ("Unable to access %ld bytes of target "
+	       "memory at 0x%lx, halting search.",
+	       (long) read_len, (long) read_addr);
+      strcpy (own_buf, "E00");
+    }
 
   free (search_buf);
   free (pattern);
@@ -1041,6 +1196,80 @@ handle_qxfer_features (const char *annex,
   return len;
 }
 
+/* Fold LEN bytes at BUF into the 64-bit FNV-1a hash HASH.  */
+
+static ULONGEST
+features_hash_buffer (const char *buf, size_t len, ULONGEST hash)
+{
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    {
+      hash ^= (unsigned char) buf[i];
+      hash *= 0x100000001b3ULL;
+    }
+
+  return hash;
+}
+
+/* Handle qXfer:features-hash:read.  The reply is a hex digest that
+   changes whenever the document named by ANNEX, or any document it
+   may include, changes.  GDB uses it to recognize a target
+   description it has already fetched and parsed.  */
+
+static int
+handle_qxfer_features_hash (const char *annex,
+			    gdb_byte *readbuf, const gdb_byte *writebuf,
+			    ULONGEST offset, LONGEST len)
+{
+  const char *document;
+  ULONGEST hash = 0xcbf29ce484222325ULL;
+  char digest[17];
+  size_t total_len;
+
+  if (writebuf != NULL)
+    return -2;
+
+  if (!target_running ())
+    return -1;
+
+  document = get_features_xml (annex);
+  if (document == NULL)
+    return -1;
+
+  /* Include the terminating NUL of each piece, so that moving text
+     from one document into the next still changes the digest.  */
+  hash = features_hash_buffer (document, strlen (document) + 1, hash);
+
+#ifdef USE_XML
+  {
+    extern const char *const xml_builtin[][2];
+    int i;
+
+    for (i = 0; xml_builtin[i][0] != NULL; i++)
+      {
+	hash = features_hash_buffer (xml_builtin[i][0],
+				     strlen (xml_builtin[i][0]) + 1, hash);
+	hash = features_hash_buffer (xml_builtin[i][1],
+				     strlen (xml_builtin[i][1]) + 1, hash);
+      }
+  }
+#endif
+
+  sprintf (digest, "%08x%08x", (unsigned int) (hash >> 32),
+	   (unsigned int) (hash & 0xffffffff));
+  total_len = strlen (digest);
+
+  if (offset > total_len)
+    return -1;
+
+  if (offset + len > total_len)
+    len = total_len - offset;
+
+  memcpy (readbuf, digest + offset, len);
+  return len;
+}
+
 /* Handle qXfer:libraries:read.  */
 
 static int
@@ -1190,22 +1419,48 @@ handle_qxfer_statictrace (const char *annex,
   return nbytes;
 }
 
-/* Helper for handle_qxfer_threads.  */
+/* Helper for handle_qxfer_threads_proper.  Describe the removed
+   thread GDB_ID in the struct buffer BUFFER.  */
 
 static void
-handle_qxfer_threads_proper (struct buffer *buffer)
+handle_qxfer_exited_thread (ptid_t gdb_id, void *buffer)
+{
+  char ptid_s[100];
+
+  write_ptid (ptid_s, gdb_id);
+  buffer_xml_printf (buffer, "<exited id=\"%s\"/>\n", ptid_s);
+}
+
+/* Helper for handle_qxfer_threads.  Describe in BUFFER all threads,
+   or if DELTA_P, only the threads added and removed since generation
+   SINCE.  */
+
+static void
+handle_qxfer_threads_proper (struct buffer *buffer, int delta_p,
+			     unsigned long since)
 {
   struct inferior_list_entry *thread;
 
-  buffer_grow_str (buffer, "<threads>\n");
+  if (delta_p)
+    buffer_xml_printf (buffer,
+		       "<threads generation=\"%lu\" since=\"%lu\">\n",
+		       threads_generation, since);
+  else
+    buffer_xml_printf (buffer, "<threads generation=\"%lu\">\n",
+		       threads_generation);
 
   for (thread = all_threads.head; thread; thread = thread->next)
     {
       ptid_t ptid = thread_to_gdb_id ((struct thread_info *)thread);
       char ptid_s[100];
-      int core = target_core_of_thread (ptid);
+      int core;
       char core_s[21];
 
+      if (delta_p && ((struct thread_info *) thread)->generation <= since)
+	continue;
+
+      core = target_core_of_thread (ptid);
+
       write_ptid (ptid_s, ptid);
 
       if (core != -1)
@@ -1221,6 +1476,9 @@ handle_qxfer_threads_proper (struct buffer *buffer)
 	}
     }
 
+  if (delta_p)
+    for_each_exited_thread_since (since, handle_qxfer_exited_thread, buffer);
+
   buffer_grow_str0 (buffer, "</threads>\n");
 }
 
@@ -1234,10 +1492,27 @@ handle_qxfer_threads (const char *annex,
   static char *result = 0;
   static unsigned int result_length = 0;
 
+  unsigned long since = 0;
+  int delta_p = 0;
+
   if (writebuf != NULL)
     return -2;
 
-  if (!target_running () || annex[0] != '\0')
+  if (!target_running ())
+    return -1;
+
+  /* An annex of "since=GENERATION" asks for the changes since that
+     generation.  If they are not all known, send the whole list.  */
+  if (strncmp (annex, "since=", strlen ("since=")) == 0)
+    {
+      char *end;
+
+      since = strtoul (annex + strlen ("since="), &end, 10);
+      if (*end != '\0')
+	return -1;
+      delta_p = threads_delta_known_p (since);
+    }
+  else if (annex[0] != '\0')
     return -1;
 
   if (offset == 0)
@@ -1250,7 +1525,7 @@ handle_qxfer_threads (const char *annex,
 
       buffer_init (&buffer);
 
-      handle_qxfer_threads_proper (&buffer);
+      handle_qxfer_threads_proper (&buffer, delta_p, since);
 
       result = buffer_finish (&buffer);
       result_length = strlen (result);
@@ -1380,6 +1655,8 @@ handle_qxfer_btrace (const char *annex,
     type = btrace_read_all;
   else if (strcmp (annex, "new") == 0)
     type = btrace_read_new;
+  else if (strcmp (annex, "delta") == 0)
+    type = btrace_read_delta;
   else
     {
       strcpy (own_buf, "E.Bad annex.");
@@ -1412,6 +1689,7 @@ static const struct qxfer qxfer_packets[] =
     { "btrace", handle_qxfer_btrace },
     { "fdpic", handle_qxfer_fdpic},
     { "features", handle_qxfer_features },
+    { "features-hash", handle_qxfer_features_hash },
     { "libraries", handle_qxfer_libraries },
     { "libraries-svr4", handle_qxfer_libraries_svr4 },
     { "osdata", handle_qxfer_osdata },
@@ -1541,10 +1819,68 @@ handle_qxfer (char *own_buf, int packet_len, int *new_packet_len_p)
   return 0;
 }
 
-/* Table used by the crc32 function to calcuate the checksum.  */
+/* Tables used by the crc32 function to calculate the checksum.
+   CRC32_TABLE[0] is the usual byte at a time table;
+   CRC32_TABLE[K][I] is the CRC of byte I followed by K zero bytes,
+   which lets crc32 process eight bytes at a time.  */
+
+static unsigned int crc32_table[8][256];
+
+/* How many bytes of inferior memory crc32 reads at a time.  */
+
+#define CRC32_CHUNK_SIZE 65536
+
+/* Initialize CRC32_TABLE.  */
+
+static void
+init_crc32_table (void)
+{
+  int i, j, k;
+  unsigned int c;
+
+  for (i = 0; i < 256; i++)
+    {
+      for (c = i << 24, j = 8; j > 0; --j)
+	c = c & 0x80000000 ? (c << 1) ^ 0x04c11db7 : (c << 1);
+      crc32_table[0][i] = c;
+    }
+
+  for (k = 1; k < 8; k++)
+    for (i = 0; i < 256; i++)
+      {
+	c = crc32_table[k - 1][i];
+	crc32_table[k][i] = (c << 8) ^ crc32_table[0][c >> 24];
+      }
+}
+
+/* Update CRC with the LEN bytes at BUF.  */
+
+static unsigned int
+crc32_buffer (const unsigned char *buf, size_t len, unsigned int crc)
+{
+  /* Eight bytes at a time: the first four are combined with the CRC,
+     and the last four only need the table of their position.  */
+  while (len >= 8)
+    {
+      crc ^= ((unsigned int) buf[0] << 24 | (unsigned int) buf[1] << 16
+	      | (unsigned int) buf[2] << 8 | buf[3]);
+      crc = (crc32_table[7][crc >> 24]
+	     ^ crc32_table[6][(crc >> 16) & 255]
+	     ^ crc32_table[5][(crc >> 8) & 255]
+	     ^ crc32_table[4][crc & 255]
+	     ^ crc32_table[3][buf[4]]
+	     ^ crc32_table[2][buf[5]]
+	     ^ crc32_table[1][buf[6]]
+	     ^ crc32_table[0][buf[7]]);
+      buf += 8;
+      len -= 8;
+    }
+
+  while (len--)
+    crc = (crc << 8) ^ crc32_table[0][((crc >> 24) ^ *buf++) & 255];
 
-static unsigned int crc32_table[256] =
-{0, 0};
+  return crc;
+}
 
 /* Compute 32 bit CRC from inferior memory.
 
@@ -1552,34 +1888,146 @@ static unsigned int crc32_table[256] =
    On failure, return (unsigned long long) -1.  */
 
 static unsigned long long
-crc32 (CORE_ADDR base, int len, unsigned int crc)
+crc32 (CORE_ADDR base, ULONGEST len, unsigned int crc)
 {
-  if (!crc32_table[1])
+  unsigned char *buf;
+
+  if (!crc32_table[0][1])
+    init_crc32_table ();
+
+  buf = xmalloc (len < CRC32_CHUNK_SIZE ? len : CRC32_CHUNK_SIZE);
+  while (len > 0)
     {
-      /* Initialize the CRC table and the decoding table.  */
-      int i, j;
-      unsigned int c;
+      int todo = len < CRC32_CHUNK_SIZE ? len : CRC32_CHUNK_SIZE;
 
-      for (i = 0; i < 256; i++)
+      /* Return failure if memory read fails.  */
+      if (read_inferior_memory (base, buf, todo) != 0)
 	{
-	  for (c = i << 24, j = 8; j > 0; --j)
-	    c = c & 0x80000000 ? (c << 1) ^ 0x04c11db7 : (c << 1);
-	  crc32_table[i] = c;
+	  free (buf);
+	  return (unsigned long long) -1;
 	}
+
+      crc = crc32_buffer (buf, todo, crc);
+      base += todo;
+      len -= todo;
     }
 
-  while (len--)
+  free (buf);
+  return (unsigned long long) crc;
+}
+
+/* Handle a "qCRC:ADDR,LENGTH[;ADDR,LENGTH]..." packet in OWN_BUF:
+   reply with "C" and the CRC of each range, or "E01" for the ranges
+   that can't be read, separated by ';'.  Stop early at the ranges
+   whose reply would overflow the packet.  */
+
+static void
+handle_qcrc (char *own_buf)
+{
+  char *p = own_buf + strlen ("qCRC:");
+  char *reply, *out;
+  int first = 1;
+
+  /* Build the reply apart, since it may be longer than the
+     request.  */
+  reply = xmalloc (PBUFSIZ);
+  out = reply;
+  while (*p != '\0')
     {
-      unsigned char byte = 0;
+      ULONGEST base, len;
+      unsigned long long crc;
 
-      /* Return failure if memory read fails.  */
-      if (read_inferior_memory (base, &byte, 1) != 0)
-	return (unsigned long long) -1;
+      if (!first)
+	{
+	  if (*p++ != ';')
+	    break;
 
-      crc = (crc << 8) ^ crc32_table[((crc >> 24) ^ byte) & 255];
-      base++;
+	  /* Room for ';', 'C' and 8 hex digits.  */
+	  if (out - reply + 10 >= PBUFSIZ)
+	    break;
+	}
+
+      p = unpack_varlen_hex (p, &base);
+      if (*p++ != ',')
+	{
+	  if (first)
+	    {
+	      free (reply);
+	      write_enn (own_buf);
+	      return;
+	    }
+	  break;
+	}
+      p = unpack_varlen_hex (p, &len);
+
+      crc = crc32 (base, len, 0xffffffff);
+
+      if (!first)
+	*out++ = ';';
+      /* Check for memory failure.  */
+      if (crc == (unsigned long long) -1)
+	out += sprintf (out, "E01");
+      else
+	out += sprintf (out, "C%lx", (unsigned long) crc);
+      first = 0;
     }
-  return (unsigned long long) crc;
+
+  strcpy (own_buf, reply);
+  free (reply);
+}
+
+/* Handle a "qRegs:THREAD-ID;THREAD-ID..." packet in OWN_BUF: reply
+   with the 'g' packet contents of each listed thread, separated by
+   ';', or "E01" for the threads whose registers can't be read.  Stop
+   early at the threads which would overflow the packet.  */
+
+static void
+handle_qregs (char *own_buf)
+{
+  struct thread_info *saved_inferior = current_inferior;
+  char *request = xstrdup (own_buf + strlen ("qRegs:"));
+  char *p = request;
+  char *out = own_buf;
+
+  while (*p != '\0')
+    {
+      ptid_t gdb_id = read_ptid (p, &p);
+      struct thread_info *thread = find_thread_ptid (gdb_id);
+      struct regcache *regcache = NULL;
+      int len;
+
+      if (thread != NULL
+	  && (!non_stop || the_target->thread_stopped == NULL
+	      || thread_stopped (thread)))
+	{
+	  current_inferior = thread;
+	  regcache = get_thread_regcache (thread, 1);
+	}
+
+      len = regcache != NULL ? 2 * register_cache_size (regcache->tdesc) : 3;
+      if (out + len + 1 >= own_buf + PBUFSIZ - 1)
+	break;
+
+      if (out != own_buf)
+	*out++ = ';';
+      if (regcache != NULL)
+	registers_to_string (regcache, out);
+      else
+	strcpy (out, "E01");
+      out += len;
+
+      if (*p != ';')
+	break;
+      p++;
+    }
+  *out = '\0';
+
+  /* An empty reply would mean that qRegs is not supported.  */
+  if (out == own_buf)
+    write_enn (own_buf);
+
+  current_inferior = saved_inferior;
+  free (request);
 }
 
 /* Handle all of the extended 'q' packets.  */
@@ -1610,6 +2058,16 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
       return;
     }
 
+  if (strncmp ("qRegs:", own_buf, strlen ("qRegs:")) == 0)
+    {
+      require_running (own_buf);
+      if (current_traceframe >= 0)
+	write_enn (own_buf);
+      else
+	handle_qregs (own_buf);
+      return;
+    }
+
   if (strcmp ("qSymbol::", own_buf) == 0)
     {
       /* GDB is suggesting new symbols have been loaded.  This may
@@ -1624,6 +2082,10 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 	 we access breakpoint shadows.  */
       validate_breakpoints ();
 
+      /* GDB may now know symbols it did not know before.  */
+      if (target_running ())
+	forget_missing_symbols ();
+
       if (target_supports_tracepoints ())
 	tracepoint_look_up_symbols ();
 
@@ -1695,6 +2157,8 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 
       /* Start processing qSupported packet.  */
       target_process_qsupported (NULL);
+      compress_packets = 0;
+      batch_symbol_lookups = 0;
 
       /* Process each feature being provided by GDB.  The first
 	 feature will follow a ':', and latter features will follow
@@ -1726,6 +2190,18 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 		  if (target_supports_multi_process ())
 		    multi_process = 1;
 		}
+#if HAVE_ZLIB_H
+	      else if (strcmp (p, "zlib-compression+") == 0)
+		{
+		  /* GDB can decompress our packets.  */
+		  compress_packets = 1;
+		}
+#endif
+	      else if (strcmp (p, "qSymbols+") == 0)
+		{
+		  /* GDB can look up many symbols at once.  */
+		  batch_symbol_lookups = 1;
+		}
 	      else if (strcmp (p, "qRelocInsn+") == 0)
 		{
 		  /* GDB supports relocate instruction requests.  */
@@ -1771,9 +2247,31 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 	 If we reported to GDB on startup that we don't support
 	 qXfer:feature:read at all, we will never be re-queried.  */
       strcat (own_buf, ";qXfer:features:read+");
+      strcat (own_buf, ";qXfer:features-hash:read+");
 
       if (transport_is_reliable)
-	strcat (own_buf, ";QStartNoAckMode+");
+	{
+	  strcat (own_buf, ";QStartNoAckMode+");
+
+	  /* Packets are read from a buffer and answered in order, so
+	     GDB may send several memory reads before the first
+	     reply.  */
+	  strcat (own_buf, ";MemoryReadWindow=10");
+	}
+
+      strcat (own_buf, ";binary-upload+");
+
+      strcat (own_buf, ";QExpediteStack+");
+
+      strcat (own_buf, ";qRegs+");
+
+      strcat (own_buf, ";qCRC:ranges+");
+
+      if (batch_symbol_lookups)
+	strcat (own_buf, ";qSymbols+");
+
+      if (compress_packets)
+	strcat (own_buf, ";zlib-compression+");
 
       if (the_target->qxfer_osdata != NULL)
 	strcat (own_buf, ";qXfer:osdata:read+");
@@ -1803,6 +2301,7 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 	  strcat (own_buf, ";qXfer:traceframe-info:read+");
 	  strcat (own_buf, ";EnableDisableTracepoints+");
 	  strcat (own_buf, ";QTBuffer:size+");
+	  strcat (own_buf, ";qTBufferBin+");
 	  strcat (own_buf, ";tracenz+");
 	}
 
@@ -1980,34 +2479,16 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
   if (strncmp ("qCRC:", own_buf, 5) == 0)
     {
       /* CRC check (compare-section).  */
-      char *comma;
-      ULONGEST base;
-      int len;
-      unsigned long long crc;
-
       require_running (own_buf);
-      comma = unpack_varlen_hex (own_buf + 5, &base);
-      if (*comma++ != ',')
-	{
-	  write_enn (own_buf);
-	  return;
-	}
-      len = strtoul (comma, NULL, 16);
-      crc = crc32 (base, len, 0xffffffff);
-      /* Check for memory failure.  */
-      if (crc == (unsigned long long) -1)
-	{
-	  write_enn (own_buf);
-	  return;
-	}
-      sprintf (own_buf, "C%lx", (unsigned long) crc);
+      handle_qcrc (own_buf);
       return;
     }
 
   if (handle_qxfer (own_buf, packet_len, new_packet_len_p))
     return;
 
-  if (target_supports_tracepoints () && handle_tracepoint_query (own_buf))
+  if (target_supports_tracepoints ()
+      && handle_tracepoint_query (own_buf, new_packet_len_p))
     return;
 
   /* Otherwise we didn't know what packet it was.  Say we didn't
@@ -2596,8 +3077,9 @@ gdbserver_usage (FILE *stream)
 	   "\tgdbserver [OPTIONS] --attach COMM PID\n"
 	   "\tgdbserver [OPTIONS] --multi COMM\n"
 	   "\n"
-	   "COMM may either be a tty device (for serial debugging), or \n"
-	   "HOST:PORT to listen for a TCP connection.\n"
+	   "COMM may either be a tty device (for serial debugging),\n"
+	   "HOST:PORT to listen for a TCP connection, or shm:FILE to\n"
+	   "listen for a shared memory connection from GDB on this host.\n"
 	   "\n"
 	   "Options:\n"
 	   "  --debug               Enable general debugging output.\n"
@@ -2966,6 +3448,7 @@ main (int argc, char *argv[])
     {
       noack_mode = 0;
       multi_process = 0;
+      expedite_stack_length = 0;
       /* Be sure we're out of tfind mode.  */
       current_traceframe = -1;
 
@@ -3350,6 +3833,27 @@ process_serial_event (void)
       else
 	convert_int_to_ascii (mem_buf, own_buf, res);
       break;
+    case 'x':
+      require_running (own_buf);
+      decode_m_packet (&own_buf[1], &mem_addr, &len);
+      if (len > PBUFSIZ - 2)
+	len = PBUFSIZ - 2;
+      res = gdb_read_memory (mem_addr, mem_buf, len);
+      if (res < 0)
+	write_enn (own_buf);
+      else
+	{
+	  int out_len;
+
+	  /* Send as much of the data as fits once escaped; GDB asks
+	     again for the rest.  */
+	  own_buf[0] = 'b';
+	  new_packet_len
+	    = remote_escape_output (mem_buf, res,
+				    (unsigned char *) own_buf + 1,
+				    &out_len, PBUFSIZ - 2) + 1;
+	}
+      break;
     case 'M':
       require_running (own_buf);
       decode_M_packet (&own_buf[1], &mem_addr, &len, &mem_buf);
@@ -3592,14 +4096,24 @@ handle_target_event (int err, gdb_client_data client_data)
   if (debug_threads)
     fprintf (stderr, "handling possible target event\n");
 
-  last_ptid = mywait (minus_one_ptid, &last_status,
-		      TARGET_WNOHANG, 1);
-
-  if (last_status.kind != TARGET_WAITKIND_IGNORE)
+  /* Handle all the events the target has ready, so that in non-stop
+     the stop notifications of several threads or processes are queued
+     at once, rather than one per trip through the event loop.  */
+  while (1)
     {
-      int pid = ptid_get_pid (last_ptid);
-      struct process_info *process = find_process_pid (pid);
-      int forward_event = !gdb_connected () || process->gdb_detached;
+      int pid;
+      struct process_info *process;
+      int forward_event;
+
+      last_ptid = mywait (minus_one_ptid, &last_status,
+			  TARGET_WNOHANG, 1);
+
+      if (last_status.kind == TARGET_WAITKIND_IGNORE)
+	break;
+
+      pid = ptid_get_pid (last_ptid);
+      process = find_process_pid (pid);
+      forward_event = !gdb_connected () || process->gdb_detached;
 
       if (last_status.kind == TARGET_WAITKIND_EXITED
 	  || last_status.kind == TARGET_WAITKIND_SIGNALLED)
@@ -125,6 +125,13 @@ extern int disable_packet_Tthread;
 extern int disable_packet_qC;
 extern int disable_packet_qfThreadInfo;
 
+/* The most stack memory included in a stop reply.  */
+#define MAX_EXPEDITE_STACK_LENGTH 2048
+
+extern int expedite_stack_regno;
+extern unsigned int expedite_stack_length;
+extern unsigned int expedite_stack_align;
+
 extern int run_once;
 extern int multi_process;
 extern int non_stop;
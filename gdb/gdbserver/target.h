@@ -59,6 +59,12 @@ struct thread_resume
   CORE_ADDR step_range_end;	/* Exclusive */
 };
 
+/* The type of the callback passed to the find_memory_regions target
+   method.  */
+
+typedef int (*find_memory_region_callback) (CORE_ADDR addr, CORE_ADDR size,
+					    int readable, void *data);
+
 struct target_ops
 {
   /* Start a new process.
@@ -305,13 +311,15 @@ struct target_ops
   /* Install a fast tracepoint jump pad.  TPOINT is the address of the
      tracepoint internal object as used by the IPA agent.  TPADDR is
      the address of tracepoint.  COLLECTOR is address of the function
-     the jump pad redirects to.  LOCKADDR is the address of the jump
-     pad lock object.  ORIG_SIZE is the size in bytes of the
-     instruction at TPADDR.  JUMP_ENTRY points to the address of the
-     jump pad entry, and on return holds the address past the end of
-     the created jump pad.  If a trampoline is created by the function,
-     then TRAMPOLINE and TRAMPOLINE_SIZE return the address and size of
-     the trampoline, else they remain unchanged.  JJUMP_PAD_INSN is a
+     the jump pad redirects to.  COLLECTING_OFFSET is the offset from
+     the thread area of the in-process agent's thread-local slot
+     where the jump pad records that the thread is collecting.
+     ORIG_SIZE is the size in bytes of the instruction at TPADDR.
+     JUMP_ENTRY points to the address of the jump pad entry, and on
+     return holds the address past the end of the created jump pad.
+     If a trampoline is created by the function, then TRAMPOLINE and
+     TRAMPOLINE_SIZE return the address and size of the trampoline,
+     else they remain unchanged.  JJUMP_PAD_INSN is a
      buffer containing a copy of the instruction at TPADDR.
      ADJUST_INSN_ADDR and ADJUST_INSN_ADDR_END are output parameters that
      return the address range where the instruction at TPADDR was relocated
@@ -319,7 +327,7 @@ struct target_ops
      message.  */
   int (*install_fast_tracepoint_jump_pad) (CORE_ADDR tpoint, CORE_ADDR tpaddr,
 					   CORE_ADDR collector,
-					   CORE_ADDR lockaddr,
+					   int collecting_offset,
 					   ULONGEST orig_size,
 					   CORE_ADDR *jump_entry,
 					   CORE_ADDR *trampoline,
@@ -365,6 +373,20 @@ struct target_ops
 
   /* Return true if target supports range stepping.  */
   int (*supports_range_stepping) (void);
+
+  /* Return true if fetching one register of a thread only fetches
+     the registers transferred together with it, and storing all the
+     registers only stores those the register cache marks dirty, so
+     that the registers of a thread can be fetched as they are read.
+     Otherwise all the registers are fetched at once.  */
+  int (*supports_lazy_regcache) (void);
+
+  /* Call FUNC for each region of memory of the current process, with
+     its address, its size and whether it is readable.  Stop if FUNC
+     returns nonzero.  Return 0 on success, or -1 if the regions are
+     not known.  */
+  int (*find_memory_regions) (find_memory_region_callback func,
+			      void *data);
 };
 
 extern struct target_ops *the_target;
@@ -457,7 +479,7 @@ int kill_inferior (int);
     } while (0)
 
 #define install_fast_tracepoint_jump_pad(tpoint, tpaddr,		\
-					 collector, lockaddr,		\
+					 collector, collecting_offset,	\
 					 orig_size,			\
 					 jump_entry,			\
 					 trampoline, trampoline_size,	\
@@ -467,7 +489,8 @@ int kill_inferior (int);
 					 adjusted_insn_addr_end,	\
 					 err)				\
   (*the_target->install_fast_tracepoint_jump_pad) (tpoint, tpaddr,	\
-						   collector,lockaddr,	\
+						   collector,		\
+						   collecting_offset,	\
 						   orig_size, jump_entry, \
 						   trampoline,		\
 						   trampoline_size,	\
@@ -504,6 +527,14 @@ int kill_inferior (int);
   (the_target->supports_range_stepping ? \
    (*the_target->supports_range_stepping) () : 0)
 
+#define target_supports_lazy_regcache() \
+  (the_target->supports_lazy_regcache ? \
+   (*the_target->supports_lazy_regcache) () : 0)
+
+#define target_find_memory_regions(func, data) \
+  (the_target->find_memory_regions ? \
+   (*the_target->find_memory_regions) (func, data) : -1)
+
 /* Start non-stop mode, returns 0 on success, -1 on failure.   */
 
 int start_non_stop (int nonstop);
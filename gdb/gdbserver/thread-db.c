@@ -445,6 +445,20 @@ thread_db_find_new_threads (void)
     error ("Cannot find new threads: %s", thread_db_err_str (err));
 }
 
+/* Ask GDB for all the symbols in the NULL-terminated SYM_LIST at
+   once, if it can, so that the lookups libthread_db then makes one by
+   one are served from the cache.  */
+
+static void
+thread_db_prefetch_symbols (const char **sym_list)
+{
+  int count = 0;
+
+  while (sym_list[count] != NULL)
+    count++;
+  look_up_symbols (sym_list, count);
+}
+
 /* Cache all future symbols that thread_db might request.  We can not
    request symbols at arbitrary states in the remote protocol, only
    when the client tells us that new symbols are available.  So when
@@ -457,6 +471,7 @@ thread_db_look_up_symbols (void)
   const char **sym_list;
   CORE_ADDR unused;
 
+  thread_db_prefetch_symbols (thread_db->td_symbol_list_p ());
   for (sym_list = thread_db->td_symbol_list_p (); *sym_list; sym_list++)
     look_up_one_symbol (*sym_list, &unused, 1);
 
@@ -541,6 +556,9 @@ thread_db_load_search (void)
 
   tdb->td_ta_new_p = &td_ta_new;
 
+  /* td_ta_new looks up some of these symbols.  */
+  thread_db_prefetch_symbols (td_symbol_list ());
+
   /* Attempt to open a connection to the thread library.  */
   err = tdb->td_ta_new_p (&tdb->proc_handle, &tdb->thread_agent);
   if (err != TD_OK)
@@ -607,6 +625,10 @@ try_thread_db_load_1 (void *handle)
   while (0)
 
   CHK (1, tdb->td_ta_new_p = dlsym (handle, "td_ta_new"));
+  CHK (1, tdb->td_symbol_list_p = dlsym (handle, "td_symbol_list"));
+
+  /* td_ta_new looks up some of these symbols.  */
+  thread_db_prefetch_symbols (tdb->td_symbol_list_p ());
 
   /* Attempt to open a connection to the thread library.  */
   err = tdb->td_ta_new_p (&tdb->proc_handle, &tdb->thread_agent);
@@ -622,7 +644,6 @@ try_thread_db_load_1 (void *handle)
   CHK (1, tdb->td_ta_map_lwp2thr_p = dlsym (handle, "td_ta_map_lwp2thr"));
   CHK (1, tdb->td_thr_get_info_p = dlsym (handle, "td_thr_get_info"));
   CHK (1, tdb->td_ta_thr_iter_p = dlsym (handle, "td_ta_thr_iter"));
-  CHK (1, tdb->td_symbol_list_p = dlsym (handle, "td_symbol_list"));
 
   /* This is required only when thread_db_use_events is on.  */
   CHK (thread_db_use_events,
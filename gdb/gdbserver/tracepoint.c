@@ -88,10 +88,12 @@ trace_vdebug (const char *fmt, ...)
 #  define ATTR_USED __attribute__((used))
 #  define ATTR_NOINLINE __attribute__((noinline))
 #  define ATTR_CONSTRUCTOR __attribute__ ((constructor))
+#  define ATTR_INITIAL_EXEC __attribute__ ((tls_model ("initial-exec")))
 #else
 #  define ATTR_USED
 #  define ATTR_NOINLINE
 #  define ATTR_CONSTRUCTOR
+#  define ATTR_INITIAL_EXEC
 #endif
 
 /* Make sure the functions the IPA needs to export (symbols GDBserver
@@ -122,6 +124,7 @@ trace_vdebug (const char *fmt, ...)
 # define gdb_trampoline_buffer_end gdb_agent_gdb_trampoline_buffer_end
 # define gdb_trampoline_buffer_error gdb_agent_gdb_trampoline_buffer_error
 # define collecting gdb_agent_collecting
+# define collecting_offset gdb_agent_collecting_offset
 # define gdb_collect gdb_agent_gdb_collect
 # define stop_tracing gdb_agent_stop_tracing
 # define flush_trace_buffer gdb_agent_flush_trace_buffer
@@ -132,12 +135,9 @@ trace_vdebug (const char *fmt, ...)
 # define error_tracepoint gdb_agent_error_tracepoint
 # define tracepoints gdb_agent_tracepoints
 # define tracing gdb_agent_tracing
-# define trace_buffer_ctrl gdb_agent_trace_buffer_ctrl
-# define trace_buffer_ctrl_curr gdb_agent_trace_buffer_ctrl_curr
+# define trace_buffer_lanes gdb_agent_trace_buffer_lanes
 # define trace_buffer_lo gdb_agent_trace_buffer_lo
 # define trace_buffer_hi gdb_agent_trace_buffer_hi
-# define traceframe_read_count gdb_agent_traceframe_read_count
-# define traceframe_write_count gdb_agent_traceframe_write_count
 # define traceframes_created gdb_agent_traceframes_created
 # define trace_state_variables gdb_agent_trace_state_variables
 # define get_raw_reg gdb_agent_get_raw_reg
@@ -162,7 +162,7 @@ struct ipa_sym_addresses
   CORE_ADDR addr_gdb_trampoline_buffer;
   CORE_ADDR addr_gdb_trampoline_buffer_end;
   CORE_ADDR addr_gdb_trampoline_buffer_error;
-  CORE_ADDR addr_collecting;
+  CORE_ADDR addr_collecting_offset;
   CORE_ADDR addr_gdb_collect;
   CORE_ADDR addr_stop_tracing;
   CORE_ADDR addr_flush_trace_buffer;
@@ -173,12 +173,7 @@ struct ipa_sym_addresses
   CORE_ADDR addr_error_tracepoint;
   CORE_ADDR addr_tracepoints;
   CORE_ADDR addr_tracing;
-  CORE_ADDR addr_trace_buffer_ctrl;
-  CORE_ADDR addr_trace_buffer_ctrl_curr;
-  CORE_ADDR addr_trace_buffer_lo;
-  CORE_ADDR addr_trace_buffer_hi;
-  CORE_ADDR addr_traceframe_read_count;
-  CORE_ADDR addr_traceframe_write_count;
+  CORE_ADDR addr_trace_buffer_lanes;
   CORE_ADDR addr_traceframes_created;
   CORE_ADDR addr_trace_state_variables;
   CORE_ADDR addr_get_raw_reg;
@@ -199,7 +194,7 @@ static struct
   IPA_SYM(gdb_trampoline_buffer),
   IPA_SYM(gdb_trampoline_buffer_end),
   IPA_SYM(gdb_trampoline_buffer_error),
-  IPA_SYM(collecting),
+  IPA_SYM(collecting_offset),
   IPA_SYM(gdb_collect),
   IPA_SYM(stop_tracing),
   IPA_SYM(flush_trace_buffer),
@@ -210,12 +205,7 @@ static struct
   IPA_SYM(error_tracepoint),
   IPA_SYM(tracepoints),
   IPA_SYM(tracing),
-  IPA_SYM(trace_buffer_ctrl),
-  IPA_SYM(trace_buffer_ctrl_curr),
-  IPA_SYM(trace_buffer_lo),
-  IPA_SYM(trace_buffer_hi),
-  IPA_SYM(traceframe_read_count),
-  IPA_SYM(traceframe_write_count),
+  IPA_SYM(trace_buffer_lanes),
   IPA_SYM(traceframes_created),
   IPA_SYM(trace_state_variables),
   IPA_SYM(get_raw_reg),
@@ -325,11 +315,17 @@ maybe_write_ipa_ust_not_loaded (char *buffer)
 void
 tracepoint_look_up_symbols (void)
 {
+  const char *names[sizeof (symbol_list) / sizeof (symbol_list[0])];
   int i;
 
   if (agent_loaded_p ())
     return;
 
+  /* Ask GDB for all of them at once, if it can.  */
+  for (i = 0; i < sizeof (symbol_list) / sizeof (symbol_list[0]); i++)
+    names[i] = symbol_list[i].name;
+  look_up_symbols (names, i);
+
   for (i = 0; i < sizeof (symbol_list) / sizeof (symbol_list[0]); i++)
     {
       CORE_ADDR *addrp =
@@ -428,13 +424,6 @@ read_inferior_integer (CORE_ADDR symaddr, int *val)
 struct tracepoint;
 static int tracepoint_send_agent (struct tracepoint *tpoint);
 
-static int
-read_inferior_uinteger (CORE_ADDR symaddr, unsigned int *val)
-{
-  return read_inferior_memory (symaddr, (unsigned char *) val,
-			       sizeof (*val));
-}
-
 static int
 read_inferior_data_pointer (CORE_ADDR symaddr, CORE_ADDR *val)
 {
@@ -741,6 +730,12 @@ struct tracepoint
   /* True if the tracepoint is currently enabled.  */
   int8_t enabled;
 
+  /* True if the condition or the actions of the tracepoint refer to
+     trace state variables.  The in-process agent collects such
+     tracepoints one thread at a time, so that the updates different
+     threads make to the variables do not interleave.  */
+  int8_t uses_tsvs;
+
   /* The number of single steps that will be performed after each
      tracepoint hit.  */
   uint64_t step_count;
@@ -887,7 +882,7 @@ static const char *eval_result_names[] =
 
 /* The tracepoint in which the error occurred.  */
 
-static struct tracepoint *error_tracepoint;
+IP_AGENT_EXPORT struct tracepoint *error_tracepoint;
 
 struct trace_state_variable
 {
@@ -978,11 +973,36 @@ struct traceframe
      tracepoint hit.  */
   unsigned int data_size : 32;
 
+#ifdef IN_PROCESS_AGENT
+  /* The order in which the traceframe was finished, among all the
+     traceframes of the in-process agent.  GDBserver uploads the
+     traceframes of the different trace buffer lanes in this order.
+     Using the creation order instead would let a traceframe that
+     was still being collected during an upload end up after younger
+     traceframes of other lanes.  */
+  unsigned int seq;
+#endif
+
   /* The base of the trace data, which is contiguous from this point.  */
   unsigned char data[0];
 
 } ATTR_PACKED;
 
+#ifndef IN_PROCESS_AGENT
+
+/* Same as above, as laid out in the in-process agent's trace
+   buffer.  */
+
+struct ipa_traceframe
+{
+  int tpnum : 16;
+  unsigned int data_size : 32;
+  unsigned int seq;
+  unsigned char data[0];
+} ATTR_PACKED;
+
+#endif
+
 /* The size of the EOB marker, in bytes.  A traceframe with zeroed
    fields (and no data) marks the end of trace data.  */
 #define TRACEFRAME_EOB_MARKER_SIZE offsetof (struct traceframe, data)
@@ -1092,7 +1112,8 @@ struct ipa_trace_buffer_control
   - reads current token, extracts current trace buffer control index,
     and starts tentatively updating the rightmost one (0->1, 1->2,
     2->0).  Note that only one inferior thread is executing this code
-    at any given time, due to an outer lock in the jump pads.
+    for a given trace buffer lane at any given time, as the thread
+    claimed the lane before allocating from it.
 
   - updates counters, and tries to commit the token.
 
@@ -1111,16 +1132,17 @@ struct ipa_trace_buffer_control
   - updates the token unconditionally, using the current buffer
     control index, since it knows that the IP agent always writes to
     the rightmost, and due to the breakpoint, at most one IP thread
-    can try to update the trace buffer concurrently to GDBserver, so
+    can try to update a lane concurrently to GDBserver, so
     there will be no danger of trace buffer control index wrap making
     the IPA write to the same index as GDBserver.
 
-  - flushes the IP agent's trace buffer completely, and updates the
-    current trace buffer control structure.  GDBserver *always* wins.
+  - flushes the IP agent's trace buffer lanes completely, and
+    updates their current trace buffer control structure.  GDBserver
+    *always* wins.
 
   - removes the `about_to_request_buffer_space' breakpoint.
 
-The token is stored in the `trace_buffer_ctrl_curr' variable.
+The token is stored in the `ctrl_curr' field of each lane.
 Internally, it's bits are defined as:
 
  |-------------+-----+-------------+--------+-------------+--------------|
@@ -1148,31 +1170,83 @@ A GDBserver update of `trace_buffer_ctrl_curr' does:
     - writes GSB,PC,CC
 */
 
-/* These are the bits of `trace_buffer_ctrl_curr' that are reserved
-   for the counters described below.  The cleared bits are used to
-   hold the index of the items of the `trace_buffer_ctrl' array that
-   is "current".  */
+/* These are the bits of the token that are reserved for the counters
+   described below.  The cleared bits are used to hold the index of
+   the items of the `ctrl' array that is "current".  */
 #define GDBSERVER_FLUSH_COUNT_MASK        0xfffffff0
 
-/* `trace_buffer_ctrl_curr' contains two counters.  The `previous'
+/* The token contains two counters.  The `previous'
    counter, and the `current' counter.  */
 
 #define GDBSERVER_FLUSH_COUNT_MASK_PREV   0x7ff00000
 #define GDBSERVER_FLUSH_COUNT_MASK_CURR   0x0007ff00
 
-/* When GDBserver update the IP agent's `trace_buffer_ctrl_curr', it
-   always stamps this bit as set.  */
+/* When GDBserver update the IP agent's token, it always stamps this
+   bit as set.  */
 #define GDBSERVER_UPDATED_FLUSH_COUNT_BIT 0x80000000
 
+/* The in-process agent splits its trace buffer in this many lanes.
+   Each lane is a trace buffer of its own, with its own control
+   structures and token, and is written to by at most one thread at
+   any given time: a thread claims a lane, preferably always the same
+   one, for the time it takes to write a traceframe.  Threads
+   collecting at the same time thus each allocate from a lane of
+   their own, without waiting for each other.  GDBserver merges the
+   traceframes of all lanes back in creation order when uploading
+   them.  */
+
+#define TRACE_BUFFER_LANES 16
+
 #ifdef IN_PROCESS_AGENT
-IP_AGENT_EXPORT struct trace_buffer_control trace_buffer_ctrl[3];
-IP_AGENT_EXPORT unsigned int trace_buffer_ctrl_curr;
 
-# define TRACE_BUFFER_CTRL_CURR \
-  (trace_buffer_ctrl_curr & ~GDBSERVER_FLUSH_COUNT_MASK)
+struct trace_buffer_lane
+{
+  /* The control structures of this lane, and the token telling
+     which of them is current.  */
+  struct trace_buffer_control ctrl[3];
+  unsigned int ctrl_curr;
+
+  /* Nonzero while a thread writes a traceframe to this lane.  */
+  unsigned int busy;
+
+  /* The part of the trace buffer this lane covers.  */
+  unsigned char *lo;
+  unsigned char *hi;
+
+  /* The difference between these counters is the number of complete
+     traceframes in this lane.  The IP agent writes to the write
+     count, GDBserver writes to the read count.  */
+  unsigned int write_count;
+  unsigned int read_count;
+};
+
+IP_AGENT_EXPORT struct trace_buffer_lane trace_buffer_lanes[TRACE_BUFFER_LANES];
+
+/* The lane the current thread is writing a traceframe to, if any.  */
+static __thread struct trace_buffer_lane *current_lane ATTR_INITIAL_EXEC;
+
+/* The lane the current thread tries to claim first, plus one.  Zero
+   until the thread first collects.  */
+static __thread unsigned int preferred_lane ATTR_INITIAL_EXEC;
+
+/* The count of threads that were given a preferred lane.  */
+static unsigned int preferred_lane_count;
 
 #else
 
+/* Same as above, to be used by GDBserver when updating the in-process
+   agent.  */
+struct ipa_trace_buffer_lane
+{
+  struct ipa_trace_buffer_control ctrl[3];
+  unsigned int ctrl_curr;
+  unsigned int busy;
+  uintptr_t lo;
+  uintptr_t hi;
+  unsigned int write_count;
+  unsigned int read_count;
+};
+
 /* The GDBserver side agent only needs one instance of this object, as
    it doesn't need to sync with itself.  Define it as array anyway so
    that the rest of the code base doesn't need to care for the
@@ -1207,20 +1281,25 @@ struct trace_buffer_control trace_buffer_ctrl[1];
 			     ? (trace_buffer_wrap - trace_buffer_lo)	\
 			     : 0)))
 
+#ifndef IN_PROCESS_AGENT
+
 /* The difference between these counters represents the total number
-   of complete traceframes present in the trace buffer.  The IP agent
-   writes to the write count, GDBserver writes to read count.  */
+   of complete traceframes present in the trace buffer.  The
+   in-process agent keeps such counters for each of its lanes.  */
 
-IP_AGENT_EXPORT unsigned int traceframe_write_count;
-IP_AGENT_EXPORT unsigned int traceframe_read_count;
+unsigned int traceframe_write_count;
+unsigned int traceframe_read_count;
 
 /* Convenience macro.  */
 
 #define traceframe_count \
   ((unsigned int) (traceframe_write_count - traceframe_read_count))
 
+#endif
+
 /* The count of all traceframes created in the current run, including
-   ones that were discarded to make room.  */
+   ones that were discarded to make room.  In the in-process agent,
+   this numbers the traceframes as they are created.  */
 
 IP_AGENT_EXPORT int traceframes_created;
 
@@ -1410,6 +1489,34 @@ static LONGEST get_timestamp (void);
    unconditionally.  */
 #define cmpxchg(mem, oldval, newval) \
   __sync_val_compare_and_swap (mem, oldval, newval)
+#define fetch_and_add(mem, val) \
+  __sync_fetch_and_add (mem, val)
+
+#ifdef IN_PROCESS_AGENT
+
+/* Several threads may be collecting at the same time.  This lock is
+   held while updating the counts of a tracepoint.  */
+static unsigned int tracepoint_counts_lock;
+
+/* This lock is held by a thread collecting a tracepoint that refers
+   to trace state variables.  */
+static unsigned int trace_state_variables_lock;
+
+static void
+spin_lock (unsigned int *lock)
+{
+  while (cmpxchg (lock, 0, 1) != 0)
+    ;
+}
+
+static void
+spin_unlock (unsigned int *lock)
+{
+  memory_barrier ();
+  *lock = 0;
+}
+
+#endif
 
 /* Record that an error occurred during expression evaluation.  */
 
@@ -1439,6 +1546,30 @@ record_tracepoint_error (struct tracepoint *tpoint, const char *which,
 static void
 clear_trace_buffer (void)
 {
+#ifdef IN_PROCESS_AGENT
+  size_t lane_size;
+  int i;
+
+  lane_size = (trace_buffer_hi - trace_buffer_lo) / TRACE_BUFFER_LANES;
+
+  for (i = 0; i < TRACE_BUFFER_LANES; i++)
+    {
+      struct trace_buffer_lane *lane = &trace_buffer_lanes[i];
+
+      lane->lo = trace_buffer_lo + i * lane_size;
+      lane->hi = lane->lo + lane_size;
+      lane->ctrl[0].start = lane->lo;
+      lane->ctrl[0].free = lane->lo;
+      lane->ctrl[0].end_free = lane->hi;
+      lane->ctrl[0].wrap = lane->hi;
+      lane->ctrl_curr = 0;
+      lane->busy = 0;
+      /* A traceframe with zeroed fields marks the end of trace data.  */
+      ((struct traceframe *) lane->lo)->tpnum = 0;
+      ((struct traceframe *) lane->lo)->data_size = 0;
+      lane->read_count = lane->write_count = 0;
+    }
+#else
   trace_buffer_start = trace_buffer_lo;
   trace_buffer_free = trace_buffer_lo;
   trace_buffer_end_free = trace_buffer_hi;
@@ -1447,6 +1578,7 @@ clear_trace_buffer (void)
   ((struct traceframe *) trace_buffer_free)->tpnum = 0;
   ((struct traceframe *) trace_buffer_free)->data_size = 0;
   traceframe_read_count = traceframe_write_count = 0;
+#endif
   traceframes_created = 0;
 }
 
@@ -1455,35 +1587,34 @@ clear_trace_buffer (void)
 static void
 clear_inferior_trace_buffer (void)
 {
-  CORE_ADDR ipa_trace_buffer_lo;
-  CORE_ADDR ipa_trace_buffer_hi;
-  struct traceframe ipa_traceframe = { 0 };
-  struct ipa_trace_buffer_control ipa_trace_buffer_ctrl;
+  struct ipa_trace_buffer_lane lanes[TRACE_BUFFER_LANES];
+  struct ipa_traceframe ipa_traceframe = { 0 };
+  int i;
 
-  read_inferior_data_pointer (ipa_sym_addrs.addr_trace_buffer_lo,
-			      &ipa_trace_buffer_lo);
-  read_inferior_data_pointer (ipa_sym_addrs.addr_trace_buffer_hi,
-			      &ipa_trace_buffer_hi);
+  if (read_inferior_memory (ipa_sym_addrs.addr_trace_buffer_lanes,
+			    (unsigned char *) lanes, sizeof (lanes)))
+    return;
 
-  ipa_trace_buffer_ctrl.start = ipa_trace_buffer_lo;
-  ipa_trace_buffer_ctrl.free = ipa_trace_buffer_lo;
-  ipa_trace_buffer_ctrl.end_free = ipa_trace_buffer_hi;
-  ipa_trace_buffer_ctrl.wrap = ipa_trace_buffer_hi;
+  for (i = 0; i < TRACE_BUFFER_LANES; i++)
+    {
+      struct ipa_trace_buffer_lane *lane = &lanes[i];
 
-  /* A traceframe with zeroed fields marks the end of trace data.  */
-  write_inferior_memory (ipa_sym_addrs.addr_trace_buffer_ctrl,
-			 (unsigned char *) &ipa_trace_buffer_ctrl,
-			 sizeof (ipa_trace_buffer_ctrl));
+      lane->ctrl[0].start = lane->lo;
+      lane->ctrl[0].free = lane->lo;
+      lane->ctrl[0].end_free = lane->hi;
+      lane->ctrl[0].wrap = lane->hi;
+      lane->ctrl_curr = 0;
+      lane->read_count = lane->write_count = 0;
 
-  write_inferior_uinteger (ipa_sym_addrs.addr_trace_buffer_ctrl_curr, 0);
+      /* A traceframe with zeroed fields marks the end of trace data.  */
+      write_inferior_memory (lane->lo,
+			     (unsigned char *) &ipa_traceframe,
+			     sizeof (ipa_traceframe));
+    }
 
-  /* A traceframe with zeroed fields marks the end of trace data.  */
-  write_inferior_memory (ipa_trace_buffer_lo,
-			 (unsigned char *) &ipa_traceframe,
-			 sizeof (ipa_traceframe));
+  write_inferior_memory (ipa_sym_addrs.addr_trace_buffer_lanes,
+			 (unsigned char *) lanes, sizeof (lanes));
 
-  write_inferior_uinteger (ipa_sym_addrs.addr_traceframe_write_count, 0);
-  write_inferior_uinteger (ipa_sym_addrs.addr_traceframe_read_count, 0);
   write_inferior_integer (ipa_sym_addrs.addr_traceframes_created, 0);
 }
 
@@ -1529,11 +1660,18 @@ trace_buffer_alloc (size_t amt)
   struct trace_buffer_control *tbctrl;
   unsigned int curr;
 #ifdef IN_PROCESS_AGENT
+  struct trace_buffer_lane *lane = current_lane;
+  struct trace_buffer_control *ctrl = lane->ctrl;
+  unsigned char *buffer_lo = lane->lo;
+  unsigned char *buffer_hi = lane->hi;
   unsigned int prev, prev_filtered;
   unsigned int commit_count;
   unsigned int commit;
   unsigned int readout;
 #else
+  struct trace_buffer_control *ctrl = trace_buffer_ctrl;
+  unsigned char *buffer_lo = trace_buffer_lo;
+  unsigned char *buffer_hi = trace_buffer_hi;
   struct traceframe *oldest;
   unsigned char *new_start;
 #endif
@@ -1545,12 +1683,20 @@ trace_buffer_alloc (size_t amt)
   amt += TRACEFRAME_EOB_MARKER_SIZE;
 
 #ifdef IN_PROCESS_AGENT
+  /* Flushing the lane would not help if it can't hold the block even
+     when empty.  */
+  if (amt > (size_t) (buffer_hi - buffer_lo))
+    {
+      trace_debug ("Block too large for a trace buffer lane");
+      return NULL;
+    }
+
  again:
   memory_barrier ();
 
   /* Read the current token and extract the index to try to write to,
      storing it in CURR.  */
-  prev = trace_buffer_ctrl_curr;
+  prev = lane->ctrl_curr;
   prev_filtered = prev & ~GDBSERVER_FLUSH_COUNT_MASK;
   curr = prev_filtered + 1;
   if (curr > 2)
@@ -1561,26 +1707,25 @@ trace_buffer_alloc (size_t amt)
   /* Start out with a copy of the current state.  GDBserver may be
      midway writing to the PREV_FILTERED TBC, but, that's OK, we won't
      be able to commit anyway if that happens.  */
-  trace_buffer_ctrl[curr]
-    = trace_buffer_ctrl[prev_filtered];
+  ctrl[curr] = ctrl[prev_filtered];
   trace_debug ("trying curr=%u", curr);
 #else
   /* The GDBserver's agent doesn't need all that syncing, and always
      updates TCB 0 (there's only one, mind you).  */
   curr = 0;
 #endif
-  tbctrl = &trace_buffer_ctrl[curr];
+  tbctrl = &ctrl[curr];
 
   /* Offsets are easier to grok for debugging than raw addresses,
      especially for the small trace buffer sizes that are useful for
      testing.  */
   trace_debug ("Trace buffer [%d] start=%d free=%d endfree=%d wrap=%d hi=%d",
 	       curr,
-	       (int) (tbctrl->start - trace_buffer_lo),
-	       (int) (tbctrl->free - trace_buffer_lo),
-	       (int) (tbctrl->end_free - trace_buffer_lo),
-	       (int) (tbctrl->wrap - trace_buffer_lo),
-	       (int) (trace_buffer_hi - trace_buffer_lo));
+	       (int) (tbctrl->start - buffer_lo),
+	       (int) (tbctrl->free - buffer_lo),
+	       (int) (tbctrl->end_free - buffer_lo),
+	       (int) (tbctrl->wrap - buffer_lo),
+	       (int) (buffer_hi - buffer_lo));
 
   /* The algorithm here is to keep trying to get a contiguous block of
      the requested size, possibly discarding older traceframes to free
@@ -1593,7 +1738,7 @@ trace_buffer_alloc (size_t amt)
       /* First, if we have two free parts, try the upper one first.  */
       if (tbctrl->end_free < tbctrl->free)
 	{
-	  if (tbctrl->free + amt <= trace_buffer_hi)
+	  if (tbctrl->free + amt <= buffer_hi)
 	    /* We have enough in the upper part.  */
 	    break;
 	  else
@@ -1604,7 +1749,7 @@ trace_buffer_alloc (size_t amt)
 		 discarded.  */
 	      trace_debug ("Upper part too small, setting wraparound");
 	      tbctrl->wrap = tbctrl->free;
-	      tbctrl->free = trace_buffer_lo;
+	      tbctrl->free = buffer_lo;
 	    }
 	}
 
@@ -1664,7 +1809,7 @@ trace_buffer_alloc (size_t amt)
       if (new_start < tbctrl->start)
 	{
 	  trace_debug ("Discarding past the wraparound");
-	  tbctrl->wrap = trace_buffer_hi;
+	  tbctrl->wrap = buffer_hi;
 	}
       tbctrl->start = new_start;
       tbctrl->end_free = tbctrl->start;
@@ -1673,11 +1818,11 @@ trace_buffer_alloc (size_t amt)
 		   "Trace buffer [%d], start=%d free=%d "
 		   "endfree=%d wrap=%d hi=%d",
 		   curr,
-		   (int) (tbctrl->start - trace_buffer_lo),
-		   (int) (tbctrl->free - trace_buffer_lo),
-		   (int) (tbctrl->end_free - trace_buffer_lo),
-		   (int) (tbctrl->wrap - trace_buffer_lo),
-		   (int) (trace_buffer_hi - trace_buffer_lo));
+		   (int) (tbctrl->start - buffer_lo),
+		   (int) (tbctrl->free - buffer_lo),
+		   (int) (tbctrl->end_free - buffer_lo),
+		   (int) (tbctrl->wrap - buffer_lo),
+		   (int) (buffer_hi - buffer_lo));
 
       /* Now go back around the loop.  The discard might have resulted
 	 in either one or two pieces of free space, so we want to try
@@ -1707,7 +1852,7 @@ trace_buffer_alloc (size_t amt)
 	    | curr);
 
   /* Try to commit it.  */
-  readout = cmpxchg (&trace_buffer_ctrl_curr, prev, commit);
+  readout = cmpxchg (&lane->ctrl_curr, prev, commit);
   if (readout != prev)
     {
       trace_debug ("GDBserver has touched the trace buffer, restarting."
@@ -1732,7 +1877,7 @@ trace_buffer_alloc (size_t amt)
 
     memory_barrier ();
 
-    refetch = trace_buffer_ctrl_curr;
+    refetch = lane->ctrl_curr;
 
     if (refetch == commit
 	|| ((refetch & GDBSERVER_FLUSH_COUNT_MASK_PREV) >> 12) == commit_count)
@@ -1768,11 +1913,11 @@ trace_buffer_alloc (size_t amt)
       trace_debug ("Trace buffer [%d] start=%d free=%d "
 		   "endfree=%d wrap=%d hi=%d",
 		   curr,
-		   (int) (tbctrl->start - trace_buffer_lo),
-		   (int) (tbctrl->free - trace_buffer_lo),
-		   (int) (tbctrl->end_free - trace_buffer_lo),
-		   (int) (tbctrl->wrap - trace_buffer_lo),
-		   (int) (trace_buffer_hi - trace_buffer_lo));
+		   (int) (tbctrl->start - buffer_lo),
+		   (int) (tbctrl->free - buffer_lo),
+		   (int) (tbctrl->end_free - buffer_lo),
+		   (int) (tbctrl->wrap - buffer_lo),
+		   (int) (buffer_hi - buffer_lo));
     }
 
   return rslt;
@@ -1813,6 +1958,7 @@ add_tracepoint (int num, CORE_ADDR addr)
   tpoint->actions = NULL;
   tpoint->actions_str = NULL;
   tpoint->cond = NULL;
+  tpoint->uses_tsvs = 0;
   tpoint->num_step_actions = 0;
   tpoint->step_actions = NULL;
   tpoint->step_actions_str = NULL;
@@ -2198,6 +2344,44 @@ set_trace_state_variable_getter (int num, LONGEST (*getter) (void))
   tsv->getter = getter;
 }
 
+#ifdef IN_PROCESS_AGENT
+
+/* Claim a trace buffer lane for the current thread to write a
+   traceframe to, waiting for one to be free if need be.  */
+
+static void
+claim_trace_buffer_lane (void)
+{
+  unsigned int i;
+
+  if (preferred_lane == 0)
+    preferred_lane = (fetch_and_add (&preferred_lane_count, 1)
+		      % TRACE_BUFFER_LANES) + 1;
+
+  for (i = preferred_lane - 1; ; i = (i + 1) % TRACE_BUFFER_LANES)
+    {
+      struct trace_buffer_lane *lane = &trace_buffer_lanes[i];
+
+      if (lane->busy == 0 && cmpxchg (&lane->busy, 0, 1) == 0)
+	{
+	  current_lane = lane;
+	  return;
+	}
+    }
+}
+
+/* Let other threads write to the lane of the current thread.  */
+
+static void
+release_trace_buffer_lane (void)
+{
+  memory_barrier ();
+  current_lane->busy = 0;
+  current_lane = NULL;
+}
+
+#endif
+
 /* Add a raw traceframe for the given tracepoint.  */
 
 static struct traceframe *
@@ -2205,10 +2389,19 @@ add_traceframe (struct tracepoint *tpoint)
 {
   struct traceframe *tframe;
 
+#ifdef IN_PROCESS_AGENT
+  claim_trace_buffer_lane ();
+#endif
+
   tframe = trace_buffer_alloc (sizeof (struct traceframe));
 
   if (tframe == NULL)
-    return NULL;
+    {
+#ifdef IN_PROCESS_AGENT
+      release_trace_buffer_lane ();
+#endif
+      return NULL;
+    }
 
   tframe->tpnum = tpoint->number;
   tframe->data_size = 0;
@@ -2235,7 +2428,13 @@ add_traceframe_block (struct traceframe *tframe,
   gdb_assert (tframe->tpnum == tpoint->number);
 
   tframe->data_size += amt;
+#ifdef IN_PROCESS_AGENT
+  spin_lock (&tracepoint_counts_lock);
+#endif
   tpoint->traceframe_usage += amt;
+#ifdef IN_PROCESS_AGENT
+  spin_unlock (&tracepoint_counts_lock);
+#endif
 
   return block;
 }
@@ -2245,8 +2444,17 @@ add_traceframe_block (struct traceframe *tframe,
 static void
 finish_traceframe (struct traceframe *tframe)
 {
+#ifdef IN_PROCESS_AGENT
+  tframe->seq = fetch_and_add (&traceframes_created, 1);
+
+  /* GDBserver may upload the traceframe as soon as it is counted.  */
+  memory_barrier ();
+  ++current_lane->write_count;
+  release_trace_buffer_lane ();
+#else
   ++traceframe_write_count;
   ++traceframes_created;
+#endif
 }
 
 #ifndef IN_PROCESS_AGENT
@@ -3080,6 +3288,7 @@ install_fast_tracepoint (struct tracepoint *tpoint, char *errbuf)
      installed.  */
   unsigned char fjump[MAX_JUMP_SIZE];
   ULONGEST fjump_size;
+  int collecting_offset;
 
   if (tpoint->orig_size < target_get_min_fast_tracepoint_insn_len ())
     {
@@ -3088,6 +3297,14 @@ install_fast_tracepoint (struct tracepoint *tpoint, char *errbuf)
       return 0;
     }
 
+  if (read_inferior_integer (ipa_sym_addrs.addr_collecting_offset,
+			     &collecting_offset))
+    {
+      strcpy (errbuf, "E.Could not read the in-process agent's "
+	      "collecting slot offset.");
+      return 1;
+    }
+
   jentry = jump_entry = get_jump_space_head ();
 
   trampoline = 0;
@@ -3097,7 +3314,7 @@ install_fast_tracepoint (struct tracepoint *tpoint, char *errbuf)
   err = install_fast_tracepoint_jump_pad (tpoint->obj_addr_on_target,
 					  tpoint->address,
 					  ipa_sym_addrs.addr_gdb_collect,
-					  ipa_sym_addrs.addr_collecting,
+					  collecting_offset,
 					  tpoint->orig_size,
 					  &jentry,
 					  &trampoline, &trampoline_size,
@@ -3975,51 +4192,73 @@ cmd_qtminftpilen (char *packet)
   sprintf (packet, "%x", target_get_min_fast_tracepoint_insn_len ());
 }
 
-/* Respond to qTBuffer packet with a block of raw data from the trace
-   buffer.  GDB may ask for a lot, but we are allowed to reply with
-   only as much as will fit within packet limits or whatever.  */
+/* Find the block of raw trace buffer data that a qTBuffer or
+   qTBufferBin packet asks for, with PACKET pointing at its offset and
+   length.  Return 1 and set *TBP and *NUM to the block, trimmed to
+   the end of the data, or return 0 if the offset is right at the end,
+   or -1 if it is out of bounds.  */
 
-static void
-cmd_qtbuffer (char *own_buf)
+static int
+find_raw_trace_data (char *packet, unsigned char **tbp, ULONGEST *num)
 {
-  ULONGEST offset, num, tot;
-  unsigned char *tbp;
-  char *packet = own_buf;
-
-  packet += strlen ("qTBuffer:");
+  ULONGEST offset, tot;
 
   packet = unpack_varlen_hex (packet, &offset);
   ++packet; /* skip a comma */
-  unpack_varlen_hex (packet, &num);
+  unpack_varlen_hex (packet, num);
 
   trace_debug ("Want to get trace buffer, %d bytes at offset 0x%s",
-	       (int) num, phex_nz (offset, 0));
+	       (int) *num, phex_nz (offset, 0));
 
   tot = (trace_buffer_hi - trace_buffer_lo) - free_space ();
 
   /* If we're right at the end, reply specially that we're done.  */
   if (offset == tot)
-    {
-      strcpy (own_buf, "l");
-      return;
-    }
+    return 0;
 
   /* Object to any other out-of-bounds request.  */
   if (offset > tot)
-    {
-      write_enn (own_buf);
-      return;
-    }
+    return -1;
 
   /* Compute the pointer corresponding to the given offset, accounting
      for wraparound.  */
-  tbp = trace_buffer_start + offset;
-  if (tbp >= trace_buffer_wrap)
-    tbp -= (trace_buffer_wrap - trace_buffer_lo);
+  *tbp = trace_buffer_start + offset;
+  if (*tbp >= trace_buffer_wrap)
+    *tbp -= (trace_buffer_wrap - trace_buffer_lo);
 
   /* Trim to the remaining bytes if we're close to the end.  */
-  if (num > tot - offset)
-    num = tot - offset;
+  if (*num > tot - offset)
+    *num = tot - offset;
+
+  /* Trim to the wraparound point; GDB asks again for the rest.  */
+  if (*tbp < trace_buffer_wrap && *num > trace_buffer_wrap - *tbp)
+    *num = trace_buffer_wrap - *tbp;
+
+  return 1;
+}
+
+/* Respond to qTBuffer packet with a block of raw data from the trace
+   buffer.  GDB may ask for a lot, but we are allowed to reply with
+   only as much as will fit within packet limits or whatever.  */
+
+static void
+cmd_qtbuffer (char *own_buf)
+{
+  ULONGEST num;
+  unsigned char *tbp;
+  int res;
+
+  res = find_raw_trace_data (own_buf + strlen ("qTBuffer:"), &tbp, &num);
+  if (res == 0)
+    {
+      strcpy (own_buf, "l");
+      return;
+    }
+  else if (res < 0)
+    {
+      write_enn (own_buf);
+      return;
+    }
 
   /* Trim to available packet size.  */
   if (num >= (PBUFSIZ - 16) / 2 )
@@ -4028,6 +4267,36 @@ cmd_qtbuffer (char *own_buf)
   convert_int_to_ascii (tbp, own_buf, num);
 }
 
+/* Respond to qTBufferBin packet, like qTBuffer but with the data
+   escaped as binary.  Return the length of the reply.  */
+
+static int
+cmd_qtbufferbin (char *own_buf)
+{
+  ULONGEST num;
+  unsigned char *tbp;
+  int res, out_len;
+
+  res = find_raw_trace_data (own_buf + strlen ("qTBufferBin:"), &tbp, &num);
+  if (res == 0)
+    {
+      strcpy (own_buf, "l");
+      return 1;
+    }
+  else if (res < 0)
+    {
+      write_enn (own_buf);
+      return strlen (own_buf);
+    }
+
+  /* Send as much of the data as fits once escaped.  */
+  if (num > PBUFSIZ - 2)
+    num = PBUFSIZ - 2;
+  own_buf[0] = 'b';
+  return remote_escape_output (tbp, num, (gdb_byte *) own_buf + 1,
+			       &out_len, PBUFSIZ - 2) + 1;
+}
+
 static void
 cmd_bigqtbuffer_circular (char *own_buf)
 {
@@ -4213,7 +4482,7 @@ handle_tracepoint_general_set (char *packet)
 }
 
 int
-handle_tracepoint_query (char *packet)
+handle_tracepoint_query (char *packet, int *new_packet_len_p)
 {
   if (strcmp ("qTStatus", packet) == 0)
     {
@@ -4255,6 +4524,11 @@ handle_tracepoint_query (char *packet)
       cmd_qtbuffer (packet);
       return 1;
     }
+  else if (strncmp ("qTBufferBin:", packet, strlen ("qTBufferBin:")) == 0)
+    {
+      *new_packet_len_p = cmd_qtbufferbin (packet);
+      return 1;
+    }
   else if (strcmp ("qTfSTM", packet) == 0)
     {
       cmd_qtfstm (packet);
@@ -4609,6 +4883,10 @@ collect_data_at_tracepoint (struct tracepoint_hit_ctx *ctx, CORE_ADDR stop_pc,
   struct traceframe *tframe;
   int acti;
 
+#ifdef IN_PROCESS_AGENT
+  spin_lock (&tracepoint_counts_lock);
+#endif
+
   /* Only count it as a hit when we actually collect data.  */
   tpoint->hit_count++;
 
@@ -4622,6 +4900,10 @@ collect_data_at_tracepoint (struct tracepoint_hit_ctx *ctx, CORE_ADDR stop_pc,
       && stopping_tracepoint == NULL)
     stopping_tracepoint = tpoint;
 
+#ifdef IN_PROCESS_AGENT
+  spin_unlock (&tracepoint_counts_lock);
+#endif
+
   trace_debug ("Making new traceframe for tracepoint %d at 0x%s, hit %" PRIu64,
 	       tpoint->number, paddress (tpoint->address), tpoint->hit_count);
 
@@ -5530,10 +5812,29 @@ typedef struct collecting_t
 
 #ifndef IN_PROCESS_AGENT
 
+/* Return the address of the `collecting' slot of the thread
+   identified by THREAD_AREA in the in-process agent, or 0 if it can't
+   be found.  */
+
+static CORE_ADDR
+collecting_slot_address (CORE_ADDR thread_area)
+{
+  int offset;
+
+  if (read_inferior_integer (ipa_sym_addrs.addr_collecting_offset, &offset)
+      || offset == 0)
+    return 0;
+
+  return thread_area + offset;
+}
+
 void
-force_unlock_trace_buffer (void)
+force_unlock_trace_buffer (CORE_ADDR thread_area)
 {
-  write_inferior_data_pointer (ipa_sym_addrs.addr_collecting, 0);
+  CORE_ADDR slot = collecting_slot_address (thread_area);
+
+  if (slot != 0)
+    write_inferior_data_pointer (slot, 0);
 }
 
 /* Check if the thread identified by THREAD_AREA which is stopped at
@@ -5655,13 +5956,14 @@ fast_tracepoint_collecting (CORE_ADDR thread_area,
   else
     {
       collecting_t ipa_collecting_obj;
+      CORE_ADDR slot;
 
-      /* If `collecting' is set/locked, then the THREAD_AREA thread
-	 may or not be the one holding the lock.  We have to read the
-	 lock to find out.  */
+      /* The THREAD_AREA thread is collecting if its `collecting' slot
+	 is set.  */
 
-      if (read_inferior_data_pointer (ipa_sym_addrs.addr_collecting,
-				      &ipa_collecting))
+      slot = collecting_slot_address (thread_area);
+      if (slot == 0
+	  || read_inferior_data_pointer (slot, &ipa_collecting))
 	{
 	  trace_debug ("fast_tracepoint_collecting:"
 		       " failed reading 'collecting' in the inferior");
@@ -5670,12 +5972,10 @@ fast_tracepoint_collecting (CORE_ADDR thread_area,
 
       if (!ipa_collecting)
 	{
-	  trace_debug ("fast_tracepoint_collecting: not collecting"
-		       " (and nobody is).");
+	  trace_debug ("fast_tracepoint_collecting: not collecting");
 	  return 0;
 	}
 
-      /* Some thread is collecting.  Check which.  */
       if (read_inferior_memory (ipa_collecting,
 				(unsigned char *) &ipa_collecting_obj,
 				sizeof (ipa_collecting_obj)) != 0)
@@ -5683,8 +5983,8 @@ fast_tracepoint_collecting (CORE_ADDR thread_area,
 
       if (ipa_collecting_obj.thread_area != thread_area)
 	{
-	  trace_debug ("fast_tracepoint_collecting: not collecting "
-		       "(another thread is)");
+	  warning ("fast_tracepoint_collecting: collecting object of "
+		   "another thread?");
 	  return 0;
 	}
 
@@ -5741,12 +6041,18 @@ fast_tracepoint_collecting, returning continue-until-break at %s",
 
 #ifdef IN_PROCESS_AGENT
 
-/* The global fast tracepoint collect lock.  Points to a collecting_t
-   object built on the stack by the jump pad, if presently locked;
-   NULL if it isn't locked.  Note that this lock *must* be set while
-   executing any *function other than the jump pad.  See
+/* Each thread's fast tracepoint collect slot.  Points to a
+   collecting_t object built on the stack by the jump pad, while the
+   thread is collecting; NULL otherwise.  Note that this slot *must*
+   be set while executing any *function other than the jump pad.  See
    fast_tracepoint_collecting.  */
-static collecting_t * ATTR_USED collecting;
+static __thread collecting_t *collecting ATTR_INITIAL_EXEC;
+
+/* The offset of the `collecting' slot of each thread from its thread
+   area.  The jump pads reach the slot through the thread pointer
+   register, and GDBserver reads it to tell whether a thread is
+   collecting.  */
+IP_AGENT_EXPORT int collecting_offset;
 
 /* This routine, called from the jump pad (in asm) is designed to be
    called from the jump pads of fast tracepoints, thus it is on the
@@ -5756,6 +6062,7 @@ IP_AGENT_EXPORT void ATTR_USED
 gdb_collect (struct tracepoint *tpoint, unsigned char *regs)
 {
   struct fast_tracepoint_ctx ctx;
+  int stop;
 
   /* Don't do anything until the trace run is completely set up.  */
   if (!tracing)
@@ -5785,6 +6092,9 @@ gdb_collect (struct tracepoint *tpoint, unsigned char *regs)
       if (ctx.tpoint->type != tpoint->type)
 	continue;
 
+      if (ctx.tpoint->uses_tsvs)
+	spin_lock (&trace_state_variables_lock);
+
       /* Test the condition if present, and collect if true.  */
       if (ctx.tpoint->cond == NULL
 	  || condition_true_at_tracepoint ((struct tracepoint_hit_ctx *) &ctx,
@@ -5793,28 +6103,29 @@ gdb_collect (struct tracepoint *tpoint, unsigned char *regs)
 	  collect_data_at_tracepoint ((struct tracepoint_hit_ctx *) &ctx,
 				      ctx.tpoint->address, ctx.tpoint);
 
-	  /* Note that this will cause original insns to be written back
-	     to where we jumped from, but that's OK because we're jumping
-	     back to the next whole instruction.  This will go badly if
-	     instruction restoration is not atomic though.  */
-	  if (stopping_tracepoint
-	      || trace_buffer_is_full
-	      || expr_eval_result != expr_eval_no_error)
-	    {
-	      stop_tracing ();
-	      break;
-	    }
+	  stop = (stopping_tracepoint
+		  || trace_buffer_is_full
+		  || expr_eval_result != expr_eval_no_error);
 	}
       else
 	{
 	  /* If there was a condition and it evaluated to false, the only
 	     way we would stop tracing is if there was an error during
 	     condition expression evaluation.  */
-	  if (expr_eval_result != expr_eval_no_error)
-	    {
-	      stop_tracing ();
-	      break;
-	    }
+	  stop = expr_eval_result != expr_eval_no_error;
+	}
+
+      if (ctx.tpoint->uses_tsvs)
+	spin_unlock (&trace_state_variables_lock);
+
+      /* Note that this will cause original insns to be written back
+	 to where we jumped from, but that's OK because we're jumping
+	 back to the next whole instruction.  This will go badly if
+	 instruction restoration is not atomic though.  */
+      if (stop)
+	{
+	  stop_tracing ();
+	  break;
 	}
     }
 }
@@ -5823,21 +6134,30 @@ gdb_collect (struct tracepoint *tpoint, unsigned char *regs)
 
 #ifndef IN_PROCESS_AGENT
 
+/* The functions called by compiled code are gdbserver's own when
+   the code is for gdbserver to run.  */
+
 CORE_ADDR
 get_raw_reg_func_addr (void)
 {
+  if (emit_for_gdbserver)
+    return (CORE_ADDR) (uintptr_t) gdbserver_agent_get_reg;
   return ipa_sym_addrs.addr_get_raw_reg;
 }
 
 CORE_ADDR
 get_get_tsv_func_addr (void)
 {
+  if (emit_for_gdbserver)
+    return (CORE_ADDR) (uintptr_t) get_trace_state_variable_value;
   return ipa_sym_addrs.addr_get_trace_state_variable_value;
 }
 
 CORE_ADDR
 get_set_tsv_func_addr (void)
 {
+  if (emit_for_gdbserver)
+    return (CORE_ADDR) (uintptr_t) set_trace_state_variable_value;
   return ipa_sym_addrs.addr_set_trace_state_variable_value;
 }
 
@@ -5952,6 +6272,30 @@ download_agent_expr (struct agent_expr *expr)
 
 /* Sync tracepoint with IPA, but leave maintenance of linked list to caller.  */
 
+/* Return nonzero if the condition or the actions of TPOINT refer to
+   trace state variables.  */
+
+static int
+tracepoint_uses_tsvs (struct tracepoint *tpoint)
+{
+  int i;
+
+  if (tpoint->cond != NULL && agent_expr_uses_tsvs (tpoint->cond))
+    return 1;
+
+  for (i = 0; i < tpoint->numactions; i++)
+    if (tpoint->actions[i]->type == 'X')
+      {
+	struct eval_expr_action *eaction
+	  = (struct eval_expr_action *) tpoint->actions[i];
+
+	if (agent_expr_uses_tsvs (eaction->expr))
+	  return 1;
+      }
+
+  return 0;
+}
+
 static void
 download_tracepoint_1 (struct tracepoint *tpoint)
 {
@@ -5982,6 +6326,8 @@ download_tracepoint_1 (struct tracepoint *tpoint)
       claim_jump_space (jentry - jump_entry);
     }
 
+  tpoint->uses_tsvs = tracepoint_uses_tsvs (tpoint);
+
   target_tracepoint = *tpoint;
 
   tpptr = target_malloc (sizeof (*tpoint));
@@ -6234,253 +6580,289 @@ download_trace_state_variables (void)
     }
 }
 
+/* The address of the in-process agent's trace buffer lane number
+   LANE, and of its FIELD.  */
+
+#define IPA_LANE_ADDR(LANE)						\
+  (ipa_sym_addrs.addr_trace_buffer_lanes				\
+   + (LANE) * sizeof (struct ipa_trace_buffer_lane))
+#define IPA_LANE_FIELD_ADDR(LANE, FIELD)				\
+  (IPA_LANE_ADDR (LANE) + offsetof (struct ipa_trace_buffer_lane, FIELD))
+
+/* Read the header of the traceframe at TF in LANE of the IP Agent's
+   trace buffer into IPA_TFRAME, if LANE has traceframes left.  */
+
+static void
+read_ipa_traceframe_header (struct ipa_trace_buffer_lane *lane,
+			    CORE_ADDR tf, struct ipa_traceframe *ipa_tframe)
+{
+  if (lane->write_count == lane->read_count)
+    return;
+
+  if (read_inferior_memory (tf, (unsigned char *) ipa_tframe,
+			    offsetof (struct ipa_traceframe, data)))
+    error ("Uploading: couldn't read traceframe at %s\n", paddress (tf));
+
+  if (ipa_tframe->tpnum == 0)
+    fatal ("Uploading: No (more) fast traceframes, but "
+	   "ipa_traceframe_count == %u??\n",
+	   lane->write_count - lane->read_count);
+}
+
+/* Copy the traceframe at *TF, whose header is IPA_TFRAME, out of
+   LANE of the IP Agent's trace buffer into GDBserver's trace buffer.
+   TBCTRL is the lane's current control structure.  Update it, *TF,
+   and LANE's read count to discard the traceframe from the lane.  */
+
+static void
+upload_fast_traceframe (struct ipa_trace_buffer_lane *lane,
+			struct ipa_trace_buffer_control *tbctrl,
+			CORE_ADDR *tf, struct ipa_traceframe *ipa_tframe)
+{
+  struct tracepoint *tpoint;
+  struct traceframe *tframe;
+  unsigned char *block;
+  CORE_ADDR data, next;
+
+  /* Note that this will be incorrect for multi-location
+     tracepoints...  */
+  tpoint = find_next_tracepoint_by_number (NULL, ipa_tframe->tpnum);
+
+  tframe = add_traceframe (tpoint);
+  if (tframe == NULL)
+    {
+      trace_buffer_is_full = 1;
+      trace_debug ("Uploading: trace buffer is full");
+    }
+  else
+    {
+      /* Copy the whole set of blocks in one go for now.  FIXME:
+	 split this in smaller blocks.  */
+      block = add_traceframe_block (tframe, tpoint,
+				    ipa_tframe->data_size);
+      if (block != NULL)
+	{
+	  ULONGEST size = ipa_tframe->data_size;
+	  ULONGEST len;
+
+	  /* The blocks are allocated one by one, so the data continues
+	     at the start of the lane if one of them did not fit before
+	     the wraparound.  */
+	  data = *tf + offsetof (struct ipa_traceframe, data);
+	  if (data >= tbctrl->wrap)
+	    data -= tbctrl->wrap - lane->lo;
+	  while (size > 0)
+	    {
+	      len = size;
+	      if (data < tbctrl->wrap && data + len > tbctrl->wrap)
+		len = tbctrl->wrap - data;
+
+	      if (read_inferior_memory (data, block, len))
+		error ("Uploading: Couldn't read traceframe data at %s\n",
+		       paddress (data));
+
+	      block += len;
+	      size -= len;
+	      data = lane->lo;
+	    }
+	}
+
+      trace_debug ("Uploading: traceframe didn't fit");
+      finish_traceframe (tframe);
+    }
+
+  /* Note that the IPA's buffer is always circular.  */
+  next = *tf + sizeof (struct ipa_traceframe) + ipa_tframe->data_size;
+  if (next >= tbctrl->wrap)
+    next -= tbctrl->wrap - lane->lo;
+  *tf = next;
+
+  /* If we freed the traceframe that wrapped around, go back
+     to the non-wrap case.  */
+  if (*tf < tbctrl->start)
+    {
+      trace_debug ("Lib: Discarding past the wraparound");
+      tbctrl->wrap = lane->hi;
+    }
+  tbctrl->start = *tf;
+  tbctrl->end_free = tbctrl->start;
+  ++lane->read_count;
+
+  if (tbctrl->start == tbctrl->free
+      && tbctrl->start == tbctrl->end_free)
+    {
+      trace_debug ("Lib: lane is fully empty.  "
+		   "start=%d free=%d endfree=%d",
+		   (int) (tbctrl->start - lane->lo),
+		   (int) (tbctrl->free - lane->lo),
+		   (int) (tbctrl->end_free - lane->lo));
+
+      tbctrl->start = lane->lo;
+      tbctrl->free = lane->lo;
+      tbctrl->end_free = lane->hi;
+      tbctrl->wrap = lane->hi;
+    }
+
+  trace_debug ("Uploaded a traceframe\n"
+	       "Lib: start=%d free=%d endfree=%d wrap=%d hi=%d",
+	       (int) (tbctrl->start - lane->lo),
+	       (int) (tbctrl->free - lane->lo),
+	       (int) (tbctrl->end_free - lane->lo),
+	       (int) (tbctrl->wrap - lane->lo),
+	       (int) (lane->hi - lane->lo));
+}
+
 /* Upload complete trace frames out of the IP Agent's trace buffer
    into GDBserver's trace buffer.  This always uploads either all or
-   no trace frames.  This is the counter part of
+   no trace frames of each lane, merging the trace frames of all lanes
+   in the order they were created.  This is the counter part of
    `trace_alloc_trace_buffer'.  See its description of the atomic
    synching mechanism.  */
 
 static void
 upload_fast_traceframes (void)
 {
-  unsigned int ipa_traceframe_read_count, ipa_traceframe_write_count;
-  unsigned int ipa_traceframe_read_count_racy, ipa_traceframe_write_count_racy;
-  CORE_ADDR tf;
-  struct ipa_trace_buffer_control ipa_trace_buffer_ctrl;
-  unsigned int curr_tbctrl_idx;
-  unsigned int ipa_trace_buffer_ctrl_curr;
-  unsigned int ipa_trace_buffer_ctrl_curr_old;
-  CORE_ADDR ipa_trace_buffer_ctrl_addr;
+  struct ipa_trace_buffer_lane lanes[TRACE_BUFFER_LANES];
+  unsigned int curr_tbctrl_idx[TRACE_BUFFER_LANES];
+  int uploading[TRACE_BUFFER_LANES];
+  CORE_ADDR tf[TRACE_BUFFER_LANES];
+  struct ipa_traceframe ipa_tframe[TRACE_BUFFER_LANES];
   struct breakpoint *about_to_request_buffer_space_bkpt;
-  CORE_ADDR ipa_trace_buffer_lo;
-  CORE_ADDR ipa_trace_buffer_hi;
+  int i, pending = 0;
 
-  if (read_inferior_uinteger (ipa_sym_addrs.addr_traceframe_read_count,
-			      &ipa_traceframe_read_count_racy))
+  if (read_inferior_memory (ipa_sym_addrs.addr_trace_buffer_lanes,
+			    (unsigned char *) lanes, sizeof (lanes)))
     {
       /* This will happen in most targets if the current thread is
 	 running.  */
       return;
     }
 
-  if (read_inferior_uinteger (ipa_sym_addrs.addr_traceframe_write_count,
-			      &ipa_traceframe_write_count_racy))
-    return;
+  for (i = 0; i < TRACE_BUFFER_LANES; i++)
+    pending += lanes[i].write_count - lanes[i].read_count;
 
-  trace_debug ("ipa_traceframe_count (racy area): %d (w=%d, r=%d)",
-	       ipa_traceframe_write_count_racy
-	       - ipa_traceframe_read_count_racy,
-	       ipa_traceframe_write_count_racy,
-	       ipa_traceframe_read_count_racy);
+  trace_debug ("ipa_traceframe_count (racy area): %d", pending);
 
-  if (ipa_traceframe_write_count_racy == ipa_traceframe_read_count_racy)
+  if (pending == 0)
     return;
 
   about_to_request_buffer_space_bkpt
     = set_breakpoint_at (ipa_sym_addrs.addr_about_to_request_buffer_space,
 			 NULL);
 
-  if (read_inferior_uinteger (ipa_sym_addrs.addr_trace_buffer_ctrl_curr,
-			      &ipa_trace_buffer_ctrl_curr))
+  if (read_inferior_memory (ipa_sym_addrs.addr_trace_buffer_lanes,
+			    (unsigned char *) lanes, sizeof (lanes)))
     return;
 
-  ipa_trace_buffer_ctrl_curr_old = ipa_trace_buffer_ctrl_curr;
+  for (i = 0; i < TRACE_BUFFER_LANES; i++)
+    {
+      unsigned int prev, counter, token;
 
-  curr_tbctrl_idx = ipa_trace_buffer_ctrl_curr & ~GDBSERVER_FLUSH_COUNT_MASK;
+      uploading[i] = lanes[i].write_count != lanes[i].read_count;
+      if (!uploading[i])
+	continue;
 
-  {
-    unsigned int prev, counter;
+      curr_tbctrl_idx[i] = lanes[i].ctrl_curr & ~GDBSERVER_FLUSH_COUNT_MASK;
 
-    /* Update the token, with new counters, and the GDBserver stamp
-       bit.  Alway reuse the current TBC index.  */
-    prev = ipa_trace_buffer_ctrl_curr & GDBSERVER_FLUSH_COUNT_MASK_CURR;
-    counter = (prev + 0x100) & GDBSERVER_FLUSH_COUNT_MASK_CURR;
+      /* Update the token, with new counters, and the GDBserver stamp
+	 bit.  Alway reuse the current TBC index.  */
+      prev = lanes[i].ctrl_curr & GDBSERVER_FLUSH_COUNT_MASK_CURR;
+      counter = (prev + 0x100) & GDBSERVER_FLUSH_COUNT_MASK_CURR;
 
-    ipa_trace_buffer_ctrl_curr = (GDBSERVER_UPDATED_FLUSH_COUNT_BIT
-				  | (prev << 12)
-				  | counter
-				  | curr_tbctrl_idx);
-  }
+      token = (GDBSERVER_UPDATED_FLUSH_COUNT_BIT
+	       | (prev << 12)
+	       | counter
+	       | curr_tbctrl_idx[i]);
 
-  if (write_inferior_uinteger (ipa_sym_addrs.addr_trace_buffer_ctrl_curr,
-			       ipa_trace_buffer_ctrl_curr))
-    return;
+      if (write_inferior_uinteger (IPA_LANE_FIELD_ADDR (i, ctrl_curr),
+				   token))
+	return;
 
-  trace_debug ("Lib: Committed %08x -> %08x",
-	       ipa_trace_buffer_ctrl_curr_old,
-	       ipa_trace_buffer_ctrl_curr);
+      trace_debug ("Lib: Committed %08x -> %08x in lane %d",
+		   lanes[i].ctrl_curr, token, i);
+    }
 
-  /* Re-read these, now that we've installed the
-     `about_to_request_buffer_space' breakpoint/lock.  A thread could
-     have finished a traceframe between the last read of these
-     counters and setting the breakpoint above.  If we start
-     uploading, we never want to leave this function with
-     traceframe_read_count != 0, otherwise, GDBserver could end up
+  /* Re-read the lanes, now that we've installed the
+     `about_to_request_buffer_space' breakpoint/lock, and stamped the
+     tokens.  A thread could have finished a traceframe between the
+     last read of the counters and setting the breakpoint above.  If
+     we start uploading a lane, we never want to leave this function
+     with traceframes left in it, otherwise, GDBserver could end up
      incrementing the counter tokens more than once (due to event loop
      nesting), which would break the IP agent's "effective" detection
      (see trace_alloc_trace_buffer).  */
-  if (read_inferior_uinteger (ipa_sym_addrs.addr_traceframe_read_count,
-			      &ipa_traceframe_read_count))
-    return;
-  if (read_inferior_uinteger (ipa_sym_addrs.addr_traceframe_write_count,
-			      &ipa_traceframe_write_count))
+  if (read_inferior_memory (ipa_sym_addrs.addr_trace_buffer_lanes,
+			    (unsigned char *) lanes, sizeof (lanes)))
     return;
 
-  if (debug_threads)
+  /* Get the first traceframe of each lane, from its current TBC
+     object (each lane has an array of 3 such objects).  The index is
+     stored in the token.  */
+  for (i = 0; i < TRACE_BUFFER_LANES; i++)
     {
-      trace_debug ("ipa_traceframe_count (blocked area): %d (w=%d, r=%d)",
-		   ipa_traceframe_write_count - ipa_traceframe_read_count,
-		   ipa_traceframe_write_count, ipa_traceframe_read_count);
-
-      if (ipa_traceframe_write_count != ipa_traceframe_write_count_racy
-	  || ipa_traceframe_read_count != ipa_traceframe_read_count_racy)
-	trace_debug ("note that ipa_traceframe_count's parts changed");
-    }
-
-  /* Get the address of the current TBC object (the IP agent has an
-     array of 3 such objects).  The index is stored in the TBC
-     token.  */
-  ipa_trace_buffer_ctrl_addr = ipa_sym_addrs.addr_trace_buffer_ctrl;
-  ipa_trace_buffer_ctrl_addr
-    += sizeof (struct ipa_trace_buffer_control) * curr_tbctrl_idx;
-
-  if (read_inferior_memory (ipa_trace_buffer_ctrl_addr,
-			    (unsigned char *) &ipa_trace_buffer_ctrl,
-			    sizeof (struct ipa_trace_buffer_control)))
-    return;
-
-  if (read_inferior_data_pointer (ipa_sym_addrs.addr_trace_buffer_lo,
-				  &ipa_trace_buffer_lo))
-    return;
-  if (read_inferior_data_pointer (ipa_sym_addrs.addr_trace_buffer_hi,
-				  &ipa_trace_buffer_hi))
-    return;
+      struct ipa_trace_buffer_control *tbctrl;
 
-  /* Offsets are easier to grok for debugging than raw addresses,
-     especially for the small trace buffer sizes that are useful for
-     testing.  */
-  trace_debug ("Lib: Trace buffer [%d] start=%d free=%d "
-	       "endfree=%d wrap=%d hi=%d",
-	       curr_tbctrl_idx,
-	       (int) (ipa_trace_buffer_ctrl.start - ipa_trace_buffer_lo),
-	       (int) (ipa_trace_buffer_ctrl.free - ipa_trace_buffer_lo),
-	       (int) (ipa_trace_buffer_ctrl.end_free - ipa_trace_buffer_lo),
-	       (int) (ipa_trace_buffer_ctrl.wrap - ipa_trace_buffer_lo),
-	       (int) (ipa_trace_buffer_hi - ipa_trace_buffer_lo));
-
-  /* Note that the IPA's buffer is always circular.  */
-
-#define IPA_FIRST_TRACEFRAME() (ipa_trace_buffer_ctrl.start)
+      if (!uploading[i])
+	continue;
 
-#define IPA_NEXT_TRACEFRAME_1(TF, TFOBJ)		\
-  ((TF) + sizeof (struct traceframe) + (TFOBJ)->data_size)
+      tbctrl = &lanes[i].ctrl[curr_tbctrl_idx[i]];
 
-#define IPA_NEXT_TRACEFRAME(TF, TFOBJ)					\
-  (IPA_NEXT_TRACEFRAME_1 (TF, TFOBJ)					\
-   - ((IPA_NEXT_TRACEFRAME_1 (TF, TFOBJ) >= ipa_trace_buffer_ctrl.wrap) \
-      ? (ipa_trace_buffer_ctrl.wrap - ipa_trace_buffer_lo)		\
-      : 0))
+      /* Offsets are easier to grok for debugging than raw addresses,
+	 especially for the small trace buffer sizes that are useful
+	 for testing.  */
+      trace_debug ("Lib: Lane %d, trace buffer [%d] w=%u r=%u start=%d "
+		   "free=%d endfree=%d wrap=%d hi=%d",
+		   i, curr_tbctrl_idx[i],
+		   lanes[i].write_count, lanes[i].read_count,
+		   (int) (tbctrl->start - lanes[i].lo),
+		   (int) (tbctrl->free - lanes[i].lo),
+		   (int) (tbctrl->end_free - lanes[i].lo),
+		   (int) (tbctrl->wrap - lanes[i].lo),
+		   (int) (lanes[i].hi - lanes[i].lo));
 
-  tf = IPA_FIRST_TRACEFRAME ();
+      tf[i] = tbctrl->start;
+      read_ipa_traceframe_header (&lanes[i], tf[i], &ipa_tframe[i]);
+    }
 
-  while (ipa_traceframe_write_count - ipa_traceframe_read_count)
+  /* Merge the lanes, going for the oldest traceframe first.  */
+  while (1)
     {
-      struct tracepoint *tpoint;
-      struct traceframe *tframe;
-      unsigned char *block;
-      struct traceframe ipa_tframe;
-
-      if (read_inferior_memory (tf, (unsigned char *) &ipa_tframe,
-				offsetof (struct traceframe, data)))
-	error ("Uploading: couldn't read traceframe at %s\n", paddress (tf));
-
-      if (ipa_tframe.tpnum == 0)
-	fatal ("Uploading: No (more) fast traceframes, but "
-	       "ipa_traceframe_count == %u??\n",
-	       ipa_traceframe_write_count - ipa_traceframe_read_count);
+      int next = -1;
 
-      /* Note that this will be incorrect for multi-location
-	 tracepoints...  */
-      tpoint = find_next_tracepoint_by_number (NULL, ipa_tframe.tpnum);
+      for (i = 0; i < TRACE_BUFFER_LANES; i++)
+	if (uploading[i]
+	    && lanes[i].write_count != lanes[i].read_count
+	    && (next == -1
+		|| (int) (ipa_tframe[i].seq - ipa_tframe[next].seq) < 0))
+	  next = i;
 
-      tframe = add_traceframe (tpoint);
-      if (tframe == NULL)
-	{
-	  trace_buffer_is_full = 1;
-	  trace_debug ("Uploading: trace buffer is full");
-	}
-      else
-	{
-	  /* Copy the whole set of blocks in one go for now.  FIXME:
-	     split this in smaller blocks.  */
-	  block = add_traceframe_block (tframe, tpoint,
-					ipa_tframe.data_size);
-	  if (block != NULL)
-	    {
-	      if (read_inferior_memory (tf
-					+ offsetof (struct traceframe, data),
-					block, ipa_tframe.data_size))
-		error ("Uploading: Couldn't read traceframe data at %s\n",
-		       paddress (tf + offsetof (struct traceframe, data)));
-	    }
-
-	  trace_debug ("Uploading: traceframe didn't fit");
-	  finish_traceframe (tframe);
-	}
-
-      tf = IPA_NEXT_TRACEFRAME (tf, &ipa_tframe);
+      if (next == -1)
+	break;
 
-      /* If we freed the traceframe that wrapped around, go back
-	 to the non-wrap case.  */
-      if (tf < ipa_trace_buffer_ctrl.start)
-	{
-	  trace_debug ("Lib: Discarding past the wraparound");
-	  ipa_trace_buffer_ctrl.wrap = ipa_trace_buffer_hi;
-	}
-      ipa_trace_buffer_ctrl.start = tf;
-      ipa_trace_buffer_ctrl.end_free = ipa_trace_buffer_ctrl.start;
-      ++ipa_traceframe_read_count;
+      upload_fast_traceframe (&lanes[next],
+			      &lanes[next].ctrl[curr_tbctrl_idx[next]],
+			      &tf[next], &ipa_tframe[next]);
+      read_ipa_traceframe_header (&lanes[next], tf[next], &ipa_tframe[next]);
+    }
 
-      if (ipa_trace_buffer_ctrl.start == ipa_trace_buffer_ctrl.free
-	  && ipa_trace_buffer_ctrl.start == ipa_trace_buffer_ctrl.end_free)
-	{
-	  trace_debug ("Lib: buffer is fully empty.  "
-		       "Trace buffer [%d] start=%d free=%d endfree=%d",
-		       curr_tbctrl_idx,
-		       (int) (ipa_trace_buffer_ctrl.start
-			      - ipa_trace_buffer_lo),
-		       (int) (ipa_trace_buffer_ctrl.free
-			      - ipa_trace_buffer_lo),
-		       (int) (ipa_trace_buffer_ctrl.end_free
-			      - ipa_trace_buffer_lo));
-
-	  ipa_trace_buffer_ctrl.start = ipa_trace_buffer_lo;
-	  ipa_trace_buffer_ctrl.free = ipa_trace_buffer_lo;
-	  ipa_trace_buffer_ctrl.end_free = ipa_trace_buffer_hi;
-	  ipa_trace_buffer_ctrl.wrap = ipa_trace_buffer_hi;
-	}
+  for (i = 0; i < TRACE_BUFFER_LANES; i++)
+    {
+      if (!uploading[i])
+	continue;
 
-      trace_debug ("Uploaded a traceframe\n"
-		   "Lib: Trace buffer [%d] start=%d free=%d "
-		   "endfree=%d wrap=%d hi=%d",
-		   curr_tbctrl_idx,
-		   (int) (ipa_trace_buffer_ctrl.start - ipa_trace_buffer_lo),
-		   (int) (ipa_trace_buffer_ctrl.free - ipa_trace_buffer_lo),
-		   (int) (ipa_trace_buffer_ctrl.end_free
-			  - ipa_trace_buffer_lo),
-		   (int) (ipa_trace_buffer_ctrl.wrap - ipa_trace_buffer_lo),
-		   (int) (ipa_trace_buffer_hi - ipa_trace_buffer_lo));
-    }
-
-  if (write_inferior_memory (ipa_trace_buffer_ctrl_addr,
-			     (unsigned char *) &ipa_trace_buffer_ctrl,
-			     sizeof (struct ipa_trace_buffer_control)))
-    return;
+      if (write_inferior_memory (IPA_LANE_FIELD_ADDR (i, ctrl)
+				 + (curr_tbctrl_idx[i]
+				    * sizeof (struct ipa_trace_buffer_control)),
+				 (unsigned char *)
+				 &lanes[i].ctrl[curr_tbctrl_idx[i]],
+				 sizeof (struct ipa_trace_buffer_control)))
+	return;
 
-  write_inferior_integer (ipa_sym_addrs.addr_traceframe_read_count,
-			  ipa_traceframe_read_count);
+      write_inferior_uinteger (IPA_LANE_FIELD_ADDR (i, read_count),
+			       lanes[i].read_count);
+    }
 
-  trace_debug ("Done uploading traceframes [%d]\n", curr_tbctrl_idx);
+  trace_debug ("Done uploading traceframes\n");
 
   pause_all (1);
   cancel_breakpoints ();
@@ -6610,6 +6992,7 @@ gdb_probe (const struct marker *mdata, void *probe_private,
 {
   struct tracepoint *tpoint;
   struct static_tracepoint_ctx ctx;
+  int stop;
 
   /* Don't do anything until the trace run is completely set up.  */
   if (!tracing)
@@ -6656,6 +7039,9 @@ gdb_probe (const struct marker *mdata, void *probe_private,
 	       mdata->location, mdata->channel,
 	       mdata->name, mdata->format);
 
+  if (tpoint->uses_tsvs)
+    spin_lock (&trace_state_variables_lock);
+
   /* Test the condition if present, and collect if true.  */
   if (tpoint->cond == NULL
       || condition_true_at_tracepoint ((struct tracepoint_hit_ctx *) &ctx,
@@ -6664,19 +7050,23 @@ gdb_probe (const struct marker *mdata, void *probe_private,
       collect_data_at_tracepoint ((struct tracepoint_hit_ctx *) &ctx,
 				  tpoint->address, tpoint);
 
-      if (stopping_tracepoint
-	  || trace_buffer_is_full
-	  || expr_eval_result != expr_eval_no_error)
-	stop_tracing ();
+      stop = (stopping_tracepoint
+	      || trace_buffer_is_full
+	      || expr_eval_result != expr_eval_no_error);
     }
   else
     {
       /* If there was a condition and it evaluated to false, the only
 	 way we would stop tracing is if there was an error during
 	 condition expression evaluation.  */
-      if (expr_eval_result != expr_eval_no_error)
-	stop_tracing ();
+      stop = expr_eval_result != expr_eval_no_error;
     }
+
+  if (tpoint->uses_tsvs)
+    spin_unlock (&trace_state_variables_lock);
+
+  if (stop)
+    stop_tracing ();
 }
 
 /* Called if the gdb static tracepoint requested collecting "$_sdata",
@@ -7362,6 +7752,11 @@ initialize_tracepoint: mmap'ing jump pad buffer failed with %s",
 
   strcpy (gdb_trampoline_buffer_error, "No errors reported");
 
+  /* The slot is at the same offset from the thread area in every
+     thread.  */
+  collecting_offset = (int) ((uintptr_t) &collecting
+			     - current_thread_area ());
+
   initialize_low_tracepoint ();
 #endif
 }
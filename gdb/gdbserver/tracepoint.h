@@ -33,7 +33,7 @@ void tracepoint_look_up_symbols (void);
 void stop_tracing (void);
 
 int handle_tracepoint_general_set (char *own_buf);
-int handle_tracepoint_query (char *own_buf);
+int handle_tracepoint_query (char *own_buf, int *new_packet_len_p);
 
 int tracepoint_finished_step (struct thread_info *tinfo, CORE_ADDR stop_pc);
 int tracepoint_was_hit (struct thread_info *tinfo, CORE_ADDR stop_pc);
@@ -75,7 +75,7 @@ struct fast_tpoint_collect_status
 int fast_tracepoint_collecting (CORE_ADDR thread_area,
 				CORE_ADDR stop_pc,
 				struct fast_tpoint_collect_status *status);
-void force_unlock_trace_buffer (void);
+void force_unlock_trace_buffer (CORE_ADDR thread_area);
 
 int handle_tracepoint_bkpts (struct thread_info *tinfo, CORE_ADDR stop_pc);
 
@@ -89,6 +89,10 @@ void supply_static_tracepoint_registers (struct regcache *regcache,
 void set_trampoline_buffer_space (CORE_ADDR begin, CORE_ADDR end,
 				  char *errmsg);
 
+/* Return the thread area of the calling thread, the same address
+   GDBserver's get_thread_area finds for it.  */
+CORE_ADDR current_thread_area (void);
+
 extern const struct target_desc *ipa_tdesc;
 
 #else
@@ -173,6 +173,8 @@ alloc_type (struct objfile *objfile)
   TYPE_MAIN_TYPE (type) = OBSTACK_ZALLOC (&objfile->objfile_obstack,
 					  struct main_type);
   OBJSTAT (objfile, n_types++);
+  OBJSTAT (objfile, sz_types += sizeof (struct type)
+			       + sizeof (struct main_type));
 
   TYPE_OBJFILE_OWNED (type) = 1;
   TYPE_OWNER (type).objfile = objfile;
@@ -30,11 +30,13 @@
 
 #include "gdb_assert.h"
 #include "gdb_string.h"
+#include "gdb_wait.h"
 #include "elf/common.h"
 #include <sys/uio.h>
 #include <sys/ptrace.h>
 #include <sys/user.h>
 #include <sys/procfs.h>
+#include <sys/syscall.h>
 
 #ifdef HAVE_SYS_REG_H
 #include <sys/reg.h>
@@ -74,6 +76,16 @@ struct arch_lwp_info
 {
   /* Non-zero if our copy differs from what's recorded in the thread.  */
   int debug_registers_changed;
+
+  /* Non-zero if DR_WRITTEN and DR_CONTROL_WRITTEN below hold what the
+     thread's debug registers were last set to.  Only the registers
+     whose value differs need writing then.  */
+  int dr_written_p;
+
+  /* The debug address registers, and DR_CONTROL, as last written to
+     the thread.  */
+  CORE_ADDR dr_written[DR_NADDR];
+  unsigned long dr_control_written;
 };
 
 /* Does the current host support PTRACE_GETREGSET?  */
@@ -771,6 +783,7 @@ i386_linux_prepare_to_resume (struct lwp_info *lwp)
 
   if (lwp->arch_private->debug_registers_changed)
     {
+      struct arch_lwp_info *info = lwp->arch_private;
       struct i386_debug_reg_state *state
 	= i386_debug_reg_state (ptid_get_pid (lwp->ptid));
       int i;
@@ -779,9 +792,12 @@ i386_linux_prepare_to_resume (struct lwp_info *lwp)
 	 i386_linux_dr_set calls ordering.  */
 
       for (i = DR_FIRSTADDR; i <= DR_LASTADDR; i++)
-	if (state->dr_ref_count[i] > 0)
+	if (state->dr_ref_count[i] > 0
+	    && (!info->dr_written_p
+		|| info->dr_written[i] != state->dr_mirror[i]))
 	  {
 	    i386_linux_dr_set (lwp->ptid, i, state->dr_mirror[i]);
+	    info->dr_written[i] = state->dr_mirror[i];
 
 	    /* If we're setting a watchpoint, any change the inferior
 	       had done itself to the debug registers needs to be
@@ -790,9 +806,18 @@ i386_linux_prepare_to_resume (struct lwp_info *lwp)
 	    clear_status = 1;
 	  }
 
-      i386_linux_dr_set (lwp->ptid, DR_CONTROL, state->dr_control_mirror);
+      /* Watchpoints are removed and inserted again around every
+	 stop, usually ending up in the registers they were in, so
+	 often nothing needs writing at all.  */
+      if (!info->dr_written_p
+	  || info->dr_control_written != state->dr_control_mirror)
+	{
+	  i386_linux_dr_set (lwp->ptid, DR_CONTROL, state->dr_control_mirror);
+	  info->dr_control_written = state->dr_control_mirror;
+	}
 
-      lwp->arch_private->debug_registers_changed = 0;
+      info->dr_written_p = 1;
+      info->debug_registers_changed = 0;
     }
 
   if (clear_status || lwp->stopped_by_watchpoint)
@@ -1090,6 +1115,59 @@ i386_linux_teardown_btrace (struct btrace_target_info *tinfo)
   linux_disable_btrace (tinfo);
 }
 
+/* Make the stopped LWP LP call mprotect (ADDR, LEN, PROT), by
+   single-stepping a system call instruction written over the one at
+   its pc, and put everything back afterwards.  Return 0 if the call
+   succeeded.  */
+
+static int
+i386_linux_inferior_mprotect (struct lwp_info *lp, CORE_ADDR addr,
+			      ULONGEST len, int prot)
+{
+  struct user_regs_struct regs, saved_regs;
+  int tid = ptid_get_lwp (lp->ptid);
+  long insn, saved_insn;
+  int status, ret = -1;
+
+  if (ptrace (PTRACE_GETREGS, tid, 0, (long) &saved_regs) < 0)
+    return -1;
+
+  errno = 0;
+  saved_insn = ptrace (PTRACE_PEEKTEXT, tid, saved_regs.eip, 0);
+  if (errno != 0)
+    return -1;
+
+  regs = saved_regs;
+
+  /* Make sure the kernel does not restart a system call the LWP was
+     stopped in instead of running ours.  */
+  regs.orig_eax = -1;
+
+  /* int $0x80.  */
+  insn = (saved_insn & ~0xffffL) | 0x80cd;
+  regs.eax = SYS_mprotect;
+  regs.ebx = addr;
+  regs.ecx = len;
+  regs.edx = prot;
+
+  if (ptrace (PTRACE_POKETEXT, tid, saved_regs.eip, insn) == 0)
+    {
+      if (ptrace (PTRACE_SETREGS, tid, 0, (long) &regs) == 0)
+	{
+	  status = linux_nat_step_lwp (lp);
+	  if (WIFSTOPPED (status)
+	      && ptrace (PTRACE_GETREGS, tid, 0, (long) &regs) == 0
+	      && regs.eax == 0)
+	    ret = 0;
+	}
+
+      ptrace (PTRACE_POKETEXT, tid, saved_regs.eip, saved_insn);
+      ptrace (PTRACE_SETREGS, tid, 0, (long) &saved_regs);
+    }
+
+  return ret;
+}
+
 /* -Wmissing-prototypes */
 extern initialize_file_ftype _initialize_i386_linux_nat;
 
@@ -1136,4 +1214,5 @@ _initialize_i386_linux_nat (void)
   linux_nat_set_new_fork (t, i386_linux_new_fork);
   linux_nat_set_forget_process (t, i386_forget_process);
   linux_nat_set_prepare_to_resume (t, i386_linux_prepare_to_resume);
+  linux_nat_set_inferior_mprotect (t, i386_linux_inferior_mprotect);
 }
@@ -33,6 +33,7 @@
 #include "gdbtypes.h"
 #include "objfiles.h"
 #include "osabi.h"
+#include "prologue-cache.h"
 #include "regcache.h"
 #include "reggroups.h"
 #include "regset.h"
@@ -1567,6 +1568,71 @@ i386_analyze_prologue (struct gdbarch *gdbarch,
   return i386_analyze_register_saves (pc, current_pc, cache);
 }
 
+/* The parts of a `struct i386_frame_cache' that a complete run of
+   i386_analyze_prologue fills in, as recorded in the prologue cache.
+   The prologue analysis only records saves of %eax through %edi.  */
+
+struct i386_prologue_info
+{
+  /* Offset of the end of the analyzed prologue from the function's
+     start address.  */
+  CORE_ADDR length;
+
+  LONGEST sp_offset;
+  CORE_ADDR saved_regs[I386_EDI_REGNUM + 1];
+  int saved_sp_reg;
+  int pc_in_eax;
+  long locals;
+};
+
+/* Like i386_analyze_prologue, but reuse an earlier analysis of the
+   function at PC if CURRENT_PC is past the end of its prologue.  The
+   fields of CACHE listed in `struct i386_prologue_info' must still
+   have the values i386_alloc_frame_cache gave them.
+
+   Only analyses that were not cut short by CURRENT_PC are recorded;
+   those are exactly the ones that returned an address below
+   CURRENT_PC, and they give the same result for any CURRENT_PC past
+   that address.  */
+
+static CORE_ADDR
+i386_analyze_prologue_cached (struct gdbarch *gdbarch,
+			      CORE_ADDR pc, CORE_ADDR current_pc,
+			      struct i386_frame_cache *cache)
+{
+  const struct i386_prologue_info *info;
+  struct i386_prologue_info new_info;
+  CORE_ADDR end;
+
+  info = prologue_cache_lookup (gdbarch, pc, sizeof (*info));
+  if (info != NULL && current_pc > pc + info->length)
+    {
+      cache->sp_offset = info->sp_offset;
+      memcpy (cache->saved_regs, info->saved_regs,
+	      sizeof (info->saved_regs));
+      cache->saved_sp_reg = info->saved_sp_reg;
+      cache->pc_in_eax = info->pc_in_eax;
+      cache->locals = info->locals;
+      return pc + info->length;
+    }
+
+  end = i386_analyze_prologue (gdbarch, pc, current_pc, cache);
+
+  if (info == NULL && end < current_pc)
+    {
+      new_info.length = end - pc;
+      new_info.sp_offset = cache->sp_offset;
+      memcpy (new_info.saved_regs, cache->saved_regs,
+	      sizeof (new_info.saved_regs));
+      new_info.saved_sp_reg = cache->saved_sp_reg;
+      new_info.pc_in_eax = cache->pc_in_eax;
+      new_info.locals = cache->locals;
+      prologue_cache_store (gdbarch, pc, &new_info, sizeof (new_info));
+    }
+
+  return end;
+}
+
 /* Return PC of first real instruction.  */
 
 static CORE_ADDR
@@ -1749,8 +1815,8 @@ i386_frame_cache_1 (struct frame_info *this_frame,
   cache->saved_regs[I386_EIP_REGNUM] = 4;
 
   if (cache->pc != 0)
-    i386_analyze_prologue (gdbarch, cache->pc, get_frame_pc (this_frame),
-			   cache);
+    i386_analyze_prologue_cached (gdbarch, cache->pc,
+				  get_frame_pc (this_frame), cache);
 
   if (cache->locals < 0)
     {
@@ -3993,6 +4059,10 @@ struct i386_record_s
   int rip_offset;
   int popl_esp_hack;
   const int *regmap;
+
+  /* Nonzero if what is recorded depends on more than the bytes of the
+     instruction, such as the values of registers.  */
+  int uses_state;
 };
 
 /* Parse the "modrm" part of the memory address irp->addr points at.
@@ -4025,6 +4095,7 @@ i386_record_lea_modrm_addr (struct i386_record_s *irp, uint64_t *addr)
   gdb_byte buf[4];
   ULONGEST offset64;
 
+  irp->uses_state = 1;
   *addr = 0;
   if (irp->aflag)
     {
@@ -4216,6 +4287,7 @@ i386_record_lea_modrm (struct i386_record_s *irp)
 
   if (irp->override >= 0)
     {
+      irp->uses_state = 1;
       if (record_full_memory_query)
         {
 	  int q;
@@ -4251,6 +4323,7 @@ i386_record_push (struct i386_record_s *irp, int size)
 {
   ULONGEST addr;
 
+  irp->uses_state = 1;
   if (record_full_arch_list_add_reg (irp->regcache,
 				     irp->regmap[X86_RECORD_RESP_REGNUM]))
     return -1;
@@ -5107,6 +5180,7 @@ i386_process_record (struct gdbarch *gdbarch, struct regcache *regcache,
     case 0xa3:
       if (ir.override >= 0)
         {
+	  ir.uses_state = 1;
           if (record_full_memory_query)
             {
 	      int q;
@@ -5757,6 +5831,7 @@ Do you want to stop the program?"),
     case 0xab:
     case 0x6c:    /* insS */
     case 0x6d:
+      ir.uses_state = 1;
       regcache_raw_read_unsigned (ir.regcache,
                                   ir.regmap[X86_RECORD_RECX_REGNUM],
                                   &addr);
@@ -6150,6 +6225,7 @@ Do you want to stop the program?"),
 	    ir.addr -= 2;
 	    goto no_support;
 	  }
+	ir.uses_state = 1;
 	ret = tdep->i386_intx80_record (ir.regcache);
 	if (ret)
 	  return ret;
@@ -6238,6 +6314,7 @@ Do you want to stop the program?"),
 	    ir.addr -= 2;
 	    goto no_support;
 	  }
+	ir.uses_state = 1;
 	ret = tdep->i386_sysenter_record (ir.regcache);
 	if (ret)
 	  return ret;
@@ -6261,6 +6338,7 @@ Do you want to stop the program?"),
 	    ir.addr -= 2;
 	    goto no_support;
 	  }
+	ir.uses_state = 1;
 	ret = tdep->i386_syscall_record (ir.regcache);
 	if (ret)
 	  return ret;
@@ -6336,6 +6414,7 @@ Do you want to stop the program?"),
 	      }
 	    if (ir.override >= 0)
 	      {
+		ir.uses_state = 1;
                 if (record_full_memory_query)
                   {
 	            int q;
@@ -6393,6 +6472,7 @@ Do you want to stop the program?"),
 	      /* sidt */
 	      if (ir.override >= 0)
 		{
+		  ir.uses_state = 1;
                   if (record_full_memory_query)
                     {
 	              int q;
@@ -7375,6 +7455,7 @@ reswitch_prefix_add:
           break;
 
         case 0x0ff7:    /* maskmovq */
+	  ir.uses_state = 1;
           regcache_raw_read_unsigned (ir.regcache,
                                       ir.regmap[X86_RECORD_REDI_REGNUM],
                                       &addr);
@@ -7383,6 +7464,7 @@ reswitch_prefix_add:
           break;
 
         case 0x660ff7:    /* maskmovdqu */
+	  ir.uses_state = 1;
           regcache_raw_read_unsigned (ir.regcache,
                                       ir.regmap[X86_RECORD_REDI_REGNUM],
                                       &addr);
@@ -7406,6 +7488,10 @@ reswitch_prefix_add:
   if (record_full_arch_list_add_end ())
     return -1;
 
+  if (!ir.uses_state)
+    record_full_arch_list_cache (gdbarch, ir.orig_addr,
+				 ir.addr - ir.orig_addr);
+
   return 0;
 
  no_support:
@@ -230,6 +230,60 @@ void set_step_info (struct frame_info *frame, struct symtab_and_line sal);
 
 extern void clear_exit_convenience_vars (void);
 
+/* The phases of the handling of an event from the inferior that are
+   timed for "maintenance info infrun-stats".  */
+
+enum infrun_phase
+  {
+    /* handle_inferior_event, which contains most of the others.  */
+    INFRUN_PHASE_HANDLE_EVENT,
+
+    /* bpstat_stop_status.  */
+    INFRUN_PHASE_BPSTAT,
+
+    /* Checking the conditions, ignore counts and Python stop methods
+       of the breakpoints hit.  */
+    INFRUN_PHASE_CONDITION,
+
+    /* clear_proceed_status.  */
+    INFRUN_PHASE_CLEAR_PROCEED,
+
+    /* Discarding the register and frame caches.  */
+    INFRUN_PHASE_REGISTERS_CHANGED,
+
+    /* update_thread_list.  */
+    INFRUN_PHASE_THREAD_LIST,
+
+    /* The normal_stop observers, such as the Python stop events.  */
+    INFRUN_PHASE_STOP_OBSERVERS,
+
+    INFRUN_PHASE_COUNT
+  };
+
+/* The state of one execution of a phase, between infrun_phase_begin
+   and infrun_phase_end.  */
+
+struct infrun_phase_timer
+{
+  enum infrun_phase phase;
+
+  /* Non-zero if the phase is timed, in which case START_USECS is when
+     it started.  */
+  int timed;
+  ULONGEST start_usecs;
+};
+
+/* Record the start of an execution of PHASE in TIMER.  */
+
+extern void infrun_phase_begin (struct infrun_phase_timer *timer,
+				enum infrun_phase phase);
+
+/* Record the end of the execution of a phase started by
+   infrun_phase_begin with TIMER.  If an error is thrown in between,
+   the execution is simply not accounted for.  */
+
+extern void infrun_phase_end (struct infrun_phase_timer *timer);
+
 /* From infcmd.c */
 
 extern void post_create_inferior (struct target_ops *, int);
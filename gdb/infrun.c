@@ -60,6 +60,11 @@
 #include "objfiles.h"
 #include "completer.h"
 #include "target-descriptions.h"
+#include <sys/time.h>
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#endif
 
 /* Prototypes for local functions */
 
@@ -155,6 +160,181 @@ show_debug_infrun (struct ui_file *file, int from_tty,
   fprintf_filtered (file, _("Inferior debugging is %s.\n"), value);
 }
 
+/* Statistics about the time spent in each phase of the handling of
+   the events from the inferior, for "maintenance info infrun-stats".
+   They are only collected after "maintenance set infrun-stats on", so
+   that the phases cost a test and a call otherwise.  The beginning
+   and end of every phase are also SystemTap SDT probes, gdb:phase__begin
+   and gdb:phase__end, whose argument is the enum infrun_phase, so a
+   tracer can time them whether the statistics are on or not.  */
+
+static int infrun_stats_enabled = 0;
+
+static void
+show_infrun_stats_enabled (struct ui_file *file, int from_tty,
+			   struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("Collection of infrun statistics is %s.\n"),
+		    value);
+}
+
+/* The number of buckets of the latency histograms: under 1us, 10us,
+   100us, 1ms, 10ms and 100ms, and longer.  */
+#define INFRUN_STATS_BUCKETS 7
+
+static struct
+{
+  /* The executions of the phase, and the total, longest and
+     histogram of their durations, in microseconds.  */
+  ULONGEST count;
+  ULONGEST usecs;
+  ULONGEST max_usecs;
+  ULONGEST histogram[INFRUN_STATS_BUCKETS];
+} infrun_phase_stats[INFRUN_PHASE_COUNT];
+
+/* When the statistics were last cleared, in microseconds.  */
+
+static ULONGEST infrun_stats_start_usecs;
+
+static const char *const infrun_phase_names[INFRUN_PHASE_COUNT] =
+{
+  "handle_inferior_event",
+  "bpstat_stop_status",
+  "breakpoint conditions",
+  "clear_proceed_status",
+  "registers_changed",
+  "update_thread_list",
+  "normal_stop observers"
+};
+
+/* Return the current time, in microseconds.  */
+
+static ULONGEST
+infrun_stats_now (void)
+{
+  struct timeval now;
+
+  gettimeofday (&now, NULL);
+  return (ULONGEST) now.tv_sec * 1000000 + now.tv_usec;
+}
+
+/* Forget all the statistics.  */
+
+static void
+infrun_stats_clear (void)
+{
+  memset (infrun_phase_stats, 0, sizeof (infrun_phase_stats));
+  infrun_stats_start_usecs = infrun_stats_now ();
+}
+
+/* See inferior.h.  */
+
+void
+infrun_phase_begin (struct infrun_phase_timer *timer,
+		    enum infrun_phase phase)
+{
+#ifdef HAVE_SYS_SDT_H
+  STAP_PROBE1 (gdb, phase__begin, (int) phase);
+#endif
+
+  timer->phase = phase;
+  timer->timed = infrun_stats_enabled;
+  if (timer->timed)
+    timer->start_usecs = infrun_stats_now ();
+}
+
+/* See inferior.h.  */
+
+void
+infrun_phase_end (struct infrun_phase_timer *timer)
+{
+  ULONGEST usecs, limit;
+  int bucket;
+
+#ifdef HAVE_SYS_SDT_H
+  STAP_PROBE1 (gdb, phase__end, (int) timer->phase);
+#endif
+
+  /* Don't count a phase that ran across "maint set infrun-stats".  */
+  if (!timer->timed || !infrun_stats_enabled)
+    return;
+
+  usecs = infrun_stats_now () - timer->start_usecs;
+  for (bucket = 0, limit = 1;
+       bucket < INFRUN_STATS_BUCKETS - 1 && usecs >= limit;
+       bucket++, limit *= 10)
+    ;
+
+  infrun_phase_stats[timer->phase].count++;
+  infrun_phase_stats[timer->phase].usecs += usecs;
+  if (usecs > infrun_phase_stats[timer->phase].max_usecs)
+    infrun_phase_stats[timer->phase].max_usecs = usecs;
+  infrun_phase_stats[timer->phase].histogram[bucket]++;
+}
+
+/* Implement "maint set infrun-stats".  Turning the statistics on
+   starts them afresh.  */
+
+static void
+set_infrun_stats_enabled (char *args, int from_tty,
+			  struct cmd_list_element *c)
+{
+  if (infrun_stats_enabled)
+    infrun_stats_clear ();
+}
+
+/* Implement "maint info infrun-stats".  */
+
+static void
+maintenance_info_infrun_stats (char *args, int from_tty)
+{
+  static const char *const bucket_names[INFRUN_STATS_BUCKETS] =
+    { "<1us", "<10us", "<100us", "<1ms", "<10ms", "<100ms", ">=100ms" };
+  ULONGEST elapsed, events;
+  int phase, bucket;
+
+  if (!infrun_stats_enabled)
+    {
+      printf_filtered (_("Infrun statistics are not being collected; "
+			 "use \"maint set infrun-stats on\".\n"));
+      return;
+    }
+
+  elapsed = infrun_stats_now () - infrun_stats_start_usecs;
+  events = infrun_phase_stats[INFRUN_PHASE_HANDLE_EVENT].count;
+  printf_filtered (_("%s events handled in %s.%06lu seconds"),
+		   pulongest (events), pulongest (elapsed / 1000000),
+		   (unsigned long) (elapsed % 1000000));
+  if (elapsed != 0)
+    printf_filtered (_(", %s per second"),
+		     pulongest (events * 1000000 / elapsed));
+  printf_filtered (".\n");
+
+  printf_filtered ("%-24s %8s %10s %10s %10s",
+		   _("Phase"), _("Count"), _("Avg usecs"), _("Max usecs"),
+		   _("Tot usecs"));
+  for (bucket = 0; bucket < INFRUN_STATS_BUCKETS; bucket++)
+    printf_filtered (" %7s", bucket_names[bucket]);
+  printf_filtered ("\n");
+
+  for (phase = 0; phase < INFRUN_PHASE_COUNT; phase++)
+    {
+      printf_filtered ("%-24s %8s %10s %10s %10s",
+		       infrun_phase_names[phase],
+		       pulongest (infrun_phase_stats[phase].count),
+		       pulongest (infrun_phase_stats[phase].count != 0
+				  ? (infrun_phase_stats[phase].usecs
+				     / infrun_phase_stats[phase].count)
+				  : 0),
+		       pulongest (infrun_phase_stats[phase].max_usecs),
+		       pulongest (infrun_phase_stats[phase].usecs));
+      for (bucket = 0; bucket < INFRUN_STATS_BUCKETS; bucket++)
+	printf_filtered (" %7s",
+			 pulongest (infrun_phase_stats[phase].histogram[bucket]));
+      printf_filtered ("\n");
+    }
+}
+
 
 /* Support for disabling address space randomization.  */
 
@@ -1063,15 +1243,17 @@ static ptid_t deferred_step_ptid;
 
    In non-stop mode, we can have independent and simultaneous step
    requests, so more than one thread may need to simultaneously step
-   over a breakpoint.  The current implementation assumes there is
-   only one scratch space per process.  In this case, we have to
-   serialize access to the scratch space.  If thread A wants to step
-   over a breakpoint, but we are currently waiting for some other
-   thread to complete a displaced step, we leave thread A stopped and
-   place it in the displaced_step_request_queue.  Whenever a displaced
-   step finishes, we pick the next thread in the queue and start a new
-   displaced step operation on it.  See displaced_step_prepare and
-   displaced_step_fixup for details.  */
+   over a breakpoint.  We carve as many scratch pads as fit out of the
+   function containing the location gdbarch_displaced_step_location
+   returns (usually the program's entry point, whose code is only run
+   once), up to DISPLACED_STEP_MAX_BUFFERS, and let that many threads
+   step at the same time.  If thread A wants to step over a
+   breakpoint, but all the scratch pads are in use by other threads'
+   displaced steps, we leave thread A stopped and place it in the
+   displaced_step_request_queue.  Whenever a displaced step finishes,
+   we pick the next thread in the queue and start a new displaced
+   step operation on it, in the scratch pad just freed.  See
+   displaced_step_prepare and displaced_step_fixup for details.  */
 
 struct displaced_step_request
 {
@@ -1079,22 +1261,16 @@ struct displaced_step_request
   struct displaced_step_request *next;
 };
 
-/* Per-inferior displaced stepping state.  */
-struct displaced_step_inferior_state
-{
-  /* Pointer to next in linked list.  */
-  struct displaced_step_inferior_state *next;
-
-  /* The process this displaced step state refers to.  */
-  int pid;
-
-  /* A queue of pending displaced stepping requests.  One entry per
-     thread that needs to do a displaced step.  */
-  struct displaced_step_request *step_request_queue;
+/* The maximum number of scratch pads, and so of simultaneous
+   displaced steps, per inferior.  */
+#define DISPLACED_STEP_MAX_BUFFERS 16
 
+/* A scratch pad, and the displaced step using it.  */
+struct displaced_step_buffer
+{
   /* If this is not null_ptid, this is the thread carrying out a
-     displaced single-step in process PID.  This thread's state will
-     require fixing up once it has completed its step.  */
+     displaced single-step in this scratch pad.  This thread's state
+     will require fixing up once it has completed its step.  */
   ptid_t step_ptid;
 
   /* The architecture the thread had when we stepped it.  */
@@ -1112,6 +1288,29 @@ struct displaced_step_inferior_state
   gdb_byte *step_saved_copy;
 };
 
+/* Per-inferior displaced stepping state.  */
+struct displaced_step_inferior_state
+{
+  /* Pointer to next in linked list.  */
+  struct displaced_step_inferior_state *next;
+
+  /* The process this displaced step state refers to.  */
+  int pid;
+
+  /* A queue of pending displaced stepping requests.  One entry per
+     thread that needs to do a displaced step.  */
+  struct displaced_step_request *step_request_queue;
+
+  /* The number of scratch pads in BUFFERS we may use, and where the
+     first starts.  These are computed again whenever no displaced
+     step is in progress.  */
+  int num_buffers;
+  CORE_ADDR buffers_base;
+
+  /* The scratch pads.  */
+  struct displaced_step_buffer buffers[DISPLACED_STEP_MAX_BUFFERS];
+};
+
 /* The list of states of processes involved in displaced stepping
    presently.  */
 static struct displaced_step_inferior_state *displaced_step_inferior_states;
@@ -1155,6 +1354,38 @@ add_displaced_stepping_state (int pid)
   return state;
 }
 
+/* Return the scratch pad of DISPLACED that thread PTID is displaced
+   stepping in, or NULL if PTID is not displaced stepping.  */
+
+static struct displaced_step_buffer *
+displaced_step_find_buffer (struct displaced_step_inferior_state *displaced,
+			    ptid_t ptid)
+{
+  int i;
+
+  for (i = 0; i < displaced->num_buffers; i++)
+    if (!ptid_equal (displaced->buffers[i].step_ptid, null_ptid)
+	&& ptid_equal (displaced->buffers[i].step_ptid, ptid))
+      return &displaced->buffers[i];
+
+  return NULL;
+}
+
+/* Return non-zero if any thread of DISPLACED's process is displaced
+   stepping.  */
+
+static int
+displaced_step_in_progress (struct displaced_step_inferior_state *displaced)
+{
+  int i;
+
+  for (i = 0; i < displaced->num_buffers; i++)
+    if (!ptid_equal (displaced->buffers[i].step_ptid, null_ptid))
+      return 1;
+
+  return 0;
+}
+
 /* If inferior is in displaced stepping, and ADDR equals to starting address
    of copy area, return corresponding displaced_step_closure.  Otherwise,
    return NULL.  */
@@ -1165,10 +1396,16 @@ get_displaced_step_closure_by_addr (CORE_ADDR addr)
   struct displaced_step_inferior_state *displaced
     = get_displaced_stepping_state (ptid_get_pid (inferior_ptid));
 
+  int i;
+
+  if (displaced == NULL)
+    return NULL;
+
   /* If checking the mode of displaced instruction in copy area.  */
-  if (displaced && !ptid_equal (displaced->step_ptid, null_ptid)
-     && (displaced->step_copy == addr))
-    return displaced->step_closure;
+  for (i = 0; i < displaced->num_buffers; i++)
+    if (!ptid_equal (displaced->buffers[i].step_ptid, null_ptid)
+	&& displaced->buffers[i].step_copy == addr)
+      return displaced->buffers[i].step_closure;
 
   return NULL;
 }
@@ -1188,7 +1425,11 @@ remove_displaced_stepping_state (int pid)
     {
       if (it->pid == pid)
 	{
+	  int i;
+
 	  *prev_next_p = it->next;
+	  for (i = 0; i < DISPLACED_STEP_MAX_BUFFERS; i++)
+	    xfree (it->buffers[i].step_saved_copy);
 	  xfree (it);
 	  return;
 	}
@@ -1244,25 +1485,50 @@ use_displaced_stepping (struct gdbarch *gdbarch)
 
 /* Clean out any stray displaced stepping state.  */
 static void
-displaced_step_clear (struct displaced_step_inferior_state *displaced)
+displaced_step_clear (struct displaced_step_buffer *buffer)
 {
   /* Indicate that there is no cleanup pending.  */
-  displaced->step_ptid = null_ptid;
+  buffer->step_ptid = null_ptid;
 
-  if (displaced->step_closure)
+  if (buffer->step_closure)
     {
-      gdbarch_displaced_step_free_closure (displaced->step_gdbarch,
-                                           displaced->step_closure);
-      displaced->step_closure = NULL;
+      gdbarch_displaced_step_free_closure (buffer->step_gdbarch,
+                                           buffer->step_closure);
+      buffer->step_closure = NULL;
     }
 }
 
 static void
 displaced_step_clear_cleanup (void *arg)
 {
-  struct displaced_step_inferior_state *state = arg;
+  struct displaced_step_buffer *buffer = arg;
 
-  displaced_step_clear (state);
+  displaced_step_clear (buffer);
+}
+
+/* Return how many scratch pads of LEN bytes fit between BASE, the
+   address gdbarch_displaced_step_location returned, and the end of
+   the function containing it.  */
+
+static int
+displaced_step_buffer_count (CORE_ADDR base, ULONGEST len)
+{
+  struct bound_minimal_symbol msymbol = lookup_minimal_symbol_by_pc (base);
+  int count = 1;
+
+  if (msymbol.minsym != NULL && MSYMBOL_SIZE (msymbol.minsym) > 0)
+    {
+      CORE_ADDR end = (SYMBOL_VALUE_ADDRESS (msymbol.minsym)
+		       + MSYMBOL_SIZE (msymbol.minsym));
+
+      if (end > base + len)
+	count = (end - base) / len;
+    }
+
+  if (count > DISPLACED_STEP_MAX_BUFFERS)
+    count = DISPLACED_STEP_MAX_BUFFERS;
+
+  return count;
 }
 
 /* Dump LEN bytes at BUF in hex to FILE, followed by a newline.  */
@@ -1303,7 +1569,8 @@ displaced_step_prepare (ptid_t ptid)
   ULONGEST len;
   struct displaced_step_closure *closure;
   struct displaced_step_inferior_state *displaced;
-  int status;
+  struct displaced_step_buffer *buffer = NULL;
+  int status, i;
 
   /* We should never reach this function if the architecture does not
      support displaced stepping.  */
@@ -1315,12 +1582,30 @@ displaced_step_prepare (ptid_t ptid)
      jump/branch).  */
   tp->control.may_range_step = 0;
 
-  /* We have to displaced step one thread at a time, as we only have
-     access to a single scratch space per inferior.  */
+  /* We can only displaced step as many threads at a time as we have
+     scratch pads.  */
 
   displaced = add_displaced_stepping_state (ptid_get_pid (ptid));
+  len = gdbarch_max_insn_length (gdbarch);
+
+  if (!displaced_step_in_progress (displaced))
+    {
+      old_cleanups = save_inferior_ptid ();
+      inferior_ptid = ptid;
+      displaced->buffers_base = gdbarch_displaced_step_location (gdbarch);
+      displaced->num_buffers
+	= displaced_step_buffer_count (displaced->buffers_base, len);
+      do_cleanups (old_cleanups);
+    }
+
+  for (i = 0; i < displaced->num_buffers; i++)
+    if (ptid_equal (displaced->buffers[i].step_ptid, null_ptid))
+      {
+	buffer = &displaced->buffers[i];
+	break;
+      }
 
-  if (!ptid_equal (displaced->step_ptid, null_ptid))
+  if (buffer == NULL)
     {
       /* Already waiting for a displaced step to finish.  Defer this
 	 request and place in queue.  */
@@ -1356,21 +1641,21 @@ displaced_step_prepare (ptid_t ptid)
 			    target_pid_to_str (ptid));
     }
 
-  displaced_step_clear (displaced);
+  displaced_step_clear (buffer);
 
   old_cleanups = save_inferior_ptid ();
   inferior_ptid = ptid;
 
   original = regcache_read_pc (regcache);
 
-  copy = gdbarch_displaced_step_location (gdbarch);
-  len = gdbarch_max_insn_length (gdbarch);
+  copy = displaced->buffers_base + (buffer - displaced->buffers) * len;
 
   /* Save the original contents of the copy area.  */
-  displaced->step_saved_copy = xmalloc (len);
+  xfree (buffer->step_saved_copy);
+  buffer->step_saved_copy = xmalloc (len);
   ignore_cleanups = make_cleanup (free_current_contents,
-				  &displaced->step_saved_copy);
-  status = target_read_memory (copy, displaced->step_saved_copy, len);
+				  &buffer->step_saved_copy);
+  status = target_read_memory (copy, buffer->step_saved_copy, len);
   if (status != 0)
     throw_error (MEMORY_ERROR,
 		 _("Error accessing memory address %s (%s) for "
@@ -1381,7 +1666,7 @@ displaced_step_prepare (ptid_t ptid)
       fprintf_unfiltered (gdb_stdlog, "displaced: saved %s: ",
 			  paddress (gdbarch, copy));
       displaced_step_dump_bytes (gdb_stdlog,
-				 displaced->step_saved_copy,
+				 buffer->step_saved_copy,
 				 len);
     };
 
@@ -1393,13 +1678,13 @@ displaced_step_prepare (ptid_t ptid)
 
   /* Save the information we need to fix things up if the step
      succeeds.  */
-  displaced->step_ptid = ptid;
-  displaced->step_gdbarch = gdbarch;
-  displaced->step_closure = closure;
-  displaced->step_original = original;
-  displaced->step_copy = copy;
+  buffer->step_ptid = ptid;
+  buffer->step_gdbarch = gdbarch;
+  buffer->step_closure = closure;
+  buffer->step_original = original;
+  buffer->step_copy = copy;
 
-  make_cleanup (displaced_step_clear_cleanup, displaced);
+  make_cleanup (displaced_step_clear_cleanup, buffer);
 
   /* Resume execution at the copy.  */
   regcache_write_pc (regcache, copy);
@@ -1429,18 +1714,17 @@ write_memory_ptid (ptid_t ptid, CORE_ADDR memaddr,
 /* Restore the contents of the copy area for thread PTID.  */
 
 static void
-displaced_step_restore (struct displaced_step_inferior_state *displaced,
-			ptid_t ptid)
+displaced_step_restore (struct displaced_step_buffer *buffer, ptid_t ptid)
 {
-  ULONGEST len = gdbarch_max_insn_length (displaced->step_gdbarch);
+  ULONGEST len = gdbarch_max_insn_length (buffer->step_gdbarch);
 
-  write_memory_ptid (ptid, displaced->step_copy,
-		     displaced->step_saved_copy, len);
+  write_memory_ptid (ptid, buffer->step_copy,
+		     buffer->step_saved_copy, len);
   if (debug_displaced)
     fprintf_unfiltered (gdb_stdlog, "displaced: restored %s %s\n",
 			target_pid_to_str (ptid),
-			paddress (displaced->step_gdbarch,
-				  displaced->step_copy));
+			paddress (buffer->step_gdbarch,
+				  buffer->step_copy));
 }
 
 static void
@@ -1449,29 +1733,30 @@ displaced_step_fixup (ptid_t event_ptid, enum gdb_signal signal)
   struct cleanup *old_cleanups;
   struct displaced_step_inferior_state *displaced
     = get_displaced_stepping_state (ptid_get_pid (event_ptid));
+  struct displaced_step_buffer *buffer;
 
   /* Was any thread of this process doing a displaced step?  */
   if (displaced == NULL)
     return;
 
-  /* Was this event for the pid we displaced?  */
-  if (ptid_equal (displaced->step_ptid, null_ptid)
-      || ! ptid_equal (displaced->step_ptid, event_ptid))
+  /* Was this event for a thread we displaced?  */
+  buffer = displaced_step_find_buffer (displaced, event_ptid);
+  if (buffer == NULL)
     return;
 
-  old_cleanups = make_cleanup (displaced_step_clear_cleanup, displaced);
+  old_cleanups = make_cleanup (displaced_step_clear_cleanup, buffer);
 
-  displaced_step_restore (displaced, displaced->step_ptid);
+  displaced_step_restore (buffer, buffer->step_ptid);
 
   /* Did the instruction complete successfully?  */
   if (signal == GDB_SIGNAL_TRAP)
     {
       /* Fix up the resulting state.  */
-      gdbarch_displaced_step_fixup (displaced->step_gdbarch,
-                                    displaced->step_closure,
-                                    displaced->step_original,
-                                    displaced->step_copy,
-                                    get_thread_regcache (displaced->step_ptid));
+      gdbarch_displaced_step_fixup (buffer->step_gdbarch,
+                                    buffer->step_closure,
+                                    buffer->step_original,
+                                    buffer->step_copy,
+                                    get_thread_regcache (buffer->step_ptid));
     }
   else
     {
@@ -1480,13 +1765,13 @@ displaced_step_fixup (ptid_t event_ptid, enum gdb_signal signal)
       struct regcache *regcache = get_thread_regcache (event_ptid);
       CORE_ADDR pc = regcache_read_pc (regcache);
 
-      pc = displaced->step_original + (pc - displaced->step_copy);
+      pc = buffer->step_original + (pc - buffer->step_copy);
       regcache_write_pc (regcache, pc);
     }
 
   do_cleanups (old_cleanups);
 
-  displaced->step_ptid = null_ptid;
+  buffer->step_ptid = null_ptid;
 
   /* Are there any pending displaced stepping requests?  If so, run
      one now.  Leave the state object around, since we're likely to
@@ -1533,8 +1818,9 @@ displaced_step_fixup (ptid_t event_ptid, enum gdb_signal signal)
 	      displaced_step_dump_bytes (gdb_stdlog, buf, sizeof (buf));
 	    }
 
+	  buffer = displaced_step_find_buffer (displaced, ptid);
 	  if (gdbarch_displaced_step_hw_singlestep (gdbarch,
-						    displaced->step_closure))
+						    buffer->step_closure))
 	    target_resume (ptid, 1, GDB_SIGNAL_0);
 	  else
 	    target_resume (ptid, 0, GDB_SIGNAL_0);
@@ -1589,8 +1875,11 @@ infrun_thread_ptid_changed (ptid_t old_ptid, ptid_t new_ptid)
        displaced;
        displaced = displaced->next)
     {
-      if (ptid_equal (displaced->step_ptid, old_ptid))
-	displaced->step_ptid = new_ptid;
+      int i;
+
+      for (i = 0; i < displaced->num_buffers; i++)
+	if (ptid_equal (displaced->buffers[i].step_ptid, old_ptid))
+	  displaced->buffers[i].step_ptid = new_ptid;
 
       for (it = displaced->step_request_queue; it; it = it->next)
 	if (ptid_equal (it->ptid, old_ptid))
@@ -1794,6 +2083,7 @@ a command like `return' or `jump' to continue execution."));
       && !current_inferior ()->waiting_for_vfork_done)
     {
       struct displaced_step_inferior_state *displaced;
+      struct displaced_step_buffer *buffer;
 
       if (!displaced_step_prepare (inferior_ptid))
 	{
@@ -1813,8 +2103,9 @@ a command like `return' or `jump' to continue execution."));
       pc = regcache_read_pc (get_thread_regcache (inferior_ptid));
 
       displaced = get_displaced_stepping_state (ptid_get_pid (inferior_ptid));
+      buffer = displaced_step_find_buffer (displaced, inferior_ptid);
       step = gdbarch_displaced_step_hw_singlestep (gdbarch,
-						   displaced->step_closure);
+						   buffer->step_closure);
     }
 
   /* Do we need to do it the hard way, w/temp breakpoints?  */
@@ -2015,6 +2306,10 @@ clear_proceed_status_callback (struct thread_info *tp, void *data)
 void
 clear_proceed_status (void)
 {
+  struct infrun_phase_timer timer;
+
+  infrun_phase_begin (&timer, INFRUN_PHASE_CLEAR_PROCEED);
+
   if (!non_stop)
     {
       /* In all-stop mode, delete the per-thread status of all
@@ -2048,6 +2343,8 @@ clear_proceed_status (void)
       regcache_xfree (stop_registers);
       stop_registers = NULL;
     }
+
+  infrun_phase_end (&timer);
 }
 
 /* Check the current thread against the thread that reported the most recent
@@ -2652,7 +2949,7 @@ prepare_for_detach (void)
 
   /* Is any thread of this process displaced stepping?  If not,
      there's nothing else to do.  */
-  if (displaced == NULL || ptid_equal (displaced->step_ptid, null_ptid))
+  if (displaced == NULL || !displaced_step_in_progress (displaced))
     return;
 
   if (debug_infrun)
@@ -2662,7 +2959,7 @@ prepare_for_detach (void)
   old_chain_1 = make_cleanup_restore_integer (&inf->detaching);
   inf->detaching = 1;
 
-  while (!ptid_equal (displaced->step_ptid, null_ptid))
+  while (displaced_step_in_progress (displaced))
     {
       struct cleanup *old_chain_2;
       struct execution_control_state ecss;
@@ -3139,12 +3436,26 @@ fill_in_stop_func (struct gdbarch *gdbarch,
     }
 }
 
+static void handle_inferior_event_1 (struct execution_control_state *ecs);
+
 /* Given an execution control state that has been freshly filled in
    by an event from the inferior, figure out what it means and take
    appropriate action.  */
 
 static void
 handle_inferior_event (struct execution_control_state *ecs)
+{
+  struct infrun_phase_timer timer;
+
+  infrun_phase_begin (&timer, INFRUN_PHASE_HANDLE_EVENT);
+  handle_inferior_event_1 (ecs);
+  infrun_phase_end (&timer);
+}
+
+/* Worker for handle_inferior_event.  */
+
+static void
+handle_inferior_event_1 (struct execution_control_state *ecs)
 {
   struct frame_info *frame;
   struct gdbarch *gdbarch;
@@ -3488,10 +3799,13 @@ Cannot fill $_exitsignal with the correct signal number.\n"));
 	struct gdbarch *gdbarch = get_regcache_arch (regcache);
 	struct displaced_step_inferior_state *displaced
 	  = get_displaced_stepping_state (ptid_get_pid (ecs->ptid));
+	struct displaced_step_buffer *buffer
+	  = (displaced != NULL
+	     ? displaced_step_find_buffer (displaced, ecs->ptid) : NULL);
 
 	/* If checking displaced stepping is supported, and thread
 	   ecs->ptid is displaced stepping.  */
-	if (displaced && ptid_equal (displaced->step_ptid, ecs->ptid))
+	if (buffer != NULL)
 	  {
 	    struct inferior *parent_inf
 	      = find_inferior_pid (ptid_get_pid (ecs->ptid));
@@ -3508,7 +3822,7 @@ Cannot fill $_exitsignal with the correct signal number.\n"));
 	    if (ecs->ws.kind == TARGET_WAITKIND_FORKED)
 	      {
 		/* Restore scratch pad for child process.  */
-		displaced_step_restore (displaced, ecs->ws.value.related_pid);
+		displaced_step_restore (buffer, ecs->ws.value.related_pid);
 	      }
 
 	    /* Since the vfork/fork syscall instruction was executed in the scratchpad,
@@ -6205,11 +6519,15 @@ done:
 	       && inferior_thread ()->control.proceed_to_finish)
 	  && !inferior_thread ()->control.in_infcall))
     {
+      struct infrun_phase_timer timer;
+
+      infrun_phase_begin (&timer, INFRUN_PHASE_STOP_OBSERVERS);
       if (!ptid_equal (inferior_ptid, null_ptid))
 	observer_notify_normal_stop (inferior_thread ()->control.stop_bpstat,
 				     stop_print_frame);
       else
 	observer_notify_normal_stop (NULL, stop_print_frame);
+      infrun_phase_end (&timer);
     }
 
   if (target_has_execution)
@@ -7250,6 +7568,27 @@ When non-zero, inferior specific debugging is enabled."),
 			     show_debug_infrun,
 			     &setdebuglist, &showdebuglist);
 
+  add_setshow_boolean_cmd ("infrun-stats", class_maintenance,
+			   &infrun_stats_enabled, _("\
+Set whether to collect statistics about the handling of inferior events."), _("\
+Show whether to collect statistics about the handling of inferior events."), _("\
+When on, GDB times the phases of the handling of each event from the\n\
+inferior, such as checking breakpoint conditions, for\n\
+\"maintenance info infrun-stats\".  Turning this on clears the statistics."),
+			   set_infrun_stats_enabled,
+			   show_infrun_stats_enabled,
+			   &maintenance_set_cmdlist,
+			   &maintenance_show_cmdlist);
+
+  add_cmd ("infrun-stats", class_maintenance,
+	   maintenance_info_infrun_stats, _("\
+Show statistics about the handling of inferior events.\n\
+This shows the number of events handled per second and, for each phase\n\
+of their handling, how many times it ran, its average, longest and total\n\
+duration, and a histogram of its durations.  Phases nest: for instance,\n\
+handle_inferior_event includes bpstat_stop_status."),
+	   &maintenanceinfolist);
+
   add_setshow_boolean_cmd ("displaced", class_maintenance,
 			   &debug_displaced, _("\
 Set displaced stepping debugging."), _("\
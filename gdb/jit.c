@@ -40,6 +40,7 @@
 #include "gdb_stat.h"
 #include "exceptions.h"
 #include "gdb_bfd.h"
+#include "hashtab.h"
 
 static const char *jit_reader_dir = NULL;
 
@@ -74,29 +75,52 @@ struct target_buffer
 {
   CORE_ADDR base;
   ULONGEST size;
+
+  /* A copy of the whole file, or NULL if it could not be read at
+     once, in which case reads go to the target.  */
+  gdb_byte *contents;
 };
 
-/* Openning the file is a no-op.  */
+/* Opening the file reads it from the target with a single transfer.
+   BFD reads the headers, tables and sections of the file with many
+   small reads, each of which would otherwise go to the target.  */
 
 static void *
 mem_bfd_iovec_open (struct bfd *abfd, void *open_closure)
 {
+  struct target_buffer *buffer = (struct target_buffer *) open_closure;
+
+  if (buffer->size == (size_t) buffer->size)
+    buffer->contents = malloc (buffer->size);
+  if (buffer->contents != NULL
+      && target_read_memory (buffer->base, buffer->contents,
+			     buffer->size) != 0)
+    {
+      free (buffer->contents);
+      buffer->contents = NULL;
+    }
+
   return open_closure;
 }
 
-/* Closing the file is just freeing the base/size pair on our side.  */
+/* Closing the file is just freeing the base/size pair and the copy of
+   the file on our side.  */
 
 static int
 mem_bfd_iovec_close (struct bfd *abfd, void *stream)
 {
-  xfree (stream);
+  struct target_buffer *buffer = (struct target_buffer *) stream;
+
+  free (buffer->contents);
+  xfree (buffer);
 
   /* Zero means success.  */
   return 0;
 }
 
-/* For reading the file, we just need to pass through to target_read_memory and
-   fix up the arguments and return values.  */
+/* For reading the file, we just need to copy from the file's contents, or
+   pass through to target_read_memory, and fix up the arguments and return
+   values.  */
 
 static file_ptr
 mem_bfd_iovec_pread (struct bfd *abfd, void *stream, void *buf,
@@ -113,6 +137,12 @@ mem_bfd_iovec_pread (struct bfd *abfd, void *stream, void *buf,
   if (nbytes == 0)
     return 0;
 
+  if (buffer->contents != NULL)
+    {
+      memcpy (buf, buffer->contents + offset, nbytes);
+      return nbytes;
+    }
+
   err = target_read_memory (buffer->base + offset, (gdb_byte *) buf, nbytes);
   if (err)
     return -1;
@@ -136,7 +166,7 @@ mem_bfd_iovec_stat (struct bfd *abfd, void *stream, struct stat *sb)
 static struct bfd *
 bfd_open_from_target_memory (CORE_ADDR addr, ULONGEST size, char *target)
 {
-  struct target_buffer *buffer = xmalloc (sizeof (struct target_buffer));
+  struct target_buffer *buffer = XCNEW (struct target_buffer);
 
   buffer->base = addr;
   buffer->size = size;
@@ -256,6 +286,14 @@ struct jit_program_space_data
      set.  */
 
   struct breakpoint *jit_breakpoint;
+
+  /* The objfiles created for JIT code entries, keyed by the address of
+     the struct jit_code_entry.  A JIT can register many thousands of
+     entries, and each registration and unregistration needs to find
+     the objfile of its entry.  This is NULL until an objfile is
+     created.  */
+
+  htab_t entry_objfiles;
 };
 
 /* Per-objfile structure recording the addresses in the program space.
@@ -295,18 +333,6 @@ get_jit_objfile_data (struct objfile *objf)
   return objf_data;
 }
 
-/* Remember OBJFILE has been created for struct jit_code_entry located
-   at inferior address ENTRY.  */
-
-static void
-add_objfile_entry (struct objfile *objfile, CORE_ADDR entry)
-{
-  struct jit_objfile_data *objf_data;
-
-  objf_data = get_jit_objfile_data (objfile);
-  objf_data->addr = entry;
-}
-
 /* Return jit_program_space_data for current program space.  Allocate
    if not already present.  */
 
@@ -326,10 +352,70 @@ get_jit_program_space_data (void)
   return ps_data;
 }
 
+/* Hash the jit_code_entry address ADDR.  */
+
+static hashval_t
+hash_entry_addr (CORE_ADDR addr)
+{
+  return iterative_hash_object (addr, 0);
+}
+
+/* Hash function for the entry_objfiles table, whose elements are
+   objfiles.  */
+
+static hashval_t
+hash_entry_objfile (const void *p)
+{
+  const struct objfile *objfile = p;
+  const struct jit_objfile_data *objf_data;
+
+  objf_data = objfile_data ((struct objfile *) objfile, jit_objfile_data);
+  return hash_entry_addr (objf_data->addr);
+}
+
+/* Equality function for the entry_objfiles table.  OBJFILE is an
+   element and ENTRY points to the jit_code_entry address looked up.  */
+
+static int
+eq_entry_objfile (const void *objfile, const void *entry)
+{
+  const struct jit_objfile_data *objf_data;
+
+  objf_data = objfile_data ((struct objfile *) objfile, jit_objfile_data);
+  return objf_data->addr == *(const CORE_ADDR *) entry;
+}
+
+/* Remember OBJFILE has been created for struct jit_code_entry located
+   at inferior address ENTRY.  */
+
+static void
+add_objfile_entry (struct objfile *objfile, CORE_ADDR entry)
+{
+  struct jit_objfile_data *objf_data;
+  struct jit_program_space_data *ps_data;
+  void **slot;
+
+  objf_data = get_jit_objfile_data (objfile);
+  objf_data->addr = entry;
+
+  ps_data = get_jit_program_space_data ();
+  if (ps_data->entry_objfiles == NULL)
+    ps_data->entry_objfiles = htab_create_alloc (127, hash_entry_objfile,
+						 eq_entry_objfile, NULL,
+						 xcalloc, xfree);
+  slot = htab_find_slot_with_hash (ps_data->entry_objfiles, &entry,
+				   hash_entry_addr (entry), INSERT);
+  *slot = objfile;
+}
+
 static void
 jit_program_space_data_cleanup (struct program_space *ps, void *arg)
 {
-  xfree (arg);
+  struct jit_program_space_data *ps_data = arg;
+
+  if (ps_data->entry_objfiles != NULL)
+    htab_delete (ps_data->entry_objfiles);
+  xfree (ps_data);
 }
 
 /* Helper function for reading the global JIT descriptor from remote
@@ -798,6 +884,7 @@ jit_object_close_impl (struct gdb_symbol_callbacks *cb,
       finalize_symtab (i, objfile);
     }
   add_objfile_entry (objfile, *priv_data);
+  forget_symbol_lookup_failures (objfile->pspace);
   xfree (obj);
 }
 
@@ -859,12 +946,13 @@ jit_reader_try_read_symtab (struct jit_code_entry *code_entry,
 }
 
 /* Try to read CODE_ENTRY using BFD.  ENTRY_ADDR is the address of the
-   struct jit_code_entry in the inferior address space.  */
+   struct jit_code_entry in the inferior address space.  ADD_FLAGS are
+   passed to symbol_file_add_from_bfd.  */
 
 static void
 jit_bfd_try_read_symtab (struct jit_code_entry *code_entry,
                          CORE_ADDR entry_addr,
-                         struct gdbarch *gdbarch)
+                         struct gdbarch *gdbarch, int add_flags)
 {
   bfd *nbfd;
   struct section_addr_info *sai;
@@ -926,7 +1014,8 @@ JITed symbol file is not an object file, ignoring it.\n"));
 
   /* This call does not take ownership of SAI.  */
   make_cleanup_bfd_unref (nbfd);
-  objfile = symbol_file_add_from_bfd (nbfd, bfd_get_filename (nbfd), 0, sai,
+  objfile = symbol_file_add_from_bfd (nbfd, bfd_get_filename (nbfd),
+				      add_flags, sai,
 				      OBJF_SHARED | OBJF_NOT_FILENAME, NULL);
 
   do_cleanups (old_cleanups);
@@ -936,11 +1025,14 @@ JITed symbol file is not an object file, ignoring it.\n"));
 /* This function registers code associated with a JIT code entry.  It uses the
    pointer and size pair in the entry to read the symbol file from the remote
    and then calls symbol_file_add_from_local_memory to add it as though it were
-   a symbol file added by the user.  */
+   a symbol file added by the user.  ADD_FLAGS are as for
+   symbol_file_add_from_bfd; SYMFILE_DEFER_BP_RESET lets the caller
+   re-set the breakpoints once for many entries.  */
 
 static void
 jit_register_code (struct gdbarch *gdbarch,
-                   CORE_ADDR entry_addr, struct jit_code_entry *code_entry)
+                   CORE_ADDR entry_addr, struct jit_code_entry *code_entry,
+		   int add_flags)
 {
   int success;
 
@@ -954,7 +1046,7 @@ jit_register_code (struct gdbarch *gdbarch,
   success = jit_reader_try_read_symtab (code_entry, entry_addr);
 
   if (!success)
-    jit_bfd_try_read_symtab (code_entry, entry_addr, gdbarch);
+    jit_bfd_try_read_symtab (code_entry, entry_addr, gdbarch, add_flags);
 }
 
 /* This function unregisters JITed code and frees the corresponding
@@ -971,17 +1063,12 @@ jit_unregister_code (struct objfile *objfile)
 static struct objfile *
 jit_find_objf_with_entry_addr (CORE_ADDR entry_addr)
 {
-  struct objfile *objf;
+  struct jit_program_space_data *ps_data = get_jit_program_space_data ();
 
-  ALL_OBJFILES (objf)
-    {
-      struct jit_objfile_data *objf_data;
-
-      objf_data = objfile_data (objf, jit_objfile_data);
-      if (objf_data != NULL && objf_data->addr == entry_addr)
-        return objf;
-    }
-  return NULL;
+  if (ps_data->entry_objfiles == NULL)
+    return NULL;
+  return htab_find_with_hash (ps_data->entry_objfiles, &entry_addr,
+			      hash_entry_addr (entry_addr));
 }
 
 /* This is called when a breakpoint is deleted.  It updates the
@@ -1306,6 +1393,7 @@ jit_inferior_init (struct gdbarch *gdbarch)
   struct jit_code_entry cur_entry;
   struct jit_program_space_data *ps_data;
   CORE_ADDR cur_entry_addr;
+  int registered = 0;
 
   if (jit_debug)
     fprintf_unfiltered (gdb_stdlog, "jit_inferior_init\n");
@@ -1343,8 +1431,15 @@ jit_inferior_init (struct gdbarch *gdbarch)
       if (jit_find_objf_with_entry_addr (cur_entry_addr) != NULL)
         continue;
 
-      jit_register_code (gdbarch, cur_entry_addr, &cur_entry);
+      /* Re-set the breakpoints once for all the entries, rather than
+	 after reading each of them.  */
+      jit_register_code (gdbarch, cur_entry_addr, &cur_entry,
+			 SYMFILE_DEFER_BP_RESET);
+      registered = 1;
     }
+
+  if (registered)
+    breakpoint_re_set ();
 }
 
 /* Exported routine to call when an inferior has been created.  */
@@ -1406,7 +1501,7 @@ jit_event_handler (struct gdbarch *gdbarch)
       break;
     case JIT_REGISTER:
       jit_read_code_entry (gdbarch, entry_addr, &code_entry);
-      jit_register_code (gdbarch, entry_addr, &code_entry);
+      jit_register_code (gdbarch, entry_addr, &code_entry, 0);
       break;
     case JIT_UNREGISTER:
       objf = jit_find_objf_with_entry_addr (entry_addr);
@@ -1440,6 +1535,24 @@ free_objfile_data (struct objfile *objfile, void *data)
 	ps_data->objfile = NULL;
     }
 
+  if (objf_data->addr != 0)
+    {
+      struct jit_program_space_data *ps_data;
+
+      ps_data = program_space_data (objfile->pspace, jit_program_space_data);
+      if (ps_data != NULL && ps_data->entry_objfiles != NULL)
+	{
+	  void **slot;
+
+	  slot = htab_find_slot_with_hash (ps_data->entry_objfiles,
+					   &objf_data->addr,
+					   hash_entry_addr (objf_data->addr),
+					   NO_INSERT);
+	  if (slot != NULL && *slot == objfile)
+	    htab_clear_slot (ps_data->entry_objfiles, slot);
+	}
+    }
+
   xfree (data);
 }
 
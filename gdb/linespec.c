@@ -988,11 +988,204 @@ iterate_name_matcher (const char *name, void *d)
   return 0; /* Skip this symbol.  */
 }
 
+/* The symbols of an objfile found by one search of
+   iterate_over_all_matching_symtabs.  Breakpoints are re-set every
+   time a shared library is loaded, and each re-set searches every
+   objfile for the names in all the linespecs again.  Each objfile
+   keeps a table of the results, which stay good until a symtab is
+   added to the objfile.  */
+
+struct matching_symbols
+{
+  /* The name searched for.  It is allocated along with the entry.  */
+  char *name;
+
+  /* The other parameters of the search.  */
+  domain_enum domain;
+  int include_inline;
+  const struct language_defn *language;
+  enum case_sensitivity case_sensitivity;
+
+  /* The objfile's most recent symtab at the time of the search.
+     Symtabs are only ever added at the front of the list.  */
+  struct symtab *symtabs;
+
+  /* The symbols found, in the order they were found.  */
+  VEC (symbolp) *symbols;
+};
+
+/* The key of the per-objfile table of struct matching_symbols.  */
+
+static const struct objfile_data *matching_symbols_key;
+
+/* The maximum number of entries in an objfile's table of matching
+   symbols.  When it is full the table is emptied, rather than keeping
+   track of which entries were used last.  */
+
+#define MAX_MATCHING_SYMBOLS 1024
+
+/* Hash function for struct matching_symbols.  */
+
+static hashval_t
+hash_matching_symbols (const void *p)
+{
+  const struct matching_symbols *e = p;
+
+  return htab_hash_string (e->name) * 7 + e->domain;
+}
+
+/* Equality function for struct matching_symbols.  */
+
+static int
+eq_matching_symbols (const void *a, const void *b)
+{
+  const struct matching_symbols *ea = a;
+  const struct matching_symbols *eb = b;
+
+  return (ea->domain == eb->domain
+	  && ea->include_inline == eb->include_inline
+	  && ea->language == eb->language
+	  && ea->case_sensitivity == eb->case_sensitivity
+	  && strcmp (ea->name, eb->name) == 0);
+}
+
+/* Free a struct matching_symbols.  */
+
+static void
+free_matching_symbols (void *p)
+{
+  struct matching_symbols *e = p;
+
+  VEC_free (symbolp, e->symbols);
+  xfree (e);
+}
+
+/* Free an objfile's table of matching symbols.  */
+
+static void
+matching_symbols_cleanup (struct objfile *objfile, void *arg)
+{
+  htab_delete (arg);
+}
+
+/* A callback for iterate_over_objfile_matching_symtabs, that adds SYM
+   to the vector of symbols D.  */
+
+static int
+record_matching_symbol (struct symbol *sym, void *d)
+{
+  VEC (symbolp) **symbols = d;
+
+  VEC_safe_push (symbolp, *symbols, sym);
+  return 1; /* Continue iterating.  */
+}
+
+/* Call CALLBACK for each symbol of OBJFILE, in the current program
+   space, that matches NAME in DOMAIN.  MATCHER_DATA is for
+   expand_symtabs_matching.  STATE and INCLUDE_INLINE are as for
+   iterate_over_all_matching_symtabs.  */
+
+static void
+iterate_over_objfile_matching_symtabs
+  (struct linespec_state *state, struct objfile *objfile,
+   const char *name, const domain_enum domain,
+   symbol_found_callback_ftype *callback, void *data,
+   int include_inline, struct symbol_matcher_data *matcher_data)
+{
+  htab_t table = objfile_data (objfile, matching_symbols_key);
+  struct matching_symbols e, *entry;
+  VEC (symbolp) *symbols = NULL;
+  struct cleanup *cleanup;
+  struct symtab *symtab;
+  struct symbol *sym;
+  void **slot;
+  size_t len;
+  int ix;
+
+  if (table == NULL)
+    {
+      table = htab_create_alloc (127, hash_matching_symbols,
+				 eq_matching_symbols, free_matching_symbols,
+				 xcalloc, xfree);
+      set_objfile_data (objfile, matching_symbols_key, table);
+    }
+
+  e.name = (char *) name;
+  e.domain = domain;
+  e.include_inline = include_inline;
+  e.language = state->language;
+  e.case_sensitivity = case_sensitivity;
+  slot = htab_find_slot (table, &e, NO_INSERT);
+  if (slot != NULL)
+    {
+      entry = *slot;
+      if (entry->symtabs == objfile->symtabs)
+	{
+	  for (ix = 0; VEC_iterate (symbolp, entry->symbols, ix, sym); ++ix)
+	    if (!callback (sym, data))
+	      break;
+	  return;
+	}
+      htab_clear_slot (table, slot);
+    }
+
+  cleanup = make_cleanup (VEC_cleanup (symbolp), &symbols);
+
+  if (objfile->sf)
+    objfile->sf->qf->expand_symtabs_matching (objfile, NULL,
+					      iterate_name_matcher,
+					      ALL_DOMAIN,
+					      matcher_data);
+
+  ALL_OBJFILE_PRIMARY_SYMTABS (objfile, symtab)
+    {
+      iterate_over_file_blocks (symtab, name, domain,
+				record_matching_symbol, &symbols);
+
+      if (include_inline)
+	{
+	  struct symbol_and_data_callback cad = { record_matching_symbol,
+						  &symbols };
+	  struct block *block;
+	  int i;
+
+	  for (i = FIRST_LOCAL_BLOCK;
+	       i < BLOCKVECTOR_NBLOCKS (BLOCKVECTOR (symtab)); i++)
+	    {
+	      block = BLOCKVECTOR_BLOCK (BLOCKVECTOR (symtab), i);
+	      state->language->la_iterate_over_symbols
+		(block, name, domain, iterate_inline_only, &cad);
+	    }
+	}
+    }
+
+  discard_cleanups (cleanup);
+
+  if (htab_elements (table) >= MAX_MATCHING_SYMBOLS)
+    htab_empty (table);
+
+  len = strlen (name);
+  entry = xmalloc (sizeof (*entry) + len + 1);
+  *entry = e;
+  entry->name = (char *) (entry + 1);
+  memcpy (entry->name, name, len + 1);
+  entry->symtabs = objfile->symtabs;
+  entry->symbols = symbols;
+  slot = htab_find_slot (table, entry, INSERT);
+  *slot = entry;
+
+  for (ix = 0; VEC_iterate (symbolp, entry->symbols, ix, sym); ++ix)
+    if (!callback (sym, data))
+      break;
+}
+
 /* A helper that walks over all matching symtabs in all objfiles and
    calls CALLBACK for each symbol matching NAME.  If SEARCH_PSPACE is
    not NULL, then the search is restricted to just that program
    space.  If INCLUDE_INLINE is nonzero then symbols representing
-   inlined instances of functions will be included in the result.  */
+   inlined instances of functions will be included in the result.
+   Once CALLBACK returns zero, it is not called for the remaining
+   symbols of the same objfile.  */
 
 static void
 iterate_over_all_matching_symtabs (struct linespec_state *state,
@@ -1023,35 +1216,9 @@ iterate_over_all_matching_symtabs (struct linespec_state *state,
     set_current_program_space (pspace);
 
     ALL_OBJFILES (objfile)
-    {
-      struct symtab *symtab;
-
-      if (objfile->sf)
-	objfile->sf->qf->expand_symtabs_matching (objfile, NULL,
-						  iterate_name_matcher,
-						  ALL_DOMAIN,
-						  &matcher_data);
-
-      ALL_OBJFILE_PRIMARY_SYMTABS (objfile, symtab)
-	{
-	  iterate_over_file_blocks (symtab, name, domain, callback, data);
-
-	  if (include_inline)
-	    {
-	      struct symbol_and_data_callback cad = { callback, data };
-	      struct block *block;
-	      int i;
-
-	      for (i = FIRST_LOCAL_BLOCK;
-		   i < BLOCKVECTOR_NBLOCKS (BLOCKVECTOR (symtab)); i++)
-		{
-		  block = BLOCKVECTOR_BLOCK (BLOCKVECTOR (symtab), i);
-		  state->language->la_iterate_over_symbols
-		    (block, name, domain, iterate_inline_only, &cad);
-		}
-	    }
-	}
-    }
+      iterate_over_objfile_matching_symtabs (state, objfile, name, domain,
+					     callback, data, include_inline,
+					     &matcher_data);
   }
 }
 
@@ -3026,6 +3193,14 @@ symtabs_from_filename (const char *filename)
   
   result = collect_symtabs_from_filename (filename);
 
+  /* The file may be in a shared library whose symbols have not been
+     read yet.  */
+  if (VEC_empty (symtab_ptr, result) && read_all_deferred_symbols () > 0)
+    {
+      VEC_free (symtab_ptr, result);
+      result = collect_symtabs_from_filename (filename);
+    }
+
   if (VEC_empty (symtab_ptr, result))
     {
       if (!have_full_symbols () && !have_partial_symbols ())
@@ -3084,6 +3259,26 @@ find_function_symbols (struct linespec_state *state,
     *minsyms = info.result.minimal_symbols;
 }
 
+/* Call read_deferred_symbols for the objfile of each minimal symbol
+   in MINSYMS whose symbols were deferred.  Return the number of
+   objfiles read.  */
+
+static int
+read_deferred_minsym_objfiles (VEC (bound_minimal_symbol_d) *minsyms)
+{
+  bound_minimal_symbol_d *item;
+  int ix, count = 0;
+
+  for (ix = 0; VEC_iterate (bound_minimal_symbol_d, minsyms, ix, item); ++ix)
+    if ((item->objfile->flags & OBJF_DEFERRED) != 0)
+      {
+	read_deferred_symbols (item->objfile);
+	count++;
+      }
+
+  return count;
+}
+
 /* Find all symbols named NAME in FILE_SYMTABS, returning debug symbols
    in SYMBOLS and minimal symbols in MINSYMS.  */
 
@@ -3128,6 +3323,21 @@ find_linespec_symbols (struct linespec_state *state,
   find_function_symbols (state, file_symtabs, lookup_name,
 			 symbols, minsyms);
 
+  /* Read the symbols of any shared library whose reading was
+     deferred and which the name resolved to, so that the locations
+     get line and prologue information; or of all of them if the name
+     was not found at all.  Then look again.  */
+  if (read_deferred_minsym_objfiles (*minsyms) > 0
+      || (VEC_empty (symbolp, *symbols)
+	  && VEC_empty (bound_minimal_symbol_d, *minsyms)
+	  && read_all_deferred_symbols () > 0))
+    {
+      VEC_free (symbolp, *symbols);
+      VEC_free (bound_minimal_symbol_d, *minsyms);
+      find_function_symbols (state, file_symtabs, lookup_name,
+			     symbols, minsyms);
+    }
+
   /* If we were unable to locate a symbol of the same name, try dividing
      the name into class and method names and searching the class and its
      baseclasses.  */
@@ -3712,3 +3922,13 @@ make_cleanup_destroy_linespec_result (struct linespec_result *ls)
 {
   return make_cleanup (cleanup_linespec_result, ls);
 }
+
+/* Provide a prototype to silence -Wmissing-prototypes.  */
+extern initialize_file_ftype _initialize_linespec;
+
+void
+_initialize_linespec (void)
+{
+  matching_symbols_key
+    = register_objfile_data_with_cleanup (NULL, matching_symbols_cleanup);
+}
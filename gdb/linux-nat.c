@@ -68,7 +68,16 @@
 #include "linux-ptrace.h"
 #include "buffer.h"
 #include "target-descriptions.h"
+#include "record.h"
+#include "ax.h"
+#include "ax-gdb.h"
 #include "filestuff.h"
+#include "hashtab.h"
+#ifdef HAVE_PROCESS_VM_READV
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#endif
 
 #ifndef SPUFS_MAGIC
 #define SPUFS_MAGIC 0x23c9b64e
@@ -191,6 +200,10 @@ static linux_nat_forget_process_ftype *linux_nat_forget_process_hook;
 /* Hook to call prior to resuming a thread.  */
 static void (*linux_nat_prepare_to_resume) (struct lwp_info *);
 
+/* The method to call, if any, to make a stopped LWP run the mprotect
+   system call.  */
+static linux_nat_inferior_mprotect_ftype *linux_nat_inferior_mprotect;
+
 /* The method to call, if any, when the siginfo object needs to be
    converted between the layout returned by ptrace, and the layout in
    the architecture of the inferior.  */
@@ -275,6 +288,11 @@ static void linux_nat_async (void (*callback)
 static int kill_lwp (int lwpid, int signo);
 
 static int stop_callback (struct lwp_info *lp, void *data);
+static void forget_page_watches (int pid);
+static void detach_tracepoint_traps (int pid, int child_pid);
+static void forget_tracepoints (int pid);
+static void linux_nat_trace_stop (void);
+static void mark_lwp_pending (struct lwp_info *lp);
 
 static void block_child_signals (sigset_t *prev_mask);
 static void restore_child_signals_mask (sigset_t *prev_mask);
@@ -285,6 +303,8 @@ static void purge_lwp_list (int pid);
 static void delete_lwp (ptid_t ptid);
 static struct lwp_info *find_lwp_pid (ptid_t ptid);
 
+static void close_proc_mem_file (void);
+
 
 /* Trivial list manipulation functions to keep track of a list of
    new stopped processes.  */
@@ -594,6 +614,7 @@ holding the child stopped.  Try \"set detach-on-fork\" or \
 		 resuming the inferior.  */
 	      parent_lp->status = 0;
 	      parent_lp->waitstatus.kind = TARGET_WAITKIND_VFORK_DONE;
+	      mark_lwp_pending (parent_lp);
 	      parent_lp->stopped = 1;
 
 	      /* If we're in async mode, need to tell the event loop
@@ -791,6 +812,23 @@ linux_child_set_syscall_catchpoint (int pid, int needed, int any_count,
 
 /* List of known LWPs.  */
 struct lwp_info *lwp_list;
+
+/* The LWPs of LWP_LIST, indexed by LWP id.  If several LWPs share an
+   id, the table holds the newest one, which is the one a walk of
+   LWP_LIST finds first.  */
+static htab_t lwp_lwpid_htab;
+
+/* The number of LWPs in LWP_LIST shadowed in LWP_LWPID_HTAB by a
+   newer LWP with the same id.  */
+static int num_shadowed_lwps;
+
+/* Chain of LWPs that may have a pending status, linked through their
+   PENDING_NEXT fields.  Every place that leaves a status or extended
+   wait status pending in an LWP puts it on the chain, so looking for
+   a pending event doesn't need to walk all of LWP_LIST.  Entries
+   whose status has since been consumed are dropped lazily, by
+   find_pending_lwp.  */
+static struct lwp_info *pending_lwps;
 
 
 /* Original signal mask.  */
@@ -851,6 +889,7 @@ linux_nat_pass_signals (int numsigs, unsigned char *pass_signals)
 
 /* Prototypes for local functions.  */
 static int stop_wait_callback (struct lwp_info *lp, void *data);
+static int status_callback (struct lwp_info *lp, void *data);
 static int linux_thread_alive (ptid_t ptid);
 static char *linux_child_pid_to_exec_file (int pid);
 
@@ -886,10 +925,139 @@ status_to_str (int status)
 static void
 lwp_free (struct lwp_info *lp)
 {
+  if (lp->pending_listed)
+    {
+      struct lwp_info **lpp;
+
+      for (lpp = &pending_lwps; *lpp != lp; lpp = &(*lpp)->pending_next)
+	;
+      *lpp = lp->pending_next;
+    }
+
   xfree (lp->arch_private);
   xfree (lp);
 }
 
+/* Hash function for an entry of LWP_LWPID_HTAB.  */
+
+static hashval_t
+hash_lwp_lwpid (const void *entry)
+{
+  const struct lwp_info *lp = entry;
+
+  return ptid_get_lwp (lp->ptid);
+}
+
+/* Equality function for LWP_LWPID_HTAB.  ENTRY is an LWP, KEY a
+   pointer to an LWP id.  */
+
+static int
+eq_lwp_lwpid (const void *entry, const void *key)
+{
+  const struct lwp_info *lp = entry;
+  const int *lwpid = key;
+
+  return ptid_get_lwp (lp->ptid) == *lwpid;
+}
+
+/* Index LP, just added to the front of LWP_LIST, in
+   LWP_LWPID_HTAB.  */
+
+static void
+lwp_lwpid_htab_insert (struct lwp_info *lp)
+{
+  int lwpid = ptid_get_lwp (lp->ptid);
+  void **slot;
+
+  if (lwp_lwpid_htab == NULL)
+    lwp_lwpid_htab = htab_create_alloc (13, hash_lwp_lwpid, eq_lwp_lwpid,
+					NULL, xcalloc, xfree);
+
+  slot = htab_find_slot_with_hash (lwp_lwpid_htab, &lwpid, lwpid, INSERT);
+  if (*slot != NULL)
+    num_shadowed_lwps++;
+  *slot = lp;
+}
+
+/* Remove LP, already unlinked from LWP_LIST, from LWP_LWPID_HTAB.  If
+   LP shadowed an older LWP with the same id, index that one
+   instead.  */
+
+static void
+lwp_lwpid_htab_remove (struct lwp_info *lp)
+{
+  int lwpid = ptid_get_lwp (lp->ptid);
+  struct lwp_info *other;
+  void **slot;
+
+  slot = htab_find_slot_with_hash (lwp_lwpid_htab, &lwpid, lwpid,
+				   NO_INSERT);
+  if (slot == NULL || *slot != lp)
+    {
+      /* LP itself was shadowed.  */
+      num_shadowed_lwps--;
+      return;
+    }
+
+  if (num_shadowed_lwps > 0)
+    for (other = lwp_list; other != NULL; other = other->next)
+      if (ptid_get_lwp (other->ptid) == lwpid)
+	{
+	  num_shadowed_lwps--;
+	  *slot = other;
+	  return;
+	}
+
+  htab_clear_slot (lwp_lwpid_htab, slot);
+}
+
+/* Put LP on the chain of LWPs that may have a pending status, if it
+   isn't there already.  */
+
+static void
+mark_lwp_pending (struct lwp_info *lp)
+{
+  if (!lp->pending_listed)
+    {
+      lp->pending_listed = 1;
+      lp->pending_next = pending_lwps;
+      pending_lwps = lp;
+    }
+}
+
+/* Return an LWP matching FILTER that has been resumed and has a
+   pending status, or NULL.  This is equivalent to
+
+     iterate_over_lwps (filter, status_callback, NULL)
+
+   but only looks at the LWPs on the pending chain.  LWPs found there
+   without a pending status are taken off the chain.  */
+
+static struct lwp_info *
+find_pending_lwp (ptid_t filter)
+{
+  struct lwp_info **lpp = &pending_lwps;
+
+  while (*lpp != NULL)
+    {
+      struct lwp_info *lp = *lpp;
+
+      if (lp->status == 0 && lp->waitstatus.kind == TARGET_WAITKIND_IGNORE)
+	{
+	  lp->pending_listed = 0;
+	  *lpp = lp->pending_next;
+	  continue;
+	}
+
+      if (ptid_match (lp->ptid, filter) && status_callback (lp, NULL))
+	return lp;
+
+      lpp = &lp->pending_next;
+    }
+
+  return NULL;
+}
+
 /* Remove all LWPs belong to PID from the lwp list.  */
 
 static void
@@ -910,6 +1078,7 @@ purge_lwp_list (int pid)
 	  else
 	    lpprev->next = lp->next;
 
+	  lwp_lwpid_htab_remove (lp);
 	  lwp_free (lp);
 	}
       else
@@ -950,6 +1119,7 @@ add_initial_lwp (ptid_t ptid)
 
   lp->next = lwp_list;
   lwp_list = lp;
+  lwp_lwpid_htab_insert (lp);
 
   return lp;
 }
@@ -982,20 +1152,21 @@ delete_lwp (ptid_t ptid)
 {
   struct lwp_info *lp, *lpprev;
 
-  lpprev = NULL;
-
-  for (lp = lwp_list; lp; lpprev = lp, lp = lp->next)
-    if (ptid_equal (lp->ptid, ptid))
-      break;
-
-  if (!lp)
+  lp = find_lwp_pid (ptid);
+  if (lp == NULL || !ptid_equal (lp->ptid, ptid))
     return;
 
+  lpprev = NULL;
+  if (lwp_list != lp)
+    for (lpprev = lwp_list; lpprev->next != lp; lpprev = lpprev->next)
+      ;
+
   if (lpprev)
     lpprev->next = lp->next;
   else
     lwp_list = lp->next;
 
+  lwp_lwpid_htab_remove (lp);
   lwp_free (lp);
 }
 
@@ -1005,19 +1176,17 @@ delete_lwp (ptid_t ptid)
 static struct lwp_info *
 find_lwp_pid (ptid_t ptid)
 {
-  struct lwp_info *lp;
   int lwp;
 
+  if (lwp_lwpid_htab == NULL)
+    return NULL;
+
   if (ptid_lwp_p (ptid))
     lwp = ptid_get_lwp (ptid);
   else
     lwp = ptid_get_pid (ptid);
 
-  for (lp = lwp_list; lp; lp = lp->next)
-    if (lwp == ptid_get_lwp (lp->ptid))
-      return lp;
-
-  return NULL;
+  return htab_find_with_hash (lwp_lwpid_htab, &lwp, lwp);
 }
 
 /* Call CALLBACK with its second argument set to DATA for every LWP in
@@ -1252,6 +1421,7 @@ lin_lwp_attach_lwp (ptid_t ptid)
 	{
 	  lp->resumed = 1;
 	  lp->status = status;
+	  mark_lwp_pending (lp);
 	}
 
       target_post_attach (ptid_get_lwp (lp->ptid));
@@ -1416,6 +1586,7 @@ linux_nat_attach (struct target_ops *ops, char *args, int from_tty)
 			(long) ptid_get_pid (lp->ptid), status_to_str (status));
 
   lp->status = status;
+  mark_lwp_pending (lp);
 
   if (target_can_async_p ())
     target_async (inferior_event_handler, 0);
@@ -1565,6 +1736,8 @@ linux_nat_detach (struct target_ops *ops, char *args, int from_tty)
 
   pid = ptid_get_pid (inferior_ptid);
 
+  close_proc_mem_file ();
+
   /* Don't unregister from the event loop, as there may be other
      inferiors running. */
 
@@ -1575,6 +1748,11 @@ linux_nat_detach (struct target_ops *ops, char *args, int from_tty)
      they're no longer running.  */
   iterate_over_lwps (pid_to_ptid (pid), stop_wait_callback, NULL);
 
+  /* The process would not survive hitting a tracepoint trap once we
+     are gone.  */
+  linux_nat_trace_stop ();
+  forget_tracepoints (pid);
+
   iterate_over_lwps (pid_to_ptid (pid), detach_callback, NULL);
 
   /* Only the initial process should be left right now.  */
@@ -1743,6 +1921,20 @@ linux_nat_resume (struct target_ops *ops,
   lp->step = step;
   lp->last_resume_kind = step ? resume_step : resume_continue;
 
+  /* If the core lets us, step the whole range ourselves; see
+     linux_nat_range_step.  Record targets need to see every step.  */
+  lp->step_range_start = lp->step_range_end = 0;
+  if (step && signo == GDB_SIGNAL_0 && use_range_stepping && !RECORD_IS_USED)
+    {
+      struct thread_info *tp = find_thread_ptid (lp->ptid);
+
+      if (tp != NULL && tp->control.may_range_step)
+	{
+	  lp->step_range_start = tp->control.step_range_start;
+	  lp->step_range_end = tp->control.step_range_end;
+	}
+    }
+
   /* If we have a pending wait status for this thread, there is no
      point in resuming the process.  But first make sure that
      linux_nat_wait won't preemptively handle the event - we
@@ -1858,6 +2050,9 @@ linux_handle_syscall_trap (struct lwp_info *lp, int stopping)
   struct gdbarch *gdbarch = target_thread_architecture (lp->ptid);
   int syscall_number = (int) gdbarch_get_syscall_number (gdbarch, lp->ptid);
 
+  /* We may leave the syscall event pending in LP->waitstatus.  */
+  mark_lwp_pending (lp);
+
   if (stopping)
     {
       /* If we're stopping threads, there's a SIGSTOP pending, which
@@ -1990,6 +2185,9 @@ linux_handle_extended_wait (struct lwp_info *lp, int status,
   struct target_waitstatus *ourstatus = &lp->waitstatus;
   int event = status >> 16;
 
+  /* We may leave the event pending in LP->waitstatus.  */
+  mark_lwp_pending (lp);
+
   if (event == PTRACE_EVENT_FORK || event == PTRACE_EVENT_VFORK
       || event == PTRACE_EVENT_CLONE)
     {
@@ -2026,6 +2224,12 @@ linux_handle_extended_wait (struct lwp_info *lp, int status,
 	    linux_nat_new_fork (lp, new_pid);
 	}
 
+      /* A forked child has copies of the tracepoint traps, but we only
+	 collect trace frames in the parent.  A vforked child shares
+	 them with the parent.  */
+      if (event == PTRACE_EVENT_FORK)
+	detach_tracepoint_traps (ptid_get_pid (lp->ptid), new_pid);
+
       if (event == PTRACE_EVENT_FORK
 	  && linux_fork_checkpointing_p (ptid_get_pid (lp->ptid)))
 	{
@@ -2150,6 +2354,7 @@ linux_handle_extended_wait (struct lwp_info *lp, int status,
 				    (long) ptid_get_lwp (new_lp->ptid),
 				    status_to_str (status));
 	      new_lp->status = status;
+	      mark_lwp_pending (new_lp);
 	    }
 
 	  /* Note the need to use the low target ops to resume, to
@@ -2196,6 +2401,18 @@ linux_handle_extended_wait (struct lwp_info *lp, int status,
 			    "LHEW: Got exec event from LWP %ld\n",
 			    ptid_get_lwp (lp->ptid));
 
+      /* The pages we protected, and the tracepoint traps, are gone
+	 with the old image.  */
+      forget_page_watches (ptid_get_pid (lp->ptid));
+      forget_tracepoints (ptid_get_pid (lp->ptid));
+
+      /* The kernel clears the debug registers on exec; to the arch
+	 code, this is a new thread.  */
+      xfree (lp->arch_private);
+      lp->arch_private = NULL;
+      if (linux_nat_new_thread != NULL)
+	linux_nat_new_thread (lp);
+
       ourstatus->kind = TARGET_WAITKIND_EXECD;
       ourstatus->value.execd_pathname
 	= xstrdup (linux_child_pid_to_exec_file (pid));
@@ -2563,7 +2780,17 @@ linux_nat_set_status_is_event (struct target_ops *t,
   linux_nat_status_is_event = status_is_event;
 }
 
-/* Wait until LP is stopped.  */
+/* Wait until LP is stopped.
+
+   This waits for each LWP in turn with waitpid on that LWP, rather
+   than collecting the stops in whatever order they come with
+   waitpid (-1).  The kernel finds a specific child directly, but for
+   waitpid (-1) walks the whole list of traced children on every call,
+   which makes collecting the stops of N LWPs quadratic.  Since an LWP
+   that has already stopped just waits for us here, waiting for the
+   LWPs in list order costs nothing extra.  (When stopping thousands
+   of LWPs, most of the time goes to the kernel sending the SIGSTOPs
+   in stop_callback: each one scans every thread in the group.)  */
 
 static int
 stop_wait_callback (struct lwp_info *lp, void *data)
@@ -2616,6 +2843,7 @@ stop_wait_callback (struct lwp_info *lp, void *data)
 
 	  /* Save the sigtrap event.  */
 	  lp->status = status;
+	  mark_lwp_pending (lp);
 	  gdb_assert (!lp->stopped);
 	  gdb_assert (lp->signalled);
 	  lp->stopped = 1;
@@ -2795,6 +3023,7 @@ select_event_lwp (ptid_t filter, struct lwp_info **orig_lp, int *status)
 
   /* Record the wait status for the original LWP.  */
   (*orig_lp)->status = *status;
+  mark_lwp_pending (*orig_lp);
 
   /* Give preference to any LWP that is being single-stepped.  */
   event_lp = iterate_over_lwps (filter,
@@ -2879,6 +3108,7 @@ stop_and_resume_callback (struct lwp_info *lp, void *data)
 				    "(leaving SIGSTOP pending)\n",
 				    ptid_get_lwp (lp->ptid));
 	      lp->status = W_STOPCODE (SIGSTOP);
+	      mark_lwp_pending (lp);
 	    }
 
 	  if (lp->status == 0)
@@ -3116,6 +3346,7 @@ linux_nat_filter_event (int lwpid, int status, int *new_pending_p)
   /* An interesting event.  */
   gdb_assert (lp);
   lp->status = status;
+  mark_lwp_pending (lp);
   return lp;
 }
 
@@ -3184,147 +3415,2355 @@ check_zombie_leaders (void)
     }
 }
 
-static ptid_t
-linux_nat_wait_1 (struct target_ops *ops,
-		  ptid_t ptid, struct target_waitstatus *ourstatus,
-		  int target_options)
+/* Breakpoints inserted with target-side conditions.  GDB hands us the
+   conditions as agent expressions when it inserts a breakpoint while
+   "set breakpoint condition-evaluation" allows the target to evaluate
+   them.  When a thread traps at one of these breakpoints in all-stop
+   mode, and all of the conditions evaluate to false, we step the
+   thread over the breakpoint and resume it ourselves, instead of
+   stopping every thread and reporting an event to the core only to
+   have it resume the inferior again.  */
+
+struct lwp_cond_breakpoint
 {
-  static sigset_t prev_mask;
-  enum resume_kind last_resume_kind;
-  struct lwp_info *lp;
-  int status;
+  /* The process the breakpoint is inserted into.  */
+  int pid;
 
-  if (debug_linux_nat)
-    fprintf_unfiltered (gdb_stdlog, "LLW: enter\n");
+  /* The breakpoint's address and size, as placed.  */
+  CORE_ADDR placed_address;
+  int placed_size;
 
-  /* The first time we get here after starting a new inferior, we may
-     not have added it to the LWP list yet - this is the earliest
-     moment at which we know its PID.  */
-  if (ptid_is_pid (inferior_ptid))
-    {
-      /* Upgrade the main thread's ptid.  */
-      thread_change_ptid (inferior_ptid,
-			  ptid_build (ptid_get_pid (inferior_ptid),
-				      ptid_get_pid (inferior_ptid), 0));
+  /* The conditions, copied from the bp_target_info.  The breakpoint
+     location owns the originals, and may free them while the
+     breakpoint stays inserted.  */
+  VEC(agent_expr_p) *conditions;
 
-      lp = add_initial_lwp (inferior_ptid);
-      lp->resumed = 1;
-    }
+  /* Next in the list.  */
+  struct lwp_cond_breakpoint *next;
+};
 
-  /* Make sure SIGCHLD is blocked until the sigsuspend below.  */
-  block_child_signals (&prev_mask);
+static struct lwp_cond_breakpoint *lwp_cond_breakpoints;
 
-retry:
-  lp = NULL;
-  status = 0;
+/* Remove, and free, the conditional breakpoint of process PID at
+   ADDR.  If ADDR is -1, remove all of PID's conditional
+   breakpoints.  */
 
-  /* First check if there is a LWP with a wait status pending.  */
-  if (ptid_equal (ptid, minus_one_ptid) || ptid_is_pid (ptid))
+static void
+forget_cond_breakpoints (int pid, CORE_ADDR addr)
+{
+  struct lwp_cond_breakpoint **bpp = &lwp_cond_breakpoints;
+
+  while (*bpp != NULL)
     {
-      /* Any LWP in the PTID group that's been resumed will do.  */
-      lp = iterate_over_lwps (ptid, status_callback, NULL);
-      if (lp)
+      struct lwp_cond_breakpoint *bp = *bpp;
+
+      if (bp->pid == pid
+	  && (addr == (CORE_ADDR) -1 || bp->placed_address == addr))
 	{
-	  if (debug_linux_nat && lp->status)
-	    fprintf_unfiltered (gdb_stdlog,
-				"LLW: Using pending wait status %s for %s.\n",
-				status_to_str (lp->status),
-				target_pid_to_str (lp->ptid));
+	  struct agent_expr *aexpr;
+	  int ix;
+
+	  *bpp = bp->next;
+	  for (ix = 0; VEC_iterate (agent_expr_p, bp->conditions, ix, aexpr);
+	       ix++)
+	    free_agent_expr (aexpr);
+	  VEC_free (agent_expr_p, bp->conditions);
+	  xfree (bp);
 	}
+      else
+	bpp = &bp->next;
     }
-  else if (ptid_lwp_p (ptid))
-    {
-      if (debug_linux_nat)
-	fprintf_unfiltered (gdb_stdlog,
-			    "LLW: Waiting for specific LWP %s.\n",
-			    target_pid_to_str (ptid));
+}
 
-      /* We have a specific LWP to check.  */
-      lp = find_lwp_pid (ptid);
-      gdb_assert (lp);
+/* Return the conditional breakpoint of process PID at ADDR, or NULL
+   if there is none.  */
 
-      if (debug_linux_nat && lp->status)
-	fprintf_unfiltered (gdb_stdlog,
-			    "LLW: Using pending wait status %s for %s.\n",
-			    status_to_str (lp->status),
-			    target_pid_to_str (lp->ptid));
+static struct lwp_cond_breakpoint *
+find_cond_breakpoint (int pid, CORE_ADDR addr)
+{
+  struct lwp_cond_breakpoint *bp;
 
-      /* We check for lp->waitstatus in addition to lp->status,
-	 because we can have pending process exits recorded in
-	 lp->status and W_EXITCODE(0,0) == 0.  We should probably have
-	 an additional lp->status_p flag.  */
-      if (lp->status == 0 && lp->waitstatus.kind == TARGET_WAITKIND_IGNORE)
-	lp = NULL;
-    }
+  for (bp = lwp_cond_breakpoints; bp != NULL; bp = bp->next)
+    if (bp->pid == pid && bp->placed_address == addr)
+      return bp;
 
-  if (!target_can_async_p ())
+  return NULL;
+}
+
+static int
+linux_nat_insert_breakpoint (struct gdbarch *gdbarch,
+			     struct bp_target_info *bp_tgt)
+{
+  int pid = ptid_get_pid (inferior_ptid);
+  int ret;
+
+  /* GDB re-inserts an already inserted breakpoint when only its
+     conditions changed; always start from a clean slate.  */
+  forget_cond_breakpoints (pid, bp_tgt->placed_address);
+
+  ret = linux_ops->to_insert_breakpoint (gdbarch, bp_tgt);
+
+  if (ret == 0 && !VEC_empty (agent_expr_p, bp_tgt->conditions))
     {
-      /* Causes SIGINT to be passed on to the attached process.  */
-      set_sigint_trap ();
+      struct lwp_cond_breakpoint *bp = XCNEW (struct lwp_cond_breakpoint);
+      struct agent_expr *aexpr;
+      int ix;
+
+      bp->pid = pid;
+      bp->placed_address = bp_tgt->placed_address;
+      bp->placed_size = bp_tgt->placed_size;
+      for (ix = 0; VEC_iterate (agent_expr_p, bp_tgt->conditions, ix, aexpr);
+	   ix++)
+	VEC_safe_push (agent_expr_p, bp->conditions, copy_agent_expr (aexpr));
+
+      bp->next = lwp_cond_breakpoints;
+      lwp_cond_breakpoints = bp;
     }
 
-  /* But if we don't find a pending event, we'll have to wait.  */
+  /* Like remote targets, we consume the condition list.  */
+  VEC_free (agent_expr_p, bp_tgt->conditions);
 
-  while (lp == NULL)
-    {
-      pid_t lwpid;
+  return ret;
+}
 
-      /* Always use -1 and WNOHANG, due to couple of a kernel/ptrace
-	 quirks:
+static int
+linux_nat_remove_breakpoint (struct gdbarch *gdbarch,
+			     struct bp_target_info *bp_tgt)
+{
+  forget_cond_breakpoints (ptid_get_pid (inferior_ptid),
+			   bp_tgt->placed_address);
 
-	 - If the thread group leader exits while other threads in the
-	   thread group still exist, waitpid(TGID, ...) hangs.  That
-	   waitpid won't return an exit status until the other threads
-	   in the group are reapped.
+  return linux_ops->to_remove_breakpoint (gdbarch, bp_tgt);
+}
 
-	 - When a non-leader thread execs, that thread just vanishes
-	   without reporting an exit (so we'd hang if we waited for it
-	   explicitly in that case).  The exec event is reported to
-	   the TGID pid.  */
+static int
+linux_nat_supports_evaluation_of_breakpoint_conditions (void)
+{
+  return 1;
+}
 
-      errno = 0;
-      lwpid = my_waitpid (-1, &status,  __WCLONE | WNOHANG);
-      if (lwpid == 0 || (lwpid == -1 && errno == ECHILD))
-	lwpid = my_waitpid (-1, &status, WNOHANG);
+/* LP has just reported STATUS.  If that is the end of a single-step
+   within the range the core asked us to step, and not at a
+   breakpoint, step LP again and return 1; the caller should then go
+   back to waiting.  Otherwise, return 0.  This saves a trip through
+   the core, and stopping all threads, for every instruction of a
+   source line being stepped.  */
 
-      if (debug_linux_nat)
-	fprintf_unfiltered (gdb_stdlog,
-			    "LNW: waitpid(-1, ...) returned %d, %s\n",
-			    lwpid, errno ? safe_strerror (errno) : "ERRNO-OK");
+static int
+linux_nat_range_step (struct lwp_info *lp, int status)
+{
+  struct cleanup *old_chain;
+  struct regcache *regcache;
+  struct gdbarch *gdbarch;
+  struct address_space *aspace;
+  CORE_ADDR pc;
+  int decr_pc;
 
-      if (lwpid > 0)
+  if (!lp->step
+      || lp->step_range_start == lp->step_range_end
+      || !linux_nat_status_is_event (status)
+      || lp->waitstatus.kind != TARGET_WAITKIND_IGNORE
+      || lp->stopped_by_watchpoint)
+    return 0;
+
+  old_chain = save_inferior_ptid ();
+  inferior_ptid = lp->ptid;
+
+  regcache = get_thread_regcache (lp->ptid);
+  gdbarch = get_regcache_arch (regcache);
+  aspace = get_regcache_aspace (regcache);
+  pc = regcache_read_pc (regcache);
+  decr_pc = gdbarch_decr_pc_after_break (gdbarch);
+
+  /* Compilers often split a line into several adjacent line table
+     entries, which the core would step through one range at a time.
+     If LP left the range into another entry for the same line of the
+     same function, take that entry as the new range, just as the core
+     would.  */
+  if (pc < lp->step_range_start || pc >= lp->step_range_end)
+    {
+      struct symtab_and_line range_sal, sal;
+      CORE_ADDR range_func, func;
+
+      range_sal = find_pc_line (lp->step_range_start, 0);
+      sal = find_pc_line (pc, 0);
+      if (sal.line != 0
+	  && sal.line == range_sal.line
+	  && sal.symtab == range_sal.symtab
+	  && sal.end > pc
+	  && find_pc_partial_function (lp->step_range_start, NULL,
+				       &range_func, NULL)
+	  && find_pc_partial_function (pc, NULL, &func, NULL)
+	  && func == range_func
+	  && pc != func)
 	{
-	  /* If this is true, then we paused LWPs momentarily, and may
-	     now have pending events to handle.  */
-	  int new_pending;
+	  lp->step_range_start = sal.pc;
+	  lp->step_range_end = sal.end;
+	}
+    }
 
-	  if (debug_linux_nat)
-	    {
-	      fprintf_unfiltered (gdb_stdlog,
-				  "LLW: waitpid %ld received %s\n",
-				  (long) lwpid, status_to_str (status));
-	    }
+  /* Report steps that leave the range, and traps that may be
+     breakpoint hits.  */
+  if (pc < lp->step_range_start
+      || pc >= lp->step_range_end
+      || breakpoint_inserted_here_p (aspace, pc)
+      || (decr_pc != 0 && breakpoint_inserted_here_p (aspace, pc - decr_pc)))
+    {
+      do_cleanups (old_chain);
+      return 0;
+    }
 
-	  lp = linux_nat_filter_event (lwpid, status, &new_pending);
+  do_cleanups (old_chain);
 
-	  /* STATUS is now no longer valid, use LP->STATUS instead.  */
-	  status = 0;
+  if (debug_linux_nat)
+    fprintf_unfiltered (gdb_stdlog,
+			"LLW: %s: range stepping at %s [%s, %s)\n",
+			target_pid_to_str (lp->ptid), paddress (gdbarch, pc),
+			paddress (gdbarch, lp->step_range_start),
+			paddress (gdbarch, lp->step_range_end));
 
-	  if (lp && !ptid_match (lp->ptid, ptid))
-	    {
-	      gdb_assert (lp->resumed);
+  registers_changed ();
+  if (linux_nat_prepare_to_resume != NULL)
+    linux_nat_prepare_to_resume (lp);
+  linux_ops->to_resume (linux_ops, pid_to_ptid (ptid_get_lwp (lp->ptid)),
+			1, GDB_SIGNAL_0);
+  lp->stopped = 0;
+  return 1;
+}
 
-	      if (debug_linux_nat)
-		fprintf (stderr,
-			 "LWP %ld got an event %06x, leaving pending.\n",
-			 ptid_get_lwp (lp->ptid), lp->status);
+/* Callback for iterate_over_lwps.  Let LP run again after
+   linux_nat_skip_false_condition stopped it, unless it has an event
+   to report.  This includes LWPs we discovered while stopping, which
+   the core would otherwise have resumed along with the rest.  */
 
-	      if (WIFSTOPPED (lp->status))
-		{
-		  if (WSTOPSIG (lp->status) != SIGSTOP)
-		    {
-		      /* Cancel breakpoint hits.  The breakpoint may
-			 be removed before we fetch events from this
+static int
+resume_after_skip_callback (struct lwp_info *lp, void *data)
+{
+  if (lp->last_resume_kind != resume_stop)
+    {
+      lp->resumed = 1;
+      resume_lwp (lp, lp->step, GDB_SIGNAL_0);
+    }
+  return 0;
+}
+
+/* See linux-nat.h.  */
+
+int
+linux_nat_step_lwp (struct lwp_info *lp)
+{
+  int lwpid = ptid_get_lwp (lp->ptid);
+  int status, signo = 0;
+
+  if (linux_nat_prepare_to_resume != NULL)
+    linux_nat_prepare_to_resume (lp);
+
+  for (;;)
+    {
+      if (ptrace (PTRACE_SINGLESTEP, lwpid, 0, 0) != 0
+	  || my_waitpid (lwpid, &status, __WALL) != lwpid)
+	return 0;
+
+      if (!WIFSTOPPED (status)
+	  || (WSTOPSIG (status) == SIGTRAP && status >> 16 == 0))
+	break;
+
+      /* A signal arrived before the instruction ran.  Swallow a
+	 SIGSTOP we sent earlier; send any other signal again once the
+	 step is done, so that it is reported as usual.  */
+      if (WSTOPSIG (status) == SIGSTOP && lp->signalled)
+	lp->signalled = 0;
+      else if (WSTOPSIG (status) != SIGTRAP)
+	signo = WSTOPSIG (status);
+      else
+	break;
+    }
+
+  if (signo != 0 && WIFSTOPPED (status))
+    kill_lwp (lwpid, signo);
+
+  return status;
+}
+
+static int linux_nat_xfer_raw_memory (gdb_byte *readbuf,
+				      const gdb_byte *writebuf,
+				      CORE_ADDR addr, int len);
+
+/* Step LP, stopped at a software breakpoint instruction at PC, over
+   the instruction the breakpoint replaces, with the breakpoint lifted
+   meanwhile.  Other threads must be stopped.  Return the status the
+   step ended with, 0 if LP could not be waited for, or -1 if the
+   breakpoint could not be lifted.  */
+
+static int
+linux_nat_step_over_trap (struct lwp_info *lp, struct gdbarch *gdbarch,
+			  CORE_ADDR pc)
+{
+  struct regcache *regcache = get_thread_regcache (lp->ptid);
+  gdb_byte orig[BREAKPOINT_MAX], trap[BREAKPOINT_MAX];
+  CORE_ADDR bp_addr = pc;
+  int len, lwpid, status;
+
+  /* Read the original contents through the breakpoint shadows, which
+     the core and the tracepoints keep up to date, and what is there
+     now, which may be a trap of either; then lift it while we
+     step.  */
+  if (gdbarch_breakpoint_from_pc (gdbarch, &bp_addr, &len) == NULL
+      || bp_addr != pc || len > BREAKPOINT_MAX
+      || target_read_memory (pc, orig, len) != 0
+      || linux_nat_xfer_raw_memory (trap, NULL, pc, len) != 0
+      || linux_nat_xfer_raw_memory (NULL, orig, pc, len) != 0)
+    return -1;
+
+  if (gdbarch_decr_pc_after_break (gdbarch) != 0)
+    regcache_write_pc (regcache, pc);
+
+  registers_changed ();
+  if (linux_nat_prepare_to_resume != NULL)
+    linux_nat_prepare_to_resume (lp);
+  lwpid = ptid_get_lwp (lp->ptid);
+  for (;;)
+    {
+      linux_ops->to_resume (linux_ops, pid_to_ptid (lwpid), 1, GDB_SIGNAL_0);
+      lp->stopped = 0;
+
+      if (my_waitpid (lwpid, &status, lp->cloned ? __WCLONE : 0) != lwpid)
+	status = 0;
+
+      /* A SIGSTOP we sent earlier may be reported before the step
+	 completes.  Swallow it, and step again; otherwise the thread
+	 would go back to the breakpoint and trap again.  */
+      if (lp->signalled && WIFSTOPPED (status) && WSTOPSIG (status) == SIGSTOP)
+	{
+	  lp->signalled = 0;
+	  continue;
+	}
+      break;
+    }
+
+  /* Put the breakpoint back.  If the thread is gone, write through
+     the process instead.  */
+  if (!WIFSTOPPED (status))
+    inferior_ptid = pid_to_ptid (ptid_get_pid (lp->ptid));
+  linux_nat_xfer_raw_memory (NULL, trap, pc, len);
+
+  lp->tracepoint_collected_at = 0;
+  return status;
+}
+
+/* Deal with STATUS, which LP reported after linux_nat_step_over_trap
+   stepped it; the caller is then going to resume LP along with the
+   other threads.  */
+
+static void
+linux_nat_finish_step_over (struct lwp_info *lp, int status)
+{
+  int new_pending;
+
+  if (status == 0)
+    ;
+  else if (WIFSTOPPED (status) && WSTOPSIG (status) == SIGTRAP
+	   && status >> 16 == 0)
+    {
+      lp->stopped = 1;
+      save_sigtrap (lp);
+      if (lp->stopped_by_watchpoint)
+	{
+	  lp->status = status;
+	  mark_lwp_pending (lp);
+	}
+      registers_changed ();
+    }
+  else
+    {
+      /* Something else happened while stepping; let the usual event
+	 processing handle it, leaving any event pending.  */
+      linux_nat_filter_event (ptid_get_lwp (lp->ptid), status, &new_pending);
+    }
+}
+
+/* LP has just reported STATUS.  If that is a trap at a breakpoint
+   whose target-side conditions all evaluate to false, step LP over the
+   breakpoint and let it continue, and return 1; the caller should then
+   go back to waiting.  Otherwise, return 0, and leave LP alone.  */
+
+static int
+linux_nat_skip_false_condition (struct lwp_info *lp, int status)
+{
+  struct cleanup *old_chain;
+  struct regcache *regcache;
+  struct gdbarch *gdbarch;
+  struct lwp_cond_breakpoint *bp;
+  struct agent_expr *aexpr;
+  CORE_ADDR pc;
+  int ix;
+
+  if (lwp_cond_breakpoints == NULL
+      || non_stop
+      || lp->step
+      || !linux_nat_status_is_event (status)
+      || lp->waitstatus.kind != TARGET_WAITKIND_IGNORE
+      || lp->stopped_by_watchpoint)
+    return 0;
+
+  old_chain = save_inferior_ptid ();
+  inferior_ptid = lp->ptid;
+
+  regcache = get_thread_regcache (lp->ptid);
+  gdbarch = get_regcache_arch (regcache);
+  pc = regcache_read_pc (regcache) - gdbarch_decr_pc_after_break (gdbarch);
+
+  bp = find_cond_breakpoint (ptid_get_pid (lp->ptid), pc);
+  if (bp == NULL
+      || !breakpoint_inserted_here_p (get_regcache_aspace (regcache), pc))
+    {
+      do_cleanups (old_chain);
+      return 0;
+    }
+
+  /* Any condition that is true, or that we fail to evaluate, means
+     the core must see this event.  It evaluates the conditions again
+     anyway.  */
+  for (ix = 0; VEC_iterate (agent_expr_p, bp->conditions, ix, aexpr); ix++)
+    {
+      ULONGEST value;
+
+      if (eval_agent_expr (aexpr, regcache, &value) != 0 || value != 0)
+	{
+	  do_cleanups (old_chain);
+	  return 0;
+	}
+    }
+
+  if (debug_linux_nat)
+    fprintf_unfiltered (gdb_stdlog,
+			"LLW: %s: condition false at %s, stepping over\n",
+			target_pid_to_str (lp->ptid), paddress (gdbarch, pc));
+
+  /* The breakpoint must stay in place for every other thread, so stop
+     them while LP steps over it.  */
+  lp->stopped = 1;
+  iterate_over_lwps (minus_one_ptid, stop_callback, NULL);
+  iterate_over_lwps (minus_one_ptid, stop_wait_callback, NULL);
+
+  /* If we can't step over the breakpoint, report the event; the core
+     will step over it in the usual way.  */
+  status = linux_nat_step_over_trap (lp, gdbarch, pc);
+  do_cleanups (old_chain);
+  if (status == -1)
+    return 0;
+
+  linux_nat_finish_step_over (lp, status);
+
+  /* Let LP, and the threads we stopped above, continue, unless they
+     have events of their own to report.  */
+  iterate_over_lwps (minus_one_ptid, resume_after_skip_callback, NULL);
+  return 1;
+}
+
+/* Tracepoints collected by the native target.  While a trace run is
+   going, each tracepoint location has a software breakpoint trap of
+   our own, kept out of sight of the core: reads of the inferior's
+   memory show the original contents, and writes to it go beneath the
+   trap.  When a thread hits one of these traps, linux_nat_wait_1
+   collects a trace frame for each tracepoint there, evaluating the
+   tracepoint's condition and collection actions as agent expressions,
+   then steps the thread over the trap and lets it continue, without
+   reporting an event to the core.  The trace frames are kept in
+   memory, in the layout of a trace file (see tfile_open), so that
+   "tsave" can write them out as they are.  This is done in all-stop
+   mode only.  */
+
+/* The default size of the trace buffer.  */
+#define LWP_TRACE_BUFFER_SIZE_DEFAULT (5 * 1024 * 1024)
+
+/* A tracepoint location downloaded to the native target.  */
+
+struct lwp_tracepoint
+{
+  /* The process the tracepoint is in.  */
+  int pid;
+
+  /* The tracepoint's number, and address.  */
+  int number;
+  CORE_ADDR address;
+
+  /* Nonzero if the tracepoint is enabled.  */
+  int enabled;
+
+  /* Stop the trace run after this many hits, if not zero.  */
+  ULONGEST pass_count;
+
+  /* The number of hits, and of bytes of trace frames collected, in
+     this trace run.  */
+  ULONGEST hit_count;
+  ULONGEST traceframe_usage;
+
+  /* The condition, or NULL if there is none.  */
+  struct agent_expr *cond;
+
+  /* What to collect: all registers, if COLLECT_REGS is nonzero, the
+     NUM_RANGES memory ranges in RANGES, and the memory the agent
+     expressions in EXPRS collect.  */
+  int collect_regs;
+  int num_ranges;
+  struct memrange *ranges;
+  VEC(agent_expr_p) *exprs;
+
+  /* The trap, if INSERTED is nonzero.  SHADOW holds the memory
+     contents it replaces.  */
+  int inserted;
+  int trap_len;
+  gdb_byte shadow[BREAKPOINT_MAX];
+
+  /* Next in the list.  */
+  struct lwp_tracepoint *next;
+};
+
+static struct lwp_tracepoint *lwp_tracepoints;
+
+/* Nonzero while a trace run is going.  */
+static int lwp_tracing;
+
+/* Why, and when, the last trace run stopped.  */
+static enum trace_stop_reason lwp_trace_stop_reason = trace_never_run;
+static int lwp_trace_stopping_tracepoint;
+static char *lwp_trace_stop_desc;
+static LONGEST lwp_trace_start_time;
+static LONGEST lwp_trace_stop_time;
+
+/* The trace frames of the last trace run.  LWP_TRACE_BUFFER_LEN bytes
+   of LWP_TRACE_BUFFER are in use, and at most LWP_TRACE_BUFFER_MAX
+   bytes may be.  */
+static gdb_byte *lwp_trace_buffer;
+static size_t lwp_trace_buffer_len;
+static size_t lwp_trace_buffer_alloc;
+static size_t lwp_trace_buffer_max = LWP_TRACE_BUFFER_SIZE_DEFAULT;
+
+/* The offsets of the trace frames in LWP_TRACE_BUFFER, by number.  */
+typedef size_t lwp_traceframe_offset;
+DEF_VEC_I (lwp_traceframe_offset);
+static VEC (lwp_traceframe_offset) *lwp_traceframes;
+
+/* The number of trace frames created in the last trace run.  */
+static int lwp_traceframes_created;
+
+/* Return the current time, in microseconds, for the trace status.  */
+
+static LONGEST
+lwp_trace_current_time (void)
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return (LONGEST) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* Transfer LEN bytes of the current inferior's memory at ADDR, to
+   READBUF or from WRITEBUF, without going through our view of the
+   memory, which hides the tracepoint traps.  Return zero on
+   success.  */
+
+static int
+linux_nat_xfer_raw_memory (gdb_byte *readbuf, const gdb_byte *writebuf,
+			   CORE_ADDR addr, int len)
+{
+  struct cleanup *old_chain = save_inferior_ptid ();
+  int done = 0;
+
+  if (ptid_lwp_p (inferior_ptid))
+    inferior_ptid = pid_to_ptid (ptid_get_lwp (inferior_ptid));
+
+  while (done < len)
+    {
+      LONGEST xfered
+	= linux_ops->to_xfer_partial (linux_ops, TARGET_OBJECT_MEMORY, NULL,
+				      readbuf != NULL ? readbuf + done : NULL,
+				      writebuf != NULL ? writebuf + done : NULL,
+				      addr + done, len - done);
+
+      if (xfered <= 0)
+	break;
+      done += xfered;
+    }
+
+  do_cleanups (old_chain);
+  return done < len;
+}
+
+/* Return the first tracepoint of process PID at ADDR whose trap is
+   inserted, or NULL if there is none.  */
+
+static struct lwp_tracepoint *
+find_inserted_tracepoint (int pid, CORE_ADDR addr)
+{
+  struct lwp_tracepoint *tp;
+
+  for (tp = lwp_tracepoints; tp != NULL; tp = tp->next)
+    if (tp->inserted && tp->pid == pid && tp->address == addr)
+      return tp;
+
+  return NULL;
+}
+
+/* Insert the trap of tracepoint TP, unless another tracepoint at the
+   same place already has one inserted.  */
+
+static void
+insert_tracepoint_trap (struct lwp_tracepoint *tp)
+{
+  struct gdbarch *gdbarch = target_gdbarch ();
+  struct lwp_tracepoint *other = find_inserted_tracepoint (tp->pid,
+							  tp->address);
+  CORE_ADDR addr = tp->address;
+  const gdb_byte *trap;
+
+  trap = gdbarch_breakpoint_from_pc (gdbarch, &addr, &tp->trap_len);
+  if (trap == NULL || tp->trap_len > BREAKPOINT_MAX || addr != tp->address)
+    error (_("Cannot insert tracepoint %d at %s."),
+	   tp->number, paddress (gdbarch, tp->address));
+
+  if (other != NULL)
+    memcpy (tp->shadow, other->shadow, tp->trap_len);
+  else if (linux_nat_xfer_raw_memory (tp->shadow, NULL, addr, tp->trap_len)
+	   || linux_nat_xfer_raw_memory (NULL, trap, addr, tp->trap_len))
+    error (_("Cannot insert tracepoint %d at %s."),
+	   tp->number, paddress (gdbarch, tp->address));
+
+  tp->inserted = 1;
+}
+
+/* Remove the trap of tracepoint TP, unless another tracepoint at the
+   same place still needs it.  */
+
+static void
+remove_tracepoint_trap (struct lwp_tracepoint *tp)
+{
+  if (!tp->inserted)
+    return;
+
+  tp->inserted = 0;
+  if (find_inserted_tracepoint (tp->pid, tp->address) == NULL)
+    linux_nat_xfer_raw_memory (NULL, tp->shadow, tp->address, tp->trap_len);
+}
+
+/* Hide the tracepoint traps of the current inferior from the LEN
+   bytes of its memory at ADDR: show the contents they replace in
+   READBUF, or, when writing WRITEBUF, keep its contents for when the
+   traps are removed.  In the latter case, return a copy of WRITEBUF
+   to write instead, with the traps in place, or NULL if there is no
+   trap in the range.  */
+
+static gdb_byte *
+hide_tracepoint_traps (gdb_byte *readbuf, const gdb_byte *writebuf,
+		       CORE_ADDR addr, LONGEST len)
+{
+  int pid = ptid_get_pid (inferior_ptid);
+  struct lwp_tracepoint *tp;
+  gdb_byte *copy = NULL;
+
+  for (tp = lwp_tracepoints; tp != NULL; tp = tp->next)
+    {
+      CORE_ADDR lo, hi;
+      const gdb_byte *trap;
+      CORE_ADDR trap_addr = tp->address;
+      int trap_len;
+
+      if (!tp->inserted || tp->pid != pid
+	  || tp->address + tp->trap_len <= addr || tp->address >= addr + len)
+	continue;
+
+      lo = max (addr, tp->address);
+      hi = min (addr + len, tp->address + tp->trap_len);
+      if (readbuf != NULL)
+	memcpy (readbuf + (lo - addr), tp->shadow + (lo - tp->address),
+		hi - lo);
+      else
+	{
+	  memcpy (tp->shadow + (lo - tp->address), writebuf + (lo - addr),
+		  hi - lo);
+	  if (copy == NULL)
+	    {
+	      copy = xmalloc (len);
+	      memcpy (copy, writebuf, len);
+	    }
+	  trap = gdbarch_breakpoint_from_pc (target_gdbarch (), &trap_addr,
+					     &trap_len);
+	  memcpy (copy + (lo - addr), trap + (lo - tp->address), hi - lo);
+	}
+    }
+
+  return copy;
+}
+
+/* Callback for iterate_over_lwps.  If LP has a trap pending from a
+   tracepoint trap that has been removed, or whose trace frame is not
+   collected yet, throw the trap away and arrange for LP to execute
+   the instruction at the tracepoint again, as cancel_breakpoint does
+   for breakpoints.  DATA is an LWP to leave alone, or NULL.  */
+
+static int
+cancel_tracepoint_trap_callback (struct lwp_info *lp, void *data)
+{
+  struct regcache *regcache;
+  struct gdbarch *gdbarch;
+  struct lwp_tracepoint *tp;
+  CORE_ADDR pc;
+
+  if (lp == data || !linux_nat_lp_status_is_event (lp))
+    return 0;
+
+  regcache = get_thread_regcache (lp->ptid);
+  gdbarch = get_regcache_arch (regcache);
+  pc = regcache_read_pc (regcache) - gdbarch_decr_pc_after_break (gdbarch);
+
+  for (tp = lwp_tracepoints; tp != NULL; tp = tp->next)
+    if (tp->pid == ptid_get_pid (lp->ptid) && tp->address == pc)
+      break;
+
+  /* A trap at a breakpoint of the core is for cancel_breakpoint to
+     deal with.  */
+  if (tp == NULL
+      || (!tp->inserted
+	  && breakpoint_inserted_here_p (get_regcache_aspace (regcache), pc)))
+    return 0;
+
+  if (debug_linux_nat)
+    fprintf_unfiltered (gdb_stdlog,
+			"LLW: %s: push back tracepoint trap at %s\n",
+			target_pid_to_str (lp->ptid), paddress (gdbarch, pc));
+
+  if (gdbarch_decr_pc_after_break (gdbarch) != 0)
+    regcache_write_pc (regcache, pc);
+  lp->status = 0;
+  return 0;
+}
+
+/* Stop the trace run for REASON, removing all the tracepoint traps.
+   STOPPING is the tracepoint responsible, if there is one, and DESC
+   describes the reason in more detail, or is NULL.  */
+
+static void
+linux_nat_stop_trace_run (enum trace_stop_reason reason, int stopping,
+			  const char *desc)
+{
+  struct lwp_tracepoint *tp;
+  struct cleanup *old_chain = save_inferior_ptid ();
+
+  lwp_tracing = 0;
+  lwp_trace_stop_reason = reason;
+  lwp_trace_stopping_tracepoint = stopping;
+  xfree (lwp_trace_stop_desc);
+  lwp_trace_stop_desc = desc != NULL ? xstrdup (desc) : NULL;
+  lwp_trace_stop_time = lwp_trace_current_time ();
+
+  for (tp = lwp_tracepoints; tp != NULL; tp = tp->next)
+    if (tp->inserted)
+      {
+	struct lwp_info *lp = find_lwp_pid (pid_to_ptid (tp->pid));
+
+	if (lp != NULL)
+	  {
+	    inferior_ptid = lp->ptid;
+	    remove_tracepoint_trap (tp);
+	  }
+	tp->inserted = 0;
+      }
+
+  do_cleanups (old_chain);
+
+  /* Threads that hit a trap we just removed must not report it.  */
+  iterate_over_lwps (minus_one_ptid, cancel_tracepoint_trap_callback, NULL);
+}
+
+/* Reserve LEN more bytes at the end of the trace buffer, and return
+   them, or return NULL if the buffer is full.  */
+
+static gdb_byte *
+lwp_trace_buffer_reserve (size_t len)
+{
+  gdb_byte *p;
+
+  if (lwp_trace_buffer_len + len > lwp_trace_buffer_max)
+    return NULL;
+
+  if (lwp_trace_buffer_len + len > lwp_trace_buffer_alloc)
+    {
+      if (lwp_trace_buffer_alloc == 0)
+	lwp_trace_buffer_alloc = 64 * 1024;
+      while (lwp_trace_buffer_len + len > lwp_trace_buffer_alloc)
+	lwp_trace_buffer_alloc *= 2;
+      if (lwp_trace_buffer_alloc > lwp_trace_buffer_max)
+	lwp_trace_buffer_alloc = lwp_trace_buffer_max;
+      lwp_trace_buffer = xrealloc (lwp_trace_buffer, lwp_trace_buffer_alloc);
+    }
+
+  p = lwp_trace_buffer + lwp_trace_buffer_len;
+  lwp_trace_buffer_len += len;
+  return p;
+}
+
+/* The state of collecting one trace frame.  */
+
+struct lwp_trace_collect
+{
+  struct gdbarch *gdbarch;
+
+  /* Nonzero if the trace buffer filled up.  */
+  int full;
+};
+
+/* Add a block of LEN bytes of memory at ADDR to the trace frame being
+   collected, as described by DATA, a struct lwp_trace_collect.
+   Memory that can't be read is left out.  This is the
+   ax_trace_memory_ftype function for the collection actions.  */
+
+static int
+lwp_trace_collect_memory (void *data, CORE_ADDR addr, ULONGEST len)
+{
+  struct lwp_trace_collect *collect = data;
+  enum bfd_endian byte_order = gdbarch_byte_order (collect->gdbarch);
+
+  while (len > 0 && !collect->full)
+    {
+      size_t start = lwp_trace_buffer_len;
+      int n = len > 0xffff ? 0xffff : len;
+      gdb_byte *p = lwp_trace_buffer_reserve (1 + 8 + 2 + n);
+
+      if (p == NULL)
+	{
+	  collect->full = 1;
+	  break;
+	}
+
+      p[0] = 'M';
+      store_unsigned_integer (p + 1, 8, byte_order, addr);
+      store_unsigned_integer (p + 9, 2, byte_order, n);
+      if (target_read_memory (addr, p + 11, n) != 0)
+	lwp_trace_buffer_len = start;
+
+      addr += n;
+      len -= n;
+    }
+
+  return 0;
+}
+
+/* Collect a trace frame for tracepoint TP, hit by the thread whose
+   registers are in REGCACHE.  Stop the trace run if the buffer is full
+   or TP's pass count is reached.  */
+
+static void
+lwp_trace_collect_frame (struct lwp_tracepoint *tp,
+			 struct regcache *regcache)
+{
+  struct gdbarch *gdbarch = get_regcache_arch (regcache);
+  enum bfd_endian byte_order = gdbarch_byte_order (gdbarch);
+  struct lwp_trace_collect collect;
+  struct agent_expr *aexpr;
+  size_t start = lwp_trace_buffer_len;
+  gdb_byte *p;
+  int i, ix;
+
+  if (tp->cond != NULL)
+    {
+      ULONGEST value;
+
+      if (eval_agent_expr (tp->cond, regcache, &value) != 0)
+	{
+	  linux_nat_stop_trace_run (tracepoint_error, tp->number,
+				    _("cannot evaluate the condition"));
+	  return;
+	}
+      if (value == 0)
+	return;
+    }
+
+  tp->hit_count++;
+
+  collect.gdbarch = gdbarch;
+  collect.full = 0;
+
+  /* The frame header: the tracepoint number, and the size of the
+     blocks that follow, which we know at the end.  */
+  p = lwp_trace_buffer_reserve (2 + 4);
+  if (p == NULL)
+    collect.full = 1;
+  else
+    store_unsigned_integer (p, 2, byte_order, tp->number);
+
+  if (tp->collect_regs && !collect.full)
+    {
+      int size = 0;
+
+      for (i = 0; i < gdbarch_num_regs (gdbarch); i++)
+	size += register_size (gdbarch, i);
+
+      p = lwp_trace_buffer_reserve (1 + size);
+      if (p == NULL)
+	collect.full = 1;
+      else
+	{
+	  *p++ = 'R';
+	  for (i = 0; i < gdbarch_num_regs (gdbarch); i++)
+	    {
+	      if (regcache_raw_read (regcache, i, p) != REG_VALID)
+		memset (p, 0, register_size (gdbarch, i));
+	      p += register_size (gdbarch, i);
+	    }
+	}
+    }
+
+  for (i = 0; i < tp->num_ranges && !collect.full; i++)
+    {
+      struct memrange *r = &tp->ranges[i];
+      CORE_ADDR addr = r->start;
+
+      if (r->type != memrange_absolute)
+	{
+	  ULONGEST base;
+
+	  if (regcache_cooked_read_unsigned (regcache, r->type,
+					     &base) != REG_VALID)
+	    continue;
+	  addr += base;
+	}
+      lwp_trace_collect_memory (&collect, addr, r->end - r->start);
+    }
+
+  for (ix = 0;
+       !collect.full && VEC_iterate (agent_expr_p, tp->exprs, ix, aexpr);
+       ix++)
+    if (eval_trace_agent_expr (aexpr, regcache, lwp_trace_collect_memory,
+			       &collect) != 0)
+      {
+	lwp_trace_buffer_len = start;
+	linux_nat_stop_trace_run (tracepoint_error, tp->number,
+				  _("cannot evaluate a collection action"));
+	return;
+      }
+
+  if (collect.full)
+    {
+      lwp_trace_buffer_len = start;
+      linux_nat_stop_trace_run (trace_buffer_full, 0, NULL);
+      return;
+    }
+
+  store_unsigned_integer (lwp_trace_buffer + start + 2, 4, byte_order,
+			  lwp_trace_buffer_len - start - 6);
+  VEC_safe_push (lwp_traceframe_offset, lwp_traceframes, start);
+  lwp_traceframes_created++;
+  tp->traceframe_usage += lwp_trace_buffer_len - start;
+
+  if (tp->pass_count != 0 && tp->hit_count >= tp->pass_count)
+    linux_nat_stop_trace_run (tracepoint_passcount, tp->number, NULL);
+}
+
+/* LP has just reported *STATUSP.  If that is a trap at a tracepoint,
+   collect the tracepoint's trace frames.  Then, if the core has a
+   breakpoint there too, leave LP stopped at the trap for the core to
+   see, and return 0.  If the core asked for LP to be single-stepped,
+   step it over the trap, leave the status of the step in *STATUSP,
+   and return 0.  Otherwise, let LP continue, and return 1; the caller
+   should then go back to waiting.  Also return 0, and leave LP alone,
+   if *STATUSP is not a tracepoint trap.  */
+
+static int
+linux_nat_tracepoint_trap (struct lwp_info *lp, int *statusp)
+{
+  struct cleanup *old_chain;
+  struct regcache *regcache;
+  struct gdbarch *gdbarch;
+  struct lwp_tracepoint *tp;
+  siginfo_t siginfo;
+  CORE_ADDR pc;
+  int pid = ptid_get_pid (lp->ptid);
+  int decr_pc, core_breakpoint, status;
+
+  if (!lwp_tracing
+      || non_stop
+      || !linux_nat_status_is_event (*statusp)
+      || lp->waitstatus.kind != TARGET_WAITKIND_IGNORE
+      || lp->stopped_by_watchpoint)
+    return 0;
+
+  /* A step that ended just after a trap is not a hit.  */
+  if (linux_nat_get_siginfo (lp->ptid, &siginfo)
+      && siginfo.si_code == TRAP_TRACE)
+    return 0;
+
+  old_chain = save_inferior_ptid ();
+  inferior_ptid = lp->ptid;
+
+  regcache = get_thread_regcache (lp->ptid);
+  gdbarch = get_regcache_arch (regcache);
+  decr_pc = gdbarch_decr_pc_after_break (gdbarch);
+  pc = regcache_read_pc (regcache) - decr_pc;
+
+  if (find_inserted_tracepoint (pid, pc) == NULL)
+    {
+      do_cleanups (old_chain);
+      return 0;
+    }
+
+  /* Collect the frames with the thread's PC at the tracepoint, where
+     it is going to resume.  */
+  core_breakpoint
+    = breakpoint_inserted_here_p (get_regcache_aspace (regcache), pc);
+  if (decr_pc != 0)
+    regcache_write_pc (regcache, pc);
+
+  /* The other threads must not run past the trap while we lift it to
+     step over it, nor hit it after the trace run stops and takes it
+     away.  Reporting the stop to the core stops them anyway.  */
+  lp->stopped = 1;
+  iterate_over_lwps (minus_one_ptid, stop_callback, NULL);
+  iterate_over_lwps (minus_one_ptid, stop_wait_callback, NULL);
+
+  if (lp->tracepoint_collected_at == pc)
+    {
+      /* We collected this hit already, before the core saw the
+	 thread stop at its own breakpoint here.  The core is now
+	 stepping over that.  */
+      lp->tracepoint_collected_at = 0;
+    }
+  else
+    {
+      if (debug_linux_nat)
+	fprintf_unfiltered (gdb_stdlog,
+			    "LLW: %s: collecting tracepoint at %s\n",
+			    target_pid_to_str (lp->ptid),
+			    paddress (gdbarch, pc));
+
+      for (tp = lwp_tracepoints; tp != NULL && lwp_tracing; tp = tp->next)
+	if (tp->inserted && tp->enabled
+	    && tp->pid == pid && tp->address == pc)
+	  lwp_trace_collect_frame (tp, regcache);
+    }
+
+  if (core_breakpoint)
+    {
+      if (lwp_tracing)
+	lp->tracepoint_collected_at = pc;
+      if (decr_pc != 0)
+	regcache_write_pc (regcache, pc + decr_pc);
+      do_cleanups (old_chain);
+      return 0;
+    }
+
+  /* The trace run may have stopped meanwhile, and taken the trap
+     away.  */
+  if (find_inserted_tracepoint (pid, pc) == NULL)
+    {
+      do_cleanups (old_chain);
+      registers_changed ();
+      iterate_over_lwps (minus_one_ptid, resume_after_skip_callback, NULL);
+      return 1;
+    }
+
+  status = linux_nat_step_over_trap (lp, gdbarch, pc);
+  do_cleanups (old_chain);
+
+  if (status == -1)
+    {
+      /* Let the core see the trap, rather than looping on it.  */
+      warning (_("Cannot step over the tracepoint at %s."),
+	       paddress (gdbarch, pc));
+      if (decr_pc != 0)
+	regcache_write_pc (regcache, pc + decr_pc);
+      return 0;
+    }
+
+  if (lp->step && WIFSTOPPED (status) && WSTOPSIG (status) == SIGTRAP
+      && status >> 16 == 0)
+    {
+      /* The core asked for a single-step, and that is done now; report
+	 it in place of the trap.  */
+      lp->stopped = 1;
+      save_sigtrap (lp);
+      registers_changed ();
+      *statusp = status;
+      return 0;
+    }
+
+  linux_nat_finish_step_over (lp, status);
+  iterate_over_lwps (minus_one_ptid, resume_after_skip_callback, NULL);
+  return 1;
+}
+
+/* Remove the tracepoint traps of process PID from the memory of
+   CHILD_PID, a fork of it.  */
+
+static void
+detach_tracepoint_traps (int pid, int child_pid)
+{
+  struct cleanup *old_chain = save_inferior_ptid ();
+  struct lwp_tracepoint *tp;
+
+  inferior_ptid = pid_to_ptid (child_pid);
+  for (tp = lwp_tracepoints; tp != NULL; tp = tp->next)
+    if (tp->inserted && tp->pid == pid)
+      linux_nat_xfer_raw_memory (NULL, tp->shadow, tp->address,
+				 tp->trap_len);
+
+  do_cleanups (old_chain);
+}
+
+/* Native tracing targets methods.  */
+
+/* Forget the tracepoints of process PID, or all of them if PID is -1,
+   without removing their traps.  */
+
+static void
+forget_tracepoints (int pid)
+{
+  struct lwp_tracepoint **tpp = &lwp_tracepoints;
+
+  while (*tpp != NULL)
+    {
+      struct lwp_tracepoint *tp = *tpp;
+
+      if (pid == -1 || tp->pid == pid)
+	{
+	  struct agent_expr *aexpr;
+	  int ix;
+
+	  *tpp = tp->next;
+	  if (tp->cond != NULL)
+	    free_agent_expr (tp->cond);
+	  for (ix = 0; VEC_iterate (agent_expr_p, tp->exprs, ix, aexpr); ix++)
+	    free_agent_expr (aexpr);
+	  VEC_free (agent_expr_p, tp->exprs);
+	  xfree (tp->ranges);
+	  xfree (tp);
+	}
+      else
+	tpp = &tp->next;
+    }
+
+  if (lwp_tracepoints == NULL && lwp_tracing)
+    {
+      lwp_tracing = 0;
+      lwp_trace_stop_reason = trace_disconnected;
+      lwp_trace_stop_time = lwp_trace_current_time ();
+    }
+}
+
+static void
+linux_nat_trace_init (void)
+{
+  if (non_stop)
+    error (_("Tracing is not supported in non-stop mode "
+	     "by the native target."));
+
+  forget_tracepoints (-1);
+  VEC_free (lwp_traceframe_offset, lwp_traceframes);
+  lwp_trace_buffer_len = 0;
+  lwp_traceframes_created = 0;
+  lwp_trace_stop_reason = trace_never_run;
+  xfree (lwp_trace_stop_desc);
+  lwp_trace_stop_desc = NULL;
+}
+
+static void
+linux_nat_download_tracepoint (struct bp_location *loc)
+{
+  struct breakpoint *b = loc->owner;
+  struct tracepoint *t = (struct tracepoint *) b;
+  struct collection_list tracepoint_list, stepping_list;
+  struct lwp_tracepoint *tp;
+  struct cleanup *old_chain;
+  int i;
+
+  if (b->type == bp_static_tracepoint)
+    error (_("Static tracepoints are not supported by the native target."));
+
+  old_chain = encode_actions_and_make_cleanup (loc, &tracepoint_list,
+					       &stepping_list);
+  if (stepping_list.next_memrange != 0 || stepping_list.next_aexpr_elt != 0)
+    error (_("Tracepoint %d: \"while-stepping\" is not supported "
+	     "by the native target."), b->number);
+  for (i = 0; i < sizeof (stepping_list.regs_mask); i++)
+    if (stepping_list.regs_mask[i] != 0)
+      error (_("Tracepoint %d: \"while-stepping\" is not supported "
+	       "by the native target."), b->number);
+
+  tp = XCNEW (struct lwp_tracepoint);
+  tp->pid = ptid_get_pid (inferior_ptid);
+  tp->number = b->number;
+  tp->address = loc->address;
+  tp->enabled = (b->enable_state == bp_enabled);
+  tp->pass_count = t->pass_count;
+  if (loc->cond != NULL)
+    tp->cond = gen_eval_for_expr (loc->address, loc->cond);
+
+  /* The frame layout only allows for the whole register block; take it
+     if any register is wanted.  */
+  for (i = 0; i < sizeof (tracepoint_list.regs_mask); i++)
+    if (tracepoint_list.regs_mask[i] != 0)
+      tp->collect_regs = 1;
+
+  tp->num_ranges = tracepoint_list.next_memrange;
+  tp->ranges = XNEWVEC (struct memrange, tp->num_ranges);
+  memcpy (tp->ranges, tracepoint_list.list,
+	  tp->num_ranges * sizeof (struct memrange));
+  for (i = 0; i < tracepoint_list.next_aexpr_elt; i++)
+    VEC_safe_push (agent_expr_p, tp->exprs,
+		   copy_agent_expr (tracepoint_list.aexpr_list[i]));
+
+  do_cleanups (old_chain);
+
+  tp->next = lwp_tracepoints;
+  lwp_tracepoints = tp;
+
+  /* A tracepoint added while the trace is running takes effect right
+     away.  */
+  if (lwp_tracing)
+    insert_tracepoint_trap (tp);
+}
+
+static int
+linux_nat_can_download_tracepoint (void)
+{
+  return lwp_tracing;
+}
+
+static void
+linux_nat_download_trace_state_variable (struct trace_state_variable *tsv)
+{
+  /* Trace state variables are not supported; actions that use them
+     fail when evaluated.  */
+}
+
+/* Return the tracepoint of process PID for location LOC, or NULL if
+   there is none.  */
+
+static struct lwp_tracepoint *
+find_tracepoint_for_location (int pid, struct bp_location *loc)
+{
+  struct lwp_tracepoint *tp;
+
+  for (tp = lwp_tracepoints; tp != NULL; tp = tp->next)
+    if (tp->pid == pid
+	&& tp->number == loc->owner->number
+	&& tp->address == loc->address)
+      return tp;
+
+  return NULL;
+}
+
+static void
+linux_nat_enable_tracepoint (struct bp_location *loc)
+{
+  struct lwp_tracepoint *tp
+    = find_tracepoint_for_location (ptid_get_pid (inferior_ptid), loc);
+
+  if (tp != NULL)
+    tp->enabled = 1;
+}
+
+static void
+linux_nat_disable_tracepoint (struct bp_location *loc)
+{
+  struct lwp_tracepoint *tp
+    = find_tracepoint_for_location (ptid_get_pid (inferior_ptid), loc);
+
+  if (tp != NULL)
+    tp->enabled = 0;
+}
+
+static int
+linux_nat_supports_enable_disable_tracepoint (void)
+{
+  return 1;
+}
+
+static void
+linux_nat_trace_set_readonly_regions (void)
+{
+  /* Read-only sections are read from the executable file anyway.  */
+}
+
+static void
+linux_nat_trace_start (void)
+{
+  struct lwp_tracepoint *tp;
+  volatile struct gdb_exception ex;
+
+  lwp_trace_start_time = lwp_trace_current_time ();
+  lwp_trace_stop_time = 0;
+  lwp_tracing = 1;
+
+  TRY_CATCH (ex, RETURN_MASK_ALL)
+    {
+      for (tp = lwp_tracepoints; tp != NULL; tp = tp->next)
+	insert_tracepoint_trap (tp);
+    }
+  if (ex.reason < 0)
+    {
+      linux_nat_stop_trace_run (tracepoint_error, 0, ex.message);
+      throw_exception (ex);
+    }
+}
+
+static int
+linux_nat_get_trace_status (struct trace_status *ts)
+{
+  struct gdbarch *gdbarch = target_gdbarch ();
+  int i;
+
+  /* "tsave" wants to know the size of the register blocks.  */
+  trace_regblock_size = 0;
+  for (i = 0; i < gdbarch_num_regs (gdbarch); i++)
+    trace_regblock_size += register_size (gdbarch, i);
+
+  ts->filename = NULL;
+  ts->running_known = 1;
+  ts->running = lwp_tracing;
+  ts->stop_reason = (lwp_tracing ? trace_stop_reason_unknown
+		     : lwp_trace_stop_reason);
+  ts->stopping_tracepoint = lwp_trace_stopping_tracepoint;
+  xfree (ts->stop_desc);
+  ts->stop_desc = (lwp_trace_stop_desc != NULL
+		   ? xstrdup (lwp_trace_stop_desc) : NULL);
+  ts->traceframe_count = VEC_length (lwp_traceframe_offset, lwp_traceframes);
+  ts->traceframes_created = lwp_traceframes_created;
+  ts->buffer_size = lwp_trace_buffer_max;
+  ts->buffer_free = lwp_trace_buffer_max - lwp_trace_buffer_len;
+  ts->disconnected_tracing = 0;
+  ts->circular_buffer = 0;
+  ts->start_time = lwp_trace_start_time;
+  ts->stop_time = lwp_trace_stop_time;
+
+  return lwp_tracing;
+}
+
+static void
+linux_nat_get_tracepoint_status (struct breakpoint *b,
+				 struct uploaded_tp *utp)
+{
+  struct tracepoint *t = (struct tracepoint *) b;
+  struct lwp_tracepoint *tp;
+
+  if (t == NULL)
+    return;
+
+  t->base.hit_count = 0;
+  t->traceframe_usage = 0;
+  for (tp = lwp_tracepoints; tp != NULL; tp = tp->next)
+    if (t->number_on_target != 0 && tp->number == t->number_on_target)
+      {
+	t->base.hit_count += tp->hit_count;
+	t->traceframe_usage += tp->traceframe_usage;
+      }
+}
+
+static void
+linux_nat_trace_stop (void)
+{
+  if (lwp_tracing)
+    linux_nat_stop_trace_run (tstop_command, 0, NULL);
+}
+
+static void
+linux_nat_set_trace_buffer_size (LONGEST val)
+{
+  if (lwp_tracing)
+    return;
+
+  if (val < 0)
+    lwp_trace_buffer_max = LWP_TRACE_BUFFER_SIZE_DEFAULT;
+  else
+    lwp_trace_buffer_max = val;
+
+  if (lwp_trace_buffer_len > lwp_trace_buffer_max)
+    {
+      lwp_trace_buffer_len = 0;
+      VEC_free (lwp_traceframe_offset, lwp_traceframes);
+    }
+}
+
+/* Return the offset in LWP_TRACE_BUFFER of the blocks of trace frame
+   TFNUM, and their size in *SIZE.  Return 0 if there is no such trace
+   frame.  */
+
+static size_t
+lwp_traceframe_blocks (int tfnum, size_t *size)
+{
+  enum bfd_endian byte_order = gdbarch_byte_order (target_gdbarch ());
+  size_t offset;
+
+  if (tfnum < 0 || tfnum >= VEC_length (lwp_traceframe_offset,
+					lwp_traceframes))
+    return 0;
+
+  offset = VEC_index (lwp_traceframe_offset, lwp_traceframes, tfnum);
+  *size = extract_unsigned_integer (lwp_trace_buffer + offset + 2, 4,
+				    byte_order);
+  return offset + 6;
+}
+
+/* Return the tracepoint number of trace frame TFNUM.  */
+
+static int
+lwp_traceframe_tpnum (int tfnum)
+{
+  enum bfd_endian byte_order = gdbarch_byte_order (target_gdbarch ());
+  size_t offset = VEC_index (lwp_traceframe_offset, lwp_traceframes, tfnum);
+
+  return extract_unsigned_integer (lwp_trace_buffer + offset, 2, byte_order);
+}
+
+/* Return the block of type TYPE in trace frame TFNUM, after the one at
+   *OFFSET if that is not zero, and set *OFFSET to its offset in
+   LWP_TRACE_BUFFER; or return NULL if there is none.  The blocks are
+   laid out as tfile_open expects.  */
+
+static gdb_byte *
+lwp_traceframe_next_block (int tfnum, char type, size_t *offset)
+{
+  enum bfd_endian byte_order = gdbarch_byte_order (target_gdbarch ());
+  struct gdbarch *gdbarch = target_gdbarch ();
+  size_t size, pos, end;
+  int i;
+
+  pos = lwp_traceframe_blocks (tfnum, &size);
+  if (pos == 0)
+    return NULL;
+  end = pos + size;
+
+  while (pos < end)
+    {
+      gdb_byte *block = lwp_trace_buffer + pos;
+      size_t len = 1;
+
+      switch (*block)
+	{
+	case 'R':
+	  for (i = 0; i < gdbarch_num_regs (gdbarch); i++)
+	    len += register_size (gdbarch, i);
+	  break;
+	case 'M':
+	  len += 8 + 2 + extract_unsigned_integer (block + 9, 2, byte_order);
+	  break;
+	default:
+	  internal_error (__FILE__, __LINE__,
+			  _("unknown trace frame block type %c"), *block);
+	}
+
+      if (*block == type && pos > *offset)
+	{
+	  *offset = pos;
+	  return block;
+	}
+      pos += len;
+    }
+
+  return NULL;
+}
+
+/* Return the address at which trace frame TFNUM was collected.  */
+
+static CORE_ADDR
+lwp_traceframe_address (int tfnum)
+{
+  struct tracepoint *tp
+    = get_tracepoint_by_number_on_target (lwp_traceframe_tpnum (tfnum));
+
+  if (tp != NULL && tp->base.loc != NULL)
+    return tp->base.loc->address;
+  return 0;
+}
+
+static int
+linux_nat_trace_find (enum trace_find_type type, int num,
+		      CORE_ADDR addr1, CORE_ADDR addr2, int *tpp)
+{
+  int count = VEC_length (lwp_traceframe_offset, lwp_traceframes);
+  int tfnum, found = 0;
+  struct tracepoint *tp;
+  CORE_ADDR tfaddr;
+
+  if (num == -1)
+    {
+      if (tpp != NULL)
+	*tpp = -1;
+      return -1;
+    }
+
+  if (type == tfind_number)
+    {
+      tfnum = num;
+      found = (tfnum >= 0 && tfnum < count);
+    }
+  else
+    for (tfnum = get_traceframe_number () + 1; tfnum < count; tfnum++)
+      {
+	switch (type)
+	  {
+	  case tfind_pc:
+	    found = (lwp_traceframe_address (tfnum) == addr1);
+	    break;
+	  case tfind_tp:
+	    tp = get_tracepoint (num);
+	    found = (tp != NULL
+		     && tp->number_on_target == lwp_traceframe_tpnum (tfnum));
+	    break;
+	  case tfind_range:
+	    tfaddr = lwp_traceframe_address (tfnum);
+	    found = (addr1 <= tfaddr && tfaddr <= addr2);
+	    break;
+	  case tfind_outside:
+	    tfaddr = lwp_traceframe_address (tfnum);
+	    found = !(addr1 <= tfaddr && tfaddr <= addr2);
+	    break;
+	  default:
+	    internal_error (__FILE__, __LINE__, _("unknown tfind type"));
+	  }
+	if (found)
+	  break;
+      }
+
+  if (!found)
+    {
+      if (tpp != NULL)
+	*tpp = -1;
+      return -1;
+    }
+
+  if (tpp != NULL)
+    *tpp = lwp_traceframe_tpnum (tfnum);
+  return tfnum;
+}
+
+/* Supply REGCACHE's registers from the current trace frame, as
+   tfile_fetch_registers does.  */
+
+static void
+lwp_traceframe_fetch_registers (struct regcache *regcache)
+{
+  struct gdbarch *gdbarch = get_regcache_arch (regcache);
+  int tfnum = get_traceframe_number ();
+  size_t offset = 0;
+  gdb_byte *block = lwp_traceframe_next_block (tfnum, 'R', &offset);
+  int regn;
+
+  if (block != NULL)
+    {
+      block++;
+      for (regn = 0; regn < gdbarch_num_regs (gdbarch); regn++)
+	{
+	  regcache_raw_supply (regcache, regn, block);
+	  block += register_size (gdbarch, regn);
+	}
+      return;
+    }
+
+  /* Without the registers, all we know is the PC, from the
+     tracepoint's address.  */
+  for (regn = 0; regn < gdbarch_num_regs (gdbarch); regn++)
+    regcache_raw_supply (regcache, regn, NULL);
+
+  if (gdbarch_pc_regnum (gdbarch) >= 0)
+    {
+      int pc_regno = gdbarch_pc_regnum (gdbarch);
+      gdb_byte buf[MAX_REGISTER_SIZE];
+
+      store_unsigned_integer (buf, register_size (gdbarch, pc_regno),
+			      gdbarch_byte_order (gdbarch),
+			      lwp_traceframe_address (tfnum));
+      regcache_raw_supply (regcache, pc_regno, buf);
+    }
+}
+
+static void
+linux_nat_fetch_registers (struct target_ops *ops,
+			   struct regcache *regcache, int regno)
+{
+  if (get_traceframe_number () != -1)
+    lwp_traceframe_fetch_registers (regcache);
+  else
+    linux_ops->to_fetch_registers (ops, regcache, regno);
+}
+
+static void
+linux_nat_store_registers (struct target_ops *ops,
+			   struct regcache *regcache, int regno)
+{
+  if (get_traceframe_number () != -1)
+    error (_("Cannot change registers while looking at trace frames."));
+
+  linux_ops->to_store_registers (ops, regcache, regno);
+}
+
+/* Read LEN bytes of memory at ADDR from the current trace frame into
+   READBUF, and return how many could be read, or
+   TARGET_XFER_E_UNAVAILABLE if the trace frame does not have the
+   memory at ADDR.  */
+
+static LONGEST
+lwp_traceframe_read_memory (gdb_byte *readbuf, CORE_ADDR addr, LONGEST len)
+{
+  enum bfd_endian byte_order = gdbarch_byte_order (target_gdbarch ());
+  int tfnum = get_traceframe_number ();
+  size_t offset = 0;
+  gdb_byte *block;
+
+  while ((block = lwp_traceframe_next_block (tfnum, 'M', &offset)) != NULL)
+    {
+      CORE_ADDR maddr = extract_unsigned_integer (block + 1, 8, byte_order);
+      unsigned int mlen = extract_unsigned_integer (block + 9, 2, byte_order);
+
+      if (maddr <= addr && addr < maddr + mlen)
+	{
+	  LONGEST amt = min (len, maddr + mlen - addr);
+
+	  memcpy (readbuf, block + 11 + (addr - maddr), amt);
+	  return amt;
+	}
+    }
+
+  return TARGET_XFER_E_UNAVAILABLE;
+}
+
+static LONGEST
+linux_nat_get_raw_trace_data (gdb_byte *buf, ULONGEST offset, LONGEST len)
+{
+  if (offset >= lwp_trace_buffer_len)
+    return 0;
+
+  len = min (len, lwp_trace_buffer_len - offset);
+  memcpy (buf, lwp_trace_buffer + offset, len);
+  return len;
+}
+
+static struct traceframe_info *
+linux_nat_traceframe_info (void)
+{
+  enum bfd_endian byte_order = gdbarch_byte_order (target_gdbarch ());
+  int tfnum = get_traceframe_number ();
+  struct traceframe_info *info;
+  size_t offset = 0;
+  gdb_byte *block;
+
+  /* All of the live memory is available.  */
+  if (tfnum == -1)
+    return NULL;
+
+  info = XCNEW (struct traceframe_info);
+  while ((block = lwp_traceframe_next_block (tfnum, 'M', &offset)) != NULL)
+    {
+      struct mem_range *r = VEC_safe_push (mem_range_s, info->memory, NULL);
+
+      r->start = extract_unsigned_integer (block + 1, 8, byte_order);
+      r->length = extract_unsigned_integer (block + 9, 2, byte_order);
+    }
+
+  return info;
+}
+
+/* Watchpoints that the debug registers cannot hold are implemented
+   by write-protecting the pages they watch, instead of making the core
+   single-step the whole program.  A write to such a page faults; we
+   then let the faulting instruction complete with the page writable
+   again, write-protect the page once more, and report a watchpoint
+   trigger if the fault was at a watched address.  This is only done in
+   all-stop mode, where we can stop the other threads while the page is
+   writable.  */
+
+/* Whether to implement watchpoints with page protection when the
+   debug registers run out.  */
+static int can_use_page_watchpoints = 1;
+
+/* A write watchpoint implemented with page protection.  */
+
+struct page_watch
+{
+  /* The process being watched.  */
+  int pid;
+
+  /* The watched range.  */
+  CORE_ADDR addr;
+  int len;
+
+  /* Next in the list.  */
+  struct page_watch *next;
+};
+
+static struct page_watch *page_watches;
+
+/* A page we have write-protected.  We keep the entry when we lift the
+   protection again, so that we still recognize faults on the page
+   that other threads reported meanwhile.  */
+
+struct watched_page
+{
+  /* The process the page belongs to.  */
+  int pid;
+
+  /* The start of the page.  */
+  CORE_ADDR addr;
+
+  /* The page's own protection, which we restore.  */
+  int prot;
+
+  /* Non-zero if the page is currently write-protected.  */
+  int protected_p;
+
+  /* Next in the list.  */
+  struct watched_page *next;
+};
+
+static struct watched_page *watched_pages;
+
+/* Writes can fault at an address somewhat before the watched range,
+   when a wide store starts in front of it.  Report faults this close
+   to a watched range too; the core ignores triggers that did not
+   change the value.  */
+
+#define PAGE_WATCH_SLACK 64
+
+static void
+show_can_use_page_watchpoints (struct ui_file *file, int from_tty,
+			       struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file,
+		    _("Use of page protection for watchpoints is %s.\n"),
+		    value);
+}
+
+/* Return the page size of the inferior.  */
+
+static CORE_ADDR
+page_watch_page_size (void)
+{
+  static CORE_ADDR page_size;
+
+  if (page_size == 0)
+    page_size = sysconf (_SC_PAGESIZE);
+  return page_size;
+}
+
+/* Return the page watch of process PID that covers ADDR, or NULL if
+   there is none.  */
+
+static struct page_watch *
+find_page_watch_at (int pid, CORE_ADDR addr)
+{
+  struct page_watch *w;
+
+  for (w = page_watches; w != NULL; w = w->next)
+    if (w->pid == pid
+	&& addr + PAGE_WATCH_SLACK > w->addr
+	&& addr < w->addr + w->len)
+      return w;
+
+  return NULL;
+}
+
+/* Return non-zero if some page watch of process PID overlaps the page
+   starting at PAGE.  */
+
+static int
+page_watched_p (int pid, CORE_ADDR page)
+{
+  struct page_watch *w;
+
+  for (w = page_watches; w != NULL; w = w->next)
+    if (w->pid == pid
+	&& w->addr < page + page_watch_page_size ()
+	&& w->addr + w->len > page)
+      return 1;
+
+  return 0;
+}
+
+/* Return the entry for the page of process PID that starts at PAGE,
+   or NULL if we never protected it.  */
+
+static struct watched_page *
+find_watched_page (int pid, CORE_ADDR page)
+{
+  struct watched_page *p;
+
+  for (p = watched_pages; p != NULL; p = p->next)
+    if (p->pid == pid && p->addr == page)
+      return p;
+
+  return NULL;
+}
+
+/* Forget all page watches and watched pages of process PID.  */
+
+static void
+forget_page_watches (int pid)
+{
+  struct page_watch **wp = &page_watches;
+  struct watched_page **pp = &watched_pages;
+
+  while (*wp != NULL)
+    {
+      struct page_watch *w = *wp;
+
+      if (w->pid == pid)
+	{
+	  *wp = w->next;
+	  xfree (w);
+	}
+      else
+	wp = &w->next;
+    }
+
+  while (*pp != NULL)
+    {
+      struct watched_page *p = *pp;
+
+      if (p->pid == pid)
+	{
+	  *pp = p->next;
+	  xfree (p);
+	}
+      else
+	pp = &p->next;
+    }
+}
+
+/* Return the protection of the mapping of process PID that contains
+   ADDR, as read from /proc/PID/maps, or -1 if ADDR is not mapped.  */
+
+static int
+linux_nat_page_protection (int pid, CORE_ADDR addr)
+{
+  char filename[100];
+  char line[PATH_MAX + 100];
+  struct cleanup *cleanup;
+  FILE *f;
+  int prot = -1;
+
+  xsnprintf (filename, sizeof filename, "/proc/%d/maps", pid);
+  f = gdb_fopen_cloexec (filename, "r");
+  if (f == NULL)
+    return -1;
+  cleanup = make_cleanup_fclose (f);
+
+  while (fgets (line, sizeof line, f) != NULL)
+    {
+      unsigned long start, end;
+      char perms[5];
+
+      if (sscanf (line, "%lx-%lx %4s", &start, &end, perms) != 3)
+	continue;
+      if (addr >= start && addr < end)
+	{
+	  prot = 0;
+	  if (perms[0] == 'r')
+	    prot |= PROT_READ;
+	  if (perms[1] == 'w')
+	    prot |= PROT_WRITE;
+	  if (perms[2] == 'x')
+	    prot |= PROT_EXEC;
+	  break;
+	}
+    }
+
+  do_cleanups (cleanup);
+  return prot;
+}
+
+/* Set the protection of the page at PAGE to PROT, by having the
+   stopped LWP LWPID run mprotect.  Return 0 on success.  */
+
+static int
+inferior_mprotect (int lwpid, CORE_ADDR page, int prot)
+{
+  struct lwp_info *lp = find_lwp_pid (pid_to_ptid (lwpid));
+  struct lwp_info tmp;
+  int ret;
+
+  /* The LWP may be a fork child we do not track.  */
+  if (lp == NULL)
+    {
+      memset (&tmp, 0, sizeof (tmp));
+      tmp.ptid = ptid_build (lwpid, lwpid, 0);
+      tmp.stopped = 1;
+      lp = &tmp;
+    }
+
+  ret = linux_nat_inferior_mprotect (lp, page, page_watch_page_size (), prot);
+
+  if (debug_linux_nat)
+    fprintf_unfiltered (gdb_stdlog,
+			"LNPW: mprotect (%s, %d) in LWP %d %s\n",
+			core_addr_to_string (page), prot, lwpid,
+			ret == 0 ? "(OK)" : "(FAILED)");
+  return ret;
+}
+
+/* Bring the protection of the pages of process PID in line with its
+   page watches, using the stopped LWP LWPID.  Return 0 on success.  */
+
+static int
+sync_watched_pages (int pid, int lwpid)
+{
+  CORE_ADDR page_size = page_watch_page_size ();
+  struct watched_page *p;
+  struct page_watch *w;
+  int ret = 0;
+
+  for (p = watched_pages; p != NULL; p = p->next)
+    if (p->pid == pid && p->protected_p && !page_watched_p (pid, p->addr))
+      {
+	if (inferior_mprotect (lwpid, p->addr, p->prot) == 0)
+	  p->protected_p = 0;
+	else
+	  ret = -1;
+      }
+
+  for (w = page_watches; w != NULL; w = w->next)
+    {
+      CORE_ADDR page;
+
+      if (w->pid != pid)
+	continue;
+
+      for (page = w->addr & ~(page_size - 1);
+	   page < w->addr + w->len;
+	   page += page_size)
+	{
+	  int prot;
+
+	  p = find_watched_page (pid, page);
+	  if (p != NULL && p->protected_p)
+	    continue;
+
+	  /* Writes to pages that are not writable fault anyway.  */
+	  prot = linux_nat_page_protection (pid, page);
+	  if (prot < 0)
+	    {
+	      ret = -1;
+	      continue;
+	    }
+	  if ((prot & PROT_WRITE) == 0)
+	    continue;
+
+	  if (inferior_mprotect (lwpid, page, prot & ~PROT_WRITE) != 0)
+	    {
+	      ret = -1;
+	      continue;
+	    }
+
+	  if (p == NULL)
+	    {
+	      p = XNEW (struct watched_page);
+	      p->pid = pid;
+	      p->addr = page;
+	      p->next = watched_pages;
+	      watched_pages = p;
+	    }
+	  p->prot = prot;
+	  p->protected_p = 1;
+	}
+    }
+
+  return ret;
+}
+
+/* Return non-zero if we can insert page watches into the inferior
+   now.  */
+
+static int
+page_watches_usable_p (void)
+{
+  return (can_use_page_watchpoints
+	  && !non_stop
+	  && linux_nat_inferior_mprotect != NULL);
+}
+
+static int
+linux_nat_can_use_hw_breakpoint (int type, int cnt, int othertype)
+{
+  int ret = 1;
+
+  if (linux_ops->to_can_use_hw_breakpoint != NULL)
+    ret = linux_ops->to_can_use_hw_breakpoint (type, cnt, othertype);
+
+  if (ret <= 0 && type == bp_hardware_watchpoint && page_watches_usable_p ())
+    ret = 1;
+
+  return ret;
+}
+
+static int
+linux_nat_region_ok_for_watchpoint (CORE_ADDR addr, int len)
+{
+  if (linux_ops->to_region_ok_for_hw_watchpoint != NULL
+      ? linux_ops->to_region_ok_for_hw_watchpoint (addr, len)
+      : len <= gdbarch_ptr_bit (target_gdbarch ()) / TARGET_CHAR_BIT)
+    return 1;
+
+  return page_watches_usable_p ();
+}
+
+static int
+linux_nat_insert_watchpoint (CORE_ADDR addr, int len, int type,
+			     struct expression *cond)
+{
+  struct lwp_info *lp;
+  struct page_watch *w;
+  int pid;
+
+  if (linux_ops->to_insert_watchpoint != NULL
+      && linux_ops->to_insert_watchpoint (addr, len, type, cond) == 0)
+    return 0;
+
+  /* Only writes can be caught this way without faulting on every
+     access to the page.  */
+  if (type != hw_write || len <= 0 || !page_watches_usable_p ())
+    return 1;
+
+  lp = find_lwp_pid (inferior_ptid);
+  if (lp == NULL || !lp->stopped)
+    return 1;
+  pid = ptid_get_pid (lp->ptid);
+
+  w = XNEW (struct page_watch);
+  w->pid = pid;
+  w->addr = addr;
+  w->len = len;
+  w->next = page_watches;
+  page_watches = w;
+
+  if (sync_watched_pages (pid, ptid_get_lwp (lp->ptid)) != 0)
+    {
+      page_watches = w->next;
+      xfree (w);
+      sync_watched_pages (pid, ptid_get_lwp (lp->ptid));
+      return 1;
+    }
+
+  return 0;
+}
+
+static int
+linux_nat_remove_watchpoint (CORE_ADDR addr, int len, int type,
+			     struct expression *cond)
+{
+  int pid = ptid_get_pid (inferior_ptid);
+  struct page_watch **wp;
+  int lwpid;
+
+  lwpid = ptid_get_lwp (inferior_ptid);
+  if (lwpid == 0)
+    lwpid = pid;
+
+  /* When a process forks, the core removes the parent's watchpoints
+     from the child, which is not an inferior of its own yet.  The
+     child inherited the protected pages; just unprotect them.  */
+  if (pid != current_inferior ()->pid && find_inferior_pid (pid) == NULL)
+    {
+      int parent_pid = current_inferior ()->pid;
+      CORE_ADDR page_size = page_watch_page_size ();
+      struct watched_page *p;
+      CORE_ADDR page;
+
+      if (find_page_watch_at (parent_pid, addr) == NULL)
+	return (linux_ops->to_remove_watchpoint != NULL
+		? linux_ops->to_remove_watchpoint (addr, len, type, cond)
+		: 1);
+
+      for (page = addr & ~(page_size - 1); page < addr + len;
+	   page += page_size)
+	{
+	  p = find_watched_page (parent_pid, page);
+	  if (p != NULL && p->protected_p)
+	    inferior_mprotect (lwpid, page, p->prot);
+	}
+      return 0;
+    }
+
+  for (wp = &page_watches; *wp != NULL; wp = &(*wp)->next)
+    {
+      struct page_watch *w = *wp;
+
+      if (w->pid == pid && w->addr == addr && w->len == len)
+	{
+	  *wp = w->next;
+	  xfree (w);
+	  return sync_watched_pages (pid, lwpid) == 0 ? 0 : 1;
+	}
+    }
+
+  if (linux_ops->to_remove_watchpoint != NULL)
+    return linux_ops->to_remove_watchpoint (addr, len, type, cond);
+  return 1;
+}
+
+/* LP has just reported STATUS.  If that is a write fault on a page we
+   write-protected, have LP complete the write with the page writable,
+   and return 1 if LP's event was dealt with and the caller should go
+   back to waiting.  Otherwise, return 0 with *STATUSP holding the
+   event to report, which is a watchpoint trigger if the write was to
+   a watched address.  */
+
+static int
+linux_nat_page_watch_fault (struct lwp_info *lp, int *statusp)
+{
+  int status = *statusp;
+  int pid = ptid_get_pid (lp->ptid);
+  int lwpid = ptid_get_lwp (lp->ptid);
+  int protect_lwpid;
+  struct watched_page *p;
+  struct page_watch *w;
+  CORE_ADDR addr;
+  siginfo_t siginfo;
+
+  if (watched_pages == NULL
+      || !WIFSTOPPED (status)
+      || WSTOPSIG (status) != SIGSEGV
+      || !linux_nat_get_siginfo (lp->ptid, &siginfo)
+      || siginfo.si_code != SEGV_ACCERR)
+    return 0;
+
+  addr = (CORE_ADDR) (uintptr_t) siginfo.si_addr;
+  p = find_watched_page (pid, addr & ~(page_watch_page_size () - 1));
+  if (p == NULL)
+    return 0;
+
+  if (!p->protected_p)
+    {
+      int prot;
+
+      /* We lifted the protection after the fault happened.  Let the
+	 write happen again, unless the page is really read-only.  */
+      prot = linux_nat_page_protection (pid, p->addr);
+      if (prot < 0 || (prot & PROT_WRITE) == 0)
+	return 0;
+
+      registers_changed ();
+      if (linux_nat_prepare_to_resume != NULL)
+	linux_nat_prepare_to_resume (lp);
+      linux_ops->to_resume (linux_ops, pid_to_ptid (lwpid),
+			    lp->step, GDB_SIGNAL_0);
+      lp->stopped = 0;
+      return 1;
+    }
+
+  w = find_page_watch_at (pid, addr);
+
+  if (debug_linux_nat)
+    fprintf_unfiltered (gdb_stdlog,
+			"LNPW: %s: write fault at %s (%s)\n",
+			target_pid_to_str (lp->ptid),
+			core_addr_to_string (addr),
+			w != NULL ? "watched" : "not watched");
+
+  /* Other threads must not write to the page while it is writable.  */
+  lp->stopped = 1;
+  iterate_over_lwps (minus_one_ptid, stop_callback, NULL);
+  iterate_over_lwps (minus_one_ptid, stop_wait_callback, NULL);
+
+  if (inferior_mprotect (lwpid, p->addr, p->prot) != 0)
+    return 0;
+
+  status = linux_nat_step_lwp (lp);
+
+  /* The step may have triggered a hardware watchpoint as well.  Find
+     out before we step LP again below.  */
+  if (WIFSTOPPED (status) && WSTOPSIG (status) == SIGTRAP
+      && status >> 16 == 0)
+    save_sigtrap (lp);
+
+  protect_lwpid = lwpid;
+  if (!WIFSTOPPED (status))
+    {
+      /* LP is gone; protect the page again through another LWP.  */
+      struct lwp_info *other;
+
+      ALL_LWPS (other)
+	if (ptid_get_pid (other->ptid) == pid && other != lp && other->stopped)
+	  {
+	    protect_lwpid = ptid_get_lwp (other->ptid);
+	    break;
+	  }
+    }
+  if (inferior_mprotect (protect_lwpid, p->addr, p->prot & ~PROT_WRITE) != 0)
+    p->protected_p = 0;
+
+  registers_changed ();
+
+  if (WIFSTOPPED (status) && WSTOPSIG (status) == SIGTRAP
+      && status >> 16 == 0)
+    {
+      if (!lp->stopped_by_watchpoint && w != NULL)
+	{
+	  lp->stopped_by_watchpoint = 1;
+	  lp->stopped_data_address_p = 1;
+	  lp->stopped_data_address = addr < w->addr ? w->addr : addr;
+	}
+
+      /* Report the trigger, or the end of a step the core asked
+	 for.  */
+      if (lp->stopped_by_watchpoint || lp->step)
+	{
+	  *statusp = status;
+	  return 0;
+	}
+    }
+  else if (status != 0)
+    {
+      int new_pending;
+
+      /* Something else happened while stepping; let the usual event
+	 processing handle it, leaving any event pending.  */
+      linux_nat_filter_event (lwpid, status, &new_pending);
+    }
+
+  iterate_over_lwps (minus_one_ptid, resume_after_skip_callback, NULL);
+  return 1;
+}
+
+static ptid_t
+linux_nat_wait_1 (struct target_ops *ops,
+		  ptid_t ptid, struct target_waitstatus *ourstatus,
+		  int target_options)
+{
+  static sigset_t prev_mask;
+  enum resume_kind last_resume_kind;
+  struct lwp_info *lp;
+  int status;
+
+  if (debug_linux_nat)
+    fprintf_unfiltered (gdb_stdlog, "LLW: enter\n");
+
+  /* The first time we get here after starting a new inferior, we may
+     not have added it to the LWP list yet - this is the earliest
+     moment at which we know its PID.  */
+  if (ptid_is_pid (inferior_ptid))
+    {
+      /* Upgrade the main thread's ptid.  */
+      thread_change_ptid (inferior_ptid,
+			  ptid_build (ptid_get_pid (inferior_ptid),
+				      ptid_get_pid (inferior_ptid), 0));
+
+      lp = add_initial_lwp (inferior_ptid);
+      lp->resumed = 1;
+    }
+
+  /* Make sure SIGCHLD is blocked until the sigsuspend below.  */
+  block_child_signals (&prev_mask);
+
+retry:
+  lp = NULL;
+  status = 0;
+
+  /* First check if there is a LWP with a wait status pending.  */
+  if (ptid_equal (ptid, minus_one_ptid) || ptid_is_pid (ptid))
+    {
+      /* Any LWP in the PTID group that's been resumed will do.  */
+      lp = find_pending_lwp (ptid);
+      if (lp)
+	{
+	  if (debug_linux_nat && lp->status)
+	    fprintf_unfiltered (gdb_stdlog,
+				"LLW: Using pending wait status %s for %s.\n",
+				status_to_str (lp->status),
+				target_pid_to_str (lp->ptid));
+	}
+    }
+  else if (ptid_lwp_p (ptid))
+    {
+      if (debug_linux_nat)
+	fprintf_unfiltered (gdb_stdlog,
+			    "LLW: Waiting for specific LWP %s.\n",
+			    target_pid_to_str (ptid));
+
+      /* We have a specific LWP to check.  */
+      lp = find_lwp_pid (ptid);
+      gdb_assert (lp);
+
+      if (debug_linux_nat && lp->status)
+	fprintf_unfiltered (gdb_stdlog,
+			    "LLW: Using pending wait status %s for %s.\n",
+			    status_to_str (lp->status),
+			    target_pid_to_str (lp->ptid));
+
+      /* We check for lp->waitstatus in addition to lp->status,
+	 because we can have pending process exits recorded in
+	 lp->status and W_EXITCODE(0,0) == 0.  We should probably have
+	 an additional lp->status_p flag.  */
+      if (lp->status == 0 && lp->waitstatus.kind == TARGET_WAITKIND_IGNORE)
+	lp = NULL;
+    }
+
+  if (!target_can_async_p ())
+    {
+      /* Causes SIGINT to be passed on to the attached process.  */
+      set_sigint_trap ();
+    }
+
+  /* But if we don't find a pending event, we'll have to wait.  */
+
+  while (lp == NULL)
+    {
+      pid_t lwpid;
+
+      /* Always use -1 and WNOHANG, due to couple of a kernel/ptrace
+	 quirks:
+
+	 - If the thread group leader exits while other threads in the
+	   thread group still exist, waitpid(TGID, ...) hangs.  That
+	   waitpid won't return an exit status until the other threads
+	   in the group are reapped.
+
+	 - When a non-leader thread execs, that thread just vanishes
+	   without reporting an exit (so we'd hang if we waited for it
+	   explicitly in that case).  The exec event is reported to
+	   the TGID pid.  */
+
+      errno = 0;
+      lwpid = my_waitpid (-1, &status,  __WCLONE | WNOHANG);
+      if (lwpid == 0 || (lwpid == -1 && errno == ECHILD))
+	lwpid = my_waitpid (-1, &status, WNOHANG);
+
+      if (debug_linux_nat)
+	fprintf_unfiltered (gdb_stdlog,
+			    "LNW: waitpid(-1, ...) returned %d, %s\n",
+			    lwpid, errno ? safe_strerror (errno) : "ERRNO-OK");
+
+      if (lwpid > 0)
+	{
+	  /* If this is true, then we paused LWPs momentarily, and may
+	     now have pending events to handle.  */
+	  int new_pending;
+
+	  if (debug_linux_nat)
+	    {
+	      fprintf_unfiltered (gdb_stdlog,
+				  "LLW: waitpid %ld received %s\n",
+				  (long) lwpid, status_to_str (status));
+	    }
+
+	  lp = linux_nat_filter_event (lwpid, status, &new_pending);
+
+	  /* STATUS is now no longer valid, use LP->STATUS instead.  */
+	  status = 0;
+
+	  if (lp && !ptid_match (lp->ptid, ptid))
+	    {
+	      gdb_assert (lp->resumed);
+
+	      if (debug_linux_nat)
+		fprintf (stderr,
+			 "LWP %ld got an event %06x, leaving pending.\n",
+			 ptid_get_lwp (lp->ptid), lp->status);
+
+	      if (WIFSTOPPED (lp->status))
+		{
+		  if (WSTOPSIG (lp->status) != SIGSTOP)
+		    {
+		      /* Cancel breakpoint hits.  The breakpoint may
+			 be removed before we fetch events from this
 			 process to report to the core.  It is best
 			 not to assume the moribund breakpoints
 			 heuristic always handles these cases --- it
@@ -3381,6 +5820,7 @@ retry:
 		  /* Store the pending event in the waitstatus as
 		     well, because W_EXITCODE(0,0) == 0.  */
 		  store_waitstatus (&lp->waitstatus, lp->status);
+		  mark_lwp_pending (lp);
 		}
 
 	      /* Keep looking.  */
@@ -3492,6 +5932,23 @@ retry:
 	  goto retry;
 	}
 
+      /* Likewise, don't report tracepoint hits, single-steps within
+	 the range the core asked us to step, nor breakpoint hits whose
+	 target-side condition is false.  */
+      if (linux_nat_tracepoint_trap (lp, &status))
+	goto retry;
+
+      if (linux_nat_range_step (lp, status))
+	goto retry;
+
+      if (linux_nat_skip_false_condition (lp, status))
+	goto retry;
+
+      /* Nor faults on pages we write-protected to implement
+	 watchpoints, unless they hit a watchpoint.  */
+      if (linux_nat_page_watch_fault (lp, &status))
+	goto retry;
+
       if (!non_stop)
 	{
 	  /* Only do the below in all-stop, as we currently use SIGINT
@@ -3541,6 +5998,8 @@ retry:
 	 See the comment in cancel_breakpoints_callback to find out
 	 why.  */
       iterate_over_lwps (minus_one_ptid, cancel_breakpoints_callback, lp);
+      if (lwp_tracepoints != NULL)
+	iterate_over_lwps (minus_one_ptid, cancel_tracepoint_trap_callback, lp);
 
       /* We'll need this to determine whether to report a SIGSTOP as
 	 TARGET_WAITKIND_0.  Need to take a copy because
@@ -3828,7 +6287,11 @@ linux_nat_mourn_inferior (struct target_ops *ops)
 {
   int pid = ptid_get_pid (inferior_ptid);
 
+  close_proc_mem_file ();
   purge_lwp_list (pid);
+  forget_cond_breakpoints (pid, (CORE_ADDR) -1);
+  forget_page_watches (pid);
+  forget_tracepoints (pid);
 
   if (! forks_exist_p ())
     /* Normal case, no other forks available.  */
@@ -3937,7 +6400,29 @@ linux_nat_xfer_partial (struct target_ops *ops, enum target_object object,
   if (object == TARGET_OBJECT_MEMORY && ptid_equal (inferior_ptid, null_ptid))
     return 0;
 
-  old_chain = save_inferior_ptid ();
+  if (object == TARGET_OBJECT_MEMORY && get_traceframe_number () != -1
+      && lwp_traceframes != NULL)
+    {
+      if (writebuf != NULL)
+	error (_("Cannot change memory while looking at trace frames."));
+      return lwp_traceframe_read_memory (readbuf, offset, len);
+    }
+
+  /* Writes must not overwrite the tracepoint traps.  */
+  old_chain = make_cleanup (null_cleanup, NULL);
+  if (object == TARGET_OBJECT_MEMORY && writebuf != NULL
+      && lwp_tracepoints != NULL)
+    {
+      gdb_byte *copy = hide_tracepoint_traps (NULL, writebuf, offset, len);
+
+      if (copy != NULL)
+	{
+	  make_cleanup (xfree, copy);
+	  writebuf = copy;
+	}
+    }
+
+  save_inferior_ptid ();
 
   if (ptid_lwp_p (inferior_ptid))
     inferior_ptid = pid_to_ptid (ptid_get_lwp (inferior_ptid));
@@ -3946,6 +6431,12 @@ linux_nat_xfer_partial (struct target_ops *ops, enum target_object object,
 				     offset, len);
 
   do_cleanups (old_chain);
+
+  /* Reads must not see them.  */
+  if (object == TARGET_OBJECT_MEMORY && readbuf != NULL && xfer > 0
+      && lwp_tracepoints != NULL)
+    hide_tracepoint_traps (readbuf, NULL, offset, xfer);
+
   return xfer;
 }
 
@@ -4108,10 +6599,142 @@ linux_nat_make_corefile_notes (bfd *obfd, int *note_size)
 				    linux_nat_collect_thread_registers);
 }
 
-/* Implement the to_xfer_partial interface for memory reads using the /proc
-   filesystem.  Because we can use a single read() call for /proc, this
-   can be much more efficient than banging away at PTRACE_PEEKTEXT,
-   but it doesn't support writes.  */
+/* The /proc/PID/mem file kept open by linux_proc_xfer_partial, or -1,
+   and the PID it was opened for.  */
+
+static int proc_mem_fd = -1;
+static int proc_mem_pid;
+
+/* Close the /proc/PID/mem file kept open, if any.  */
+
+static void
+close_proc_mem_file (void)
+{
+  if (proc_mem_fd != -1)
+    {
+      close (proc_mem_fd);
+      proc_mem_fd = -1;
+    }
+}
+
+/* Return a file descriptor for reading /proc/PID/mem, or -1.  The file
+   is kept open for later calls for the same PID.  */
+
+static int
+open_proc_mem_file (int pid)
+{
+  char filename[64];
+
+  if (proc_mem_fd != -1 && proc_mem_pid == pid)
+    return proc_mem_fd;
+
+  close_proc_mem_file ();
+  xsnprintf (filename, sizeof filename, "/proc/%d/mem", pid);
+  proc_mem_fd = gdb_open_cloexec (filename, O_RDONLY | O_LARGEFILE, 0);
+  proc_mem_pid = pid;
+  return proc_mem_fd;
+}
+
+/* Read LEN bytes at OFFSET of the /proc/PID/mem file FD into READBUF.
+   Return nonzero if all of them could be read.  */
+
+static int
+read_proc_mem_file (int fd, gdb_byte *readbuf, ULONGEST offset, LONGEST len)
+{
+  /* If pread64 is available, use it.  It's faster if the kernel
+     supports it (only one syscall), and it's 64-bit safe even on
+     32-bit platforms (for instance, SPARC debugging a SPARC64
+     application).  */
+#ifdef HAVE_PREAD64
+  return pread64 (fd, readbuf, len, offset) == len;
+#else
+  return lseek (fd, offset, SEEK_SET) != -1 && read (fd, readbuf, len) == len;
+#endif
+}
+
+#ifdef HAVE_PROCESS_VM_READV
+
+/* Nonzero if the kernel does not provide process_vm_readv and
+   process_vm_writev.  */
+
+static int process_vm_unsupported;
+
+/* The most pages transferred by one process_vm_readv or
+   process_vm_writev call.  */
+
+#define PROCESS_VM_MAX_PAGES 256
+
+/* Transfer LEN bytes at OFFSET in the address space of process PID to
+   READBUF, or from WRITEBUF, with a single process_vm_readv or
+   process_vm_writev call.  The remote range is split into one iovec
+   per page: these calls never split an iovec, so this lets a transfer
+   stop at the first page that cannot be accessed instead of failing as
+   a whole.  Return the number of bytes transferred, which may be less
+   than LEN, or 0 if nothing could be.  */
+
+static LONGEST
+linux_process_vm_xfer (int pid, gdb_byte *readbuf, const gdb_byte *writebuf,
+		       ULONGEST offset, LONGEST len)
+{
+  static ULONGEST page_size;
+  struct iovec local, remote[PROCESS_VM_MAX_PAGES];
+  unsigned long count = 0;
+  ULONGEST addr = offset;
+  ULONGEST end = offset + len;
+  ssize_t ret;
+
+  if (process_vm_unsupported)
+    return 0;
+
+  if (page_size == 0)
+    page_size = sysconf (_SC_PAGESIZE);
+
+  while (addr < end && count < PROCESS_VM_MAX_PAGES)
+    {
+      ULONGEST next = (addr & ~(page_size - 1)) + page_size;
+
+      if (next > end || next < addr)
+	next = end;
+      remote[count].iov_base = (void *) (uintptr_t) addr;
+      remote[count].iov_len = next - addr;
+      count++;
+      addr = next;
+    }
+
+  local.iov_len = addr - offset;
+  if (readbuf != NULL)
+    {
+      local.iov_base = readbuf;
+      ret = process_vm_readv (pid, &local, 1, remote, count, 0);
+    }
+  else
+    {
+#ifdef HAVE_PROCESS_VM_WRITEV
+      local.iov_base = (void *) writebuf;
+      ret = process_vm_writev (pid, &local, 1, remote, count, 0);
+#else
+      return 0;
+#endif
+    }
+
+  if (ret == -1)
+    {
+      if (errno == ENOSYS)
+	process_vm_unsupported = 1;
+      return 0;
+    }
+
+  return ret;
+}
+
+#endif /* HAVE_PROCESS_VM_READV */
+
+/* Implement the to_xfer_partial interface for memory transfers using
+   process_vm_readv and process_vm_writev where the kernel has them,
+   or else for reads using the /proc filesystem.  Because either needs
+   only one system call, this can be much more efficient than banging
+   away at PTRACE_PEEKTEXT.  Writes to memory the inferior cannot write
+   itself, such as breakpoints in its code, are left to ptrace.  */
 
 static LONGEST
 linux_proc_xfer_partial (struct target_ops *ops, enum target_object object,
@@ -4119,39 +6742,46 @@ linux_proc_xfer_partial (struct target_ops *ops, enum target_object object,
 			 const gdb_byte *writebuf,
 			 ULONGEST offset, LONGEST len)
 {
-  LONGEST ret;
+  int pid;
   int fd;
-  char filename[64];
 
-  if (object != TARGET_OBJECT_MEMORY || !readbuf)
+  if (object != TARGET_OBJECT_MEMORY)
     return 0;
 
   /* Don't bother for one word.  */
   if (len < 3 * sizeof (long))
     return 0;
 
-  /* We could keep this file open and cache it - possibly one per
-     thread.  That requires some juggling, but is even faster.  */
-  sprintf (filename, "/proc/%d/mem", ptid_get_pid (inferior_ptid));
-  fd = gdb_open_cloexec (filename, O_RDONLY | O_LARGEFILE, 0);
+  pid = ptid_get_pid (inferior_ptid);
+
+#ifdef HAVE_PROCESS_VM_READV
+  {
+    LONGEST xfer = linux_process_vm_xfer (pid, readbuf, writebuf,
+					  offset, len);
+
+    if (xfer != 0)
+      return xfer;
+  }
+#endif
+
+  if (!readbuf)
+    return 0;
+
+  fd = open_proc_mem_file (pid);
   if (fd == -1)
     return 0;
+  if (read_proc_mem_file (fd, readbuf, offset, len))
+    return len;
 
-  /* If pread64 is available, use it.  It's faster if the kernel
-     supports it (only one syscall), and it's 64-bit safe even on
-     32-bit platforms (for instance, SPARC debugging a SPARC64
-     application).  */
-#ifdef HAVE_PREAD64
-  if (pread64 (fd, readbuf, len, offset) != len)
-#else
-  if (lseek (fd, offset, SEEK_SET) == -1 || read (fd, readbuf, len) != len)
-#endif
-    ret = 0;
-  else
-    ret = len;
+  /* The file kept open may be for an address space the process has
+     since replaced by exec'ing, or for an earlier process with the same
+     PID.  Try again with a fresh one.  */
+  close_proc_mem_file ();
+  fd = open_proc_mem_file (pid);
+  if (fd != -1 && read_proc_mem_file (fd, readbuf, offset, len))
+    return len;
 
-  close (fd);
-  return ret;
+  return 0;
 }
 
 
@@ -4837,6 +7467,14 @@ linux_nat_add_target (struct target_ops *t)
   t->to_thread_address_space = linux_nat_thread_address_space;
   t->to_stopped_by_watchpoint = linux_nat_stopped_by_watchpoint;
   t->to_stopped_data_address = linux_nat_stopped_data_address;
+  t->to_insert_breakpoint = linux_nat_insert_breakpoint;
+  t->to_remove_breakpoint = linux_nat_remove_breakpoint;
+  t->to_supports_evaluation_of_breakpoint_conditions
+    = linux_nat_supports_evaluation_of_breakpoint_conditions;
+  t->to_can_use_hw_breakpoint = linux_nat_can_use_hw_breakpoint;
+  t->to_region_ok_for_hw_watchpoint = linux_nat_region_ok_for_watchpoint;
+  t->to_insert_watchpoint = linux_nat_insert_watchpoint;
+  t->to_remove_watchpoint = linux_nat_remove_watchpoint;
 
   t->to_can_async_p = linux_nat_can_async_p;
   t->to_is_async_p = linux_nat_is_async_p;
@@ -4856,6 +7494,28 @@ linux_nat_add_target (struct target_ops *t)
 
   t->to_core_of_thread = linux_nat_core_of_thread;
 
+  /* Methods for tracing.  */
+  t->to_fetch_registers = linux_nat_fetch_registers;
+  t->to_store_registers = linux_nat_store_registers;
+  t->to_trace_init = linux_nat_trace_init;
+  t->to_download_tracepoint = linux_nat_download_tracepoint;
+  t->to_can_download_tracepoint = linux_nat_can_download_tracepoint;
+  t->to_download_trace_state_variable
+    = linux_nat_download_trace_state_variable;
+  t->to_enable_tracepoint = linux_nat_enable_tracepoint;
+  t->to_disable_tracepoint = linux_nat_disable_tracepoint;
+  t->to_supports_enable_disable_tracepoint
+    = linux_nat_supports_enable_disable_tracepoint;
+  t->to_trace_set_readonly_regions = linux_nat_trace_set_readonly_regions;
+  t->to_trace_start = linux_nat_trace_start;
+  t->to_get_trace_status = linux_nat_get_trace_status;
+  t->to_get_tracepoint_status = linux_nat_get_tracepoint_status;
+  t->to_trace_stop = linux_nat_trace_stop;
+  t->to_trace_find = linux_nat_trace_find;
+  t->to_get_raw_trace_data = linux_nat_get_raw_trace_data;
+  t->to_set_trace_buffer_size = linux_nat_set_trace_buffer_size;
+  t->to_traceframe_info = linux_nat_traceframe_info;
+
   /* We don't change the stratum; this target will sit at
      process_stratum and thread_db will set at thread_stratum.  This
      is a little strange, since this is a multi-threaded-capable
@@ -4930,6 +7590,16 @@ linux_nat_set_prepare_to_resume (struct target_ops *t,
 
 /* See linux-nat.h.  */
 
+void
+linux_nat_set_inferior_mprotect (struct target_ops *t,
+				 linux_nat_inferior_mprotect_ftype *fn)
+{
+  /* Save the pointer.  */
+  linux_nat_inferior_mprotect = fn;
+}
+
+/* See linux-nat.h.  */
+
 int
 linux_nat_get_siginfo (ptid_t ptid, siginfo_t *siginfo)
 {
@@ -4964,6 +7634,17 @@ Enables printf debugging output."),
 			     show_debug_linux_nat,
 			     &setdebuglist, &showdebuglist);
 
+  add_setshow_boolean_cmd ("can-use-page-watchpoints", class_support,
+			   &can_use_page_watchpoints, _("\
+Set whether to use page protection for watchpoints."), _("\
+Show whether to use page protection for watchpoints."), _("\
+When on, write watchpoints that the debug registers cannot hold are\n\
+implemented by write-protecting the pages they watch, instead of\n\
+single-stepping the program."),
+			   NULL,
+			   show_can_use_page_watchpoints,
+			   &setlist, &showlist);
+
   /* Save this mask as the default.  */
   sigprocmask (SIG_SETMASK, NULL, &normal_mask);
 
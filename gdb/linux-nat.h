@@ -62,6 +62,12 @@ struct lwp_info
   /* Non-zero if we were stepping this LWP.  */
   int step;
 
+  /* If we were stepping this LWP, and these differ, the range of
+     addresses, [STEP_RANGE_START, STEP_RANGE_END), we keep stepping it
+     in without reporting the steps to the core.  */
+  CORE_ADDR step_range_start;
+  CORE_ADDR step_range_end;
+
   /* STOPPED_BY_WATCHPOINT is non-zero if this LWP stopped with a data
      watchpoint trap.  */
   int stopped_by_watchpoint;
@@ -74,6 +80,11 @@ struct lwp_info
   int stopped_data_address_p;
   CORE_ADDR stopped_data_address;
 
+  /* If not zero, the address of the tracepoints whose trace frames we
+     collected when this LWP hit them, and that the core has yet to
+     step over because it has a breakpoint there too.  */
+  CORE_ADDR tracepoint_collected_at;
+
   /* Non-zero if we expect a duplicated SIGINT.  */
   int ignore_sigint;
 
@@ -95,6 +106,11 @@ struct lwp_info
   /* Arch-specific additions.  */
   struct arch_lwp_info *arch_private;
 
+  /* Non-zero if this LWP is on the chain of LWPs that may have a
+     pending status, linked through PENDING_NEXT.  */
+  int pending_listed;
+  struct lwp_info *pending_next;
+
   /* Next LWP in list.  */
   struct lwp_info *next;
 };
@@ -178,6 +194,24 @@ void linux_nat_set_siginfo_fixup (struct target_ops *,
 void linux_nat_set_prepare_to_resume (struct target_ops *,
 				      void (*) (struct lwp_info *));
 
+/* Register a method that makes the stopped LWP LP call mprotect on
+   the LEN bytes at ADDR with protection PROT, and returns 0 if the
+   call succeeded, or -1 otherwise.  The LWP's registers and memory
+   must be left as they were.  Write watchpoints that the debug
+   registers cannot hold are implemented with page protection when
+   this is set.  */
+typedef int (linux_nat_inferior_mprotect_ftype) (struct lwp_info *lp,
+						 CORE_ADDR addr,
+						 ULONGEST len, int prot);
+void linux_nat_set_inferior_mprotect (struct target_ops *,
+				      linux_nat_inferior_mprotect_ftype *);
+
+/* Single-step the stopped LWP LP by one instruction, delivering no
+   signal, and return the wait status, or 0 if LP could not be
+   stepped.  A SIGSTOP we sent LP earlier is swallowed, and any other
+   signal that arrives first is sent again once the step is done.  */
+int linux_nat_step_lwp (struct lwp_info *lp);
+
 /* Update linux-nat internal state when changing from one fork
    to another.  */
 void linux_nat_switch_fork (ptid_t new_ptid);
@@ -1657,6 +1657,72 @@ find_new_threads_once (struct thread_db_info *info, int iteration,
   return data.new_threads;
 }
 
+/* Callback for linux_proc_iterate_tasks.  Ask libthread_db about
+   LWPID only if we do not know its thread handle yet.  */
+
+static int
+find_new_lwp_callback (pid_t lwpid, void *data)
+{
+  struct callback_data *cb_data = data;
+  struct thread_db_info *info = cb_data->info;
+  struct thread_info *tp;
+  td_thrhandle_t th;
+  td_err_e err;
+
+  tp = find_thread_ptid (ptid_build (info->pid, lwpid, 0));
+  if (tp != NULL && tp->private != NULL && !tp->private->dying)
+    return 0;
+
+  /* Just in case td_ta_map_lwp2thr doesn't initialize it completely.  */
+  th.th_unique = 0;
+
+  err = info->td_ta_map_lwp2thr_p (info->thread_agent, lwpid, &th);
+  if (err != TD_OK)
+    /* Not a user-level thread yet.  */
+    return 0;
+
+  find_new_threads_callback (&th, data);
+  return 0;
+}
+
+/* Helper for thread_db_find_new_threads_2.  Like
+   find_new_threads_once, but enumerate the LWPs of the process from
+   /proc/PID/task, which is much cheaper than having libthread_db read
+   every thread descriptor out of the inferior.  Returns the number of
+   new threads found, or -1 if the LWPs could not be listed.  */
+
+static int
+find_new_lwps_once (struct thread_db_info *info)
+{
+  volatile struct gdb_exception except;
+  struct callback_data data;
+  int ret = 0;
+
+  data.info = info;
+  data.new_threads = 0;
+
+  TRY_CATCH (except, RETURN_MASK_ERROR)
+    {
+      ret = linux_proc_iterate_tasks (info->pid, find_new_lwp_callback,
+				      &data);
+    }
+
+  if (libthread_db_debug)
+    {
+      if (except.reason < 0)
+	exception_fprintf (gdb_stderr, except,
+			   "Warning: find_new_lwps_once: ");
+
+      printf_filtered (_("Found %d new threads in /proc.\n"),
+		       data.new_threads);
+    }
+
+  if (ret < 0)
+    return -1;
+
+  return data.new_threads;
+}
+
 /* Search for new threads, accessing memory through stopped thread
    PTID.  If UNTIL_NO_NEW is true, repeat searching until several
    searches in a row do not discover any new threads.  */
@@ -1686,7 +1752,7 @@ thread_db_find_new_threads_2 (ptid_t ptid, int until_no_new)
 	    loop = -1;
 	  }
     }
-  else
+  else if (!target_has_execution || find_new_lwps_once (info) < 0)
     find_new_threads_once (info, 0, &err);
 
   if (err != TD_OK)
@@ -75,6 +75,17 @@ struct macro_table
      strings are all allocated in bcache, if non-zero, or with xmalloc
      otherwise.  */
   splay_tree definitions;
+
+  /* If non-zero, a function to call to fill in the table the first
+     time its contents are needed, and its argument; see
+     macro_set_reader.  */
+  void (*read) (struct macro_table *table, void *baton);
+  void *read_baton;
+
+  /* The number of bytes allocated with macro_alloc for this table,
+     including the table itself.  Strings held in the bcache are not
+     counted here.  */
+  size_t memory_used;
 };
 
 
@@ -87,6 +98,7 @@ struct macro_table
 static void *
 macro_alloc (int size, struct macro_table *t)
 {
+  t->memory_used += size;
   if (t->obstack)
     return obstack_alloc (t->obstack, size);
   else
@@ -430,9 +442,37 @@ macro_set_main (struct macro_table *t,
 }
 
 
+void
+macro_set_reader (struct macro_table *t,
+		  void (*read) (struct macro_table *table, void *baton),
+		  void *baton)
+{
+  t->read = read;
+  t->read_baton = baton;
+}
+
+
+/* Fill in T if its contents have not been read yet.  */
+
+static void
+macro_read_table (struct macro_table *t)
+{
+  void (*read) (struct macro_table *, void *) = t->read;
+
+  if (read != NULL)
+    {
+      /* Clear the reader first, so that the table is read only once,
+	 even if reading it fails.  */
+      t->read = NULL;
+      read (t, t->read_baton);
+    }
+}
+
+
 struct macro_source_file *
 macro_main (struct macro_table *t)
 {
+  macro_read_table (t);
   gdb_assert (t->main_source);
 
   return t->main_source;
@@ -996,6 +1036,8 @@ macro_for_each (struct macro_table *table, macro_callback_fn fn,
 {
   struct macro_for_each_data datum;
 
+  macro_read_table (table);
+
   datum.fn = fn;
   datum.user_data = user_data;
   datum.file = NULL;
@@ -1066,6 +1108,7 @@ new_macro_table (struct obstack *obstack, struct bcache *b,
   t->main_source = NULL;
   t->comp_dir = comp_dir;
   t->redef_ok = 0;
+  t->memory_used = sizeof (*t);
   t->definitions = (splay_tree_new_with_allocator
                     (macro_tree_compare,
                      ((splay_tree_delete_key_fn) macro_tree_delete_key),
@@ -1090,6 +1133,14 @@ free_macro_table (struct macro_table *table)
 
 /* See macrotab.h for the comment.  */
 
+size_t
+macro_table_memory_used (struct macro_table *table)
+{
+  return table->memory_used;
+}
+
+/* See macrotab.h for the comment.  */
+
 char *
 macro_source_fullname (struct macro_source_file *file)
 {
@@ -177,6 +177,13 @@ struct macro_table *new_macro_table (struct obstack *obstack,
 void free_macro_table (struct macro_table *table);
 
 
+/* Return the number of bytes TABLE has allocated for its own
+   structures: source files, definitions and the splay tree holding
+   them.  Names and definition strings kept in the table's bcache are
+   accounted to that bcache instead.  */
+size_t macro_table_memory_used (struct macro_table *table);
+
+
 /* Set FILENAME as the main source file of TABLE.  Return a source
    file structure describing that file; if we record the #definition
    of macros, or the #inclusion of other files into FILENAME, we'll
@@ -195,6 +202,15 @@ struct macro_source_file *macro_set_main (struct macro_table *table,
 /* Return the main source file of the macro table TABLE.  */
 struct macro_source_file *macro_main (struct macro_table *table);
 
+/* Arrange for READ to be called with TABLE and BATON to fill in TABLE
+   the first time its contents are needed, that is by macro_main or
+   macro_for_each.  This lets a symbol reader defer reading the macros
+   of a compilation unit until they are used.  READ is called at most
+   once, and it must call macro_set_main.  */
+void macro_set_reader (struct macro_table *table,
+		       void (*read) (struct macro_table *table, void *baton),
+		       void *baton);
+
 /* Mark the macro table TABLE so that macros defined in this table can
    be redefined without error.  Note that it invalid to call this if
    TABLE is allocated on an obstack.  */
@@ -359,6 +359,7 @@ captured_main (void *data)
 #endif
 
   pre_stat_chain = make_command_stats_cleanup (0);
+  make_profile_phase_cleanup ("startup", NULL);
 
 #if defined (HAVE_SETLOCALE) && defined (HAVE_LC_MESSAGES)
   setlocale (LC_MESSAGES, "");
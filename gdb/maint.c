@@ -42,10 +42,13 @@
 #include "top.h"
 #include "timeval-utils.h"
 #include "maint.h"
+#include "remote.h"
 
 #include "cli/cli-decode.h"
 #include "cli/cli-utils.h"
 #include "cli/cli-setshow.h"
+#include "completer.h"
+#include "readline/tilde.h"
 
 extern void _initialize_maint_cmds (void);
 
@@ -406,6 +409,16 @@ maintenance_info_sections (char *arg, int from_tty)
 static void
 maintenance_print_statistics (char *args, int from_tty)
 {
+  if (args != NULL
+      && check_for_argument (&args, "-json", sizeof ("-json") - 1))
+    {
+      args = skip_spaces (args);
+      if (*args != '\0')
+	error (_("Junk at end of arguments."));
+      print_objfile_statistics_json ();
+      return;
+    }
+
   print_objfile_statistics ();
   print_symbol_bcache_statistics ();
 }
@@ -746,6 +759,10 @@ static int per_command_space;
 
 static int per_command_symtab;
 
+/* If nonzero, display remote protocol traffic stats for each command.  */
+
+static int per_command_remote;
+
 /* mt per-command commands.  */
 
 static struct cmd_list_element *per_command_setlist;
@@ -765,6 +782,7 @@ struct cmd_stats
   int time_enabled : 1;
   int space_enabled : 1;
   int symtab_enabled : 1;
+  int remote_enabled : 1;
   long start_cpu_time;
   struct timeval start_wall_time;
   long start_space;
@@ -774,6 +792,11 @@ struct cmd_stats
   int start_nr_primary_symtabs;
   /* Total number of blocks.  */
   int start_nr_blocks;
+  /* Remote protocol totals, see remote_get_packet_totals.  */
+  ULONGEST start_remote_packets;
+  ULONGEST start_remote_bytes_sent;
+  ULONGEST start_remote_bytes_received;
+  ULONGEST start_remote_usecs;
 };
 
 /* Set whether to display time statistics to NEW_VALUE
@@ -885,6 +908,30 @@ report_command_stats (void *arg)
 			 nr_blocks,
 			 nr_blocks - start_stats->start_nr_blocks);
     }
+
+  if (start_stats->remote_enabled)
+    {
+      ULONGEST packets, bytes_sent, bytes_received, usecs;
+
+      remote_get_packet_totals (&packets, &bytes_sent, &bytes_received,
+				&usecs);
+      usecs -= start_stats->start_remote_usecs;
+      printf_unfiltered (_("#remote packets: %s (+%s),"
+			   " bytes sent: %s (+%s),"
+			   " bytes received: %s (+%s),"
+			   " reply wait time: %s.%06ld\n"),
+			 pulongest (packets),
+			 pulongest (packets
+				    - start_stats->start_remote_packets),
+			 pulongest (bytes_sent),
+			 pulongest (bytes_sent
+				    - start_stats->start_remote_bytes_sent),
+			 pulongest (bytes_received),
+			 pulongest (bytes_received
+				    - start_stats->start_remote_bytes_received),
+			 pulongest (usecs / 1000000),
+			 (long) (usecs % 1000000));
+    }
 }
 
 /* Create a cleanup that reports time and space used since its creation.
@@ -899,7 +946,8 @@ make_command_stats_cleanup (int msg_type)
   /* Early exit if we're not reporting any stats.  */
   if (!per_command_time
       && !per_command_space
-      && !per_command_symtab)
+      && !per_command_symtab
+      && !per_command_remote)
     return make_cleanup (null_cleanup, 0);
 
   new_stat = XZALLOC (struct cmd_stats);
@@ -933,12 +981,272 @@ make_command_stats_cleanup (int msg_type)
       new_stat->symtab_enabled = 1;
     }
 
+  if (per_command_remote)
+    {
+      remote_get_packet_totals (&new_stat->start_remote_packets,
+				&new_stat->start_remote_bytes_sent,
+				&new_stat->start_remote_bytes_received,
+				&new_stat->start_remote_usecs);
+      new_stat->remote_enabled = 1;
+    }
+
   /* Initalize timer to keep track of how long we waited for the user.  */
   reset_prompt_for_continue_wait_time ();
 
   return make_cleanup_dtor (report_command_stats, new_stat, xfree);
 }
 
+/* A node in the tree of profiled phases.  Each node accumulates the
+   resources used by every execution of one phase, for instance
+   reading the symbols of one objfile, within one parent phase.  */
+
+struct profile_phase
+{
+  /* The name of the phase.  This is not copied.  */
+  const char *name;
+
+  /* What the phase worked on, such as an objfile name, or NULL.  */
+  char *detail;
+
+  /* The number of completed executions of the phase.  */
+  unsigned long count;
+
+  /* Run time and wall time spent in the phase, including the time
+     spent in its sub-phases.  */
+  long cpu_time;
+  struct timeval wall_time;
+
+  /* Growth of the heap while in the phase.  */
+  long space;
+
+  /* The enclosing phase.  */
+  struct profile_phase *parent;
+
+  /* The sub-phases, in order of first execution.  */
+  struct profile_phase *children;
+
+  /* The next phase with the same parent.  */
+  struct profile_phase *next;
+};
+
+/* The root of the tree of profiled phases.  It is never executed
+   itself.  */
+
+static struct profile_phase profile_root;
+
+/* The phase being executed.  */
+
+static struct profile_phase *current_profile_phase = &profile_root;
+
+/* The state saved on entry to a phase, used as a cleanup argument.  */
+
+struct profile_phase_start
+{
+  struct profile_phase *phase;
+  long start_cpu_time;
+  struct timeval start_wall_time;
+  long start_space;
+};
+
+/* Return the current size of GDB's heap, or zero if it cannot be
+   measured.  */
+
+static long
+profile_heap_size (void)
+{
+#ifdef HAVE_SBRK
+  return (char *) sbrk (0) - lim_at_start;
+#else
+  return 0;
+#endif
+}
+
+/* Return the sub-phase of PARENT called NAME working on DETAIL,
+   creating it if needed.  */
+
+static struct profile_phase *
+find_profile_phase (struct profile_phase *parent, const char *name,
+		    const char *detail)
+{
+  struct profile_phase *phase, **link;
+
+  for (link = &parent->children; *link != NULL; link = &(*link)->next)
+    {
+      phase = *link;
+      if (strcmp (phase->name, name) == 0
+	  && (phase->detail == NULL
+	      ? detail == NULL
+	      : detail != NULL && strcmp (phase->detail, detail) == 0))
+	return phase;
+    }
+
+  phase = XCNEW (struct profile_phase);
+  phase->name = name;
+  phase->detail = detail != NULL ? xstrdup (detail) : NULL;
+  phase->parent = parent;
+  *link = phase;
+  return phase;
+}
+
+/* Account the resources used since the phase described by ARG, a
+   struct profile_phase_start, was entered, and make its parent the
+   current phase again.  */
+
+static void
+end_profile_phase (void *arg)
+{
+  struct profile_phase_start *start = arg;
+  struct profile_phase *phase = start->phase;
+  struct timeval now_wall_time, delta_wall_time;
+
+  gettimeofday (&now_wall_time, NULL);
+  timeval_sub (&delta_wall_time, &now_wall_time, &start->start_wall_time);
+  timeval_add (&phase->wall_time, &phase->wall_time, &delta_wall_time);
+  phase->cpu_time += get_run_time () - start->start_cpu_time;
+  phase->space += profile_heap_size () - start->start_space;
+  phase->count++;
+
+  current_profile_phase = phase->parent;
+}
+
+/* See maint.h.  */
+
+struct cleanup *
+make_profile_phase_cleanup (const char *name, const char *detail)
+{
+  struct profile_phase_start *start = XNEW (struct profile_phase_start);
+
+  start->phase = find_profile_phase (current_profile_phase, name, detail);
+  current_profile_phase = start->phase;
+
+  start->start_space = profile_heap_size ();
+  start->start_cpu_time = get_run_time ();
+  gettimeofday (&start->start_wall_time, NULL);
+
+  return make_cleanup_dtor (end_profile_phase, start, xfree);
+}
+
+/* Print the string STR to FILE as a JSON string literal.  */
+
+static void
+print_json_string (struct ui_file *file, const char *str)
+{
+  fputc_unfiltered ('"', file);
+  for (; *str != '\0'; str++)
+    {
+      if (*str == '"' || *str == '\\')
+	fprintf_unfiltered (file, "\\%c", *str);
+      else if ((unsigned char) *str < 0x20)
+	fprintf_unfiltered (file, "\\u%04x", (unsigned char) *str);
+      else
+	fputc_unfiltered (*str, file);
+    }
+  fputc_unfiltered ('"', file);
+}
+
+/* Print the sub-phases of PARENT to FILE as the elements of a JSON
+   array, indented by DEPTH levels.  */
+
+static void
+print_profile_phases (struct ui_file *file, struct profile_phase *parent,
+		      int depth)
+{
+  struct profile_phase *phase;
+
+  for (phase = parent->children; phase != NULL; phase = phase->next)
+    {
+      fprintf_unfiltered (file, "%*s{\"name\": ", depth * 2, "");
+      print_json_string (file, phase->name);
+      if (phase->detail != NULL)
+	{
+	  fprintf_unfiltered (file, ", \"detail\": ");
+	  print_json_string (file, phase->detail);
+	}
+      fprintf_unfiltered (file, ", \"count\": %lu", phase->count);
+      fprintf_unfiltered (file, ", \"cpu\": %ld.%06ld",
+			  phase->cpu_time / 1000000,
+			  phase->cpu_time % 1000000);
+      fprintf_unfiltered (file, ", \"wall\": %ld.%06ld",
+			  (long) phase->wall_time.tv_sec,
+			  (long) phase->wall_time.tv_usec);
+      fprintf_unfiltered (file, ", \"space\": %ld", phase->space);
+      if (phase->children != NULL)
+	{
+	  fprintf_unfiltered (file, ",\n%*s \"phases\": [\n",
+			      depth * 2, "");
+	  print_profile_phases (file, phase, depth + 1);
+	  fprintf_unfiltered (file, "%*s]", depth * 2, "");
+	}
+      fprintf_unfiltered (file, "}%s\n", phase->next != NULL ? "," : "");
+    }
+}
+
+/* Clear the statistics of PARENT's sub-phases.  The phases themselves
+   are kept, as some of them may be executing.  */
+
+static void
+reset_profile_phases (struct profile_phase *parent)
+{
+  struct profile_phase *phase;
+
+  for (phase = parent->children; phase != NULL; phase = phase->next)
+    {
+      phase->count = 0;
+      phase->cpu_time = 0;
+      phase->wall_time.tv_sec = 0;
+      phase->wall_time.tv_usec = 0;
+      phase->space = 0;
+      reset_profile_phases (phase);
+    }
+}
+
+/* The "maintenance profile" command.  */
+
+static struct cmd_list_element *maintenance_profile_list;
+
+static void
+maintenance_profile_command (char *args, int from_tty)
+{
+  printf_unfiltered (_("\"maintenance profile\" must be followed "
+		       "by the name of a profile command.\n"));
+  help_list (maintenance_profile_list, "maintenance profile ", -1,
+	     gdb_stdout);
+}
+
+/* The "maintenance profile dump" command.  */
+
+static void
+maintenance_profile_dump (char *args, int from_tty)
+{
+  struct ui_file *file = gdb_stdout;
+  struct cleanup *cleanups = make_cleanup (null_cleanup, NULL);
+
+  if (args != NULL && *args != '\0')
+    {
+      char *filename = tilde_expand (args);
+
+      make_cleanup (xfree, filename);
+      file = gdb_fopen (filename, "w");
+      if (file == NULL)
+	perror_with_name (filename);
+      make_cleanup_ui_file_delete (file);
+    }
+
+  fprintf_unfiltered (file, "{\"phases\": [\n");
+  print_profile_phases (file, &profile_root, 1);
+  fprintf_unfiltered (file, "]}\n");
+
+  do_cleanups (cleanups);
+}
+
+/* The "maintenance profile reset" command.  */
+
+static void
+maintenance_profile_reset (char *args, int from_tty)
+{
+  reset_profile_phases (&profile_root);
+}
+
 /* Handle unknown "mt set per-command" arguments.
    In this case have "mt set per-command on|off" affect every setting.  */
 
@@ -973,6 +1281,8 @@ show_per_command_cmd (char *args, int from_tty)
 void
 _initialize_maint_cmds (void)
 {
+  struct cmd_list_element *c;
+
   add_prefix_cmd ("maintenance", class_maintenance, maintenance_command, _("\
 Commands for use by GDB maintainers.\n\
 Includes commands to dump specific internal GDB structures in\n\
@@ -1046,6 +1356,25 @@ Call internal GDB demangler routine to demangle a C++ link name\n\
 and prints the result."),
 	   &maintenancelist);
 
+  add_prefix_cmd ("profile", class_maintenance, maintenance_profile_command,
+		  _("\
+Commands for GDB's phase profile.\n\
+GDB records the time and space used by phases of its work, such as\n\
+executing a command or reading the symbols of an objfile."),
+		  &maintenance_profile_list, "maintenance profile ", 0,
+		  &maintenancelist);
+
+  c = add_cmd ("dump", class_maintenance, maintenance_profile_dump, _("\
+Print GDB's phase profile in JSON format.\n\
+Usage: maintenance profile dump [FILE]\n\
+Write the profile to FILE if it is given, or else print it."),
+	       &maintenance_profile_list);
+  set_cmd_completer (c, filename_completer);
+
+  add_cmd ("reset", class_maintenance, maintenance_profile_reset, _("\
+Clear GDB's phase profile."),
+	   &maintenance_profile_list);
+
   add_prefix_cmd ("per-command", class_maintenance, set_per_command_cmd, _("\
 Per-command statistics settings."),
 		    &per_command_setlist, "set per-command ",
@@ -1086,6 +1415,17 @@ displayed following the command's output."),
 			   NULL, NULL,
 			   &per_command_setlist, &per_command_showlist);
 
+  add_setshow_boolean_cmd ("remote", class_maintenance,
+			   &per_command_remote, _("\
+Set whether to display per-command remote protocol statistics."), _("\
+Show whether to display per-command remote protocol statistics."),
+			   _("\
+If enabled, the number of remote protocol packets exchanged by each\n\
+command, their size, and the time spent waiting for their replies\n\
+will be displayed following the command's output."),
+			   NULL, NULL,
+			   &per_command_setlist, &per_command_showlist);
+
   /* This is equivalent to "mt set per-command time on".
      Kept because some people are used to typing "mt time 1".  */
   add_cmd ("time", class_maintenance, maintenance_time_display, _("\
@@ -1109,7 +1449,9 @@ the type structure, and the interpretation of the data."),
 	   &maintenanceprintlist);
 
   add_cmd ("statistics", class_maintenance, maintenance_print_statistics,
-	   _("Print statistics about internal gdb state."),
+	   _("Print statistics about internal gdb state.\n\
+With the -json option, print the per-objfile counts and memory usage\n\
+as a JSON object instead."),
 	   &maintenanceprintlist);
 
   add_cmd ("architecture", class_maintenance,
@@ -28,4 +28,13 @@ extern void set_per_command_space (int);
 
 extern struct cleanup *make_command_stats_cleanup (int);
 
+/* Enter the phase NAME of GDB's work, for "maintenance profile".
+   DETAIL, if not NULL, names what the phase works on, such as an
+   objfile; it is copied.  NAME is not copied and must remain valid.
+   The phase ends, and its resource usage is recorded, when the
+   returned cleanup is run.  */
+
+extern struct cleanup *make_profile_phase_cleanup (const char *name,
+						 const char *detail);
+
 #endif /* MAINT_H */
@@ -37,6 +37,8 @@
 #include "gdb.h"
 #include "objfiles.h"
 #include "tracepoint.h"
+#include "gdb_vecs.h"
+#include "gdbcmd.h"
 
 /* These are the interpreter setup, etc. functions for the MI
    interpreter.  */
@@ -321,6 +323,173 @@ mi_command_loop (void *data)
   start_event_loop ();
 }
 
+/* Whether thread, library and breakpoint notifications are batched.
+   Set by "set mi-async-batch".  */
+
+static int mi_async_batch;
+
+/* A thread creation waiting to be reported.  */
+
+typedef struct mi_batched_thread
+{
+  int num;
+  int inferior_num;
+} mi_batched_thread_s;
+
+DEF_VEC_O (mi_batched_thread_s);
+
+/* A library load waiting to be reported.  The names are copied, as
+   the so_list may be gone by the time the batch is flushed.  */
+
+typedef struct mi_batched_solib
+{
+  char *original_name;
+  char *name;
+  int symbols_loaded;
+
+  /* The inferior's number, or -1 if the library list is global.  */
+  int inferior_num;
+} mi_batched_solib_s;
+
+DEF_VEC_O (mi_batched_solib_s);
+
+/* The notifications collected since the last flush.  */
+
+static VEC (mi_batched_thread_s) *mi_batched_threads;
+static VEC (mi_batched_solib_s) *mi_batched_solibs;
+static VEC (int) *mi_batched_breakpoints;
+
+/* Marked when the first notification is added to the batch, so that
+   it is flushed on the next iteration of the event loop even when no
+   stop or command result follows.  */
+
+static struct async_event_handler *mi_async_batch_token;
+
+static void mi_async_batch_handler (gdb_client_data arg);
+
+/* Start collecting a batched notification.  */
+
+static void
+mi_async_batch_mark (void)
+{
+  if (mi_async_batch_token == NULL)
+    mi_async_batch_token
+      = create_async_event_handler (mi_async_batch_handler, NULL);
+
+  if (VEC_empty (mi_batched_thread_s, mi_batched_threads)
+      && VEC_empty (mi_batched_solib_s, mi_batched_solibs)
+      && VEC_empty (int, mi_batched_breakpoints))
+    mark_async_event_handler (mi_async_batch_token);
+}
+
+/* See mi-main.h.  */
+
+void
+mi_async_batch_flush (void)
+{
+  struct mi_interp *mi;
+  struct ui_out *mi_uiout;
+  mi_batched_thread_s *thr;
+  mi_batched_solib_s *lib;
+  int ix, bnum;
+
+  if (VEC_empty (mi_batched_thread_s, mi_batched_threads)
+      && VEC_empty (mi_batched_solib_s, mi_batched_solibs)
+      && VEC_empty (int, mi_batched_breakpoints))
+    return;
+
+  mi = top_level_interpreter_data ();
+  mi_uiout = interp_ui_out (top_level_interpreter ());
+  target_terminal_ours ();
+
+  if (!VEC_empty (mi_batched_thread_s, mi_batched_threads))
+    {
+      fputs_unfiltered ("threads-created,threads=[", mi->event_channel);
+      for (ix = 0;
+	   VEC_iterate (mi_batched_thread_s, mi_batched_threads, ix, thr);
+	   ++ix)
+	fprintf_unfiltered (mi->event_channel,
+			    "%s{id=\"%d\",group-id=\"i%d\"}",
+			    ix > 0 ? "," : "", thr->num, thr->inferior_num);
+      fputs_unfiltered ("]", mi->event_channel);
+      gdb_flush (mi->event_channel);
+      VEC_truncate (mi_batched_thread_s, mi_batched_threads, 0);
+    }
+
+  if (!VEC_empty (mi_batched_solib_s, mi_batched_solibs))
+    {
+      fputs_unfiltered ("libraries-loaded,libraries=[", mi->event_channel);
+      for (ix = 0;
+	   VEC_iterate (mi_batched_solib_s, mi_batched_solibs, ix, lib);
+	   ++ix)
+	{
+	  fprintf_unfiltered (mi->event_channel,
+			      "%s{id=\"%s\",target-name=\"%s\","
+			      "host-name=\"%s\",symbols-loaded=\"%d\"",
+			      ix > 0 ? "," : "",
+			      lib->original_name, lib->original_name,
+			      lib->name, lib->symbols_loaded);
+	  if (lib->inferior_num != -1)
+	    fprintf_unfiltered (mi->event_channel, ",thread-group=\"i%d\"",
+				lib->inferior_num);
+	  fputs_unfiltered ("}", mi->event_channel);
+	  xfree (lib->original_name);
+	  xfree (lib->name);
+	}
+      fputs_unfiltered ("]", mi->event_channel);
+      gdb_flush (mi->event_channel);
+      VEC_truncate (mi_batched_solib_s, mi_batched_solibs, 0);
+    }
+
+  if (!VEC_empty (int, mi_batched_breakpoints))
+    {
+      struct cleanup *list_cleanup;
+
+      /* Each breakpoint is reported as it is now, once, however many
+	 times it was modified.  Breakpoints deleted in the meantime
+	 have already been reported by =breakpoint-deleted, and
+	 gdb_breakpoint_query prints nothing for them.  */
+      fputs_unfiltered ("breakpoints-modified", mi->event_channel);
+      ui_out_redirect (mi_uiout, mi->event_channel);
+      list_cleanup = make_cleanup_ui_out_list_begin_end (mi_uiout, "bkpts");
+      for (ix = 0; VEC_iterate (int, mi_batched_breakpoints, ix, bnum); ++ix)
+	gdb_breakpoint_query (mi_uiout, bnum, NULL);
+      do_cleanups (list_cleanup);
+      ui_out_redirect (mi_uiout, NULL);
+      gdb_flush (mi->event_channel);
+      VEC_truncate (int, mi_batched_breakpoints, 0);
+    }
+}
+
+/* Event loop callback for mi_async_batch_token.  */
+
+static void
+mi_async_batch_handler (gdb_client_data arg)
+{
+  mi_async_batch_flush ();
+}
+
+/* Implement the "set mi-async-batch" command.  Report anything still
+   pending when batching is turned off.  */
+
+static void
+set_mi_async_batch (char *args, int from_tty, struct cmd_list_element *c)
+{
+  if (!mi_async_batch)
+    mi_async_batch_flush ();
+}
+
+/* Implement the "show mi-async-batch" command.  */
+
+static void
+show_mi_async_batch (struct ui_file *file, int from_tty,
+		     struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file,
+		    _("Batching of MI async notifications is %s.\n"),
+		    value);
+}
+
 static void
 mi_new_thread (struct thread_info *t)
 {
@@ -329,6 +498,17 @@ mi_new_thread (struct thread_info *t)
 
   gdb_assert (inf);
 
+  if (mi_async_batch)
+    {
+      mi_batched_thread_s thr;
+
+      mi_async_batch_mark ();
+      thr.num = t->num;
+      thr.inferior_num = inf->num;
+      VEC_safe_push (mi_batched_thread_s, mi_batched_threads, &thr);
+      return;
+    }
+
   fprintf_unfiltered (mi->event_channel, 
 		      "thread-created,id=\"%d\",group-id=\"i%d\"",
 		      t->num, inf->num);
@@ -344,6 +524,8 @@ mi_thread_exit (struct thread_info *t, int silent)
   if (silent)
     return;
 
+  mi_async_batch_flush ();
+
   inf = find_inferior_pid (ptid_get_pid (t->ptid));
 
   mi = top_level_interpreter_data ();
@@ -428,6 +610,8 @@ mi_on_normal_stop (struct bpstats *bs, int print_frame)
      not the current one.  */
   struct ui_out *mi_uiout = interp_ui_out (top_level_interpreter ());
 
+  mi_async_batch_flush ();
+
   if (print_frame)
     {
       int core;
@@ -633,6 +817,7 @@ mi_breakpoint_deleted (struct breakpoint *b)
   if (b->number <= 0)
     return;
 
+  mi_async_batch_flush ();
   target_terminal_ours ();
 
   fprintf_unfiltered (mi->event_channel, "breakpoint-deleted,id=\"%d\"",
@@ -656,6 +841,18 @@ mi_breakpoint_modified (struct breakpoint *b)
   if (b->number <= 0)
     return;
 
+  if (mi_async_batch)
+    {
+      int ix, bnum;
+
+      for (ix = 0; VEC_iterate (int, mi_batched_breakpoints, ix, bnum); ++ix)
+	if (bnum == b->number)
+	  return;
+      mi_async_batch_mark ();
+      VEC_safe_push (int, mi_batched_breakpoints, b->number);
+      return;
+    }
+
   target_terminal_ours ();
   fprintf_unfiltered (mi->event_channel,
 		      "breakpoint-modified");
@@ -713,6 +910,8 @@ mi_on_resume (ptid_t ptid)
   if (tp->control.in_infcall)
     return;
 
+  mi_async_batch_flush ();
+
   /* To cater for older frontends, emit ^running, but do it only once
      per each command.  We do it here, since at this point we know
      that the target was successfully resumed, and in non-async mode,
@@ -770,6 +969,22 @@ mi_solib_loaded (struct so_list *solib)
 {
   struct mi_interp *mi = top_level_interpreter_data ();
 
+  if (mi_async_batch)
+    {
+      mi_batched_solib_s lib;
+
+      mi_async_batch_mark ();
+      lib.original_name = xstrdup (solib->so_original_name);
+      lib.name = xstrdup (solib->so_name);
+      lib.symbols_loaded = solib->symbols_loaded;
+      if (gdbarch_has_global_solist (target_gdbarch ()))
+	lib.inferior_num = -1;
+      else
+	lib.inferior_num = current_inferior ()->num;
+      VEC_safe_push (mi_batched_solib_s, mi_batched_solibs, &lib);
+      return;
+    }
+
   target_terminal_ours ();
   if (gdbarch_has_global_solist (target_gdbarch ()))
     fprintf_unfiltered (mi->event_channel,
@@ -794,6 +1009,7 @@ mi_solib_unloaded (struct so_list *solib)
 {
   struct mi_interp *mi = top_level_interpreter_data ();
 
+  mi_async_batch_flush ();
   target_terminal_ours ();
   if (gdbarch_has_global_solist (target_gdbarch ()))
     fprintf_unfiltered (mi->event_channel,
@@ -973,4 +1189,16 @@ _initialize_mi_interp (void)
   interp_add (interp_new (INTERP_MI2, &procs));
   interp_add (interp_new (INTERP_MI3, &procs));
   interp_add (interp_new (INTERP_MI, &procs));
+
+  add_setshow_boolean_cmd ("mi-async-batch", class_support,
+			   &mi_async_batch, _("\
+Set whether MI async notifications are batched."), _("\
+Show whether MI async notifications are batched."), _("\
+When on, the =thread-created, =library-loaded and =breakpoint-modified\n\
+notifications are collected and reported together, as =threads-created,\n\
+=libraries-loaded and =breakpoints-modified, before the next stop or\n\
+command result is reported, or when GDB next returns to its event loop."),
+			   set_mi_async_batch,
+			   show_mi_async_batch,
+			   &setlist, &showlist);
 }
@@ -1599,6 +1599,7 @@ mi_cmd_data_read_memory_bytes (char *command, char **argv, int argc)
        VEC_iterate (memory_read_result_s, result, ix, read_result);
        ++ix)
     {
+      static const char hex_digits[] = "0123456789abcdef";
       struct cleanup *t = make_cleanup_ui_out_tuple_begin_end (uiout, NULL);
       char *data, *p;
       int i;
@@ -1614,8 +1615,10 @@ mi_cmd_data_read_memory_bytes (char *command, char **argv, int argc)
 	   i < (read_result->end - read_result->begin);
 	   ++i, p += 2)
 	{
-	  sprintf (p, "%02x", read_result->data[i]);
+	  p[0] = hex_digits[read_result->data[i] >> 4];
+	  p[1] = hex_digits[read_result->data[i] & 0xf];
 	}
+      *p = '\0';
       ui_out_field_string (uiout, "contents", data);
       xfree (data);
       do_cleanups (t);
@@ -1944,6 +1947,7 @@ captured_mi_execute_command (struct ui_out *uiout, struct mi_parse *context)
 			    context->token, context->command, context->args);
 
       mi_cmd_execute (context);
+      mi_async_batch_flush ();
 
       /* Print the result if there were no errors.
 
@@ -1983,6 +1987,7 @@ captured_mi_execute_command (struct ui_out *uiout, struct mi_parse *context)
 	argv[0] = "console";
 	argv[1] = context->command;
 	mi_cmd_interpreter_exec ("-interpreter-exec", argv, 2);
+	mi_async_batch_flush ();
 
 	/* If we changed interpreters, DON'T print out anything.  */
 	if (current_interp_named_p (INTERP_MI)
@@ -2014,6 +2019,7 @@ captured_mi_execute_command (struct ui_out *uiout, struct mi_parse *context)
 static void
 mi_print_exception (const char *token, struct gdb_exception exception)
 {
+  mi_async_batch_flush ();
   fputs_unfiltered (token, raw_stdout);
   fputs_unfiltered ("^error,msg=\"", raw_stdout);
   if (exception.message == NULL)
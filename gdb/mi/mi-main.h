@@ -28,6 +28,11 @@ extern void mi_load_progress (const char *section_name,
 
 extern void mi_print_timing_maybe (void);
 
+/* Report the thread, library and breakpoint notifications collected
+   while "set mi-async-batch" is on.  Does nothing if there are none.  */
+
+extern void mi_async_batch_flush (void);
+
 extern char *current_token;
 
 extern int running_result_record_printed;
@@ -464,6 +464,123 @@ lookup_minimal_symbol_solib_trampoline (const char *name,
   return NULL;
 }
 
+/* An address index over an objfile's minimal symbols.  The addresses
+   are copied out of the msymbols array into a separate vector laid out
+   in Eytzinger (breadth-first binary tree) order, so that the first
+   levels of every search share a handful of cache lines and no probe
+   has to touch a minimal_symbol.  */
+
+struct msymbol_addr_index
+{
+  /* The number of addresses.  */
+  int count;
+
+  /* The addresses in Eytzinger order.  Element 0 is unused; the
+     children of element K are 2K and 2K + 1.  */
+  CORE_ADDR *addrs;
+
+  /* For each element of ADDRS, its index in the msymbols array.  */
+  int *msym_index;
+};
+
+static const struct objfile_data *msymbol_addr_index_key;
+
+/* Fill INDEX from the sorted msymbols of OBJFILE, taking the elements
+   in order starting at *NEXT for the subtree rooted at K.  */
+
+static void
+fill_msymbol_addr_index (struct msymbol_addr_index *index,
+			 struct objfile *objfile, int k, int *next)
+{
+  if (k > index->count)
+    return;
+
+  fill_msymbol_addr_index (index, objfile, 2 * k, next);
+  index->addrs[k] = SYMBOL_VALUE_ADDRESS (&objfile->msymbols[*next]);
+  index->msym_index[k] = *next;
+  ++*next;
+  fill_msymbol_addr_index (index, objfile, 2 * k + 1, next);
+}
+
+/* Free the address index INDEX.  */
+
+static void
+free_msymbol_addr_index (struct msymbol_addr_index *index)
+{
+  if (index != NULL)
+    {
+      xfree (index->addrs);
+      xfree (index->msym_index);
+      xfree (index);
+    }
+}
+
+/* The objfile data cleanup for msymbol_addr_index_key.  */
+
+static void
+msymbol_addr_index_cleanup (struct objfile *objfile, void *arg)
+{
+  free_msymbol_addr_index (arg);
+}
+
+/* Discard the address index of OBJFILE, if any.  It is rebuilt on
+   demand.  */
+
+static void
+invalidate_msymbol_addr_index (struct objfile *objfile)
+{
+  free_msymbol_addr_index (objfile_data (objfile, msymbol_addr_index_key));
+  set_objfile_data (objfile, msymbol_addr_index_key, NULL);
+}
+
+/* Return the address index of OBJFILE, building it if needed.  */
+
+static struct msymbol_addr_index *
+get_msymbol_addr_index (struct objfile *objfile)
+{
+  struct msymbol_addr_index *index;
+  int next = 0;
+
+  index = objfile_data (objfile, msymbol_addr_index_key);
+  if (index != NULL)
+    return index;
+
+  index = XNEW (struct msymbol_addr_index);
+  index->count = objfile->minimal_symbol_count;
+  index->addrs = XNEWVEC (CORE_ADDR, index->count + 1);
+  index->msym_index = XNEWVEC (int, index->count + 1);
+  fill_msymbol_addr_index (index, objfile, 1, &next);
+  gdb_assert (next == index->count);
+
+  set_objfile_data (objfile, msymbol_addr_index_key, index);
+  return index;
+}
+
+/* Return the index in OBJFILE's msymbols of the last minimal symbol
+   whose address is less than or equal to PC, or -1 if PC is below
+   every minimal symbol.  */
+
+static int
+msymbol_upper_index (struct objfile *objfile, CORE_ADDR pc)
+{
+  struct msymbol_addr_index *index = get_msymbol_addr_index (objfile);
+  int k = 1;
+
+  /* Descend to a leaf.  Going right means the element is <= PC.  */
+  while (k <= index->count)
+    k = 2 * k + (index->addrs[k] <= pc);
+
+  /* Undo the trailing right turns and the final left one; K is then
+     the first element greater than PC, or 0 if there is none.  */
+  while (k & 1)
+    k >>= 1;
+  k >>= 1;
+
+  if (k == 0)
+    return index->count - 1;
+  return index->msym_index[k] - 1;
+}
+
 /* Search through the minimal symbol table for each objfile and find
    the symbol whose address is the largest address that is still less
    than or equal to PC, and matches SECTION (which is not NULL).
@@ -484,9 +601,7 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc,
 				       struct obj_section *section,
 				       int want_trampoline)
 {
-  int lo;
   int hi;
-  int new;
   struct objfile *objfile;
   struct minimal_symbol *msymbol;
   struct minimal_symbol *best_symbol = NULL;
@@ -513,7 +628,7 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc,
        objfile = objfile_separate_debug_iterate (section->objfile, objfile))
     {
       /* If this objfile has a minimal symbol table, go search it using
-         a binary search.  Note that a minimal symbol table always consists
+         its address index.  Note that a minimal symbol table always consists
          of at least two symbols, a "real" symbol and the terminating
          "null symbol".  If there are no real symbols, then there is no
          minimal symbol table at all.  */
@@ -523,8 +638,6 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc,
 	  int best_zero_sized = -1;
 
           msymbol = objfile->msymbols;
-	  lo = 0;
-	  hi = objfile->minimal_symbol_count - 1;
 
 	  /* This code assumes that the minimal symbols are sorted by
 	     ascending address values.  If the pc value is greater than or
@@ -533,44 +646,14 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc,
 	     "best" symbol.  This includes the last real symbol, for cases
 	     where the pc value is larger than any address in this vector.
 
-	     By iterating until the address associated with the current
-	     hi index (the endpoint of the test interval) is less than
-	     or equal to the desired pc value, we accomplish two things:
-	     (1) the case where the pc value is larger than any minimal
-	     symbol address is trivially solved, (2) the address associated
-	     with the hi index is always the one we want when the interation
-	     terminates.  In essence, we are iterating the test interval
-	     down until the pc value is pushed out of it from the high end.
-
-	     Warning: this code is trickier than it would appear at first.  */
+	     HI is the last of the symbols at the highest address not
+	     above PC.  That way we can find the right symbol if there
+	     are several at the same address.  */
 
 	  /* Should also require that pc is <= end of objfile.  FIXME!  */
-	  if (pc >= SYMBOL_VALUE_ADDRESS (&msymbol[lo]))
+	  hi = msymbol_upper_index (objfile, pc);
+	  if (hi >= 0)
 	    {
-	      while (SYMBOL_VALUE_ADDRESS (&msymbol[hi]) > pc)
-		{
-		  /* pc is still strictly less than highest address.  */
-		  /* Note "new" will always be >= lo.  */
-		  new = (lo + hi) / 2;
-		  if ((SYMBOL_VALUE_ADDRESS (&msymbol[new]) >= pc) ||
-		      (lo == new))
-		    {
-		      hi = new;
-		    }
-		  else
-		    {
-		      lo = new;
-		    }
-		}
-
-	      /* If we have multiple symbols at the same address, we want
-	         hi to point to the last one.  That way we can find the
-	         right symbol if it has an index greater than hi.  */
-	      while (hi < objfile->minimal_symbol_count - 1
-		     && (SYMBOL_VALUE_ADDRESS (&msymbol[hi])
-			 == SYMBOL_VALUE_ADDRESS (&msymbol[hi + 1])))
-		hi++;
-
 	      /* Skip various undesirable symbols.  */
 	      while (hi >= 0)
 		{
@@ -726,6 +809,11 @@ lookup_minimal_symbol_by_pc_section (CORE_ADDR pc, struct obj_section *section)
 	  return result;
 	}
     }
+
+  /* A PC in a library whose symbols were deferred needs them now.  */
+  if ((section->objfile->flags & OBJF_DEFERRED) != 0)
+    read_deferred_symbols (section->objfile);
+
   return lookup_minimal_symbol_by_pc_section_1 (pc, section, 0);
 }
 
@@ -746,6 +834,47 @@ lookup_minimal_symbol_by_pc (CORE_ADDR pc)
   return lookup_minimal_symbol_by_pc_section_1 (pc, section, 0);
 }
 
+/* See minsyms.h.  */
+
+void
+lookup_minimal_symbols_by_pcs (const CORE_ADDR *pcs, int count,
+			       struct bound_minimal_symbol *results)
+{
+  struct obj_section *section = NULL;
+  int i;
+
+  for (i = 0; i < count; i++)
+    {
+      CORE_ADDR pc = pcs[i];
+
+      gdb_assert (i == 0 || pcs[i - 1] <= pc);
+
+      if (i > 0 && pcs[i - 1] == pc)
+	{
+	  results[i] = results[i - 1];
+	  continue;
+	}
+
+      /* Consecutive PCs usually fall in the same section; only go
+	 back to the section map when PC leaves it.  Overlays can map
+	 the same address to different sections, so always ask then.  */
+      if (section == NULL
+	  || overlay_debugging
+	  || pc < obj_section_addr (section)
+	  || pc >= obj_section_endaddr (section))
+	section = find_pc_section (pc);
+
+      if (section == NULL)
+	memset (&results[i], 0, sizeof (results[i]));
+      else
+	{
+	  if ((section->objfile->flags & OBJF_DEFERRED) != 0)
+	    read_deferred_symbols (section->objfile);
+	  results[i] = lookup_minimal_symbol_by_pc_section_1 (pc, section, 0);
+	}
+    }
+}
+
 /* Return non-zero iff PC is in an STT_GNU_IFUNC function resolver.  */
 
 int
@@ -1127,6 +1256,9 @@ build_minimal_symbol_hash_tables (struct objfile *objfile)
   int i;
   struct minimal_symbol *msym;
 
+  /* The symbols may have moved or changed address.  */
+  invalidate_msymbol_addr_index (objfile);
+
   /* Clear the hash tables.  */
   for (i = 0; i < MINIMAL_SYMBOL_HASH_SIZE; i++)
     {
@@ -1360,3 +1492,13 @@ find_solib_trampoline_target (struct frame_info *frame, CORE_ADDR pc)
     }
   return 0;
 }
+
+/* Provide a prototype to silence -Wmissing-prototypes.  */
+extern initialize_file_ftype _initialize_minsyms;
+
+void
+_initialize_minsyms (void)
+{
+  msymbol_addr_index_key
+    = register_objfile_data_with_cleanup (NULL, msymbol_addr_index_cleanup);
+}
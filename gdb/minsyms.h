@@ -235,6 +235,14 @@ struct bound_minimal_symbol lookup_minimal_symbol_by_pc_section
 
 struct bound_minimal_symbol lookup_minimal_symbol_by_pc (CORE_ADDR);
 
+/* Look up the minimal symbols for COUNT PCs at once, storing the
+   result for PCS[I] in RESULTS[I] as lookup_minimal_symbol_by_pc
+   would.  PCS must be sorted in ascending order; this lets
+   consecutive lookups share their section search.  */
+
+void lookup_minimal_symbols_by_pcs (const CORE_ADDR *pcs, int count,
+				    struct bound_minimal_symbol *results);
+
 /* Iterate over all the minimal symbols in the objfile OBJF which
    match NAME.  Both the ordinary and demangled names of each symbol
    are considered.  The caller is responsible for canonicalizing NAME,
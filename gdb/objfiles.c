@@ -63,6 +63,10 @@ DEFINE_REGISTRY (objfile, REGISTRY_ACCESS_FIELD)
 /* Externally visible variables that are owned by this module.
    See declarations in objfile.h for more info.  */
 
+typedef struct objfile *objfilep;
+
+DEF_VEC_P (objfilep);
+
 struct objfile_pspace_info
 {
   struct obj_section **sections;
@@ -72,9 +76,18 @@ struct objfile_pspace_info
      was last updated.  */
   int new_objfiles_available;
 
+  /* The object files added since the section map was last updated,
+     whose sections can be merged into it.  */
+  VEC (objfilep) *new_objfiles;
+
   /* Nonzero if the section map MUST be updated before use.  */
   int section_map_dirty;
 
+  /* Nonzero if some section was left out of the section map because
+     it overlapped another one.  Removing the sections of an objfile
+     from the map may then uncover it, so that needs a rebuild.  */
+  int overlaps_filtered;
+
   /* Nonzero if section map updates should be inhibited if possible.  */
   int inhibit_updates;
 };
@@ -82,12 +95,15 @@ struct objfile_pspace_info
 /* Per-program-space data key.  */
 static const struct program_space_data *objfiles_pspace_data;
 
+static void remove_objfile_from_section_map (struct objfile *objfile);
+
 static void
 objfiles_pspace_data_cleanup (struct program_space *pspace, void *arg)
 {
   struct objfile_pspace_info *info = arg;
 
   xfree (info->sections);
+  VEC_free (objfilep, info->new_objfiles);
   xfree (info);
 }
 
@@ -152,6 +168,7 @@ get_objfile_bfd_data (struct objfile *objfile, struct bfd *abfd)
       obstack_init (&storage->storage_obstack);
       storage->filename_cache = bcache_xmalloc (NULL, NULL);
       storage->macro_cache = bcache_xmalloc (NULL, NULL);
+      storage->psymbol_cache = psymbol_bcache_init ();
     }
 
   return storage;
@@ -164,6 +181,7 @@ free_objfile_per_bfd_storage (struct objfile_per_bfd_storage *storage)
 {
   bcache_xfree (storage->filename_cache);
   bcache_xfree (storage->macro_cache);
+  psymbol_bcache_free (storage->psymbol_cache);
   if (storage->demangled_names_hash)
     htab_delete (storage->demangled_names_hash);
   obstack_free (&storage->storage_obstack, 0);
@@ -274,7 +292,6 @@ allocate_objfile (bfd *abfd, const char *name, int flags)
   struct objfile *objfile;
 
   objfile = (struct objfile *) xzalloc (sizeof (struct objfile));
-  objfile->psymbol_cache = psymbol_bcache_init ();
   /* We could use obstack_specify_allocation here instead, but
      gdb_obstack.h specifies the alloc/dealloc functions.  */
   obstack_init (&objfile->objfile_obstack);
@@ -334,8 +351,14 @@ allocate_objfile (bfd *abfd, const char *name, int flags)
   /* Save passed in flag bits.  */
   objfile->flags |= flags;
 
-  /* Rebuild section map next time we need it.  */
-  get_objfile_pspace_data (objfile->pspace)->new_objfiles_available = 1;
+  /* Add its sections to the section map next time we need it.  */
+  {
+    struct objfile_pspace_info *info
+      = get_objfile_pspace_data (objfile->pspace);
+
+    info->new_objfiles_available = 1;
+    VEC_safe_push (objfilep, info->new_objfiles, objfile);
+  }
 
   return objfile;
 }
@@ -655,13 +678,14 @@ free_objfile (struct objfile *objfile)
     xfree (objfile->global_psymbols.list);
   if (objfile->static_psymbols.list)
     xfree (objfile->static_psymbols.list);
+
+  /* Drop its sections from the section map before they go away with
+     the obstack.  */
+  remove_objfile_from_section_map (objfile);
+
   /* Free the obstacks for non-reusable objfiles.  */
-  psymbol_bcache_free (objfile->psymbol_cache);
   obstack_free (&objfile->objfile_obstack, 0);
 
-  /* Rebuild section map next time we need it.  */
-  get_objfile_pspace_data (objfile->pspace)->section_map_dirty = 1;
-
   /* The last thing we do is free the objfile struct itself.  */
   xfree (objfile);
 }
@@ -791,6 +815,9 @@ objfile_relocate1 (struct objfile *objfile,
     }
   }
 
+  /* The symtabs' address ranges have changed.  */
+  clear_pc_symtab_index (objfile);
+
   /* Relocate isolated symbols.  */
   {
     struct symbol *iter;
@@ -1342,7 +1369,9 @@ update_section_map (struct program_space *pspace,
 
   qsort (map, alloc_size, sizeof (*map), qsort_cmp);
   map_size = filter_debuginfo_sections(map, alloc_size);
+  i = map_size;
   map_size = filter_overlapping_sections(map, map_size);
+  pspace_info->overlaps_filtered = map_size < i;
 
   if (map_size < alloc_size)
     /* Some sections were eliminated.  Trim excess space.  */
@@ -1354,6 +1383,140 @@ update_section_map (struct program_space *pspace,
   *pmap_size = map_size;
 }
 
+/* Merge the sections of the objfiles in PSPACE's new_objfiles list
+   into its section map, which must be up to date otherwise.  Only the
+   part of the map the new sections land in is filtered again; the
+   rest was filtered when it was built and cannot have changed.  */
+
+static void
+merge_new_objfiles_into_section_map (struct program_space *pspace)
+{
+  struct objfile_pspace_info *pspace_info = get_objfile_pspace_data (pspace);
+  struct obj_section **old_map = pspace_info->sections;
+  int old_size = pspace_info->num_sections;
+  struct obj_section **added, **map, *s;
+  int num_added, map_size, i, j, k, lo, hi, window;
+  CORE_ADDR end;
+  struct objfile *objfile;
+  int ix;
+
+  num_added = 0;
+  for (ix = 0;
+       VEC_iterate (objfilep, pspace_info->new_objfiles, ix, objfile);
+       ix++)
+    ALL_OBJFILE_OSECTIONS (objfile, s)
+      if (insert_section_p (objfile->obfd, s->the_bfd_section))
+	num_added++;
+
+  if (num_added == 0)
+    return;
+
+  added = xmalloc (num_added * sizeof (*added));
+  i = 0;
+  for (ix = 0;
+       VEC_iterate (objfilep, pspace_info->new_objfiles, ix, objfile);
+       ix++)
+    ALL_OBJFILE_OSECTIONS (objfile, s)
+      if (insert_section_p (objfile->obfd, s->the_bfd_section))
+	added[i++] = s;
+  qsort (added, num_added, sizeof (*added), qsort_cmp);
+
+  /* Merge the two sorted lists, remembering where the new sections
+     start and end up.  */
+  map = xmalloc ((old_size + num_added) * sizeof (*map));
+  lo = -1;
+  hi = -1;
+  for (i = 0, j = 0, k = 0; i < old_size || j < num_added; k++)
+    {
+      if (j < num_added
+	  && (i == old_size || qsort_cmp (&added[j], &old_map[i]) < 0))
+	{
+	  if (lo < 0)
+	    lo = k;
+	  hi = k;
+	  map[k] = added[j++];
+	}
+      else
+	map[k] = old_map[i++];
+    }
+  map_size = k;
+  xfree (added);
+
+  /* The old map had no overlaps, so an old section before the first
+     new one can only overlap the new ones if it is right before it.
+     After the last new one, take in all the sections starting before
+     the end of those seen so far, or at the same address.  */
+  if (lo > 0)
+    lo--;
+  end = obj_section_endaddr (map[lo]);
+  for (i = lo + 1; i <= hi; i++)
+    if (obj_section_endaddr (map[i]) > end)
+      end = obj_section_endaddr (map[i]);
+  while (hi + 1 < map_size
+	 && (obj_section_addr (map[hi + 1]) < end
+	     || obj_section_addr (map[hi + 1]) == obj_section_addr (map[hi])))
+    {
+      hi++;
+      if (obj_section_endaddr (map[hi]) > end)
+	end = obj_section_endaddr (map[hi]);
+    }
+
+  window = filter_debuginfo_sections (map + lo, hi + 1 - lo);
+  i = window;
+  window = filter_overlapping_sections (map + lo, window);
+  if (window < i)
+    pspace_info->overlaps_filtered = 1;
+
+  if (window < hi + 1 - lo)
+    {
+      memmove (map + lo + window, map + hi + 1,
+	       (map_size - hi - 1) * sizeof (*map));
+      map_size -= hi + 1 - lo - window;
+    }
+
+  xfree (old_map);
+  pspace_info->sections = map;
+  pspace_info->num_sections = map_size;
+}
+
+/* Remove the sections of OBJFILE from its program space's section
+   map, keeping the rest of the map as it is, or arrange for the map
+   to be rebuilt if that could be wrong.  */
+
+static void
+remove_objfile_from_section_map (struct objfile *objfile)
+{
+  struct objfile_pspace_info *pspace_info
+    = get_objfile_pspace_data (objfile->pspace);
+  struct objfile *o;
+  int i, j, ix;
+
+  for (ix = 0;
+       VEC_iterate (objfilep, pspace_info->new_objfiles, ix, o);
+       ix++)
+    if (o == objfile)
+      {
+	VEC_ordered_remove (objfilep, pspace_info->new_objfiles, ix);
+	break;
+      }
+
+  if (pspace_info->section_map_dirty)
+    return;
+
+  /* A section of OBJFILE may have hidden an overlapping one of
+     another objfile, which should now take its place.  */
+  if (pspace_info->overlaps_filtered)
+    {
+      pspace_info->section_map_dirty = 1;
+      return;
+    }
+
+  for (i = 0, j = 0; i < pspace_info->num_sections; i++)
+    if (pspace_info->sections[i]->objfile != objfile)
+      pspace_info->sections[j++] = pspace_info->sections[i];
+  pspace_info->num_sections = j;
+}
+
 /* Bsearch comparison function.  */
 
 static int
@@ -1387,12 +1550,16 @@ find_pc_section (CORE_ADDR pc)
       || (pspace_info->new_objfiles_available
 	  && !pspace_info->inhibit_updates))
     {
-      update_section_map (current_program_space,
-			  &pspace_info->sections,
-			  &pspace_info->num_sections);
+      if (pspace_info->section_map_dirty)
+	update_section_map (current_program_space,
+			    &pspace_info->sections,
+			    &pspace_info->num_sections);
+      else
+	merge_new_objfiles_into_section_map (current_program_space);
 
       /* Don't need updates to section map until objfiles are added,
          removed or relocated.  */
+      VEC_truncate (objfilep, pspace_info->new_objfiles, 0);
       pspace_info->new_objfiles_available = 0;
       pspace_info->section_map_dirty = 0;
     }
@@ -27,6 +27,7 @@
 #include "gdb_bfd.h"
 
 struct bcache;
+struct psymbol_bcache;
 struct htab;
 struct symtab;
 struct objfile_data;
@@ -141,7 +142,11 @@ struct obj_section
 /* The "objstats" structure provides a place for gdb to record some
    interesting information about its internal state at runtime, on a
    per objfile basis, such as information about the number of symbols
-   read, size of string table (if any), etc.  */
+   read, size of string table (if any), etc.
+
+   The size_t counters break down, by kind of data, the bytes the
+   symbol readers allocate on the objfile obstack.  They are reported
+   by "maint print statistics".  */
 
 struct objstats
   {
@@ -151,11 +156,17 @@ struct objstats
     int n_stabs;		/* Number of ".stabs" read (if applicable) */
     int n_types;		/* Number of types */
     int sz_strtab;		/* Size of stringtable, (if applicable) */
+    size_t sz_psymtabs;		/* Bytes of partial symtabs */
+    size_t sz_syms;		/* Bytes of full symbols */
+    size_t sz_blocks;		/* Bytes of blocks and blockvectors */
+    size_t sz_types;		/* Bytes of types */
+    size_t sz_linetables;	/* Bytes of line tables */
   };
 
 #define OBJSTAT(objfile, expr) (objfile -> stats.expr)
 #define OBJSTATS struct objstats stats
 extern void print_objfile_statistics (void);
+extern void print_objfile_statistics_json (void);
 extern void print_symbol_bcache_statistics (void);
 
 /* Number of entries in the minimal symbol hash table.  */
@@ -179,6 +190,12 @@ struct objfile_per_bfd_storage
   /* Byte cache for macros.  */
   struct bcache *macro_cache;
 
+  /* Byte cache for partial symbols.  A partial symbol does not depend
+     on the objfile it was read for beyond its address, so objfiles
+     sharing a BFD at the same offsets (e.g. several inferiors running
+     the same executable) share the storage for their psymbols.  */
+  struct psymbol_bcache *psymbol_cache;
+
   /* The gdbarch associated with the BFD.  Note that this gdbarch is
      determined solely from BFD information, without looking at target
      information.  The gdbarch determined from a running target may
@@ -272,11 +289,6 @@ struct objfile
 
     struct obstack objfile_obstack; 
 
-    /* A byte cache where we can stash arbitrary "chunks" of bytes that
-       will not change.  */
-
-    struct psymbol_bcache *psymbol_cache; /* Byte cache for partial syms.  */
-
     /* Vectors of all partial symbols read in from file.  The actual data
        is stored in the objfile_obstack.  */
 
@@ -434,6 +446,12 @@ struct objfile
 
 #define OBJF_NOT_FILENAME (1 << 6)
 
+/* Only the dynamic symbols of this objfile have been read, as
+   requested by SYMFILE_DEFER_READ.  read_deferred_symbols reads the
+   rest of its symbols and clears this flag.  */
+
+#define OBJF_DEFERRED (1 << 7)
+
 /* Declarations for functions defined in objfiles.c */
 
 extern struct objfile *allocate_objfile (bfd *, const char *name, int);
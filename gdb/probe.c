@@ -31,8 +31,104 @@
 #include "gdb_regex.h"
 #include "frame.h"
 #include "arch-utils.h"
+#include "hashtab.h"
 #include <ctype.h>
 
+/* The probes of an objfile that share a name.  */
+
+struct probe_name_entry
+{
+  const char *name;
+  VEC (probe_p) *probes;
+};
+
+/* Per-objfile key for the hash table of probe_name_entry objects
+   indexing the objfile's probes by name.  */
+
+static const struct objfile_data *probe_index_key;
+
+static hashval_t
+hash_probe_name_entry (const void *p)
+{
+  const struct probe_name_entry *entry = p;
+
+  return htab_hash_string (entry->name);
+}
+
+static int
+eq_probe_name_entry (const void *a, const void *b)
+{
+  const struct probe_name_entry *ea = a;
+  const struct probe_name_entry *eb = b;
+
+  return strcmp (ea->name, eb->name) == 0;
+}
+
+static void
+free_probe_name_entry (void *p)
+{
+  struct probe_name_entry *entry = p;
+
+  VEC_free (probe_p, entry->probes);
+  xfree (entry);
+}
+
+static void
+probe_index_free (struct objfile *objfile, void *arg)
+{
+  htab_delete (arg);
+}
+
+/* Return the probes of OBJFILE named NAME, in the order the objfile
+   lists them, or NULL if there are none.  The probes are indexed by
+   name the first time this is called for OBJFILE.  OBJFILE must have
+   sym_probe_fns.  */
+
+static VEC (probe_p) *
+find_probes_by_name (struct objfile *objfile, const char *name)
+{
+  struct probe_name_entry key, *entry;
+  htab_t index;
+
+  index = objfile_data (objfile, probe_index_key);
+  if (index == NULL)
+    {
+      VEC (probe_p) *probes;
+      struct probe *probe;
+      int ix;
+
+      probes = objfile->sf->sym_probe_fns->sym_get_probes (objfile);
+      index = htab_create_alloc (VEC_length (probe_p, probes) / 2 + 1,
+				 hash_probe_name_entry, eq_probe_name_entry,
+				 free_probe_name_entry, xcalloc, xfree);
+
+      for (ix = 0; VEC_iterate (probe_p, probes, ix, probe); ix++)
+	{
+	  void **slot;
+
+	  key.name = probe->name;
+	  slot = htab_find_slot (index, &key, INSERT);
+	  if (*slot == NULL)
+	    {
+	      entry = XNEW (struct probe_name_entry);
+	      entry->name = probe->name;
+	      entry->probes = NULL;
+	      *slot = entry;
+	    }
+	  else
+	    entry = *slot;
+
+	  VEC_safe_push (probe_p, entry->probes, probe);
+	}
+
+      set_objfile_data (objfile, probe_index_key, index);
+    }
+
+  key.name = name;
+  entry = htab_find (index, &key);
+  return entry != NULL ? entry->probes : NULL;
+}
+
 
 
 /* See definition in probe.h.  */
@@ -121,7 +217,7 @@ parse_probes (char **argptr, struct linespec_result *canonical)
 			     objfile_namestr) != 0)
 	  continue;
 
-	probes = objfile->sf->sym_probe_fns->sym_get_probes (objfile);
+	probes = find_probes_by_name (objfile, name);
 
 	for (ix = 0; VEC_iterate (probe_p, probes, ix, probe); ix++)
 	  {
@@ -133,9 +229,6 @@ parse_probes (char **argptr, struct linespec_result *canonical)
 	    if (provider && strcmp (probe->provider, provider) != 0)
 	      continue;
 
-	    if (strcmp (probe->name, name) != 0)
-	      continue;
-
 	    ++result.nelts;
 	    result.sals = xrealloc (result.sals,
 				    result.nelts
@@ -187,15 +280,12 @@ find_probes_in_objfile (struct objfile *objfile, const char *provider,
   if (!objfile->sf || !objfile->sf->sym_probe_fns)
     return NULL;
 
-  probes = objfile->sf->sym_probe_fns->sym_get_probes (objfile);
+  probes = find_probes_by_name (objfile, name);
   for (ix = 0; VEC_iterate (probe_p, probes, ix, probe); ix++)
     {
       if (strcmp (probe->provider, provider) != 0)
 	continue;
 
-      if (strcmp (probe->name, name) != 0)
-	continue;
-
       VEC_safe_push (probe_p, result, probe);
     }
 
@@ -778,6 +868,9 @@ _initialize_probe (void)
 {
   VEC_safe_push (probe_ops_cp, all_probe_ops, &probe_ops_any);
 
+  probe_index_key = register_objfile_data_with_cleanup (NULL,
+							 probe_index_free);
+
   add_cmd ("all", class_info, info_probes_command,
 	   _("\
 Show information about all type of probes."),
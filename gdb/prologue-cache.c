@@ -0,0 +1,164 @@
+/* Per-objfile cache of prologue analysis results.
+
+   Copyright (C) 2013 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "defs.h"
+#include "objfiles.h"
+#include "prologue-cache.h"
+#include "hashtab.h"
+#include "gdb_assert.h"
+#include "gdb_string.h"
+
+/* One recorded analysis.  The entry and its data live on the
+   objfile's obstack; only the hash table itself is malloc'd.  */
+
+struct prologue_cache_entry
+{
+  /* The architecture that did the analysis.  */
+  struct gdbarch *gdbarch;
+
+  /* The start of the function, without the objfile's section
+     offset.  */
+  CORE_ADDR addr;
+
+  /* The architecture's private record and its size.  */
+  size_t size;
+  void *data;
+};
+
+static const struct objfile_data *prologue_cache_objfile_data_key;
+
+static hashval_t
+hash_prologue_cache_entry (const void *p)
+{
+  const struct prologue_cache_entry *entry = p;
+
+  return htab_hash_pointer (entry->gdbarch) ^ (hashval_t) entry->addr;
+}
+
+static int
+eq_prologue_cache_entry (const void *a, const void *b)
+{
+  const struct prologue_cache_entry *lhs = a;
+  const struct prologue_cache_entry *rhs = b;
+
+  return lhs->gdbarch == rhs->gdbarch && lhs->addr == rhs->addr;
+}
+
+static void
+prologue_cache_objfile_data_free (struct objfile *objfile, void *arg)
+{
+  htab_t table = arg;
+
+  htab_delete (table);
+}
+
+/* Find the objfile containing FUNC_ADDR and fill in KEY for it.
+   Return the objfile, or NULL if FUNC_ADDR is not in any objfile.  */
+
+static struct objfile *
+prologue_cache_key (struct gdbarch *gdbarch, CORE_ADDR func_addr,
+		    struct prologue_cache_entry *key)
+{
+  struct obj_section *sec = find_pc_section (func_addr);
+
+  if (sec == NULL)
+    return NULL;
+
+  key->gdbarch = gdbarch;
+  key->addr = func_addr - obj_section_offset (sec);
+  return sec->objfile;
+}
+
+/* See prologue-cache.h.  */
+
+const void *
+prologue_cache_lookup (struct gdbarch *gdbarch, CORE_ADDR func_addr,
+		       size_t size)
+{
+  struct prologue_cache_entry key, *entry;
+  struct objfile *objfile;
+  htab_t table;
+
+  objfile = prologue_cache_key (gdbarch, func_addr, &key);
+  if (objfile == NULL)
+    return NULL;
+
+  table = objfile_data (objfile, prologue_cache_objfile_data_key);
+  if (table == NULL)
+    return NULL;
+
+  entry = htab_find (table, &key);
+  if (entry == NULL)
+    return NULL;
+
+  gdb_assert (entry->size == size);
+  return entry->data;
+}
+
+/* See prologue-cache.h.  */
+
+void
+prologue_cache_store (struct gdbarch *gdbarch, CORE_ADDR func_addr,
+		      const void *data, size_t size)
+{
+  struct prologue_cache_entry key, *entry;
+  struct objfile *objfile;
+  htab_t table;
+  void **slot;
+
+  objfile = prologue_cache_key (gdbarch, func_addr, &key);
+  if (objfile == NULL)
+    return;
+
+  table = objfile_data (objfile, prologue_cache_objfile_data_key);
+  if (table == NULL)
+    {
+      table = htab_create_alloc (13, hash_prologue_cache_entry,
+				 eq_prologue_cache_entry, NULL,
+				 xcalloc, xfree);
+      set_objfile_data (objfile, prologue_cache_objfile_data_key, table);
+    }
+
+  slot = htab_find_slot (table, &key, INSERT);
+  entry = *slot;
+  if (entry == NULL)
+    {
+      entry = OBSTACK_ZALLOC (&objfile->objfile_obstack,
+			      struct prologue_cache_entry);
+      *entry = key;
+      *slot = entry;
+    }
+  if (entry->data == NULL || entry->size != size)
+    {
+      entry->data = obstack_alloc (&objfile->objfile_obstack, size);
+      entry->size = size;
+    }
+  memcpy (entry->data, data, size);
+}
+
+/* Provide a prototype to silence -Wmissing-prototypes.  */
+extern initialize_file_ftype _initialize_prologue_cache;
+
+void
+_initialize_prologue_cache (void)
+{
+  prologue_cache_objfile_data_key
+    = register_objfile_data_with_cleanup (NULL,
+					  prologue_cache_objfile_data_free);
+}
@@ -0,0 +1,53 @@
+/* Per-objfile cache of prologue analysis results.
+
+   Copyright (C) 2013 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef PROLOGUE_CACHE_H
+#define PROLOGUE_CACHE_H
+
+struct gdbarch;
+
+/* Prologue analyzers read the instructions at the start of a
+   function from the target, and they are run again for every frame
+   of that function that has to be unwound without debug info.  These
+   functions let an architecture remember what it found the first
+   time.
+
+   The results are kept with the objfile that contains the function,
+   keyed by GDBARCH and the function's unrelocated start address, and
+   are discarded along with the objfile.  Functions outside of any
+   objfile are never cached.  The cached data is an opaque block of
+   SIZE bytes whose layout is private to the architecture; it should
+   not contain absolute addresses, since the objfile may be relocated
+   after the analysis was recorded.  */
+
+/* Return the data recorded for the function starting at FUNC_ADDR by
+   an earlier call to prologue_cache_store with the same GDBARCH, or
+   NULL if there is none.  SIZE must match the size that was stored.  */
+
+extern const void *prologue_cache_lookup (struct gdbarch *gdbarch,
+					  CORE_ADDR func_addr, size_t size);
+
+/* Record SIZE bytes at DATA as the prologue analysis of the function
+   starting at FUNC_ADDR, for GDBARCH.  Replaces any earlier record.  */
+
+extern void prologue_cache_store (struct gdbarch *gdbarch,
+				  CORE_ADDR func_addr,
+				  const void *data, size_t size);
+
+#endif /* PROLOGUE_CACHE_H */
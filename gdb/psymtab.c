@@ -1206,6 +1206,129 @@ psymtab_to_fullname (struct partial_symtab *ps)
   return ps->fullname;
 }
 
+/* An index of the partial symbols of an objfile by the dict_hash of
+   their search names, used to find the psymtabs that may define a
+   name when the sorted global psymbols cannot be searched, as for Ada
+   wild matches.  An entry records that the psymtab at position
+   PSYMTAB in the psymtab list of the objfile has a partial symbol
+   whose name hashes to HASH.  The entries are sorted by hash, then by
+   psymtab position, without duplicates.  */
+
+struct psymbol_hash_entry
+{
+  unsigned int hash;
+  int psymtab;
+};
+
+struct psymbol_hash_index
+{
+  /* The entries for the global and the static partial symbols.  */
+  int count[2];
+  struct psymbol_hash_entry *entries[2];
+};
+
+static const struct objfile_data *psymbol_hash_index_key;
+
+/* qsort comparison function for struct psymbol_hash_entry.  */
+
+static int
+compare_psymbol_hash_entries (const void *a, const void *b)
+{
+  const struct psymbol_hash_entry *ea = a;
+  const struct psymbol_hash_entry *eb = b;
+
+  if (ea->hash != eb->hash)
+    return ea->hash < eb->hash ? -1 : 1;
+  return ea->psymtab - eb->psymtab;
+}
+
+/* The objfile data cleanup for psymbol_hash_index_key.  */
+
+static void
+psymbol_hash_index_cleanup (struct objfile *objfile, void *arg)
+{
+  struct psymbol_hash_index *index = arg;
+
+  xfree (index->entries[0]);
+  xfree (index->entries[1]);
+  xfree (index);
+}
+
+/* Fill in the entries of INDEX for the global partial symbols of
+   OBJFILE if GLOBAL is non-zero, or for the static ones otherwise.  */
+
+static void
+fill_psymbol_hash_index (struct psymbol_hash_index *index,
+			 struct objfile *objfile, int global)
+{
+  struct psymbol_hash_entry *entries;
+  struct partial_symtab *ps;
+  int n = 0, count = 0, i, pos = 0;
+
+  ALL_OBJFILE_PSYMTABS_REQUIRED (objfile, ps)
+    n += global ? ps->n_global_syms : ps->n_static_syms;
+
+  entries = XNEWVEC (struct psymbol_hash_entry, n);
+
+  ALL_OBJFILE_PSYMTABS_REQUIRED (objfile, ps)
+    {
+      struct partial_symbol **psym;
+      int length;
+
+      if (global)
+	{
+	  psym = objfile->global_psymbols.list + ps->globals_offset;
+	  length = ps->n_global_syms;
+	}
+      else
+	{
+	  psym = objfile->static_psymbols.list + ps->statics_offset;
+	  length = ps->n_static_syms;
+	}
+
+      for (i = 0; i < length; i++, psym++)
+	{
+	  entries[count].hash = dict_hash (SYMBOL_SEARCH_NAME (*psym));
+	  entries[count].psymtab = pos;
+	  count++;
+	}
+      pos++;
+    }
+  gdb_assert (count == n);
+
+  qsort (entries, count, sizeof (entries[0]), compare_psymbol_hash_entries);
+
+  /* Remove the duplicates.  */
+  n = 0;
+  for (i = 0; i < count; i++)
+    if (n == 0
+	|| entries[i].hash != entries[n - 1].hash
+	|| entries[i].psymtab != entries[n - 1].psymtab)
+      entries[n++] = entries[i];
+
+  index->count[global] = n;
+  index->entries[global] = xrealloc (entries, n * sizeof (entries[0]));
+}
+
+/* Return the hash index of OBJFILE, building it if needed.  */
+
+static struct psymbol_hash_index *
+get_psymbol_hash_index (struct objfile *objfile)
+{
+  struct psymbol_hash_index *index;
+
+  index = objfile_data (objfile, psymbol_hash_index_key);
+  if (index != NULL)
+    return index;
+
+  index = XNEW (struct psymbol_hash_index);
+  fill_psymbol_hash_index (index, objfile, 0);
+  fill_psymbol_hash_index (index, objfile, 1);
+
+  set_objfile_data (objfile, psymbol_hash_index_key, index);
+  return index;
+}
+
 /*  For all symbols, s, in BLOCK that are in NAMESPACE and match NAME
     according to the function MATCH, call CALLBACK(BLOCK, s, DATA).
     BLOCK is assumed to come from OBJFILE.  Returns 1 iff CALLBACK
@@ -1249,13 +1372,54 @@ map_matching_symbols_psymtab (struct objfile *objfile,
 {
   const int block_kind = global ? GLOBAL_BLOCK : STATIC_BLOCK;
   struct partial_symtab *ps;
+  struct psymbol_hash_entry *entry = NULL, *end = NULL;
+  unsigned int hash = 0;
+  int pos = 0;
+
+  /* Without ORDERED_COMPARE, match_partial_symbol has to call MATCH on
+     every partial symbol of a psymtab.  The names MATCH accepts have
+     the dict_hash of NAME, like the symbols map_block finds, so only
+     the psymtabs the hash index lists for it are searched.  */
+  if (ordered_compare == NULL)
+    {
+      struct psymbol_hash_index *index = get_psymbol_hash_index (objfile);
+      int lo = 0, hi = index->count[global];
+
+      hash = dict_hash (name);
+      while (lo < hi)
+	{
+	  int mid = lo + (hi - lo) / 2;
+
+	  if (index->entries[global][mid].hash < hash)
+	    lo = mid + 1;
+	  else
+	    hi = mid;
+	}
+
+      entry = index->entries[global] + lo;
+      end = index->entries[global] + index->count[global];
+    }
 
   ALL_OBJFILE_PSYMTABS_REQUIRED (objfile, ps)
     {
+      int listed = 1;
+
       QUIT;
+
+      if (ordered_compare == NULL)
+	{
+	  listed = (entry < end
+		    && entry->hash == hash
+		    && entry->psymtab == pos);
+	  if (listed)
+	    entry++;
+	}
+      pos++;
+
       if (ps->readin
-	  || match_partial_symbol (objfile, ps, global, name, namespace, match,
-				   ordered_compare))
+	  || (listed
+	      && match_partial_symbol (objfile, ps, global, name, namespace,
+				       match, ordered_compare)))
 	{
 	  struct symtab *s = psymtab_to_symtab (objfile, ps);
 	  struct block *block;
@@ -1571,7 +1735,7 @@ psymbol_bcache_full (struct partial_symbol *sym,
 }
 
 /* Helper function, initialises partial symbol structure and stashes 
-   it into objfile's bcache.  Note that our caching mechanism will
+   it into the per-BFD bcache.  Note that our caching mechanism will
    use all fields of struct partial_symbol to determine hash value of the
    structure.  In other words, having two symbols with the same name but
    different domain (or address) is possible and correct.  */
@@ -1602,7 +1766,10 @@ add_psymbol_to_bcache (const char *name, int namelength, int copy_name,
       SYMBOL_VALUE_ADDRESS (&psymbol) = coreaddr;
     }
   SYMBOL_SECTION (&psymbol) = -1;
-  SYMBOL_SET_LANGUAGE (&psymbol, language, &objfile->objfile_obstack);
+  /* The cached symbol may be used by other objfiles sharing the BFD, so
+     it must not refer to this objfile's obstack.  */
+  SYMBOL_SET_LANGUAGE (&psymbol, language,
+		       &objfile->per_bfd->storage_obstack);
   PSYMBOL_DOMAIN (&psymbol) = domain;
   PSYMBOL_CLASS (&psymbol) = class;
 
@@ -1610,7 +1777,7 @@ add_psymbol_to_bcache (const char *name, int namelength, int copy_name,
 
   /* Stash the partial symbol away in the cache.  */
   return psymbol_bcache_full (&psymbol,
-                              objfile->psymbol_cache,
+                              objfile->per_bfd->psymbol_cache,
                               added);
 }
 
@@ -1737,13 +1904,17 @@ allocate_psymtab (const char *filename, struct objfile *objfile)
       objfile->free_psymtabs = psymtab->next;
     }
   else
-    psymtab = (struct partial_symtab *)
-      obstack_alloc (&objfile->objfile_obstack,
-		     sizeof (struct partial_symtab));
+    {
+      psymtab = (struct partial_symtab *)
+	obstack_alloc (&objfile->objfile_obstack,
+		       sizeof (struct partial_symtab));
+      OBJSTAT (objfile, sz_psymtabs += sizeof (struct partial_symtab));
+    }
 
   memset (psymtab, 0, sizeof (struct partial_symtab));
   psymtab->filename = obstack_copy0 (&objfile->objfile_obstack,
 				     filename, strlen (filename));
+  OBJSTAT (objfile, sz_psymtabs += strlen (filename) + 1);
   psymtab->symtab = NULL;
 
   /* Prepend it to the psymtab list for the objfile it belongs to.
@@ -2088,6 +2259,171 @@ maintenance_check_psymtabs (char *ignore, int from_tty)
 
 
 
+/* A sorted index of the partial symbol names of an objfile, used to
+   find the psymtabs defining names with a given prefix without
+   calling a matcher on every partial symbol.  */
+
+struct psymbol_name_entry
+{
+  const char *name;
+  struct partial_symtab *psymtab;
+};
+
+struct psymbol_name_index
+{
+  int count;
+  struct psymbol_name_entry *entries;
+};
+
+static const struct objfile_data *psymbol_name_index_key;
+
+/* qsort comparison function for struct psymbol_name_entry.  */
+
+static int
+compare_psymbol_name_entries (const void *a, const void *b)
+{
+  const struct psymbol_name_entry *ea = a;
+  const struct psymbol_name_entry *eb = b;
+
+  return strcmp (ea->name, eb->name);
+}
+
+/* The objfile data cleanup for psymbol_name_index_key.  */
+
+static void
+psymbol_name_index_cleanup (struct objfile *objfile, void *arg)
+{
+  struct psymbol_name_index *index = arg;
+
+  xfree (index->entries);
+  xfree (index);
+}
+
+/* Return the name index of OBJFILE, building it if needed.  */
+
+static struct psymbol_name_index *
+get_psymbol_name_index (struct objfile *objfile)
+{
+  struct psymbol_name_index *index;
+  struct partial_symtab *ps;
+  int n = 0;
+
+  index = objfile_data (objfile, psymbol_name_index_key);
+  if (index != NULL)
+    return index;
+
+  ALL_OBJFILE_PSYMTABS_REQUIRED (objfile, ps)
+    n += ps->n_global_syms + ps->n_static_syms;
+
+  index = XNEW (struct psymbol_name_index);
+  index->entries = XNEWVEC (struct psymbol_name_entry, n);
+  index->count = 0;
+
+  ALL_OBJFILE_PSYMTABS_REQUIRED (objfile, ps)
+    {
+      struct partial_symbol **psym;
+      int i;
+
+      psym = objfile->global_psymbols.list + ps->globals_offset;
+      for (i = 0; i < ps->n_global_syms; i++, psym++)
+	{
+	  index->entries[index->count].name = SYMBOL_SEARCH_NAME (*psym);
+	  index->entries[index->count].psymtab = ps;
+	  index->count++;
+	}
+
+      psym = objfile->static_psymbols.list + ps->statics_offset;
+      for (i = 0; i < ps->n_static_syms; i++, psym++)
+	{
+	  index->entries[index->count].name = SYMBOL_SEARCH_NAME (*psym);
+	  index->entries[index->count].psymtab = ps;
+	  index->count++;
+	}
+    }
+  gdb_assert (index->count == n);
+
+  qsort (index->entries, index->count, sizeof (index->entries[0]),
+	 compare_psymbol_name_entries);
+
+  set_objfile_data (objfile, psymbol_name_index_key, index);
+  return index;
+}
+
+/* Expand the psymtabs of OBJFILE that define a name starting with the
+   PREFIX_LEN characters of PREFIX and accepted by FUN, as
+   expand_symtabs_matching would with FUN as the name matcher.  Return
+   zero if a matching name is in a shared psymtab; the caller must
+   then use expand_symtabs_matching, which knows how to find the
+   psymtabs including it.  Psymtabs expanded so far stay expanded, as
+   expand_symtabs_matching would have expanded them too.  */
+
+static int
+expand_psymtabs_with_prefix (struct objfile *objfile,
+			     const char *prefix, int prefix_len,
+			     int (*fun) (const char *, void *), void *data)
+{
+  struct psymbol_name_index *index = get_psymbol_name_index (objfile);
+  int lo = 0, hi = index->count;
+  int i;
+
+  /* Find the first name not below PREFIX.  */
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (strncmp (index->entries[mid].name, prefix, prefix_len) < 0)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  for (i = lo;
+       (i < index->count
+	&& strncmp (index->entries[i].name, prefix, prefix_len) == 0);
+       i++)
+    {
+      struct partial_symtab *ps = index->entries[i].psymtab;
+
+      QUIT;
+
+      if (ps->readin || !fun (index->entries[i].name, data))
+	continue;
+      if (ps->user != NULL)
+	return 0;
+      psymtab_to_symtab (objfile, ps);
+    }
+
+  return 1;
+}
+
+/* See psymtab.h.  */
+
+void
+expand_partial_symbol_names_with_prefix (const char *prefix, int prefix_len,
+					 int (*fun) (const char *, void *),
+					 void *data)
+{
+  struct objfile *objfile;
+
+  ALL_OBJFILES (objfile)
+  {
+    if (objfile->sf == NULL)
+      continue;
+
+    /* The index is sorted case-sensitively.  An objfile whose
+       symbols were deferred has no psymtabs to index yet.  */
+    if (objfile->sf->qf == &psym_functions
+	&& case_sensitivity == case_sensitive_on
+	&& (objfile->flags & OBJF_DEFERRED) == 0
+	&& expand_psymtabs_with_prefix (objfile, prefix, prefix_len,
+					fun, data))
+      continue;
+
+    objfile->sf->qf->expand_symtabs_matching (objfile, NULL, fun,
+					      ALL_DOMAIN, data);
+  }
+}
+
 void
 expand_partial_symbol_names (int (*fun) (const char *, void *),
 			     void *data)
@@ -2121,6 +2457,11 @@ extern initialize_file_ftype _initialize_psymtab;
 void
 _initialize_psymtab (void)
 {
+  psymbol_name_index_key
+    = register_objfile_data_with_cleanup (NULL, psymbol_name_index_cleanup);
+  psymbol_hash_index_key
+    = register_objfile_data_with_cleanup (NULL, psymbol_hash_index_cleanup);
+
   add_cmd ("psymbols", class_maintenance, maintenance_print_psymbols, _("\
 Print dump of current partial symbol definitions.\n\
 Entries in the partial symbol table are dumped to file OUTFILE.\n\
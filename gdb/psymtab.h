@@ -33,6 +33,16 @@ extern struct bcache *psymbol_bcache_get_bcache (struct psymbol_bcache *);
 void expand_partial_symbol_names (int (*fun) (const char *, void *),
 				  void *data);
 
+/* Like expand_partial_symbol_names, but FUN only accepts names that
+   start with the PREFIX_LEN characters of PREFIX, which lets objfiles
+   with partial symbols use a sorted name index instead of calling FUN
+   for each name.  */
+
+void expand_partial_symbol_names_with_prefix (const char *prefix,
+					      int prefix_len,
+					      int (*fun) (const char *, void *),
+					      void *data);
+
 void map_partial_symbol_filenames (symbol_filename_ftype *fun, void *data,
 				   int need_fullname);
 
@@ -293,6 +293,9 @@ def do_enable_pretty_printer (arg, flag):
             total += do_enable_pretty_printer_1(objfile.pretty_printers,
                                                 name_re, subname_re, flag)
 
+    # Printers found earlier for a type may no longer apply.
+    gdb.invalidate_cached_pretty_printers()
+
     if flag:
         state = "enabled"
     else:
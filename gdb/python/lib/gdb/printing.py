@@ -147,6 +147,7 @@ def register_pretty_printer(obj, printer, replace=False):
             i = i + 1
 
     obj.pretty_printers.insert(0, printer)
+    gdb.invalidate_cached_pretty_printers()
 
 
 class RegexpCollectionPrettyPrinter(PrettyPrinter):
@@ -159,8 +160,15 @@ class RegexpCollectionPrettyPrinter(PrettyPrinter):
     ...
     pretty_printer.add_printer("myclassN", "^myclassN$", MyClassNPrinter)
     register_pretty_printer(obj, pretty_printer)
+
+    The choice of printer depends only on the type of the value, so the
+    printer is marked type_pure: GDB remembers which printer, if any,
+    it chose for each type.  A subclass whose __call__ also looks at
+    the value itself must set type_pure to False.
     """
 
+    type_pure = True
+
     class RegexpSubprinter(SubPrettyPrinter):
         def __init__(self, name, regexp, gen_printer):
             super(RegexpCollectionPrettyPrinter.RegexpSubprinter, self).__init__(name)
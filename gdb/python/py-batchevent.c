@@ -0,0 +1,90 @@
+/* Python interface to batches of events.
+
+   Copyright (C) 2013 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "defs.h"
+#include "py-event.h"
+
+static PyTypeObject batch_event_object_type
+    CPYCHECKER_TYPE_OBJECT_FOR_TYPEDEF ("event_object");
+
+/* The events emitted since the last batch was delivered, or NULL if
+   there are none.  */
+
+static PyObject *pending_events;
+
+/* Add EVENT, about to be emitted to REGISTRY, to the pending batch if
+   anyone is listening for batches.  Returns 0 on success, or -1 with
+   a Python exception set.  */
+
+int
+evpy_add_to_batch (PyObject *event, eventregistry_object *registry)
+{
+  if (registry == gdb_py_events.batch
+      || evregpy_no_listeners_p (gdb_py_events.batch))
+    return 0;
+
+  if (pending_events == NULL)
+    {
+      pending_events = PyList_New (0);
+      if (pending_events == NULL)
+	return -1;
+    }
+
+  return PyList_Append (pending_events, event);
+}
+
+/* Deliver the events emitted since the last batch, if there were any,
+   to the listeners of gdb.events.batch in a single event.  Return -1
+   if emit fails.  */
+
+int
+emit_batch_event (void)
+{
+  PyObject *events = pending_events;
+  PyObject *event;
+
+  if (events == NULL)
+    return 0;
+  pending_events = NULL;
+
+  if (evregpy_no_listeners_p (gdb_py_events.batch))
+    {
+      Py_DECREF (events);
+      return 0;
+    }
+
+  event = create_event_object (&batch_event_object_type);
+  if (event == NULL
+      || evpy_add_attribute (event, "events", events) < 0)
+    {
+      Py_XDECREF (event);
+      Py_DECREF (events);
+      return -1;
+    }
+  Py_DECREF (events);
+
+  return evpy_emit_event (event, gdb_py_events.batch);
+}
+
+GDBPY_NEW_EVENT_TYPE (batch,
+                      "gdb.BatchEvent",
+                      "BatchEvent",
+                      "GDB event batch object",
+                      event_object_type,
+                      static);
@@ -38,7 +38,7 @@ emit_continue_event (ptid_t ptid)
 {
   PyObject *event;
 
-  if (evregpy_no_listeners_p (gdb_py_events.cont))
+  if (!evregpy_wanted_p (gdb_py_events.cont))
     return 0;
 
   event = create_continue_event_object ();
@@ -92,6 +92,15 @@ evpy_emit_event (PyObject *event,
   PyObject *callback_list_copy = NULL;
   Py_ssize_t i;
 
+  if (evpy_add_to_batch (event, registry) < 0)
+    goto fail;
+
+  if (evregpy_no_listeners_p (registry))
+    {
+      Py_DECREF (event);
+      return 0;
+    }
+
   /* Create a copy of call back list and use that for
      notifying listeners to avoid skipping callbacks
      in the case of a callback being disconnected during
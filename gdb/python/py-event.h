@@ -112,6 +112,10 @@ extern int evpy_emit_event (PyObject *event,
 extern PyObject *create_event_object (PyTypeObject *py_type);
 extern PyObject *create_thread_event_object (PyTypeObject *py_type);
 extern int emit_new_objfile_event (struct objfile *objfile);
+extern int emit_batch_event (void);
+extern int evpy_add_to_batch (PyObject *event,
+			      eventregistry_object *registry)
+  CPYCHECKER_NEGATIVE_RESULT_SETS_EXCEPTION;
 
 extern void evpy_dealloc (PyObject *self);
 extern int evpy_add_attribute (PyObject *event,
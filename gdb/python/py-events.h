@@ -46,6 +46,7 @@ typedef struct
   eventregistry_object *cont;
   eventregistry_object *exited;
   eventregistry_object *new_objfile;
+  eventregistry_object *batch;
 
   PyObject *module;
 
@@ -56,5 +57,6 @@ extern events_object gdb_py_events;
 
 extern eventregistry_object *create_eventregistry_object (void);
 extern int evregpy_no_listeners_p (eventregistry_object *registry);
+extern int evregpy_wanted_p (eventregistry_object *registry);
 
 #endif /* GDB_PY_EVENTS_H */
@@ -125,6 +125,19 @@ evregpy_no_listeners_p (eventregistry_object *registry)
   return PyList_Size (registry->callbacks) == 0;
 }
 
+/* Return nonzero if an event for REGISTRY would be seen by anyone,
+   either REGISTRY's own listeners or those of gdb.events.batch.
+   This only looks at the sizes of the callback lists, so GDB's event
+   observers can call it before taking the GIL, and return at once
+   when no one is listening.  */
+
+int
+evregpy_wanted_p (eventregistry_object *registry)
+{
+  return (!evregpy_no_listeners_p (registry)
+	  || !evregpy_no_listeners_p (gdb_py_events.batch));
+}
+
 static PyMethodDef eventregistry_object_methods[] =
 {
   { "connect", evregpy_connect, METH_VARARGS, "Add function" },
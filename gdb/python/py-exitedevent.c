@@ -72,7 +72,7 @@ emit_exited_event (const LONGEST *exit_code, struct inferior *inf)
 {
   PyObject *event;
 
-  if (evregpy_no_listeners_p (gdb_py_events.exited))
+  if (!evregpy_wanted_p (gdb_py_events.exited))
     return 0;
 
   event = create_exited_event_object (exit_code, inf);
@@ -302,39 +302,115 @@ py_print_value (struct ui_out *out, struct value *val,
   return PY_BT_OK;
 }
 
-/* Helper function to call a Python method and extract an iterator
-   from the result.  If the function returns anything but an iterator
-   the exception is preserved and NULL is returned.  FILTER is the
-   Python object to call, and FUNC is the name of the method.  Returns
-   a PyObject, or NULL on error with the appropriate exception set.
-   This function can return an iterator, or NULL.  */
+/* Helper function to fetch the frame element NAME of FILTER.  FIELDS
+   is the dictionary returned by FILTER's "frame_fields" method, or
+   NULL; if it has an entry for NAME, that is used.  Otherwise FILTER's
+   method NAME is called.  Returns a new reference, which is Py_None if
+   FILTER has no such method, or NULL on error with the appropriate
+   exception set.  */
 
 static PyObject *
-get_py_iter_from_func (PyObject *filter, char *func)
+get_py_frame_element (PyObject *filter, PyObject *fields, char *name)
 {
-  if (PyObject_HasAttrString (filter, func))
+  if (fields != NULL)
     {
-      PyObject *result = PyObject_CallMethod (filter, func, NULL);
+      PyObject *result = PyDict_GetItemString (fields, name);
 
       if (result != NULL)
 	{
-	  if (result == Py_None)
-	    {
-	      return result;
-	    }
-	  else
-	    {
-	      PyObject *iterator = PyObject_GetIter (result);
-
-	      Py_DECREF (result);
-	      return iterator;
-	    }
+	  Py_INCREF (result);
+	  return result;
 	}
     }
-  else
+
+  if (PyObject_HasAttrString (filter, name))
+    return PyObject_CallMethod (filter, name, NULL);
+
+  Py_RETURN_NONE;
+}
+
+/* Helper function to fetch a frame element and extract an iterator
+   from it.  If the element is anything but an iterable or None the
+   exception is preserved and NULL is returned.  FILTER, FIELDS and
+   FUNC are as for get_py_frame_element.  Returns a PyObject, or NULL
+   on error with the appropriate exception set.  This function can
+   return an iterator, Py_None, or NULL.  */
+
+static PyObject *
+get_py_iter_from_func (PyObject *filter, PyObject *fields, char *func)
+{
+  PyObject *result = get_py_frame_element (filter, fields, func);
+
+  if (result != NULL && result != Py_None)
+    {
+      PyObject *iterator = PyObject_GetIter (result);
+
+      Py_DECREF (result);
+      return iterator;
+    }
+
+  return result;
+}
+
+/* Helper function to ask FILTER for all the frame elements that
+   printing with FLAGS will need, in one call to its "frame_fields"
+   method, rather than calling a method for each.  NEED_ADDRESS is
+   nonzero if the frame's address will be printed.  Returns a new
+   reference to the resulting dictionary, Py_None if FILTER has no
+   "frame_fields" method, or NULL on error with the appropriate
+   exception set.  */
+
+static PyObject *
+get_py_frame_fields (PyObject *filter, int flags, int need_address)
+{
+  PyObject *names, *name, *result;
+  const char *wanted[7];
+  int i, n = 0;
+
+  if (! PyObject_HasAttrString (filter, "frame_fields"))
     Py_RETURN_NONE;
 
-  return NULL;
+  if ((flags & PRINT_FRAME_INFO) && need_address)
+    wanted[n++] = "address";
+  if (flags & PRINT_FRAME_INFO)
+    {
+      wanted[n++] = "function";
+      wanted[n++] = "filename";
+      wanted[n++] = "line";
+    }
+  if (flags & PRINT_ARGS)
+    wanted[n++] = "frame_args";
+  if (flags & PRINT_LOCALS)
+    wanted[n++] = "frame_locals";
+  wanted[n++] = "elided";
+
+  names = PyTuple_New (n);
+  if (names == NULL)
+    return NULL;
+  for (i = 0; i < n; i++)
+    {
+      name = PyString_FromString (wanted[i]);
+      if (name == NULL)
+	{
+	  Py_DECREF (names);
+	  return NULL;
+	}
+      PyTuple_SET_ITEM (names, i, name);
+    }
+
+  result = PyObject_CallMethod (filter, "frame_fields", "O", names);
+  Py_DECREF (names);
+
+  if (result != NULL && ! PyDict_Check (result))
+    {
+      PyErr_SetString (PyExc_RuntimeError,
+		       _("FrameDecorator.frame_fields: expecting a " \
+			 "dictionary."));
+      Py_DECREF (result);
+      return NULL;
+    }
+
+  return result;
 }
 
 /*  Helper function to output a single frame argument and value to an
@@ -860,7 +936,8 @@ enumerate_locals (PyObject *iter,
     error, or PY_BT_OK on success.  */
 
 static enum py_bt_status
-py_mi_print_variables (PyObject *filter, struct ui_out *out,
+py_mi_print_variables (PyObject *filter, PyObject *fields,
+		       struct ui_out *out,
 		       struct value_print_options *opts,
 		       enum py_frame_args args_type,
 		       struct frame_info *frame)
@@ -869,12 +946,12 @@ py_mi_print_variables (PyObject *filter, struct ui_out *out,
   PyObject *args_iter;
   PyObject *locals_iter;
 
-  args_iter = get_py_iter_from_func (filter, "frame_args");
+  args_iter = get_py_iter_from_func (filter, fields, "frame_args");
   old_chain = make_cleanup_py_xdecref (args_iter);
   if (args_iter == NULL)
     goto error;
 
-  locals_iter = get_py_iter_from_func (filter, "frame_locals");
+  locals_iter = get_py_iter_from_func (filter, fields, "frame_locals");
   if (locals_iter == NULL)
     goto error;
 
@@ -904,12 +981,13 @@ py_mi_print_variables (PyObject *filter, struct ui_out *out,
 
 static enum py_bt_status
 py_print_locals (PyObject *filter,
+		 PyObject *fields,
 		 struct ui_out *out,
 		 enum py_frame_args args_type,
 		 int indent,
 		 struct frame_info *frame)
 {
-  PyObject *locals_iter = get_py_iter_from_func (filter,
+  PyObject *locals_iter = get_py_iter_from_func (filter, fields,
 						 "frame_locals");
   struct cleanup *old_chain = make_cleanup_py_xdecref (locals_iter);
 
@@ -938,11 +1016,13 @@ py_print_locals (PyObject *filter,
 
 static enum py_bt_status
 py_print_args (PyObject *filter,
+	       PyObject *fields,
 	       struct ui_out *out,
 	       enum py_frame_args args_type,
 	       struct frame_info *frame)
 {
-  PyObject *args_iter  = get_py_iter_from_func (filter, "frame_args");
+  PyObject *args_iter  = get_py_iter_from_func (filter, fields,
+						 "frame_args");
   struct cleanup *old_chain = make_cleanup_py_xdecref (args_iter);
   volatile struct gdb_exception except;
 
@@ -1011,8 +1091,9 @@ py_print_frame (PyObject *filter, int flags, enum py_frame_args args_type,
   struct frame_info *frame = NULL;
   struct cleanup *cleanup_stack = make_cleanup (null_cleanup, NULL);
   struct value_print_options opts;
-  PyObject *py_inf_frame, *elided;
+  PyObject *py_inf_frame, *elided, *fields;
   int print_level, print_frame_info, print_args, print_locals;
+  int need_address;
   volatile struct gdb_exception except;
 
   /* Extract print settings from FLAGS.  */
@@ -1023,6 +1104,10 @@ py_print_frame (PyObject *filter, int flags, enum py_frame_args args_type,
 
   get_user_print_options (&opts);
 
+  /* The address is only printed if "set print address" is on, but
+     frame annotations above level 1 include it too.  */
+  need_address = opts.addressprint || annotation_level > 1;
+
   /* Get the underlying frame.  This is needed to determine GDB
   architecture, and also, in the cases of frame variables/arguments to
   read them if they returned filter object requires us to do so.  */
@@ -1047,11 +1132,18 @@ py_print_frame (PyObject *filter, int flags, enum py_frame_args args_type,
       goto error;
     }
 
+  /* Fetch everything needed at once, if the decorator allows it.  */
+  fields = get_py_frame_fields (filter, flags, need_address);
+  if (fields == NULL)
+    goto error;
+  make_cleanup_py_decref (fields);
+  if (fields == Py_None)
+    fields = NULL;
 
   /* stack-list-variables.  */
   if (print_locals && print_args && ! print_frame_info)
     {
-      if (py_mi_print_variables (filter, out, &opts,
+      if (py_mi_print_variables (filter, fields, out, &opts,
 				 args_type, frame) == PY_BT_ERROR)
 	goto error;
       else
@@ -1085,9 +1177,11 @@ py_print_frame (PyObject *filter, int flags, enum py_frame_args args_type,
 
       /* The address is required for frame annotations, and also for
 	 address printing.  */
-      if (PyObject_HasAttrString (filter, "address"))
+      if (need_address)
 	{
-	  PyObject *paddr = PyObject_CallMethod (filter, "address", NULL);
+	  PyObject *paddr = get_py_frame_element (filter, fields,
+						  "address");
+
 	  if (paddr != NULL)
 	    {
 	      if (paddr != Py_None)
@@ -1160,9 +1254,10 @@ py_print_frame (PyObject *filter, int flags, enum py_frame_args args_type,
 	}
 
       /* Print frame function name.  */
-      if (PyObject_HasAttrString (filter, "function"))
+      if (fields != NULL || PyObject_HasAttrString (filter, "function"))
 	{
-	  PyObject *py_func = PyObject_CallMethod (filter, "function", NULL);
+	  PyObject *py_func = get_py_frame_element (filter, fields,
+						    "function");
 
 	  if (py_func != NULL)
 	    {
@@ -1230,7 +1325,8 @@ py_print_frame (PyObject *filter, int flags, enum py_frame_args args_type,
      wrong.  */
   if (print_args)
     {
-      if (py_print_args (filter, out, args_type, frame) == PY_BT_ERROR)
+      if (py_print_args (filter, fields, out, args_type,
+			 frame) == PY_BT_ERROR)
 	goto error;
     }
 
@@ -1247,10 +1343,11 @@ py_print_frame (PyObject *filter, int flags, enum py_frame_args args_type,
 	  goto error;
 	}
 
-      if (PyObject_HasAttrString (filter, "filename"))
+      if (fields != NULL || PyObject_HasAttrString (filter, "filename"))
 	{
-	  PyObject *py_fn = PyObject_CallMethod (filter, "filename",
-						 NULL);
+	  PyObject *py_fn = get_py_frame_element (filter, fields,
+						  "filename");
+
 	  if (py_fn != NULL)
 	    {
 	      if (py_fn != Py_None)
@@ -1285,9 +1382,9 @@ py_print_frame (PyObject *filter, int flags, enum py_frame_args args_type,
 	    goto error;
 	}
 
-      if (PyObject_HasAttrString (filter, "line"))
+      if (fields != NULL || PyObject_HasAttrString (filter, "line"))
 	{
-	  PyObject *py_line = PyObject_CallMethod (filter, "line", NULL);
+	  PyObject *py_line = get_py_frame_element (filter, fields, "line");
 	  int line;
 
 	  if (py_line != NULL)
@@ -1333,13 +1430,13 @@ py_print_frame (PyObject *filter, int flags, enum py_frame_args args_type,
 
   if (print_locals)
     {
-      if (py_print_locals (filter, out, args_type, indent,
+      if (py_print_locals (filter, fields, out, args_type, indent,
 			   frame) == PY_BT_ERROR)
 	goto error;
     }
 
   /* Finally recursively print elided frames, if any.  */
-  elided  = get_py_iter_from_func (filter, "elided");
+  elided  = get_py_iter_from_func (filter, fields, "elided");
   if (elided == NULL)
     goto error;
 
@@ -60,6 +60,12 @@ typedef struct {
   PyObject_HEAD
   void *buffer;
 
+  /* If BUFFER points into a read-only mapping of the core file rather
+     than to memory of our own, what to pass to
+     core_file_unmap_memory.  */
+  void *map_addr;
+  bfd_size_type map_len;
+
   /* These are kept just for mbpy_str.  */
   CORE_ADDR addr;
   CORE_ADDR length;
@@ -91,6 +97,9 @@ python_on_normal_stop (struct bpstats *bs, int print_frame)
   if (!find_thread_ptid (inferior_ptid))
       return;
 
+  if (!evregpy_wanted_p (gdb_py_events.stop))
+    return;
+
   stop_signal = inferior_thread ()->suspend.stop_signal;
 
   cleanup = ensure_python_env (get_current_arch (), current_language);
@@ -98,6 +107,11 @@ python_on_normal_stop (struct bpstats *bs, int print_frame)
   if (emit_stop_event (bs, stop_signal) < 0)
     gdbpy_print_stack ();
 
+  /* Listeners of gdb.events.batch get everything up to and including
+     the stop at once.  */
+  if (emit_batch_event () < 0)
+    gdbpy_print_stack ();
+
   do_cleanups (cleanup);
 }
 
@@ -109,6 +123,9 @@ python_on_resume (ptid_t ptid)
   if (!gdb_python_initialized)
     return;
 
+  if (!evregpy_wanted_p (gdb_py_events.cont))
+    return;
+
   cleanup = ensure_python_env (target_gdbarch (), current_language);
 
   if (emit_continue_event (ptid) < 0)
@@ -126,6 +143,9 @@ python_inferior_exit (struct inferior *inf)
   if (!gdb_python_initialized)
     return;
 
+  if (!evregpy_wanted_p (gdb_py_events.exited))
+    return;
+
   cleanup = ensure_python_env (target_gdbarch (), current_language);
 
   if (inf->has_exit_code)
@@ -151,6 +171,11 @@ python_new_objfile (struct objfile *objfile)
   if (!gdb_python_initialized)
     return;
 
+  /* With many shared libraries this is called very often, so don't
+     even take the GIL if no one is listening.  */
+  if (!evregpy_wanted_p (gdb_py_events.new_objfile))
+    return;
+
   cleanup = ensure_python_env (get_objfile_arch (objfile), current_language);
 
   if (emit_new_objfile_event (objfile) < 0)
@@ -421,12 +446,16 @@ gdbpy_inferiors (PyObject *unused, PyObject *unused2)
 /* Implementation of Inferior.read_memory (address, length).
    Returns a Python buffer object with LENGTH bytes of the inferior's
    memory at ADDRESS.  Both arguments are integers.  Returns NULL on error,
-   with a python exception set.  */
+   with a python exception set.  When the memory comes straight from
+   the core file, the buffer is a read-only view of the file's pages
+   instead of a copy.  */
 static PyObject *
 infpy_read_memory (PyObject *self, PyObject *args, PyObject *kw)
 {
   CORE_ADDR addr, length;
   void *buffer = NULL;
+  void *map_addr = NULL;
+  bfd_size_type map_len = 0;
   membuf_object *membuf_obj;
   PyObject *addr_obj, *length_obj, *result;
   volatile struct gdb_exception except;
@@ -442,9 +471,14 @@ infpy_read_memory (PyObject *self, PyObject *args, PyObject *kw)
 
   TRY_CATCH (except, RETURN_MASK_ALL)
     {
-      buffer = xmalloc (length);
-
-      read_memory (addr, buffer, length);
+      buffer = (void *) core_file_map_memory (addr, length,
+					      &map_addr, &map_len);
+      if (buffer == NULL)
+	{
+	  buffer = xmalloc (length);
+
+	  read_memory (addr, buffer, length);
+	}
     }
   if (except.reason < 0)
     {
@@ -455,19 +489,28 @@ infpy_read_memory (PyObject *self, PyObject *args, PyObject *kw)
   membuf_obj = PyObject_New (membuf_object, &membuf_object_type);
   if (membuf_obj == NULL)
     {
-      xfree (buffer);
+      if (map_addr != NULL)
+	core_file_unmap_memory (map_addr, map_len);
+      else
+	xfree (buffer);
       return NULL;
     }
 
   membuf_obj->buffer = buffer;
+  membuf_obj->map_addr = map_addr;
+  membuf_obj->map_len = map_len;
   membuf_obj->addr = addr;
   membuf_obj->length = length;
 
 #ifdef IS_PY3K
   result = PyMemoryView_FromObject ((PyObject *) membuf_obj);
 #else
-  result = PyBuffer_FromReadWriteObject ((PyObject *) membuf_obj, 0,
-					 Py_END_OF_BUFFER);
+  if (map_addr != NULL)
+    result = PyBuffer_FromObject ((PyObject *) membuf_obj, 0,
+				  Py_END_OF_BUFFER);
+  else
+    result = PyBuffer_FromReadWriteObject ((PyObject *) membuf_obj, 0,
+					   Py_END_OF_BUFFER);
 #endif
   Py_DECREF (membuf_obj);
 
@@ -536,7 +579,12 @@ infpy_write_memory (PyObject *self, PyObject *args, PyObject *kw)
 static void
 mbpy_dealloc (PyObject *self)
 {
-  xfree (((membuf_object *) self)->buffer);
+  membuf_object *membuf_obj = (membuf_object *) self;
+
+  if (membuf_obj->map_addr != NULL)
+    core_file_unmap_memory (membuf_obj->map_addr, membuf_obj->map_len);
+  else
+    xfree (membuf_obj->buffer);
   Py_TYPE (self)->tp_free (self);
 }
 
@@ -561,8 +609,8 @@ get_buffer (PyObject *self, Py_buffer *buf, int flags)
   int ret;
   
   ret = PyBuffer_FillInfo (buf, self, membuf_obj->buffer,
-			   membuf_obj->length, 0, 
-			   PyBUF_CONTIG);
+			   membuf_obj->length, membuf_obj->map_addr != NULL,
+			   PyBUF_CONTIG_RO | (flags & PyBUF_WRITABLE));
   buf->format = "c";
 
   return ret;
@@ -590,6 +638,13 @@ get_read_buffer (PyObject *self, Py_ssize_t segment, void **ptrptr)
 static Py_ssize_t
 get_write_buffer (PyObject *self, Py_ssize_t segment, void **ptrptr)
 {
+  if (((membuf_object *) self)->map_addr != NULL)
+    {
+      PyErr_SetString (PyExc_TypeError,
+		       _("The memory buffer is read-only."));
+      return -1;
+    }
+
   return get_read_buffer (self, segment, ptrptr);
 }
 
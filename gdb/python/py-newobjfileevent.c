@@ -57,7 +57,7 @@ emit_new_objfile_event (struct objfile *objfile)
 {
   PyObject *event;
 
-  if (evregpy_no_listeners_p (gdb_py_events.new_objfile))
+  if (!evregpy_wanted_p (gdb_py_events.new_objfile))
     return 0;
 
   event = create_new_objfile_event_object (objfile);
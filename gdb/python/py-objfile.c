@@ -138,6 +138,8 @@ objfpy_set_printers (PyObject *o, PyObject *value, void *ignore)
   self->printers = value;
   Py_XDECREF (tmp);
 
+  gdbpy_clear_printer_cache ();
+
   return 0;
 }
 
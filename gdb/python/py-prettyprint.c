@@ -23,6 +23,8 @@
 #include "symtab.h"
 #include "language.h"
 #include "valprint.h"
+#include "observer.h"
+#include "hashtab.h"
 
 #include "python.h"
 
@@ -41,14 +43,155 @@ enum string_repr_result
     string_repr_ok
   };
 
+/* The lookup functions are called for every value printed, and most
+   of them only look at the value's type.  A lookup function can say so
+   with a true "type_pure" attribute, and GDB then remembers its
+   answer: this cache maps a type to the type-pure lookup function that
+   recognized it, or to nothing if every lookup function consulted was
+   type-pure and none recognized it.  The cache is emptied when
+   objfiles come and go, when a pretty_printers list is replaced, and
+   by gdb.invalidate_cached_pretty_printers, which the gdb.printing
+   module calls when printers are registered, enabled or disabled.  */
+
+struct printer_cache_entry
+{
+  struct type *type;
+
+  /* The lookup function that recognized TYPE, or NULL if none did.  */
+  PyObject *function;
+};
+
+static htab_t printer_cache;
+
+static hashval_t
+hash_printer_cache_entry (const void *p)
+{
+  const struct printer_cache_entry *entry = p;
+
+  return htab_hash_pointer (entry->type);
+}
+
+static int
+eq_printer_cache_entry (const void *a, const void *b)
+{
+  const struct printer_cache_entry *lhs = a;
+  const struct printer_cache_entry *rhs = b;
+
+  return lhs->type == rhs->type;
+}
+
+/* Free a cache entry.  The caller must hold the GIL.  */
+
+static void
+free_printer_cache_entry (void *p)
+{
+  struct printer_cache_entry *entry = p;
+
+  Py_XDECREF (entry->function);
+  xfree (entry);
+}
+
+/* Return the cache entry for TYPE, or NULL if there is none.  This
+   does not need the GIL.  */
+
+static struct printer_cache_entry *
+printer_cache_lookup (struct type *type)
+{
+  struct printer_cache_entry key;
+
+  if (printer_cache == NULL)
+    return NULL;
+
+  key.type = type;
+  return htab_find (printer_cache, &key);
+}
+
+/* Record that FUNCTION, which may be NULL, is the lookup function for
+   TYPE.  The caller must hold the GIL.  */
+
+static void
+printer_cache_store (struct type *type, PyObject *function)
+{
+  struct printer_cache_entry key, *entry;
+  void **slot;
+
+  if (printer_cache == NULL)
+    printer_cache = htab_create_alloc (127, hash_printer_cache_entry,
+				       eq_printer_cache_entry,
+				       free_printer_cache_entry,
+				       xcalloc, xfree);
+
+  key.type = type;
+  slot = htab_find_slot (printer_cache, &key, INSERT);
+  if (*slot != NULL)
+    free_printer_cache_entry (*slot);
+
+  entry = XNEW (struct printer_cache_entry);
+  entry->type = type;
+  entry->function = function;
+  Py_XINCREF (function);
+  *slot = entry;
+}
+
+/* See python-internal.h.  */
+
+void
+gdbpy_clear_printer_cache (void)
+{
+  if (printer_cache != NULL)
+    htab_empty (printer_cache);
+}
+
+/* Empty the cache from an observer, where the GIL is not held.  */
+
+static void
+printer_cache_clear_observer (struct objfile *objfile)
+{
+  struct cleanup *cleanup;
+  struct gdbarch *gdbarch;
+
+  if (printer_cache == NULL || htab_elements (printer_cache) == 0)
+    return;
+
+  gdbarch = objfile != NULL ? get_objfile_arch (objfile) : target_gdbarch ();
+  cleanup = ensure_python_env (gdbarch, current_language);
+  gdbpy_clear_printer_cache ();
+  do_cleanups (cleanup);
+}
+
+/* Return 1 if FUNCTION has a true "type_pure" attribute, 0 if not, and
+   -1 with the Python error set on error.  */
+
+static int
+type_pure_p (PyObject *function)
+{
+  PyObject *attr;
+  int cmp;
+
+  if (!PyObject_HasAttr (function, gdbpy_type_pure_cst))
+    return 0;
+
+  attr = PyObject_GetAttr (function, gdbpy_type_pure_cst);
+  if (attr == NULL)
+    return -1;
+  cmp = PyObject_IsTrue (attr);
+  Py_DECREF (attr);
+  return cmp;
+}
+
 /* Helper function for find_pretty_printer which iterates over a list,
    calls each function and inspects output.  This will return a
    printer object if one recognizes VALUE.  If no printer is found, it
    will return None.  On error, it will set the Python error and
-   return NULL.  */
+   return NULL.
+
+   *PURE is cleared if a function that is not type-pure was called.
+   If a printer is found, *LOOKUP is set to a new reference to the
+   function that returned it.  */
 
 static PyObject *
-search_pp_list (PyObject *list, PyObject *value)
+search_pp_list (PyObject *list, PyObject *value, int *pure,
+		PyObject **lookup)
 {
   Py_ssize_t pp_list_size, list_index;
   PyObject *function, *printer = NULL;
@@ -77,11 +220,25 @@ search_pp_list (PyObject *list, PyObject *value)
 	    continue;
 	}
 
+      if (*pure)
+	{
+	  int cmp = type_pure_p (function);
+
+	  if (cmp == -1)
+	    return NULL;
+	  if (!cmp)
+	    *pure = 0;
+	}
+
       printer = PyObject_CallFunctionObjArgs (function, value, NULL);
       if (! printer)
 	return NULL;
       else if (printer != Py_None)
-	return printer;
+	{
+	  Py_INCREF (function);
+	  *lookup = function;
+	  return printer;
+	}
 
       Py_DECREF (printer);
     }
@@ -93,10 +250,12 @@ search_pp_list (PyObject *list, PyObject *value)
    Look for a pretty-printer to print VALUE in all objfiles.
    The result is NULL if there's an error and the search should be terminated.
    The result is Py_None, suitably inc-ref'd, if no pretty-printer was found.
-   Otherwise the result is the pretty-printer function, suitably inc-ref'd.  */
+   Otherwise the result is the pretty-printer function, suitably inc-ref'd.
+   PURE and LOOKUP are as for search_pp_list.  */
 
 static PyObject *
-find_pretty_printer_from_objfiles (PyObject *value)
+find_pretty_printer_from_objfiles (PyObject *value, int *pure,
+				   PyObject **lookup)
 {
   PyObject *pp_list;
   PyObject *function;
@@ -113,7 +272,7 @@ find_pretty_printer_from_objfiles (PyObject *value)
       }
 
     pp_list = objfpy_get_printers (objf, NULL);
-    function = search_pp_list (pp_list, value);
+    function = search_pp_list (pp_list, value, pure, lookup);
     Py_XDECREF (pp_list);
 
     /* If there is an error in any objfile list, abort the search and exit.  */
@@ -133,10 +292,12 @@ find_pretty_printer_from_objfiles (PyObject *value)
    Look for a pretty-printer to print VALUE in the current program space.
    The result is NULL if there's an error and the search should be terminated.
    The result is Py_None, suitably inc-ref'd, if no pretty-printer was found.
-   Otherwise the result is the pretty-printer function, suitably inc-ref'd.  */
+   Otherwise the result is the pretty-printer function, suitably inc-ref'd.
+   PURE and LOOKUP are as for search_pp_list.  */
 
 static PyObject *
-find_pretty_printer_from_progspace (PyObject *value)
+find_pretty_printer_from_progspace (PyObject *value, int *pure,
+				    PyObject **lookup)
 {
   PyObject *pp_list;
   PyObject *function;
@@ -145,7 +306,7 @@ find_pretty_printer_from_progspace (PyObject *value)
   if (!obj)
     return NULL;
   pp_list = pspy_get_printers (obj, NULL);
-  function = search_pp_list (pp_list, value);
+  function = search_pp_list (pp_list, value, pure, lookup);
   Py_XDECREF (pp_list);
   return function;
 }
@@ -154,10 +315,12 @@ find_pretty_printer_from_progspace (PyObject *value)
    Look for a pretty-printer to print VALUE in the gdb module.
    The result is NULL if there's an error and the search should be terminated.
    The result is Py_None, suitably inc-ref'd, if no pretty-printer was found.
-   Otherwise the result is the pretty-printer function, suitably inc-ref'd.  */
+   Otherwise the result is the pretty-printer function, suitably inc-ref'd.
+   PURE and LOOKUP are as for search_pp_list.  */
 
 static PyObject *
-find_pretty_printer_from_gdb (PyObject *value)
+find_pretty_printer_from_gdb (PyObject *value, int *pure,
+			      PyObject **lookup)
 {
   PyObject *pp_list;
   PyObject *function;
@@ -173,7 +336,7 @@ find_pretty_printer_from_gdb (PyObject *value)
       Py_RETURN_NONE;
     }
 
-  function = search_pp_list (pp_list, value);
+  function = search_pp_list (pp_list, value, pure, lookup);
   Py_XDECREF (pp_list);
   return function;
 }
@@ -185,23 +348,40 @@ find_pretty_printer_from_gdb (PyObject *value)
 static PyObject *
 find_pretty_printer (PyObject *value)
 {
+  struct type *type = value_type (value_object_to_value (value));
+  struct printer_cache_entry *entry;
   PyObject *function;
+  PyObject *lookup = NULL;
+  int pure = 1;
+
+  entry = printer_cache_lookup (type);
+  if (entry != NULL)
+    {
+      if (entry->function == NULL)
+	Py_RETURN_NONE;
+      return PyObject_CallFunctionObjArgs (entry->function, value, NULL);
+    }
 
   /* Look at the pretty-printer list for each objfile
      in the current program-space.  */
-  function = find_pretty_printer_from_objfiles (value);
+  function = find_pretty_printer_from_objfiles (value, &pure, &lookup);
   if (function == NULL || function != Py_None)
-    return function;
+    goto done;
   Py_DECREF (function);
 
   /* Look at the pretty-printer list for the current program-space.  */
-  function = find_pretty_printer_from_progspace (value);
+  function = find_pretty_printer_from_progspace (value, &pure, &lookup);
   if (function == NULL || function != Py_None)
-    return function;
+    goto done;
   Py_DECREF (function);
 
   /* Look at the pretty-printer list in the gdb module.  */
-  function = find_pretty_printer_from_gdb (value);
+  function = find_pretty_printer_from_gdb (value, &pure, &lookup);
+
+ done:
+  if (function != NULL && pure)
+    printer_cache_store (type, lookup);
+  Py_XDECREF (lookup);
   return function;
 }
 
@@ -695,6 +875,7 @@ apply_val_pretty_printer (struct type *type, const gdb_byte *valaddr,
 			  const struct language_defn *language)
 {
   struct gdbarch *gdbarch = get_type_arch (type);
+  struct printer_cache_entry *entry;
   PyObject *printer = NULL;
   PyObject *val_obj = NULL;
   struct value *value;
@@ -710,6 +891,12 @@ apply_val_pretty_printer (struct type *type, const gdb_byte *valaddr,
   if (!gdb_python_initialized)
     return 0;
 
+  /* Don't build a gdb.Value just to learn again that no printer
+     recognizes TYPE.  */
+  entry = printer_cache_lookup (type);
+  if (entry != NULL && entry->function == NULL)
+    return 0;
+
   cleanups = ensure_python_env (gdbarch, language);
 
   /* Instantiate the printer.  */
@@ -839,6 +1026,24 @@ gdbpy_default_visualizer (PyObject *self, PyObject *args)
   return cons;
 }
 
+/* Implementation of gdb.invalidate_cached_pretty_printers () -> None.
+   Forget which printers were found for which types.  */
+
+PyObject *
+gdbpy_invalidate_cached_pretty_printers (PyObject *self, PyObject *args)
+{
+  gdbpy_clear_printer_cache ();
+  Py_RETURN_NONE;
+}
+
+int
+gdbpy_initialize_prettyprint (void)
+{
+  observer_attach_new_objfile (printer_cache_clear_observer);
+  observer_attach_free_objfile (printer_cache_clear_observer);
+  return 0;
+}
+
 #else /* HAVE_PYTHON */
 
 int
@@ -50,7 +50,7 @@ emit_stop_event (struct bpstats *bs, enum gdb_signal stop_signal)
   PyObject *first_bp = NULL;
   struct bpstats *current_bs;
 
-  if (evregpy_no_listeners_p (gdb_py_events.stop))
+  if (!evregpy_wanted_p (gdb_py_events.stop))
     return 0;
 
   /* Add any breakpoint set at this location to the list.  */
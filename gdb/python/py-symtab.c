@@ -186,6 +186,97 @@ stpy_static_block (PyObject *self, PyObject *args)
   return block_to_block_object (block, symtab->objfile);
 }
 
+/* Return the line table of the underlying symtab, as a tuple of
+   (pc, line) tuples in the table's order.  This is much cheaper than
+   looking up one address at a time.  */
+
+static PyObject *
+stpy_linetable (PyObject *self, PyObject *args)
+{
+  struct symtab *symtab = NULL;
+  struct linetable *table;
+  PyObject *result;
+  int i, nitems;
+
+  STPY_REQUIRE_VALID (self, symtab);
+
+  table = LINETABLE (symtab);
+  nitems = table == NULL ? 0 : table->nitems;
+
+  result = PyTuple_New (nitems);
+  if (result == NULL)
+    return NULL;
+
+  for (i = 0; i < nitems; i++)
+    {
+      struct linetable_entry *entry = &table->item[i];
+      PyObject *item;
+
+      item = Py_BuildValue ("(Ni)", gdb_py_long_from_ulongest (entry->pc),
+			    entry->line);
+      if (item == NULL)
+	{
+	  Py_DECREF (result);
+	  return NULL;
+	}
+      PyTuple_SET_ITEM (result, i, item);
+    }
+
+  return result;
+}
+
+/* Return the address ranges of all the blocks of the underlying
+   symtab, as a tuple of (start, end, function) tuples, where FUNCTION
+   is the name of the function the block belongs to, or None.  This
+   avoids creating a gdb.Block, and a gdb.Symbol for each of its
+   symbols, just to find out where code lives.  */
+
+static PyObject *
+stpy_block_ranges (PyObject *self, PyObject *args)
+{
+  struct symtab *symtab = NULL;
+  struct blockvector *blockvector;
+  PyObject *result;
+  int i, nblocks;
+
+  STPY_REQUIRE_VALID (self, symtab);
+
+  blockvector = BLOCKVECTOR (symtab);
+  nblocks = BLOCKVECTOR_NBLOCKS (blockvector);
+
+  result = PyTuple_New (nblocks);
+  if (result == NULL)
+    return NULL;
+
+  for (i = 0; i < nblocks; i++)
+    {
+      struct block *block = BLOCKVECTOR_BLOCK (blockvector, i);
+      struct symbol *function = BLOCK_FUNCTION (block);
+      PyObject *item, *name;
+
+      if (function != NULL)
+	name = PyString_FromString (SYMBOL_PRINT_NAME (function));
+      else
+	{
+	  name = Py_None;
+	  Py_INCREF (name);
+	}
+
+      item = Py_BuildValue ("(NNN)",
+			    gdb_py_long_from_ulongest (BLOCK_START (block)),
+			    gdb_py_long_from_ulongest (BLOCK_END (block)),
+			    name);
+      if (item == NULL)
+	{
+	  Py_DECREF (result);
+	  return NULL;
+	}
+      PyTuple_SET_ITEM (result, i, item);
+    }
+
+  return result;
+}
+
 static PyObject *
 salpy_str (PyObject *self)
 {
@@ -532,6 +623,12 @@ Return the global block of the symbol table." },
   { "static_block", stpy_static_block, METH_NOARGS,
     "static_block () -> gdb.Block.\n\
 Return the static block of the symbol table." },
+  { "linetable", stpy_linetable, METH_NOARGS,
+    "linetable () -> Tuple.\n\
+Return the line table of the symbol table, as (pc, line) pairs." },
+  { "block_ranges", stpy_block_ranges, METH_NOARGS,
+    "block_ranges () -> Tuple.\n\
+Return the (start, end, function) of each block of the symbol table." },
   {NULL}  /* Sentinel */
 };
 
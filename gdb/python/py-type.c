@@ -31,6 +31,8 @@
 #include "bcache.h"
 #include "dwarf2loc.h"
 #include "typeprint.h"
+#include "observer.h"
+#include "progspace.h"
 
 typedef struct pyty_type_object
 {
@@ -251,6 +253,177 @@ convert_field (struct type *type, int field)
   return NULL;
 }
 
+/* Each objfile with cached data in this file has one of these.  */
+
+struct typy_objfile_cache
+{
+  /* The field tuples of the objfile's types, as struct
+     typy_fields_entry objects.  */
+  htab_t fields;
+};
+
+/* An entry in the field tuple cache.  */
+
+struct typy_fields_entry
+{
+  struct type *type;
+
+  /* A tuple holding one gdb.Field object per field of TYPE.  */
+  PyObject *fields;
+};
+
+static const struct objfile_data *typy_cache_data_key;
+
+static void clear_type_lookup_cache (void);
+
+/* Hash function for struct typy_fields_entry.  */
+
+static hashval_t
+hash_typy_fields_entry (const void *p)
+{
+  const struct typy_fields_entry *entry = p;
+
+  return htab_hash_pointer (entry->type);
+}
+
+/* Equality function for struct typy_fields_entry.  */
+
+static int
+eq_typy_fields_entry (const void *a, const void *b)
+{
+  const struct typy_fields_entry *lhs = a;
+  const struct typy_fields_entry *rhs = b;
+
+  return lhs->type == rhs->type;
+}
+
+/* Free a field tuple cache entry.  The caller must hold the GIL.  */
+
+static void
+free_typy_fields_entry (void *p)
+{
+  struct typy_fields_entry *entry = p;
+
+  Py_DECREF (entry->fields);
+  xfree (entry);
+}
+
+/* Return the cache for OBJFILE, creating it if necessary.  */
+
+static struct typy_objfile_cache *
+get_typy_objfile_cache (struct objfile *objfile)
+{
+  struct typy_objfile_cache *cache;
+
+  cache = objfile_data (objfile, typy_cache_data_key);
+  if (cache == NULL)
+    {
+      cache = XNEW (struct typy_objfile_cache);
+      cache->fields = htab_create_alloc (127, hash_typy_fields_entry,
+					 eq_typy_fields_entry,
+					 free_typy_fields_entry,
+					 xcalloc, xfree);
+      set_objfile_data (objfile, typy_cache_data_key, cache);
+    }
+
+  return cache;
+}
+
+/* Free the cached data of an objfile that is going away.  Type
+   lookups may have found one of its types, so the lookup cache is
+   emptied as well.  */
+
+static void
+free_typy_objfile_cache (struct objfile *objfile, void *datum)
+{
+  struct typy_objfile_cache *cache = datum;
+  struct cleanup *cleanup;
+
+  clear_type_lookup_cache ();
+
+  if (!gdb_python_initialized)
+    return;
+
+  cleanup = ensure_python_env (get_objfile_arch (objfile), current_language);
+  htab_delete (cache->fields);
+  xfree (cache);
+  do_cleanups (cleanup);
+}
+
+/* Return a new reference to a tuple holding one gdb.Field object
+   for each field of TYPE, or NULL on error.  The tuple of a type
+   owned by an objfile is computed once and cached until the objfile
+   is freed, so callers must not modify it.  */
+
+static PyObject *
+typy_get_fields_tuple (struct type *type)
+{
+  struct typy_objfile_cache *cache = NULL;
+  struct typy_fields_entry key, *entry;
+  PyObject *result;
+  void **slot;
+  int i;
+
+  if (TYPE_OBJFILE_OWNED (type) && TYPE_OBJFILE (type) != NULL)
+    {
+      cache = get_typy_objfile_cache (TYPE_OBJFILE (type));
+      key.type = type;
+      entry = htab_find (cache->fields, &key);
+      if (entry != NULL)
+	{
+	  Py_INCREF (entry->fields);
+	  return entry->fields;
+	}
+    }
+
+  result = PyTuple_New (TYPE_NFIELDS (type));
+  if (result == NULL)
+    return NULL;
+
+  for (i = 0; i < TYPE_NFIELDS (type); i++)
+    {
+      PyObject *field = convert_field (type, i);
+
+      if (field == NULL)
+	{
+	  Py_DECREF (result);
+	  return NULL;
+	}
+      PyTuple_SET_ITEM (result, i, field);
+    }
+
+  if (cache != NULL)
+    {
+      slot = htab_find_slot (cache->fields, &key, INSERT);
+      entry = XNEW (struct typy_fields_entry);
+      entry->type = type;
+      entry->fields = result;
+      Py_INCREF (result);
+      *slot = entry;
+    }
+
+  return result;
+}
+
+/* Return a new reference to the gdb.Field object for field FIELD of
+   TYPE, using the cached field tuple.  Returns NULL on error.  */
+
+static PyObject *
+typy_get_field (struct type *type, int field)
+{
+  PyObject *fields, *result;
+
+  fields = typy_get_fields_tuple (type);
+  if (fields == NULL)
+    return NULL;
+
+  result = PyTuple_GET_ITEM (fields, field);
+  Py_INCREF (result);
+  Py_DECREF (fields);
+
+  return result;
+}
+
 /* Helper function to return the name of a field, as a gdb.Field object.
    If the field doesn't have a name, None is returned.  */
 
@@ -286,7 +459,7 @@ make_fielditem (struct type *type, int i, enum gdbpy_iter_kind kind)
       key = field_name (type, i);
       if (key == NULL)
 	goto fail;
-      value = convert_field (type, i);
+      value = typy_get_field (type, i);
       if (value == NULL)
 	goto fail;
       item = PyTuple_New (2);
@@ -299,7 +472,7 @@ make_fielditem (struct type *type, int i, enum gdbpy_iter_kind kind)
       item = field_name (type, i);
       break;
     case iter_values:
-      item =  convert_field (type, i);
+      item = typy_get_field (type, i);
       break;
     default:
       gdb_assert_not_reached ("invalid gdbpy_iter_kind");
@@ -331,6 +504,17 @@ typy_fields_items (PyObject *self, enum gdbpy_iter_kind kind)
     }
   GDB_PY_HANDLE_EXCEPTION (except);
 
+  if (kind == iter_values)
+    {
+      PyObject *fields = typy_get_fields_tuple (checked_type);
+
+      if (fields == NULL)
+	return NULL;
+      result = PySequence_List (fields);
+      Py_DECREF (fields);
+      return result;
+    }
+
   if (checked_type != type)
     py_type = type_to_type_object (checked_type);
   iter = typy_make_iter (py_type, kind);
@@ -707,12 +891,96 @@ typy_get_sizeof (PyObject *self, void *closure)
   return gdb_py_long_from_longest (TYPE_LENGTH (type));
 }
 
+/* An entry in the cache of global type lookups.  The result of a
+   lookup depends on the language and architecture that Python code
+   runs with, and on the program space searched.  */
+
+struct type_lookup_entry
+{
+  char *name;
+  const struct language_defn *language;
+  struct gdbarch *gdbarch;
+  struct program_space *pspace;
+  struct type *type;
+};
+
+/* The cache of lookups done by typy_lookup_typename without a block.
+   It is emptied whenever an objfile is added or freed, since either
+   can change the result of a lookup.  */
+
+static htab_t type_lookup_cache;
+
+/* Hash function for struct type_lookup_entry.  */
+
+static hashval_t
+hash_type_lookup_entry (const void *p)
+{
+  const struct type_lookup_entry *entry = p;
+
+  return htab_hash_string (entry->name);
+}
+
+/* Equality function for struct type_lookup_entry.  */
+
+static int
+eq_type_lookup_entry (const void *a, const void *b)
+{
+  const struct type_lookup_entry *lhs = a;
+  const struct type_lookup_entry *rhs = b;
+
+  return (lhs->language == rhs->language
+	  && lhs->gdbarch == rhs->gdbarch
+	  && lhs->pspace == rhs->pspace
+	  && strcmp (lhs->name, rhs->name) == 0);
+}
+
+/* Free a type lookup cache entry.  */
+
+static void
+free_type_lookup_entry (void *p)
+{
+  struct type_lookup_entry *entry = p;
+
+  xfree (entry->name);
+  xfree (entry);
+}
+
+/* Empty the type lookup cache.  */
+
+static void
+clear_type_lookup_cache (void)
+{
+  if (type_lookup_cache != NULL)
+    htab_empty (type_lookup_cache);
+}
+
+/* A new_objfile observer that empties the type lookup cache.  */
+
+static void
+type_lookup_cache_clear_observer (struct objfile *objfile)
+{
+  clear_type_lookup_cache ();
+}
+
 static struct type *
 typy_lookup_typename (const char *type_name, const struct block *block)
 {
   struct type *type = NULL;
+  struct type_lookup_entry key, *entry;
+  void **slot;
   volatile struct gdb_exception except;
 
+  if (block == NULL && type_lookup_cache != NULL)
+    {
+      key.name = (char *) type_name;
+      key.language = python_language;
+      key.gdbarch = python_gdbarch;
+      key.pspace = current_program_space;
+      entry = htab_find (type_lookup_cache, &key);
+      if (entry != NULL)
+	return entry->type;
+    }
+
   TRY_CATCH (except, RETURN_MASK_ALL)
     {
       if (!strncmp (type_name, "struct ", 7))
@@ -727,6 +995,36 @@ typy_lookup_typename (const char *type_name, const struct block *block)
     }
   GDB_PY_HANDLE_EXCEPTION (except);
 
+  /* Remember the result.  The cache for the type's objfile must
+     exist so that freeing the objfile flushes this entry.  */
+  if (block == NULL && type != NULL)
+    {
+      if (TYPE_OBJFILE_OWNED (type) && TYPE_OBJFILE (type) != NULL)
+	get_typy_objfile_cache (TYPE_OBJFILE (type));
+
+      if (type_lookup_cache == NULL)
+	type_lookup_cache = htab_create_alloc (127, hash_type_lookup_entry,
+					       eq_type_lookup_entry,
+					       free_type_lookup_entry,
+					       xcalloc, xfree);
+
+      key.name = (char *) type_name;
+      key.language = python_language;
+      key.gdbarch = python_gdbarch;
+      key.pspace = current_program_space;
+      slot = htab_find_slot (type_lookup_cache, &key, INSERT);
+      if (*slot == NULL)
+	{
+	  entry = XNEW (struct type_lookup_entry);
+	  entry->name = xstrdup (type_name);
+	  entry->language = python_language;
+	  entry->gdbarch = python_gdbarch;
+	  entry->pspace = current_program_space;
+	  entry->type = type;
+	  *slot = entry;
+	}
+    }
+
   return type;
 }
 
@@ -1307,7 +1605,7 @@ typy_getitem (PyObject *self, PyObject *key)
 
       if (t_field_name && (strcmp_iw (t_field_name, field) == 0))
 	{
-	  return convert_field (type, i);
+	  return typy_get_field (type, i);
 	}
     }
   PyErr_SetObject (PyExc_KeyError, key);
@@ -1528,6 +1826,9 @@ gdbpy_initialize_types (void)
 
   typy_objfile_data_key
     = register_objfile_data_with_cleanup (save_objfile_types, NULL);
+  typy_cache_data_key
+    = register_objfile_data_with_cleanup (NULL, free_typy_objfile_cache);
+  observer_attach_new_objfile (type_lookup_cache_clear_observer);
 
   if (PyType_Ready (&type_object_type) < 0)
     return -1;
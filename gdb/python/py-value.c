@@ -729,6 +729,113 @@ valpy_hash (PyObject *self)
   return (long) (intptr_t) self;
 }
 
+/* Fetch the contents of the value SELF, setting *LENGTH to their size.
+   Returns NULL on error, with a python exception set.  The contents
+   stay put for as long as the value exists, so the buffer interface
+   can hand them out without copying.  */
+
+static const gdb_byte *
+valpy_get_contents (PyObject *self, Py_ssize_t *length)
+{
+  struct value *value = ((value_object *) self)->value;
+  const gdb_byte *contents = NULL;
+  volatile struct gdb_exception except;
+
+  TRY_CATCH (except, RETURN_MASK_ALL)
+    {
+      contents = value_contents (value);
+      *length = TYPE_LENGTH (check_typedef (value_type (value)));
+    }
+  if (except.reason < 0)
+    {
+      gdbpy_convert_exception (except);
+      return NULL;
+    }
+
+  return contents;
+}
+
+#ifdef IS_PY3K
+
+/* Implement the buffer protocol: a value's contents, as bytes.  The
+   buffer is read-only, since writing to it would not change the
+   inferior.  */
+
+static int
+valpy_get_buffer (PyObject *self, Py_buffer *buf, int flags)
+{
+  const gdb_byte *contents;
+  Py_ssize_t length;
+  int ret;
+
+  contents = valpy_get_contents (self, &length);
+  if (contents == NULL)
+    {
+      buf->obj = NULL;
+      return -1;
+    }
+
+  ret = PyBuffer_FillInfo (buf, self, (void *) contents, length, 1, flags);
+  buf->format = "B";
+
+  return ret;
+}
+
+#else
+
+static Py_ssize_t
+valpy_get_read_buffer (PyObject *self, Py_ssize_t segment, void **ptrptr)
+{
+  const gdb_byte *contents;
+  Py_ssize_t length;
+
+  if (segment)
+    {
+      PyErr_SetString (PyExc_SystemError,
+		       _("A gdb.Value buffer supports only one segment."));
+      return -1;
+    }
+
+  contents = valpy_get_contents (self, &length);
+  if (contents == NULL)
+    return -1;
+
+  *ptrptr = (void *) contents;
+  return length;
+}
+
+static Py_ssize_t
+valpy_get_seg_count (PyObject *self, Py_ssize_t *lenp)
+{
+  if (lenp)
+    {
+      const gdb_byte *contents = valpy_get_contents (self, lenp);
+
+      /* There's no way to report an error from here.  */
+      if (contents == NULL)
+	{
+	  PyErr_Clear ();
+	  *lenp = 0;
+	}
+    }
+
+  return 1;
+}
+
+static Py_ssize_t
+valpy_get_char_buffer (PyObject *self, Py_ssize_t segment, char **ptrptr)
+{
+  void *ptr = NULL;
+  Py_ssize_t ret;
+
+  ret = valpy_get_read_buffer (self, segment, &ptr);
+  *ptrptr = (char *) ptr;
+
+  return ret;
+}
+
+#endif	/* IS_PY3K */
+
 enum valpy_opcode
 {
   VALPY_ADD,
@@ -1500,6 +1607,31 @@ static PyMappingMethods value_object_as_mapping = {
   valpy_setitem
 };
 
+#ifdef IS_PY3K
+
+static PyBufferProcs value_object_as_buffer = {
+  valpy_get_buffer
+};
+
+#else
+
+/* Python doesn't provide a decent way to get compatibility here.  */
+#if HAVE_LIBPYTHON2_4
+#define CHARBUFFERPROC_NAME getcharbufferproc
+#else
+#define CHARBUFFERPROC_NAME charbufferproc
+#endif
+
+static PyBufferProcs value_object_as_buffer = {
+  valpy_get_read_buffer,
+  NULL,
+  valpy_get_seg_count,
+  /* The cast here works around a difference between Python 2.4 and
+     Python 2.5.  */
+  (CHARBUFFERPROC_NAME) valpy_get_char_buffer
+};
+#endif	/* IS_PY3K */
+
 PyTypeObject value_object_type = {
   PyVarObject_HEAD_INIT (NULL, 0)
   "gdb.Value",			  /*tp_name*/
@@ -1519,7 +1651,7 @@ PyTypeObject value_object_type = {
   valpy_str,			  /*tp_str*/
   0,				  /*tp_getattro*/
   0,				  /*tp_setattro*/
-  0,				  /*tp_as_buffer*/
+  &value_object_as_buffer,	  /*tp_as_buffer*/
   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_CHECKTYPES
   | Py_TPFLAGS_BASETYPE,	  /*tp_flags*/
   "GDB value object",		  /* tp_doc */
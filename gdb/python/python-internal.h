@@ -365,6 +365,8 @@ int gdbpy_initialize_pspace (void)
   CPYCHECKER_NEGATIVE_RESULT_SETS_EXCEPTION;
 int gdbpy_initialize_objfile (void)
   CPYCHECKER_NEGATIVE_RESULT_SETS_EXCEPTION;
+int gdbpy_initialize_prettyprint (void)
+  CPYCHECKER_NEGATIVE_RESULT_SETS_EXCEPTION;
 int gdbpy_initialize_breakpoints (void)
   CPYCHECKER_NEGATIVE_RESULT_SETS_EXCEPTION;
 int gdbpy_initialize_finishbreakpoints (void)
@@ -397,6 +399,8 @@ int gdbpy_initialize_thread_event (void)
   CPYCHECKER_NEGATIVE_RESULT_SETS_EXCEPTION;
 int gdbpy_initialize_new_objfile_event (void)
   CPYCHECKER_NEGATIVE_RESULT_SETS_EXCEPTION;
+int gdbpy_initialize_batch_event (void)
+  CPYCHECKER_NEGATIVE_RESULT_SETS_EXCEPTION;
 int gdbpy_initialize_arch (void)
   CPYCHECKER_NEGATIVE_RESULT_SETS_EXCEPTION;
 
@@ -460,6 +464,14 @@ PyObject *apply_varobj_pretty_printer (PyObject *print_obj,
 PyObject *gdbpy_get_varobj_pretty_printer (struct value *value);
 char *gdbpy_get_display_hint (PyObject *printer);
 PyObject *gdbpy_default_visualizer (PyObject *self, PyObject *args);
+PyObject *gdbpy_invalidate_cached_pretty_printers (PyObject *self,
+						  PyObject *args);
+
+/* Forget which pretty-printer was found for which type.  Call this
+   when the pretty-printer lists change.  The caller must hold the
+   GIL.  */
+
+void gdbpy_clear_printer_cache (void);
 
 void bpfinishpy_pre_stop_hook (struct breakpoint_object *bp_obj);
 void bpfinishpy_post_stop_hook (struct breakpoint_object *bp_obj);
@@ -469,6 +481,7 @@ extern PyObject *gdbpy_children_cst;
 extern PyObject *gdbpy_to_string_cst;
 extern PyObject *gdbpy_display_hint_cst;
 extern PyObject *gdbpy_enabled_cst;
+extern PyObject *gdbpy_type_pure_cst;
 extern PyObject *gdbpy_value_cst;
 
 /* Exception types.  */
@@ -72,6 +72,7 @@ static const char *gdbpy_should_print_stack = python_excp_message;
 #include "observer.h"
 #include "interps.h"
 #include "event-top.h"
+#include "py-event.h"
 
 /* True if Python has been successfully initialized, false
    otherwise.  */
@@ -93,6 +94,7 @@ PyObject *gdbpy_children_cst;
 PyObject *gdbpy_display_hint_cst;
 PyObject *gdbpy_doc_cst;
 PyObject *gdbpy_enabled_cst;
+PyObject *gdbpy_type_pure_cst;
 PyObject *gdbpy_value_cst;
 
 /* The GdbError exception.  */
@@ -910,6 +912,11 @@ before_prompt_hook (const char *current_gdb_prompt)
 
   cleanup = ensure_python_env (get_current_arch (), current_language);
 
+  /* Deliver whatever happened outside of a stop, such as objfiles
+     loaded by a command.  */
+  if (emit_batch_event () < 0)
+    gdbpy_print_stack ();
+
   if (gdb_python_module
       && PyObject_HasAttrString (gdb_python_module, "prompt_hook"))
     {
@@ -1670,6 +1677,7 @@ message == an error message without a stack will be printed."),
       || gdbpy_initialize_types () < 0
       || gdbpy_initialize_pspace () < 0
       || gdbpy_initialize_objfile () < 0
+      || gdbpy_initialize_prettyprint () < 0
       || gdbpy_initialize_breakpoints () < 0
       || gdbpy_initialize_finishbreakpoints () < 0
       || gdbpy_initialize_lazy_string () < 0
@@ -1686,6 +1694,7 @@ message == an error message without a stack will be printed."),
       || gdbpy_initialize_exited_event () < 0
       || gdbpy_initialize_thread_event () < 0
       || gdbpy_initialize_new_objfile_event ()  < 0
+      || gdbpy_initialize_batch_event () < 0
       || gdbpy_initialize_arch () < 0)
     goto fail;
 
@@ -1706,6 +1715,9 @@ message == an error message without a stack will be printed."),
   gdbpy_enabled_cst = PyString_FromString ("enabled");
   if (gdbpy_enabled_cst == NULL)
     goto fail;
+  gdbpy_type_pure_cst = PyString_FromString ("type_pure");
+  if (gdbpy_type_pure_cst == NULL)
+    goto fail;
   gdbpy_value_cst = PyString_FromString ("value");
   if (gdbpy_value_cst == NULL)
     goto fail;
@@ -1837,6 +1849,10 @@ set to True." },
 
   { "default_visualizer", gdbpy_default_visualizer, METH_VARARGS,
     "Find the default visualizer for a Value." },
+  { "invalidate_cached_pretty_printers",
+    gdbpy_invalidate_cached_pretty_printers, METH_NOARGS,
+    "invalidate_cached_pretty_printers () -> None.\n\
+Forget which pretty-printers were found for which types." },
 
   { "current_progspace", gdbpy_get_current_progspace, METH_NOARGS,
     "Return the current Progspace." },
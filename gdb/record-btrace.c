@@ -217,6 +217,7 @@ record_btrace_info (void)
   btrace_fetch (tp);
 
   btinfo = &tp->btrace;
+  btrace_update_ftrace (btinfo);
   insts = VEC_length (btrace_inst_s, btinfo->itrace);
   funcs = VEC_length (btrace_func_s, btinfo->ftrace);
 
@@ -503,6 +504,7 @@ record_btrace_call_history (int size, int flags)
   uiout_cleanup = make_cleanup_ui_out_tuple_begin_end (uiout,
 						       "insn history");
   btinfo = require_btrace ();
+  btrace_update_ftrace (btinfo);
   last = VEC_length (btrace_func_s, btinfo->ftrace);
 
   context = abs (size);
@@ -578,6 +580,7 @@ record_btrace_call_history_range (ULONGEST from, ULONGEST to, int flags)
   uiout_cleanup = make_cleanup_ui_out_tuple_begin_end (uiout,
 						       "func history");
   btinfo = require_btrace ();
+  btrace_update_ftrace (btinfo);
   last = VEC_length (btrace_func_s, btinfo->ftrace);
 
   begin = (unsigned int) from;
@@ -74,7 +74,11 @@
    instruction.
 
    Each struct record_full_entry is linked to "record_full_list" by "prev"
-   and "next" pointers.  */
+   and "next" pointers.
+
+   The value of a record_full_reg or record_full_mem entry follows it
+   in memory, so an entry takes just the space it needs.  See
+   record_full_entry_size.  */
 
 struct record_full_mem_entry
 {
@@ -83,22 +87,16 @@ struct record_full_mem_entry
   /* Set this flag if target memory for this entry
      can no longer be accessed.  */
   int mem_entry_not_accessible;
-  union
-  {
-    gdb_byte *ptr;
-    gdb_byte buf[sizeof (gdb_byte *)];
-  } u;
+  /* The LEN bytes of the value, actually.  */
+  gdb_byte buf[1];
 };
 
 struct record_full_reg_entry
 {
   unsigned short num;
   unsigned short len;
-  union 
-  {
-    gdb_byte *ptr;
-    gdb_byte buf[2 * sizeof (gdb_byte *)];
-  } u;
+  /* The LEN bytes of the value, actually.  */
+  gdb_byte buf[1];
 };
 
 struct record_full_end_entry
@@ -154,6 +152,44 @@ struct record_full_entry
   } u;
 };
 
+/* The entries of the execution log are allocated one after the other
+   from a series of chunks, in the order they are linked in the log,
+   with the entries of the instruction being recorded last.  Entries
+   are only released at the ends: the first ones when the log is full,
+   and the last ones when the log is cut short or an instruction can't
+   be recorded.  This saves the overhead of allocating each entry and
+   its value separately, and releasing entries costs next to
+   nothing.  */
+
+struct record_full_chunk
+{
+  struct record_full_chunk *prev;
+  struct record_full_chunk *next;
+
+  /* The entries still in use are between BOTTOM and TOP.  */
+  gdb_byte *bottom;
+  gdb_byte *top;
+
+  /* The end of the space of this chunk.  */
+  gdb_byte *end;
+};
+
+/* The usual size of a chunk.  A larger entry gets a chunk of its
+   own.  */
+#define RECORD_FULL_CHUNK_SIZE (64 * 1024)
+
+/* Round N up to keep the entries aligned.  */
+#define RECORD_FULL_ALIGN(n) \
+  (((n) + sizeof (ULONGEST) - 1) & ~(sizeof (ULONGEST) - 1))
+
+/* The first and last chunks of the execution log.  */
+static struct record_full_chunk *record_full_chunk_first;
+static struct record_full_chunk *record_full_chunk_last;
+
+/* A chunk of the usual size no longer used, kept to save allocating a
+   new one when the log is full and moves forward.  */
+static struct record_full_chunk *record_full_chunk_spare;
+
 /* If true, query if PREC cannot record memory
    change of next instruction.  */
 int record_full_memory_query = 0;
@@ -204,6 +240,45 @@ static unsigned int record_full_insn_num = 0;
    than count of insns presently in execution log).  */
 static ULONGEST record_full_insn_count;
 
+/* The effects of instructions that the architecture's process_record
+   found to depend only on the bytes of the instruction are remembered
+   by address, so that the next time the same instruction is executed
+   they are added to the arch list without decoding it again.  */
+
+/* One change made by a cached instruction: register REGNUM, or if
+   REGNUM is -1, LEN bytes of memory at ADDR.  */
+
+struct record_full_cached_effect
+{
+  int regnum;
+  CORE_ADDR addr;
+  int len;
+};
+
+/* The longest instruction whose effects are cached.  */
+
+#define RECORD_FULL_CACHED_INSN_MAX 16
+
+struct record_full_cached_insn
+{
+  struct gdbarch *gdbarch;
+  CORE_ADDR addr;
+
+  /* The instruction bytes that were decoded.  The cached effects are
+     only used while the memory at ADDR still holds them.  */
+  int len;
+  gdb_byte insn[RECORD_FULL_CACHED_INSN_MAX];
+
+  int num_effects;
+  struct record_full_cached_effect effects[1];
+};
+
+/* The cache is emptied when it grows to this many instructions.  */
+
+#define RECORD_FULL_INSN_CACHE_MAX 65536
+
+static htab_t record_full_insn_cache;
+
 /* The target_ops of process record.  */
 static struct target_ops record_full_ops;
 static struct target_ops record_full_core_ops;
@@ -253,6 +328,146 @@ static void record_full_goto_insn (struct record_full_entry *entry,
 				   enum exec_direction_kind dir);
 static void record_full_save (const char *recfilename);
 
+/* Return the space taken by an entry of type TYPE whose value has LEN
+   bytes.  */
+
+static size_t
+record_full_entry_size (enum record_full_type type, int len)
+{
+  size_t size;
+
+  switch (type)
+    {
+    case record_full_reg:
+      size = offsetof (struct record_full_entry, u.reg.buf) + len;
+      break;
+    case record_full_mem:
+      size = offsetof (struct record_full_entry, u.mem.buf) + len;
+      break;
+    default:
+      size = (offsetof (struct record_full_entry, u)
+	      + sizeof (struct record_full_end_entry));
+      break;
+    }
+
+  return RECORD_FULL_ALIGN (size);
+}
+
+/* Return the start of the space for entries of CHUNK.  */
+
+static gdb_byte *
+record_full_chunk_data (struct record_full_chunk *chunk)
+{
+  return ((gdb_byte *) chunk
+	  + RECORD_FULL_ALIGN (sizeof (struct record_full_chunk)));
+}
+
+/* Unlink CHUNK, which holds no entry anymore, from the chunks of the
+   execution log, and free it.  */
+
+static void
+record_full_chunk_release (struct record_full_chunk *chunk)
+{
+  if (chunk->prev != NULL)
+    chunk->prev->next = chunk->next;
+  else
+    record_full_chunk_first = chunk->next;
+  if (chunk->next != NULL)
+    chunk->next->prev = chunk->prev;
+  else
+    record_full_chunk_last = chunk->prev;
+
+  if (record_full_chunk_spare == NULL
+      && chunk->end == (record_full_chunk_data (chunk)
+			+ RECORD_FULL_CHUNK_SIZE))
+    record_full_chunk_spare = chunk;
+  else
+    xfree (chunk);
+}
+
+/* Free all the chunks of the execution log, which must not hold any
+   entry anymore.  */
+
+static void
+record_full_chunks_release (void)
+{
+  while (record_full_chunk_first != NULL)
+    {
+      gdb_assert (record_full_chunk_first->bottom
+		  == record_full_chunk_first->top);
+      record_full_chunk_release (record_full_chunk_first);
+    }
+
+  xfree (record_full_chunk_spare);
+  record_full_chunk_spare = NULL;
+}
+
+/* Allocate an entry of type TYPE whose value has LEN bytes, after all
+   the others.  */
+
+static struct record_full_entry *
+record_full_entry_alloc (enum record_full_type type, int len)
+{
+  size_t size = record_full_entry_size (type, len);
+  struct record_full_chunk *chunk = record_full_chunk_last;
+  struct record_full_entry *rec;
+
+  if (chunk == NULL || chunk->end - chunk->top < size)
+    {
+      size_t data_size = (size > RECORD_FULL_CHUNK_SIZE
+			  ? size : RECORD_FULL_CHUNK_SIZE);
+
+      if (data_size == RECORD_FULL_CHUNK_SIZE
+	  && record_full_chunk_spare != NULL)
+	{
+	  chunk = record_full_chunk_spare;
+	  record_full_chunk_spare = NULL;
+	}
+      else
+	chunk = xmalloc (RECORD_FULL_ALIGN (sizeof (struct record_full_chunk))
+			 + data_size);
+
+      chunk->bottom = chunk->top = record_full_chunk_data (chunk);
+      chunk->end = chunk->top + data_size;
+      chunk->next = NULL;
+      chunk->prev = record_full_chunk_last;
+      if (record_full_chunk_last != NULL)
+	record_full_chunk_last->next = chunk;
+      else
+	record_full_chunk_first = chunk;
+      record_full_chunk_last = chunk;
+    }
+
+  rec = (struct record_full_entry *) chunk->top;
+  chunk->top += size;
+
+  memset (rec, 0, offsetof (struct record_full_entry, u));
+  rec->type = type;
+  return rec;
+}
+
+/* Free REC, which must be the first or the last entry allocated.  */
+
+static void
+record_full_entry_free (struct record_full_entry *rec, int len)
+{
+  size_t size = record_full_entry_size (rec->type, len);
+  struct record_full_chunk *chunk;
+
+  chunk = record_full_chunk_last;
+  if (chunk != NULL && (gdb_byte *) rec + size == chunk->top)
+    chunk->top = (gdb_byte *) rec;
+  else
+    {
+      chunk = record_full_chunk_first;
+      gdb_assert (chunk != NULL && (gdb_byte *) rec == chunk->bottom);
+      chunk->bottom += size;
+    }
+
+  if (chunk->bottom == chunk->top)
+    record_full_chunk_release (chunk);
+}
+
 /* Alloc and free functions for record_full_reg, record_full_mem, and
    record_full_end entries.  */
 
@@ -263,13 +478,11 @@ record_full_reg_alloc (struct regcache *regcache, int regnum)
 {
   struct record_full_entry *rec;
   struct gdbarch *gdbarch = get_regcache_arch (regcache);
+  int len = register_size (gdbarch, regnum);
 
-  rec = xcalloc (1, sizeof (struct record_full_entry));
-  rec->type = record_full_reg;
+  rec = record_full_entry_alloc (record_full_reg, len);
   rec->u.reg.num = regnum;
-  rec->u.reg.len = register_size (gdbarch, regnum);
-  if (rec->u.reg.len > sizeof (rec->u.reg.u.buf))
-    rec->u.reg.u.ptr = (gdb_byte *) xmalloc (rec->u.reg.len);
+  rec->u.reg.len = len;
 
   return rec;
 }
@@ -280,9 +493,7 @@ static inline void
 record_full_reg_release (struct record_full_entry *rec)
 {
   gdb_assert (rec->type == record_full_reg);
-  if (rec->u.reg.len > sizeof (rec->u.reg.u.buf))
-    xfree (rec->u.reg.u.ptr);
-  xfree (rec);
+  record_full_entry_free (rec, rec->u.reg.len);
 }
 
 /* Alloc a record_full_mem record entry.  */
@@ -292,12 +503,10 @@ record_full_mem_alloc (CORE_ADDR addr, int len)
 {
   struct record_full_entry *rec;
 
-  rec = xcalloc (1, sizeof (struct record_full_entry));
-  rec->type = record_full_mem;
+  rec = record_full_entry_alloc (record_full_mem, len);
   rec->u.mem.addr = addr;
   rec->u.mem.len = len;
-  if (rec->u.mem.len > sizeof (rec->u.mem.u.buf))
-    rec->u.mem.u.ptr = (gdb_byte *) xmalloc (len);
+  rec->u.mem.mem_entry_not_accessible = 0;
 
   return rec;
 }
@@ -308,9 +517,7 @@ static inline void
 record_full_mem_release (struct record_full_entry *rec)
 {
   gdb_assert (rec->type == record_full_mem);
-  if (rec->u.mem.len > sizeof (rec->u.mem.u.buf))
-    xfree (rec->u.mem.u.ptr);
-  xfree (rec);
+  record_full_entry_free (rec, rec->u.mem.len);
 }
 
 /* Alloc a record_full_end record entry.  */
@@ -320,8 +527,9 @@ record_full_end_alloc (void)
 {
   struct record_full_entry *rec;
 
-  rec = xcalloc (1, sizeof (struct record_full_entry));
-  rec->type = record_full_end;
+  rec = record_full_entry_alloc (record_full_end, 0);
+  rec->u.end.sigval = GDB_SIGNAL_0;
+  rec->u.end.insn_num = 0;
 
   return rec;
 }
@@ -331,7 +539,7 @@ record_full_end_alloc (void)
 static inline void
 record_full_end_release (struct record_full_entry *rec)
 {
-  xfree (rec);
+  record_full_entry_free (rec, 0);
 }
 
 /* Free one record entry, any type.
@@ -387,19 +595,25 @@ record_full_list_release (struct record_full_entry *rec)
 static void
 record_full_list_release_following (struct record_full_entry *rec)
 {
-  struct record_full_entry *tmp = rec->next;
+  struct record_full_entry *tmp = rec;
 
-  rec->next = NULL;
-  while (tmp)
+  /* Free the entries from the last one, which was allocated last.  */
+  while (tmp->next)
+    tmp = tmp->next;
+
+  while (tmp != rec)
     {
-      rec = tmp->next;
+      struct record_full_entry *prev = tmp->prev;
+
       if (record_full_entry_release (tmp) == record_full_end)
 	{
 	  record_full_insn_num--;
 	  record_full_insn_count--;
 	}
-      tmp = rec;
+      tmp = prev;
     }
+
+  rec->next = NULL;
 }
 
 /* Delete the first instruction from the beginning of the log, to make
@@ -464,15 +678,9 @@ record_full_get_loc (struct record_full_entry *rec)
 {
   switch (rec->type) {
   case record_full_mem:
-    if (rec->u.mem.len > sizeof (rec->u.mem.u.buf))
-      return rec->u.mem.u.ptr;
-    else
-      return rec->u.mem.u.buf;
+    return rec->u.mem.buf;
   case record_full_reg:
-    if (rec->u.reg.len > sizeof (rec->u.reg.u.buf))
-      return rec->u.reg.u.ptr;
-    else
-      return rec->u.reg.u.buf;
+    return rec->u.reg.buf;
   case record_full_end:
   default:
     gdb_assert_not_reached ("unexpected record_full_entry type");
@@ -495,10 +703,12 @@ record_full_arch_list_add_reg (struct regcache *regcache, int regnum)
 
   rec = record_full_reg_alloc (regcache, regnum);
 
-  regcache_raw_read (regcache, regnum, record_full_get_loc (rec));
-
+  /* Add it first, so that it is released along with the arch list if
+     reading the register fails.  */
   record_full_arch_list_add (rec);
 
+  regcache_raw_read (regcache, regnum, record_full_get_loc (rec));
+
   return 0;
 }
 
@@ -554,6 +764,168 @@ record_full_arch_list_add_end (void)
   return 0;
 }
 
+/* Hash function for record_full_insn_cache.  */
+
+static hashval_t
+record_full_cached_insn_hash (const void *p)
+{
+  const struct record_full_cached_insn *insn = p;
+
+  return (hashval_t) insn->addr ^ htab_hash_pointer (insn->gdbarch);
+}
+
+/* Equality function for record_full_insn_cache.  */
+
+static int
+record_full_cached_insn_eq (const void *a, const void *b)
+{
+  const struct record_full_cached_insn *insn_a = a;
+  const struct record_full_cached_insn *insn_b = b;
+
+  return (insn_a->addr == insn_b->addr
+	  && insn_a->gdbarch == insn_b->gdbarch);
+}
+
+/* Look for the instruction at ADDR in record_full_insn_cache.  Return
+   NULL if it isn't cached.  */
+
+static struct record_full_cached_insn *
+record_full_insn_cache_find (struct gdbarch *gdbarch, CORE_ADDR addr)
+{
+  struct record_full_cached_insn key;
+
+  if (record_full_insn_cache == NULL)
+    return NULL;
+
+  key.gdbarch = gdbarch;
+  key.addr = addr;
+  return htab_find (record_full_insn_cache, &key);
+}
+
+/* Remember that the changes just added to the arch list, by the
+   instruction at ADDR whose first LEN bytes were decoded, depend only
+   on those bytes.  The next time the instruction is recorded, the
+   same registers and memory are saved without calling
+   gdbarch_process_record.  */
+
+void
+record_full_arch_list_cache (struct gdbarch *gdbarch, CORE_ADDR addr,
+			     int len)
+{
+  struct record_full_cached_insn *insn;
+  struct record_full_entry *rec;
+  int num_effects = 0;
+  void **slot;
+
+  if (len <= 0 || len > RECORD_FULL_CACHED_INSN_MAX
+      || record_full_arch_list_tail == NULL
+      || record_full_arch_list_tail->type != record_full_end)
+    return;
+
+  for (rec = record_full_arch_list_head;
+       rec != record_full_arch_list_tail;
+       rec = rec->next)
+    {
+      if (rec->type == record_full_end)
+	return;
+      num_effects++;
+    }
+
+  insn = xmalloc (sizeof (struct record_full_cached_insn)
+		  + (num_effects - 1)
+		  * sizeof (struct record_full_cached_effect));
+  insn->gdbarch = gdbarch;
+  insn->addr = addr;
+  insn->len = len;
+  if (target_read_memory (addr, insn->insn, len) != 0)
+    {
+      xfree (insn);
+      return;
+    }
+
+  insn->num_effects = 0;
+  for (rec = record_full_arch_list_head;
+       rec != record_full_arch_list_tail;
+       rec = rec->next)
+    {
+      struct record_full_cached_effect *effect
+	= &insn->effects[insn->num_effects++];
+
+      if (rec->type == record_full_reg)
+	{
+	  effect->regnum = rec->u.reg.num;
+	  effect->addr = 0;
+	  effect->len = 0;
+	}
+      else
+	{
+	  effect->regnum = -1;
+	  effect->addr = rec->u.mem.addr;
+	  effect->len = rec->u.mem.len;
+	}
+    }
+
+  if (record_full_insn_cache == NULL)
+    record_full_insn_cache = htab_create (1024, record_full_cached_insn_hash,
+					  record_full_cached_insn_eq, xfree);
+  else if (htab_elements (record_full_insn_cache)
+	   >= RECORD_FULL_INSN_CACHE_MAX)
+    htab_empty (record_full_insn_cache);
+
+  slot = htab_find_slot (record_full_insn_cache, insn, INSERT);
+  if (*slot != NULL)
+    xfree (*slot);
+  *slot = insn;
+}
+
+/* If the effects of the instruction at PC are cached and its bytes
+   are unchanged, add them to the arch list.  Return 1 if so, 0 if the
+   instruction must be decoded, or -1 if saving a value failed.  */
+
+static int
+record_full_arch_list_add_cached (struct regcache *regcache, CORE_ADDR pc)
+{
+  struct gdbarch *gdbarch = get_regcache_arch (regcache);
+  struct record_full_cached_insn *insn;
+  gdb_byte buf[RECORD_FULL_CACHED_INSN_MAX];
+  int i;
+
+  insn = record_full_insn_cache_find (gdbarch, pc);
+  if (insn == NULL)
+    return 0;
+
+  if (target_read_memory (pc, buf, insn->len) != 0
+      || memcmp (buf, insn->insn, insn->len) != 0)
+    {
+      htab_remove_elt (record_full_insn_cache, insn);
+      return 0;
+    }
+
+  if (record_debug > 1)
+    fprintf_unfiltered (gdb_stdlog,
+			"Process record: using cached effects of the "
+			"instruction at %s.\n",
+			paddress (gdbarch, pc));
+
+  for (i = 0; i < insn->num_effects; i++)
+    {
+      struct record_full_cached_effect *effect = &insn->effects[i];
+
+      if (effect->regnum >= 0)
+	{
+	  if (record_full_arch_list_add_reg (regcache, effect->regnum))
+	    return -1;
+	}
+      else if (record_full_arch_list_add_mem (effect->addr, effect->len))
+	return -1;
+    }
+
+  if (record_full_arch_list_add_end ())
+    return -1;
+
+  return 1;
+}
+
 static void
 record_full_check_insn_num (int set_terminal)
 {
@@ -636,9 +1008,15 @@ record_full_message (struct regcache *regcache, enum gdb_signal signal)
 
   if (signal == GDB_SIGNAL_0
       || !gdbarch_process_record_signal_p (gdbarch))
-    ret = gdbarch_process_record (gdbarch,
-				  regcache,
-				  regcache_read_pc (regcache));
+    {
+      CORE_ADDR pc = regcache_read_pc (regcache);
+
+      ret = record_full_arch_list_add_cached (regcache, pc);
+      if (ret > 0)
+	ret = 0;
+      else if (ret == 0)
+	ret = gdbarch_process_record (gdbarch, regcache, pc);
+    }
   else
     ret = gdbarch_process_record_signal (gdbarch,
 					 regcache,
@@ -710,6 +1088,234 @@ record_full_gdb_operation_disable_set (void)
 /* Flag set to TRUE for target_stopped_by_watchpoint.  */
 static int record_full_hw_watchpoint = 0;
 
+/* While replaying many instructions at once, the registers and memory
+   they change are only updated in GDB's copies, and written back to
+   the target once when the replay stops, instead of reading and
+   writing the target for every entry.  A register's copy lives in the
+   regcache.  Memory is copied in blocks of RECORD_FULL_REPLAY_BLOCK
+   bytes.  */
+
+#define RECORD_FULL_REPLAY_BLOCK 256
+
+struct record_full_replay_block
+{
+  CORE_ADDR addr;
+
+  /* The range of DATA that must be written back.  DIRTY_START is
+     greater than or equal to DIRTY_END if nothing changed.  */
+  int dirty_start;
+  int dirty_end;
+
+  gdb_byte data[RECORD_FULL_REPLAY_BLOCK];
+};
+
+/* The regcache being replayed into, or NULL if entries are executed
+   directly on the target.  */
+static struct regcache *record_full_replay_regcache;
+
+/* For each raw register, nonzero if it must be written back.  */
+static gdb_byte *record_full_replay_dirty_regs;
+
+/* The memory blocks copied so far.  */
+static htab_t record_full_replay_blocks;
+
+/* Hash function for record_full_replay_blocks.  */
+
+static hashval_t
+record_full_replay_block_hash (const void *p)
+{
+  const struct record_full_replay_block *block = p;
+
+  return (hashval_t) (block->addr / RECORD_FULL_REPLAY_BLOCK);
+}
+
+/* Equality function for record_full_replay_blocks.  */
+
+static int
+record_full_replay_block_eq (const void *a, const void *b)
+{
+  const struct record_full_replay_block *block_a = a;
+  const struct record_full_replay_block *block_b = b;
+
+  return block_a->addr == block_b->addr;
+}
+
+/* Start executing entries into GDB's copies of the state of
+   REGCACHE's thread.  */
+
+static void
+record_full_replay_begin (struct regcache *regcache)
+{
+  struct gdbarch *gdbarch = get_regcache_arch (regcache);
+
+  gdb_assert (record_full_replay_regcache == NULL);
+
+  record_full_replay_regcache = regcache;
+  record_full_replay_dirty_regs = xzalloc (gdbarch_num_regs (gdbarch));
+  record_full_replay_blocks
+    = htab_create (64, record_full_replay_block_hash,
+		   record_full_replay_block_eq, xfree);
+}
+
+/* Write BLOCK's changes back to the target.  */
+
+static void
+record_full_replay_write_block (struct record_full_replay_block *block)
+{
+  if (block->dirty_start >= block->dirty_end)
+    return;
+
+  if (target_write_memory (block->addr + block->dirty_start,
+			   block->data + block->dirty_start,
+			   block->dirty_end - block->dirty_start)
+      && record_debug)
+    warning (_("Process record: error writing memory at "
+	       "addr = %s len = %d."),
+	     paddress (target_gdbarch (), block->addr + block->dirty_start),
+	     block->dirty_end - block->dirty_start);
+  block->dirty_start = RECORD_FULL_REPLAY_BLOCK;
+  block->dirty_end = 0;
+}
+
+/* Callback for htab_traverse, writing back one block.  */
+
+static int
+record_full_replay_write_block_1 (void **slot, void *ignore)
+{
+  record_full_replay_write_block (*slot);
+  return 1;
+}
+
+/* Write all changed registers and memory back to the target, and
+   return to executing entries directly on it.  */
+
+static void
+record_full_replay_end (void)
+{
+  struct regcache *regcache = record_full_replay_regcache;
+  int regnum, num_regs;
+
+  if (regcache == NULL)
+    return;
+
+  record_full_replay_regcache = NULL;
+  num_regs = gdbarch_num_regs (get_regcache_arch (regcache));
+  for (regnum = 0; regnum < num_regs; regnum++)
+    if (record_full_replay_dirty_regs[regnum])
+      break;
+  if (regnum < num_regs)
+    {
+      target_prepare_to_store (regcache);
+      for (; regnum < num_regs; regnum++)
+	if (record_full_replay_dirty_regs[regnum])
+	  target_store_registers (regcache, regnum);
+    }
+  xfree (record_full_replay_dirty_regs);
+  record_full_replay_dirty_regs = NULL;
+
+  htab_traverse_noresize (record_full_replay_blocks,
+			  record_full_replay_write_block_1, NULL);
+  htab_delete (record_full_replay_blocks);
+  record_full_replay_blocks = NULL;
+}
+
+/* Cleanup version of record_full_replay_end.  */
+
+static void
+record_full_replay_end_cleanup (void *ignore)
+{
+  record_full_replay_end ();
+}
+
+/* Return the copy of the block of memory at ADDR, reading it if
+   needed.  If CREATE is zero and the block wasn't copied yet, or if
+   it can't be read, return NULL.  */
+
+static struct record_full_replay_block *
+record_full_replay_get_block (CORE_ADDR addr, int create)
+{
+  struct record_full_replay_block key, *block;
+  void **slot;
+
+  key.addr = addr;
+  slot = htab_find_slot (record_full_replay_blocks, &key,
+			 create ? INSERT : NO_INSERT);
+  if (slot == NULL)
+    return NULL;
+  if (*slot != NULL)
+    return *slot;
+
+  block = xmalloc (sizeof (struct record_full_replay_block));
+  if (target_read_memory (addr, block->data, RECORD_FULL_REPLAY_BLOCK))
+    {
+      xfree (block);
+      htab_clear_slot (record_full_replay_blocks, slot);
+      return NULL;
+    }
+  block->addr = addr;
+  block->dirty_start = RECORD_FULL_REPLAY_BLOCK;
+  block->dirty_end = 0;
+  *slot = block;
+  return block;
+}
+
+/* Execute the memory entry ENTRY on the copies of the blocks it
+   covers.  Return zero if some block can't be read; the blocks of
+   ENTRY were then written back and dropped, so that the entry can be
+   executed directly on the target.  */
+
+static int
+record_full_replay_swap_mem (struct record_full_entry *entry)
+{
+  CORE_ADDR start = entry->u.mem.addr;
+  CORE_ADDR end = start + entry->u.mem.len;
+  CORE_ADDR first = start - start % RECORD_FULL_REPLAY_BLOCK;
+  CORE_ADDR addr;
+  gdb_byte *loc = record_full_get_loc (entry);
+
+  for (addr = first; addr < end; addr += RECORD_FULL_REPLAY_BLOCK)
+    if (record_full_replay_get_block (addr, 1) == NULL)
+      {
+	for (addr = first; addr < end; addr += RECORD_FULL_REPLAY_BLOCK)
+	  {
+	    struct record_full_replay_block *block
+	      = record_full_replay_get_block (addr, 0);
+
+	    if (block != NULL)
+	      {
+		record_full_replay_write_block (block);
+		htab_remove_elt (record_full_replay_blocks, block);
+	      }
+	  }
+	return 0;
+      }
+
+  for (addr = first; addr < end; addr += RECORD_FULL_REPLAY_BLOCK)
+    {
+      struct record_full_replay_block *block
+	= record_full_replay_get_block (addr, 0);
+      CORE_ADDR lo = max (start, addr);
+      CORE_ADDR hi = min (end, addr + RECORD_FULL_REPLAY_BLOCK);
+      int offset = lo - addr;
+      int len = hi - lo;
+      gdb_byte tmp;
+      int i;
+
+      for (i = 0; i < len; i++)
+	{
+	  tmp = block->data[offset + i];
+	  block->data[offset + i] = loc[lo - start + i];
+	  loc[lo - start + i] = tmp;
+	}
+      if (offset < block->dirty_start)
+	block->dirty_start = offset;
+      if (offset + len > block->dirty_end)
+	block->dirty_end = offset + len;
+    }
+
+  return 1;
+}
+
 /* Execute one instruction from the record log.  Each instruction in
    the log will be represented by an arbitrary sequence of register
    entries and memory entries, followed by an 'end' entry.  */
@@ -733,8 +1339,16 @@ record_full_exec_insn (struct regcache *regcache,
                               entry->u.reg.num);
 
         regcache_cooked_read (regcache, entry->u.reg.num, reg);
-        regcache_cooked_write (regcache, entry->u.reg.num, 
-			       record_full_get_loc (entry));
+	if (regcache == record_full_replay_regcache
+	    && !gdbarch_cannot_store_register (gdbarch, entry->u.reg.num))
+	  {
+	    regcache_raw_supply (regcache, entry->u.reg.num,
+				 record_full_get_loc (entry));
+	    record_full_replay_dirty_regs[entry->u.reg.num] = 1;
+	  }
+	else
+	  regcache_cooked_write (regcache, entry->u.reg.num,
+				 record_full_get_loc (entry));
         memcpy (record_full_get_loc (entry), reg, entry->u.reg.len);
       }
       break;
@@ -754,8 +1368,16 @@ record_full_exec_insn (struct regcache *regcache,
                                   paddress (gdbarch, entry->u.mem.addr),
                                   entry->u.mem.len);
 
-            if (record_read_memory (gdbarch,
-				    entry->u.mem.addr, mem, entry->u.mem.len))
+            if (record_full_replay_regcache != NULL
+		&& record_full_replay_swap_mem (entry))
+	      {
+		if (hardware_watchpoint_inserted_in_range
+		    (get_regcache_aspace (regcache),
+		     entry->u.mem.addr, entry->u.mem.len))
+		  record_full_hw_watchpoint = 1;
+	      }
+	    else if (record_read_memory (gdbarch, entry->u.mem.addr, mem,
+					 entry->u.mem.len))
 	      entry->u.mem.mem_entry_not_accessible = 1;
             else
               {
@@ -1024,6 +1646,13 @@ record_full_close (void)
     fprintf_unfiltered (gdb_stdlog, "Process record: record_full_close\n");
 
   record_full_list_release (record_full_list);
+  record_full_chunks_release ();
+
+  if (record_full_insn_cache != NULL)
+    {
+      htab_delete (record_full_insn_cache);
+      record_full_insn_cache = NULL;
+    }
 
   /* Release record_full_core_regbuf.  */
   if (record_full_core_regbuf)
@@ -1372,6 +2001,8 @@ record_full_wait_1 (struct target_ops *ops,
 
       /* Loop over the record_full_list, looking for the next place to
 	 stop.  */
+      record_full_replay_begin (regcache);
+      make_cleanup (record_full_replay_end_cleanup, NULL);
       do
 	{
 	  /* Check for beginning and end of log.  */
@@ -1472,6 +2103,7 @@ record_full_wait_1 (struct target_ops *ops,
 	    }
 	}
       while (continue_flag);
+      record_full_replay_end ();
 
 replay_out:
       if (record_full_get_sig)
@@ -2492,6 +3124,7 @@ record_full_restore (void)
 	  regnum = netorder32 (regnum);
 
           rec = record_full_reg_alloc (regcache, regnum);
+	  record_full_arch_list_add (rec);
 
           /* Get val.  */
           bfdcore_read (core_bfd, osec, record_full_get_loc (rec),
@@ -2518,6 +3151,7 @@ record_full_restore (void)
 	  addr = netorder64 (addr);
 
           rec = record_full_mem_alloc (addr, len);
+	  record_full_arch_list_add (rec);
 
           /* Get val.  */
           bfdcore_read (core_bfd, osec, record_full_get_loc (rec),
@@ -2536,6 +3170,7 @@ record_full_restore (void)
 
         case record_full_end: /* end */
           rec = record_full_end_alloc ();
+	  record_full_arch_list_add (rec);
           record_full_insn_num ++;
 
 	  /* Get signal value.  */
@@ -2565,9 +3200,6 @@ record_full_restore (void)
 		 bfd_get_filename (core_bfd));
           break;
         }
-
-      /* Add rec to record arch list.  */
-      record_full_arch_list_add (rec);
     }
 
   discard_cleanups (old_cleanups);
@@ -2853,6 +3485,9 @@ record_full_goto_insn (struct record_full_entry *entry,
   if (dir == EXEC_FORWARD)
     record_full_list = record_full_list->next;
 
+  record_full_replay_begin (regcache);
+  make_cleanup (record_full_replay_end_cleanup, NULL);
+
   do
     {
       record_full_exec_insn (regcache, gdbarch, record_full_list);
@@ -43,6 +43,13 @@
 
 struct gdbarch_data *regcache_descr_handle;
 
+/* The register buffer of a regcache is split into chunks of about
+   this many bytes, each holding a run of whole registers.  Chunks are
+   reference counted, so that copies of a regcache share them until
+   one of the copies writes to a register.  */
+
+#define REGCACHE_CHUNK_SIZE 256
+
 struct regcache_descr
 {
   /* The architecture this descriptor belongs to.  */
@@ -74,6 +81,16 @@ struct regcache_descr
   long *register_offset;
   long *sizeof_register;
 
+  /* The layout of the register chunks.  Register REGNUM lives in
+     chunk REGISTER_CHUNK[REGNUM], which covers the bytes
+     [CHUNK_OFFSET[CHUNK] .. CHUNK_OFFSET[CHUNK + 1]) of the register
+     buffer.  The raw registers exactly fill the first NR_RAW_CHUNKS
+     chunks.  */
+  int nr_raw_chunks;
+  int nr_cooked_chunks;
+  int *register_chunk;
+  long *chunk_offset;
+
   /* Cached table containing the type of each register.  */
   struct type **register_type;
 };
@@ -144,6 +161,38 @@ init_regcache_descr (struct gdbarch *gdbarch)
     descr->sizeof_cooked_registers = offset;
   }
 
+  /* Group the registers into chunks, starting a new chunk once the
+     current one is big enough, and at the first pseudo register.  */
+  {
+    int chunk = 0;
+
+    descr->register_chunk
+      = GDBARCH_OBSTACK_CALLOC (gdbarch, descr->nr_cooked_registers, int);
+    descr->chunk_offset
+      = GDBARCH_OBSTACK_CALLOC (gdbarch, descr->nr_cooked_registers + 2,
+				long);
+    descr->chunk_offset[0] = 0;
+    descr->nr_raw_chunks = 0;
+    for (i = 0; i < descr->nr_cooked_registers; i++)
+      {
+	if (i == descr->nr_raw_registers
+	    || (descr->register_offset[i] - descr->chunk_offset[chunk]
+		>= REGCACHE_CHUNK_SIZE))
+	  {
+	    if (i == descr->nr_raw_registers)
+	      descr->nr_raw_chunks = chunk + 1;
+	    chunk++;
+	    descr->chunk_offset[chunk] = descr->register_offset[i];
+	  }
+	descr->register_chunk[i] = chunk;
+      }
+    chunk++;
+    descr->chunk_offset[chunk] = descr->sizeof_cooked_registers;
+    descr->nr_cooked_chunks = chunk;
+    if (descr->nr_raw_registers == descr->nr_cooked_registers)
+      descr->nr_raw_chunks = chunk;
+  }
+
   return descr;
 }
 
@@ -181,6 +230,19 @@ register_size (struct gdbarch *gdbarch, int regnum)
   return size;
 }
 
+/* A chunk of a register buffer, shared by all the regcaches that
+   hold the same values for its registers.  */
+
+struct regcache_chunk
+{
+  /* The number of regcaches using this chunk.  */
+  int refcount;
+
+  /* The register contents.  The size of the chunk is given by the
+     regcache_descr's CHUNK_OFFSET.  */
+  gdb_byte data[1];
+};
+
 /* The register cache for storing raw register values.  */
 
 struct regcache
@@ -191,10 +253,12 @@ struct regcache
      makes sense, like PC or SP).  */
   struct address_space *aspace;
 
-  /* The register buffers.  A read-only register cache can hold the
-     full [0 .. gdbarch_num_regs + gdbarch_num_pseudo_regs) while a read/write
-     register cache can only hold [0 .. gdbarch_num_regs).  */
-  gdb_byte *registers;
+  /* The register buffers, as an array of chunks.  A read-only
+     register cache can hold the full [0 .. gdbarch_num_regs +
+     gdbarch_num_pseudo_regs) while a read/write register cache can
+     only hold [0 .. gdbarch_num_regs).  Chunks may be shared with
+     other regcaches; see register_buffer_for_write.  */
+  struct regcache_chunk **chunks;
   /* Register cache status.  */
   signed char *register_status;
   /* Is this a read-only cache?  A read-only cache is used for saving
@@ -209,12 +273,57 @@ struct regcache
   ptid_t ptid;
 };
 
+/* Return the number of chunks REGCACHE's register buffer has.  */
+
+static int
+regcache_nr_chunks (const struct regcache *regcache)
+{
+  return (regcache->readonly_p
+	  ? regcache->descr->nr_cooked_chunks
+	  : regcache->descr->nr_raw_chunks);
+}
+
+/* Allocate a zeroed, unshared chunk for chunk number CHUNK of a
+   register buffer laid out according to DESCR.  */
+
+static struct regcache_chunk *
+regcache_chunk_alloc (struct regcache_descr *descr, int chunk)
+{
+  struct regcache_chunk *result;
+  long size = descr->chunk_offset[chunk + 1] - descr->chunk_offset[chunk];
+
+  result = xzalloc (offsetof (struct regcache_chunk, data) + size);
+  result->refcount = 1;
+  return result;
+}
+
+/* Drop a reference to CHUNK, freeing it if it was the last one.  */
+
+static void
+regcache_chunk_unref (struct regcache_chunk *chunk)
+{
+  if (--chunk->refcount == 0)
+    xfree (chunk);
+}
+
+/* Make chunk number CHUNK of DST share SRC's.  */
+
+static void
+regcache_share_chunk (struct regcache *dst, const struct regcache *src,
+		      int chunk)
+{
+  src->chunks[chunk]->refcount++;
+  regcache_chunk_unref (dst->chunks[chunk]);
+  dst->chunks[chunk] = src->chunks[chunk];
+}
+
 static struct regcache *
 regcache_xmalloc_1 (struct gdbarch *gdbarch, struct address_space *aspace,
 		    int readonly_p)
 {
   struct regcache_descr *descr;
   struct regcache *regcache;
+  int i;
 
   gdb_assert (gdbarch != NULL);
   descr = regcache_descr (gdbarch);
@@ -222,19 +331,15 @@ regcache_xmalloc_1 (struct gdbarch *gdbarch, struct address_space *aspace,
   regcache->descr = descr;
   regcache->readonly_p = readonly_p;
   if (readonly_p)
-    {
-      regcache->registers
-	= XCALLOC (descr->sizeof_cooked_registers, gdb_byte);
-      regcache->register_status
-	= XCALLOC (descr->sizeof_cooked_register_status, signed char);
-    }
+    regcache->register_status
+      = XCALLOC (descr->sizeof_cooked_register_status, signed char);
   else
-    {
-      regcache->registers
-	= XCALLOC (descr->sizeof_raw_registers, gdb_byte);
-      regcache->register_status
-	= XCALLOC (descr->sizeof_raw_register_status, signed char);
-    }
+    regcache->register_status
+      = XCALLOC (descr->sizeof_raw_register_status, signed char);
+  regcache->chunks = XCALLOC (regcache_nr_chunks (regcache),
+			      struct regcache_chunk *);
+  for (i = 0; i < regcache_nr_chunks (regcache); i++)
+    regcache->chunks[i] = regcache_chunk_alloc (descr, i);
   regcache->aspace = aspace;
   regcache->ptid = minus_one_ptid;
   return regcache;
@@ -249,9 +354,13 @@ regcache_xmalloc (struct gdbarch *gdbarch, struct address_space *aspace)
 void
 regcache_xfree (struct regcache *regcache)
 {
+  int i;
+
   if (regcache == NULL)
     return;
-  xfree (regcache->registers);
+  for (i = 0; i < regcache_nr_chunks (regcache); i++)
+    regcache_chunk_unref (regcache->chunks[i]);
+  xfree (regcache->chunks);
   xfree (regcache->register_status);
   xfree (regcache);
 }
@@ -284,18 +393,101 @@ get_regcache_aspace (const struct regcache *regcache)
 
 /* Return  a pointer to register REGNUM's buffer cache.  */
 
-static gdb_byte *
+static const gdb_byte *
 register_buffer (const struct regcache *regcache, int regnum)
 {
-  return regcache->registers + regcache->descr->register_offset[regnum];
+  const struct regcache_descr *descr = regcache->descr;
+  int chunk = descr->register_chunk[regnum];
+
+  return (regcache->chunks[chunk]->data
+	  + descr->register_offset[regnum] - descr->chunk_offset[chunk]);
+}
+
+/* Like register_buffer, but for storing into register REGNUM.  If
+   the chunk holding REGNUM is shared with other regcaches, give
+   REGCACHE its own copy first.  */
+
+static gdb_byte *
+register_buffer_for_write (struct regcache *regcache, int regnum)
+{
+  struct regcache_descr *descr = regcache->descr;
+  int chunk = descr->register_chunk[regnum];
+  struct regcache_chunk *old = regcache->chunks[chunk];
+
+  if (old->refcount > 1)
+    {
+      struct regcache_chunk *copy = regcache_chunk_alloc (descr, chunk);
+
+      memcpy (copy->data, old->data,
+	      descr->chunk_offset[chunk + 1] - descr->chunk_offset[chunk]);
+      regcache_chunk_unref (old);
+      regcache->chunks[chunk] = copy;
+    }
+
+  return (regcache->chunks[chunk]->data
+	  + descr->register_offset[regnum] - descr->chunk_offset[chunk]);
+}
+
+/* Reset all of REGCACHE's registers to zero and REG_UNKNOWN, dropping
+   any chunks shared with other regcaches.  */
+
+static void
+regcache_clear (struct regcache *regcache)
+{
+  struct regcache_descr *descr = regcache->descr;
+  int i;
+
+  for (i = 0; i < regcache_nr_chunks (regcache); i++)
+    {
+      struct regcache_chunk *chunk = regcache->chunks[i];
+
+      if (chunk->refcount > 1)
+	{
+	  regcache_chunk_unref (chunk);
+	  regcache->chunks[i] = regcache_chunk_alloc (descr, i);
+	}
+      else
+	memset (chunk->data, 0,
+		descr->chunk_offset[i + 1] - descr->chunk_offset[i]);
+    }
+  memset (regcache->register_status, 0,
+	  (regcache->readonly_p
+	   ? descr->sizeof_cooked_register_status
+	   : descr->sizeof_raw_register_status));
+}
+
+/* Save register REGNUM into DST, for regcache_save, if it belongs to
+   the save_reggroup.  */
+
+static void
+regcache_save_register (struct regcache *dst, int regnum,
+			regcache_cooked_read_ftype *cooked_read, void *src)
+{
+  struct gdbarch *gdbarch = dst->descr->gdbarch;
+  gdb_byte buf[MAX_REGISTER_SIZE];
+
+  if (gdbarch_register_reggroup_p (gdbarch, regnum, save_reggroup))
+    {
+      enum register_status status = cooked_read (src, regnum, buf);
+
+      if (status == REG_VALID)
+	memcpy (register_buffer_for_write (dst, regnum), buf,
+		register_size (gdbarch, regnum));
+      else
+	{
+	  gdb_assert (status != REG_UNKNOWN);
+
+	  memset (register_buffer_for_write (dst, regnum), 0,
+		  register_size (gdbarch, regnum));
+	}
+      dst->register_status[regnum] = status;
+    }
 }
 
 void
 regcache_save (struct regcache *dst, regcache_cooked_read_ftype *cooked_read,
 	       void *src)
 {
-  struct gdbarch *gdbarch = dst->descr->gdbarch;
-  gdb_byte buf[MAX_REGISTER_SIZE];
   int regnum;
 
   /* The DST should be `read-only', if it wasn't then the save would
@@ -303,30 +495,61 @@ regcache_save (struct regcache *dst, regcache_cooked_read_ftype *cooked_read,
      target.  */
   gdb_assert (dst->readonly_p);
   /* Clear the dest.  */
-  memset (dst->registers, 0, dst->descr->sizeof_cooked_registers);
-  memset (dst->register_status, 0,
-	  dst->descr->sizeof_cooked_register_status);
+  regcache_clear (dst);
   /* Copy over any registers (identified by their membership in the
      save_reggroup) and mark them as valid.  The full [0 .. gdbarch_num_regs +
      gdbarch_num_pseudo_regs) range is checked since some architectures need
      to save/restore `cooked' registers that live in memory.  */
   for (regnum = 0; regnum < dst->descr->nr_cooked_registers; regnum++)
+    regcache_save_register (dst, regnum, cooked_read, src);
+}
+
+static enum register_status regcache_raw_update (struct regcache *, int);
+static enum register_status do_cooked_read (void *, int, gdb_byte *);
+
+/* Like regcache_save (DST, do_cooked_read, SRC), for a read/write
+   SRC.  Instead of copying them, DST shares the chunks of SRC whose
+   raw registers are all saved and valid, so that the snapshot costs
+   next to nothing until one of the two regcaches is written to.  */
+
+static void
+regcache_save_shared (struct regcache *dst, struct regcache *src)
+{
+  struct regcache_descr *descr = dst->descr;
+  struct gdbarch *gdbarch = descr->gdbarch;
+  int regnum, chunk;
+
+  gdb_assert (dst->readonly_p && !src->readonly_p);
+  regcache_clear (dst);
+
+  regnum = 0;
+  for (chunk = 0; chunk < descr->nr_cooked_chunks; chunk++)
     {
-      if (gdbarch_register_reggroup_p (gdbarch, regnum, save_reggroup))
+      int first = regnum;
+      int share = chunk < descr->nr_raw_chunks;
+
+      while (regnum < descr->nr_cooked_registers
+	     && descr->register_chunk[regnum] == chunk)
 	{
-	  enum register_status status = cooked_read (src, regnum, buf);
+	  if (share
+	      && (!gdbarch_register_reggroup_p (gdbarch, regnum,
+						save_reggroup)
+		  || regcache_raw_update (src, regnum) != REG_VALID))
+	    share = 0;
+	  regnum++;
+	}
 
-	  if (status == REG_VALID)
-	    memcpy (register_buffer (dst, regnum), buf,
-		    register_size (gdbarch, regnum));
-	  else
-	    {
-	      gdb_assert (status != REG_UNKNOWN);
+      if (share)
+	{
+	  regcache_share_chunk (dst, src, chunk);
+	  memset (dst->register_status + first, REG_VALID, regnum - first);
+	}
+      else
+	{
+	  int i;
 
-	      memset (register_buffer (dst, regnum), 0,
-		      register_size (gdbarch, regnum));
-	    }
-	  dst->register_status[regnum] = status;
+	  for (i = first; i < regnum; i++)
+	    regcache_save_register (dst, i, do_cooked_read, src);
 	}
     }
 }
@@ -377,7 +600,7 @@ regcache_cpy (struct regcache *dst, struct regcache *src)
   gdb_assert (src->readonly_p || dst->readonly_p);
 
   if (!src->readonly_p)
-    regcache_save (dst, do_cooked_read, src);
+    regcache_save_shared (dst, src);
   else if (!dst->readonly_p)
     regcache_restore (dst, do_cooked_read, src);
   else
@@ -387,6 +610,8 @@ regcache_cpy (struct regcache *dst, struct regcache *src)
 void
 regcache_cpy_no_passthrough (struct regcache *dst, struct regcache *src)
 {
+  int i;
+
   gdb_assert (src != NULL && dst != NULL);
   gdb_assert (src->descr->gdbarch == dst->descr->gdbarch);
   /* NOTE: cagney/2002-05-17: Don't let the caller do a no-passthrough
@@ -395,8 +620,10 @@ regcache_cpy_no_passthrough (struct regcache *dst, struct regcache *src)
      completely invalid.  */
   gdb_assert (dst->readonly_p && src->readonly_p);
 
-  memcpy (dst->registers, src->registers,
-	  dst->descr->sizeof_cooked_registers);
+  /* Rather than copying the register contents, share SRC's chunks;
+     whichever regcache is written to next gets its own copy.  */
+  for (i = 0; i < dst->descr->nr_cooked_chunks; i++)
+    regcache_share_chunk (dst, src, i);
   memcpy (dst->register_status, src->register_status,
 	  dst->descr->sizeof_cooked_register_status);
 }
@@ -454,13 +681,24 @@ struct regcache *
 get_thread_arch_aspace_regcache (ptid_t ptid, struct gdbarch *gdbarch,
 				 struct address_space *aspace)
 {
-  struct regcache_list *list;
+  struct regcache_list *list, **prevp;
   struct regcache *new_regcache;
 
-  for (list = current_regcache; list; list = list->next)
-    if (ptid_equal (list->regcache->ptid, ptid)
-	&& get_regcache_arch (list->regcache) == gdbarch)
-      return list->regcache;
+  for (prevp = &current_regcache; *prevp != NULL; prevp = &(*prevp)->next)
+    {
+      list = *prevp;
+      if (ptid_equal (list->regcache->ptid, ptid)
+	  && get_regcache_arch (list->regcache) == gdbarch)
+	{
+	  /* Move it to the front, so that looking up the same thread's
+	     registers again, as is done all the time, is quick even
+	     when many threads have had theirs fetched.  */
+	  *prevp = list->next;
+	  list->next = current_regcache;
+	  current_regcache = list;
+	  return list->regcache;
+	}
+    }
 
   new_regcache = regcache_xmalloc_1 (gdbarch, aspace, 0);
   new_regcache->ptid = ptid;
@@ -548,6 +786,9 @@ void
 registers_changed_ptid (ptid_t ptid)
 {
   struct regcache_list *list, **list_link;
+  struct infrun_phase_timer timer;
+
+  infrun_phase_begin (&timer, INFRUN_PHASE_REGISTERS_CHANGED);
 
   list = current_regcache;
   list_link = &current_regcache;
@@ -580,6 +821,8 @@ registers_changed_ptid (ptid_t ptid)
 	 forget about any frames we have cached, too.  */
       reinit_frame_cache ();
     }
+
+  infrun_phase_end (&timer);
 }
 
 void
@@ -595,10 +838,13 @@ registers_changed (void)
   alloca (0);
 }
 
-enum register_status
-regcache_raw_read (struct regcache *regcache, int regnum, gdb_byte *buf)
+/* Fetch raw register REGNUM of REGCACHE from the target if it is
+   not in the cache yet, and return its status.  */
+
+static enum register_status
+regcache_raw_update (struct regcache *regcache, int regnum)
 {
-  gdb_assert (regcache != NULL && buf != NULL);
+  gdb_assert (regcache != NULL);
   gdb_assert (regnum >= 0 && regnum < regcache->descr->nr_raw_registers);
   /* Make certain that the register cache is up-to-date with respect
      to the current thread.  This switching shouldn't be necessary
@@ -620,7 +866,15 @@ regcache_raw_read (struct regcache *regcache, int regnum, gdb_byte *buf)
 	regcache->register_status[regnum] = REG_UNAVAILABLE;
     }
 
-  if (regcache->register_status[regnum] != REG_VALID)
+  return regcache->register_status[regnum];
+}
+
+enum register_status
+regcache_raw_read (struct regcache *regcache, int regnum, gdb_byte *buf)
+{
+  gdb_assert (regcache != NULL && buf != NULL);
+
+  if (regcache_raw_update (regcache, regnum) != REG_VALID)
     memset (buf, 0, regcache->descr->sizeof_register[regnum]);
   else
     memcpy (buf, register_buffer (regcache, regnum),
@@ -869,7 +1123,7 @@ regcache_raw_write (struct regcache *regcache, int regnum,
   inferior_ptid = regcache->ptid;
 
   target_prepare_to_store (regcache);
-  memcpy (register_buffer (regcache, regnum), buf,
+  memcpy (register_buffer_for_write (regcache, regnum), buf,
 	  regcache->descr->sizeof_register[regnum]);
   regcache->register_status[regnum] = REG_VALID;
   target_store_registers (regcache, regnum);
@@ -998,7 +1252,7 @@ regcache_raw_supply (struct regcache *regcache, int regnum, const void *buf)
   gdb_assert (regnum >= 0 && regnum < regcache->descr->nr_raw_registers);
   gdb_assert (!regcache->readonly_p);
 
-  regbuf = register_buffer (regcache, regnum);
+  regbuf = register_buffer_for_write (regcache, regnum);
   size = regcache->descr->sizeof_register[regnum];
 
   if (buf)
@@ -28,6 +28,7 @@
 #include "symfile.h"
 #include "exceptions.h"
 #include "target.h"
+#include "dcache.h"
 /*#include "terminal.h" */
 #include "gdbcmd.h"
 #include "objfiles.h"
@@ -45,6 +46,9 @@
 #include "target-descriptions.h"
 #include "gdb_bfd.h"
 #include "filestuff.h"
+#include "elf-bfd.h"
+#include "build-id.h"
+#include "filenames.h"
 
 #include <ctype.h>
 #include <sys/time.h>
@@ -70,6 +74,9 @@
 #include "ax-gdb.h"
 #include "agent.h"
 #include "btrace.h"
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
 
 /* Temp hacks for tracepoint encoding migration.  */
 static char *target_buf;
@@ -260,7 +267,7 @@ struct vCont_action_support
 
 /* Controls whether GDB is willing to use range stepping.  */
 
-static int use_range_stepping = 1;
+int use_range_stepping = 1;
 
 #define OPAQUETHREADBYTES 8
 
@@ -296,6 +303,12 @@ struct remote_state
      Otherwise zero, meaning to use the guessed size.  */
   long explicit_packet_size;
 
+  /* The number of memory read requests the stub allows GDB to have
+     outstanding at once, as reported by the MemoryReadWindow
+     feature.  Zero or one means GDB waits for each reply before
+     sending the next request.  */
+  int memory_read_window;
+
   /* remote_wait is normally called when the target is running and
      waits for a stop reply packet.  But sometimes we need to call it
      when the target is already stopped.  We can send a "?" packet
@@ -393,6 +406,16 @@ struct remote_state
      the target know about program signals list changes.  */
   char *last_program_signals_packet;
 
+  /* The last QExpediteStack packet sent to the target.  Like the
+     signal lists above, it is only sent again when it changes.  */
+  char *last_expedite_stack_packet;
+
+  /* The generation of the stub's thread list that GDB's thread list
+     was last brought up to date with, if THREADS_GENERATION_P.  The
+     next qXfer:threads:read then asks only for the changes since.  */
+  int threads_generation_p;
+  ULONGEST threads_generation;
+
   enum gdb_signal last_sent_signal;
 
   int last_sent_step;
@@ -908,6 +931,12 @@ show_remotebreak (struct ui_file *file, int from_tty,
 
 static unsigned int remote_address_size;
 
+/* The number of bytes of stack memory above the stack pointer that a
+   stub supporting QExpediteStack is asked to include in each stop
+   reply.  Zero disables the request.  */
+
+static unsigned int remote_expedited_stack_size = 256;
+
 /* Temporary to track who currently owns the terminal.  See
    remote_terminal_* for more details.  */
 
@@ -1312,6 +1341,7 @@ packet_ok (const char *buf, struct packet_config *config)
 enum {
   PACKET_vCont = 0,
   PACKET_X,
+  PACKET_x,
   PACKET_qSymbol,
   PACKET_P,
   PACKET_p,
@@ -1326,6 +1356,7 @@ enum {
   PACKET_vFile_close,
   PACKET_vFile_unlink,
   PACKET_vFile_readlink,
+  PACKET_vFile_fstat,
   PACKET_qXfer_auxv,
   PACKET_qXfer_features,
   PACKET_qXfer_libraries,
@@ -1366,14 +1397,90 @@ enum {
   PACKET_QDisableRandomization,
   PACKET_QAgent,
   PACKET_QTBuffer_size,
+  PACKET_qTBufferBin,
   PACKET_Qbtrace_off,
   PACKET_Qbtrace_bts,
   PACKET_qXfer_btrace,
+  PACKET_zlib_compression,
+  PACKET_QExpediteStack,
+  PACKET_qRegs,
+  PACKET_qSymbols,
+  PACKET_qCRC_ranges,
+  PACKET_qXfer_features_hash,
   PACKET_MAX
 };
 
 static struct packet_config remote_protocol_packets[PACKET_MAX];
 
+/* Statistics about the compressed packets received from the
+   target since the connection was opened.  */
+
+static struct
+{
+  /* The number of compressed packets.  */
+  ULONGEST packets;
+
+  /* Their total size, as received.  */
+  ULONGEST wire_bytes;
+
+  /* Their total size once decompressed.  */
+  ULONGEST bytes;
+
+  /* The run time spent decompressing them, in microseconds.  */
+  long usecs;
+} remote_compression_stats;
+
+/* The number of buckets of the round-trip time histograms: under
+   100us, 1ms, 10ms, 100ms and 1s, and longer.  */
+#define REMOTE_RTT_BUCKETS 6
+
+/* Statistics about one type of packet sent to the target since the
+   connection was opened.  */
+
+typedef struct remote_packet_stats
+{
+  /* The packet type: its letter, or the name of a 'q', 'Q' or 'v'
+     packet.  */
+  char *name;
+
+  /* The packets sent, and their size, framing included.  */
+  ULONGEST sent;
+  ULONGEST bytes_sent;
+
+  /* The replies received, and their size.  */
+  ULONGEST replies;
+  ULONGEST bytes_received;
+
+  /* The total time waited for the replies, in microseconds, and its
+     histogram.  */
+  ULONGEST usecs;
+  ULONGEST histogram[REMOTE_RTT_BUCKETS];
+} remote_packet_stats_s;
+
+DEF_VEC_O (remote_packet_stats_s);
+
+static VEC (remote_packet_stats_s) *remote_packet_stats;
+
+/* The packets sent whose replies haven't been received yet, oldest
+   first, in a ring of REMOTE_PENDING_REPLIES entries.  There is more
+   than one when memory reads are pipelined.  */
+
+#define REMOTE_PENDING_REPLIES 128
+
+static struct
+{
+  /* The index of the packet type in REMOTE_PACKET_STATS.  */
+  int type;
+
+  /* When the packet was sent.  */
+  struct timeval start;
+} remote_pending_replies[REMOTE_PENDING_REPLIES];
+
+static int remote_pending_replies_first;
+static int remote_pending_replies_count;
+
+static void remote_clear_packet_stats (void);
+
 static void
 set_remote_protocol_packet_cmd (char *args, int from_tty,
 				struct cmd_list_element *c)
@@ -1731,6 +1838,44 @@ remote_pass_signals (int numsigs, unsigned char *pass_signals)
     }
 }
 
+/* If 'QExpediteStack' is supported, ask the remote stub to include
+   the memory at the top of the stack in its stop replies, in whole
+   dcache lines, so that the first frames of a backtrace after a stop
+   need no memory reads.  */
+
+static void
+remote_expedite_stack (void)
+{
+  struct remote_state *rs = get_remote_state ();
+  struct gdbarch *gdbarch = target_gdbarch ();
+  int sp_regnum = gdbarch_sp_regnum (gdbarch);
+  struct packet_reg *reg;
+  char *packet;
+
+  if (remote_protocol_packets[PACKET_QExpediteStack].support
+      == PACKET_DISABLE)
+    return;
+
+  if (sp_regnum < 0 || sp_regnum >= gdbarch_num_regs (gdbarch))
+    return;
+  reg = packet_reg_from_regnum (get_remote_arch_state (), sp_regnum);
+
+  packet = xstrprintf ("QExpediteStack:%s,%x,%x",
+		       phex_nz (reg->pnum, 0), remote_expedited_stack_size,
+		       dcache_get_line_size ());
+  if (rs->last_expedite_stack_packet == NULL
+      || strcmp (rs->last_expedite_stack_packet, packet) != 0)
+    {
+      putpkt (packet);
+      getpkt (&rs->buf, &rs->buf_size, 0);
+      packet_ok (rs->buf, &remote_protocol_packets[PACKET_QExpediteStack]);
+      xfree (rs->last_expedite_stack_packet);
+      rs->last_expedite_stack_packet = packet;
+    }
+  else
+    xfree (packet);
+}
+
 /* If 'QProgramSignals' is supported, tell the remote stub what
    signals it should pass through to the inferior when detaching.  */
 
@@ -2647,14 +2792,44 @@ typedef struct thread_item
   ptid_t ptid;
   char *extra;
   int core;
+
+  /* Nonzero if the thread has exited, as reported by an <exited>
+     element of a thread list delta.  */
+  int exited;
 } thread_item_t;
 DEF_VEC_O(thread_item_t);
 
 struct threads_parsing_context
 {
   VEC (thread_item_t) *items;
+
+  /* The generation of the list, if GENERATION_P.  */
+  int generation_p;
+  ULONGEST generation;
+
+  /* Nonzero if the list only has the changes since an earlier
+     generation.  */
+  int delta_p;
 };
 
+static void
+start_threads (struct gdb_xml_parser *parser,
+	       const struct gdb_xml_element *element,
+	       void *user_data, VEC(gdb_xml_value_s) *attributes)
+{
+  struct threads_parsing_context *data = user_data;
+  struct gdb_xml_value *attr;
+
+  attr = xml_find_attribute (attributes, "generation");
+  if (attr != NULL)
+    {
+      data->generation_p = 1;
+      data->generation = *(ULONGEST *) attr->value;
+    }
+
+  data->delta_p = xml_find_attribute (attributes, "since") != NULL;
+}
+
 static void
 start_thread (struct gdb_xml_parser *parser,
 	      const struct gdb_xml_element *element,
@@ -2676,6 +2851,25 @@ start_thread (struct gdb_xml_parser *parser,
     item.core = -1;
 
   item.extra = 0;
+  item.exited = 0;
+
+  VEC_safe_push (thread_item_t, data->items, &item);
+}
+
+static void
+start_exited_thread (struct gdb_xml_parser *parser,
+		     const struct gdb_xml_element *element,
+		     void *user_data, VEC(gdb_xml_value_s) *attributes)
+{
+  struct threads_parsing_context *data = user_data;
+  struct thread_item item;
+  char *id;
+
+  id = xml_find_attribute (attributes, "id")->value;
+  item.ptid = read_ptid (id, NULL);
+  item.core = -1;
+  item.extra = NULL;
+  item.exited = 1;
 
   VEC_safe_push (thread_item_t, data->items, &item);
 }
@@ -2701,16 +2895,30 @@ const struct gdb_xml_element thread_children[] = {
   { NULL, NULL, NULL, GDB_XML_EF_NONE, NULL, NULL }
 };
 
+const struct gdb_xml_attribute exited_thread_attributes[] = {
+  { "id", GDB_XML_AF_NONE, NULL, NULL },
+  { NULL, GDB_XML_AF_NONE, NULL, NULL }
+};
+
 const struct gdb_xml_element threads_children[] = {
   { "thread", thread_attributes, thread_children,
     GDB_XML_EF_REPEATABLE | GDB_XML_EF_OPTIONAL,
     start_thread, end_thread },
+  { "exited", exited_thread_attributes, NULL,
+    GDB_XML_EF_REPEATABLE | GDB_XML_EF_OPTIONAL,
+    start_exited_thread, NULL },
   { NULL, NULL, NULL, GDB_XML_EF_NONE, NULL, NULL }
 };
 
+const struct gdb_xml_attribute threads_attributes[] = {
+  { "generation", GDB_XML_AF_OPTIONAL, gdb_xml_parse_attr_ulongest, NULL },
+  { "since", GDB_XML_AF_OPTIONAL, gdb_xml_parse_attr_ulongest, NULL },
+  { NULL, GDB_XML_AF_NONE, NULL, NULL }
+};
+
 const struct gdb_xml_element threads_elements[] = {
-  { "threads", NULL, threads_children,
-    GDB_XML_EF_NONE, NULL, NULL },
+  { "threads", threads_attributes, threads_children,
+    GDB_XML_EF_NONE, start_threads, NULL },
   { NULL, NULL, NULL, GDB_XML_EF_NONE, NULL, NULL }
 };
 
@@ -2751,16 +2959,26 @@ remote_threads_info (struct target_ops *ops)
 #if defined(HAVE_LIBEXPAT)
   if (remote_protocol_packets[PACKET_qXfer_threads].support == PACKET_ENABLE)
     {
-      char *xml = target_read_stralloc (&current_target,
-					 TARGET_OBJECT_THREADS, NULL);
+      char *annex = NULL;
+      char *xml;
+      struct cleanup *back_to;
+
+      /* If the stub numbers the generations of its thread list, only
+	 ask for the threads added and removed since the list GDB last
+	 saw, rather than for all of them again.  */
+      if (rs->threads_generation_p && thread_count () > 0)
+	annex = xstrprintf ("since=%s", pulongest (rs->threads_generation));
+      back_to = make_cleanup (xfree, annex);
 
-      struct cleanup *back_to = make_cleanup (xfree, xml);
+      xml = target_read_stralloc (&current_target,
+				  TARGET_OBJECT_THREADS, annex);
+      make_cleanup (xfree, xml);
 
       if (xml && *xml)
 	{
 	  struct threads_parsing_context context;
 
-	  context.items = NULL;
+	  memset (&context, 0, sizeof (context));
 	  make_cleanup (clear_threads_parsing_context, &context);
 
 	  if (gdb_xml_parse_quick (_("threads"), "threads.dtd",
@@ -2769,11 +2987,20 @@ remote_threads_info (struct target_ops *ops)
 	      int i;
 	      struct thread_item *item;
 
+	      rs->threads_generation_p = context.generation_p;
+	      rs->threads_generation = context.generation;
+
 	      for (i = 0;
 		   VEC_iterate (thread_item_t, context.items, i, item);
 		   ++i)
 		{
-		  if (!ptid_equal (item->ptid, null_ptid))
+		  if (item->exited)
+		    {
+		      if (context.delta_p
+			  && find_thread_ptid (item->ptid) != NULL)
+			delete_thread (item->ptid);
+		    }
+		  else if (!ptid_equal (item->ptid, null_ptid))
 		    {
 		      struct private_thread_info *info;
 		      /* In non-stop mode, we assume new found threads
@@ -3677,12 +3904,85 @@ init_all_packet_configs (void)
 
 /* Symbol look-up.  */
 
+/* Look up the minimal symbol NAME for the remote stub.  If found,
+   store its value in *ADDR and return 1, otherwise return 0.  */
+
+static int
+remote_lookup_symbol (const char *name, CORE_ADDR *addr)
+{
+  struct minimal_symbol *sym;
+
+  sym = lookup_minimal_symbol (name, NULL, NULL);
+  if (sym == NULL)
+    return 0;
+
+  /* If this is a function address, return the start of code instead
+     of any data function descriptor.  */
+  *addr = gdbarch_convert_from_func_ptr_addr (target_gdbarch (),
+					      SYMBOL_VALUE_ADDRESS (sym),
+					      &current_target);
+  return 1;
+}
+
+/* Build in MSG, of size MSG_SIZE, the reply to the batched symbol
+   lookup REQUEST, "qSymbols:NAME;NAME...".  The reply gives, in the
+   same order, "VALUE:NAME" for each name, with an empty VALUE for
+   the symbols that are not found.  */
+
+static void
+remote_answer_qsymbols (const char *request, char *msg, int msg_size)
+{
+  int addr_size = gdbarch_addr_bit (target_gdbarch ()) / 8;
+  const char *name_hex = request + strlen ("qSymbols:");
+  char *p = msg;
+  char *name = alloca (strlen (name_hex) / 2 + 1);
+
+  strcpy (p, "qSymbols:");
+  p += strlen (p);
+
+  while (*name_hex != '\0')
+    {
+      const char *name_end = strchr (name_hex, ';');
+      int name_len;
+      const char *value = "";
+      CORE_ADDR sym_addr;
+      int end;
+
+      if (name_end == NULL)
+	name_end = name_hex + strlen (name_hex);
+      name_len = name_end - name_hex;
+
+      end = hex2bin (name_hex, (gdb_byte *) name, name_len / 2);
+      name[end] = '\0';
+      if (remote_lookup_symbol (name, &sym_addr))
+	value = phex_nz (sym_addr, addr_size);
+
+      /* The stub must keep its request short enough for the reply to
+	 fit in a packet.  */
+      if ((p - msg) + strlen (value) + 1 + name_len + 1 >= msg_size)
+	error (_("Remote qSymbols request is too long"));
+
+      p += sprintf (p, "%s:", value);
+      memcpy (p, name_hex, name_len);
+      p += name_len;
+      *p = '\0';
+
+      name_hex = name_end;
+      if (*name_hex == ';')
+	{
+	  *p++ = ';';
+	  *p = '\0';
+	  name_hex++;
+	}
+    }
+}
+
 static void
 remote_check_symbols (void)
 {
   struct remote_state *rs = get_remote_state ();
+  int addr_size = gdbarch_addr_bit (target_gdbarch ()) / 8;
   char *msg, *reply, *tmp;
-  struct minimal_symbol *sym;
   int end;
 
   /* The remote side has no concept of inferiors that aren't running
@@ -3711,29 +4011,27 @@ remote_check_symbols (void)
   packet_ok (rs->buf, &remote_protocol_packets[PACKET_qSymbol]);
   reply = rs->buf;
 
-  while (strncmp (reply, "qSymbol:", 8) == 0)
+  while (1)
     {
-      tmp = &reply[8];
-      end = hex2bin (tmp, (gdb_byte *) msg, strlen (tmp) / 2);
-      msg[end] = '\0';
-      sym = lookup_minimal_symbol (msg, NULL, NULL);
-      if (sym == NULL)
-	xsnprintf (msg, get_remote_packet_size (), "qSymbol::%s", &reply[8]);
-      else
+      if (strncmp (reply, "qSymbols:", 9) == 0)
+	remote_answer_qsymbols (reply, msg, get_remote_packet_size ());
+      else if (strncmp (reply, "qSymbol:", 8) == 0)
 	{
-	  int addr_size = gdbarch_addr_bit (target_gdbarch ()) / 8;
-	  CORE_ADDR sym_addr = SYMBOL_VALUE_ADDRESS (sym);
-
-	  /* If this is a function address, return the start of code
-	     instead of any data function descriptor.  */
-	  sym_addr = gdbarch_convert_from_func_ptr_addr (target_gdbarch (),
-							 sym_addr,
-							 &current_target);
-
-	  xsnprintf (msg, get_remote_packet_size (), "qSymbol:%s:%s",
-		     phex_nz (sym_addr, addr_size), &reply[8]);
+	  CORE_ADDR sym_addr;
+
+	  tmp = &reply[8];
+	  end = hex2bin (tmp, (gdb_byte *) msg, strlen (tmp) / 2);
+	  msg[end] = '\0';
+	  if (!remote_lookup_symbol (msg, &sym_addr))
+	    xsnprintf (msg, get_remote_packet_size (), "qSymbol::%s",
+		       &reply[8]);
+	  else
+	    xsnprintf (msg, get_remote_packet_size (), "qSymbol:%s:%s",
+		       phex_nz (sym_addr, addr_size), &reply[8]);
 	}
-  
+      else
+	break;
+
       putpkt (msg);
       getpkt (&rs->buf, &rs->buf_size, 0);
       reply = rs->buf;
@@ -3873,6 +4171,42 @@ remote_packet_size (const struct protocol_feature *feature,
   rs->explicit_packet_size = packet_size;
 }
 
+/* The largest memory read window GDB will use, whatever the stub
+   reports.  */
+
+#define MAX_REMOTE_MEMORY_READ_WINDOW 64
+
+static void
+remote_memory_read_window_feature (const struct protocol_feature *feature,
+				   enum packet_support support,
+				   const char *value)
+{
+  struct remote_state *rs = get_remote_state ();
+  int window;
+  char *value_end;
+
+  if (support != PACKET_ENABLE)
+    return;
+
+  if (value == NULL || *value == '\0')
+    {
+      warning (_("Remote target reported \"%s\" without a size."),
+	       feature->name);
+      return;
+    }
+
+  errno = 0;
+  window = strtol (value, &value_end, 16);
+  if (errno != 0 || *value_end != '\0' || window < 0)
+    {
+      warning (_("Remote target reported \"%s\" with a bad size: \"%s\"."),
+	       feature->name, value);
+      return;
+    }
+
+  rs->memory_read_window = min (window, MAX_REMOTE_MEMORY_READ_WINDOW);
+}
+
 static void
 remote_multi_process_feature (const struct protocol_feature *feature,
 			      enum packet_support support, const char *value)
@@ -3993,10 +4327,23 @@ remote_augmented_libraries_svr4_read_feature
 
 static const struct protocol_feature remote_protocol_features[] = {
   { "PacketSize", PACKET_DISABLE, remote_packet_size, -1 },
+  { "MemoryReadWindow", PACKET_DISABLE, remote_memory_read_window_feature,
+    -1 },
+  { "binary-upload", PACKET_DISABLE, remote_supported_packet, PACKET_x },
+  { "zlib-compression", PACKET_DISABLE, remote_supported_packet,
+    PACKET_zlib_compression },
+  { "QExpediteStack", PACKET_DISABLE, remote_supported_packet,
+    PACKET_QExpediteStack },
+  { "qRegs", PACKET_DISABLE, remote_supported_packet, PACKET_qRegs },
+  { "qCRC:ranges", PACKET_DISABLE, remote_supported_packet,
+    PACKET_qCRC_ranges },
+  { "qSymbols", PACKET_DISABLE, remote_supported_packet, PACKET_qSymbols },
   { "qXfer:auxv:read", PACKET_DISABLE, remote_supported_packet,
     PACKET_qXfer_auxv },
   { "qXfer:features:read", PACKET_DISABLE, remote_supported_packet,
     PACKET_qXfer_features },
+  { "qXfer:features-hash:read", PACKET_DISABLE, remote_supported_packet,
+    PACKET_qXfer_features_hash },
   { "qXfer:libraries:read", PACKET_DISABLE, remote_supported_packet,
     PACKET_qXfer_libraries },
   { "qXfer:libraries-svr4:read", PACKET_DISABLE, remote_supported_packet,
@@ -4060,6 +4407,8 @@ static const struct protocol_feature remote_protocol_features[] = {
   { "QAgent", PACKET_DISABLE, remote_supported_packet, PACKET_QAgent},
   { "QTBuffer:size", PACKET_DISABLE,
     remote_supported_packet, PACKET_QTBuffer_size},
+  { "qTBufferBin", PACKET_DISABLE,
+    remote_supported_packet, PACKET_qTBufferBin},
   { "tracenz", PACKET_DISABLE,
     remote_string_tracing_feature, -1 },
   { "Qbtrace:off", PACKET_DISABLE, remote_supported_packet, PACKET_Qbtrace_off },
@@ -4139,6 +4488,16 @@ remote_query_supported (void)
 
       q = remote_query_supported_append (q, "qRelocInsn+");
 
+#ifdef HAVE_ZLIB_H
+      if (remote_protocol_packets[PACKET_zlib_compression].support
+	  != PACKET_DISABLE)
+	q = remote_query_supported_append (q, "zlib-compression+");
+#endif
+
+      if (remote_protocol_packets[PACKET_qSymbols].support
+	  != PACKET_DISABLE)
+	q = remote_query_supported_append (q, "qSymbols+");
+
       q = reconcat (q, "qSupported:", q, (char *) NULL);
       putpkt (q);
 
@@ -4298,6 +4657,12 @@ remote_open_1 (char *name, int from_tty,
   xfree (rs->last_program_signals_packet);
   rs->last_program_signals_packet = NULL;
 
+  /* Likewise the stack memory request.  */
+  xfree (rs->last_expedite_stack_packet);
+  rs->last_expedite_stack_packet = NULL;
+
+  rs->threads_generation_p = 0;
+
   remote_fileio_reset ();
   reopen_exec_file ();
   reread_symbols ();
@@ -4345,6 +4710,9 @@ remote_open_1 (char *name, int from_tty,
   init_all_packet_configs ();
   rs->cached_wait_status = 0;
   rs->explicit_packet_size = 0;
+  rs->memory_read_window = 0;
+  memset (&remote_compression_stats, 0, sizeof (remote_compression_stats));
+  remote_clear_packet_stats ();
   rs->noack_mode = 0;
   rs->multi_process_aware = 0;
   rs->extended = extended_p;
@@ -4937,6 +5305,8 @@ remote_resume (struct target_ops *ops,
   rs->last_sent_signal = siggnal;
   rs->last_sent_step = step;
 
+  remote_expedite_stack ();
+
   /* The vCont packet doesn't need to specify threads via Hc.  */
   /* No reverse support (yet) for vCont.  */
   if (execution_direction != EXEC_REVERSE)
@@ -5291,6 +5661,12 @@ typedef struct stop_reply
   CORE_ADDR watch_data_address;
 
   int core;
+
+  /* Expedited stack memory: STACK_LEN bytes at STACK_ADDR, in an
+     xmalloc'd buffer, or NULL.  The contents go to the dcache.  */
+  CORE_ADDR stack_addr;
+  gdb_byte *stack_data;
+  int stack_len;
 } *stop_reply_p;
 
 DECLARE_QUEUE_P (stop_reply_p);
@@ -5351,6 +5727,7 @@ stop_reply_dtr (struct notif_event *event)
   struct stop_reply *r = (struct stop_reply *) event;
 
   VEC_free (cached_reg_t, r->regcache);
+  xfree (r->stack_data);
 }
 
 static struct notif_event *
@@ -5591,6 +5968,8 @@ remote_parse_stop_reply (char *buf, struct stop_reply *event)
   event->stopped_by_watchpoint_p = 0;
   event->regcache = NULL;
   event->core = -1;
+  event->stack_data = NULL;
+  event->stack_len = 0;
 
   switch (buf[0])
     {
@@ -5670,6 +6049,26 @@ Packet: '%s'\n"),
 		  p = unpack_varlen_hex (++p1, &c);
 		  event->core = c;
 		}
+	      else if (strncmp (p, "stack", p1 - p) == 0)
+		{
+		  p = unpack_varlen_hex (++p1, &addr);
+		  if (*p != ',')
+		    error (_("Malformed packet (missing comma): %s\n\
+Packet: '%s'\n"),
+			   p, buf);
+		  ++p;
+		  p_temp = p;
+		  while (*p_temp && *p_temp != ';')
+		    p_temp++;
+
+		  xfree (event->stack_data);
+		  event->stack_addr = (CORE_ADDR) addr;
+		  event->stack_len = (p_temp - p) / 2;
+		  event->stack_data = xmalloc (event->stack_len);
+		  event->stack_len = hex2bin (p, event->stack_data,
+					      event->stack_len);
+		  p = p_temp;
+		}
 	      else
 		{
 		  /* Silently skip unknown optional info.  */
@@ -5911,6 +6310,11 @@ process_stop_reply (struct stop_reply *stop_reply,
 
       remote_notice_new_inferior (ptid, 0);
       demand_private_info (ptid)->core = stop_reply->core;
+
+      /* Expedited stack memory.  */
+      if (stop_reply->stack_data != NULL)
+	target_dcache_fill (ptid, stop_reply->stack_addr,
+			    stop_reply->stack_data, stop_reply->stack_len);
     }
 
   stop_reply_xfree (stop_reply);
@@ -6243,21 +6647,21 @@ send_g_packet (void)
   return buf_len / 2;
 }
 
+/* Supply to REGCACHE the registers in the BUF_LEN characters of 'g'
+   packet reply contents at BUF.  */
+
 static void
-process_g_packet (struct regcache *regcache)
+process_g_packet (struct regcache *regcache, const char *buf, int buf_len)
 {
   struct gdbarch *gdbarch = get_regcache_arch (regcache);
-  struct remote_state *rs = get_remote_state ();
   struct remote_arch_state *rsa = get_remote_arch_state ();
-  int i, buf_len;
-  char *p;
+  int i;
+  const char *p;
   char *regs;
 
-  buf_len = strlen (rs->buf);
-
   /* Further sanity checks, with knowledge of the architecture.  */
   if (buf_len > 2 * rsa->sizeof_g_packet)
-    error (_("Remote 'g' packet reply is too long: %s"), rs->buf);
+    error (_("Remote 'g' packet reply is too long: %s"), buf);
 
   /* Save the size of the packet sent to us by the target.  It is used
      as a heuristic when determining the max size of packets that the
@@ -6294,7 +6698,7 @@ process_g_packet (struct regcache *regcache)
      hex characters.  Suck them all up, then supply them to the
      register cacheing/storage mechanism.  */
 
-  p = rs->buf;
+  p = buf;
   for (i = 0; i < rsa->sizeof_g_packet; i++)
     {
       if (p[0] == 0 || p[1] == 0)
@@ -6315,13 +6719,13 @@ process_g_packet (struct regcache *regcache)
 
       if (r->in_g_packet)
 	{
-	  if (r->offset * 2 >= strlen (rs->buf))
+	  if (r->offset * 2 >= buf_len)
 	    /* This shouldn't happen - we adjusted in_g_packet above.  */
 	    internal_error (__FILE__, __LINE__,
 			    _("unexpected end of 'g' packet reply"));
-	  else if (rs->buf[r->offset * 2] == 'x')
+	  else if (buf[r->offset * 2] == 'x')
 	    {
-	      gdb_assert (r->offset * 2 < strlen (rs->buf));
+	      gdb_assert (r->offset * 2 < buf_len);
 	      /* The register isn't available, mark it as such (at
 		 the same time setting the value to zero).  */
 	      regcache_raw_supply (regcache, r->regnum, NULL);
@@ -6333,11 +6737,166 @@ process_g_packet (struct regcache *regcache)
     }
 }
 
+/* The threads a 'qRegs' packet asks for.  */
+
+struct qregs_threads
+{
+  struct gdbarch *gdbarch;
+
+  /* A register in the 'g' packet; threads for which it is already
+     known have had their registers fetched.  */
+  int regnum;
+
+  ptid_t *ptids;
+  int count;
+  int max_count;
+};
+
+/* Add the thread THREAD to the qregs_threads DATA if it is a stopped
+   thread of the current inferior whose registers GDB hasn't fetched
+   yet.  */
+
+static void
+qregs_add_thread (struct thread_info *thread, struct qregs_threads *data)
+{
+  struct regcache *regcache;
+
+  if (data->count >= data->max_count
+      || ptid_equal (thread->ptid, inferior_ptid)
+      || ptid_get_pid (thread->ptid) != ptid_get_pid (inferior_ptid)
+      || ptid_get_tid (thread->ptid) <= 0
+      || thread->state == THREAD_EXITED
+      || thread->executing)
+    return;
+
+  regcache = get_thread_arch_regcache (thread->ptid, data->gdbarch);
+  if (regcache_register_status (regcache, data->regnum) == REG_UNKNOWN)
+    data->ptids[data->count++] = thread->ptid;
+}
+
+/* Fetch the registers included in the 'g' packet for the current
+   thread into REGCACHE, and along with them those of the other stopped
+   threads whose registers GDB hasn't fetched yet, with a single
+   'qRegs' packet.  This saves a 'Hg' and a 'g' round trip per thread
+   when GDB goes through the threads, as "thread apply all bt" does.
+   Return nonzero if REGCACHE was filled, zero if the caller should
+   use 'g'.  */
+
+static int
+fetch_registers_using_qregs (struct regcache *regcache)
+{
+  struct remote_state *rs = get_remote_state ();
+  struct remote_arch_state *rsa = get_remote_arch_state ();
+  struct gdbarch *gdbarch = get_regcache_arch (regcache);
+  struct qregs_threads data;
+  struct thread_info *thread;
+  struct cleanup *old_chain;
+  char *p, *endp;
+  int i, filled = 0;
+
+  if (remote_protocol_packets[PACKET_qRegs].support == PACKET_DISABLE
+      || get_traceframe_number () != -1
+      || ptid_get_tid (inferior_ptid) <= 0)
+    return 0;
+
+  data.gdbarch = gdbarch;
+  for (data.regnum = 0; data.regnum < gdbarch_num_regs (gdbarch);
+       data.regnum++)
+    if (rsa->regs[data.regnum].in_g_packet)
+      break;
+  if (data.regnum == gdbarch_num_regs (gdbarch))
+    return 0;
+
+  /* The reply has the hex 'g' contents of each thread, and a
+     separator.  Each thread id takes up to 36 characters of the
+     request.  */
+  data.max_count = min ((get_remote_packet_size () - 1)
+			/ (2 * rsa->sizeof_g_packet + 1),
+			(get_remote_packet_size () - 8) / 36);
+  if (data.max_count < 2)
+    return 0;
+
+  data.ptids = xmalloc (data.max_count * sizeof (ptid_t));
+  old_chain = make_cleanup (xfree, data.ptids);
+  data.ptids[0] = inferior_ptid;
+  data.count = 1;
+  ALL_THREADS (thread)
+    qregs_add_thread (thread, &data);
+
+  /* Not worth a new packet for the current thread alone.  */
+  if (data.count == 1)
+    {
+      do_cleanups (old_chain);
+      return 0;
+    }
+
+  p = rs->buf;
+  endp = rs->buf + get_remote_packet_size ();
+  p += xsnprintf (p, endp - p, "qRegs:");
+  for (i = 0; i < data.count; i++)
+    {
+      if (i > 0)
+	*p++ = ';';
+      p = write_ptid (p, endp, data.ptids[i]);
+    }
+  *p = '\0';
+
+  putpkt (rs->buf);
+  getpkt (&rs->buf, &rs->buf_size, 0);
+  if (packet_ok (rs->buf, &remote_protocol_packets[PACKET_qRegs])
+      != PACKET_OK)
+    {
+      do_cleanups (old_chain);
+      return 0;
+    }
+
+  /* The reply has an entry for each of the first threads asked for,
+     in order: either their 'g' contents, or "Enn" if they couldn't be
+     read.  */
+  p = rs->buf;
+  for (i = 0; i < data.count; i++)
+    {
+      char *end = strchr (p, ';');
+      int len;
+
+      if (end == NULL)
+	end = p + strlen (p);
+      len = end - p;
+
+      if (len > 0 && len % 2 == 0)
+	{
+	  struct regcache *thread_regcache
+	    = (i == 0 ? regcache
+	       : get_thread_arch_regcache (data.ptids[i], gdbarch));
+
+	  process_g_packet (thread_regcache, p, len);
+	  if (i == 0)
+	    filled = 1;
+	}
+
+      if (*end == '\0')
+	break;
+      p = end + 1;
+    }
+
+  do_cleanups (old_chain);
+  return filled;
+}
+
+/* Fetch the registers included in the 'g' packet into REGCACHE.  If
+   OTHER_THREADS_P, fetch those of the other threads along with
+   them, when the target can.  */
+
 static void
-fetch_registers_using_g (struct regcache *regcache)
+fetch_registers_using_g (struct regcache *regcache, int other_threads_p)
 {
+  struct remote_state *rs = get_remote_state ();
+
+  if (other_threads_p && fetch_registers_using_qregs (regcache))
+    return;
+
   send_g_packet ();
-  process_g_packet (regcache);
+  process_g_packet (regcache, rs->buf, strlen (rs->buf));
 }
 
 /* Make the remote selected traceframe match GDB's selected
@@ -6367,9 +6926,16 @@ static void
 remote_fetch_registers (struct target_ops *ops,
 			struct regcache *regcache, int regnum)
 {
+  struct remote_state *rs = get_remote_state ();
   struct remote_arch_state *rsa = get_remote_arch_state ();
+  int other_threads_p;
   int i;
 
+  /* Moving to another thread is a hint that GDB is going through the
+     threads, and will want their registers too.  While GDB stays on
+     one thread, as when stepping, fetch its registers alone.  */
+  other_threads_p = !ptid_equal (rs->general_thread, inferior_ptid);
+
   set_remote_traceframe ();
   set_general_thread (inferior_ptid);
 
@@ -6385,7 +6951,7 @@ remote_fetch_registers (struct target_ops *ops,
 	 contents, so fall back to 'p'.  */
       if (reg->in_g_packet)
 	{
-	  fetch_registers_using_g (regcache);
+	  fetch_registers_using_g (regcache, other_threads_p);
 	  if (reg->in_g_packet)
 	    return;
 	}
@@ -6399,7 +6965,7 @@ remote_fetch_registers (struct target_ops *ops,
       return;
     }
 
-  fetch_registers_using_g (regcache);
+  fetch_registers_using_g (regcache, other_threads_p);
 
   for (i = 0; i < gdbarch_num_regs (get_regcache_arch (regcache)); i++)
     if (!rsa->regs[i].in_g_packet)
@@ -6977,13 +7543,123 @@ remote_write_bytes (CORE_ADDR memaddr, const gdb_byte *myaddr, ssize_t len)
 				 memaddr, myaddr, len, packet_format[0], 1);
 }
 
-/* Read memory data directly from the remote machine.
-   This does not use the data cache; the data cache uses this.
-   MEMADDR is the address in the remote memory space.
-   MYADDR is the address of the buffer in our space.
-   LEN is the number of bytes.
+/* Return non-zero if memory reads should use the binary "x" packet
+   rather than "m".  */
 
-   Returns number of bytes transferred, or a negative value (an 'enum
+static int
+remote_binary_upload_p (void)
+{
+  return remote_protocol_packets[PACKET_x].support == PACKET_ENABLE;
+}
+
+/* Send an "m" or "x" packet asking for LEN bytes at MEMADDR, without
+   waiting for the reply.  */
+
+static void
+remote_send_memory_read (CORE_ADDR memaddr, int len)
+{
+  struct remote_state *rs = get_remote_state ();
+  char *p;
+
+  /* Construct "m"<memaddr>","<len>", or the same with "x".  */
+  memaddr = remote_address_masked (memaddr);
+  p = rs->buf;
+  *p++ = remote_binary_upload_p () ? 'x' : 'm';
+  p += hexnumstr (p, (ULONGEST) memaddr);
+  *p++ = ',';
+  p += hexnumstr (p, (ULONGEST) len);
+  *p = '\0';
+  putpkt (rs->buf);
+}
+
+/* Get the reply to a memory read request for LEN bytes sent by
+   remote_send_memory_read, and store the data in MYADDR.  Returns the
+   number of bytes stored, which may be less than LEN, or
+   TARGET_XFER_E_IO if the stub reported an error.  */
+
+static LONGEST
+remote_read_memory_reply (gdb_byte *myaddr, int len)
+{
+  struct remote_state *rs = get_remote_state ();
+  int packet_len;
+
+  packet_len = getpkt_sane (&rs->buf, &rs->buf_size, 0);
+  if (packet_len < 0)
+    return TARGET_XFER_E_IO;
+
+  if (packet_len == 3 && rs->buf[0] == 'E'
+      && isxdigit (rs->buf[1]) && isxdigit (rs->buf[2]))
+    return TARGET_XFER_E_IO;
+
+  if (!remote_binary_upload_p ())
+    {
+      /* Reply describes memory byte by byte, each byte encoded as two
+	 hex characters.  */
+      return hex2bin (rs->buf, myaddr, len);
+    }
+
+  /* An "x" reply is "b" followed by the escaped binary data, which
+     the stub may have cut short to fit in a packet.  */
+  if (packet_len < 1 || rs->buf[0] != 'b')
+    error (_("Unknown remote memory read reply: %s"), rs->buf);
+
+  return remote_unescape_input ((gdb_byte *) rs->buf + 1, packet_len - 1,
+				myaddr, len);
+}
+
+/* Read LEN bytes at MEMADDR into MYADDR with up to WINDOW memory
+   read requests of at most TODO bytes each in flight, then collect
+   the replies in order.  Only used in no-ack mode, where putpkt does
+   not read from the remote.  Returns the number of bytes read before
+   the first error or short reply, or TARGET_XFER_E_IO if the first
+   request failed.  */
+
+static LONGEST
+remote_read_bytes_pipelined (CORE_ADDR memaddr, gdb_byte *myaddr, int len,
+			     int todo, int window)
+{
+  int count, i, done = 0;
+  LONGEST xfered = 0;
+
+  count = min (window, (len + todo - 1) / todo);
+  for (i = 0; i < count; i++)
+    remote_send_memory_read (memaddr + (CORE_ADDR) i * todo,
+			     min (todo, len - i * todo));
+
+  /* Every request gets a reply, so keep reading after a failure to
+     stay in step with the stub.  */
+  for (i = 0; i < count; i++)
+    {
+      int size = min (todo, len - i * todo);
+      LONGEST got;
+
+      got = remote_read_memory_reply (myaddr + i * todo, size);
+      if (done)
+	continue;
+
+      if (got < 0)
+	{
+	  if (i == 0)
+	    xfered = got;
+	  done = 1;
+	  continue;
+	}
+
+      xfered += got;
+      if (got < size)
+	done = 1;
+    }
+
+  return xfered;
+}
+
+/* Read memory data directly from the remote machine.
+   This does not use the data cache; the data cache uses this.
+   MEMADDR is the address in the remote memory space.
+   MYADDR is the address of the buffer in our space.
+   LEN is the number of bytes.
+
+   Returns number of bytes transferred, or a negative value (an 'enum
    target_xfer_error' value) for error.  */
 
 static LONGEST
@@ -6991,9 +7667,7 @@ remote_read_bytes (CORE_ADDR memaddr, gdb_byte *myaddr, int len)
 {
   struct remote_state *rs = get_remote_state ();
   int max_buf_size;		/* Max size of packet output buffer.  */
-  char *p;
   int todo;
-  int i;
 
   if (len <= 0)
     return 0;
@@ -7002,29 +7676,24 @@ remote_read_bytes (CORE_ADDR memaddr, gdb_byte *myaddr, int len)
   /* The packet buffer will be large enough for the payload;
      get_memory_packet_size ensures this.  */
 
-  /* Number if bytes that will fit.  */
-  todo = min (len, max_buf_size / 2);
+  /* Number if bytes that will fit.  A binary reply takes one
+     character per byte, plus the leading "b"; the stub sends fewer
+     bytes if escapes make them not fit.  */
+  if (remote_binary_upload_p ())
+    todo = min (len, max_buf_size - 1);
+  else
+    todo = min (len, max_buf_size / 2);
 
-  /* Construct "m"<memaddr>","<len>".  */
-  memaddr = remote_address_masked (memaddr);
-  p = rs->buf;
-  *p++ = 'm';
-  p += hexnumstr (p, (ULONGEST) memaddr);
-  *p++ = ',';
-  p += hexnumstr (p, (ULONGEST) todo);
-  *p = '\0';
-  putpkt (rs->buf);
-  getpkt (&rs->buf, &rs->buf_size, 0);
-  if (rs->buf[0] == 'E'
-      && isxdigit (rs->buf[1]) && isxdigit (rs->buf[2])
-      && rs->buf[3] == '\0')
-    return TARGET_XFER_E_IO;
-  /* Reply describes memory byte by byte, each byte encoded as two hex
-     characters.  */
-  p = rs->buf;
-  i = hex2bin (p, myaddr, todo);
+  /* If the stub takes several requests at once, keep that many in
+     flight so a large read is not limited by the round-trip
+     time.  */
+  if (todo < len && rs->noack_mode && rs->memory_read_window > 1)
+    return remote_read_bytes_pipelined (memaddr, myaddr, len, todo,
+					rs->memory_read_window);
+
+  remote_send_memory_read (memaddr, todo);
   /* Return what we have.  Let higher layers handle partial reads.  */
-  return i;
+  return remote_read_memory_reply (myaddr, todo);
 }
 
 
@@ -7259,6 +7928,149 @@ putpkt (char *buf)
   return putpkt_binary (buf, strlen (buf));
 }
 
+/* Forget all the packet statistics.  */
+
+static void
+remote_clear_packet_stats (void)
+{
+  remote_packet_stats_s *stats;
+  int ix;
+
+  for (ix = 0;
+       VEC_iterate (remote_packet_stats_s, remote_packet_stats, ix, stats);
+       ix++)
+    xfree (stats->name);
+  VEC_free (remote_packet_stats_s, remote_packet_stats);
+  remote_pending_replies_count = 0;
+}
+
+/* Return the index in REMOTE_PACKET_STATS of the type of the CNT
+   bytes packet BUF, adding it if needed.  'q', 'Q' and 'v' packets
+   are told apart by name, along with the object and operation of
+   qXfer and the operation of vFile.  */
+
+static int
+remote_packet_stats_type (const char *buf, int cnt)
+{
+  remote_packet_stats_s *stats;
+  remote_packet_stats_s new_stats;
+  int len, parts, ix;
+
+  if (cnt > 0 && (buf[0] == 'q' || buf[0] == 'Q' || buf[0] == 'v'))
+    {
+      if (cnt >= 5 && strncmp (buf, "qXfer", 5) == 0)
+	parts = 3;
+      else if (cnt >= 5 && strncmp (buf, "vFile", 5) == 0)
+	parts = 2;
+      else
+	parts = 1;
+
+      for (len = 0; len < cnt; len++)
+	if (buf[len] == ';' || buf[len] == ','
+	    || (buf[len] == ':' && --parts == 0))
+	  break;
+    }
+  else
+    len = cnt > 0 ? 1 : 0;
+
+  for (ix = 0;
+       VEC_iterate (remote_packet_stats_s, remote_packet_stats, ix, stats);
+       ix++)
+    if (strncmp (stats->name, buf, len) == 0 && stats->name[len] == '\0')
+      return ix;
+
+  memset (&new_stats, 0, sizeof (new_stats));
+  new_stats.name = savestring (buf, len);
+  VEC_safe_push (remote_packet_stats_s, remote_packet_stats, &new_stats);
+  return ix;
+}
+
+/* Account for sending the CNT bytes packet BUF.  */
+
+static void
+remote_count_sent_packet (const char *buf, int cnt)
+{
+  int type = remote_packet_stats_type (buf, cnt);
+  remote_packet_stats_s *stats
+    = VEC_index (remote_packet_stats_s, remote_packet_stats, type);
+  int slot;
+
+  stats->sent++;
+  stats->bytes_sent += cnt + 4;
+
+  if (remote_pending_replies_count == REMOTE_PENDING_REPLIES)
+    {
+      /* Give up on the oldest reply.  */
+      remote_pending_replies_first
+	= (remote_pending_replies_first + 1) % REMOTE_PENDING_REPLIES;
+      remote_pending_replies_count--;
+    }
+
+  slot = ((remote_pending_replies_first + remote_pending_replies_count)
+	  % REMOTE_PENDING_REPLIES);
+  remote_pending_replies[slot].type = type;
+  gettimeofday (&remote_pending_replies[slot].start, NULL);
+  remote_pending_replies_count++;
+}
+
+/* Account for receiving a LEN bytes reply to the oldest packet still
+   waiting for one.  */
+
+static void
+remote_count_reply (int len)
+{
+  remote_packet_stats_s *stats;
+  struct timeval now;
+  ULONGEST usecs, limit;
+  int slot = remote_pending_replies_first;
+  int bucket;
+
+  if (remote_pending_replies_count == 0)
+    return;
+
+  remote_pending_replies_first
+    = (remote_pending_replies_first + 1) % REMOTE_PENDING_REPLIES;
+  remote_pending_replies_count--;
+
+  gettimeofday (&now, NULL);
+  usecs = ((now.tv_sec - remote_pending_replies[slot].start.tv_sec)
+	   * 1000000
+	   + now.tv_usec - remote_pending_replies[slot].start.tv_usec);
+
+  for (bucket = 0, limit = 100;
+       bucket < REMOTE_RTT_BUCKETS - 1 && usecs >= limit;
+       bucket++, limit *= 10)
+    ;
+
+  stats = VEC_index (remote_packet_stats_s, remote_packet_stats,
+		     remote_pending_replies[slot].type);
+  stats->replies++;
+  stats->bytes_received += len + 4;
+  stats->usecs += usecs;
+  stats->histogram[bucket]++;
+}
+
+/* See remote.h.  */
+
+void
+remote_get_packet_totals (ULONGEST *packets, ULONGEST *bytes_sent,
+			  ULONGEST *bytes_received, ULONGEST *usecs)
+{
+  remote_packet_stats_s *stats;
+  int ix;
+
+  *packets = *bytes_sent = *bytes_received = *usecs = 0;
+  for (ix = 0;
+       VEC_iterate (remote_packet_stats_s, remote_packet_stats, ix, stats);
+       ix++)
+    {
+      *packets += stats->sent;
+      *bytes_sent += stats->bytes_sent;
+      *bytes_received += stats->bytes_received;
+      *usecs += stats->usecs;
+    }
+}
+
 /* Send a packet to the remote machine, with error checking.  The data
    of the packet is in BUF.  The string in BUF can be at most
    get_remote_packet_size () - 5 to account for the $, # and checksum,
@@ -7292,6 +8104,8 @@ putpkt_binary (char *buf, int cnt)
      stale cached response.  */
   rs->cached_wait_status = 0;
 
+  remote_count_sent_packet (buf, cnt);
+
   /* Copy the packet into buffer BUF2, encapsulating it
      and giving it a checksum.  */
 
@@ -7503,6 +8317,63 @@ skip_frame (void)
    trailing NULL) on success. (could be extended to return one of the
    SERIAL status indications).  */
 
+/* Decompress the payload of a compressed frame, the LEN characters in
+   *BUF_P, in place, growing *BUF_P if needed.  The payload is the size
+   of the uncompressed data in hex, ":", then the zlib-compressed data
+   as escaped binary.  Return the length of the packet, or -1 if the
+   payload is malformed.  */
+
+static long
+remote_inflate_packet (char **buf_p, long *sizeof_buf, long len)
+{
+#ifdef HAVE_ZLIB_H
+  char *buf = *buf_p;
+  char *colon = memchr (buf, ':', len);
+  ULONGEST size;
+  uLongf dest_len;
+  gdb_byte *zbuf;
+  long start = get_run_time ();
+  int zlen, ok;
+
+  if (colon == NULL || colon == buf)
+    return -1;
+  *colon = '\0';
+  /* Real packets may be larger than MAX_REMOTE_PACKET_SIZE; only
+     reject a size that zlib, which compresses at most 1032:1, cannot
+     have produced from this frame.  */
+  if (strlen (unpack_varlen_hex (buf, &size)) != 0
+      || size > (ULONGEST) len * 1032)
+    return -1;
+
+  zbuf = xmalloc (len);
+  zlen = remote_unescape_input ((gdb_byte *) colon + 1,
+				len - (colon + 1 - buf), zbuf, len);
+
+  if (size + 1 > *sizeof_buf)
+    {
+      *sizeof_buf = size + 1;
+      *buf_p = xrealloc (*buf_p, *sizeof_buf);
+    }
+
+  dest_len = size;
+  ok = (uncompress ((Bytef *) *buf_p, &dest_len, zbuf, zlen) == Z_OK
+	&& dest_len == size);
+  xfree (zbuf);
+  if (!ok)
+    return -1;
+  (*buf_p)[size] = '\0';
+
+  remote_compression_stats.packets++;
+  remote_compression_stats.wire_bytes += len;
+  remote_compression_stats.bytes += size;
+  remote_compression_stats.usecs += get_run_time () - start;
+
+  return size;
+#else
+  return -1;
+#endif
+}
+
 static long
 read_frame (char **buf_p,
 	    long *sizeof_buf)
@@ -7707,7 +8578,7 @@ getpkt_or_notif_sane_1 (char **buf, long *sizeof_buf, int forever,
 	     show up within remote_timeout intervals.  */
 	  do
 	    c = readchar (timeout);
-	  while (c != SERIAL_TIMEOUT && c != '$' && c != '%');
+	  while (c != SERIAL_TIMEOUT && c != '$' && c != '%' && c != '&');
 
 	  if (c == SERIAL_TIMEOUT)
 	    {
@@ -7731,6 +8602,16 @@ getpkt_or_notif_sane_1 (char **buf, long *sizeof_buf, int forever,
 	      /* We've found the start of a packet or notification.
 		 Now collect the data.  */
 	      val = read_frame (buf, sizeof_buf);
+
+	      /* A '&' frame is an ordinary packet, compressed.  */
+	      if (val >= 0 && c == '&')
+		{
+		  val = remote_inflate_packet (buf, sizeof_buf, val);
+		  if (val < 0 && remote_debug)
+		    fputs_filtered ("Bad compressed packet, retrying\n",
+				    gdb_stdlog);
+		  c = '$';
+		}
 	      if (val >= 0)
 		break;
 	    }
@@ -7769,6 +8650,7 @@ getpkt_or_notif_sane_1 (char **buf, long *sizeof_buf, int forever,
 	    remote_serial_write ("+", 1);
 	  if (is_notif != NULL)
 	    *is_notif = 0;
+	  remote_count_reply (val);
 	  return val;
 	}
 
@@ -7914,6 +8796,10 @@ extended_remote_mourn_1 (struct target_ops *target)
      connected.  */
   rs->waiting_for_stop_reply = 0;
 
+  /* GDB forgets the threads of the process; have the next thread
+     list update fetch them all.  */
+  rs->threads_generation_p = 0;
+
   /* If the current general thread belonged to the process we just
      detached from or has exited, the remote side current general
      thread becomes undefined.  Considering a case like this:
@@ -8600,24 +9486,128 @@ remote_verify_memory (struct target_ops *ops,
   return (host_crc == target_crc);
 }
 
+/* Read the contents of section S of the exec file, and return their
+   CRC, as computed by the "qCRC:" request.  */
+
+static unsigned long
+section_crc (asection *s)
+{
+  bfd_size_type size = bfd_get_section_size (s);
+  struct cleanup *old_chain;
+  gdb_byte *sectdata;
+  unsigned long crc;
+
+  sectdata = xmalloc (size);
+  old_chain = make_cleanup (xfree, sectdata);
+  bfd_get_section_contents (exec_bfd, s, sectdata, 0, size);
+  crc = xcrc32 (sectdata, size, 0xffffffff);
+  do_cleanups (old_chain);
+
+  return crc;
+}
+
+/* Verify the first sections of the COUNT in SECTS against the
+   target's memory with a single "qCRC:" request for several ranges.
+   Store in RESULTS 1 for each section that matched, 0 for each one
+   that didn't, or -1 for each one whose memory the target couldn't
+   read, and return how many sections were verified.  The request
+   holds as many sections as fit in a packet, and the target may
+   reply for fewer.  */
+
+static int
+remote_verify_sections (asection **sects, int count, int *results)
+{
+  struct remote_state *rs = get_remote_state ();
+  int max_size = get_remote_packet_size ();
+  unsigned long *host_crcs;
+  struct cleanup *old_chain;
+  char *p, *endbuf = rs->buf + max_size;
+  int i, n;
+
+  p = rs->buf;
+  strcpy (p, "qCRC:");
+  p += strlen (p);
+  for (n = 0; n < count; n++)
+    {
+      char item[2 * (2 * sizeof (ULONGEST) + 1)];
+      asection *s = sects[n];
+      int len;
+
+      len = xsnprintf (item, sizeof (item), "%s%s,%s",
+		       n > 0 ? ";" : "",
+		       phex_nz (s->lma, 0),
+		       phex_nz (bfd_get_section_size (s), 0));
+      if (n > 0 && p + len >= endbuf)
+	break;
+      strcpy (p, item);
+      p += len;
+    }
+  putpkt (rs->buf);
+
+  /* Compute the host CRCs while the target computes its own.  */
+  host_crcs = xmalloc (n * sizeof (unsigned long));
+  old_chain = make_cleanup (xfree, host_crcs);
+  for (i = 0; i < n; i++)
+    host_crcs[i] = section_crc (sects[i]);
+
+  getpkt (&rs->buf, &rs->buf_size, 0);
+  p = rs->buf;
+  for (i = 0; i < n && *p != '\0'; i++)
+    {
+      ULONGEST target_crc;
+
+      if (i > 0)
+	{
+	  if (*p != ';')
+	    break;
+	  p++;
+	}
+
+      if (*p == 'E')
+	{
+	  results[i] = -1;
+	  while (*p != '\0' && *p != ';')
+	    p++;
+	  continue;
+	}
+
+      if (*p != 'C')
+	break;
+
+      p = unpack_varlen_hex (p + 1, &target_crc);
+      results[i] = host_crcs[i] == target_crc;
+    }
+
+  do_cleanups (old_chain);
+
+  if (i == 0)
+    error (_("remote target does not support this operation"));
+
+  return i;
+}
+
 /* compare-sections command
 
    With no arguments, compares each loadable section in the exec bfd
    with the same memory range on the target, and reports mismatches.
-   Useful for verifying the image on the target against the exec file.  */
+   Useful for verifying the image on the target against the exec file.
+   If the target supports it, the sections are checked in batches
+   with a single request each.  */
 
 static void
 compare_sections_command (char *args, int from_tty)
 {
+  struct remote_state *rs = get_remote_state ();
   asection *s;
   struct cleanup *old_chain;
-  gdb_byte *sectdata;
+  asection **sects;
+  int *results;
   const char *sectname;
   bfd_size_type size;
   bfd_vma lma;
-  int matched = 0;
+  int count = 0;
   int mismatched = 0;
-  int res;
+  int i, j, n;
 
   if (!exec_bfd)
     error (_("command cannot be used without an exec file"));
@@ -8625,6 +9615,9 @@ compare_sections_command (char *args, int from_tty)
   /* Make sure the remote is pointing at the right process.  */
   set_general_process ();
 
+  sects = xmalloc (bfd_count_sections (exec_bfd) * sizeof (asection *));
+  old_chain = make_cleanup (xfree, sects);
+
   for (s = exec_bfd->sections; s; s = s->next)
     {
       if (!(s->flags & SEC_LOAD))
@@ -8638,37 +9631,66 @@ compare_sections_command (char *args, int from_tty)
       if (args && strcmp (args, sectname) != 0)
 	continue;		/* Not the section selected by user.  */
 
-      matched = 1;		/* Do this section.  */
-      lma = s->lma;
-
-      sectdata = xmalloc (size);
-      old_chain = make_cleanup (xfree, sectdata);
-      bfd_get_section_contents (exec_bfd, s, sectdata, 0, size);
-
-      res = target_verify_memory (sectdata, lma, size);
+      sects[count++] = s;	/* Do this section.  */
+    }
 
-      if (res == -1)
-	error (_("target memory fault, section %s, range %s -- %s"), sectname,
-	       paddress (target_gdbarch (), lma),
-	       paddress (target_gdbarch (), lma + size));
+  results = xmalloc (count * sizeof (int));
+  make_cleanup (xfree, results);
 
-      printf_filtered ("Section %s, range %s -- %s: ", sectname,
-		       paddress (target_gdbarch (), lma),
-		       paddress (target_gdbarch (), lma + size));
-      if (res)
-	printf_filtered ("matched.\n");
+  for (i = 0; i < count; i += n)
+    {
+      if (rs->remote_desc != NULL
+	  && (remote_protocol_packets[PACKET_qCRC_ranges].support
+	      == PACKET_ENABLE))
+	n = remote_verify_sections (sects + i, count - i, results);
       else
 	{
-	  printf_filtered ("MIS-MATCHED!\n");
-	  mismatched++;
+	  struct cleanup *data_chain;
+	  gdb_byte *sectdata;
+
+	  s = sects[i];
+	  size = bfd_get_section_size (s);
+	  sectdata = xmalloc (size);
+	  data_chain = make_cleanup (xfree, sectdata);
+	  bfd_get_section_contents (exec_bfd, s, sectdata, 0, size);
+
+	  n = 1;
+	  results[0] = target_verify_memory (sectdata, s->lma, size);
+
+	  do_cleanups (data_chain);
 	}
 
-      do_cleanups (old_chain);
+      for (j = 0; j < n; j++)
+	{
+	  s = sects[i + j];
+	  sectname = bfd_get_section_name (exec_bfd, s);
+	  lma = s->lma;
+	  size = bfd_get_section_size (s);
+
+	  if (results[j] == -1)
+	    error (_("target memory fault, section %s, range %s -- %s"),
+		   sectname, paddress (target_gdbarch (), lma),
+		   paddress (target_gdbarch (), lma + size));
+
+	  printf_filtered ("Section %s, range %s -- %s: ", sectname,
+			   paddress (target_gdbarch (), lma),
+			   paddress (target_gdbarch (), lma + size));
+	  if (results[j])
+	    printf_filtered ("matched.\n");
+	  else
+	    {
+	      printf_filtered ("MIS-MATCHED!\n");
+	      mismatched++;
+	    }
+	}
     }
+
+  do_cleanups (old_chain);
+
   if (mismatched > 0)
     warning (_("One or more sections of the remote executable does not match\n\
 the loaded file\n"));
-  if (args && !matched)
+  if (args && count == 0)
     printf_filtered (_("No loaded section named '%s'.\n"), args);
 }
 
@@ -8895,6 +9917,11 @@ remote_xfer_partial (struct target_ops *ops, enum target_object object,
 	(ops, "features", annex, readbuf, offset, len,
 	 &remote_protocol_packets[PACKET_qXfer_features]);
 
+    case TARGET_OBJECT_AVAILABLE_FEATURES_HASH:
+      return remote_read_qxfer
+	(ops, "features-hash", annex, readbuf, offset, len,
+	 &remote_protocol_packets[PACKET_qXfer_features_hash]);
+
     case TARGET_OBJECT_LIBRARIES:
       return remote_read_qxfer
 	(ops, "libraries", annex, readbuf, offset, len,
@@ -8918,7 +9945,6 @@ remote_xfer_partial (struct target_ops *ops, enum target_object object,
         &remote_protocol_packets[PACKET_qXfer_osdata]);
 
     case TARGET_OBJECT_THREADS:
-      gdb_assert (annex == NULL);
       return remote_read_qxfer (ops, "threads", annex, readbuf, offset, len,
 				&remote_protocol_packets[PACKET_qXfer_threads]);
 
@@ -9170,6 +10196,67 @@ remote_memory_map (struct target_ops *ops)
   return result;
 }
 
+/* Implement "maintenance info remote-compression".  */
+
+static void
+maintenance_info_remote_compression (char *args, int from_tty)
+{
+  ULONGEST wire = remote_compression_stats.wire_bytes;
+  ULONGEST bytes = remote_compression_stats.bytes;
+
+  printf_filtered (_("Compressed packets received: %s\n"),
+		   pulongest (remote_compression_stats.packets));
+  if (remote_compression_stats.packets == 0)
+    return;
+
+  printf_filtered (_("Bytes received: %s, %s once decompressed\n"),
+		   pulongest (wire), pulongest (bytes));
+  printf_filtered (_("Compression ratio: %.2f\n"), (double) bytes / wire);
+  printf_filtered (_("Bytes saved: %s\n"), pulongest (bytes - wire));
+  printf_filtered (_("Time spent decompressing: %ld.%06ld seconds\n"),
+		   remote_compression_stats.usecs / 1000000,
+		   remote_compression_stats.usecs % 1000000);
+}
+
+/* Implement "maint info remote-stats".  */
+
+static void
+maintenance_info_remote_stats (char *args, int from_tty)
+{
+  static const char *const bucket_names[REMOTE_RTT_BUCKETS] =
+    { "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s" };
+  remote_packet_stats_s *stats;
+  int ix, bucket;
+
+  if (VEC_empty (remote_packet_stats_s, remote_packet_stats))
+    {
+      printf_filtered (_("No packets have been sent to the target.\n"));
+      return;
+    }
+
+  printf_filtered ("%-28s %8s %10s %8s %10s %10s",
+		   _("Packet"), _("Sent"), _("Bytes"), _("Replies"),
+		   _("Bytes"), _("Avg usecs"));
+  for (bucket = 0; bucket < REMOTE_RTT_BUCKETS; bucket++)
+    printf_filtered (" %7s", bucket_names[bucket]);
+  printf_filtered ("\n");
+
+  for (ix = 0;
+       VEC_iterate (remote_packet_stats_s, remote_packet_stats, ix, stats);
+       ix++)
+    {
+      printf_filtered ("%-28s %8s %10s %8s %10s %10s", stats->name,
+		       pulongest (stats->sent), pulongest (stats->bytes_sent),
+		       pulongest (stats->replies),
+		       pulongest (stats->bytes_received),
+		       pulongest (stats->replies != 0
+				  ? stats->usecs / stats->replies : 0));
+      for (bucket = 0; bucket < REMOTE_RTT_BUCKETS; bucket++)
+	printf_filtered (" %7s", pulongest (stats->histogram[bucket]));
+      printf_filtered ("\n");
+    }
+}
+
 static void
 packet_command (char *args, int from_tty)
 {
@@ -9690,6 +10777,12 @@ remote_hostio_parse_result (char *buffer, int *retcode,
     return -1;
 }
 
+static int remote_hostio_send_request (int command_bytes, int which_packet,
+				       int *remote_errno);
+static int remote_hostio_read_result (int which_packet, int *remote_errno,
+				      char **attachment,
+				      int *attachment_len);
+
 /* Send a prepared I/O packet to the target and read its response.
    The prepared packet is in the global RS->BUF before this function
    is called, and the answer is there when we return.
@@ -9710,10 +10803,24 @@ static int
 remote_hostio_send_command (int command_bytes, int which_packet,
 			    int *remote_errno, char **attachment,
 			    int *attachment_len)
+{
+  if (remote_hostio_send_request (command_bytes, which_packet,
+				  remote_errno) < 0)
+    return -1;
+
+  return remote_hostio_read_result (which_packet, remote_errno,
+				    attachment, attachment_len);
+}
+
+/* Send the prepared I/O packet in RS->BUF, of COMMAND_BYTES bytes,
+   without waiting for the response.  Return 0, or -1 if WHICH_PACKET
+   cannot be used (and set *REMOTE_ERRNO).  */
+
+static int
+remote_hostio_send_request (int command_bytes, int which_packet,
+			    int *remote_errno)
 {
   struct remote_state *rs = get_remote_state ();
-  int ret, bytes_read;
-  char *attachment_tmp;
 
   if (!rs->remote_desc
       || remote_protocol_packets[which_packet].support == PACKET_DISABLE)
@@ -9723,6 +10830,21 @@ remote_hostio_send_command (int command_bytes, int which_packet,
     }
 
   putpkt_binary (rs->buf, command_bytes);
+  return 0;
+}
+
+/* Read the response to an I/O packet sent by
+   remote_hostio_send_request, and return it as
+   remote_hostio_send_command does.  */
+
+static int
+remote_hostio_read_result (int which_packet, int *remote_errno,
+			   char **attachment, int *attachment_len)
+{
+  struct remote_state *rs = get_remote_state ();
+  int ret, bytes_read;
+  char *attachment_tmp;
+
   bytes_read = getpkt_sane (&rs->buf, &rs->buf_size, 0);
 
   /* If it timed out, something is wrong.  Don't try to parse the
@@ -9826,20 +10948,15 @@ remote_hostio_pwrite (int fd, const gdb_byte *write_buf, int len,
 				     remote_errno, NULL, NULL);
 }
 
-/* Read up to LEN bytes FD on the remote target into READ_BUF
-   Return the number of bytes read, or -1 if an error occurs (and
-   set *REMOTE_ERRNO).  */
+/* Prepare in RS->BUF a request to read LEN bytes at OFFSET from FD
+   on the remote target.  Return the length of the request.  */
 
 static int
-remote_hostio_pread (int fd, gdb_byte *read_buf, int len,
-		     ULONGEST offset, int *remote_errno)
+remote_hostio_pread_request (int fd, int len, ULONGEST offset)
 {
   struct remote_state *rs = get_remote_state ();
   char *p = rs->buf;
-  char *attachment;
   int left = get_remote_packet_size ();
-  int ret, attachment_len;
-  int read_len;
 
   remote_buffer_add_string (&p, &left, "vFile:pread:");
 
@@ -9851,9 +10968,22 @@ remote_hostio_pread (int fd, gdb_byte *read_buf, int len,
 
   remote_buffer_add_int (&p, &left, offset);
 
-  ret = remote_hostio_send_command (p - rs->buf, PACKET_vFile_pread,
-				    remote_errno, &attachment,
-				    &attachment_len);
+  return p - rs->buf;
+}
+
+/* Read the response to a request for up to LEN bytes sent by
+   remote_hostio_pread_request into READ_BUF.  Return the number of
+   bytes read, or -1 if an error occurs (and set *REMOTE_ERRNO).  */
+
+static int
+remote_hostio_pread_reply (gdb_byte *read_buf, int len, int *remote_errno)
+{
+  char *attachment;
+  int ret, attachment_len;
+  int read_len;
+
+  ret = remote_hostio_read_result (PACKET_vFile_pread, remote_errno,
+				   &attachment, &attachment_len);
 
   if (ret < 0)
     return ret;
@@ -9866,6 +10996,131 @@ remote_hostio_pread (int fd, gdb_byte *read_buf, int len,
   return ret;
 }
 
+/* Read up to LEN bytes FD on the remote target into READ_BUF
+   Return the number of bytes read, or -1 if an error occurs (and
+   set *REMOTE_ERRNO).  */
+
+static int
+remote_hostio_pread (int fd, gdb_byte *read_buf, int len,
+		     ULONGEST offset, int *remote_errno)
+{
+  if (remote_hostio_send_request (remote_hostio_pread_request (fd, len,
+							       offset),
+				  PACKET_vFile_pread, remote_errno) < 0)
+    return -1;
+
+  return remote_hostio_pread_reply (read_buf, len, remote_errno);
+}
+
+/* Read up to LEN bytes at OFFSET from FD on the remote target into
+   READ_BUF, keeping as many vFile:pread requests of a packet each in
+   flight as the stub accepts memory reads (see
+   remote_read_bytes_pipelined).  Return the number of bytes read,
+   which is less than LEN only at the end of the file or after an
+   error, or -1 if an error occurs before anything is read (and set
+   *REMOTE_ERRNO).  */
+
+static LONGEST
+remote_hostio_pread_all (int fd, gdb_byte *read_buf, LONGEST len,
+			 ULONGEST offset, int *remote_errno)
+{
+  struct remote_state *rs = get_remote_state ();
+  int chunk = get_remote_packet_size ();
+  int window = 1;
+  struct pread_request
+  {
+    LONGEST start;
+    int size;
+  } *queue;
+  int head = 0, count = 0, failed = 0;
+  struct cleanup *old_chain;
+  /* The start of the next new request, and where the data stops:
+     LEN, or the end of the file or the first failed request once
+     they are known.  */
+  LONGEST next = 0, end = len;
+
+  if (rs->noack_mode && rs->memory_read_window > 1)
+    window = rs->memory_read_window;
+
+  queue = xmalloc (window * sizeof (*queue));
+  old_chain = make_cleanup (xfree, queue);
+
+  while (1)
+    {
+      struct pread_request *req;
+      int errno_tmp, got;
+
+      /* Keep the window full.  */
+      while (count < window && next < end)
+	{
+	  req = &queue[(head + count) % window];
+	  req->start = next;
+	  req->size = min (chunk, end - next);
+	  if (remote_hostio_send_request (remote_hostio_pread_request
+					  (fd, req->size, offset + next),
+					  PACKET_vFile_pread,
+					  &errno_tmp) < 0)
+	    {
+	      *remote_errno = errno_tmp;
+	      end = next;
+	      failed = 1;
+	      break;
+	    }
+	  next += req->size;
+	  count++;
+	}
+
+      if (count == 0)
+	break;
+
+      /* Replies come in the order of the requests.  */
+      req = &queue[head];
+      head = (head + 1) % window;
+      count--;
+
+      got = remote_hostio_pread_reply (read_buf + req->start, req->size,
+				       &errno_tmp);
+      if (got <= 0)
+	{
+	  /* A failure, or the end of the file.  */
+	  if (req->start < end)
+	    {
+	      end = req->start;
+	      failed = got < 0;
+	      if (failed)
+		*remote_errno = errno_tmp;
+	    }
+	}
+      else if (got < req->size && req->start + got < end)
+	{
+	  struct pread_request *rest = &queue[(head + count) % window];
+
+	  /* The stub sent less than asked, usually because escapes
+	     took room in the packet; ask for the rest.  */
+	  rest->start = req->start + got;
+	  rest->size = req->size - got;
+	  if (remote_hostio_send_request (remote_hostio_pread_request
+					  (fd, rest->size,
+					   offset + rest->start),
+					  PACKET_vFile_pread,
+					  &errno_tmp) < 0)
+	    {
+	      *remote_errno = errno_tmp;
+	      end = rest->start;
+	      failed = 1;
+	    }
+	  else
+	    count++;
+	}
+    }
+
+  do_cleanups (old_chain);
+
+  if (failed && end == 0)
+    return -1;
+  return end;
+}
+
 /* Close FD on the remote target.  Return 0, or -1 if an error occurs
    (and set *REMOTE_ERRNO).  */
 
@@ -9941,6 +11196,77 @@ remote_hostio_readlink (const char *filename, int *remote_errno)
   return ret;
 }
 
+/* Convert the remote stat buffer FST to *ST.  Fields that struct
+   fio_stat does not have are left zero.  */
+
+static void
+remote_fileio_to_host_stat (struct fio_stat *fst, struct stat *st)
+{
+  ULONGEST mode;
+
+#define FIO_FIELD(field) \
+  extract_unsigned_integer ((gdb_byte *) fst->field, sizeof (fst->field), \
+			    BFD_ENDIAN_BIG)
+
+  memset (st, 0, sizeof (*st));
+  st->st_dev = FIO_FIELD (fst_dev);
+  st->st_ino = FIO_FIELD (fst_ino);
+  st->st_nlink = FIO_FIELD (fst_nlink);
+  st->st_uid = FIO_FIELD (fst_uid);
+  st->st_gid = FIO_FIELD (fst_gid);
+  st->st_rdev = FIO_FIELD (fst_rdev);
+  st->st_size = FIO_FIELD (fst_size);
+  st->st_atime = FIO_FIELD (fst_atime);
+  st->st_mtime = FIO_FIELD (fst_mtime);
+  st->st_ctime = FIO_FIELD (fst_ctime);
+
+  mode = FIO_FIELD (fst_mode);
+  st->st_mode = mode & 0777;
+  if (mode & FILEIO_S_IFREG)
+    st->st_mode |= S_IFREG;
+  else if (mode & FILEIO_S_IFDIR)
+    st->st_mode |= S_IFDIR;
+  else if (mode & FILEIO_S_IFCHR)
+    st->st_mode |= S_IFCHR;
+
+#undef FIO_FIELD
+}
+
+/* Read the status of FD on the remote target into *ST.  Return 0, or
+   -1 if an error occurs (and set *REMOTE_ERRNO).  */
+
+static int
+remote_hostio_fstat (int fd, struct stat *st, int *remote_errno)
+{
+  struct remote_state *rs = get_remote_state ();
+  char *p = rs->buf;
+  int left = get_remote_packet_size () - 1;
+  char *attachment;
+  int ret, attachment_len, read_len;
+  struct fio_stat fst;
+
+  remote_buffer_add_string (&p, &left, "vFile:fstat:");
+
+  remote_buffer_add_int (&p, &left, fd);
+
+  ret = remote_hostio_send_command (p - rs->buf, PACKET_vFile_fstat,
+				    remote_errno, &attachment,
+				    &attachment_len);
+  if (ret < 0)
+    return ret;
+
+  read_len = remote_unescape_input ((gdb_byte *) attachment, attachment_len,
+				    (gdb_byte *) &fst, sizeof (fst));
+  if (read_len != ret)
+    error (_("Fstat returned %d, but %d bytes."), ret, read_len);
+  if (read_len != sizeof (fst))
+    error (_("Fstat returned %d bytes, expected %d."),
+	   read_len, (int) sizeof (fst));
+
+  remote_fileio_to_host_stat (&fst, st);
+  return 0;
+}
+
 static int
 remote_fileio_errno_to_host (int errnum)
 {
@@ -10013,12 +11339,28 @@ remote_hostio_close_cleanup (void *opaque)
 }
 
 
+/* A remote file opened as a BFD.  */
+
+struct remote_bfd_stream
+{
+  /* The remote file descriptor.  */
+  int fd;
+
+  /* The bytes last read ahead of a small request, at offset
+     BUF_OFFSET of the file, or NULL.  BFD reads headers, symbols and
+     the like in many small pieces that are close together, and this
+     saves a round trip for most of them.  */
+  gdb_byte *buf;
+  file_ptr buf_offset;
+  int buf_len;
+};
+
 static void *
 remote_bfd_iovec_open (struct bfd *abfd, void *open_closure)
 {
   const char *filename = bfd_get_filename (abfd);
   int fd, remote_errno;
-  int *stream;
+  struct remote_bfd_stream *stream;
 
   gdb_assert (remote_filename_p (filename));
 
@@ -10030,18 +11372,20 @@ remote_bfd_iovec_open (struct bfd *abfd, void *open_closure)
       return NULL;
     }
 
-  stream = xmalloc (sizeof (int));
-  *stream = fd;
+  stream = XZALLOC (struct remote_bfd_stream);
+  stream->fd = fd;
   return stream;
 }
 
 static int
 remote_bfd_iovec_close (struct bfd *abfd, void *stream)
 {
-  int fd = *(int *)stream;
+  struct remote_bfd_stream *s = stream;
+  int fd = s->fd;
   int remote_errno;
 
-  xfree (stream);
+  xfree (s->buf);
+  xfree (s);
 
   /* Ignore errors on close; these may happen if the remote
      connection was already torn down.  */
@@ -10055,35 +11399,62 @@ static file_ptr
 remote_bfd_iovec_pread (struct bfd *abfd, void *stream, void *buf,
 			file_ptr nbytes, file_ptr offset)
 {
-  int fd = *(int *)stream;
+  struct remote_bfd_stream *s = stream;
+  int read_ahead = get_remote_packet_size ();
   int remote_errno;
-  file_ptr pos, bytes;
+  LONGEST bytes;
 
-  pos = 0;
-  while (nbytes > pos)
+  /* Large requests go straight to the remote file, with replies in
+     flight for a whole window of requests.  */
+  if (nbytes >= read_ahead)
     {
-      bytes = remote_hostio_pread (fd, (gdb_byte *) buf + pos, nbytes - pos,
-				   offset + pos, &remote_errno);
-      if (bytes == 0)
-        /* Success, but no bytes, means end-of-file.  */
-        break;
+      bytes = remote_hostio_pread_all (s->fd, buf, nbytes, offset,
+				       &remote_errno);
       if (bytes == -1)
 	{
 	  errno = remote_fileio_errno_to_host (remote_errno);
 	  bfd_set_error (bfd_error_system_call);
 	  return -1;
 	}
+      return bytes;
+    }
 
-      pos += bytes;
+  /* Small ones read a whole packet, unless the last one did.  */
+  if (s->buf == NULL
+      || offset < s->buf_offset
+      || offset + nbytes > s->buf_offset + s->buf_len)
+    {
+      s->buf = xrealloc (s->buf, read_ahead);
+      s->buf_len = 0;
+      bytes = remote_hostio_pread_all (s->fd, s->buf, read_ahead, offset,
+				       &remote_errno);
+      if (bytes == -1)
+	{
+	  errno = remote_fileio_errno_to_host (remote_errno);
+	  bfd_set_error (bfd_error_system_call);
+	  return -1;
+	}
+      s->buf_offset = offset;
+      s->buf_len = bytes;
     }
 
-  return pos;
+  /* The end of the file may be before the end of the request.  */
+  bytes = min (nbytes, s->buf_offset + s->buf_len - offset);
+  memcpy (buf, s->buf + (offset - s->buf_offset), bytes);
+  return bytes;
 }
 
 static int
 remote_bfd_iovec_stat (struct bfd *abfd, void *stream, struct stat *sb)
 {
-  /* FIXME: We should probably implement remote_hostio_stat.  */
+  struct remote_bfd_stream *s = stream;
+  int remote_errno;
+
+  if (remote_hostio_fstat (s->fd, sb, &remote_errno) == 0)
+    return 0;
+
+  /* Without vFile:fstat, pretend the file is as large as can be.  */
+  memset (sb, 0, sizeof (*sb));
   sb->st_size = INT_MAX;
   return 0;
 }
@@ -10096,6 +11467,336 @@ remote_filename_p (const char *filename)
 		  sizeof (REMOTE_SYSROOT_PREFIX) - 1) == 0;
 }
 
+/* When non-zero, object files read from the target are copied to the
+   remote file cache, and read from there.  */
+
+static int remote_file_cache_enabled = 0;
+
+/* The directory holding the remote file cache.  */
+
+static char *remote_file_cache_directory;
+
+/* How many bytes of a remote file are read at once when copying it to
+   the cache.  */
+
+#define REMOTE_FILE_CACHE_BUFFER_SIZE (1024 * 1024)
+
+static void
+show_remote_file_cache_enabled (struct ui_file *file, int from_tty,
+				struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("Whether to cache remote files is %s.\n"),
+		    value);
+}
+
+static void
+show_remote_file_cache_directory (struct ui_file *file, int from_tty,
+				  struct cmd_list_element *c,
+				  const char *value)
+{
+  fprintf_filtered (file,
+		    _("The directory of the remote file cache is \"%s\".\n"),
+		    value);
+}
+
+#ifdef USE_WIN32API
+#undef mkdir
+#define mkdir(pathname, mode) mkdir (pathname)
+#endif
+
+/* Create the missing directories leading to the file NAME.  Return 0
+   on success, or -1 with errno set.  */
+
+static int
+remote_file_cache_make_dirs (const char *name)
+{
+  char *dir = xstrdup (name);
+  char *p;
+  int ret = 0;
+
+  for (p = dir + 1; *p != '\0' && ret == 0; p++)
+    if (IS_DIR_SEPARATOR (*p))
+      {
+	char c = *p;
+
+	*p = '\0';
+	if (mkdir (dir, 0700) != 0 && errno != EEXIST)
+	  ret = -1;
+	*p = c;
+      }
+
+  xfree (dir);
+  return ret;
+}
+
+/* Return the name of the copy in the cache of the remote file ABFD,
+   to be freed by the caller, or NULL if it cannot have one.  ST is
+   the status of the remote file, or NULL if that is unknown.
+
+   An ELF file is named after its build-id, so that a library is only
+   copied once whatever its name and the target it comes from.  Other
+   files are named after their name, size and modification time.  */
+
+static char *
+remote_file_cache_name (bfd *abfd, const struct stat *st)
+{
+  const char *filename
+    = bfd_get_filename (abfd) + sizeof (REMOTE_SYSROOT_PREFIX) - 1;
+  const struct elf_build_id *build_id = build_id_bfd_get (abfd);
+  size_t len;
+
+  if (build_id != NULL && build_id->size > 1)
+    {
+      char *hex = alloca (2 * build_id->size + 1);
+
+      bin2hex (build_id->data, hex, build_id->size);
+      return xstrprintf ("%s/build-id/%.2s/%s", remote_file_cache_directory,
+			 hex, hex + 2);
+    }
+
+  /* Refuse the names that could put the copy outside of the cache.  */
+  len = strlen (filename);
+  if (st == NULL
+      || filename[0] != '/'
+      || strstr (filename, "/../") != NULL
+      || (len >= 3 && strcmp (filename + len - 3, "/..") == 0))
+    return NULL;
+
+  return xstrprintf ("%s/files%s.%s-%s", remote_file_cache_directory,
+		     filename, pulongest (st->st_size),
+		     pulongest (st->st_mtime));
+}
+
+/* A copy being written to the cache.  */
+
+struct remote_file_cache_copy
+{
+  /* The temporary name of the copy, and the descriptor it is open
+     with, or -1.  */
+  char *name;
+  int fd;
+};
+
+/* Close and remove the copy ARG, unless it was renamed already.  */
+
+static void
+remote_file_cache_copy_cleanup (void *arg)
+{
+  struct remote_file_cache_copy *copy = arg;
+
+  if (copy->fd != -1)
+    close (copy->fd);
+  unlink (copy->name);
+}
+
+/* Copy the remote file FD to NAME in the cache, and return a
+   descriptor open for reading on the copy, or -1 after a warning if
+   that fails.  The copy is written under a temporary name, so that no
+   incomplete copy is ever found in the cache, even if GDB dies while
+   writing it.  */
+
+static int
+remote_file_cache_fetch (int fd, const char *name)
+{
+  struct remote_file_cache_copy copy;
+  struct cleanup *old_chain;
+  ULONGEST offset = 0;
+  gdb_byte *buf;
+  int ret = -1;
+
+  if (remote_file_cache_make_dirs (name) != 0)
+    {
+      warning (_("Cannot create the directories of \"%s\": %s"),
+	       name, safe_strerror (errno));
+      return -1;
+    }
+
+  copy.name = xstrprintf ("%s.%d", name, (int) getpid ());
+  old_chain = make_cleanup (xfree, copy.name);
+  copy.fd = gdb_open_cloexec (copy.name,
+			      O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0600);
+  if (copy.fd == -1)
+    {
+      warning (_("Cannot create \"%s\": %s"), copy.name,
+	       safe_strerror (errno));
+      do_cleanups (old_chain);
+      return -1;
+    }
+  make_cleanup (remote_file_cache_copy_cleanup, &copy);
+
+  buf = xmalloc (REMOTE_FILE_CACHE_BUFFER_SIZE);
+  make_cleanup (xfree, buf);
+
+  while (1)
+    {
+      int remote_errno;
+      LONGEST bytes;
+
+      bytes = remote_hostio_pread_all (fd, buf, REMOTE_FILE_CACHE_BUFFER_SIZE,
+				       offset, &remote_errno);
+      if (bytes == -1)
+	{
+	  warning (_("Cannot read the remote file for \"%s\": %s"), name,
+		   safe_strerror (remote_fileio_errno_to_host (remote_errno)));
+	  break;
+	}
+
+      /* Success, but no bytes, means end-of-file.  */
+      if (bytes == 0)
+	{
+	  if (close (copy.fd) == 0 && rename (copy.name, name) == 0)
+	    ret = gdb_open_cloexec (name, O_RDONLY | O_BINARY, 0);
+	  else
+	    warning (_("Cannot write \"%s\": %s"), name,
+		     safe_strerror (errno));
+	  copy.fd = -1;
+	  break;
+	}
+
+      if (write (copy.fd, buf, bytes) != bytes)
+	{
+	  warning (_("Cannot write \"%s\": %s"), copy.name,
+		   safe_strerror (errno));
+	  break;
+	}
+
+      offset += bytes;
+    }
+
+  do_cleanups (old_chain);
+  return ret;
+}
+
+/* BFD's file cache may close a file and open it again by name,
+   which the remote name of a copy does not allow, so copies are read
+   through these functions.  The stream is a pointer to the descriptor
+   of the copy, and so is the open closure.  */
+
+static void *
+remote_file_cache_iovec_open (struct bfd *abfd, void *open_closure)
+{
+  int *stream = xmalloc (sizeof (int));
+
+  *stream = *(int *) open_closure;
+  return stream;
+}
+
+static int
+remote_file_cache_iovec_close (struct bfd *abfd, void *stream)
+{
+  close (*(int *) stream);
+  xfree (stream);
+
+  /* Zero means success.  */
+  return 0;
+}
+
+static file_ptr
+remote_file_cache_iovec_pread (struct bfd *abfd, void *stream, void *buf,
+			       file_ptr nbytes, file_ptr offset)
+{
+  int fd = *(int *) stream;
+  file_ptr pos = 0;
+
+  while (nbytes > pos)
+    {
+      ssize_t bytes;
+
+#ifdef HAVE_PREAD
+      bytes = pread (fd, (gdb_byte *) buf + pos, nbytes - pos, offset + pos);
+#else
+      if (lseek (fd, offset + pos, SEEK_SET) == -1)
+	bytes = -1;
+      else
+	bytes = read (fd, (gdb_byte *) buf + pos, nbytes - pos);
+#endif
+      if (bytes == 0)
+	/* End-of-file.  */
+	break;
+      if (bytes == -1)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  bfd_set_error (bfd_error_system_call);
+	  return -1;
+	}
+
+      pos += bytes;
+    }
+
+  return pos;
+}
+
+static int
+remote_file_cache_iovec_stat (struct bfd *abfd, void *stream,
+			      struct stat *sb)
+{
+  return fstat (*(int *) stream, sb);
+}
+
+/* Return a BFD for the copy in the cache of the remote file ABFD,
+   copying it first if the cache does not have it, or NULL if it
+   cannot be cached.  TARGET is as for remote_bfd_open.  */
+
+static bfd *
+remote_file_cache_open (bfd *abfd, const char *target)
+{
+  const char *remote_file = bfd_get_filename (abfd);
+  struct cleanup *old_chain;
+  struct stat st, local_st;
+  int fd, local_fd, remote_errno, have_stat;
+  char *name;
+  bfd *copy;
+
+  fd = remote_hostio_open (remote_file + sizeof (REMOTE_SYSROOT_PREFIX) - 1,
+			   FILEIO_O_RDONLY, 0, &remote_errno);
+  if (fd == -1)
+    return NULL;
+  old_chain = make_cleanup (remote_hostio_close_cleanup, &fd);
+
+  have_stat = remote_hostio_fstat (fd, &st, &remote_errno) == 0;
+  name = remote_file_cache_name (abfd, have_stat ? &st : NULL);
+  if (name == NULL)
+    {
+      do_cleanups (old_chain);
+      return NULL;
+    }
+  make_cleanup (xfree, name);
+
+  local_fd = gdb_open_cloexec (name, O_RDONLY | O_BINARY, 0);
+
+  /* A copy of another size is not a copy of this file.  */
+  if (local_fd != -1 && have_stat
+      && (fstat (local_fd, &local_st) != 0
+	  || local_st.st_size != st.st_size))
+    {
+      close (local_fd);
+      local_fd = -1;
+    }
+
+  if (local_fd == -1)
+    local_fd = remote_file_cache_fetch (fd, name);
+
+  do_cleanups (old_chain);
+
+  if (local_fd == -1)
+    return NULL;
+
+  /* Keep the remote name, which is what users expect to see, and
+     which separate debug files are looked up from.  */
+  copy = gdb_bfd_openr_iovec (remote_file, target,
+			      remote_file_cache_iovec_open, &local_fd,
+			      remote_file_cache_iovec_pread,
+			      remote_file_cache_iovec_close,
+			      remote_file_cache_iovec_stat);
+
+  /* Only failing to find TARGET leaves the descriptor to us.  */
+  if (copy == NULL)
+    close (local_fd);
+
+  return copy;
+}
+
 bfd *
 remote_bfd_open (const char *remote_file, const char *target)
 {
@@ -10105,6 +11806,18 @@ remote_bfd_open (const char *remote_file, const char *target)
 				   remote_bfd_iovec_close,
 				   remote_bfd_iovec_stat);
 
+  if (abfd != NULL && remote_file_cache_enabled
+      && *remote_file_cache_directory != '\0')
+    {
+      bfd *copy = remote_file_cache_open (abfd, target);
+
+      if (copy != NULL)
+	{
+	  gdb_bfd_unref (abfd);
+	  abfd = copy;
+	}
+    }
+
   return abfd;
 }
 
@@ -11063,6 +12776,105 @@ remote_save_trace_data (const char *filename)
   return 0;
 }
 
+/* Send a qTBufferBin packet asking for LEN bytes of raw trace data at
+   OFFSET, without waiting for the reply.  */
+
+static void
+remote_send_raw_trace_data_request (ULONGEST offset, LONGEST len)
+{
+  struct remote_state *rs = get_remote_state ();
+  char *p;
+
+  p = rs->buf;
+  strcpy (p, "qTBufferBin:");
+  p += strlen (p);
+  p += hexnumstr (p, offset);
+  *p++ = ',';
+  p += hexnumstr (p, len);
+  *p++ = '\0';
+
+  putpkt (rs->buf);
+}
+
+/* Get the reply to a qTBufferBin packet for LEN bytes, and store the
+   data in BUF.  Returns the number of bytes stored, which may be less
+   than LEN, zero at the end of the trace buffer, or -1 on error.  */
+
+static LONGEST
+remote_raw_trace_data_reply (gdb_byte *buf, LONGEST len)
+{
+  struct remote_state *rs = get_remote_state ();
+  int packet_len;
+
+  packet_len = getpkt_sane (&rs->buf, &rs->buf_size, 0);
+  if (packet_len < 0)
+    return -1;
+
+  if (packet_len == 1 && rs->buf[0] == 'l')
+    return 0;
+
+  if (packet_len < 1 || rs->buf[0] != 'b')
+    return -1;
+
+  return remote_unescape_input ((gdb_byte *) rs->buf + 1, packet_len - 1,
+				buf, len);
+}
+
+/* Get up to LEN bytes of raw trace data at OFFSET with qTBufferBin
+   packets.  If the stub takes several requests at once, as for memory
+   reads, keep that many in flight, then collect the replies in
+   order.  Returns the number of bytes read before the first short
+   reply, or -1 if the first request failed.  */
+
+static LONGEST
+remote_get_raw_trace_data_binary (gdb_byte *buf, ULONGEST offset,
+				  LONGEST len)
+{
+  struct remote_state *rs = get_remote_state ();
+  LONGEST todo, xfered = 0;
+  int count, i, window = 1, done = 0;
+
+  /* A binary reply takes one character per byte, plus the leading
+     "b"; the stub sends fewer bytes if escapes make them not fit.  */
+  todo = min (len, get_remote_packet_size () - 1);
+
+  /* The requests are only pipelined in no-ack mode, where putpkt does
+     not read from the remote.  */
+  if (todo < len && rs->noack_mode && rs->memory_read_window > 1)
+    window = rs->memory_read_window;
+
+  count = min (window, (len + todo - 1) / todo);
+  for (i = 0; i < count; i++)
+    remote_send_raw_trace_data_request (offset + i * todo,
+					min (todo, len - i * todo));
+
+  /* Every request gets a reply, so keep reading after a failure to
+     stay in step with the stub.  */
+  for (i = 0; i < count; i++)
+    {
+      LONGEST size = min (todo, len - i * todo);
+      LONGEST got;
+
+      got = remote_raw_trace_data_reply (buf + i * todo, size);
+      if (done)
+	continue;
+
+      if (got < 0)
+	{
+	  if (i == 0)
+	    xfered = got;
+	  done = 1;
+	  continue;
+	}
+
+      xfered += got;
+      if (got < size)
+	done = 1;
+    }
+
+  return xfered;
+}
+
 /* This is basically a memory transfer, but needs to be its own packet
    because we don't know how the target actually organizes its trace
    memory, plus we want to be able to ask for as much as possible, but
@@ -11076,6 +12888,9 @@ remote_get_raw_trace_data (gdb_byte *buf, ULONGEST offset, LONGEST len)
   char *p;
   int rslt;
 
+  if (remote_protocol_packets[PACKET_qTBufferBin].support == PACKET_ENABLE)
+    return remote_get_raw_trace_data_binary (buf, offset, len);
+
   p = rs->buf;
   strcpy (p, "qTBuffer:");
   p += strlen (p);
@@ -11442,6 +13257,9 @@ remote_read_btrace (struct btrace_target_info *tinfo,
     case btrace_read_new:
       annex = "new";
       break;
+    case btrace_read_delta:
+      annex = "delta";
+      break;
     default:
       internal_error (__FILE__, __LINE__,
 		      _("Bad branch tracing read type: %u."),
@@ -11450,6 +13268,12 @@ remote_read_btrace (struct btrace_target_info *tinfo,
 
   xml = target_read_stralloc (&current_target,
                               TARGET_OBJECT_BTRACE, annex);
+
+  /* Older stubs don't know about delta reads.  */
+  if (xml == NULL && type == btrace_read_delta)
+    xml = target_read_stralloc (&current_target,
+				TARGET_OBJECT_BTRACE, "new");
+
   if (xml != NULL)
     {
       struct cleanup *cleanup = make_cleanup (xfree, xml);
@@ -11890,6 +13714,19 @@ response packet.  GDB supplies the initial `$' character, and the\n\
 terminating `#' character and checksum."),
 	   &maintenancelist);
 
+  add_cmd ("remote-compression", class_maintenance,
+	   maintenance_info_remote_compression, _("\
+Show statistics about the compressed packets received from the target."),
+	   &maintenanceinfolist);
+
+  add_cmd ("remote-stats", class_maintenance,
+	   maintenance_info_remote_stats, _("\
+Show statistics about the packets exchanged with the target.\n\
+For each type of packet, this shows how many were sent and their size,\n\
+how many replies were received and their size, and the average time\n\
+waited for a reply along with a histogram of those times."),
+	   &maintenanceinfolist);
+
   add_setshow_boolean_cmd ("remotebreak", no_class, &remote_break, _("\
 Set whether to send break if interrupted."), _("\
 Show whether to send break if interrupted."), _("\
@@ -11913,6 +13750,44 @@ Valid value is \"Ctrl-C\", \"BREAK\" or \"BREAK-g\". The default is \"Ctrl-C\"."
 			&remote_set_cmdlist,
 			&remote_show_cmdlist);
 
+  add_setshow_boolean_cmd ("file-cache", class_files,
+			   &remote_file_cache_enabled, _("\
+Set whether to cache the files read from the remote target."), _("\
+Show whether to cache the files read from the remote target."), _("\
+When enabled, the object files GDB reads from the target, such as\n\
+shared libraries when the sysroot is \"remote:\", are copied once to\n\
+the remote file cache directory, keyed by the file's build-id, and\n\
+read from the copy in this session and the following ones."),
+			   NULL,
+			   show_remote_file_cache_enabled,
+			   &remote_set_cmdlist, &remote_show_cmdlist);
+
+  {
+    const char *cache_home = getenv ("XDG_CACHE_HOME");
+    const char *home = getenv ("HOME");
+
+    if (cache_home != NULL && IS_ABSOLUTE_PATH (cache_home))
+      remote_file_cache_directory = concat (cache_home, SLASH_STRING, "gdb",
+					    SLASH_STRING, "remote-files",
+					    (char *) NULL);
+    else if (home != NULL)
+      remote_file_cache_directory = concat (home, SLASH_STRING, ".cache",
+					    SLASH_STRING, "gdb", SLASH_STRING,
+					    "remote-files", (char *) NULL);
+    else
+      remote_file_cache_directory = xstrdup ("");
+  }
+
+  add_setshow_optional_filename_cmd ("file-cache-directory", class_files,
+				     &remote_file_cache_directory, _("\
+Set the directory of the remote file cache."), _("\
+Show the directory of the remote file cache."), _("\
+Files copied by \"set remote file-cache on\" are stored in this\n\
+directory.  It is created if it does not exist."),
+				     NULL,
+				     show_remote_file_cache_directory,
+				     &remote_set_cmdlist, &remote_show_cmdlist);
+
   add_setshow_boolean_cmd ("interrupt-on-connect", class_support,
 			   &interrupt_on_connect, _("\
 Set whether interrupt-sequence is sent to remote target when gdb connects to."), _("		\
@@ -11993,6 +13868,35 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (&remote_protocol_packets[PACKET_X],
 			 "X", "binary-download", 1);
 
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_x],
+			 "x", "binary-upload", 0);
+
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_zlib_compression],
+			 "zlib-compression", "zlib-compression", 0);
+
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_QExpediteStack],
+			 "QExpediteStack", "expedite-stack", 0);
+
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_qRegs],
+			 "qRegs", "multi-thread-registers", 0);
+
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_qSymbols],
+			 "qSymbols", "symbol-lookup-batch", 0);
+
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_qCRC_ranges],
+			 "qCRC:ranges", "verify-memory-ranges", 0);
+
+  add_setshow_zuinteger_cmd ("expedited-stack-size", class_obscure,
+			     &remote_expedited_stack_size, _("\
+Set the stack memory to include in remote stop replies."), _("\
+Show the stack memory to include in remote stop replies."), _("\
+When the remote stub supports it, each stop reply carries this many\n\
+bytes of memory above the stack pointer of the stopping thread, which\n\
+GDB then need not read to unwind the first frames.  Zero disables this."),
+			     NULL,
+			     NULL, /* FIXME: i18n: */
+			     &remote_set_cmdlist, &remote_show_cmdlist);
+
   add_packet_config_cmd (&remote_protocol_packets[PACKET_vCont],
 			 "vCont", "verbose-resume", 0);
 
@@ -12107,6 +14011,9 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (&remote_protocol_packets[PACKET_vFile_readlink],
 			 "vFile:readlink", "hostio-readlink", 0);
 
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_vFile_fstat],
+			 "vFile:fstat", "hostio-fstat", 0);
+
   add_packet_config_cmd (&remote_protocol_packets[PACKET_vAttach],
 			 "vAttach", "attach", 0);
 
@@ -12164,6 +14071,9 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (&remote_protocol_packets[PACKET_QTBuffer_size],
 			 "QTBuffer:size", "trace-buffer-size", 0);
 
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_qTBufferBin],
+			 "qTBufferBin", "trace-buffer-binary-upload", 0);
+
   add_packet_config_cmd (&remote_protocol_packets[PACKET_Qbtrace_off],
        "Qbtrace:off", "disable-btrace", 0);
 
@@ -12173,6 +14083,10 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (&remote_protocol_packets[PACKET_qXfer_btrace],
        "qXfer:btrace", "read-btrace", 0);
 
+  add_packet_config_cmd
+    (&remote_protocol_packets[PACKET_qXfer_features_hash],
+     "qXfer:features-hash:read", "target-features-hash", 0);
+
   /* Keep the old ``set remote Z-packet ...'' working.  Each individual
      Z sub-packet has its own set and show commands, but users may
      have sets to this variable in their .gdbinit files (or in their
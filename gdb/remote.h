@@ -71,4 +71,15 @@ extern int remote_register_number_and_offset (struct gdbarch *gdbarch,
 					      int *poffset);
 
 extern void remote_notif_get_pending_events (struct notif_client *np);
+
+/* Store in *PACKETS the number of packets sent to the target since
+   the connection was opened, in *BYTES_SENT and *BYTES_RECEIVED the
+   size of those packets and of their replies, and in *USECS the time
+   spent waiting for the replies, in microseconds.  */
+
+extern void remote_get_packet_totals (ULONGEST *packets,
+				      ULONGEST *bytes_sent,
+				      ULONGEST *bytes_received,
+				      ULONGEST *usecs);
+
 #endif
@@ -176,6 +176,11 @@ fd_event (int error, void *context)
 	  scb->bufcnt = nr;
 	  scb->bufp = scb->buf;
 	}
+      else if (errno == EAGAIN)
+	{
+	  /* The wakeup was spurious; keep waiting for data.  */
+	  return;
+	}
       else
 	{
 	  scb->bufcnt = SERIAL_ERROR;
@@ -0,0 +1,206 @@
+/* Serial interface for a shared memory connection to gdbserver.
+
+   Copyright (C) 2013 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "defs.h"
+#include "serial.h"
+#include "ser-base.h"
+#include "shm-ring.h"
+#include "gdb_string.h"
+
+#include <errno.h>
+#include <signal.h>
+
+extern void _initialize_ser_shm (void);
+
+/* Open a connection "shm:PATH" to a gdbserver.  */
+
+static int
+shm_serial_open (struct serial *scb, const char *name)
+{
+  struct shm_channel *ch;
+
+  if (strncmp (name, SHM_CONNECTION_PREFIX,
+	       strlen (SHM_CONNECTION_PREFIX)) == 0)
+    name += strlen (SHM_CONNECTION_PREFIX);
+
+  ch = XZALLOC (struct shm_channel);
+  if (shm_channel_connect (name, ch) < 0)
+    {
+      xfree (ch);
+      return -1;
+    }
+
+  scb->state = ch;
+
+  /* The event loop waits for our doorbell.  */
+  scb->fd = ch->in_fd;
+
+#ifdef SIGPIPE
+  /* If we don't do this, then GDB simply exits
+     when gdbserver dies and we ring its doorbell.  */
+  signal (SIGPIPE, SIG_IGN);
+#endif
+
+  return 0;
+}
+
+static void
+shm_serial_close (struct serial *scb)
+{
+  struct shm_channel *ch = scb->state;
+
+  if (ch != NULL)
+    {
+      shm_channel_close (ch);
+      xfree (ch);
+      scb->state = NULL;
+    }
+  scb->fd = -1;
+}
+
+/* Wait for data for at most TIMEOUT seconds and copy it to the
+   input FIFO of SCB.  This works like do_ser_base_readchar, except
+   that the ring is watched directly, without any system call if the
+   data comes right away.  */
+
+static int
+do_shm_serial_readchar (struct serial *scb, int timeout)
+{
+  struct shm_channel *ch = scb->state;
+  int status;
+  int delta;
+
+  /* Break the timeout into steps of 1 second, to keep the GUI alive,
+     as do_ser_base_readchar does.  */
+  delta = (timeout == 0 ? 0 : 1);
+  while (1)
+    {
+      if (deprecated_ui_loop_hook)
+	{
+	  if (deprecated_ui_loop_hook (0))
+	    return SERIAL_TIMEOUT;
+	}
+
+      status = shm_channel_wait (ch, delta);
+      if (status != 0)
+	break;
+
+      if (timeout > 0)
+	timeout -= delta;
+      if (timeout == 0)
+	return SERIAL_TIMEOUT;
+    }
+
+  if (status < 0)
+    return errno == EPIPE ? SERIAL_EOF : SERIAL_ERROR;
+
+  scb->bufcnt = shm_channel_read (ch, scb->buf, BUFSIZ);
+  scb->bufcnt--;
+  scb->bufp = scb->buf;
+  return *scb->bufp++;
+}
+
+static int
+shm_serial_readchar (struct serial *scb, int timeout)
+{
+  return generic_readchar (scb, timeout, do_shm_serial_readchar);
+}
+
+/* Fill the input FIFO of SCB, after the event loop saw its doorbell
+   ring.  */
+
+static int
+shm_serial_read_prim (struct serial *scb, size_t count)
+{
+  struct shm_channel *ch = scb->state;
+  int drained, nr;
+
+  drained = shm_channel_drain (ch);
+  nr = shm_channel_read (ch, scb->buf, count);
+  if (nr > 0)
+    return nr;
+  if (drained < 0)
+    return errno == EPIPE ? 0 : -1;
+
+  /* The doorbell was for bytes already read.  */
+  errno = EAGAIN;
+  return -1;
+}
+
+static int
+shm_serial_write_prim (struct serial *scb, const void *buf, size_t count)
+{
+  return shm_channel_write (scb->state, buf, count);
+}
+
+/* While the event loop waits on our doorbell, have gdbserver ring it
+   for every write.  */
+
+static void
+shm_serial_async (struct serial *scb, int async_p)
+{
+  struct shm_channel *ch = scb->state;
+
+  shm_channel_stay_armed (ch, async_p);
+
+  /* No doorbell rings for bytes that came in before, so move them to
+     the input FIFO, which the event loop does check.  */
+  if (async_p && scb->bufcnt == 0)
+    {
+      int nr = shm_channel_read (ch, scb->buf, BUFSIZ);
+
+      if (nr > 0)
+	{
+	  scb->bufcnt = nr;
+	  scb->bufp = scb->buf;
+	}
+    }
+
+  ser_base_async (scb, async_p);
+}
+
+void
+_initialize_ser_shm (void)
+{
+  struct serial_ops *ops = XMALLOC (struct serial_ops);
+
+  memset (ops, 0, sizeof (struct serial_ops));
+  ops->name = "shm";
+  ops->next = 0;
+  ops->open = shm_serial_open;
+  ops->close = shm_serial_close;
+  ops->readchar = shm_serial_readchar;
+  ops->write = ser_base_write;
+  ops->flush_output = ser_base_flush_output;
+  ops->flush_input = ser_base_flush_input;
+  ops->send_break = ser_base_send_break;
+  ops->go_raw = ser_base_raw;
+  ops->get_tty_state = ser_base_get_tty_state;
+  ops->copy_tty_state = ser_base_copy_tty_state;
+  ops->set_tty_state = ser_base_set_tty_state;
+  ops->print_tty_state = ser_base_print_tty_state;
+  ops->noflush_set_tty_state = ser_base_noflush_set_tty_state;
+  ops->setbaudrate = ser_base_setbaudrate;
+  ops->setstopbits = ser_base_setstopbits;
+  ops->drain_output = ser_base_drain_output;
+  ops->async = shm_serial_async;
+  ops->read_prim = shm_serial_read_prim;
+  ops->write_prim = shm_serial_write_prim;
+  serial_add_interface (ops);
+}
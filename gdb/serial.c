@@ -197,6 +197,8 @@ serial_open (const char *name)
       ++open_name;
       open_name = skip_spaces_const (open_name);
     }
+  else if (strncmp (name, "shm:", 4) == 0)
+    ops = serial_interface_lookup ("shm");
   /* Check for a colon, suggesting an IP address/port pair.
      Do this *after* checking for all the interesting prefixes.  We
      don't want to constrain the syntax of what can follow them.  */
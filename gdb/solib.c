@@ -47,6 +47,7 @@
 #include "interps.h"
 #include "filesystem.h"
 #include "gdb_bfd.h"
+#include "maint.h"
 #include "filestuff.h"
 
 /* Architecture-specific operations.  */
@@ -98,6 +99,12 @@ struct target_so_ops *current_target_so_ops;
    symbol files.  This takes precedence over the environment variables PATH
    and LD_LIBRARY_PATH.  */
 static char *solib_search_path = NULL;
+
+/* If nonzero, read only the dynamic symbols of automatically loaded
+   shared libraries, and the rest of their symbols when first
+   needed.  */
+static int solib_defer_symbols = 0;
+
 static void
 show_solib_search_path (struct ui_file *file, int from_tty,
 			struct cmd_list_element *c, const char *value)
@@ -611,6 +618,11 @@ solib_read_symbols (struct so_list *so, int flags)
 
       flags |= current_inferior ()->symfile_flags;
 
+      /* libthread_db looks up symbols that libpthread does not
+	 export.  */
+      if (libpthread_name_p (so->so_name))
+	flags &= ~SYMFILE_DEFER_READ;
+
       TRY_CATCH (e, RETURN_MASK_ERROR)
 	{
 	  struct section_addr_info *sap;
@@ -664,6 +676,35 @@ solib_used (const struct so_list *const known)
   return 0;
 }
 
+/* Search the shared object list linked from START for one that OPS
+   considers to be the same as GDB, stopping at the end of the list
+   or at the link STOP.  Return the link pointing to the matching
+   shared object, or NULL if there is none.  */
+
+static struct so_list **
+find_same_so (const struct target_so_ops *ops, struct so_list *gdb,
+	      struct so_list **start, struct so_list **stop)
+{
+  struct so_list **link;
+
+  for (link = start; *link != NULL && link != stop; link = &(*link)->next)
+    {
+      if (ops->same)
+	{
+	  if (ops->same (gdb, *link))
+	    return link;
+	}
+      else
+	{
+	  if (! filename_cmp (gdb->so_original_name,
+			      (*link)->so_original_name))
+	    return link;
+	}
+    }
+
+  return NULL;
+}
+
 /* Synchronize GDB's shared object list with inferior's.
 
    Extract the list of currently loaded shared objects from the
@@ -692,7 +733,7 @@ update_solib_list (int from_tty, struct target_ops *target)
 {
   const struct target_so_ops *ops = solib_ops (target_gdbarch ());
   struct so_list *inferior = ops->current_sos();
-  struct so_list *gdb, **gdb_link;
+  struct so_list *gdb, **gdb_link, **i_start;
 
   /* We can reach here due to changing solib-search-path or the
      sysroot, before having any inferior.  */
@@ -735,29 +776,22 @@ update_solib_list (int from_tty, struct target_ops *target)
 
   gdb = so_list_head;
   gdb_link = &so_list_head;
+  i_start = &inferior;
   while (gdb)
     {
-      struct so_list *i = inferior;
-      struct so_list **i_link = &inferior;
+      struct so_list *i = NULL;
+      struct so_list **i_link;
 
       /* Check to see whether the shared object *gdb also appears in
-	 the inferior's current list.  */
-      while (i)
-	{
-	  if (ops->same)
-	    {
-	      if (ops->same (gdb, i))
-		break;
-	    }
-	  else
-	    {
-	      if (! filename_cmp (gdb->so_original_name, i->so_original_name))
-		break;	      
-	    }
-
-	  i_link = &i->next;
-	  i = *i_link;
-	}
+	 the inferior's current list.  Both lists are normally in load
+	 order, so look first after the previous match, and only then
+	 before it; this keeps the usual case linear rather than
+	 quadratic in the number of shared objects.  */
+      i_link = find_same_so (ops, gdb, i_start, NULL);
+      if (i_link == NULL && i_start != &inferior)
+	i_link = find_same_so (ops, gdb, &inferior, i_start);
+      if (i_link != NULL)
+	i = *i_link;
 
       /* If the shared object appears on the inferior's list too, then
          it's still loaded, so we don't need to do anything.  Delete
@@ -766,6 +800,7 @@ update_solib_list (int from_tty, struct target_ops *target)
 	{
 	  *i_link = i->next;
 	  free_so (i);
+	  i_start = i_link;
 	  gdb_link = &gdb->next;
 	  gdb = *gdb_link;
 	}
@@ -894,6 +929,7 @@ solib_add (char *pattern, int from_tty,
 	   struct target_ops *target, int readsyms)
 {
   struct so_list *gdb;
+  struct cleanup *phase;
 
   current_program_space->solib_add_generation++;
 
@@ -905,7 +941,9 @@ solib_add (char *pattern, int from_tty,
 	error (_("Invalid regexp: %s"), re_err);
     }
 
+  phase = make_profile_phase_cleanup ("update solib list", NULL);
   update_solib_list (from_tty, target);
+  do_cleanups (phase);
 
   /* Walk the list of currently loaded shared libraries, and read
      symbols for any that match the pattern --- or any whose symbols
@@ -914,7 +952,8 @@ solib_add (char *pattern, int from_tty,
     int any_matches = 0;
     int loaded_any_symbols = 0;
     const int flags =
-        SYMFILE_DEFER_BP_RESET | (from_tty ? SYMFILE_VERBOSE : 0);
+        SYMFILE_DEFER_BP_RESET | (from_tty ? SYMFILE_VERBOSE : 0)
+	| (solib_defer_symbols && pattern == NULL ? SYMFILE_DEFER_READ : 0);
 
     for (gdb = so_list_head; gdb; gdb = gdb->next)
       if (! pattern || re_exec (gdb->so_name))
@@ -932,9 +971,17 @@ solib_add (char *pattern, int from_tty,
 	    {
 	      if (gdb->symbols_loaded)
 		{
+		  /* A library named explicitly gets all of its
+		     symbols.  */
+		  if (pattern && gdb->objfile != NULL
+		      && (gdb->objfile->flags & OBJF_DEFERRED) != 0)
+		    {
+		      read_deferred_symbols (gdb->objfile);
+		      loaded_any_symbols = 1;
+		    }
 		  /* If no pattern was given, be quiet for shared
 		     libraries we have already loaded.  */
-		  if (pattern && (from_tty || info_verbose))
+		  else if (pattern && (from_tty || info_verbose))
 		    printf_unfiltered (_("Symbols already loaded for %s\n"),
 				       gdb->so_name);
 		}
@@ -1040,9 +1087,12 @@ info_sharedlibrary_command (char *pattern, int from_tty)
 	  ui_out_field_skip (uiout, "to");
 	}
 
-      if (! ui_out_is_mi_like_p (interp_ui_out (top_level_interpreter ()))
-	  && so->symbols_loaded
-	  && !objfile_has_symbols (so->objfile))
+      if (so->symbols_loaded && so->objfile != NULL
+	  && (so->objfile->flags & OBJF_DEFERRED) != 0)
+	ui_out_field_string (uiout, "syms-read", "Deferred");
+      else if (! ui_out_is_mi_like_p (interp_ui_out (top_level_interpreter ()))
+	       && so->symbols_loaded
+	       && !objfile_has_symbols (so->objfile))
 	{
 	  so_missing_debug_info = 1;
 	  ui_out_field_string (uiout, "syms-read", "Yes (*)");
@@ -1244,6 +1294,9 @@ void
 handle_solib_event (void)
 {
   const struct target_so_ops *ops = solib_ops (target_gdbarch ());
+  struct cleanup *phase;
+
+  phase = make_profile_phase_cleanup ("solib event", NULL);
 
   if (ops->handle_event != NULL)
     ops->handle_event ();
@@ -1256,6 +1309,8 @@ handle_solib_event (void)
   target_terminal_ours_for_output ();
   solib_add (NULL, 0, &current_target, auto_solib_add);
   target_terminal_inferior ();
+
+  do_cleanups (phase);
 }
 
 /* Reload shared libraries, but avoid reloading the same symbol file
@@ -1273,7 +1328,8 @@ reload_shared_libraries_1 (int from_tty)
       bfd *abfd;
       int was_loaded = so->symbols_loaded;
       const int flags =
-	SYMFILE_DEFER_BP_RESET | (from_tty ? SYMFILE_VERBOSE : 0);
+	SYMFILE_DEFER_BP_RESET | (from_tty ? SYMFILE_VERBOSE : 0)
+	| (solib_defer_symbols ? SYMFILE_DEFER_READ : 0);
 
       filename = tilde_expand (so->so_original_name);
       make_cleanup (xfree, filename);
@@ -1375,6 +1431,15 @@ reload_shared_libraries (char *ignored, int from_tty,
   ops->special_symbol_handling ();
 }
 
+static void
+show_solib_defer_symbols (struct ui_file *file, int from_tty,
+			  struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("Deferred reading of shared library "
+			    "symbols is %s.\n"),
+		    value);
+}
+
 static void
 show_auto_solib_add (struct ui_file *file, int from_tty,
 		     struct cmd_list_element *c, const char *value)
@@ -1542,6 +1607,19 @@ inferior.  Otherwise, symbols must be loaded manually, using \
 			   show_auto_solib_add,
 			   &setlist, &showlist);
 
+  add_setshow_boolean_cmd ("solib-defer-symbols", class_support,
+			   &solib_defer_symbols, _("\
+Set deferred reading of shared library symbols."), _("\
+Show deferred reading of shared library symbols."), _("\
+If \"on\", only the dynamic symbols of automatically loaded shared\n\
+libraries are read when they are loaded.  The rest of a library's\n\
+symbols are read the first time they are needed: when a PC in the\n\
+library is looked up, when a breakpoint location resolves to it, or\n\
+when a symbol lookup finds nothing elsewhere."),
+			   NULL,
+			   show_solib_defer_symbols,
+			   &setlist, &showlist);
+
   add_setshow_filename_cmd ("sysroot", class_support,
 			    &gdb_sysroot, _("\
 Set an alternate system root."), _("\
@@ -33,6 +33,12 @@
 #include "gdb_string.h"
 #include "gdb_stat.h"
 #include <fcntl.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void *) -1)
+#endif
+#endif
 #include "gdbcore.h"
 #include "gdb_regex.h"
 #include "symfile.h"
@@ -44,6 +50,7 @@
 #include "completer.h"
 #include "ui-out.h"
 #include "readline/readline.h"
+#include "hashtab.h"
 
 #define OPEN_MODE (O_RDONLY | O_BINARY)
 #define FDOPEN_MODE FOPEN_RB
@@ -142,6 +149,23 @@ static int first_line_listed;
 
 static struct symtab *last_source_visited = NULL;
 static int last_source_error = 0;
+
+/* The line positions of the source files scanned so far, keyed by
+   their full name.  All the symtabs of a file, e.g. of a header that
+   many compilation units include, then share one scan of it.  An entry
+   is only used while the file has the size and modification time it
+   had when it was scanned.  */
+
+struct source_lines
+{
+  char *fullname;
+  time_t mtime;
+  off_t size;
+  int nlines;
+  int *line_charpos;
+};
+
+static htab_t source_lines_table;
 
 /* Return the first line listed by print_source_lines.
    Used by command interpreters to request listing from
@@ -395,6 +419,9 @@ forget_cached_source_info (void)
       forget_cached_source_info_for_objfile (objfile);
     }
 
+  if (source_lines_table != NULL)
+    htab_empty (source_lines_table);
+
   last_source_visited = NULL;
 }
 
@@ -1167,6 +1194,81 @@ symtab_to_filename_for_display (struct symtab *symtab)
     internal_error (__FILE__, __LINE__, _("invalid filename_display_string"));
 }
 
+/* The most source files to remember the line positions of.  */
+
+#define MAX_SOURCE_LINES 256
+
+static hashval_t
+hash_source_lines (const void *p)
+{
+  const struct source_lines *lines = p;
+
+  return filename_hash (lines->fullname);
+}
+
+static int
+eq_source_lines (const void *a, const void *b)
+{
+  const struct source_lines *lhs = a;
+  const struct source_lines *rhs = b;
+
+  return filename_cmp (lhs->fullname, rhs->fullname) == 0;
+}
+
+static void
+free_source_lines (void *p)
+{
+  struct source_lines *lines = p;
+
+  xfree (lines->fullname);
+  xfree (lines->line_charpos);
+  xfree (lines);
+}
+
+/* Set S->line_charpos and S->nlines to a copy of LINE_CHARPOS, the
+   positions of the NLINES lines.  */
+
+static void
+set_source_lines (struct symtab *s, const int *line_charpos, int nlines)
+{
+  s->nlines = nlines;
+  s->line_charpos = (int *) xmalloc (nlines * sizeof (int));
+  memcpy (s->line_charpos, line_charpos, nlines * sizeof (int));
+}
+
+/* Return the positions of the lines in the SIZE bytes at DATA, and
+   set *NLINES to the number of lines.  */
+
+static int *
+scan_source_lines (const char *data, size_t size, int *nlines)
+{
+  const char *p = data, *end = data + size;
+  int lines_allocated = 1000;
+  int *line_charpos;
+
+  line_charpos = (int *) xmalloc (lines_allocated * sizeof (int));
+  line_charpos[0] = 0;
+  *nlines = 1;
+
+  /* memchr is much faster at finding the newlines than a loop over
+     the characters.  */
+  while ((p = memchr (p, '\n', end - p)) != NULL
+	 /* A newline at the end does not start a new line.  */
+	 && ++p != end)
+    {
+      if (*nlines == lines_allocated)
+	{
+	  lines_allocated *= 2;
+	  line_charpos =
+	    (int *) xrealloc ((char *) line_charpos,
+			      sizeof (int) * lines_allocated);
+	}
+      line_charpos[(*nlines)++] = p - data;
+    }
+
+  return (int *) xrealloc ((char *) line_charpos, *nlines * sizeof (int));
+}
+
 /* Create and initialize the table S->line_charpos that records
    the positions of the lines in the source file, which is assumed
    to be open on descriptor DESC.
@@ -1176,15 +1278,16 @@ void
 find_source_lines (struct symtab *s, int desc)
 {
   struct stat st;
-  char *data, *p, *end;
+  char *data = NULL;
   int nlines = 0;
-  int lines_allocated = 1000;
   int *line_charpos;
   long mtime = 0;
   int size;
+  int mapped = 0;
+  struct source_lines *lines = NULL;
+  struct cleanup *old_cleanups;
 
   gdb_assert (s);
-  line_charpos = (int *) xmalloc (lines_allocated * sizeof (int));
   if (fstat (desc, &st) < 0)
     perror_with_name (symtab_to_filename_for_display (s));
 
@@ -1196,52 +1299,96 @@ find_source_lines (struct symtab *s, int desc)
   if (mtime && mtime < st.st_mtime)
     warning (_("Source file is more recent than executable."));
 
-  {
-    struct cleanup *old_cleanups;
+  if (s->fullname != NULL && source_lines_table != NULL)
+    {
+      struct source_lines key;
 
-    /* st_size might be a large type, but we only support source files whose 
-       size fits in an int.  */
-    size = (int) st.st_size;
+      key.fullname = s->fullname;
+      lines = htab_find (source_lines_table, &key);
+      if (lines != NULL
+	  && lines->mtime == st.st_mtime && lines->size == st.st_size)
+	{
+	  set_source_lines (s, lines->line_charpos, lines->nlines);
+	  return;
+	}
+    }
 
-    /* Use malloc, not alloca, because this may be pretty large, and we may
-       run into various kinds of limits on stack size.  */
-    data = (char *) xmalloc (size);
-    old_cleanups = make_cleanup (xfree, data);
+  /* st_size might be a large type, but we only support source files whose 
+     size fits in an int.  */
+  size = (int) st.st_size;
 
-    /* Reassign `size' to result of read for systems where \r\n -> \n.  */
-    size = myread (desc, data, size);
-    if (size < 0)
-      perror_with_name (symtab_to_filename_for_display (s));
-    end = data + size;
-    p = data;
-    line_charpos[0] = 0;
-    nlines = 1;
-    while (p != end)
-      {
-	if (*p++ == '\n'
-	/* A newline at the end does not start a new line.  */
-	    && p != end)
-	  {
-	    if (nlines == lines_allocated)
-	      {
-		lines_allocated *= 2;
-		line_charpos =
-		  (int *) xrealloc ((char *) line_charpos,
-				    sizeof (int) * lines_allocated);
-	      }
-	    line_charpos[nlines++] = p - data;
-	  }
-      }
-    do_cleanups (old_cleanups);
-  }
+#ifdef HAVE_MMAP
+  /* Map the file rather than read it when we can, since only its
+     newlines are looked at.  */
+  if (size > 0)
+    {
+      data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, desc, 0);
+      if (data == MAP_FAILED)
+	data = NULL;
+      else
+	mapped = 1;
+    }
+#endif
+
+  if (data == NULL)
+    {
+      /* Use malloc, not alloca, because this may be pretty large, and we
+	 may run into various kinds of limits on stack size.  */
+      data = (char *) xmalloc (size);
+      old_cleanups = make_cleanup (xfree, data);
+
+      /* Reassign `size' to result of read for systems where \r\n ->
+	 \n.  */
+      size = myread (desc, data, size);
+      if (size < 0)
+	perror_with_name (symtab_to_filename_for_display (s));
+    }
+  else
+    old_cleanups = make_cleanup (null_cleanup, NULL);
+
+  line_charpos = scan_source_lines (data, size, &nlines);
+
+#ifdef HAVE_MMAP
+  if (mapped)
+    munmap (data, size);
+#endif
+  do_cleanups (old_cleanups);
 
   s->nlines = nlines;
-  s->line_charpos =
-    (int *) xrealloc ((char *) line_charpos, nlines * sizeof (int));
+  s->line_charpos = line_charpos;
+
+  if (s->fullname == NULL)
+    return;
+
+  if (source_lines_table == NULL)
+    source_lines_table = htab_create_alloc (17, hash_source_lines,
+					    eq_source_lines,
+					    free_source_lines,
+					    xcalloc, xfree);
+  else if (lines == NULL
+	   && htab_elements (source_lines_table) >= MAX_SOURCE_LINES)
+    htab_empty (source_lines_table);
+
+  if (lines == NULL)
+    {
+      void **slot;
+
+      lines = XCNEW (struct source_lines);
+      lines->fullname = xstrdup (s->fullname);
+      slot = htab_find_slot (source_lines_table, lines, INSERT);
+      *slot = lines;
+    }
+  else
+    xfree (lines->line_charpos);
 
+  lines->mtime = st.st_mtime;
+  lines->size = st.st_size;
+  lines->nlines = nlines;
+  lines->line_charpos = (int *) xmalloc (nlines * sizeof (int));
+  memcpy (lines->line_charpos, line_charpos, nlines * sizeof (int));
 }
 
-
+
 
 /* Get full pathname and line number positions for a symtab.
    Return nonzero if line numbers may have changed.
@@ -1418,6 +1565,10 @@ print_source_lines_base (struct symtab *s, int line, int stopline,
   while (nlines-- > 0)
     {
       char buf[20];
+      /* The plain characters of the line not printed yet.  They are
+	 printed together, rather than one by one.  */
+      char text[256];
+      int len = 0;
 
       c = fgetc (stream);
       if (c == EOF)
@@ -1432,11 +1583,18 @@ print_source_lines_base (struct symtab *s, int line, int stopline,
       ui_out_text (uiout, buf);
       do
 	{
-	  if (c < 040 && c != '\t' && c != '\n' && c != '\r')
+	  int plain = ((c >= 040 || c == '\t' || c == '\n')
+		       && c != 0177);
+
+	  if (len > 0 && (!plain || len == sizeof (text) - 1))
 	    {
-	      xsnprintf (buf, sizeof (buf), "^%c", c + 0100);
-	      ui_out_text (uiout, buf);
+	      text[len] = '\0';
+	      ui_out_text (uiout, text);
+	      len = 0;
 	    }
+
+	  if (plain)
+	    text[len++] = c;
 	  else if (c == 0177)
 	    ui_out_text (uiout, "^?");
 	  else if (c == '\r')
@@ -1451,11 +1609,17 @@ print_source_lines_base (struct symtab *s, int line, int stopline,
 	    }
 	  else
 	    {
-	      xsnprintf (buf, sizeof (buf), "%c", c);
+	      xsnprintf (buf, sizeof (buf), "^%c", c + 0100);
 	      ui_out_text (uiout, buf);
 	    }
 	}
       while (c != '\n' && (c = fgetc (stream)) >= 0);
+
+      if (len > 0)
+	{
+	  text[len] = '\0';
+	  ui_out_text (uiout, text);
+	}
     }
 
   do_cleanups (cleanup);
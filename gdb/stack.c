@@ -1732,7 +1732,9 @@ backtrace_command_1 (char *count_exp, int show_locals, int no_filters,
       else
 	{
 	  py_start = 0;
-	  py_end = count;
+	  /* The frame filters take the level of the last frame to
+	     print, not the number of frames.  */
+	  py_end = count - 1;
 	}
     }
   else
@@ -1759,7 +1761,9 @@ backtrace_command_1 (char *count_exp, int show_locals, int no_filters,
 	}
     }
 
-  if (! no_filters)
+  /* A PY_END of -1 would mean the whole stack, so "backtrace 0"
+     leaves the frame filters out.  */
+  if (! no_filters && count != 0)
     {
       int flags = PRINT_LEVEL | PRINT_FRAME_INFO | PRINT_ARGS;
       enum py_frame_args arg_type;
@@ -1780,7 +1784,7 @@ backtrace_command_1 (char *count_exp, int show_locals, int no_filters,
     }
   /* Run the inbuilt backtrace if there are no filters registered, or
      "no-filters" has been specified from the command.  */
-  if (no_filters ||  result == PY_BT_NO_FILTERS)
+  if (no_filters || count == 0 || result == PY_BT_NO_FILTERS)
     {
       for (i = 0, fi = trailing; fi && count--; i++, fi = get_prev_frame (fi))
 	{
@@ -56,6 +56,7 @@
 #include "remote.h"
 #include "stack.h"
 #include "gdb_bfd.h"
+#include "maint.h"
 #include "cli/cli-utils.h"
 #include "target.h"
 
@@ -63,6 +64,7 @@
 #include <fcntl.h>
 #include "gdb_string.h"
 #include "gdb_stat.h"
+#include "gdb_dirent.h"
 #include <ctype.h>
 #include <time.h>
 #include <sys/time.h>
@@ -836,8 +838,19 @@ default_symfile_segments (bfd *abfd)
 static void
 read_symbols (struct objfile *objfile, int add_flags)
 {
+  struct cleanup *phase;
+
+  phase = make_profile_phase_cleanup ("read symbols", objfile_name (objfile));
   (*objfile->sf->sym_read) (objfile, add_flags);
 
+  /* The reader left the rest of the symbols for
+     read_deferred_symbols.  */
+  if ((objfile->flags & OBJF_DEFERRED) != 0)
+    {
+      do_cleanups (phase);
+      return;
+    }
+
   /* find_separate_debug_file_in_section should be called only if there is
      single binary with no existing separate debug info file.  */
   if (!objfile_has_partial_symbols (objfile)
@@ -861,6 +874,85 @@ read_symbols (struct objfile *objfile, int add_flags)
     }
   if ((add_flags & SYMFILE_NO_READ) == 0)
     require_partial_symbols (objfile, 0);
+
+  do_cleanups (phase);
+}
+
+/* See symfile.h.  */
+
+void
+read_deferred_symbols (struct objfile *objfile)
+{
+  volatile struct gdb_exception e;
+
+  if ((objfile->flags & OBJF_DEFERRED) == 0)
+    return;
+
+  /* Anything that asked for the partial symbols meanwhile found
+     none; let them be read for real.  */
+  objfile->flags &= ~(OBJF_DEFERRED | OBJF_PSYMTABS_READ);
+
+  if (info_verbose)
+    {
+      printf_unfiltered (_("Reading deferred symbols from %s..."),
+			 objfile_name (objfile));
+      gdb_flush (gdb_stdout);
+    }
+
+  /* This is called from symbol lookups, which should not fail just
+     because this objfile's symbols could not be read.  */
+  TRY_CATCH (e, RETURN_MASK_ERROR)
+    {
+      read_symbols (objfile, 0);
+    }
+  if (e.reason < 0)
+    exception_fprintf (gdb_stderr, e,
+		       _("Error while reading deferred symbols for %s:\n"),
+		       objfile_name (objfile));
+  else if (info_verbose)
+    printf_unfiltered (_("done.\n"));
+
+  /* Lookups that failed before may succeed now.  */
+  forget_symbol_lookup_failures (objfile->pspace);
+
+  bfd_cache_close_all ();
+}
+
+/* See symfile.h.  */
+
+int
+read_all_deferred_symbols (void)
+{
+  struct objfile *objfile;
+  int count = 0;
+
+  ALL_OBJFILES (objfile)
+    if ((objfile->flags & OBJF_DEFERRED) != 0)
+      {
+	read_deferred_symbols (objfile);
+	count++;
+      }
+
+  return count;
+}
+
+/* See symfile.h.  */
+
+int
+read_deferred_symbols_for_name (const char *name)
+{
+  struct objfile *objfile;
+  int count = 0;
+
+  ALL_OBJFILES (objfile)
+    if ((objfile->flags & OBJF_DEFERRED) != 0
+	&& lookup_minimal_symbol (name, NULL, objfile) != NULL)
+      {
+	read_deferred_symbols (objfile);
+	count++;
+      }
+
+  return count;
 }
 
 /* Initialize entry point information for this objfile.  */
@@ -1092,7 +1184,7 @@ symbol_file_add_with_addrs (bfd *abfd, const char *name, int add_flags,
   if (readnow_symbol_files)
     {
       flags |= OBJF_READNOW;
-      add_flags &= ~SYMFILE_NO_READ;
+      add_flags &= ~(SYMFILE_NO_READ | SYMFILE_DEFER_READ);
     }
 
   /* Give user a chance to burp if we'd be
@@ -1144,7 +1236,8 @@ symbol_file_add_with_addrs (bfd *abfd, const char *name, int add_flags,
 	objfile->sf->qf->expand_all_symtabs (objfile);
     }
 
-  if (should_print && !objfile_has_symbols (objfile))
+  if (should_print && !objfile_has_symbols (objfile)
+      && (objfile->flags & OBJF_DEFERRED) == 0)
     {
       wrap_here ("");
       printf_unfiltered (_("(no debugging symbols found)..."));
@@ -1285,6 +1378,154 @@ symbol_file_clear (int from_tty)
     printf_unfiltered (_("No symbol file now.\n"));
 }
 
+/* A cached listing of one of the directories probed while searching
+   for separate debug files.  */
+
+struct debug_dir_listing
+{
+  /* The directory name, as it appeared in the probed file names
+     (including any trailing directory separator).  */
+  char *dirname;
+
+  /* The names of the entries of DIRNAME, or NULL if DIRNAME does not
+     exist.  */
+  htab_t entries;
+
+  /* Nonzero if DIRNAME exists but could not be read, in which case
+     nothing is known about its entries.  */
+  int unreadable;
+};
+
+/* Listings of the directories probed for separate debug files, keyed
+   by directory name.  Looking for a separate debug file probes several
+   candidate paths for every objfile, nearly all of which do not exist;
+   with a listing of each directory read once, those probes are answered
+   without going to the file system.  The cache lives until the
+   debug-file-directory setting or the executable changes.  */
+
+static htab_t debug_dir_listings;
+
+static hashval_t
+hash_debug_dir_listing (const void *p)
+{
+  const struct debug_dir_listing *listing = p;
+
+  return filename_hash (listing->dirname);
+}
+
+static int
+eq_debug_dir_listing (const void *a, const void *b)
+{
+  const struct debug_dir_listing *la = a;
+  const struct debug_dir_listing *lb = b;
+
+  return filename_eq (la->dirname, lb->dirname);
+}
+
+static void
+del_debug_dir_listing (void *p)
+{
+  struct debug_dir_listing *listing = p;
+
+  if (listing->entries != NULL)
+    htab_delete (listing->entries);
+  xfree (listing->dirname);
+  xfree (listing);
+}
+
+/* Discard all cached directory listings.  */
+
+static void
+flush_debug_dir_listings (void)
+{
+  if (debug_dir_listings != NULL)
+    {
+      htab_delete (debug_dir_listings);
+      debug_dir_listings = NULL;
+    }
+}
+
+/* Read the directory DIRNAME into a new listing.  */
+
+static struct debug_dir_listing *
+read_debug_dir_listing (const char *dirname)
+{
+  struct debug_dir_listing *listing = XCNEW (struct debug_dir_listing);
+  DIR *dir;
+
+  listing->dirname = xstrdup (dirname);
+
+  dir = opendir (dirname);
+  if (dir == NULL)
+    {
+      /* Only a directory which is not there says anything about the
+	 files in it; a search-only directory may still hold them.  */
+      if (errno != ENOENT && errno != ENOTDIR)
+	listing->unreadable = 1;
+    }
+  else
+    {
+      struct dirent *entry;
+
+      listing->entries = htab_create_alloc (16, filename_hash, filename_eq,
+					    xfree, xcalloc, xfree);
+      while ((entry = readdir (dir)) != NULL)
+	{
+	  void **slot = htab_find_slot (listing->entries, entry->d_name,
+					INSERT);
+
+	  if (*slot == NULL)
+	    *slot = xstrdup (entry->d_name);
+	}
+      closedir (dir);
+    }
+
+  return listing;
+}
+
+/* See symfile.h.  */
+
+int
+debug_file_may_exist (const char *filename)
+{
+  const char *base = lbasename (filename);
+  struct debug_dir_listing key, *listing;
+  void **slot;
+  char *dirname;
+
+  if (base == filename || *base == '\0' || remote_filename_p (filename))
+    return 1;
+
+  dirname = savestring (filename, base - filename);
+  key.dirname = dirname;
+
+  if (debug_dir_listings == NULL)
+    debug_dir_listings = htab_create_alloc (16, hash_debug_dir_listing,
+					    eq_debug_dir_listing,
+					    del_debug_dir_listing,
+					    xcalloc, xfree);
+  slot = htab_find_slot (debug_dir_listings, &key, INSERT);
+  if (*slot == NULL)
+    *slot = read_debug_dir_listing (dirname);
+  listing = *slot;
+  xfree (dirname);
+
+  if (listing->unreadable)
+    return 1;
+  if (listing->entries == NULL)
+    return 0;
+  return htab_find (listing->entries, base) != NULL;
+}
+
+/* Handle a change of the debug-file-directory setting.  */
+
+static void
+set_debug_file_directory (char *args, int from_tty,
+			  struct cmd_list_element *c)
+{
+  flush_debug_dir_listings ();
+}
+
 static int
 separate_debug_file_exists (const char *name, unsigned long crc,
 			    struct objfile *parent_objfile)
@@ -1304,6 +1545,9 @@ separate_debug_file_exists (const char *name, unsigned long crc,
   if (filename_cmp (name, objfile_name (parent_objfile)) == 0)
     return 0;
 
+  if (!debug_file_may_exist (name))
+    return 0;
+
   abfd = gdb_bfd_open_maybe_remote (name);
 
   if (!abfd)
@@ -2575,8 +2819,6 @@ reread_symbols (void)
 		  sizeof (objfile->static_psymbols));
 
 	  /* Free the obstacks for non-reusable objfiles.  */
-	  psymbol_bcache_free (objfile->psymbol_cache);
-	  objfile->psymbol_cache = psymbol_bcache_init ();
 	  obstack_free (&objfile->objfile_obstack, 0);
 	  objfile->sections = NULL;
 	  objfile->symtabs = NULL;
@@ -2630,7 +2872,7 @@ reread_symbols (void)
 	  (*objfile->sf->sym_init) (objfile);
 	  clear_complaints (&symfile_complaints, 1, 1);
 
-	  objfile->flags &= ~OBJF_PSYMTABS_READ;
+	  objfile->flags &= ~(OBJF_DEFERRED | OBJF_PSYMTABS_READ);
 	  read_symbols (objfile, 0);
 
 	  if (!objfile_has_symbols (objfile))
@@ -3839,6 +4081,7 @@ _initialize_symfile (void)
   struct cmd_list_element *c;
 
   observer_attach_free_objfile (symfile_free_objfile);
+  observer_attach_executable_changed (flush_debug_dir_listings);
 
   c = add_cmd ("symbol-file", class_files, symbol_file_command, _("\
 Load symbol table from executable file FILE.\n\
@@ -3918,7 +4161,7 @@ Separate debug symbols are first searched for in the same\n\
 directory as the binary, then in the `" DEBUG_SUBDIRECTORY "' subdirectory,\n\
 and lastly at the path of the directory of the binary with\n\
 each global debug-file-directory component prepended."),
-				     NULL,
+				     set_debug_file_directory,
 				     show_debug_file_directory,
 				     &setlist, &showlist);
 }
@@ -467,11 +467,31 @@ enum symfile_add_flags
 
     /* Do not immediately read symbols for this file.  By default,
        symbols are read when the objfile is created.  */
-    SYMFILE_NO_READ = 1 << 4
+    SYMFILE_NO_READ = 1 << 4,
+
+    /* Read only the dynamic symbols of this file for now, if the
+       symbol reader supports it.  The rest are read by
+       read_deferred_symbols when first needed.  */
+    SYMFILE_DEFER_READ = 1 << 5
   };
 
 extern void new_symfile_objfile (struct objfile *, int);
 
+/* Read the symbols of OBJFILE that SYMFILE_DEFER_READ left unread.
+   Do nothing if there are none.  */
+
+extern void read_deferred_symbols (struct objfile *objfile);
+
+/* Call read_deferred_symbols for every objfile of the current
+   program space.  Return the number of objfiles read.  */
+
+extern int read_all_deferred_symbols (void);
+
+/* Likewise, but only for the objfiles with a minimal symbol named
+   NAME.  */
+
+extern int read_deferred_symbols_for_name (const char *name);
+
 extern struct objfile *symbol_file_add (const char *, int,
 					struct section_addr_info *, int);
 
@@ -484,6 +504,13 @@ extern void symbol_file_add_separate (bfd *, const char *, int,
 
 extern char *find_separate_debug_file_by_debuglink (struct objfile *);
 
+/* Return zero if FILENAME is known not to exist, judging by a cached
+   listing of the directory containing it, and nonzero if it may
+   exist.  Used to skip the many absent candidates probed while
+   searching for separate debug files.  */
+
+extern int debug_file_may_exist (const char *filename);
+
 /* Create a new section_addr_info, with room for NUM_SECTIONS.  */
 
 extern struct section_addr_info *alloc_section_addr_info (size_t
@@ -649,6 +676,8 @@ extern void dwarf2_build_frame_info (struct objfile *);
 
 void dwarf2_free_objfile (struct objfile *);
 
+extern size_t dwarf2_cu_cache_memory_used (struct objfile *);
+
 /* From mdebugread.c */
 
 extern void mdebug_build_psymtabs (struct objfile *,
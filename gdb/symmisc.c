@@ -42,6 +42,7 @@
 #include "readline/readline.h"
 
 #include "psymtab.h"
+#include "macrotab.h"
 
 #ifndef DEV_TTY
 #define DEV_TTY "/dev/tty"
@@ -86,7 +87,7 @@ print_symbol_bcache_statistics (void)
     QUIT;
     printf_filtered (_("Byte cache statistics for '%s':\n"),
 		     objfile_name (objfile));
-    print_bcache_statistics (psymbol_bcache_get_bcache (objfile->psymbol_cache),
+    print_bcache_statistics (psymbol_bcache_get_bcache (objfile->per_bfd->psymbol_cache),
                              "partial symbol cache");
     print_bcache_statistics (objfile->per_bfd->macro_cache,
 			     "preprocessor macro cache");
@@ -95,6 +96,66 @@ print_symbol_bcache_statistics (void)
   }
 }
 
+/* Memory used by one objfile, broken down by kind of data.  */
+
+struct objfile_memory_stats
+{
+  /* Obstacks and bcaches, as a whole.  */
+  size_t objfile_obstack;
+  size_t bfd_obstack;
+  size_t psymbol_cache;
+  size_t macro_cache;
+  size_t filename_cache;
+
+  /* Allocations accounted in the objfile's objstats, and other
+     per-category totals.  */
+  size_t psymtabs;
+  size_t psymbol_lists;
+  size_t symbols;
+  size_t blocks;
+  size_t types;
+  size_t linetables;
+  size_t macro_tables;
+  size_t dwarf2_cu_cache;
+};
+
+/* Fill in STATS for OBJFILE.  */
+
+static void
+get_objfile_memory_stats (struct objfile *objfile,
+			  struct objfile_memory_stats *stats)
+{
+  struct symtab *s;
+
+  stats->objfile_obstack = obstack_memory_used (&objfile->objfile_obstack);
+  stats->bfd_obstack
+    = obstack_memory_used (&objfile->per_bfd->storage_obstack);
+  stats->psymbol_cache
+    = bcache_memory_used (psymbol_bcache_get_bcache
+			  (objfile->per_bfd->psymbol_cache));
+  stats->macro_cache = bcache_memory_used (objfile->per_bfd->macro_cache);
+  stats->filename_cache
+    = bcache_memory_used (objfile->per_bfd->filename_cache);
+
+  stats->psymtabs = OBJSTAT (objfile, sz_psymtabs);
+  stats->psymbol_lists = ((objfile->global_psymbols.size
+			   + objfile->static_psymbols.size)
+			  * sizeof (struct partial_symbol *));
+  stats->symbols = OBJSTAT (objfile, sz_syms);
+  stats->blocks = OBJSTAT (objfile, sz_blocks);
+  stats->types = OBJSTAT (objfile, sz_types);
+  stats->linetables = OBJSTAT (objfile, sz_linetables);
+
+  /* All the symtabs of a compilation unit share its macro table; count
+     it once, through the primary symtab.  */
+  stats->macro_tables = 0;
+  ALL_OBJFILE_SYMTABS (objfile, s)
+    if (s->primary && s->macro_table != NULL)
+      stats->macro_tables += macro_table_memory_used (s->macro_table);
+
+  stats->dwarf2_cu_cache = dwarf2_cu_cache_memory_used (objfile);
+}
+
 void
 print_objfile_statistics (void)
 {
@@ -106,6 +167,8 @@ print_objfile_statistics (void)
   ALL_PSPACES (pspace)
     ALL_PSPACE_OBJFILES (pspace, objfile)
   {
+    struct objfile_memory_stats mem;
+
     QUIT;
     printf_filtered (_("Statistics for '%s':\n"), objfile_name (objfile));
     if (OBJSTAT (objfile, n_stabs) > 0)
@@ -143,18 +206,101 @@ print_objfile_statistics (void)
     if (OBJSTAT (objfile, sz_strtab) > 0)
       printf_filtered (_("  Space used by a.out string tables: %d\n"),
 		       OBJSTAT (objfile, sz_strtab));
-    printf_filtered (_("  Total memory used for objfile obstack: %d\n"),
-		     obstack_memory_used (&objfile->objfile_obstack));
-    printf_filtered (_("  Total memory used for BFD obstack: %d\n"),
-		     obstack_memory_used (&objfile->per_bfd->storage_obstack));
-    printf_filtered (_("  Total memory used for psymbol cache: %d\n"),
-		     bcache_memory_used (psymbol_bcache_get_bcache
-		                          (objfile->psymbol_cache)));
-    printf_filtered (_("  Total memory used for macro cache: %d\n"),
-		     bcache_memory_used (objfile->per_bfd->macro_cache));
-    printf_filtered (_("  Total memory used for file name cache: %d\n"),
-		     bcache_memory_used (objfile->per_bfd->filename_cache));
+    get_objfile_memory_stats (objfile, &mem);
+    printf_filtered (_("  Total memory used for objfile obstack: %s\n"),
+		     pulongest (mem.objfile_obstack));
+    printf_filtered (_("  Total memory used for BFD obstack: %s\n"),
+		     pulongest (mem.bfd_obstack));
+    printf_filtered (_("  Total memory used for psymbol cache: %s\n"),
+		     pulongest (mem.psymbol_cache));
+    printf_filtered (_("  Total memory used for macro cache: %s\n"),
+		     pulongest (mem.macro_cache));
+    printf_filtered (_("  Total memory used for file name cache: %s\n"),
+		     pulongest (mem.filename_cache));
+    printf_filtered (_("  Memory used by category:\n"));
+    printf_filtered (_("    Partial symtabs: %s\n"),
+		     pulongest (mem.psymtabs));
+    printf_filtered (_("    Partial symbol lists: %s\n"),
+		     pulongest (mem.psymbol_lists));
+    printf_filtered (_("    Full symbols: %s\n"), pulongest (mem.symbols));
+    printf_filtered (_("    Blocks: %s\n"), pulongest (mem.blocks));
+    printf_filtered (_("    Types: %s\n"), pulongest (mem.types));
+    printf_filtered (_("    Line tables: %s\n"), pulongest (mem.linetables));
+    printf_filtered (_("    Macro tables: %s\n"),
+		     pulongest (mem.macro_tables));
+    printf_filtered (_("    DWARF CU cache: %s\n"),
+		     pulongest (mem.dwarf2_cu_cache));
+  }
+}
+
+/* Print STR as a JSON string literal.  */
+
+static void
+print_json_string (const char *str)
+{
+  const char *p;
+
+  printf_filtered ("\"");
+  for (p = str; *p != '\0'; p++)
+    {
+      if (*p == '"' || *p == '\\')
+	printf_filtered ("\\%c", *p);
+      else if ((unsigned char) *p < 0x20)
+	printf_filtered ("\\u%04x", (unsigned char) *p);
+      else
+	printf_filtered ("%c", *p);
+    }
+  printf_filtered ("\"");
+}
+
+/* Like print_objfile_statistics, but print the counts and the memory
+   breakdown of every objfile as a single JSON object, for consumption
+   by scripts.  */
+
+void
+print_objfile_statistics_json (void)
+{
+  struct program_space *pspace;
+  struct objfile *objfile;
+  const char *sep = "";
+
+  printf_filtered ("{\"objfiles\": [");
+  ALL_PSPACES (pspace)
+    ALL_PSPACE_OBJFILES (pspace, objfile)
+  {
+    struct objfile_memory_stats mem;
+
+    QUIT;
+    get_objfile_memory_stats (objfile, &mem);
+
+    printf_filtered ("%s\n {\"name\": ", sep);
+    print_json_string (objfile_name (objfile));
+    printf_filtered (",\n  \"minimal_symbols\": %d, \"partial_symbols\": %d,"
+		     " \"full_symbols\": %d, \"stabs\": %d, \"types\": %d,\n",
+		     OBJSTAT (objfile, n_minsyms), OBJSTAT (objfile, n_psyms),
+		     OBJSTAT (objfile, n_syms), OBJSTAT (objfile, n_stabs),
+		     OBJSTAT (objfile, n_types));
+    printf_filtered ("  \"memory\": {\"objfile_obstack\": %s,"
+		     " \"bfd_obstack\": %s, \"psymbol_cache\": %s,"
+		     " \"macro_cache\": %s, \"filename_cache\": %s,",
+		     pulongest (mem.objfile_obstack),
+		     pulongest (mem.bfd_obstack),
+		     pulongest (mem.psymbol_cache),
+		     pulongest (mem.macro_cache),
+		     pulongest (mem.filename_cache));
+    printf_filtered (" \"strtab\": %d,\n", OBJSTAT (objfile, sz_strtab));
+    printf_filtered ("             \"psymtabs\": %s, \"psymbol_lists\": %s,"
+		     " \"symbols\": %s, \"blocks\": %s, \"types\": %s,",
+		     pulongest (mem.psymtabs), pulongest (mem.psymbol_lists),
+		     pulongest (mem.symbols), pulongest (mem.blocks),
+		     pulongest (mem.types));
+    printf_filtered (" \"line_tables\": %s, \"macro_tables\": %s,"
+		     " \"dwarf2_cu_cache\": %s}}",
+		     pulongest (mem.linetables), pulongest (mem.macro_tables),
+		     pulongest (mem.dwarf2_cu_cache));
+    sep = ",";
   }
+  printf_filtered ("\n]}\n");
 }
 
 static void
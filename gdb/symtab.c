@@ -556,6 +556,12 @@ symbol_set_language (struct general_symbol_info *gsymbol,
 struct demangled_name_entry
 {
   const char *mangled;
+
+  /* The language the name was demangled for, and the language the
+     demangler settled on.  See symbol_find_demangled_name_cached.  */
+  ENUM_BITFIELD(language) input_language : 8;
+  ENUM_BITFIELD(language) language : 8;
+
   char demangled[1];
 };
 
@@ -679,6 +685,45 @@ symbol_find_demangled_name (struct general_symbol_info *gsymbol,
   return NULL;
 }
 
+/* Like symbol_find_demangled_name, but first look for MANGLED in the
+   demangled name hash of OBJFILE's backlink, if OBJFILE is a separate
+   debug objfile.  Separate debug files usually carry the same symbol
+   table as the objfile they belong to, so most names were already
+   demangled when reading the backlink's minimal symbols.  LOOKUP_NAME
+   is the key of MANGLED in the hash.  */
+
+static char *
+symbol_find_demangled_name_cached (struct general_symbol_info *gsymbol,
+				   struct objfile *objfile,
+				   const char *lookup_name,
+				   const char *mangled)
+{
+  struct objfile *backlink = objfile->separate_debug_objfile_backlink;
+
+  if (gsymbol->language == language_unknown)
+    gsymbol->language = language_auto;
+
+  if (backlink != NULL
+      && backlink->per_bfd != objfile->per_bfd
+      && backlink->per_bfd->demangled_names_hash != NULL)
+    {
+      struct demangled_name_entry entry;
+      const struct demangled_name_entry *found;
+
+      entry.mangled = lookup_name;
+      found = htab_find (backlink->per_bfd->demangled_names_hash, &entry);
+      if (found != NULL && found->input_language == gsymbol->language)
+	{
+	  gsymbol->language = found->language;
+	  if (found->demangled[0] == '\0')
+	    return NULL;
+	  return xstrdup (found->demangled);
+	}
+    }
+
+  return symbol_find_demangled_name (gsymbol, mangled);
+}
+
 /* Set both the mangled and demangled (if any) names for GSYMBOL based
    on LINKAGE_NAME and LEN.  Ordinarily, NAME is copied onto the
    objfile's obstack; but if COPY_NAME is 0 and if NAME is
@@ -800,8 +845,11 @@ symbol_set_names (struct general_symbol_info *gsymbol,
       || (gsymbol->language == language_go
 	  && (*slot)->demangled[0] == '\0'))
     {
-      char *demangled_name = symbol_find_demangled_name (gsymbol,
-							 linkage_name_copy);
+      enum language input_language = (gsymbol->language == language_unknown
+				       ? language_auto : gsymbol->language);
+      char *demangled_name
+	= symbol_find_demangled_name_cached (gsymbol, objfile, lookup_name,
+					     linkage_name_copy);
       int demangled_len = demangled_name ? strlen (demangled_name) : 0;
 
       /* Suppose we have demangled_name==NULL, copy_name==0, and
@@ -837,6 +885,8 @@ symbol_set_names (struct general_symbol_info *gsymbol,
 	  (*slot)->mangled = mangled_ptr;
 	}
 
+      (*slot)->input_language = input_language;
+      (*slot)->language = gsymbol->language;
       if (demangled_name != NULL)
 	{
 	  strcpy ((*slot)->demangled, demangled_name);
@@ -1435,6 +1485,159 @@ lookup_symbol_aux (const char *name, const struct block *block,
   return lookup_static_symbol_aux (name, domain);
 }
 
+/* Global and static symbol lookups that failed.  Searching every
+   objfile for a name that does not exist is expensive, and callers
+   such as pretty-printers tend to probe the same missing names over
+   and over.  Each program space keeps its own table, which is emptied
+   whenever an objfile is added or removed.  */
+
+struct symbol_lookup_failure
+{
+  /* The name looked up.  It is allocated along with the entry.  */
+  char *name;
+
+  domain_enum domain;
+
+  /* GLOBAL_BLOCK or STATIC_BLOCK.  */
+  int block_index;
+
+  /* The setting of "set case-sensitive" during the lookup.  */
+  enum case_sensitivity case_sensitivity;
+};
+
+/* The maximum number of failures remembered per program space.  The
+   table is emptied when it is full.  */
+
+#define MAX_SYMBOL_LOOKUP_FAILURES 4096
+
+static const struct program_space_data *symbol_lookup_failures_key;
+
+/* The key of the table of transparent type lookups of each program
+   space; see basic_lookup_transparent_type.  */
+
+static const struct program_space_data *transparent_types_key;
+
+/* Hash function for struct symbol_lookup_failure.  */
+
+static hashval_t
+hash_symbol_lookup_failure (const void *p)
+{
+  const struct symbol_lookup_failure *f = p;
+
+  return (htab_hash_string (f->name) + f->domain * 3 + f->block_index) * 7
+	  + f->case_sensitivity;
+}
+
+/* Equality function for struct symbol_lookup_failure.  */
+
+static int
+eq_symbol_lookup_failure (const void *a, const void *b)
+{
+  const struct symbol_lookup_failure *fa = a;
+  const struct symbol_lookup_failure *fb = b;
+
+  return (fa->domain == fb->domain
+	  && fa->block_index == fb->block_index
+	  && fa->case_sensitivity == fb->case_sensitivity
+	  && strcmp (fa->name, fb->name) == 0);
+}
+
+/* Return the table of failed lookups of the current program space,
+   creating it if CREATE is non-zero.  */
+
+static htab_t
+get_symbol_lookup_failures (int create)
+{
+  htab_t failures;
+
+  failures = program_space_data (current_program_space,
+				 symbol_lookup_failures_key);
+  if (failures == NULL && create)
+    {
+      failures = htab_create_alloc (127, hash_symbol_lookup_failure,
+				    eq_symbol_lookup_failure, xfree,
+				    xcalloc, xfree);
+      set_program_space_data (current_program_space,
+			      symbol_lookup_failures_key, failures);
+    }
+
+  return failures;
+}
+
+/* Return non-zero if looking up NAME in DOMAIN in the BLOCK_INDEX
+   blocks of all objfiles is known to fail.  */
+
+static int
+symbol_lookup_failed_p (const char *name, domain_enum domain,
+			int block_index)
+{
+  htab_t failures = get_symbol_lookup_failures (0);
+  struct symbol_lookup_failure f;
+
+  if (failures == NULL)
+    return 0;
+
+  f.name = (char *) name;
+  f.domain = domain;
+  f.block_index = block_index;
+  f.case_sensitivity = case_sensitivity;
+
+  return htab_find (failures, &f) != NULL;
+}
+
+/* Remember that looking up NAME in DOMAIN in the BLOCK_INDEX blocks of
+   all objfiles failed.  */
+
+static void
+record_symbol_lookup_failure (const char *name, domain_enum domain,
+			      int block_index)
+{
+  htab_t failures = get_symbol_lookup_failures (1);
+  struct symbol_lookup_failure f, *entry;
+  void **slot;
+  size_t len = strlen (name);
+
+  if (htab_elements (failures) >= MAX_SYMBOL_LOOKUP_FAILURES)
+    htab_empty (failures);
+
+  f.name = (char *) name;
+  f.domain = domain;
+  f.block_index = block_index;
+  f.case_sensitivity = case_sensitivity;
+
+  slot = htab_find_slot (failures, &f, INSERT);
+  if (*slot != NULL)
+    return;
+
+  entry = xmalloc (sizeof (*entry) + len + 1);
+  *entry = f;
+  entry->name = (char *) (entry + 1);
+  memcpy (entry->name, name, len + 1);
+  *slot = entry;
+}
+
+/* See symtab.h.  */
+
+void
+forget_symbol_lookup_failures (struct program_space *pspace)
+{
+  htab_t failures = program_space_data (pspace, symbol_lookup_failures_key);
+  htab_t types = program_space_data (pspace, transparent_types_key);
+
+  if (failures != NULL)
+    htab_empty (failures);
+  if (types != NULL)
+    htab_empty (types);
+}
+
+/* The program space data cleanup for symbol_lookup_failures_key.  */
+
+static void
+symbol_lookup_failures_cleanup (struct program_space *pspace, void *arg)
+{
+  htab_delete (arg);
+}
+
 /* Search all static file-level symbols for NAME from DOMAIN.  Do the symtabs
    first, then check the psymtabs.  If a psymtab indicates the existence of the
    desired name as a file-level static, then do psymtab-to-symtab conversion on
@@ -1446,6 +1649,9 @@ lookup_static_symbol_aux (const char *name, const domain_enum domain)
   struct objfile *objfile;
   struct symbol *sym;
 
+  if (symbol_lookup_failed_p (name, domain, STATIC_BLOCK))
+    return NULL;
+
   sym = lookup_symbol_aux_symtabs (STATIC_BLOCK, name, domain);
   if (sym != NULL)
     return sym;
@@ -1457,6 +1663,7 @@ lookup_static_symbol_aux (const char *name, const domain_enum domain)
       return sym;
   }
 
+  record_symbol_lookup_failure (name, domain, STATIC_BLOCK);
   return NULL;
 }
 
@@ -1830,6 +2037,11 @@ lookup_symbol_global (const char *name,
   struct objfile *objfile = NULL;
   struct global_sym_lookup_data lookup_data;
 
+  /* Every objfile gets searched below, so a failure does not depend
+     on BLOCK.  */
+  if (symbol_lookup_failed_p (name, domain, GLOBAL_BLOCK))
+    return NULL;
+
   /* Call library-specific lookup procedure.  */
   objfile = lookup_objfile_from_block (block);
   if (objfile != NULL)
@@ -1844,6 +2056,17 @@ lookup_symbol_global (const char *name,
     (objfile != NULL ? get_objfile_arch (objfile) : target_gdbarch (),
      lookup_symbol_global_iterator_cb, &lookup_data, objfile);
 
+  /* The symbol may be in a shared library whose symbols have not
+     been read yet.  Only the libraries exporting NAME are read, as
+     lookups that are expected to miss, such as the typedef checks
+     made while canonicalizing a name, are common.  */
+  if (lookup_data.result == NULL && read_deferred_symbols_for_name (name) > 0)
+    gdbarch_iterate_over_objfiles_in_search_order
+      (objfile != NULL ? get_objfile_arch (objfile) : target_gdbarch (),
+       lookup_symbol_global_iterator_cb, &lookup_data, objfile);
+
+  if (lookup_data.result == NULL)
+    record_symbol_lookup_failure (name, domain, GLOBAL_BLOCK);
   return lookup_data.result;
 }
 
@@ -1908,14 +2131,15 @@ basic_lookup_transparent_type_quick (struct objfile *objfile, int kind,
   return NULL;
 }
 
-/* The standard implementation of lookup_transparent_type.  This code
-   was modeled on lookup_symbol -- the parts not relevant to looking
-   up types were just left out.  In particular it's assumed here that
-   types are available in struct_domain and only at file-static or
-   global blocks.  */
+/* Search all the objfiles for the complete type NAME, for
+   basic_lookup_transparent_type.  This code was modeled on
+   lookup_symbol -- the parts not relevant to looking up types were
+   just left out.  In particular it's assumed here that types are
+   available in struct_domain and only at file-static or global
+   blocks.  */
 
-struct type *
-basic_lookup_transparent_type (const char *name)
+static struct type *
+basic_lookup_transparent_type_1 (const char *name)
 {
   struct symbol *sym;
   struct symtab *s = NULL;
@@ -1981,6 +2205,90 @@ basic_lookup_transparent_type (const char *name)
   return (struct type *) 0;
 }
 
+/* The result of a transparent type lookup.  check_typedef looks up
+   the complete type of every opaque type it comes across, each time;
+   when the complete type is in another objfile, or nowhere, nothing
+   short of searching all the objfiles again says so.  Each program
+   space keeps its own table of the results, emptied along with the
+   failed symbol lookups.  */
+
+struct transparent_type_entry
+{
+  /* The name looked up.  It is allocated along with the entry.  */
+  char *name;
+
+  /* The setting of "set case-sensitive" during the lookup.  */
+  enum case_sensitivity case_sensitivity;
+
+  /* The complete type, or NULL if there is none.  */
+  struct type *type;
+};
+
+/* Hash function for struct transparent_type_entry.  */
+
+static hashval_t
+hash_transparent_type_entry (const void *p)
+{
+  const struct transparent_type_entry *e = p;
+
+  return htab_hash_string (e->name) * 7 + e->case_sensitivity;
+}
+
+/* Equality function for struct transparent_type_entry.  */
+
+static int
+eq_transparent_type_entry (const void *a, const void *b)
+{
+  const struct transparent_type_entry *ea = a;
+  const struct transparent_type_entry *eb = b;
+
+  return (ea->case_sensitivity == eb->case_sensitivity
+	  && strcmp (ea->name, eb->name) == 0);
+}
+
+/* The standard implementation of lookup_transparent_type.  The
+   result is remembered until the objfiles change.  */
+
+struct type *
+basic_lookup_transparent_type (const char *name)
+{
+  htab_t types = program_space_data (current_program_space,
+				     transparent_types_key);
+  struct transparent_type_entry e, *entry;
+  size_t len;
+  void **slot;
+
+  if (types == NULL)
+    {
+      types = htab_create_alloc (127, hash_transparent_type_entry,
+				 eq_transparent_type_entry, xfree,
+				 xcalloc, xfree);
+      set_program_space_data (current_program_space,
+			      transparent_types_key, types);
+    }
+
+  e.name = (char *) name;
+  e.case_sensitivity = case_sensitivity;
+  entry = htab_find (types, &e);
+  if (entry != NULL)
+    return entry->type;
+
+  e.type = basic_lookup_transparent_type_1 (name);
+
+  if (htab_elements (types) >= MAX_SYMBOL_LOOKUP_FAILURES)
+    htab_empty (types);
+
+  slot = htab_find_slot (types, &e, INSERT);
+  len = strlen (name);
+  entry = xmalloc (sizeof (*entry) + len + 1);
+  *entry = e;
+  entry->name = (char *) (entry + 1);
+  memcpy (entry->name, name, len + 1);
+  *slot = entry;
+
+  return e.type;
+}
+
 /* Search BLOCK for symbol NAME in DOMAIN.
 
    Note that if NAME is the demangled form of a C++ symbol, we will fail
@@ -2069,6 +2377,187 @@ iterate_over_symbols (const struct block *block, const char *name,
     }
 }
 
+/* An index of the primary symtabs of an objfile by the address range
+   of their global block, used by find_pc_sect_symtab.  Global block
+   ranges may overlap, and the smallest range containing the PC wins,
+   so rather than an addrmap this is an array sorted by start address
+   with the running maximum of the end addresses, which bounds how far
+   back a search has to look.  Symtabs are only ever added at the head
+   of the objfile's list, so the index is rebuilt whenever the head
+   changes.  */
+
+struct pc_symtab_entry
+{
+  CORE_ADDR start;
+  CORE_ADDR end;
+
+  /* The maximum END of this and all preceding entries.  */
+  CORE_ADDR max_end;
+
+  struct symtab *symtab;
+
+  /* The position of SYMTAB in the objfile's list, counting from the
+     tail, so that it does not change as symtabs are added.  */
+  int pos;
+};
+
+struct pc_symtab_index
+{
+  /* The head of the objfile's symtab list when the index was
+     built.  */
+  struct symtab *head;
+
+  int count;
+  struct pc_symtab_entry *entries;
+};
+
+typedef struct pc_symtab_entry *pc_symtab_entry_p;
+DEF_VEC_P (pc_symtab_entry_p);
+
+static const struct objfile_data *pc_symtab_index_key;
+
+/* qsort comparison function for struct pc_symtab_entry, ordering by
+   start address.  */
+
+static int
+compare_pc_symtab_entries (const void *a, const void *b)
+{
+  const struct pc_symtab_entry *ea = a;
+  const struct pc_symtab_entry *eb = b;
+
+  if (ea->start != eb->start)
+    return ea->start < eb->start ? -1 : 1;
+  return eb->pos - ea->pos;
+}
+
+/* qsort comparison function for pointers to struct pc_symtab_entry,
+   putting them in the order of the objfile's symtab list.  */
+
+static int
+compare_pc_symtab_entry_ptrs_by_pos (const void *a, const void *b)
+{
+  const struct pc_symtab_entry *ea = *(const struct pc_symtab_entry **) a;
+  const struct pc_symtab_entry *eb = *(const struct pc_symtab_entry **) b;
+
+  return eb->pos - ea->pos;
+}
+
+/* Free INDEX.  */
+
+static void
+free_pc_symtab_index (struct pc_symtab_index *index)
+{
+  if (index != NULL)
+    {
+      xfree (index->entries);
+      xfree (index);
+    }
+}
+
+/* The objfile data cleanup for pc_symtab_index_key.  */
+
+static void
+pc_symtab_index_cleanup (struct objfile *objfile, void *arg)
+{
+  free_pc_symtab_index (arg);
+}
+
+/* See symtab.h.  */
+
+void
+clear_pc_symtab_index (struct objfile *objfile)
+{
+  free_pc_symtab_index (objfile_data (objfile, pc_symtab_index_key));
+  set_objfile_data (objfile, pc_symtab_index_key, NULL);
+}
+
+/* Return the PC index of OBJFILE's symtabs, building it if needed.  */
+
+static struct pc_symtab_index *
+get_pc_symtab_index (struct objfile *objfile)
+{
+  struct pc_symtab_index *index;
+  struct symtab *s;
+  int n = 0, i;
+
+  index = objfile_data (objfile, pc_symtab_index_key);
+  if (index != NULL && index->head == objfile->symtabs)
+    return index;
+
+  clear_pc_symtab_index (objfile);
+
+  ALL_OBJFILE_SYMTABS (objfile, s)
+    if (s->primary)
+      n++;
+
+  index = XNEW (struct pc_symtab_index);
+  index->head = objfile->symtabs;
+  index->count = n;
+  index->entries = XNEWVEC (struct pc_symtab_entry, n);
+
+  i = 0;
+  ALL_OBJFILE_SYMTABS (objfile, s)
+    if (s->primary)
+      {
+	const struct block *b
+	  = BLOCKVECTOR_BLOCK (BLOCKVECTOR (s), GLOBAL_BLOCK);
+	struct pc_symtab_entry *e = &index->entries[i];
+
+	e->start = BLOCK_START (b);
+	e->end = BLOCK_END (b);
+	e->symtab = s;
+	e->pos = n - 1 - i;
+	i++;
+      }
+
+  qsort (index->entries, n, sizeof (index->entries[0]),
+	 compare_pc_symtab_entries);
+
+  for (i = 0; i < n; i++)
+    {
+      struct pc_symtab_entry *e = &index->entries[i];
+
+      e->max_end = e->end;
+      if (i > 0 && index->entries[i - 1].max_end > e->max_end)
+	e->max_end = index->entries[i - 1].max_end;
+    }
+
+  set_objfile_data (objfile, pc_symtab_index_key, index);
+  return index;
+}
+
+/* Append a pointer to each entry of INDEX whose range contains PC to
+   *RESULT, ordered as the objfile's symtab list.  */
+
+static void
+find_pc_symtab_candidates (struct pc_symtab_index *index, CORE_ADDR pc,
+			   VEC (pc_symtab_entry_p) **result)
+{
+  struct pc_symtab_entry *e;
+  int lo = 0, hi = index->count;
+  int i, first = VEC_length (pc_symtab_entry_p, *result);
+
+  /* Find the first entry starting after PC.  */
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (index->entries[mid].start <= pc)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  for (i = lo - 1; i >= 0 && index->entries[i].max_end > pc; i--)
+    if (index->entries[i].end > pc)
+      VEC_safe_push (pc_symtab_entry_p, *result, &index->entries[i]);
+
+  if (VEC_length (pc_symtab_entry_p, *result) - first > 1)
+    qsort (VEC_address (pc_symtab_entry_p, *result) + first,
+	   VEC_length (pc_symtab_entry_p, *result) - first,
+	   sizeof (e), compare_pc_symtab_entry_ptrs_by_pos);
+}
+
 /* Find the symtab associated with PC and SECTION.  Look through the
    psymtabs and read in another symtab if necessary.  */
 
@@ -2082,6 +2571,8 @@ find_pc_sect_symtab (CORE_ADDR pc, struct obj_section *section)
   struct objfile *objfile;
   CORE_ADDR distance = 0;
   struct minimal_symbol *msymbol;
+  VEC (pc_symtab_entry_p) *candidates = NULL;
+  struct cleanup *cleanup;
 
   /* If we know that this is not a text address, return failure.  This is
      necessary because we loop based on the block's high and low code
@@ -2112,16 +2603,26 @@ find_pc_sect_symtab (CORE_ADDR pc, struct obj_section *section)
      It also happens for objfiles that have their functions reordered.
      For these, the symtab we are looking for is not necessarily read in.  */
 
-  ALL_PRIMARY_SYMTABS (objfile, s)
+  cleanup = make_cleanup (VEC_cleanup (pc_symtab_entry_p), &candidates);
+
+  ALL_OBJFILES (objfile)
   {
-    bv = BLOCKVECTOR (s);
-    b = BLOCKVECTOR_BLOCK (bv, GLOBAL_BLOCK);
+    int ix;
+    struct pc_symtab_entry *e;
 
-    if (BLOCK_START (b) <= pc
-	&& BLOCK_END (b) > pc
-	&& (distance == 0
-	    || BLOCK_END (b) - BLOCK_START (b) < distance))
+    VEC_truncate (pc_symtab_entry_p, candidates, 0);
+    find_pc_symtab_candidates (get_pc_symtab_index (objfile), pc,
+			       &candidates);
+
+    for (ix = 0; VEC_iterate (pc_symtab_entry_p, candidates, ix, e); ++ix)
       {
+	s = e->symtab;
+	bv = BLOCKVECTOR (s);
+	b = BLOCKVECTOR_BLOCK (bv, GLOBAL_BLOCK);
+
+	if (distance != 0 && BLOCK_END (b) - BLOCK_START (b) >= distance)
+	  continue;
+
 	/* For an objfile that has its functions reordered,
 	   find_pc_psymtab will find the proper partial symbol table
 	   and we simply return its corresponding symtab.  */
@@ -2138,7 +2639,10 @@ find_pc_sect_symtab (CORE_ADDR pc, struct obj_section *section)
 						      pc, section,
 						      0);
 	    if (result)
-	      return result;
+	      {
+		do_cleanups (cleanup);
+		return result;
+	      }
 	  }
 	if (section != 0)
 	  {
@@ -2161,6 +2665,8 @@ find_pc_sect_symtab (CORE_ADDR pc, struct obj_section *section)
       }
   }
 
+  do_cleanups (cleanup);
+
   if (best_s != NULL)
     return (best_s);
 
@@ -3409,8 +3915,58 @@ struct search_symbols_data
   /* It is true if PREG contains valid data, false otherwise.  */
   unsigned preg_p : 1;
   regex_t preg;
+
+  /* Text every name matching PREG must start with, and its length.
+     PREFIX_LEN is zero if there is no such text.  */
+  const char *prefix;
+  int prefix_len;
 };
 
+/* Return the length of the text at the start of REGEXP, a basic
+   regular expression beginning with '^', that every string it matches
+   must start with.  Return zero if there is no such text or it cannot
+   be determined easily.  The text starts at REGEXP + 1.  */
+
+static int
+regexp_literal_prefix_length (const char *regexp)
+{
+  const char *p;
+  int len;
+
+  if (regexp[0] != '^' || strstr (regexp, "\\|") != NULL)
+    return 0;
+
+  for (p = regexp + 1; *p != '\0' && strchr (".[\\*^$", *p) == NULL; p++)
+    ;
+  len = p - (regexp + 1);
+
+  /* A repetition operator applies to the last literal character.  */
+  if (len > 0
+      && (*p == '*'
+	  || (*p == '\\'
+	      && (p[1] == '{' || p[1] == '?' || p[1] == '+'))))
+    len--;
+
+  return len;
+}
+
+/* Return non-zero if NAME matches the regexp of DATA, if any.  */
+
+static int
+search_symbols_regexp_matches (struct search_symbols_data *data,
+			       const char *name)
+{
+  if (!data->preg_p)
+    return 1;
+
+  /* Rule out most names cheaply before running the regexp.  */
+  if (data->prefix_len > 0
+      && strncmp (name, data->prefix, data->prefix_len) != 0)
+    return 0;
+
+  return regexec (&data->preg, name, 0, NULL, 0) == 0;
+}
+
 /* A callback for expand_symtabs_matching.  */
 
 static int
@@ -3429,7 +3985,7 @@ search_symbols_name_matches (const char *symname, void *user_data)
 {
   struct search_symbols_data *data = user_data;
 
-  return !data->preg_p || regexec (&data->preg, symname, 0, NULL, 0) == 0;
+  return search_symbols_regexp_matches (data, symname);
 }
 
 /* Search the symbol table for matches to the regular expression REGEXP,
@@ -3493,6 +4049,8 @@ search_symbols (char *regexp, enum search_domain kind,
 
   *matches = NULL;
   datum.preg_p = 0;
+  datum.prefix = NULL;
+  datum.prefix_len = 0;
 
   if (regexp != NULL)
     {
@@ -3543,6 +4101,14 @@ search_symbols (char *regexp, enum search_domain kind,
 	}
       datum.preg_p = 1;
       make_regfree_cleanup (&datum.preg);
+
+      /* The regexp is matched case-insensitively if case sensitivity
+	 is off, so the prefix cannot be compared with strncmp then.  */
+      if (case_sensitivity != case_sensitive_off)
+	{
+	  datum.prefix = regexp + 1;
+	  datum.prefix_len = regexp_literal_prefix_length (regexp);
+	}
     }
 
   /* Search through the partial symtabs *first* for all symbols
@@ -3593,9 +4159,8 @@ search_symbols (char *regexp, enum search_domain kind,
 	    || MSYMBOL_TYPE (msymbol) == ourtype3
 	    || MSYMBOL_TYPE (msymbol) == ourtype4)
 	  {
-	    if (!datum.preg_p
-		|| regexec (&datum.preg, SYMBOL_NATURAL_NAME (msymbol), 0,
-			    NULL, 0) == 0)
+	    if (search_symbols_regexp_matches (&datum,
+					       SYMBOL_NATURAL_NAME (msymbol)))
 	      {
 		/* Note: An important side-effect of these lookup functions
 		   is to expand the symbol table if msymbol is found, for the
@@ -3636,9 +4201,8 @@ search_symbols (char *regexp, enum search_domain kind,
 				       files, nfiles, 1))
 		     && file_matches (symtab_to_fullname (real_symtab),
 				      files, nfiles, 0)))
-		&& ((!datum.preg_p
-		     || regexec (&datum.preg, SYMBOL_NATURAL_NAME (sym), 0,
-				 NULL, 0) == 0)
+		&& (search_symbols_regexp_matches (&datum,
+						   SYMBOL_NATURAL_NAME (sym))
 		    && ((kind == VARIABLES_DOMAIN
 			 && SYMBOL_CLASS (sym) != LOC_TYPEDEF
 			 && SYMBOL_CLASS (sym) != LOC_UNRESOLVED
@@ -3696,9 +4260,8 @@ search_symbols (char *regexp, enum search_domain kind,
 	    || MSYMBOL_TYPE (msymbol) == ourtype3
 	    || MSYMBOL_TYPE (msymbol) == ourtype4)
 	  {
-	    if (!datum.preg_p
-		|| regexec (&datum.preg, SYMBOL_NATURAL_NAME (msymbol), 0,
-			    NULL, 0) == 0)
+	    if (search_symbols_regexp_matches (&datum,
+					       SYMBOL_NATURAL_NAME (msymbol)))
 	      {
 		/* For functions we can do a quick check of whether the
 		   symbol might be found via find_pc_symtab.  */
@@ -4341,7 +4904,8 @@ default_make_symbol_completion_list_break_on (const char *text,
   /* Look through the partial symtabs for all symbols which begin
      by matching SYM_TEXT.  Expand all CUs that you find to the list.
      The real names will get added by COMPLETION_LIST_ADD_SYMBOL below.  */
-  expand_partial_symbol_names (expand_partial_symbol_name, &datum);
+  expand_partial_symbol_names_with_prefix (sym_text, sym_text_len,
+					   expand_partial_symbol_name, &datum);
 
   /* At this point scan through the misc symbol vectors and add each
      symbol you find to the list.  Eventually we want to ignore
@@ -5039,6 +5603,24 @@ symtab_observer_executable_changed (void)
   set_main_name (NULL);
 }
 
+/* Handle ``new_objfile'' and ``free_objfile'' events for the symtab
+   module.  */
+
+static void
+symtab_observer_objfiles_changed (struct objfile *objfile)
+{
+  /* Symbols may have appeared or disappeared.  */
+  if (objfile == NULL)
+    {
+      struct program_space *pspace;
+
+      ALL_PSPACES (pspace)
+	forget_symbol_lookup_failures (pspace);
+    }
+  else
+    forget_symbol_lookup_failures (objfile->pspace);
+}
+
 /* Return 1 if the supplied producer string matches the ARM RealView
    compiler (armcc).  */
 
@@ -5191,6 +5773,7 @@ allocate_symbol (struct objfile *objfile)
 
   result = OBSTACK_ZALLOC (&objfile->objfile_obstack, struct symbol);
   SYMBOL_SECTION (result) = -1;
+  OBJSTAT (objfile, sz_syms += sizeof (struct symbol));
 
   return result;
 }
@@ -5205,11 +5788,57 @@ allocate_template_symbol (struct objfile *objfile)
 
   result = OBSTACK_ZALLOC (&objfile->objfile_obstack, struct template_symbol);
   SYMBOL_SECTION (&result->base) = -1;
+  OBJSTAT (objfile, sz_syms += sizeof (struct template_symbol));
 
   return result;
 }
 
 
+/* The number of frames, counting from the innermost one, whose symbol
+   tables are expanded when the inferior stops.  Zero disables this.  */
+
+static unsigned int prefetch_symtab_frames = 0;
+
+static void
+show_prefetch_symtab_frames (struct ui_file *file, int from_tty,
+			     struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("The number of frames whose symbol tables "
+			    "are expanded when the program stops is %s.\n"),
+		    value);
+}
+
+/* The 'normal_stop' observer notification callback.  Expand the symbol
+   tables covering the innermost PREFETCH_SYMTAB_FRAMES frames, so that
+   the commands typically used to inspect the stop, like "bt full",
+   don't each have to read in one more compilation unit.  */
+
+static void
+symtab_observer_normal_stop (struct bpstats *bs, int print_frame)
+{
+  volatile struct gdb_exception ex;
+
+  if (prefetch_symtab_frames == 0 || !has_stack_frames ())
+    return;
+
+  /* This is only speculative, so errors (e.g. unreadable memory while
+     unwinding) are not reported.  */
+  TRY_CATCH (ex, RETURN_MASK_ERROR)
+    {
+      struct frame_info *frame;
+      unsigned int count = 0;
+
+      for (frame = get_current_frame ();
+	   frame != NULL && count < prefetch_symtab_frames;
+	   frame = get_prev_frame (frame), ++count)
+	{
+	  CORE_ADDR pc;
+
+	  if (get_frame_address_in_block_if_available (frame, &pc))
+	    find_pc_symtab (pc);
+	}
+    }
+}
 
 void
 _initialize_symtab (void)
@@ -5281,5 +5910,31 @@ When enabled, debugging messages are printed when building symbol tables."),
 			    NULL,
 			    &setdebuglist, &showdebuglist);
 
+  add_setshow_zuinteger_cmd ("prefetch-symtab-frames", class_obscure,
+			     &prefetch_symtab_frames, _("\
+Set the number of frames whose symbol tables are read when the program stops."),
+			     _("\
+Show the number of frames whose symbol tables are read when the program stops."),
+			     _("\
+When the program stops, GDB reads in the full symbol tables covering\n\
+this many of the innermost frames, so that commands like \"bt full\"\n\
+respond without further delay.  Zero (the default) disables this."),
+			     NULL,
+			     show_prefetch_symtab_frames,
+			     &setlist, &showlist);
+
   observer_attach_executable_changed (symtab_observer_executable_changed);
+  observer_attach_normal_stop (symtab_observer_normal_stop);
+  observer_attach_new_objfile (symtab_observer_objfiles_changed);
+  observer_attach_free_objfile (symtab_observer_objfiles_changed);
+
+  pc_symtab_index_key
+    = register_objfile_data_with_cleanup (NULL, pc_symtab_index_cleanup);
+
+  symbol_lookup_failures_key
+    = register_program_space_data_with_cleanup (NULL,
+						symbol_lookup_failures_cleanup);
+  transparent_types_key
+    = register_program_space_data_with_cleanup (NULL,
+						symbol_lookup_failures_cleanup);
 }
@@ -1058,6 +1058,19 @@ extern struct symbol *lookup_language_this (const struct language_defn *lang,
 struct symbol *lookup_static_symbol_aux (const char *name,
 					 const domain_enum domain);
 
+/* Discard the record of failed global and static symbol lookups, and
+   of transparent type lookups, in PSPACE.  This is done automatically by the new_objfile and
+   free_objfile observers; code that creates symbols without notifying
+   them must call it itself.  */
+
+extern void forget_symbol_lookup_failures (struct program_space *pspace);
+
+/* Discard the index find_pc_sect_symtab keeps of OBJFILE's symtabs.
+   This must be called when the address ranges of its blocks
+   change.  */
+
+extern void clear_pc_symtab_index (struct objfile *objfile);
+
 
 /* lookup a symbol by name, within a specified block.  */
 
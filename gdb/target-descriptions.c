@@ -1868,6 +1868,17 @@ Unset the file to read for an XML target description.  When unset,\n\
 GDB will read the description from the target."),
 	   &tdesc_unset_cmdlist);
 
+  add_setshow_optional_filename_cmd ("cache-directory", class_obscure,
+				     &tdesc_cache_directory, _("\
+Set the directory for caching target descriptions."), _("\
+Show the directory for caching target descriptions."), _("\
+When set, target descriptions fetched from a target that identifies\n\
+them by a digest are saved in this directory, and are read from it\n\
+instead of from the target the next time the target reports the same\n\
+digest.  When empty, descriptions are only cached for the current session."),
+				     NULL, NULL,
+				     &tdesc_set_cmdlist, &tdesc_show_cmdlist);
+
   add_cmd ("c-tdesc", class_maintenance, maint_print_c_tdesc_cmd, _("\
 Print the current target description as a C source file."),
 	   &maintenanceprintlist);
@@ -43,6 +43,7 @@
 #include "tracepoint.h"
 #include "gdb/fileio.h"
 #include "agent.h"
+#include "observer.h"
 
 static void target_info (char *, int);
 
@@ -168,10 +169,11 @@ struct target_ops current_target;
 
 static struct cmd_list_element *targetlist = NULL;
 
-/* Nonzero if we should trust readonly sections from the
-   executable when reading memory.  */
+/* Whether we should trust readonly sections from the executable when
+   reading memory.  In the "auto" mode we do once the target has
+   confirmed that its memory holds their contents.  */
 
-static int trust_readonly = 0;
+static enum auto_boolean trust_readonly = AUTO_BOOLEAN_AUTO;
 
 /* Nonzero if we should show true memory content including
    memory breakpoint inserted by gdb.  */
@@ -235,6 +237,32 @@ show_stack_cache_enabled_p (struct ui_file *file, int from_tty,
   fprintf_filtered (file, _("Cache use for stack accesses is %s.\n"), value);
 }
 
+/* The option sets this.  */
+static int code_cache_enabled_p_1 = 1;
+/* And set_code_cache_enabled_p updates this.  See stack_cache_enabled_p
+   for why they are separate.  */
+static int code_cache_enabled_p = 1;
+
+/* This is called *after* the code-cache has been set.  Flush the cache
+   for off->on and on->off transitions.  */
+
+static void
+set_code_cache_enabled_p (char *args, int from_tty,
+			  struct cmd_list_element *c)
+{
+  if (code_cache_enabled_p != code_cache_enabled_p_1)
+    target_dcache_invalidate ();
+
+  code_cache_enabled_p = code_cache_enabled_p_1;
+}
+
+static void
+show_code_cache_enabled_p (struct ui_file *file, int from_tty,
+			   struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("Cache use for code accesses is %s.\n"), value);
+}
+
 /* Cache of memory operations, to speed up remote access.  */
 static DCACHE *target_dcache;
 
@@ -246,6 +274,17 @@ target_dcache_invalidate (void)
   dcache_invalidate (target_dcache);
 }
 
+/* Store in the target dcache the LEN bytes of stack memory at MEMADDR
+   in MYADDR, which the target sent along with a stop of PTID.  */
+
+void
+target_dcache_fill (ptid_t ptid, CORE_ADDR memaddr,
+		    const gdb_byte *myaddr, int len)
+{
+  if (stack_cache_enabled_p)
+    dcache_fill (target_dcache, ptid, memaddr, myaddr, len);
+}
+
 /* The user just typed 'target' without the name of a target.  */
 
 static void
@@ -1357,6 +1396,129 @@ target_section_by_addr (struct target_ops *target, CORE_ADDR addr)
   return NULL;
 }
 
+/* Return nonzero if some target on the stack can compare its memory
+   with the debugger's idea of it.  */
+
+static int
+target_can_verify_memory (void)
+{
+  struct target_ops *t;
+
+  for (t = current_target.beneath; t != NULL; t = t->beneath)
+    if (t->to_verify_memory != NULL)
+      return 1;
+
+  return 0;
+}
+
+/* Return nonzero if reads from the readonly section SECP may be
+   satisfied from the executable file, according to
+   "trust-readonly-sections".  In the "auto" mode, ask the target
+   whether its memory holds the section's contents the first time
+   around, and remember the answer in SECP.  */
+
+static int
+trust_readonly_section_p (struct target_section *secp)
+{
+  if (trust_readonly == AUTO_BOOLEAN_TRUE)
+    return 1;
+  if (trust_readonly == AUTO_BOOLEAN_FALSE
+      || get_traceframe_number () != -1
+      || !target_can_verify_memory ())
+    return 0;
+
+  if (secp->verified == 0)
+    {
+      struct bfd_section *asect = secp->the_bfd_section;
+      bfd_size_type size = secp->endaddr - secp->addr;
+      volatile struct gdb_exception ex;
+      struct cleanup *cleanups;
+      gdb_byte *contents;
+
+      secp->verified = -1;
+
+      contents = xmalloc (size);
+      cleanups = make_cleanup (xfree, contents);
+      if (bfd_get_section_contents (asect->owner, asect, contents, 0, size))
+	{
+	  /* Targets report lack of support with an error.  */
+	  TRY_CATCH (ex, RETURN_MASK_ERROR)
+	    {
+	      if (target_verify_memory (contents, secp->addr, size) == 1)
+		secp->verified = 1;
+	    }
+	}
+      do_cleanups (cleanups);
+
+      if (targetdebug)
+	fprintf_unfiltered (gdb_stdlog,
+			    "target: section %s at %s %s the target's memory\n",
+			    bfd_section_name (asect->owner, asect),
+			    paddress (target_gdbarch (), secp->addr),
+			    secp->verified > 0 ? "matches" : "does not match");
+    }
+
+  return secp->verified > 0;
+}
+
+/* Forget the results of checking the current target sections with
+   trust_readonly_section_p.  If MISMATCHED_ONLY, forget only those
+   found not to match: they may have compared unequal due to
+   breakpoints inserted at the time.  */
+
+static void
+forget_readonly_section_checks (int mismatched_only)
+{
+  struct target_section_table *table
+    = target_get_section_table (&current_target);
+  struct target_section *secp;
+
+  if (table == NULL)
+    return;
+
+  for (secp = table->sections; secp < table->sections_end; secp++)
+    if (!mismatched_only || secp->verified < 0)
+      secp->verified = 0;
+}
+
+/* Forget that the current target sections overlapping the LEN bytes
+   at MEMADDR were found to match the target's memory, since we are
+   changing it.  */
+
+static void
+forget_readonly_section_checks_in_range (CORE_ADDR memaddr, LONGEST len)
+{
+  struct target_section_table *table
+    = target_get_section_table (&current_target);
+  struct target_section *secp;
+
+  if (table == NULL)
+    return;
+
+  for (secp = table->sections; secp < table->sections_end; secp++)
+    if (secp->addr < memaddr + len && memaddr < secp->endaddr)
+      secp->verified = 0;
+}
+
+/* Observer for the inferior_created event: a new process or target
+   connection may hold different memory.  */
+
+static void
+target_inferior_created (struct target_ops *ops, int from_tty)
+{
+  forget_readonly_section_checks (0);
+}
+
+/* Observer for the normal_stop event: breakpoints are usually out of
+   the target's memory now, so sections which didn't match may do
+   so.  */
+
+static void
+target_normal_stop (struct bpstats *bs, int print_frame)
+{
+  forget_readonly_section_checks (1);
+}
+
 /* Read memory from the live target, even if currently inspecting a
    traceframe.  The return is the same as that of target_read.  */
 
@@ -1471,8 +1633,9 @@ memory_xfer_partial_1 (struct target_ops *ops, enum target_object object,
 	}
     }
 
-  /* Try the executable files, if "trust-readonly-sections" is set.  */
-  if (readbuf != NULL && trust_readonly)
+  /* Try the executable files, if "trust-readonly-sections" allows
+     it.  */
+  if (readbuf != NULL && trust_readonly != AUTO_BOOLEAN_FALSE)
     {
       struct target_section *secp;
       struct target_section_table *table;
@@ -1481,7 +1644,8 @@ memory_xfer_partial_1 (struct target_ops *ops, enum target_object object,
       if (secp != NULL
 	  && (bfd_get_section_flags (secp->the_bfd_section->owner,
 				     secp->the_bfd_section)
-	      & SEC_READONLY))
+	      & SEC_READONLY)
+	  && trust_readonly_section_p (secp))
 	{
 	  table = target_get_section_table (ops);
 	  return section_table_xfer_memory_partial (readbuf, writebuf,
@@ -1586,7 +1750,8 @@ memory_xfer_partial_1 (struct target_ops *ops, enum target_object object,
 	 the collected memory range fails.  */
       && get_traceframe_number () == -1
       && (region->attrib.cache
-	  || (stack_cache_enabled_p && object == TARGET_OBJECT_STACK_MEMORY)))
+	  || (stack_cache_enabled_p && object == TARGET_OBJECT_STACK_MEMORY)
+	  || (code_cache_enabled_p && object == TARGET_OBJECT_CODE_MEMORY)))
     {
       if (readbuf != NULL)
 	res = dcache_xfer_memory (ops, target_dcache, memaddr, readbuf,
@@ -1631,15 +1796,16 @@ memory_xfer_partial_1 (struct target_ops *ops, enum target_object object,
   while (ops != NULL);
 
   /* Make sure the cache gets updated no matter what - if we are writing
-     to the stack.  Even if this write is not tagged as such, we still need
-     to update the cache.  */
+     to the stack or the code.  Even if this write is not tagged as such,
+     we still need to update the cache.  */
 
   if (res > 0
       && inf != NULL
       && writebuf != NULL
       && !region->attrib.cache
-      && stack_cache_enabled_p
-      && object != TARGET_OBJECT_STACK_MEMORY)
+      && (stack_cache_enabled_p || code_cache_enabled_p)
+      && object != TARGET_OBJECT_STACK_MEMORY
+      && object != TARGET_OBJECT_CODE_MEMORY)
     {
       dcache_update (target_dcache, memaddr, (void *) writebuf, res);
     }
@@ -1689,6 +1855,11 @@ memory_xfer_partial (struct target_ops *ops, enum target_object object,
       old_chain = make_cleanup (xfree, buf);
       memcpy (buf, writebuf, len);
 
+      /* Writes other than the raw ones inserting breakpoints make the
+	 memory differ from the executable file.  */
+      if (object != TARGET_OBJECT_RAW_MEMORY)
+	forget_readonly_section_checks_in_range (memaddr, len);
+
       breakpoint_xfer_memory (NULL, buf, writebuf, memaddr, len);
       res = memory_xfer_partial_1 (ops, object, NULL, buf, memaddr, len);
 
@@ -1733,7 +1904,8 @@ target_xfer_partial (struct target_ops *ops,
   /* If this is a memory transfer, let the memory-specific code
      have a look at it instead.  Memory transfers are more
      complicated.  */
-  if (object == TARGET_OBJECT_MEMORY || object == TARGET_OBJECT_STACK_MEMORY)
+  if (object == TARGET_OBJECT_MEMORY || object == TARGET_OBJECT_STACK_MEMORY
+      || object == TARGET_OBJECT_CODE_MEMORY)
     retval = memory_xfer_partial (ops, object, readbuf,
 				  writebuf, offset, len);
   else
@@ -1747,6 +1919,16 @@ target_xfer_partial (struct target_ops *ops,
 
       retval = ops->to_xfer_partial (ops, raw_object, annex, readbuf,
 				     writebuf, offset, len);
+
+      /* Raw writes are how breakpoints are inserted and removed; the
+	 cached code must see them, or the breakpoint instructions would
+	 be left in the cache after a removal.  */
+      if (object == TARGET_OBJECT_RAW_MEMORY
+	  && retval > 0
+	  && writebuf != NULL
+	  && !ptid_equal (inferior_ptid, null_ptid)
+	  && (stack_cache_enabled_p || code_cache_enabled_p))
+	dcache_update (target_dcache, offset, (void *) writebuf, retval);
     }
 
   if (targetdebug)
@@ -1835,6 +2017,23 @@ target_read_stack (CORE_ADDR memaddr, gdb_byte *myaddr, ssize_t len)
     return TARGET_XFER_E_IO;
 }
 
+/* Like target_read_memory, but specify explicitly that this is a read from
+   the target's code.  This may trigger different cache behavior.  */
+
+int
+target_read_code (CORE_ADDR memaddr, gdb_byte *myaddr, ssize_t len)
+{
+  /* Dispatch to the topmost target, not the flattened current_target.
+     Memory accesses check target->to_has_(all_)memory, and the
+     flattened target doesn't inherit those.  */
+
+  if (target_read (current_target.beneath, TARGET_OBJECT_CODE_MEMORY, NULL,
+		   myaddr, memaddr, len) == len)
+    return 0;
+  else
+    return TARGET_XFER_E_IO;
+}
+
 /* Write LEN bytes from MYADDR to target memory at address MEMADDR.
    Returns either 0 for success or a target_xfer_error value if any
    error occurs.  If an error occurs, no guarantee is made about how
@@ -2280,6 +2479,97 @@ read_memory_robust (struct target_ops *ops, ULONGEST offset, LONGEST len)
   return result;
 }
 
+/* Ranges passed to target_read_multi which are at most this many
+   bytes apart are read together, bytes in between included.  */
+
+#define READ_MULTI_MAX_GAP 64
+
+/* The most bytes target_read_multi reads with one transfer.  */
+
+#define READ_MULTI_MAX_LEN 65536
+
+/* qsort comparison function for pointers to struct memory_read_range,
+   ordering them by address.  */
+
+static int
+compare_memory_read_range_ptrs (const void *ap, const void *bp)
+{
+  const struct memory_read_range *a
+    = *(const struct memory_read_range * const *) ap;
+  const struct memory_read_range *b
+    = *(const struct memory_read_range * const *) bp;
+
+  if (a->offset < b->offset)
+    return -1;
+  if (a->offset > b->offset)
+    return 1;
+  return 0;
+}
+
+/* See target.h.  */
+
+void
+target_read_multi (struct target_ops *ops, enum target_object object,
+		   struct memory_read_range *ranges, int count)
+{
+  struct memory_read_range **sorted;
+  struct cleanup *cleanups;
+  gdb_byte *buf = NULL;
+  int i, j, k;
+
+  sorted = xmalloc (count * sizeof (*sorted));
+  cleanups = make_cleanup (xfree, sorted);
+  for (i = 0; i < count; i++)
+    {
+      sorted[i] = &ranges[i];
+      sorted[i]->ok = 0;
+    }
+  qsort (sorted, count, sizeof (*sorted), compare_memory_read_range_ptrs);
+
+  make_cleanup (free_current_contents, &buf);
+  buf = xmalloc (READ_MULTI_MAX_LEN);
+
+  for (i = 0; i < count; i = j)
+    {
+      ULONGEST start = sorted[i]->offset;
+      ULONGEST end = start + sorted[i]->len;
+
+      /* Gather the following ranges close enough to read with this
+	 one.  */
+      for (j = i + 1; j < count; j++)
+	{
+	  ULONGEST next_end = sorted[j]->offset + sorted[j]->len;
+
+	  if (sorted[j]->offset > end + READ_MULTI_MAX_GAP
+	      || max (end, next_end) - start > READ_MULTI_MAX_LEN)
+	    break;
+	  end = max (end, next_end);
+	}
+
+      if (j - i > 1
+	  && target_read (ops, object, NULL, buf, start, end - start)
+	     == end - start)
+	{
+	  for (k = i; k < j; k++)
+	    {
+	      memcpy (sorted[k]->buf, buf + (sorted[k]->offset - start),
+		      sorted[k]->len);
+	      sorted[k]->ok = 1;
+	    }
+	  continue;
+	}
+
+      /* Read the ranges one by one; some of them, or the bytes in
+	 between, may not be readable.  */
+      for (k = i; k < j; k++)
+	sorted[k]->ok = (target_read (ops, object, NULL, sorted[k]->buf,
+				      sorted[k]->offset, sorted[k]->len)
+			 == sorted[k]->len);
+    }
+
+  do_cleanups (cleanups);
+}
+
 
 /* An alternative to target_write with progress callbacks.  */
 
@@ -2890,45 +3180,152 @@ target_read_description (struct target_ops *target)
   return NULL;
 }
 
-/* The default implementation of to_search_memory.
-   This implements a basic search of memory, reading target memory and
-   performing the search here (as opposed to performing the search in on the
-   target side with, for example, gdbserver).  */
+/* How many bytes of target memory simple_search_memory reads at a
+   time.  NOTE: also defined in find.c testcase.  */
+#define SEARCH_CHUNK_SIZE (1024 * 1024)
 
-int
-simple_search_memory (struct target_ops *ops,
-		      CORE_ADDR start_addr, ULONGEST search_space_len,
-		      const gdb_byte *pattern, ULONGEST pattern_len,
-		      CORE_ADDR *found_addrp)
+/* A readable region of target memory, [START, END).  */
+
+struct search_region
 {
-  /* NOTE: also defined in find.c testcase.  */
-#define SEARCH_CHUNK_SIZE 16000
-  const unsigned chunk_size = SEARCH_CHUNK_SIZE;
-  /* Buffer to hold memory contents for searching.  */
-  gdb_byte *search_buf;
-  unsigned search_buf_size;
-  struct cleanup *old_cleanups;
+  CORE_ADDR start;
+  CORE_ADDR end;
+};
 
-  search_buf_size = chunk_size + pattern_len - 1;
+/* The readable regions of target memory, as collected by
+   collect_search_region.  */
 
-  /* No point in trying to allocate a buffer larger than the search space.  */
-  if (search_space_len < search_buf_size)
-    search_buf_size = search_space_len;
+struct search_regions
+{
+  struct search_region *regions;
+  int count;
+  int size;
+};
 
-  search_buf = malloc (search_buf_size);
-  if (search_buf == NULL)
-    error (_("Unable to allocate memory to perform the search."));
-  old_cleanups = make_cleanup (free_current_contents, &search_buf);
+/* A find_memory_region_ftype callback recording the readable regions
+   in DATA, a struct search_regions.  */
+
+static int
+collect_search_region (CORE_ADDR addr, unsigned long size,
+		       int read, int write, int exec, int modified,
+		       void *data)
+{
+  struct search_regions *r = data;
+
+  if (!read || size == 0)
+    return 0;
+
+  if (r->count == r->size)
+    {
+      r->size = r->size == 0 ? 16 : 2 * r->size;
+      r->regions = xrealloc (r->regions,
+			     r->size * sizeof (struct search_region));
+    }
+
+  r->regions[r->count].start = addr;
+  r->regions[r->count].end = addr + size;
+  r->count++;
+  return 0;
+}
+
+/* qsort comparison function for struct search_region.  */
+
+static int
+compare_search_regions (const void *ap, const void *bp)
+{
+  const struct search_region *a = ap;
+  const struct search_region *b = bp;
+
+  if (a->start != b->start)
+    return a->start < b->start ? -1 : 1;
+  return 0;
+}
+
+/* Find the readable regions of the memory of the live process being
+   debugged, sorted by address, with the contiguous ones merged since a
+   pattern may straddle them.  Return 0 if the target can't tell.  */
+
+static int
+find_search_regions (struct search_regions *r)
+{
+  volatile struct gdb_exception ex;
+  int found = 0;
+  int i, n;
+
+  r->regions = NULL;
+  r->count = 0;
+  r->size = 0;
+
+  if (!target_has_execution)
+    return 0;
+
+  /* Try gdbarch method first, then fall back to target method, as
+     gcore does.  */
+  TRY_CATCH (ex, RETURN_MASK_ERROR)
+    {
+      if (gdbarch_find_memory_regions_p (target_gdbarch ())
+	  && gdbarch_find_memory_regions (target_gdbarch (),
+					  collect_search_region, r) == 0)
+	found = 1;
+      else
+	{
+	  r->count = 0;
+	  found = target_find_memory_regions (collect_search_region, r) == 0;
+	}
+    }
+  if (ex.reason < 0 || !found)
+    {
+      xfree (r->regions);
+      r->regions = NULL;
+      r->count = 0;
+      return 0;
+    }
+
+  qsort (r->regions, r->count, sizeof (struct search_region),
+	 compare_search_regions);
+  for (i = 0, n = 0; i < r->count; i++)
+    {
+      if (n > 0 && r->regions[i].start <= r->regions[n - 1].end)
+	{
+	  if (r->regions[i].end > r->regions[n - 1].end)
+	    r->regions[n - 1].end = r->regions[i].end;
+	}
+      else
+	r->regions[n++] = r->regions[i];
+    }
+  r->count = n;
+
+  return 1;
+}
+
+/* Search SEARCH_SPACE_LEN bytes of target memory beginning at
+   START_ADDR for PATTERN, reading SEARCH_CHUNK_SIZE bytes at a time
+   into SEARCH_BUF, which holds MAX_BUF_SIZE bytes, at least
+   SEARCH_CHUNK_SIZE + PATTERN_LEN - 1 bytes if SEARCH_SPACE_LEN is
+   larger.  Return 1 and set *FOUND_ADDRP if found, or 0 if not.  If
+   a read fails, return -1, and set *READ_ADDRP and *READ_LENP to the
+   failed read and *RESUME_ADDRP to the address from which the search
+   did not complete.  */
+
+static int
+search_memory_chunks (struct target_ops *ops,
+		      CORE_ADDR start_addr, ULONGEST search_space_len,
+		      const gdb_byte *pattern, ULONGEST pattern_len,
+		      gdb_byte *search_buf, unsigned max_buf_size,
+		      CORE_ADDR *found_addrp, CORE_ADDR *resume_addrp,
+		      CORE_ADDR *read_addrp, ULONGEST *read_lenp)
+{
+  const unsigned chunk_size = SEARCH_CHUNK_SIZE;
+  unsigned search_buf_size = min (search_space_len, max_buf_size);
 
   /* Prime the search buffer.  */
 
   if (target_read (ops, TARGET_OBJECT_MEMORY, NULL,
 		   search_buf, start_addr, search_buf_size) != search_buf_size)
     {
-      warning (_("Unable to access %s bytes of target "
-		 "memory at %s, halting search."),
-	       pulongest (search_buf_size), hex_string (start_addr));
-      do_cleanups (old_cleanups);
+      *resume_addrp = start_addr;
+      *read_addrp = start_addr;
+      *read_lenp = search_buf_size;
       return -1;
     }
 
@@ -2948,10 +3345,7 @@ simple_search_memory (struct target_ops *ops,
 
       if (found_ptr != NULL)
 	{
-	  CORE_ADDR found_addr = start_addr + (found_ptr - search_buf);
-
-	  *found_addrp = found_addr;
-	  do_cleanups (old_cleanups);
+	  *found_addrp = start_addr + (found_ptr - search_buf);
 	  return 1;
 	}
 
@@ -2980,11 +3374,9 @@ simple_search_memory (struct target_ops *ops,
 			   search_buf + keep_len, read_addr,
 			   nr_to_read) != nr_to_read)
 	    {
-	      warning (_("Unable to access %s bytes of target "
-			 "memory at %s, halting search."),
-		       plongest (nr_to_read),
-		       hex_string (read_addr));
-	      do_cleanups (old_cleanups);
+	      *resume_addrp = start_addr + chunk_size;
+	      *read_addrp = read_addr;
+	      *read_lenp = nr_to_read;
 	      return -1;
 	    }
 
@@ -2994,10 +3386,89 @@ simple_search_memory (struct target_ops *ops,
 
   /* Not found.  */
 
-  do_cleanups (old_cleanups);
   return 0;
 }
 
+/* The default implementation of to_search_memory.
+   This implements a basic search of memory, reading target memory and
+   performing the search here (as opposed to performing the search in on the
+   target side with, for example, gdbserver).
+
+   If some memory can't be read and the target lists the mapped regions
+   of the process, as from /proc/PID/maps on GNU/Linux, the unmapped
+   gaps are skipped.  */
+
+int
+simple_search_memory (struct target_ops *ops,
+		      CORE_ADDR start_addr, ULONGEST search_space_len,
+		      const gdb_byte *pattern, ULONGEST pattern_len,
+		      CORE_ADDR *found_addrp)
+{
+  /* Buffer to hold memory contents for searching.  */
+  gdb_byte *search_buf;
+  unsigned search_buf_size;
+  struct cleanup *old_cleanups;
+  CORE_ADDR resume_addr, read_addr, end_addr;
+  ULONGEST read_len;
+  int res;
+
+  search_buf_size = SEARCH_CHUNK_SIZE + pattern_len - 1;
+
+  /* No point in trying to allocate a buffer larger than the search space.  */
+  if (search_space_len < search_buf_size)
+    search_buf_size = search_space_len;
+
+  search_buf = malloc (search_buf_size);
+  if (search_buf == NULL)
+    error (_("Unable to allocate memory to perform the search."));
+  old_cleanups = make_cleanup (free_current_contents, &search_buf);
+
+  res = search_memory_chunks (ops, start_addr, search_space_len,
+			      pattern, pattern_len,
+			      search_buf, search_buf_size, found_addrp,
+			      &resume_addr, &read_addr, &read_len);
+
+  if (res < 0)
+    {
+      struct search_regions regions;
+      int i;
+
+      end_addr = start_addr + search_space_len;
+      if (end_addr < start_addr)
+	end_addr = (CORE_ADDR) -1;
+
+      /* Search the rest of the readable regions only.  */
+      if (find_search_regions (&regions))
+	{
+	  make_cleanup (xfree, regions.regions);
+
+	  res = 0;
+	  for (i = 0; i < regions.count && res == 0; i++)
+	    {
+	      CORE_ADDR lo = max (regions.regions[i].start, resume_addr);
+	      CORE_ADDR hi = min (regions.regions[i].end, end_addr);
+
+	      if (hi <= lo || hi - lo < pattern_len)
+		continue;
+
+	      res = search_memory_chunks (ops, lo, hi - lo,
+					  pattern, pattern_len,
+					  search_buf, search_buf_size,
+					  found_addrp, &resume_addr,
+					  &read_addr, &read_len);
+	    }
+	}
+
+      if (res < 0)
+	warning (_("Unable to access %s bytes of target "
+		   "memory at %s, halting search."),
+		 pulongest (read_len), hex_string (read_addr));
+    }
+
+  do_cleanups (old_cleanups);
+  return res;
+}
+
 /* Search SEARCH_SPACE_LEN bytes beginning at START_ADDR for the
    sequence of bytes in PATTERN with length PATTERN_LEN.
 
@@ -5101,16 +5572,18 @@ command."),
 			     show_targetdebug,
 			     &setdebuglist, &showdebuglist);
 
-  add_setshow_boolean_cmd ("trust-readonly-sections", class_support,
-			   &trust_readonly, _("\
+  add_setshow_auto_boolean_cmd ("trust-readonly-sections", class_support,
+				&trust_readonly, _("\
 Set mode for reading from readonly sections."), _("\
 Show mode for reading from readonly sections."), _("\
 When this mode is on, memory reads from readonly sections (such as .text)\n\
 will be read from the object file instead of from the target.  This will\n\
-result in significant performance improvement for remote targets."),
-			   NULL,
-			   show_trust_readonly,
-			   &setlist, &showlist);
+result in significant performance improvement for remote targets.\n\
+When auto, this is done for the sections the target confirms to hold\n\
+the object file's contents, if the target can check that."),
+				NULL,
+				show_trust_readonly,
+				&setlist, &showlist);
 
   add_com ("monitor", class_obscure, do_monitor_command,
 	   _("Send a command to the remote monitor (remote targets only)."));
@@ -5140,6 +5613,17 @@ By default, caching for stack access is on."),
 			   show_stack_cache_enabled_p,
 			   &setlist, &showlist);
 
+  add_setshow_boolean_cmd ("code-cache", class_support,
+			   &code_cache_enabled_p_1, _("\
+Set cache use for code segment access."), _("\
+Show cache use for code segment access."), _("\
+When on, use the data cache for all code segment access, regardless\n\
+of any configured memory regions.  This improves remote performance\n\
+significantly.  By default, caching for code segment access is on."),
+			   set_code_cache_enabled_p,
+			   show_code_cache_enabled_p,
+			   &setlist, &showlist);
+
   add_setshow_boolean_cmd ("may-write-registers", class_support,
 			   &may_write_registers_1, _("\
 Set permission to write into registers."), _("\
@@ -5194,6 +5678,8 @@ Otherwise, any attempt to interrupt or stop will be ignored."),
 			   set_target_permissions, NULL,
 			   &setlist, &showlist);
 
+  observer_attach_inferior_created (target_inferior_created);
+  observer_attach_normal_stop (target_normal_stop);
 
   target_dcache = dcache_init ();
 }
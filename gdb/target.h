@@ -144,6 +144,9 @@ enum target_object
      if it is not in a region marked as such, since it is known to be
      "normal" RAM.  */
   TARGET_OBJECT_STACK_MEMORY,
+  /* Memory known to be part of the target code.   This is cached even
+     if it is not in a region marked as such.  */
+  TARGET_OBJECT_CODE_MEMORY,
   /* Kernel Unwind Table.  See "ia64-tdep.c".  */
   TARGET_OBJECT_UNWIND_TABLE,
   /* Transfer auxilliary vector.  */
@@ -195,7 +198,11 @@ enum target_object
   /* OpenVMS Unwind Information Block.  */
   TARGET_OBJECT_OPENVMS_UIB,
   /* Branch trace data, in XML format.  */
-  TARGET_OBJECT_BTRACE
+  TARGET_OBJECT_BTRACE,
+  /* A digest identifying the contents of a TARGET_OBJECT_AVAILABLE_FEATURES
+     document and everything it includes, as a string of hex digits.
+     ANNEX names the document, as for TARGET_OBJECT_AVAILABLE_FEATURES.  */
+  TARGET_OBJECT_AVAILABLE_FEATURES_HASH
   /* Possible future objects: TARGET_OBJECT_FILE, ...  */
 };
 
@@ -268,6 +275,29 @@ extern void free_memory_read_result_vector (void *);
 extern VEC(memory_read_result_s)* read_memory_robust (struct target_ops *ops,
 						      ULONGEST offset,
 						      LONGEST len);
+
+/* One of the ranges read by target_read_multi.  */
+
+struct memory_read_range
+  {
+    /* The address and length of the range.  */
+    ULONGEST offset;
+    LONGEST len;
+    /* Where to store its contents.  */
+    gdb_byte *buf;
+    /* Set to nonzero if the whole range could be read.  */
+    int ok;
+  };
+
+/* Read the COUNT independent RANGES of OPS's OBJECT, like target_read
+   would read each of them.  Ranges which lie close together are read
+   with one transfer, falling back to reading them separately if that
+   fails, which saves round trips on targets where transfers are
+   costly.  */
+
+extern void target_read_multi (struct target_ops *ops,
+			       enum target_object object,
+			       struct memory_read_range *ranges, int count);
   
 extern LONGEST target_write (struct target_ops *ops,
 			     enum target_object object,
@@ -1030,6 +1060,10 @@ int target_supports_disable_randomization (void);
 #define target_supports_string_tracing() \
   (*current_target.to_supports_string_tracing) ()
 
+/* Non-zero if the user lets targets step a range of addresses
+   without reporting each step; see "set range-stepping".  */
+extern int use_range_stepping;
+
 /* Returns true if this target can handle breakpoint conditions
    on its end.  */
 
@@ -1045,6 +1079,11 @@ int target_supports_disable_randomization (void);
 /* Invalidate all target dcaches.  */
 extern void target_dcache_invalidate (void);
 
+/* Store stack memory the target sent along with a stop reply in the
+   target dcache.  */
+extern void target_dcache_fill (ptid_t ptid, CORE_ADDR memaddr,
+				const gdb_byte *myaddr, int len);
+
 extern int target_read_string (CORE_ADDR, char **, int, int *);
 
 extern int target_read_memory (CORE_ADDR memaddr, gdb_byte *myaddr,
@@ -1052,6 +1091,8 @@ extern int target_read_memory (CORE_ADDR memaddr, gdb_byte *myaddr,
 
 extern int target_read_stack (CORE_ADDR memaddr, gdb_byte *myaddr, ssize_t len);
 
+extern int target_read_code (CORE_ADDR memaddr, gdb_byte *myaddr, ssize_t len);
+
 extern int target_write_memory (CORE_ADDR memaddr, const gdb_byte *myaddr,
 				ssize_t len);
 
@@ -1836,6 +1877,11 @@ struct target_section
 
     struct bfd_section *the_bfd_section;
 
+    /* Whether the target's memory holds the section's contents, as
+       checked for "set trust-readonly-sections auto": zero if not
+       checked yet, positive if it does, negative if it doesn't.  */
+    int verified;
+
     /* The "owner" of the section.
        It can be any unique value.  It is set by add_target_sections
        and used by remove_target_sections.
@@ -21,11 +21,12 @@
 #include <unistd.h>
 #include <string.h>
 
-#define CHUNK_SIZE 16000 /* same as findcmd.c's */
+#define CHUNK_SIZE 1048576 /* same as target.c's */
 
 void *global_var_0;
 void *global_var_1;
 void *global_var_2;
+void *global_var_3;
 
 void
 breakpt ()
@@ -40,20 +41,24 @@ main (void)
   size_t pg_size;
   int pg_count;
   void *unmapped_page, *last_mapped_page, *first_mapped_page;
+  void *after_unmapped_page;
 
   /*
-    Map enough pages to cover at least CHUNK_SIZE, and one extra page.  We
-    then unmap the last page.
+    Map enough pages to cover at least CHUNK_SIZE, and two extra pages.
+    We then unmap the second to last page, and put a 0xff byte in the
+    last page.
 
     From gdb we can then perform find commands into unmapped region, gdb
-    should give an error.
+    should give an error, or skip the unmapped page if it knows the
+    mappings of the process.
 
     .-- global_var_0  .-- global_var_1
     |                 |   .-- global_var_2
-    |                 |   |
-    .----.----.----.----.----.
-    |    |    |    |    |    |
-    '----'----'----'----'----'
+    |                 |   |    .-- global_var_3
+    |                 |   |    |
+    .----.----.----.----.----.----.
+    |    |    |    |    |    |    |
+    '----'----'----'----'----'----'
     |<- CHUNK_SIZE ->|
 
     If CHUNK_SIZE equals page size then we'll get 3 pages, and if
@@ -69,11 +74,14 @@ main (void)
 
     (3) We do a find from global_var_2 to (global_var_2 + 16), this too
     will fail when loading the first chunk regardless of the chunk size.
+
+    (4) We do a find from global_var_0 to (global_var_3 + 16), this finds
+    the 0xff byte if the unmapped page is skipped.
   */
 
   pg_size = getpagesize ();
-  /* The +2 ensures the extra page.  */
-  pg_count = CHUNK_SIZE / pg_size + 2;
+  /* The +3 ensures the two extra pages.  */
+  pg_count = CHUNK_SIZE / pg_size + 3;
 
   p = mmap (0, pg_count * pg_size, PROT_READ|PROT_WRITE,
 	    MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
@@ -85,20 +93,23 @@ main (void)
 
   memset (p, 0, pg_count * pg_size);
 
-  if (munmap (p + (pg_count - 1) * pg_size, pg_size) == -1)
+  if (munmap (p + (pg_count - 2) * pg_size, pg_size) == -1)
     {
       perror ("munmap");
       return EXIT_FAILURE;
     }
 
   first_mapped_page = p;
-  last_mapped_page = p + (pg_count - 2) * pg_size;
+  last_mapped_page = p + (pg_count - 3) * pg_size;
   unmapped_page = last_mapped_page + pg_size;
+  after_unmapped_page = unmapped_page + pg_size;
+  *((unsigned char *) after_unmapped_page + 8) = 0xff;
 
   /* Setup global variables we reference from gdb.  */
   global_var_0 = first_mapped_page;
   global_var_1 = unmapped_page - 16;
   global_var_2 = unmapped_page + 16;
+  global_var_3 = after_unmapped_page;
 
   breakpt ();
 
@@ -0,0 +1,99 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright (C) 2013 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#ifndef THREAD_COUNT
+#define THREAD_COUNT 1000
+#endif
+
+#ifndef INLINE_DEPTH
+#define INLINE_DEPTH 32
+#endif
+
+/* Defined in the sources generated by large-program.exp.  It calls
+   into every generated CU and shared library.  */
+extern int call_all (int);
+
+static pthread_barrier_t barrier;
+
+/* The threads sit here, under INLINE_DEPTH inlined frames, for GDB
+   to backtrace.  */
+
+static void __attribute__ ((noinline))
+idle (void)
+{
+  while (1)
+    sleep (1000);
+}
+
+template<int N>
+static inline __attribute__ ((always_inline)) void
+inline_stack (int arg)
+{
+  volatile int depth = N;
+
+  inline_stack<N - 1> (arg + depth);
+}
+
+template<>
+inline __attribute__ ((always_inline)) void
+inline_stack<0> (int arg)
+{
+  volatile int local = arg;
+
+  pthread_barrier_wait (&barrier);
+  idle ();
+}
+
+static void *
+thread_function (void *arg)
+{
+  inline_stack<INLINE_DEPTH> ((int) (long) arg);
+  return NULL;
+}
+
+/* Called once all the threads are waiting in idle.  */
+
+void
+all_threads_started (void)
+{
+}
+
+int
+main (void)
+{
+  pthread_t threads[THREAD_COUNT];
+  pthread_attr_t attr;
+  int i;
+
+  call_all (0);
+
+  /* Keep the address space of a thousand threads small.  */
+  pthread_attr_init (&attr);
+  pthread_attr_setstacksize (&attr, 128 * 1024);
+
+  pthread_barrier_init (&barrier, NULL, THREAD_COUNT + 1);
+  for (i = 0; i < THREAD_COUNT; i++)
+    pthread_create (&threads[i], &attr, thread_function, (void *) (long) i);
+  pthread_barrier_wait (&barrier);
+
+  all_threads_started ();
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+# Copyright (C) 2013 Free Software Foundation, Inc.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# These test cases measure the speed of the symbol readers and of the
+# unwinder on the large program generated by large-program.exp.  The
+# VARIANT of each test case is appended to its name, so that the
+# results of the programs built with different options can be told
+# apart.
+
+from perftest import perftest
+
+class LargeProgramSymbolFile(perftest.TestCaseWithBasicMeasurements):
+    """Measure "file" on the executable, before it runs."""
+
+    def __init__(self, variant, binfile):
+        super (LargeProgramSymbolFile, self).__init__ ("large_program_symbol_file" + variant)
+        self.binfile = binfile
+
+    def warm_up(self):
+        gdb.execute ("set confirm off")
+
+    def execute_test(self):
+        for i in range (3):
+            gdb.execute ("symbol-file", to_string=True)
+            func = lambda: gdb.execute ("file %s" % self.binfile, to_string=True)
+            self.measure.measure (func, i)
+
+class LargeProgramSharedLibrary(perftest.TestCaseWithBasicMeasurements):
+    """Measure reading the symbols of the shared libraries."""
+
+    def __init__(self, variant, solib_count):
+        super (LargeProgramSharedLibrary, self).__init__ ("large_program_sharedlibrary" + variant)
+        self.solib_count = solib_count
+
+    def execute_test(self):
+        gdb.execute ("nosharedlibrary")
+        func = lambda: gdb.execute ("sharedlibrary", to_string=True)
+        self.measure.measure (func, self.solib_count)
+
+class LargeProgramBreak(perftest.TestCaseWithBasicMeasurements):
+    """Measure "break" on each of NAMES."""
+
+    def __init__(self, variant, names):
+        super (LargeProgramBreak, self).__init__ ("large_program_break" + variant)
+        self.names = names
+
+    def execute_test(self):
+        for name in self.names:
+            func = lambda: gdb.execute ("break %s" % name, to_string=True)
+            self.measure.measure (func, name)
+            gdb.execute ("delete")
+
+class LargeProgramBacktraceFull(perftest.TestCaseWithBasicMeasurements):
+    """Measure "bt full" in the first N threads, for each N of THREAD_COUNTS."""
+
+    def __init__(self, variant, thread_counts):
+        super (LargeProgramBacktraceFull, self).__init__ ("large_program_bt_full" + variant)
+        self.thread_counts = thread_counts
+
+    def warm_up(self):
+        # Make sure GDB knows about all the threads.
+        gdb.execute ("info threads", to_string=True)
+
+    def execute_test(self):
+        for count in self.thread_counts:
+            # Don't let the frames unwound by the previous run be
+            # reused.
+            gdb.execute ("flushregs", to_string=True)
+            command = "thread apply 1-%d bt full" % count
+            func = lambda: gdb.execute (command, to_string=True)
+            self.measure.measure (func, count)
+
+class LargeProgramPtype(perftest.TestCaseWithBasicMeasurements):
+    """Measure "ptype" of each of TYPES."""
+
+    def __init__(self, variant, types):
+        super (LargeProgramPtype, self).__init__ ("large_program_ptype" + variant)
+        self.types = types
+
+    def execute_test(self):
+        for type in self.types:
+            func = lambda: gdb.execute ("ptype %s" % type, to_string=True)
+            self.measure.measure (func, type)
+
+class LargeProgramComplete(perftest.TestCaseWithBasicMeasurements):
+    """Measure the completion of each of LINES, as TAB would do it."""
+
+    def __init__(self, variant, lines):
+        super (LargeProgramComplete, self).__init__ ("large_program_complete" + variant)
+        self.lines = lines
+
+    def execute_test(self):
+        for line in self.lines:
+            func = lambda: gdb.execute ("complete %s" % line, to_string=True)
+            self.measure.measure (func, line)
@@ -0,0 +1,68 @@
+# Copyright (C) 2013 Free Software Foundation, Inc.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Relay the remote protocol between GDB, on the standard input and
+# output, and a gdbserver listening on HOST:PORT, holding each chunk
+# of data from gdbserver for MSECS milliseconds.  This models a link
+# whose round trip takes that long, as "gdbreplay --delay" does.  Use
+# it as:
+#
+#   (gdb) target remote | python delay-proxy.py MSECS HOST:PORT
+
+import os
+import select
+import socket
+import sys
+import time
+
+def write_all(fd, data):
+    while data:
+        written = os.write (fd, data)
+        data = data[written:]
+
+def main():
+    if len (sys.argv) != 3:
+        sys.stderr.write ("Usage: delay-proxy.py MSECS HOST:PORT\n")
+        sys.exit (1)
+
+    delay = float (sys.argv[1]) / 1000
+    host, port = sys.argv[2].rsplit (":", 1)
+    if host == "":
+        host = "localhost"
+
+    sock = socket.create_connection ((host, int (port)))
+    sock.setsockopt (socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    stdin = sys.stdin.fileno ()
+    stdout = sys.stdout.fileno ()
+
+    while True:
+        readable = select.select ([stdin, sock], [], [])[0]
+        if stdin in readable:
+            data = os.read (stdin, 65536)
+            if not data:
+                break
+            sock.sendall (data)
+        if sock in readable:
+            data = sock.recv (65536)
+            if not data:
+                break
+            if delay > 0:
+                time.sleep (delay)
+            write_all (stdout, data)
+
+    sock.close ()
+
+if __name__ == "__main__":
+    main ()
@@ -44,21 +44,42 @@ class Reporter(object):
         raise NotImplementedError("Abstract Method:end.")
 
 class TextReporter(Reporter):
-    """Report results in a plain text file 'perftest.log'."""
+    """Report results in plain text files 'perftest.log' and 'perftest.sum'.
+
+    Each result is written to 'perftest.log' as it is.  It is also
+    written to 'perftest.sum' as a line of four fields, "TEST
+    MEASUREMENT PARAMETER VALUE", none of which contains white space,
+    so that the results of two runs can be compared by a script.
+    """
 
     def __init__(self, append):
         super (TextReporter, self).__init__(Reporter(append))
         self.txt_log = None
+        self.txt_sum = None
+
+    def _sum_field(self, value):
+        if isinstance(value, float):
+            return "%.6f" % value
+        return '_'.join(str(value).split())
 
     def report(self, *args):
         self.txt_log.write(' '.join(str(arg) for arg in args))
         self.txt_log.write('\n')
 
+        # ARGS is (TEST MEASUREMENT, PARAMETER, VALUE).
+        fields = str(args[0]).split(None, 1)
+        fields.extend(self._sum_field(arg) for arg in args[1:])
+        self.txt_sum.write(' '.join(fields))
+        self.txt_sum.write('\n')
+
     def start(self):
         if self.append:
             self.txt_log = open ("perftest.log", 'a+');
+            self.txt_sum = open ("perftest.sum", 'a+');
         else:
             self.txt_log = open ("perftest.log", 'w');
+            self.txt_sum = open ("perftest.sum", 'w');
 
     def end(self):
         self.txt_log.close ()
+        self.txt_sum.close ()
@@ -0,0 +1,95 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright (C) 2013 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#ifndef THREAD_COUNT
+#define THREAD_COUNT 16
+#endif
+
+#define BUFFER_SIZE (1024 * 1024)
+
+/* Memory to read from GDB.  */
+unsigned char buffer[BUFFER_SIZE];
+
+/* The number of calls to marker between two calls to batch_done.  GDB
+   changes it.  */
+volatile int batch_size = 1;
+
+volatile int counter;
+
+static pthread_barrier_t barrier;
+
+/* Where the breakpoints and tracepoints hit.  */
+
+void
+marker (void)
+{
+  counter++;
+}
+
+/* Called after each batch of BATCH_SIZE calls to marker.  */
+
+void
+batch_done (void)
+{
+}
+
+/* The extra threads just sit there, for GDB to backtrace.  */
+
+static void
+idle (void)
+{
+  while (1)
+    sleep (1000);
+}
+
+static void *
+thread_function (void *arg)
+{
+  pthread_barrier_wait (&barrier);
+  idle ();
+  return NULL;
+}
+
+int
+main (void)
+{
+  pthread_t threads[THREAD_COUNT];
+  int i;
+
+  for (i = 0; i < BUFFER_SIZE; i++)
+    buffer[i] = i;
+
+  pthread_barrier_init (&barrier, NULL, THREAD_COUNT + 1);
+  for (i = 0; i < THREAD_COUNT; i++)
+    pthread_create (&threads[i], NULL, thread_function, NULL);
+  pthread_barrier_wait (&barrier);
+
+  /* All threads started.  */
+  batch_done ();
+
+  while (1)
+    {
+      for (i = 0; i < batch_size; i++)
+	marker ();
+      batch_done ();
+    }
+
+  return 0;
+}
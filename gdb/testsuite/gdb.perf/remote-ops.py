@@ -0,0 +1,100 @@
+# Copyright (C) 2013 Free Software Foundation, Inc.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# These test cases measure the speed of the operations that talk to
+# the target the most: hitting breakpoints, stepping, backtracing all
+# threads, reading memory and collecting tracepoints.  The inferior is
+# expected to be stopped in batch_done.
+
+from perftest import perftest
+
+class RemoteBreakpointHits(perftest.TestCaseWithBasicMeasurements):
+    def __init__(self, hit_counts):
+        super (RemoteBreakpointHits, self).__init__ ("remote_breakpoint_hits")
+        self.hit_counts = hit_counts
+
+    def execute_test(self):
+        bp = gdb.Breakpoint ("marker")
+        for count in self.hit_counts:
+            # Stop after COUNT hits, reporting all of them to GDB.
+            bp.ignore_count = count - 1
+            func = lambda: gdb.execute ("continue", to_string=True)
+            self.measure.measure (func, count)
+        bp.delete ()
+
+class RemoteStepping(perftest.TestCaseWithBasicMeasurements):
+    def __init__(self, command, step_counts):
+        super (RemoteStepping, self).__init__ ("remote_" + command)
+        self.command = command
+        self.step_counts = step_counts
+
+    def warm_up(self):
+        gdb.execute (self.command, to_string=True)
+
+    def execute_test(self):
+        for count in self.step_counts:
+            command = "%s %d" % (self.command, count)
+            func = lambda: gdb.execute (command, to_string=True)
+            self.measure.measure (func, count)
+
+class RemoteBacktraceAllThreads(perftest.TestCaseWithBasicMeasurements):
+    def __init__(self, thread_counts):
+        super (RemoteBacktraceAllThreads, self).__init__ ("remote_thread_apply_bt")
+        self.thread_counts = thread_counts
+
+    def warm_up(self):
+        # Make sure GDB knows about all the threads.
+        gdb.execute ("info threads", to_string=True)
+
+    def execute_test(self):
+        for count in self.thread_counts:
+            # Don't let the registers read by the previous run be
+            # reused.
+            gdb.execute ("flushregs", to_string=True)
+            command = "thread apply 1-%d bt" % count
+            func = lambda: gdb.execute (command, to_string=True)
+            self.measure.measure (func, count)
+
+class RemoteMemoryRead(perftest.TestCaseWithBasicMeasurements):
+    def __init__(self, sizes):
+        super (RemoteMemoryRead, self).__init__ ("remote_memory_read")
+        self.sizes = sizes
+
+    def execute_test(self):
+        inferior = gdb.selected_inferior ()
+        address = int (gdb.parse_and_eval ("&buffer"))
+        for size in self.sizes:
+            func = lambda: inferior.read_memory (address, size)
+            self.measure.measure (func, size)
+
+class RemoteTracepointCollection(perftest.TestCaseWithBasicMeasurements):
+    """Measure the collection of the tracepoints set in marker."""
+
+    def __init__(self, batch_sizes):
+        super (RemoteTracepointCollection, self).__init__ ("remote_tracepoint_collection")
+        self.batch_sizes = batch_sizes
+
+    def execute_test(self):
+        bp = gdb.Breakpoint ("batch_done")
+        for size in self.batch_sizes:
+            # Stopped in batch_done, so the next batch has SIZE calls
+            # to marker.
+            gdb.execute ("set var batch_size = %d" % size)
+            gdb.execute ("tstart")
+            func = lambda: gdb.execute ("continue", to_string=True)
+            self.measure.measure (func, size)
+            gdb.execute ("tstop")
+        gdb.execute ("set var batch_size = 1")
+        bp.delete ()
@@ -57,6 +57,15 @@ def new_objfile_handler (event):
     print ("event type: new_objfile")
     print ("new objfile name: %s" % (event.new_objfile.filename))
 
+def batch_handler (event):
+    assert (isinstance (event, gdb.BatchEvent))
+    print ("event type: batch")
+    objfiles = [e for e in event.events
+                if isinstance (e, gdb.NewObjFileEvent)]
+    print ("new objfiles in batch: %d" % (len (objfiles)))
+    if (isinstance (event.events[-1], gdb.StopEvent)):
+        print ("batch ends with stop")
+
 class test_events (gdb.Command):
     """Test events."""
 
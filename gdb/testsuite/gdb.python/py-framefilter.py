@@ -80,6 +80,38 @@ class FrameFilter ():
 
         return frame_iter
 
+class Batched_Function (FrameDecorator):
+
+    requested = None
+
+    def __init__(self, fobj):
+        super(Batched_Function, self).__init__(fobj)
+
+    def frame_fields (self, names):
+        Batched_Function.requested = names
+        fields = {}
+        for name in names:
+            fields[name] = getattr (self, name) ()
+        fields["function"] = "batched_" + str (self.function ())
+        return fields
+
+class BatchedFilter ():
+
+    def __init__ (self):
+        self.name = "Batched"
+        self.priority = 50
+        self.enabled = True
+        gdb.frame_filters [self.name] = self
+
+    def filter (self, frame_iter):
+        if hasattr(itertools, "imap"):
+            frame_iter = itertools.imap (Batched_Function,
+                                         frame_iter)
+        else:
+            frame_iter = map(Batched_Function, frame_iter)
+
+        return frame_iter
+
 class ElidingFrameDecorator(FrameDecorator):
 
     def __init__(self, frame, elided_frames):
@@ -45,6 +45,7 @@
 #include "gdb_regex.h"
 #include "cli/cli-utils.h"
 #include "continuations.h"
+#include "hashtab.h"
 
 /* Definition of struct thread_info exported to gdbthread.h.  */
 
@@ -57,6 +58,22 @@ void _initialize_thread (void);
 struct thread_info *thread_list = NULL;
 static int highest_thread_num;
 
+/* The thread last returned by find_thread_ptid, or NULL.  Most
+   lookups are for the current thread, and with thousands of threads,
+   as in big core files, walking the list each time makes commands
+   like "thread apply all" quadratic.  */
+static struct thread_info *last_found_thread;
+
+/* All threads in THREAD_LIST, indexed by ptid.  When several threads
+   share a ptid (exited threads that could not be deleted yet, whose
+   ids the OS reused), the table holds the newest one, which is the
+   one a walk of THREAD_LIST finds first.  */
+static htab_t thread_ptid_htab;
+
+/* The number of threads in THREAD_LIST shadowed in THREAD_PTID_HTAB
+   by a newer thread with the same ptid.  */
+static int num_shadowed_threads;
+
 static void thread_command (char *tidstr, int from_tty);
 static void thread_apply_all_command (char *, int);
 static int thread_alive (struct thread_info *);
@@ -136,9 +153,92 @@ clear_thread_inferior_resources (struct thread_info *tp)
   do_all_continuations_thread (tp, 1);
 }
 
+/* Hash function for a ptid.  */
+
+static hashval_t
+hash_ptid (ptid_t ptid)
+{
+  ULONGEST tid = ptid_get_tid (ptid);
+  hashval_t hash = ptid_get_pid (ptid);
+
+  hash = hash * 31 + ptid_get_lwp (ptid);
+  return hash * 31 + (hashval_t) (tid ^ (tid >> 32));
+}
+
+/* Hash function for an entry of THREAD_PTID_HTAB.  */
+
+static hashval_t
+hash_thread_ptid (const void *entry)
+{
+  const struct thread_info *tp = entry;
+
+  return hash_ptid (tp->ptid);
+}
+
+/* Equality function for THREAD_PTID_HTAB.  ENTRY is a thread, KEY a
+   pointer to a ptid.  */
+
+static int
+eq_thread_ptid (const void *entry, const void *key)
+{
+  const struct thread_info *tp = entry;
+  const ptid_t *ptid = key;
+
+  return ptid_equal (tp->ptid, *ptid);
+}
+
+/* Index TP, a thread just added to the front of THREAD_LIST or whose
+   ptid just changed, in THREAD_PTID_HTAB.  */
+
+static void
+thread_ptid_htab_insert (struct thread_info *tp)
+{
+  void **slot;
+
+  slot = htab_find_slot_with_hash (thread_ptid_htab, &tp->ptid,
+				   hash_ptid (tp->ptid), INSERT);
+  if (*slot != NULL)
+    num_shadowed_threads++;
+  *slot = tp;
+}
+
+/* Remove TP from THREAD_PTID_HTAB, before TP is freed or its ptid
+   changes.  If TP shadowed an older thread with the same ptid, index
+   that one instead.  */
+
+static void
+thread_ptid_htab_remove (struct thread_info *tp)
+{
+  struct thread_info *other;
+  void **slot;
+
+  slot = htab_find_slot_with_hash (thread_ptid_htab, &tp->ptid,
+				   hash_ptid (tp->ptid), NO_INSERT);
+  if (slot == NULL || *slot != tp)
+    {
+      /* TP itself was shadowed.  */
+      num_shadowed_threads--;
+      return;
+    }
+
+  if (num_shadowed_threads > 0)
+    for (other = thread_list; other != NULL; other = other->next)
+      if (other != tp && ptid_equal (other->ptid, tp->ptid))
+	{
+	  num_shadowed_threads--;
+	  *slot = other;
+	  return;
+	}
+
+  htab_clear_slot (thread_ptid_htab, slot);
+}
+
 static void
 free_thread (struct thread_info *tp)
 {
+  if (tp == last_found_thread)
+    last_found_thread = NULL;
+
   if (tp->private)
     {
       if (tp->private_dtor)
@@ -168,6 +268,8 @@ init_thread_list (void)
     }
 
   thread_list = NULL;
+  htab_empty (thread_ptid_htab);
+  num_shadowed_threads = 0;
 }
 
 /* Allocate a new thread with target id PTID and add it to the thread
@@ -185,6 +287,10 @@ new_thread (ptid_t ptid)
   tp->next = thread_list;
   thread_list = tp;
 
+  /* The new thread shadows any older one with the same ptid.  */
+  last_found_thread = NULL;
+  thread_ptid_htab_insert (tp);
+
   /* Nothing to follow yet.  */
   tp->pending_follow.kind = TARGET_WAITKIND_SPURIOUS;
   tp->state = THREAD_STOPPED;
@@ -223,7 +329,9 @@ add_thread_silent (ptid_t ptid)
 	  delete_thread (ptid);
 
 	  /* Now reset its ptid, and reswitch inferior_ptid to it.  */
+	  thread_ptid_htab_remove (tp);
 	  tp->ptid = ptid;
+	  thread_ptid_htab_insert (tp);
 	  tp->state = THREAD_STOPPED;
 	  switch_to_thread (ptid);
 
@@ -270,12 +378,7 @@ delete_thread_1 (ptid_t ptid, int silent)
 {
   struct thread_info *tp, *tpprev;
 
-  tpprev = NULL;
-
-  for (tp = thread_list; tp; tpprev = tp, tp = tp->next)
-    if (ptid_equal (tp->ptid, ptid))
-      break;
-
+  tp = find_thread_ptid (ptid);
   if (!tp)
     return;
 
@@ -308,6 +411,13 @@ delete_thread_1 (ptid_t ptid, int silent)
   tp->state = THREAD_EXITED;
   clear_thread_inferior_resources (tp);
 
+  thread_ptid_htab_remove (tp);
+
+  tpprev = NULL;
+  if (thread_list != tp)
+    for (tpprev = thread_list; tpprev->next != tp; tpprev = tpprev->next)
+      ;
+
   if (tpprev)
     tpprev->next = tp->next;
   else
@@ -350,11 +460,14 @@ find_thread_ptid (ptid_t ptid)
 {
   struct thread_info *tp;
 
-  for (tp = thread_list; tp; tp = tp->next)
-    if (ptid_equal (tp->ptid, ptid))
-      return tp;
+  if (last_found_thread != NULL && ptid_equal (last_found_thread->ptid, ptid))
+    return last_found_thread;
 
-  return NULL;
+  tp = htab_find_with_hash (thread_ptid_htab, &ptid, hash_ptid (ptid));
+  if (tp != NULL)
+    last_found_thread = tp;
+
+  return tp;
 }
 
 /*
@@ -414,11 +527,10 @@ valid_thread_id (int num)
 int
 pid_to_thread_id (ptid_t ptid)
 {
-  struct thread_info *tp;
+  struct thread_info *tp = find_thread_ptid (ptid);
 
-  for (tp = thread_list; tp; tp = tp->next)
-    if (ptid_equal (tp->ptid, ptid))
-      return tp->num;
+  if (tp != NULL)
+    return tp->num;
 
   return 0;
 }
@@ -437,11 +549,8 @@ thread_id_to_pid (int num)
 int
 in_thread_list (ptid_t ptid)
 {
-  struct thread_info *tp;
-
-  for (tp = thread_list; tp; tp = tp->next)
-    if (ptid_equal (tp->ptid, ptid))
-      return 1;
+  if (find_thread_ptid (ptid) != NULL)
+    return 1;
 
   return 0;			/* Never heard of 'im.  */
 }
@@ -574,7 +683,9 @@ thread_change_ptid (ptid_t old_ptid, ptid_t new_ptid)
   inf->pid = ptid_get_pid (new_ptid);
 
   tp = find_thread_ptid (old_ptid);
+  thread_ptid_htab_remove (tp);
   tp->ptid = new_ptid;
+  thread_ptid_htab_insert (tp);
 
   observer_notify_thread_ptid_changed (old_ptid, new_ptid);
 }
@@ -1489,8 +1600,12 @@ gdb_thread_select (struct ui_out *uiout, char *tidstr, char **error_message)
 void
 update_thread_list (void)
 {
+  struct infrun_phase_timer timer;
+
+  infrun_phase_begin (&timer, INFRUN_PHASE_THREAD_LIST);
   prune_threads ();
   target_find_new_threads ();
+  infrun_phase_end (&timer);
 }
 
 /* Return a new value for the selected thread's id.  Return a value of 0 if
@@ -1523,6 +1638,9 @@ _initialize_thread (void)
 {
   static struct cmd_list_element *thread_apply_list = NULL;
 
+  thread_ptid_htab = htab_create_alloc (13, hash_thread_ptid, eq_thread_ptid,
+					NULL, xcalloc, xfree);
+
   add_info ("threads", info_threads_command, 
 	    _("Display currently known threads.\n\
 Usage: info threads [ID]...\n\
@@ -23,6 +23,7 @@
 #include "cli/cli-script.h"
 #include "cli/cli-setshow.h"
 #include "cli/cli-decode.h"
+#include "cli/cli-utils.h"
 #include "symtab.h"
 #include "inferior.h"
 #include "exceptions.h"
@@ -414,7 +415,7 @@ execute_command (char *p, int from_tty)
   if (*p)
     {
       const char *cmd = p;
-      char *arg;
+      char *arg, *name;
       line = p;
 
       /* If trace-commands is set then this will print this command.  */
@@ -423,6 +424,12 @@ execute_command (char *p, int from_tty)
       c = lookup_cmd (&cmd, cmdlist, "", 0, 1);
       p = (char *) cmd;
 
+      /* Profile the command under the words that named it.  */
+      name = savestring (line, p - line);
+      *remove_trailing_whitespace (name, name + strlen (name)) = '\0';
+      make_profile_phase_cleanup ("command", name);
+      xfree (name);
+
       /* Pass null arg rather than an empty one.  */
       arg = *p ? p : 0;
 
@@ -855,10 +855,6 @@ validate_actionline (const char *line, struct breakpoint *b)
     error (_("`%s' is not a supported tracepoint action."), line);
 }
 
-enum {
-  memrange_absolute = -1
-};
-
 /* MEMRANGE functions: */
 
 static int memrange_cmp (const void *, const void *);
@@ -3038,6 +3034,7 @@ all_tracepoint_actions_and_cleanup (struct breakpoint *t)
       make_cleanup (xfree, default_collect_action);
       default_collect_action->next = actions;
       default_collect_action->line = default_collect_line;
+      default_collect_action->condition = NULL;
       actions = default_collect_action;
     }
 
@@ -3207,9 +3204,10 @@ tfile_write_status (struct trace_file_writer *self,
   if (ts->stop_reason == tracepoint_error
       || ts->stop_reason == tstop_command)
     {
-      char *buf = (char *) alloca (strlen (ts->stop_desc) * 2 + 1);
+      const char *desc = ts->stop_desc != NULL ? ts->stop_desc : "";
+      char *buf = (char *) alloca (strlen (desc) * 2 + 1);
 
-      bin2hex ((gdb_byte *) ts->stop_desc, buf, 0);
+      bin2hex ((gdb_byte *) desc, buf, 0);
       fprintf (writer->fp, ":%s", buf);
     }
   fprintf (writer->fp, ":%x", ts->stopping_tracepoint);
@@ -3406,6 +3404,63 @@ static const struct trace_file_write_ops tfile_write_ops =
 #define TRACE_WRITE_V_BLOCK(writer, num, val)	\
   writer->ops->frame_ops->write_v_block ((writer), (num), (val))
 
+/* How much of the trace buffer trace_save asks the target for at a
+   time.  The remote target may split this in several pipelined
+   requests.  */
+
+#define TRACE_SAVE_CHUNK_SIZE (256 * 1024)
+
+/* The part of the trace buffer that trace_save last got from the
+   target, so that the small reads of parsing the traceframes do not
+   each cost a request.  */
+
+struct trace_buffer_reader
+{
+  /* The data, TRACE_SAVE_CHUNK_SIZE bytes long.  */
+  gdb_byte *buf;
+
+  /* The offset in the trace buffer of the first byte of BUF, and the
+     number of bytes BUF holds.  */
+  ULONGEST offset;
+  LONGEST len;
+};
+
+/* Read LEN bytes of the trace buffer at OFFSET into BUF, through
+   READER.  Returns the number of bytes read, which is less than LEN
+   at the end of the trace buffer, or -1 on error.  */
+
+static LONGEST
+trace_buffer_read (struct trace_buffer_reader *reader, gdb_byte *buf,
+		   ULONGEST offset, LONGEST len)
+{
+  gdb_assert (len <= TRACE_SAVE_CHUNK_SIZE);
+
+  if (offset < reader->offset
+      || offset + len > reader->offset + reader->len)
+    {
+      reader->offset = offset;
+      reader->len = 0;
+      while (reader->len < len)
+	{
+	  LONGEST gotten;
+
+	  gotten = target_get_raw_trace_data (reader->buf + reader->len,
+					      offset + reader->len,
+					      (TRACE_SAVE_CHUNK_SIZE
+					       - reader->len));
+	  if (gotten < 0)
+	    return gotten;
+	  if (gotten == 0)
+	    break;
+	  reader->len += gotten;
+	}
+    }
+
+  len = min (len, reader->offset + reader->len - offset);
+  memcpy (buf, reader->buf + (offset - reader->offset), len);
+  return len;
+}
+
 /* Save tracepoint data to file named FILENAME through WRITER.  WRITER
    determines the trace file format.  If TARGET_DOES_SAVE is non-zero,
    the save is performed on the target, otherwise GDB obtains all trace
@@ -3425,6 +3480,8 @@ trace_save (const char *filename, struct trace_file_writer *writer,
 #define MAX_TRACE_UPLOAD 2000
   int written;
   enum bfd_endian byte_order = gdbarch_byte_order (target_gdbarch ());
+  struct trace_buffer_reader reader;
+  struct cleanup *old_chain;
 
   /* If the target is to save the data to a file on its own, then just
      send the command and be done with it.  */
@@ -3482,6 +3539,11 @@ trace_save (const char *filename, struct trace_file_writer *writer,
   /* Mark the end of the definition section.  */
   writer->ops->write_definition_end (writer);
 
+  reader.buf = xmalloc (TRACE_SAVE_CHUNK_SIZE);
+  reader.offset = 0;
+  reader.len = 0;
+  old_chain = make_cleanup (xfree, reader.buf);
+
   /* Get and write the trace data proper.  */
   while (1)
     {
@@ -3495,15 +3557,15 @@ trace_save (const char *filename, struct trace_file_writer *writer,
 	  /* We ask for big blocks, in the hopes of efficiency, but
 	     will take less if the target has packet size limitations
 	     or some such.  */
-	  gotten = target_get_raw_trace_data (buf, offset,
-					      MAX_TRACE_UPLOAD);
+	  gotten = target_get_raw_trace_data (reader.buf, offset,
+					      TRACE_SAVE_CHUNK_SIZE);
 	  if (gotten < 0)
 	    error (_("Failure to get requested trace buffer data"));
 	  /* No more data is forthcoming, we're done.  */
 	  if (gotten == 0)
 	    break;
 
-	  writer->ops->write_trace_buffer (writer, buf, gotten);
+	  writer->ops->write_trace_buffer (writer, reader.buf, gotten);
 
 	  offset += gotten;
 	}
@@ -3514,7 +3576,7 @@ trace_save (const char *filename, struct trace_file_writer *writer,
 	  /* Parse the trace buffers according to how data are stored
 	     in trace buffer in GDBserver.  */
 
-	  gotten = target_get_raw_trace_data (buf, offset, 6);
+	  gotten = trace_buffer_read (&reader, buf, offset, 6);
 
 	  if (gotten == 0)
 	    break;
@@ -3543,7 +3605,7 @@ trace_save (const char *filename, struct trace_file_writer *writer,
 		  /* We'll fetch one block each time, in order to
 		     handle the extremely large 'M' block.  We first
 		     fetch one byte to get the type of the block.  */
-		  gotten = target_get_raw_trace_data (buf, offset, 1);
+		  gotten = trace_buffer_read (&reader, buf, offset, 1);
 		  if (gotten < 1)
 		    error (_("Failure to get requested trace buffer data"));
 
@@ -3556,8 +3618,8 @@ trace_save (const char *filename, struct trace_file_writer *writer,
 		    {
 		    case 'R':
 		      gotten
-			= target_get_raw_trace_data (buf, offset,
-						     trace_regblock_size);
+			= trace_buffer_read (&reader, buf, offset,
+					     trace_regblock_size);
 		      if (gotten < trace_regblock_size)
 			error (_("Failure to get requested trace"
 				 " buffer data"));
@@ -3572,7 +3634,7 @@ trace_save (const char *filename, struct trace_file_writer *writer,
 			LONGEST t;
 			int j;
 
-			t = target_get_raw_trace_data (buf,offset, 10);
+			t = trace_buffer_read (&reader, buf, offset, 10);
 			if (t < 10)
 			  error (_("Failure to get requested trace"
 				   " buffer data"));
@@ -3603,9 +3665,9 @@ trace_save (const char *filename, struct trace_file_writer *writer,
 			    else
 			      read_length = mlen - j;
 
-			    t = target_get_raw_trace_data (buf,
-							   offset + j,
-							   read_length);
+			    t = trace_buffer_read (&reader, buf,
+						   offset + j,
+						   read_length);
 			    if (t < read_length)
 			      error (_("Failure to get requested"
 				       " trace buffer data"));
@@ -3625,8 +3687,8 @@ trace_save (const char *filename, struct trace_file_writer *writer,
 			LONGEST val;
 
 			gotten
-			  = target_get_raw_trace_data (buf, offset,
-						       12);
+			  = trace_buffer_read (&reader, buf, offset,
+					       12);
 			if (gotten < 12)
 			  error (_("Failure to get requested"
 				   " trace buffer data"));
@@ -3658,6 +3720,8 @@ trace_save (const char *filename, struct trace_file_writer *writer,
 	}
     }
 
+  do_cleanups (old_chain);
+
   writer->ops->end (writer);
 }
 
@@ -4244,26 +4308,153 @@ static off_t cur_offset;
 static int cur_data_size;
 int trace_regblock_size;
 
+/* The trace file is read through a buffer of TFILE_BUFFER_SIZE bytes,
+   holding the TFILE_BUFFER_LEN bytes of the file that start at
+   TFILE_BUFFER_OFFSET.  TFILE_POS is the position tfile_read reads
+   from next.  */
+
+#define TFILE_BUFFER_SIZE (64 * 1024)
+
+static gdb_byte *tfile_buffer;
+static off_t tfile_buffer_offset;
+static int tfile_buffer_len;
+static off_t tfile_pos;
+
+/* The location of a traceframe in the trace file.  */
+
+struct tfile_traceframe
+{
+  /* The offset of the traceframe's data, after its header.  */
+  off_t offset;
+
+  /* The size of the traceframe's data.  */
+  unsigned int data_size;
+
+  /* The number of the tracepoint that collected it, on the target.  */
+  short tpnum;
+};
+
+typedef struct tfile_traceframe tfile_traceframe_s;
+DEF_VEC_O (tfile_traceframe_s);
+
+/* The traceframes of the trace file found so far, by number.  The
+   file is only scanned as far as needed to find the traceframes asked
+   for.  TFILE_TRACEFRAMES_END is the offset of the header following
+   the traceframes found, and TFILE_TRACEFRAMES_COMPLETE is nonzero
+   once that header ends the traceframes.  */
+
+static VEC (tfile_traceframe_s) *tfile_traceframes;
+static off_t tfile_traceframes_end;
+static int tfile_traceframes_complete;
+
 static void tfile_interp_line (char *line,
 			       struct uploaded_tp **utpp,
 			       struct uploaded_tsv **utsvp);
 
-/* Read SIZE bytes into READBUF from the trace frame, starting at
-   TRACE_FD's current position.  Note that this call `read'
-   underneath, hence it advances the file's seek position.  Throws an
-   error if the `read' syscall fails, or less than SIZE bytes are
-   read.  */
+/* Make the next tfile_read read from OFFSET in the trace file.  */
+
+static void
+tfile_seek (off_t offset)
+{
+  tfile_pos = offset;
+}
+
+/* Read SIZE bytes into READBUF from the trace file, starting at the
+   position set by tfile_seek, and advance that position.  Throws an
+   error if reading the file fails, or if it has fewer than SIZE
+   bytes.  */
 
 static void
 tfile_read (gdb_byte *readbuf, int size)
 {
-  int gotten;
+  while (size > 0)
+    {
+      int gotten;
+
+      if (tfile_buffer_offset <= tfile_pos
+	  && tfile_pos < tfile_buffer_offset + tfile_buffer_len)
+	{
+	  gotten = tfile_buffer_offset + tfile_buffer_len - tfile_pos;
+	  if (gotten > size)
+	    gotten = size;
+	  memcpy (readbuf, tfile_buffer + (tfile_pos - tfile_buffer_offset),
+		  gotten);
+	}
+      else
+	{
+	  if (lseek (trace_fd, tfile_pos, SEEK_SET) < 0)
+	    perror_with_name (trace_filename);
+
+	  /* Large reads bypass the buffer.  */
+	  if (size >= TFILE_BUFFER_SIZE)
+	    {
+	      gotten = read (trace_fd, readbuf, size);
+	      if (gotten < 0)
+		perror_with_name (trace_filename);
+	    }
+	  else
+	    {
+	      tfile_buffer_len = 0;
+	      gotten = read (trace_fd, tfile_buffer, TFILE_BUFFER_SIZE);
+	      if (gotten < 0)
+		perror_with_name (trace_filename);
+	      if (gotten == 0)
+		error (_("Premature end of file while reading trace file"));
+	      tfile_buffer_offset = tfile_pos;
+	      tfile_buffer_len = gotten;
+	      continue;
+	    }
+	}
+
+      if (gotten == 0)
+	error (_("Premature end of file while reading trace file"));
+
+      readbuf += gotten;
+      size -= gotten;
+      tfile_pos += gotten;
+    }
+}
+
+/* Return the location of traceframe TFNUM in the trace file, reading
+   the headers of the traceframes before it if needed, or NULL if
+   there is no such traceframe.  */
+
+static struct tfile_traceframe *
+tfile_find_traceframe (int tfnum)
+{
+  enum bfd_endian byte_order = gdbarch_byte_order (target_gdbarch ());
+
+  if (tfnum < 0)
+    return NULL;
+
+  while (!tfile_traceframes_complete
+	 && VEC_length (tfile_traceframe_s, tfile_traceframes) <= tfnum)
+    {
+      struct tfile_traceframe *frame;
+      gdb_byte buf[4];
+      short tpnum;
+
+      tfile_seek (tfile_traceframes_end);
+      tfile_read (buf, 2);
+      tpnum = (short) extract_signed_integer (buf, 2, byte_order);
+      if (tpnum == 0)
+	{
+	  tfile_traceframes_complete = 1;
+	  break;
+	}
 
-  gotten = read (trace_fd, readbuf, size);
-  if (gotten < 0)
-    perror_with_name (trace_filename);
-  else if (gotten < size)
-    error (_("Premature end of file while reading trace file"));
+      frame = VEC_safe_push (tfile_traceframe_s, tfile_traceframes, NULL);
+      frame->tpnum = tpnum;
+      tfile_read (buf, 4);
+      frame->data_size
+	= (unsigned int) extract_unsigned_integer (buf, 4, byte_order);
+      frame->offset = tfile_traceframes_end + 2 + 4;
+      tfile_traceframes_end = frame->offset + frame->data_size;
+    }
+
+  if (tfnum < VEC_length (tfile_traceframe_s, tfile_traceframes))
+    return VEC_index (tfile_traceframe_s, tfile_traceframes, tfnum);
+  return NULL;
 }
 
 static void
@@ -4309,6 +4500,10 @@ tfile_open (char *filename, int from_tty)
 
   trace_filename = xstrdup (filename);
   trace_fd = scratch_chan;
+  tfile_buffer = xmalloc (TFILE_BUFFER_SIZE);
+  tfile_buffer_offset = 0;
+  tfile_buffer_len = 0;
+  tfile_seek (0);
 
   bytes = 0;
   /* Read the file header and test for validity.  */
@@ -4360,6 +4555,8 @@ tfile_open (char *filename, int from_tty)
 
       /* Record the starting offset of the binary trace data.  */
       trace_frames_offset = bytes;
+      tfile_traceframes_end = trace_frames_offset;
+      tfile_traceframes_complete = 0;
 
       /* If we don't have a blocksize, we can't interpret the
 	 traceframes.  */
@@ -4759,6 +4956,9 @@ tfile_close (void)
   trace_fd = -1;
   xfree (trace_filename);
   trace_filename = NULL;
+  xfree (tfile_buffer);
+  tfile_buffer = NULL;
+  VEC_free (tfile_traceframe_s, tfile_traceframes);
 
   trace_reset_local_state ();
 }
@@ -4787,53 +4987,38 @@ tfile_get_tracepoint_status (struct breakpoint *tp, struct uploaded_tp *utp)
      trace files, so nothing to do here.  */
 }
 
-/* Given the position of a traceframe in the file, figure out what
-   address the frame was collected at.  This would normally be the
-   value of a collected PC register, but if not available, we
-   improvise.  */
+/* Figure out what address traceframe FRAME was collected at.  This
+   would normally be the value of a collected PC register, but if not
+   available, we improvise.  */
 
 static CORE_ADDR
-tfile_get_traceframe_address (off_t tframe_offset)
+tfile_get_traceframe_address (struct tfile_traceframe *frame)
 {
   CORE_ADDR addr = 0;
-  short tpnum;
   struct tracepoint *tp;
-  off_t saved_offset = cur_offset;
 
   /* FIXME dig pc out of collected registers.  */
 
   /* Fall back to using tracepoint address.  */
-  lseek (trace_fd, tframe_offset, SEEK_SET);
-  tfile_read ((gdb_byte *) &tpnum, 2);
-  tpnum = (short) extract_signed_integer ((gdb_byte *) &tpnum, 2,
-					  gdbarch_byte_order
-					      (target_gdbarch ()));
-
-  tp = get_tracepoint_by_number_on_target (tpnum);
+  tp = get_tracepoint_by_number_on_target (frame->tpnum);
   /* FIXME this is a poor heuristic if multiple locations.  */
   if (tp && tp->base.loc)
     addr = tp->base.loc->address;
 
-  /* Restore our seek position.  */
-  cur_offset = saved_offset;
-  lseek (trace_fd, cur_offset, SEEK_SET);
   return addr;
 }
 
-/* Given a type of search and some parameters, scan the collection of
-   traceframes in the file looking for a match.  When found, return
-   both the traceframe and tracepoint number, otherwise -1 for
-   each.  */
+/* Given a type of search and some parameters, look through the
+   traceframes in the file for a match.  When found, return both the
+   traceframe and tracepoint number, otherwise -1 for each.  */
 
 static int
 tfile_trace_find (enum trace_find_type type, int num,
 		  CORE_ADDR addr1, CORE_ADDR addr2, int *tpp)
 {
-  short tpnum;
-  int tfnum = 0, found = 0;
-  unsigned int data_size;
+  struct tfile_traceframe *frame = NULL;
+  int tfnum, found = 0;
   struct tracepoint *tp;
-  off_t offset, tframe_offset;
   CORE_ADDR tfaddr;
 
   if (num == -1)
@@ -4843,78 +5028,60 @@ tfile_trace_find (enum trace_find_type type, int num,
       return -1;
     }
 
-  lseek (trace_fd, trace_frames_offset, SEEK_SET);
-  offset = trace_frames_offset;
-  while (1)
+  if (type == tfind_number)
     {
-      tframe_offset = offset;
-      tfile_read ((gdb_byte *) &tpnum, 2);
-      tpnum = (short) extract_signed_integer ((gdb_byte *) &tpnum, 2,
-					      gdbarch_byte_order
-						  (target_gdbarch ()));
-      offset += 2;
-      if (tpnum == 0)
-	break;
-      tfile_read ((gdb_byte *) &data_size, 4);
-      data_size = (unsigned int) extract_unsigned_integer
-                                     ((gdb_byte *) &data_size, 4,
-				      gdbarch_byte_order (target_gdbarch ()));
-      offset += 4;
-
-      if (type == tfind_number)
-	{
-	  /* Looking for a specific trace frame.  */
-	  if (tfnum == num)
-	    found = 1;
-	}
-      else
+      /* Looking for a specific trace frame.  */
+      tfnum = num;
+      frame = tfile_find_traceframe (tfnum);
+      found = (frame != NULL);
+    }
+  else
+    {
+      /* Start from the _next_ trace frame.  */
+      for (tfnum = traceframe_number + 1;
+	   !found && (frame = tfile_find_traceframe (tfnum)) != NULL;
+	   ++tfnum)
 	{
-	  /* Start from the _next_ trace frame.  */
-	  if (tfnum > traceframe_number)
+	  switch (type)
 	    {
-	      switch (type)
-		{
-		case tfind_pc:
-		  tfaddr = tfile_get_traceframe_address (tframe_offset);
-		  if (tfaddr == addr1)
-		    found = 1;
-		  break;
-		case tfind_tp:
-		  tp = get_tracepoint (num);
-		  if (tp && tpnum == tp->number_on_target)
-		    found = 1;
-		  break;
-		case tfind_range:
-		  tfaddr = tfile_get_traceframe_address (tframe_offset);
-		  if (addr1 <= tfaddr && tfaddr <= addr2)
-		    found = 1;
-		  break;
-		case tfind_outside:
-		  tfaddr = tfile_get_traceframe_address (tframe_offset);
-		  if (!(addr1 <= tfaddr && tfaddr <= addr2))
-		    found = 1;
-		  break;
-		default:
-		  internal_error (__FILE__, __LINE__, _("unknown tfind type"));
-		}
+	    case tfind_pc:
+	      tfaddr = tfile_get_traceframe_address (frame);
+	      if (tfaddr == addr1)
+		found = 1;
+	      break;
+	    case tfind_tp:
+	      tp = get_tracepoint (num);
+	      if (tp && frame->tpnum == tp->number_on_target)
+		found = 1;
+	      break;
+	    case tfind_range:
+	      tfaddr = tfile_get_traceframe_address (frame);
+	      if (addr1 <= tfaddr && tfaddr <= addr2)
+		found = 1;
+	      break;
+	    case tfind_outside:
+	      tfaddr = tfile_get_traceframe_address (frame);
+	      if (!(addr1 <= tfaddr && tfaddr <= addr2))
+		found = 1;
+	      break;
+	    default:
+	      internal_error (__FILE__, __LINE__, _("unknown tfind type"));
 	    }
+	  if (found)
+	    break;
 	}
+    }
 
-      if (found)
-	{
-	  if (tpp)
-	    *tpp = tpnum;
-	  cur_offset = offset;
-	  cur_data_size = data_size;
+  if (found)
+    {
+      if (tpp)
+	*tpp = frame->tpnum;
+      cur_offset = frame->offset;
+      cur_data_size = frame->data_size;
 
-	  return tfnum;
-	}
-      /* Skip past the traceframe's data.  */
-      lseek (trace_fd, data_size, SEEK_CUR);
-      offset += data_size;
-      /* Update our own count of traceframes.  */
-      ++tfnum;
+      return tfnum;
     }
+
   /* Did not find what we were looking for.  */
   if (tpp)
     *tpp = -1;
@@ -4952,7 +5119,7 @@ traceframe_walk_blocks (walk_blocks_callback_func callback,
   /* Iterate through a traceframe's blocks, looking for a block of the
      requested type.  */
 
-  lseek (trace_fd, cur_offset + pos, SEEK_SET);
+  tfile_seek (cur_offset + pos);
   while (pos < cur_data_size)
     {
       unsigned short mlen;
@@ -4968,21 +5135,21 @@ traceframe_walk_blocks (walk_blocks_callback_func callback,
       switch (block_type)
 	{
 	case 'R':
-	  lseek (trace_fd, cur_offset + pos + trace_regblock_size, SEEK_SET);
+	  tfile_seek (cur_offset + pos + trace_regblock_size);
 	  pos += trace_regblock_size;
 	  break;
 	case 'M':
-	  lseek (trace_fd, cur_offset + pos + 8, SEEK_SET);
+	  tfile_seek (cur_offset + pos + 8);
 	  tfile_read ((gdb_byte *) &mlen, 2);
           mlen = (unsigned short)
                 extract_unsigned_integer ((gdb_byte *) &mlen, 2,
                                           gdbarch_byte_order
                                               (target_gdbarch ()));
-	  lseek (trace_fd, mlen, SEEK_CUR);
+	  tfile_seek (tfile_pos + mlen);
 	  pos += (8 + 2 + mlen);
 	  break;
 	case 'V':
-	  lseek (trace_fd, cur_offset + pos + 4 + 8, SEEK_SET);
+	  tfile_seek (cur_offset + pos + 4 + 8);
 	  pos += (4 + 8);
 	  break;
 	default:
@@ -5134,7 +5301,7 @@ tfile_xfer_partial (struct target_ops *ops, enum target_object object,
 		amt = len;
 
 	      if (maddr != offset)
-	        lseek (trace_fd, offset - maddr, SEEK_CUR);
+		tfile_seek (tfile_pos + (offset - maddr));
 	      tfile_read (readbuf, amt);
 	      return amt;
 	    }
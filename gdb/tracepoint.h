@@ -323,6 +323,10 @@ struct trace_file_writer
   const struct trace_file_write_ops *ops;
 };
 
+enum {
+  memrange_absolute = -1
+};
+
 struct memrange
 {
   /* memrange_absolute for absolute memory range, else basereg
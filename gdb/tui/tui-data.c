@@ -214,6 +214,8 @@ tui_clear_win_detail (struct tui_win_info *win_info)
 	  win_info->detail.source_info.start_line_or_addr.loa = LOA_ADDRESS;
 	  win_info->detail.source_info.start_line_or_addr.u.addr = 0;
 	  win_info->detail.source_info.horizontal_offset = 0;
+	  win_info->detail.source_info.content_offset = 0;
+	  win_info->detail.source_info.content_tab_len = 0;
 	  break;
 	case CMD_WIN:
 	  win_info->detail.command_info.cur_line =
@@ -542,6 +544,8 @@ init_win_info (struct tui_win_info *win_info)
       win_info->detail.source_info.start_line_or_addr.loa = LOA_ADDRESS;
       win_info->detail.source_info.start_line_or_addr.u.addr = 0;
       win_info->detail.source_info.fullname = NULL;
+      win_info->detail.source_info.content_offset = 0;
+      win_info->detail.source_info.content_tab_len = 0;
       break;
     case DATA_WIN:
       win_info->detail.data_display_info.data_content = (tui_win_content) NULL;
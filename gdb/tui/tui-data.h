@@ -277,6 +277,12 @@ struct tui_source_info
 
   /* Architecture associated with code at this location.  */
   struct gdbarch *gdbarch;
+
+  /* The horizontal offset and the tab length the source lines of the
+     content were formatted with.  A content_tab_len of 0 means the
+     lines have to be read anew.  */
+  int content_offset;
+  int content_tab_len;
 };
 
 
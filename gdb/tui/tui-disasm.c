@@ -37,6 +37,8 @@
 #include "tui/tui-file.h"
 #include "tui/tui-disasm.h"
 #include "progspace.h"
+#include "observer.h"
+#include "hashtab.h"
 
 #include "gdb_curses.h"
 
@@ -47,6 +49,65 @@ struct tui_asm_line
   char *insn;
 };
 
+/* The instructions disassembled since the inferior last ran, so that
+   scrolling or moving the disassembly window doesn't disassemble
+   them again.  */
+
+struct tui_insn
+{
+  struct gdbarch *gdbarch;
+  CORE_ADDR addr;
+
+  /* The address of the next instruction.  */
+  CORE_ADDR next_addr;
+
+  char *addr_string;
+  char *insn;
+};
+
+static htab_t tui_insn_cache;
+
+/* The most instructions to remember.  The disassembly window only
+   needs a few screenfuls of them.  */
+
+#define MAX_TUI_INSNS 1024
+
+static hashval_t
+hash_tui_insn (const void *p)
+{
+  const struct tui_insn *insn = p;
+
+  return htab_hash_pointer (insn->gdbarch) ^ (hashval_t) insn->addr;
+}
+
+static int
+eq_tui_insn (const void *a, const void *b)
+{
+  const struct tui_insn *lhs = a;
+  const struct tui_insn *rhs = b;
+
+  return lhs->gdbarch == rhs->gdbarch && lhs->addr == rhs->addr;
+}
+
+static void
+free_tui_insn (void *p)
+{
+  struct tui_insn *insn = p;
+
+  xfree (insn->addr_string);
+  xfree (insn->insn);
+  xfree (insn);
+}
+
+/* Forget all the instructions disassembled so far.  */
+
+static void
+tui_forget_insns (void)
+{
+  if (tui_insn_cache != NULL)
+    htab_empty (tui_insn_cache);
+}
+
 /* Function to set the disassembly window's content.
    Disassemble count lines starting at pc.
    Return address of the count'th instruction after pc.  */
@@ -59,13 +120,32 @@ tui_disassemble (struct gdbarch *gdbarch, struct tui_asm_line *asm_lines,
   /* Now init the ui_file structure.  */
   gdb_dis_out = tui_sfileopen (256);
 
+  if (tui_insn_cache == NULL)
+    tui_insn_cache = htab_create_alloc (127, hash_tui_insn, eq_tui_insn,
+					free_tui_insn, xcalloc, xfree);
+
   /* Now construct each line.  */
   for (; count > 0; count--, asm_lines++)
     {
+      struct tui_insn key, *insn;
+      void **slot;
+
       if (asm_lines->addr_string)
         xfree (asm_lines->addr_string);
       if (asm_lines->insn)
         xfree (asm_lines->insn);
+
+      key.gdbarch = gdbarch;
+      key.addr = pc;
+      insn = htab_find (tui_insn_cache, &key);
+      if (insn != NULL)
+	{
+	  asm_lines->addr = pc;
+	  asm_lines->addr_string = xstrdup (insn->addr_string);
+	  asm_lines->insn = xstrdup (insn->insn);
+	  pc = insn->next_addr;
+	  continue;
+	}
       
       print_address (gdbarch, pc, gdb_dis_out);
       asm_lines->addr = pc;
@@ -79,6 +159,18 @@ tui_disassemble (struct gdbarch *gdbarch, struct tui_asm_line *asm_lines,
 
       /* Reset the buffer to empty.  */
       ui_file_rewind (gdb_dis_out);
+
+      if (htab_elements (tui_insn_cache) >= MAX_TUI_INSNS)
+	htab_empty (tui_insn_cache);
+
+      insn = XNEW (struct tui_insn);
+      insn->gdbarch = gdbarch;
+      insn->addr = asm_lines->addr;
+      insn->next_addr = pc;
+      insn->addr_string = xstrdup (asm_lines->addr_string);
+      insn->insn = xstrdup (asm_lines->insn);
+      slot = htab_find_slot (tui_insn_cache, insn, INSERT);
+      *slot = insn;
     }
   ui_file_delete (gdb_dis_out);
   return pc;
@@ -408,3 +500,50 @@ tui_vertical_disassem_scroll (enum tui_scroll_direction scroll_direction,
 				      NULL, val, FALSE);
     }
 }
+
+/* Observers that forget the instructions disassembled so far when
+   the code or the way it is shown may have changed.  */
+
+static void
+tui_disasm_target_resumed (ptid_t ptid)
+{
+  tui_forget_insns ();
+}
+
+static void
+tui_disasm_memory_changed (struct inferior *inferior, CORE_ADDR addr,
+			   ssize_t len, const bfd_byte *data)
+{
+  tui_forget_insns ();
+}
+
+static void
+tui_disasm_new_objfile (struct objfile *objfile)
+{
+  tui_forget_insns ();
+}
+
+static void
+tui_disasm_traceframe_changed (int tfnum, int tpnum)
+{
+  tui_forget_insns ();
+}
+
+static void
+tui_disasm_command_param_changed (const char *param, const char *value)
+{
+  tui_forget_insns ();
+}
+
+/* Provide a prototype to silence -Wmissing-prototypes.  */
+extern initialize_file_ftype _initialize_tui_disasm;
+
+void
+_initialize_tui_disasm (void)
+{
+  observer_attach_target_resumed (tui_disasm_target_resumed);
+  observer_attach_memory_changed (tui_disasm_memory_changed);
+  observer_attach_new_objfile (tui_disasm_new_objfile);
+  observer_attach_traceframe_changed (tui_disasm_traceframe_changed);
+  observer_attach_command_param_changed (tui_disasm_command_param_changed);
+}
@@ -59,6 +59,11 @@ int tui_target_has_run = 0;
 static void
 tui_new_objfile_hook (struct objfile* objfile)
 {
+  /* The source files may have changed along with the symbols; see
+     that the source window reads its lines anew.  */
+  if (TUI_SRC_WIN != NULL)
+    TUI_SRC_WIN->detail.source_info.content_tab_len = 0;
+
   if (tui_active)
     tui_display_main ();
 }
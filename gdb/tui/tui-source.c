@@ -38,6 +38,156 @@
 #include "gdb_string.h"
 #include "gdb_curses.h"
 
+/* Read the next line from STREAM, the source line LINE_NO, into the
+   window element ELEMENT.  SRC_LINE is the buffer in which the line
+   is formatted, before OFFSET characters are skipped; THRESHOLD is
+   the number of characters it can hold.  */
+static void
+tui_read_source_line (FILE *stream, struct tui_win_element *element,
+		      int line_no, char *src_line, int offset, int threshold)
+{
+  int i, c, cur_len;
+
+  /* Get the first character in the line.  */
+  c = fgetc (stream);
+
+  /* Init the line with the line number.  */
+  sprintf (src_line, "%-6d", line_no);
+  cur_len = strlen (src_line);
+  i = cur_len - ((cur_len / tui_default_tab_len ())
+		 * tui_default_tab_len ());
+  while (i < tui_default_tab_len ())
+    {
+      src_line[cur_len] = ' ';
+      i++;
+      cur_len++;
+    }
+  src_line[cur_len] = (char) 0;
+
+  element->which_element.source.line_or_addr.loa = LOA_LINE;
+  element->which_element.source.line_or_addr.u.line_no = line_no;
+  if (c != EOF)
+    {
+      i = strlen (src_line) - 1;
+      do
+	{
+	  if ((c != '\n') && (c != '\r') 
+	      && (++i < threshold))
+	    {
+	      if (c < 040 && c != '\t')
+		{
+		  src_line[i++] = '^';
+		  src_line[i] = c + 0100;
+		}
+	      else if (c == 0177)
+		{
+		  src_line[i++] = '^';
+		  src_line[i] = '?';
+		}
+	      else
+		{ /* Store the charcter in the line buffer.  If it is
+		     a tab, then translate to the correct number of
+		     chars so we don't overwrite our buffer.  */
+		  if (c == '\t')
+		    {
+		      int j, max_tab_len = tui_default_tab_len ();
+
+		      for (j = i - ((i / max_tab_len) * max_tab_len);
+			   j < max_tab_len && i < threshold;
+			   i++, j++)
+			src_line[i] = ' ';
+		      i--;
+		    }
+		  else
+		    src_line[i] = c;
+		}
+	      src_line[i + 1] = 0;
+	    }
+	  else
+	    { /* If we have not reached EOL, then eat chars until we
+		 do.  */
+	      while (c != EOF && c != '\n' && c != '\r')
+		c = fgetc (stream);
+	      /* Handle non-'\n' end-of-line.  */
+	      if (c == '\r' 
+		  && (c = fgetc (stream)) != '\n' 
+		  && c != EOF)
+		{
+		  ungetc (c, stream);
+		  c = '\r';
+		}
+	    }
+	}
+      while (c != EOF && c != '\n' && c != '\r' 
+	     && i < threshold 
+	     && (c = fgetc (stream)));
+    }
+
+  /* Now copy the line taking the offset into account.  */
+  if (strlen (src_line) > offset)
+    {
+      if (src_line != element->which_element.source.line)
+	strcpy (element->which_element.source.line, &src_line[offset]);
+    }
+  else
+    element->which_element.source.line[0] = (char) 0;
+}
+
+/* Return how many of the NLINES lines to display from line LINE_NO
+   of the source file FULLNAME are in the current content of the
+   source window, formatted in the way they would be now.  Move them
+   to their new place in the content.  If the window has moved down,
+   the lines kept are at the start of the content, otherwise they are
+   at its end.  */
+static int
+tui_keep_source_lines (const char *fullname, int line_no, int nlines)
+{
+  struct tui_source_info *src = &TUI_SRC_WIN->detail.source_info;
+  tui_win_content content = (tui_win_content) TUI_SRC_WIN->generic.content;
+  int delta, kept, i;
+
+  if (!TUI_SRC_WIN->generic.content_in_use
+      || TUI_SRC_WIN->generic.content_size != nlines
+      || src->start_line_or_addr.loa != LOA_LINE
+      || src->content_tab_len != tui_default_tab_len ()
+      || src->content_offset != src->horizontal_offset
+      || src->fullname == NULL
+      || filename_cmp (src->fullname, fullname) != 0)
+    return 0;
+
+  delta = line_no - src->start_line_or_addr.u.line_no;
+  if (delta >= nlines || delta <= -nlines)
+    return 0;
+
+  /* The lines share one buffer that is freed through the first
+     element, so the lines are copied rather than the elements
+     moved.  */
+  if (delta >= 0)
+    {
+      kept = nlines - delta;
+      for (i = 0; i < kept; i++)
+	{
+	  strcpy (content[i]->which_element.source.line,
+		  content[i + delta]->which_element.source.line);
+	  content[i]->which_element.source.line_or_addr
+	    = content[i + delta]->which_element.source.line_or_addr;
+	}
+    }
+  else
+    {
+      kept = nlines + delta;
+      for (i = nlines - 1; i >= -delta; i--)
+	{
+	  strcpy (content[i]->which_element.source.line,
+		  content[i + delta]->which_element.source.line);
+	  content[i]->which_element.source.line_or_addr
+	    = content[i + delta]->which_element.source.line_or_addr;
+	}
+    }
+
+  return kept;
+}
+
 /* Function to display source in the source window.  */
 enum tui_status
 tui_set_source_content (struct symtab *s, 
@@ -49,7 +199,7 @@ tui_set_source_content (struct symtab *s,
   if (s != (struct symtab *) NULL)
     {
       FILE *stream;
-      int i, desc, c, line_width, nlines;
+      int desc, line_width, nlines;
       char *src_line = 0;
 
       if ((ret = tui_alloc_source_buffer (TUI_SRC_WIN)) == TUI_SUCCESS)
@@ -85,26 +235,61 @@ tui_set_source_content (struct symtab *s,
 				     symtab_to_filename_for_display (s),
 				     s->nlines);
 		}
-	      else if (lseek (desc, s->line_charpos[line_no - 1], 0) < 0)
-		{
-		  close (desc);
-		  perror_with_name (symtab_to_filename_for_display (s));
-		}
 	      else
 		{
-		  int offset, cur_line_no, cur_line, cur_len, threshold;
+		  int offset, cur_line, threshold, kept, first, last;
 		  struct tui_gen_win_info *locator
 		    = tui_locator_win_info_ptr ();
                   struct tui_source_info *src
 		    = &TUI_SRC_WIN->detail.source_info;
 		  const char *s_filename = symtab_to_filename_for_display (s);
+		  const char *s_fullname = symtab_to_fullname (s);
+		  union tui_which_element *item
+		    = &((struct tui_win_element *)
+			locator->content[0])->which_element;
+		  int is_exec_file
+		    = filename_cmp (item->locator.full_name, s_fullname) == 0;
+
+		  /* Only the lines that are not displayed yet have to be
+		     read from the file: when stepping or scrolling, most
+		     of them usually are.  FIRST and LAST are the indexes
+		     in the content of the lines to read.  */
+		  kept = tui_keep_source_lines (s_fullname, line_no, nlines);
+		  if (kept > 0
+		      && line_no > src->start_line_or_addr.u.line_no)
+		    {
+		      first = kept;
+		      last = nlines;
+		    }
+		  else
+		    {
+		      first = 0;
+		      last = nlines - kept;
+		    }
+
+		  if (first < last)
+		    {
+		      off_t pos;
+
+		      /* Lines past the end of the file are shown empty.  */
+		      if (line_no + first <= s->nlines)
+			pos = lseek (desc, s->line_charpos[line_no + first - 1],
+				     SEEK_SET);
+		      else
+			pos = lseek (desc, 0, SEEK_END);
+		      if (pos < 0)
+			{
+			  close (desc);
+			  perror_with_name (s_filename);
+			}
+		    }
 
                   if (TUI_SRC_WIN->generic.title)
                     xfree (TUI_SRC_WIN->generic.title);
                   TUI_SRC_WIN->generic.title = xstrdup (s_filename);
 
 		  xfree (src->fullname);
-		  src->fullname = xstrdup (symtab_to_fullname (s));
+		  src->fullname = xstrdup (s_fullname);
 
 		  /* Determine the threshold for the length of the
                      line and the offset to start the display.  */
@@ -112,129 +297,41 @@ tui_set_source_content (struct symtab *s,
 		  threshold = (line_width - 1) + offset;
 		  stream = fdopen (desc, FOPEN_RT);
 		  clearerr (stream);
-		  cur_line = 0;
 		  src->gdbarch = get_objfile_arch (s->objfile);
 		  src->start_line_or_addr.loa = LOA_LINE;
-		  cur_line_no = src->start_line_or_addr.u.line_no = line_no;
+		  src->start_line_or_addr.u.line_no = line_no;
+		  src->content_offset = offset;
+		  src->content_tab_len = tui_default_tab_len ();
 		  if (offset > 0)
 		    src_line = (char *) xmalloc (
 					   (threshold + 1) * sizeof (char));
-		  while (cur_line < nlines)
+		  for (cur_line = first; cur_line < last; cur_line++)
 		    {
 		      struct tui_win_element *element
 			= (struct tui_win_element *)
 			TUI_SRC_WIN->generic.content[cur_line];
 
-		      /* Get the first character in the line.  */
-		      c = fgetc (stream);
-
 		      if (offset == 0)
-			src_line = ((struct tui_win_element *)
-				   TUI_SRC_WIN->generic.content[
-					cur_line])->which_element.source.line;
-		      /* Init the line with the line number.  */
-		      sprintf (src_line, "%-6d", cur_line_no);
-		      cur_len = strlen (src_line);
-		      i = cur_len - ((cur_len / tui_default_tab_len ())
-				     * tui_default_tab_len ());
-		      while (i < tui_default_tab_len ())
-			{
-			  src_line[cur_len] = ' ';
-			  i++;
-			  cur_len++;
-			}
-		      src_line[cur_len] = (char) 0;
-
-		      /* Set whether element is the execution point
-		         and whether there is a break point on it.  */
-		      element->which_element.source.line_or_addr.loa =
-			LOA_LINE;
-		      element->which_element.source.line_or_addr.u.line_no =
-			cur_line_no;
-		      element->which_element.source.is_exec_point =
-			(filename_cmp (((struct tui_win_element *)
-				       locator->content[0])->which_element.locator.full_name,
-				       symtab_to_fullname (s)) == 0
-			 && cur_line_no == ((struct tui_win_element *)
-					    locator->content[0])->which_element.locator.line_no);
-		      if (c != EOF)
-			{
-			  i = strlen (src_line) - 1;
-			  do
-			    {
-			      if ((c != '\n') && (c != '\r') 
-				  && (++i < threshold))
-				{
-				  if (c < 040 && c != '\t')
-				    {
-				      src_line[i++] = '^';
-				      src_line[i] = c + 0100;
-				    }
-				  else if (c == 0177)
-				    {
-				      src_line[i++] = '^';
-				      src_line[i] = '?';
-				    }
-				  else
-				    { /* Store the charcter in the
-					 line buffer.  If it is a tab,
-					 then translate to the correct
-					 number of chars so we don't
-					 overwrite our buffer.  */
-				      if (c == '\t')
-					{
-					  int j, max_tab_len
-					    = tui_default_tab_len ();
-
-					  for (j = i - ((i / max_tab_len)
-							* max_tab_len);
-					       j < max_tab_len
-						 && i < threshold;
-					       i++, j++)
-					    src_line[i] = ' ';
-					  i--;
-					}
-				      else
-					src_line[i] = c;
-				    }
-				  src_line[i + 1] = 0;
-				}
-			      else
-				{ /* If we have not reached EOL, then
-				     eat chars until we do.  */
-				  while (c != EOF && c != '\n' && c != '\r')
-				    c = fgetc (stream);
-				  /* Handle non-'\n' end-of-line.  */
-				  if (c == '\r' 
-				      && (c = fgetc (stream)) != '\n' 
-				      && c != EOF)
-				    {
-				       ungetc (c, stream);
-				       c = '\r';
-				    }
-				  
-				}
-			    }
-			  while (c != EOF && c != '\n' && c != '\r' 
-				 && i < threshold 
-				 && (c = fgetc (stream)));
-			}
-		      /* Now copy the line taking the offset into
-			 account.  */
-		      if (strlen (src_line) > offset)
-			strcpy (((struct tui_win_element *)
-				 TUI_SRC_WIN->generic.content[cur_line])->which_element.source.line,
-				&src_line[offset]);
-		      else
-			((struct tui_win_element *)
-			 TUI_SRC_WIN->generic.content[
-			  cur_line])->which_element.source.line[0] = (char) 0;
-		      cur_line++;
-		      cur_line_no++;
+			src_line = element->which_element.source.line;
+		      tui_read_source_line (stream, element,
+					    line_no + cur_line,
+					    src_line, offset, threshold);
 		    }
 		  if (offset > 0)
 		    xfree (src_line);
 		  fclose (stream);
+
+		  /* Set whether each element is the execution point.  */
+		  for (cur_line = 0; cur_line < nlines; cur_line++)
+		    {
+		      struct tui_win_element *element
+			= (struct tui_win_element *)
+			TUI_SRC_WIN->generic.content[cur_line];
+
+		      element->which_element.source.is_exec_point
+			= (is_exec_file
+			   && line_no + cur_line == item->locator.line_no);
+		    }
 		  TUI_SRC_WIN->generic.content_size = nlines;
 		  ret = TUI_SUCCESS;
 		}
@@ -472,9 +472,11 @@ mem_file_write (struct ui_file *file,
     {
       int new_length = stream->length_buffer + length_buffer;
 
+      /* Grow the buffer geometrically, so that building a large
+	 string a few bytes at a time stays linear.  */
       if (new_length >= stream->sizeof_buffer)
 	{
-	  stream->sizeof_buffer = new_length;
+	  stream->sizeof_buffer = max (new_length, 2 * stream->sizeof_buffer);
 	  stream->buffer = xrealloc (stream->buffer, stream->sizeof_buffer);
 	}
       memcpy (stream->buffer + stream->length_buffer, buffer, length_buffer);
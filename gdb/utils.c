@@ -1556,12 +1556,53 @@ printchar (int c, void (*do_fputs) (const char *, struct ui_file *),
     }
   else
     {
+      char buf[2];
+
       if (c == '\\' || c == quoter)
 	do_fputs ("\\", stream);
-      do_fprintf (stream, "%c", c);
+      buf[0] = c;
+      buf[1] = '\0';
+      do_fputs (buf, stream);
     }
 }
 
+/* Return non-zero if printchar prints C as itself in a literal string
+   delimited by QUOTER.  */
+
+static int
+printchar_plain_p (int c, int quoter)
+{
+  c &= 0xFF;
+
+  return !(c < 0x20
+	   || (c >= 0x7F && c < 0xA0)
+	   || (sevenbit_strings && c >= 0x80)
+	   || c == '\\' || c == quoter);
+}
+
+/* Print the N characters at STR on STREAM like printchar would, but
+   write each run of characters that need no escaping in one go.  */
+
+static void
+printstrn_unfiltered (const char *str, int n, int quoter,
+		      struct ui_file *stream)
+{
+  int i, start = 0;
+
+  for (i = 0; i < n; i++)
+    if (!printchar_plain_p (str[i], quoter))
+      {
+	if (i > start)
+	  ui_file_write (stream, str + start, i - start);
+	printchar (str[i], fputs_unfiltered, fprintf_unfiltered, stream,
+		   quoter);
+	start = i + 1;
+      }
+
+  if (n > start)
+    ui_file_write (stream, str + start, n - start);
+}
+
 /* Print the character C on STREAM as part of the contents of a
    literal string whose delimiter is QUOTER.  Note that these routines
    should only be call for printing things which are independent of
@@ -1577,8 +1618,7 @@ fputstr_filtered (const char *str, int quoter, struct ui_file *stream)
 void
 fputstr_unfiltered (const char *str, int quoter, struct ui_file *stream)
 {
-  while (*str)
-    printchar (*str++, fputs_unfiltered, fprintf_unfiltered, stream, quoter);
+  printstrn_unfiltered (str, strlen (str), quoter, stream);
 }
 
 void
@@ -1595,10 +1635,7 @@ void
 fputstrn_unfiltered (const char *str, int n, int quoter,
 		     struct ui_file *stream)
 {
-  int i;
-
-  for (i = 0; i < n; i++)
-    printchar (str[i], fputs_unfiltered, fprintf_unfiltered, stream, quoter);
+  printstrn_unfiltered (str, n, quoter, stream);
 }
 
 
@@ -1751,6 +1751,14 @@ partial_memory_read (CORE_ADDR memaddr, gdb_byte *myaddr,
   return (nread);
 }
 
+/* The largest block of bytes read_string fetches at once when looking
+   for a string's terminating NUL.  Blocks are also kept from crossing
+   a multiple of this size, so that a block never spans two pages: a
+   failed read falls back to reading a byte at a time, and that way
+   the fallback fails on its first byte.  */
+
+#define MAX_STRING_CHUNK 4096
+
 /* Read a string from the inferior, at ADDR, with LEN characters of WIDTH bytes
    each.  Fetch at most FETCHLIMIT characters.  BUFFER will be set to a newly
    allocated buffer containing the string, which the caller is responsible to
@@ -1791,9 +1799,14 @@ read_string (CORE_ADDR addr, int len, int width, unsigned int fetchlimit,
      so we might as well read them all in one operation.  If LEN is -1, we
      are looking for a NUL terminator to end the fetching, so we might as
      well read in blocks that are large enough to be efficient, but not so
-     large as to be slow if fetchlimit happens to be large.  So we choose the
-     minimum of 8 and fetchlimit.  We used to use 200 instead of 8 but
-     200 is way too big for remote debugging over a serial line.  */
+     large as to be slow if fetchlimit happens to be large.  So we start
+     with the minimum of 8 and fetchlimit.  We used to use 200 instead of 8
+     but 200 is way too big for remote debugging over a serial line.  Each
+     further block is twice as large as the one before, up to
+     MAX_STRING_CHUNK bytes, so that long strings do not take one read
+     (and one reallocation of the buffer) per 8 characters.  Since the
+     blocks grow with what has already been read, at most about as many
+     bytes are fetched past the NUL as precede it.  */
 
   chunksize = (len == -1 ? min (8, fetchlimit) : fetchlimit);
 
@@ -1821,9 +1834,16 @@ read_string (CORE_ADDR addr, int len, int width, unsigned int fetchlimit,
 
       do
 	{
+	  CORE_ADDR boundary;
+
 	  QUIT;
 	  nfetch = min (chunksize, fetchlimit - bufsize);
 
+	  /* Stop this block at the next MAX_STRING_CHUNK boundary.  */
+	  boundary = (addr | (MAX_STRING_CHUNK - 1)) + 1;
+	  if ((boundary - addr) / width > 0)
+	    nfetch = min (nfetch, (boundary - addr) / width);
+
 	  if (*buffer == NULL)
 	    *buffer = (gdb_byte *) xmalloc (nfetch * width);
 	  else
@@ -1832,6 +1852,7 @@ read_string (CORE_ADDR addr, int len, int width, unsigned int fetchlimit,
 
 	  bufptr = *buffer + bufsize * width;
 	  bufsize += nfetch;
+	  chunksize = max (min (2 * chunksize, MAX_STRING_CHUNK / width), 1);
 
 	  /* Read as much as we can.  */
 	  nfetch = partial_memory_read (addr, bufptr, nfetch * width, &errcode)
@@ -667,6 +667,17 @@ static int value_history_count;	/* Abs number of last entry stored.  */
 
 static struct value *all_values;
 
+/* Values that have been freed, chained through their NEXT fields and
+   kept for reuse by allocate_value_lazy.  Printing a large aggregate
+   creates and frees several values for every element, and recycling
+   them saves a malloc/free pair each time.  At most MAX_FREE_VALUES
+   are kept.  */
+
+#define MAX_FREE_VALUES 1024
+
+static struct value *free_values;
+static int num_free_values;
+
 /* Allocate a lazy value for type TYPE.  Its actual content is
    "lazily" allocated too: the content field of the return value is
    NULL; it will be allocated when it is fetched from the target.  */
@@ -684,7 +695,15 @@ allocate_value_lazy (struct type *type)
      description correctly.  */
   check_typedef (type);
 
-  val = (struct value *) xzalloc (sizeof (struct value));
+  if (free_values != NULL)
+    {
+      val = free_values;
+      free_values = val->next;
+      num_free_values--;
+      memset (val, 0, sizeof (struct value));
+    }
+  else
+    val = (struct value *) xzalloc (sizeof (struct value));
   val->contents = NULL;
   val->next = all_values;
   all_values = val;
@@ -1297,8 +1316,16 @@ value_free (struct value *val)
 
       xfree (val->contents);
       VEC_free (range_s, val->unavailable);
+
+      if (num_free_values < MAX_FREE_VALUES)
+	{
+	  val->next = free_values;
+	  free_values = val;
+	  num_free_values++;
+	}
+      else
+	xfree (val);
     }
-  xfree (val);
 }
 
 /* Free all values allocated since MARK was obtained by value_mark
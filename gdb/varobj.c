@@ -67,6 +67,11 @@ varobj_enable_pretty_printing (void)
   pretty_printing = 1;
 }
 
+/* Aggregate values up to this many bytes are read from the target in
+   one go when their children are updated.  */
+
+#define MAX_VAROBJ_PREFETCH 65536
+
 /* Data structures */
 
 /* Every root variable has one of these structures saved in its
@@ -96,6 +101,12 @@ struct varobj_root
      always updated in the specific scope/thread/frame.  */
   int floating;
 
+  /* For a floating varobj, the block of the selected frame and the
+     language that EXP was last parsed in.  While they stay the same,
+     -var-update need not parse the expression again.  */
+  const struct block *floating_block;
+  const struct language_defn *floating_language;
+
   /* Flag that indicates validity: set to 0 when this varobj_root refers 
      to symbols that do not exist anymore.  */
   int is_valid;
@@ -343,10 +354,6 @@ varobj_create (char *objname,
       else
 	fi = NULL;
 
-      /* frame = -2 means always use selected frame.  */
-      if (type == USE_SELECTED_FRAME)
-	var->root->floating = 1;
-
       pc = 0;
       block = NULL;
       if (fi != NULL)
@@ -355,6 +362,14 @@ varobj_create (char *objname,
 	  pc = get_frame_pc (fi);
 	}
 
+      /* frame = -2 means always use selected frame.  */
+      if (type == USE_SELECTED_FRAME)
+	{
+	  var->root->floating = 1;
+	  var->root->floating_block = block;
+	  var->root->floating_language = current_language;
+	}
+
       p = expression;
       innermost_block = NULL;
       /* Wrap the call to parse expression, so we can 
@@ -1389,6 +1404,40 @@ update_type_if_necessary (struct varobj *var, struct value *new_value)
   return 0;
 }
 
+/* Add to *COUNT the number of VAR's descendants that fetch their
+   value when VAR is updated, stopping once it exceeds one.  */
+
+static void
+varobj_count_fetched_children (struct varobj *var, int *count)
+{
+  struct varobj *child;
+  int i;
+
+  for (i = 0;
+       *count <= 1 && VEC_iterate (varobj_p, var->children, i, child);
+       ++i)
+    {
+      if (child == NULL || child->frozen)
+	continue;
+      if (child->type != NULL && varobj_value_is_changeable_p (child))
+	++*count;
+      else
+	varobj_count_fetched_children (child, count);
+    }
+}
+
+/* Return 1 if more than one of VAR's descendants fetches its value
+   when VAR is updated.  */
+
+static int
+varobj_fetched_children_p (struct varobj *var)
+{
+  int count = 0;
+
+  varobj_count_fetched_children (var, &count);
+  return count > 1;
+}
+
 /* Assign a new value to a variable object.  If INITIAL is non-zero,
    this is the first assignement after the variable object was just
    created, or changed type.  In that case, just assign the value 
@@ -1482,6 +1531,28 @@ install_new_value (struct varobj *var, struct value *value, int initial)
 	}
     }
 
+  /* Aggregates are not compared, so their values are normally left
+     lazy -- but then each of their descendants that is compared reads
+     its own part from the target.  If several such descendants are
+     being updated too, and the aggregate is not too large, read it at
+     once instead; its children are then taken from its contents.  */
+  if (!need_to_fetch && value != NULL && value_lazy (value)
+      && VALUE_LVAL (value) == lval_memory
+      && !var->frozen
+      && (TYPE_LENGTH (check_typedef (value_type (value)))
+	  <= MAX_VAROBJ_PREFETCH)
+      && varobj_fetched_children_p (var))
+    {
+      volatile struct gdb_exception except;
+
+      /* On failure, leave the value lazy and let the children read
+	 what they can.  */
+      TRY_CATCH (except, RETURN_MASK_ERROR)
+	{
+	  value_fetch_lazy (value);
+	}
+    }
+
   /* Get a reference now, before possibly passing it to any Python
      code that might release it.  */
   if (value != NULL)
@@ -2205,6 +2276,8 @@ new_root_variable (void)
   var->root->valid_block = NULL;
   var->root->frame = null_frame_id;
   var->root->floating = 0;
+  var->root->floating_block = NULL;
+  var->root->floating_language = NULL;
   var->root->rootvar = NULL;
   var->root->is_valid = 1;
 
@@ -2465,6 +2538,24 @@ value_of_root_1 (struct varobj **var_handle)
   return new_val;
 }
 
+/* Return 1 if the expression of floating varobj VAR was parsed in the
+   block of the selected frame and in the current language, so that
+   it need not be parsed again.  */
+
+static int
+varobj_floating_exp_valid_p (struct varobj *var)
+{
+  const struct block *block;
+
+  if (var->root->floating_block == NULL
+      || var->root->floating_language != current_language
+      || !has_stack_frames ())
+    return 0;
+
+  block = get_frame_block (get_selected_frame (NULL), 0);
+  return block == var->root->floating_block;
+}
+
 /* What is the ``struct value *'' of the root variable VAR?
    For floating variable object, evaluation can get us a value
    of different type from what is stored in varobj already.  In
@@ -2490,7 +2581,13 @@ value_of_root (struct varobj **var_handle, int *type_changed)
   if (!is_root_p (var))
     return NULL;
 
-  if (var->root->floating)
+  if (var->root->floating && varobj_floating_exp_valid_p (var))
+    {
+      /* The expression was parsed in the same block and language as
+	 before, so parsing it again would give the same result.  */
+      *type_changed = 0;
+    }
+  else if (var->root->floating)
     {
       struct varobj *tmp_var;
       char *old_type, *new_type;
@@ -2515,6 +2612,8 @@ value_of_root (struct varobj **var_handle, int *type_changed)
 
          var->root->exp = tmp_var->root->exp;
          tmp_var->root->exp = tmp_exp;
+	 var->root->floating_block = tmp_var->root->floating_block;
+	 var->root->floating_language = tmp_var->root->floating_language;
 
 	  varobj_delete (tmp_var, NULL, 0);
 	  *type_changed = 0;
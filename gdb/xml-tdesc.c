@@ -27,9 +27,17 @@
 #include "osabi.h"
 
 #include "filenames.h"
+#include "hashtab.h"
+#include "safe-ctype.h"
+#include "gdb_string.h"
+#include "filestuff.h"
 
 #include "gdb_assert.h"
 
+/* See xml-tdesc.h.  */
+
+char *tdesc_cache_directory;
+
 #if !defined(HAVE_LIBEXPAT)
 
 /* Parse DOCUMENT into a target description.  Or don't, since we don't have
@@ -37,7 +45,7 @@
 
 static struct target_desc *
 tdesc_parse_xml (const char *document, xml_fetch_another fetcher,
-		 void *fetcher_baton)
+		 void *fetcher_baton, const char *target_hash)
 {
   static int have_warned;
 
@@ -51,6 +59,20 @@ tdesc_parse_xml (const char *document, xml_fetch_another fetcher,
   return NULL;
 }
 
+/* Without an XML parser nothing is ever cached.  */
+
+static struct target_desc *
+tdesc_lookup_target_hash (const char *target_hash)
+{
+  return NULL;
+}
+
+static const char *
+tdesc_target_hash_document (const char *target_hash)
+{
+  return NULL;
+}
+
 #else /* HAVE_LIBEXPAT */
 
 /* A record of every XML description we have parsed.  We never discard
@@ -63,13 +85,128 @@ tdesc_parse_xml (const char *document, xml_fetch_another fetcher,
 
 struct tdesc_xml_cache
 {
+  /* The fully expanded XML text, with all XIncludes processed.  */
   const char *xml_document;
   struct target_desc *tdesc;
 };
-typedef struct tdesc_xml_cache tdesc_xml_cache_s;
-DEF_VEC_O(tdesc_xml_cache_s);
 
-static VEC(tdesc_xml_cache_s) *xml_cache;
+/* The parsed descriptions, hashed by their expanded XML text.  */
+
+static htab_t xml_cache;
+
+/* A target-supplied digest (see TARGET_OBJECT_AVAILABLE_FEATURES_HASH)
+   that is known to identify the description in CACHE.  Several
+   targets may report different digests for the same document.  */
+
+struct tdesc_target_hash
+{
+  char *target_hash;
+  struct tdesc_xml_cache *cache;
+};
+
+/* The known target digests, hashed by the digest string.  */
+
+static htab_t target_hash_cache;
+
+static hashval_t
+hash_tdesc_xml_cache (const void *p)
+{
+  const struct tdesc_xml_cache *cache = p;
+
+  return htab_hash_string (cache->xml_document);
+}
+
+static int
+eq_tdesc_xml_cache (const void *a, const void *b)
+{
+  const struct tdesc_xml_cache *ca = a;
+  const struct tdesc_xml_cache *cb = b;
+
+  return strcmp (ca->xml_document, cb->xml_document) == 0;
+}
+
+static hashval_t
+hash_tdesc_target_hash (const void *p)
+{
+  const struct tdesc_target_hash *entry = p;
+
+  return htab_hash_string (entry->target_hash);
+}
+
+static int
+eq_tdesc_target_hash (const void *a, const void *b)
+{
+  const struct tdesc_target_hash *ea = a;
+  const struct tdesc_target_hash *eb = b;
+
+  return strcmp (ea->target_hash, eb->target_hash) == 0;
+}
+
+/* Return the cache entry recorded for TARGET_HASH, or NULL.  */
+
+static struct tdesc_xml_cache *
+tdesc_find_target_hash (const char *target_hash)
+{
+  struct tdesc_target_hash key, *entry;
+
+  if (target_hash_cache == NULL)
+    return NULL;
+
+  key.target_hash = (char *) target_hash;
+  entry = htab_find (target_hash_cache, &key);
+  return entry != NULL ? entry->cache : NULL;
+}
+
+/* Remember that TARGET_HASH identifies the description in CACHE.  */
+
+static void
+tdesc_record_target_hash (const char *target_hash,
+			  struct tdesc_xml_cache *cache)
+{
+  struct tdesc_target_hash key, *entry;
+  void **slot;
+
+  if (target_hash_cache == NULL)
+    target_hash_cache = htab_create_alloc (8, hash_tdesc_target_hash,
+					   eq_tdesc_target_hash, NULL,
+					   xcalloc, xfree);
+
+  key.target_hash = (char *) target_hash;
+  slot = htab_find_slot (target_hash_cache, &key, INSERT);
+  if (*slot != NULL)
+    {
+      /* The digest should not change meaning, but if it does the
+	 text we just fetched wins.  */
+      entry = *slot;
+      entry->cache = cache;
+      return;
+    }
+
+  entry = XNEW (struct tdesc_target_hash);
+  entry->target_hash = xstrdup (target_hash);
+  entry->cache = cache;
+  *slot = entry;
+}
+
+/* Return the description already parsed for TARGET_HASH, or NULL.  */
+
+static struct target_desc *
+tdesc_lookup_target_hash (const char *target_hash)
+{
+  struct tdesc_xml_cache *cache = tdesc_find_target_hash (target_hash);
+
+  return cache != NULL ? cache->tdesc : NULL;
+}
+
+/* Return the expanded XML text parsed for TARGET_HASH, or NULL.  */
+
+static const char *
+tdesc_target_hash_document (const char *target_hash)
+{
+  struct tdesc_xml_cache *cache = tdesc_find_target_hash (target_hash);
+
+  return cache != NULL ? cache->xml_document : NULL;
+}
 
 /* Callback data for target description parsing.  */
 
@@ -499,17 +636,21 @@ static const struct gdb_xml_element tdesc_elements[] = {
   { NULL, NULL, NULL, GDB_XML_EF_NONE, NULL, NULL }
 };
 
-/* Parse DOCUMENT into a target description and return it.  */
+/* Parse DOCUMENT into a target description and return it.  If
+   TARGET_HASH is not NULL, it is the digest the target reported for
+   DOCUMENT; remember it, so that the next time the target reports
+   the same digest the description can be used without fetching
+   DOCUMENT again.  */
 
 static struct target_desc *
 tdesc_parse_xml (const char *document, xml_fetch_another fetcher,
-		 void *fetcher_baton)
+		 void *fetcher_baton, const char *target_hash)
 {
   struct cleanup *back_to, *result_cleanup;
   struct tdesc_parsing_data data;
-  struct tdesc_xml_cache *cache;
+  struct tdesc_xml_cache key, *cache;
   char *expanded_text;
-  int ix;
+  void **slot;
 
   /* Expand all XInclude directives.  */
   expanded_text = xml_process_xincludes (_("target description"),
@@ -520,15 +661,22 @@ tdesc_parse_xml (const char *document, xml_fetch_another fetcher,
       return NULL;
     }
 
-  /* Check for an exact match in the list of descriptions we have
-     previously parsed.  strcmp is a slightly inefficient way to
-     do this; an SHA-1 checksum would work as well.  */
-  for (ix = 0; VEC_iterate (tdesc_xml_cache_s, xml_cache, ix, cache); ix++)
-    if (strcmp (cache->xml_document, expanded_text) == 0)
-      {
-       xfree (expanded_text);
-       return cache->tdesc;
-      }
+  /* Check for an exact match among the descriptions we have
+     previously parsed.  */
+  if (xml_cache == NULL)
+    xml_cache = htab_create_alloc (8, hash_tdesc_xml_cache,
+				   eq_tdesc_xml_cache, NULL,
+				   xcalloc, xfree);
+
+  key.xml_document = expanded_text;
+  cache = htab_find (xml_cache, &key);
+  if (cache != NULL)
+    {
+      xfree (expanded_text);
+      if (target_hash != NULL)
+	tdesc_record_target_hash (target_hash, cache);
+      return cache->tdesc;
+    }
 
   back_to = make_cleanup (null_cleanup, NULL);
 
@@ -541,13 +689,15 @@ tdesc_parse_xml (const char *document, xml_fetch_another fetcher,
 			   tdesc_elements, expanded_text, &data) == 0)
     {
       /* Parsed successfully.  */
-      struct tdesc_xml_cache new_cache;
-
-      new_cache.xml_document = expanded_text;
-      new_cache.tdesc = data.tdesc;
-      VEC_safe_push (tdesc_xml_cache_s, xml_cache, &new_cache);
+      cache = XNEW (struct tdesc_xml_cache);
+      cache->xml_document = expanded_text;
+      cache->tdesc = data.tdesc;
+      slot = htab_find_slot (xml_cache, cache, INSERT);
+      *slot = cache;
+      if (target_hash != NULL)
+	tdesc_record_target_hash (target_hash, cache);
       discard_cleanups (result_cleanup);
-      do_cleanups (back_to);
+      discard_cleanups (back_to);
       return data.tdesc;
     }
   else
@@ -584,7 +734,8 @@ file_read_description_xml (const char *filename)
   if (dirname != NULL)
     make_cleanup (xfree, dirname);
 
-  tdesc = tdesc_parse_xml (tdesc_str, xml_fetch_content_from_file, dirname);
+  tdesc = tdesc_parse_xml (tdesc_str, xml_fetch_content_from_file, dirname,
+			   NULL);
   do_cleanups (back_to);
 
   return tdesc;
@@ -610,24 +761,161 @@ fetch_available_features_from_target (const char *name, void *baton_)
 }
 
 
+/* Return non-zero if TARGET_HASH looks like a digest a target would
+   report: a short, non-empty string of hex digits.  Anything else is
+   ignored, which also keeps it safe to use as a file name.  */
+
+static int
+tdesc_valid_target_hash (const char *target_hash)
+{
+  const char *p;
+
+  for (p = target_hash; *p != '\0'; p++)
+    if (!ISXDIGIT (*p))
+      return 0;
+
+  return p > target_hash && p - target_hash <= 128;
+}
+
+/* Return the name of the file caching the description with digest
+   TARGET_HASH, or NULL if there is no cache directory.  The result
+   is malloc allocated.  */
+
+static char *
+tdesc_cache_file_name (const char *target_hash)
+{
+  if (tdesc_cache_directory == NULL || *tdesc_cache_directory == '\0')
+    return NULL;
+
+  return concat (tdesc_cache_directory, SLASH_STRING, target_hash, ".xml",
+		 (char *) NULL);
+}
+
+/* Try to load the description with digest TARGET_HASH from the cache
+   directory.  Return NULL if it is not there.  */
+
+static const struct target_desc *
+tdesc_cache_load (const char *target_hash)
+{
+  struct target_desc *tdesc;
+  struct cleanup *back_to;
+  char *filename, *tdesc_str;
+
+  filename = tdesc_cache_file_name (target_hash);
+  if (filename == NULL)
+    return NULL;
+
+  back_to = make_cleanup (xfree, filename);
+  tdesc_str = xml_fetch_content_from_file (filename, NULL);
+  if (tdesc_str == NULL)
+    {
+      do_cleanups (back_to);
+      return NULL;
+    }
+
+  /* The cached copy was saved with its XIncludes already expanded.  */
+  make_cleanup (xfree, tdesc_str);
+  tdesc = tdesc_parse_xml (tdesc_str, xml_fetch_content_from_file, NULL,
+			   target_hash);
+  do_cleanups (back_to);
+
+  return tdesc;
+}
+
+/* Save the expanded text of the description with digest TARGET_HASH
+   in the cache directory, if there is one.  Failures are silently
+   ignored; the cache is only an optimization.  */
+
+static void
+tdesc_cache_store (const char *target_hash)
+{
+  const char *document;
+  struct cleanup *back_to;
+  char *filename, *tmpname;
+  size_t len;
+  FILE *file;
+  int ok;
+
+  document = tdesc_target_hash_document (target_hash);
+  if (document == NULL)
+    return;
+
+  filename = tdesc_cache_file_name (target_hash);
+  if (filename == NULL)
+    return;
+
+  /* Write to a temporary name and rename it into place, so that a
+     concurrent GDB never reads a partial file.  */
+  back_to = make_cleanup (xfree, filename);
+  tmpname = xstrprintf ("%s.%ld", filename, (long) getpid ());
+  make_cleanup (xfree, tmpname);
+
+  file = gdb_fopen_cloexec (tmpname, FOPEN_WT);
+  if (file == NULL)
+    {
+      do_cleanups (back_to);
+      return;
+    }
+
+  len = strlen (document);
+  ok = fwrite (document, 1, len, file) == len;
+  ok = (fclose (file) == 0) && ok;
+  if (!ok || rename (tmpname, filename) != 0)
+    unlink (tmpname);
+
+  do_cleanups (back_to);
+}
+
 /* Read an XML target description using OPS.  Parse it, and return the
    parsed description.  */
 
 const struct target_desc *
 target_read_description_xml (struct target_ops *ops)
 {
-  struct target_desc *tdesc;
-  char *tdesc_str;
+  const struct target_desc *tdesc;
+  char *tdesc_str, *target_hash;
   struct cleanup *back_to;
 
+  back_to = make_cleanup (null_cleanup, NULL);
+
+  /* If the target can identify its description, we may already have
+     it, either from an earlier connection in this session or from the
+     cache directory.  Then there is no need to transfer it again.  */
+  target_hash = target_read_stralloc (ops,
+				      TARGET_OBJECT_AVAILABLE_FEATURES_HASH,
+				      "target.xml");
+  if (target_hash != NULL)
+    {
+      make_cleanup (xfree, target_hash);
+      if (!tdesc_valid_target_hash (target_hash))
+	target_hash = NULL;
+    }
+
+  if (target_hash != NULL)
+    {
+      tdesc = tdesc_lookup_target_hash (target_hash);
+      if (tdesc == NULL)
+	tdesc = tdesc_cache_load (target_hash);
+      if (tdesc != NULL)
+	{
+	  do_cleanups (back_to);
+	  return tdesc;
+	}
+    }
+
   tdesc_str = fetch_available_features_from_target ("target.xml", ops);
   if (tdesc_str == NULL)
-    return NULL;
+    {
+      do_cleanups (back_to);
+      return NULL;
+    }
 
-  back_to = make_cleanup (xfree, tdesc_str);
+  make_cleanup (xfree, tdesc_str);
   tdesc = tdesc_parse_xml (tdesc_str,
 			   fetch_available_features_from_target,
-			   ops);
+			   ops, target_hash);
+  if (tdesc != NULL && target_hash != NULL)
+    tdesc_cache_store (target_hash);
   do_cleanups (back_to);
 
   return tdesc;
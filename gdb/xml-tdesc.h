@@ -31,3 +31,9 @@ const struct target_desc *file_read_description_xml (const char *filename);
    parsed description.  */
 
 const struct target_desc *target_read_description_xml (struct target_ops *);
+
+/* The directory in which to keep copies of target descriptions
+   fetched from targets that report a digest for them, or NULL or
+   empty for none.  See "set tdesc cache-directory".  */
+
+extern char *tdesc_cache_directory;
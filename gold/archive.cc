@@ -727,14 +727,100 @@ Archive::read_symbols(off_t off)
   this->members_[off] = member;
 }
 
+// The value in armap_next_ at the end of a chain.
+
+static const size_t no_armap_entry = static_cast<size_t>(-1);
+
+// Hash a name in the archive map, stopping at any version.
+
+size_t
+Archive::Armap_name_hash::operator()(const char* name) const
+{
+  size_t h = 5381;
+  for (const char* p = name; *p != '\0' && *p != '@'; ++p)
+    h = h * 33 + static_cast<unsigned char>(*p);
+  return h;
+}
+
+// Compare two names in the archive map, stopping at any version.
+
+bool
+Archive::Armap_name_eq::operator()(const char* a, const char* b) const
+{
+  while (*a != '\0' && *a != '@')
+    {
+      if (*a != *b)
+	return false;
+      ++a;
+      ++b;
+    }
+  return *b == '\0' || *b == '@';
+}
+
+// Build the index of the names in the archive map.
+
+void
+Archive::build_armap_index()
+{
+  const size_t armap_size = this->armap_.size();
+  this->armap_next_.resize(armap_size);
+  for (size_t i = 0; i < armap_size; ++i)
+    {
+      const char* sym_name = (this->armap_names_.data()
+			      + this->armap_[i].name_offset);
+      std::pair<Armap_index::iterator, bool> ins =
+	this->armap_index_.insert(std::make_pair(sym_name, i));
+      if (ins.second)
+	this->armap_next_[i] = no_armap_entry;
+      else
+	{
+	  this->armap_next_[i] = ins.first->second;
+	  ins.first->second = i;
+	}
+    }
+}
+
+// Add to *PENDING the unchecked entries in the archive map before
+// LIMIT for the undefined symbols of OBJ, which we just included.
+// Including OBJ can only change whether an entry selects its member
+// if OBJ refers to the entry's symbol, so these are the only entries
+// which need to be checked again.
+
+void
+Archive::add_pending_entries(const Object* obj, size_t limit,
+			     Armap_index_set* pending)
+{
+  if (this->armap_next_.empty() && !this->armap_.empty())
+    this->build_armap_index();
+
+  const Object::Symbols* syms = obj->get_global_symbols();
+  if (syms == NULL)
+    return;
+  for (Object::Symbols::const_iterator p = syms->begin();
+       p != syms->end();
+       ++p)
+    {
+      if (*p == NULL || !(*p)->is_undefined())
+	continue;
+      Armap_index::const_iterator q = this->armap_index_.find((*p)->name());
+      if (q == this->armap_index_.end())
+	continue;
+      for (size_t i = q->second; i != no_armap_entry; i = this->armap_next_[i])
+	if (i < limit && !this->armap_checked_[i])
+	  pending->insert(i);
+    }
+}
+
 // Select members from the archive and add them to the link.  We walk
 // through the elements in the archive map, and look each one up in
 // the symbol table.  If it exists as a strong undefined symbol, we
-// pull in the corresponding element.  We have to do this in a loop,
-// since pulling in one element may create new undefined symbols which
-// may be satisfied by other objects in the archive.  Return true in
-// the normal case, false if the first member we tried to add from
-// this archive had an incompatible target.
+// pull in the corresponding element.  Pulling in one element may
+// create new undefined symbols which may be satisfied by other
+// objects in the archive, so after the first walk we look again at
+// the entries for those symbols, in further walks in the same order,
+// until no more elements are pulled in.  Return true in the normal
+// case, false if the first member we tried to add from this archive
+// had an incompatible target.
 
 bool
 Archive::add_symbols(Symbol_table* symtab, Layout* layout,
@@ -757,65 +843,84 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
   // offset we saw that was present in the seen_offsets_ set.
   off_t last_seen_offset = -1;
 
-  // Track which symbols in the symbol table we've already found to be
-  // defined.
+  // The entries to check again in a later walk, because a member we
+  // included refers to their symbols.  During the first walk we only
+  // need to add the entries we have already passed.
+  Armap_index_set pending;
+  bool first_walk = true;
 
   char* tmpbuf = NULL;
   size_t tmpbuflen = 0;
-  bool added_new_object;
-  do
+  size_t next = 0;
+  while (true)
     {
-      added_new_object = false;
-      for (size_t i = 0; i < armap_size; ++i)
+      size_t i;
+      if (first_walk && next < armap_size)
+	i = next;
+      else
 	{
-          if (this->armap_checked_[i])
-            continue;
-	  if (this->armap_[i].file_offset == last_seen_offset)
-            {
-              this->armap_checked_[i] = true;
-              continue;
-            }
-	  if (this->seen_offsets_.find(this->armap_[i].file_offset)
-              != this->seen_offsets_.end())
-	    {
-              this->armap_checked_[i] = true;
-	      last_seen_offset = this->armap_[i].file_offset;
-	      continue;
-	    }
+	  // Take the next pending entry in this walk, or start the
+	  // next walk.
+	  first_walk = false;
+	  Armap_index_set::iterator p = pending.lower_bound(next);
+	  if (p == pending.end())
+	    p = pending.begin();
+	  if (p == pending.end())
+	    break;
+	  i = *p;
+	  pending.erase(p);
+	}
+      next = i + 1;
 
-	  const char* sym_name = (this->armap_names_.data()
-				  + this->armap_[i].name_offset);
+      if (this->armap_checked_[i])
+	continue;
+      if (this->armap_[i].file_offset == last_seen_offset)
+	{
+	  this->armap_checked_[i] = true;
+	  continue;
+	}
+      if (this->seen_offsets_.find(this->armap_[i].file_offset)
+	  != this->seen_offsets_.end())
+	{
+	  this->armap_checked_[i] = true;
+	  last_seen_offset = this->armap_[i].file_offset;
+	  continue;
+	}
 
-          Symbol* sym;
-          std::string why;
-          Archive::Should_include t =
-	    Archive::should_include_member(symtab, layout, sym_name, &sym,
-					   &why, &tmpbuf, &tmpbuflen);
+      const char* sym_name = (this->armap_names_.data()
+			      + this->armap_[i].name_offset);
 
-	  if (t == Archive::SHOULD_INCLUDE_NO
-              || t == Archive::SHOULD_INCLUDE_YES)
-	    this->armap_checked_[i] = true;
+      Symbol* sym;
+      std::string why;
+      Archive::Should_include t =
+	Archive::should_include_member(symtab, layout, sym_name, &sym,
+				       &why, &tmpbuf, &tmpbuflen);
 
-	  if (t != Archive::SHOULD_INCLUDE_YES)
-	    continue;
+      if (t == Archive::SHOULD_INCLUDE_NO
+	  || t == Archive::SHOULD_INCLUDE_YES)
+	this->armap_checked_[i] = true;
 
-	  // We want to include this object in the link.
-	  last_seen_offset = this->armap_[i].file_offset;
-	  this->seen_offsets_.insert(last_seen_offset);
+      if (t != Archive::SHOULD_INCLUDE_YES)
+	continue;
 
-	  if (!this->include_member(symtab, layout, input_objects,
-				    last_seen_offset, mapfile, sym,
-				    why.c_str()))
-	    {
-	      if (tmpbuf != NULL)
-		free(tmpbuf);
-	      return false;
-	    }
+      // We want to include this object in the link.
+      last_seen_offset = this->armap_[i].file_offset;
+      this->seen_offsets_.insert(last_seen_offset);
 
-	  added_new_object = true;
+      Object* obj = NULL;
+      if (!this->include_member(symtab, layout, input_objects,
+				last_seen_offset, mapfile, sym,
+				why.c_str(), &obj))
+	{
+	  if (tmpbuf != NULL)
+	    free(tmpbuf);
+	  return false;
 	}
+
+      if (obj != NULL)
+	this->add_pending_entries(obj, first_walk ? i : armap_size,
+				  &pending);
     }
-  while (added_new_object);
 
   if (tmpbuf != NULL)
     free(tmpbuf);
@@ -884,7 +989,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->first,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -896,7 +1001,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->off,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -930,7 +1035,8 @@ Archive::count_members()
 bool
 Archive::include_member(Symbol_table* symtab, Layout* layout,
 			Input_objects* input_objects, off_t off,
-			Mapfile* mapfile, Symbol* sym, const char* why)
+			Mapfile* mapfile, Symbol* sym, const char* why,
+			Object** pobj)
 {
   ++Archive::total_members_loaded;
 
@@ -947,6 +1053,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
           obj->layout(symtab, layout, sd);
           obj->add_symbols(symtab, sd, layout);
 	  this->included_member_ = true;
+	  if (pobj != NULL)
+	    *pobj = obj;
         }
       delete sd;
       return true;
@@ -977,6 +1085,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
     {
       pluginobj->add_symbols(symtab, NULL, layout);
       this->included_member_ = true;
+      if (pobj != NULL)
+	*pobj = obj;
       return true;
     }
 
@@ -1005,6 +1115,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
         obj->unlock(this->task_);
 
       this->included_member_ = true;
+      if (pobj != NULL)
+	*pobj = obj;
     }
 
   return true;
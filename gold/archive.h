@@ -23,6 +23,7 @@
 #ifndef GOLD_ARCHIVE_H
 #define GOLD_ARCHIVE_H
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -331,10 +332,25 @@ class Archive : public Library_base
   bool
   include_all_members(Symbol_table*, Layout*, Input_objects*, Mapfile*);
 
-  // Include an archive member in the link.
+  // Include an archive member in the link.  If POBJ is not NULL, set
+  // *POBJ to the object if its symbols were added to the link.
   bool
   include_member(Symbol_table*, Layout*, Input_objects*, off_t off,
-		 Mapfile*, Symbol*, const char* why);
+		 Mapfile*, Symbol*, const char* why, Object** pobj);
+
+  // A set of indexes into the archive map.
+  typedef std::set<size_t> Armap_index_set;
+
+  // Build armap_index_.
+  void
+  build_armap_index();
+
+  // Add to *PENDING the entries in the archive map which have not
+  // been checked, whose index is less than LIMIT, and which are
+  // for a symbol which OBJ refers to but does not define.
+  void
+  add_pending_entries(const Object* obj, size_t limit,
+		      Armap_index_set* pending);
 
   // Return whether we found this archive by searching a directory.
   bool
@@ -373,6 +389,28 @@ class Archive : public Library_base
     { return static_cast<size_t>(val); }
   };
 
+  // Hash a name in the archive map, ignoring any version.
+  class Armap_name_hash
+  {
+   public:
+    size_t
+    operator()(const char*) const;
+  };
+
+  // Compare names in the archive map, ignoring any version.
+  class Armap_name_eq
+  {
+   public:
+    bool
+    operator()(const char*, const char*) const;
+  };
+
+  // Map a symbol name, without any version, to the last entry in the
+  // archive map with that name.  The other entries with the same name
+  // are chained through armap_next_.
+  typedef Unordered_map<const char*, size_t, Armap_name_hash,
+			Armap_name_eq> Armap_index;
+
   // For keeping track of open nested archives in a thin archive file.
   typedef Unordered_map<std::string, Archive*> Nested_archive_table;
 
@@ -391,6 +429,14 @@ class Archive : public Library_base
   std::vector<bool> armap_checked_;
   // Track which elements have been included by offset.
   Unordered_set<off_t, Seen_hash> seen_offsets_;
+  // The names in the archive map, built when we first include a
+  // member.  When we include a member, we use this to find the
+  // entries which its undefined symbols may now select, rather than
+  // checking every entry again.
+  Armap_index armap_index_;
+  // For each entry in the archive map, the previous entry with the
+  // same name, or -1 if there is none.
+  std::vector<size_t> armap_next_;
   // Table of objects whose symbols have been pre-read.
   std::map<off_t, Archive_member> members_;
   // True if this is a thin archive.
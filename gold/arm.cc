@@ -1671,13 +1671,14 @@ class Arm_relobj : public Sized_relobj_file<32, big_endian>
   // Count the local symbols.
   void
   do_count_local_symbols(Stringpool_template<char>*,
-			 Stringpool_template<char>*);
+			 Stringpool_template<char>*, size_t);
 
   void
   do_relocate_sections(
       const Symbol_table* symtab, const Layout* layout,
       const unsigned char* pshdrs, Output_file* of,
-      typename Sized_relobj_file<32, big_endian>::Views* pivews);
+      typename Sized_relobj_file<32, big_endian>::Views* pivews,
+      Workqueue* workqueue);
 
   // Read the symbol information.
   void
@@ -6346,13 +6347,15 @@ template<bool big_endian>
 void
 Arm_relobj<big_endian>::do_count_local_symbols(
     Stringpool_template<char>* pool,
-    Stringpool_template<char>* dynpool)
+    Stringpool_template<char>* dynpool,
+    size_t position)
 {
   // We need to fix-up the values of any local symbols whose type are
   // STT_ARM_TFUNC.
 
   // Ask parent to count the local symbols.
-  Sized_relobj_file<32, big_endian>::do_count_local_symbols(pool, dynpool);
+  Sized_relobj_file<32, big_endian>::do_count_local_symbols(pool, dynpool,
+							    position);
   const unsigned int loccount = this->local_symbol_count();
   if (loccount == 0)
     return;
@@ -6443,11 +6446,13 @@ Arm_relobj<big_endian>::do_relocate_sections(
     const Layout* layout,
     const unsigned char* pshdrs,
     Output_file* of,
-    typename Sized_relobj_file<32, big_endian>::Views* pviews)
+    typename Sized_relobj_file<32, big_endian>::Views* pviews,
+    Workqueue* workqueue)
 {
   // Call parent to relocate sections.
   Sized_relobj_file<32, big_endian>::do_relocate_sections(symtab, layout,
-							  pshdrs, of, pviews);
+							  pshdrs, of, pviews,
+							  workqueue);
 
   // We do not generate stubs if doing a relocatable link.
   if (parameters->options().relocatable())
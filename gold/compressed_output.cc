@@ -28,6 +28,7 @@
 
 #include "parameters.h"
 #include "options.h"
+#include "workqueue.h"
 #include "compressed_output.h"
 
 namespace gold
@@ -35,6 +36,135 @@ namespace gold
 
 #ifdef HAVE_ZLIB_H
 
+// Large sections are compressed in chunks of this size, which may be
+// compressed at once by several threads.  Each chunk is compressed
+// with a raw deflate stream, primed with the last window of data of
+// the previous chunk, and ends with a sync flush so that the next
+// chunk starts on a byte boundary.  The chunks together with a zlib
+// header and the Adler-32 checksum of all the data make a single zlib
+// stream.  A section of one chunk is compressed exactly as compress2
+// would do it.  The chunks do not depend on the number of threads,
+// so neither does the output.
+
+static const unsigned long zlib_chunk_size = 1024 * 1024;
+
+// The size of the deflate window.
+
+static const unsigned long zlib_window_size = 32 * 1024;
+
+// The most helper tasks to use when the thread count is not known.
+
+static const size_t parallel_compress_max_helpers = 8;
+
+// A chunk of a section being compressed.
+
+struct Zlib_chunk
+{
+  // The compressed data, allocated using new.
+  unsigned char* data;
+  // The size of the compressed data.
+  unsigned long size;
+  // The Adler-32 checksum of the uncompressed data.
+  uLong adler;
+  // Whether the chunk was compressed successfully.
+  bool ok;
+
+  Zlib_chunk()
+    : data(NULL), size(0), adler(0), ok(false)
+  { }
+};
+
+// Compress the chunk at OFFSET in UNCOMPRESSED_DATA of LENGTH bytes,
+// using COMPRESS_LEVEL, into CHUNK.  IS_LAST is true for the last
+// chunk of the section.
+
+static void
+zlib_compress_chunk(const unsigned char* uncompressed_data,
+		    unsigned long offset, unsigned long length,
+		    bool is_last, int compress_level, Zlib_chunk* chunk)
+{
+  const Bytef* in = reinterpret_cast<const Bytef*>(uncompressed_data
+						   + offset);
+  chunk->adler = adler32(adler32(0, Z_NULL, 0), in, length);
+
+  z_stream strm;
+  memset(&strm, 0, sizeof strm);
+  if (deflateInit2(&strm, compress_level, Z_DEFLATED, -MAX_WBITS, 8,
+		   Z_DEFAULT_STRATEGY) != Z_OK)
+    return;
+
+  if (offset > 0)
+    {
+      unsigned long dict_size = std::min(offset, zlib_window_size);
+      if (deflateSetDictionary(&strm, in - dict_size, dict_size) != Z_OK)
+	{
+	  deflateEnd(&strm);
+	  return;
+	}
+    }
+
+  // Leave room for the sync flush marker.
+  unsigned long bound = deflateBound(&strm, length) + 16;
+  chunk->data = new unsigned char[bound];
+  strm.next_in = const_cast<Bytef*>(in);
+  strm.avail_in = length;
+  strm.next_out = reinterpret_cast<Bytef*>(chunk->data);
+  strm.avail_out = bound;
+  int rc = deflate(&strm, is_last ? Z_FINISH : Z_SYNC_FLUSH);
+  if (is_last)
+    chunk->ok = rc == Z_STREAM_END;
+  else
+    chunk->ok = rc == Z_OK && strm.avail_in == 0 && strm.avail_out > 0;
+  chunk->size = bound - strm.avail_out;
+  deflateEnd(&strm);
+}
+
+// The jobs to compress the chunks of a section.
+
+class Zlib_compress_work : public Parallel_work
+{
+ public:
+  Zlib_compress_work(const unsigned char* uncompressed_data,
+		     unsigned long uncompressed_size, int compress_level,
+		     std::vector<Zlib_chunk>* chunks)
+    : Parallel_work(chunks->size(), "zlib_compress"),
+      uncompressed_data_(uncompressed_data),
+      uncompressed_size_(uncompressed_size),
+      compress_level_(compress_level), chunks_(chunks)
+  { }
+
+ protected:
+  void
+  do_run(size_t i, const Task*)
+  {
+    unsigned long offset = i * zlib_chunk_size;
+    unsigned long length = std::min(zlib_chunk_size,
+				    this->uncompressed_size_ - offset);
+    bool is_last = i + 1 == this->chunks_->size();
+    zlib_compress_chunk(this->uncompressed_data_, offset, length, is_last,
+			this->compress_level_, &(*this->chunks_)[i]);
+  }
+
+ private:
+  const unsigned char* uncompressed_data_;
+  unsigned long uncompressed_size_;
+  int compress_level_;
+  std::vector<Zlib_chunk>* chunks_;
+};
+
+// Return the number of helper tasks to compress JOB_COUNT chunks.
+
+static size_t
+parallel_compress_helpers(size_t job_count)
+{
+  gold_assert(job_count > 0);
+  size_t helpers = job_count - 1;
+  size_t thread_count = parameters->options().thread_count_final();
+  if (thread_count == 0)
+    return std::min(helpers, parallel_compress_max_helpers);
+  return std::min(helpers, thread_count - 1);
+}
+
 // Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns true
 // if it successfully compressed, false if it failed for any reason
 // (including not having zlib support in the library).  If it returns
@@ -42,17 +172,18 @@ namespace gold
 // sets *COMPRESSED_DATA and *COMPRESSED_SIZE to appropriate values.
 // It also writes a header before COMPRESSED_DATA: 4 bytes saying
 // "ZLIB", and 8 bytes indicating the uncompressed size, in big-endian
-// order.
+// order.  When using threads, the chunks are compressed by several
+// tasks queued on WORKQUEUE; TASK is the task calling this.
 
 static bool
 zlib_compress(const unsigned char* uncompressed_data,
               unsigned long uncompressed_size,
               unsigned char** compressed_data,
-              unsigned long* compressed_size)
+              unsigned long* compressed_size,
+	      Workqueue* workqueue,
+	      const Task* task)
 {
   const int header_size = 12;
-  *compressed_size = uncompressed_size + uncompressed_size / 1000 + 128;
-  *compressed_data = new unsigned char[*compressed_size + header_size];
 
   int compress_level;
   if (parameters->options().optimize() >= 1)
@@ -60,25 +191,73 @@ zlib_compress(const unsigned char* uncompressed_data,
   else
     compress_level = 1;
 
-  int rc = compress2(reinterpret_cast<Bytef*>(*compressed_data) + header_size,
-                     compressed_size,
-                     reinterpret_cast<const Bytef*>(uncompressed_data),
-                     uncompressed_size,
-                     compress_level);
-  if (rc == Z_OK)
+  size_t chunk_count = ((uncompressed_size + zlib_chunk_size - 1)
+			/ zlib_chunk_size);
+  if (chunk_count == 0)
+    chunk_count = 1;
+  std::vector<Zlib_chunk> chunks(chunk_count);
+  size_t helpers = 0;
+  if (workqueue != NULL && parameters->options().threads())
+    helpers = parallel_compress_helpers(chunk_count);
+  Zlib_compress_work* work = new Zlib_compress_work(uncompressed_data,
+						    uncompressed_size,
+						    compress_level, &chunks);
+  work->run(workqueue, task, helpers);
+
+  bool ok = true;
+  unsigned long size = header_size + 2 + 4;
+  for (size_t i = 0; i < chunk_count; ++i)
     {
-      memcpy(*compressed_data, "ZLIB", 4);
-      elfcpp::Swap_unaligned<64, true>::writeval(*compressed_data + 4,
-						 uncompressed_size);
-      *compressed_size += header_size;
-      return true;
+      ok = ok && chunks[i].ok;
+      size += chunks[i].size;
     }
-  else
+
+  if (ok)
     {
-      delete[] *compressed_data;
-      *compressed_data = NULL;
-      return false;
+      *compressed_size = size;
+      *compressed_data = new unsigned char[size];
+      unsigned char* p = *compressed_data;
+      memcpy(p, "ZLIB", 4);
+      elfcpp::Swap_unaligned<64, true>::writeval(p + 4, uncompressed_size);
+      p += header_size;
+
+      // Write the zlib header the way deflate writes it.
+      unsigned int level_flags;
+      if (compress_level < 2)
+	level_flags = 0;
+      else if (compress_level < 6)
+	level_flags = 1;
+      else if (compress_level == 6)
+	level_flags = 2;
+      else
+	level_flags = 3;
+      unsigned int zlib_header = (((Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8)
+				  | (level_flags << 6));
+      zlib_header += 31 - zlib_header % 31;
+      elfcpp::Swap_unaligned<16, true>::writeval(p, zlib_header);
+      p += 2;
+
+      uLong adler = adler32(0, Z_NULL, 0);
+      for (size_t i = 0; i < chunk_count; ++i)
+	{
+	  memcpy(p, chunks[i].data, chunks[i].size);
+	  p += chunks[i].size;
+	  unsigned long length = std::min(zlib_chunk_size,
+					  uncompressed_size
+					  - i * zlib_chunk_size);
+	  adler = adler32_combine(adler, chunks[i].adler, length);
+	}
+      elfcpp::Swap_unaligned<32, true>::writeval(p, adler);
+      p += 4;
+      gold_assert(p == *compressed_data + size);
     }
+  else
+    *compressed_data = NULL;
+
+  for (size_t i = 0; i < chunk_count; ++i)
+    delete[] chunks[i].data;
+
+  return ok;
 }
 
 // Decompress COMPRESSED_DATA of size COMPRESSED_SIZE, into a buffer
@@ -128,7 +307,7 @@ zlib_decompress(const unsigned char* compressed_data,
 
 static bool
 zlib_compress(const unsigned char*, unsigned long,
-              unsigned char**, unsigned long*)
+              unsigned char**, unsigned long*, Workqueue*, const Task*)
 {
   return false;
 }
@@ -191,16 +370,20 @@ decompress_input_section(const unsigned char* compressed_data,
 
 // Class Output_compressed_section.
 
-// Set the final data size of a compressed section.  This is where
-// we actually compress the section data.
+// Compress the section data.  This is called once all the input
+// sections have been written, before the offsets of the
+// postprocessing sections are set.
 
 void
-Output_compressed_section::set_final_data_size()
+Output_compressed_section::compress(Workqueue* workqueue, const Task* task)
 {
+  gold_assert(!this->is_compressed_);
+  this->is_compressed_ = true;
+
   off_t uncompressed_size = this->postprocessing_buffer_size();
 
   // (Try to) compress the data.
-  unsigned long compressed_size;
+  unsigned long compressed_size = 0;
   unsigned char* uncompressed_data = this->postprocessing_buffer();
 
   // At this point the contents of all regular input sections will
@@ -212,20 +395,34 @@ Output_compressed_section::set_final_data_size()
   bool success = false;
   if (strcmp(this->options_->compress_debug_sections(), "zlib") == 0)
     success = zlib_compress(uncompressed_data, uncompressed_size,
-                            &this->data_, &compressed_size);
+                            &this->data_, &compressed_size,
+			    workqueue, task);
   if (success)
-    {
-      // This converts .debug_foo to .zdebug_foo
-      this->new_section_name_ = std::string(".z") + (this->name() + 1);
-      this->set_name(this->new_section_name_.c_str());
-      this->set_data_size(compressed_size);
-    }
+    this->data_size_ = compressed_size;
   else
     {
       gold_warning(_("not compressing section data: zlib error"));
       gold_assert(this->data_ == NULL);
-      this->set_data_size(uncompressed_size);
+      this->data_size_ = uncompressed_size;
+    }
+}
+
+// Set the final data size of a compressed section.  This is where we
+// compress the section data, if that was not done already.
+
+void
+Output_compressed_section::set_final_data_size()
+{
+  if (!this->is_compressed_)
+    this->compress(NULL, NULL);
+
+  if (this->data_ != NULL)
+    {
+      // This converts .debug_foo to .zdebug_foo
+      this->new_section_name_ = std::string(".z") + (this->name() + 1);
+      this->set_name(this->new_section_name_.c_str());
     }
+  this->set_data_size(this->data_size_);
 }
 
 // Write out a compressed section.  If we couldn't compress, we just
@@ -36,6 +36,8 @@ namespace gold
 {
 
 class General_options;
+class Workqueue;
+class Task;
 
 // Read the compression header of a compressed debug section and return
 // the uncompressed size.
@@ -60,9 +62,16 @@ class Output_compressed_section : public Output_section
 			    const char* name, elfcpp::Elf_Word flags,
 			    elfcpp::Elf_Xword type)
     : Output_section(name, flags, type),
-      options_(options)
+      options_(options), is_compressed_(false), data_(NULL), data_size_(0)
   { this->set_requires_postprocessing(); }
 
+  // Compress the section data, once all the input sections have been
+  // written.  Large sections are compressed in chunks, several at once
+  // when using threads; TASK is the task calling this.  If this is not
+  // called, set_final_data_size compresses the data itself.
+  void
+  compress(Workqueue* workqueue, const Task* task);
+
  protected:
   // Set the final data size.
   void
@@ -75,8 +84,12 @@ class Output_compressed_section : public Output_section
  private:
   // The options--this includes the compression type.
   const General_options* options_;
-  // The compressed data.
+  // Whether compress has been called.
+  bool is_compressed_;
+  // The compressed data, or NULL if we could not compress it.
   unsigned char* data_;
+  // The size of the compressed data.
+  off_t data_size_;
   // The new section name if we do compress.
   std::string new_section_name_;
 };
@@ -28,6 +28,8 @@
 #include <cstdlib>
 #include <cstring>
 #include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <vector>
 #include <algorithm>
@@ -45,6 +47,7 @@
 #include "compressed_output.h"
 #include "stringpool.h"
 #include "dwarf_reader.h"
+#include "workqueue.h"
 
 static void
 usage(FILE* fd, int) ATTRIBUTE_NORETURN;
@@ -91,29 +94,75 @@ struct Unit_set
   { }
 };
 
+// A compilation unit or type unit in an input file.
+
+struct Input_unit
+{
+  // The dwo_id of a compilation unit, or the signature of a type unit.
+  uint64_t signature;
+  // The offset and length of the unit within its input section.
+  // For a set read from the index of a .dwp file, these are not used.
+  Section_bounds bounds;
+  // For a set read from the index of a .dwp file, the section number,
+  // offset, and size of each column of its row in the index.
+  std::vector<std::pair<unsigned int, Section_bounds> > columns;
+
+  Input_unit()
+    : signature(0), bounds(), columns()
+  { }
+};
+
 // An input file.
 // This class may represent a .dwo file, a .dwp file
 // produced by an earlier run, or an executable file whose
 // debug section identifies a set of .dwo files to read.
+//
+// A .dwo or .dwp file is processed in three steps.  First, read
+// parses the file, which may be done for several files at once.
+// Second, add_to_output adds its strings and units to the output
+// file, and assigns the output offsets of its contributions; this
+// is done one file at a time, in order, so that the string offsets
+// and the indexes do not depend on the number of threads.  Third,
+// after the output file is laid out, write_contributions copies the
+// contents of the contributions into the output file, which may
+// again be done for several files at once.
 
 class Dwo_file
 {
  public:
   Dwo_file(const char* name)
-    : name_(name), obj_(NULL), input_file_(NULL), is_compressed_(),
-      sect_offsets_(), str_offset_map_()
+    : name_(name), obj_(NULL), input_file_(NULL), machine_(0), size_(0),
+      big_endian_(false), osabi_(0), abiversion_(0), is_compressed_(),
+      sect_offsets_(), str_offset_map_(), str_contents_(NULL), str_len_(0),
+      str_is_new_(false), strings_(), debug_shndx_(), section_sizes_(),
+      unit_lists_(), copies_()
   { }
 
   ~Dwo_file();
 
+  // Return the filename.
+  const char*
+  name() const
+  { return this->name_; }
+
   // Read the input executable file and extract the list of .dwo files
   // that it references.
   void
   read_executable(File_list* files);
 
-  // Read the input file and send its contents to OUTPUT_FILE.
+  // Read and parse the input file.
   void
-  read(Dwp_output_file* output_file);
+  read();
+
+  // Add the strings and units read from the input file to OUTPUT_FILE,
+  // and release the input file.
+  void
+  add_to_output(Dwp_output_file* output_file);
+
+  // Copy the contributions of the input file to OUTPUT_FILE, once
+  // its layout is final.
+  void
+  write_contributions(Dwp_output_file* output_file);
 
  private:
   // Types for mapping input string offsets to output string offsets.
@@ -130,16 +179,55 @@ class Dwo_file
     { return i1.first < i2.first; }
   };
 
+  // A string in the input string table.
+  struct Input_string
+  {
+    section_offset_type offset;
+    size_t length;
+    size_t hash_code;
+  };
+
+  // The units in one .debug_info.dwo or .debug_types.dwo section,
+  // or in one index section of a .dwp file.
+  struct Unit_list
+  {
+    // The .debug_info.dwo or .debug_types.dwo section.
+    unsigned int shndx;
+    // TRUE for type units.
+    bool is_debug_types;
+    // TRUE if the units were read from a .debug_cu_index or
+    // .debug_tu_index section.
+    bool is_index;
+    // The units, in the order in which they appear.
+    std::vector<Input_unit> units;
+  };
+
+  // A contribution of the input file to the output file.
+  struct Copy
+  {
+    // The output section.
+    elfcpp::DW_SECT section_id;
+    // The input section, and the offset of the contribution within it.
+    unsigned int shndx;
+    section_offset_type input_offset;
+    // The size of the contribution.
+    section_size_type size;
+    // The offset of the contribution within the output section.
+    section_offset_type output_offset;
+  };
+
   // Create a Sized_relobj_dwo of the given size and endianness,
-  // and record the target info.  P is a pointer to the ELF header
-  // in memory.
+  // and record the target info.
   Relobj*
-  make_object(Dwp_output_file* output_file);
+  make_object();
 
   template <int size, bool big_endian>
   Relobj*
-  sized_make_object(const unsigned char* p, Input_file* input_file,
-		    Dwp_output_file* output_file);
+  sized_make_object(const unsigned char* p, Input_file* input_file);
+
+  // Release the input file.
+  void
+  release();
 
   // Return the number of sections in the input object file.
   unsigned int
@@ -164,21 +252,23 @@ class Dwo_file
   { return this->obj_->decompressed_section_contents(shndx, plen, is_new); }
 
   // Read the .debug_cu_index or .debug_tu_index section of a .dwp file,
-  // and process the CU or TU sets.
+  // and collect the CU or TU sets.
   void
-  read_unit_index(unsigned int, unsigned int *, Dwp_output_file*,
-		  bool is_tu_index);
+  read_unit_index(unsigned int, unsigned int *, bool is_tu_index);
 
   template <bool big_endian>
   void
-  sized_read_unit_index(unsigned int, unsigned int *, Dwp_output_file*,
-			bool is_tu_index);
+  sized_read_unit_index(unsigned int, unsigned int *, bool is_tu_index);
+
+  // Read the input string table section.
+  void
+  read_strings(unsigned int);
 
   // Merge the input string table section into the output file.
   void
-  add_strings(Dwp_output_file*, unsigned int);
+  add_strings(Dwp_output_file*);
 
-  // Copy a section from the input file to the output file.
+  // Add a section from the input file to the output file.
   Section_bounds
   copy_section(Dwp_output_file* output_file, unsigned int shndx,
 	       elfcpp::DW_SECT section_id);
@@ -196,11 +286,14 @@ class Dwo_file
   unsigned int
   remap_str_offset(section_offset_type val);
 
+  // Collect the units of a .debug_info.dwo or .debug_types.dwo section.
+  void
+  read_unit_set(unsigned int *debug_shndx, bool is_debug_types);
+
   // Add a set of .debug_info.dwo or .debug_types.dwo and related sections
   // to OUTPUT_FILE.
   void
-  add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
-	       bool is_debug_types);
+  add_unit_set(Dwp_output_file* output_file, const Unit_list& list);
 
   // The filename.
   const char* name_;
@@ -208,12 +301,32 @@ class Dwo_file
   Relobj* obj_;
   // The Input_file object.
   Input_file* input_file_;
+  // ELF header parameters.
+  int machine_;
+  int size_;
+  bool big_endian_;
+  int osabi_;
+  int abiversion_;
   // Flags indicating which sections are compressed.
   std::vector<bool> is_compressed_;
   // Map input section index onto output section offset and size.
   std::vector<Section_bounds> sect_offsets_;
   // Map input string offsets to output string offsets.
   Str_offset_map str_offset_map_;
+  // The contents of the input string table section.
+  const unsigned char* str_contents_;
+  section_size_type str_len_;
+  bool str_is_new_;
+  // The strings in the input string table section.
+  std::vector<Input_string> strings_;
+  // The debug sections related to the units, and their sizes.
+  unsigned int debug_shndx_[elfcpp::DW_SECT_MAX + 1];
+  section_size_type section_sizes_[elfcpp::DW_SECT_MAX + 1];
+  // The units, in the order in which they are added to the output file.
+  std::vector<Unit_list> unit_lists_;
+  // The contributions to the output file, in the order in which
+  // they were added.
+  std::vector<Copy> copies_;
 };
 
 // An ELF input file.
@@ -396,7 +509,7 @@ class Sized_relobj_dwo : public Sized_relobj<size, big_endian>
   // Count the local symbols.
   void
   do_count_local_symbols(Stringpool_template<char>*,
-			 Stringpool_template<char>*)
+			 Stringpool_template<char>*, size_t)
   { gold_unreachable(); }
 
   // Finalize the local symbols.
@@ -416,7 +529,7 @@ class Sized_relobj_dwo : public Sized_relobj<size, big_endian>
 
   // Relocate the input sections and write out the local symbols.
   void
-  do_relocate(const Symbol_table*, const Layout*, Output_file*)
+  do_relocate(const Symbol_table*, const Layout*, Output_file*, Workqueue*)
   { gold_unreachable(); }
 
  private:
@@ -433,7 +546,7 @@ class Dwp_output_file
  public:
   Dwp_output_file(const char* name)
     : name_(name), machine_(0), size_(0), big_endian_(false), osabi_(0),
-      abiversion_(0), fd_(NULL), next_file_offset_(0), shnum_(1), sections_(),
+      abiversion_(0), fd_(-1), next_file_offset_(0), shnum_(1), sections_(),
       section_id_map_(), shoff_(0), shstrndx_(0), have_strings_(false),
       stringpool_(), shstrtab_(), cu_index_(), tu_index_(), last_type_sig_(0),
       last_tu_slot_(0)
@@ -447,14 +560,17 @@ class Dwp_output_file
   record_target_info(const char* name, int machine, int size, bool big_endian,
 		     int osabi, int abiversion);
 
-  // Add a string to the debug strings section.
+  // Add a string to the debug strings section.  HASH_CODE is
+  // gold::string_hash(STR, LEN).
   section_offset_type
-  add_string(const char* str, size_t len);
+  add_string(const char* str, size_t len, size_t hash_code);
 
-  // Add a section to the output file, and return the new section offset.
+  // Add a contribution of LEN bytes to a section of the output file,
+  // and return its offset within the section.  The contents are
+  // written later by write_contribution.
   section_offset_type
-  add_contribution(elfcpp::DW_SECT section_id, const unsigned char* contents,
-		   section_size_type len, int align);
+  add_contribution(elfcpp::DW_SECT section_id, section_size_type len,
+		   int align);
 
   // Add a set of .debug_info and related sections to the output file.
   void
@@ -468,20 +584,23 @@ class Dwp_output_file
   void
   add_tu_set(Unit_set* tu_set);
 
+  // Assign file offsets to the sections which have contributions.
+  // This is called after all the contributions have been added.
+  void
+  layout_sections();
+
+  // Write the contents of a contribution at OFFSET within its output
+  // section.  This may be called by several threads at once.
+  void
+  write_contribution(elfcpp::DW_SECT section_id, section_offset_type offset,
+		     const unsigned char* contents, section_size_type len);
+
   // Finalize the file, write the string tables and index sections,
   // and close the file.
   void
   finalize();
 
  private:
-  // Contributions to output sections.
-  struct Contribution
-  {
-    section_offset_type output_offset;
-    section_size_type size;
-    const unsigned char* contents;
-  };
-
   // Sections in the output file.
   struct Section
   {
@@ -489,10 +608,9 @@ class Dwp_output_file
     off_t offset;
     section_size_type size;
     int align;
-    std::vector<Contribution> contributions;
 
     Section(const char* n, int a)
-      : name(n), offset(0), size(0), align(a), contributions()
+      : name(n), offset(0), size(0), align(a)
     { }
   };
 
@@ -589,6 +707,11 @@ class Dwp_output_file
   unsigned int
   add_output_section(const char* section_name, int align);
 
+  // Write LEN bytes of CONTENTS to the output file at FILE_OFFSET.
+  // Return false on error.
+  bool
+  write_at(off_t file_offset, const unsigned char* contents, size_t len);
+
   // Write a new section to the output file.
   void
   write_new_section(const char* section_name, const unsigned char* contents,
@@ -602,24 +725,22 @@ class Dwp_output_file
   void
   sized_write_ehdr();
 
-  // Write a section header.
+  // Write a section header into the buffer at P.
   void
-  write_shdr(const char* name, unsigned int type, unsigned int flags,
-	     uint64_t addr, off_t offset, section_size_type sect_size,
+  write_shdr(unsigned char* p, const char* name, unsigned int type,
+	     unsigned int flags, uint64_t addr, off_t offset,
+	     section_size_type sect_size,
 	     unsigned int link, unsigned int info,
 	     unsigned int align, unsigned int ent_size);
 
   template<unsigned int size, bool big_endian>
   void
-  sized_write_shdr(const char* name, unsigned int type, unsigned int flags,
-		   uint64_t addr, off_t offset, section_size_type sect_size,
+  sized_write_shdr(unsigned char* p, const char* name, unsigned int type,
+		   unsigned int flags, uint64_t addr, off_t offset,
+		   section_size_type sect_size,
 		   unsigned int link, unsigned int info,
 		   unsigned int align, unsigned int ent_size);
 
-  // Write the contributions to an output section.
-  void
-  write_contributions(const Section& sect);
-
   // Write a CU or TU index section.
   template<bool big_endian>
   void
@@ -634,7 +755,7 @@ class Dwp_output_file
   int osabi_;
   int abiversion_;
   // The output file descriptor.
-  FILE* fd_;
+  int fd_;
   // Next available file offset.
   off_t next_file_offset_;
   // The number of sections.
@@ -696,22 +817,22 @@ class Dwo_name_info_reader : public Dwarf_info_reader
 };
 
 // A specialization of Dwarf_info_reader, for reading DWARF CUs and TUs
-// and adding them to the output file.
+// and collecting their signatures and bounds.
 
 class Unit_reader : public Dwarf_info_reader
 {
  public:
   Unit_reader(bool is_type_unit, Relobj* object, unsigned int shndx)
     : Dwarf_info_reader(is_type_unit, object, NULL, 0, shndx, 0, 0),
-      output_file_(NULL), sections_(NULL)
+      units_(NULL)
   { }
 
   ~Unit_reader()
   { }
 
-  // Read the CUs or TUs and add them to the output file.
+  // Read the CUs or TUs and append them to UNITS.
   void
-  add_units(Dwp_output_file*, unsigned int debug_abbrev, Section_bounds*);
+  read_units(unsigned int debug_abbrev, std::vector<Input_unit>* units);
 
  protected:
   // Visit a compilation unit.
@@ -724,8 +845,7 @@ class Unit_reader : public Dwarf_info_reader
 		  uint64_t signature, Dwarf_die*);
 
  private:
-  Dwp_output_file* output_file_;
-  Section_bounds* sections_;
+  std::vector<Input_unit>* units_;
 };
 
 // Return the name of a DWARF .dwo section.
@@ -821,11 +941,23 @@ Sized_relobj_dwo<size, big_endian>::do_decompressed_section_contents(
 // Class Dwo_file.
 
 Dwo_file::~Dwo_file()
+{
+  if (this->str_is_new_)
+    delete[] this->str_contents_;
+  this->release();
+}
+
+// Release the input file.
+
+void
+Dwo_file::release()
 {
   if (this->obj_ != NULL)
     delete this->obj_;
+  this->obj_ = NULL;
   if (this->input_file_ != NULL)
     delete this->input_file_;
+  this->input_file_ = NULL;
 }
 
 // Read the input executable file and extract the list of .dwo files
@@ -834,7 +966,7 @@ Dwo_file::~Dwo_file()
 void
 Dwo_file::read_executable(File_list* files)
 {
-  this->obj_ = this->make_object(NULL);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -874,12 +1006,13 @@ Dwo_file::read_executable(File_list* files)
     }
 }
 
-// Read the input file and send its contents to OUTPUT_FILE.
+// Read and parse the input file.  This does not touch the output
+// file, so it may be called for several files at once.
 
 void
-Dwo_file::read(Dwp_output_file* output_file)
+Dwo_file::read()
 {
-  this->obj_ = this->make_object(output_file);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -887,9 +1020,7 @@ Dwo_file::read(Dwp_output_file* output_file)
 
   typedef std::vector<unsigned int> Types_list;
   Types_list debug_types;
-  unsigned int debug_shndx[elfcpp::DW_SECT_MAX + 1];
-  for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
-    debug_shndx[i] = 0;
+  unsigned int* debug_shndx = this->debug_shndx_;
   unsigned int debug_str = 0;
   unsigned int debug_cu_index = 0;
   unsigned int debug_tu_index = 0;
@@ -935,29 +1066,48 @@ Dwo_file::read(Dwp_output_file* output_file)
 	debug_tu_index = i;
     }
 
-  // Merge the input string table into the output string table.
-  this->add_strings(output_file, debug_str);
+  // Read the input string table.
+  this->read_strings(debug_str);
+
+  // Record the sizes of the related sections, which are all we need
+  // to lay out the output file.
+  for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
+    {
+      unsigned int shndx = debug_shndx[i];
+      if (shndx == 0)
+	continue;
+      if (this->is_compressed_[shndx])
+	{
+	  section_size_type len;
+	  const unsigned char* contents =
+	      this->obj_->section_contents(shndx, &len, false);
+	  this->section_sizes_[i] = get_uncompressed_size(contents, len);
+	}
+      else
+	this->section_sizes_[i] = convert_to_section_size_type(
+	    this->obj_->section_size(shndx));
+    }
 
-  // If we found any .dwp index sections, read those and add the section
-  // sets to the output file.
+  // If we found any .dwp index sections, read those and collect the
+  // section sets.
   if (debug_cu_index > 0 || debug_tu_index > 0)
     {
       if (debug_cu_index > 0)
-	this->read_unit_index(debug_cu_index, debug_shndx, output_file, false);
+	this->read_unit_index(debug_cu_index, debug_shndx, false);
       if (debug_tu_index > 0)
         {
 	  if (debug_types.size() != 1)
 	    gold_fatal(_("%s: .dwp file must have exactly one "
 			 ".debug_types.dwo section"), this->name_);
 	  debug_shndx[elfcpp::DW_SECT_TYPES] = debug_types[0];
-	  this->read_unit_index(debug_tu_index, debug_shndx, output_file, true);
+	  this->read_unit_index(debug_tu_index, debug_shndx, true);
 	}
       return;
     }
 
   // If we found no index sections, this is a .dwo file.
   if (debug_shndx[elfcpp::DW_SECT_INFO] > 0)
-    this->add_unit_set(output_file, debug_shndx, false);
+    this->read_unit_set(debug_shndx, false);
 
   debug_shndx[elfcpp::DW_SECT_INFO] = 0;
   for (Types_list::const_iterator tp = debug_types.begin();
@@ -965,15 +1115,101 @@ Dwo_file::read(Dwp_output_file* output_file)
        ++tp)
     {
       debug_shndx[elfcpp::DW_SECT_TYPES] = *tp;
-      this->add_unit_set(output_file, debug_shndx, true);
+      this->read_unit_set(debug_shndx, true);
+    }
+}
+
+// Add the strings and units read from the input file to OUTPUT_FILE.
+// This must be called for each file in turn, in the order in which
+// the files were given, after read.  The contents of the units and
+// sections are copied later by write_contributions, so we can release
+// the input file now.
+
+void
+Dwo_file::add_to_output(Dwp_output_file* output_file)
+{
+  output_file->record_target_info(this->name_, this->machine_, this->size_,
+				  this->big_endian_, this->osabi_,
+				  this->abiversion_);
+
+  // Merge the input string table into the output string table.
+  this->add_strings(output_file);
+
+  // Add the section sets for each .debug_info.dwo or .debug_types.dwo
+  // section, or for each index section of a .dwp file.
+  for (std::vector<Unit_list>::const_iterator p = this->unit_lists_.begin();
+       p != this->unit_lists_.end();
+       ++p)
+    this->add_unit_set(output_file, *p);
+  std::vector<Unit_list>().swap(this->unit_lists_);
+
+  this->release();
+}
+
+// Copy the contributions of the input file to OUTPUT_FILE.  This must
+// be called after OUTPUT_FILE has been laid out.  It may be called
+// for several files at once.
+
+void
+Dwo_file::write_contributions(Dwp_output_file* output_file)
+{
+  if (this->copies_.empty())
+    return;
+
+  this->obj_ = this->make_object();
+
+  unsigned int shndx = 0;
+  const unsigned char* contents = NULL;
+  section_size_type len = 0;
+  bool is_new = false;
+  for (std::vector<Copy>::const_iterator p = this->copies_.begin();
+       p != this->copies_.end();
+       ++p)
+    {
+      if (p->size == 0)
+	continue;
+
+      // The contributions from one input section are usually
+      // consecutive, so keep the contents of the last section.
+      if (p->shndx != shndx)
+	{
+	  if (is_new)
+	    delete[] contents;
+	  shndx = p->shndx;
+	  contents = this->section_contents(shndx, &len, &is_new);
+	}
+
+      if (p->input_offset < 0
+	  || static_cast<section_size_type>(p->input_offset) > len
+	  || p->size > len - p->input_offset)
+	gold_fatal(_("%s: section %s is corrupt"), this->name_,
+		   this->section_name(shndx).c_str());
+
+      if (p->section_id == elfcpp::DW_SECT_STR_OFFSETS)
+	{
+	  const unsigned char* remapped =
+	      this->remap_str_offsets(contents + p->input_offset, p->size);
+	  output_file->write_contribution(p->section_id, p->output_offset,
+					  remapped, p->size);
+	  delete[] remapped;
+	}
+      else
+	output_file->write_contribution(p->section_id, p->output_offset,
+					contents + p->input_offset, p->size);
     }
+  if (is_new)
+    delete[] contents;
+
+  std::vector<Copy>().swap(this->copies_);
+  Str_offset_map().swap(this->str_offset_map_);
+  this->release();
 }
 
 // Create a Sized_relobj_dwo of the given size and endianness,
 // and record the target info.
 
 Relobj*
-Dwo_file::make_object(Dwp_output_file* output_file)
+Dwo_file::make_object()
 {
   // Open the input file.
   Input_file* input_file = new Input_file(this->name_);
@@ -994,8 +1230,7 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     gold_fatal(_("%s: not an ELF object file"), this->name_);
   
   // Get the size, endianness, machine, etc. info from the header,
-  // make an appropriately-sized Relobj, and pass the target info
-  // to the output object.
+  // and make an appropriately-sized Relobj.
   int size;
   bool big_endian;
   std::string error;
@@ -1007,15 +1242,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_32_BIG
-	return this->sized_make_object<32, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<32, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_32_LITTLE
-	return this->sized_make_object<32, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<32, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1024,15 +1257,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_64_BIG
-	return this->sized_make_object<64, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<64, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_64_LITTLE
-	return this->sized_make_object<64, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<64, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1046,41 +1277,37 @@ Dwo_file::make_object(Dwp_output_file* output_file)
 
 template <int size, bool big_endian>
 Relobj*
-Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file,
-			    Dwp_output_file* output_file)
+Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file)
 {
   elfcpp::Ehdr<size, big_endian> ehdr(p);
   Sized_relobj_dwo<size, big_endian>* obj =
       new Sized_relobj_dwo<size, big_endian>(this->name_, input_file, ehdr);
   obj->setup();
-  if (output_file != NULL)
-    output_file->record_target_info(
-	this->name_, ehdr.get_e_machine(), size, big_endian,
-	ehdr.get_e_ident()[elfcpp::EI_OSABI],
-	ehdr.get_e_ident()[elfcpp::EI_ABIVERSION]);
+  this->machine_ = ehdr.get_e_machine();
+  this->size_ = size;
+  this->big_endian_ = big_endian;
+  this->osabi_ = ehdr.get_e_ident()[elfcpp::EI_OSABI];
+  this->abiversion_ = ehdr.get_e_ident()[elfcpp::EI_ABIVERSION];
   return obj;
 }
 
 // Read the .debug_cu_index or .debug_tu_index section of a .dwp file,
-// and process the CU or TU sets.
+// and collect the CU or TU sets.
 
 void
 Dwo_file::read_unit_index(unsigned int shndx, unsigned int *debug_shndx,
-			  Dwp_output_file* output_file, bool is_tu_index)
+			  bool is_tu_index)
 {
   if (this->obj_->is_big_endian())
-    this->sized_read_unit_index<true>(shndx, debug_shndx, output_file,
-				      is_tu_index);
+    this->sized_read_unit_index<true>(shndx, debug_shndx, is_tu_index);
   else
-    this->sized_read_unit_index<false>(shndx, debug_shndx, output_file,
-				       is_tu_index);
+    this->sized_read_unit_index<false>(shndx, debug_shndx, is_tu_index);
 }
 
 template <bool big_endian>
 void
 Dwo_file::sized_read_unit_index(unsigned int shndx,
 				unsigned int *debug_shndx,
-				Dwp_output_file* output_file,
 				bool is_tu_index)
 {
   elfcpp::DW_SECT info_sect = (is_tu_index
@@ -1112,7 +1339,11 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
       elfcpp::Swap_unaligned<32, big_endian>::readval(contents
 						      + 2 * sizeof(uint32_t));
   if (ncols == 0 || nused == 0)
-    return;
+    {
+      if (index_is_new)
+	delete[] contents;
+      return;
+    }
 
   unsigned int nslots =
       elfcpp::Swap_unaligned<32, big_endian>::readval(contents
@@ -1129,20 +1360,12 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
     gold_fatal(_("%s: section %s is corrupt"), this->name_,
 	       this->section_name(shndx).c_str());
 
-  // Copy the related sections and track the section offsets and sizes.
-  Section_bounds sections[elfcpp::DW_SECT_MAX + 1];
-  for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    {
-      if (debug_shndx[i] > 0)
-	sections[i] = this->copy_section(output_file, debug_shndx[i],
-					 static_cast<elfcpp::DW_SECT>(i));
-    }
-
-  // Get the contents of the .debug_info.dwo or .debug_types.dwo section.
-  section_size_type info_len;
-  bool info_is_new;
-  const unsigned char* info_contents =
-      this->section_contents(info_shndx, &info_len, &info_is_new);
+  Unit_list list;
+  list.shndx = info_shndx;
+  list.is_debug_types = is_tu_index;
+  list.is_index = true;
+  this->unit_lists_.push_back(list);
+  std::vector<Input_unit>& units(this->unit_lists_.back().units);
 
   // Loop over the slots of the hash table.
   for (unsigned int i = 0; i < nslots; ++i)
@@ -1151,18 +1374,19 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
           elfcpp::Swap_unaligned<64, big_endian>::readval(phash);
       unsigned int index =
 	  elfcpp::Swap_unaligned<32, big_endian>::readval(pindex);
-      if (index != 0 && (!is_tu_index || !output_file->lookup_tu(signature)))
+      if (index != 0)
 	{
-	  Unit_set* unit_set = new Unit_set();
-	  unit_set->signature = signature;
+	  units.push_back(Input_unit());
+	  Input_unit& unit(units.back());
+	  unit.signature = signature;
 	  const unsigned char* pch = pcolhdrs;
 	  const unsigned char* porow =
 	      poffsets + (index - 1) * ncols * sizeof(uint32_t);
 	  const unsigned char* psrow =
 	      psizes + (index - 1) * ncols * sizeof(uint32_t);
 
-	  // Adjust the offset of each contribution within the input section
-	  // by the offset of the input section within the output section.
+	  // Record the offset and size of each contribution within
+	  // its input section.
 	  for (unsigned int j = 0; j <= ncols; j++)
 	    {
 	      unsigned int dw_sect =
@@ -1171,35 +1395,14 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 		  elfcpp::Swap_unaligned<64, big_endian>::readval(porow);
 	      unsigned int size =
 		  elfcpp::Swap_unaligned<64, big_endian>::readval(psrow);
-	      unit_set->sections[dw_sect].offset = (sections[dw_sect].offset
-						    + offset);
-	      unit_set->sections[dw_sect].size = size;
+	      if (dw_sect <= elfcpp::DW_SECT_MAX)
+		unit.columns.push_back(std::make_pair(dw_sect,
+						      Section_bounds(offset,
+								     size)));
 	      pch += sizeof(uint32_t);
 	      porow += sizeof(uint32_t);
 	      psrow += sizeof(uint32_t);
 	    }
-
-	  const unsigned char* unit_start =
-	      info_contents + unit_set->sections[info_sect].offset;
-	  section_size_type unit_length = unit_set->sections[info_sect].size;
-
-	  // Dwp_output_file::add_contribution writes the .debug_info.dwo
-	  // section directly to the output file, so we only need to
-	  // duplicate contributions for .debug_types.dwo section.
-	  if (is_tu_index)
-	    {
-	      unsigned char *copy = new unsigned char[unit_length];
-	      memcpy(copy, unit_start, unit_length);
-	      unit_start = copy;
-	    }
-	  section_offset_type off =
-	      output_file->add_contribution(info_sect, unit_start,
-					    unit_length, 1);
-	  unit_set->sections[info_sect].offset = off;
-	  if (is_tu_index)
-	    output_file->add_tu_set(unit_set);
-	  else
-	    output_file->add_cu_set(unit_set);
 	}
       phash += sizeof(uint64_t);
       pindex += sizeof(uint32_t);
@@ -1207,14 +1410,13 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 
   if (index_is_new)
     delete[] contents;
-  if (info_is_new)
-    delete[] info_contents;
 }
 
-// Merge the input string table section into the output file.
+// Read the input string table section.  The strings are added to the
+// output file by add_strings.
 
 void
-Dwo_file::add_strings(Dwp_output_file* output_file, unsigned int debug_str)
+Dwo_file::read_strings(unsigned int debug_str)
 {
   section_size_type len;
   bool is_new;
@@ -1229,34 +1431,65 @@ Dwo_file::add_strings(Dwp_output_file* output_file, unsigned int debug_str)
 	       this->name_,
 	       this->section_name(debug_str).c_str());
 
-  // Count the number of strings in the section, and size the map.
+  // Count the number of strings in the section, and size the list.
   size_t count = 0;
   for (const char* pt = p; pt < pend; pt += strlen(pt) + 1)
     ++count;
-  this->str_offset_map_.reserve(count + 1);
+  this->strings_.reserve(count);
 
-  // Add the strings to the output string table, and record the new offsets
-  // in the map.
+  // Record the offset, length and hash code of each string, so that
+  // add_strings only needs to enter them in the output string table.
   section_offset_type i = 0;
-  section_offset_type new_offset;
   while (p < pend)
     {
       size_t len = strlen(p);
-      new_offset = output_file->add_string(p, len);
-      this->str_offset_map_.push_back(std::make_pair(i, new_offset));
+      Input_string s = { i, len, string_hash<char>(p, len) };
+      this->strings_.push_back(s);
       p += len + 1;
       i += len + 1;
     }
+
+  this->str_contents_ = pdata;
+  this->str_len_ = len;
+  this->str_is_new_ = is_new;
+}
+
+// Merge the input string table section into the output file.
+
+void
+Dwo_file::add_strings(Dwp_output_file* output_file)
+{
+  const char* p = reinterpret_cast<const char*>(this->str_contents_);
+
+  // Size the map.
+  this->str_offset_map_.reserve(this->strings_.size() + 1);
+
+  // Add the strings to the output string table, and record the new offsets
+  // in the map.
+  section_offset_type new_offset;
+  for (std::vector<Input_string>::const_iterator s = this->strings_.begin();
+       s != this->strings_.end();
+       ++s)
+    {
+      new_offset = output_file->add_string(p + s->offset, s->length,
+					   s->hash_code);
+      this->str_offset_map_.push_back(std::make_pair(s->offset, new_offset));
+    }
   new_offset = 0;
-  this->str_offset_map_.push_back(std::make_pair(i, new_offset));
-  if (is_new)
-    delete[] pdata;
+  this->str_offset_map_.push_back(std::make_pair(this->str_len_, new_offset));
+
+  std::vector<Input_string>().swap(this->strings_);
+  if (this->str_is_new_)
+    delete[] this->str_contents_;
+  this->str_contents_ = NULL;
+  this->str_is_new_ = false;
 }
 
-// Copy a section from the input file to the output file.
+// Add a section from the input file to the output file.
 // Return the offset and length of this input section's contribution
-// in the output section.  If copying .debug_str_offsets.dwo, remap
-// the string offsets for the output string table.
+// in the output section.  The contents are copied later by
+// write_contributions; if copying .debug_str_offsets.dwo, that
+// remaps the string offsets for the output string table.
 
 Section_bounds
 Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
@@ -1267,32 +1500,11 @@ Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
   if (this->sect_offsets_[shndx].size > 0)
     return this->sect_offsets_[shndx];
 
-  // Get the section contents. Upon return, if IS_NEW is true, the memory
-  // has been allocated via new; if false, the memory is part of the mapped
-  // input file, and we will need to duplicate it so that it will persist
-  // after we close the input file.
-  section_size_type len;
-  bool is_new;
-  const unsigned char* contents = this->section_contents(shndx, &len, &is_new);
-
-  if (section_id == elfcpp::DW_SECT_STR_OFFSETS)
-    {
-      const unsigned char* remapped = this->remap_str_offsets(contents, len);
-      if (is_new)
-	delete[] contents;
-      contents = remapped;
-    }
-  else if (!is_new)
-    {
-      unsigned char* copy = new unsigned char[len];
-      memcpy(copy, contents, len);
-      contents = copy;
-    }
-
-  // Add the contents of the input section to the output section.
-  // The output file takes ownership of the memory pointed to by CONTENTS.
-  section_offset_type off = output_file->add_contribution(section_id, contents,
-							  len, 1);
+  // Add the input section to the output section.
+  section_size_type len = this->section_sizes_[section_id];
+  section_offset_type off = output_file->add_contribution(section_id, len, 1);
+  Copy copy = { section_id, shndx, 0, len, off };
+  this->copies_.push_back(copy);
 
   // Store the output section bounds.
   Section_bounds bounds(off, len);
@@ -1358,12 +1570,10 @@ Dwo_file::remap_str_offset(section_offset_type val)
   return p->second + (val - p->first);
 }
 
-// Add a set of .debug_info.dwo or .debug_types.dwo and related sections
-// to OUTPUT_FILE.
+// Collect the units of a .debug_info.dwo or .debug_types.dwo section.
 
 void
-Dwo_file::add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
-		       bool is_debug_types)
+Dwo_file::read_unit_set(unsigned int *debug_shndx, bool is_debug_types)
 {
   unsigned int shndx = (is_debug_types
 			? debug_shndx[elfcpp::DW_SECT_TYPES]
@@ -1374,20 +1584,83 @@ Dwo_file::add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
   if (debug_shndx[elfcpp::DW_SECT_ABBREV] == 0)
     gold_fatal(_("%s: no .debug_abbrev.dwo section found"), this->name_);
 
+  Unit_list list;
+  list.shndx = shndx;
+  list.is_debug_types = is_debug_types;
+  list.is_index = false;
+  this->unit_lists_.push_back(list);
+
+  // Parse the .debug_info or .debug_types section and collect each
+  // compilation or type unit.
+  Unit_reader reader(is_debug_types, this->obj_, shndx);
+  reader.read_units(debug_shndx[elfcpp::DW_SECT_ABBREV],
+		    &this->unit_lists_.back().units);
+}
+
+// Add a set of .debug_info.dwo or .debug_types.dwo and related sections
+// to OUTPUT_FILE.
+
+void
+Dwo_file::add_unit_set(Dwp_output_file* output_file, const Unit_list& list)
+{
+  elfcpp::DW_SECT info_sect = (list.is_debug_types
+			       ? elfcpp::DW_SECT_TYPES
+			       : elfcpp::DW_SECT_INFO);
+
   // Copy the related sections and track the section offsets and sizes.
   Section_bounds sections[elfcpp::DW_SECT_MAX + 1];
   for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
     {
-      if (debug_shndx[i] > 0)
-	sections[i] = this->copy_section(output_file, debug_shndx[i],
+      if (this->debug_shndx_[i] > 0)
+	sections[i] = this->copy_section(output_file, this->debug_shndx_[i],
 					 static_cast<elfcpp::DW_SECT>(i));
     }
 
-  // Parse the .debug_info or .debug_types section and add each compilation
-  // or type unit to the output file, along with the contributions to the
-  // related sections.
-  Unit_reader reader(is_debug_types, this->obj_, shndx);
-  reader.add_units(output_file, debug_shndx[elfcpp::DW_SECT_ABBREV], sections);
+  // Add each compilation or type unit to the output file, along with
+  // the contributions to the related sections.
+  for (std::vector<Input_unit>::const_iterator p = list.units.begin();
+       p != list.units.end();
+       ++p)
+    {
+      if (list.is_debug_types && output_file->lookup_tu(p->signature))
+	continue;
+
+      Unit_set* unit_set = new Unit_set();
+      unit_set->signature = p->signature;
+      Section_bounds bounds;
+      if (list.is_index)
+	{
+	  // Adjust the offset of each contribution within the input section
+	  // by the offset of the input section within the output section.
+	  for (unsigned int j = 0; j < p->columns.size(); ++j)
+	    {
+	      unsigned int dw_sect = p->columns[j].first;
+	      const Section_bounds& column(p->columns[j].second);
+	      unit_set->sections[dw_sect].offset = (sections[dw_sect].offset
+						    + column.offset);
+	      unit_set->sections[dw_sect].size = column.size;
+	    }
+	  bounds = unit_set->sections[info_sect];
+	}
+      else
+	{
+	  for (unsigned int i = elfcpp::DW_SECT_ABBREV;
+	       i <= elfcpp::DW_SECT_MAX;
+	       ++i)
+	    unit_set->sections[i] = sections[i];
+	  bounds = p->bounds;
+	}
+
+      section_offset_type off =
+	  output_file->add_contribution(info_sect, bounds.size, 1);
+      Copy copy = { info_sect, list.shndx, bounds.offset, bounds.size, off };
+      this->copies_.push_back(copy);
+      unit_set->sections[info_sect] = Section_bounds(off, bounds.size);
+      if (list.is_debug_types)
+	output_file->add_tu_set(unit_set);
+      else
+	output_file->add_cu_set(unit_set);
+    }
 }
 
 // Class Dwp_output_file.
@@ -1418,25 +1691,19 @@ Dwp_output_file::record_target_info(const char*, int machine,
   else
     gold_unreachable();
 
-  this->fd_ = ::fopen(this->name_, "wb");
-  if (this->fd_ == NULL)
-    gold_fatal(_("%s: %s"), this->name_, strerror(errno));
-
-  // Write zeroes for the ELF header initially.  We'll write
-  // the actual header during finalize().
-  static const char buf[elfcpp::Elf_sizes<64>::ehdr_size] = { 0 };
-  if (::fwrite(buf, 1, this->next_file_offset_, this->fd_)
-      < (size_t) this->next_file_offset_)
+  // We write the ELF header during finalize().
+  this->fd_ = ::open(this->name_, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (this->fd_ < 0)
     gold_fatal(_("%s: %s"), this->name_, strerror(errno));
 }
 
 // Add a string to the debug strings section.
 
 section_offset_type
-Dwp_output_file::add_string(const char* str, size_t len)
+Dwp_output_file::add_string(const char* str, size_t len, size_t hash_code)
 {
   Stringpool::Key key;
-  this->stringpool_.add_with_length(str, len, true, &key);
+  this->stringpool_.add_prehashed(str, len, hash_code, true, &key);
   this->have_strings_ = true;
   // We aren't supposed to call get_offset() until after
   // calling set_string_offsets(), but the offsets will
@@ -1463,15 +1730,13 @@ Dwp_output_file::add_output_section(const char* section_name, int align)
 }
 
 // Add a contribution to a section in the output file, and return the offset
-// of the contribution within the output section.  The .debug_info.dwo section
-// is expected to be the largest one, so we will write the contents of this
-// section directly to the output file as we receive contributions, allowing
-// us to free that memory as soon as possible. We will save the remaining
-// contributions until we finalize the layout of the output file.
+// of the contribution within the output section.  We only lay out the
+// contributions here; the input files write their contents directly to
+// the output file once all the sections have been laid out, so that we
+// never need to hold the contents in memory.
 
 section_offset_type
 Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
-				  const unsigned char* contents,
 				  section_size_type len,
 				  int align)
 {
@@ -1491,52 +1756,63 @@ Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
 
   Section& section = this->sections_[shndx - 1];
 
-  section_offset_type section_offset;
+  // Keep track of the total size.
+  if (align > section.align)
+    section.align = align;
+  section_offset_type section_offset = align_offset(section.size, align);
+  section.size = section_offset + len;
 
-  if (section_id == elfcpp::DW_SECT_INFO)
-    {
-      // Write the .debug_info.dwo section directly.
-      // We do not need to free the memory in this case.
-      off_t file_offset = this->next_file_offset_;
-      gold_assert(this->size_ > 0 && file_offset > 0);
-
-      file_offset = align_offset(file_offset, align);
-      if (section.offset == 0)
-	section.offset = file_offset;
+  return section_offset;
+}
 
-      if (align > section.align)
-	{
-	  // Since we've already committed to the layout for this
-	  // section, an unexpected large alignment boundary may
-	  // be impossible to honor.
-	  if (align_offset(section.offset, align) != section.offset)
-	    gold_fatal(_("%s: alignment (%d) for section '%s' "
-			 "cannot be honored"),
-		       this->name_, align, section_name);
-	  section.align = align;
-	}
+// Assign file offsets to the sections which have contributions.  The
+// .debug_info.dwo section goes first, right after the ELF header; the
+// others follow in the order in which they were created.
 
-      section_offset = file_offset - section.offset;
-      section.size = file_offset + len - section.offset;
+void
+Dwp_output_file::layout_sections()
+{
+  off_t file_offset = this->next_file_offset_;
 
-      ::fseek(this->fd_, file_offset, SEEK_SET);
-      if (::fwrite(contents, 1, len, this->fd_) < len)
-	gold_fatal(_("%s: error writing section '%s'"), this->name_,
-		   section_name);
-      this->next_file_offset_ = file_offset + len;
+  unsigned int info_shndx = this->section_id_map_[elfcpp::DW_SECT_INFO];
+  if (info_shndx > 0)
+    {
+      Section& sect = this->sections_[info_shndx - 1];
+      file_offset = align_offset(file_offset, sect.align);
+      sect.offset = file_offset;
+      file_offset += sect.size;
     }
-  else
+
+  for (unsigned int i = 0; i < this->sections_.size(); i++)
     {
-      // Collect the contributions and keep track of the total size.
-      if (align > section.align)
-	section.align = align;
-      section_offset = align_offset(section.size, align);
-      section.size = section_offset + len;
-      Contribution contrib = { section_offset, len, contents };
-      section.contributions.push_back(contrib);
+      Section& sect = this->sections_[i];
+      if (i + 1 == info_shndx || sect.size == 0)
+	continue;
+      file_offset = align_offset(file_offset, sect.align);
+      sect.offset = file_offset;
+      file_offset += sect.size;
     }
 
-  return section_offset;
+  this->next_file_offset_ = file_offset;
+}
+
+// Write the contents of a contribution at OFFSET within its output
+// section.  The layout is final by now, so this does not change any
+// state, and may be called by several threads at once.
+
+void
+Dwp_output_file::write_contribution(elfcpp::DW_SECT section_id,
+				    section_offset_type offset,
+				    const unsigned char* contents,
+				    section_size_type len)
+{
+  unsigned int shndx = this->section_id_map_[section_id];
+  gold_assert(shndx > 0);
+  const Section& sect = this->sections_[shndx - 1];
+  gold_assert(offset >= 0
+	      && static_cast<section_size_type>(offset) + len <= sect.size);
+  if (!this->write_at(sect.offset + offset, contents, len))
+    gold_fatal(_("%s: error writing section '%s'"), this->name_, sect.name);
 }
 
 // Add a set of .debug_info and related sections to the output file.
@@ -1689,20 +1965,6 @@ Dwp_output_file::finalize()
 {
   unsigned char* buf;
 
-  // Write the accumulated output sections.
-  for (unsigned int i = 0; i < this->sections_.size(); i++)
-    {
-      Section& sect = this->sections_[i];
-      // If the offset has already been assigned, the section has been written.
-      if (sect.offset > 0 || sect.size == 0)
-	continue;
-      off_t file_offset = this->next_file_offset_;
-      file_offset = align_offset(file_offset, sect.align);
-      sect.offset = file_offset;
-      this->write_contributions(sect);
-      this->next_file_offset_ = file_offset + sect.size;
-    }
-
   // Write the debug string table.
   if (this->have_strings_)
     {
@@ -1738,8 +2000,7 @@ Dwp_output_file::finalize()
   buf = new unsigned char[shstrtab_len];
   this->shstrtab_.write_to_buffer(buf, shstrtab_len);
   off_t shstrtab_off = file_offset;
-  ::fseek(this->fd_, file_offset, 0);
-  if (::fwrite(buf, 1, shstrtab_len, this->fd_) < shstrtab_len)
+  if (!this->write_at(file_offset, buf, shstrtab_len))
     gold_fatal(_("%s: error writing section '.shstrtab'"), this->name_);
   delete[] buf;
   file_offset += shstrtab_len;
@@ -1749,48 +2010,70 @@ Dwp_output_file::finalize()
   // .shstrtab section header.
   file_offset = align_offset(file_offset, this->size_ == 32 ? 4 : 8);
   this->shoff_ = file_offset;
-  ::fseek(this->fd_, file_offset, 0);
+  const unsigned int shdr_size = (this->size_ == 32
+				  ? elfcpp::Elf_sizes<32>::shdr_size
+				  : elfcpp::Elf_sizes<64>::shdr_size);
+  const size_t shdrs_len = this->shnum_ * shdr_size;
+  buf = new unsigned char[shdrs_len];
+  unsigned char* p = buf;
   section_size_type sh0_size = 0;
   unsigned int sh0_link = 0;
   if (this->shnum_ >= elfcpp::SHN_LORESERVE)
     sh0_size = this->shnum_;
   if (this->shstrndx_ >= elfcpp::SHN_LORESERVE)
     sh0_link = this->shstrndx_;
-  this->write_shdr(NULL, 0, 0, 0, 0, sh0_size, sh0_link, 0, 0, 0);
+  this->write_shdr(p, NULL, 0, 0, 0, 0, sh0_size, sh0_link, 0, 0, 0);
+  p += shdr_size;
   for (unsigned int i = 0; i < this->sections_.size(); ++i)
     {
       Section& sect = this->sections_[i];
-      this->write_shdr(sect.name, elfcpp::SHT_PROGBITS, 0, 0, sect.offset,
+      this->write_shdr(p, sect.name, elfcpp::SHT_PROGBITS, 0, 0, sect.offset,
 		       sect.size, 0, 0, sect.align, 0);
+      p += shdr_size;
     }
-  this->write_shdr(shstrtab_name, elfcpp::SHT_STRTAB, 0, 0,
+  this->write_shdr(p, shstrtab_name, elfcpp::SHT_STRTAB, 0, 0,
 		   shstrtab_off, shstrtab_len, 0, 0, 1, 0);
+  p += shdr_size;
+  gold_assert(p == buf + shdrs_len);
+  if (!this->write_at(file_offset, buf, shdrs_len))
+    gold_fatal(_("%s: error writing section header table"), this->name_);
+  delete[] buf;
 
   // Write the ELF header.
   this->write_ehdr();
 
   // Close the file.
-  if (this->fd_ != NULL)
+  if (this->fd_ >= 0)
     {
-      if (::fclose(this->fd_) != 0)
+      if (::close(this->fd_) != 0)
 	gold_fatal(_("%s: %s"), this->name_, strerror(errno));
     }
-  this->fd_ = NULL;
+  this->fd_ = -1;
 }
 
-// Write the contributions to an output section.
+// Write LEN bytes of CONTENTS to the output file at FILE_OFFSET.
+// Return false on error.
 
-void
-Dwp_output_file::write_contributions(const Section& sect)
+bool
+Dwp_output_file::write_at(off_t file_offset, const unsigned char* contents,
+			  size_t len)
 {
-  for (unsigned int i = 0; i < sect.contributions.size(); ++i)
+  while (len > 0)
     {
-      const Contribution& c = sect.contributions[i];
-      ::fseek(this->fd_, sect.offset + c.output_offset, SEEK_SET);
-      if (::fwrite(c.contents, 1, c.size, this->fd_) < c.size)
-	gold_fatal(_("%s: error writing section '%s'"), this->name_, sect.name);
-      delete[] c.contents;
+      ssize_t bytes = ::pwrite(this->fd_, contents, len, file_offset);
+      if (bytes < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  return false;
+	}
+      if (bytes == 0)
+	return false;
+      contents += bytes;
+      len -= bytes;
+      file_offset += bytes;
     }
+  return true;
 }
 
 // Write a new section to the output file.
@@ -1809,8 +2092,7 @@ Dwp_output_file::write_new_section(const char* section_name,
   file_offset = align_offset(file_offset, align);
   section.offset = file_offset;
   section.size = len;
-  ::fseek(this->fd_, file_offset, SEEK_SET);
-  if (::fwrite(contents, 1, len, this->fd_) < len)
+  if (!this->write_at(file_offset, contents, len))
     gold_fatal(_("%s: error writing section '%s'"), this->name_, section_name);
   this->next_file_offset_ = file_offset + len;
 }
@@ -1988,16 +2270,16 @@ Dwp_output_file::sized_write_ehdr()
 		      ? this->shstrndx_
 		      : static_cast<unsigned int>(elfcpp::SHN_XINDEX));
 
-  ::fseek(this->fd_, 0, 0);
-  if (::fwrite(buf, 1, ehdr_size, this->fd_) < ehdr_size)
+  if (!this->write_at(0, buf, ehdr_size))
     gold_fatal(_("%s: error writing ELF header"), this->name_);
 }
 
 // Write a section header.
 
 void
-Dwp_output_file::write_shdr(const char* name, unsigned int type,
-			    unsigned int flags, uint64_t addr, off_t offset,
+Dwp_output_file::write_shdr(unsigned char* p, const char* name,
+			    unsigned int type, unsigned int flags,
+			    uint64_t addr, off_t offset,
 			    section_size_type sect_size, unsigned int link,
 			    unsigned int info, unsigned int align,
 			    unsigned int ent_size)
@@ -2005,22 +2287,22 @@ Dwp_output_file::write_shdr(const char* name, unsigned int type,
   if (this->size_ == 32)
     {
       if (this->big_endian_)
-	return this->sized_write_shdr<32, true>(name, type, flags, addr,
+	return this->sized_write_shdr<32, true>(p, name, type, flags, addr,
 						offset, sect_size, link, info,
 						align, ent_size);
       else
-	return this->sized_write_shdr<32, false>(name, type, flags, addr,
+	return this->sized_write_shdr<32, false>(p, name, type, flags, addr,
 						 offset, sect_size, link, info,
 						 align, ent_size);
     }
   else if (this->size_ == 64)
     {
       if (this->big_endian_)
-	return this->sized_write_shdr<64, true>(name, type, flags, addr,
+	return this->sized_write_shdr<64, true>(p, name, type, flags, addr,
 						offset, sect_size, link, info,
 						align, ent_size);
       else
-	return this->sized_write_shdr<64, false>(name, type, flags, addr,
+	return this->sized_write_shdr<64, false>(p, name, type, flags, addr,
 						 offset, sect_size, link, info,
 						 align, ent_size);
     }
@@ -2030,15 +2312,14 @@ Dwp_output_file::write_shdr(const char* name, unsigned int type,
 
 template<unsigned int size, bool big_endian>
 void
-Dwp_output_file::sized_write_shdr(const char* name, unsigned int type,
-				  unsigned int flags, uint64_t addr,
-				  off_t offset, section_size_type sect_size,
+Dwp_output_file::sized_write_shdr(unsigned char* p, const char* name,
+				  unsigned int type, unsigned int flags,
+				  uint64_t addr, off_t offset,
+				  section_size_type sect_size,
 				  unsigned int link, unsigned int info,
 				  unsigned int align, unsigned int ent_size)
 {
-  const unsigned int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
-  unsigned char buf[shdr_size];
-  elfcpp::Shdr_write<size, big_endian> shdr(buf);
+  elfcpp::Shdr_write<size, big_endian> shdr(p);
 
   shdr.put_sh_name(name == NULL ? 0 : this->shstrtab_.get_offset(name));
   shdr.put_sh_type(type);
@@ -2050,8 +2331,6 @@ Dwp_output_file::sized_write_shdr(const char* name, unsigned int type,
   shdr.put_sh_info(info);
   shdr.put_sh_addralign(align);
   shdr.put_sh_entsize(ent_size);
-  if (::fwrite(buf, 1, shdr_size, this->fd_) < shdr_size)
-    gold_fatal(_("%s: error writing section header table"), this->name_);
 }
 
 // Class Dwo_name_info_reader.
@@ -2068,15 +2347,13 @@ Dwo_name_info_reader::visit_compilation_unit(off_t, off_t, Dwarf_die* die)
 
 // Class Unit_reader.
 
-// Read the CUs or TUs and add them to the output file.
+// Read the CUs or TUs and append them to UNITS.
 
 void
-Unit_reader::add_units(Dwp_output_file* output_file,
-		       unsigned int debug_abbrev,
-		       Section_bounds* sections)
+Unit_reader::read_units(unsigned int debug_abbrev,
+			std::vector<Input_unit>* units)
 {
-  this->output_file_ = output_file;
-  this->sections_ = sections;
+  this->units_ = units;
   this->set_abbrev_shndx(debug_abbrev);
   this->parse();
 }
@@ -2084,52 +2361,150 @@ Unit_reader::add_units(Dwp_output_file* output_file,
 // Visit a compilation unit.
 
 void
-Unit_reader::visit_compilation_unit(off_t, off_t cu_length, Dwarf_die* die)
+Unit_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
+				    Dwarf_die* die)
 {
   if (cu_length == 0)
     return;
 
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
-
-  // Dwp_output_file::add_contribution writes the .debug_info.dwo section
-  // directly to the output file, so we do not need to duplicate the
-  // section contents, and add_contribution does not need to free the memory.
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_INFO,
-					   this->buffer_at_offset(0),
-					   cu_length, 1);
-  Section_bounds bounds(off, cu_length);
-  unit_set->sections[elfcpp::DW_SECT_INFO] = bounds;
-  this->output_file_->add_cu_set(unit_set);
+  Input_unit unit;
+  unit.signature = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
+  unit.bounds = Section_bounds(cu_offset, cu_length);
+  this->units_->push_back(unit);
 }
 
-// Visit a type unit.
+// Visit a type unit.  We check for duplicate type signatures when
+// the unit is added to the output file.
 
 void
-Unit_reader::visit_type_unit(off_t, off_t tu_length, off_t,
+Unit_reader::visit_type_unit(off_t tu_offset, off_t tu_length, off_t,
 			     uint64_t signature, Dwarf_die*)
 {
   if (tu_length == 0)
     return;
-  if (this->output_file_->lookup_tu(signature))
-    return;
 
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = signature;
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
-
-  unsigned char* contents = new unsigned char[tu_length];
-  memcpy(contents, this->buffer_at_offset(0), tu_length);
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_TYPES, contents,
-					   tu_length, 1);
-  Section_bounds bounds(off, tu_length);
-  unit_set->sections[elfcpp::DW_SECT_TYPES] = bounds;
-  this->output_file_->add_tu_set(unit_set);
+  Input_unit unit;
+  unit.signature = signature;
+  unit.bounds = Section_bounds(tu_offset, tu_length);
+  this->units_->push_back(unit);
+}
+
+// The number of input files to read at once.  The files of a batch
+// are held open until their contents have been added to the output
+// file.
+
+static const size_t dwp_read_batch_size = 64;
+
+// The number of threads to use with --threads when --thread-count is
+// not given.
+
+static const size_t dwp_default_thread_count = 8;
+
+// Return the number of helper tasks to run JOB_COUNT jobs.
+
+static size_t
+dwp_helpers(size_t job_count)
+{
+  gold_assert(job_count > 0);
+  if (!parameters->options().threads())
+    return 0;
+  size_t thread_count = parameters->options().thread_count();
+  if (thread_count == 0)
+    thread_count = dwp_default_thread_count;
+  return std::min(job_count - 1, thread_count - 1);
+}
+
+typedef std::vector<Dwo_file*> Dwo_file_list;
+
+// Read a batch of input files.
+
+class Dwo_read_work : public Parallel_work
+{
+ public:
+  Dwo_read_work(Dwo_file* const* files, size_t count)
+    : Parallel_work(count, "dwo_read"), files_(files)
+  { }
+
+ protected:
+  void
+  do_run(size_t i, const Task*)
+  { this->files_[i]->read(); }
+
+ private:
+  Dwo_file* const* files_;
+};
+
+// Copy the contributions of the input files to the output file.
+
+class Dwo_write_work : public Parallel_work
+{
+ public:
+  Dwo_write_work(const Dwo_file_list& files, Dwp_output_file* output_file)
+    : Parallel_work(files.size(), "dwo_write"), files_(files),
+      output_file_(output_file)
+  { }
+
+ protected:
+  void
+  do_run(size_t i, const Task*)
+  { this->files_[i]->write_contributions(this->output_file_); }
+
+ private:
+  const Dwo_file_list& files_;
+  Dwp_output_file* output_file_;
+};
+
+// The task which builds the output file.
+
+class Dwp_runner : public Task_function_runner
+{
+ public:
+  Dwp_runner(const Dwo_file_list& files, Dwp_output_file* output_file,
+	     bool verbose)
+    : files_(files), output_file_(output_file), verbose_(verbose)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const Dwo_file_list& files_;
+  Dwp_output_file* output_file_;
+  bool verbose_;
+};
+
+// Read the input files a batch at a time, several at once, and add
+// each one's contents to the output file in turn.  Then lay out the
+// output file and copy the contents of all the input files into it.
+
+void
+Dwp_runner::run(Workqueue* workqueue, const Task* task)
+{
+  const size_t file_count = this->files_.size();
+  for (size_t first = 0; first < file_count; first += dwp_read_batch_size)
+    {
+      size_t count = std::min(dwp_read_batch_size, file_count - first);
+      Dwo_read_work* work = new Dwo_read_work(&this->files_[first], count);
+      work->run(workqueue, task, dwp_helpers(count));
+
+      for (size_t i = first; i < first + count; ++i)
+	{
+	  if (this->verbose_)
+	    fprintf(stderr, "%s\n", this->files_[i]->name());
+	  this->files_[i]->add_to_output(this->output_file_);
+	}
+    }
+
+  this->output_file_->layout_sections();
+
+  if (file_count > 0)
+    {
+      Dwo_write_work* work = new Dwo_write_work(this->files_,
+						this->output_file_);
+      work->run(workqueue, task, dwp_helpers(file_count));
+    }
+
+  this->output_file_->finalize();
 }
 
 }; // End namespace gold
@@ -2138,11 +2513,21 @@ using namespace gold;
 
 // Options.
 
+// Codes for the options which have no short form.
+
+enum
+{
+  OPT_THREADS = 256,
+  OPT_THREAD_COUNT
+};
+
 struct option dwp_options[] =
   {
     { "exec", required_argument, NULL, 'e' },
     { "help", no_argument, NULL, 'h' },
     { "output", required_argument, NULL, 'o' },
+    { "threads", no_argument, NULL, OPT_THREADS },
+    { "thread-count", required_argument, NULL, OPT_THREAD_COUNT },
     { "verbose", no_argument, NULL, 'v' },
     { "version", no_argument, NULL, 'V' },
     { NULL, 0, NULL, 0 }
@@ -2158,6 +2543,9 @@ usage(FILE* fd, int exit_status)
   fprintf(fd, _("  -e EXE, --exec EXE       Get list of dwo files from EXE"
 		" (defaults output to EXE.dwp)\n"));
   fprintf(fd, _("  -o FILE, --output FILE   Set output dwp file name\n"));
+  fprintf(fd, _("      --threads            Read and write the files"
+		" using multiple threads\n"));
+  fprintf(fd, _("      --thread-count COUNT Number of threads to use\n"));
   fprintf(fd, _("  -v, --verbose            Verbose output\n"));
   fprintf(fd, _("  -V, --version            Print version number\n"));
 
@@ -2218,6 +2606,9 @@ main(int argc, char** argv)
   std::string output_filename;
   const char* exe_filename = NULL;
   bool verbose = false;
+  bool threads = false;
+  int thread_count = 0;
+  char* endptr;
   int c;
   while ((c = getopt_long(argc, argv, "e:ho:vV", dwp_options, NULL)) != -1)
     {
@@ -2231,6 +2622,14 @@ main(int argc, char** argv)
 	  case 'o':
 	    output_filename.assign(optarg);
 	    break;
+	  case OPT_THREADS:
+	    threads = true;
+	    break;
+	  case OPT_THREAD_COUNT:
+	    thread_count = strtol(optarg, &endptr, 0);
+	    if (*endptr != '\0' || thread_count < 0)
+	      gold_fatal(_("invalid --thread-count: %s"), optarg);
+	    break;
 	  case 'v':
 	    verbose = true;
 	    break;
@@ -2250,6 +2649,21 @@ main(int argc, char** argv)
       output_filename.append(".dwp");
     }
 
+#ifndef ENABLE_THREADS
+  if (threads)
+    {
+      gold_warning(_("ignoring --threads: "
+		     "%s was compiled without thread support"),
+		   program_name);
+      threads = false;
+    }
+  if (thread_count > 0)
+    gold_warning(_("ignoring --thread-count: "
+		   "%s was compiled without thread support"),
+		 program_name);
+#endif
+  options.set_threading(threads, thread_count);
+
   Dwp_output_file output_file(output_filename.c_str());
 
   // Get list of .dwo files from the executable.
@@ -2267,15 +2681,26 @@ main(int argc, char** argv)
     gold_fatal(_("no input files and no executable specified"));
 
   // Process each file, adding its contents to the output file.
+  Dwo_file_list dwo_files;
+  dwo_files.reserve(files.size());
   for (File_list::const_iterator f = files.begin(); f != files.end(); ++f)
-    {
-      if (verbose)
-        fprintf(stderr, "%s\n", f->c_str());
-      Dwo_file dwo_file(f->c_str());
-      dwo_file.read(&output_file);
-    }
-
-  output_file.finalize();
+    dwo_files.push_back(new Dwo_file(f->c_str()));
+
+  Workqueue workqueue(options);
+  if (threads)
+    workqueue.set_thread_count(thread_count > 0
+			       ? thread_count
+			       : static_cast<int>(dwp_default_thread_count));
+  workqueue.queue(new Task_function(new Dwp_runner(dwo_files, &output_file,
+						   verbose),
+				    new Task_token(true),
+				    "Task_function Dwp_runner"));
+  workqueue.process(0);
+
+  for (Dwo_file_list::iterator p = dwo_files.begin();
+       p != dwo_files.end();
+       ++p)
+    delete *p;
 
   return EXIT_SUCCESS;
 }
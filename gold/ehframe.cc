@@ -29,6 +29,7 @@
 #include "dwarf.h"
 #include "symtab.h"
 #include "reloc.h"
+#include "workqueue.h"
 #include "ehframe.h"
 
 namespace gold
@@ -84,6 +85,8 @@ Eh_frame_hdr::Eh_frame_hdr(Output_section* eh_frame_section,
     eh_frame_section_(eh_frame_section),
     eh_frame_data_(eh_frame_data),
     fde_offsets_(),
+    fde_addresses_(),
+    fde_table_valid_(false),
     any_unrecognized_eh_frame_sections_(false)
 {
 }
@@ -179,24 +182,18 @@ Eh_frame_hdr::do_sized_write(Output_file* of)
 
       // We have the offsets of the FDEs in the .eh_frame section.  We
       // couldn't easily get the PC values before, as they depend on
-      // relocations which are, of course, target specific.  This code
-      // is run after all those relocations have been applied to the
-      // output file.  Here we read the output file again to find the
-      // PC values.  Then we sort the list and write it out.
-
-      Fde_addresses<size> fde_addresses(this->fde_offsets_.size());
-      this->get_fde_addresses<size, big_endian>(of, &this->fde_offsets_,
-						&fde_addresses);
-
-      std::sort(fde_addresses.begin(), fde_addresses.end(),
-		Fde_address_compare<size>());
+      // relocations which are, of course, target specific.  The table
+      // is normally built by build_fde_table once all those
+      // relocations have been applied to the output file.
+      if (!this->fde_table_valid_)
+	this->sized_build_fde_table<size, big_endian>(of, NULL, NULL);
 
       typename elfcpp::Elf_types<size>::Elf_Addr output_address;
       output_address = this->address();
 
       unsigned char* pfde = oview + 12;
-      for (typename Fde_addresses<size>::iterator p = fde_addresses.begin();
-	   p != fde_addresses.end();
+      for (Fde_addresses::const_iterator p = this->fde_addresses_.begin();
+	   p != this->fde_addresses_.end();
 	   ++p)
 	{
 	  elfcpp::Swap<32, big_endian>::writeval(pfde,
@@ -206,6 +203,8 @@ Eh_frame_hdr::do_sized_write(Output_file* of)
 	  pfde += 8;
 	}
 
+      Fde_addresses().swap(this->fde_addresses_);
+
       gold_assert(pfde - oview == oview_size);
     }
 
@@ -290,37 +289,193 @@ Eh_frame_hdr::get_fde_pc(
   return pc;
 }
 
-// Given an array of FDE offsets in the .eh_frame section, return an
-// array of offsets from the exception frame header to the FDE's
-// output PC and to the output address of the FDE itself.  We get the
-// FDE's PC by actually looking in the .eh_frame section we just wrote
-// to the output file.
+// Convert the FDE offsets from START up to END into addresses of the
+// FDE's output PC and of the FDE itself.  We get the FDE's PC by
+// actually looking in the .eh_frame section we just wrote to the
+// output file, whose contents are EH_FRAME_CONTENTS.
 
 template<int size, bool big_endian>
 void
-Eh_frame_hdr::get_fde_addresses(Output_file* of,
-				const Fde_offsets* fde_offsets,
-				Fde_addresses<size>* fde_addresses)
+Eh_frame_hdr::get_fde_addresses(const unsigned char* eh_frame_contents,
+				size_t start, size_t end)
 {
   typename elfcpp::Elf_types<size>::Elf_Addr eh_frame_address;
   eh_frame_address = this->eh_frame_section_->address();
+
+  for (size_t i = start; i < end; ++i)
+    {
+      const Fde_offset& fde_offset(this->fde_offsets_[i]);
+      typename elfcpp::Elf_types<size>::Elf_Addr fde_pc;
+      fde_pc = this->get_fde_pc<size, big_endian>(eh_frame_address,
+						  eh_frame_contents,
+						  fde_offset.first,
+						  fde_offset.second);
+      this->fde_addresses_[i] = std::make_pair(fde_pc,
+					       (eh_frame_address
+						+ fde_offset.first));
+    }
+}
+
+// The FDE table is built in blocks of this many FDEs.  Each block is
+// converted and sorted by one job, and then the sorted blocks are
+// merged in pairs.  The blocks do not depend on the number of
+// threads, and the table is sorted on both addresses, so neither
+// does the output.
+
+static const size_t fde_table_block_size = 16384;
+
+// The most helper tasks to use when the thread count is not known.
+
+static const size_t parallel_fde_table_max_helpers = 8;
+
+// The jobs to convert and sort the blocks of the FDE table.
+
+template<int size, bool big_endian>
+class Fde_table_sort_work : public Parallel_work
+{
+ public:
+  Fde_table_sort_work(Eh_frame_hdr* eh_frame_hdr,
+		      const unsigned char* eh_frame_contents, size_t count)
+    : Parallel_work(count, "fde_table_sort"),
+      eh_frame_hdr_(eh_frame_hdr), eh_frame_contents_(eh_frame_contents)
+  { }
+
+ protected:
+  void
+  do_run(size_t i, const Task*)
+  {
+    Eh_frame_hdr::Fde_addresses& fdes(this->eh_frame_hdr_->fde_addresses_);
+    size_t start = i * fde_table_block_size;
+    size_t end = std::min(start + fde_table_block_size, fdes.size());
+    this->eh_frame_hdr_->get_fde_addresses<size, big_endian>(
+	this->eh_frame_contents_, start, end);
+    std::sort(fdes.begin() + start, fdes.begin() + end);
+  }
+
+ private:
+  Eh_frame_hdr* eh_frame_hdr_;
+  const unsigned char* eh_frame_contents_;
+};
+
+// The jobs to merge pairs of sorted runs of WIDTH FDEs.
+
+template<typename Fde_addresses>
+class Fde_table_merge_work : public Parallel_work
+{
+ public:
+  Fde_table_merge_work(Fde_addresses* fdes, size_t width, size_t count)
+    : Parallel_work(count, "fde_table_merge"),
+      fdes_(fdes), width_(width)
+  { }
+
+ protected:
+  void
+  do_run(size_t i, const Task*)
+  {
+    size_t start = 2 * i * this->width_;
+    size_t middle = start + this->width_;
+    size_t end = std::min(middle + this->width_, this->fdes_->size());
+    std::inplace_merge(this->fdes_->begin() + start,
+		       this->fdes_->begin() + middle,
+		       this->fdes_->begin() + end);
+  }
+
+ private:
+  Fde_addresses* fdes_;
+  size_t width_;
+};
+
+// Return the number of helper tasks to run JOB_COUNT jobs.
+
+static size_t
+parallel_fde_table_helpers(size_t job_count)
+{
+  gold_assert(job_count > 0);
+  size_t helpers = job_count - 1;
+  size_t thread_count = parameters->options().thread_count_final();
+  if (thread_count == 0)
+    return std::min(helpers, parallel_fde_table_max_helpers);
+  return std::min(helpers, thread_count - 1);
+}
+
+// Build the sorted FDE table.
+
+void
+Eh_frame_hdr::build_fde_table(Output_file* of, Workqueue* workqueue,
+			      const Task* task)
+{
+  if (this->any_unrecognized_eh_frame_sections_
+      || this->fde_offsets_.empty())
+    return;
+
+  switch (parameters->size_and_endianness())
+    {
+#ifdef HAVE_TARGET_32_LITTLE
+    case Parameters::TARGET_32_LITTLE:
+      this->sized_build_fde_table<32, false>(of, workqueue, task);
+      break;
+#endif
+#ifdef HAVE_TARGET_32_BIG
+    case Parameters::TARGET_32_BIG:
+      this->sized_build_fde_table<32, true>(of, workqueue, task);
+      break;
+#endif
+#ifdef HAVE_TARGET_64_LITTLE
+    case Parameters::TARGET_64_LITTLE:
+      this->sized_build_fde_table<64, false>(of, workqueue, task);
+      break;
+#endif
+#ifdef HAVE_TARGET_64_BIG
+    case Parameters::TARGET_64_BIG:
+      this->sized_build_fde_table<64, true>(of, workqueue, task);
+      break;
+#endif
+    default:
+      gold_unreachable();
+    }
+}
+
+// Build the sorted FDE table with the right size and endianness.
+// WORKQUEUE may be NULL, in which case the table is built by this
+// thread alone.
+
+template<int size, bool big_endian>
+void
+Eh_frame_hdr::sized_build_fde_table(Output_file* of, Workqueue* workqueue,
+				    const Task* task)
+{
   off_t eh_frame_offset = this->eh_frame_section_->offset();
   off_t eh_frame_size = this->eh_frame_section_->data_size();
   const unsigned char* eh_frame_contents = of->get_input_view(eh_frame_offset,
 							      eh_frame_size);
 
-  for (Fde_offsets::const_iterator p = fde_offsets->begin();
-       p != fde_offsets->end();
-       ++p)
+  size_t fde_count = this->fde_offsets_.size();
+  this->fde_addresses_.resize(fde_count);
+  size_t block_count = ((fde_count + fde_table_block_size - 1)
+			/ fde_table_block_size);
+  bool parallel = workqueue != NULL && parameters->options().threads();
+
+  Fde_table_sort_work<size, big_endian>* sort_work =
+    new Fde_table_sort_work<size, big_endian>(this, eh_frame_contents,
+					      block_count);
+  sort_work->run(workqueue, task,
+		 parallel ? parallel_fde_table_helpers(block_count) : 0);
+
+  for (size_t width = fde_table_block_size;
+       width < fde_count;
+       width *= 2)
     {
-      typename elfcpp::Elf_types<size>::Elf_Addr fde_pc;
-      fde_pc = this->get_fde_pc<size, big_endian>(eh_frame_address,
-						  eh_frame_contents,
-						  p->first, p->second);
-      fde_addresses->push_back(fde_pc, eh_frame_address + p->first);
+      size_t merge_count = (fde_count - width + 2 * width - 1) / (2 * width);
+      Fde_table_merge_work<Fde_addresses>* merge_work =
+	new Fde_table_merge_work<Fde_addresses>(&this->fde_addresses_, width,
+						merge_count);
+      merge_work->run(workqueue, task,
+		      parallel ? parallel_fde_table_helpers(merge_count) : 0);
     }
 
   of->free_input_view(eh_frame_offset, eh_frame_size, eh_frame_contents);
+
+  this->fde_table_valid_ = true;
 }
 
 // Class Fde.
@@ -36,6 +36,9 @@ namespace gold
 template<int size, bool big_endian>
 class Track_relocs;
 
+class Task;
+class Workqueue;
+
 class Eh_frame;
 
 // This class manages the .eh_frame_hdr section, which holds the data
@@ -63,6 +66,14 @@ class Eh_frame_hdr : public Output_section_data
       this->fde_offsets_.push_back(std::make_pair(fde_offset, fde_encoding));
   }
 
+  // Build the sorted table of FDEs.  This is called after the
+  // .eh_frame section has been written to OF and relocated.  When
+  // using threads, the table is built by several tasks queued on
+  // WORKQUEUE; TASK is the task calling this.  If this is not called,
+  // the table is built when the section is written.
+  void
+  build_fde_table(Output_file* of, Workqueue* workqueue, const Task* task);
+
  protected:
   // Set the final data size.
   void
@@ -78,6 +89,9 @@ class Eh_frame_hdr : public Output_section_data
   { mapfile->print_output_data(this, _("** eh_frame_hdr")); }
 
  private:
+  template<int size, bool big_endian>
+  friend class Fde_table_sort_work;
+
   // Write the data to the file with the right endianness.
   template<int size, bool big_endian>
   void
@@ -91,48 +105,14 @@ class Eh_frame_hdr : public Output_section_data
   typedef std::vector<Fde_offset> Fde_offsets;
 
   // When writing out the header, we convert the FDE offsets into FDE
-  // addresses.  This is a list of pairs of the offset from the header
-  // to the FDE PC and to the FDE itself.
-  template<int size>
-  class Fde_addresses
-  {
-   public:
-    typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
-    typedef typename std::pair<Address, Address> Fde_address;
-    typedef typename std::vector<Fde_address> Fde_address_list;
-    typedef typename Fde_address_list::iterator iterator;
-
-    Fde_addresses(unsigned int reserve)
-      : fde_addresses_()
-    { this->fde_addresses_.reserve(reserve); }
-
-    void
-    push_back(Address pc_address, Address fde_address)
-    {
-      this->fde_addresses_.push_back(std::make_pair(pc_address, fde_address));
-    }
-
-    iterator
-    begin()
-    { return this->fde_addresses_.begin(); }
-
-    iterator
-    end()
-    { return this->fde_addresses_.end(); }
+  // addresses.  This is a pair of the address of the FDE PC and the
+  // address of the FDE itself.  The table is sorted by both, so that
+  // the order of FDEs with the same PC does not depend on how the
+  // table was sorted.
+  typedef std::pair<uint64_t, uint64_t> Fde_address;
 
-   private:
-    Fde_address_list fde_addresses_;
-  };
-
-  // Compare Fde_address objects.
-  template<int size>
-  struct Fde_address_compare
-  {
-    bool
-    operator()(const typename Fde_addresses<size>::Fde_address& f1,
-	       const typename Fde_addresses<size>::Fde_address& f2) const
-    { return f1.first < f2.first; }
-  };
+  // The list of FDE addresses.
+  typedef std::vector<Fde_address> Fde_addresses;
 
   // Return the PC to which an FDE refers.
   template<int size, bool big_endian>
@@ -141,12 +121,17 @@ class Eh_frame_hdr : public Output_section_data
 	     const unsigned char* eh_frame_contents,
 	     section_offset_type fde_offset, unsigned char fde_encoding);
 
-  // Convert Fde_offsets to Fde_addresses.
+  // Convert the FDE offsets from START up to END to FDE addresses,
+  // given the contents of the .eh_frame section in the output file.
   template<int size, bool big_endian>
   void
-  get_fde_addresses(Output_file* of,
-		    const Fde_offsets* fde_offsets,
-		    Fde_addresses<size>* fde_addresses);
+  get_fde_addresses(const unsigned char* eh_frame_contents,
+		    size_t start, size_t end);
+
+  // Build the sorted FDE table with the right size and endianness.
+  template<int size, bool big_endian>
+  void
+  sized_build_fde_table(Output_file*, Workqueue*, const Task*);
 
   // The .eh_frame section.
   Output_section* eh_frame_section_;
@@ -154,6 +139,11 @@ class Eh_frame_hdr : public Output_section_data
   const Eh_frame* eh_frame_data_;
   // Data from the FDEs in the .eh_frame sections.
   Fde_offsets fde_offsets_;
+  // The sorted FDE table, built after the .eh_frame section has been
+  // written.
+  Fde_addresses fde_addresses_;
+  // Whether fde_addresses_ has been built.
+  bool fde_table_valid_;
   // Whether we found any .eh_frame sections which we could not
   // process.
   bool any_unrecognized_eh_frame_sections_;
@@ -364,6 +354,11 @@ class Eh_frame : public Output_section_data
   set_eh_frame_hdr(Eh_frame_hdr* hdr)
   { this->eh_frame_hdr_ = hdr; }
 
+  // Return the exception frame header, or NULL if there is none.
+  Eh_frame_hdr*
+  eh_frame_hdr() const
+  { return this->eh_frame_hdr_; }
+
   // Add the input section SHNDX in OBJECT.  SYMBOLS is the contents
   // of the symbol table section (size SYMBOLS_SIZE), SYMBOL_NAMES is
   // the symbol names section (size SYMBOL_NAMES_SIZE).  RELOC_SHNDX
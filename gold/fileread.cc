@@ -115,6 +115,71 @@ get_mtime(const char* filename, Timespec* mtime)
   return true;
 }
 
+// Compute a checksum of the contents of an unopened file.  This is
+// not a cryptographic hash; it only has to notice real changes to an
+// input file.  It mixes in eight bytes at a time, read as a little
+// endian word, so the result does not depend on the host.
+
+bool
+get_file_checksum(const char* filename, uint64_t* checksum)
+{
+  int o = open_descriptor(-1, filename, O_RDONLY);
+  if (o < 0)
+    return false;
+
+  const uint64_t mult = 0x9e3779b97f4a7c15ULL;
+  const size_t buffer_size = 1 << 20;
+  unsigned char* buffer = new unsigned char[buffer_size];
+  uint64_t h = 0;
+  uint64_t length = 0;
+  bool ok = true;
+  bool eof = false;
+  while (ok && !eof)
+    {
+      // Fill the whole buffer, so that the words stay aligned with
+      // the file across reads.
+      size_t len = 0;
+      while (len < buffer_size)
+	{
+	  ssize_t bytes = ::read(o, buffer + len, buffer_size - len);
+	  if (bytes < 0 && errno == EINTR)
+	    continue;
+	  if (bytes < 0)
+	    {
+	      ok = false;
+	      break;
+	    }
+	  if (bytes == 0)
+	    {
+	      eof = true;
+	      break;
+	    }
+	  len += bytes;
+	}
+      length += len;
+
+      // Pad the last word with zeroes.  The length is mixed in at the
+      // end, so the padding can not hide a change.
+      while (len % 8 != 0)
+	buffer[len++] = 0;
+      for (size_t i = 0; i < len; i += 8)
+	{
+	  h = (h ^ elfcpp::Swap_unaligned<64, false>::readval(buffer + i))
+	      * mult;
+	  h ^= h >> 29;
+	}
+    }
+  delete[] buffer;
+  release_descriptor(o, true);
+  if (!ok)
+    return false;
+
+  h = (h ^ length) * mult;
+  h ^= h >> 32;
+  *checksum = h != 0 ? h : 1;
+  return true;
+}
+
 // Class File_read.
 
 // A lock for the File_read static variables.
@@ -211,6 +276,17 @@ File_read::open(const Task* task, const std::string& name)
       this->size_ = s.st_size;
       gold_debug(DEBUG_FILES, "Attempt to open %s succeeded",
 		 this->name_.c_str());
+
+      // The tasks which read the file are queued right after the
+      // file is opened.  With --io-hints, ask the kernel to start
+      // reading the file in now, so that those tasks do not wait for
+      // the disk.  This is only a hint, so ignore any error.
+#ifdef POSIX_FADV_WILLNEED
+      if (parameters->options_valid()
+	  && parameters->options().io_hints_input())
+	::posix_fadvise(this->descriptor_, 0, this->size_,
+			POSIX_FADV_WILLNEED);
+#endif
       this->token_.add_writer(task);
     }
 
@@ -857,6 +933,40 @@ File_read::print_stats()
 	  program_name, File_read::maximum_mapped_bytes);
 }
 
+// Tell the kernel that the SIZE bytes at DATA, which were returned
+// by get_view or get_lasting_view, will be read sequentially.  This
+// is used for the relocation sections.
+
+void
+File_read::advise_sequential(const unsigned char* data,
+			     section_size_type size)
+{
+#if defined(HAVE_MMAP) && defined(MADV_SEQUENTIAL)
+  if (size == 0
+      || !parameters->options_valid()
+      || !parameters->options().io_hints_input())
+    return;
+
+  uintptr_t system_page_size = File_read::page_size;
+#ifdef HAVE_SYSCONF
+  long ps = ::sysconf(_SC_PAGESIZE);
+  if (ps > 0)
+    system_page_size = ps;
+#endif
+
+  // madvise needs a page aligned address.  The pages before DATA
+  // belong to the same view, so it is fine to include them.  This is
+  // only a hint, so ignore any error.
+  uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  uintptr_t pstart = start & ~(system_page_size - 1);
+  ::madvise(reinterpret_cast<char*>(pstart), size + (start - pstart),
+	    MADV_SEQUENTIAL);
+#else
+  (void) data;
+  (void) size;
+#endif
+}
+
 // Class File_view.
 
 File_view::~File_view()
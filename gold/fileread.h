@@ -58,6 +58,14 @@ struct Timespec
 bool
 get_mtime(const char* filename, Timespec* mtime);
 
+// Compute a checksum of the contents of an unopened file, used by
+// incremental links to tell whether a file whose modification time
+// changed really has different contents.  The checksum is never 0.
+// Returns false if the file can not be read.
+
+bool
+get_file_checksum(const char* filename, uint64_t* checksum);
+
 class Position_dependent_options;
 class Input_file_argument;
 class Dirsearch;
@@ -207,6 +215,13 @@ class File_read
   static void
   print_stats();
 
+  // Tell the kernel that the SIZE bytes at DATA, which point into a
+  // view of some file, will be read sequentially.  This is only a
+  // hint, and it does nothing unless --io-hints asks for hints on the
+  // input files.
+  static void
+  advise_sequential(const unsigned char* data, section_size_type size);
+
   // Return the open file descriptor (for plugins).
   int
   descriptor()
@@ -22,18 +22,191 @@
 
 
 #include "gold.h"
+
+#include <algorithm>
+
 #include "object.h"
 #include "gc.h"
 #include "symtab.h"
+#include "workqueue.h"
 
 namespace gold
 {
 
+// The sections are marked in parallel if there are at least this many
+// sections with references.
+
+static const size_t parallel_gc_min_sections = 16384;
+
+// The most helper tasks to use when the --thread-count-middle option
+// does not say how many threads to use.
+
+static const size_t parallel_gc_max_helpers = 8;
+
+// A worker moves sections to the shared pool in chunks of this many,
+// once it has at least twice as many of its own.
+
+static const size_t parallel_gc_chunk = 256;
+
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4
+
+// This class marks the sections reachable from the sections in a
+// shared pool.  The sections with references are numbered by their
+// position in the sorted vector KEYS, and each has a mark bit in
+// MARKS, set atomically.  Each job is a worker which takes sections
+// from the pool and walks their references, giving some of its work
+// back to the pool when it has plenty, until no worker has any left.
+// Sections reached which have no references of their own are added to
+// LEAVES.
+
+class Gc_mark_work : public Parallel_work
+{
+ public:
+  typedef Garbage_collection::Sections_reachable Sections_reachable;
+
+  Gc_mark_work(size_t workers, const std::vector<Section_id>& keys,
+	       const std::vector<const Sections_reachable*>& refs,
+	       std::vector<unsigned int>* marks,
+	       std::vector<unsigned int>* pool,
+	       Sections_reachable* leaves)
+    : Parallel_work(workers, "gc_mark"),
+      keys_(keys), refs_(refs), marks_(marks), pool_(pool), leaves_(leaves),
+      lock_(), condvar_(lock_), busy_(0)
+  { }
+
+  // Set the mark bit of section I, returning true if it was clear.
+  static bool
+  set_mark(std::vector<unsigned int>* marks, unsigned int i)
+  {
+    unsigned int bit = 1U << (i % 32);
+    unsigned int old = __sync_fetch_and_or(&(*marks)[i / 32], bit);
+    return (old & bit) == 0;
+  }
+
+ protected:
+  void
+  do_run(size_t, const Task*);
+
+ private:
+  // Walk the references of the sections on STACK.
+  void
+  mark(std::vector<unsigned int>* stack, Sections_reachable* leaves);
+
+  const std::vector<Section_id>& keys_;
+  const std::vector<const Sections_reachable*>& refs_;
+  std::vector<unsigned int>* marks_;
+  // The sections waiting to be walked, protected by LOCK_.
+  std::vector<unsigned int>* pool_;
+  // The reached sections without references, protected by LOCK_.
+  Sections_reachable* leaves_;
+  Lock lock_;
+  // Signalled when sections are added to the pool, or when the last
+  // busy worker runs out of work.
+  Condvar condvar_;
+  // The number of workers walking sections, protected by LOCK_.
+  int busy_;
+};
+
+void
+Gc_mark_work::do_run(size_t, const Task*)
+{
+  std::vector<unsigned int> stack;
+  Sections_reachable leaves;
+  while (true)
+    {
+      {
+	Hold_lock hl(this->lock_);
+	while (this->pool_->empty() && this->busy_ > 0)
+	  this->condvar_.wait();
+	if (this->pool_->empty())
+	  {
+	    // Every section has been walked.
+	    this->leaves_->insert(leaves.begin(), leaves.end());
+	    this->condvar_.broadcast();
+	    return;
+	  }
+	size_t count = std::min(this->pool_->size(), parallel_gc_chunk);
+	stack.assign(this->pool_->end() - count, this->pool_->end());
+	this->pool_->resize(this->pool_->size() - count);
+	++this->busy_;
+      }
+
+      this->mark(&stack, &leaves);
+
+      {
+	Hold_lock hl(this->lock_);
+	--this->busy_;
+	if (this->busy_ == 0 && this->pool_->empty())
+	  this->condvar_.broadcast();
+      }
+    }
+}
+
+void
+Gc_mark_work::mark(std::vector<unsigned int>* stack,
+		   Sections_reachable* leaves)
+{
+  size_t walked = 0;
+  while (!stack->empty())
+    {
+      unsigned int i = stack->back();
+      stack->pop_back();
+      const Sections_reachable* refs = this->refs_[i];
+      for (Sections_reachable::const_iterator p = refs->begin();
+	   p != refs->end();
+	   ++p)
+	{
+	  std::vector<Section_id>::const_iterator pk =
+	    std::lower_bound(this->keys_.begin(), this->keys_.end(), *p);
+	  if (pk == this->keys_.end() || *pk != *p)
+	    leaves->insert(*p);
+	  else
+	    {
+	      unsigned int j = pk - this->keys_.begin();
+	      if (set_mark(this->marks_, j))
+		stack->push_back(j);
+	    }
+	}
+
+      // Now and then, give some work to workers waiting for it.
+      ++walked;
+      if (walked % parallel_gc_chunk == 0
+	  && stack->size() >= 2 * parallel_gc_chunk)
+	{
+	  Hold_lock hl(this->lock_);
+	  if (this->pool_->empty())
+	    {
+	      this->pool_->assign(stack->end() - parallel_gc_chunk,
+				  stack->end());
+	      stack->resize(stack->size() - parallel_gc_chunk);
+	      this->condvar_.broadcast();
+	    }
+	}
+    }
+}
+
+#endif // defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+
 // Garbage collection uses a worklist style algorithm to determine the 
-// transitive closure of all referenced sections.
+// transitive closure of all referenced sections.  With threads, and
+// enough sections, this is done by marking the sections in parallel.
 void 
-Garbage_collection::do_transitive_closure()
+Garbage_collection::do_transitive_closure(Workqueue* workqueue,
+					  const Task* task)
 {
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4
+  if (parameters->options().threads()
+      && this->section_reloc_map().size() >= parallel_gc_min_sections)
+    {
+      this->parallel_transitive_closure(workqueue, task);
+      this->worklist_ready();
+      return;
+    }
+#else
+  (void) workqueue;
+  (void) task;
+#endif
+
   while (!this->worklist().empty())
     {
       // Add elements from the work list to the referenced list
@@ -53,9 +226,10 @@ Garbage_collection::do_transitive_closure()
                 this->section_reloc_map().find(entry);
       if (find_it == this->section_reloc_map().end()) 
           continue;
-      Garbage_collection::Sections_reachable v = find_it->second;
+      const Garbage_collection::Sections_reachable& v(find_it->second);
       // Scan the vector of references for each work_list entry. 
-      for (Garbage_collection::Sections_reachable::iterator it_v = v.begin();
+      for (Garbage_collection::Sections_reachable::const_iterator it_v =
+	     v.begin();
            it_v != v.end();
            ++it_v)
         {
@@ -70,5 +244,68 @@ Garbage_collection::do_transitive_closure()
   this->worklist_ready();
 }
 
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4
+
+// Find the transitive closure of the sections in the work list by
+// marking the sections reachable from them in parallel.  The
+// referenced list ends up the same as when it is done one by one.
+
+void
+Garbage_collection::parallel_transitive_closure(Workqueue* workqueue,
+						const Task* task)
+{
+  // Number the sections with references in sorted order, so that a
+  // section's number can be found by a binary search.
+  std::vector<Section_id> keys;
+  std::vector<const Sections_reachable*> refs;
+  keys.reserve(this->section_reloc_map().size());
+  refs.reserve(this->section_reloc_map().size());
+  for (Section_ref::const_iterator p = this->section_reloc_map().begin();
+       p != this->section_reloc_map().end();
+       ++p)
+    {
+      keys.push_back(p->first);
+      refs.push_back(&p->second);
+    }
+
+  std::vector<unsigned int> marks((keys.size() + 31) / 32, 0);
+  std::vector<unsigned int> pool;
+  Sections_reachable leaves;
+
+  while (!this->worklist().empty())
+    {
+      Section_id entry = this->worklist().front();
+      this->worklist().pop();
+      std::vector<Section_id>::const_iterator pk =
+	std::lower_bound(keys.begin(), keys.end(), entry);
+      if (pk == keys.end() || *pk != entry)
+	leaves.insert(entry);
+      else
+	{
+	  unsigned int i = pk - keys.begin();
+	  if (Gc_mark_work::set_mark(&marks, i))
+	    pool.push_back(i);
+	}
+    }
+
+  if (!pool.empty())
+    {
+      size_t helpers = parallel_gc_max_helpers;
+      size_t thread_count = parameters->options().thread_count_middle();
+      if (thread_count != 0)
+	helpers = thread_count - 1;
+      Gc_mark_work* work = new Gc_mark_work(helpers + 1, keys, refs,
+					    &marks, &pool, &leaves);
+      work->run(workqueue, task, helpers);
+    }
+
+  for (unsigned int i = 0; i < keys.size(); ++i)
+    if ((marks[i / 32] & (1U << (i % 32))) != 0)
+      this->referenced_list().insert(keys[i]);
+  this->referenced_list().insert(leaves.begin(), leaves.end());
+}
+
+#endif // defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+
 } // End namespace gold.
 
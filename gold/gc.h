@@ -45,6 +45,8 @@ struct Reloc_types;
 class Output_section;
 class General_options;
 class Layout;
+class Task;
+class Workqueue;
 
 class Garbage_collection
 {
@@ -84,8 +86,11 @@ class Garbage_collection
   worklist_ready()
   { this->is_worklist_ready_ = true; }
 
+  // Find the sections reachable from those in the work list.  TASK is
+  // the task calling this, and the work may be shared with other tasks
+  // queued on WORKQUEUE.
   void
-  do_transitive_closure();
+  do_transitive_closure(Workqueue* workqueue, const Task* task);
 
   bool
   is_section_garbage(Object* obj, unsigned int shndx)
@@ -117,6 +122,10 @@ class Garbage_collection
   }
 
  private:
+  // Find the sections reachable from those in the work list, marking
+  // them in parallel.
+  void
+  parallel_transitive_closure(Workqueue* workqueue, const Task* task);
 
   Worklist_type work_list_;
   bool is_worklist_ready_;
@@ -22,12 +22,16 @@
 
 #include "gold.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "gdb-index.h"
 #include "dwarf_reader.h"
 #include "dwarf.h"
 #include "object.h"
 #include "output.h"
 #include "demangle.h"
+#include "workqueue.h"
 
 namespace gold
 {
@@ -171,6 +175,261 @@ mapped_index_string_hash(const unsigned char* str)
   return r;
 }
 
+class Gdb_index_info_reader;
+
+// This class holds what the .debug_info and .debug_types sections of
+// one input object add to the .gdb_index section.  The sections of
+// an object may be scanned in another thread, so the compilation
+// units and type units it records are numbered within the object, and
+// Gdb_index::add_scan adds them to the index later.
+
+class Gdb_index_scan
+{
+ public:
+  // Statistics gathered while scanning.
+  struct Stats
+  {
+    Stats()
+      : cu_count(0), cu_nopubnames_count(0), tu_count(0),
+	tu_nopubnames_count(0)
+    { }
+
+    unsigned int cu_count;
+    unsigned int cu_nopubnames_count;
+    unsigned int tu_count;
+    unsigned int tu_nopubnames_count;
+  };
+
+  // A compilation unit.
+  struct Comp_unit
+  {
+    Comp_unit(off_t off, off_t len)
+      : cu_offset(off), cu_length(len)
+    { }
+    off_t cu_offset;
+    off_t cu_length;
+  };
+
+  // A type unit.
+  struct Type_unit
+  {
+    Type_unit(off_t off, off_t toff, uint64_t sig)
+      : tu_offset(off), type_offset(toff), type_signature(sig)
+    { }
+    off_t tu_offset;
+    off_t type_offset;
+    uint64_t type_signature;
+  };
+
+  // The address ranges of a compilation unit.
+  struct Cu_ranges
+  {
+    Cu_ranges(int index, Dwarf_range_list* r)
+      : cu_index(index), ranges(r)
+    { }
+    int cu_index;
+    Dwarf_range_list* ranges;
+  };
+
+  // A symbol.  The name is at NAME_OFFSET in the names buffer.  The
+  // hash codes are computed here, so that they are computed in the
+  // thread which scans the object.
+  struct Symbol
+  {
+    Symbol(int index, size_t offset, size_t length, unsigned int hash,
+	   size_t phash)
+      : cu_index(index), name_offset(offset), name_length(length),
+	hashval(hash), pool_hash(phash)
+    { }
+    int cu_index;
+    size_t name_offset;
+    size_t name_length;
+    unsigned int hashval;
+    size_t pool_hash;
+  };
+
+  Gdb_index_scan(Relobj* object)
+    : object_(object), symbols_(NULL), symbols_size_(0), sections_(),
+      pubtables_mapped_(false), pubnames_table_(NULL), pubtypes_table_(NULL),
+      cu_pubname_map_(), cu_pubtype_map_(), stmt_list_offset_(-1),
+      comp_units_(), type_units_(), ranges_(), symbols_list_(), names_(),
+      stats_()
+  { }
+
+  ~Gdb_index_scan();
+
+  // The input object.
+  Relobj*
+  object() const
+  { return this->object_; }
+
+  // Record a section to scan later.  SYMBOLS is copied, since it is
+  // freed once the object has been laid out.
+  void
+  defer_section(bool is_type_unit, const unsigned char* symbols,
+		off_t symbols_size, unsigned int shndx,
+		unsigned int reloc_shndx, unsigned int reloc_type);
+
+  // Scan the sections recorded by defer_section.  The object must be
+  // locked.
+  void
+  scan_deferred_sections();
+
+  // Scan a section now.
+  void
+  scan_section(bool is_type_unit, const unsigned char* symbols,
+	       off_t symbols_size, unsigned int shndx,
+	       unsigned int reloc_shndx, unsigned int reloc_type);
+
+  // The following are called by Gdb_index_info_reader.
+
+  // Add a compilation unit, and return its index within the object.
+  int
+  add_comp_unit(off_t cu_offset, off_t cu_length)
+  {
+    this->comp_units_.push_back(Comp_unit(cu_offset, cu_length));
+    return this->comp_units_.size() - 1;
+  }
+
+  // Add a type unit, and return its index within the object.
+  int
+  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
+  {
+    this->type_units_.push_back(Type_unit(tu_offset, type_offset, signature));
+    return this->type_units_.size() - 1;
+  }
+
+  // Add an address range.
+  void
+  add_address_range_list(int cu_index, Dwarf_range_list* ranges)
+  { this->ranges_.push_back(Cu_ranges(cu_index, ranges)); }
+
+  // Add a symbol.
+  void
+  add_symbol(int cu_index, const char* sym_name);
+
+  // Return the offset into the pubnames table for the cu at the given
+  // offset.
+  off_t
+  find_pubname_offset(off_t cu_offset);
+
+  // Return the offset into the pubtypes table for the cu at the
+  // given offset.
+  off_t
+  find_pubtype_offset(off_t cu_offset);
+
+  // Return TRUE if we have already processed the pubnames and types
+  // set of the CUs and TUS associated with the statement list at
+  // OFFSET.
+  bool
+  pubnames_read(off_t offset)
+  { return this->stmt_list_offset_ == offset; }
+
+  // Record that we have already read the pubnames associated with
+  // OFFSET.
+  void
+  set_pubnames_read(off_t offset)
+  { this->stmt_list_offset_ = offset; }
+
+  // Return a pointer to the given table.
+  Dwarf_pubnames_table*
+  pubnames_table()
+  { return this->pubnames_table_; }
+
+  Dwarf_pubnames_table*
+  pubtypes_table()
+  { return this->pubtypes_table_; }
+
+  // Return the statistics.
+  Stats*
+  stats()
+  { return &this->stats_; }
+
+  // The following are called by Gdb_index::add_scan.
+
+  const std::vector<Comp_unit>&
+  comp_units() const
+  { return this->comp_units_; }
+
+  const std::vector<Type_unit>&
+  type_units() const
+  { return this->type_units_; }
+
+  const std::vector<Cu_ranges>&
+  ranges() const
+  { return this->ranges_; }
+
+  const std::vector<Symbol>&
+  symbols() const
+  { return this->symbols_list_; }
+
+  // Return the name of symbol SYM.
+  const char*
+  symbol_name(const Symbol& sym) const
+  { return this->names_.data() + sym.name_offset; }
+
+  // Clear the results, once they have been added to the index.  The
+  // ownership of the address ranges passes to the index.
+  void
+  clear_results();
+
+ private:
+  Gdb_index_scan(const Gdb_index_scan&);
+  Gdb_index_scan& operator=(const Gdb_index_scan&);
+
+  // A section recorded by defer_section.
+  struct Deferred_section
+  {
+    Deferred_section(bool type_unit, unsigned int sec, unsigned int rsec,
+		     unsigned int rtype)
+      : is_type_unit(type_unit), shndx(sec), reloc_shndx(rsec),
+	reloc_type(rtype)
+    { }
+    bool is_type_unit;
+    unsigned int shndx;
+    unsigned int reloc_shndx;
+    unsigned int reloc_type;
+  };
+
+  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
+
+  // Scan the pubnames or pubtypes section and build a map of the
+  // various cus and tus it refers to, so we can process the entries
+  // when we encounter the die for that cu or tu.  Return the
+  // just-read table so it can be cached.
+  Dwarf_pubnames_table*
+  map_pubtable_to_dies(unsigned int attr, Gdb_index_info_reader* dwinfo,
+		       const unsigned char* symbols, off_t symbols_size);
+
+  // The input object.
+  Relobj* object_;
+  // The copy of the symbols of the object, for the deferred sections.
+  unsigned char* symbols_;
+  off_t symbols_size_;
+  // The sections to scan later.
+  std::vector<Deferred_section> sections_;
+  // Whether the pubnames and pubtypes sections have been read.
+  bool pubtables_mapped_;
+  // Tables to store the pubnames sections of the object, which are
+  // read along with its first section.
+  Dwarf_pubnames_table* pubnames_table_;
+  Dwarf_pubnames_table* pubtypes_table_;
+  Pubname_offset_map cu_pubname_map_;
+  Pubname_offset_map cu_pubtype_map_;
+  // The stmt list offset of the CUs and TUs associated with the last
+  // read pubnames and pubtypes sections.
+  off_t stmt_list_offset_;
+  // The results.
+  std::vector<Comp_unit> comp_units_;
+  std::vector<Type_unit> type_units_;
+  std::vector<Cu_ranges> ranges_;
+  std::vector<Symbol> symbols_list_;
+  // The null-terminated names of the symbols.
+  std::string names_;
+  // The statistics.
+  Stats stats_;
+};
+
 // A specialization of Dwarf_info_reader, for building the .gdb_index.
 
 class Gdb_index_info_reader : public Dwarf_info_reader
@@ -183,15 +442,19 @@ class Gdb_index_info_reader : public Dwarf_info_reader
 			unsigned int shndx,
 			unsigned int reloc_shndx,
 			unsigned int reloc_type,
-			Gdb_index* gdb_index)
+			Gdb_index_scan* scan)
     : Dwarf_info_reader(is_type_unit, object, symbols, symbols_size, shndx,
 			reloc_shndx, reloc_type),
-      gdb_index_(gdb_index), cu_index_(0), cu_language_(0)
+      scan_(scan), cu_index_(0), cu_language_(0)
   { }
 
   ~Gdb_index_info_reader()
   { this->clear_declarations(); }
 
+  // Add the statistics of a scan to the totals.
+  static void
+  add_stats(const Gdb_index_scan::Stats* stats);
+
   // Print usage statistics.
   static void
   print_stats();
@@ -285,9 +548,9 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   clear_declarations();
 
-  // The Gdb_index section.
-  Gdb_index* gdb_index_;
-  // The current CU index (negative for a TU).
+  // The scan of the object.
+  Gdb_index_scan* scan_;
+  // The current CU index within the object (negative for a TU).
   int cu_index_;
   // The language of the current CU or TU.
   unsigned int cu_language_;
@@ -321,8 +584,8 @@ void
 Gdb_index_info_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
 					      Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_cu_count;
-  this->cu_index_ = this->gdb_index_->add_comp_unit(cu_offset, cu_length);
+  ++this->scan_->stats()->cu_count;
+  this->cu_index_ = this->scan_->add_comp_unit(cu_offset, cu_length);
   this->visit_top_die(root_die);
 }
 
@@ -333,10 +596,10 @@ Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t,
 				       off_t type_offset, uint64_t signature,
 				       Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_tu_count;
+  ++this->scan_->stats()->tu_count;
   // Use a negative index to flag this as a TU instead of a CU.
-  this->cu_index_ = -1 - this->gdb_index_->add_type_unit(tu_offset, type_offset,
-							 signature);
+  this->cu_index_ = -1 - this->scan_->add_type_unit(tu_offset, type_offset,
+						     signature);
   this->visit_top_die(root_die);
 }
 
@@ -379,9 +642,9 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 	if (!this->read_pubnames_and_pubtypes(die))
 	  {
 	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
-	      ++Gdb_index_info_reader::dwarf_cu_nopubnames_count;
+	      ++this->scan_->stats()->cu_nopubnames_count;
 	    else
-	      ++Gdb_index_info_reader::dwarf_tu_nopubnames_count;
+	      ++this->scan_->stats()->tu_nopubnames_count;
 	    this->visit_children(die, NULL);
 	  }
 	break;
@@ -436,7 +699,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	    // If the DIE is not a declaration, add it to the index.
 	    std::string full_name = this->get_qualified_name(die, context);
 	    if (!full_name.empty())
-	      this->gdb_index_->add_symbol(this->cu_index_, full_name.c_str());
+	      this->scan_->add_symbol(this->cu_index_, full_name.c_str());
 	  }
 	break;
       case elfcpp::DW_TAG_typedef:
@@ -475,8 +738,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	      if (full_name.empty())
 		full_name = this->get_qualified_name(die, context);
 	      if (!full_name.empty())
-		this->gdb_index_->add_symbol(this->cu_index_,
-					     full_name.c_str());
+		this->scan_->add_symbol(this->cu_index_, full_name.c_str());
 	    }
 
 	  // We're interested in the children only for namespaces and
@@ -823,8 +1085,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
     {
       Dwarf_range_list* ranges = this->read_range_list(shndx, ranges_offset);
       if (ranges != NULL)
-	this->gdb_index_->add_address_range_list(this->object(),
-						 this->cu_index_, ranges);
+	this->scan_->add_address_range_list(this->cu_index_, ranges);
       return;
     }
 
@@ -849,8 +1110,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
         {
 	  Dwarf_range_list* ranges = new Dwarf_range_list();
 	  ranges->add(shndx, low_pc, high_pc);
-	  this->gdb_index_->add_address_range_list(this->object(),
-						   this->cu_index_, ranges);
+	  this->scan_->add_address_range_list(this->cu_index_, ranges);
         }
     }
 }
@@ -874,7 +1134,7 @@ Gdb_index_info_reader::read_pubtable(Dwarf_pubnames_table* table, off_t offset)
       if (name == NULL)
         break;
 
-      this->gdb_index_->add_symbol(this->cu_index_, name);
+      this->scan_->add_symbol(this->cu_index_, name);
     }
   return true;
 }
@@ -905,8 +1165,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
           // have read. If it does, then no need to read the pubnames.
           // If it doesn't, then the caller will have to parse the
           // dies manually to find the names.
-          return this->gdb_index_->pubnames_read(this->object(),
-                                                 stmt_list_off);
+          return this->scan_->pubnames_read(stmt_list_off);
         }
       else
         {
@@ -917,10 +1176,10 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 
   // We found the attribute, so we can check if the corresponding
   // pubnames have been read.
-  if (this->gdb_index_->pubnames_read(this->object(), stmt_list_off))
+  if (this->scan_->pubnames_read(stmt_list_off))
     return true;
 
-  this->gdb_index_->set_pubnames_read(this->object(), stmt_list_off);
+  this->scan_->set_pubnames_read(stmt_list_off);
 
   // We have an attribute, and the pubnames haven't been read, so read
   // them.
@@ -928,12 +1187,12 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
   // In some of the cases, we could rely on the previous value of
   // offset here, but sorting out which cases complicates the logic
   // enough that it isn't worth it. So just look up the offset again.
-  offset = this->gdb_index_->find_pubname_offset(this->cu_offset());
-  names = this->read_pubtable(this->gdb_index_->pubnames_table(), offset);
+  offset = this->scan_->find_pubname_offset(this->cu_offset());
+  names = this->read_pubtable(this->scan_->pubnames_table(), offset);
 
   bool types = false;
-  offset = this->gdb_index_->find_pubtype_offset(this->cu_offset());
-  types = this->read_pubtable(this->gdb_index_->pubtypes_table(), offset);
+  offset = this->scan_->find_pubtype_offset(this->cu_offset());
+  types = this->read_pubtable(this->scan_->pubtypes_table(), offset);
   return names || types;
 }
 
@@ -953,6 +1212,19 @@ Gdb_index_info_reader::clear_declarations()
   this->declarations_.clear();
 }
 
+// Add the statistics of a scan to the totals.
+
+void
+Gdb_index_info_reader::add_stats(const Gdb_index_scan::Stats* stats)
+{
+  Gdb_index_info_reader::dwarf_cu_count += stats->cu_count;
+  Gdb_index_info_reader::dwarf_cu_nopubnames_count
+    += stats->cu_nopubnames_count;
+  Gdb_index_info_reader::dwarf_tu_count += stats->tu_count;
+  Gdb_index_info_reader::dwarf_tu_nopubnames_count
+    += stats->tu_nopubnames_count;
+}
+
 // Print usage statistics.
 void
 Gdb_index_info_reader::print_stats()
@@ -967,41 +1239,85 @@ Gdb_index_info_reader::print_stats()
           program_name, Gdb_index_info_reader::dwarf_tu_nopubnames_count);
 }
 
-// Class Gdb_index.
+// Class Gdb_index_scan.
 
-// Construct the .gdb_index section.
+Gdb_index_scan::~Gdb_index_scan()
+{
+  delete this->pubnames_table_;
+  delete this->pubtypes_table_;
+  delete[] this->symbols_;
+  for (std::vector<Cu_ranges>::const_iterator p = this->ranges_.begin();
+       p != this->ranges_.end();
+       ++p)
+    delete p->ranges;
+}
 
-Gdb_index::Gdb_index(Output_section* gdb_index_section)
-  : Output_section_data(4),
-    pubnames_table_(NULL),
-    pubtypes_table_(NULL),
-    gdb_index_section_(gdb_index_section),
-    comp_units_(),
-    type_units_(),
-    ranges_(),
-    cu_vector_list_(),
-    cu_vector_offsets_(NULL),
-    stringpool_(),
-    tu_offset_(0),
-    addr_offset_(0),
-    symtab_offset_(0),
-    cu_pool_offset_(0),
-    stringpool_offset_(0),
-    pubnames_object_(NULL),
-    stmt_list_offset_(-1)
+// Record a section to scan later.
+
+void
+Gdb_index_scan::defer_section(bool is_type_unit,
+			      const unsigned char* symbols,
+			      off_t symbols_size,
+			      unsigned int shndx,
+			      unsigned int reloc_shndx,
+			      unsigned int reloc_type)
 {
-  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+  // All the sections of an object are passed the same symbols.
+  if (this->sections_.empty() && symbols != NULL)
+    {
+      this->symbols_ = new unsigned char[symbols_size];
+      memcpy(this->symbols_, symbols, symbols_size);
+      this->symbols_size_ = symbols_size;
+    }
+  this->sections_.push_back(Deferred_section(is_type_unit, shndx,
+					     reloc_shndx, reloc_type));
 }
 
-Gdb_index::~Gdb_index()
+// Scan the sections recorded by defer_section, in order.
+
+void
+Gdb_index_scan::scan_deferred_sections()
 {
-  // Free the memory used by the symbol table.
-  delete this->gdb_symtab_;
-  // Free the memory used by the CU vectors.
-  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
-    delete this->cu_vector_list_[i];
+  for (std::vector<Deferred_section>::const_iterator p =
+	 this->sections_.begin();
+       p != this->sections_.end();
+       ++p)
+    this->scan_section(p->is_type_unit, this->symbols_, this->symbols_size_,
+		       p->shndx, p->reloc_shndx, p->reloc_type);
+
+  delete[] this->symbols_;
+  this->symbols_ = NULL;
+  this->symbols_size_ = 0;
+  this->sections_.clear();
 }
 
+// Scan a .debug_info or .debug_types section.  The pubnames and
+// pubtypes sections of the object are read along with the first one.
+
+void
+Gdb_index_scan::scan_section(bool is_type_unit,
+			     const unsigned char* symbols,
+			     off_t symbols_size,
+			     unsigned int shndx,
+			     unsigned int reloc_shndx,
+			     unsigned int reloc_type)
+{
+  Gdb_index_info_reader dwinfo(is_type_unit, this->object_,
+			       symbols, symbols_size,
+			       shndx, reloc_shndx,
+			       reloc_type, this);
+  if (!this->pubtables_mapped_)
+    {
+      this->pubtables_mapped_ = true;
+      this->pubnames_table_
+	= this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, &dwinfo,
+				     symbols, symbols_size);
+      this->pubtypes_table_
+	= this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, &dwinfo,
+				     symbols, symbols_size);
+    }
+  dwinfo.parse();
+}
 
 // Scan the pubnames and pubtypes sections and build a map of the
 // various cus and tus they refer to, so we can process the entries
@@ -1009,11 +1325,10 @@ Gdb_index::~Gdb_index()
 // Return the just-read table so it can be cached.
 
 Dwarf_pubnames_table*
-Gdb_index::map_pubtable_to_dies(unsigned int attr,
-                                Gdb_index_info_reader* dwinfo,
-                                Relobj* object,
-                                const unsigned char* symbols,
-                                off_t symbols_size)
+Gdb_index_scan::map_pubtable_to_dies(unsigned int attr,
+				     Gdb_index_info_reader* dwinfo,
+				     const unsigned char* symbols,
+				     off_t symbols_size)
 {
   uint64_t section_offset = 0;
   Dwarf_pubnames_table* table;
@@ -1031,7 +1346,7 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
     }
 
   map->clear();
-  if (!table->read_section(object, symbols, symbols_size))
+  if (!table->read_section(this->object_, symbols, symbols_size))
     return NULL;
 
   while (table->read_header(section_offset))
@@ -1043,33 +1358,11 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
   return table;
 }
 
-// Wrapper for map_pubtable_to_dies
-
-void
-Gdb_index::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                          Relobj* object,
-                                          const unsigned char* symbols,
-                                          off_t symbols_size)
-{
-  // This is a new object, so reset the relevant variables.
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = -1;
-
-  delete this->pubnames_table_;
-  this->pubnames_table_
-      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo,
-                                   object, symbols, symbols_size);
-  delete this->pubtypes_table_;
-  this->pubtypes_table_
-      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo,
-                                   object, symbols, symbols_size);
-}
-
 // Given a cu_offset, find the associated section of the pubnames
 // table.
 
 off_t
-Gdb_index::find_pubname_offset(off_t cu_offset)
+Gdb_index_scan::find_pubname_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubname_map_.find(cu_offset);
   if (it != this->cu_pubname_map_.end())
@@ -1081,7 +1374,7 @@ Gdb_index::find_pubname_offset(off_t cu_offset)
 // table.
 
 off_t
-Gdb_index::find_pubtype_offset(off_t cu_offset)
+Gdb_index_scan::find_pubtype_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubtype_map_.find(cu_offset);
   if (it != this->cu_pubtype_map_.end())
@@ -1089,7 +1382,122 @@ Gdb_index::find_pubtype_offset(off_t cu_offset)
   return -1;
 }
 
-// Scan a .debug_info or .debug_types input section.
+// Add a symbol, with its hash codes.
+
+void
+Gdb_index_scan::add_symbol(int cu_index, const char* sym_name)
+{
+  size_t len = strlen(sym_name);
+  unsigned int hash = mapped_index_string_hash(
+      reinterpret_cast<const unsigned char*>(sym_name));
+  this->symbols_list_.push_back(Symbol(cu_index, this->names_.size(), len,
+				       hash,
+				       gold::string_hash<char>(sym_name, len)));
+  this->names_.append(sym_name, len + 1);
+}
+
+// Clear the results.
+
+void
+Gdb_index_scan::clear_results()
+{
+  this->comp_units_.clear();
+  this->type_units_.clear();
+  this->ranges_.clear();
+  this->symbols_list_.clear();
+  this->names_.clear();
+  this->stats_ = Stats();
+}
+
+// Scan the deferred .debug_info and .debug_types sections in
+// parallel.  Each job scans the objects in one file.
+
+class Gdb_index_scan_work : public Parallel_work
+{
+ public:
+  typedef std::vector<std::vector<Gdb_index_scan*> > Jobs;
+
+  Gdb_index_scan_work(const Jobs* jobs)
+    : Parallel_work(jobs->size(), "gdb_index_scan"), jobs_(jobs)
+  { }
+
+ protected:
+  void
+  do_run(size_t i, const Task* task)
+  {
+    const std::vector<Gdb_index_scan*>& job((*this->jobs_)[i]);
+    for (std::vector<Gdb_index_scan*>::const_iterator p = job.begin();
+	 p != job.end();
+	 ++p)
+      {
+	Task_lock_obj<Object> tl(task, (*p)->object());
+	(*p)->scan_deferred_sections();
+      }
+  }
+
+ private:
+  const Jobs* jobs_;
+};
+
+// The most helper tasks to use when the --thread-count-middle option
+// does not say how many threads to use.
+
+static const size_t parallel_gdb_index_max_helpers = 8;
+
+// Return the number of helper tasks to scan JOB_COUNT files.
+
+static size_t
+parallel_gdb_index_helpers(size_t job_count)
+{
+  gold_assert(job_count > 0);
+  size_t helpers = job_count - 1;
+  size_t thread_count = parameters->options().thread_count_middle();
+  if (thread_count == 0)
+    return std::min(helpers, parallel_gdb_index_max_helpers);
+  return std::min(helpers, thread_count - 1);
+}
+
+// Class Gdb_index.
+
+// Construct the .gdb_index section.
+
+Gdb_index::Gdb_index(Output_section* gdb_index_section)
+  : Output_section_data(4),
+    gdb_index_section_(gdb_index_section),
+    comp_units_(),
+    type_units_(),
+    ranges_(),
+    cu_vector_list_(),
+    cu_vector_offsets_(NULL),
+    stringpool_(),
+    tu_offset_(0),
+    addr_offset_(0),
+    symtab_offset_(0),
+    cu_pool_offset_(0),
+    stringpool_offset_(0),
+    current_scan_(NULL),
+    deferred_scans_()
+{
+  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+}
+
+Gdb_index::~Gdb_index()
+{
+  // Free the memory used by the symbol table.
+  delete this->gdb_symtab_;
+  // Free the memory used by the CU vectors.
+  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
+    delete this->cu_vector_list_[i];
+  delete this->current_scan_;
+  for (unsigned int i = 0; i < this->deferred_scans_.size(); ++i)
+    delete this->deferred_scans_[i];
+}
+
+// Scan a .debug_info or .debug_types input section.  With threads,
+// record the section, so that the sections of several objects can be
+// scanned at once in scan_deferred_inputs.  The sections of an
+// incremental object are not deferred, since its symbols are not
+// available.
 
 void
 Gdb_index::scan_debug_info(bool is_type_unit,
@@ -1100,25 +1508,122 @@ Gdb_index::scan_debug_info(bool is_type_unit,
 			   unsigned int reloc_shndx,
 			   unsigned int reloc_type)
 {
-  Gdb_index_info_reader dwinfo(is_type_unit, object,
-			       symbols, symbols_size,
-			       shndx, reloc_shndx,
-			       reloc_type, this);
-  if (object != this->pubnames_object_)
-    map_pubnames_and_types_to_dies(&dwinfo, object, symbols, symbols_size);
-  dwinfo.parse();
+  if (parameters->options().threads() && !parameters->incremental())
+    {
+      if (this->deferred_scans_.empty()
+	  || this->deferred_scans_.back()->object() != object)
+	this->deferred_scans_.push_back(new Gdb_index_scan(object));
+      this->deferred_scans_.back()->defer_section(is_type_unit, symbols,
+						  symbols_size, shndx,
+						  reloc_shndx, reloc_type);
+      return;
+    }
+
+  // The pubnames of an object are kept until we see a new object.
+  if (this->current_scan_ == NULL || this->current_scan_->object() != object)
+    {
+      delete this->current_scan_;
+      this->current_scan_ = new Gdb_index_scan(object);
+    }
+  this->current_scan_->scan_section(is_type_unit, symbols, symbols_size,
+				    shndx, reloc_shndx, reloc_type);
+  this->add_scan(this->current_scan_);
+}
+
+// Scan the deferred sections, and add the results in order.
+
+void
+Gdb_index::scan_deferred_inputs(Workqueue* workqueue, const Task* task)
+{
+  if (this->deferred_scans_.empty())
+    return;
+
+  Gdb_index_scan_work::Jobs jobs;
+  Unordered_map<const Task_token*, size_t> file_jobs;
+  for (Scan_list::const_iterator p = this->deferred_scans_.begin();
+       p != this->deferred_scans_.end();
+       ++p)
+    {
+      std::pair<Unordered_map<const Task_token*, size_t>::iterator, bool>
+	ins = file_jobs.insert(std::make_pair((*p)->object()->token(),
+					      jobs.size()));
+      if (ins.second)
+	jobs.push_back(std::vector<Gdb_index_scan*>());
+      jobs[ins.first->second].push_back(*p);
+    }
+
+  size_t helpers = parallel_gdb_index_helpers(jobs.size());
+  Gdb_index_scan_work* work = new Gdb_index_scan_work(&jobs);
+  work->run(workqueue, task, helpers);
+
+  for (Scan_list::iterator p = this->deferred_scans_.begin();
+       p != this->deferred_scans_.end();
+       ++p)
+    {
+      this->add_scan(*p);
+      delete *p;
+    }
+  this->deferred_scans_.clear();
+}
+
+// Add the results of SCAN.  The compilation units and type units of
+// SCAN are numbered from those already added.
+
+void
+Gdb_index::add_scan(Gdb_index_scan* scan)
+{
+  int cu_base = this->comp_units_.size();
+  int tu_base = this->type_units_.size();
+
+  const std::vector<Gdb_index_scan::Comp_unit>& cus(scan->comp_units());
+  for (std::vector<Gdb_index_scan::Comp_unit>::const_iterator p = cus.begin();
+       p != cus.end();
+       ++p)
+    this->comp_units_.push_back(Comp_unit(p->cu_offset, p->cu_length));
+
+  const std::vector<Gdb_index_scan::Type_unit>& tus(scan->type_units());
+  for (std::vector<Gdb_index_scan::Type_unit>::const_iterator p = tus.begin();
+       p != tus.end();
+       ++p)
+    this->type_units_.push_back(Type_unit(p->tu_offset, p->type_offset,
+					  p->type_signature));
+
+  const std::vector<Gdb_index_scan::Cu_ranges>& ranges(scan->ranges());
+  for (std::vector<Gdb_index_scan::Cu_ranges>::const_iterator p =
+	 ranges.begin();
+       p != ranges.end();
+       ++p)
+    this->ranges_.push_back(Per_cu_range_list(scan->object(),
+					      cu_base + p->cu_index,
+					      p->ranges));
+
+  // A negative index is a type unit.
+  const std::vector<Gdb_index_scan::Symbol>& syms(scan->symbols());
+  for (std::vector<Gdb_index_scan::Symbol>::const_iterator p = syms.begin();
+       p != syms.end();
+       ++p)
+    {
+      int cu_index = (p->cu_index >= 0
+		      ? cu_base + p->cu_index
+		      : p->cu_index - tu_base);
+      this->add_symbol(cu_index, scan->symbol_name(*p), p->name_length,
+		       p->hashval, p->pool_hash);
+    }
+
+  Gdb_index_info_reader::add_stats(scan->stats());
+  scan->clear_results();
 }
 
 // Add a symbol.
 
 void
-Gdb_index::add_symbol(int cu_index, const char* sym_name)
+Gdb_index::add_symbol(int cu_index, const char* sym_name, size_t len,
+		      unsigned int hashval, size_t pool_hash)
 {
-  unsigned int hash = mapped_index_string_hash(
-      reinterpret_cast<const unsigned char*>(sym_name));
   Gdb_symbol* sym = new Gdb_symbol();
-  this->stringpool_.add(sym_name, true, &sym->name_key);
-  sym->hashval = hash;
+  this->stringpool_.add_prehashed(sym_name, len, pool_hash, true,
+				  &sym->name_key);
+  sym->hashval = hashval;
   sym->cu_vector_index = 0;
 
   Gdb_symbol* found = this->gdb_symtab_->add(sym);
@@ -1143,27 +1648,6 @@ Gdb_index::add_symbol(int cu_index, const char* sym_name)
     cu_vec->push_back(cu_index);
 }
 
-// Return TRUE if we have already processed the pubnames associated
-// with the statement list at the given OFFSET.
-
-bool
-Gdb_index::pubnames_read(const Relobj* object, off_t offset)
-{
-  bool ret = (this->pubnames_object_ == object
-	      && this->stmt_list_offset_ == offset);
-  return ret;
-}
-
-// Record that we have processed the pubnames associated with the
-// statement list for OBJECT at the given OFFSET.
-
-void
-Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
-{
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = offset;
-}
-
 // Set the size of the .gdb_index section.
 
 void
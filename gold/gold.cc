@@ -515,7 +515,7 @@ queue_middle_tasks(const General_options& options,
       symtab->gc_mark_undef_symbols(layout);
       gold_assert(symtab->gc() != NULL);
       // Do a transitive closure on all references to determine the worklist.
-      symtab->gc()->do_transitive_closure();
+      symtab->gc()->do_transitive_closure(workqueue, task);
     }
 
   // If identical code folding (--icf) is chosen it makes sense to do it
@@ -523,7 +523,8 @@ queue_middle_tasks(const General_options& options,
   // be folding sections that will be garbage.
   if (parameters->options().icf_enabled())
     {
-      symtab->icf()->find_identical_sections(input_objects, symtab);
+      symtab->icf()->find_identical_sections(input_objects, symtab,
+                                             workqueue, task);
     }
 
   // Call Object::layout for the second time to determine the
@@ -139,6 +139,9 @@
 // applications.  Up to 6 %  text size reductions.
 
 #include "gold.h"
+
+#include <algorithm>
+
 #include "object.h"
 #include "gc.h"
 #include "icf.h"
@@ -147,59 +150,116 @@
 #include "demangle.h"
 #include "elfcpp.h"
 #include "int_encoding.h"
+#include "workqueue.h"
 
 namespace gold
 {
 
+// The relocations of a candidate section to sections which might be
+// folded.  Their part of the section's contents names the kept
+// sections of their targets, so it changes as sections are folded.
+
+struct Icf_tracked_relocs
+{
+  // The unique numbers of the sections the relocations point to.
+  std::vector<unsigned int> targets;
+  // The addend string of each relocation, followed by '@'.
+  std::string addends;
+};
+
+// What is known about the contents of a candidate section.  The
+// contents are the section's text and relocs to sections that cannot
+// be folded, which are computed once, followed by the tracked relocs,
+// which are formatted again only when the kept section of one of
+// their targets changes.
+
+struct Icf_section_contents
+{
+  Icf_section_contents()
+    : text(), input_cksum(0), text_cksum(0), first_relocs(),
+      later_relocs(), relocs(), cksum(0), relocs_stamp(0),
+      deferred(false)
+  { }
+
+  // The section's text and relocs to sections that cannot be folded.
+  std::string text;
+  // The checksum of the section's contents in the input file.
+  uint32_t input_cksum;
+  // The checksum of TEXT.
+  uint32_t text_cksum;
+  // The tracked relocs as seen by the first iteration, which looks
+  // through function descriptors.
+  Icf_tracked_relocs first_relocs;
+  // The tracked relocs as seen by later iterations.
+  Icf_tracked_relocs later_relocs;
+  // The tracked relocs, formatted with the kept sections of their
+  // targets.
+  std::string relocs;
+  // The checksum of TEXT followed by RELOCS.
+  uint32_t cksum;
+  // When RELOCS was last formatted for a later iteration, or 0.
+  unsigned int relocs_stamp;
+  // True if the text must be computed again without threads.
+  bool deferred;
+};
+
+// Records when the kept section of each candidate section last
+// changed, so that the tracked relocs of a section are only
+// formatted again if that of one of their targets did.
+
+struct Icf_kept_changes
+{
+  Icf_kept_changes(unsigned int section_count)
+    : stamps(section_count, 0), stamp(1)
+  { }
+
+  // The value of STAMP when the kept section of each section last
+  // changed.
+  std::vector<unsigned int> stamps;
+  // Incremented for each change.
+  unsigned int stamp;
+};
+
+// The flags and entry size of each section of an input object, for
+// when the contents of candidate sections are computed with threads.
+// The relocs of a section may point to the sections of any object,
+// so these are read ahead of time while each object is locked.
+
+typedef std::vector<std::pair<uint64_t, uint64_t> > Icf_section_flags;
+
+typedef Unordered_map<const Object*, Icf_section_flags> Icf_section_flags_map;
+
 // This function determines if a section or a group of identical
 // sections has unique contents.  Such unique sections or groups can be
 // declared final and need not be processed any further.
 // Parameters :
-// ID_SECTION : Vector mapping a section index to a Section_id pair.
 // IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
 //                            sections is already known to be unique.
-// SECTION_CONTENTS : Contains the section's text and relocs to sections
-//                    that cannot be folded.   SECTION_CONTENTS are NULL
-//                    implies that this function is being called for the
-//                    first time before the first iteration of icf.
+// FIRST_ITERATION : True if this is called before the first iteration
+//                   of icf, in which case the checksums of the sections'
+//                   contents in the input files are used.  Otherwise the
+//                   checksums of the sections' text and relocs to sections
+//                   that cannot be folded are used.
+// CONTENTS : The contents of each section.
 
 static void
-preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
-                               std::vector<bool>* is_secn_or_group_unique,
-                               std::vector<std::string>* section_contents)
+preprocess_for_unique_sections(
+    std::vector<bool>* is_secn_or_group_unique,
+    bool first_iteration,
+    const std::vector<Icf_section_contents>& contents)
 {
   Unordered_map<uint32_t, unsigned int> uniq_map;
   std::pair<Unordered_map<uint32_t, unsigned int>::iterator, bool>
     uniq_map_insert;
 
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < contents.size(); i++)
     {
       if ((*is_secn_or_group_unique)[i])
         continue;
 
-      uint32_t cksum;
-      Section_id secn = id_section[i];
-      section_size_type plen;
-      if (section_contents == NULL)
-        {
-          // Lock the object so we can read from it.  This is only called
-          // single-threaded from queue_middle_tasks, so it is OK to lock.
-          // Unfortunately we have no way to pass in a Task token.
-          const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-          Task_lock_obj<Object> tl(dummy_task, secn.first);
-          const unsigned char* contents;
-          contents = secn.first->section_contents(secn.second,
-                                                  &plen,
-                                                  false);
-          cksum = xcrc32(contents, plen, 0xffffffff);
-        }
-      else
-        {
-          const unsigned char* contents_array = reinterpret_cast
-            <const unsigned char*>((*section_contents)[i].c_str());
-          cksum = xcrc32(contents_array, (*section_contents)[i].length(),
-                         0xffffffff);
-        }
+      uint32_t cksum = (first_iteration
+                        ? contents[i].input_cksum
+                        : contents[i].text_cksum);
       uniq_map_insert = uniq_map.insert(std::make_pair(cksum, i));
       if (uniq_map_insert.second)
         {
@@ -213,202 +273,233 @@ preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
     }
 }
 
-// This returns the buffer containing the section's contents, both
-// text and relocs.  Relocs are differentiated as those pointing to
-// sections that could be folded and those that cannot.  Only relocs
-// pointing to sections that could be folded are recomputed on
-// subsequent invocations of this function.
+// Format the addend string of a reloc.  ADDEND points to a pair where
+// first is the symbol value and second is the addend, and OFFSET is
+// the offset of the reloc.
+
+static void
+format_reloc_addend(const std::pair<long long, long long>& addend,
+                    uint64_t offset, char* addend_str, size_t len)
+{
+  // It would be nice if we could use format macros in inttypes.h
+  // here but there are not in ISO/IEC C++ 1998.
+  snprintf(addend_str, len, "%llx %llx %llux",
+           static_cast<long long>(addend.first),
+           static_cast<long long>(addend.second),
+           static_cast<unsigned long long>(offset));
+}
+
+// If a reloc to RELOC_SECN through symbol SYM points to a section that
+// might be folded, return true and set *SECN_ID to its unique number.
+
+static bool
+is_tracked_reloc(const Section_id& reloc_secn, const Symbol* sym,
+                 const Icf::Uniq_secn_id_map& section_id_map,
+                 unsigned int* secn_id)
+{
+  bool is_sym_preemptible = (sym != NULL
+                             && !sym->is_from_dynobj()
+                             && !sym->is_undefined()
+                             && sym->is_preemptible());
+  if (is_sym_preemptible)
+    return false;
+  Icf::Uniq_secn_id_map::const_iterator section_id_map_it =
+    section_id_map.find(reloc_secn);
+  if (section_id_map_it == section_id_map.end())
+    return false;
+  *secn_id = section_id_map_it->second;
+  return true;
+}
+
+// Add a tracked reloc to section SECN_ID with ADDEND_STR to RELOCS.
+
+static void
+add_tracked_reloc(unsigned int secn_id, const char* addend_str,
+                  Icf_tracked_relocs* relocs)
+{
+  relocs->targets.push_back(secn_id);
+  relocs->addends.append(addend_str);
+  relocs->addends.append("@");
+}
+
+// This computes the contents of a section which do not change between
+// iterations, and records its relocs to sections that could be folded.
+// The caller must have locked the section's object.  Relocs are
+// differentiated as those pointing to sections that could be folded
+// and those that cannot.  Only relocs pointing to sections that could
+// be folded are recomputed on subsequent iterations.
 // Parameters  :
-// FIRST_ITERATION    : true if it is the first invocation.
 // SECN               : Section for which contents are desired.
-// SECTION_NUM        : Unique section number of this section.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
-// KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
-//                      sections.
-
-static std::string
-get_section_contents(bool first_iteration,
-                     const Section_id& secn,
-                     unsigned int section_num,
-                     unsigned int* num_tracked_relocs,
+// SECTION_FLAGS      : If not NULL, the flags and entry sizes of the
+//                      sections of the input objects.  This is used
+//                      when other threads may be reading the objects,
+//                      in which case no object is read but SECN's.
+// CONTENTS           : Store the section's text and relocs to non-ICF
+//                      sections, and the relocs to ICF sections.
+// This returns false if SECTION_FLAGS is not NULL and the
+// contents could not be computed without reading another object.
+
+static bool
+get_section_contents(const Section_id& secn,
                      Symbol_table* symtab,
-                     const std::vector<unsigned int>& kept_section_id,
-                     std::vector<std::string>* section_contents)
+                     const Icf_section_flags_map* section_flags,
+                     Icf_section_contents* contents)
 {
-  // Lock the object so we can read from it.  This is only called
-  // single-threaded from queue_middle_tasks, so it is OK to lock.
-  // Unfortunately we have no way to pass in a Task token.
-  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-  Task_lock_obj<Object> tl(dummy_task, secn.first);
-
   section_size_type plen;
-  const unsigned char* contents = NULL;
-  if (first_iteration)
-    contents = secn.first->section_contents(secn.second, &plen, false);
+  const unsigned char* section_text =
+    secn.first->section_contents(secn.second, &plen, false);
 
-  // The buffer to hold all the contents including relocs.  A checksum
-  // is then computed on this buffer.
-  std::string buffer;
-  std::string icf_reloc_buffer;
+  // The buffer to hold the contents that don't change.  A checksum is
+  // then computed on this buffer followed by the tracked relocs.
+  std::string& buffer(contents->text);
 
-  if (num_tracked_relocs)
-    *num_tracked_relocs = 0;
+  buffer.clear();
+  contents->first_relocs.targets.clear();
+  contents->first_relocs.addends.clear();
+  contents->later_relocs.targets.clear();
+  contents->later_relocs.addends.clear();
 
   Icf::Reloc_info_list& reloc_info_list = 
     symtab->icf()->reloc_info_list();
 
-  Icf::Reloc_info_list::iterator it_reloc_info_list =
+  Icf::Reloc_info_list::const_iterator it_reloc_info_list =
     reloc_info_list.find(secn);
 
-  buffer.clear();
-  icf_reloc_buffer.clear();
+  const Icf::Uniq_secn_id_map& section_id_map =
+    symtab->icf()->section_to_int_map();
 
   // Process relocs and put them into the buffer.
 
   if (it_reloc_info_list != reloc_info_list.end())
     {
-      Icf::Sections_reachable_info v =
-        (it_reloc_info_list->second).section_info;
+      const Icf::Reloc_info& reloc_info(it_reloc_info_list->second);
+      Icf::Sections_reachable_info::const_iterator it_v =
+        reloc_info.section_info.begin();
       // Stores the information of the symbol pointed to by the reloc.
-      Icf::Symbol_info s = (it_reloc_info_list->second).symbol_info;
+      Icf::Symbol_info::const_iterator it_s = reloc_info.symbol_info.begin();
       // Stores the addend and the symbol value.
-      Icf::Addend_info a = (it_reloc_info_list->second).addend_info;
+      Icf::Addend_info::const_iterator it_a = reloc_info.addend_info.begin();
       // Stores the offset of the reloc.
-      Icf::Offset_info o = (it_reloc_info_list->second).offset_info;
-      Icf::Reloc_addend_size_info reloc_addend_size_info =
-        (it_reloc_info_list->second).reloc_addend_size_info;
-      Icf::Sections_reachable_info::iterator it_v = v.begin();
-      Icf::Symbol_info::iterator it_s = s.begin();
-      Icf::Addend_info::iterator it_a = a.begin();
-      Icf::Offset_info::iterator it_o = o.begin();
-      Icf::Reloc_addend_size_info::iterator it_addend_size =
-        reloc_addend_size_info.begin();
-
-      for (; it_v != v.end(); ++it_v, ++it_s, ++it_a, ++it_o, ++it_addend_size)
+      Icf::Offset_info::const_iterator it_o = reloc_info.offset_info.begin();
+      Icf::Reloc_addend_size_info::const_iterator it_addend_size =
+        reloc_info.reloc_addend_size_info.begin();
+
+      for (;
+           it_v != reloc_info.section_info.end();
+           ++it_v, ++it_s, ++it_a, ++it_o, ++it_addend_size)
         {
-	  if (first_iteration
-	      && it_v->first != NULL)
+          // ADDEND_STR stores the symbol value and addend and offset,
+          // each at most 16 hex digits long.
+          char addend_str[50];
+
+          // Later iterations see the reloc as it was recorded.
+          Section_id reloc_secn(*it_v);
+          unsigned int secn_id;
+          if (reloc_secn.first != NULL
+              && reloc_secn != secn
+              && is_tracked_reloc(reloc_secn, *it_s, section_id_map, &secn_id))
+            {
+              format_reloc_addend(*it_a, *it_o, addend_str,
+                                  sizeof(addend_str));
+              add_tracked_reloc(secn_id, addend_str, &contents->later_relocs);
+            }
+
+          std::pair<long long, long long> addend(*it_a);
+	  if (reloc_secn.first != NULL)
 	    {
 	      Symbol_location loc;
-	      loc.object = it_v->first;
-	      loc.shndx = it_v->second;
-	      loc.offset = convert_types<off_t, long long>(it_a->first
-							   + it_a->second);
+	      loc.object = reloc_secn.first;
+	      loc.shndx = reloc_secn.second;
+	      loc.offset = convert_types<off_t, long long>(addend.first
+							   + addend.second);
 	      // Look through function descriptors
 	      parameters->target().function_location(&loc);
-	      if (loc.shndx != it_v->second)
+	      if (loc.shndx != reloc_secn.second)
 		{
-		  it_v->second = loc.shndx;
+		  reloc_secn.second = loc.shndx;
 		  // Modify symvalue/addend to the code entry.
-		  it_a->first = loc.offset;
-		  it_a->second = 0;
+		  addend.first = loc.offset;
+		  addend.second = 0;
 		}
 	    }
 
-          // ADDEND_STR stores the symbol value and addend and offset,
-          // each at most 16 hex digits long.  it_a points to a pair
-          // where first is the symbol value and second is the
-          // addend.
-          char addend_str[50];
-
-	  // It would be nice if we could use format macros in inttypes.h
-	  // here but there are not in ISO/IEC C++ 1998.
-          snprintf(addend_str, sizeof(addend_str), "%llx %llx %llux",
-                   static_cast<long long>((*it_a).first),
-		   static_cast<long long>((*it_a).second),
-		   static_cast<unsigned long long>(*it_o));
+          format_reloc_addend(addend, *it_o, addend_str, sizeof(addend_str));
 
 	  // If the symbol pointed to by the reloc is not in an ordinary
 	  // section or if the symbol type is not FROM_OBJECT, then the
 	  // object is NULL.
-	  if (it_v->first == NULL)
+	  if (reloc_secn.first == NULL)
             {
-	      if (first_iteration)
-                {
-		  // If the symbol name is available, use it.
-                  if ((*it_s) != NULL)
-                      buffer.append((*it_s)->name());
-                  // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
-		}
+              // If the symbol name is available, use it.
+              if ((*it_s) != NULL)
+                  buffer.append((*it_s)->name());
+              // Append the addend.
+              buffer.append(addend_str);
+              buffer.append("@");
 	      continue;
 	    }
 
-          Section_id reloc_secn(it_v->first, it_v->second);
-
           // If this reloc turns back and points to the same section,
           // like a recursive call, use a special symbol to mark this.
-          if (reloc_secn.first == secn.first
-              && reloc_secn.second == secn.second)
+          if (reloc_secn == secn)
             {
-              if (first_iteration)
-                {
-                  buffer.append("R");
-                  buffer.append(addend_str);
-                  buffer.append("@");
-                }
+              buffer.append("R");
+              buffer.append(addend_str);
+              buffer.append("@");
               continue;
             }
-          Icf::Uniq_secn_id_map& section_id_map =
-            symtab->icf()->section_to_int_map();
-          Icf::Uniq_secn_id_map::iterator section_id_map_it =
-            section_id_map.find(reloc_secn);
-          bool is_sym_preemptible = (*it_s != NULL
-				     && !(*it_s)->is_from_dynobj()
-				     && !(*it_s)->is_undefined()
-				     && (*it_s)->is_preemptible());
-          if (!is_sym_preemptible
-              && section_id_map_it != section_id_map.end())
+          if (is_tracked_reloc(reloc_secn, *it_s, section_id_map, &secn_id))
             {
               // This is a reloc to a section that might be folded.
-              if (num_tracked_relocs)
-                (*num_tracked_relocs)++;
-
-              char kept_section_str[10];
-              unsigned int secn_id = section_id_map_it->second;
-              snprintf(kept_section_str, sizeof(kept_section_str), "%u",
-                       kept_section_id[secn_id]);
-              if (first_iteration)
-                {
-                  buffer.append("ICF_R");
-                  buffer.append(addend_str);
-                }
-              icf_reloc_buffer.append(kept_section_str);
-              // Append the addend.
-              icf_reloc_buffer.append(addend_str);
-              icf_reloc_buffer.append("@");
+              buffer.append("ICF_R");
+              buffer.append(addend_str);
+              add_tracked_reloc(secn_id, addend_str, &contents->first_relocs);
             }
           else
             {
               // This is a reloc to a section that cannot be folded.
               // Process it only in the first iteration.
-              if (!first_iteration)
-                continue;
-
-              uint64_t secn_flags = (it_v->first)->section_flags(it_v->second);
+              uint64_t secn_flags;
+              uint64_t entsize;
+              if (section_flags == NULL)
+                {
+                  Object* object = reloc_secn.first;
+                  secn_flags = object->section_flags(reloc_secn.second);
+                  entsize = object->section_entsize(reloc_secn.second);
+                }
+              else
+                {
+                  Icf_section_flags_map::const_iterator p =
+                    section_flags->find(reloc_secn.first);
+                  if (p == section_flags->end())
+                    return false;
+                  gold_assert(reloc_secn.second < p->second.size());
+                  secn_flags = p->second[reloc_secn.second].first;
+                  entsize = p->second[reloc_secn.second].second;
+                }
               // This reloc points to a merge section.  Hash the
               // contents of this section.
               if ((secn_flags & elfcpp::SHF_MERGE) != 0
 		  && parameters->target().can_icf_inline_merge_sections())
                 {
-                  uint64_t entsize =
-                    (it_v->first)->section_entsize(it_v->second);
-		  long long offset = it_a->first;
+                  // Other threads may be reading other input files.
+                  if (section_flags != NULL
+                      && reloc_secn.first->token() != secn.first->token())
+                    return false;
 
-                  unsigned long long addend = it_a->second;
+		  long long offset = addend.first;
+
+                  unsigned long long reloc_addend = addend.second;
                   // Ignoring the addend when it is a negative value.  See the 
                   // comments in Merged_symbol_value::Value in object.h.
-                  if (addend < 0xffffff00)
-                    offset = offset + addend;
+                  if (reloc_addend < 0xffffff00)
+                    offset = offset + reloc_addend;
 
 		  // For SHT_REL relocation sections, the addend is stored in the
 		  // text section at the relocation offset.
 		  uint64_t reloc_addend_value = 0;
                   const unsigned char* reloc_addend_ptr =
-		    contents + static_cast<unsigned long long>(*it_o);
+		    section_text + static_cast<unsigned long long>(*it_o);
 		  switch(*it_addend_size)
 		    {
 		      case 0:
@@ -446,9 +537,9 @@ get_section_contents(bool first_iteration,
 
                   section_size_type secn_len;
                   const unsigned char* str_contents =
-                  (it_v->first)->section_contents(it_v->second,
-                                                  &secn_len,
-                                                  false) + offset;
+                  (reloc_secn.first)->section_contents(reloc_secn.second,
+                                                       &secn_len,
+                                                       false) + offset;
                   if ((secn_flags & elfcpp::SHF_STRINGS) != 0)
                     {
                       // String merge section.
@@ -508,10 +599,11 @@ get_section_contents(bool first_iteration,
                 {
                   // Symbol name is not available, like for a local symbol,
                   // use object and section id.
-                  buffer.append(it_v->first->name());
-                  char secn_id[10];
-                  snprintf(secn_id, sizeof(secn_id), "%u",it_v->second);
-                  buffer.append(secn_id);
+                  buffer.append(reloc_secn.first->name());
+                  char secn_id_str[10];
+                  snprintf(secn_id_str, sizeof(secn_id_str), "%u",
+                           reloc_secn.second);
+                  buffer.append(secn_id_str);
                   // Append the addend.
                   buffer.append(addend_str);
                   buffer.append("@");
@@ -520,23 +612,86 @@ get_section_contents(bool first_iteration,
         }
     }
 
-  if (first_iteration)
-    {
-      buffer.append("Contents = ");
-      buffer.append(reinterpret_cast<const char*>(contents), plen);
-      // Store the section contents that dont change to avoid recomputing
-      // during the next call to this function.
-      (*section_contents)[section_num] = buffer;
-    }
-  else
+  buffer.append("Contents = ");
+  buffer.append(reinterpret_cast<const char*>(section_text), plen);
+  contents->text_cksum =
+    xcrc32(reinterpret_cast<const unsigned char*>(buffer.data()),
+           buffer.length(), 0xffffffff);
+  return true;
+}
+
+// Format RELOCS into BUFFER, naming the kept section of each target.
+
+static void
+format_tracked_relocs(const Icf_tracked_relocs& relocs,
+                      const std::vector<unsigned int>& kept_section_id,
+                      std::string* buffer)
+{
+  buffer->clear();
+  std::string::size_type pos = 0;
+  for (std::vector<unsigned int>::const_iterator p = relocs.targets.begin();
+       p != relocs.targets.end();
+       ++p)
     {
-      gold_assert(buffer.empty());
-      // Reuse the contents computed in the previous iteration.
-      buffer.append((*section_contents)[section_num]);
+      char kept_section_str[10];
+      snprintf(kept_section_str, sizeof(kept_section_str), "%u",
+               kept_section_id[*p]);
+      buffer->append(kept_section_str);
+      // Append the addend.
+      std::string::size_type end = relocs.addends.find('@', pos);
+      gold_assert(end != std::string::npos);
+      buffer->append(relocs.addends, pos, end + 1 - pos);
+      pos = end + 1;
     }
+}
+
+// Return true if the kept section of any target of RELOCS has changed
+// since STAMP.
+
+static bool
+tracked_relocs_changed(const Icf_tracked_relocs& relocs,
+                       const Icf_kept_changes& kept_changes,
+                       unsigned int stamp)
+{
+  for (std::vector<unsigned int>::const_iterator p = relocs.targets.begin();
+       p != relocs.targets.end();
+       ++p)
+    if (kept_changes.stamps[*p] > stamp)
+      return true;
+  return false;
+}
+
+// Make KEPT_SECTION the kept section of section I.
+
+static void
+set_kept_section(unsigned int i, unsigned int kept_section,
+                 std::vector<unsigned int>* kept_section_id,
+                 Icf_kept_changes* kept_changes)
+{
+  (*kept_section_id)[i] = kept_section;
+  ++kept_changes->stamp;
+  kept_changes->stamps[i] = kept_changes->stamp;
+}
 
-  buffer.append(icf_reloc_buffer);
-  return buffer;
+// Return true if the contents of two sections, each the text followed
+// by the tracked relocs, are the same.
+
+static bool
+section_contents_equal(const Icf_section_contents& c1,
+                       const Icf_section_contents& c2)
+{
+  if (c1.text.length() < c2.text.length())
+    return section_contents_equal(c2, c1);
+  if (c1.text.length() + c1.relocs.length()
+      != c2.text.length() + c2.relocs.length())
+    return false;
+  // The text of C1 is at least as long as that of C2, so it overlaps
+  // the start of C2's relocs.
+  std::string::size_type overlap = c1.text.length() - c2.text.length();
+  return (c1.text.compare(0, c2.text.length(), c2.text) == 0
+          && c1.text.compare(c2.text.length(), overlap,
+                             c2.relocs, 0, overlap) == 0
+          && c2.relocs.compare(overlap, std::string::npos, c1.relocs) == 0);
 }
 
 // This function computes a checksum on each section to detect and form
@@ -544,7 +699,9 @@ get_section_contents(bool first_iteration,
 // sections.
 // Further iterations do this only for the kept sections from each group to
 // determine if larger groups of identical sections could be formed.  The
-// first section in each group is the kept section for that group.
+// first section in each group is the kept section for that group.  The
+// checksum of a kept section whose tracked relocs point to the same kept
+// sections as when it was last computed is reused.
 //
 // CRC32 is the checksumming algorithm and can have collisions.  That is,
 // two sections with different contents can have the same checksum. Hence,
@@ -554,56 +711,36 @@ get_section_contents(bool first_iteration,
 //
 // Parameters  :
 // ITERATION_NUM           : Invocation instance of this function.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
 // KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// ID_SECTION         : Vector mapping a section to an unique integer.
+// KEPT_CHANGES       : Records changes to KEPT_SECTION_ID.
 // IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
 //                            sections is already known to be unique.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
-//                      sections.
+// CONTENTS           : The contents of each section.
 
 static bool
 match_sections(unsigned int iteration_num,
-               Symbol_table* symtab,
-               std::vector<unsigned int>* num_tracked_relocs,
                std::vector<unsigned int>* kept_section_id,
-               const std::vector<Section_id>& id_section,
+               Icf_kept_changes* kept_changes,
                std::vector<bool>* is_secn_or_group_unique,
-               std::vector<std::string>* section_contents)
+               std::vector<Icf_section_contents>* contents)
 {
   Unordered_multimap<uint32_t, unsigned int> section_cksum;
   std::pair<Unordered_multimap<uint32_t, unsigned int>::iterator,
             Unordered_multimap<uint32_t, unsigned int>::iterator> key_range;
   bool converged = true;
 
-  if (iteration_num == 1)
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   NULL);
-  else
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   section_contents);
-
-  std::vector<std::string> full_section_contents;
-
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < contents->size(); i++)
     {
-      full_section_contents.push_back("");
       if ((*is_secn_or_group_unique)[i])
         continue;
 
-      Section_id secn = id_section[i];
-      std::string this_secn_contents;
-      uint32_t cksum;
+      Icf_section_contents& this_secn_contents((*contents)[i]);
+      bool recompute = true;
       if (iteration_num == 1)
         {
-          unsigned int num_relocs = 0;
-          this_secn_contents = get_section_contents(true, secn, i, &num_relocs,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
-          (*num_tracked_relocs)[i] = num_relocs;
+          format_tracked_relocs(this_secn_contents.first_relocs,
+                                *kept_section_id, &this_secn_contents.relocs);
+          this_secn_contents.relocs_stamp = 0;
         }
       else
         {
@@ -614,26 +751,43 @@ match_sections(unsigned int iteration_num,
               unsigned int kept_section = (*kept_section_id)[i];
               if (kept_section != (*kept_section_id)[kept_section])
                 {
-                  (*kept_section_id)[i] = (*kept_section_id)[kept_section];
+                  set_kept_section(i, (*kept_section_id)[kept_section],
+                                   kept_section_id, kept_changes);
                 }
               continue;
             }
-          this_secn_contents = get_section_contents(false, secn, i, NULL,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
+          if (this_secn_contents.relocs_stamp != 0
+              && !tracked_relocs_changed(this_secn_contents.later_relocs,
+                                         *kept_changes,
+                                         this_secn_contents.relocs_stamp))
+            {
+              // The contents are the same as when the checksum was
+              // last computed.
+              recompute = false;
+            }
+          else
+            {
+              format_tracked_relocs(this_secn_contents.later_relocs,
+                                    *kept_section_id,
+                                    &this_secn_contents.relocs);
+              this_secn_contents.relocs_stamp = kept_changes->stamp;
+            }
         }
 
-      const unsigned char* this_secn_contents_array =
-            reinterpret_cast<const unsigned char*>(this_secn_contents.c_str());
-      cksum = xcrc32(this_secn_contents_array, this_secn_contents.length(),
-                     0xffffffff);
+      if (recompute)
+        this_secn_contents.cksum =
+          xcrc32(reinterpret_cast<const unsigned char*>
+                   (this_secn_contents.relocs.data()),
+                 this_secn_contents.relocs.length(),
+                 this_secn_contents.text_cksum);
+
+      uint32_t cksum = this_secn_contents.cksum;
       size_t count = section_cksum.count(cksum);
 
       if (count == 0)
         {
           // Start a group with this cksum.
           section_cksum.insert(std::make_pair(cksum, i));
-          full_section_contents[i] = this_secn_contents;
         }
       else
         {
@@ -643,14 +797,11 @@ match_sections(unsigned int iteration_num,
           for (it = key_range.first; it != key_range.second; ++it)
             {
               unsigned int kept_section = it->second;
-              if (full_section_contents[kept_section].length()
-                  != this_secn_contents.length())
-                  continue;
-              if (memcmp(full_section_contents[kept_section].c_str(),
-                         this_secn_contents.c_str(),
-                         this_secn_contents.length()) != 0)
+              if (!section_contents_equal((*contents)[kept_section],
+                                          this_secn_contents))
                   continue;
-              (*kept_section_id)[i] = kept_section;
+              set_kept_section(i, kept_section, kept_section_id,
+                               kept_changes);
               converged = false;
               break;
             }
@@ -658,12 +809,12 @@ match_sections(unsigned int iteration_num,
             {
               // Create a new group for this cksum.
               section_cksum.insert(std::make_pair(cksum, i));
-              full_section_contents[i] = this_secn_contents;
             }
         }
       // If there are no relocs to foldable sections do not process
       // this section any further.
-      if (iteration_num == 1 && (*num_tracked_relocs)[i] == 0)
+      if (iteration_num == 1
+          && this_secn_contents.first_relocs.targets.empty())
         (*is_secn_or_group_unique)[i] = true;
     }
 
@@ -688,31 +839,142 @@ is_function_ctor_or_dtor(const std::string& section_name)
   return false;
 }
 
+// The contents of the candidate sections are computed in parallel
+// when there are at least this many of them.
+
+static const unsigned int parallel_icf_min_sections = 256;
+
+// The most helper tasks to use when the --thread-count-middle option
+// does not say how many threads to use.
+
+static const size_t parallel_icf_max_helpers = 8;
+
+// This class computes the contents of the candidate sections, or the
+// checksums of their contents in the input files, a job for each input
+// file.  The jobs are the unique numbers of the sections of each file,
+// in order.
+
+class Icf_contents_work : public Parallel_work
+{
+ public:
+  typedef std::vector<std::vector<unsigned int> > Jobs;
+
+  // If INPUT_CKSUMS is true, compute the checksums of the sections'
+  // contents in the input files, otherwise compute the contents of
+  // those sections which are not unique.
+  Icf_contents_work(const Jobs* jobs, bool input_cksums,
+                    const std::vector<Section_id>& id_section,
+                    const std::vector<bool>& is_secn_or_group_unique,
+                    Symbol_table* symtab,
+                    const Icf_section_flags_map* section_flags,
+                    std::vector<Icf_section_contents>* contents)
+    : Parallel_work(jobs->size(),
+                    input_cksums ? "icf_cksums" : "icf_contents"),
+      jobs_(jobs), input_cksums_(input_cksums), id_section_(id_section),
+      is_secn_or_group_unique_(is_secn_or_group_unique), symtab_(symtab),
+      section_flags_(section_flags), contents_(contents)
+  { }
+
+ protected:
+  void
+  do_run(size_t i, const Task* task);
+
+ private:
+  const Jobs* jobs_;
+  bool input_cksums_;
+  const std::vector<Section_id>& id_section_;
+  const std::vector<bool>& is_secn_or_group_unique_;
+  Symbol_table* symtab_;
+  const Icf_section_flags_map* section_flags_;
+  std::vector<Icf_section_contents>* contents_;
+};
+
+void
+Icf_contents_work::do_run(size_t i, const Task* task)
+{
+  const std::vector<unsigned int>& job((*this->jobs_)[i]);
+  std::vector<unsigned int>::const_iterator p = job.begin();
+  while (p != job.end())
+    {
+      // Lock each object once for all its sections.
+      Object* object = this->id_section_[*p].first;
+      Task_lock_obj<Object> tl(task, object);
+      for (; p != job.end() && this->id_section_[*p].first == object; ++p)
+        {
+          if (this->is_secn_or_group_unique_[*p])
+            continue;
+          const Section_id& secn(this->id_section_[*p]);
+          Icf_section_contents* contents = &(*this->contents_)[*p];
+          if (this->input_cksums_)
+            {
+              section_size_type plen;
+              const unsigned char* section_text =
+                object->section_contents(secn.second, &plen, false);
+              contents->input_cksum = xcrc32(section_text, plen, 0xffffffff);
+            }
+          else
+            contents->deferred = !get_section_contents(secn, this->symtab_,
+                                                       this->section_flags_,
+                                                       contents);
+        }
+    }
+}
+
+// Return the number of helper tasks to use for JOB_COUNT jobs.
+
+static size_t
+parallel_icf_helpers(size_t job_count)
+{
+  gold_assert(job_count > 0);
+  size_t helpers = job_count - 1;
+  size_t thread_count = parameters->options().thread_count_middle();
+  if (thread_count == 0)
+    return std::min(helpers, parallel_icf_max_helpers);
+  return std::min(helpers, thread_count - 1);
+}
+
 // This is the main ICF function called in gold.cc.  This does the
 // initialization and calls match_sections repeatedly (twice by default)
 // which computes the crc checksums and detects identical functions.
+// The contents of the candidate sections are computed first, in
+// parallel when threads are in use.  TASK is the task calling this.
 
 void
 Icf::find_identical_sections(const Input_objects* input_objects,
-                             Symbol_table* symtab)
+                             Symbol_table* symtab,
+                             Workqueue* workqueue,
+                             const Task* task)
 {
   unsigned int section_num = 0;
-  std::vector<unsigned int> num_tracked_relocs;
   std::vector<bool> is_secn_or_group_unique;
-  std::vector<std::string> section_contents;
   const Target& target = parameters->target();
 
+  // The sections of each input file, in order.
+  Icf_contents_work::Jobs jobs;
+  Unordered_map<const Task_token*, size_t> file_jobs;
+
+  // With threads, record the flags of the sections of each object
+  // while it is locked here.
+  Icf_section_flags_map section_flags;
+  const bool threads = parameters->options().threads();
+
   // Decide which sections are possible candidates first.
 
   for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
        p != input_objects->relobj_end();
        ++p)
     {
-      // Lock the object so we can read from it.  This is only called
-      // single-threaded from queue_middle_tasks, so it is OK to lock.
-      // Unfortunately we have no way to pass in a Task token.
-      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-      Task_lock_obj<Object> tl(dummy_task, *p);
+      // Lock the object so we can read from it.
+      Task_lock_obj<Object> tl(task, *p);
+
+      if (threads)
+        {
+          Icf_section_flags& flags(section_flags[*p]);
+          flags.reserve((*p)->shnum());
+          for (unsigned int i = 0; i < (*p)->shnum(); ++i)
+            flags.push_back(std::make_pair((*p)->section_flags(i),
+                                           (*p)->section_entsize(i)));
+        }
 
       for (unsigned int i = 0;i < (*p)->shnum(); ++i)
         {
@@ -737,13 +999,60 @@ Icf::find_identical_sections(const Input_objects* input_objects,
           this->id_section_.push_back(Section_id(*p, i));
           this->section_id_[Section_id(*p, i)] = section_num;
           this->kept_section_id_.push_back(section_num);
-          num_tracked_relocs.push_back(0);
           is_secn_or_group_unique.push_back(false);
-          section_contents.push_back("");
+
+          std::pair<Unordered_map<const Task_token*, size_t>::iterator, bool>
+            ins = file_jobs.insert(std::make_pair((*p)->token(),
+                                                  jobs.size()));
+          if (ins.second)
+            jobs.push_back(std::vector<unsigned int>());
+          jobs[ins.first->second].push_back(section_num);
+
           section_num++;
         }
     }
 
+  std::vector<Icf_section_contents> contents(section_num);
+  Icf_kept_changes kept_changes(section_num);
+
+  const bool parallel = (threads
+                         && jobs.size() >= 2
+                         && section_num >= parallel_icf_min_sections);
+  size_t helpers = parallel ? parallel_icf_helpers(jobs.size()) : 0;
+  const Icf_section_flags_map* flags = parallel ? &section_flags : NULL;
+
+  if (!jobs.empty())
+    {
+      Icf_contents_work* work =
+        new Icf_contents_work(&jobs, true, this->id_section_,
+                              is_secn_or_group_unique, symtab, flags,
+                              &contents);
+      work->run(workqueue, task, helpers);
+    }
+
+  preprocess_for_unique_sections(&is_secn_or_group_unique, true, contents);
+
+  if (!jobs.empty())
+    {
+      Icf_contents_work* work =
+        new Icf_contents_work(&jobs, false, this->id_section_,
+                              is_secn_or_group_unique, symtab, flags,
+                              &contents);
+      work->run(workqueue, task, helpers);
+    }
+
+  // Compute the contents which could not be computed in parallel,
+  // because their relocs point to merge sections in other files.
+  for (unsigned int i = 0; i < section_num; ++i)
+    {
+      if (!contents[i].deferred)
+        continue;
+      const Section_id& secn(this->id_section_[i]);
+      Task_lock_obj<Object> tl(task, secn.first);
+      contents[i].deferred = false;
+      get_section_contents(secn, symtab, NULL, &contents[i]);
+    }
+
   unsigned int num_iterations = 0;
 
   // Default number of iterations to run ICF is 2.
@@ -756,10 +1065,12 @@ Icf::find_identical_sections(const Input_objects* input_objects,
   while (!converged && (num_iterations < max_iterations))
     {
       num_iterations++;
-      converged = match_sections(num_iterations, symtab,
-                                 &num_tracked_relocs, &this->kept_section_id_,
-                                 this->id_section_, &is_secn_or_group_unique,
-                                 &section_contents);
+      if (num_iterations > 1)
+        preprocess_for_unique_sections(&is_secn_or_group_unique, false,
+                                       contents);
+      converged = match_sections(num_iterations, &this->kept_section_id_,
+                                 &kept_changes, &is_secn_or_group_unique,
+                                 &contents);
     }
 
   if (parameters->options().print_icf_sections())
@@ -35,6 +35,8 @@ namespace gold
 class Object;
 class Input_objects;
 class Symbol_table;
+class Task;
+class Workqueue;
 
 class Icf
 {
@@ -77,10 +79,14 @@ class Icf
   get_folded_section(Object* dup_obj, unsigned int dup_shndx);
 
   // Forms groups of identical sections where the first member
-  // of each group is the kept section during folding.
+  // of each group is the kept section during folding.  TASK is the
+  // task calling this, and the work may be shared with other tasks
+  // queued on WORKQUEUE.
   void
   find_identical_sections(const Input_objects* input_objects,
-                          Symbol_table* symtab);
+                          Symbol_table* symtab,
+                          Workqueue* workqueue,
+                          const Task* task);
 
   // This is set when ICF has been run and the groups of
   // identical sections have been formed.
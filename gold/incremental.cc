@@ -38,13 +38,15 @@
 #include "target.h"
 #include "fileread.h"
 #include "script.h"
+#include "workqueue.h"
 
 namespace gold {
 
 // Version number for the .gnu_incremental_inputs section.
 // Version 1 was the initial checkin.
 // Version 2 adds some padding to ensure 8-byte alignment where necessary.
-const unsigned int INCREMENTAL_LINK_VERSION = 2;
+// Version 3 adds a checksum of the contents to each input file entry.
+const unsigned int INCREMENTAL_LINK_VERSION = 3;
 
 // This class manages the .gnu_incremental_inputs section, which holds
 // the header information, a directory of input files, and separate
@@ -305,6 +307,7 @@ Sized_incremental_binary<size, big_endian>::setup_readers()
   Incremental_inputs_reader<size, big_endian>& inputs = this->inputs_reader_;
   unsigned int count = inputs.input_file_count();
   this->input_objects_.resize(count);
+  this->file_changed_.resize(count, FILE_CHANGED_UNKNOWN);
   this->input_entry_readers_.reserve(count);
   this->library_map_.resize(count);
   this->script_map_.resize(count);
@@ -467,11 +470,29 @@ Sized_incremental_binary<size, big_endian>::do_check_inputs(
 }
 
 // Return TRUE if input file N has changed since the last incremental link.
+// A file whose modification time is newer is still taken as unchanged if
+// the checksum of its contents is the same as in the last link.
 
 template<int size, bool big_endian>
 bool
 Sized_incremental_binary<size, big_endian>::do_file_has_changed(
     unsigned int n) const
+{
+  gold_assert(n < this->file_changed_.size());
+  if (this->file_changed_[n] != FILE_CHANGED_UNKNOWN)
+    return this->file_changed_[n] == FILE_CHANGED_YES;
+  bool changed = this->file_contents_changed(n);
+  this->file_changed_[n] = changed ? FILE_CHANGED_YES : FILE_CHANGED_NO;
+  return changed;
+}
+
+// Return TRUE if input file N has changed since the last incremental link,
+// without looking at the cached answer.
+
+template<int size, bool big_endian>
+bool
+Sized_incremental_binary<size, big_endian>::file_contents_changed(
+    unsigned int n) const
 {
   Input_entry_reader input_file = this->inputs_reader_.input_file(n);
   Incremental_disposition disp = INCREMENTAL_CHECK;
@@ -507,11 +528,22 @@ Sized_incremental_binary<size, big_endian>::do_file_has_changed(
       return true;
     }
 
-  if (new_mtime.seconds > old_mtime.seconds)
+  if (new_mtime.seconds < old_mtime.seconds
+      || (new_mtime.seconds == old_mtime.seconds
+	  && new_mtime.nanoseconds <= old_mtime.nanoseconds))
+    return false;
+
+  // The file has been written since the last link.  If it was rebuilt
+  // with the same contents, we can still keep its contributions.
+  uint64_t old_checksum = input_file.get_checksum();
+  if (old_checksum == 0)
     return true;
-  if (new_mtime.seconds == old_mtime.seconds
-      && new_mtime.nanoseconds > old_mtime.nanoseconds)
+  uint64_t new_checksum;
+  if (!get_file_checksum(filename, &new_checksum))
     return true;
+  if (new_checksum != old_checksum)
+    return true;
+  gold_debug(DEBUG_INCREMENTAL, "%s: contents unchanged", filename);
   return false;
 }
 
@@ -1025,11 +1057,16 @@ Incremental_inputs::report_archive_begin(Library_base* arch,
   if (script_info != NULL)
     arg_serial = 0;
 
-  this->strtab_->add(arch->filename().c_str(), false, &filename_key);
+  const char* filename = this->strtab_->add(arch->filename().c_str(), false,
+					    &filename_key);
   Incremental_archive_entry* entry =
       new Incremental_archive_entry(filename_key, arg_serial, mtime);
   arch->set_incremental_info(entry);
 
+  // A --start-lib group is not a file; its members are.
+  if (arch->filename() != "/group/")
+    this->checksum_inputs_.push_back(std::make_pair(entry, filename));
+
   if (script_info != NULL)
     {
       Incremental_script_entry* script_entry = script_info->incremental_info();
@@ -1097,7 +1134,8 @@ Incremental_inputs::report_object(Object* obj, unsigned int arg_serial,
   if (script_info != NULL)
     arg_serial = 0;
 
-  this->strtab_->add(obj->name().c_str(), false, &filename_key);
+  const char* filename = this->strtab_->add(obj->name().c_str(), false,
+					    &filename_key);
 
   Incremental_input_entry* input_entry;
 
@@ -1134,6 +1172,11 @@ Incremental_inputs::report_object(Object* obj, unsigned int arg_serial,
 
   this->inputs_.push_back(input_entry);
 
+  // The members of an archive are checked through the archive, but
+  // the members of a --start-lib group are files of their own.
+  if (arch == NULL || arch->filename() == "/group/")
+    this->checksum_inputs_.push_back(std::make_pair(input_entry, filename));
+
   if (script_info != NULL)
     {
       Incremental_script_entry* script_entry = script_info->incremental_info();
@@ -1183,19 +1226,110 @@ Incremental_inputs::report_script(Script_info* script,
 {
   Stringpool::Key filename_key;
 
-  this->strtab_->add(script->filename().c_str(), false, &filename_key);
+  const char* filename = this->strtab_->add(script->filename().c_str(), false,
+					    &filename_key);
   Incremental_script_entry* entry =
       new Incremental_script_entry(filename_key, arg_serial, script, mtime);
   this->inputs_.push_back(entry);
+  this->checksum_inputs_.push_back(std::make_pair(entry, filename));
   script->set_incremental_info(entry);
 }
 
+// Compute the checksums of the input files in parallel.  Each job
+// reads one file.
+
+class Incremental_checksum_work : public Parallel_work
+{
+ public:
+  typedef std::vector<std::pair<Incremental_input_entry*, const char*> > Jobs;
+
+  Incremental_checksum_work(const Jobs* jobs)
+    : Parallel_work(jobs->size(), "incremental_checksum"), jobs_(jobs)
+  { }
+
+ protected:
+  void
+  do_run(size_t i, const Task*)
+  {
+    const std::pair<Incremental_input_entry*, const char*>& job =
+	(*this->jobs_)[i];
+    uint64_t checksum;
+    if (get_file_checksum(job.second, &checksum))
+      job.first->set_checksum(checksum);
+  }
+
+ private:
+  const Jobs* jobs_;
+};
+
+// The most helper tasks to use when the --thread-count-middle option
+// does not say how many threads to use.
+
+static const size_t parallel_checksum_max_helpers = 8;
+
+// Return the number of helper tasks to compute JOB_COUNT checksums.
+
+static size_t
+parallel_checksum_helpers(size_t job_count)
+{
+  gold_assert(job_count > 0);
+  size_t helpers = job_count - 1;
+  size_t thread_count = parameters->options().thread_count_middle();
+  if (thread_count == 0)
+    return std::min(helpers, parallel_checksum_max_helpers);
+  return std::min(helpers, thread_count - 1);
+}
+
 // Finalize the incremental link information.  Called from
 // Layout::finalize.
 
 void
-Incremental_inputs::finalize()
-{
+Incremental_inputs::finalize(Incremental_binary* base, Workqueue* workqueue,
+			     const Task* task)
+{
+  // Record a checksum of each input file, so that the next incremental
+  // update can tell whether a file with a newer modification time has
+  // really changed.  A file that has the same name and modification
+  // time as in the base file keeps its old checksum; only the others
+  // are read.
+  Unordered_map<std::string, unsigned int> base_files;
+  if (base != NULL)
+    {
+      unsigned int count = base->input_file_count();
+      for (unsigned int i = 0; i < count; ++i)
+	base_files[base->get_input_reader(i)->filename()] = i;
+    }
+
+  Incremental_checksum_work::Jobs jobs;
+  for (Checksum_inputs::const_iterator p = this->checksum_inputs_.begin();
+       p != this->checksum_inputs_.end();
+       ++p)
+    {
+      Unordered_map<std::string, unsigned int>::const_iterator q =
+	base_files.find(p->second);
+      if (q != base_files.end())
+	{
+	  const Incremental_binary::Input_reader* old =
+	    base->get_input_reader(q->second);
+	  Timespec old_mtime = old->get_mtime();
+	  const Timespec& mtime = p->first->get_mtime();
+	  if (old->get_checksum() != 0
+	      && old_mtime.seconds == mtime.seconds
+	      && old_mtime.nanoseconds == mtime.nanoseconds)
+	    {
+	      p->first->set_checksum(old->get_checksum());
+	      continue;
+	    }
+	}
+      jobs.push_back(*p);
+    }
+
+  if (!jobs.empty())
+    {
+      Incremental_checksum_work* work = new Incremental_checksum_work(&jobs);
+      work->run(workqueue, task, parallel_checksum_helpers(jobs.size()));
+    }
+
   // Finalize the string table.
   this->strtab_->set_string_offsets();
 }
@@ -1498,7 +1632,8 @@ Output_section_incremental_inputs<size, big_endian>::write_input_files(
       Swap32::writeval(pov + 16, mtime.nanoseconds);
       Swap16::writeval(pov + 20, flags);
       Swap16::writeval(pov + 22, (*p)->arg_serial());
-      gold_assert(this->input_entry_size == 24);
+      Swap64::writeval(pov + 24, (*p)->get_checksum());
+      gold_assert(this->input_entry_size == 32);
       pov += this->input_entry_size;
     }
   return pov;
@@ -2464,7 +2599,8 @@ template<int size, bool big_endian>
 void
 Sized_relobj_incr<size, big_endian>::do_count_local_symbols(
     Stringpool_template<char>* pool,
-    Stringpool_template<char>*)
+    Stringpool_template<char>*,
+    size_t)
 {
   const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
 
@@ -2543,7 +2679,8 @@ template<int size, bool big_endian>
 void
 Sized_relobj_incr<size, big_endian>::do_relocate(const Symbol_table*,
 						 const Layout* layout,
-						 Output_file* of)
+						 Output_file* of,
+						 Workqueue*)
 {
   if (this->incr_reloc_count_ == 0)
     return;
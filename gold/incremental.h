@@ -46,6 +46,8 @@ class Incremental_inputs;
 class Incremental_binary;
 class Incremental_library;
 class Object;
+class Task;
+class Workqueue;
 
 // Incremental input type as stored in .gnu_incremental_inputs.
 
@@ -100,8 +102,8 @@ class Incremental_input_entry
   Incremental_input_entry(Stringpool::Key filename_key, unsigned int arg_serial,
 			  Timespec mtime)
     : filename_key_(filename_key), file_index_(0), offset_(0), info_offset_(0),
-      arg_serial_(arg_serial), mtime_(mtime), is_in_system_directory_(false),
-      as_needed_(false)
+      arg_serial_(arg_serial), mtime_(mtime), checksum_(0),
+      is_in_system_directory_(false), as_needed_(false)
   { }
 
   virtual
@@ -156,6 +158,17 @@ class Incremental_input_entry
   get_mtime() const
   { return this->mtime_; }
 
+  // Set the checksum of the contents of the input file.
+  void
+  set_checksum(uint64_t checksum)
+  { this->checksum_ = checksum; }
+
+  // Get the checksum of the contents of the input file, or 0 if it
+  // is not known.
+  uint64_t
+  get_checksum() const
+  { return this->checksum_; }
+
   // Record that the file was found in a system directory.
   void
   set_is_in_system_directory()
@@ -248,6 +261,9 @@ class Incremental_input_entry
   // Last modification time of the file.
   Timespec mtime_;
 
+  // Checksum of the contents of the file, or 0 if not known.
+  uint64_t checksum_;
+
   // TRUE if the file was found in a system directory.
   bool is_in_system_directory_;
 
@@ -563,7 +579,7 @@ class Incremental_inputs
       strtab_(new Stringpool()), current_object_(NULL),
       current_object_entry_(NULL), inputs_section_(NULL),
       symtab_section_(NULL), relocs_section_(NULL),
-      reloc_count_(0)
+      reloc_count_(0), checksum_inputs_()
   { }
 
   ~Incremental_inputs() { delete this->strtab_; }
@@ -611,9 +627,12 @@ class Incremental_inputs
   set_reloc_count(unsigned int count)
   { this->reloc_count_ = count; }
 
-  // Prepare for layout.  Called from Layout::finalize.
+  // Prepare for layout.  Called from Layout::finalize.  BASE is the
+  // base file of an incremental update, or NULL.  TASK is the task
+  // calling this; WORKQUEUE is used to compute the checksums of the
+  // input files in parallel.
   void
-  finalize();
+  finalize(Incremental_binary* base, Workqueue* workqueue, const Task* task);
 
   // Create the .gnu_incremental_inputs and related sections.
   void
@@ -703,6 +722,12 @@ class Incremental_inputs
   // Total count of incremental relocations.  Updated during Scan_relocs
   // phase at the completion of each object file.
   unsigned int reloc_count_;
+
+  // The input entries that are files of their own, and so get a
+  // checksum, with the names of the files.
+  typedef std::vector<std::pair<Incremental_input_entry*, const char*> >
+      Checksum_inputs;
+  Checksum_inputs checksum_inputs_;
 };
 
 // Reader class for global symbol info from an object file entry in
@@ -760,8 +785,9 @@ class Incremental_inputs_reader
   // (3 x 4-byte fields, plus 4 bytes padding.)
   static const unsigned int header_size = 16;
   // Size of an input file entry.
-  // (2 x 4-byte fields, 1 x 12-byte field, 2 x 2-byte fields.)
-  static const unsigned int input_entry_size = 24;
+  // (2 x 4-byte fields, 1 x 12-byte field, 2 x 2-byte fields,
+  // 1 x 8-byte field.)
+  static const unsigned int input_entry_size = 32;
   // Size of the first part of the supplemental info block for
   // relocatable objects and archive members.
   // (7 x 4-byte fields, plus 4 bytes padding.)
@@ -846,6 +872,11 @@ class Incremental_inputs_reader
       return t;
     }
 
+    // Return the checksum of the file contents, or 0 if not known.
+    uint64_t
+    get_checksum() const
+    { return Swap64::readval(this->inputs_->p_ + this->offset_ + 24); }
+
     // Return the type of input file.
     Incremental_input_type
     type() const
@@ -1380,6 +1411,10 @@ class Incremental_binary
     get_mtime() const
     { return this->do_get_mtime(); }
 
+    uint64_t
+    get_checksum() const
+    { return this->do_get_checksum(); }
+
     Incremental_input_type
     type() const
     { return this->do_type(); }
@@ -1403,6 +1438,9 @@ class Incremental_binary
     virtual Timespec
     do_get_mtime() const = 0;
 
+    virtual uint64_t
+    do_get_checksum() const = 0;
+
     virtual Incremental_input_type
     do_type() const = 0;
 
@@ -1596,7 +1634,7 @@ class Sized_incremental_binary : public Incremental_binary
       input_objects_(), section_map_(), symbol_map_(), copy_relocs_(),
       main_symtab_loc_(), main_strtab_loc_(), has_incremental_info_(false),
       inputs_reader_(), symtab_reader_(), relocs_reader_(), got_plt_reader_(),
-      input_entry_readers_()
+      input_entry_readers_(), file_changed_()
   { this->setup_readers(); }
 
   // Returns TRUE if the file contains incremental info.
@@ -1677,6 +1715,11 @@ class Sized_incremental_binary : public Incremental_binary
   virtual bool
   do_file_has_changed(unsigned int n) const;
 
+  // Return TRUE if input file N has changed, without using the
+  // answers cached in file_changed_.
+  bool
+  file_contents_changed(unsigned int n) const;
+
   // Initialize the layout of the output file based on the existing
   // output file.
   virtual void
@@ -1721,6 +1764,10 @@ class Sized_incremental_binary : public Incremental_binary
     do_get_mtime() const
     { return this->reader_.get_mtime(); }
 
+    uint64_t
+    do_get_checksum() const
+    { return this->reader_.get_checksum(); }
+
     Incremental_input_type
     do_type() const
     { return this->reader_.type(); }
@@ -1805,6 +1852,17 @@ class Sized_incremental_binary : public Incremental_binary
   Incremental_relocs_reader<size, big_endian> relocs_reader_;
   Incremental_got_plt_reader<big_endian> got_plt_reader_;
   std::vector<Sized_input_reader> input_entry_readers_;
+
+  // The answers of do_file_has_changed, cached since it may be asked
+  // about the same archive many times, and it may have to compute a
+  // checksum of the file.
+  enum File_changed
+  {
+    FILE_CHANGED_UNKNOWN,
+    FILE_CHANGED_NO,
+    FILE_CHANGED_YES
+  };
+  mutable std::vector<unsigned char> file_changed_;
 };
 
 // An incremental Relobj.  This class represents a relocatable object
@@ -1993,7 +2051,7 @@ class Sized_relobj_incr : public Sized_relobj<size, big_endian>
   // Count the local symbols.
   void
   do_count_local_symbols(Stringpool_template<char>*,
-			 Stringpool_template<char>*);
+			 Stringpool_template<char>*, size_t);
 
   // Finalize the local symbols.
   unsigned int
@@ -2009,7 +2067,8 @@ class Sized_relobj_incr : public Sized_relobj<size, big_endian>
 
   // Relocate the input sections and write out the local symbols.
   void
-  do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of);
+  do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of,
+	      Workqueue*);
 
   // Set the offset of a section.
   void
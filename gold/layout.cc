@@ -42,6 +42,7 @@
 #include "script.h"
 #include "script-sections.h"
 #include "output.h"
+#include "merge.h"
 #include "symtab.h"
 #include "dynobj.h"
 #include "ehframe.h"
@@ -376,6 +377,7 @@ Layout_task_runner::run(Workqueue* workqueue, const Task* task)
   off_t file_size = layout->finalize(this->input_objects_,
 				     this->symtab_,
 				     this->target_,
+				     workqueue,
 				     task);
 
   // Now we know the final size of the output file and we know where
@@ -432,6 +434,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     unattached_section_list_(),
     special_output_list_(),
     relax_output_list_(),
+    compressed_section_list_(),
     section_headers_(NULL),
     tls_segment_(NULL),
     relro_segment_(NULL),
@@ -495,6 +498,15 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
   // The section name pool is worth optimizing in all cases, because
   // it is small, but there are often overlaps due to .rel sections.
   this->namepool_.set_optimize();
+
+  // With threads, the local symbols of several objects are counted at
+  // once; see count_local_symbols.  The local symbols of incremental
+  // objects are only known as they are counted.
+  if (parameters->options().threads() && !parameters->incremental())
+    {
+      this->sympool_.set_concurrent();
+      this->dynpool_.set_concurrent();
+    }
 }
 
 // For incremental links, record the base file to be modified.
@@ -1609,8 +1621,13 @@ Layout::make_output_section(const char* name, elfcpp::Elf_Word type,
   if ((flags & elfcpp::SHF_ALLOC) == 0
       && strcmp(parameters->options().compress_debug_sections(), "none") != 0
       && is_compressible_debug_section(name))
-    os = new Output_compressed_section(&parameters->options(), name, type,
-				       flags);
+    {
+      Output_compressed_section* ocs =
+	new Output_compressed_section(&parameters->options(), name, type,
+				      flags);
+      this->compressed_section_list_.push_back(ocs);
+      os = ocs;
+    }
   else if ((flags & elfcpp::SHF_ALLOC) == 0
 	   && parameters->options().strip_debug_non_line()
 	   && strcmp(".debug_abbrev", name) == 0)
@@ -2647,11 +2664,16 @@ Layout::read_layout_from_file()
 
 off_t
 Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
-		 Target* target, const Task* task)
+		 Target* target, Workqueue* workqueue, const Task* task)
 {
   target->finalize_sections(this, input_objects, symtab);
 
-  this->count_local_symbols(task, input_objects);
+  this->count_local_symbols(workqueue, task, input_objects);
+
+  this->add_deferred_merge_inputs(workqueue, task);
+
+  if (this->gdb_index_data_ != NULL)
+    this->gdb_index_data_->scan_deferred_inputs(workqueue, task);
 
   this->link_stabs_sections();
 
@@ -2773,7 +2795,8 @@ Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
   // Create the incremental inputs sections.
   if (this->incremental_inputs_)
     {
-      this->incremental_inputs_->finalize();
+      this->incremental_inputs_->finalize(this->incremental_base_, workqueue,
+					  task);
       this->create_incremental_info_sections(symtab);
     }
 
@@ -3865,11 +3888,76 @@ Layout::place_orphan_sections_in_script()
     }
 }
 
+// The input objects whose local symbols are counted by several tasks
+// at once.  Each job counts the local symbols of the objects in one
+// input file, since only one task at a time may lock the file.
+
+class Count_local_symbols_work : public Parallel_work
+{
+ public:
+  // The objects of an input file, in order, each with the position of
+  // its local symbol names in the batch of ordered adds to the pools.
+  typedef std::vector<std::pair<Relobj*, size_t> > Objects;
+
+  typedef std::vector<Objects> Jobs;
+
+  // JOBS is cleared.
+  Count_local_symbols_work(Jobs* jobs, Stringpool* sympool,
+			   Stringpool* dynpool)
+    : Parallel_work(jobs->size(), "count_local_symbols"),
+      jobs_(), sympool_(sympool), dynpool_(dynpool)
+  { this->jobs_.swap(*jobs); }
+
+ protected:
+  void
+  do_run(size_t i, const Task* task)
+  {
+    const Objects& objects(this->jobs_[i]);
+    for (Objects::const_iterator p = objects.begin();
+	 p != objects.end();
+	 ++p)
+      {
+	Task_lock_obj<Object> tlo(task, p->first);
+	p->first->count_local_symbols(this->sympool_, this->dynpool_,
+				      p->second);
+      }
+  }
+
+ private:
+  Jobs jobs_;
+  Stringpool* sympool_;
+  Stringpool* dynpool_;
+};
+
+// The local symbols are counted in parallel if there are at least
+// this many of them.
+
+static const unsigned int parallel_count_min_symbols = 4096;
+
+// The most helper tasks to use for work done in parallel during
+// Layout::finalize when the --thread-count-middle option does not say
+// how many threads to use.
+
+static const size_t parallel_finalize_max_helpers = 8;
+
+// Return the number of helper tasks to use for JOB_COUNT jobs.
+
+static size_t
+parallel_finalize_helpers(size_t job_count)
+{
+  gold_assert(job_count > 0);
+  size_t helpers = job_count - 1;
+  size_t thread_count = parameters->options().thread_count_middle();
+  if (thread_count == 0)
+    return std::min(helpers, parallel_finalize_max_helpers);
+  return std::min(helpers, thread_count - 1);
+}
+
 // Count the local symbols in the regular symbol table and the dynamic
 // symbol table, and build the respective string pools.
 
 void
-Layout::count_local_symbols(const Task* task,
+Layout::count_local_symbols(Workqueue* workqueue, const Task* task,
 			    const Input_objects* input_objects)
 {
   // First, figure out an upper bound on the number of symbols we'll
@@ -3881,22 +3969,190 @@ Layout::count_local_symbols(const Task* task,
        ++p)
     symbol_count += (*p)->local_symbol_count();
 
+  // The names of the local symbols of each object come after those
+  // of the objects before it.
+  this->sympool_.begin_ordered_adds(symbol_count);
+  this->dynpool_.begin_ordered_adds(symbol_count);
+
   // Go from "upper bound" to "estimate."  We overcount for two
   // reasons: we double-count symbols that occur in more than one
   // object file, and we count symbols that are dropped from the
   // output.  Add it all together and assume we overcount by 100%.
-  symbol_count /= 2;
+  unsigned int estimate = symbol_count / 2;
 
   // We assume all symbols will go into both the sympool and dynpool.
-  this->sympool_.reserve(symbol_count);
-  this->dynpool_.reserve(symbol_count);
+  this->sympool_.reserve(estimate);
+  this->dynpool_.reserve(estimate);
+
+  Count_local_symbols_work::Jobs jobs;
+  if (workqueue != NULL
+      && this->sympool_.is_concurrent()
+      && this->dynpool_.is_concurrent()
+      && symbol_count >= parallel_count_min_symbols)
+    {
+      // Each job counts the local symbols of the objects in one file.
+      Unordered_map<const Task_token*, size_t> file_jobs;
+      size_t position = 0;
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  std::pair<Unordered_map<const Task_token*, size_t>::iterator, bool>
+	    ins = file_jobs.insert(std::make_pair((*p)->token(),
+						  jobs.size()));
+	  if (ins.second)
+	    jobs.push_back(Count_local_symbols_work::Objects());
+	  jobs[ins.first->second].push_back(std::make_pair(*p, position));
+	  position += (*p)->local_symbol_count();
+	}
+    }
 
+  if (jobs.size() >= 2)
+    {
+      // The work takes over the jobs.
+      size_t helpers = parallel_finalize_helpers(jobs.size());
+      Count_local_symbols_work* work =
+	new Count_local_symbols_work(&jobs, &this->sympool_, &this->dynpool_);
+      work->run(workqueue, task, helpers);
+      return;
+    }
+
+  size_t position = 0;
   for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
        p != input_objects->relobj_end();
        ++p)
     {
       Task_lock_obj<Object> tlo(task, *p);
-      (*p)->count_local_symbols(&this->sympool_, &this->dynpool_);
+      (*p)->count_local_symbols(&this->sympool_, &this->dynpool_, position);
+      position += (*p)->local_symbol_count();
+    }
+}
+
+// Add or map the deferred input sections of merge sections in
+// parallel.  Each job handles the input sections of the objects in
+// one file.
+
+class Merge_inputs_work : public Parallel_work
+{
+ public:
+  // The deferred input sections of an input file, each given by its
+  // merge section and its index there.
+  typedef std::vector<std::pair<Output_merge_base*, size_t> > Inputs;
+
+  typedef std::vector<Inputs> Jobs;
+
+  // If MAP is true, map the input sections, otherwise add them.
+  Merge_inputs_work(const Jobs* jobs, bool map)
+    : Parallel_work(jobs->size(),
+		    map ? "map_merge_inputs" : "add_merge_inputs"),
+      jobs_(jobs), map_(map)
+  { }
+
+  // Add or map the input sections of JOB.
+  static void
+  run_job(const Inputs& job, bool map, const Task* task)
+  {
+    for (Inputs::const_iterator p = job.begin(); p != job.end(); ++p)
+      {
+	if (map)
+	  p->first->map_deferred_input(p->second);
+	else
+	  {
+	    Task_lock_obj<Object> tlo(task,
+				      p->first->deferred_input_object(p->second));
+	    p->first->add_deferred_input(p->second);
+	  }
+      }
+  }
+
+ protected:
+  void
+  do_run(size_t i, const Task* task)
+  { run_job((*this->jobs_)[i], this->map_, task); }
+
+ private:
+  const Jobs* jobs_;
+  bool map_;
+};
+
+// The deferred input sections are handled in parallel if there are at
+// least this many of them.
+
+static const size_t parallel_merge_min_inputs = 64;
+
+// The merge sections of output sections may defer adding their input
+// sections, so that the work can be shared among threads.  Add them
+// now, then map them to the output sections.  The results are the
+// same as though each input section were added when it was seen.
+
+void
+Layout::add_deferred_merge_inputs(Workqueue* workqueue, const Task* task)
+{
+  std::vector<Output_merge_base*> merge_sections;
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    (*p)->get_merge_sections(&merge_sections);
+
+  Merge_inputs_work::Jobs jobs;
+  Unordered_map<const Task_token*, size_t> file_jobs;
+  size_t input_count = 0;
+  for (std::vector<Output_merge_base*>::const_iterator p =
+	 merge_sections.begin();
+       p != merge_sections.end();
+       ++p)
+    {
+      size_t count = (*p)->start_deferred_inputs();
+      for (size_t i = 0; i < count; ++i)
+	{
+	  Relobj* object = (*p)->deferred_input_object(i);
+	  std::pair<Unordered_map<const Task_token*, size_t>::iterator, bool>
+	    ins = file_jobs.insert(std::make_pair(object->token(),
+						  jobs.size()));
+	  if (ins.second)
+	    jobs.push_back(Merge_inputs_work::Inputs());
+	  jobs[ins.first->second].push_back(std::make_pair(*p, i));
+	}
+      input_count += count;
+    }
+
+  if (jobs.empty())
+    return;
+
+  const bool parallel = (workqueue != NULL
+			 && jobs.size() >= 2
+			 && input_count >= parallel_merge_min_inputs);
+
+  if (parallel)
+    {
+      Merge_inputs_work* work = new Merge_inputs_work(&jobs, false);
+      work->run(workqueue, task, parallel_finalize_helpers(jobs.size()));
+    }
+  else
+    {
+      for (Merge_inputs_work::Jobs::const_iterator p = jobs.begin();
+	   p != jobs.end();
+	   ++p)
+	Merge_inputs_work::run_job(*p, false, task);
+    }
+
+  for (std::vector<Output_merge_base*>::const_iterator p =
+	 merge_sections.begin();
+       p != merge_sections.end();
+       ++p)
+    (*p)->finish_deferred_inputs();
+
+  if (parallel)
+    {
+      Merge_inputs_work* work = new Merge_inputs_work(&jobs, true);
+      work->run(workqueue, task, parallel_finalize_helpers(jobs.size()));
+    }
+  else
+    {
+      for (Merge_inputs_work::Jobs::const_iterator p = jobs.begin();
+	   p != jobs.end();
+	   ++p)
+	Merge_inputs_work::run_job(*p, true, task);
     }
 }
 
@@ -5304,7 +5560,9 @@ Layout::write_data(const Symbol_table* symtab, Output_file* of) const
 // input sections are complete.
 
 void
-Layout::write_sections_after_input_sections(Output_file* of)
+Layout::write_sections_after_input_sections(Output_file* of,
+					    Workqueue* workqueue,
+					    const Task* task)
 {
   // Determine the final section offsets, and thus the final output
   // file size.  Note we finalize the .shstrab last, to allow the
@@ -5312,6 +5570,15 @@ Layout::write_sections_after_input_sections(Output_file* of)
   // writing.
   if (this->any_postprocessing_sections_)
     {
+      // Compress the debug sections first, so that the chunks of
+      // large sections may be compressed in parallel.
+      for (Compressed_section_list::const_iterator p =
+	     this->compressed_section_list_.begin();
+	   p != this->compressed_section_list_.end();
+	   ++p)
+	if (!(*p)->is_data_size_valid())
+	  (*p)->compress(workqueue, task);
+
       off_t off = this->output_file_size_;
       off = this->set_section_offsets(off, POSTPROCESSING_SECTIONS_PASS);
 
@@ -5327,6 +5594,13 @@ Layout::write_sections_after_input_sections(Output_file* of)
 	}
     }
 
+  // The .eh_frame section has been relocated, so we can build the
+  // sorted table for .eh_frame_hdr, using threads if we have them.
+  if (this->eh_frame_data_ != NULL
+      && this->eh_frame_data_->eh_frame_hdr() != NULL)
+    this->eh_frame_data_->eh_frame_hdr()->build_fde_table(of, workqueue,
+							  task);
+
   for (Section_list::const_iterator p = this->section_list_.begin();
        p != this->section_list_.end();
        ++p)
@@ -5607,9 +5881,10 @@ Write_after_input_sections_task::locks(Task_locker* tl)
 // Run the task.
 
 void
-Write_after_input_sections_task::run(Workqueue*)
+Write_after_input_sections_task::run(Workqueue* workqueue)
 {
-  this->layout_->write_sections_after_input_sections(this->of_);
+  this->layout_->write_sections_after_input_sections(this->of_, workqueue,
+						     this);
 }
 
 // Close_task_runner methods.
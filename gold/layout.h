@@ -58,6 +58,7 @@ class Output_data_dynamic;
 class Output_symtab_xindex;
 class Output_reduced_debug_abbrev_section;
 class Output_reduced_debug_info_section;
+class Output_compressed_section;
 class Eh_frame;
 class Gdb_index;
 class Target;
@@ -784,7 +785,8 @@ class Layout
 
   // Finalize the layout after all the input sections have been added.
   off_t
-  finalize(const Input_objects*, Symbol_table*, Target*, const Task*);
+  finalize(const Input_objects*, Symbol_table*, Target*, Workqueue*,
+	   const Task*);
 
   // Return whether any sections require postprocessing.
   bool
@@ -841,9 +843,11 @@ class Layout
   write_data(const Symbol_table*, Output_file*) const;
 
   // Write out output sections which can not be written until all the
-  // input sections are complete.
+  // input sections are complete.  TASK is the task calling this,
+  // which may queue more work on WORKQUEUE.
   void
-  write_sections_after_input_sections(Output_file* of);
+  write_sections_after_input_sections(Output_file* of, Workqueue* workqueue,
+				      const Task* task);
 
   // Return an output section named NAME, or NULL if there is none.
   Output_section*
@@ -927,6 +931,9 @@ class Layout
   // either a section or a segment.
   typedef std::vector<Output_data*> Data_list;
 
+  // A list of compressed debug sections.
+  typedef std::vector<Output_compressed_section*> Compressed_section_list;
+
   // Store the allocated sections into the section list.  This is used
   // by the linker script code.
   void
@@ -1055,7 +1062,11 @@ class Layout
   // Count the local symbols in the regular symbol table and the dynamic
   // symbol table, and build the respective string pools.
   void
-  count_local_symbols(const Task*, const Input_objects*);
+  count_local_symbols(Workqueue*, const Task*, const Input_objects*);
+
+  // Add the deferred input sections of the merge sections.
+  void
+  add_deferred_merge_inputs(Workqueue*, const Task*);
 
   // Create the output sections for the symbol table.
   void
@@ -1338,6 +1349,8 @@ class Layout
   // Like special_output_list_, but cleared and recreated on each
   // iteration of relaxation.
   Data_list relax_output_list_;
+  // The list of compressed debug sections.
+  Compressed_section_list compressed_section_list_;
   // The section headers.
   Output_section_headers* section_headers_;
   // A pointer to the PT_TLS segment if there is one.
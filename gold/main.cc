@@ -29,6 +29,10 @@
 #include <malloc.h>
 #endif
 
+#ifdef HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
 #include "libiberty.h"
 
 #include "script.h"
@@ -251,6 +255,9 @@ main(int argc, char** argv)
   // Run the main task processing loop.
   workqueue.process(0);
 
+  if (command_line.options().user_set_trace_tasks())
+    workqueue.write_task_trace(command_line.options().trace_tasks());
+
   if (command_line.options().print_output_format())
     print_output_format();
 
@@ -295,6 +302,14 @@ main(int argc, char** argv)
       fprintf(stderr, _("%s: total space allocated by malloc: %d bytes\n"),
 	      program_name, m.arena);
 #endif
+#ifdef HAVE_GETRUSAGE
+      struct rusage ru;
+      if (::getrusage(RUSAGE_SELF, &ru) == 0)
+	fprintf(stderr, _("%s: page faults: %ld minor, %ld major\n"),
+		program_name, static_cast<long>(ru.ru_minflt),
+		static_cast<long>(ru.ru_majflt));
+#endif
+      workqueue.print_stats();
       File_read::print_stats();
       Archive::print_stats();
       Lib_group::print_stats();
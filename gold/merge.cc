@@ -59,6 +59,20 @@ Object_merge_map::get_input_merge_map(unsigned int shndx)
   return NULL;
 }
 
+// Sort the entries of MAP by input offset, if they are not already
+// sorted.
+
+void
+Object_merge_map::sort_input_merge_map(Input_merge_map* map)
+{
+  if (!map->sorted)
+    {
+      std::sort(map->entries.begin(), map->entries.end(),
+		Input_merge_compare());
+      map->sorted = true;
+    }
+}
+
 // Get or create the Input_merge_map to use for an input section.
 
 Object_merge_map::Input_merge_map*
@@ -152,12 +166,7 @@ Object_merge_map::get_output_offset(const Merge_map* merge_map,
       || (merge_map != NULL && map->merge_map != merge_map))
     return false;
 
-  if (!map->sorted)
-    {
-      std::sort(map->entries.begin(), map->entries.end(),
-		Input_merge_compare());
-      map->sorted = true;
-    }
+  sort_input_merge_map(map);
 
   Input_merge_entry entry;
   entry.input_offset = input_offset;
@@ -182,6 +191,19 @@ Object_merge_map::get_output_offset(const Merge_map* merge_map,
   return true;
 }
 
+// Sort the mappings of every input section.
+
+void
+Object_merge_map::sort_input_merge_maps()
+{
+  sort_input_merge_map(&this->first_map_);
+  sort_input_merge_map(&this->second_map_);
+  for (Section_merge_maps::iterator p = this->section_merge_maps_.begin();
+       p != this->section_merge_maps_.end();
+       ++p)
+    sort_input_merge_map(p->second);
+}
+
 // Return whether this is the merge map for section SHNDX.
 
 inline bool
@@ -538,45 +560,117 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   Merged_strings_list* merged_strings_list =
       new Merged_strings_list(object, shndx);
   this->merged_strings_lists_.push_back(merged_strings_list);
-  Merged_strings& merged_strings = merged_strings_list->merged_strings;
 
-  // Count the number of non-null strings in the section and size the list.
+  // We assume here that the beginning of the section is correctly
+  // aligned, so each string within the section must retain the same
+  // modulo.
+  uintptr_t init_align_modulo = (reinterpret_cast<uintptr_t>(pdata)
+				 & (this->addralign() - 1));
+  bool has_misaligned_strings = false;
+
+  // Count the number of non-null strings in the section, and the
+  // number of strings including the null ones.
   size_t count = 0;
+  size_t string_count = 0;
   const Char_type* pt = p;
   while (pt < pend0)
     {
       size_t len = string_length(pt);
       if (len != 0)
-	++count;
+	{
+	  ++count;
+
+	  // Within merge input section each string must be aligned.
+	  if ((reinterpret_cast<uintptr_t>(pt) & (this->addralign() - 1))
+	      != init_align_modulo)
+	    has_misaligned_strings = true;
+	}
+      ++string_count;
       pt += len + 1;
     }
   if (pend0 < pend)
-    ++count;
-  merged_strings.reserve(count + 1);
+    {
+      ++count;
+      ++string_count;
+    }
+
+  if (!this->stringpool_.is_concurrent())
+    {
+      merged_strings_list->merged_strings.reserve(count + 1);
+      this->add_strings(merged_strings_list, pdata, sec_len);
+    }
+  else
+    {
+      // The strings will be added by add_deferred_input.  Keep the
+      // contents of a compressed section until then, rather than
+      // uncompressing it again.
+      merged_strings_list->position = this->deferred_count_;
+      merged_strings_list->count = string_count;
+      this->deferred_count_ += string_count;
+      if (is_new)
+	{
+	  merged_strings_list->contents = pdata;
+	  merged_strings_list->contents_size = sec_len;
+	  is_new = false;
+	}
+    }
+
+  this->input_count_ += count;
+  // The index of the end of the last string in the section, in bytes.
+  // An unterminated string is treated as though it had a null.
+  this->input_size_ += sec_len;
+  if (pend0 < pend)
+    this->input_size_ += sizeof(Char_type);
+
+  if (has_misaligned_strings)
+    gold_warning(_("%s: section %s contains incorrectly aligned strings;"
+		   " the alignment of those strings won't be preserved"),
+		 object->name().c_str(),
+		 object->section_name(shndx).c_str());
+
+  // For script processing, we keep the input sections.
+  if (this->keeps_input_sections())
+    record_input_section(object, shndx);
+
+  if (is_new)
+    delete[] pdata;
+
+  return true;
+}
+
+// Add the strings in PDATA, the contents of an input section of size
+// LEN, to the Stringpool.  Record their keys in MERGED_STRINGS_LIST.
+// For a concurrent Stringpool, this records their locations instead,
+// and may be called for different input sections at once.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::add_strings(
+    Merged_strings_list* merged_strings_list,
+    const unsigned char* pdata,
+    section_size_type len)
+{
+  const Char_type* p = reinterpret_cast<const Char_type*>(pdata);
+  const Char_type* pend = p + len / sizeof(Char_type);
+
+  // Find the end of the last NULL-terminated string in the buffer.
+  const Char_type* pend0 = pend;
+  while (pend0 > p && pend0[-1] != 0)
+    --pend0;
+
+  Merged_strings& merged_strings = merged_strings_list->merged_strings;
+  const bool concurrent = this->stringpool_.is_concurrent();
+  if (concurrent)
+    merged_strings.reserve(merged_strings_list->count + 1);
+  size_t position = merged_strings_list->position;
 
   // The index I is in bytes, not characters.
   section_size_type i = 0;
 
-  // We assume here that the beginning of the section is correctly
-  // aligned, so each string within the section must retain the same
-  // modulo.
-  uintptr_t init_align_modulo = (reinterpret_cast<uintptr_t>(pdata)
-				 & (this->addralign() - 1));
-  bool has_misaligned_strings = false;
-
   while (p < pend0)
     {
       size_t len = string_length(p);
-
-      // Within merge input section each string must be aligned.
-      if (len != 0
-	  && ((reinterpret_cast<uintptr_t>(p) & (this->addralign() - 1))
-	      != init_align_modulo))
-	  has_misaligned_strings = true;
-
-      Stringpool::Key key;
-      this->stringpool_.add_with_length(p, len, true, &key);
-
+      Stringpool::Key key = this->add_string(p, len, concurrent, &position);
       merged_strings.push_back(Merged_string(i, key));
       p += len + 1;
       i += (len + 1) * sizeof(Char_type);
@@ -584,36 +678,94 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   if (p < pend)
     {
       size_t len = pend - p;
-
-      Stringpool::Key key;
-      this->stringpool_.add_with_length(p, len, true, &key);
-
+      Stringpool::Key key = this->add_string(p, len, concurrent, &position);
       merged_strings.push_back(Merged_string(i, key));
-
       i += (len + 1) * sizeof(Char_type);
     }
 
+  gold_assert(!concurrent
+	      || (position
+		  == merged_strings_list->position
+		     + merged_strings_list->count));
+
   // Record the last offset in the input section so that we can
   // compute the length of the last string.
   merged_strings.push_back(Merged_string(i, 0));
+}
 
-  this->input_count_ += count;
-  this->input_size_ += i;
+// Add the mappings for the strings of an input section.  For a
+// concurrent Stringpool, this may be called for the input sections of
+// different objects at once.
 
-  if (has_misaligned_strings)
-    gold_warning(_("%s: section %s contains incorrectly aligned strings;"
-		   " the alignment of those strings won't be preserved"),
-		 object->name().c_str(),
-		 object->section_name(shndx).c_str());
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::map_strings(
+    const Merged_strings_list* merged_strings_list)
+{
+  const bool concurrent = this->stringpool_.is_concurrent();
+  section_offset_type last_input_offset = 0;
+  section_offset_type last_output_offset = 0;
+  for (typename Merged_strings::const_iterator p =
+	 merged_strings_list->merged_strings.begin();
+       p != merged_strings_list->merged_strings.end();
+       ++p)
+    {
+      section_size_type length = p->offset - last_input_offset;
+      if (length > 0)
+	this->add_mapping(merged_strings_list->object,
+			  merged_strings_list->shndx, last_input_offset,
+			  length, last_output_offset);
+      last_input_offset = p->offset;
+      if (p->stringpool_key == 0)
+	;
+      else if (concurrent)
+	last_output_offset =
+	  this->stringpool_.get_offset_from_location(p->stringpool_key);
+      else
+	last_output_offset =
+	  this->stringpool_.get_offset_from_key(p->stringpool_key);
+    }
+}
 
-  // For script processing, we keep the input sections.
-  if (this->keeps_input_sections())
-    record_input_section(object, shndx);
+// Prepare to add the deferred input sections, and return how many
+// there are.
 
+template<typename Char_type>
+size_t
+Output_merge_string<Char_type>::do_start_deferred_inputs()
+{
+  if (!this->stringpool_.is_concurrent())
+    return 0;
+  gold_assert(!this->deferred_inputs_done_);
+  this->stringpool_.begin_ordered_adds(this->deferred_count_);
+  return this->merged_strings_lists_.size();
+}
+
+// Add the strings of deferred input section I.  The object is locked.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::do_add_deferred_input(size_t i)
+{
+  Merged_strings_list* merged_strings_list = this->merged_strings_lists_[i];
+  if (merged_strings_list->contents != NULL)
+    {
+      this->add_strings(merged_strings_list, merged_strings_list->contents,
+			merged_strings_list->contents_size);
+      delete[] merged_strings_list->contents;
+      merged_strings_list->contents = NULL;
+      return;
+    }
+
+  Relobj* object = merged_strings_list->object;
+  section_size_type sec_len;
+  bool is_new;
+  const unsigned char* pdata =
+    object->decompressed_section_contents(merged_strings_list->shndx,
+					  &sec_len, &is_new);
+  this->add_strings(merged_strings_list, pdata, sec_len);
   if (is_new)
     delete[] pdata;
-
-  return true;
 }
 
 // Finalize the mappings from the input sections to the output
@@ -623,6 +775,13 @@ template<typename Char_type>
 section_size_type
 Output_merge_string<Char_type>::finalize_merged_data()
 {
+  // The deferred input sections of a concurrent Stringpool have
+  // already been mapped.
+  const bool concurrent = this->stringpool_.is_concurrent();
+  gold_assert(!concurrent
+	      || this->deferred_inputs_done_
+	      || this->merged_strings_lists_.empty());
+
   this->stringpool_.set_string_offsets();
 
   for (typename Merged_strings_lists::const_iterator l =
@@ -630,22 +789,8 @@ Output_merge_string<Char_type>::finalize_merged_data()
        l != this->merged_strings_lists_.end();
        ++l)
     {
-      section_offset_type last_input_offset = 0;
-      section_offset_type last_output_offset = 0;
-      for (typename Merged_strings::const_iterator p =
-	     (*l)->merged_strings.begin();
-	   p != (*l)->merged_strings.end();
-	   ++p)
-	{
-	  section_size_type length = p->offset - last_input_offset;
-	  if (length > 0)
-	    this->add_mapping((*l)->object, (*l)->shndx, last_input_offset,
-	    		      length, last_output_offset);
-	  last_input_offset = p->offset;
-	  if (p->stringpool_key != 0)
-	    last_output_offset =
-	        this->stringpool_.get_offset_from_key(p->stringpool_key);
-	}
+      if (!concurrent)
+	this->map_strings(*l);
       delete *l;
     }
 
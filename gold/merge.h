@@ -76,6 +76,12 @@ class Object_merge_map
   bool
   is_merge_section_for(const Merge_map*, unsigned int shndx);
 
+  // Sort the mappings of every input section, so that
+  // get_output_offset does not change the map.  This is called
+  // before several threads look up mappings at once.
+  void
+  sort_input_merge_maps();
+
   // Initialize an mapping from input offsets to output addresses for
   // section SHNDX.  STARTING_ADDRESS is the output address of the
   // merged section.
@@ -152,6 +158,10 @@ class Object_merge_map
   Input_merge_map*
   get_input_merge_map(unsigned int shndx);
 
+  // Sort the entries of MAP if needed.
+  static void
+  sort_input_merge_map(Input_merge_map* map);
+
   // Get or make the Input_merge_map to use for the section SHNDX
   // with MERGE_MAP.
   Input_merge_map*
@@ -277,6 +287,37 @@ class Output_merge_base : public Output_section_data
     gold_assert(this->keeps_input_sections_);
     return this->input_sections_.end();
   }
+
+  // When using threads, the contents of some merge sections are not
+  // added as each input section is seen.  Instead the deferred input
+  // sections are added in parallel before the output sections are
+  // sized.  This prepares to add them, and returns how many there
+  // are.
+  size_t
+  start_deferred_inputs()
+  { return this->do_start_deferred_inputs(); }
+
+  // Return the object of deferred input section I.
+  Relobj*
+  deferred_input_object(size_t i) const
+  { return this->do_deferred_input_object(i); }
+
+  // Add the contents of deferred input section I.  The object must be
+  // locked.  This may be called for several input sections at once.
+  void
+  add_deferred_input(size_t i)
+  { this->do_add_deferred_input(i); }
+
+  // Finish adding the deferred input sections.
+  void
+  finish_deferred_inputs()
+  { this->do_finish_deferred_inputs(); }
+
+  // Map deferred input section I to the output section.  This may be
+  // called for the input sections of different objects at once.
+  void
+  map_deferred_input(size_t i)
+  { this->do_map_deferred_input(i); }
  
  protected:
   // Return the output offset for an input offset.
@@ -310,6 +351,28 @@ class Output_merge_base : public Output_section_data
   do_set_keeps_input_sections()
   { this->keeps_input_sections_ = true; }
 
+  // These may be overridden by a child class which defers its input
+  // sections.
+  virtual size_t
+  do_start_deferred_inputs()
+  { return 0; }
+
+  virtual Relobj*
+  do_deferred_input_object(size_t) const
+  { gold_unreachable(); }
+
+  virtual void
+  do_add_deferred_input(size_t)
+  { gold_unreachable(); }
+
+  virtual void
+  do_finish_deferred_inputs()
+  { }
+
+  virtual void
+  do_map_deferred_input(size_t)
+  { gold_unreachable(); }
+
   // Record the merged input section for script processing.
   void
   record_input_section(Relobj* relobj, unsigned int shndx);
@@ -462,9 +525,14 @@ class Output_merge_string : public Output_merge_base
  public:
   Output_merge_string(uint64_t addralign)
     : Output_merge_base(sizeof(Char_type), addralign), stringpool_(addralign),
-      merged_strings_lists_(), input_count_(0), input_size_(0)
+      merged_strings_lists_(), input_count_(0), input_size_(0),
+      deferred_count_(0), deferred_inputs_done_(false)
   {
     this->stringpool_.set_no_zero_null();
+    // When using threads, the strings are added in parallel by
+    // add_deferred_input.
+    if (parameters->options().threads())
+      this->stringpool_.set_concurrent();
   }
 
  protected:
@@ -521,6 +589,35 @@ class Output_merge_string : public Output_merge_base
     Output_merge_base::do_set_keeps_input_sections();
   }
 
+  // Prepare to add the deferred input sections.
+  size_t
+  do_start_deferred_inputs();
+
+  // Return the object of deferred input section I.
+  Relobj*
+  do_deferred_input_object(size_t i) const
+  { return this->merged_strings_lists_[i]->object; }
+
+  // Add the strings of deferred input section I.
+  void
+  do_add_deferred_input(size_t i);
+
+  // Assign the offsets of the strings.
+  void
+  do_finish_deferred_inputs()
+  {
+    if (this->stringpool_.is_concurrent())
+      {
+	this->stringpool_.set_string_offsets();
+	this->deferred_inputs_done_ = true;
+      }
+  }
+
+  // Map deferred input section I.
+  void
+  do_map_deferred_input(size_t i)
+  { this->map_strings(this->merged_strings_lists_[i]); }
+
  private:
   // The name of the string type, for stats.
   const char*
@@ -532,7 +629,8 @@ class Output_merge_string : public Output_merge_base
   {
     // The offset in the input section.
     section_offset_type offset;
-    // The key in the Stringpool.
+    // The key in the Stringpool, or the location for a concurrent
+    // Stringpool.
     Stringpool::Key stringpool_key;
 
     Merged_string(section_offset_type offseta, Stringpool::Key stringpool_keya)
@@ -551,13 +649,61 @@ class Output_merge_string : public Output_merge_base
     // The list of merged strings.
     Merged_strings merged_strings;
 
+    // For a deferred input section, the position of its first string
+    // in the Stringpool's batch of ordered adds.
+    size_t position;
+    // For a deferred input section, the number of strings.
+    size_t count;
+    // For a deferred compressed input section, the uncompressed
+    // contents, or NULL.
+    const unsigned char* contents;
+    // The size of CONTENTS.
+    section_size_type contents_size;
+
     Merged_strings_list(Relobj* objecta, unsigned int shndxa)
-      : object(objecta), shndx(shndxa), merged_strings()
+      : object(objecta), shndx(shndxa), merged_strings(), position(0),
+	count(0), contents(NULL), contents_size(0)
     { }
+
+    ~Merged_strings_list()
+    {
+      if (this->contents != NULL)
+	delete[] this->contents;
+    }
   };
 
   typedef std::vector<Merged_strings_list*> Merged_strings_lists;
 
+  // Add the string S of length LEN to the Stringpool, and return its
+  // key.  For a concurrent Stringpool, add it at *POSITION, increment
+  // *POSITION, and return its location.
+  Stringpool::Key
+  add_string(const Char_type* s, size_t len, bool concurrent,
+	     size_t* position)
+  {
+    Stringpool::Key key;
+    if (!concurrent)
+      this->stringpool_.add_with_length(s, len, true, &key);
+    else
+      {
+	size_t hash_code = gold::string_hash<Char_type>(s, len);
+	this->stringpool_.add_in_order_with_length(s, len, hash_code, true,
+						   *position, &key);
+	++*position;
+      }
+    return key;
+  }
+
+  // Add the strings in PDATA, of size LEN, to the Stringpool and to
+  // MERGED_STRINGS_LIST.
+  void
+  add_strings(Merged_strings_list* merged_strings_list,
+	      const unsigned char* pdata, section_size_type len);
+
+  // Add the mappings for the strings in MERGED_STRINGS_LIST.
+  void
+  map_strings(const Merged_strings_list* merged_strings_list);
+
   // As we see the strings, we add them to a Stringpool.
   Stringpool_template<Char_type> stringpool_;
   // Map from a location in an input object to an entry in the
@@ -567,6 +713,10 @@ class Output_merge_string : public Output_merge_base
   size_t input_count_;
   // The total size of input sections.
   size_t input_size_;
+  // The number of strings in the deferred input sections.
+  size_t deferred_count_;
+  // Whether the deferred input sections have been added.
+  bool deferred_inputs_done_;
 };
 
 } // End namespace gold.
@@ -61,6 +61,8 @@ Read_symbols_data::~Read_symbols_data()
     delete this->symbols;
   if (this->symbol_names != NULL)
     delete this->symbol_names;
+  if (this->global_symbol_names != NULL)
+    delete this->global_symbol_names;
   if (this->versym != NULL)
     delete this->versym;
   if (this->verdef != NULL)
@@ -769,6 +771,7 @@ Sized_relobj_file<size, big_endian>::do_read_symbols(Read_symbols_data* sd)
   sd->external_symbols_offset = 0;
   sd->symbol_names = NULL;
   sd->symbol_names_size = 0;
+  sd->global_symbol_names = NULL;
 
   if (this->symtab_shndx_ == 0)
     {
@@ -837,6 +840,36 @@ Sized_relobj_file<size, big_endian>::do_read_symbols(Read_symbols_data* sd)
   sd->symbol_names = fvstrtab;
   sd->symbol_names_size =
     convert_to_section_size_type(strtabshdr.get_sh_size());
+
+  // When using threads, the input files are read in parallel but
+  // their symbols are added one at a time, so find the length and
+  // hash code of each global symbol name now.
+  if (parameters->options().threads())
+    {
+      const unsigned char* p = (fvsymtab->data()
+				+ sd->external_symbols_offset);
+      const char* names = reinterpret_cast<const char*>(fvstrtab->data());
+      size_t count = extsize / sym_size;
+      std::vector<Global_symbol_name>* gnames =
+	new std::vector<Global_symbol_name>(count);
+      for (size_t i = 0; i < count; ++i, p += sym_size)
+	{
+	  elfcpp::Sym<size, big_endian> sym(p);
+	  unsigned int st_name = sym.get_st_name();
+	  if (st_name >= sd->symbol_names_size)
+	    {
+	      // add_from_relobj will report the error.
+	      (*gnames)[i].length = 0;
+	      (*gnames)[i].hash_code = 0;
+	      continue;
+	    }
+	  const char* name = names + st_name;
+	  size_t len = strcspn(name, "@");
+	  (*gnames)[i].length = len;
+	  (*gnames)[i].hash_code = gold::string_hash<char>(name, len);
+	}
+      sd->global_symbol_names = gnames;
+    }
 }
 
 // Return the section index of symbol SYM.  Set *VALUE to its value in
@@ -1936,6 +1969,7 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
 			  sd->symbols->data() + sd->external_symbols_offset,
 			  symcount, this->local_symbol_count_,
 			  sym_names, sd->symbol_names_size,
+			  sd->global_symbol_names,
 			  &this->symbols_,
 			  &this->defined_count_);
 
@@ -1943,6 +1977,8 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
   sd->symbols = NULL;
   delete sd->symbol_names;
   sd->symbol_names = NULL;
+  delete sd->global_symbol_names;
+  sd->global_symbol_names = NULL;
 }
 
 // Find out if this object, that is a member of a lib group, should be included
@@ -2062,14 +2098,16 @@ Sized_relobj_file<size, big_endian>::set_local_plt_offset(
 
 // First pass over the local symbols.  Here we add their names to
 // *POOL and *DYNPOOL, and we store the symbol value in
-// THIS->LOCAL_VALUES_.  This function is always called from a
-// singleton thread.  This is followed by a call to
+// THIS->LOCAL_VALUES_.  The pools may be shared with threads counting
+// the local symbols of other objects; the name of symbol I is put at
+// POSITION + I in their order.  This is followed by a call to
 // finalize_local_symbols.
 
 template<int size, bool big_endian>
 void
 Sized_relobj_file<size, big_endian>::do_count_local_symbols(Stringpool* pool,
-							    Stringpool* dynpool)
+							    Stringpool* dynpool,
+							    size_t position)
 {
   gold_assert(this->symtab_shndx_ != -1U);
   if (this->symtab_shndx_ == 0)
@@ -2165,7 +2203,7 @@ Sized_relobj_file<size, big_endian>::do_count_local_symbols(Stringpool* pool,
       // If needed, add the symbol to the dynamic symbol table string pool.
       if (lv.needs_output_dynsym_entry())
 	{
-	  dynpool->add(name, true, NULL);
+	  dynpool->add_in_order(name, true, position + i);
 	  ++dyncount;
 	}
 
@@ -2207,7 +2245,7 @@ Sized_relobj_file<size, big_endian>::do_count_local_symbols(Stringpool* pool,
 	}
 
       // Add the symbol to the symbol table string pool.
-      pool->add(name, true, NULL);
+      pool->add_in_order(name, true, position + i);
       ++count;
     }
 
@@ -2995,10 +3033,20 @@ Input_objects::print_cref(const Symbol_table* symtab, FILE* f) const
 // and lineno information is not available.  This is only used in
 // error messages.
 
+// A lock for reading the object file while reporting relocations.
+// The sections of a single object may be relocated by several
+// threads, and the object's File_read is not safe to use from more
+// than one of them at a time.
+static Lock* relocate_info_lock = NULL;
+static Initialize_lock relocate_info_initialize_lock(&relocate_info_lock);
+
 template<int size, bool big_endian>
 std::string
 Relocate_info<size, big_endian>::location(size_t, off_t offset) const
 {
+  relocate_info_initialize_lock.initialize();
+  Hold_optional_lock hl(relocate_info_lock);
+
   Sized_dwarf_line_info<size, big_endian> line_info(this->object);
   std::string ret = line_info.addr2line(this->data_shndx, offset, NULL);
   if (!ret.empty())
@@ -3029,6 +3077,17 @@ Relocate_info<size, big_endian>::location(size_t, off_t offset) const
   return ret;
 }
 
+// Return the name of the data section.
+
+template<int size, bool big_endian>
+std::string
+Relocate_info<size, big_endian>::data_section_name() const
+{
+  relocate_info_initialize_lock.initialize();
+  Hold_optional_lock hl(relocate_info_lock);
+  return this->object->section_name(this->data_shndx);
+}
+
 } // End namespace gold.
 
 namespace
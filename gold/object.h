@@ -38,6 +38,7 @@ namespace gold
 
 class General_options;
 class Task;
+class Workqueue;
 class Cref;
 class Layout;
 class Output_data;
@@ -53,13 +54,25 @@ struct Symbols_data;
 template<typename Stringpool_char>
 class Stringpool_template;
 
+// The name of a global symbol, split from any version and hashed
+// when the symbols are read.
+
+struct Global_symbol_name
+{
+  // Length of the name, up to any '@' introducing a version.
+  size_t length;
+  // The hash code of the name, as computed by gold::string_hash.
+  size_t hash_code;
+};
+
 // Data to pass from read_symbols() to add_symbols().
 
 struct Read_symbols_data
 {
   Read_symbols_data()
     : section_headers(NULL), section_names(NULL), symbols(NULL),
-      symbol_names(NULL), versym(NULL), verdef(NULL), verneed(NULL)
+      symbol_names(NULL), global_symbol_names(NULL), versym(NULL),
+      verdef(NULL), verneed(NULL)
   { }
 
   ~Read_symbols_data();
@@ -82,6 +95,11 @@ struct Read_symbols_data
   File_view* symbol_names;
   // Size of symbol name data in bytes.
   section_size_type symbol_names_size;
+  // The names of the external symbols, one entry for each symbol.
+  // These are only computed when using threads, so that the work is
+  // done by the parallel Read_symbols tasks rather than while adding
+  // the symbols in command line order.  This may be NULL.
+  std::vector<Global_symbol_name>* global_symbol_names;
 
   // Version information.  This is only used on dynamic objects.
   // Version symbol data (from SHT_GNU_versym section).
@@ -1123,11 +1141,13 @@ class Relobj : public Object
 
   // Initial local symbol processing: count the number of local symbols
   // in the output symbol table and dynamic symbol table; add local symbol
-  // names to *POOL and *DYNPOOL.
+  // names to *POOL and *DYNPOOL.  The name of local symbol I goes at
+  // POSITION + I in the current batch of ordered adds to the pools;
+  // see Stringpool_template::add_in_order.
   void
   count_local_symbols(Stringpool_template<char>* pool,
-                      Stringpool_template<char>* dynpool)
-  { return this->do_count_local_symbols(pool, dynpool); }
+                      Stringpool_template<char>* dynpool, size_t position)
+  { return this->do_count_local_symbols(pool, dynpool, position); }
 
   // Set the values of the local symbols, set the output symbol table
   // indexes for the local variables, and set the offset where local
@@ -1166,9 +1186,11 @@ class Relobj : public Object
   { return this->dyn_reloc_count_; }
 
   // Relocate the input sections and write out the local symbols.
+  // WORKQUEUE may be used to relocate several sections at once.
   void
-  relocate(const Symbol_table* symtab, const Layout* layout, Output_file* of)
-  { return this->do_relocate(symtab, layout, of); }
+  relocate(const Symbol_table* symtab, const Layout* layout, Output_file* of,
+	   Workqueue* workqueue)
+  { return this->do_relocate(symtab, layout, of, workqueue); }
 
   // Return whether an input section is being included in the link.
   bool
@@ -1315,7 +1337,7 @@ class Relobj : public Object
   // Count local symbols--implemented by child class.
   virtual void
   do_count_local_symbols(Stringpool_template<char>*,
-			 Stringpool_template<char>*) = 0;
+			 Stringpool_template<char>*, size_t) = 0;
 
   // Finalize the local symbols.  Set the output symbol table indexes
   // for the local variables, and set the offset where local symbol
@@ -1334,7 +1356,8 @@ class Relobj : public Object
   // Relocate the input sections and write out the local
   // symbols--implemented by child class.
   virtual void
-  do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of) = 0;
+  do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of,
+	      Workqueue*) = 0;
 
   // Set the offset of a section--implemented by child class.
   virtual void
@@ -2286,7 +2309,7 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   // Count the local symbols.
   void
   do_count_local_symbols(Stringpool_template<char>*,
-                            Stringpool_template<char>*);
+                            Stringpool_template<char>*, size_t);
 
   // Finalize the local symbols.
   unsigned int
@@ -2302,7 +2325,8 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
 
   // Relocate the input sections and write out the local symbols.
   void
-  do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of);
+  do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of,
+	      Workqueue*);
 
   // Get the size of a section.
   uint64_t
@@ -2432,7 +2456,7 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   virtual void
   do_relocate_sections(const Symbol_table* symtab, const Layout* layout,
 		       const unsigned char* pshdrs, Output_file* of,
-		       Views* pviews);
+		       Views* pviews, Workqueue* workqueue);
 
   // Adjust this local symbol value.  Return false if the symbol
   // should be discarded from the output file.
@@ -2550,8 +2574,11 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   relocate_sections(const Symbol_table* symtab, const Layout* layout,
 		    const unsigned char* pshdrs, Output_file* of,
-		    Views* pviews)
-  { this->do_relocate_sections(symtab, layout, pshdrs, of, pviews); }
+		    Views* pviews, Workqueue* workqueue)
+  {
+    this->do_relocate_sections(symtab, layout, pshdrs, of, pviews,
+			       workqueue);
+  }
 
   // Reverse the words in a section.  Used for .ctors sections mapped
   // to .init_array sections.
@@ -2867,6 +2894,12 @@ struct Relocate_info
   // only used for error messages.
   std::string
   location(size_t relnum, off_t reloffset) const;
+
+  // Return the name of the data section.  Like location, this reads
+  // the object file, and holds a lock while doing so since the
+  // sections of an object may be relocated in parallel.
+  std::string
+  data_section_name() const;
 };
 
 // This is used to represent a section in an object and is used as the
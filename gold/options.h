@@ -938,6 +938,12 @@ class General_options
 	      N_("Map the output file for writing (default)."),
 	      N_("Do not map the output file for writing."));
 
+  DEFINE_enum(io_hints, options::TWO_DASHES, '\0', "none",
+	      N_("Give the kernel access hints for the input files, "
+		 "the output file, or both"),
+	      N_("[none,input,output,all]"),
+	      {"none", "input", "output", "all"});
+
   DEFINE_bool(print_map, options::TWO_DASHES, 'M', false,
 	      N_("Write map file on standard output"), NULL);
   DEFINE_string(Map, options::ONE_DASH, '\0', NULL, N_("Write map file"),
@@ -1138,6 +1144,11 @@ class General_options
   DEFINE_bool(trace, options::TWO_DASHES, 't', false,
 	      N_("Print the name of each input file"), NULL);
 
+  DEFINE_string(trace_tasks, options::TWO_DASHES, '\0', NULL,
+		N_("Write a timeline of the linker tasks to FILE in "
+		   "Chrome trace format"),
+		N_("FILE"));
+
   DEFINE_special(script, options::TWO_DASHES, 'T',
 		 N_("Read linker script"), N_("FILE"));
 
@@ -1335,6 +1346,15 @@ class General_options
   // any problems.
   void finalize();
 
+  // Set the threading options.  This is for programs other than the
+  // linker, such as dwp, which parse their own command line.
+  void
+  set_threading(bool threads, int thread_count)
+  {
+    this->set_threads(threads);
+    this->set_thread_count(thread_count);
+  }
+
   // True if we printed the version information.
   bool
   printed_version() const
@@ -1408,6 +1428,22 @@ class General_options
   is_stack_executable() const
   { return this->execstack_status_ == EXECSTACK_YES; }
 
+  // Whether --io-hints asks for access hints on the input files.
+  bool
+  io_hints_input() const
+  {
+    return (strcmp(this->io_hints(), "input") == 0
+	    || strcmp(this->io_hints(), "all") == 0);
+  }
+
+  // Whether --io-hints asks for access hints on the output file.
+  bool
+  io_hints_output() const
+  {
+    return (strcmp(this->io_hints(), "output") == 0
+	    || strcmp(this->io_hints(), "all") == 0);
+  }
+
   bool
   icf_enabled() const
   { return this->icf_status_ != ICF_NONE; }
@@ -4055,6 +4055,19 @@ Output_section::print_merge_stats()
     p->print_merge_stats(this->name_);
 }
 
+// Add the merge sections to MERGE_SECTIONS.
+
+void
+Output_section::get_merge_sections(
+    std::vector<Output_merge_base*>* merge_sections) const
+{
+  for (Input_section_list::const_iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    if (p->is_merge_section())
+      merge_sections->push_back(p->output_merge_base());
+}
+
 // Set a fixed layout for the section.  Used for incremental update links.
 
 void
@@ -5131,6 +5144,28 @@ Output_file::resize(off_t file_size)
     }
 }
 
+// With --io-hints, ask for transparent huge pages when mapping an
+// output file at least this large.
+
+static const off_t huge_page_min_file_size = 32 << 20;
+
+// Give the kernel hints about the mapping of the output file at BASE
+// of SIZE bytes.  These are only hints, so ignore any error.
+
+static void
+advise_output_map(void* base, off_t size)
+{
+#ifdef MADV_HUGEPAGE
+  if (parameters->options_valid()
+      && parameters->options().io_hints_output()
+      && size >= huge_page_min_file_size)
+    ::madvise(base, size, MADV_HUGEPAGE);
+#else
+  (void) base;
+  (void) size;
+#endif
+}
+
 // Map an anonymous block of memory which will later be written to the
 // file.  Return whether the map succeeded.
 
@@ -5147,6 +5182,8 @@ Output_file::map_anonymous()
       memset(base, 0, this->file_size_);
       this->map_is_allocated_ = true;
     }
+  else
+    advise_output_map(base, this->file_size_);
   this->base_ = static_cast<unsigned char*>(base);
   this->map_is_anonymous_ = true;
   return true;
@@ -5185,11 +5222,17 @@ Output_file::map_no_anonymous(bool writable)
        gold_fatal(_("%s: %s"), this->name_, strerror(err));
     }
 
-  // Map the file into memory.
+  // Map the file into memory.  With --io-hints, fault in the whole
+  // mapping now, rather than one page at a time as we write it.
   int prot = PROT_READ;
   if (writable)
     prot |= PROT_WRITE;
-  base = ::mmap(NULL, this->file_size_, prot, MAP_SHARED, o, 0);
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  if (writable && parameters->options().io_hints_output())
+    flags |= MAP_POPULATE;
+#endif
+  base = ::mmap(NULL, this->file_size_, prot, flags, o, 0);
 
   // The mmap call might fail because of file system issues: the file
   // system might not support mmap at all, or it might not support
@@ -5197,6 +5240,8 @@ Output_file::map_no_anonymous(bool writable)
   if (base == MAP_FAILED)
     return false;
 
+  advise_output_map(base, this->file_size_);
+
   this->map_is_anonymous_ = false;
   this->base_ = static_cast<unsigned char*>(base);
   return true;
@@ -3907,6 +3907,10 @@ class Output_section : public Output_data
   void
   print_merge_stats();
 
+  // Add the merge sections of this output section to MERGE_SECTIONS.
+  void
+  get_merge_sections(std::vector<Output_merge_base*>* merge_sections) const;
+
   // Set a fixed layout for the section.  Used for incremental update links.
   void
   set_fixed_layout(uint64_t sh_addr, off_t sh_offset, off_t sh_size,
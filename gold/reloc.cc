@@ -234,9 +234,9 @@ Relocate_task::locks(Task_locker* tl)
 // Run the task.
 
 void
-Relocate_task::run(Workqueue*)
+Relocate_task::run(Workqueue* workqueue)
 {
-  this->object_->relocate(this->symtab_, this->layout_, this->of_);
+  this->object_->relocate(this->symtab_, this->layout_, this->of_, workqueue);
 
   // This is normally the last thing we will do with an object, so
   // uncache all views.
@@ -253,6 +253,65 @@ Relocate_task::get_name() const
   return "Relocate_task " + this->object_->name();
 }
 
+// The relocation sections of an object which are to be relocated in
+// parallel.  Each job relocates one section by calling
+// relocate_section with the arguments recorded here.
+
+template<int size, bool big_endian>
+class Sized_relocate_sections_work : public Parallel_work
+{
+ public:
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+
+  // The arguments for relocating one section.
+  struct Section
+  {
+    Relocate_info<size, big_endian> relinfo;
+    unsigned int sh_type;
+    const unsigned char* prelocs;
+    size_t reloc_count;
+    Output_section* output_section;
+    bool needs_special_offset_handling;
+    unsigned char* view;
+    Address address;
+    section_size_type view_size;
+  };
+
+  typedef std::vector<Section> Sections;
+
+  // SECTIONS is cleared.
+  Sized_relocate_sections_work(Sized_target<size, big_endian>* target,
+			       Sections* sections, const std::string& name)
+    : Parallel_work(sections->size(), name), target_(target), sections_()
+  { this->sections_.swap(*sections); }
+
+ protected:
+  void
+  do_run(size_t i, const Task*)
+  {
+    const Section& s(this->sections_[i]);
+    this->target_->relocate_section(&s.relinfo, s.sh_type, s.prelocs,
+				    s.reloc_count, s.output_section,
+				    s.needs_special_offset_handling, s.view,
+				    s.address, s.view_size, NULL);
+  }
+
+ private:
+  Sized_target<size, big_endian>* target_;
+  Sections sections_;
+};
+
+// An object needs at least this many relocations in at least two
+// sections before its sections are relocated in parallel; for fewer,
+// the cost of the helper tasks outweighs the gain.
+
+static const size_t parallel_relocate_min_relocs = 4096;
+
+// The most helper tasks to queue for a single object when the
+// --thread-count-final option does not say how many threads to use.
+
+static const size_t parallel_relocate_max_helpers = 8;
+
 // Read the relocs and local symbols from the object file and store
 // the information in RD.
 
@@ -352,6 +411,7 @@ Sized_relobj_file<size, big_endian>::do_read_relocs(Read_relocs_data* rd)
       sr.data_shndx = shndx;
       sr.contents = this->get_lasting_view(shdr.get_sh_offset(), sh_size,
 					   true, true);
+      File_read::advise_sequential(sr.contents->data(), sh_size);
       sr.sh_type = sh_type;
       sr.reloc_count = reloc_count;
       sr.output_section = os;
@@ -643,7 +703,8 @@ template<int size, bool big_endian>
 void
 Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
 						 const Layout* layout,
-						 Output_file* of)
+						 Output_file* of,
+						 Workqueue* workqueue)
 {
   unsigned int shnum = this->shnum();
 
@@ -667,7 +728,7 @@ Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
 
   // Apply relocations.
 
-  this->relocate_sections(symtab, layout, pshdrs, of, &views);
+  this->relocate_sections(symtab, layout, pshdrs, of, &views, workqueue);
 
   // After we've done the relocations, we release the hash tables,
   // since we no longer need them.
@@ -906,7 +967,8 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
     const Layout* layout,
     const unsigned char* pshdrs,
     Output_file* of,
-    Views* pviews)
+    Views* pviews,
+    Workqueue* workqueue)
 {
   unsigned int shnum = this->shnum();
   Sized_target<size, big_endian>* target =
@@ -920,6 +982,20 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
   relinfo.layout = layout;
   relinfo.object = this;
 
+  // When using threads, the sections of a large object may be
+  // relocated by several tasks at once.  While in this loop, we only
+  // record the arguments for such sections.
+  const bool parallel = (workqueue != NULL
+			 && parameters->options().threads()
+			 && target->can_relocate_sections_in_parallel()
+			 && !parameters->options().relocatable()
+			 && !parameters->options().emit_relocs()
+			 && !parameters->incremental()
+			 && !this->uses_split_stack());
+  typedef Sized_relocate_sections_work<size, big_endian> Work;
+  typename Work::Sections sections;
+  size_t total_reloc_count = 0;
+
   const unsigned char* p = pshdrs + This::shdr_size;
   for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
     {
@@ -1008,7 +1084,23 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
 				     &reloc_map);
 	}
 
-      if (!parameters->options().relocatable())
+      if (parallel)
+	{
+	  typename Work::Section section;
+	  section.relinfo = relinfo;
+	  section.sh_type = sh_type;
+	  section.prelocs = prelocs;
+	  section.reloc_count = reloc_count;
+	  section.output_section = os;
+	  section.needs_special_offset_handling =
+	    output_offset == invalid_address;
+	  section.view = view;
+	  section.address = address;
+	  section.view_size = view_size;
+	  sections.push_back(section);
+	  total_reloc_count += reloc_count;
+	}
+      else if (!parameters->options().relocatable())
 	{
 	  target->relocate_section(&relinfo, sh_type, prelocs, reloc_count, os,
 				   output_offset == invalid_address,
@@ -1036,6 +1128,37 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
 				  (*pviews)[i].view_size);
 	}
     }
+
+  if (sections.empty())
+    return;
+
+  if (sections.size() < 2 || total_reloc_count < parallel_relocate_min_relocs)
+    {
+      for (typename Work::Sections::const_iterator ps = sections.begin();
+	   ps != sections.end();
+	   ++ps)
+	target->relocate_section(&ps->relinfo, ps->sh_type, ps->prelocs,
+				 ps->reloc_count, ps->output_section,
+				 ps->needs_special_offset_handling, ps->view,
+				 ps->address, ps->view_size, NULL);
+      return;
+    }
+
+  // Looking up a merged section offset sorts the mappings of the
+  // section on first use, so sort them all before other tasks can
+  // look them up.
+  if (this->merge_map() != NULL)
+    this->merge_map()->sort_input_merge_maps();
+
+  size_t helpers = sections.size() - 1;
+  size_t thread_count = parameters->options().thread_count_final();
+  if (thread_count == 0)
+    helpers = std::min(helpers, parallel_relocate_max_helpers);
+  else
+    helpers = std::min(helpers, thread_count - 1);
+
+  Work* work = new Work(target, &sections, this->name());
+  work->run(workqueue, NULL, helpers);
 }
 
 // Write the incremental relocs.
@@ -1695,7 +1818,8 @@ template
 void
 Sized_relobj_file<32, false>::do_relocate(const Symbol_table* symtab,
 					  const Layout* layout,
-					  Output_file* of);
+					  Output_file* of,
+					  Workqueue* workqueue);
 #endif
 
 #ifdef HAVE_TARGET_32_BIG
@@ -1703,7 +1827,8 @@ template
 void
 Sized_relobj_file<32, true>::do_relocate(const Symbol_table* symtab,
 					 const Layout* layout,
-					 Output_file* of);
+					 Output_file* of,
+					 Workqueue* workqueue);
 #endif
 
 #ifdef HAVE_TARGET_64_LITTLE
@@ -1711,7 +1836,8 @@ template
 void
 Sized_relobj_file<64, false>::do_relocate(const Symbol_table* symtab,
 					  const Layout* layout,
-					  Output_file* of);
+					  Output_file* of,
+					  Workqueue* workqueue);
 #endif
 
 #ifdef HAVE_TARGET_64_BIG
@@ -1719,7 +1845,8 @@ template
 void
 Sized_relobj_file<64, true>::do_relocate(const Symbol_table* symtab,
 					 const Layout* layout,
-					 Output_file* of);
+					 Output_file* of,
+					 Workqueue* workqueue);
 #endif
 
 #ifdef HAVE_TARGET_32_LITTLE
@@ -1730,7 +1857,8 @@ Sized_relobj_file<32, false>::do_relocate_sections(
     const Layout* layout,
     const unsigned char* pshdrs,
     Output_file* of,
-    Views* pviews);
+    Views* pviews,
+    Workqueue* workqueue);
 #endif
 
 #ifdef HAVE_TARGET_32_BIG
@@ -1741,7 +1869,8 @@ Sized_relobj_file<32, true>::do_relocate_sections(
     const Layout* layout,
     const unsigned char* pshdrs,
     Output_file* of,
-    Views* pviews);
+    Views* pviews,
+    Workqueue* workqueue);
 #endif
 
 #ifdef HAVE_TARGET_64_LITTLE
@@ -1752,7 +1881,8 @@ Sized_relobj_file<64, false>::do_relocate_sections(
     const Layout* layout,
     const unsigned char* pshdrs,
     Output_file* of,
-    Views* pviews);
+    Views* pviews,
+    Workqueue* workqueue);
 #endif
 
 #ifdef HAVE_TARGET_64_BIG
@@ -1763,7 +1893,8 @@ Sized_relobj_file<64, true>::do_relocate_sections(
     const Layout* layout,
     const unsigned char* pshdrs,
     Output_file* of,
-    Views* pviews);
+    Views* pviews,
+    Workqueue* workqueue);
 #endif
 
 #ifdef HAVE_TARGET_32_LITTLE
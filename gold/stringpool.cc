@@ -28,6 +28,7 @@
 
 #include "output.h"
 #include "parameters.h"
+#include "gold-threads.h"
 #include "stringpool.h"
 
 namespace gold
@@ -37,7 +38,8 @@ template<typename Stringpool_char>
 Stringpool_template<Stringpool_char>::Stringpool_template(uint64_t addralign)
   : string_set_(), key_to_offset_(), strings_(), strtab_size_(0),
     zero_null_(true), optimize_(false), offset_(sizeof(Stringpool_char)),
-    addralign_(addralign)
+    addralign_(addralign), shards_(NULL), next_order_(0), batch_order_(0),
+    batch_count_(0)
 {
   if (parameters->options_valid() && parameters->options().optimize() >= 2)
     this->optimize_ = true;
@@ -54,12 +56,47 @@ Stringpool_template<Stringpool_char>::clear()
   this->strings_.clear();
   this->key_to_offset_.clear();
   this->string_set_.clear();
+
+  if (this->shards_ != NULL)
+    {
+      for (unsigned int i = 0; i < shard_count; ++i)
+	{
+	  Shard* shard = &this->shards_[i];
+	  for (typename Stringdata_list::iterator p = shard->strings.begin();
+	       p != shard->strings.end();
+	       ++p)
+	    delete[] reinterpret_cast<char*>(*p);
+	  shard->strings.clear();
+	  shard->entries.clear();
+	  shard->string_set.clear();
+	}
+      this->next_order_ = 0;
+      this->batch_count_ = 0;
+    }
 }
 
 template<typename Stringpool_char>
 Stringpool_template<Stringpool_char>::~Stringpool_template()
 {
   this->clear();
+  if (this->shards_ != NULL)
+    {
+      for (unsigned int i = 0; i < shard_count; ++i)
+	delete this->shards_[i].lock;
+      delete[] this->shards_;
+    }
+}
+
+// Make the pool concurrent.
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::set_concurrent()
+{
+  gold_assert(this->shards_ == NULL && this->string_set_.empty());
+  this->shards_ = new Shard[shard_count];
+  for (unsigned int i = 0; i < shard_count; ++i)
+    this->shards_[i].lock = new Lock;
 }
 
 // Resize the internal hashtable with the expectation we'll get n new
@@ -71,21 +108,30 @@ template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::reserve(unsigned int n)
 {
-  this->key_to_offset_.reserve(n);
+  if (this->shards_ == NULL)
+    this->key_to_offset_.reserve(n);
+  else
+    n = n / shard_count + 1;
+
+  unsigned int count = this->string_set_count();
+  for (unsigned int i = 0; i < count; ++i)
+    {
+      String_set_type* string_set = this->string_set(i);
 
 #if defined(HAVE_TR1_UNORDERED_MAP)
-  // rehash() implementation is broken in gcc 4.0.3's stl
-  //this->string_set_.rehash(this->string_set_.size() + n);
-  //return;
+      // rehash() implementation is broken in gcc 4.0.3's stl
+      //string_set->rehash(string_set->size() + n);
+      //continue;
 #elif defined(HAVE_EXT_HASH_MAP)
-  this->string_set_.resize(this->string_set_.size() + n);
-  return;
+      string_set->resize(string_set->size() + n);
+      continue;
 #endif
 
-  // This is the generic "reserve" code, if no #ifdef above triggers.
-  String_set_type new_string_set(this->string_set_.size() + n);
-  new_string_set.insert(this->string_set_.begin(), this->string_set_.end());
-  this->string_set_.swap(new_string_set);
+      // This is the generic "reserve" code, if no #ifdef above triggers.
+      String_set_type new_string_set(string_set->size() + n);
+      new_string_set.insert(string_set->begin(), string_set->end());
+      string_set->swap(new_string_set);
+    }
 }
 
 // Compare two strings of arbitrary character type for equality.
@@ -135,14 +181,14 @@ Stringpool_template<Stringpool_char>::string_hash(const Stringpool_char* s,
   return gold::string_hash<Stringpool_char>(s, length);
 }
 
-// Add the string S to the list of canonical strings.  Return a
-// pointer to the canonical string.  If PKEY is not NULL, set *PKEY to
-// the key.  LENGTH is the length of S in characters.  Note that S may
-// not be NUL terminated.
+// Add the string S to the list of canonical strings STRINGS.  Return
+// a pointer to the canonical string.  LENGTH is the length of S in
+// characters.  Note that S may not be NUL terminated.
 
 template<typename Stringpool_char>
 const Stringpool_char*
-Stringpool_template<Stringpool_char>::add_string(const Stringpool_char* s,
+Stringpool_template<Stringpool_char>::add_string(Stringdata_list* strings,
+						 const Stringpool_char* s,
 						 size_t len)
 {
   // We are in trouble if we've already computed the string offsets.
@@ -166,11 +212,11 @@ Stringpool_template<Stringpool_char>::add_string(const Stringpool_char* s,
       alc = sizeof(Stringdata) + len;
       front = false;
     }
-  else if (this->strings_.empty())
+  else if (strings->empty())
     alc = sizeof(Stringdata) + buffer_size;
   else
     {
-      Stringdata* psd = this->strings_.front();
+      Stringdata* psd = strings->front();
       if (len > psd->alc - psd->len)
 	alc = sizeof(Stringdata) + buffer_size;
       else
@@ -194,9 +240,9 @@ Stringpool_template<Stringpool_char>::add_string(const Stringpool_char* s,
   psd->len = len;
 
   if (front)
-    this->strings_.push_front(psd);
+    strings->push_front(psd);
   else
-    this->strings_.push_back(psd);
+    strings->push_back(psd);
 
   return reinterpret_cast<const Stringpool_char*>(psd->data);
 }
@@ -237,9 +283,28 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
 						      size_t length,
 						      bool copy,
 						      Key* pkey)
+{
+  return this->add_prehashed(s, length, string_hash(s, length), copy, pkey);
+}
+
+template<typename Stringpool_char>
+const Stringpool_char*
+Stringpool_template<Stringpool_char>::add_prehashed(const Stringpool_char* s,
+						    size_t length,
+						    size_t hash_code,
+						    bool copy,
+						    Key* pkey)
 {
   typedef std::pair<typename String_set_type::iterator, bool> Insert_type;
 
+  if (this->shards_ != NULL)
+    {
+      const Key order = this->next_order_;
+      ++this->next_order_;
+      return this->add_to_shard(s, length, hash_code, copy, order, pkey,
+					NULL);
+    }
+
   // We add 1 so that 0 is always invalid.
   const Key k = this->key_to_offset_.size() + 1;
 
@@ -248,7 +313,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
       // When we don't need to copy the string, we can call insert
       // directly.
 
-      std::pair<Hashkey, Hashval> element(Hashkey(s, length), k);
+      std::pair<Hashkey, Hashval> element(Hashkey(s, length, hash_code), k);
 
       Insert_type ins = this->string_set_.insert(element);
 
@@ -275,7 +340,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   // canonicalize it by copying it into the canonical list. The hash
   // code will only be computed once.
 
-  Hashkey hk(s, length);
+  Hashkey hk(s, length, hash_code);
   typename String_set_type::const_iterator p = this->string_set_.find(hk);
   if (p != this->string_set_.end())
     {
@@ -286,7 +351,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
 
   this->new_key_offset(length);
 
-  hk.string = this->add_string(s, length);
+  hk.string = this->add_string(&this->strings_, s, length);
   // The contents of the string stay the same, so we don't need to
   // adjust hk.hash_code or hk.length.
 
@@ -300,12 +365,130 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   return hk.string;
 }
 
+// Start a batch of strings which may be added at once.
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::begin_ordered_adds(size_t count)
+{
+  if (this->shards_ == NULL)
+    return;
+  this->batch_order_ = this->next_order_;
+  this->batch_count_ = count;
+  this->next_order_ += count;
+}
+
+// Add a string at a position in the current batch.
+
+template<typename Stringpool_char>
+const Stringpool_char*
+Stringpool_template<Stringpool_char>::add_in_order(const Stringpool_char* s,
+						   bool copy,
+						   size_t position)
+{
+  if (this->shards_ == NULL)
+    return this->add(s, copy, NULL);
+  gold_assert(position < this->batch_count_);
+  const size_t length = string_length(s);
+  return this->add_to_shard(s, length, string_hash(s, length), copy,
+			    this->batch_order_ + position, NULL, NULL);
+}
+
+// Add a string with a known length and hash code at a position in the
+// current batch.
+
+template<typename Stringpool_char>
+const Stringpool_char*
+Stringpool_template<Stringpool_char>::add_in_order_with_length(
+    const Stringpool_char* s,
+    size_t length,
+    size_t hash_code,
+    bool copy,
+    size_t position,
+    Key* plocation)
+{
+  if (this->shards_ == NULL)
+    return this->add_prehashed(s, length, hash_code, copy, plocation);
+  gold_assert(position < this->batch_count_);
+  return this->add_to_shard(s, length, hash_code, copy,
+			    this->batch_order_ + position, NULL, plocation);
+}
+
+// Add a string to a concurrent pool.  ORDER is the position of the
+// string in the order of additions.  A string which is already in the
+// pool takes the earlier position.  If PLOCATION is not NULL, this
+// sets *PLOCATION to one more than the index of the string's entry
+// times shard_count plus the index of its shard.
+
+template<typename Stringpool_char>
+const Stringpool_char*
+Stringpool_template<Stringpool_char>::add_to_shard(const Stringpool_char* s,
+						   size_t length,
+						   size_t hash_code,
+						   bool copy,
+						   Key order, Key* pkey,
+						   Key* plocation)
+{
+  // The hash code is computed before taking the lock.
+  Hashkey hk(s, length, hash_code);
+  Shard* shard = this->shard_for(hk.hash_code);
+  Hold_lock hl(*shard->lock);
+
+  gold_assert(this->strtab_size_ == 0);
+
+  typename String_set_type::const_iterator p = shard->string_set.find(hk);
+  if (p != shard->string_set.end())
+    {
+      Shard_entry& entry(shard->entries[p->second]);
+      if (order < entry.order)
+	entry.order = order;
+      if (pkey != NULL)
+	*pkey = entry.order + 1;
+      if (plocation != NULL)
+	*plocation = p->second * shard_count + (shard - this->shards_) + 1;
+      return p->first.string;
+    }
+
+  if (copy)
+    hk.string = this->add_string(&shard->strings, s, length);
+
+  Shard_entry entry;
+  entry.order = order;
+  entry.length = length;
+  entry.offset = -1;
+  std::pair<Hashkey, Hashval> element(hk, shard->entries.size());
+  shard->entries.push_back(entry);
+
+  std::pair<typename String_set_type::iterator, bool> ins =
+    shard->string_set.insert(element);
+  gold_assert(ins.second);
+
+  if (pkey != NULL)
+    *pkey = order + 1;
+  if (plocation != NULL)
+    *plocation = element.second * shard_count + (shard - this->shards_) + 1;
+  return hk.string;
+}
+
 template<typename Stringpool_char>
 const Stringpool_char*
 Stringpool_template<Stringpool_char>::find(const Stringpool_char* s,
 					   Key* pkey) const
 {
   Hashkey hk(s);
+
+  if (this->shards_ != NULL)
+    {
+      Shard* shard = this->shard_for(hk.hash_code);
+      Hold_lock hl(*shard->lock);
+      typename String_set_type::const_iterator p = shard->string_set.find(hk);
+      if (p == shard->string_set.end())
+	return NULL;
+      if (pkey != NULL)
+	*pkey = shard->entries[p->second].order + 1;
+      return p->first.string;
+    }
+
   typename String_set_type::const_iterator p = this->string_set_.find(hk);
   if (p == this->string_set_.end())
     return NULL;
@@ -364,6 +547,32 @@ Stringpool_template<Stringpool_char>::is_suffix(const Stringpool_char* s1,
   return memcmp(s1, s2 + len2 - len1, len1 * sizeof(Stringpool_char)) == 0;
 }
 
+// Record the string table offset of a string.
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::set_entry_offset(
+    const typename String_set_type::value_type& p,
+    section_offset_type offset)
+{
+  if (this->shards_ == NULL)
+    this->key_to_offset_[p.second - 1] = offset;
+  else
+    this->shard_for(p.first.hash_code)->entries[p.second].offset = offset;
+}
+
+// Return the string table offset of a string.
+
+template<typename Stringpool_char>
+section_offset_type
+Stringpool_template<Stringpool_char>::entry_offset(
+    const typename String_set_type::value_type& p) const
+{
+  if (this->shards_ == NULL)
+    return this->key_to_offset_[p.second - 1];
+  return this->shard_for(p.first.hash_code)->entries[p.second].offset;
+}
+
 // Turn the stringpool into an ELF strtab: determine the offsets of
 // each string in the table.
 
@@ -387,22 +596,63 @@ Stringpool_template<Stringpool_char>::set_string_offsets()
   // the strtab size, and gives a relatively small benefit (it's
   // typically rare for a symbol to be a suffix of another), we only
   // take the time to sort when the user asks for heavy optimization.
-  if (!this->optimize_)
+  if (!this->optimize_ && this->shards_ == NULL)
     {
       // If we are not optimizing, the offsets are already assigned.
       offset = this->offset_;
     }
+  else if (!this->optimize_)
+    {
+      // Assign the offsets of a concurrent pool in the order the
+      // strings were added, as new_key_offset would have.
+      std::vector<Shard_entry*> by_order(this->next_order_, NULL);
+      for (unsigned int i = 0; i < shard_count; ++i)
+	{
+	  std::vector<Shard_entry>& entries(this->shards_[i].entries);
+	  for (size_t j = 0; j < entries.size(); ++j)
+	    {
+	      gold_assert(entries[j].order < this->next_order_);
+	      by_order[entries[j].order] = &entries[j];
+	    }
+	}
+
+      for (typename std::vector<Shard_entry*>::const_iterator p =
+	     by_order.begin();
+	   p != by_order.end();
+	   ++p)
+	{
+	  Shard_entry* entry = *p;
+	  if (entry == NULL)
+	    continue;
+	  if (this->zero_null_ && entry->length == 0)
+	    entry->offset = 0;
+	  else
+	    {
+	      // Align non-zero length strings.
+	      if (entry->length != 0)
+		offset = align_address(offset, this->addralign_);
+	      entry->offset = offset;
+	      offset += (entry->length + 1) * charsize;
+	    }
+	}
+    }
   else
     {
-      size_t count = this->string_set_.size();
+      size_t count = 0;
+      for (unsigned int i = 0; i < this->string_set_count(); ++i)
+	count += this->string_set(i)->size();
 
       std::vector<Stringpool_sort_info> v;
       v.reserve(count);
 
-      for (typename String_set_type::iterator p = this->string_set_.begin();
-           p != this->string_set_.end();
-           ++p)
-        v.push_back(Stringpool_sort_info(p));
+      for (unsigned int i = 0; i < this->string_set_count(); ++i)
+	{
+	  String_set_type* string_set = this->string_set(i);
+	  for (typename String_set_type::iterator p = string_set->begin();
+	       p != string_set->end();
+	       ++p)
+	    v.push_back(Stringpool_sort_info(p));
+	}
 
       std::sort(v.begin(), v.end(), Stringpool_sort_comparison());
 
@@ -428,7 +678,7 @@ Stringpool_template<Stringpool_char>::set_string_offsets()
               this_offset = align_address(offset, this->addralign_);
               offset = this_offset + ((*curr)->first.length + 1) * charsize;
             }
-	  this->key_to_offset_[(*curr)->second - 1] = this_offset;
+	  this->set_entry_offset(**curr, this_offset);
 	  last_offset = this_offset;
         }
     }
@@ -455,9 +705,12 @@ Stringpool_template<Stringpool_char>::get_offset_with_length(
 {
   gold_assert(this->strtab_size_ != 0);
   Hashkey hk(s, length);
-  typename String_set_type::const_iterator p = this->string_set_.find(hk);
-  if (p != this->string_set_.end())
-    return this->key_to_offset_[p->second - 1];
+  const String_set_type* string_set = (this->shards_ == NULL
+				       ? &this->string_set_
+				       : &this->shard_for(hk.hash_code)->string_set);
+  typename String_set_type::const_iterator p = string_set->find(hk);
+  if (p != string_set->end())
+    return this->entry_offset(*p);
   gold_unreachable();
 }
 
@@ -473,15 +726,19 @@ Stringpool_template<Stringpool_char>::write_to_buffer(
   gold_assert(bufsize >= this->strtab_size_);
   if (this->zero_null_)
     buffer[0] = '\0';
-  for (typename String_set_type::const_iterator p = this->string_set_.begin();
-       p != this->string_set_.end();
-       ++p)
+  for (unsigned int i = 0; i < this->string_set_count(); ++i)
     {
-      const int len = (p->first.length + 1) * sizeof(Stringpool_char);
-      const section_offset_type offset = this->key_to_offset_[p->second - 1];
-      gold_assert(static_cast<section_size_type>(offset) + len
-		  <= this->strtab_size_);
-      memcpy(buffer + offset, p->first.string, len);
+      const String_set_type* string_set = this->string_set(i);
+      for (typename String_set_type::const_iterator p = string_set->begin();
+	   p != string_set->end();
+	   ++p)
+	{
+	  const int len = (p->first.length + 1) * sizeof(Stringpool_char);
+	  const section_offset_type offset = this->entry_offset(*p);
+	  gold_assert(static_cast<section_size_type>(offset) + len
+		      <= this->strtab_size_);
+	  memcpy(buffer + offset, p->first.string, len);
+	}
     }
 }
 
@@ -503,16 +760,27 @@ template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::print_stats(const char* name) const
 {
+  size_t entries = 0;
+  size_t buckets = 0;
+  size_t stringdata = this->strings_.size();
+  for (unsigned int i = 0; i < this->string_set_count(); ++i)
+    {
+      entries += this->string_set(i)->size();
+#if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+      buckets += this->string_set(i)->bucket_count();
+#endif
+      if (this->shards_ != NULL)
+	stringdata += this->shards_[i].strings.size();
+    }
 #if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
   fprintf(stderr, _("%s: %s entries: %zu; buckets: %zu\n"),
-	  program_name, name, this->string_set_.size(),
-	  this->string_set_.bucket_count());
+	  program_name, name, entries, buckets);
 #else
   fprintf(stderr, _("%s: %s entries: %zu\n"),
-	  program_name, name, this->table_.size());
+	  program_name, name, entries);
 #endif
   fprintf(stderr, _("%s: %s Stringdata structures: %zu\n"),
-	  program_name, name, this->strings_.size());
+	  program_name, name, stringdata);
 }
 
 // Instantiate the templates we need.
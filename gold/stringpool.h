@@ -30,6 +30,8 @@
 namespace gold
 {
 
+class Lock;
+
 class Output_file;
 
 // Return the length of a string in units of Char_type.
@@ -89,6 +91,16 @@ string_length(const char* p)
 // string "abc" will be stored, and "bc" will be represented by an
 // offset into the middle of the string "abc".
 
+// A Stringpool may be made concurrent, so that several threads may
+// add strings to it at once.  A concurrent Stringpool divides its
+// strings among several shards by hash code, each with its own lock.
+// The key of a string is then one more than its position in the
+// order in which strings are added, and the offsets are only assigned by
+// set_string_offsets, in that order, so the string table is the same
+// as for a Stringpool which is not concurrent.  Threads that add
+// strings at once must say where their strings fall in that order;
+// see begin_ordered_adds and add_in_order.
+
 
 // A simple chunked vector class--this is a subset of std::vector
 // which stores memory in chunks.  We don't provide iterators, because
@@ -201,11 +213,24 @@ class Stringpool_template
   set_no_zero_null()
   {
     gold_assert(this->string_set_.empty()
+		&& this->next_order_ == 0
 		&& this->offset_ == sizeof(Stringpool_char));
     this->zero_null_ = false;
     this->offset_ = 0;
   }
 
+  // Indicate that several threads may add strings to this pool at
+  // once, using add_in_order.  This must be called before any strings
+  // are added.  The other functions which add strings must still
+  // only be called by one thread at a time.
+  void
+  set_concurrent();
+
+  // Return whether this pool is concurrent.
+  bool
+  is_concurrent() const
+  { return this->shards_ != NULL; }
+
   // Indicate that this string pool should be optimized, even if not
   // running with -O2.
   void
@@ -229,6 +254,37 @@ class Stringpool_template
   const Stringpool_char*
   add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey);
 
+  // Add string S of length LEN characters to the pool, where
+  // HASH_CODE is gold::string_hash(S, LEN).  This lets the caller
+  // compute the hash code beforehand, perhaps in another thread.
+  const Stringpool_char*
+  add_prehashed(const Stringpool_char* s, size_t len, size_t hash_code,
+		bool copy, Key* pkey);
+
+  // Start a batch of COUNT strings which may be added by several
+  // threads at once.  The strings are treated as though they were
+  // added in order of the positions passed to add_in_order.
+  void
+  begin_ordered_adds(size_t count);
+
+  // Add the string S to the pool, at POSITION in the last batch
+  // started by begin_ordered_adds.  POSITION must be less than the
+  // count of the batch.  For a concurrent pool, this may be called by
+  // several threads at once; otherwise the strings must be added in
+  // order of POSITION.  This does not return a key, since the key of
+  // a concurrent pool is not known until the whole batch is added.
+  const Stringpool_char*
+  add_in_order(const Stringpool_char* s, bool copy, size_t position);
+
+  // Like add_in_order, for the string S of length LEN characters
+  // whose hash code is HASH_CODE, as computed by gold::string_hash.
+  // If PLOCATION is not NULL, this sets *PLOCATION to a nonzero value
+  // to pass to get_offset_from_location.
+  const Stringpool_char*
+  add_in_order_with_length(const Stringpool_char* s, size_t len,
+			   size_t hash_code, bool copy, size_t position,
+			   Key* plocation);
+
   // If the string S is present in the pool, return the canonical
   // string pointer.  Otherwise, return NULL.  If PKEY is not NULL,
   // set *PKEY to the key.
@@ -261,10 +317,24 @@ class Stringpool_template
   section_offset_type
   get_offset_from_key(Key k) const
   {
-    gold_assert(k <= this->key_to_offset_.size());
+    gold_assert(this->shards_ == NULL && k <= this->key_to_offset_.size());
     return this->key_to_offset_[k - 1];
   }
 
+  // Get the offset of the string at LOCATION, as set by
+  // add_in_order_with_length.  This may only be called after
+  // set_string_offsets has been called.  For a concurrent pool, this
+  // may be called by several threads at once.
+  section_offset_type
+  get_offset_from_location(Key location) const
+  {
+    if (this->shards_ == NULL)
+      return this->get_offset_from_key(location);
+    const Shard& shard(this->shards_[(location - 1) % shard_count]);
+    gold_assert((location - 1) / shard_count < shard.entries.size());
+    return shard.entries[(location - 1) / shard_count].offset;
+  }
+
   // Get the size of the string table.  This returns the number of
   // bytes, not in units of Stringpool_char.
   section_size_type
@@ -313,13 +383,16 @@ class Stringpool_template
     char data[1];
   };
 
+  // List of Stringdata structures.
+  typedef std::list<Stringdata*> Stringdata_list;
+
   // Add a new key offset entry.
   void
   new_key_offset(size_t);
 
   // Copy a string into the buffers, returning a canonical string.
   const Stringpool_char*
-  add_string(const Stringpool_char*, size_t);
+  add_string(Stringdata_list*, const Stringpool_char*, size_t);
 
   // Return whether s1 is a suffix of s2.
   static bool
@@ -353,6 +426,10 @@ class Stringpool_template
     Hashkey(const Stringpool_char* s, size_t len)
       : string(s), length(len), hash_code(string_hash(s, len))
     { }
+
+    Hashkey(const Stringpool_char* s, size_t len, size_t hash)
+      : string(s), length(len), hash_code(hash)
+    { }
   };
 
   // Hash function.  This is trivial, since we have already computed
@@ -392,8 +469,76 @@ class Stringpool_template
   // offsets if we turn this into an string table section.
   typedef Chunked_vector<section_offset_type> Key_to_offset;
 
-  // List of Stringdata structures.
-  typedef std::list<Stringdata*> Stringdata_list;
+  // A string in a shard of a concurrent Stringpool.
+  struct Shard_entry
+  {
+    // The position of the string in the order of additions.  The key
+    // is one more than this.
+    Key order;
+    // The length of the string in characters.
+    size_t length;
+    // The offset of the string in the string table.
+    section_offset_type offset;
+  };
+
+  // A shard of a concurrent Stringpool.  The hash table maps strings
+  // to indexes in ENTRIES.
+  struct Shard
+  {
+    Shard()
+      : lock(NULL), string_set(), entries(), strings()
+    { }
+
+    // Protects the other fields.
+    Lock* lock;
+    String_set_type string_set;
+    std::vector<Shard_entry> entries;
+    Stringdata_list strings;
+  };
+
+  // The number of shards in a concurrent Stringpool.
+  static const unsigned int shard_count = 16;
+
+  // Return the shard for strings with hash code HASH_CODE.
+  Shard*
+  shard_for(size_t hash_code) const
+  { return &this->shards_[hash_code % shard_count]; }
+
+  // Add a string to a concurrent pool at ORDER.
+  const Stringpool_char*
+  add_to_shard(const Stringpool_char*, size_t, size_t hash_code, bool copy,
+	       Key order, Key* pkey, Key* plocation);
+
+  // Return hash table I, for passes over all the strings.
+  String_set_type*
+  string_set(unsigned int i)
+  {
+    if (this->shards_ == NULL)
+      return &this->string_set_;
+    return &this->shards_[i].string_set;
+  }
+
+  const String_set_type*
+  string_set(unsigned int i) const
+  {
+    if (this->shards_ == NULL)
+      return &this->string_set_;
+    return &this->shards_[i].string_set;
+  }
+
+  // Return the number of hash tables.
+  unsigned int
+  string_set_count() const
+  { return this->shards_ == NULL ? 1 : shard_count; }
+
+  // Record the string table offset of the string in hash table entry P.
+  void
+  set_entry_offset(const typename String_set_type::value_type& p,
+		   section_offset_type offset);
+
+  // Return the string table offset of the string in hash table entry P.
+  section_offset_type
+  entry_offset(const typename String_set_type::value_type& p) const;
 
   // Mapping from const char* to namepool entry.
   String_set_type string_set_;
@@ -411,6 +556,15 @@ class Stringpool_template
   section_offset_type offset_;
   // The alignment of strings in the stringpool.
   uint64_t addralign_;
+  // The shards of a concurrent pool, or NULL.
+  Shard* shards_;
+  // For a concurrent pool, the position of the next string added.
+  Key next_order_;
+  // For a concurrent pool, the position of the current batch of
+  // ordered adds.
+  Key batch_order_;
+  // The number of strings in the current batch of ordered adds.
+  size_t batch_count_;
 };
 
 // The most common type of Stringpool.
@@ -1080,11 +1080,14 @@ Symbol_table::add_from_relobj(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const std::vector<Global_symbol_name>* global_names,
     typename Sized_relobj_file<size, big_endian>::Symbols* sympointers,
     size_t* defined)
 {
   *defined = 0;
 
+  gold_assert(global_names == NULL || global_names->size() == count);
+
   gold_assert(size == parameters->target().get_size());
 
   const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
@@ -1134,7 +1137,14 @@ Symbol_table::add_from_relobj(
       // In an object file, an '@' in the name separates the symbol
       // name from the version name.  If there are two '@' characters,
       // this is the default version.
-      const char* ver = strchr(name, '@');
+      const char* ver;
+      if (global_names == NULL)
+	ver = strchr(name, '@');
+      else
+	{
+	  const char* end = name + (*global_names)[i].length;
+	  ver = *end == '@' ? end : NULL;
+	}
       Stringpool::Key ver_key = 0;
       int namelen = 0;
       // IS_DEFAULT_VERSION: is the version default?
@@ -1167,7 +1177,10 @@ Symbol_table::add_from_relobj(
       // about a common symbol?
       else
 	{
-	  namelen = strlen(name);
+	  if (global_names == NULL)
+	    namelen = strlen(name);
+	  else
+	    namelen = (*global_names)[i].length;
 	  if (!this->version_script_.empty()
 	      && st_shndx != elfcpp::SHN_UNDEF)
 	    {
@@ -1239,8 +1252,13 @@ Symbol_table::add_from_relobj(
         }
 
       Stringpool::Key name_key;
-      name = this->namepool_.add_with_length(name, namelen, true,
-					     &name_key);
+      if (global_names == NULL)
+	name = this->namepool_.add_with_length(name, namelen, true,
+					       &name_key);
+      else
+	name = this->namepool_.add_prehashed(name, namelen,
+					     (*global_names)[i].hash_code,
+					     true, &name_key);
 
       Sized_symbol<size>* res;
       res = this->add_from_object(relobj, name, name_key, ver, ver_key,
@@ -3414,6 +3432,7 @@ Symbol_table::add_from_relobj<32, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const std::vector<Global_symbol_name>* global_names,
     Sized_relobj_file<32, false>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3428,6 +3447,7 @@ Symbol_table::add_from_relobj<32, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const std::vector<Global_symbol_name>* global_names,
     Sized_relobj_file<32, true>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3442,6 +3462,7 @@ Symbol_table::add_from_relobj<64, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const std::vector<Global_symbol_name>* global_names,
     Sized_relobj_file<64, false>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3456,6 +3477,7 @@ Symbol_table::add_from_relobj<64, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const std::vector<Global_symbol_name>* global_names,
     Sized_relobj_file<64, true>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -359,7 +359,7 @@ relocate_section(
 	{
 	  if (comdat_behavior == CB_UNDETERMINED)
 	    {
-	      std::string name = object->section_name(relinfo->data_shndx);
+	      std::string name = relinfo->data_section_name();
 	      comdat_behavior = relocate_comdat_behavior.get(name.c_str());
 	    }
 	  if (comdat_behavior == CB_PRETEND)
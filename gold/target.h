@@ -299,6 +299,14 @@ class Target
   can_check_for_function_pointers() const
   { return this->do_can_check_for_function_pointers(); }
 
+  // Return whether the relocation sections of one input object may
+  // be applied by several threads at once.  This is true if
+  // relocate_section only reads the symbol table and layout, and
+  // only writes the view it is given.
+  bool
+  can_relocate_sections_in_parallel() const
+  { return this->do_can_relocate_sections_in_parallel(); }
+
   // Return whether a relocation to a merged section can be processed
   // to retrieve the contents.
   bool
@@ -597,6 +605,11 @@ class Target
   do_can_check_for_function_pointers() const
   { return false; }
 
+  // Virtual function which may be overridden by the child class.
+  virtual bool
+  do_can_relocate_sections_in_parallel() const
+  { return false; }
+
   // Virtual function which may be overridden by the child class.  We
   // recognize some default sections for which we don't care whether
   // they have function pointers.
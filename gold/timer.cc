@@ -23,6 +23,7 @@
 #include "gold.h"
 
 #include <unistd.h>
+#include <sys/time.h>
 
 #ifdef HAVE_TIMES
 #include <sys/times.h>
@@ -104,6 +105,17 @@ Timer::get_time(TimeStats *now)
 #endif
 }
 
+// Return the wall clock time in microseconds.
+
+uint64_t
+Timer::wall_clock_usec()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (static_cast<uint64_t>(tv.tv_sec) * 1000000
+	  + static_cast<uint64_t>(tv.tv_usec));
+}
+
 // Return the stats since start was called.
 Timer::TimeStats
 Timer::get_elapsed_time()
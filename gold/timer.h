@@ -60,6 +60,11 @@ class Timer
   void
   stamp(int n);
 
+  // Return the wall clock time in microseconds.  This is used to time
+  // single tasks, for which the resolution of times is too coarse.
+  static uint64_t
+  wall_clock_usec();
+
  private:
   // This class cannot be copied.
   Timer(const Timer&);
@@ -24,6 +24,9 @@
 #define GOLD_WORKQUEUE_INTERNAL_H
 
 #include <queue>
+#include <deque>
+#include <map>
+#include <vector>
 #include <csignal>
 
 #include "gold-threads.h"
@@ -69,6 +72,152 @@ class Workqueue_threader
   Workqueue* workqueue_;
 };
 
+// A queue of independent tasks.  A thread takes tasks from the back
+// of its own queue, and steals them from the front of the queues of
+// other threads.
+
+class Workqueue_deque
+{
+ public:
+  Workqueue_deque()
+    : lock_(), tasks_(), size_(0)
+  { }
+
+  // Return whether the queue may have tasks.  This does not take the
+  // lock, so the answer may be out of date.
+  bool
+  maybe_nonempty() const
+  { return this->size_ != 0; }
+
+  // Add T to the back of the queue.
+  void
+  push_back(Task* t)
+  {
+    Hold_lock hl(this->lock_);
+    this->tasks_.push_back(t);
+    this->size_ = this->tasks_.size();
+  }
+
+  // Remove and return the task at the back of the queue, or return
+  // NULL if it is empty.
+  Task*
+  pop_back()
+  {
+    Hold_lock hl(this->lock_);
+    if (this->tasks_.empty())
+      return NULL;
+    Task* t = this->tasks_.back();
+    this->tasks_.pop_back();
+    this->size_ = this->tasks_.size();
+    return t;
+  }
+
+  // Remove and return the task at the front of the queue, or return
+  // NULL if it is empty.
+  Task*
+  pop_front()
+  {
+    Hold_lock hl(this->lock_);
+    if (this->tasks_.empty())
+      return NULL;
+    Task* t = this->tasks_.front();
+    this->tasks_.pop_front();
+    this->size_ = this->tasks_.size();
+    return t;
+  }
+
+ private:
+  Workqueue_deque(const Workqueue_deque&);
+  Workqueue_deque& operator=(const Workqueue_deque&);
+
+  // Protects tasks_.
+  Lock lock_;
+  // The tasks.
+  std::deque<Task*> tasks_;
+  // The number of tasks, which may be read without the lock.
+  volatile size_t size_;
+};
+
+// Statistics about the tasks run by a Workqueue, for --stats and
+// --trace-tasks.  All times are wall clock times in microseconds.
+
+class Workqueue_stats
+{
+ public:
+  Workqueue_stats(bool keep_trace)
+    : lock_(), classes_(), thread_busy_(), first_start_(0), last_end_(0),
+      keep_trace_(keep_trace), events_()
+  { }
+
+  // Record that thread THREAD_NUMBER ran task T from START to END.
+  void
+  record(int thread_number, Task* t, uint64_t start, uint64_t end);
+
+  // Print the statistics to stderr.
+  void
+  print();
+
+  // Write the recorded tasks to FILENAME in the Chrome trace event
+  // format.
+  void
+  write_trace(const char* filename);
+
+ private:
+  Workqueue_stats(const Workqueue_stats&);
+  Workqueue_stats& operator=(const Workqueue_stats&);
+
+  // The totals for the tasks with the same stats_name.
+  struct Class_stats
+  {
+    Class_stats()
+      : count(0), total(0), max(0), wait(0)
+    { }
+
+    // The number of tasks run.
+    unsigned int count;
+    // The total time spent running them.
+    uint64_t total;
+    // The longest time spent running one of them.
+    uint64_t max;
+    // The total time between queueing them and running them.
+    uint64_t wait;
+  };
+
+  // A task run, for --trace-tasks.
+  struct Event
+  {
+    Event(const std::string& a_name, const std::string& a_class_name,
+	  int a_thread_number, uint64_t a_start, uint64_t a_end)
+      : name(a_name), class_name(a_class_name),
+	thread_number(a_thread_number), start(a_start), end(a_end)
+    { }
+
+    std::string name;
+    std::string class_name;
+    int thread_number;
+    uint64_t start;
+    uint64_t end;
+  };
+
+  typedef std::map<std::string, Class_stats> Classes;
+
+  // Protects the fields below.
+  Lock lock_;
+  // The totals for each kind of task.
+  Classes classes_;
+  // The time each thread spent running tasks, indexed by thread
+  // number.
+  std::vector<uint64_t> thread_busy_;
+  // When the first task started.
+  uint64_t first_start_;
+  // When the last task ended.
+  uint64_t last_end_;
+  // Whether to record each task in events_.
+  bool keep_trace_;
+  // The tasks run, for --trace-tasks.
+  std::vector<Event> events_;
+};
+
 // The threaded instantiation of Workqueue_threader.
 
 class Workqueue_threader_threadpool : public Workqueue_threader
@@ -22,6 +22,11 @@
 
 #include "gold.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
 #include "debug.h"
 #include "options.h"
 #include "timer.h"
@@ -31,6 +36,19 @@
 namespace gold
 {
 
+// Class Task.
+
+// Return the name under which --stats adds up the times of tasks of
+// the same kind.  Most task names are the class name followed by the
+// name of a file or section.
+
+std::string
+Task::stats_name()
+{
+  const std::string& name(this->name());
+  return name.substr(0, name.find(' '));
+}
+
 // Class Task_list.
 
 // Add T to the end of the list.
@@ -114,6 +132,11 @@ class Workqueue_threader_single : public Workqueue_threader
   { return false; }
 };
 
+// The most queues of independent tasks to use.  Threads beyond this
+// number share queues.
+
+static const int max_workqueue_deques = 64;
+
 // Workqueue methods.
 
 Workqueue::Workqueue(const General_options& options)
@@ -123,12 +146,25 @@ Workqueue::Workqueue(const General_options& options)
     running_(0),
     waiting_(0),
     condvar_(this->lock_),
-    threader_(NULL)
+    deques_(NULL),
+    deque_count_(1),
+    deques_used_(1),
+    active_deques_(1),
+    next_deque_(0),
+    independent_(0),
+    independent_queued_(0),
+    idle_(0),
+    threader_(NULL),
+    stats_(NULL)
 {
   bool threads = options.threads();
 #ifndef ENABLE_THREADS
   threads = false;
 #endif
+  if (threads)
+    this->deque_count_ = max_workqueue_deques;
+  this->deques_ = new Workqueue_deque[this->deque_count_];
+
   if (!threads)
     this->threader_ = new Workqueue_threader_single(this);
   else
@@ -139,10 +175,14 @@ Workqueue::Workqueue(const General_options& options)
       gold_unreachable();
 #endif
     }
+
+  if (options.stats() || options.user_set_trace_tasks())
+    this->stats_ = new Workqueue_stats(options.user_set_trace_tasks());
 }
 
 Workqueue::~Workqueue()
 {
+  delete this->stats_;
 }
 
 // Add a task to the end of a specific queue, or put it on the list
@@ -151,6 +191,9 @@ Workqueue::~Workqueue()
 void
 Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
 {
+  if (this->stats_ != NULL)
+    t->set_queue_time(Timer::wall_clock_usec());
+
   Hold_lock hl(this->lock_);
 
   Task_token* token = t->is_runnable();
@@ -199,6 +242,57 @@ Workqueue::queue_next(Task* t)
   this->add_to_queue(&this->first_tasks_, t, true);
 }
 
+// Queue an independent task.  This does not take the workqueue lock
+// unless a thread is idle, in which case we wake it up.  The tasks
+// are spread over the queues of the desired threads in turn.
+
+void
+Workqueue::queue_independent(Task* t)
+{
+  gold_assert(t->is_runnable() == NULL);
+  if (this->stats_ != NULL)
+    t->set_queue_time(Timer::wall_clock_usec());
+  __sync_fetch_and_add(&this->independent_, 1);
+
+  unsigned int i = __sync_fetch_and_add(&this->next_deque_, 1);
+  this->deques_[i % this->active_deques_].push_back(t);
+
+  // An idle thread counts itself as idle before it checks the number
+  // of queued tasks, and we count the task before we check for idle
+  // threads, so either it will see the task or we will wake it up.
+  __sync_fetch_and_add(&this->independent_queued_, 1);
+  if (__sync_fetch_and_add(&this->idle_, 0) > 0)
+    {
+      Hold_lock hl(this->lock_);
+      this->condvar_.signal();
+    }
+}
+
+// Take an independent task from the back of this thread's queue, or
+// steal one from the front of another thread's queue.  This may be
+// called with or without the workqueue lock held.
+
+Task*
+Workqueue::pop_independent(int thread_number)
+{
+  if (__sync_fetch_and_add(&this->independent_queued_, 0) <= 0)
+    return NULL;
+
+  int count = this->deques_used_;
+  int own = thread_number % this->deque_count_;
+  Task* t = this->deques_[own].pop_back();
+  for (int i = 1; t == NULL && i < count; ++i)
+    {
+      Workqueue_deque* deque = &this->deques_[(own + i) % count];
+      if (deque->maybe_nonempty())
+	t = deque->pop_front();
+    }
+
+  if (t != NULL)
+    __sync_fetch_and_sub(&this->independent_queued_, 1);
+  return t;
+}
+
 // Return whether to cancel the current thread.
 
 inline bool
@@ -243,19 +337,22 @@ Workqueue::find_runnable()
 }
 
 // Find a runnable a task, and wait until we find one.  Return NULL if
-// we should exit.  The workqueue lock must be held when this is
-// called.
+// we should exit.  If we return an independent task, set
+// *IS_INDEPENDENT; it must be run without the workqueue lock.  The
+// workqueue lock must be held when this is called.
 
 Task*
-Workqueue::find_runnable_or_wait(int thread_number)
+Workqueue::find_runnable_or_wait(int thread_number, bool* is_independent)
 {
+  *is_independent = false;
   Task* t = this->find_runnable();
 
   while (t == NULL)
     {
       if (this->running_ == 0
 	  && this->first_tasks_.empty()
-	  && this->tasks_.empty())
+	  && this->tasks_.empty()
+	  && __sync_fetch_and_add(&this->independent_, 0) == 0)
 	{
 	  // Kick all the threads to make them exit.
 	  this->condvar_.broadcast();
@@ -267,11 +364,27 @@ Workqueue::find_runnable_or_wait(int thread_number)
       if (this->should_cancel_thread(thread_number))
 	return NULL;
 
-      gold_debug(DEBUG_TASK, "%3d sleeping", thread_number);
+      // Count ourselves as idle before looking for an independent
+      // task, so that a thread which queues one after we look will
+      // wake us up.
+      __sync_fetch_and_add(&this->idle_, 1);
+      t = this->pop_independent(thread_number);
+      if (t == NULL
+	  && __sync_fetch_and_add(&this->independent_queued_, 0) <= 0)
+	{
+	  gold_debug(DEBUG_TASK, "%3d sleeping", thread_number);
+
+	  this->condvar_.wait();
 
-      this->condvar_.wait();
+	  gold_debug(DEBUG_TASK, "%3d awake", thread_number);
+	}
+      __sync_fetch_and_sub(&this->idle_, 1);
 
-      gold_debug(DEBUG_TASK, "%3d awake", thread_number);
+      if (t != NULL)
+	{
+	  *is_independent = true;
+	  return t;
+	}
 
       t = this->find_runnable();
     }
@@ -279,6 +392,59 @@ Workqueue::find_runnable_or_wait(int thread_number)
   return t;
 }
 
+// Run the task T.
+
+void
+Workqueue::run_task(int thread_number, Task* t)
+{
+  gold_debug(DEBUG_TASK, "%3d running   task %s", thread_number,
+	     t->name().c_str());
+
+  Timer timer;
+  if (is_debugging_enabled(DEBUG_TASK))
+    timer.start();
+
+  uint64_t start = 0;
+  if (this->stats_ != NULL)
+    start = Timer::wall_clock_usec();
+
+  t->run(this);
+
+  if (this->stats_ != NULL)
+    this->stats_->record(thread_number, t, start, Timer::wall_clock_usec());
+
+  if (is_debugging_enabled(DEBUG_TASK))
+    {
+      Timer::TimeStats elapsed = timer.get_elapsed_time();
+
+      gold_debug(DEBUG_TASK,
+		 "%3d completed task %s "
+		 "(user: %ld.%06ld sys: %ld.%06ld wall: %ld.%06ld)",
+		 thread_number,  t->name().c_str(),
+		 elapsed.user / 1000, (elapsed.user % 1000) * 1000,
+		 elapsed.sys / 1000, (elapsed.sys % 1000) * 1000,
+		 elapsed.wall / 1000, (elapsed.wall % 1000) * 1000);
+    }
+}
+
+// Run and delete the independent task T.  This is called without the
+// workqueue lock held.
+
+void
+Workqueue::run_independent(int thread_number, Task* t)
+{
+  this->run_task(thread_number, t);
+  delete t;
+
+  if (__sync_sub_and_fetch(&this->independent_, 1) == 0)
+    {
+      // Wake up the threads, in case they are waiting for all the
+      // tasks to finish.
+      Hold_lock hl(this->lock_);
+      this->condvar_.broadcast();
+    }
+}
+
 // Find and run tasks.  If we can't find a runnable task, wait for one
 // to become available.  If we run a task, and it frees up another
 // runnable task, then run that one too.  This returns true if we
@@ -288,48 +454,45 @@ Workqueue::find_runnable_or_wait(int thread_number)
 bool
 Workqueue::find_and_run_task(int thread_number)
 {
-  Task* t;
+  // Independent tasks do not need the workqueue lock.
+  Task* t = this->pop_independent(thread_number);
+  if (t != NULL)
+    {
+      this->run_independent(thread_number, t);
+      return true;
+    }
+
   Task_locker tl;
+  bool is_independent;
 
   {
     Hold_lock hl(this->lock_);
 
     // Find a runnable task.
-    t = this->find_runnable_or_wait(thread_number);
+    t = this->find_runnable_or_wait(thread_number, &is_independent);
 
     if (t == NULL)
       return false;
 
-    // Get the locks for the task.  This must be called while we are
-    // still holding the Workqueue lock.
-    t->locks(&tl);
+    if (!is_independent)
+      {
+	// Get the locks for the task.  This must be called while we
+	// are still holding the Workqueue lock.
+	t->locks(&tl);
 
-    ++this->running_;
+	++this->running_;
+      }
   }
 
-  while (t != NULL)
+  if (is_independent)
     {
-      gold_debug(DEBUG_TASK, "%3d running   task %s", thread_number,
-		 t->name().c_str());
-
-      Timer timer;
-      if (is_debugging_enabled(DEBUG_TASK))
-        timer.start();
-
-      t->run(this);
-
-      if (is_debugging_enabled(DEBUG_TASK))
-        {
-          Timer::TimeStats elapsed = timer.get_elapsed_time();
+      this->run_independent(thread_number, t);
+      return true;
+    }
 
-          gold_debug(DEBUG_TASK,
-                     "%3d completed task %s "
-                     "(user: %ld.%06ld sys: %ld.%06ld wall: %ld.%06ld)",
-                     thread_number,  t->name().c_str(),
-                     elapsed.user / 1000, (elapsed.user % 1000) * 1000,
-                     elapsed.sys / 1000, (elapsed.sys % 1000) * 1000,
-                     elapsed.wall / 1000, (elapsed.wall % 1000) * 1000);
-        }
+  while (t != NULL)
+    {
+      this->run_task(thread_number, t);
 
       Task* next;
       {
@@ -505,6 +668,11 @@ Workqueue::set_thread_count(int threads)
   Hold_lock hl(this->lock_);
 
   this->threader_->set_thread_count(threads);
+
+  int deques = std::max(1, std::min(threads, this->deque_count_));
+  this->active_deques_ = deques;
+  if (deques > this->deques_used_)
+    this->deques_used_ = deques;
   // Wake up all the threads, since something has changed.
   this->condvar_.broadcast();
 }
@@ -518,4 +686,293 @@ Workqueue::add_blocker(Task_token* token)
   token->add_blocker();
 }
 
+// Print the task statistics for --stats.
+
+void
+Workqueue::print_stats()
+{
+  if (this->stats_ != NULL)
+    this->stats_->print();
+}
+
+// Write the task timeline for --trace-tasks.
+
+void
+Workqueue::write_task_trace(const char* filename)
+{
+  if (this->stats_ != NULL)
+    this->stats_->write_trace(filename);
+}
+
+// Class Workqueue_stats.
+
+// Record that thread THREAD_NUMBER ran task T from START to END.
+
+void
+Workqueue_stats::record(int thread_number, Task* t, uint64_t start,
+			uint64_t end)
+{
+  std::string class_name = t->stats_name();
+  uint64_t run_time = end - start;
+  uint64_t wait = (t->queue_time() != 0 && t->queue_time() < start
+		   ? start - t->queue_time()
+		   : 0);
+
+  Hold_lock hl(this->lock_);
+
+  Class_stats& cs(this->classes_[class_name]);
+  ++cs.count;
+  cs.total += run_time;
+  if (run_time > cs.max)
+    cs.max = run_time;
+  cs.wait += wait;
+
+  gold_assert(thread_number >= 0);
+  if (static_cast<size_t>(thread_number) >= this->thread_busy_.size())
+    this->thread_busy_.resize(thread_number + 1, 0);
+  this->thread_busy_[thread_number] += run_time;
+
+  if (this->first_start_ == 0 || start < this->first_start_)
+    this->first_start_ = start;
+  if (end > this->last_end_)
+    this->last_end_ = end;
+
+  if (this->keep_trace_)
+    this->events_.push_back(Event(t->name(), class_name, thread_number,
+				  start, end));
+}
+
+// Sort task kinds by decreasing total time.
+
+struct Workqueue_stats_total_compare
+{
+  template<typename Pair>
+  bool
+  operator()(const Pair* a, const Pair* b) const
+  {
+    if (a->second.total != b->second.total)
+      return a->second.total > b->second.total;
+    return a->first < b->first;
+  }
+};
+
+// Print the statistics to stderr.
+
+void
+Workqueue_stats::print()
+{
+  Hold_lock hl(this->lock_);
+
+  std::vector<const Classes::value_type*> sorted;
+  sorted.reserve(this->classes_.size());
+  for (Classes::const_iterator p = this->classes_.begin();
+       p != this->classes_.end();
+       ++p)
+    sorted.push_back(&*p);
+  std::sort(sorted.begin(), sorted.end(), Workqueue_stats_total_compare());
+
+  for (size_t i = 0; i < sorted.size(); ++i)
+    {
+      const Class_stats& cs(sorted[i]->second);
+      fprintf(stderr,
+	      _("%s: task %s: count %u total %llu.%06llu max %llu.%06llu "
+		"wait %llu.%06llu\n"),
+	      program_name, sorted[i]->first.c_str(), cs.count,
+	      static_cast<unsigned long long>(cs.total / 1000000),
+	      static_cast<unsigned long long>(cs.total % 1000000),
+	      static_cast<unsigned long long>(cs.max / 1000000),
+	      static_cast<unsigned long long>(cs.max % 1000000),
+	      static_cast<unsigned long long>(cs.wait / 1000000),
+	      static_cast<unsigned long long>(cs.wait % 1000000));
+    }
+
+  uint64_t span = this->last_end_ - this->first_start_;
+  for (size_t i = 0; i < this->thread_busy_.size(); ++i)
+    {
+      uint64_t busy = this->thread_busy_[i];
+      if (busy == 0)
+	continue;
+      fprintf(stderr,
+	      _("%s: thread %u: busy %llu.%06llu (%u%% of task run time)\n"),
+	      program_name, static_cast<unsigned int>(i),
+	      static_cast<unsigned long long>(busy / 1000000),
+	      static_cast<unsigned long long>(busy % 1000000),
+	      static_cast<unsigned int>(span == 0 ? 100 : busy * 100 / span));
+    }
+}
+
+// Write S to F as a JSON string.
+
+static void
+write_json_string(FILE* f, const std::string& s)
+{
+  putc('"', f);
+  for (std::string::const_iterator p = s.begin(); p != s.end(); ++p)
+    {
+      unsigned char c = *p;
+      if (c == '"' || c == '\\')
+	fprintf(f, "\\%c", c);
+      else if (c < 0x20)
+	fprintf(f, "\\u%04x", c);
+      else
+	putc(c, f);
+    }
+  putc('"', f);
+}
+
+// Write the recorded tasks to FILENAME in the Chrome trace event
+// format, which can be viewed with chrome://tracing or Perfetto.  The
+// times are relative to the start of the first task.
+
+void
+Workqueue_stats::write_trace(const char* filename)
+{
+  Hold_lock hl(this->lock_);
+
+  FILE* f = fopen(filename, "w");
+  if (f == NULL)
+    {
+      gold_error(_("cannot open task trace file %s: %s"), filename,
+		 strerror(errno));
+      return;
+    }
+
+  fprintf(f, "{\"traceEvents\":[");
+  for (size_t i = 0; i < this->events_.size(); ++i)
+    {
+      const Event& e(this->events_[i]);
+      fprintf(f, "%s\n{\"name\":", i == 0 ? "" : ",");
+      write_json_string(f, e.name);
+      fprintf(f, ",\"cat\":");
+      write_json_string(f, e.class_name);
+      fprintf(f, ",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+	      "\"ts\":%llu,\"dur\":%llu}",
+	      e.thread_number,
+	      static_cast<unsigned long long>(e.start - this->first_start_),
+	      static_cast<unsigned long long>(e.end - e.start));
+    }
+  fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  if (fclose(f) != 0)
+    gold_error(_("cannot write task trace file %s: %s"), filename,
+	       strerror(errno));
+}
+
+// Class Parallel_work.
+
+// A task which helps to run a Parallel_work.
+
+class Parallel_work_task : public Task
+{
+ public:
+  Parallel_work_task(Parallel_work* work)
+    : work_(work)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*)
+  { }
+
+  void
+  run(Workqueue*)
+  {
+    this->work_->run_jobs(this);
+    this->work_->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Parallel_work_task " + this->work_->name_; }
+
+  // Keep the statistics of the helpers of different kinds of work
+  // apart.
+  std::string
+  stats_name()
+  { return this->name(); }
+
+ private:
+  Parallel_work* work_;
+};
+
+Parallel_work::Parallel_work(size_t count, const std::string& name)
+  : lock_(), condvar_(this->lock_), name_(name), count_(count), next_(0),
+    running_(0), refs_(1)
+{
+}
+
+// Queue the helper tasks, run jobs until none are left, and then
+// wait for the jobs which the helper tasks claimed.
+
+void
+Parallel_work::run(Workqueue* workqueue, const Task* task, size_t helpers)
+{
+  for (size_t i = 0; i < helpers; ++i)
+    {
+      {
+	Hold_lock hl(this->lock_);
+	++this->refs_;
+      }
+      workqueue->queue_independent(new Parallel_work_task(this));
+    }
+
+  this->run_jobs(task);
+
+  {
+    Hold_lock hl(this->lock_);
+    while (this->running_ > 0)
+      this->condvar_.wait();
+  }
+
+  this->release();
+}
+
+// Run jobs until every job has been claimed.
+
+void
+Parallel_work::run_jobs(const Task* task)
+{
+  while (true)
+    {
+      size_t i;
+      {
+	Hold_lock hl(this->lock_);
+	if (this->next_ >= this->count_)
+	  return;
+	i = this->next_;
+	++this->next_;
+	++this->running_;
+      }
+
+      this->do_run(i, task);
+
+      {
+	Hold_lock hl(this->lock_);
+	--this->running_;
+	if (this->running_ == 0 && this->next_ >= this->count_)
+	  this->condvar_.broadcast();
+      }
+    }
+}
+
+// Drop a reference to the work.
+
+void
+Parallel_work::release()
+{
+  bool last;
+  {
+    Hold_lock hl(this->lock_);
+    --this->refs_;
+    last = this->refs_ == 0;
+  }
+  if (last)
+    delete this;
+}
+
 } // End namespace gold.
@@ -45,7 +45,7 @@ class Task
 {
  public:
   Task()
-    : list_next_(NULL), name_(), should_run_soon_(false)
+    : list_next_(NULL), name_(), should_run_soon_(false), queue_time_(0)
   { }
   virtual ~Task()
   { }
@@ -106,6 +106,22 @@ class Task
     return this->name_;
   }
 
+  // Return the name under which --stats adds up the times of tasks
+  // of the same kind.  By default this is the first word of the name.
+  virtual std::string
+  stats_name();
+
+  // Record the time, in microseconds, when the Task was queued.  This
+  // is only done for --stats and --trace-tasks.
+  void
+  set_queue_time(uint64_t usec)
+  { this->queue_time_ = usec; }
+
+  // Return the time when the Task was queued.
+  uint64_t
+  queue_time() const
+  { return this->queue_time_; }
+
  protected:
   // Get the name of the task.  This must be implemented by the child
   // class.
@@ -127,6 +143,8 @@ class Task
   // Whether this Task should be executed soon.  This is used for
   // Tasks which can be run after some data is read.
   bool should_run_soon_;
+  // When the Task was queued, for --stats and --trace-tasks.
+  uint64_t queue_time_;
 };
 
 // An interface for Task_function.  This is a convenience class to run
@@ -182,6 +200,11 @@ class Task_function : public Task
   get_name() const
   { return this->name_; }
 
+  // The name says which function is run, so use all of it.
+  std::string
+  stats_name()
+  { return this->name_; }
+
  private:
   Task_function(const Task_function&);
   Task_function& operator=(const Task_function&);
@@ -191,9 +214,74 @@ class Task_function : public Task
   const char* name_;
 };
 
+// A set of independent jobs, numbered from zero, which several tasks
+// may run at once.  The task which creates the work calls run, which
+// queues helper tasks and then runs jobs itself.  Each task
+// repeatedly claims the next job which has not yet been claimed.  run
+// returns once every job is done, but it never waits for a helper
+// task which has not yet started, since the workqueue may not have a
+// free thread for it.  The work must be allocated using new; it is
+// deleted by whichever task is last to finish with it.
+
+class Parallel_work
+{
+ public:
+  // COUNT is the number of jobs, and NAME is used in the names of the
+  // helper tasks.
+  Parallel_work(size_t count, const std::string& name);
+
+  virtual
+  ~Parallel_work()
+  { }
+
+  // Run all the jobs, with the help of at most HELPERS tasks queued
+  // on WORKQUEUE.  TASK is the task calling this, which is passed to
+  // do_run; it may be NULL if the jobs need not lock anything.  This
+  // deletes the work before returning, or leaves it to be deleted by
+  // the last helper task.
+  void
+  run(Workqueue* workqueue, const Task* task, size_t helpers);
+
+ protected:
+  // Run job I.  TASK is the task running the job.
+  virtual void
+  do_run(size_t i, const Task* task) = 0;
+
+ private:
+  friend class Parallel_work_task;
+
+  Parallel_work(const Parallel_work&);
+  Parallel_work& operator=(const Parallel_work&);
+
+  // Run jobs until none are left to claim.
+  void
+  run_jobs(const Task*);
+
+  // Drop a reference, deleting the work if it was the last one.
+  void
+  release();
+
+  // Protects the fields below.
+  Lock lock_;
+  // Signalled when the last running job is finished.
+  Condvar condvar_;
+  // The name for the helper tasks.
+  std::string name_;
+  // The number of jobs.
+  size_t count_;
+  // The next job to claim.
+  size_t next_;
+  // The number of jobs being run.
+  size_t running_;
+  // The number of tasks referring to this work.
+  int refs_;
+};
+
 // The workqueue itself.
 
 class Workqueue_threader;
+class Workqueue_deque;
+class Workqueue_stats;
 
 class Workqueue
 {
@@ -216,6 +304,14 @@ class Workqueue
   void
   queue_next(Task*);
 
+  // Add a new independent task to the work queue.  An independent
+  // task is always runnable, takes no locks, and no other task waits
+  // for it.  Independent tasks are queued on per-thread queues and run
+  // without taking the workqueue lock.  When a thread's own queue is
+  // empty it takes tasks from the queues of other threads.
+  void
+  queue_independent(Task*);
+
   // Process all the tasks on the work queue.  This function runs
   // until all tasks have completed.  The argument is the thread
   // number, used only for debugging.
@@ -233,6 +329,16 @@ class Workqueue
   void
   add_blocker(Task_token*);
 
+  // Print statistics about the tasks which were run to stderr.  This
+  // is used for --stats.
+  void
+  print_stats();
+
+  // Write a timeline of the tasks which were run to FILENAME, in the
+  // Chrome trace event format.  This is used for --trace-tasks.
+  void
+  write_task_trace(const char* filename);
+
  private:
   // This class can not be copied.
   Workqueue(const Workqueue&);
@@ -242,9 +348,10 @@ class Workqueue
   void
   add_to_queue(Task_list* queue, Task* t, bool front);
 
-  // Find a runnable task, or wait for one.
+  // Find a runnable task, or wait for one.  Set *IS_INDEPENDENT if
+  // the task is an independent task.
   Task*
-  find_runnable_or_wait(int thread_number);
+  find_runnable_or_wait(int thread_number, bool* is_independent);
 
   // Find a runnable task.
   Task*
@@ -254,6 +361,19 @@ class Workqueue
   Task*
   find_runnable_in_list(Task_list*);
 
+  // Take an independent task from the queue of a thread, or steal
+  // one from another thread.  Return NULL if there is none.
+  Task*
+  pop_independent(int thread_number);
+
+  // Run a task, which is deleted afterward.
+  void
+  run_task(int thread_number, Task*);
+
+  // Run an independent task, which is deleted afterward.
+  void
+  run_independent(int thread_number, Task*);
+
   // Find an run a task.
   bool
   find_and_run_task(int);
@@ -285,9 +405,35 @@ class Workqueue
   // there may be a new Task to execute.
   Condvar condvar_;
 
+  // The queues of independent tasks.  These have their own locks.
+  // Thread N uses queue N modulo DEQUE_COUNT_.
+  Workqueue_deque* deques_;
+  // The number of queues in DEQUES_.
+  int deque_count_;
+  // The number of queues which a thread may be using.  This only
+  // increases, so that queues of cancelled threads are still emptied.
+  volatile int deques_used_;
+  // The number of queues to which new independent tasks are added,
+  // one per desired thread.
+  volatile int active_deques_;
+  // The queue to add the next independent task to, modulo
+  // ACTIVE_DEQUES_.
+  unsigned int next_deque_;
+  // The number of independent tasks queued or running.  This and the
+  // following counters are changed using atomic operations.
+  int independent_;
+  // The number of independent tasks on the queues.
+  int independent_queued_;
+  // The number of threads looking for a task to run or sleeping on
+  // condvar_.
+  int idle_;
+
   // The threading implementation.  This is set at construction time
   // and not changed thereafter.
   Workqueue_threader* threader_;
+  // The statistics about the tasks which were run, or NULL if neither
+  // --stats nor --trace-tasks was used.
+  Workqueue_stats* stats_;
 };
 
 } // End namespace gold.
@@ -527,6 +527,11 @@ class Target_x86_64 : public Sized_target<size, false>
   do_can_check_for_function_pointers() const
   { return !parameters->options().pie(); }
 
+  // Relocating a section does not change any target state.
+  bool
+  do_can_relocate_sections_in_parallel() const
+  { return true; }
+
   // Return the base for a DW_EH_PE_datarel encoding.
   uint64_t
   do_ehframe_datarel_base() const;
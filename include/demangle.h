@@ -159,6 +159,23 @@ cplus_demangle_v3_callback (const char *mangled, int options,
 extern char*
 cplus_demangle_v3 (const char *mangled, int options);
 
+/* A context for demangling many V3 ABI names with the same options,
+   reusing its scratch and output buffers from one name to the next.
+   cplus_demangle_ctx_run returns 1 and points *OUT_BUF at the result
+   (owned by the context, valid until its next use) on success, 0 on
+   error, and -1 on memory allocation failure.  */
+struct cplus_demangle_ctx;
+
+extern struct cplus_demangle_ctx *
+cplus_demangle_ctx_new (int options);
+
+extern int
+cplus_demangle_ctx_run (struct cplus_demangle_ctx *ctx, const char *mangled,
+                        char **out_buf, size_t *out_len);
+
+extern void
+cplus_demangle_ctx_free (struct cplus_demangle_ctx *ctx);
+
 extern int
 java_demangle_v3_callback (const char *mangled,
                            demangle_callbackref callback, void *opaque);
@@ -116,6 +116,9 @@ typedef struct disassemble_info
   /* Set if the user has specifically set the machine type encoded in the
      mach field of this structure.  */
 #define USER_SPECIFIED_MACHINE_TYPE (1 << 29)
+  /* Set if the caller only wants the length of the instruction, and
+     not its text.  A disassembler may then skip printing it.  */
+#define DISASSEMBLE_LENGTH_ONLY (1 << 28)
 
   /* Use internally by the target specific disassembly code.  */
   void *private_data;
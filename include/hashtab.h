@@ -139,6 +139,12 @@ struct GTY(()) htab {
   /* Current size (in entries) of the hash table, as an index into the
      table of primes.  */
   unsigned int size_prime_index;
+
+  /* For tables created by htab_create_tagged, the full hash value of
+     the element stored in each slot, so that probes can reject most
+     non-matching entries without calling eq_f on them.  NULL for
+     ordinary tables.  */
+  hashval_t * GTY((skip)) tags;
 };
 
 typedef struct htab *htab_t;
@@ -160,6 +166,8 @@ extern htab_t	htab_create_alloc_ex (size_t, htab_hash,
 extern htab_t  htab_create_typed_alloc (size_t, htab_hash, htab_eq, htab_del,
 					htab_alloc, htab_alloc, htab_free);
 
+extern htab_t	htab_create_tagged (size_t, htab_hash, htab_eq, htab_del);
+
 /* Backward-compatibility functions.  */
 extern htab_t htab_create (size_t, htab_hash, htab_eq, htab_del);
 extern htab_t htab_try_create (size_t, htab_hash, htab_eq, htab_del);
@@ -177,6 +185,9 @@ extern void **	htab_find_slot (htab_t, const void *, enum insert_option);
 extern void *	htab_find_with_hash (htab_t, const void *, hashval_t);
 extern void **	htab_find_slot_with_hash (htab_t, const void *,
 					  hashval_t, enum insert_option);
+extern void	htab_find_batch_with_hash (htab_t, const void **,
+					   const hashval_t *, size_t,
+					   void **);
 extern void	htab_clear_slot	(htab_t, void **);
 extern void	htab_remove_elt	(htab_t, void *);
 extern void	htab_remove_elt_with_hash (htab_t, void *, hashval_t);
@@ -107,11 +107,13 @@ static size_t cref_symcount;
 /* Used to take a snapshot of the cref hash table when starting to
    add syms from an as-needed library.  */
 static struct bfd_hash_entry **old_table;
+static unsigned int *old_hashes;
 static unsigned int old_size;
 static unsigned int old_count;
+static unsigned int old_used;
 static void *old_tab;
 static void *alloc_mark;
-static size_t tabsize, entsize, refsize;
+static size_t tabsize, hashsize, entsize, refsize;
 static size_t old_symcount;
 
 /* Create an entry in a cref hash table.  */
@@ -230,18 +232,22 @@ handle_asneeded_cref (bfd *abfd ATTRIBUTE_UNUSED,
 	}
 
       tabsize = cref_table.root.size * sizeof (struct bfd_hash_entry *);
-      old_tab = xmalloc (tabsize + entsize + refsize);
+      hashsize = cref_table.root.size * sizeof (unsigned int);
+      old_tab = xmalloc (tabsize + hashsize + entsize + refsize);
 
       alloc_mark = bfd_hash_allocate (&cref_table.root, 1);
       if (alloc_mark == NULL)
 	return FALSE;
 
       memcpy (old_tab, cref_table.root.table, tabsize);
-      old_ent = (char *) old_tab + tabsize;
+      memcpy ((char *) old_tab + tabsize, cref_table.root.hashes, hashsize);
+      old_ent = (char *) old_tab + tabsize + hashsize;
       old_ref = (char *) old_ent + entsize;
       old_table = cref_table.root.table;
+      old_hashes = cref_table.root.hashes;
       old_size = cref_table.root.size;
       old_count = cref_table.root.count;
+      old_used = cref_table.root.used;
       old_symcount = cref_symcount;
 
       for (i = 0; i < cref_table.root.size; i++)
@@ -278,12 +284,15 @@ handle_asneeded_cref (bfd *abfd ATTRIBUTE_UNUSED,
 	  return TRUE;
 	}
 
-      old_ent = (char *) old_tab + tabsize;
+      old_ent = (char *) old_tab + tabsize + hashsize;
       old_ref = (char *) old_ent + entsize;
       cref_table.root.table = old_table;
+      cref_table.root.hashes = old_hashes;
       cref_table.root.size = old_size;
       cref_table.root.count = old_count;
+      cref_table.root.used = old_used;
       memcpy (cref_table.root.table, old_tab, tabsize);
+      memcpy (cref_table.root.hashes, (char *) old_tab + tabsize, hashsize);
       cref_symcount = old_symcount;
 
       for (i = 0; i < cref_table.root.size; i++)
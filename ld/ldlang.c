@@ -300,46 +300,6 @@ walk_wild_section_general (lang_wild_statement_type *ptr,
     }
 }
 
-/* Routines to find a single section given its name.  If there's more
-   than one section with that name, we report that.  */
-
-typedef struct
-{
-  asection *found_section;
-  bfd_boolean multiple_sections_found;
-} section_iterator_callback_data;
-
-static bfd_boolean
-section_iterator_callback (bfd *abfd ATTRIBUTE_UNUSED, asection *s, void *data)
-{
-  section_iterator_callback_data *d = (section_iterator_callback_data *) data;
-
-  if (d->found_section != NULL)
-    {
-      d->multiple_sections_found = TRUE;
-      return TRUE;
-    }
-
-  d->found_section = s;
-  return FALSE;
-}
-
-static asection *
-find_section (lang_input_statement_type *file,
-	      struct wildcard_list *sec,
-	      bfd_boolean *multiple_sections_found)
-{
-  section_iterator_callback_data cb_data = { NULL, FALSE };
-
-  bfd_get_section_by_name_if (file->the_bfd, sec->spec.name,
-			      section_iterator_callback, &cb_data);
-  *multiple_sections_found = cb_data.multiple_sections_found;
-  return cb_data.found_section;
-}
-
-/* Code for handling simple wildcards without going through fnmatch,
-   which can be expensive because of charset translations etc.  */
-
 /* A simple wild is a literal string followed by a single '*',
    where the literal part is at least 4 characters long.  */
 
@@ -350,24 +310,6 @@ is_simple_wild (const char *name)
   return len >= 4 && name[len] == '*' && name[len + 1] == '\0';
 }
 
-static bfd_boolean
-match_simple_wild (const char *pattern, const char *name)
-{
-  /* The first four characters of the pattern are guaranteed valid
-     non-wildcard characters.  So we can go faster.  */
-  if (pattern[0] != name[0] || pattern[1] != name[1]
-      || pattern[2] != name[2] || pattern[3] != name[3])
-    return FALSE;
-
-  pattern += 4;
-  name += 4;
-  while (*pattern != '*')
-    if (*name++ != *pattern++)
-      return FALSE;
-
-  return TRUE;
-}
-
 /* Return the numerical value of the init_priority attribute from
    section name NAME.  */
 
@@ -543,181 +485,351 @@ output_section_callback_tree_to_list (lang_wild_statement_type *ptr,
   free (tree);
 }
 
-/* Specialized, optimized routines for handling different kinds of
-   wildcards */
+/* Matching every input section against the section names of every
+   wild statement in turn is slow when a script has many statements.
+   Instead, the names of the statements which give them are put in an
+   index, keyed by their literal prefix up to the first wildcard
+   character.  The sections of each input file are looked up in the
+   index once, and the matches kept sorted by statement, so that
+   walking a statement over a file visits just the sections which
+   match it.  */
+
+/* A section name in the index.  */
+
+struct wild_pattern
+{
+  /* The next name with the same literal prefix.  */
+  struct wild_pattern *next;
+  /* The spec giving the name, its statement, and its position in the
+     statement.  */
+  struct wildcard_list *spec;
+  lang_wild_statement_type *stmt;
+  unsigned int order;
+  /* How the part of the name after the prefix is matched: the name is
+     not a wildcard, the rest of it is a single '*', or it needs
+     fnmatch.  */
+  enum { wild_literal, wild_star, wild_fnmatch } kind;
+};
 
-static void
-walk_wild_section_specs1_wild0 (lang_wild_statement_type *ptr,
-				lang_input_statement_type *file,
-				callback_t callback,
-				void *data)
-{
-  /* We can just do a hash lookup for the section with the right name.
-     But if that lookup discovers more than one section with the name
-     (should be rare), we fall back to the general algorithm because
-     we would otherwise have to sort the sections to make sure they
-     get processed in the bfd's order.  */
-  bfd_boolean multiple_sections_found;
-  struct wildcard_list *sec0 = ptr->handler_data[0];
-  asection *s0 = find_section (file, sec0, &multiple_sections_found);
-
-  if (multiple_sections_found)
-    walk_wild_section_general (ptr, file, callback, data);
-  else if (s0)
-    walk_wild_consider_section (ptr, file, s0, sec0, callback, data);
+/* The names in the index with one literal prefix.  */
+
+struct wild_prefix
+{
+  const char *prefix;
+  size_t len;
+  hashval_t hash;
+  struct wild_pattern *patterns;
+};
+
+/* A section of an input file matched by a spec of a statement.  */
+
+struct wild_match
+{
+  unsigned int stmt;
+  unsigned int index;
+  unsigned int order;
+  asection *section;
+  struct wildcard_list *spec;
+};
+
+/* The sections of an input file matched by the statements in the
+   index, sorted by statement, then section, then spec.  The section
+   count and last section of the file are kept to notice when its
+   sections change.  */
+
+struct wild_file_matches
+{
+  unsigned int generation;
+  unsigned int section_count;
+  asection *section_last;
+  unsigned int count;
+  struct wild_match *matches;
+};
+
+/* The statements in the index.  WILD_INDEX_BUILT of them were there
+   when the index was last built, which bumped WILD_INDEX_GENERATION.  */
+static lang_wild_statement_type **wild_index_stmts;
+static unsigned int wild_index_count;
+static unsigned int wild_index_alloc;
+static unsigned int wild_index_built;
+static unsigned int wild_index_generation;
+
+/* The index itself, the names in it, and the distinct lengths of its
+   prefixes in increasing order.  */
+static htab_t wild_prefix_table;
+static struct wild_pattern *wild_patterns;
+static size_t *wild_prefix_lens;
+static unsigned int wild_prefix_len_count;
+
+static hashval_t
+wild_prefix_hash (const void *p)
+{
+  return ((const struct wild_prefix *) p)->hash;
 }
 
-static void
-walk_wild_section_specs1_wild1 (lang_wild_statement_type *ptr,
-				lang_input_statement_type *file,
-				callback_t callback,
-				void *data)
+static int
+wild_prefix_eq (const void *p1, const void *p2)
 {
-  asection *s;
-  struct wildcard_list *wildsec0 = ptr->handler_data[0];
+  const struct wild_prefix *w1 = (const struct wild_prefix *) p1;
+  const struct wild_prefix *w2 = (const struct wild_prefix *) p2;
 
-  for (s = file->the_bfd->sections; s != NULL; s = s->next)
-    {
-      const char *sname = bfd_get_section_name (file->the_bfd, s);
-      bfd_boolean skip = !match_simple_wild (wildsec0->spec.name, sname);
+  return w1->len == w2->len && memcmp (w1->prefix, w2->prefix, w1->len) == 0;
+}
 
-      if (!skip)
-	walk_wild_consider_section (ptr, file, s, wildsec0, callback, data);
-    }
+static int
+wild_prefix_len_compare (const void *p1, const void *p2)
+{
+  size_t l1 = *(const size_t *) p1;
+  size_t l2 = *(const size_t *) p2;
+
+  return l1 < l2 ? -1 : l1 > l2;
 }
 
 static void
-walk_wild_section_specs2_wild1 (lang_wild_statement_type *ptr,
-				lang_input_statement_type *file,
-				callback_t callback,
-				void *data)
+wild_index_free (void)
 {
-  asection *s;
-  struct wildcard_list *sec0 = ptr->handler_data[0];
-  struct wildcard_list *wildsec1 = ptr->handler_data[1];
-  bfd_boolean multiple_sections_found;
-  asection *s0 = find_section (file, sec0, &multiple_sections_found);
+  if (wild_prefix_table != NULL)
+    htab_delete (wild_prefix_table);
+  wild_prefix_table = NULL;
+  free (wild_patterns);
+  wild_patterns = NULL;
+  free (wild_prefix_lens);
+  wild_prefix_lens = NULL;
+  wild_prefix_len_count = 0;
+}
+
+/* Build the index from the statements added so far.  */
+
+static void
+wild_index_build (void)
+{
+  unsigned int i, count, npat;
+  struct wild_pattern *pat;
 
-  if (multiple_sections_found)
+  wild_index_free ();
+
+  count = 0;
+  for (i = 0; i < wild_index_count; i++)
     {
-      walk_wild_section_general (ptr, file, callback, data);
-      return;
+      struct wildcard_list *sec;
+
+      for (sec = wild_index_stmts[i]->section_list; sec; sec = sec->next)
+	count++;
     }
 
-  /* Note that if the section was not found, s0 is NULL and
-     we'll simply never succeed the s == s0 test below.  */
-  for (s = file->the_bfd->sections; s != NULL; s = s->next)
+  wild_patterns = (struct wild_pattern *) xmalloc (count * sizeof (*pat));
+  wild_prefix_lens = (size_t *) xmalloc (count * sizeof (size_t));
+  wild_prefix_table = htab_create (count * 2 + 1, wild_prefix_hash,
+				   wild_prefix_eq, free);
+
+  npat = 0;
+  for (i = 0; i < wild_index_count; i++)
     {
-      /* Recall that in this code path, a section cannot satisfy more
-	 than one spec, so if s == s0 then it cannot match
-	 wildspec1.  */
-      if (s == s0)
-	walk_wild_consider_section (ptr, file, s, sec0, callback, data);
-      else
+      lang_wild_statement_type *stmt = wild_index_stmts[i];
+      struct wildcard_list *sec;
+      unsigned int order = 0;
+
+      for (sec = stmt->section_list; sec; sec = sec->next)
 	{
-	  const char *sname = bfd_get_section_name (file->the_bfd, s);
-	  bfd_boolean skip = !match_simple_wild (wildsec1->spec.name, sname);
+	  const char *name = sec->spec.name;
+	  struct wild_prefix key, *ent;
+	  void **slot;
+
+	  pat = &wild_patterns[npat++];
+	  pat->spec = sec;
+	  pat->stmt = stmt;
+	  pat->order = order++;
+	  if (!wildcardp (name))
+	    {
+	      key.len = strlen (name);
+	      pat->kind = wild_literal;
+	    }
+	  else
+	    {
+	      key.len = strcspn (name, "?*[\\");
+	      if (name[key.len] == '*' && name[key.len + 1] == '\0')
+		pat->kind = wild_star;
+	      else
+		pat->kind = wild_fnmatch;
+	    }
 
-	  if (!skip)
-	    walk_wild_consider_section (ptr, file, s, wildsec1, callback,
-					data);
+	  key.prefix = name;
+	  key.hash = iterative_hash (name, key.len, 0);
+	  slot = htab_find_slot_with_hash (wild_prefix_table, &key, key.hash,
+					   INSERT);
+	  ent = (struct wild_prefix *) *slot;
+	  if (ent == NULL)
+	    {
+	      ent = (struct wild_prefix *) xmalloc (sizeof (*ent));
+	      *ent = key;
+	      ent->patterns = NULL;
+	      *slot = ent;
+	      wild_prefix_lens[wild_prefix_len_count++] = key.len;
+	    }
+	  pat->next = ent->patterns;
+	  ent->patterns = pat;
 	}
     }
+
+  /* Keep each prefix length once.  */
+  qsort (wild_prefix_lens, wild_prefix_len_count, sizeof (size_t),
+	 wild_prefix_len_compare);
+  for (count = 0, i = 0; i < wild_prefix_len_count; i++)
+    if (count == 0 || wild_prefix_lens[count - 1] != wild_prefix_lens[i])
+      wild_prefix_lens[count++] = wild_prefix_lens[i];
+  wild_prefix_len_count = count;
+
+  wild_index_built = wild_index_count;
+  wild_index_generation++;
 }
 
+/* Add statement PTR to the index.  */
+
 static void
-walk_wild_section_specs3_wild2 (lang_wild_statement_type *ptr,
-				lang_input_statement_type *file,
-				callback_t callback,
-				void *data)
+wild_index_add (lang_wild_statement_type *ptr)
+{
+  if (wild_index_count == wild_index_alloc)
+    {
+      wild_index_alloc = wild_index_alloc * 2 + 64;
+      wild_index_stmts = (lang_wild_statement_type **)
+	xrealloc (wild_index_stmts,
+		  wild_index_alloc * sizeof (*wild_index_stmts));
+    }
+  ptr->wild_index = wild_index_count;
+  wild_index_stmts[wild_index_count++] = ptr;
+}
+
+static int
+wild_match_compare (const void *p1, const void *p2)
 {
+  const struct wild_match *m1 = (const struct wild_match *) p1;
+  const struct wild_match *m2 = (const struct wild_match *) p2;
+
+  if (m1->stmt != m2->stmt)
+    return m1->stmt < m2->stmt ? -1 : 1;
+  if (m1->index != m2->index)
+    return m1->index < m2->index ? -1 : 1;
+  if (m1->order != m2->order)
+    return m1->order < m2->order ? -1 : 1;
+  return 0;
+}
+
+/* Return the matches of the index for the sections of FILE, looking
+   them up if this has not been done since the index or the sections
+   last changed.  */
+
+static struct wild_file_matches *
+wild_file_matches (lang_input_statement_type *file)
+{
+  bfd *abfd = file->the_bfd;
+  struct wild_file_matches *m = file->wild_matches;
+  unsigned int alloc;
+  unsigned int index;
   asection *s;
-  struct wildcard_list *sec0 = ptr->handler_data[0];
-  struct wildcard_list *wildsec1 = ptr->handler_data[1];
-  struct wildcard_list *wildsec2 = ptr->handler_data[2];
-  bfd_boolean multiple_sections_found;
-  asection *s0 = find_section (file, sec0, &multiple_sections_found);
 
-  if (multiple_sections_found)
+  if (m != NULL
+      && m->generation == wild_index_generation
+      && m->section_count == abfd->section_count
+      && m->section_last == abfd->section_last)
+    return m;
+
+  if (m == NULL)
     {
-      walk_wild_section_general (ptr, file, callback, data);
-      return;
+      m = (struct wild_file_matches *) xmalloc (sizeof (*m));
+      file->wild_matches = m;
     }
+  else
+    free (m->matches);
+  m->count = 0;
+  m->matches = NULL;
+  alloc = 0;
 
-  for (s = file->the_bfd->sections; s != NULL; s = s->next)
+  for (s = abfd->sections, index = 0; s != NULL; s = s->next, index++)
     {
-      if (s == s0)
-	walk_wild_consider_section (ptr, file, s, sec0, callback, data);
-      else
+      const char *sname = bfd_get_section_name (abfd, s);
+      size_t len = strlen (sname);
+      unsigned int l;
+
+      for (l = 0;
+	   l < wild_prefix_len_count && wild_prefix_lens[l] <= len;
+	   l++)
 	{
-	  const char *sname = bfd_get_section_name (file->the_bfd, s);
-	  bfd_boolean skip = !match_simple_wild (wildsec1->spec.name, sname);
+	  struct wild_prefix key, *ent;
+	  struct wild_pattern *pat;
+
+	  key.prefix = sname;
+	  key.len = wild_prefix_lens[l];
+	  key.hash = iterative_hash (sname, key.len, 0);
+	  ent = (struct wild_prefix *) htab_find_with_hash (wild_prefix_table,
+							    &key, key.hash);
+	  if (ent == NULL)
+	    continue;
 
-	  if (!skip)
-	    walk_wild_consider_section (ptr, file, s, wildsec1, callback, data);
-	  else
+	  for (pat = ent->patterns; pat != NULL; pat = pat->next)
 	    {
-	      skip = !match_simple_wild (wildsec2->spec.name, sname);
-	      if (!skip)
-		walk_wild_consider_section (ptr, file, s, wildsec2, callback,
-					    data);
+	      struct wild_match *match;
+
+	      if (pat->kind == wild_literal
+		  ? sname[key.len] != '\0'
+		  : (pat->kind == wild_fnmatch
+		     && fnmatch (pat->spec->spec.name, sname, 0) != 0))
+		continue;
+
+	      if (m->count == alloc)
+		{
+		  alloc = alloc * 2 + 16;
+		  m->matches = (struct wild_match *)
+		    xrealloc (m->matches, alloc * sizeof (*m->matches));
+		}
+	      match = &m->matches[m->count++];
+	      match->stmt = pat->stmt->wild_index;
+	      match->index = index;
+	      match->order = pat->order;
+	      match->section = s;
+	      match->spec = pat->spec;
 	    }
 	}
     }
+
+  qsort (m->matches, m->count, sizeof (*m->matches), wild_match_compare);
+  m->generation = wild_index_generation;
+  m->section_count = abfd->section_count;
+  m->section_last = abfd->section_last;
+  return m;
 }
 
+/* Walk a statement in the index over FILE.  This visits the same
+   sections, in the same order, as walk_wild_section_general.  */
+
 static void
-walk_wild_section_specs4_wild2 (lang_wild_statement_type *ptr,
-				lang_input_statement_type *file,
-				callback_t callback,
-				void *data)
+walk_wild_section_indexed (lang_wild_statement_type *ptr,
+			   lang_input_statement_type *file,
+			   callback_t callback,
+			   void *data)
 {
-  asection *s;
-  struct wildcard_list *sec0 = ptr->handler_data[0];
-  struct wildcard_list *sec1 = ptr->handler_data[1];
-  struct wildcard_list *wildsec2 = ptr->handler_data[2];
-  struct wildcard_list *wildsec3 = ptr->handler_data[3];
-  bfd_boolean multiple_sections_found;
-  asection *s0 = find_section (file, sec0, &multiple_sections_found), *s1;
+  struct wild_file_matches *m;
+  unsigned int stmt = ptr->wild_index;
+  unsigned int lo, hi;
 
-  if (multiple_sections_found)
-    {
-      walk_wild_section_general (ptr, file, callback, data);
-      return;
-    }
+  if (stmt >= wild_index_built)
+    wild_index_build ();
+  m = wild_file_matches (file);
 
-  s1 = find_section (file, sec1, &multiple_sections_found);
-  if (multiple_sections_found)
+  lo = 0;
+  hi = m->count;
+  while (lo < hi)
     {
-      walk_wild_section_general (ptr, file, callback, data);
-      return;
-    }
+      unsigned int mid = lo + (hi - lo) / 2;
 
-  for (s = file->the_bfd->sections; s != NULL; s = s->next)
-    {
-      if (s == s0)
-	walk_wild_consider_section (ptr, file, s, sec0, callback, data);
+      if (m->matches[mid].stmt < stmt)
+	lo = mid + 1;
       else
-	if (s == s1)
-	  walk_wild_consider_section (ptr, file, s, sec1, callback, data);
-	else
-	  {
-	    const char *sname = bfd_get_section_name (file->the_bfd, s);
-	    bfd_boolean skip = !match_simple_wild (wildsec2->spec.name,
-						   sname);
-
-	    if (!skip)
-	      walk_wild_consider_section (ptr, file, s, wildsec2, callback,
-					  data);
-	    else
-	      {
-		skip = !match_simple_wild (wildsec3->spec.name, sname);
-		if (!skip)
-		  walk_wild_consider_section (ptr, file, s, wildsec3,
-					      callback, data);
-	      }
-	  }
+	hi = mid;
     }
+
+  for (; lo < m->count && m->matches[lo].stmt == stmt; lo++)
+    walk_wild_consider_section (ptr, file, m->matches[lo].section,
+				m->matches[lo].spec, callback, data);
 }
 
 static void
@@ -757,8 +869,8 @@ wild_spec_can_overlap (const char *name1, const char *name2)
   return memcmp (name1, name2, min_prefix_len) == 0;
 }
 
-/* Select specialized code to handle various kinds of wildcard
-   statements.  */
+/* Select the code to walk a wild statement over the sections of a
+   file, and note whether wild can sort its sections with a tree.  */
 
 static void
 analyze_walk_wild_section_handler (lang_wild_statement_type *ptr)
@@ -775,18 +887,26 @@ analyze_walk_wild_section_handler (lang_wild_statement_type *ptr)
   ptr->handler_data[2] = NULL;
   ptr->handler_data[3] = NULL;
   ptr->tree = NULL;
+  ptr->wild_index = -1;
+
+  /* Statements which name all their sections go in the index of
+     section names.  Bail out if any of the names are NULL.  (Can this
+     actually happen?  walk_wild_section used to test for it.)  */
+  if (ptr->section_list == NULL)
+    return;
+  for (sec = ptr->section_list; sec != NULL; sec = sec->next)
+    if (sec->spec.name == NULL)
+      return;
+  wild_index_add (ptr);
+  ptr->walk_wild_section_handler = walk_wild_section_indexed;
 
   /* Count how many wildcard_specs there are, and how many of those
-     actually use wildcards in the name.  Also, bail out if any of the
-     wildcard names are NULL. (Can this actually happen?
-     walk_wild_section used to test for it.)  And bail out if any
-     of the wildcards are more complex than a simple string
-     ending in a single '*'.  */
+     actually use wildcards in the name.  Bail out if any of the
+     wildcards are more complex than a simple string ending in a
+     single '*'.  */
   for (sec = ptr->section_list; sec != NULL; sec = sec->next)
     {
       ++sec_count;
-      if (sec->spec.name == NULL)
-	return;
       if (wildcardp (sec->spec.name))
 	{
 	  ++wild_name_count;
@@ -795,10 +915,9 @@ analyze_walk_wild_section_handler (lang_wild_statement_type *ptr)
 	}
     }
 
-  /* The zero-spec case would be easy to optimize but it doesn't
-     happen in practice.  Likewise, more than 4 specs doesn't
-     happen in practice.  */
-  if (sec_count == 0 || sec_count > 4)
+  /* Only a few small combinations of specs have been found worth
+     sorting this way.  */
+  if (sec_count > 4)
     return;
 
   /* Check that no two specs can match the same section.  */
@@ -816,19 +935,10 @@ analyze_walk_wild_section_handler (lang_wild_statement_type *ptr)
   switch (signature)
     {
     case 0x0100:
-      ptr->walk_wild_section_handler = walk_wild_section_specs1_wild0;
-      break;
     case 0x0101:
-      ptr->walk_wild_section_handler = walk_wild_section_specs1_wild1;
-      break;
     case 0x0201:
-      ptr->walk_wild_section_handler = walk_wild_section_specs2_wild1;
-      break;
     case 0x0302:
-      ptr->walk_wild_section_handler = walk_wild_section_specs3_wild2;
-      break;
     case 0x0402:
-      ptr->walk_wild_section_handler = walk_wild_section_specs4_wild2;
       break;
     default:
       return;
@@ -836,9 +946,7 @@ analyze_walk_wild_section_handler (lang_wild_statement_type *ptr)
 
   /* Now fill the data array with pointers to the specs, first the
      specs with non-wildcard names, then the specs with wildcard
-     names.  It's OK to process the specs in different order from the
-     given order, because we've already determined that no section
-     will match more than one spec.  */
+     names.  */
   data_counter = 0;
   for (sec = ptr->section_list; sec != NULL; sec = sec->next)
     if (!wildcardp (sec->spec.name))
@@ -1241,6 +1349,7 @@ lang_finish (void)
   bfd_link_hash_table_free (link_info.output_bfd, link_info.hash);
   bfd_hash_table_free (&lang_definedness_table);
   output_section_statement_table_free ();
+  wild_index_free ();
 }
 
 /*----------------------------------------------------------------------
@@ -6494,7 +6603,12 @@ lang_relax_sections (bfd_boolean need_layout)
 	      lang_reset_memory_regions ();
 
 	      /* Perform another relax pass - this time we know where the
-		 globals are, so can make a better guess.  */
+		 globals are, so can make a better guess.  Every input
+		 section is relaxed again, even one which did not change
+		 on the last pass: whether it can relax depends on the
+		 addresses of whatever its relocs refer to, and on state
+		 some backends share between sections (the GP value,
+		 literal pools, stubs), none of which is visible here.  */
 	      relax_again = FALSE;
 	      lang_size_sections (&relax_again, FALSE);
 	    }
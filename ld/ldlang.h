@@ -305,6 +305,10 @@ typedef struct lang_input_statement_struct
   const char *target;
 
   struct lang_input_statement_flags flags;
+
+  /* The sections of this file matched by the index of section names
+     of wild statements, once they have been looked up.  */
+  struct wild_file_matches *wild_matches;
 } lang_input_statement_type;
 
 typedef struct
@@ -349,6 +353,10 @@ struct lang_wild_statement_struct
   struct wildcard_list *handler_data[4];
   lang_section_bst_type *tree;
   struct flag_info *section_flag_list;
+
+  /* The number of this statement in the index of section names, or -1
+     if it is not in the index.  */
+  int wild_index;
 };
 
 typedef struct lang_address_statement_struct
@@ -485,6 +485,19 @@ d_print_expr_op (struct d_print_info *, int, const struct demangle_component *);
 static void
 d_print_cast (struct d_print_info *, int, const struct demangle_component *);
 
+/* The kinds of name the demangler entry points accept.  */
+
+enum d_demangle_type
+  {
+    DCT_TYPE,
+    DCT_MANGLED,
+    DCT_GLOBAL_CTORS,
+    DCT_GLOBAL_DTORS
+  };
+
+static int d_demangle_classify (const char *, int, enum d_demangle_type *);
+static int d_demangle_info (struct d_info *, enum d_demangle_type, int,
+                            demangle_callbackref, void *);
 static int d_demangle_callback (const char *, int,
                                 demangle_callbackref, void *);
 static char *d_demangle (const char *, int, size_t *);
@@ -5357,41 +5370,93 @@ cplus_demangle_init_info (const char *mangled, int options, size_t len,
   di->expansion = 0;
 }
 
-/* Internal implementation for the demangler.  If MANGLED is a g++ v3 ABI
-   mangled name, return strings in repeated callback giving the demangled
-   name.  OPTIONS is the usual libiberty demangler options.  On success,
-   this returns 1.  On failure, returns 0.  */
+/* Work out what kind of name MANGLED is.  If it is one the demangler
+   handles with OPTIONS, set *PTYPE and return 1; otherwise return 0.  */
 
 static int
-d_demangle_callback (const char *mangled, int options,
-                     demangle_callbackref callback, void *opaque)
+d_demangle_classify (const char *mangled, int options,
+                     enum d_demangle_type *ptype)
 {
-  enum
-    {
-      DCT_TYPE,
-      DCT_MANGLED,
-      DCT_GLOBAL_CTORS,
-      DCT_GLOBAL_DTORS
-    }
-  type;
-  struct d_info di;
-  struct demangle_component *dc;
-  int status;
-
   if (mangled[0] == '_' && mangled[1] == 'Z')
-    type = DCT_MANGLED;
+    *ptype = DCT_MANGLED;
   else if (strncmp (mangled, "_GLOBAL_", 8) == 0
 	   && (mangled[8] == '.' || mangled[8] == '_' || mangled[8] == '$')
 	   && (mangled[9] == 'D' || mangled[9] == 'I')
 	   && mangled[10] == '_')
-    type = mangled[9] == 'I' ? DCT_GLOBAL_CTORS : DCT_GLOBAL_DTORS;
+    *ptype = mangled[9] == 'I' ? DCT_GLOBAL_CTORS : DCT_GLOBAL_DTORS;
   else
     {
       if ((options & DMGL_TYPES) == 0)
 	return 0;
-      type = DCT_TYPE;
+      *ptype = DCT_TYPE;
+    }
+
+  return 1;
+}
+
+/* Demangle the name DI was initialized with, which is of kind TYPE,
+   using the component and substitution arrays DI points to, and pass
+   the result to CALLBACK.  Returns as d_demangle_callback.  */
+
+static int
+d_demangle_info (struct d_info *di, enum d_demangle_type type, int options,
+                 demangle_callbackref callback, void *opaque)
+{
+  struct demangle_component *dc = NULL;
+
+  switch (type)
+    {
+    case DCT_TYPE:
+      dc = cplus_demangle_type (di);
+      break;
+    case DCT_MANGLED:
+      dc = cplus_demangle_mangled_name (di, 1);
+      break;
+    case DCT_GLOBAL_CTORS:
+    case DCT_GLOBAL_DTORS:
+      d_advance (di, 11);
+      dc = d_make_comp (di,
+			(type == DCT_GLOBAL_CTORS
+			 ? DEMANGLE_COMPONENT_GLOBAL_CONSTRUCTORS
+			 : DEMANGLE_COMPONENT_GLOBAL_DESTRUCTORS),
+			d_make_demangle_mangled_name (di, d_str (di)),
+			NULL);
+      d_advance (di, strlen (d_str (di)));
+      break;
     }
 
+  /* If DMGL_PARAMS is set, then if we didn't consume the entire
+     mangled string, then we didn't successfully demangle it.  If
+     DMGL_PARAMS is not set, we didn't look at the trailing
+     parameters.  */
+  if (((options & DMGL_PARAMS) != 0) && d_peek_char (di) != '\0')
+    dc = NULL;
+
+#ifdef CP_DEMANGLE_DEBUG
+  d_dump (dc, 0);
+#endif
+
+  return (dc != NULL)
+         ? cplus_demangle_print_callback (options, dc, callback, opaque)
+         : 0;
+}
+
+/* Internal implementation for the demangler.  If MANGLED is a g++ v3 ABI
+   mangled name, return strings in repeated callback giving the demangled
+   name.  OPTIONS is the usual libiberty demangler options.  On success,
+   this returns 1.  On failure, returns 0.  */
+
+static int
+d_demangle_callback (const char *mangled, int options,
+                     demangle_callbackref callback, void *opaque)
+{
+  enum d_demangle_type type;
+  struct d_info di;
+  int status;
+
+  if (! d_demangle_classify (mangled, options, &type))
+    return 0;
+
   cplus_demangle_init_info (mangled, options, strlen (mangled), &di);
 
   {
@@ -5406,41 +5471,7 @@ d_demangle_callback (const char *mangled, int options,
     di.subs = alloca (di.num_subs * sizeof (*di.subs));
 #endif
 
-    switch (type)
-      {
-      case DCT_TYPE:
-	dc = cplus_demangle_type (&di);
-	break;
-      case DCT_MANGLED:
-	dc = cplus_demangle_mangled_name (&di, 1);
-	break;
-      case DCT_GLOBAL_CTORS:
-      case DCT_GLOBAL_DTORS:
-	d_advance (&di, 11);
-	dc = d_make_comp (&di,
-			  (type == DCT_GLOBAL_CTORS
-			   ? DEMANGLE_COMPONENT_GLOBAL_CONSTRUCTORS
-			   : DEMANGLE_COMPONENT_GLOBAL_DESTRUCTORS),
-			  d_make_demangle_mangled_name (&di, d_str (&di)),
-			  NULL);
-	d_advance (&di, strlen (d_str (&di)));
-	break;
-      }
-
-    /* If DMGL_PARAMS is set, then if we didn't consume the entire
-       mangled string, then we didn't successfully demangle it.  If
-       DMGL_PARAMS is not set, we didn't look at the trailing
-       parameters.  */
-    if (((options & DMGL_PARAMS) != 0) && d_peek_char (&di) != '\0')
-      dc = NULL;
-
-#ifdef CP_DEMANGLE_DEBUG
-    d_dump (dc, 0);
-#endif
-
-    status = (dc != NULL)
-             ? cplus_demangle_print_callback (options, dc, callback, opaque)
-             : 0;
+    status = d_demangle_info (&di, type, options, callback, opaque);
   }
 
   return status;
@@ -5628,6 +5659,117 @@ cplus_demangle_v3_callback (const char *mangled, int options,
   return d_demangle_callback (mangled, options, callback, opaque);
 }
 
+/* Scratch state reused by cplus_demangle_ctx_run across calls.  */
+
+struct cplus_demangle_ctx
+{
+  /* The demangler options given to cplus_demangle_ctx_new.  */
+  int options;
+  /* Component and substitution arrays, grown to fit the longest name
+     demangled so far, and their sizes in entries.  */
+  struct demangle_component *comps;
+  int num_comps;
+  struct demangle_component **subs;
+  int num_subs;
+  /* Output buffer, which holds the result of the last call.  */
+  struct d_growable_string out;
+};
+
+/* Create a context for demangling g++ v3 ABI names with OPTIONS, the
+   usual libiberty demangler options, using cplus_demangle_ctx_run.
+   Return NULL if memory allocation fails.  */
+
+struct cplus_demangle_ctx *
+cplus_demangle_ctx_new (int options)
+{
+  struct cplus_demangle_ctx *ctx;
+
+  ctx = (struct cplus_demangle_ctx *) malloc (sizeof (*ctx));
+  if (ctx == NULL)
+    return NULL;
+
+  ctx->options = options;
+  ctx->comps = NULL;
+  ctx->num_comps = 0;
+  ctx->subs = NULL;
+  ctx->num_subs = 0;
+  d_growable_string_init (&ctx->out, 0);
+  return ctx;
+}
+
+/* Demangle MANGLED like cplus_demangle_v3, but without allocating
+   anything once CTX has grown to fit the names it is given.  On
+   success, return 1 and set *OUT_BUF to the NUL-terminated demangled
+   name and *OUT_LEN to its length; the buffer belongs to CTX and is
+   only valid until the next call with it.  Return 0 if MANGLED is not
+   a name that can be demangled, or -1 on memory allocation failure.
+   Contexts share no state, so separate threads may each use their own
+   context at the same time.  */
+
+int
+cplus_demangle_ctx_run (struct cplus_demangle_ctx *ctx, const char *mangled,
+                        char **out_buf, size_t *out_len)
+{
+  enum d_demangle_type type;
+  struct d_info di;
+
+  if (! d_demangle_classify (mangled, ctx->options, &type))
+    return 0;
+
+  cplus_demangle_init_info (mangled, ctx->options, strlen (mangled), &di);
+
+  if (di.num_comps > ctx->num_comps)
+    {
+      struct demangle_component *comps;
+
+      comps = ((struct demangle_component *)
+	       realloc (ctx->comps, di.num_comps * sizeof (*comps)));
+      if (comps == NULL)
+	return -1;
+      ctx->comps = comps;
+      ctx->num_comps = di.num_comps;
+    }
+  if (di.num_subs > ctx->num_subs)
+    {
+      struct demangle_component **subs;
+
+      subs = ((struct demangle_component **)
+	      realloc (ctx->subs, di.num_subs * sizeof (*subs)));
+      if (subs == NULL)
+	return -1;
+      ctx->subs = subs;
+      ctx->num_subs = di.num_subs;
+    }
+  di.comps = ctx->comps;
+  di.subs = ctx->subs;
+
+  ctx->out.len = 0;
+  ctx->out.allocation_failure = 0;
+  if (! d_demangle_info (&di, type, ctx->options,
+			 d_growable_string_callback_adapter, &ctx->out))
+    return 0;
+  if (ctx->out.allocation_failure)
+    return -1;
+
+  *out_buf = ctx->out.buf;
+  *out_len = ctx->out.len;
+  return 1;
+}
+
+/* Free CTX and its buffers.  */
+
+void
+cplus_demangle_ctx_free (struct cplus_demangle_ctx *ctx)
+{
+  if (ctx == NULL)
+    return;
+
+  free (ctx->comps);
+  free (ctx->subs);
+  free (ctx->out.buf);
+  free (ctx);
+}
+
 /* Demangle a Java symbol.  Java uses a subset of the V3 ABI C++ mangling 
    conventions, but the output formatting is a little different.
    This instructs the C++ demangler not to emit pointer characters ("*"), to
@@ -75,6 +75,24 @@ static hashval_t hash_pointer (const void *);
 static int eq_pointer (const void *, const void *);
 static int htab_expand (htab_t);
 static PTR *find_empty_slot_for_expand (htab_t, hashval_t);
+static hashval_t *htab_alloc_tags (htab_t, size_t);
+static void htab_free_array (htab_t, PTR);
+
+/* Prefetch the memory at ADDR for reading.  */
+#if GCC_VERSION >= 3001
+#define htab_prefetch(addr) __builtin_prefetch (addr)
+#else
+#define htab_prefetch(addr) ((void) 0)
+#endif
+
+/* Nonzero if the slot at INDEX in a table with tag array TAGS may hold
+   an element whose hash value is HASH.  Untagged tables (TAGS == NULL)
+   always have to fall back on calling eq_f.  */
+#define htab_tag_match(tags, index, hash) \
+  ((tags) == NULL || (tags)[index] == (hash))
+
+/* Number of keys htab_find_batch_with_hash prefetches ahead.  */
+#define HTAB_BATCH_SIZE 16
 
 /* At some point, we could make these be NULL, and modify the
    hash-table routines to handle NULL specially; that would avoid
@@ -274,6 +292,29 @@ htab_mod_m2 (hashval_t hash, htab_t htab)
   return 1 + htab_mod_1 (hash, p->prime - 2, p->inv_m2, p->shift);
 }
 
+/* Allocate a tag array of SIZE entries for HTAB, using the same
+   allocator as its entries.  */
+
+static hashval_t *
+htab_alloc_tags (htab_t htab, size_t size)
+{
+  if (htab->alloc_with_arg_f != NULL)
+    return (hashval_t *) (*htab->alloc_with_arg_f) (htab->alloc_arg, size,
+						    sizeof (hashval_t));
+  return (hashval_t *) (*htab->alloc_f) (size, sizeof (hashval_t));
+}
+
+/* Free an array P previously allocated for HTAB.  */
+
+static void
+htab_free_array (htab_t htab, PTR p)
+{
+  if (htab->free_f != NULL)
+    (*htab->free_f) (p);
+  else if (htab->free_with_arg_f != NULL)
+    (*htab->free_with_arg_f) (htab->alloc_arg, p);
+}
+
 /* This function creates table with length slightly longer than given
    source length.  Created hash table is initiated as empty (all the
    hash table entries are HTAB_EMPTY_ENTRY).  The function returns the
@@ -320,6 +361,7 @@ htab_create_alloc_ex (size_t size, htab_hash hash_f, htab_eq eq_f,
   result->alloc_arg = alloc_arg;
   result->alloc_with_arg_f = alloc_f;
   result->free_with_arg_f = free_f;
+  result->tags = NULL;
   return result;
 }
 
@@ -372,6 +414,7 @@ htab_create_typed_alloc (size_t size, htab_hash hash_f, htab_eq eq_f,
   result->del_f = del_f;
   result->alloc_f = alloc_f;
   result->free_f = free_f;
+  result->tags = NULL;
   return result;
 }
 
@@ -391,6 +434,37 @@ htab_set_functions_ex (htab_t htab, htab_hash hash_f, htab_eq eq_f,
   htab->free_with_arg_f = free_f;
 }
 
+/*
+
+@deftypefn Supplemental htab_t htab_create_tagged (size_t @var{size}, @
+htab_hash @var{hash_f}, htab_eq @var{eq_f}, htab_del @var{del_f})
+
+This function creates a hash table like @code{htab_create}, but which
+also records the full hash value of the element in each slot.  Probes
+compare that value before calling @var{eq_f}, so a lookup rarely has
+to touch an element other than the one it is looking for, and the
+table never needs to call @var{hash_f} when it is resized.  This costs
+an extra @code{hashval_t} per slot.
+
+The resulting table is used with the same functions as any other hash
+table.  Callers that insert through @code{htab_find_slot_with_hash}
+must store an element whose hash value is the one they passed in.
+
+@end deftypefn
+
+*/
+
+htab_t
+htab_create_tagged (size_t size, htab_hash hash_f, htab_eq eq_f,
+		    htab_del del_f)
+{
+  htab_t result;
+
+  result = htab_create_alloc (size, hash_f, eq_f, del_f, xcalloc, free);
+  result->tags = htab_alloc_tags (result, htab_size (result));
+  return result;
+}
+
 /* These functions exist solely for backward compatibility.  */
 
 #undef htab_create
@@ -421,6 +495,9 @@ htab_delete (htab_t htab)
       if (entries[i] != HTAB_EMPTY_ENTRY && entries[i] != HTAB_DELETED_ENTRY)
 	(*htab->del_f) (entries[i]);
 
+  if (htab->tags != NULL)
+    htab_free_array (htab, htab->tags);
+
   if (htab->free_f != NULL)
     {
       (*htab->free_f) (entries);
@@ -462,6 +539,11 @@ htab_empty (htab_t htab)
 						           sizeof (PTR *));
       else
 	htab->entries = (PTR *) (*htab->alloc_f) (nsize, sizeof (PTR *));
+      if (htab->tags != NULL)
+	{
+	  htab_free_array (htab, htab->tags);
+	  htab->tags = htab_alloc_tags (htab, nsize);
+	}
      htab->size = nsize;
      htab->size_prime_index = nindex;
     }
@@ -521,6 +603,8 @@ htab_expand (htab_t htab)
   PTR *olimit;
   PTR *p;
   PTR *nentries;
+  hashval_t *otags;
+  hashval_t *ntags;
   size_t nsize, osize, elts;
   unsigned int oindex, nindex;
 
@@ -550,7 +634,19 @@ htab_expand (htab_t htab)
     nentries = (PTR *) (*htab->alloc_f) (nsize, sizeof (PTR *));
   if (nentries == NULL)
     return 0;
+  otags = htab->tags;
+  ntags = NULL;
+  if (otags != NULL)
+    {
+      ntags = htab_alloc_tags (htab, nsize);
+      if (ntags == NULL)
+	{
+	  htab_free_array (htab, nentries);
+	  return 0;
+	}
+    }
   htab->entries = nentries;
+  htab->tags = ntags;
   htab->size = nsize;
   htab->size_prime_index = nindex;
   htab->n_elements -= htab->n_deleted;
@@ -563,19 +659,27 @@ htab_expand (htab_t htab)
 
       if (x != HTAB_EMPTY_ENTRY && x != HTAB_DELETED_ENTRY)
 	{
-	  PTR *q = find_empty_slot_for_expand (htab, (*htab->hash_f) (x));
-
+	  hashval_t hash;
+	  PTR *q;
+
+	  /* A tagged table already knows the hash of each element.  */
+	  if (otags != NULL)
+	    hash = otags[p - oentries];
+	  else
+	    hash = (*htab->hash_f) (x);
+	  q = find_empty_slot_for_expand (htab, hash);
 	  *q = x;
+	  if (ntags != NULL)
+	    ntags[q - nentries] = hash;
 	}
 
       p++;
     }
   while (p < olimit);
 
-  if (htab->free_f != NULL)
-    (*htab->free_f) (oentries);
-  else if (htab->free_with_arg_f != NULL)
-    (*htab->free_with_arg_f) (htab->alloc_arg, oentries);
+  htab_free_array (htab, oentries);
+  if (otags != NULL)
+    htab_free_array (htab, otags);
   return 1;
 }
 
@@ -588,14 +692,18 @@ htab_find_with_hash (htab_t htab, const PTR element, hashval_t hash)
   hashval_t index, hash2;
   size_t size;
   PTR entry;
+  const hashval_t *tags;
 
   htab->searches++;
   size = htab_size (htab);
   index = htab_mod (hash, htab);
+  tags = htab->tags;
 
   entry = htab->entries[index];
   if (entry == HTAB_EMPTY_ENTRY
-      || (entry != HTAB_DELETED_ENTRY && (*htab->eq_f) (entry, element)))
+      || (entry != HTAB_DELETED_ENTRY
+	  && htab_tag_match (tags, index, hash)
+	  && (*htab->eq_f) (entry, element)))
     return entry;
 
   hash2 = htab_mod_m2 (hash, htab);
@@ -608,7 +716,9 @@ htab_find_with_hash (htab_t htab, const PTR element, hashval_t hash)
 
       entry = htab->entries[index];
       if (entry == HTAB_EMPTY_ENTRY
-	  || (entry != HTAB_DELETED_ENTRY && (*htab->eq_f) (entry, element)))
+	  || (entry != HTAB_DELETED_ENTRY
+	      && htab_tag_match (tags, index, hash)
+	      && (*htab->eq_f) (entry, element)))
 	return entry;
     }
 }
@@ -622,6 +732,64 @@ htab_find (htab_t htab, const PTR element)
   return htab_find_with_hash (htab, element, (*htab->hash_f) (element));
 }
 
+/*
+
+@deftypefn Supplemental void htab_find_batch_with_hash (htab_t @var{htab}, @
+const void **@var{elements}, const hashval_t *@var{hashes}, size_t @var{n}, @
+void **@var{results})
+
+Look up each of the @var{n} @var{elements}, whose hash values are given
+in @var{hashes}, as if by @code{htab_find_with_hash}, storing what was
+found (or @code{NULL}) in the corresponding slot of @var{results}.  The
+lookups are done in groups whose first probe slots, and the entries
+they hold, are prefetched before any of them is compared, so the cache
+misses of the group overlap instead of being taken one at a time.
+This works with any hash table, but is most effective on one created
+by @code{htab_create_tagged}, where entries whose tag does not match are
+not prefetched at all.
+
+@end deftypefn
+
+*/
+
+void
+htab_find_batch_with_hash (htab_t htab, const PTR *elements,
+			   const hashval_t *hashes, size_t n, PTR *results)
+{
+  hashval_t index[HTAB_BATCH_SIZE];
+  const hashval_t *tags = htab->tags;
+  size_t i, j, m;
+
+  for (i = 0; i < n; i += m)
+    {
+      m = n - i < HTAB_BATCH_SIZE ? n - i : HTAB_BATCH_SIZE;
+
+      /* First bring in the primary slot of each key...  */
+      for (j = 0; j < m; j++)
+	{
+	  index[j] = htab_mod (hashes[i + j], htab);
+	  htab_prefetch (&htab->entries[index[j]]);
+	  if (tags != NULL)
+	    htab_prefetch (&tags[index[j]]);
+	}
+
+      /* ... then the elements eq_f is going to look at...  */
+      for (j = 0; j < m; j++)
+	{
+	  PTR entry = htab->entries[index[j]];
+
+	  if (entry != HTAB_EMPTY_ENTRY && entry != HTAB_DELETED_ENTRY
+	      && htab_tag_match (tags, index[j], hashes[i + j]))
+	    htab_prefetch (entry);
+	}
+
+      /* ... and only then do the lookups.  */
+      for (j = 0; j < m; j++)
+	results[i + j] = htab_find_with_hash (htab, elements[i + j],
+					      hashes[i + j]);
+    }
+}
+
 /* This function searches for a hash table slot containing an entry
    equal to the given element.  To delete an entry, call this with
    insert=NO_INSERT, then call htab_clear_slot on the slot returned
@@ -638,6 +806,7 @@ htab_find_slot_with_hash (htab_t htab, const PTR element,
   hashval_t index, hash2;
   size_t size;
   PTR entry;
+  hashval_t *tags;
 
   size = htab_size (htab);
   if (insert == INSERT && size * 3 <= htab->n_elements * 4)
@@ -648,6 +817,7 @@ htab_find_slot_with_hash (htab_t htab, const PTR element,
     }
 
   index = htab_mod (hash, htab);
+  tags = htab->tags;
 
   htab->searches++;
   first_deleted_slot = NULL;
@@ -657,7 +827,8 @@ htab_find_slot_with_hash (htab_t htab, const PTR element,
     goto empty_entry;
   else if (entry == HTAB_DELETED_ENTRY)
     first_deleted_slot = &htab->entries[index];
-  else if ((*htab->eq_f) (entry, element))
+  else if (htab_tag_match (tags, index, hash)
+	   && (*htab->eq_f) (entry, element))
     return &htab->entries[index];
       
   hash2 = htab_mod_m2 (hash, htab);
@@ -676,7 +847,8 @@ htab_find_slot_with_hash (htab_t htab, const PTR element,
 	  if (!first_deleted_slot)
 	    first_deleted_slot = &htab->entries[index];
 	}
-      else if ((*htab->eq_f) (entry, element))
+      else if (htab_tag_match (tags, index, hash)
+	       && (*htab->eq_f) (entry, element))
 	return &htab->entries[index];
     }
 
@@ -688,10 +860,14 @@ htab_find_slot_with_hash (htab_t htab, const PTR element,
     {
       htab->n_deleted--;
       *first_deleted_slot = HTAB_EMPTY_ENTRY;
+      if (tags != NULL)
+	tags[first_deleted_slot - htab->entries] = hash;
       return first_deleted_slot;
     }
 
   htab->n_elements++;
+  if (tags != NULL)
+    tags[index] = hash;
   return &htab->entries[index];
 }
 
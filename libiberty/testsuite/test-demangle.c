@@ -182,6 +182,7 @@ main(argc, argv)
   char *result;
   int failures = 0;
   int tests = 0;
+  struct cplus_demangle_ctx *ctx;
 
   if (argc > 1)
     {
@@ -193,6 +194,10 @@ main(argc, argv)
   input.data = 0;
   expect.data = 0;
 
+  /* One context shared by all the gnu-v3 tests, to check that reusing
+     its buffers gives the same results as cplus_demangle.  */
+  ctx = cplus_demangle_ctx_new (DMGL_PARAMS | DMGL_ANSI | DMGL_TYPES);
+
   for (;;)
     {
       const char *inp;
@@ -322,6 +327,23 @@ main(argc, argv)
 	  fail (lineno, format.data, input.data, result, expect.data);
 	  failures++;
 	}
+
+      if (style == gnu_v3_demangling && !ret_postfix && !ret_drop)
+	{
+	  char *ctx_result;
+	  size_t ctx_len;
+
+	  if (cplus_demangle_ctx_run (ctx, inp, &ctx_result, &ctx_len) != 1)
+	    ctx_result = NULL;
+	  if (result && ctx_result
+	      ? strcmp (result, ctx_result) != 0 || strlen (result) != ctx_len
+	      : result != ctx_result)
+	    {
+	      fail (lineno, format.data, input.data, ctx_result,
+		    result ? result : "(null)");
+	      failures++;
+	    }
+	}
       free (result);
 
       if (no_params)
@@ -343,6 +365,7 @@ main(argc, argv)
   free (format.data);
   free (input.data);
   free (expect.data);
+  cplus_demangle_ctx_free (ctx);
 
   printf ("%s: %d tests, %d failures\n", argv[0], tests, failures);
   return failures ? 1 : 0;
@@ -12655,6 +12655,16 @@ print_insn (bfd_vma pc, disassemble_info *info)
       && (used_prefixes & PREFIX_DATA) != 0)
     all_prefixes[last_data_prefix] = 0;
 
+  /* The instruction has been decoded.  A caller that only wants its
+     length has no use for the text, and printing the operands can
+     mean looking up symbols for their addresses.  */
+  if ((info->flags & DISASSEMBLE_LENGTH_ONLY) != 0)
+    {
+      if ((codep - start_codep) > MAX_CODE_LENGTH)
+	return MAX_CODE_LENGTH;
+      return codep - priv.the_buffer;
+    }
+
   prefix_length = 0;
   for (i = 0; i < (int) ARRAY_SIZE (all_prefixes); i++)
     if (all_prefixes[i])
@@ -65,6 +65,7 @@ MEMOPS_INLINE void \
 XCONCAT2 (SETMEM,mode) (SIM_CPU *cpu, IADDR pc, ADDR a, mode val) \
 { \
   PROFILE_COUNT_WRITE (cpu, a, XCONCAT2 (MODE_,mode)); \
+  SCACHE_CHECK_WRITE (cpu, a, size); \
   /* Don't read anything into "unaligned" here.  Bad name choice.  */ \
   XCONCAT2 (sim_core_write_unaligned_,size) (cpu, pc, write_map, a, val); \
 }
@@ -142,6 +143,7 @@ MEMOPS_INLINE void \
 XCONCAT2 (SETMEM,mode) (SIM_CPU *cpu, IADDR pc, ADDR a, mode val) \
 { \
   PROFILE_COUNT_WRITE (cpu, a, XCONCAT2 (MODE_,mode)); \
+  SCACHE_CHECK_WRITE (cpu, a, size); \
   /* Don't read anything into "unaligned" here.  Bad name choice.  */ \
   XCONCAT2 (sim_core_write_unaligned_,size) (cpu, pc, write_map, a, val); \
 }
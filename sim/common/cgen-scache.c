@@ -284,6 +284,10 @@ scache_flush_cpu (SIM_CPU *cpu)
      "last entry" marker during allocation.  */
   for (i = 0; i < n; ++i)
     CPU_SCACHE_HASH_TABLE (cpu) [i] . pc = UNUSED_ADDR;
+  /* Any pbb still running holds stale chain pointers.  */
+  CPU_SCACHE_FLUSHED_P (cpu) = 1;
+  CPU_SCACHE_PBB_LOW (cpu) = ~ (IADDR) 0;
+  CPU_SCACHE_PBB_HIGH (cpu) = 0;
 #else
   {
     int elm_size = IMP_PROPS_SCACHE_ELM_SIZE (MACH_IMP_PROPS (CPU_MACH (cpu)));
@@ -75,6 +75,19 @@ typedef struct cpu_scache {
   /* Target's branch address.  */
   IADDR pbb_br_npc;
 #define CPU_PBB_BR_NPC(cpu) ((cpu) -> cgen_cpu.scache.pbb_br_npc)
+
+  /* Non-zero if the cache has been flushed since the last pbb was
+     compiled.  Pbbs are chained directly to one another, so the pbb
+     running at the time of the flush must not follow or patch its chain
+     pointers; it must return to the pbb compiler instead.  */
+  int flushed_p;
+#define CPU_SCACHE_FLUSHED_P(cpu) ((cpu) -> cgen_cpu.scache.flushed_p)
+  /* Range [low,high) of target addresses covered by compiled pbbs.
+     A write into this range may modify cached code and flushes the
+     cache.  */
+  IADDR pbb_low, pbb_high;
+#define CPU_SCACHE_PBB_LOW(cpu) ((cpu) -> cgen_cpu.scache.pbb_low)
+#define CPU_SCACHE_PBB_HIGH(cpu) ((cpu) -> cgen_cpu.scache.pbb_high)
 #endif /* WITH_SCACHE_PBB */
 
 #if WITH_PROFILE_SCACHE_P
@@ -120,6 +133,19 @@ extern SCACHE *scache_lookup_or_alloc (SIM_CPU *, IADDR, int, SCACHE **);
 extern void scache_flush (SIM_DESC);
 /* Flush a cpu's scache.  */
 extern void scache_flush_cpu (SIM_CPU *);
+
+/* Flush CPU's scache if a SIZE byte write to ADDR may have modified
+   code in a compiled pbb.  */
+#if WITH_SCACHE_PBB
+#define SCACHE_CHECK_WRITE(cpu, addr, size) \
+do { \
+  if ((addr) < CPU_SCACHE_PBB_HIGH (cpu) \
+      && (addr) + (size) > CPU_SCACHE_PBB_LOW (cpu)) \
+    scache_flush_cpu (cpu); \
+} while (0)
+#else
+#define SCACHE_CHECK_WRITE(cpu, addr, size)
+#endif
 
 /* Scache profiling support.  */
 
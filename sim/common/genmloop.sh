@@ -881,6 +881,8 @@ INLINE SEM_PC
   pc = GET_H_PC ();
 
   new_vpc = scache_lookup_or_alloc (current_cpu, pc, max_insns, &sc);
+  /* Chain pointers are valid again from here on.  */
+  CPU_SCACHE_FLUSHED_P (current_cpu) = 0;
   if (! new_vpc)
     {
       /* Leading '_' to avoid collision with mainloop.in.  */
@@ -972,6 +974,12 @@ cat << EOF
       /* Update the pointer to the next free entry, may not have used as
 	 many entries as was asked for.  */
       CPU_SCACHE_NEXT_FREE (current_cpu) = sc;
+      /* Record the extent of the compiled code so writes to it can
+	 flush the cache.  */
+      if (GET_H_PC () < CPU_SCACHE_PBB_LOW (current_cpu))
+	CPU_SCACHE_PBB_LOW (current_cpu) = GET_H_PC ();
+      if (pc > CPU_SCACHE_PBB_HIGH (current_cpu))
+	CPU_SCACHE_PBB_HIGH (current_cpu) = pc;
       /* Record length of chain if profiling.
 	 This includes virtual insns since they count against
 	 max_insns too.  */
@@ -1004,6 +1012,10 @@ INLINE SEM_PC
       || STATE_EVENTS (CPU_STATE (current_cpu))->work_pending)
     CPU_RUNNING_P (current_cpu) = 0;
 
+  /* If the cache was flushed while running this block, its chain
+     pointers are stale.  */
+  if (CPU_SCACHE_FLUSHED_P (current_cpu))
+    return CPU_SCACHE_PBB_BEGIN (current_cpu);
   /* If chained to next block, go straight to it.  */
   if (abuf->fields.chain.next)
     return abuf->fields.chain.next;
@@ -1065,6 +1077,10 @@ INLINE SEM_PC
       new_vpc_ptr = &abuf->fields.chain.branch_target;
     }
 
+  /* If the cache was flushed while running this block, its chain
+     pointers are stale.  */
+  if (CPU_SCACHE_FLUSHED_P (current_cpu))
+    return CPU_SCACHE_PBB_BEGIN (current_cpu);
   /* If chained to next block, go straight to it.  */
   if (*new_vpc_ptr)
     return *new_vpc_ptr;
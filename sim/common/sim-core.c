@@ -80,6 +80,11 @@ sim_core_uninstall (SIM_DESC sd)
       free (tbd);
     }
     core->common.map[map].first = NULL;
+    core->common.map[map].last_hit = NULL;
+    if (core->common.map[map].page_index != NULL)
+      free (core->common.map[map].page_index);
+    core->common.map[map].page_index = NULL;
+    core->common.map[map].nr_pages = 0;
   }
 }
 #endif
@@ -169,6 +174,78 @@ new_sim_core_mapping (SIM_DESC sd,
 #endif
 
 
+/* Rebuild the page index of ACCESS_MAP after its list of mappings
+   has changed, and discard the last-hit cache.  Each page records the
+   first mapping (in search order) that intersects it, provided that
+   mapping covers the entire page.  No index is kept when the mappings
+   span too many pages.  */
+
+#if EXTERN_SIM_CORE_P
+static void
+sim_core_map_index (sim_core_map *access_map)
+{
+  sim_core_mapping *mapping;
+  address_word lo;
+  address_word hi;
+  unsigned long nr_pages;
+  unsigned char *claimed;
+
+  access_map->last_hit = NULL;
+  if (access_map->page_index != NULL)
+    free (access_map->page_index);
+  access_map->page_index = NULL;
+  access_map->nr_pages = 0;
+
+  if (access_map->first == NULL)
+    return;
+
+  /* determine the span of the mapped pages */
+  lo = access_map->first->base;
+  hi = access_map->first->bound;
+  for (mapping = access_map->first; mapping != NULL; mapping = mapping->next)
+    {
+      if (mapping->base < lo)
+	lo = mapping->base;
+      if (mapping->bound > hi)
+	hi = mapping->bound;
+    }
+  lo >>= SIM_CORE_PAGE_SHIFT;
+  hi >>= SIM_CORE_PAGE_SHIFT;
+  if (hi - lo >= SIM_CORE_MAX_PAGES)
+    return;
+  nr_pages = (hi - lo) + 1;
+
+  access_map->page_index = NZALLOC (sim_core_mapping *, nr_pages);
+  access_map->page_base = lo << SIM_CORE_PAGE_SHIFT;
+  access_map->nr_pages = nr_pages;
+
+  /* Walk the mappings in search order; the first mapping to touch a
+     page claims it, recording itself only if it covers the whole
+     page.  */
+  claimed = NZALLOC (unsigned char, nr_pages);
+  for (mapping = access_map->first; mapping != NULL; mapping = mapping->next)
+    {
+      unsigned long page = (mapping->base >> SIM_CORE_PAGE_SHIFT) - lo;
+      unsigned long last = (mapping->bound >> SIM_CORE_PAGE_SHIFT) - lo;
+      for (; page <= last; page++)
+	{
+	  address_word page_lo;
+	  address_word page_hi;
+	  if (claimed[page])
+	    continue;
+	  claimed[page] = 1;
+	  page_lo = access_map->page_base
+	    + ((address_word) page << SIM_CORE_PAGE_SHIFT);
+	  page_hi = page_lo + (((address_word) 1 << SIM_CORE_PAGE_SHIFT) - 1);
+	  if (mapping->base <= page_lo && mapping->bound >= page_hi)
+	    access_map->page_index[page] = mapping;
+	}
+    }
+  free (claimed);
+}
+#endif
+
+
 #if EXTERN_SIM_CORE_P
 static void
 sim_core_map_attach (SIM_DESC sd,
@@ -265,6 +342,8 @@ sim_core_map_attach (SIM_DESC sd,
 					space, addr, nr_bytes, modulo,
 					client, buffer, free_buffer);
   (*last_mapping)->next = next_mapping;
+
+  sim_core_map_index (access_map);
 }
 #endif
 
@@ -426,6 +505,7 @@ sim_core_map_detach (SIM_DESC sd,
 	  if (dead->free_buffer != NULL)
 	    free (dead->free_buffer);
 	  free (dead);
+	  sim_core_map_index (access_map);
 	  return;
 	}
     }
@@ -472,16 +552,76 @@ sim_core_find_mapping (sim_core_common *core,
 		       sim_cpu *cpu, /* abort => cpu != NULL */
 		       sim_cia cia)
 {
-  sim_core_mapping *mapping = core->map[map].first;
+  sim_core_map *access_map = &core->map[map];
+  sim_core_mapping *mapping;
+  address_word hit_base;
+  address_word hit_bound;
   ASSERT ((addr & (nr_bytes - 1)) == 0); /* must be aligned */
   ASSERT ((addr + (nr_bytes - 1)) >= addr); /* must not wrap */
   ASSERT (!abort || cpu != NULL); /* abort needs a non null CPU */
-  while (mapping != NULL)
+
+  /* same region as the last access? */
+  if (access_map->last_hit != NULL
+      && addr >= access_map->hit_base
+      && (addr + (nr_bytes - 1)) <= access_map->hit_bound)
+    return access_map->last_hit;
+
+  /* a page wholly covered by a single mapping? */
+  if (access_map->page_index != NULL
+      && addr >= access_map->page_base)
+    {
+      unsigned long page = ((addr - access_map->page_base)
+			    >> SIM_CORE_PAGE_SHIFT);
+      if (page < access_map->nr_pages
+	  && (mapping = access_map->page_index[page]) != NULL
+	  && (addr + (nr_bytes - 1)) <= mapping->bound)
+	{
+	  access_map->last_hit = mapping;
+	  access_map->hit_base = addr & ~(((address_word) 1
+					   << SIM_CORE_PAGE_SHIFT) - 1);
+	  access_map->hit_bound = (access_map->hit_base
+				   + (((address_word) 1
+				       << SIM_CORE_PAGE_SHIFT) - 1));
+	  return mapping;
+	}
+    }
+
+  /* Search the list, narrowing [HIT_BASE, HIT_BOUND] to exclude every
+     earlier mapping so that the match can be cached for the window
+     over which it is the first match.  */
+  hit_base = 0;
+  hit_bound = (address_word) -1;
+  for (mapping = access_map->first; mapping != NULL; mapping = mapping->next)
     {
       if (addr >= mapping->base
 	  && (addr + (nr_bytes - 1)) <= mapping->bound)
-	return mapping;
-      mapping = mapping->next;
+	{
+	  if (hit_base <= hit_bound)
+	    {
+	      access_map->last_hit = mapping;
+	      access_map->hit_base = (hit_base > mapping->base
+				      ? hit_base : mapping->base);
+	      access_map->hit_bound = (hit_bound < mapping->bound
+				       ? hit_bound : mapping->bound);
+	    }
+	  return mapping;
+	}
+      if (mapping->bound < addr)
+	{
+	  if (mapping->bound >= hit_base)
+	    hit_base = mapping->bound + 1;
+	}
+      else if (mapping->base > addr)
+	{
+	  if (mapping->base <= hit_bound)
+	    hit_bound = mapping->base - 1;
+	}
+      else
+	{
+	  /* partial overlap with the access; do not cache */
+	  hit_base = 1;
+	  hit_bound = 0;
+	}
     }
   if (abort)
     {
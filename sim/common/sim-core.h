@@ -68,9 +68,39 @@ struct _sim_core_mapping {
   sim_core_mapping *next;
 };
 
+/* Each access map keeps, in addition to the ordered list of
+   mappings, a cache of the mapping last found by
+   sim_core_find_mapping together with the address window over which
+   that mapping is known to be the first match.  Since the per-CPU
+   maps are copies of the global map, each processor gets its own
+   last-hit cache.
+
+   When the mapped addresses span no more than SIM_CORE_MAX_PAGES
+   pages, the map also carries a flat page index, giving for each page
+   the mapping that fully covers it (or NULL when the page is unmapped
+   or only partially covered, in which case the list is searched).
+   The index is owned by the global map and rebuilt whenever a
+   mapping is attached or detached.  */
+
+#ifndef SIM_CORE_PAGE_SHIFT
+#define SIM_CORE_PAGE_SHIFT 12
+#endif
+
+#ifndef SIM_CORE_MAX_PAGES
+#define SIM_CORE_MAX_PAGES (1 << 16)
+#endif
+
 typedef struct _sim_core_map sim_core_map;
 struct _sim_core_map {
   sim_core_mapping *first;
+  /* last-hit cache */
+  sim_core_mapping *last_hit;
+  address_word hit_base;
+  address_word hit_bound;
+  /* page index */
+  sim_core_mapping **page_index;
+  address_word page_base;
+  unsigned long nr_pages;
 };
 
 
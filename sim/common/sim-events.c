@@ -25,6 +25,7 @@
 
 #include "sim-main.h"
 #include "sim-assert.h"
+#include "libiberty.h"
 
 #ifdef HAVE_STRING_H
 #include <string.h>
@@ -104,6 +105,10 @@ struct _sim_event {
   unsigned64 lb64;
   /* trace info (if any) */
   char *trace;
+  /* timer queue - position in the heap plus one (zero when not
+     queued) and the order in which the event was scheduled */
+  int queue_index;
+  unsigned64 sequence;
   /* list */
   sim_event *next;
 };
@@ -130,7 +135,12 @@ struct _sim_event {
    To avoid the need to use 64bit arithmetic, the event queue always
    contains at least one event scheduled every 16 000 ticks.  This
    limits the time from event counter to values less than
-   16 000. */
+   16 000.
+
+   The timer events are kept in a binary heap ordered by their time
+   and, for events due at the same time, by the order in which they
+   were scheduled, so that scheduling or descheduling an event costs
+   O(log N) rather than a walk of the queue.  */
 
 
 #if !defined (SIM_EVENTS_POLL_RATE)
@@ -161,7 +171,8 @@ do \
 while (0)
 
 
-/* event queue iterator - don't iterate over the held queue. */
+/* watchpoint queue iterator - don't iterate over the held queue or
+   the timer heap. */
 
 #if EXTERN_SIM_EVENTS_P
 static sim_event **
@@ -169,8 +180,6 @@ next_event_queue (SIM_DESC sd,
 		  sim_event **queue)
 {
   if (queue == NULL)
-    return &STATE_EVENTS (sd)->queue;
-  else if (queue == &STATE_EVENTS (sd)->queue)
     return &STATE_EVENTS (sd)->watchpoints;
   else if (queue == &STATE_EVENTS (sd)->watchpoints)
     return &STATE_EVENTS (sd)->watchedpoints;
@@ -203,6 +212,7 @@ STATIC_SIM_EVENTS (MODULE_UNINSTALL_FN) sim_events_uninstall;
 STATIC_SIM_EVENTS (MODULE_INIT_FN) sim_events_init;
 STATIC_SIM_EVENTS (MODULE_RESUME_FN) sim_events_resume;
 STATIC_SIM_EVENTS (MODULE_SUSPEND_FN) sim_events_suspend;
+STATIC_SIM_EVENTS (MODULE_INFO_FN) sim_events_info;
 #endif
 
 #if EXTERN_SIM_EVENTS_P
@@ -214,6 +224,7 @@ sim_events_install (SIM_DESC sd)
   sim_module_add_init_fn (sd, sim_events_init);
   sim_module_add_resume_fn (sd, sim_events_resume);
   sim_module_add_suspend_fn (sd, sim_events_suspend);
+  sim_module_add_info_fn (sd, sim_events_info);
   return SIM_RC_OK;
 }
 #endif
@@ -254,8 +265,29 @@ sim_events_suspend (SIM_DESC sd)
 static void
 sim_events_uninstall (SIM_DESC sd)
 {
+  sim_events *events = STATE_EVENTS (sd);
   SIM_ASSERT (STATE_MAGIC (sd) == SIM_MAGIC_NUMBER);
   /* FIXME: free buffers, etc. */
+  if (events->queue != NULL)
+    free (events->queue);
+  events->queue = NULL;
+  events->nr_queued = 0;
+  events->queue_size = 0;
+}
+#endif
+
+
+/* Report statistics on the event queue.  */
+
+#if EXTERN_SIM_EVENTS_P
+static void
+sim_events_info (SIM_DESC sd, int verbose)
+{
+  sim_events *events = STATE_EVENTS (sd);
+  sim_io_printf (sd, "Events scheduled: %lu, pending: %d, most pending: %d\n",
+		 (unsigned long) events->nr_scheduled,
+		 events->nr_queued,
+		 events->max_nr_queued);
 }
 #endif
 
@@ -321,7 +353,17 @@ sim_events_init (SIM_DESC sd)
   if (events->held == NULL)
     events->held = NZALLOC (sim_event, MAX_NR_SIGNAL_SIM_EVENTS);
 
-  /* drain the normal queues */
+  /* drain the timer queue */
+  while (events->nr_queued > 0)
+    {
+      sim_event *dead = events->queue[--events->nr_queued];
+      dead->queue_index = 0;
+      sim_events_free (sd, dead);
+    }
+  events->nr_scheduled = 0;
+  events->max_nr_queued = 0;
+
+  /* drain the watchpoint queues */
   {
     sim_event **queue = NULL;
     while ((queue = next_event_queue (sd, queue)) != NULL)
@@ -349,7 +391,7 @@ sim_events_init (SIM_DESC sd)
 
   /* from now on, except when the large-int event is being processed
      the event queue is non empty */
-  SIM_ASSERT (events->queue != NULL);
+  SIM_ASSERT (events->nr_queued > 0);
 
   return SIM_RC_OK;
 }
@@ -393,16 +435,111 @@ sim_events_remain_time (SIM_DESC sd, sim_event *event)
 
 
 
+/* Timer heap operations.  */
+
+STATIC_INLINE_SIM_EVENTS\
+(int)
+sim_events_before (sim_event *a,
+		   sim_event *b)
+{
+  return (a->time_of_event < b->time_of_event
+	  || (a->time_of_event == b->time_of_event
+	      && a->sequence < b->sequence));
+}
+
+
+STATIC_INLINE_SIM_EVENTS\
+(void)
+sim_events_heap_set (sim_events *events,
+		     int i,
+		     sim_event *event)
+{
+  events->queue[i] = event;
+  event->queue_index = i + 1;
+}
+
+
+/* Move the event at position I of the heap towards the root until it
+   is not due before its parent.  */
+
+STATIC_INLINE_SIM_EVENTS\
+(void)
+sim_events_heap_up (sim_events *events,
+		    int i)
+{
+  sim_event *event = events->queue[i];
+  while (i > 0)
+    {
+      int parent = (i - 1) / 2;
+      if (!sim_events_before (event, events->queue[parent]))
+	break;
+      sim_events_heap_set (events, i, events->queue[parent]);
+      i = parent;
+    }
+  sim_events_heap_set (events, i, event);
+}
+
+
+/* Move the event at position I of the heap away from the root until
+   neither of its children is due before it.  */
+
+STATIC_INLINE_SIM_EVENTS\
+(void)
+sim_events_heap_down (sim_events *events,
+		      int i)
+{
+  sim_event *event = events->queue[i];
+  while (1)
+    {
+      int child = 2 * i + 1;
+      if (child >= events->nr_queued)
+	break;
+      if (child + 1 < events->nr_queued
+	  && sim_events_before (events->queue[child + 1],
+				events->queue[child]))
+	child += 1;
+      if (!sim_events_before (events->queue[child], event))
+	break;
+      sim_events_heap_set (events, i, events->queue[child]);
+      i = child;
+    }
+  sim_events_heap_set (events, i, event);
+}
+
+
+/* Remove and return the event at position I of the heap.  */
+
+STATIC_INLINE_SIM_EVENTS\
+(sim_event *)
+sim_events_heap_remove (sim_events *events,
+			int i)
+{
+  sim_event *dead = events->queue[i];
+  events->nr_queued -= 1;
+  if (i < events->nr_queued)
+    {
+      events->queue[i] = events->queue[events->nr_queued];
+      if (i > 0
+	  && sim_events_before (events->queue[i], events->queue[(i - 1) / 2]))
+	sim_events_heap_up (events, i);
+      else
+	sim_events_heap_down (events, i);
+    }
+  dead->queue_index = 0;
+  return dead;
+}
+
+
 STATIC_INLINE_SIM_EVENTS\
 (void)
 update_time_from_event (SIM_DESC sd)
 {
   sim_events *events = STATE_EVENTS (sd);
   signed64 current_time = sim_events_time (sd);
-  if (events->queue != NULL)
+  if (events->nr_queued > 0)
     {
-      events->time_of_event = events->queue->time_of_event;
-      events->time_from_event = (events->queue->time_of_event - current_time);
+      events->time_of_event = events->queue[0]->time_of_event;
+      events->time_from_event = (events->queue[0]->time_of_event - current_time);
     }
   else
     {
@@ -411,12 +548,10 @@ update_time_from_event (SIM_DESC sd)
     }
   if (ETRACE_P)
     {
-      sim_event *event;
       int i;
-      for (event = events->queue, i = 0;
-	   event != NULL;
-	   event = event->next, i++)
+      for (i = 0; i < events->nr_queued; i++)
 	{
+	  sim_event *event = events->queue[i];
 	  ETRACE ((_ETRACE,
 		   "event time-from-event - time %ld, delta %ld - event %d, tag 0x%lx, time %ld, handler 0x%lx, data 0x%lx%s%s\n",
 		   (long)current_time,
@@ -441,32 +576,28 @@ insert_sim_event (SIM_DESC sd,
 		  signed64 delta)
 {
   sim_events *events = STATE_EVENTS (sd);
-  sim_event *curr;
-  sim_event **prev;
-  signed64 time_of_event;
 
   if (delta < 0)
     sim_io_error (sd, "what is past is past!\n");
 
-  /* compute when the event should occur */
-  time_of_event = sim_events_time (sd) + delta;
+  /* compute when the event should occur; events due at the same time
+     occur in the order they were scheduled */
+  new_event->time_of_event = sim_events_time (sd) + delta;
+  new_event->sequence = events->nr_scheduled++;
 
-  /* find the queue insertion point - things are time ordered */
-  prev = &events->queue;
-  curr = events->queue;
-  while (curr != NULL && time_of_event >= curr->time_of_event)
+  /* insert it */
+  if (events->nr_queued == events->queue_size)
     {
-      SIM_ASSERT (curr->next == NULL
-		  || curr->time_of_event <= curr->next->time_of_event);
-      prev = &curr->next;
-      curr = curr->next;
+      events->queue_size = (events->queue_size == 0
+			    ? 64 : events->queue_size * 2);
+      events->queue = xrealloc (events->queue,
+				events->queue_size * sizeof (sim_event *));
     }
-  SIM_ASSERT (curr == NULL || time_of_event < curr->time_of_event);
-
-  /* insert it */
-  new_event->next = curr;
-  *prev = new_event;
-  new_event->time_of_event = time_of_event;
+  events->queue[events->nr_queued] = new_event;
+  events->nr_queued += 1;
+  sim_events_heap_up (events, events->nr_queued - 1);
+  if (events->nr_queued > events->max_nr_queued)
+    events->max_nr_queued = events->nr_queued;
 
   /* adjust the time until the first event */
   update_time_from_event (sd);
@@ -791,32 +922,43 @@ sim_events_deschedule (SIM_DESC sd,
   sim_event *to_remove = (sim_event*)event_to_remove;
   if (event_to_remove != NULL)
     {
-      sim_event **queue = NULL;
-      while ((queue = next_event_queue (sd, queue)) != NULL)
+      sim_event *dead = NULL;
+      int i = to_remove->queue_index - 1;
+      if (i >= 0 && i < events->nr_queued && events->queue[i] == to_remove)
+	dead = sim_events_heap_remove (events, i);
+      else
 	{
-	  sim_event **ptr_to_current;
-	  for (ptr_to_current = queue;
-	       *ptr_to_current != NULL && *ptr_to_current != to_remove;
-	       ptr_to_current = &(*ptr_to_current)->next);
-	  if (*ptr_to_current == to_remove)
+	  sim_event **queue = NULL;
+	  while (dead == NULL
+		 && (queue = next_event_queue (sd, queue)) != NULL)
 	    {
-	      sim_event *dead = *ptr_to_current;
-	      *ptr_to_current = dead->next;
-	      ETRACE ((_ETRACE,
-		       "event/watch descheduled at %ld - tag 0x%lx - time %ld, handler 0x%lx, data 0x%lx%s%s\n",
-		       (long) sim_events_time (sd),
-		       (long) event_to_remove,
-		       (long) dead->time_of_event,
-		       (long) dead->handler,
-		       (long) dead->data,
-		       (dead->trace != NULL) ? ", " : "",
-		       (dead->trace != NULL) ? dead->trace : ""));
-	      sim_events_free (sd, dead);
-	      update_time_from_event (sd);
-	      SIM_ASSERT ((events->time_from_event >= 0) == (events->queue != NULL));
-	      return;
+	      sim_event **ptr_to_current;
+	      for (ptr_to_current = queue;
+		   *ptr_to_current != NULL && *ptr_to_current != to_remove;
+		   ptr_to_current = &(*ptr_to_current)->next);
+	      if (*ptr_to_current == to_remove)
+		{
+		  dead = *ptr_to_current;
+		  *ptr_to_current = dead->next;
+		}
 	    }
 	}
+      if (dead != NULL)
+	{
+	  ETRACE ((_ETRACE,
+		   "event/watch descheduled at %ld - tag 0x%lx - time %ld, handler 0x%lx, data 0x%lx%s%s\n",
+		   (long) sim_events_time (sd),
+		   (long) event_to_remove,
+		   (long) dead->time_of_event,
+		   (long) dead->handler,
+		   (long) dead->data,
+		   (dead->trace != NULL) ? ", " : "",
+		   (dead->trace != NULL) ? dead->trace : ""));
+	  sim_events_free (sd, dead);
+	  update_time_from_event (sd);
+	  SIM_ASSERT ((events->time_from_event >= 0) == (events->nr_queued > 0));
+	  return;
+	}
     }
   ETRACE ((_ETRACE,
 	   "event/watch descheduled at %ld - tag 0x%lx - not found\n",
@@ -1165,13 +1307,12 @@ sim_events_process (SIM_DESC sd)
 
   /* consume all events for this or earlier times.  Be careful to
      allow an event to appear/disappear under our feet */
-  while (events->queue->time_of_event <
+  while (events->queue[0]->time_of_event <
 	 (event_time + events->nr_ticks_to_process))
     {
-      sim_event *to_do = events->queue;
+      sim_event *to_do = sim_events_heap_remove (events, 0);
       sim_event_handler *handler = to_do->handler;
       void *data = to_do->data;
-      events->queue = to_do->next;
       update_time_from_event (sd);
       ETRACE ((_ETRACE,
 	       "event issued at %ld - tag 0x%lx - handler 0x%lx, data 0x%lx%s%s\n",
@@ -1193,7 +1334,7 @@ sim_events_process (SIM_DESC sd)
 
   /* advance the time */
   SIM_ASSERT (events->time_from_event >= events->nr_ticks_to_process);
-  SIM_ASSERT (events->queue != NULL); /* always poll event */
+  SIM_ASSERT (events->nr_queued > 0); /* always poll event */
   events->time_from_event -= events->nr_ticks_to_process;
 
   /* this round of processing complete */
@@ -77,7 +77,13 @@ typedef struct _sim_event sim_event;
 typedef struct _sim_events sim_events;
 struct _sim_events {
   int nr_ticks_to_process;
-  sim_event *queue;
+  /* the timer events, kept as a binary heap */
+  sim_event **queue;
+  int nr_queued;
+  int queue_size;
+  /* statistics */
+  unsigned64 nr_scheduled;
+  int max_nr_queued;
   sim_event *watchpoints;
   sim_event *watchedpoints;
   sim_event *free_list;
@@ -174,6 +174,8 @@ sh64_compact_pbb_begin (SIM_CPU *current_cpu, int FAST_P)
   pc = GET_H_PC ();
 
   new_vpc = scache_lookup_or_alloc (current_cpu, pc, max_insns, &sc);
+  /* Chain pointers are valid again from here on.  */
+  CPU_SCACHE_FLUSHED_P (current_cpu) = 0;
   if (! new_vpc)
     {
       /* Leading '_' to avoid collision with mainloop.in.  */
@@ -309,6 +311,12 @@ sh64_compact_pbb_begin (SIM_CPU *current_cpu, int FAST_P)
       /* Update the pointer to the next free entry, may not have used as
 	 many entries as was asked for.  */
       CPU_SCACHE_NEXT_FREE (current_cpu) = sc;
+      /* Record the extent of the compiled code so writes to it can
+	 flush the cache.  */
+      if (GET_H_PC () < CPU_SCACHE_PBB_LOW (current_cpu))
+	CPU_SCACHE_PBB_LOW (current_cpu) = GET_H_PC ();
+      if (pc > CPU_SCACHE_PBB_HIGH (current_cpu))
+	CPU_SCACHE_PBB_HIGH (current_cpu) = pc;
       /* Record length of chain if profiling.
 	 This includes virtual insns since they count against
 	 max_insns too.  */
@@ -342,6 +350,10 @@ sh64_compact_pbb_chain (SIM_CPU *current_cpu, SEM_ARG sem_arg)
       || STATE_EVENTS (CPU_STATE (current_cpu))->work_pending)
     CPU_RUNNING_P (current_cpu) = 0;
 
+  /* If the cache was flushed while running this block, its chain
+     pointers are stale.  */
+  if (CPU_SCACHE_FLUSHED_P (current_cpu))
+    return CPU_SCACHE_PBB_BEGIN (current_cpu);
   /* If chained to next block, go straight to it.  */
   if (abuf->fields.chain.next)
     return abuf->fields.chain.next;
@@ -412,6 +424,10 @@ sh64_compact_pbb_cti_chain (SIM_CPU *current_cpu, SEM_ARG sem_arg,
       new_vpc_ptr = &abuf->fields.chain.branch_target;
     }
 
+  /* If the cache was flushed while running this block, its chain
+     pointers are stale.  */
+  if (CPU_SCACHE_FLUSHED_P (current_cpu))
+    return CPU_SCACHE_PBB_BEGIN (current_cpu);
   /* If chained to next block, go straight to it.  */
   if (*new_vpc_ptr)
     return *new_vpc_ptr;